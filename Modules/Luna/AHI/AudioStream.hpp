@@ -0,0 +1,86 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AudioStream.hpp
+* @author JXMaster
+* @date 2024/4/30
+*/
+#pragma once
+#include "Adapter.hpp"
+#include <Luna/Runtime/Stream.hpp>
+
+#ifndef LUNA_AHI_API
+#define LUNA_AHI_API
+#endif
+
+namespace Luna
+{
+    namespace AHI
+    {
+        //! @addtogroup AHI
+        //! @{
+
+        //! Describes one audio stream.
+        struct AudioStreamDesc
+        {
+            //! The bit depth of decoded samples. If this is @ref BitDepth::unspecified, the bit depth of the source data is used.
+            BitDepth bit_depth = BitDepth::f32;
+            //! The number of channels of decoded frames. If this is `0`, the number of channels of the source data is used.
+            u32 num_channels = 0;
+            //! The sample rate of decoded frames. If this is `0`, the sample rate of the source data is used.
+            u32 sample_rate = 0;
+            //! The number of decoded frames that can be buffered by the stream.
+            //! @details The stream decodes more frames when less than half of the buffer is filled, so this should be large enough
+            //! to cover the latency of one decode job.
+            u32 buffer_frames = 32768;
+            //! Whether to restart decoding from the beginning when the end of the source data is reached.
+            bool loop = false;
+        };
+
+        //! @interface IAudioStream
+        //! Decodes compressed audio data progressively, so that long audio tracks can be played with one small resident buffer.
+        //! @details Frames are decoded by jobs of the job system into one single-producer single-consumer ring buffer, and are
+        //! consumed by @ref read, which never blocks and never decodes. One decode job is submitted by @ref read when less than
+        //! half of the buffer is filled, so only one thread should call @ref read, usually the audio thread in one playback callback:
+        //! ```
+        //! device->add_playback_data_callback([stream](void* dst_buffer, const WaveFormat& format, u32 num_frames)
+        //! {
+        //!     return stream->read(dst_buffer, num_frames);
+        //! });
+        //! ```
+        //! Formats supported by the stream are WAV, FLAC and MP3.
+        struct IAudioStream : virtual Interface
+        {
+            luiid("{F1C84A3E-7D25-4B90-8E6A-2B5D07C9E413}");
+
+            //! Gets the wave format of decoded frames.
+            virtual WaveFormat get_format() = 0;
+            //! Gets the total number of frames of the stream.
+            //! @return Returns the total number of frames, or `0` if the length cannot be determined without decoding the whole stream.
+            virtual u64 get_num_frames() = 0;
+            //! Reads decoded frames from the stream.
+            //! @param[in] dst_buffer The buffer to write frames to. The buffer must be large enough to hold `num_frames` frames in the format
+            //! returned by @ref get_format.
+            //! @param[in] num_frames The number of frames to read.
+            //! @return Returns the number of frames actually read. This may be smaller than `num_frames` if the decoder does not keep up
+            //! with playback, or if the end of the stream is reached.
+            virtual u32 read(void* dst_buffer, u32 num_frames) = 0;
+            //! Checks whether all frames of the stream are decoded and read.
+            //! @details This never returns `true` if @ref AudioStreamDesc::loop is `true`, unless decoding fails.
+            virtual bool is_finished() = 0;
+        };
+
+        //! Creates one new audio stream.
+        //! @details The buffer of the stream is filled before this function returns, so that frames can be read immediately.
+        //! @param[in] stream The stream to read encoded audio data from. The audio stream keeps one reference to the stream.
+        //! If the stream implements @ref ISeekableStream, it is used for seeking in the source data, which is required by some formats
+        //! and by looping.
+        //! @param[in] desc The audio stream descriptor.
+        //! @return Returns the created audio stream.
+        LUNA_AHI_API R<Ref<IAudioStream>> new_audio_stream(IStream* stream, const AudioStreamDesc& desc = AudioStreamDesc());
+
+        //! @}
+    }
+}
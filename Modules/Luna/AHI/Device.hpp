@@ -31,6 +31,20 @@ namespace Luna
             playback = 1,
             //! Enable audio capture on this device.
             capture = 2,
+            //! Do not clear the playback buffer before playback callbacks are called.
+            //! @details This saves one buffer clear per period. The device always writes every frame of the playback buffer,
+            //! so this is safe unless the audio driver requires the buffer to be cleared.
+            no_pre_silenced_output = 4,
+        };
+
+        //! Specifies whether the device shares the audio adapter with other applications.
+        enum class ShareMode : u8
+        {
+            //! The audio adapter is shared with other applications, audio data is mixed by the operating system.
+            shared = 0,
+            //! The audio adapter is used exclusively by this device, which bypasses the mixer of the operating system and
+            //! gives the lowest latency. Creating the device fails if exclusive mode is not supported by the audio driver.
+            exclusive = 1,
         };
 
         //! Describes properties of the playback or capture audio data stream of one device.
@@ -45,6 +59,8 @@ namespace Luna
             u32 num_channels;
             //! The bit depth of one audio sample in this stream.
             BitDepth bit_depth;
+            //! The share mode of this stream.
+            ShareMode share_mode = ShareMode::shared;
         };
 
         //! Describes one audio device.
@@ -62,6 +78,38 @@ namespace Luna
             u32 sample_rate;
             //! Additional device flags, like whether to enable playback/capture stream
             DeviceFlag flags;
+            //! The number of frames processed by every playback or capture callback. This determines the latency of the device.
+            //! If this is `0`, the size is determined by the audio driver.
+            u32 period_size_in_frames = 0;
+            //! The number of periods of the internal buffer of the device. If this is `0`, the number is determined by the audio driver.
+            u32 num_periods = 0;
+        };
+
+        //! Timing statistics of one audio device.
+        struct DeviceStats
+        {
+            //! The number of times the device callback is called.
+            u64 num_callbacks = 0;
+            //! The number of frames processed by the device callback.
+            u64 num_frames = 0;
+            //! The total time spent in the device callback in seconds.
+            f64 total_callback_time = 0.0;
+            //! The time spent in the last device callback in seconds.
+            f64 last_callback_time = 0.0;
+            //! The maximum time spent in one device callback in seconds.
+            f64 max_callback_time = 0.0;
+            //! The estimated number of buffer underruns (for playback) or overruns (for capture).
+            //! @details One xrun is counted if one callback takes longer than the duration of the frames it processes, or if the
+            //! interval between two callbacks is more than twice the duration of the frames processed by the first callback.
+            u64 num_xruns = 0;
+            //! The actual number of frames of one period of the playback stream.
+            u32 playback_period_size_in_frames = 0;
+            //! The actual number of frames of one period of the capture stream.
+            u32 capture_period_size_in_frames = 0;
+            //! The latency of the playback stream in seconds, which is the duration of the internal playback buffer.
+            f64 playback_latency = 0.0;
+            //! The latency of the capture stream in seconds, which is the duration of the internal capture buffer.
+            f64 capture_latency = 0.0;
         };
 
         //! Called when audio data is required by the audio driver. The user should write audio frames to 
@@ -142,6 +190,12 @@ namespace Luna
             //! @param[in] handle The handle of the callback to remove. 
             //! This handle is returned by @ref add_capture_data_callback when adding the callback.
             virtual void remove_capture_data_callback(usize handle) = 0;
+            //! Gets timing statistics of the device.
+            //! @details Statistics are updated by the audio thread without synchronization, so values may be from different callbacks.
+            //! @return Returns the statistics.
+            virtual DeviceStats get_stats() = 0;
+            //! Resets counters of statistics returned by @ref get_stats.
+            virtual void reset_stats() = 0;
         };
 
         //! Creates one new audio device.
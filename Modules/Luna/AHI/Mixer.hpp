@@ -0,0 +1,151 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Mixer.hpp
+* @author JXMaster
+* @date 2024/4/29
+*/
+#pragma once
+#include "Device.hpp"
+
+#ifndef LUNA_AHI_API
+#define LUNA_AHI_API
+#endif
+
+namespace Luna
+{
+    namespace AHI
+    {
+        //! @addtogroup AHI
+        //! @{
+
+        //! @interface IAudioClip
+        //! Represents one immutable piece of audio data that can be played by mixers.
+        //! @details Audio data is converted to 32-bit floating-point samples when the clip is created, so mixers
+        //! do not need to convert sample formats on the audio thread. One clip can be played by multiple voices at the same time.
+        struct IAudioClip : virtual Interface
+        {
+            luiid("{2C9E4B71-5A3D-4E08-B6F2-81D7A0C5E3F9}");
+
+            //! Gets the sample rate of the clip.
+            virtual u32 get_sample_rate() = 0;
+            //! Gets the number of channels of the clip.
+            virtual u32 get_num_channels() = 0;
+            //! Gets the number of frames of the clip.
+            virtual u32 get_num_frames() = 0;
+        };
+
+        //! Creates one new audio clip.
+        //! @param[in] data The audio frames to copy from.
+        //! @param[in] format The wave format of `data`.
+        //! @param[in] num_frames The number of frames in `data`.
+        //! @return Returns the created audio clip.
+        LUNA_AHI_API R<Ref<IAudioClip>> new_audio_clip(const void* data, const WaveFormat& format, u32 num_frames);
+
+        //! Converts audio samples between bit depths.
+        //! @param[in] dst The buffer to write converted samples to.
+        //! @param[in] dst_bit_depth The bit depth of samples in `dst`.
+        //! @param[in] src The buffer to read samples from.
+        //! @param[in] src_bit_depth The bit depth of samples in `src`.
+        //! @param[in] num_samples The number of samples to convert, which is the number of frames multiplied by
+        //! the number of channels.
+        //! @remark Floating-point samples out of [-1.0, 1.0] are clamped when they are converted to integer samples.
+        LUNA_AHI_API void convert_samples(void* dst, BitDepth dst_bit_depth, const void* src, BitDepth src_bit_depth, usize num_samples);
+
+        //! The identifier of one voice played by one mixer.
+        using voice_id_t = u64;
+
+        //! The identifier of the master bus of one mixer.
+        constexpr u32 MASTER_BUS = 0;
+
+        //! Describes one voice to play.
+        struct VoiceDesc
+        {
+            //! The volume of the voice.
+            f32 gain = 1.0f;
+            //! The stereo panning of the voice in [-1.0, 1.0], where -1.0 plays only on the left channel and 1.0 plays only
+            //! on the right channel. This is used only if the clip has one channel and the device has two channels.
+            f32 pan = 0.0f;
+            //! The playback speed of the voice. This changes the pitch as well.
+            f32 pitch = 1.0f;
+            //! The bus to output this voice to.
+            u32 bus = MASTER_BUS;
+            //! Whether to play the clip repeatedly until the voice is stopped.
+            bool loop = false;
+        };
+
+        //! Describes one mixer.
+        struct MixerDesc
+        {
+            //! The number of buses of the mixer, including the master bus. Every non-master bus mixes its voices
+            //! and outputs to the master bus.
+            u32 num_buses = 1;
+            //! The maximum number of voices that can be played at the same time.
+            u32 max_voices = 256;
+            //! The maximum number of commands that can be submitted to the mixer before they are consumed by the audio thread.
+            u32 max_commands = 1024;
+        };
+
+        //! @interface IMixer
+        //! Mixes voices and buses to the playback stream of one device.
+        //! @details All functions of the mixer submit commands to one lock-free queue that is consumed by the audio thread
+        //! before every mix, so they never block the audio thread and can be called from any thread. Samples are mixed
+        //! as 32-bit floating-point values using SIMD, resampled to the sample rate of the device and converted to the bit
+        //! depth of the device only when they are written to the playback stream.
+        //!
+        //! Voices that are finished or stopped are returned to the mixer and are released by @ref update, so the audio thread
+        //! never frees memory. The user should call @ref update periodically, for example, once per frame.
+        struct IMixer : virtual Interface
+        {
+            luiid("{9A5F1E28-3B74-4C6D-8E02-D4B7C93A16E5}");
+
+            //! Starts playing one clip.
+            //! @param[in] clip The clip to play. The mixer keeps one reference to the clip until the voice is released by @ref update.
+            //! @param[in] desc The voice descriptor.
+            //! @return Returns the identifier of the new voice. Returns @ref BasicError::out_of_resource if too many voices are not released
+            //! by @ref update or the command queue is full.
+            virtual R<voice_id_t> play(IAudioClip* clip, const VoiceDesc& desc = VoiceDesc()) = 0;
+            //! Stops one voice.
+            //! @details This does nothing if the voice is already finished.
+            //! @param[in] voice The voice to stop.
+            //! @return Returns @ref BasicError::out_of_resource if the command queue is full.
+            virtual RV stop(voice_id_t voice) = 0;
+            //! Sets the volume of one voice.
+            //! @param[in] voice The voice to set.
+            //! @param[in] gain The new volume.
+            //! @return Returns @ref BasicError::out_of_resource if the command queue is full.
+            virtual RV set_voice_gain(voice_id_t voice, f32 gain) = 0;
+            //! Sets the stereo panning of one voice. See @ref VoiceDesc::pan for details.
+            //! @param[in] voice The voice to set.
+            //! @param[in] pan The new stereo panning.
+            //! @return Returns @ref BasicError::out_of_resource if the command queue is full.
+            virtual RV set_voice_pan(voice_id_t voice, f32 pan) = 0;
+            //! Sets the playback speed of one voice.
+            //! @param[in] voice The voice to set.
+            //! @param[in] pitch The new playback speed.
+            //! @return Returns @ref BasicError::out_of_resource if the command queue is full.
+            virtual RV set_voice_pitch(voice_id_t voice, f32 pitch) = 0;
+            //! Sets the volume of one bus.
+            //! @param[in] bus The index of the bus to set.
+            //! @param[in] gain The new volume.
+            //! @return Returns @ref BasicError::out_of_resource if the command queue is full.
+            virtual RV set_bus_gain(u32 bus, f32 gain) = 0;
+            //! Gets the number of voices that were played in the last mix.
+            //! @details The returned value may be outdated as soon as this function returns.
+            virtual u32 get_num_playing_voices() = 0;
+            //! Releases voices that are finished or stopped.
+            virtual void update() = 0;
+        };
+
+        //! Creates one new mixer that plays to the specified device.
+        //! @param[in] device The device to play to. Playback must be enabled on the device.
+        //! The mixer registers one playback callback to the device, and removes it when the mixer is destroyed.
+        //! @param[in] desc The mixer descriptor.
+        //! @return Returns the created mixer.
+        LUNA_AHI_API R<Ref<IMixer>> new_mixer(IDevice* device, const MixerDesc& desc = MixerDesc());
+
+        //! @}
+    }
+}
@@ -12,6 +12,7 @@
 #include "AHI.hpp"
 #include "../AHIError.hpp"
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
 namespace Luna
 {
     namespace AHI
@@ -27,8 +28,13 @@ namespace Luna
         struct AHIModule : public Module
         {
             virtual const c8* get_name() override { return "AHI"; }
+            virtual RV on_register() override
+            {
+                return add_dependency_module(this, module_job_system());
+            }
             virtual RV on_init() override
             {
+                register_mixer_types();
                 return platform_init();
             }
             virtual void on_close() override
@@ -16,5 +16,6 @@ namespace Luna
     {
         RV platform_init();
         void platform_close();
+        void register_mixer_types();
     }
 }
\ No newline at end of file
@@ -0,0 +1,170 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AudioStream.cpp
+* @author JXMaster
+* @date 2024/4/30
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_AHI_API LUNA_EXPORT
+#include "AudioStream.hpp"
+#include <Luna/JobSystem/JobSystem.hpp>
+
+namespace Luna
+{
+    namespace AHI
+    {
+        static ma_result on_decoder_read(ma_decoder* decoder, void* buffer, size_t bytes_to_read, size_t* bytes_read)
+        {
+            AudioStream* stream = (AudioStream*)decoder->pUserData;
+            usize read_bytes = 0;
+            RV r = stream->m_source->read(buffer, bytes_to_read, &read_bytes);
+            *bytes_read = read_bytes;
+            if (failed(r)) return MA_IO_ERROR;
+            return (bytes_to_read && !read_bytes) ? MA_AT_END : MA_SUCCESS;
+        }
+        static ma_result on_decoder_seek(ma_decoder* decoder, ma_int64 byte_offset, ma_seek_origin origin)
+        {
+            AudioStream* stream = (AudioStream*)decoder->pUserData;
+            if (!stream->m_seekable_source) return MA_NOT_IMPLEMENTED;
+            SeekMode mode = origin == ma_seek_origin_start ? SeekMode::begin :
+                (origin == ma_seek_origin_current ? SeekMode::current : SeekMode::end);
+            RV r = stream->m_seekable_source->seek(byte_offset, mode);
+            return succeeded(r) ? MA_SUCCESS : MA_IO_ERROR;
+        }
+
+        RV AudioStream::init(IStream* source, const AudioStreamDesc& desc)
+        {
+            if (!desc.buffer_frames) return BasicError::bad_arguments();
+            m_source = source;
+            m_seekable_source = query_interface<ISeekableStream>(source->get_object());
+            m_loop = desc.loop;
+            ma_format format = desc.bit_depth == BitDepth::unspecified ? ma_format_unknown : encode_format(desc.bit_depth);
+            ma_decoder_config config = ma_decoder_config_init(format, desc.num_channels, desc.sample_rate);
+            auto r = ma_decoder_init(on_decoder_read, on_decoder_seek, this, &config, &m_decoder);
+            if (r != MA_SUCCESS) return translate_ma_result(r);
+            m_decoder_initialized = true;
+            ma_format output_format;
+            ma_uint32 num_channels;
+            ma_uint32 sample_rate;
+            r = ma_decoder_get_data_format(&m_decoder, &output_format, &num_channels, &sample_rate, nullptr, 0);
+            if (r != MA_SUCCESS) return translate_ma_result(r);
+            m_format.bit_depth = decode_bit_depth(output_format);
+            m_format.num_channels = num_channels;
+            m_format.sample_rate = sample_rate;
+            m_frame_size = get_frame_size(m_format.bit_depth, m_format.num_channels);
+            if (!m_frame_size) return AHIError::format_not_supported();
+            ma_uint64 length = 0;
+            if (ma_decoder_get_length_in_pcm_frames(&m_decoder, &length) == MA_SUCCESS) m_num_frames = length;
+            m_buffer.resize((usize)desc.buffer_frames * m_frame_size);
+            m_capacity = desc.buffer_frames;
+            // Fills the buffer before the first read.
+            decode();
+            return ok;
+        }
+
+        AudioStream::~AudioStream()
+        {
+            if (m_decoder_initialized) ma_decoder_uninit(&m_decoder);
+        }
+
+        void AudioStream::decode()
+        {
+            // Only called by one thread at a time, guarded by `m_decoding`.
+            usize write_pos = m_write_pos;
+            usize read_pos = m_read_pos;
+            usize free_frames = m_capacity - (write_pos - read_pos);
+            while (free_frames && !m_decoder_finished)
+            {
+                // Decodes directly to the ring buffer, at most until the end of the buffer.
+                usize offset = write_pos % m_capacity;
+                usize frames_to_decode = min(free_frames, m_capacity - offset);
+                ma_uint64 decoded_frames = 0;
+                auto r = ma_decoder_read_pcm_frames(&m_decoder, m_buffer.data() + offset * m_frame_size, frames_to_decode, &decoded_frames);
+                if (decoded_frames)
+                {
+                    write_pos += (usize)decoded_frames;
+                    free_frames -= (usize)decoded_frames;
+                    // Frames must be visible before the new write position is visible.
+                    atom_exchange_usize(&m_write_pos, write_pos);
+                }
+                if (r == MA_AT_END || (r == MA_SUCCESS && decoded_frames < frames_to_decode))
+                {
+                    if (m_loop && (decoded_frames || write_pos != m_loop_begin_pos) && ma_decoder_seek_to_pcm_frame(&m_decoder, 0) == MA_SUCCESS)
+                    {
+                        // Stops looping if no frame is decoded between two restarts, which happens for empty streams.
+                        m_loop_begin_pos = write_pos;
+                        continue;
+                    }
+                    atom_exchange_u32(&m_decoder_finished, 1);
+                }
+                else if (r != MA_SUCCESS)
+                {
+                    atom_exchange_u32(&m_decoder_finished, 1);
+                }
+            }
+        }
+
+        struct AudioStreamDecodeJob
+        {
+            AudioStream* m_stream;
+
+            static void run(void* params)
+            {
+                AudioStream* stream = ((AudioStreamDecodeJob*)params)->m_stream;
+                stream->decode();
+                atom_exchange_u32(&stream->m_decoding, 0);
+                // Releases the reference retained when the job is submitted.
+                object_release(stream);
+            }
+        };
+
+        u32 AudioStream::read(void* dst_buffer, u32 num_frames)
+        {
+            usize read_pos = m_read_pos;
+            usize write_pos = m_write_pos;
+            usize frames = min<usize>(write_pos - read_pos, num_frames);
+            byte_t* dst = (byte_t*)dst_buffer;
+            usize copied = 0;
+            while (copied < frames)
+            {
+                usize offset = (read_pos + copied) % m_capacity;
+                usize n = min(frames - copied, m_capacity - offset);
+                memcpy(dst + copied * m_frame_size, m_buffer.data() + offset * m_frame_size, n * m_frame_size);
+                copied += n;
+            }
+            read_pos += frames;
+            // Frames must be copied before the space is given back to the decoder.
+            atom_exchange_usize(&m_read_pos, read_pos);
+            // Prefetches more frames when the buffer is less than half full.
+            if (!m_decoder_finished && (write_pos - read_pos) * 2 < m_capacity &&
+                atom_compare_exchange_u32(&m_decoding, 1, 0) == 0)
+            {
+                object_retain(this);
+                AudioStreamDecodeJob* job = (AudioStreamDecodeJob*)JobSystem::new_job(AudioStreamDecodeJob::run, sizeof(AudioStreamDecodeJob), alignof(AudioStreamDecodeJob));
+                job->m_stream = this;
+                JobSystem::set_job_name(job, "Audio Stream Decode");
+                JobSystem::submit_job(job, JobSystem::JobPriority::io);
+            }
+            return (u32)frames;
+        }
+
+        bool AudioStream::is_finished()
+        {
+            return m_decoder_finished && m_read_pos == m_write_pos;
+        }
+
+        LUNA_AHI_API R<Ref<IAudioStream>> new_audio_stream(IStream* stream, const AudioStreamDesc& desc)
+        {
+            Ref<AudioStream> s = new_object<AudioStream>();
+            lutry
+            {
+                luexp(s->init(stream, desc));
+            }
+            lucatchret;
+            return Ref<IAudioStream>(s);
+        }
+    }
+}
@@ -0,0 +1,56 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AudioStream.hpp
+* @author JXMaster
+* @date 2024/4/30
+*/
+#pragma once
+#include "../../AudioStream.hpp"
+#include "Common.hpp"
+#include <Luna/Runtime/Atomic.hpp>
+
+namespace Luna
+{
+    namespace AHI
+    {
+        struct AudioStream : IAudioStream
+        {
+            lustruct("AHI::AudioStream", "{3A7E95C2-0B64-4F1D-9C83-E5D2A61B47F0}");
+            luiimpl();
+
+            Ref<IStream> m_source;
+            Ref<ISeekableStream> m_seekable_source;
+            ma_decoder m_decoder;
+            bool m_decoder_initialized = false;
+            bool m_loop = false;
+            WaveFormat m_format;
+            usize m_frame_size = 0;
+            u64 m_num_frames = 0;
+
+            // The ring buffer of decoded frames. `m_write_pos` is only written by the decoder, and `m_read_pos`
+            // is only written by `read`. Both are frame counters that never wrap.
+            Vector<byte_t> m_buffer;
+            usize m_capacity = 0;
+            usize volatile m_write_pos = 0;
+            usize volatile m_read_pos = 0;
+            // The write position when the decoder restarts from the beginning for the last time.
+            usize m_loop_begin_pos = 0;
+            // `1` if one decode job is submitted and not finished.
+            u32 volatile m_decoding = 0;
+            u32 volatile m_decoder_finished = 0;
+
+            RV init(IStream* source, const AudioStreamDesc& desc);
+            ~AudioStream();
+            // Decodes frames until the buffer is full or the decoder is finished.
+            void decode();
+
+            virtual WaveFormat get_format() override { return m_format; }
+            virtual u64 get_num_frames() override { return m_num_frames; }
+            virtual u32 read(void* dst_buffer, u32 num_frames) override;
+            virtual bool is_finished() override;
+        };
+    }
+}
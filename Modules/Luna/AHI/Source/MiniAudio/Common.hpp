@@ -8,7 +8,6 @@
 * @date 2023/10/15
 */
 #pragma once
-#define MA_NO_DECODING
 #define MA_NO_ENCODING
 #define MA_NO_ENGINE
 #define MA_NO_RESOURCE_MANAGER
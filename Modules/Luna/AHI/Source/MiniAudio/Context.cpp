@@ -11,6 +11,7 @@
 #include "Common.hpp"
 #include "Adapter.hpp"
 #include "Device.hpp"
+#include "AudioStream.hpp"
 
 namespace Luna
 {
@@ -24,6 +25,8 @@ namespace Luna
             impl_interface_for_type<Adapter, IAdapter>();
             register_boxed_type<Device>();
             impl_interface_for_type<Device, IDevice>();
+            register_boxed_type<AudioStream>();
+            impl_interface_for_type<AudioStream, IAudioStream>();
             auto r = ma_context_init(NULL, 0, NULL, &g_context);
             if(r != MA_SUCCESS)
             {
@@ -13,6 +13,7 @@
 #include "Device.hpp"
 #include <Luna/Runtime/Array.hpp>
 #include <Luna/Runtime/Math/Math.hpp>
+#include <Luna/Runtime/Time.hpp>
 
 namespace Luna
 {
@@ -153,6 +154,7 @@ namespace Luna
         void data_callback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount)
         {
             Device* device = (Device*)pDevice->pUserData;
+            u64 begin_ticks = get_ticks();
             if(test_flags(device->m_flags, DeviceFlag::playback))
             {
                 MutexGuard guard(device->m_audio_sources_mutex);
@@ -210,12 +212,66 @@ namespace Luna
                 format.bit_depth = device->get_capture_bit_depth();
                 device->m_capture_event(pInput, format, frameCount);
             }
+            device->record_callback(begin_ticks, get_ticks(), frameCount);
+        }
+        void Device::record_callback(u64 begin_ticks, u64 end_ticks, u32 num_frames)
+        {
+            if(m_reset_stats_requested)
+            {
+                m_num_callbacks = 0;
+                m_num_frames = 0;
+                m_total_callback_ticks = 0;
+                m_last_callback_ticks = 0;
+                m_max_callback_ticks = 0;
+                m_num_xruns = 0;
+                m_last_callback_begin = 0;
+                atom_exchange_u32(&m_reset_stats_requested, 0);
+            }
+            u64 ticks = end_ticks - begin_ticks;
+            f64 sample_rate = (f64)get_sample_rate();
+            // The callback cannot keep up with the device if it takes longer than the duration of the frames it processes.
+            bool xrun = (f64)ticks / m_ticks_per_second > (f64)num_frames / sample_rate;
+            // The device is starved if the next callback comes much later than expected.
+            if(m_last_callback_begin && (f64)(begin_ticks - m_last_callback_begin) / m_ticks_per_second > 2.0 * (f64)m_last_callback_frames / sample_rate)
+            {
+                xrun = true;
+            }
+            if(xrun) ++m_num_xruns;
+            ++m_num_callbacks;
+            m_num_frames += num_frames;
+            m_total_callback_ticks += ticks;
+            m_last_callback_ticks = ticks;
+            m_max_callback_ticks = max<u64>(m_max_callback_ticks, ticks);
+            m_last_callback_begin = begin_ticks;
+            m_last_callback_frames = num_frames;
+        }
+        DeviceStats Device::get_stats()
+        {
+            DeviceStats stats;
+            stats.num_callbacks = m_num_callbacks;
+            stats.num_frames = m_num_frames;
+            stats.total_callback_time = (f64)m_total_callback_ticks / m_ticks_per_second;
+            stats.last_callback_time = (f64)m_last_callback_ticks / m_ticks_per_second;
+            stats.max_callback_time = (f64)m_max_callback_ticks / m_ticks_per_second;
+            stats.num_xruns = m_num_xruns;
+            if(test_flags(m_flags, DeviceFlag::playback))
+            {
+                stats.playback_period_size_in_frames = m_device.playback.internalPeriodSizeInFrames;
+                stats.playback_latency = (f64)m_device.playback.internalPeriodSizeInFrames * (f64)m_device.playback.internalPeriods / (f64)m_device.playback.internalSampleRate;
+            }
+            if(test_flags(m_flags, DeviceFlag::capture))
+            {
+                stats.capture_period_size_in_frames = m_device.capture.internalPeriodSizeInFrames;
+                stats.capture_latency = (f64)m_device.capture.internalPeriodSizeInFrames * (f64)m_device.capture.internalPeriods / (f64)m_device.capture.internalSampleRate;
+            }
+            return stats;
         }
         RV Device::init(const DeviceDesc& desc)
         {
             m_audio_sources_mutex = new_mutex();
             m_capture_event_mutex = new_mutex();
             m_flags = desc.flags;
+            m_ticks_per_second = get_ticks_per_second();
             ma_device_type type;
             if(test_flags(desc.flags, DeviceFlag::playback | DeviceFlag::capture)) type = ma_device_type_duplex;
             else if(test_flags(desc.flags, DeviceFlag::playback)) type = ma_device_type_playback;
@@ -231,6 +287,7 @@ namespace Luna
                 }
                 config.playback.format = encode_format(desc.playback.bit_depth);
                 config.playback.channels = desc.playback.num_channels;
+                config.playback.shareMode = desc.playback.share_mode == ShareMode::exclusive ? ma_share_mode_exclusive : ma_share_mode_shared;
             }
             if(test_flags(desc.flags, DeviceFlag::capture))
             {
@@ -241,8 +298,13 @@ namespace Luna
                 }
                 config.capture.format = encode_format(desc.capture.bit_depth);
                 config.capture.channels = desc.capture.num_channels;
+                config.capture.shareMode = desc.capture.share_mode == ShareMode::exclusive ? ma_share_mode_exclusive : ma_share_mode_shared;
             }
             config.sampleRate = desc.sample_rate;
+            config.periodSizeInFrames = desc.period_size_in_frames;
+            config.periods = desc.num_periods;
+            // Every frame of the playback buffer is written by `data_callback`.
+            config.noPreSilencedOutputBuffer = test_flags(desc.flags, DeviceFlag::no_pre_silenced_output) ? MA_TRUE : MA_FALSE;
             config.dataCallback = data_callback;
             config.pUserData = this;
             auto r = ma_device_init(&g_context, &config, &m_device);
@@ -12,6 +12,7 @@
 #include "Common.hpp"
 #include <Luna/Runtime/Mutex.hpp>
 #include <Luna/Runtime/Event.hpp>
+#include <Luna/Runtime/Atomic.hpp>
 
 namespace Luna
 {
@@ -48,6 +49,21 @@ namespace Luna
             usize m_next_audio_source = 0;
             Event<capture_callback_t> m_capture_event;
 
+            // Timing statistics, only written by the audio thread.
+            f64 m_ticks_per_second;
+            u64 volatile m_num_callbacks = 0;
+            u64 volatile m_num_frames = 0;
+            u64 volatile m_total_callback_ticks = 0;
+            u64 volatile m_last_callback_ticks = 0;
+            u64 volatile m_max_callback_ticks = 0;
+            u64 volatile m_num_xruns = 0;
+            u64 m_last_callback_begin = 0;
+            u32 m_last_callback_frames = 0;
+            // Set by `reset_stats` and handled by the audio thread, so that counters are written by one thread only.
+            u32 volatile m_reset_stats_requested = 0;
+
+            void record_callback(u64 begin_ticks, u64 end_ticks, u32 num_frames);
+
             RV init(const DeviceDesc& desc);
             ~Device();
 
@@ -102,6 +118,11 @@ namespace Luna
                 MutexGuard guard(m_capture_event_mutex);
                 m_capture_event.remove_handler(handle);
             }
+            virtual DeviceStats get_stats() override;
+            virtual void reset_stats() override
+            {
+                atom_exchange_u32(&m_reset_stats_requested, 1);
+            }
         };
     }
 }
\ No newline at end of file
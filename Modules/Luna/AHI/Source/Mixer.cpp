@@ -0,0 +1,581 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Mixer.cpp
+* @author JXMaster
+* @date 2024/4/29
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_AHI_API LUNA_EXPORT
+#include "../Mixer.hpp"
+#include <Luna/Runtime/MPMCQueue.hpp>
+#include <Luna/Runtime/UniquePtr.hpp>
+#include <Luna/Runtime/Math/Math.hpp>
+#include <Luna/Runtime/Math/Vector.hpp>
+#include <Luna/Runtime/Math/Simd.hpp>
+
+namespace Luna
+{
+    namespace AHI
+    {
+        // Decodes samples of the specified bit depth to floating-point samples.
+        static void decode_samples(f32* dst, const void* src, BitDepth bit_depth, usize num_samples)
+        {
+            switch (bit_depth)
+            {
+            case BitDepth::u8:
+            {
+                const u8* s = (const u8*)src;
+                for (usize i = 0; i < num_samples; ++i) dst[i] = ((f32)s[i] - 128.0f) / 128.0f;
+                break;
+            }
+            case BitDepth::s16:
+            {
+                const i16* s = (const i16*)src;
+                for (usize i = 0; i < num_samples; ++i) dst[i] = (f32)s[i] / 32768.0f;
+                break;
+            }
+            case BitDepth::s24:
+            {
+                const u8* s = (const u8*)src;
+                for (usize i = 0; i < num_samples; ++i)
+                {
+                    // Uses the same 24-bit layout as the device mixer.
+#ifdef LUNA_PLATFORM_LITTLE_ENDIAN
+                    i32 data = ((i32)(s[0])) + (((i32)s[1]) << 8) + (((i32)(s[2] & 0x7F)) << 16);
+                    data = (s[2] & 0x80) ? -data : data;
+#else
+                    i32 data = ((i32)(s[2])) + ((i32)s[1] << 8) + (((i32)(s[0] & 0x7F)) << 16);
+                    data = (s[0] & 0x80) ? -data : data;
+#endif
+                    dst[i] = (f32)data / 8388608.0f;
+                    s += 3;
+                }
+                break;
+            }
+            case BitDepth::s32:
+            {
+                const i32* s = (const i32*)src;
+                for (usize i = 0; i < num_samples; ++i) dst[i] = (f32)((f64)s[i] / 2147483648.0);
+                break;
+            }
+            case BitDepth::f32:
+                memcpy(dst, src, sizeof(f32) * num_samples);
+                break;
+            default: lupanic();
+            }
+        }
+
+        // Encodes floating-point samples to samples of the specified bit depth. Samples are clamped to [-1.0, 1.0].
+        static void encode_samples(void* dst, BitDepth bit_depth, const f32* src, usize num_samples)
+        {
+            switch (bit_depth)
+            {
+            case BitDepth::u8:
+            {
+                u8* d = (u8*)dst;
+                for (usize i = 0; i < num_samples; ++i) d[i] = (u8)clamp(src[i] * 128.0f + 128.0f, 0.0f, 255.0f);
+                break;
+            }
+            case BitDepth::s16:
+            {
+                i16* d = (i16*)dst;
+                for (usize i = 0; i < num_samples; ++i) d[i] = (i16)(clamp(src[i], -1.0f, 1.0f) * 32767.0f);
+                break;
+            }
+            case BitDepth::s24:
+            {
+                u8* d = (u8*)dst;
+                for (usize i = 0; i < num_samples; ++i)
+                {
+                    i32 sample = (i32)(clamp(src[i], -1.0f, 1.0f) * 8388607.0f);
+                    i32 magnitude = sample < 0 ? -sample : sample;
+#ifdef LUNA_PLATFORM_LITTLE_ENDIAN
+                    d[0] = (u8)(magnitude);
+                    d[1] = (u8)(magnitude >> 8);
+                    d[2] = (u8)((magnitude >> 16) & 0x7F) + (u8)(sample < 0 ? 0x80 : 0);
+#else
+                    d[0] = (u8)((magnitude >> 16) & 0x7F) + (u8)(sample < 0 ? 0x80 : 0);
+                    d[1] = (u8)(magnitude >> 8);
+                    d[2] = (u8)(magnitude);
+#endif
+                    d += 3;
+                }
+                break;
+            }
+            case BitDepth::s32:
+            {
+                i32* d = (i32*)dst;
+                for (usize i = 0; i < num_samples; ++i) d[i] = (i32)((f64)clamp(src[i], -1.0f, 1.0f) * 2147483647.0);
+                break;
+            }
+            case BitDepth::f32:
+            {
+                f32* d = (f32*)dst;
+                for (usize i = 0; i < num_samples; ++i) d[i] = clamp(src[i], -1.0f, 1.0f);
+                break;
+            }
+            default: lupanic();
+            }
+        }
+
+        LUNA_AHI_API void convert_samples(void* dst, BitDepth dst_bit_depth, const void* src, BitDepth src_bit_depth, usize num_samples)
+        {
+            if (dst_bit_depth == src_bit_depth)
+            {
+                memcpy(dst, src, get_frame_size(src_bit_depth, 1) * num_samples);
+                return;
+            }
+            if (src_bit_depth == BitDepth::f32)
+            {
+                encode_samples(dst, dst_bit_depth, (const f32*)src, num_samples);
+                return;
+            }
+            if (dst_bit_depth == BitDepth::f32)
+            {
+                decode_samples((f32*)dst, src, src_bit_depth, num_samples);
+                return;
+            }
+            // Converts through one floating-point buffer.
+            constexpr usize BUFFER_SAMPLES = 256;
+            f32 buffer[BUFFER_SAMPLES];
+            usize src_sample_size = get_frame_size(src_bit_depth, 1);
+            usize dst_sample_size = get_frame_size(dst_bit_depth, 1);
+            for (usize i = 0; i < num_samples; i += BUFFER_SAMPLES)
+            {
+                usize n = min(num_samples - i, BUFFER_SAMPLES);
+                decode_samples(buffer, (const u8*)src + i * src_sample_size, src_bit_depth, n);
+                encode_samples((u8*)dst + i * dst_sample_size, dst_bit_depth, buffer, n);
+            }
+        }
+
+        struct AudioClip : IAudioClip
+        {
+            lustruct("AHI::AudioClip", "{E4B0C7A2-1F58-4D93-A6E1-37C2D8B05F4A}");
+            luiimpl();
+
+            u32 m_sample_rate;
+            u32 m_num_channels;
+            u32 m_num_frames;
+            Vector<f32> m_samples;
+
+            virtual u32 get_sample_rate() override { return m_sample_rate; }
+            virtual u32 get_num_channels() override { return m_num_channels; }
+            virtual u32 get_num_frames() override { return m_num_frames; }
+        };
+
+        LUNA_AHI_API R<Ref<IAudioClip>> new_audio_clip(const void* data, const WaveFormat& format, u32 num_frames)
+        {
+            if (!format.num_channels || !format.sample_rate || format.bit_depth == BitDepth::unspecified) return BasicError::bad_arguments();
+            Ref<AudioClip> clip = new_object<AudioClip>();
+            clip->m_sample_rate = format.sample_rate;
+            clip->m_num_channels = format.num_channels;
+            clip->m_num_frames = num_frames;
+            usize num_samples = (usize)num_frames * format.num_channels;
+            clip->m_samples.resize(num_samples);
+            decode_samples(clip->m_samples.data(), data, format.bit_depth, num_samples);
+            return Ref<IAudioClip>(clip);
+        }
+
+        // The number of frames mixed in one pass. Mix buffers are allocated for this number of frames when the mixer
+        // is created, so the audio thread never allocates memory.
+        constexpr u32 MIX_CHUNK_FRAMES = 256;
+
+        // dst[i] += src[i] * gain. `num_samples` must be multiple of 4, and both buffers must be aligned to 16 bytes.
+        static void mix_samples(f32* dst, const f32* src, usize num_samples, f32 gain)
+        {
+#ifdef LUNA_SIMD
+            using namespace Simd;
+            float4 g = dup_f4(gain);
+            for (usize i = 0; i < num_samples; i += 4)
+            {
+                store_f4(dst + i, muladd_f4(load_f4(src + i), g, load_f4(dst + i)));
+            }
+#else
+            for (usize i = 0; i < num_samples; ++i)
+            {
+                dst[i] += src[i] * gain;
+            }
+#endif
+        }
+
+        // dst[i] *= gain. `num_samples` must be multiple of 4, and the buffer must be aligned to 16 bytes.
+        static void scale_samples(f32* dst, usize num_samples, f32 gain)
+        {
+#ifdef LUNA_SIMD
+            using namespace Simd;
+            float4 g = dup_f4(gain);
+            for (usize i = 0; i < num_samples; i += 4)
+            {
+                store_f4(dst + i, mul_f4(load_f4(dst + i), g));
+            }
+#else
+            for (usize i = 0; i < num_samples; ++i)
+            {
+                dst[i] *= gain;
+            }
+#endif
+        }
+
+        struct MixerVoice
+        {
+            Ref<AudioClip> m_clip;
+            voice_id_t m_id;
+            // The playback position in source frames.
+            f64 m_position = 0.0;
+            f32 m_gain;
+            f32 m_pan;
+            f32 m_pitch;
+            u32 m_bus;
+            bool m_loop;
+        };
+
+        enum class MixerCommandType : u8
+        {
+            play,
+            stop,
+            set_voice_gain,
+            set_voice_pan,
+            set_voice_pitch,
+            set_bus_gain,
+        };
+
+        struct MixerCommand
+        {
+            MixerCommandType type;
+            u32 bus;
+            voice_id_t voice;
+            f32 value;
+            MixerVoice* new_voice;
+        };
+
+        struct Mixer : IMixer
+        {
+            lustruct("AHI::Mixer", "{5B8D2E61-9C47-4A3F-B0E5-C16F7A84D29B}");
+            luiimpl();
+
+            Ref<IDevice> m_device;
+            usize m_callback_handle = USIZE_MAX;
+            MixerDesc m_desc;
+            UniquePtr<MPMCQueue<MixerCommand>> m_commands;
+            // Voices that are finished or stopped, released by `update`.
+            UniquePtr<MPMCQueue<MixerVoice*>> m_finished_voices;
+            u64 volatile m_next_voice_id = 0;
+            // The number of voices created by `play` and not released by `update`. This is limited so that pushing to
+            // `m_finished_voices` never fails.
+            u32 volatile m_num_allocated_voices = 0;
+            u32 m_max_allocated_voices = 0;
+            u32 volatile m_num_playing_voices = 0;
+
+            // Accessed only by the audio thread.
+            u32 m_num_channels = 0;
+            Vector<MixerVoice*> m_voices;
+            Vector<f32> m_bus_gains;
+            Vector<Float4> m_bus_buffers;
+            Vector<Float4> m_voice_buffer;
+
+            usize get_chunk_samples() const
+            {
+                return (usize)MIX_CHUNK_FRAMES * m_num_channels;
+            }
+            f32* get_bus_buffer(u32 bus)
+            {
+                return (f32*)m_bus_buffers.data() + get_chunk_samples() * bus;
+            }
+
+            RV init(IDevice* device, const MixerDesc& desc)
+            {
+                if (!test_flags(device->get_flags(), DeviceFlag::playback)) return BasicError::bad_arguments();
+                if (!desc.num_buses || !desc.max_voices) return BasicError::bad_arguments();
+                m_device = device;
+                m_desc = desc;
+                m_num_channels = device->get_playback_num_channels();
+                m_commands = UniquePtr<MPMCQueue<MixerCommand>>(memnew<MPMCQueue<MixerCommand>>(desc.max_commands));
+                m_max_allocated_voices = desc.max_voices + desc.max_commands;
+                m_finished_voices = UniquePtr<MPMCQueue<MixerVoice*>>(memnew<MPMCQueue<MixerVoice*>>(m_max_allocated_voices));
+                m_voices.reserve(desc.max_voices);
+                m_bus_gains.resize(desc.num_buses, 1.0f);
+                // `MIX_CHUNK_FRAMES` is multiple of 4, so every bus buffer is aligned to 16 bytes.
+                m_bus_buffers.resize(get_chunk_samples() * desc.num_buses / 4);
+                m_voice_buffer.resize(get_chunk_samples() / 4);
+                m_callback_handle = device->add_playback_data_callback([this](void* dst_buffer, const WaveFormat& format, u32 num_frames)
+                {
+                    return mix(dst_buffer, format, num_frames);
+                });
+                return ok;
+            }
+
+            ~Mixer()
+            {
+                // The device does not call the callback after it is removed.
+                if (m_callback_handle != USIZE_MAX) m_device->remove_playback_data_callback(m_callback_handle);
+                for (MixerVoice* voice : m_voices) memdelete(voice);
+                if (m_commands)
+                {
+                    MixerCommand command;
+                    while (m_commands->pop(command))
+                    {
+                        if (command.type == MixerCommandType::play) memdelete(command.new_voice);
+                    }
+                }
+                if (m_finished_voices)
+                {
+                    MixerVoice* voice;
+                    while (m_finished_voices->pop(voice)) memdelete(voice);
+                }
+            }
+
+            MixerVoice* find_voice(voice_id_t id, usize* index = nullptr)
+            {
+                for (usize i = 0; i < m_voices.size(); ++i)
+                {
+                    if (m_voices[i]->m_id == id)
+                    {
+                        if (index) *index = i;
+                        return m_voices[i];
+                    }
+                }
+                return nullptr;
+            }
+
+            void finish_voice(usize index)
+            {
+                m_finished_voices->push(m_voices[index]);
+                m_voices[index] = m_voices.back();
+                m_voices.pop_back();
+            }
+
+            void process_commands()
+            {
+                MixerCommand command;
+                while (m_commands->pop(command))
+                {
+                    switch (command.type)
+                    {
+                    case MixerCommandType::play:
+                        if (m_voices.size() < m_desc.max_voices) m_voices.push_back(command.new_voice);
+                        else m_finished_voices->push(command.new_voice);
+                        break;
+                    case MixerCommandType::stop:
+                    {
+                        usize index;
+                        if (find_voice(command.voice, &index)) finish_voice(index);
+                        break;
+                    }
+                    case MixerCommandType::set_voice_gain:
+                    {
+                        MixerVoice* voice = find_voice(command.voice);
+                        if (voice) voice->m_gain = command.value;
+                        break;
+                    }
+                    case MixerCommandType::set_voice_pan:
+                    {
+                        MixerVoice* voice = find_voice(command.voice);
+                        if (voice) voice->m_pan = clamp(command.value, -1.0f, 1.0f);
+                        break;
+                    }
+                    case MixerCommandType::set_voice_pitch:
+                    {
+                        MixerVoice* voice = find_voice(command.voice);
+                        if (voice) voice->m_pitch = max(command.value, 0.0f);
+                        break;
+                    }
+                    case MixerCommandType::set_bus_gain:
+                        m_bus_gains[command.bus] = command.value;
+                        break;
+                    }
+                }
+            }
+
+            // Resamples `num_frames` frames of the voice to the voice buffer. Returns `false` if the voice is finished.
+            bool render_voice(MixerVoice* voice, u32 num_frames, u32 sample_rate)
+            {
+                AudioClip* clip = voice->m_clip;
+                const f32* src = clip->m_samples.data();
+                u32 src_channels = clip->m_num_channels;
+                f64 length = (f64)clip->m_num_frames;
+                f64 step = (f64)clip->m_sample_rate / (f64)sample_rate * (f64)voice->m_pitch;
+                f32* dst = (f32*)m_voice_buffer.data();
+                // Pans mono clips on stereo devices.
+                f32 gains[2] = { voice->m_gain, voice->m_gain };
+                if (src_channels == 1 && m_num_channels == 2)
+                {
+                    gains[0] *= min(1.0f - voice->m_pan, 1.0f);
+                    gains[1] *= min(1.0f + voice->m_pan, 1.0f);
+                }
+                f64 pos = voice->m_position;
+                u32 f = 0;
+                for (; f < num_frames; ++f)
+                {
+                    if (pos >= length)
+                    {
+                        if (!voice->m_loop || length == 0.0) break;
+                        pos = fmod(pos, length);
+                    }
+                    u32 i0 = (u32)pos;
+                    u32 i1 = i0 + 1;
+                    if (i1 >= clip->m_num_frames) i1 = voice->m_loop ? 0 : i0;
+                    f32 t = (f32)(pos - (f64)i0);
+                    for (u32 c = 0; c < m_num_channels; ++c)
+                    {
+                        u32 sc = c % src_channels;
+                        f32 a = src[i0 * src_channels + sc];
+                        f32 b = src[i1 * src_channels + sc];
+                        dst[f * m_num_channels + c] = (a + (b - a) * t) * gains[c & 1];
+                    }
+                    pos += step;
+                }
+                voice->m_position = pos;
+                memzero(dst + f * m_num_channels, sizeof(f32) * (get_chunk_samples() - f * m_num_channels));
+                return f == num_frames;
+            }
+
+            void mix_chunk(u32 num_frames, u32 sample_rate)
+            {
+                // Rounds up so that samples can be processed 4 at a time.
+                usize num_samples = align_upper((usize)num_frames * m_num_channels, 4);
+                memzero(m_bus_buffers.data(), m_bus_buffers.size() * sizeof(Float4));
+                usize i = 0;
+                while (i < m_voices.size())
+                {
+                    MixerVoice* voice = m_voices[i];
+                    bool playing = render_voice(voice, num_frames, sample_rate);
+                    mix_samples(get_bus_buffer(voice->m_bus), (const f32*)m_voice_buffer.data(), num_samples, 1.0f);
+                    if (playing) ++i;
+                    else finish_voice(i);
+                }
+                f32* master = get_bus_buffer(MASTER_BUS);
+                for (u32 bus = 1; bus < m_desc.num_buses; ++bus)
+                {
+                    mix_samples(master, get_bus_buffer(bus), num_samples, m_bus_gains[bus]);
+                }
+                if (m_bus_gains[MASTER_BUS] != 1.0f) scale_samples(master, num_samples, m_bus_gains[MASTER_BUS]);
+            }
+
+            u32 mix(void* dst_buffer, const WaveFormat& format, u32 num_frames)
+            {
+                process_commands();
+                if (format.num_channels != m_num_channels) return 0;
+                usize frame_size = get_frame_size(format.bit_depth, format.num_channels);
+                for (u32 f = 0; f < num_frames; f += MIX_CHUNK_FRAMES)
+                {
+                    u32 n = min(num_frames - f, MIX_CHUNK_FRAMES);
+                    mix_chunk(n, format.sample_rate);
+                    encode_samples((u8*)dst_buffer + f * frame_size, format.bit_depth, get_bus_buffer(MASTER_BUS), (usize)n * m_num_channels);
+                }
+                atom_exchange_u32(&m_num_playing_voices, (u32)m_voices.size());
+                return num_frames;
+            }
+
+            RV submit(const MixerCommand& command)
+            {
+                return m_commands->push(command) ? ok : BasicError::out_of_resource();
+            }
+
+            virtual R<voice_id_t> play(IAudioClip* clip, const VoiceDesc& desc) override
+            {
+                if (desc.bus >= m_desc.num_buses) return BasicError::bad_arguments();
+                AudioClip* c = cast_object<AudioClip>(clip->get_object());
+                if (!c) return BasicError::bad_arguments();
+                if (atom_inc_u32(&m_num_allocated_voices) > m_max_allocated_voices)
+                {
+                    atom_dec_u32(&m_num_allocated_voices);
+                    return BasicError::out_of_resource();
+                }
+                MixerVoice* voice = memnew<MixerVoice>();
+                voice->m_clip = c;
+                voice->m_id = atom_inc_u64(&m_next_voice_id);
+                voice->m_gain = desc.gain;
+                voice->m_pan = clamp(desc.pan, -1.0f, 1.0f);
+                voice->m_pitch = max(desc.pitch, 0.0f);
+                voice->m_bus = desc.bus;
+                voice->m_loop = desc.loop;
+                MixerCommand command;
+                command.type = MixerCommandType::play;
+                command.voice = voice->m_id;
+                command.new_voice = voice;
+                if (!m_commands->push(command))
+                {
+                    memdelete(voice);
+                    atom_dec_u32(&m_num_allocated_voices);
+                    return BasicError::out_of_resource();
+                }
+                return command.voice;
+            }
+            virtual RV stop(voice_id_t voice) override
+            {
+                MixerCommand command;
+                command.type = MixerCommandType::stop;
+                command.voice = voice;
+                return submit(command);
+            }
+            virtual RV set_voice_gain(voice_id_t voice, f32 gain) override
+            {
+                MixerCommand command;
+                command.type = MixerCommandType::set_voice_gain;
+                command.voice = voice;
+                command.value = gain;
+                return submit(command);
+            }
+            virtual RV set_voice_pan(voice_id_t voice, f32 pan) override
+            {
+                MixerCommand command;
+                command.type = MixerCommandType::set_voice_pan;
+                command.voice = voice;
+                command.value = pan;
+                return submit(command);
+            }
+            virtual RV set_voice_pitch(voice_id_t voice, f32 pitch) override
+            {
+                MixerCommand command;
+                command.type = MixerCommandType::set_voice_pitch;
+                command.voice = voice;
+                command.value = pitch;
+                return submit(command);
+            }
+            virtual RV set_bus_gain(u32 bus, f32 gain) override
+            {
+                if (bus >= m_desc.num_buses) return BasicError::bad_arguments();
+                MixerCommand command;
+                command.type = MixerCommandType::set_bus_gain;
+                command.bus = bus;
+                command.value = gain;
+                return submit(command);
+            }
+            virtual u32 get_num_playing_voices() override
+            {
+                return m_num_playing_voices;
+            }
+            virtual void update() override
+            {
+                MixerVoice* voice;
+                while (m_finished_voices->pop(voice))
+                {
+                    memdelete(voice);
+                    atom_dec_u32(&m_num_allocated_voices);
+                }
+            }
+        };
+
+        void register_mixer_types()
+        {
+            register_boxed_type<AudioClip>();
+            impl_interface_for_type<AudioClip, IAudioClip>();
+            register_boxed_type<Mixer>();
+            impl_interface_for_type<Mixer, IMixer>();
+        }
+
+        LUNA_AHI_API R<Ref<IMixer>> new_mixer(IDevice* device, const MixerDesc& desc)
+        {
+            Ref<Mixer> mixer = new_object<Mixer>();
+            lutry
+            {
+                luexp(mixer->init(device, desc));
+            }
+            lucatchret;
+            return Ref<IMixer>(mixer);
+        }
+    }
+}
@@ -5,5 +5,5 @@ luna_sdk_module_target("AHI")
     add_headerfiles("Source/**.hpp", {install = false})
     add_files("**.cpp")
     add_packages("miniaudio")
-    add_deps("Runtime")
+    add_deps("Runtime", "JobSystem")
 target_end()
\ No newline at end of file
@@ -11,6 +11,7 @@
 #include <Luna/Runtime/Result.hpp>
 #include <Luna/Runtime/Ref.hpp>
 #include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/Waitable.hpp>
 
 #ifndef LUNA_ASSET_API
 #define LUNA_ASSET_API
@@ -80,6 +81,15 @@ namespace Luna
             loaded = 3
         };
 
+        //! Describes the resident memory size of one asset data object.
+        struct AssetMemorySize
+        {
+            //! The size, in bytes, of system memory used by the asset data.
+            u64 cpu_size = 0;
+            //! The size, in bytes, of video memory used by the asset data.
+            u64 gpu_size = 0;
+        };
+
         //! Describes one asset type.
         struct AssetTypeDesc
         {
@@ -125,6 +135,27 @@ namespace Luna
             //! This can be `nullptr` if the user calls @ref set_asset_data with `data` equals to `nullptr`. In such case,
             //! this function behaves like unloading existing asset data object.
             RV(*on_set_asset_data)(object_t userdata, asset_t asset, object_t data) = nullptr;
+            //! Called when one asset is being loaded by @ref load_asset_async to get assets that should be loaded before this asset.
+            //! @details The asset system schedules loading of all returned assets before loading this asset, so that
+            //! the asset data of dependencies is usually ready when @ref on_load_asset is called for this asset.
+            //! 
+            //! This function can be `nullptr`, in such case, the asset does not have any dependency.
+            //! @param[in] userdata The userdata.
+            //! @param[in] asset The asset handle of the asset being loaded.
+            //! @param[in] path The VFS path of the asset.
+            //! @param[out] out_dependencies Returns assets that this asset depends on. 
+            RV(*on_get_asset_dependencies)(object_t userdata, asset_t asset, const Path& path, Vector<asset_t>& out_dependencies) = nullptr;
+            //! Called when one asset data object is set to one asset to get the memory size used by the asset data.
+            //! @details The returned size is used by the asset streaming system to enforce the budget set by 
+            //! @ref set_asset_streaming_budget.
+            //! 
+            //! This function can be `nullptr`, in such case, asset data of this type is treated as using no memory, and is never
+            //! evicted by the streaming system.
+            //! @param[in] userdata The userdata.
+            //! @param[in] asset The asset handle of the asset.
+            //! @param[in] data The asset data object.
+            //! @return Returns the resident memory size of the asset data.
+            AssetMemorySize(*on_get_asset_data_size)(object_t userdata, asset_t asset, object_t data) = nullptr;
         };
 
         //! Registers one asset type so the asset system can handle the asset of that type.
@@ -307,6 +338,124 @@ namespace Luna
         //! object will not be changed.
         LUNA_ASSET_API RV load_asset_default_data(asset_t asset, bool force_reload = false);
 
+        //! Identifies the state of one asynchronous asset loading request.
+        enum class AssetLoadRequestState : u8
+        {
+            //! The request is waiting to be processed by asset loading jobs.
+            pending = 0,
+            //! The request is waiting for assets it depends on to be loaded.
+            waiting_for_dependencies = 1,
+            //! The asset is being loaded.
+            loading = 2,
+            //! The request is finished. Call @ref IAssetLoadRequest::get_result to check whether the asset is loaded successfully.
+            finished = 3,
+            //! The request is cancelled before the asset is loaded.
+            cancelled = 4,
+        };
+
+        //! @interface IAssetLoadRequest
+        //! Represents one asynchronous asset loading request created by @ref load_asset_async.
+        //! @details The request is signaled when it is finished or cancelled. Waiting for the request from job system jobs 
+        //! executes other jobs while waiting, so it does not block worker threads.
+        struct IAssetLoadRequest : virtual IWaitable
+        {
+            luiid("{4b9e7d21-0c56-4f3a-8e19-d7a25c6b0f84}");
+
+            //! Gets the asset loaded by this request.
+            virtual asset_t get_asset() = 0;
+
+            //! Gets the state of this request.
+            virtual AssetLoadRequestState get_state() = 0;
+
+            //! Gets the loading result of this request.
+            //! @return Returns the result returned by @ref load_asset, or @ref BasicError::interrupted if the request is cancelled,
+            //! or @ref BasicError::not_ready if the request is not finished.
+            virtual RV get_result() = 0;
+
+            //! Gets the priority of this request.
+            virtual f32 get_priority() = 0;
+
+            //! Sets the priority of this request. Requests with higher priority values are loaded first.
+            //! @details This can be called at any time, for example, every frame based on the screen-space size of objects
+            //! that use the asset. Setting priority for requests that are being loaded or finished has no effect.
+            //! @param[in] priority The new priority value.
+            virtual void set_priority(f32 priority) = 0;
+
+            //! Cancels this request.
+            //! @details Only requests in @ref AssetLoadRequestState::pending or @ref AssetLoadRequestState::waiting_for_dependencies
+            //! state can be cancelled. Since requests for the same asset are shared, cancelling one request cancels it for all users.
+            //! @return Returns `true` if the request is cancelled, returns `false` if the request is loading or finished.
+            virtual bool cancel() = 0;
+        };
+
+        //! Loads asset data asynchronously using asset loading jobs on the job system.
+        //! @details If one request for the same asset is already pending or loading, this function returns the existing 
+        //! request and raises its priority to `priority` if `priority` is higher than the current priority.
+        //! If the asset is already loaded, this function returns one finished request.
+        //! 
+        //! Before one asset is loaded, assets returned by @ref AssetTypeDesc::on_get_asset_dependencies are scheduled with
+        //! the same priority, and the asset is loaded after all of them are finished or cancelled.
+        //! @param[in] asset The asset handle of the asset to load.
+        //! @param[in] priority The priority of the request. Requests with higher priority values are loaded first.
+        //! @param[in] force_reload If this is `true`, the asset data is loaded from file even if the asset is already loaded.
+        //! See @ref load_asset for details.
+        //! @return Returns the asset loading request.
+        LUNA_ASSET_API Ref<IAssetLoadRequest> load_asset_async(asset_t asset, f32 priority = 0.0f, bool force_reload = false);
+
+        //! Sets assets that one asset depends on.
+        //! @details The asset system tracks dependencies between assets, so that when one asset is reloaded by 
+        //! @ref reload_changed_assets, all loaded assets that depend on it are reloaded as well. Dependencies of assets loaded 
+        //! by @ref load_asset_async are set automatically from @ref AssetTypeDesc::on_get_asset_dependencies.
+        //! @param[in] asset The asset handle of the asset to set.
+        //! @param[in] dependencies Assets that `asset` depends on. Existing dependencies of `asset` are replaced.
+        LUNA_ASSET_API void set_asset_dependencies(asset_t asset, Span<const asset_t> dependencies);
+
+        //! Gets assets that depend on the specified asset directly.
+        //! @param[in] asset The asset handle of the asset to query.
+        //! @param[out] out_dependents Returns assets that depend on `asset`. Existing elements in the vector will be preserved.
+        LUNA_ASSET_API void get_asset_dependents(asset_t asset, Vector<asset_t>& out_dependents);
+
+        //! Reloads loaded assets whose files are changed, and all loaded assets that depend on them directly or indirectly.
+        //! @details Assets are reloaded asynchronously as if @ref load_asset_async is called with `force_reload` set to `true`. 
+        //! One asset is reloaded after all of its dependencies that are being reloaded, so that every asset is reloaded only once.
+        //! Assets that are not loaded are not reloaded.
+        //! @param[in] changed_files VFS paths of changed files, like paths returned by @ref VFS::IFileWatcher::poll. 
+        //! Every asset file is mapped to the asset whose path equals to the file path with the extension removed.
+        //! @return Returns the number of assets scheduled for reloading.
+        LUNA_ASSET_API usize reload_changed_assets(Span<const Path> changed_files);
+
+        //! Sets the maximum number of assets that can be loaded asynchronously at the same time.
+        //! @param[in] count The maximum number of concurrent asset loading jobs. Default is 4.
+        LUNA_ASSET_API void set_max_concurrent_asset_loads(u32 count);
+
+        //! Describes the memory budget of the asset streaming system.
+        struct AssetStreamingBudget
+        {
+            //! The maximum size, in bytes, of system memory used by all loaded asset data.
+            u64 cpu_budget = U64_MAX;
+            //! The maximum size, in bytes, of video memory used by all loaded asset data.
+            u64 gpu_budget = U64_MAX;
+        };
+
+        //! Sets the memory budget of the asset streaming system.
+        //! @param[in] budget The budget to set.
+        LUNA_ASSET_API void set_asset_streaming_budget(const AssetStreamingBudget& budget);
+
+        //! Gets the total memory size of all loaded asset data reported by @ref AssetTypeDesc::on_get_asset_data_size.
+        LUNA_ASSET_API AssetMemorySize get_resident_asset_size();
+
+        //! Marks one asset as being used in the current streaming frame, so that it will not be evicted in this frame.
+        //! @details @ref get_asset_data calls this function automatically.
+        //! @param[in] asset The asset handle of the asset to mark.
+        LUNA_ASSET_API void mark_asset_used(asset_t asset);
+
+        //! Enforces the asset streaming budget and begins a new streaming frame. This should be called once per frame.
+        //! @details If the resident asset size exceeds the budget, this function unloads loaded assets that are not referenced 
+        //! outside of the asset system and are not used in the current frame, in least recently used order, until the budget is met.
+        //! Assets are unloaded as if @ref set_asset_data is called with `nullptr`.
+        //! @return Returns the number of assets unloaded.
+        LUNA_ASSET_API usize update_asset_streaming();
+
         //! Gets the asset state.
         //! @param[in] asset The asset handle of the asset to query.
         //! @return Returns the asset state of the specified asset.
@@ -0,0 +1,67 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DerivedDataCache.hpp
+* @author JXMaster
+* @date 2024/3/27
+*/
+#pragma once
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Path.hpp>
+
+#ifndef LUNA_ASSET_API
+#define LUNA_ASSET_API
+#endif
+
+namespace Luna
+{
+    namespace Asset
+    {
+        //! @addtogroup Asset
+        //! @{
+
+        //! Describes the storage of the derived data cache.
+        //! @details The derived data cache stores cooked data (like GPU-ready textures and optimized meshes) generated from asset
+        //! source data, so that the cooking work only needs to be done once for every source data.
+        //! Cached data is stored in two tiers:
+        //! 1. The local tier, which is usually one directory on the local disk.
+        //! 2. The shared tier, which is usually one directory on one network drive shared by all team members.
+        //! Data is looked up in the local tier first, then in the shared tier. Data found in the shared tier is copied to the local tier.
+        struct DerivedDataCacheDesc
+        {
+            //! The VFS directory of the local tier. If this is empty, the local tier is disabled.
+            Path local_dir;
+            //! The VFS directory of the shared tier. If this is empty, the shared tier is disabled.
+            Path shared_dir;
+        };
+
+        //! Sets the storage of the derived data cache.
+        //! @param[in] desc The derived data cache descriptor.
+        LUNA_ASSET_API void set_derived_data_cache(const DerivedDataCacheDesc& desc);
+
+        //! Computes the key of derived data from the source data and the cooker that generates derived data.
+        //! @param[in] cooker The name of the cooker. This must only contain characters that are valid in file names.
+        //! @param[in] cooker_version The version of the cooker. Increase this version when the cooked data format is changed, 
+        //! so that existing cached data is not used.
+        //! @param[in] source_data The source data used to generate derived data.
+        //! @return Returns the key of derived data.
+        LUNA_ASSET_API Name get_derived_data_key(const c8* cooker, u32 cooker_version, Span<const byte_t> source_data);
+
+        //! Gets derived data from the cache.
+        //! @param[in] key The derived data key returned by @ref get_derived_data_key.
+        //! @return Returns one mapped file that contains derived data.
+        //! @par Possible Errors
+        //! * BasicError::not_found if the derived data is not found in any tier.
+        LUNA_ASSET_API R<Ref<IMappedFile>> get_derived_data(const Name& key);
+
+        //! Stores derived data to the cache.
+        //! @details Data is written to all enabled tiers. Failing to write data to the shared tier is ignored.
+        //! @param[in] key The derived data key returned by @ref get_derived_data_key.
+        //! @param[in] data The derived data to store.
+        LUNA_ASSET_API RV put_derived_data(const Name& key, Span<const byte_t> data);
+
+        //! @}
+    }
+}
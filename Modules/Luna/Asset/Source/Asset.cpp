@@ -10,32 +10,40 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_ASSET_API LUNA_EXPORT
 #include "Asset.hpp"
-#include <Luna/Runtime/UniquePtr.hpp>
 #include <Luna/Runtime/Mutex.hpp>
 #include <Luna/Runtime/Random.hpp>
-#include <Luna/Runtime/SelfIndexedHashMap.hpp>
+#include "AssetRegistry.hpp"
 #include "AssetType.hpp"
+#include "AssetLoader.hpp"
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/VFS/VFS.hpp>
 #include <Luna/Runtime/Serialization.hpp>
 #include <Luna/VariantUtils/JSON.hpp>
 #include <Luna/Runtime/Reflection.hpp>
+#include <Luna/Runtime/Profiler.hpp>
 #include <Luna/VariantUtils/VariantUtils.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
 
 namespace Luna
 {
     namespace Asset
     {
-        struct AssetEntryExtractKey
+        // Serializes operations that change asset paths, so that the path map and asset entries are updated
+        // atomically. Lookups by GUID or path do not acquire this lock.
+        FutexMutex g_assets_mutex;
+        AssetGuidMap g_assets;
+        AssetPathMap g_asset_path_mapping;
+
+        struct AssetMetaCacheEntry
         {
-            Guid operator()(const UniquePtr<AssetEntry>& v)
-            {
-                return v->guid;
-            }
+            i64 last_write_time;
+            u64 size;
+            AssetMetaFile meta_file;
         };
-        Ref<IMutex> g_assets_mutex;
-        SelfIndexedHashMap<Guid, UniquePtr<AssetEntry>, AssetEntryExtractKey> g_assets;
-        HashMap<Path, asset_t> g_asset_path_mapping;
+        // Caches parsed meta files by meta file paths, so that reloading one directory only parses meta files that are changed.
+        HashMap<Path, AssetMetaCacheEntry> g_asset_meta_cache;
+        SpinLock g_asset_meta_cache_lock;
         void init_asset_registry()
         {
             register_struct_type<AssetMetaFile>({
@@ -43,14 +51,13 @@ namespace Luna
                 luproperty(AssetMetaFile, Name, type)
                 });
             set_serializable<AssetMetaFile>();
-            g_assets_mutex = new_mutex();
         }
         void close_asset_registry()
         {
             g_assets.clear();
-            g_assets.shrink_to_fit();
             g_asset_path_mapping.clear();
-            g_asset_path_mapping.shrink_to_fit();
+            g_asset_meta_cache.clear();
+            g_asset_meta_cache.shrink_to_fit();
         }
         inline AssetState internal_get_asset_state(AssetEntry* entry)
         {
@@ -81,6 +88,11 @@ namespace Luna
         }
         static RV internal_save_asset_meta(const AssetMetaFile& file, const Path& meta_path)
         {
+            {
+                // The timestamp may not change if the file is written multiple times in one second.
+                LockGuard guard(g_asset_meta_cache_lock);
+                g_asset_meta_cache.erase(meta_path);
+            }
             lutry
             {
                 lulet(f, VFS::open_file(meta_path, FileOpenFlag::write | FileOpenFlag::user_buffering, FileCreationMode::create_always));
@@ -92,22 +104,8 @@ namespace Luna
         }
         LUNA_ASSET_API asset_t get_asset(const Guid& guid)
         {
-            MutexGuard g(g_assets_mutex);
-            if (guid != Guid(0, 0))
-            {
-                auto iter = g_assets.find(guid);
-                if (iter != g_assets.end())
-                {
-                    asset_t ret;
-                    ret.handle = iter->get();
-                    return ret;
-                }
-            }
-            UniquePtr<AssetEntry> entry(memnew<AssetEntry>());
-            entry->guid = guid == Guid(0, 0) ? random_guid() : guid;
             asset_t ret;
-            ret.handle = entry.get();
-            g_assets.insert(move(entry));
+            ret.handle = g_assets.find_or_insert(guid == Guid(0, 0) ? random_guid() : guid);
             return ret;
         }
         LUNA_ASSET_API RV register_asset(asset_t asset, const Name& type)
@@ -122,9 +120,8 @@ namespace Luna
         {
             if(!path.empty())
             {
-                MutexGuard g1(g_assets_mutex);
-                auto iter = g_asset_path_mapping.find(path);
-                if (iter != g_asset_path_mapping.end()) return iter->second;
+                auto r = g_asset_path_mapping.find(path);
+                if (succeeded(r)) return r.get();
             }
             asset_t ret = get_asset();
             if(save_meta_to_file)
@@ -144,7 +141,7 @@ namespace Luna
             entry->type = type;
             if(!path.empty())
             {
-                g_asset_path_mapping.insert(make_pair(path, ret));
+                g_asset_path_mapping.insert(path, ret);
             }
             return ret;
         }
@@ -153,7 +150,39 @@ namespace Luna
             Path path;
             AssetMetaFile meta_file;
         };
-        static RV recursive_load_asset_meta(const Path& directory, Vector<AssetMetaUpdateInfo>& assets)
+        static R<AssetMetaFile> internal_load_asset_meta_cached(const Path& meta_path)
+        {
+            auto attr = VFS::get_file_attribute(meta_path);
+            if (succeeded(attr))
+            {
+                LockGuard guard(g_asset_meta_cache_lock);
+                auto iter = g_asset_meta_cache.find(meta_path);
+                if (iter != g_asset_meta_cache.end() &&
+                    iter->second.last_write_time == attr.get().last_write_time &&
+                    iter->second.size == attr.get().size)
+                {
+                    return iter->second.meta_file;
+                }
+            }
+            auto r = internal_load_asset_meta(meta_path);
+            if (succeeded(r) && succeeded(attr))
+            {
+                AssetMetaCacheEntry entry;
+                entry.last_write_time = attr.get().last_write_time;
+                entry.size = attr.get().size;
+                entry.meta_file = r.get();
+                LockGuard guard(g_asset_meta_cache_lock);
+                g_asset_meta_cache.insert_or_assign(meta_path, move(entry));
+            }
+            return r;
+        }
+        struct AssetDirectoryScanResult
+        {
+            Vector<Path> subdirectories;
+            Vector<Path> meta_files;
+            RV result = ok;
+        };
+        static RV scan_asset_directory(const Path& directory, AssetDirectoryScanResult& out)
         {
             lutry
             {
@@ -166,16 +195,11 @@ namespace Luna
                     path.push_back(filename);
                     if(test_flags(iter->get_attributes(), FileAttributeFlag::directory))
                     {
-                        luexp(recursive_load_asset_meta(path, assets));
+                        out.subdirectories.push_back(path);
                     }
                     else if(path.extension() == "meta")
                     {
-                        lulet(meta_file, internal_load_asset_meta(path));
-                        AssetMetaUpdateInfo info;
-                        path.remove_extension();
-                        info.path = path;
-                        info.meta_file = move(meta_file);
-                        assets.push_back(move(info));
+                        out.meta_files.push_back(path);
                     }
                     path.pop_back();
                 }
@@ -183,6 +207,49 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        //! Collects all meta files in the directory recursively. Directories of the same depth are enumerated in parallel.
+        static RV collect_asset_meta_files(const Path& directory, Vector<Path>& meta_files)
+        {
+            Vector<Path> directories;
+            directories.push_back(directory);
+            Vector<AssetDirectoryScanResult> results;
+            while (!directories.empty())
+            {
+                results.clear();
+                results.resize(directories.size());
+                JobSystem::parallel_for(0, directories.size(), 1, [&](usize i)
+                {
+                    results[i].result = scan_asset_directory(directories[i], results[i]);
+                });
+                directories.clear();
+                for (auto& r : results)
+                {
+                    if (failed(r.result)) return r.result;
+                    for (auto& d : r.subdirectories) directories.push_back(move(d));
+                    for (auto& f : r.meta_files) meta_files.push_back(move(f));
+                }
+            }
+            return ok;
+        }
+        static RV load_asset_meta_files(const Vector<Path>& meta_files, Vector<AssetMetaUpdateInfo>& assets)
+        {
+            Vector<R<AssetMetaFile>> results(meta_files.size(), R<AssetMetaFile>(BasicError::failure()));
+            JobSystem::parallel_for(0, meta_files.size(), 0, [&](usize i)
+            {
+                results[i] = internal_load_asset_meta_cached(meta_files[i]);
+            });
+            assets.reserve(assets.size() + meta_files.size());
+            for (usize i = 0; i < meta_files.size(); ++i)
+            {
+                if (failed(results[i])) return results[i].errcode();
+                AssetMetaUpdateInfo info;
+                info.path = meta_files[i];
+                info.path.remove_extension();
+                info.meta_file = move(results[i].get());
+                assets.push_back(move(info));
+            }
+            return ok;
+        }
 
         LUNA_ASSET_API RV load_assets_meta(const Path& path, bool allow_overwrite)
         {
@@ -193,7 +260,10 @@ namespace Luna
                 auto attr = VFS::get_file_attribute(path);
                 if(succeeded(attr) && test_flags(attr.get().attributes, FileAttributeFlag::directory))
                 {
-                    luexp(recursive_load_asset_meta(path, update_assets));
+                    // Enumerates directories and parses meta files in parallel, then registers all assets in one pass.
+                    Vector<Path> meta_files;
+                    luexp(collect_asset_meta_files(path, meta_files));
+                    luexp(load_asset_meta_files(meta_files, update_assets));
                 }
                 else
                 {
@@ -206,7 +276,7 @@ namespace Luna
                     update_assets.push_back(move(info));
                 }
                 // Do update.
-                MutexGuard g(g_assets_mutex);
+                LockGuard g(g_assets_mutex);
                 for(auto& info : update_assets)
                 {
                     auto asset = get_asset(info.meta_file.guid);
@@ -217,15 +287,11 @@ namespace Luna
                     {
                         if(state != AssetState::unregistered)
                         {
-                            auto iter = g_asset_path_mapping.find(entry->path);
-                            if(iter != g_asset_path_mapping.end() && iter->second == asset)
-                            {
-                                g_asset_path_mapping.erase(iter);    
-                            }
+                            g_asset_path_mapping.erase(entry->path, asset);
                         }
                         entry->type = info.meta_file.type;
                         entry->path = info.path;
-                        g_asset_path_mapping.insert(make_pair(entry->path, asset));
+                        g_asset_path_mapping.insert(entry->path, asset);
                     }
                 }
             }
@@ -273,10 +339,7 @@ namespace Luna
         }
         LUNA_ASSET_API R<asset_t> get_asset_by_path(const Path& path)
         {
-            MutexGuard g1(g_assets_mutex);
-            auto iter = g_asset_path_mapping.find(path);
-            if (iter != g_asset_path_mapping.end()) return iter->second;
-            return BasicError::not_found();
+            return g_asset_path_mapping.find(path);
         }
         LUNA_ASSET_API Guid get_asset_guid(asset_t asset)
         {
@@ -295,11 +358,10 @@ namespace Luna
         {
             lucheck_msg(asset.handle, "Asset handle must not be null!");
             AssetEntry* entry = (AssetEntry*)asset.handle;
-            MutexGuard g1(g_assets_mutex);
+            LockGuard g1(g_assets_mutex);
             LockGuard guard(entry->lock);
-            auto iter = g_asset_path_mapping.insert(make_pair(path, asset));
-            if(!iter.second) return BasicError::already_exists();
-            g_asset_path_mapping.erase(entry->path);
+            if(!g_asset_path_mapping.insert(path, asset)) return BasicError::already_exists();
+            g_asset_path_mapping.erase(entry->path, asset);
             entry->path = path;
             return ok;
         }
@@ -370,8 +432,8 @@ namespace Luna
                 luexp(get_asset_files(asset, files));
                 auto path = get_asset_path(asset);
                 {
-                    MutexGuard g(g_assets_mutex);
-                    g_asset_path_mapping.erase(path);
+                    LockGuard g(g_assets_mutex);
+                    g_asset_path_mapping.erase(path, asset);
                 }
                 path.pop_back();
                 for (auto& f : files)
@@ -390,11 +452,8 @@ namespace Luna
         LUNA_ASSET_API RV move_asset(asset_t asset, const Path& new_path)
         {
             lucheck_msg(asset.handle, "Asset handle must not be null!");
-            MutexGuard g1(g_assets_mutex);
-            {
-                auto iter = g_asset_path_mapping.find(new_path);
-                if (iter != g_asset_path_mapping.end()) return BasicError::already_exists();
-            }
+            LockGuard g1(g_assets_mutex);
+            if (succeeded(g_asset_path_mapping.find(new_path))) return BasicError::already_exists();
             lutry
             {
                 auto from_path = get_asset_path(asset);
@@ -421,9 +480,9 @@ namespace Luna
                 }
                 AssetEntry* entry = (AssetEntry*)asset.handle;
                 LockGuard guard(entry->lock);
-                g_asset_path_mapping.erase(entry->path);
+                g_asset_path_mapping.erase(entry->path, asset);
                 entry->path = new_path;
-                g_asset_path_mapping.insert(make_pair(entry->path, asset));
+                g_asset_path_mapping.insert(entry->path, asset);
                 AssetMetaFile meta_file;
                 meta_file.type = entry->type;
                 meta_file.guid = entry->guid;
@@ -439,6 +498,7 @@ namespace Luna
         {
             if(!asset.handle) return ObjRef();
             AssetEntry* entry = (AssetEntry*)asset.handle;
+            entry->last_used_frame = g_asset_streaming_frame;
             LockGuard g(entry->lock);
             return entry->data;
         }
@@ -447,6 +507,7 @@ namespace Luna
             lucheck_msg(asset.handle, "Asset handle must not be null!");
             AssetEntry* entry = (AssetEntry*)asset.handle;
             LockGuard g(entry->lock);
+            AssetMemorySize data_size;
             lutry
             {
                 lulet(desc, get_asset_type_desc(entry->type));
@@ -454,9 +515,10 @@ namespace Luna
                 {
                     luexp(desc.on_set_asset_data(desc.userdata.get(), asset, data));
                 }
+                data_size = get_asset_data_size(desc, asset, data);
             }
             lucatchret;
-            entry->data = data;
+            set_asset_entry_data(entry, ObjRef(data), data_size);
             return ok;
         }
         LUNA_ASSET_API RV load_asset(asset_t asset, bool force_reload)
@@ -485,14 +547,16 @@ namespace Luna
                 ObjRef data;
                 if (desc.on_load_asset)
                 {
+                    LUNA_PROFILE_ZONE(type.c_str());
                     luset(data, desc.on_load_asset(desc.userdata.get(), asset, path));
                 }
                 else
                 {
                     luthrow(set_error(BasicError::not_supported(), "Asset loading is not implemented by asset %s", type.c_str()));
                 }
+                AssetMemorySize data_size = get_asset_data_size(desc, asset, data.get());
                 g = entry->lock;
-                entry->data = data;
+                set_asset_entry_data(entry, data, data_size);
                 entry->loading = false;
                 g.unlock();
             }
@@ -532,8 +596,9 @@ namespace Luna
                 {
                     luthrow(set_error(BasicError::not_supported(), "Asset default data loading is not implemented by asset %s", entry->type.c_str()));
                 }
+                AssetMemorySize data_size = get_asset_data_size(desc, asset, data.get());
                 g = entry->lock;
-                entry->data = data;
+                set_asset_entry_data(entry, data, data_size);
                 entry->loading = false;
                 g.unlock();
             }
@@ -581,8 +646,9 @@ namespace Luna
         }
         LUNA_ASSET_API void close()
         {
-            MutexGuard guard(g_assets_mutex);
-            MutexGuard guard2(g_asset_types_mutex);
+            LockGuard guard(g_assets_mutex);
+            LockGuard guard2(g_asset_types_mutex);
+            close_asset_streaming();
             close_asset_registry();
             close_asset_type();
         }
@@ -591,12 +657,15 @@ namespace Luna
             virtual const c8* get_name() override { return "Asset"; }
             virtual RV on_register() override
             {
-                return add_dependency_modules(this, {module_variant_utils(), module_vfs()});
+                return add_dependency_modules(this, {module_variant_utils(), module_vfs(), module_job_system()});
             }
             virtual RV on_init() override
             {
                 init_asset_type();
                 init_asset_registry();
+                init_asset_loader();
+                init_asset_streaming();
+                init_asset_dependencies();
                 register_struct_type<asset_t>({});
                 SerializableTypeDesc desc;
                 desc.serialize_func = [](typeinfo_t type, const void* inst) -> R<Variant>
@@ -624,10 +693,11 @@ namespace Luna
             }
             virtual void on_close() override
             {
+                close_asset_loader();
+                close_asset_dependencies();
+                close_asset_streaming();
                 close_asset_registry();
                 close_asset_type();
-                g_assets_mutex.reset();
-                g_asset_types_mutex.reset();
             }
         };
     }
@@ -33,17 +33,36 @@ namespace Luna
             ObjRef data;
             bool loading;
             SpinLock lock;
+            // The memory size of `data`.
+            AssetMemorySize data_size;
+            // The last streaming frame that this asset is used.
+            u64 last_used_frame;
             AssetEntry() :
-                loading(false) {}
-            void reset()
-            {
-                type.reset();
-                path.clear();
-                data.reset();
-                loading = false;
-            }
+                loading(false),
+                last_used_frame(0) {}
+            void reset();
         };
+        // Sets the asset data object of one entry and updates the resident asset size. 
+        // Must be called with `entry->lock` locked.
+        void set_asset_entry_data(AssetEntry* entry, ObjRef data, const AssetMemorySize& data_size);
+        // Gets the memory size of one asset data object. Returns zero size if `data` is `nullptr`.
+        AssetMemorySize get_asset_data_size(const AssetTypeDesc& desc, asset_t asset, object_t data);
+        inline void AssetEntry::reset()
+        {
+            type.reset();
+            path.clear();
+            set_asset_entry_data(this, ObjRef(), AssetMemorySize());
+            loading = false;
+        }
         void init_asset_registry();
         void close_asset_registry();
+        void init_asset_streaming();
+        void close_asset_streaming();
+        void init_asset_dependencies();
+        void close_asset_dependencies();
+        // Gets dependencies set by `set_asset_dependencies`.
+        void get_recorded_asset_dependencies(asset_t asset, Vector<asset_t>& out_dependencies);
+        // The index of the current streaming frame, increased by `update_asset_streaming`.
+        extern volatile u64 g_asset_streaming_frame;
     }
 }
\ No newline at end of file
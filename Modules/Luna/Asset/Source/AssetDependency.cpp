@@ -0,0 +1,102 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AssetDependency.cpp
+* @author JXMaster
+* @date 2024/3/28
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_ASSET_API LUNA_EXPORT
+#include "Asset.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Futex.hpp>
+
+namespace Luna
+{
+    namespace Asset
+    {
+        FutexMutex g_dependencies_mutex;
+        // Maps every asset to assets it depends on.
+        HashMap<opaque_t, Vector<asset_t>> g_asset_dependencies;
+        // Maps every asset to assets that depend on it.
+        HashMap<opaque_t, Vector<asset_t>> g_asset_dependents;
+
+        void init_asset_dependencies()
+        {
+        }
+        void close_asset_dependencies()
+        {
+            g_asset_dependencies.clear();
+            g_asset_dependencies.shrink_to_fit();
+            g_asset_dependents.clear();
+            g_asset_dependents.shrink_to_fit();
+        }
+        static void remove_dependent(asset_t dependency, asset_t dependent)
+        {
+            auto iter = g_asset_dependents.find(dependency.handle);
+            if (iter == g_asset_dependents.end()) return;
+            auto& dependents = iter->second;
+            for (usize i = 0; i < dependents.size(); ++i)
+            {
+                if (dependents[i] == dependent)
+                {
+                    dependents[i] = dependents.back();
+                    dependents.pop_back();
+                    break;
+                }
+            }
+            if (dependents.empty()) g_asset_dependents.erase(iter);
+        }
+        LUNA_ASSET_API void set_asset_dependencies(asset_t asset, Span<const asset_t> dependencies)
+        {
+            lucheck_msg(asset.handle, "Asset handle must not be null!");
+            LockGuard guard(g_dependencies_mutex);
+            auto iter = g_asset_dependencies.find(asset.handle);
+            if (iter != g_asset_dependencies.end())
+            {
+                for (asset_t dependency : iter->second)
+                {
+                    remove_dependent(dependency, asset);
+                }
+                g_asset_dependencies.erase(iter);
+            }
+            if (dependencies.empty()) return;
+            Vector<asset_t> deps;
+            for (asset_t dependency : dependencies)
+            {
+                if (!dependency || dependency == asset) continue;
+                bool duplicated = false;
+                for (asset_t dep : deps)
+                {
+                    if (dep == dependency)
+                    {
+                        duplicated = true;
+                        break;
+                    }
+                }
+                if (duplicated) continue;
+                deps.push_back(dependency);
+                auto dependents = g_asset_dependents.insert(make_pair(dependency.handle, Vector<asset_t>())).first;
+                dependents->second.push_back(asset);
+            }
+            g_asset_dependencies.insert(make_pair(asset.handle, move(deps)));
+        }
+        void get_recorded_asset_dependencies(asset_t asset, Vector<asset_t>& out_dependencies)
+        {
+            LockGuard guard(g_dependencies_mutex);
+            auto iter = g_asset_dependencies.find(asset.handle);
+            if (iter == g_asset_dependencies.end()) return;
+            out_dependencies.insert(out_dependencies.end(), iter->second.begin(), iter->second.end());
+        }
+        LUNA_ASSET_API void get_asset_dependents(asset_t asset, Vector<asset_t>& out_dependents)
+        {
+            lucheck_msg(asset.handle, "Asset handle must not be null!");
+            LockGuard guard(g_dependencies_mutex);
+            auto iter = g_asset_dependents.find(asset.handle);
+            if (iter == g_asset_dependents.end()) return;
+            out_dependents.insert(out_dependents.end(), iter->second.begin(), iter->second.end());
+        }
+    }
+}
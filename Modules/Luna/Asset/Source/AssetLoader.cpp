@@ -0,0 +1,364 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AssetLoader.cpp
+* @author JXMaster
+* @date 2024/3/25
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_ASSET_API LUNA_EXPORT
+#include "AssetLoader.hpp"
+#include "AssetType.hpp"
+#include "Asset.hpp"
+#include <Luna/Runtime/Futex.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/HashSet.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/PerfCounter.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+
+namespace Luna
+{
+    namespace Asset
+    {
+        struct AssetLoadRequest : IAssetLoadRequest
+        {
+            lustruct("Asset::AssetLoadRequest", "{c73d0a5e-2f81-4b96-a4e7-91d5b03c6f28}");
+            luiimpl();
+
+            asset_t m_asset;
+            // Allocated when the request is created, and finished when the request is finished or cancelled.
+            JobSystem::job_id_t m_job_id;
+
+            // The following members are guarded by `g_loader_mutex`.
+            f32 m_priority = 0.0f;
+            AssetLoadRequestState m_state = AssetLoadRequestState::pending;
+            RV m_result = BasicError::not_ready();
+            bool m_dependencies_resolved = false;
+            bool m_force_reload = false;
+            u32 m_num_pending_dependencies = 0;
+            // Requests that wait for this request to finish.
+            Vector<Ref<AssetLoadRequest>> m_dependents;
+
+            virtual void wait() override
+            {
+                JobSystem::wait_job(m_job_id);
+            }
+            virtual bool try_wait() override
+            {
+                return JobSystem::is_job_finished(m_job_id);
+            }
+            virtual asset_t get_asset() override
+            {
+                return m_asset;
+            }
+            virtual AssetLoadRequestState get_state() override;
+            virtual RV get_result() override;
+            virtual f32 get_priority() override;
+            virtual void set_priority(f32 priority) override;
+            virtual bool cancel() override;
+        };
+
+        FutexMutex g_loader_mutex;
+        // Requests that are not finished or cancelled, indexed by asset handles.
+        HashMap<opaque_t, Ref<AssetLoadRequest>> g_inflight_requests;
+        // Requests in `AssetLoadRequestState::pending` state. Priorities can be changed at any time, so the
+        // request with the highest priority is searched when one request is popped.
+        Vector<Ref<AssetLoadRequest>> g_pending_requests;
+        u32 g_num_running_loaders;
+        u32 g_max_running_loaders;
+
+        static void erase_pending_request(AssetLoadRequest* request)
+        {
+            for (usize i = 0; i < g_pending_requests.size(); ++i)
+            {
+                if (g_pending_requests[i].get() == request)
+                {
+                    g_pending_requests[i] = move(g_pending_requests.back());
+                    g_pending_requests.pop_back();
+                    return;
+                }
+            }
+        }
+        static Ref<AssetLoadRequest> pop_pending_request()
+        {
+            if (g_pending_requests.empty()) return nullptr;
+            usize index = 0;
+            for (usize i = 1; i < g_pending_requests.size(); ++i)
+            {
+                if (g_pending_requests[i]->m_priority > g_pending_requests[index]->m_priority)
+                {
+                    index = i;
+                }
+            }
+            Ref<AssetLoadRequest> ret = move(g_pending_requests[index]);
+            g_pending_requests[index] = move(g_pending_requests.back());
+            g_pending_requests.pop_back();
+            return ret;
+        }
+        // Called with `g_loader_mutex` locked.
+        static void finish_request(AssetLoadRequest* request, AssetLoadRequestState state, RV result)
+        {
+            request->m_state = state;
+            request->m_result = result;
+            auto iter = g_inflight_requests.find(request->m_asset.handle);
+            if (iter != g_inflight_requests.end() && iter->second.get() == request)
+            {
+                g_inflight_requests.erase(iter);
+            }
+            for (auto& dependent : request->m_dependents)
+            {
+                --dependent->m_num_pending_dependencies;
+                if (!dependent->m_num_pending_dependencies && dependent->m_state == AssetLoadRequestState::waiting_for_dependencies)
+                {
+                    dependent->m_state = AssetLoadRequestState::pending;
+                    g_pending_requests.push_back(dependent);
+                }
+            }
+            request->m_dependents.clear();
+            JobSystem::finish_job_id(request->m_job_id);
+        }
+        // Called with `g_loader_mutex` locked.
+        static Ref<AssetLoadRequest> get_or_create_request(asset_t asset, f32 priority, bool force_reload)
+        {
+            auto iter = g_inflight_requests.find(asset.handle);
+            if (iter != g_inflight_requests.end() && 
+                (!force_reload || iter->second->m_state == AssetLoadRequestState::pending || iter->second->m_state == AssetLoadRequestState::waiting_for_dependencies))
+            {
+                iter->second->m_priority = max(iter->second->m_priority, priority);
+                iter->second->m_force_reload |= force_reload;
+                return iter->second;
+            }
+            Ref<AssetLoadRequest> request = new_object<AssetLoadRequest>();
+            request->m_asset = asset;
+            request->m_priority = priority;
+            request->m_force_reload = force_reload;
+            request->m_job_id = JobSystem::allocate_job_id();
+            if (!force_reload && get_asset_state(asset) == AssetState::loaded)
+            {
+                request->m_state = AssetLoadRequestState::finished;
+                request->m_result = ok;
+                JobSystem::finish_job_id(request->m_job_id);
+                return request;
+            }
+            if (iter != g_inflight_requests.end())
+            {
+                // The asset is being loaded, but one reload is requested. The new request is processed after the 
+                // current loading is finished, so that the latest file data is loaded.
+                request->m_state = AssetLoadRequestState::waiting_for_dependencies;
+                request->m_num_pending_dependencies = 1;
+                iter->second->m_dependents.push_back(request);
+                iter->second = request;
+                return request;
+            }
+            g_inflight_requests.insert(make_pair(asset.handle, request));
+            g_pending_requests.push_back(request);
+            return request;
+        }
+        // The number of assets being loaded by loader jobs.
+        perf_counter_t g_loads_in_flight_counter = 0;
+        // The number of asset loads finished by loader jobs.
+        perf_counter_t g_finished_loads_counter = 0;
+        static void asset_loader_job(void* params);
+        // Called with `g_loader_mutex` locked.
+        static void submit_loader_jobs()
+        {
+            while (g_num_running_loaders < g_max_running_loaders && g_num_running_loaders < g_pending_requests.size())
+            {
+                ++g_num_running_loaders;
+                void* job = JobSystem::new_job(asset_loader_job, sizeof(usize), alignof(usize));
+                JobSystem::submit_job(job, JobSystem::JobPriority::io);
+            }
+        }
+        static Vector<asset_t> get_asset_dependencies(asset_t asset)
+        {
+            Vector<asset_t> dependencies;
+            Name type = get_asset_type(asset);
+            auto desc = get_asset_type_desc(type);
+            if (succeeded(desc) && desc.get().on_get_asset_dependencies)
+            {
+                auto r = desc.get().on_get_asset_dependencies(desc.get().userdata.get(), asset, get_asset_path(asset), dependencies);
+                // Dependencies are only used for scheduling, so failing to get dependencies does not fail the loading.
+                if (succeeded(r))
+                {
+                    set_asset_dependencies(asset, dependencies.cspan());
+                    return dependencies;
+                }
+                dependencies.clear();
+            }
+            // Uses dependencies set by the user.
+            get_recorded_asset_dependencies(asset, dependencies);
+            return dependencies;
+        }
+        static void asset_loader_job(void* params)
+        {
+            LockGuard guard(g_loader_mutex);
+            while (true)
+            {
+                Ref<AssetLoadRequest> request = pop_pending_request();
+                if (!request) break;
+                request->m_state = AssetLoadRequestState::loading;
+                if (!request->m_dependencies_resolved)
+                {
+                    request->m_dependencies_resolved = true;
+                    guard.unlock();
+                    Vector<asset_t> dependencies = get_asset_dependencies(request->m_asset);
+                    guard = g_loader_mutex;
+                    for (asset_t dependency : dependencies)
+                    {
+                        if (!dependency || dependency == request->m_asset) continue;
+                        Ref<AssetLoadRequest> dep = get_or_create_request(dependency, request->m_priority, false);
+                        // Requests that are waiting for dependencies are not waited, which breaks dependency cycles.
+                        if (dep->m_state == AssetLoadRequestState::finished ||
+                            dep->m_state == AssetLoadRequestState::cancelled ||
+                            dep->m_state == AssetLoadRequestState::waiting_for_dependencies) continue;
+                        dep->m_dependents.push_back(request);
+                        ++request->m_num_pending_dependencies;
+                    }
+                    if (request->m_num_pending_dependencies)
+                    {
+                        request->m_state = AssetLoadRequestState::waiting_for_dependencies;
+                        submit_loader_jobs();
+                        continue;
+                    }
+                }
+                guard.unlock();
+                perf_counter_add(g_loads_in_flight_counter, 1);
+                RV r = load_asset(request->m_asset, request->m_force_reload);
+                perf_counter_add(g_loads_in_flight_counter, -1);
+                perf_counter_add(g_finished_loads_counter, 1);
+                if (failed(r))
+                {
+                    log_error("Asset", "Failed to load asset %s: %s", get_asset_path(request->m_asset).encode().c_str(), explain(r.errcode()));
+                }
+                guard = g_loader_mutex;
+                finish_request(request.get(), AssetLoadRequestState::finished, r);
+                submit_loader_jobs();
+            }
+            --g_num_running_loaders;
+        }
+        AssetLoadRequestState AssetLoadRequest::get_state()
+        {
+            LockGuard guard(g_loader_mutex);
+            return m_state;
+        }
+        RV AssetLoadRequest::get_result()
+        {
+            LockGuard guard(g_loader_mutex);
+            return m_result;
+        }
+        f32 AssetLoadRequest::get_priority()
+        {
+            LockGuard guard(g_loader_mutex);
+            return m_priority;
+        }
+        void AssetLoadRequest::set_priority(f32 priority)
+        {
+            LockGuard guard(g_loader_mutex);
+            m_priority = priority;
+        }
+        bool AssetLoadRequest::cancel()
+        {
+            LockGuard guard(g_loader_mutex);
+            if (m_state == AssetLoadRequestState::pending)
+            {
+                erase_pending_request(this);
+            }
+            else if (m_state != AssetLoadRequestState::waiting_for_dependencies)
+            {
+                return false;
+            }
+            finish_request(this, AssetLoadRequestState::cancelled, BasicError::interrupted());
+            return true;
+        }
+        void init_asset_loader()
+        {
+            register_boxed_type<AssetLoadRequest>();
+            impl_interface_for_type<AssetLoadRequest, IAssetLoadRequest, IWaitable>();
+            g_num_running_loaders = 0;
+            g_max_running_loaders = 4;
+            g_loads_in_flight_counter = register_perf_counter("Asset.LoadsInFlight", PerfCounterType::gauge);
+            g_finished_loads_counter = register_perf_counter("Asset.FinishedLoads", PerfCounterType::counter);
+        }
+        void close_asset_loader()
+        {
+            LockGuard guard(g_loader_mutex);
+            while (!g_pending_requests.empty())
+            {
+                Ref<AssetLoadRequest> request = move(g_pending_requests.back());
+                g_pending_requests.pop_back();
+                finish_request(request.get(), AssetLoadRequestState::cancelled, BasicError::interrupted());
+            }
+            // Waits for running loading jobs to exit.
+            while (g_num_running_loaders)
+            {
+                guard.unlock();
+                yield_current_thread();
+                guard = g_loader_mutex;
+            }
+            // Requests left here are waiting for dependencies that are cancelled.
+            Vector<Ref<AssetLoadRequest>> requests;
+            for (auto& request : g_inflight_requests) requests.push_back(request.second);
+            for (auto& request : requests)
+            {
+                finish_request(request.get(), AssetLoadRequestState::cancelled, BasicError::interrupted());
+            }
+            g_inflight_requests.clear();
+            g_inflight_requests.shrink_to_fit();
+            g_pending_requests.clear();
+            g_pending_requests.shrink_to_fit();
+            guard.unlock();
+        }
+        LUNA_ASSET_API Ref<IAssetLoadRequest> load_asset_async(asset_t asset, f32 priority, bool force_reload)
+        {
+            lucheck_msg(asset.handle, "Asset handle must not be null!");
+            LockGuard guard(g_loader_mutex);
+            Ref<AssetLoadRequest> request = get_or_create_request(asset, priority, force_reload);
+            submit_loader_jobs();
+            return request;
+        }
+        LUNA_ASSET_API usize reload_changed_assets(Span<const Path> changed_files)
+        {
+            // Collects changed assets and their dependents.
+            Vector<asset_t> assets;
+            HashSet<opaque_t> visited;
+            for (auto& file : changed_files)
+            {
+                Path path = file;
+                path.remove_extension();
+                auto asset = get_asset_by_path(path);
+                if (failed(asset) || !visited.insert(asset.get().handle).second) continue;
+                assets.push_back(asset.get());
+            }
+            for (usize i = 0; i < assets.size(); ++i)
+            {
+                Vector<asset_t> dependents;
+                get_asset_dependents(assets[i], dependents);
+                for (asset_t dependent : dependents)
+                {
+                    if (visited.insert(dependent.handle).second) assets.push_back(dependent);
+                }
+            }
+            // Schedules all reloads in one lock scope, so that every asset waits for reloading of its dependencies.
+            usize num_reloads = 0;
+            LockGuard guard(g_loader_mutex);
+            for (asset_t asset : assets)
+            {
+                if (get_asset_state(asset) != AssetState::loaded) continue;
+                get_or_create_request(asset, 0.0f, true);
+                ++num_reloads;
+            }
+            submit_loader_jobs();
+            return num_reloads;
+        }
+        LUNA_ASSET_API void set_max_concurrent_asset_loads(u32 count)
+        {
+            LockGuard guard(g_loader_mutex);
+            g_max_running_loaders = max<u32>(count, 1);
+            submit_loader_jobs();
+        }
+    }
+}
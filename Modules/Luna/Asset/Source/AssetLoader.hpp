@@ -0,0 +1,20 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AssetLoader.hpp
+* @author JXMaster
+* @date 2024/3/25
+*/
+#pragma once
+#include "../Asset.hpp"
+
+namespace Luna
+{
+    namespace Asset
+    {
+        void init_asset_loader();
+        void close_asset_loader();
+    }
+}
@@ -0,0 +1,204 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AssetRegistry.hpp
+* @author JXMaster
+* @date 2024/3/29
+*/
+#pragma once
+#include "Asset.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+
+namespace Luna
+{
+    namespace Asset
+    {
+        // Maps asset GUIDs to asset entries. The map is split into shards by GUID bits, so that insertions to different shards
+        // do not contend. Entries are never removed from the map until the map is cleared, so lookups can be performed without
+        // locking: every shard stores entries in one open addressing table, and one table is replaced by one larger table
+        // when it is half full, the replaced table is kept alive until the map is cleared since readers may still access it.
+        struct AssetGuidMap
+        {
+            static constexpr usize NUM_SHARDS = 64;
+
+            struct Table
+            {
+                // Always power of two.
+                usize capacity;
+                AssetEntry* volatile* slots() { return (AssetEntry* volatile*)(this + 1); }
+                const AssetEntry* volatile* slots() const { return (const AssetEntry* volatile*)(this + 1); }
+            };
+            struct Shard
+            {
+                Table* volatile table = nullptr;
+                // The number of entries in `table`. Guarded by `lock`.
+                usize size = 0;
+                SpinLock lock;
+                Vector<Table*> retired_tables;
+            };
+            Shard m_shards[NUM_SHARDS];
+
+            static usize get_hash(const Guid& guid)
+            {
+                return hash<Guid>()(guid);
+            }
+            static Table* new_table(usize capacity)
+            {
+                Table* table = (Table*)memalloc(sizeof(Table) + sizeof(AssetEntry*) * capacity, alignof(Table));
+                table->capacity = capacity;
+                memzero((void*)table->slots(), sizeof(AssetEntry*) * capacity);
+                return table;
+            }
+            static AssetEntry* find_in_table(Table* table, const Guid& guid, usize h)
+            {
+                if (!table) return nullptr;
+                usize mask = table->capacity - 1;
+                usize i = (h / NUM_SHARDS) & mask;
+                while (true)
+                {
+                    AssetEntry* entry = table->slots()[i];
+                    if (!entry) return nullptr;
+                    if (entry->guid == guid) return entry;
+                    i = (i + 1) & mask;
+                }
+            }
+            static void insert_to_table(Table* table, AssetEntry* entry, usize h)
+            {
+                usize mask = table->capacity - 1;
+                usize i = (h / NUM_SHARDS) & mask;
+                while (table->slots()[i]) i = (i + 1) & mask;
+                // Uses one atomic operation to publish the entry, so that readers see the fully constructed entry.
+                atom_exchange_pointer(&table->slots()[i], entry);
+            }
+            //! Finds the entry with the specified GUID. This function is lock-free.
+            AssetEntry* find(const Guid& guid)
+            {
+                usize h = get_hash(guid);
+                return find_in_table(m_shards[h % NUM_SHARDS].table, guid, h);
+            }
+            //! Finds the entry with the specified GUID, or creates one new entry if not found.
+            AssetEntry* find_or_insert(const Guid& guid)
+            {
+                usize h = get_hash(guid);
+                Shard& shard = m_shards[h % NUM_SHARDS];
+                AssetEntry* entry = find_in_table(shard.table, guid, h);
+                if (entry) return entry;
+                LockGuard guard(shard.lock);
+                // Checks again, since the entry may be inserted by other threads before the lock is acquired.
+                entry = find_in_table(shard.table, guid, h);
+                if (entry) return entry;
+                entry = memnew<AssetEntry>();
+                entry->guid = guid;
+                Table* table = shard.table;
+                if (!table || (shard.size + 1) * 2 > table->capacity)
+                {
+                    Table* new_tbl = new_table(table ? table->capacity * 2 : 64);
+                    if (table)
+                    {
+                        for (usize i = 0; i < table->capacity; ++i)
+                        {
+                            AssetEntry* e = table->slots()[i];
+                            if (e) insert_to_table(new_tbl, e, get_hash(e->guid));
+                        }
+                        shard.retired_tables.push_back(table);
+                    }
+                    insert_to_table(new_tbl, entry, h);
+                    atom_exchange_pointer(&shard.table, new_tbl);
+                }
+                else
+                {
+                    insert_to_table(table, entry, h);
+                }
+                ++shard.size;
+                return entry;
+            }
+            //! Deletes all entries. This must not be called when other threads are accessing the map.
+            void clear()
+            {
+                for (auto& shard : m_shards)
+                {
+                    Table* table = shard.table;
+                    if (table)
+                    {
+                        for (usize i = 0; i < table->capacity; ++i)
+                        {
+                            AssetEntry* e = table->slots()[i];
+                            if (e) memdelete(e);
+                        }
+                        memfree(table);
+                        shard.table = nullptr;
+                    }
+                    for (Table* t : shard.retired_tables) memfree(t);
+                    shard.retired_tables.clear();
+                    shard.retired_tables.shrink_to_fit();
+                    shard.size = 0;
+                }
+            }
+        };
+
+        // Maps asset paths to asset handles. The map is split into shards by path hashes, and every shard is guarded
+        // by one spin lock, so that accesses to different paths rarely contend.
+        struct AssetPathMap
+        {
+            static constexpr usize NUM_SHARDS = 64;
+
+            struct Shard
+            {
+                SpinLock lock;
+                HashMap<Path, asset_t> map;
+            };
+            Shard m_shards[NUM_SHARDS];
+
+            Shard& get_shard(const Path& path)
+            {
+                usize h = path.hash_code();
+                // Uses high bits of the hash, since low bits are used by the hash map in the shard.
+                return m_shards[(h ^ (h >> 17)) % NUM_SHARDS];
+            }
+            R<asset_t> find(const Path& path)
+            {
+                Shard& shard = get_shard(path);
+                LockGuard guard(shard.lock);
+                auto iter = shard.map.find(path);
+                if (iter == shard.map.end()) return BasicError::not_found();
+                return iter->second;
+            }
+            //! Inserts one mapping. Returns `false` if the path is already mapped.
+            bool insert(const Path& path, asset_t asset)
+            {
+                Shard& shard = get_shard(path);
+                LockGuard guard(shard.lock);
+                return shard.map.insert(make_pair(path, asset)).second;
+            }
+            void insert_or_assign(const Path& path, asset_t asset)
+            {
+                Shard& shard = get_shard(path);
+                LockGuard guard(shard.lock);
+                shard.map.insert_or_assign(path, asset);
+            }
+            //! Erases one mapping if the path is mapped to the specified asset.
+            void erase(const Path& path, asset_t asset)
+            {
+                Shard& shard = get_shard(path);
+                LockGuard guard(shard.lock);
+                auto iter = shard.map.find(path);
+                if (iter != shard.map.end() && iter->second == asset)
+                {
+                    shard.map.erase(iter);
+                }
+            }
+            void clear()
+            {
+                for (auto& shard : m_shards)
+                {
+                    LockGuard guard(shard.lock);
+                    shard.map.clear();
+                    shard.map.shrink_to_fit();
+                }
+            }
+        };
+    }
+}
@@ -0,0 +1,139 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AssetStreaming.cpp
+* @author JXMaster
+* @date 2024/3/26
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_ASSET_API LUNA_EXPORT
+#include "Asset.hpp"
+#include "AssetType.hpp"
+#include <Luna/Runtime/HashSet.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
+
+namespace Luna
+{
+    namespace Asset
+    {
+        volatile u64 g_asset_streaming_frame;
+
+        SpinLock g_streaming_lock;
+        AssetStreamingBudget g_streaming_budget;
+        AssetMemorySize g_resident_size;
+        // Entries whose asset data reports non-zero memory size. Only these entries can be evicted.
+        HashSet<AssetEntry*> g_resident_assets;
+
+        void init_asset_streaming()
+        {
+            g_asset_streaming_frame = 0;
+            g_streaming_budget = AssetStreamingBudget();
+            g_resident_size = AssetMemorySize();
+        }
+        void close_asset_streaming()
+        {
+            LockGuard guard(g_streaming_lock);
+            g_resident_assets.clear();
+            g_resident_assets.shrink_to_fit();
+            g_resident_size = AssetMemorySize();
+        }
+        AssetMemorySize get_asset_data_size(const AssetTypeDesc& desc, asset_t asset, object_t data)
+        {
+            if (!data || !desc.on_get_asset_data_size) return AssetMemorySize();
+            return desc.on_get_asset_data_size(desc.userdata.get(), asset, data);
+        }
+        void set_asset_entry_data(AssetEntry* entry, ObjRef data, const AssetMemorySize& data_size)
+        {
+            entry->data = move(data);
+            LockGuard guard(g_streaming_lock);
+            g_resident_size.cpu_size -= entry->data_size.cpu_size;
+            g_resident_size.gpu_size -= entry->data_size.gpu_size;
+            entry->data_size = entry->data ? data_size : AssetMemorySize();
+            g_resident_size.cpu_size += entry->data_size.cpu_size;
+            g_resident_size.gpu_size += entry->data_size.gpu_size;
+            if (entry->data_size.cpu_size || entry->data_size.gpu_size)
+            {
+                g_resident_assets.insert(entry);
+            }
+            else
+            {
+                g_resident_assets.erase(entry);
+            }
+        }
+        static bool is_over_budget()
+        {
+            return g_resident_size.cpu_size > g_streaming_budget.cpu_budget ||
+                g_resident_size.gpu_size > g_streaming_budget.gpu_budget;
+        }
+        LUNA_ASSET_API void set_asset_streaming_budget(const AssetStreamingBudget& budget)
+        {
+            LockGuard guard(g_streaming_lock);
+            g_streaming_budget = budget;
+        }
+        LUNA_ASSET_API AssetMemorySize get_resident_asset_size()
+        {
+            LockGuard guard(g_streaming_lock);
+            return g_resident_size;
+        }
+        LUNA_ASSET_API void mark_asset_used(asset_t asset)
+        {
+            lucheck_msg(asset.handle, "Asset handle must not be null!");
+            AssetEntry* entry = (AssetEntry*)asset.handle;
+            entry->last_used_frame = g_asset_streaming_frame;
+        }
+        LUNA_ASSET_API usize update_asset_streaming()
+        {
+            u64 current_frame = g_asset_streaming_frame;
+            usize num_evicted = 0;
+            LockGuard guard(g_streaming_lock);
+            if (is_over_budget())
+            {
+                struct Candidate
+                {
+                    u64 last_used_frame;
+                    AssetEntry* entry;
+                };
+                Vector<Candidate> candidates;
+                for (AssetEntry* entry : g_resident_assets)
+                {
+                    u64 last_used_frame = entry->last_used_frame;
+                    if (last_used_frame < current_frame)
+                    {
+                        candidates.push_back({ last_used_frame, entry });
+                    }
+                }
+                guard.unlock();
+                sort(candidates.begin(), candidates.end(), [](const Candidate& lhs, const Candidate& rhs) { return lhs.last_used_frame < rhs.last_used_frame; });
+                for (auto& candidate : candidates)
+                {
+                    guard = g_streaming_lock;
+                    bool over_budget = is_over_budget();
+                    guard.unlock();
+                    if (!over_budget) break;
+                    AssetEntry* entry = candidate.entry;
+                    LockGuard entry_guard(entry->lock);
+                    // Skips assets that are used, reloaded or unloaded after candidates are collected.
+                    if (!entry->data || entry->loading || entry->last_used_frame >= current_frame) continue;
+                    // Skips assets that are referenced outside of the asset system.
+                    if (object_ref_count(entry->data.get()) > 1) continue;
+                    entry_guard.unlock();
+                    asset_t asset;
+                    asset.handle = entry;
+                    if (succeeded(set_asset_data(asset, nullptr)))
+                    {
+                        ++num_evicted;
+                    }
+                }
+            }
+            else
+            {
+                guard.unlock();
+            }
+            atom_inc_u64(&g_asset_streaming_frame);
+            return num_evicted;
+        }
+    }
+}
@@ -10,7 +10,8 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_ASSET_API LUNA_EXPORT
 #include "AssetType.hpp"
-#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Futex.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
 #include <Luna/Runtime/SelfIndexedHashMap.hpp>
 
 namespace Luna
@@ -25,12 +26,11 @@ namespace Luna
             }
         };
 
-        Ref<IMutex> g_asset_types_mutex;
+        FutexMutex g_asset_types_mutex;
         SelfIndexedHashMap<Name, AssetTypeDesc, AssetTypeDescExtractKey> g_asset_types;
 
         void init_asset_type()
         {
-            g_asset_types_mutex = new_mutex();
         }
         void close_asset_type()
         {
@@ -39,12 +39,12 @@ namespace Luna
         }
         LUNA_ASSET_API void register_asset_type(const AssetTypeDesc& desc)
         {
-            MutexGuard g(g_asset_types_mutex);
+            LockGuard g(g_asset_types_mutex);
             g_asset_types.insert_or_assign(desc);
         }
         R<AssetTypeDesc> get_asset_type_desc(const Name& name)
         {
-            MutexGuard g(g_asset_types_mutex);
+            LockGuard g(g_asset_types_mutex);
             auto iter = g_asset_types.find(name);
             if (iter == g_asset_types.end()) return AssetError::unknown_asset_type();
             return *iter;
@@ -9,7 +9,7 @@
 */
 #pragma once
 #include "../Asset.hpp"
-#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Futex.hpp>
 
 namespace Luna
 {
@@ -18,6 +18,6 @@ namespace Luna
         R<AssetTypeDesc> get_asset_type_desc(const Name& name);
         void init_asset_type();
         void close_asset_type();
-        extern Ref<IMutex> g_asset_types_mutex;
+        extern FutexMutex g_asset_types_mutex;
     }
 }
\ No newline at end of file
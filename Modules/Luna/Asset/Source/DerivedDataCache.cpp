@@ -0,0 +1,121 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DerivedDataCache.cpp
+* @author JXMaster
+* @date 2024/3/27
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_ASSET_API LUNA_EXPORT
+#include "../DerivedDataCache.hpp"
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Hash.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/VFS/VFS.hpp>
+
+namespace Luna
+{
+    namespace Asset
+    {
+        SpinLock g_ddc_lock;
+        DerivedDataCacheDesc g_ddc_desc;
+
+        LUNA_ASSET_API void set_derived_data_cache(const DerivedDataCacheDesc& desc)
+        {
+            LockGuard guard(g_ddc_lock);
+            g_ddc_desc = desc;
+        }
+        static DerivedDataCacheDesc get_derived_data_cache()
+        {
+            LockGuard guard(g_ddc_lock);
+            return g_ddc_desc;
+        }
+        LUNA_ASSET_API Name get_derived_data_key(const c8* cooker, u32 cooker_version, Span<const byte_t> source_data)
+        {
+            // Uses two hashes with different seeds to produce one 128-bit hash, so that collisions are practically impossible.
+            u64 h1 = memhash64(source_data.data(), source_data.size(), 0x9E3779B97F4A7C15ULL);
+            u64 h2 = memhash64(source_data.data(), source_data.size(), 0xC2B2AE3D27D4EB4FULL);
+            c8 buf[256];
+            snprintf(buf, 256, "%s-%u-%016llx%016llx", cooker, cooker_version, (unsigned long long)h1, (unsigned long long)h2);
+            return Name(buf);
+        }
+        // Stores every data file in one subdirectory named by the last two characters of the key, so that one
+        // directory does not contain too many files.
+        static Path get_derived_data_path(const Path& dir, const Name& key)
+        {
+            Path ret = dir;
+            usize key_size = key.size();
+            ret.push_back(key_size >= 2 ? Name(key.c_str() + key_size - 2, 2) : Name("00"));
+            ret.push_back(key);
+            return ret;
+        }
+        static RV write_derived_data(const Path& path, Span<const byte_t> data)
+        {
+            lutry
+            {
+                Path dir = path;
+                dir.pop_back();
+                auto r = VFS::create_dir(dir);
+                if (failed(r) && r.errcode() != BasicError::already_exists()) return r.errcode();
+                // The shared tier is written by multiple processes, so every write uses one unique temporary file.
+                luexp(VFS::write_file_atomically(path, data));
+            }
+            lucatchret;
+            return ok;
+        }
+        LUNA_ASSET_API R<Ref<IMappedFile>> get_derived_data(const Name& key)
+        {
+            DerivedDataCacheDesc desc = get_derived_data_cache();
+            if (!desc.local_dir.empty())
+            {
+                auto r = VFS::map_file(get_derived_data_path(desc.local_dir, key));
+                if (succeeded(r)) return r;
+            }
+            if (!desc.shared_dir.empty())
+            {
+                auto r = VFS::map_file(get_derived_data_path(desc.shared_dir, key));
+                if (succeeded(r))
+                {
+                    if (!desc.local_dir.empty())
+                    {
+                        // Copies data to the local tier. Failing to do so only makes later lookups read the shared tier
+                        // again, so the error is only reported.
+                        Ref<IMappedFile> file = r.get();
+                        RV write_r = write_derived_data(get_derived_data_path(desc.local_dir, key), { file->get_data(), file->get_size() });
+                        if (failed(write_r))
+                        {
+                            log_warning("Asset", "Failed to copy derived data %s to the local cache: %s", key.c_str(), explain(write_r.errcode()));
+                        }
+                    }
+                    return r;
+                }
+            }
+            return BasicError::not_found();
+        }
+        LUNA_ASSET_API RV put_derived_data(const Name& key, Span<const byte_t> data)
+        {
+            DerivedDataCacheDesc desc = get_derived_data_cache();
+            lutry
+            {
+                if (!desc.local_dir.empty())
+                {
+                    luexp(write_derived_data(get_derived_data_path(desc.local_dir, key), data));
+                }
+                if (!desc.shared_dir.empty())
+                {
+                    // The shared tier may be read-only or unreachable, so failing to write it does not fail the call
+                    // as documented, and the error is only reported.
+                    RV write_r = write_derived_data(get_derived_data_path(desc.shared_dir, key), data);
+                    if (failed(write_r))
+                    {
+                        log_warning("Asset", "Failed to write derived data %s to the shared cache: %s", key.c_str(), explain(write_r.errcode()));
+                    }
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+    }
+}
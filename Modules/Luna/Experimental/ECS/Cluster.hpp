@@ -10,6 +10,7 @@
 #pragma once
 #include <Luna/Runtime/Functional.hpp>
 #include <Luna/Runtime/Span.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
 
 #ifndef LUNA_ECS_API
 #define LUNA_ECS_API
@@ -48,6 +49,36 @@ namespace Luna
         //! Every world is composited by multiple clusters, every entity will only belong to one cluster.
         struct Cluster;
 
+        //! The maximum size of component data stored in one cluster chunk in bytes.
+        //! @details Every cluster stores its entities in fixed-size chunks, every chunk stores all components of 
+        //! up to @ref get_cluster_chunk_capacity entities. Entities in one chunk are stored contiguously, so one chunk 
+        //! can be processed by one job without touching memory of other chunks.
+        constexpr usize CLUSTER_CHUNK_SIZE = 16384;
+
+        //! The alignment of every component array in one cluster chunk.
+        constexpr usize CLUSTER_COLUMN_ALIGNMENT = 32;
+
+        //! Every component array in one cluster chunk is padded to store one multiple of this number of elements, so 
+        //! SIMD code can load and store full batches of up to this number of elements at the end of the array. Padding 
+        //! elements are uninitialized, and may only be accessed as raw memory.
+        constexpr usize CLUSTER_COLUMN_PADDING = 8;
+
+        //! Describes one chunk of one cluster.
+        struct ClusterChunk
+        {
+            //! The component arrays of this chunk, using the same order as @ref get_cluster_components.
+            //! The i-th element of every array belongs to the i-th entity of this chunk.
+            void** components;
+            //! The change versions of component arrays of this chunk, using the same order as @ref get_cluster_components.
+            //! The version of one component array is updated when the array is written by one task or system with write access, 
+            //! or when entities are added to or moved into this chunk.
+            const u64* versions;
+            //! The entities stored in this chunk.
+            Span<const entity_id_t> entities;
+            //! The index of the first entity of this chunk in the cluster.
+            usize first_index;
+        };
+
         //! Describes the entity address. The address of the entity will change when structural changes 
         //! are performed to the world.
         struct EntityAddress
@@ -66,16 +97,160 @@ namespace Luna
         //! The returned span is valid so long as the cluster is valid.
         LUNA_ECS_API Span<const entity_id_t> get_cluster_tags(Cluster* cluster);
 
-        LUNA_ECS_API void* get_cluster_components_data(Cluster* cluster, typeinfo_t component_type);
+        //! Gets the maximum number of entities that can be stored in one chunk of the cluster.
+        LUNA_ECS_API usize get_cluster_chunk_capacity(Cluster* cluster);
+        //! Gets the number of chunks that store entities of the cluster.
+        LUNA_ECS_API usize get_cluster_num_chunks(Cluster* cluster);
+        //! Gets one chunk of the cluster.
+        //! The returned chunk is valid until the next structural change of the world.
+        LUNA_ECS_API ClusterChunk get_cluster_chunk(Cluster* cluster, usize chunk_index);
+
+        //! Gets the index of the specified component type in @ref get_cluster_components.
+        //! @return Returns the component index, or `-1` if the cluster does not have such component.
+        LUNA_ECS_API isize get_cluster_component_index(Cluster* cluster, typeinfo_t component_type);
+
+        //! Gets the component array of the specified component type in the specified chunk.
+        //! @return Returns the component array, or `nullptr` if the cluster does not have such component.
+        LUNA_ECS_API void* get_cluster_components_data(Cluster* cluster, typeinfo_t component_type, usize chunk_index = 0);
+        template <typename _Ty>
+        inline _Ty* get_cluster_components_data(Cluster* cluster, usize chunk_index = 0)
+        {
+            return static_cast<_Ty*>(get_cluster_components_data(cluster, typeof<_Ty>(), chunk_index));
+        }
+        //! Gets the change version of the specified component array in the specified chunk.
+        //! @return Returns the change version, or `0` if the cluster does not have such component.
+        LUNA_ECS_API u64 get_cluster_component_version(Cluster* cluster, typeinfo_t component_type, usize chunk_index);
+        //! Gets the component array of the specified component type in the specified chunk for writing, and marks the 
+        //! component array as changed at the specified version.
+        //! @param[in] version The change version of the writer, usually fetched from @ref ITaskContext::get_change_version.
+        //! @return Returns the component array, or `nullptr` if the cluster does not have such component.
+        LUNA_ECS_API void* write_cluster_components_data(Cluster* cluster, typeinfo_t component_type, usize chunk_index, u64 version);
         template <typename _Ty>
-        inline _Ty* get_cluster_components_data(Cluster* cluster)
+        inline _Ty* write_cluster_components_data(Cluster* cluster, usize chunk_index, u64 version)
         {
-            return static_cast<_Ty*>(get_cluster_components_data(cluster, typeof<_Ty>()));
+            return static_cast<_Ty*>(write_cluster_components_data(cluster, typeof<_Ty>(), chunk_index, version));
         }
-        //! Gets the cluster data array.
-        LUNA_ECS_API void** get_cluster_components_data_array(Cluster* cluster);
+        //! Gets the component data array of the specified chunk.
+        LUNA_ECS_API void** get_cluster_components_data_array(Cluster* cluster, usize chunk_index = 0);
+        //! Gets the component of the entity at the specified index of the cluster.
+        //! @return Returns the component data, or `nullptr` if the cluster does not have such component.
+        LUNA_ECS_API void* get_cluster_entity_component(Cluster* cluster, typeinfo_t component_type, usize index);
         //!    Gets the entities ID array of the cluster.
         LUNA_ECS_API Span<const entity_id_t> get_cluster_entities(Cluster* cluster);
+
+        //! Calls the specified function once for every chunk of the cluster using multiple threads.
+        //! @param[in] cluster The cluster to process.
+        //! @param[in] func The function to call. The function signature should be `void(const ClusterChunk& chunk)`.
+        //! @remark This function blocks until all chunks are processed. Structural changes to the world must not be 
+        //! performed when this function is running.
+        template <typename _Func>
+        inline void parallel_for_each_cluster_chunk(Cluster* cluster, _Func&& func)
+        {
+            JobSystem::parallel_for(0, get_cluster_num_chunks(cluster), 1, [cluster, &func](usize i)
+            {
+                func(get_cluster_chunk(cluster, i));
+            });
+        }
+
+        namespace Impl
+        {
+            struct ColumnSpanArg
+            {
+                template <typename _Ty>
+                static Span<_Ty> make(void* data, usize count) { return Span<_Ty>((_Ty*)data, count); }
+            };
+            struct ColumnPointerArg
+            {
+                template <typename _Ty>
+                static _Ty* make(void* data, usize count) { return (_Ty*)data; }
+            };
+            template <typename _Arg, typename... _Tys>
+            struct ColumnInvoker
+            {
+                template <typename _Func, typename... _Args>
+                static void invoke(_Func& func, usize count, void* const* columns, _Args... args)
+                {
+                    func(count, args...);
+                }
+            };
+            template <typename _Arg, typename _Ty, typename... _Rest>
+            struct ColumnInvoker<_Arg, _Ty, _Rest...>
+            {
+                template <typename _Func, typename... _Args>
+                static void invoke(_Func& func, usize count, void* const* columns, _Args... args)
+                {
+                    ColumnInvoker<_Arg, _Rest...>::invoke(func, count, columns + 1, args..., _Arg::template make<_Ty>(columns[0], count));
+                }
+            };
+            template <typename... _Tys>
+            inline bool get_column_indices(Cluster* cluster, usize* indices)
+            {
+                isize r[] = { get_cluster_component_index(cluster, typeof<remove_cv_t<_Tys>>())... };
+                for (usize i = 0; i < sizeof...(_Tys); ++i)
+                {
+                    if (r[i] < 0) return false;
+                    indices[i] = (usize)r[i];
+                }
+                return true;
+            }
+        }
+
+        //! Calls the specified function once for every chunk of the cluster with typed component arrays of the chunk.
+        //! @param[in] cluster The cluster to process.
+        //! @param[in] func The function to call. The function signature should be `void(usize count, Span<_Tys>... columns)`, 
+        //! where `count` is the number of entities in the chunk, and every span refers to the component array of the 
+        //! corresponding component type in the chunk. Use `const` component types for read-only access.
+        //! @remark Every component array is aligned to @ref CLUSTER_COLUMN_ALIGNMENT and padded by @ref CLUSTER_COLUMN_PADDING.
+        //! If the cluster does not have all specified components, this function does nothing.
+        template <typename... _Tys, typename _Func>
+        inline void for_each_chunk(Cluster* cluster, _Func&& func)
+        {
+            static_assert(sizeof...(_Tys) > 0, "At least one component type must be specified.");
+            usize indices[sizeof...(_Tys)];
+            if (!Impl::get_column_indices<_Tys...>(cluster, indices)) return;
+            usize num_chunks = get_cluster_num_chunks(cluster);
+            for (usize c = 0; c < num_chunks; ++c)
+            {
+                ClusterChunk chunk = get_cluster_chunk(cluster, c);
+                void* columns[sizeof...(_Tys)];
+                for (usize i = 0; i < sizeof...(_Tys); ++i) columns[i] = chunk.components[indices[i]];
+                Impl::ColumnInvoker<Impl::ColumnSpanArg, _Tys...>::invoke(func, chunk.entities.size(), columns);
+            }
+        }
+
+        //! Calls the specified function for every batch of `_Width` entities in every chunk of the cluster.
+        //! @param[in] cluster The cluster to process.
+        //! @param[in] func The function to call. The function signature should be `void(usize count, _Tys*... columns)`, 
+        //! where `count` is the number of valid entities in the batch, and every pointer points to the first component of 
+        //! the batch. `count` is `_Width` for all batches except the last batch of every chunk.
+        //! @remark The function may always load and store `_Width` elements from every pointer, since component arrays are padded.
+        //! If `_Width * sizeof(_Ty)` is one multiple of @ref CLUSTER_COLUMN_ALIGNMENT, every pointer of component type `_Ty` 
+        //! is aligned to @ref CLUSTER_COLUMN_ALIGNMENT, so aligned SIMD loads in `Runtime/Math/Simd.hpp` can be used.
+        template <usize _Width, typename... _Tys, typename _Func>
+        inline void for_each_chunk_batch(Cluster* cluster, _Func&& func)
+        {
+            static_assert(sizeof...(_Tys) > 0, "At least one component type must be specified.");
+            static_assert(_Width > 0 && _Width <= CLUSTER_COLUMN_PADDING && CLUSTER_COLUMN_PADDING % _Width == 0, 
+                "The batch width must divide CLUSTER_COLUMN_PADDING.");
+            usize indices[sizeof...(_Tys)];
+            if (!Impl::get_column_indices<_Tys...>(cluster, indices)) return;
+            usize sizes[] = { sizeof(_Tys)... };
+            usize num_chunks = get_cluster_num_chunks(cluster);
+            for (usize c = 0; c < num_chunks; ++c)
+            {
+                ClusterChunk chunk = get_cluster_chunk(cluster, c);
+                usize count = chunk.entities.size();
+                for (usize begin = 0; begin < count; begin += _Width)
+                {
+                    void* columns[sizeof...(_Tys)];
+                    for (usize i = 0; i < sizeof...(_Tys); ++i)
+                    {
+                        columns[i] = (void*)((usize)chunk.components[indices[i]] + sizes[i] * begin);
+                    }
+                    Impl::ColumnInvoker<Impl::ColumnPointerArg, _Tys...>::invoke(func, min<usize>(count - begin, _Width), columns);
+                }
+            }
+        }
     }
 
     template<>
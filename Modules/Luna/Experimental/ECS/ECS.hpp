@@ -10,6 +10,7 @@
 #pragma once
 #include "TaskContext.hpp"
 #include "World.hpp"
+#include "Scheduler.hpp"
 
 namespace Luna
 {
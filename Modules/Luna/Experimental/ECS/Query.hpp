@@ -0,0 +1,78 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Query.hpp
+* @author JXMaster
+* @date 2024/4/23
+*/
+#pragma once
+#include "Cluster.hpp"
+#include <Luna/Runtime/Interface.hpp>
+
+namespace Luna
+{
+    namespace ECS
+    {
+        //! Describes one query.
+        struct QueryDesc
+        {
+            //! Components that must exist in matched clusters.
+            Span<const typeinfo_t> required_components;
+            //! Components that must not exist in matched clusters.
+            Span<const typeinfo_t> excluded_components;
+            //! Components that may or may not exist in matched clusters. 
+            //! These components do not affect matching, they are recorded so that systems can 
+            //! declare all components they access in one query.
+            Span<const typeinfo_t> optional_components;
+            //! Components whose changes are checked by @ref IQuery::get_changed_chunks. 
+            //! These components do not affect cluster matching.
+            Span<const typeinfo_t> changed_components;
+            //! Tags that must exist in matched clusters.
+            Span<const entity_id_t> required_tags;
+            //! Tags that must not exist in matched clusters.
+            Span<const entity_id_t> excluded_tags;
+        };
+
+        //! Identifies one chunk of one cluster.
+        struct QueryChunk
+        {
+            Cluster* cluster;
+            usize chunk_index;
+        };
+
+        //! @interface IQuery
+        //! Represents one persistent query that records all clusters matching the query description.
+        //! @details The matching cluster list is updated by the world incrementally when new clusters are 
+        //! created, so getting clusters from one query does not scan all clusters of the world.
+        struct IQuery : virtual Interface
+        {
+            luiid("{6b7e3f0e-2a4d-4f39-9d56-0c5c1e9a8b21}");
+
+            //! Gets clusters that match this query.
+            //! @remark The returned span is valid until the next structural change of the world.
+            virtual Span<Cluster* const> get_clusters() = 0;
+
+            //! Gets chunks of matched clusters whose changed components are changed after the specified version.
+            //! @param[out] result Receives the changed chunks. Existing elements are cleared.
+            //! @param[in] since_version The version to compare with. One chunk is returned if the change version of any 
+            //! component specified in @ref QueryDesc::changed_components is greater than this version. If no changed component 
+            //! is specified, all components of the chunk are checked.
+            virtual void get_changed_chunks(Vector<QueryChunk>& result, u64 since_version) = 0;
+
+            //! Gets the required components of this query, sorted by type.
+            virtual Span<const typeinfo_t> get_required_components() = 0;
+            //! Gets the excluded components of this query, sorted by type.
+            virtual Span<const typeinfo_t> get_excluded_components() = 0;
+            //! Gets the optional components of this query, sorted by type.
+            virtual Span<const typeinfo_t> get_optional_components() = 0;
+            //! Gets the changed components of this query, sorted by type.
+            virtual Span<const typeinfo_t> get_changed_components() = 0;
+            //! Gets the required tags of this query, sorted by value.
+            virtual Span<const entity_id_t> get_required_tags() = 0;
+            //! Gets the excluded tags of this query, sorted by value.
+            virtual Span<const entity_id_t> get_excluded_tags() = 0;
+        };
+    }
+}
@@ -0,0 +1,94 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Scheduler.hpp
+* @author JXMaster
+* @date 2024/4/24
+*/
+#pragma once
+#include "World.hpp"
+
+namespace Luna
+{
+    namespace ECS
+    {
+        //! The callback function of one system that is invoked once per execution.
+        //! @param[in] world The world the system runs on.
+        //! @param[in] userdata The user data specified in @ref SystemDesc::userdata.
+        using system_func_t = void(IWorld* world, void* userdata);
+
+        //! The callback function of one system that is invoked once for every chunk of clusters matched by the 
+        //! system query.
+        //! @param[in] cluster The cluster that contains the chunk.
+        //! @param[in] chunk The chunk to process.
+        //! @param[in] userdata The user data specified in @ref SystemDesc::userdata.
+        //! @remark Chunk callbacks of the same system may be called on multiple threads concurrently.
+        using system_chunk_func_t = void(Cluster* cluster, const ClusterChunk& chunk, void* userdata);
+
+        //! Describes one system that is executed by the scheduler.
+        struct SystemDesc
+        {
+            //! The name of the system, used for debugging and profiling.
+            const c8* name = nullptr;
+            //! Components that will be read by this system.
+            Span<const typeinfo_t> read_components;
+            //! Components that will be read from and written to by this system.
+            Span<const typeinfo_t> write_components;
+            //! Whether this system needs exclusive access to the world. Exclusive systems conflict with all other systems, 
+            //! and are required if the system performs structural changes to the world.
+            bool exclusive = false;
+            //! The function called once when the system is executed. May be `nullptr`.
+            system_func_t* func = nullptr;
+            //! The function called once for every chunk of clusters matched by `query` when the system is executed. 
+            //! Chunk callbacks are called after `func` returns. May be `nullptr`.
+            system_chunk_func_t* chunk_func = nullptr;
+            //! The query that selects clusters processed by `chunk_func`.
+            IQuery* query = nullptr;
+            //! If `true`, `chunk_func` is only called for chunks returned by @ref IQuery::get_changed_chunks since the last 
+            //! execution of this system, so that the system only processes changed data.
+            //! @remark Component arrays of `write_components` in every chunk passed to `chunk_func` are marked as changed by 
+            //! the scheduler before `chunk_func` is called, whether or not this is `true`.
+            bool changed_only = false;
+            //! The user data passed to `func` and `chunk_func`.
+            void* userdata = nullptr;
+        };
+
+        //! @interface IScheduler
+        //! Executes systems on the job system according to their component access.
+        //! @details Systems are executed in the order they are added, except that systems that do not conflict with each other 
+        //! may run concurrently. Two systems conflict if any of them is exclusive, or if one system writes one component that 
+        //! is read or written by the other system. Every system is submitted as one job that depends on jobs of all preceding 
+        //! conflicting systems, so no thread is blocked waiting for other systems.
+        struct IScheduler : virtual Interface
+        {
+            luiid("{5d0c8a7b-93e2-4f1a-a6c4-7e1b2f9d3058}");
+
+            //! Adds one system to the scheduler.
+            //! @param[in] desc The system descriptor. All data referred by the descriptor are copied, except `query` and `userdata`.
+            //! @return Returns the index of the added system.
+            virtual usize add_system(const SystemDesc& desc) = 0;
+
+            //! Removes all systems from the scheduler.
+            virtual void clear_systems() = 0;
+
+            //! Gets the systems that the specified system depends on.
+            //! @param[in] system The index of the system.
+            //! @return Returns indices of preceding systems that must be finished before the system can be executed.
+            virtual Span<const usize> get_system_dependencies(usize system) = 0;
+
+            //! Executes all systems once.
+            //! @param[in] world The world to execute systems on.
+            //! @return Returns one job ID that is finished when all systems and their chunk jobs are finished.
+            //! @remark This call does not block the current thread. The scheduler, the world and all queries and user data 
+            //! referred by systems must be valid, and systems must not be added or removed, until the returned job is finished.
+            //! Systems executed by the scheduler access the world directly, so the world must not be accessed by tasks started 
+            //! from @ref ITaskContext until the returned job is finished.
+            virtual JobSystem::job_id_t execute(IWorld* world) = 0;
+        };
+
+        //! Creates one new scheduler.
+        LUNA_ECS_API Ref<IScheduler> new_scheduler();
+    }
+}
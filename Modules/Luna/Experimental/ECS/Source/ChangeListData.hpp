@@ -26,7 +26,10 @@ namespace Luna
             remove_all_components,
             add_tag,
             remove_tag,
-            remove_all_tags
+            remove_all_tags,
+            add_entities,
+            remove_query_entities,
+            move_query_entities,
         };
         struct ComponentBuffer
         {
@@ -82,6 +85,13 @@ namespace Luna
                 const u8* begin = reinterpret_cast<const u8*>(&data);
                 m_op_data.insert(m_op_data.end(), Span<const u8>(begin, sizeof(_Ty)));
             }
+
+            template <typename _Ty>
+            void write_span(Span<const _Ty> data)
+            {
+                write(data.size());
+                m_op_data.insert(m_op_data.end(), Span<const u8>(reinterpret_cast<const u8*>(data.data()), data.size_bytes()));
+            }
         };
 
         struct ChangeListData
@@ -90,17 +100,28 @@ namespace Luna
             // Holds buffer to contain new components.
             // Every component will have one buffer.
             HashMap<typeinfo_t, ComponentBuffer> m_new_component_data;
+            // Queries referred by batch operations.
+            Vector<Ref<IQuery>> m_queries;
 
             ChangeListData() {}
 
             ChangeListData(ChangeListData&& rhs) :
                 m_ops(move(rhs.m_ops)),
-                m_new_component_data(move(rhs.m_new_component_data)) {}
+                m_new_component_data(move(rhs.m_new_component_data)),
+                m_queries(move(rhs.m_queries)) {}
+            ChangeListData& operator=(ChangeListData&& rhs)
+            {
+                m_ops = move(rhs.m_ops);
+                m_new_component_data = move(rhs.m_new_component_data);
+                m_queries = move(rhs.m_queries);
+                return *this;
+            }
 
             void reset()
             {
                 m_ops.m_op_data.clear();
                 m_new_component_data.clear();
+                m_queries.clear();
             }
 
             entity_id_t add_entity(entity_id_t id)
@@ -182,6 +203,38 @@ namespace Luna
             {
                 m_ops.write(ChangeListOpType::remove_all_tags);
             }
+            void add_entities(Span<const entity_id_t> ids, Span<const typeinfo_t> components, Span<const entity_id_t> tags)
+            {
+                m_ops.write(ChangeListOpType::add_entities);
+                m_ops.write_span(ids);
+                m_ops.write_span(components);
+                m_ops.write_span(tags);
+            }
+            void remove_query_entities(IQuery* query)
+            {
+                m_ops.write(ChangeListOpType::remove_query_entities);
+                m_ops.write(m_queries.size());
+                m_queries.push_back(query);
+            }
+            void move_query_entities(IQuery* query, Span<const typeinfo_t> add_components, Span<const typeinfo_t> remove_components,
+                Span<const entity_id_t> add_tags, Span<const entity_id_t> remove_tags)
+            {
+                m_ops.write(ChangeListOpType::move_query_entities);
+                m_ops.write(m_queries.size());
+                m_queries.push_back(query);
+                m_ops.write_span(add_components);
+                m_ops.write_span(remove_components);
+                m_ops.write_span(add_tags);
+                m_ops.write_span(remove_tags);
+            }
+        };
+
+        // One change list submitted to the world by `ITaskContext::submit`.
+        struct ChangeListNode
+        {
+            ChangeListNode* m_next = nullptr;
+            u64 m_order = 0;
+            ChangeListData m_data;
         };
     }
 }
\ No newline at end of file
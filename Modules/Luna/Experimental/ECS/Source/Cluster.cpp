@@ -16,85 +16,148 @@ namespace Luna
 {
     namespace ECS
     {
+        void Cluster::init_chunk_layout()
+        {
+            usize num_components = m_component_types.size();
+            m_component_sizes.resize(num_components);
+            m_component_offsets.resize(num_components);
+            // Entity IDs are counted in so that clusters without components still have bounded chunks.
+            usize entity_size = sizeof(entity_id_t);
+            m_chunk_alignment = max<usize>(alignof(void*), CLUSTER_COLUMN_ALIGNMENT);
+            for (usize i = 0; i < num_components; ++i)
+            {
+                typeinfo_t type = m_component_types[i];
+                m_component_sizes[i] = get_type_size(type);
+                entity_size += m_component_sizes[i];
+                m_chunk_alignment = max(m_chunk_alignment, get_type_alignment(type));
+            }
+            usize capacity = max<usize>(CLUSTER_CHUNK_SIZE / entity_size, 1);
+            usize size;
+            while (true)
+            {
+                // The chunk header stores pointers and change versions of component arrays.
+                size = (sizeof(void*) + sizeof(u64)) * num_components;
+                // Every column is aligned and padded so that SIMD code can process columns in full batches.
+                usize padded_capacity = align_upper(capacity, CLUSTER_COLUMN_PADDING);
+                for (usize i = 0; i < num_components; ++i)
+                {
+                    size = align_upper(size, max<usize>(get_type_alignment(m_component_types[i]), CLUSTER_COLUMN_ALIGNMENT));
+                    m_component_offsets[i] = size;
+                    size += m_component_sizes[i] * padded_capacity;
+                }
+                // Shrink the capacity if alignment paddings exceed the chunk size.
+                if (size <= CLUSTER_CHUNK_SIZE || capacity == 1) break;
+                --capacity;
+            }
+            m_chunk_capacity = capacity;
+            m_chunk_size = max<usize>(size, sizeof(void*));
+        }
+        void** Cluster::allocate_chunk()
+        {
+            void** chunk = (void**)memalloc(m_chunk_size, m_chunk_alignment);
+            u64* versions = (u64*)(chunk + m_component_types.size());
+            u64 version = m_world_version ? *m_world_version : 0;
+            for (usize i = 0; i < m_component_types.size(); ++i)
+            {
+                chunk[i] = (void*)((usize)chunk + m_component_offsets[i]);
+                versions[i] = version;
+            }
+            m_chunks.push_back(chunk);
+            return chunk;
+        }
+        void Cluster::construct_component(usize component_index, usize begin, usize end)
+        {
+            typeinfo_t type = m_component_types[component_index];
+            for_each_chunk_range(begin, end, [&](usize index, usize count)
+            {
+                construct_type_range(type, get_component_data(component_index, index), count);
+            });
+        }
+        void Cluster::destruct_component(usize component_index, usize begin, usize end)
+        {
+            typeinfo_t type = m_component_types[component_index];
+            if (is_type_trivially_destructable(type)) return;
+            for_each_chunk_range(begin, end, [&](usize index, usize count)
+            {
+                destruct_type_range(type, get_component_data(component_index, index), count);
+            });
+        }
+        void Cluster::destruct_components(usize begin, usize end)
+        {
+            for (usize i = 0; i < m_component_types.size(); ++i)
+            {
+                destruct_component(i, begin, end);
+            }
+        }
+        void Cluster::mark_changed(usize begin, usize end)
+        {
+            if (!m_world_version || begin >= end) return;
+            u64 version = *m_world_version;
+            usize last_chunk = (end - 1) / m_chunk_capacity;
+            for (usize c = begin / m_chunk_capacity; c <= last_chunk; ++c)
+            {
+                u64* versions = get_chunk_versions(c);
+                for (usize i = 0; i < m_component_types.size(); ++i)
+                {
+                    versions[i] = version;
+                }
+            }
+        }
         usize Cluster::allocate_entry()
         {
-            if (m_size == m_entities.size()) expand_buffer();
+            if (m_size == m_chunks.size() * m_chunk_capacity) allocate_chunk();
             usize r = m_size;
             ++m_size;
+            mark_changed(r, m_size);
+            m_entities.push_back(NULL_ENTITY);
+            // All data remain unconstructed.
+            return r;
+        }
+        usize Cluster::allocate_entries(usize count)
+        {
+            usize r = m_size;
+            m_size += count;
+            while (m_size > m_chunks.size() * m_chunk_capacity) allocate_chunk();
+            m_entities.resize(m_size, NULL_ENTITY);
+            mark_changed(r, m_size);
             // All data remain unconstructed.
             return r;
         }
         void Cluster::free_entry(World* world, usize index)
         {
             // Destruct components.
-            for (usize i = 0; i < m_component_types.size(); ++i)
-            {
-                typeinfo_t type = m_component_types[i];
-                if (!is_type_trivially_destructable(type))
-                {
-                    usize strip = get_type_size(type);
-                    void* data = (void*)((usize)(m_components[i]) + strip * index);
-                    destruct_type(type, data);
-                }
-            }
+            destruct_components(index, index + 1);
             --m_size;
             if (index != m_size)
             {
                 // Swap the back entity to fill the empty space.
                 relocate_entity(index, m_size);
                 // Update world record for the swapped entity.
-                auto& ent = world->m_entities[m_entities[index].index];
-                ent.m_index = index;
+                auto ent = world->m_entities.get(m_entities[index].index);
+                ent->m_index = index;
+            }
+            m_entities.pop_back();
+            // Keep at most one empty chunk to avoid reallocating chunks repeatedly.
+            if (m_chunks.size() >= 2 && m_size <= (m_chunks.size() - 2) * m_chunk_capacity)
+            {
+                memfree(m_chunks.back(), m_chunk_alignment);
+                m_chunks.pop_back();
             }
         }
         void Cluster::free_all_entities()
         {
             // Destruct components.
-            for (usize i = 0; i < m_component_types.size(); ++i)
-            {
-                typeinfo_t type = m_component_types[i];
-                if (!is_type_trivially_destructable(type))
-                {
-                    destruct_type_range(type, m_components[i], m_size);
-                }
-            }
+            destruct_components(0, m_size);
             m_entities.clear();
             m_size = 0;
         }
         void Cluster::relocate_entity(usize dst, usize src)
         {
+            mark_changed(dst, dst + 1);
             m_entities[dst] = move(m_entities[src]);
             for (usize i = 0; i < m_component_types.size(); ++i)
             {
-                typeinfo_t type = m_component_types[i];
-                usize strip = get_type_size(type);
-                void* data = m_components[i];
-                void* dst_ptr = (void*)((usize)(data) + strip * dst);
-                void* src_ptr = (void*)((usize)(data) + strip * src);
-                relocate_type(type, dst_ptr, src_ptr);
-            }
-        }
-        void Cluster::expand_buffer()
-        {
-            // Expand from 1 to handle single-component case.
-            usize old_capacity = m_entities.size();
-            usize new_capacity = max<usize>(old_capacity * 2, 1);
-            usize expand_count = new_capacity - old_capacity;
-            // Resize entity.
-            m_entities.resize(new_capacity);
-            // Resize component arrays.
-            for (usize i = 0; i < m_component_types.size(); ++i)
-            {
-                typeinfo_t type = m_component_types[i];
-                void* old_data = m_components[i];
-                usize type_size = get_type_size(type);
-                void* new_data = memalloc(type_size * new_capacity, get_type_alignment(type));
-                if (old_data)
-                {
-                    relocate_type_range(type, new_data, old_data, m_size);
-                    memfree(old_data);
-                }
-                m_components[i] = new_data;
+                relocate_type(m_component_types[i], get_component_data(i, dst), get_component_data(i, src));
             }
         }
         LUNA_ECS_API Span<const typeinfo_t> get_cluster_components(Cluster* cluster)
@@ -105,17 +168,60 @@ namespace Luna
         {
             return { cluster->m_tags.data(), cluster->m_tags.size() };
         }
-        LUNA_ECS_API void* get_cluster_components_data(Cluster* cluster, typeinfo_t component_type)
+        LUNA_ECS_API usize get_cluster_chunk_capacity(Cluster* cluster)
+        {
+            return cluster->m_chunk_capacity;
+        }
+        LUNA_ECS_API usize get_cluster_num_chunks(Cluster* cluster)
+        {
+            return (cluster->m_size + cluster->m_chunk_capacity - 1) / cluster->m_chunk_capacity;
+        }
+        LUNA_ECS_API ClusterChunk get_cluster_chunk(Cluster* cluster, usize chunk_index)
+        {
+            ClusterChunk ret;
+            ret.components = cluster->m_chunks[chunk_index];
+            ret.versions = cluster->get_chunk_versions(chunk_index);
+            ret.first_index = chunk_index * cluster->m_chunk_capacity;
+            usize size = min(cluster->m_size - ret.first_index, cluster->m_chunk_capacity);
+            ret.entities = { cluster->m_entities.data() + ret.first_index, size };
+            return ret;
+        }
+        LUNA_ECS_API isize get_cluster_component_index(Cluster* cluster, typeinfo_t component_type)
         {
             auto& component_types = cluster->m_component_types;
             auto iter = binary_search_iter(component_types.begin(), component_types.end(), component_type);
-            if (iter == component_types.end()) return nullptr;
-            usize index = iter - component_types.begin();
-            return cluster->m_components[index];
+            if (iter == component_types.end()) return -1;
+            return (isize)(iter - component_types.begin());
+        }
+        LUNA_ECS_API void* get_cluster_components_data(Cluster* cluster, typeinfo_t component_type, usize chunk_index)
+        {
+            isize index = get_cluster_component_index(cluster, component_type);
+            if (index < 0 || chunk_index >= cluster->m_chunks.size()) return nullptr;
+            return cluster->m_chunks[chunk_index][index];
+        }
+        LUNA_ECS_API u64 get_cluster_component_version(Cluster* cluster, typeinfo_t component_type, usize chunk_index)
+        {
+            isize index = get_cluster_component_index(cluster, component_type);
+            if (index < 0 || chunk_index >= cluster->m_chunks.size()) return 0;
+            return cluster->get_chunk_versions(chunk_index)[index];
+        }
+        LUNA_ECS_API void* write_cluster_components_data(Cluster* cluster, typeinfo_t component_type, usize chunk_index, u64 version)
+        {
+            isize index = get_cluster_component_index(cluster, component_type);
+            if (index < 0 || chunk_index >= cluster->m_chunks.size()) return nullptr;
+            u64& v = cluster->get_chunk_versions(chunk_index)[index];
+            if (v < version) v = version;
+            return cluster->m_chunks[chunk_index][index];
+        }
+        LUNA_ECS_API void** get_cluster_components_data_array(Cluster* cluster, usize chunk_index)
+        {
+            return chunk_index < cluster->m_chunks.size() ? cluster->m_chunks[chunk_index] : nullptr;
         }
-        LUNA_ECS_API void** get_cluster_components_data_array(Cluster* cluster)
+        LUNA_ECS_API void* get_cluster_entity_component(Cluster* cluster, typeinfo_t component_type, usize index)
         {
-            return cluster->m_components;
+            isize component_index = get_cluster_component_index(cluster, component_type);
+            if (component_index < 0) return nullptr;
+            return cluster->get_component_data((usize)component_index, index);
         }
         LUNA_ECS_API Span<const entity_id_t> get_cluster_entities(Cluster* cluster)
         {
@@ -23,43 +23,39 @@ namespace Luna
             Span<entity_id_t> m_tags;
             //! Entities that is contained by this arche type.
             Vector<entity_id_t> m_entities;
-            //! Array of pointers to component arrays.
-            //! Using the same order of `m_components` in archetype.
-            void** m_components;
+            //! The size of every component type, using the same order of `m_component_types`.
+            Vector<usize> m_component_sizes;
+            //! The offset of every component array in one chunk.
+            Vector<usize> m_component_offsets;
+            //! Chunks that store component data. Every chunk begins with one array of pointers to
+            //! component arrays in this chunk, followed by one array of change versions of component arrays, 
+            //! both using the same order of `m_component_types`.
+            Vector<void**> m_chunks;
+            //! The change version of the world, used to mark changed component arrays in structural changes.
+            const u64* m_world_version;
+            //! The number of entities that can be stored in one chunk.
+            usize m_chunk_capacity;
+            //! The allocation size and alignment of one chunk.
+            usize m_chunk_size;
+            usize m_chunk_alignment;
 
             usize m_size;
 
             Cluster() :
-                m_components(nullptr),
+                m_world_version(nullptr),
+                m_chunk_capacity(1),
+                m_chunk_size(0),
+                m_chunk_alignment(alignof(void*)),
                 m_size(0) {}
 
             ~Cluster()
             {
-                for (usize i = 0; i < m_component_types.size(); ++i)
+                destruct_components(0, m_size);
+                for (void** chunk : m_chunks)
                 {
-                    if (m_components[i])
-                    {
-                        typeinfo_t type = m_component_types[i];
-                        if (!is_type_trivially_destructable(type))
-                        {
-                            usize strip = get_type_size(type);
-                            for (usize i = 0; i < m_entities.size(); ++i)
-                            {
-                                if (m_entities[i] != NULL_ENTITY)
-                                {
-                                    void* data = (void*)((usize)(m_components[i]) + strip * i);
-                                    destruct_type(type, data);
-                                }
-                            }
-                        }
-                        memfree(m_components[i], get_type_alignment(type));
-                        m_components[i] = nullptr;
-                    }
-                }
-                if (m_components)
-                {
-                    memfree(m_components);
+                    memfree(chunk, m_chunk_alignment);
                 }
+                m_chunks.clear();
                 if (m_component_types.data())
                 {
                     memfree(m_component_types.data());
@@ -70,8 +66,39 @@ namespace Luna
                 }
             }
 
-            void expand_buffer();
+            void* get_component_data(usize component_index, usize entity_index) const
+            {
+                void** chunk = m_chunks[entity_index / m_chunk_capacity];
+                return (void*)((usize)chunk[component_index] + m_component_sizes[component_index] * (entity_index % m_chunk_capacity));
+            }
+
+            u64* get_chunk_versions(usize chunk_index) const
+            {
+                return (u64*)(m_chunks[chunk_index] + m_component_types.size());
+            }
+            //! Marks all component arrays of chunks that contain entities in [`begin`, `end`) as changed.
+            void mark_changed(usize begin, usize end);
+
+            //! Computes the chunk layout from component types. Called once after `m_component_types` is set.
+            void init_chunk_layout();
+            void** allocate_chunk();
+            //! Calls `func(begin, count)` for every range of entities in [`begin`, `end`) that are stored in the same chunk.
+            template <typename _Func>
+            void for_each_chunk_range(usize begin, usize end, _Func&& func) const
+            {
+                while (begin < end)
+                {
+                    usize chunk_end = min((begin / m_chunk_capacity + 1) * m_chunk_capacity, end);
+                    func(begin, chunk_end - begin);
+                    begin = chunk_end;
+                }
+            }
+            void construct_component(usize component_index, usize begin, usize end);
+            void destruct_component(usize component_index, usize begin, usize end);
+            void destruct_components(usize begin, usize end);
             usize allocate_entry();
+            //! Allocates `count` entries at the end of the cluster and returns the index of the first entry.
+            usize allocate_entries(usize count);
             void free_entry(World* world, usize index);
             void relocate_entity(usize dst, usize src);
             void free_all_entities();
@@ -11,7 +11,10 @@
 #define LUNA_ECS_API LUNA_EXPORT
 #include "World.hpp"
 #include "TaskContext.hpp"
+#include "Query.hpp"
+#include "Scheduler.hpp"
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
 namespace Luna
 {
     namespace ECS
@@ -21,7 +24,7 @@ namespace Luna
             virtual const c8* get_name() override { return "ECS"; }
             virtual RV on_register() override
             {
-                return add_dependency_module(this, module_job_system());
+                return add_dependency_modules(this, {module_job_system(), module_variant_utils()});
             }
             virtual RV on_init() override
             {
@@ -29,6 +32,10 @@ namespace Luna
                 impl_interface_for_type<World, IWorld>();
                 register_boxed_type<TaskContext>();
                 impl_interface_for_type<TaskContext, ITaskContext>();
+                register_boxed_type<Query>();
+                impl_interface_for_type<Query, IQuery>();
+                register_boxed_type<Scheduler>();
+                impl_interface_for_type<Scheduler, IScheduler>();
                 return ok;
             }
         };
@@ -39,10 +39,9 @@ namespace Luna
                 {
                     // relocate components.
                     auto iter2 = data.find(dst_component_type);
-                    usize strip = get_type_size(dst_component_type);
-                    void* dst_data = (void*)((usize)dst_cluster->m_components[dst_component_index] + strip * dst_index);
+                    void* dst_data = dst_cluster->get_component_data(dst_component_index, dst_index);
                     void* src_data = (iter2 != data.end()) ? iter2->second :
-                        (void*)((usize)(src_cluster->m_components[src_component_index]) + strip * src_index);
+                        src_cluster->get_component_data(src_component_index, src_index);
                     move_construct_type(dst_component_type, dst_data, src_data);
                     ++src_component_index;
                     ++dst_component_index;
@@ -56,8 +55,7 @@ namespace Luna
                 {
                     // exist in dst but not in src, add.
                     auto iter2 = data.find(dst_component_type);
-                    usize strip = get_type_size(dst_component_type);
-                    void* dst_data = (void*)((usize)dst_cluster->m_components[dst_component_index] + strip * dst_index);
+                    void* dst_data = dst_cluster->get_component_data(dst_component_index, dst_index);
                     if (iter2 != data.end())
                     {
                         void* src_data = iter2->second;
@@ -80,8 +78,7 @@ namespace Luna
                 // exist in dst but not in src, add.
                 typeinfo_t dst_component_type = dst_components[dst_component_index];
                 auto iter2 = data.find(dst_component_type);
-                usize strip = get_type_size(dst_component_type);
-                void* dst_data = (void*)((usize)dst_cluster->m_components[dst_component_index] + strip * dst_index);
+                void* dst_data = dst_cluster->get_component_data(dst_component_index, dst_index);
                 if (iter2 != data.end())
                 {
                     void* src_data = iter2->second;
@@ -108,10 +105,11 @@ namespace Luna
                 Cluster* dst_cluster = world->get_cluster(
                     {m_component_types.data(), m_component_types.size()},
                     { m_tags.data(), m_tags.size() }, true);
-                usize dst_index = m_src_index;
-                if (dst_cluster != m_src_cluster)
+                // The entity may be moved in its cluster after the resolver is created, since relocating other entities 
+                // of the same cluster swaps the last entity into the freed slot. So the current location is read from the record.
+                if (dst_cluster != record->m_cluster)
                 {
-                    usize dst_index = relocate_entity(world, m_src_cluster, m_src_index, dst_cluster, m_data);
+                    usize dst_index = relocate_entity(world, record->m_cluster, record->m_index, dst_cluster, m_data);
                     // update record.
                     record->m_index = dst_index;
                     record->m_cluster = dst_cluster;
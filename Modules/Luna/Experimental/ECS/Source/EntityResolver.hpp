@@ -16,8 +16,6 @@ namespace Luna
     {
         struct EntityResolver
         {
-            Cluster* m_src_cluster = { nullptr };
-            usize m_src_index = 0;
             Vector<typeinfo_t> m_component_types;
             Vector<entity_id_t> m_tags;
             HashMap<typeinfo_t, void*> m_data;
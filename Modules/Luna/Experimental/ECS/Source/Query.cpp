@@ -0,0 +1,133 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Query.cpp
+* @author JXMaster
+* @date 2024/4/23
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_ECS_API LUNA_EXPORT
+#include "Query.hpp"
+namespace Luna
+{
+    namespace ECS
+    {
+        template <typename _Ty>
+        static void init_sorted_array(Vector<_Ty>& dst, Span<const _Ty> src)
+        {
+            dst.clear();
+            dst.reserve(src.size());
+            for (auto& v : src)
+            {
+                dst.push_back(v);
+            }
+            sort(dst.begin(), dst.end());
+            // Remove duplicated values so that the array can be used as a sorted set.
+            usize size = 0;
+            for (usize i = 0; i < dst.size(); ++i)
+            {
+                if (!size || dst[size - 1] != dst[i]) dst[size++] = dst[i];
+            }
+            dst.resize(size);
+        }
+        template <typename _Ty>
+        static bool contains_all(Span<const _Ty> sorted_set, const Vector<_Ty>& values)
+        {
+            return includes(sorted_set.begin(), sorted_set.end(), values.begin(), values.end());
+        }
+        template <typename _Ty>
+        static bool contains_none(Span<const _Ty> sorted_set, const Vector<_Ty>& values)
+        {
+            auto iter1 = sorted_set.begin();
+            auto iter2 = values.begin();
+            while (iter1 != sorted_set.end() && iter2 != values.end())
+            {
+                if (*iter1 < *iter2) ++iter1;
+                else if (*iter2 < *iter1) ++iter2;
+                else return false;
+            }
+            return true;
+        }
+        void Query::init(World* world, const QueryDesc& desc)
+        {
+            m_world = world;
+            init_sorted_array(m_required_components, desc.required_components);
+            init_sorted_array(m_excluded_components, desc.excluded_components);
+            init_sorted_array(m_optional_components, desc.optional_components);
+            init_sorted_array(m_changed_components, desc.changed_components);
+            init_sorted_array(m_required_tags, desc.required_tags);
+            init_sorted_array(m_excluded_tags, desc.excluded_tags);
+            // Match existing clusters once, succeeding clusters are matched when they are created.
+            LockGuard guard(world->m_queries_lock);
+            for (auto& cluster : world->m_clusters)
+            {
+                if (match(cluster.get()))
+                {
+                    m_clusters.push_back(cluster.get());
+                }
+            }
+            world->m_queries.push_back(this);
+        }
+        bool Query::match(Cluster* cluster) const
+        {
+            Span<const typeinfo_t> components = { cluster->m_component_types.data(), cluster->m_component_types.size() };
+            Span<const entity_id_t> tags = { cluster->m_tags.data(), cluster->m_tags.size() };
+            return contains_all(components, m_required_components) &&
+                contains_none(components, m_excluded_components) &&
+                contains_all(tags, m_required_tags) &&
+                contains_none(tags, m_excluded_tags);
+        }
+        bool Query::is_chunk_changed(Cluster* cluster, usize chunk_index, u64 since_version) const
+        {
+            const u64* versions = cluster->get_chunk_versions(chunk_index);
+            auto& component_types = cluster->m_component_types;
+            if (m_changed_components.empty())
+            {
+                for (usize i = 0; i < component_types.size(); ++i)
+                {
+                    if (versions[i] > since_version) return true;
+                }
+                return false;
+            }
+            for (typeinfo_t type : m_changed_components)
+            {
+                auto iter = binary_search_iter(component_types.begin(), component_types.end(), type);
+                if (iter != component_types.end() && versions[iter - component_types.begin()] > since_version) return true;
+            }
+            return false;
+        }
+        void Query::get_changed_chunks(Vector<QueryChunk>& result, u64 since_version)
+        {
+            result.clear();
+            for (Cluster* cluster : m_clusters)
+            {
+                usize num_chunks = get_cluster_num_chunks(cluster);
+                for (usize i = 0; i < num_chunks; ++i)
+                {
+                    if (is_chunk_changed(cluster, i, since_version))
+                    {
+                        result.push_back({ cluster, i });
+                    }
+                }
+            }
+        }
+        Query::~Query()
+        {
+            if (m_world)
+            {
+                LockGuard guard(m_world->m_queries_lock);
+                auto& queries = m_world->m_queries;
+                for (auto iter = queries.begin(); iter != queries.end(); ++iter)
+                {
+                    if (*iter == this)
+                    {
+                        queries.erase(iter);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Query.hpp
+* @author JXMaster
+* @date 2024/4/23
+*/
+#pragma once
+#include "World.hpp"
+namespace Luna
+{
+    namespace ECS
+    {
+        struct Query : IQuery
+        {
+            lustruct("ECS::Query", "{c3a81e52-7f0b-4d6c-b1e4-5a92d07f3c68}");
+            luiimpl();
+
+            Ref<World> m_world;
+            Vector<typeinfo_t> m_required_components;
+            Vector<typeinfo_t> m_excluded_components;
+            Vector<typeinfo_t> m_optional_components;
+            Vector<typeinfo_t> m_changed_components;
+            Vector<entity_id_t> m_required_tags;
+            Vector<entity_id_t> m_excluded_tags;
+            //! Clusters that match this query, updated by the world when new clusters are created.
+            Vector<Cluster*> m_clusters;
+
+            void init(World* world, const QueryDesc& desc);
+            bool match(Cluster* cluster) const;
+            bool is_chunk_changed(Cluster* cluster, usize chunk_index, u64 since_version) const;
+
+            ~Query();
+
+            virtual Span<Cluster* const> get_clusters() override { return { m_clusters.data(), m_clusters.size() }; }
+            virtual void get_changed_chunks(Vector<QueryChunk>& result, u64 since_version) override;
+            virtual Span<const typeinfo_t> get_changed_components() override { return { m_changed_components.data(), m_changed_components.size() }; }
+            virtual Span<const typeinfo_t> get_required_components() override { return { m_required_components.data(), m_required_components.size() }; }
+            virtual Span<const typeinfo_t> get_excluded_components() override { return { m_excluded_components.data(), m_excluded_components.size() }; }
+            virtual Span<const typeinfo_t> get_optional_components() override { return { m_optional_components.data(), m_optional_components.size() }; }
+            virtual Span<const entity_id_t> get_required_tags() override { return { m_required_tags.data(), m_required_tags.size() }; }
+            virtual Span<const entity_id_t> get_excluded_tags() override { return { m_excluded_tags.data(), m_excluded_tags.size() }; }
+        };
+    }
+}
@@ -0,0 +1,189 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Scheduler.cpp
+* @author JXMaster
+* @date 2024/4/24
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_ECS_API LUNA_EXPORT
+#include "Scheduler.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/Runtime/HashSet.hpp>
+
+namespace Luna
+{
+    namespace ECS
+    {
+        static void init_component_set(Vector<typeinfo_t>& dst, Span<const typeinfo_t> src)
+        {
+            dst.clear();
+            dst.reserve(src.size());
+            for (typeinfo_t type : src)
+            {
+                dst.push_back(type);
+            }
+            sort(dst.begin(), dst.end());
+        }
+        static bool intersects(const Vector<typeinfo_t>& lhs, const Vector<typeinfo_t>& rhs)
+        {
+            auto iter1 = lhs.begin();
+            auto iter2 = rhs.begin();
+            while (iter1 != lhs.end() && iter2 != rhs.end())
+            {
+                if (*iter1 < *iter2) ++iter1;
+                else if (*iter2 < *iter1) ++iter2;
+                else return true;
+            }
+            return false;
+        }
+        static bool is_conflict(const SystemData& lhs, const SystemData& rhs)
+        {
+            if (lhs.m_exclusive || rhs.m_exclusive) return true;
+            return intersects(lhs.m_write_components, rhs.m_write_components) ||
+                intersects(lhs.m_write_components, rhs.m_read_components) ||
+                intersects(lhs.m_read_components, rhs.m_write_components);
+        }
+        usize Scheduler::add_system(const SystemDesc& desc)
+        {
+            SystemData system;
+            system.m_name = desc.name;
+            init_component_set(system.m_read_components, desc.read_components);
+            init_component_set(system.m_write_components, desc.write_components);
+            system.m_exclusive = desc.exclusive;
+            system.m_func = desc.func;
+            system.m_chunk_func = desc.chunk_func;
+            system.m_query = desc.query;
+            system.m_changed_only = desc.changed_only;
+            system.m_last_version = 0;
+            system.m_userdata = desc.userdata;
+            // Build conflict edges to preceding systems. Edges that are implied by other edges are skipped, so that every
+            // system only waits for the nearest conflicting systems.
+            usize index = m_systems.size();
+            HashSet<usize> reachable;
+            for (usize i = index; i > 0; --i)
+            {
+                usize prev = i - 1;
+                if (reachable.contains(prev)) continue;
+                if (is_conflict(system, m_systems[prev]))
+                {
+                    system.m_dependencies.push_back(prev);
+                    // All dependencies of `prev` are finished before `prev` starts.
+                    Vector<usize> stack;
+                    stack.push_back(prev);
+                    while (!stack.empty())
+                    {
+                        usize s = stack.back();
+                        stack.pop_back();
+                        for (usize dep : m_systems[s].m_dependencies)
+                        {
+                            if (reachable.insert(dep).second)
+                            {
+                                stack.push_back(dep);
+                            }
+                        }
+                    }
+                }
+            }
+            m_systems.push_back(move(system));
+            return index;
+        }
+        void Scheduler::clear_systems()
+        {
+            m_systems.clear();
+        }
+        struct SystemJob
+        {
+            SystemData* system;
+            IWorld* world;
+        };
+        struct SystemChunkJob
+        {
+            system_chunk_func_t* func;
+            Cluster* cluster;
+            usize chunk_index;
+            void* userdata;
+        };
+        static void system_chunk_job(void* params)
+        {
+            SystemChunkJob* job = (SystemChunkJob*)params;
+            job->func(job->cluster, get_cluster_chunk(job->cluster, job->chunk_index), job->userdata);
+        }
+        static void system_job(void* params)
+        {
+            SystemJob* job = (SystemJob*)params;
+            SystemData* system = job->system;
+            u64 version = job->world->increment_change_version();
+            if (system->m_func)
+            {
+                system->m_func(job->world, system->m_userdata);
+            }
+            if (system->m_chunk_func && system->m_query)
+            {
+                // Chunk jobs are created as children of this job, so that systems waiting for this system
+                // wait for all chunk jobs as well.
+                auto submit_chunk_job = [&](Cluster* cluster, usize chunk_index)
+                {
+                    for (typeinfo_t type : system->m_write_components)
+                    {
+                        write_cluster_components_data(cluster, type, chunk_index, version);
+                    }
+                    void* chunk_job = JobSystem::new_job(system_chunk_job, sizeof(SystemChunkJob), alignof(SystemChunkJob), params);
+                    new (chunk_job) SystemChunkJob{ system->m_chunk_func, cluster, chunk_index, system->m_userdata };
+                    JobSystem::submit_job(chunk_job);
+                };
+                if (system->m_changed_only)
+                {
+                    Vector<QueryChunk> chunks;
+                    system->m_query->get_changed_chunks(chunks, system->m_last_version);
+                    for (auto& chunk : chunks)
+                    {
+                        submit_chunk_job(chunk.cluster, chunk.chunk_index);
+                    }
+                }
+                else
+                {
+                    for (Cluster* cluster : system->m_query->get_clusters())
+                    {
+                        usize num_chunks = get_cluster_num_chunks(cluster);
+                        for (usize i = 0; i < num_chunks; ++i)
+                        {
+                            submit_chunk_job(cluster, i);
+                        }
+                    }
+                }
+            }
+            system->m_last_version = version;
+        }
+        static void system_finish_job(void* params) {}
+        JobSystem::job_id_t Scheduler::execute(IWorld* world)
+        {
+            m_system_jobs.clear();
+            m_system_jobs.reserve(m_systems.size());
+            Vector<JobSystem::job_id_t> wait_jobs;
+            for (auto& system : m_systems)
+            {
+                wait_jobs.clear();
+                for (usize dep : system.m_dependencies)
+                {
+                    wait_jobs.push_back(m_system_jobs[dep]);
+                }
+                void* job = JobSystem::new_job(system_job, sizeof(SystemJob), alignof(SystemJob));
+                new (job) SystemJob{ &system, world };
+                if (system.m_name)
+                {
+                    JobSystem::set_job_name(job, system.m_name.c_str());
+                }
+                m_system_jobs.push_back(JobSystem::submit_job(job, { wait_jobs.data(), wait_jobs.size() }));
+            }
+            void* job = JobSystem::new_job(system_finish_job, sizeof(usize), alignof(usize));
+            return JobSystem::submit_job(job, { m_system_jobs.data(), m_system_jobs.size() });
+        }
+        LUNA_ECS_API Ref<IScheduler> new_scheduler()
+        {
+            return new_object<Scheduler>();
+        }
+    }
+}
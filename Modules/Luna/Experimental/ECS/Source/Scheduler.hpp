@@ -0,0 +1,55 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Scheduler.hpp
+* @author JXMaster
+* @date 2024/4/24
+*/
+#pragma once
+#include "../Scheduler.hpp"
+#include <Luna/Runtime/Name.hpp>
+#include <Luna/Runtime/Vector.hpp>
+namespace Luna
+{
+    namespace ECS
+    {
+        struct SystemData
+        {
+            Name m_name;
+            //! Sorted component types.
+            Vector<typeinfo_t> m_read_components;
+            Vector<typeinfo_t> m_write_components;
+            bool m_exclusive;
+            system_func_t* m_func;
+            system_chunk_func_t* m_chunk_func;
+            Ref<IQuery> m_query;
+            bool m_changed_only;
+            //! The change version of the last execution of this system.
+            u64 m_last_version;
+            void* m_userdata;
+            //! Indices of preceding systems that conflict with this system.
+            Vector<usize> m_dependencies;
+        };
+
+        struct Scheduler : IScheduler
+        {
+            lustruct("ECS::Scheduler", "{a2f64d19-0c3b-4e87-9b5a-d81e6c7f2403}");
+            luiimpl();
+
+            Vector<SystemData> m_systems;
+            //! Job IDs of systems in the last execution.
+            Vector<JobSystem::job_id_t> m_system_jobs;
+
+            virtual usize add_system(const SystemDesc& desc) override;
+            virtual void clear_systems() override;
+            virtual Span<const usize> get_system_dependencies(usize system) override
+            {
+                auto& deps = m_systems[system].m_dependencies;
+                return { deps.data(), deps.size() };
+            }
+            virtual JobSystem::job_id_t execute(IWorld* world) override;
+        };
+    }
+}
@@ -0,0 +1,313 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Snapshot.cpp
+* @author JXMaster
+* @date 2024/4/26
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_ECS_API LUNA_EXPORT
+#include "World.hpp"
+#include <Luna/Runtime/Serialization.hpp>
+#include <Luna/VariantUtils/Binary.hpp>
+
+namespace Luna
+{
+    namespace ECS
+    {
+        // Snapshot layout:
+        // SnapshotHeader
+        // SnapshotTypeEntry[num_types]
+        // u32 generations[num_entity_slots]
+        // For every cluster:
+        //   SnapshotClusterHeader
+        //   u32 component_type_indices[num_components]
+        //   entity_id_t tags[num_tags]
+        //   entity_id_t entities[num_entities]
+        //   For every component in `component_type_indices` order:
+        //     Raw components: component data of every chunk, stored contiguously.
+        //     Serialized components: u64 size + binary variant data for every entity.
+        constexpr u32 SNAPSHOT_MAGIC = 0x53434531; // "1ECS"
+        constexpr u32 SNAPSHOT_VERSION = 1;
+
+        enum class SnapshotTypeFlag : u32
+        {
+            none = 0x00,
+            // Components are stored as raw memory blocks.
+            raw = 0x01,
+        };
+
+        struct SnapshotHeader
+        {
+            u32 magic;
+            u32 version;
+            u32 num_types;
+            u32 num_clusters;
+            u32 num_entity_slots;
+            u32 reserved;
+        };
+
+        struct SnapshotTypeEntry
+        {
+            Guid guid;
+            u64 size;
+            SnapshotTypeFlag flags;
+            u32 reserved;
+        };
+
+        struct SnapshotClusterHeader
+        {
+            u32 num_components;
+            u32 num_tags;
+            u64 num_entities;
+        };
+
+        static RV write_data(IStream* stream, const void* data, usize size)
+        {
+            if (!size) return ok;
+            usize write_bytes = 0;
+            lutry
+            {
+                luexp(stream->write(data, size, &write_bytes));
+                if (write_bytes != size) return BasicError::end_of_file();
+            }
+            lucatchret;
+            return ok;
+        }
+
+        static RV read_data(IStream* stream, void* data, usize size)
+        {
+            if (!size) return ok;
+            usize read_bytes = 0;
+            lutry
+            {
+                luexp(stream->read(data, size, &read_bytes));
+                if (read_bytes != size) return BasicError::end_of_file();
+            }
+            lucatchret;
+            return ok;
+        }
+
+        static bool is_raw_component_type(typeinfo_t type)
+        {
+            return is_type_trivially_copy_constructable(type);
+        }
+
+        RV World::save_snapshot(IStream* stream)
+        {
+            lutry
+            {
+                // Build the type table.
+                Vector<typeinfo_t> types;
+                HashMap<typeinfo_t, u32> type_indices;
+                u32 num_clusters = 0;
+                for (auto& cluster : m_clusters)
+                {
+                    if (!cluster->m_size) continue;
+                    ++num_clusters;
+                    for (typeinfo_t type : cluster->m_component_types)
+                    {
+                        if (type_indices.insert(make_pair(type, (u32)types.size())).second)
+                        {
+                            types.push_back(type);
+                        }
+                    }
+                }
+                SnapshotHeader header;
+                header.magic = SNAPSHOT_MAGIC;
+                header.version = SNAPSHOT_VERSION;
+                header.num_types = (u32)types.size();
+                header.num_clusters = num_clusters;
+                header.num_entity_slots = m_entity_id_allocator.m_next_free_slot;
+                header.reserved = 0;
+                luexp(write_data(stream, &header, sizeof(SnapshotHeader)));
+                for (typeinfo_t type : types)
+                {
+                    SnapshotTypeEntry entry;
+                    entry.guid = get_type_guid(type);
+                    entry.size = get_type_size(type);
+                    entry.flags = is_raw_component_type(type) ? SnapshotTypeFlag::raw : SnapshotTypeFlag::none;
+                    entry.reserved = 0;
+                    luexp(write_data(stream, &entry, sizeof(SnapshotTypeEntry)));
+                }
+                // Write generations so that IDs allocated after loading do not collide with IDs stored
+                // in components.
+                Vector<u32> generations;
+                generations.resize(header.num_entity_slots, 0);
+                for (u32 i = 0; i < header.num_entity_slots; ++i)
+                {
+                    EntityRecord* record = m_entities.get(i);
+                    if (record) generations[i] = record->m_generation;
+                }
+                luexp(write_data(stream, generations.data(), sizeof(u32) * generations.size()));
+                // Write clusters.
+                for (auto& c : m_clusters)
+                {
+                    Cluster* cluster = c.get();
+                    if (!cluster->m_size) continue;
+                    SnapshotClusterHeader cluster_header;
+                    cluster_header.num_components = (u32)cluster->m_component_types.size();
+                    cluster_header.num_tags = (u32)cluster->m_tags.size();
+                    cluster_header.num_entities = cluster->m_size;
+                    luexp(write_data(stream, &cluster_header, sizeof(SnapshotClusterHeader)));
+                    for (typeinfo_t type : cluster->m_component_types)
+                    {
+                        u32 type_index = type_indices.find(type)->second;
+                        luexp(write_data(stream, &type_index, sizeof(u32)));
+                    }
+                    luexp(write_data(stream, cluster->m_tags.data(), cluster->m_tags.size_bytes()));
+                    luexp(write_data(stream, cluster->m_entities.data(), sizeof(entity_id_t) * cluster->m_size));
+                    for (usize i = 0; i < cluster->m_component_types.size(); ++i)
+                    {
+                        typeinfo_t type = cluster->m_component_types[i];
+                        if (is_raw_component_type(type))
+                        {
+                            RV r = ok;
+                            cluster->for_each_chunk_range(0, cluster->m_size, [&](usize index, usize count)
+                            {
+                                if (succeeded(r)) r = write_data(stream, cluster->get_component_data(i, index), cluster->m_component_sizes[i] * count);
+                            });
+                            luexp(r);
+                        }
+                        else
+                        {
+                            for (usize e = 0; e < cluster->m_size; ++e)
+                            {
+                                lulet(data, serialize(type, cluster->get_component_data(i, e)));
+                                Blob encoded = VariantUtils::write_binary(data);
+                                u64 encoded_size = encoded.size();
+                                luexp(write_data(stream, &encoded_size, sizeof(u64)));
+                                luexp(write_data(stream, encoded.data(), encoded.size()));
+                            }
+                        }
+                    }
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+
+        RV World::load_snapshot(IStream* stream)
+        {
+            lutry
+            {
+                SnapshotHeader header;
+                luexp(read_data(stream, &header, sizeof(SnapshotHeader)));
+                if (header.magic != SNAPSHOT_MAGIC || header.version != SNAPSHOT_VERSION) return BasicError::format_error();
+                // Resolve the type table.
+                Vector<typeinfo_t> types;
+                Vector<bool> raw_types;
+                for (u32 i = 0; i < header.num_types; ++i)
+                {
+                    SnapshotTypeEntry entry;
+                    luexp(read_data(stream, &entry, sizeof(SnapshotTypeEntry)));
+                    typeinfo_t type = get_type_by_guid(entry.guid);
+                    if (!type) return BasicError::not_found();
+                    bool raw = test_flags(entry.flags, SnapshotTypeFlag::raw);
+                    if (get_type_size(type) != entry.size || (raw && !is_raw_component_type(type))) return BasicError::bad_data();
+                    types.push_back(type);
+                    raw_types.push_back(raw);
+                }
+                Vector<u32> generations;
+                generations.resize(header.num_entity_slots, 0);
+                luexp(read_data(stream, generations.data(), sizeof(u32) * generations.size()));
+                // Reset entity records.
+                remove_all_entities();
+                m_entity_id_allocator.m_free_list_head = 0;
+                u32 num_slots = max(header.num_entity_slots, (u32)m_entity_id_allocator.m_next_free_slot);
+                m_entity_id_allocator.m_next_free_slot = num_slots;
+                for (u32 i = 0; i < header.num_entity_slots; ++i)
+                {
+                    m_entities.get_or_create(i)->m_generation = generations[i];
+                }
+                // Read clusters.
+                Vector<u32> component_type_indices;
+                Vector<typeinfo_t> components;
+                Vector<entity_id_t> tags;
+                Vector<usize> column_indices;
+                for (u32 c = 0; c < header.num_clusters; ++c)
+                {
+                    SnapshotClusterHeader cluster_header;
+                    luexp(read_data(stream, &cluster_header, sizeof(SnapshotClusterHeader)));
+                    component_type_indices.resize(cluster_header.num_components);
+                    luexp(read_data(stream, component_type_indices.data(), sizeof(u32) * component_type_indices.size()));
+                    components.clear();
+                    for (u32 type_index : component_type_indices)
+                    {
+                        if (type_index >= types.size()) return BasicError::bad_data();
+                        components.push_back(types[type_index]);
+                    }
+                    // Component types are sorted by `typeinfo_t`, whose order may differ between runs.
+                    sort(components.begin(), components.end());
+                    tags.resize(cluster_header.num_tags);
+                    luexp(read_data(stream, tags.data(), sizeof(entity_id_t) * tags.size()));
+                    Cluster* cluster = get_cluster({ components.data(), components.size() }, { tags.data(), tags.size() }, true);
+                    usize num_entities = (usize)cluster_header.num_entities;
+                    usize begin = cluster->allocate_entries(num_entities);
+                    usize end = begin + num_entities;
+                    luexp(read_data(stream, cluster->m_entities.data() + begin, sizeof(entity_id_t) * num_entities));
+                    for (usize i = begin; i < end; ++i)
+                    {
+                        entity_id_t id = cluster->m_entities[i];
+                        if (id.index >= header.num_entity_slots) return BasicError::bad_data();
+                        EntityRecord* record = m_entities.get(id.index);
+                        record->m_generation = id.generation;
+                        record->m_cluster = cluster;
+                        record->m_index = i;
+                    }
+                    // Construct non-raw components first, so that the cluster can always be destructed.
+                    column_indices.clear();
+                    for (u32 type_index : component_type_indices)
+                    {
+                        column_indices.push_back((usize)get_cluster_component_index(cluster, types[type_index]));
+                    }
+                    for (usize i = 0; i < component_type_indices.size(); ++i)
+                    {
+                        if (!raw_types[component_type_indices[i]])
+                        {
+                            cluster->construct_component(column_indices[i], begin, end);
+                        }
+                    }
+                    for (usize i = 0; i < component_type_indices.size(); ++i)
+                    {
+                        usize column = column_indices[i];
+                        typeinfo_t type = cluster->m_component_types[column];
+                        if (raw_types[component_type_indices[i]])
+                        {
+                            RV r = ok;
+                            cluster->for_each_chunk_range(begin, end, [&](usize index, usize count)
+                            {
+                                if (succeeded(r)) r = read_data(stream, cluster->get_component_data(column, index), cluster->m_component_sizes[column] * count);
+                            });
+                            luexp(r);
+                        }
+                        else
+                        {
+                            Vector<byte_t> encoded;
+                            for (usize e = begin; e < end; ++e)
+                            {
+                                u64 encoded_size;
+                                luexp(read_data(stream, &encoded_size, sizeof(u64)));
+                                encoded.resize((usize)encoded_size);
+                                luexp(read_data(stream, encoded.data(), encoded.size()));
+                                lulet(data, VariantUtils::read_binary(encoded.data(), encoded.size()));
+                                luexp(deserialize(type, cluster->get_component_data(column, e), data));
+                            }
+                        }
+                    }
+                }
+                // Free all slots that are not used by loaded entities.
+                for (u32 i = num_slots; i > 0; --i)
+                {
+                    EntityRecord* record = m_entities.get(i - 1);
+                    if (record && !record->m_cluster) m_entity_id_allocator.push_free_index(i - 1);
+                }
+                increment_change_version();
+            }
+            lucatchret;
+            return ok;
+        }
+    }
+}
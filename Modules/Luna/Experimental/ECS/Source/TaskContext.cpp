@@ -26,6 +26,46 @@ namespace Luna
             data_ptr += sizeof(_Ty);
         }
 
+        template <typename _Ty>
+        inline void read_span(Vector<_Ty>& values, u8*& data_ptr)
+        {
+            usize size;
+            read_data(size, data_ptr);
+            values.resize(size);
+            memcpy(values.data(), data_ptr, sizeof(_Ty) * size);
+            data_ptr += sizeof(_Ty) * size;
+        }
+
+        template <typename _Ty>
+        inline void to_sorted_set(Vector<_Ty>& dst, Span<const _Ty> src)
+        {
+            dst.clear();
+            dst.reserve(src.size());
+            for (auto& v : src)
+            {
+                dst.push_back(v);
+            }
+            sort(dst.begin(), dst.end());
+            usize size = 0;
+            for (usize i = 0; i < dst.size(); ++i)
+            {
+                if (!size || dst[size - 1] != dst[i]) dst[size++] = dst[i];
+            }
+            dst.resize(size);
+        }
+
+        // Computes `(src | add) - remove`. All inputs must be sorted.
+        template <typename _Ty>
+        inline void apply_set_changes(Vector<_Ty>& dst, Span<const _Ty> src, const Vector<_Ty>& add, const Vector<_Ty>& remove)
+        {
+            Vector<_Ty> merged;
+            merged.resize(src.size() + add.size());
+            auto merged_end = set_union(src.begin(), src.end(), add.begin(), add.end(), merged.begin());
+            dst.resize(merged.size());
+            auto dst_end = set_difference(merged.begin(), merged_end, remove.begin(), remove.end(), dst.begin());
+            dst.resize((usize)(dst_end - dst.begin()));
+        }
+
         inline EntityResolver* get_resolver(World* world, HashMap<entity_id_t, EntityResolver>& resolvers, 
             entity_id_t id)
         {
@@ -39,50 +79,72 @@ namespace Luna
                     return nullptr;
                 }
                 EntityResolver resolver;
-                resolver.m_src_cluster = record->m_cluster;
-                resolver.m_src_index = record->m_index;
                 resolver.m_component_types.assign(record->m_cluster->m_component_types);
                 resolver.m_tags.assign(record->m_cluster->m_tags);
                 iter = resolvers.insert(make_pair(id, move(resolver))).first;
             }
             return &(iter->second);
         }
-        void TaskContext::apply_change_list()
+        void apply_change_list(World* world, ChangeListData& data)
         {
-            u8* data_ptr = m_data.m_ops.m_op_data.data();
-            u8* data_end = data_ptr + m_data.m_ops.m_op_data.size();
+            // Component arrays changed by structural changes are marked with one new version.
+            world->increment_change_version();
+            u8* data_ptr = data.m_ops.m_op_data.data();
+            u8* data_end = data_ptr + data.m_ops.m_op_data.size();
             HashMap<entity_id_t, EntityResolver> resolvers;
             EntityResolver* current_resolver = nullptr;
+            entity_id_t current_entity = NULL_ENTITY;
+            // Batch operations move entities between clusters, so pending entity changes must be applied
+            // before them.
+            auto flush_resolvers = [&]()
+            {
+                for (auto& resolver : resolvers)
+                {
+                    resolver.second.apply(world, resolver.first);
+                }
+                resolvers.clear();
+                if (current_resolver)
+                {
+                    current_resolver = get_resolver(world, resolvers, current_entity);
+                }
+            };
             while (data_ptr < data_end)
             {
                 ChangeListOpType op;
                 read_data(op, data_ptr);
+                // Deferred component construction of new entities must be done before other operations
+                // read or move component data.
+                if (op != ChangeListOpType::add_entity && op != ChangeListOpType::add_entities)
+                {
+                    world->construct_deferred_entities();
+                }
                 switch(op)
                 {
                 case ChangeListOpType::add_entity:
                 {
                     entity_id_t id;
                     read_data(id, data_ptr);
-                    m_world->add_entity_record(id);
+                    world->add_entity_record(id);
                 }
                 break;
                 case ChangeListOpType::remove_entity:
                 {
                     entity_id_t id;
                     read_data(id, data_ptr);
-                    m_world->remove_entity(id);
+                    world->remove_entity(id);
                 }
                 break;
                 case ChangeListOpType::remove_all_entities:
                 {
-                    m_world->remove_all_entities();
+                    world->remove_all_entities();
                 }
                 break;
                 case ChangeListOpType::set_target_entity:
                 {
                     entity_id_t id;
                     read_data(id, data_ptr);
-                    current_resolver = get_resolver(m_world, resolvers, id);
+                    current_entity = id;
+                    current_resolver = get_resolver(world, resolvers, id);
                 }
                 break;
                 case ChangeListOpType::add_component:
@@ -98,8 +160,8 @@ namespace Luna
                         // If the component is actually added, or the user need to add component even if exists.
                         if (added || op == ChangeListOpType::add_component)
                         {
-                            auto iter = m_data.m_new_component_data.find(component_type);
-                            luassert(iter != m_data.m_new_component_data.end());
+                            auto iter = data.m_new_component_data.find(component_type);
+                            luassert(iter != data.m_new_component_data.end());
                             void* ptr = (void*)((usize)iter->second.m_data + index * get_type_size(iter->second.m_type));
                             current_resolver->m_data.insert_or_assign(component_type, ptr);
                         }
@@ -154,12 +216,79 @@ namespace Luna
                     }
                 }
                 break;
+                case ChangeListOpType::add_entities:
+                {
+                    Vector<entity_id_t> ids;
+                    Vector<typeinfo_t> components;
+                    Vector<entity_id_t> tags;
+                    read_span(ids, data_ptr);
+                    read_span(components, data_ptr);
+                    read_span(tags, data_ptr);
+                    flush_resolvers();
+                    world->add_entities({ ids.data(), ids.size() }, { components.data(), components.size() }, { tags.data(), tags.size() });
+                }
+                break;
+                case ChangeListOpType::remove_query_entities:
+                {
+                    usize query_index;
+                    read_data(query_index, data_ptr);
+                    flush_resolvers();
+                    for (Cluster* cluster : data.m_queries[query_index]->get_clusters())
+                    {
+                        world->remove_cluster_entities(cluster);
+                    }
+                    if (current_resolver && !world->get_entity_record(current_entity))
+                    {
+                        current_resolver = nullptr;
+                    }
+                }
+                break;
+                case ChangeListOpType::move_query_entities:
+                {
+                    usize query_index;
+                    Vector<typeinfo_t> add_components;
+                    Vector<typeinfo_t> remove_components;
+                    Vector<entity_id_t> add_tags;
+                    Vector<entity_id_t> remove_tags;
+                    read_data(query_index, data_ptr);
+                    read_span(add_components, data_ptr);
+                    read_span(remove_components, data_ptr);
+                    read_span(add_tags, data_ptr);
+                    read_span(remove_tags, data_ptr);
+                    flush_resolvers();
+                    // Destination clusters created below may be added to the query, so take a snapshot first.
+                    Vector<Cluster*> clusters;
+                    clusters.assign(data.m_queries[query_index]->get_clusters());
+                    Vector<typeinfo_t> dst_components;
+                    Vector<entity_id_t> dst_tags;
+                    for (Cluster* cluster : clusters)
+                    {
+                        if (!cluster->m_size) continue;
+                        apply_set_changes(dst_components, Span<const typeinfo_t>(cluster->m_component_types.data(), cluster->m_component_types.size()),
+                            add_components, remove_components);
+                        apply_set_changes(dst_tags, Span<const entity_id_t>(cluster->m_tags.data(), cluster->m_tags.size()),
+                            add_tags, remove_tags);
+                        Cluster* dst_cluster = world->get_cluster({ dst_components.data(), dst_components.size() },
+                            { dst_tags.data(), dst_tags.size() }, true);
+                        world->move_cluster_entities(cluster, dst_cluster);
+                    }
+                    if (current_resolver)
+                    {
+                        resolvers.clear();
+                        current_resolver = get_resolver(world, resolvers, current_entity);
+                    }
+                }
+                break;
                 default: lupanic();
                 }
             }
+            if (!resolvers.empty())
+            {
+                world->construct_deferred_entities();
+            }
             for(auto& resolver : resolvers)
             {
-                resolver.second.apply(m_world, resolver.first);
+                resolver.second.apply(world, resolver.first);
             }
         }
         JobSystem::job_id_t TaskContext::begin_task(
@@ -167,7 +296,7 @@ namespace Luna
                 Span<typeinfo_t> read_components,
                 Span<typeinfo_t> write_components)
         {
-            MutexGuard guard(m_world->m_queue_lock);
+            LockGuard guard(m_world->m_queue_lock);
             auto id = JobSystem::allocate_job_id();
             Vector<JobSystem::job_id_t> wait_jobs;
             if (m_world->m_last_exclusive_task != JobSystem::INVALID_JOB_ID)
@@ -248,9 +377,32 @@ namespace Luna
                 Span<typeinfo_t> read_components,
                 Span<typeinfo_t> write_components)
         {
-            m_world = (World*)world->get_object();
+            World* new_world = (World*)world->get_object();
+            if (m_world && m_world != new_world)
+            {
+                // Reserved IDs are only valid for the world they are allocated from.
+                m_world->m_entity_id_allocator.free_block(m_id_block);
+            }
+            m_world = new_world;
             m_exec_mode = exec_mode;
             m_job_id = begin_task(exec_mode, read_components, write_components);
+            m_change_version = m_world->increment_change_version();
+        }
+        void TaskContext::apply_change_list()
+        {
+            ECS::apply_change_list(m_world, m_data);
+        }
+        void TaskContext::submit(u64 order)
+        {
+            if (!m_data.m_ops.m_op_data.empty())
+            {
+                ChangeListNode* node = memnew<ChangeListNode>();
+                node->m_order = order;
+                node->m_data = move(m_data);
+                m_world->push_change_list(node);
+            }
+            end_task(m_job_id);
+            m_data.reset();
         }
         void TaskContext::end()
         {
@@ -270,8 +422,26 @@ namespace Luna
                     end_task(m_job_id);
                 }
             }
+            else
+            {
+                // Tasks that record no change must still be finished, or succeeding tasks wait for them forever.
+                end_task(m_job_id);
+            }
             m_data.reset();
         }
+        void TaskContext::add_entities(Span<entity_id_t> out_ids, Span<const typeinfo_t> components, Span<const entity_id_t> tags)
+        {
+            for (auto& id : out_ids)
+            {
+                id = m_world->m_entity_id_allocator.allocate_id(m_id_block);
+            }
+            Vector<typeinfo_t> sorted_components;
+            Vector<entity_id_t> sorted_tags;
+            to_sorted_set(sorted_components, components);
+            to_sorted_set(sorted_tags, tags);
+            m_data.add_entities({ out_ids.data(), out_ids.size() }, { sorted_components.data(), sorted_components.size() },
+                { sorted_tags.data(), sorted_tags.size() });
+        }
         R<EntityAddress> TaskContext::get_entity(entity_id_t id)
         {
             EntityRecord* record = m_world->get_entity_record(id);
@@ -17,6 +17,8 @@ namespace Luna
 {
     namespace ECS
     {
+        void apply_change_list(World* world, ChangeListData& data);
+
         struct TaskContext : ITaskContext
         {
             lustruct("ECS::TaskContext", "{0da44741-176c-4fee-af5b-3938c84cd2b2}");
@@ -25,8 +27,12 @@ namespace Luna
             Ref<World> m_world;
             JobSystem::job_id_t m_job_id;
             TaskExecutionMode m_exec_mode;
+            //! The change version of the current task.
+            u64 m_change_version = 0;
 
             ChangeListData m_data;
+            //! Entity IDs reserved from `m_world`.
+            EntityIdBlock m_id_block;
 
             void apply_change_list();
 
@@ -37,6 +43,11 @@ namespace Luna
 
             void end_task(JobSystem::job_id_t id);
 
+            ~TaskContext()
+            {
+                if (m_world) m_world->m_entity_id_allocator.free_block(m_id_block);
+            }
+
             virtual void begin(
                 IWorld* world,
                 TaskExecutionMode exec_mode,
@@ -44,13 +55,22 @@ namespace Luna
                 Span<typeinfo_t> write_components
                 ) override;
             virtual void end() override;
+            virtual void submit(u64 order) override;
 
             virtual IWorld* get_world() override { return m_world; }
+            virtual u64 get_change_version() override { return m_change_version; }
             virtual R<EntityAddress> get_entity(entity_id_t id) override;
             virtual void get_clusters(Vector<Cluster*>& result, filter_func_t* filter, void* userdata) override;
-            virtual entity_id_t add_entity() override { return m_data.add_entity(m_world->m_entity_id_allocator.allocate_id()); }
+            virtual entity_id_t add_entity() override { return m_data.add_entity(m_world->m_entity_id_allocator.allocate_id(m_id_block)); }
             virtual void remove_entity(entity_id_t id) override { return m_data.remove_entity(id); }
             virtual void remove_all_entities() override { m_data.remove_all_entities(); }
+            virtual void add_entities(Span<entity_id_t> out_ids, Span<const typeinfo_t> components, Span<const entity_id_t> tags) override;
+            virtual void remove_entities(IQuery* query) override { m_data.remove_query_entities(query); }
+            virtual void move_entities(IQuery* query, Span<const typeinfo_t> add_components, Span<const typeinfo_t> remove_components,
+                Span<const entity_id_t> add_tags, Span<const entity_id_t> remove_tags) override
+            {
+                m_data.move_query_entities(query, add_components, remove_components, add_tags, remove_tags);
+            }
             virtual void set_target_entity(entity_id_t id) { m_data.set_target_entity(id); }
             virtual void* add_component(typeinfo_t component_type, bool allow_overwrite, usize* data_index) override { return m_data.add_component(component_type, allow_overwrite, data_index); }
             virtual void* get_temp_component_data(typeinfo_t component_type, usize index) override { return m_data.get_temp_component_data(component_type, index); }
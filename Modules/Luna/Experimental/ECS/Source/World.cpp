@@ -10,6 +10,9 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_ECS_API LUNA_EXPORT
 #include "World.hpp"
+#include "Query.hpp"
+#include "TaskContext.hpp"
+#include <Luna/JobSystem/Parallel.hpp>
 #include <Luna/Runtime/Random.hpp>
 #include <Luna/Runtime/Log.hpp>
 namespace Luna
@@ -45,37 +48,37 @@ namespace Luna
                     memcpy(tags_buf, tags.data(), tags.size_bytes());
                     new_cluster->m_tags = { tags_buf, tags.size() };
                 }
-                if (!components.empty())
+                new_cluster->m_world_version = (const u64*)&m_change_version;
+                new_cluster->init_chunk_layout();
+                m_clusters.insert(move(new_cluster));
+                // Update queries incrementally.
+                LockGuard guard(m_queries_lock);
+                for (Query* query : m_queries)
                 {
-                    new_cluster->m_components = (void**)memalloc(sizeof(void*) * components.size());
-                    memzero(new_cluster->m_components, sizeof(void*) * components.size());
+                    if (query->match(ret))
+                    {
+                        query->m_clusters.push_back(ret);
+                    }
                 }
-                m_clusters.insert(move(new_cluster));
                 return ret;
             }
             return nullptr;
         }
+        Ref<IQuery> World::new_query(const QueryDesc& desc)
+        {
+            Ref<Query> query = new_object<Query>();
+            query->init(this, desc);
+            return query;
+        }
         EntityRecord* World::get_entity_record(entity_id_t id)
         {
-            if ((u64)id.index >= m_entities.size()) return nullptr;
-            auto& ent = m_entities[id.index];
-            if (ent.m_generation != id.generation || !ent.m_cluster) return nullptr;
-            return &ent;
+            EntityRecord* ent = m_entities.get(id.index);
+            if (!ent || ent->m_generation != id.generation || !ent->m_cluster) return nullptr;
+            return ent;
         }
         EntityRecord* World::get_or_create_entity_record(entity_id_t id)
         {
-            while (id.index >= m_entities.size())
-            {
-                // Expand array.
-                if (m_entities.size() == m_entities.capacity())
-                {
-                    m_entities.reserve(m_entities.size() + 1024);
-                }
-                auto rec = m_entities.emplace_back();
-                rec->m_cluster = nullptr;
-                rec->m_generation = 0;
-            }
-            return &m_entities[id.index];
+            return m_entities.get_or_create(id.index);
         }
         void World::remove_finished_tasks()
         {
@@ -130,15 +133,152 @@ namespace Luna
         {
             for (auto& cluster : m_clusters)
             {
-                for (usize i = 0; i < cluster->m_size; ++i)
+                remove_cluster_entities(cluster.get());
+            }
+        }
+        void World::remove_cluster_entities(Cluster* cluster)
+        {
+            for (usize i = 0; i < cluster->m_size; ++i)
+            {
+                entity_id_t id = cluster->m_entities[i];
+                auto record = get_entity_record(id);
+                record->m_cluster = nullptr;
+                m_entity_id_allocator.free_id(id);
+            }
+            cluster->free_all_entities();
+        }
+        void World::add_entities(Span<const entity_id_t> ids, Span<const typeinfo_t> components, Span<const entity_id_t> tags)
+        {
+            if (ids.empty()) return;
+            Cluster* cluster = get_cluster(components, tags, true);
+            usize begin = cluster->allocate_entries(ids.size());
+            usize end = begin + ids.size();
+            if (m_defer_construction)
+            {
+                cluster->for_each_chunk_range(begin, end, [&](usize index, usize count)
+                {
+                    m_deferred_entities.push_back({ cluster, index, count });
+                });
+            }
+            else
+            {
+                for (usize i = 0; i < cluster->m_component_types.size(); ++i)
                 {
-                    entity_id_t id = cluster->m_entities[i];
-                    auto record = get_entity_record(id);
-                    record->m_cluster = nullptr;
-                    m_entity_id_allocator.free_id(id);
+                    cluster->construct_component(i, begin, end);
                 }
-                cluster->free_all_entities();
             }
+            for (usize i = 0; i < ids.size(); ++i)
+            {
+                entity_id_t id = ids[i];
+                auto ent = get_or_create_entity_record(id);
+                ent->m_generation = id.generation;
+                ent->m_cluster = cluster;
+                ent->m_index = begin + i;
+                cluster->m_entities[begin + i] = id;
+            }
+        }
+        void World::construct_deferred_entities()
+        {
+            if (m_deferred_entities.empty()) return;
+            // Every range lies in one chunk of one cluster, so ranges can be constructed concurrently.
+            JobSystem::parallel_for(0, m_deferred_entities.size(), 1, [this](usize i)
+            {
+                auto& range = m_deferred_entities[i];
+                Cluster* cluster = range.m_cluster;
+                for (usize c = 0; c < cluster->m_component_types.size(); ++c)
+                {
+                    construct_type_range(cluster->m_component_types[c], cluster->get_component_data(c, range.m_begin), range.m_count);
+                }
+            });
+            m_deferred_entities.clear();
+        }
+        void World::flush_change_lists()
+        {
+            Ref<TaskContext> context = new_object<TaskContext>();
+            context->begin(this, TaskExecutionMode::exclusive, {}, {});
+            Vector<ChangeListNode*> nodes;
+            ChangeListNode* node = atom_exchange_pointer(&m_submitted_change_lists, nullptr);
+            while (node)
+            {
+                nodes.push_back(node);
+                node = node->m_next;
+            }
+            sort(nodes.begin(), nodes.end(), [](ChangeListNode* lhs, ChangeListNode* rhs) { return lhs->m_order < rhs->m_order; });
+            m_defer_construction = true;
+            for (ChangeListNode* n : nodes)
+            {
+                apply_change_list(this, n->m_data);
+            }
+            construct_deferred_entities();
+            m_defer_construction = false;
+            for (ChangeListNode* n : nodes)
+            {
+                memdelete(n);
+            }
+            context->end_task(context->m_job_id);
+        }
+        // Calls `func(src_index, dst_index, count)` for every range that is contiguous in both clusters.
+        template <typename _Func>
+        static void for_each_move_range(Cluster* src, usize src_begin, Cluster* dst, usize dst_begin, usize count, _Func&& func)
+        {
+            dst->for_each_chunk_range(dst_begin, dst_begin + count, [&](usize dst_index, usize dst_count)
+            {
+                usize src_index = src_begin + (dst_index - dst_begin);
+                src->for_each_chunk_range(src_index, src_index + dst_count, [&](usize index, usize n)
+                {
+                    func(index, dst_index + (index - src_index), n);
+                });
+            });
+        }
+        void World::move_cluster_entities(Cluster* src, Cluster* dst)
+        {
+            if (src == dst || !src->m_size) return;
+            usize count = src->m_size;
+            usize dst_begin = dst->allocate_entries(count);
+            usize dst_end = dst_begin + count;
+            memcpy(dst->m_entities.data() + dst_begin, src->m_entities.data(), sizeof(entity_id_t) * count);
+            // Walk both sorted component lists and move whole columns.
+            usize src_component_index = 0;
+            usize dst_component_index = 0;
+            auto& src_components = src->m_component_types;
+            auto& dst_components = dst->m_component_types;
+            while (src_component_index < src_components.size() || dst_component_index < dst_components.size())
+            {
+                if (dst_component_index == dst_components.size() ||
+                    (src_component_index < src_components.size() && src_components[src_component_index] < dst_components[dst_component_index]))
+                {
+                    // exist in src but not in dst, remove.
+                    src->destruct_component(src_component_index, 0, count);
+                    ++src_component_index;
+                }
+                else if (src_component_index == src_components.size() ||
+                    dst_components[dst_component_index] < src_components[src_component_index])
+                {
+                    // exist in dst but not in src, add.
+                    dst->construct_component(dst_component_index, dst_begin, dst_end);
+                    ++dst_component_index;
+                }
+                else
+                {
+                    typeinfo_t type = dst_components[dst_component_index];
+                    for_each_move_range(src, 0, dst, dst_begin, count, [&](usize src_index, usize dst_index, usize n)
+                    {
+                        relocate_type_range(type, dst->get_component_data(dst_component_index, dst_index),
+                            src->get_component_data(src_component_index, src_index), n);
+                    });
+                    ++src_component_index;
+                    ++dst_component_index;
+                }
+            }
+            for (usize i = 0; i < count; ++i)
+            {
+                auto ent = m_entities.get(dst->m_entities[dst_begin + i].index);
+                ent->m_cluster = dst;
+                ent->m_index = dst_begin + i;
+            }
+            // All components are relocated or destructed, so only clear the entity list.
+            src->m_entities.clear();
+            src->m_size = 0;
         }
         LUNA_ECS_API Ref<IWorld> new_world()
         {
@@ -10,12 +10,13 @@
 #pragma once
 #include <Luna/Runtime/UniquePtr.hpp>
 #include <Luna/Runtime/HashSet.hpp>
-#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Futex.hpp>
 #include "ChangeListData.hpp"
 #include <Luna/Runtime/SpinLock.hpp>
 #include <Luna/Runtime/RingDeque.hpp>
 #include "Cluster.hpp"
 #include <Luna/Runtime/SelfIndexedHashMap.hpp>
+#include <Luna/Runtime/Atomic.hpp>
 
 namespace Luna
 {
@@ -26,38 +27,173 @@ namespace Luna
             Cluster* m_cluster;
             usize m_index;
             u32 m_generation;
+            //! The next free record index plus one when this record is in the free list.
+            u32 m_next_free;
+        };
+
+        //! The number of entity records in one record page.
+        constexpr u32 ENTITY_RECORD_PAGE_SIZE = 4096;
+        //! The maximum number of record pages of one world.
+        constexpr u32 MAX_ENTITY_RECORD_PAGES = 16384;
+
+        //! Stores entity records in fixed-size pages, so that the address of one record never changes 
+        //! and records can be read while new pages are allocated by other threads.
+        struct EntityRecordTable
+        {
+            EntityRecord* volatile* m_pages;
+
+            EntityRecordTable()
+            {
+                m_pages = (EntityRecord* volatile*)memalloc(sizeof(EntityRecord*) * MAX_ENTITY_RECORD_PAGES);
+                memzero((void*)m_pages, sizeof(EntityRecord*) * MAX_ENTITY_RECORD_PAGES);
+            }
+            ~EntityRecordTable()
+            {
+                for (u32 i = 0; i < MAX_ENTITY_RECORD_PAGES; ++i)
+                {
+                    if (m_pages[i]) memfree(m_pages[i]);
+                }
+                memfree((void*)m_pages);
+            }
+            //! Gets the record of the specified index, returns `nullptr` if the record page is not allocated.
+            EntityRecord* get(u32 index) const
+            {
+                u32 page = index / ENTITY_RECORD_PAGE_SIZE;
+                if (page >= MAX_ENTITY_RECORD_PAGES) return nullptr;
+                EntityRecord* records = m_pages[page];
+                return records ? records + (index % ENTITY_RECORD_PAGE_SIZE) : nullptr;
+            }
+            EntityRecord* get_or_create(u32 index)
+            {
+                u32 page = index / ENTITY_RECORD_PAGE_SIZE;
+                lucheck_msg(page < MAX_ENTITY_RECORD_PAGES, "Too many entities are allocated in one world.");
+                EntityRecord* records = m_pages[page];
+                if (!records)
+                {
+                    EntityRecord* new_records = (EntityRecord*)memalloc(sizeof(EntityRecord) * ENTITY_RECORD_PAGE_SIZE);
+                    for (u32 i = 0; i < ENTITY_RECORD_PAGE_SIZE; ++i)
+                    {
+                        new_records[i].m_cluster = nullptr;
+                        new_records[i].m_index = 0;
+                        new_records[i].m_generation = 0;
+                        new_records[i].m_next_free = 0;
+                    }
+                    records = atom_compare_exchange_pointer(m_pages + page, new_records, nullptr);
+                    if (records)
+                    {
+                        // Another thread allocates the page first.
+                        memfree(new_records);
+                    }
+                    else
+                    {
+                        records = new_records;
+                    }
+                }
+                return records + (index % ENTITY_RECORD_PAGE_SIZE);
+            }
+        };
+
+        //! The number of entity IDs reserved by one ID block.
+        constexpr u32 ENTITY_ID_BLOCK_SIZE = 256;
+
+        //! One range of entity IDs reserved by one task context, so that allocating new IDs does not 
+        //! touch shared states.
+        struct EntityIdBlock
+        {
+            u32 m_next = 0;
+            u32 m_end = 0;
         };
 
         struct EntityIdAllocator
         {
-            RingDeque<entity_id_t> m_free_ids;
-            u32 m_next_free_slot;
-            SpinLock m_lock;
+            EntityRecordTable* m_records;
+            //! The free list head. The low 32 bits store the index of the first free record plus one, 
+            //! the high 32 bits store one tag that is increased on every modification to prevent ABA problems.
+            u64 volatile m_free_list_head;
+            u32 volatile m_next_free_slot;
 
-            EntityIdAllocator() :
+            EntityIdAllocator(EntityRecordTable* records) :
+                m_records(records),
+                m_free_list_head(0),
                 m_next_free_slot(0) {}
 
-            entity_id_t allocate_id()
+            bool pop_free_id(entity_id_t& id)
             {
-                LockGuard guard(m_lock);
-                if (!m_free_ids.empty())
+                u64 head = m_free_list_head;
+                while (true)
                 {
-                    entity_id_t id = m_free_ids.front();
-                    m_free_ids.pop_front();
-                    ++id.generation;
-                    return id;
+                    u32 slot = (u32)head;
+                    if (!slot) return false;
+                    EntityRecord* record = m_records->get(slot - 1);
+                    u64 new_head = (((head >> 32) + 1) << 32) | (u64)record->m_next_free;
+                    u64 prev = atom_compare_exchange_u64(&m_free_list_head, new_head, head);
+                    if (prev == head)
+                    {
+                        id.index = slot - 1;
+                        id.generation = record->m_generation + 1;
+                        return true;
+                    }
+                    head = prev;
                 }
+            }
+
+            entity_id_t allocate_id(EntityIdBlock& block)
+            {
+                entity_id_t ret;
+                if (pop_free_id(ret)) return ret;
+                if (block.m_next == block.m_end)
+                {
+                    block.m_next = atom_add_u32(&m_next_free_slot, (i32)ENTITY_ID_BLOCK_SIZE);
+                    block.m_end = block.m_next + ENTITY_ID_BLOCK_SIZE;
+                    // One block spans at most two pages.
+                    m_records->get_or_create(block.m_next);
+                    m_records->get_or_create(block.m_end - 1);
+                }
+                ret.index = block.m_next;
+                ret.generation = 1;
+                ++block.m_next;
+                return ret;
+            }
+
+            entity_id_t allocate_id()
+            {
                 entity_id_t ret;
-                ret.index = m_next_free_slot;
+                if (pop_free_id(ret)) return ret;
+                ret.index = atom_inc_u32(&m_next_free_slot) - 1;
                 ret.generation = 1;
-                ++m_next_free_slot;
+                m_records->get_or_create(ret.index);
                 return ret;
             }
 
+            //! Pushes the record of the specified index to the free list. The generation of the record must 
+            //! be the generation of the last allocated ID of the record.
+            void push_free_index(u32 index)
+            {
+                EntityRecord* record = m_records->get(index);
+                u64 head = m_free_list_head;
+                while (true)
+                {
+                    record->m_next_free = (u32)head;
+                    u64 new_head = (((head >> 32) + 1) << 32) | (u64)(index + 1);
+                    u64 prev = atom_compare_exchange_u64(&m_free_list_head, new_head, head);
+                    if (prev == head) return;
+                    head = prev;
+                }
+            }
+
             void free_id(entity_id_t id)
             {
-                LockGuard guard(m_lock);
-                m_free_ids.push_back(id);
+                push_free_index(id.index);
+            }
+
+            //! Gives IDs that are not allocated from the block back to the allocator.
+            void free_block(EntityIdBlock& block)
+            {
+                for (u32 i = block.m_next; i < block.m_end; ++i)
+                {
+                    push_free_index(i);
+                }
+                block.m_next = block.m_end = 0;
             }
         };
 
@@ -102,14 +238,23 @@ namespace Luna
             }
         };
 
+        struct Query;
+
+        struct DeferredEntityRange
+        {
+            Cluster* m_cluster;
+            usize m_begin;
+            usize m_count;
+        };
+
         struct World : public IWorld
         {
             lustruct("ECS::World", "{945066F9-0292-46DC-8659-41D1C5874EA6}");
             luiimpl();
 
             //! Entity allocation and management.
+            EntityRecordTable m_entities;
             EntityIdAllocator m_entity_id_allocator;
-            Vector<EntityRecord> m_entities;
 
             //! Achetype for empty entity.
             Cluster* m_empty_cluster;
@@ -117,23 +262,65 @@ namespace Luna
             //! Clusters managed by this world.
             SelfIndexedHashMap<ClusterType, UniquePtr<Cluster>, ClusterExtractKey> m_clusters;
 
+            //! Queries created from this world. New clusters are matched against these queries when created.
+            Vector<Query*> m_queries;
+            SpinLock m_queries_lock;
+
             //! Task management.
             RingDeque<TaskScheduleData> m_tasks;
             JobSystem::job_id_t m_last_exclusive_task;
-            Vector<ChangeListData> m_change_lists;
-            Ref<IMutex> m_queue_lock;
+            //! Change lists submitted by task contexts, linked as one lock-free stack.
+            ChangeListNode* volatile m_submitted_change_lists = nullptr;
+            //! Ranges of new entities whose components are not constructed yet.
+            Vector<DeferredEntityRange> m_deferred_entities;
+            //! The change version of the world.
+            u64 volatile m_change_version = 1;
+            //! Whether to defer component construction of new entities.
+            bool m_defer_construction = false;
+            FutexMutex m_queue_lock;
 
             World() :
+                m_entity_id_allocator(&m_entities),
                 m_last_exclusive_task(JobSystem::INVALID_JOB_ID)
             {
                 UniquePtr<Cluster> empty_cluster(memnew<Cluster>());
+                empty_cluster->m_world_version = (const u64*)&m_change_version;
+                empty_cluster->init_chunk_layout();
                 m_empty_cluster = empty_cluster.get();
                 m_clusters.insert(move(empty_cluster));
-                m_queue_lock = new_mutex();
+            }
+            ~World()
+            {
+                // Discard changes that are submitted but not flushed.
+                ChangeListNode* node = m_submitted_change_lists;
+                while (node)
+                {
+                    ChangeListNode* next = node->m_next;
+                    memdelete(node);
+                    node = next;
+                }
             }
 
             Cluster* get_cluster(Span<const typeinfo_t> components, Span<const entity_id_t> tags,
                 bool create_if_not_exist);
+            Ref<IQuery> new_query(const QueryDesc& desc);
+            void flush_change_lists();
+            u64 get_change_version() { return m_change_version; }
+            u64 increment_change_version() { return atom_inc_u64(&m_change_version); }
+            RV save_snapshot(IStream* stream);
+            RV load_snapshot(IStream* stream);
+            void push_change_list(ChangeListNode* node)
+            {
+                ChangeListNode* head = m_submitted_change_lists;
+                while (true)
+                {
+                    node->m_next = head;
+                    ChangeListNode* prev = atom_compare_exchange_pointer(&m_submitted_change_lists, node, head);
+                    if (prev == head) return;
+                    head = prev;
+                }
+            }
+            void construct_deferred_entities();
             EntityRecord* get_entity_record(entity_id_t id);
             EntityRecord* get_or_create_entity_record(entity_id_t id);
 
@@ -143,6 +330,13 @@ namespace Luna
             entity_id_t add_entity();
             void remove_entity(entity_id_t id);
             void remove_all_entities();
+            //! Removes all entities of one cluster.
+            void remove_cluster_entities(Cluster* cluster);
+            //! Adds entities to the cluster with the specified components and tags.
+            //! Components are default-constructed.
+            void add_entities(Span<const entity_id_t> ids, Span<const typeinfo_t> components, Span<const entity_id_t> tags);
+            //! Moves all entities of `src` to `dst`, relocating component columns in chunk ranges.
+            void move_cluster_entities(Cluster* src, Cluster* dst);
         };
     }
 
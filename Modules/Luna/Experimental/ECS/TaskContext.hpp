@@ -8,7 +8,7 @@
 * @date 2023/1/6
 */
 #pragma once
-#include "Cluster.hpp"
+#include "Query.hpp"
 #include <Luna/Runtime/Interface.hpp>
 #include <Luna/Runtime/Result.hpp>
 #include <Luna/Runtime/Ref.hpp>
@@ -79,9 +79,17 @@ namespace Luna
             //! Gets the world which this task context is attached to.
             virtual IWorld* get_world() = 0;
 
+            //! Gets the change version of the current task.
+            //! @details Pass this version to @ref write_cluster_components_data to mark component arrays written by 
+            //! this task. One task should only write component types specified in `write_components` in @ref begin.
+            virtual u64 get_change_version() = 0;
+
             //! Gets the entity address for the specified entity.
             virtual R<EntityAddress> get_entity(entity_id_t id) = 0;
 
+            //! Gets all clusters that pass the specified filter.
+            //! @remark This call tests every cluster of the world. Use @ref IWorld::new_query for filters that are 
+            //! evaluated repeatedly.
             virtual void get_clusters(Vector<Cluster*>& result, filter_func_t* filter, void* userdata) = 0;
 
             template <typename _Filter>
@@ -111,9 +119,9 @@ namespace Luna
                 auto r = get_entity(id);
                 if (failed(r)) return r.errcode();
                 typeinfo_t type = typeof<_Ty>();
-                void* components = get_cluster_components_data(r.get().cluster, type);
-                if (!components) return ECSError::component_not_found();
-                return (_Ty*)((usize)components + r.get().index * get_type_size(type));
+                void* component = get_cluster_entity_component(r.get().cluster, type, r.get().index);
+                if (!component) return ECSError::component_not_found();
+                return (_Ty*)component;
             }
 
             //! Adds one entity to the world.
@@ -128,6 +136,29 @@ namespace Luna
             //! Removes all entities in the world.
             virtual void remove_all_entities() = 0;
 
+            //! Adds multiple entities with the same components and tags to the world.
+            //! @param[out] out_ids Receives IDs of added entities. The number of entities to add is the size of this span.
+            //! @param[in] components The components of added entities. Components are default-constructed when the change is applied.
+            //! @param[in] tags The tags of added entities.
+            //! @remark All entities are added to one cluster at once, and component columns are constructed in chunk ranges, 
+            //! which is much faster than adding entities and components one by one.
+            virtual void add_entities(Span<entity_id_t> out_ids, Span<const typeinfo_t> components, Span<const entity_id_t> tags) = 0;
+
+            //! Removes all entities in clusters matched by the specified query.
+            //! @param[in] query The query. Clusters are matched when the change is applied.
+            virtual void remove_entities(IQuery* query) = 0;
+
+            //! Adds and removes components and tags for all entities in clusters matched by the specified query.
+            //! @param[in] query The query. Clusters are matched when the change is applied.
+            //! @param[in] add_components Components to add. Added components are default-constructed.
+            //! @param[in] remove_components Components to remove.
+            //! @param[in] add_tags Tags to add.
+            //! @param[in] remove_tags Tags to remove.
+            //! @remark Entities of one source cluster are moved to the destination cluster together, and every component 
+            //! column is relocated in chunk ranges rather than one entity at a time.
+            virtual void move_entities(IQuery* query, Span<const typeinfo_t> add_components, Span<const typeinfo_t> remove_components,
+                Span<const entity_id_t> add_tags, Span<const entity_id_t> remove_tags) = 0;
+
             //! Changes the target entity for succeeding component and tag modification calls, including:
             //! * `add_component`
             //! * `remove_component`
@@ -192,6 +223,14 @@ namespace Luna
 
             //! Finishes the current task and lets succeeding tasks to be run.
             virtual void end() = 0;
+
+            //! Finishes the current task and submits structural changes recorded by this task to the world without 
+            //! applying them.
+            //! @param[in] order The merge order of the submitted changes. Submitted changes are applied in ascending 
+            //! order of this value when @ref IWorld::flush_change_lists is called, so the result does not depend on which 
+            //! thread submits first. Every task should use one unique order value, such as the index of the job.
+            //! @remark Unlike @ref end, this call never blocks to wait for other tasks, and does not take any lock.
+            virtual void submit(u64 order) = 0;
         };
 
         LUNA_ECS_API Ref<ITaskContext> new_task_context();
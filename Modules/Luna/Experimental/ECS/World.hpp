@@ -8,10 +8,11 @@
 * @date 2023/1/4
 */
 #pragma once
-#include "Cluster.hpp"
+#include "Query.hpp"
 #include <Luna/Runtime/Interface.hpp>
 #include <Luna/Runtime/Ref.hpp>
 #include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Stream.hpp>
 #include <Luna/JobSystem/JobSystem.hpp>
 
 namespace Luna
@@ -57,6 +58,45 @@ namespace Luna
             //! Gets the cluster by components and tags.
              virtual Cluster* get_cluster(Span<const typeinfo_t> components, Span<const entity_id_t> tags, 
                  bool create_if_not_exist = false) = 0;
+
+            //! Creates one persistent query that tracks clusters matching the query description.
+            //! @param[in] desc The query description.
+            //! @return Returns the created query. The query keeps the world alive.
+            virtual Ref<IQuery> new_query(const QueryDesc& desc) = 0;
+
+            //! Applies all changes submitted by @ref ITaskContext::submit to the world.
+            //! @details Submitted changes are applied in ascending order of their order values. Component construction of 
+            //! entities added by @ref ITaskContext::add_entities is performed in parallel for every destination cluster chunk.
+            //! @remark This call runs as one exclusive task, so it waits for all running tasks of the world to finish.
+            virtual void flush_change_lists() = 0;
+
+            //! Gets the current change version of the world.
+            //! @details The change version increases every time one task or system begins, and is used to mark changed 
+            //! component arrays. See @ref ClusterChunk::versions for details.
+            virtual u64 get_change_version() = 0;
+
+            //! Increases the change version of the world atomically and returns the new version.
+            virtual u64 increment_change_version() = 0;
+
+            //! Writes all entities and components of the world to one binary snapshot.
+            //! @param[in] stream The stream to write the snapshot to.
+            //! @details The snapshot stores one type table that identifies component types by their type GUIDs, followed by 
+            //! entities of every cluster. Component types that are trivially copy constructable are written as raw memory blocks 
+            //! per cluster chunk, other component types are serialized by @ref serialize and encoded in the binary variant format, 
+            //! and must therefore be serializable.
+            //! @remark This call must not be called when tasks of the world are running.
+            virtual RV save_snapshot(IStream* stream) = 0;
+
+            //! Replaces all entities and components of the world with entities and components read from one binary snapshot 
+            //! written by @ref save_snapshot.
+            //! @param[in] stream The stream to read the snapshot from.
+            //! @details Entity IDs are preserved, so components and tags that refer to entities stay valid after loading. 
+            //! Raw component blocks are copied to cluster storage directly without constructing components first.
+            //! Returns @ref BasicError::not_found if one component type in the snapshot is not registered, and returns 
+            //! @ref BasicError::bad_data if the size or copy semantic of one component type is different from the snapshot.
+            //! @remark This call must not be called when tasks of the world are running or task contexts of the world are alive.
+            //! If this call fails, the world contains one partial snapshot.
+            virtual RV load_snapshot(IStream* stream) = 0;
         };
 
         //! Creates one new world.
@@ -10,6 +10,8 @@
 #pragma once
 #include <Luna/Runtime/Stream.hpp>
 #include <Luna/Runtime/Ref.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
 
 #ifndef LUNA_NETWORK_API
 #define LUNA_NETWORK_API
@@ -103,6 +105,36 @@ namespace Luna
             };
         };
 
+        //! Describes one buffer used by @ref ISocket::send_v and @ref ISocket::recv_v.
+        struct SocketBuffer
+        {
+            //! The buffer data. This is not modified by @ref ISocket::send_v.
+            void* data;
+            //! The buffer size in bytes.
+            usize size;
+        };
+
+        //! Describes one datagram used by @ref ISocket::send_datagrams and @ref ISocket::recv_datagrams.
+        struct Datagram
+        {
+            //! The datagram data buffer.
+            void* data;
+            //! When sending, specifies the size of the datagram. When receiving, specifies the capacity of `data`, 
+            //! and receives the size of the received datagram.
+            usize size;
+            //! When sending, specifies the destination address. When receiving, receives the source address.
+            SocketAddress address;
+        };
+
+        //! Receives the result of one asynchronous socket operation.
+        struct AsyncSocketIOResult
+        {
+            //! The result of the operation.
+            RV result;
+            //! The number of bytes read or written.
+            usize transferred_bytes;
+        };
+
         //! @interface ISocket
         //! Represents one socket, which is a network communication endpoint.
         //! @details Each socket is associated with a socket address, which consists of an IP address and a port number. 
@@ -135,6 +167,79 @@ namespace Luna
             //! @param[out] address The assigned address for the accepted connection.
             //! @return Returns the socket that represents the accepted connection.
             virtual R<Ref<ISocket>> accept(SocketAddress& address) = 0;
+
+            //! Sets whether this socket works in blocking mode.
+            //! @param[in] blocking `true` to make socket operations block until they complete, `false` to make them return immediately.
+            //! @details Sockets are created in blocking mode. In non-blocking mode, @ref read, @ref write and @ref accept return 
+            //! @ref BasicError::not_ready if the operation cannot be completed immediately, and @ref connect returns
+            //! @ref BasicError::in_progress if the connection cannot be established immediately. Non-blocking sockets are 
+            //! usually used with @ref INetworkPoller, which tells when the socket is ready for the next operation.
+            virtual RV set_blocking(bool blocking) = 0;
+
+            //! Sends data in multiple buffers in one call without copying them to one continuous buffer.
+            //! @param[in] buffers The buffers to send. Buffers are sent in their order in the span.
+            //! @param[out] sent_bytes If not `nullptr`, receives the number of bytes sent, which may be smaller than the total size of all buffers.
+            //! @details This maps to `sendmsg` on POSIX platforms and `WSASend` on Windows.
+            virtual RV send_v(Span<const SocketBuffer> buffers, usize* sent_bytes = nullptr) = 0;
+
+            //! Receives data to multiple buffers in one call.
+            //! @param[in] buffers The buffers to receive data. Buffers are filled in their order in the span.
+            //! @param[out] received_bytes If not `nullptr`, receives the number of bytes received. `0` is reported if the connection is 
+            //! closed by the remote side.
+            //! @details This maps to `recvmsg` on POSIX platforms and `WSARecv` on Windows.
+            virtual RV recv_v(Span<const SocketBuffer> buffers, usize* received_bytes = nullptr) = 0;
+
+            //! Sends data of one file to the socket.
+            //! @param[in] file The file to send. The file cursor is not used or changed if the file is opened by @ref open_file.
+            //! @param[in] offset The offset, in bytes, from the beginning of the file to send data from.
+            //! @param[in] size The number of bytes to send.
+            //! @param[out] sent_bytes If not `nullptr`, receives the number of bytes sent, which may be smaller than `size` if 
+            //! the end of the file is reached or the socket is in non-blocking mode.
+            //! @details If the file is opened by @ref open_file, data is copied from the system file cache to the socket directly by 
+            //! `sendfile` on POSIX platforms and `TransmitFile` on Windows, without being copied to user space. Otherwise, data is read 
+            //! from the file to one temporary buffer and then sent.
+            virtual RV send_file(IFile* file, u64 offset, u64 size, u64* sent_bytes = nullptr) = 0;
+
+            //! Sends multiple datagrams using as few system calls as possible.
+            //! @param[in] datagrams The datagrams to send. Every datagram is sent to its own address.
+            //! @param[out] sent_datagrams If not `nullptr`, receives the number of datagrams sent. Datagrams are sent in order, so 
+            //! the first `sent_datagrams` datagrams are sent.
+            //! @details On Linux, all datagrams are sent by `sendmmsg`, and consecutive datagrams with the same address and size are 
+            //! sent as one message using UDP generic segmentation offload (GSO) if supported by the system, so that they are 
+            //! split by the kernel or the network card. On other platforms, datagrams are sent one by one.
+            //! @return Returns one error only if no datagram is sent.
+            virtual RV send_datagrams(Span<const Datagram> datagrams, usize* sent_datagrams = nullptr) = 0;
+
+            //! Receives multiple datagrams using as few system calls as possible.
+            //! @param[in,out] datagrams The buffers to receive datagrams. @ref Datagram::size and @ref Datagram::address are 
+            //! set for every received datagram. Datagrams larger than the buffer are truncated.
+            //! @param[out] received_datagrams If not `nullptr`, receives the number of received datagrams.
+            //! @details This call blocks until at least one datagram is received if the socket is in blocking mode, then receives 
+            //! datagrams that are already queued without blocking. On Linux, datagrams are received by one `recvmmsg` call.
+            //! @return Returns one error only if no datagram is received.
+            virtual RV recv_datagrams(Span<Datagram> datagrams, usize* received_datagrams = nullptr) = 0;
+
+            //! Reads data from the socket asynchronously.
+            //! @param[in] buffer The buffer to write read data to. The buffer must be valid until the operation is finished.
+            //! @param[in] size The maximum number of bytes to read.
+            //! @param[out] out_result The object to receive the result of the operation. The object must be valid until the operation is finished.
+            //! @return Returns one job ID that is finished when the operation is finished. The result is written to `out_result` before the 
+            //! job ID is finished, so jobs can wait for the operation by passing the job ID to @ref JobSystem::submit_job, and read the result 
+            //! when they are executed.
+            //! @details The operation finishes when any data is read, so @ref AsyncSocketIOResult::transferred_bytes may be smaller than `size`.
+            //! @ref AsyncSocketIOResult::transferred_bytes is `0` if the connection is closed by the remote side. 
+            //! Asynchronous operations of all sockets are performed by one network IO thread using @ref INetworkPoller, and the socket is 
+            //! switched to non-blocking mode when the operation is submitted. Read operations of the same socket are finished in submission order.
+            virtual R<JobSystem::job_id_t> read_async(void* buffer, usize size, AsyncSocketIOResult* out_result) = 0;
+
+            //! Writes data to the socket asynchronously.
+            //! @param[in] buffer The data to write. The buffer must be valid until the operation is finished.
+            //! @param[in] size The number of bytes to write.
+            //! @param[out] out_result The object to receive the result of the operation. The object must be valid until the operation is finished.
+            //! @return Returns one job ID that is finished when the operation is finished. See @ref read_async for details.
+            //! @details The operation finishes when all data is written or one error occurs. Write operations of the same socket are finished in 
+            //! submission order.
+            virtual R<JobSystem::job_id_t> write_async(const void* buffer, usize size, AsyncSocketIOResult* out_result) = 0;
         };
 
         //! Specifies the socket type.
@@ -196,6 +301,78 @@ namespace Luna
         //! @return Returns the created socket.
         LUNA_NETWORK_API R<Ref<ISocket>> new_socket(AddressFamily af, SocketType type, Protocol protocol);
 
+        //! Specifies socket events that can be watched by @ref INetworkPoller.
+        enum class PollEventFlag : u8
+        {
+            none = 0x00,
+            //! The socket has data to read, or has incoming connections to accept if the socket is listening.
+            readable = 0x01,
+            //! The socket can be written without blocking, or the connection is established if the socket is connecting.
+            writable = 0x02,
+            //! One error occurs on the socket. This event is always watched and can only be reported by @ref INetworkPoller::wait.
+            error = 0x04,
+            //! The remote side closes the connection. This event is always watched and can only be reported by @ref INetworkPoller::wait.
+            hang_up = 0x08,
+        };
+
+        //! Describes one socket event reported by @ref INetworkPoller::wait.
+        struct PollEvent
+        {
+            //! The socket that receives the event.
+            ISocket* socket;
+            //! The user data specified when registering the socket.
+            void* userdata;
+            //! The received events.
+            PollEventFlag events;
+        };
+
+        //! @interface INetworkPoller
+        //! Watches events of many sockets, so that one thread can serve many connections.
+        //! @details This is implemented by `epoll` on Linux, `kqueue` on macOS and `WSAPoll` on Windows. Events are level-triggered:
+        //! one event is reported by every @ref wait call until the event condition is cleared, for example, by reading all data 
+        //! from the socket.
+        //! @remark The poller is not thread safe, calls to one poller must be synchronized.
+        struct INetworkPoller : virtual Interface
+        {
+            luiid("{6E1B0A52-8D3C-4F27-9B64-2A5C7E13D8F0}");
+
+            //! Registers one socket to the poller.
+            //! @param[in] socket The socket to register. The poller keeps one reference to the socket until it is removed.
+            //! @param[in] events The events to watch.
+            //! @param[in] userdata The user data reported in @ref PollEvent::userdata.
+            //! @return Returns @ref BasicError::already_exists if the socket is already registered.
+            virtual RV add_socket(ISocket* socket, PollEventFlag events, void* userdata) = 0;
+
+            //! Changes events and user data of one registered socket.
+            //! @param[in] socket The socket to modify.
+            //! @param[in] events The new events to watch.
+            //! @param[in] userdata The new user data.
+            //! @return Returns @ref BasicError::not_found if the socket is not registered.
+            virtual RV modify_socket(ISocket* socket, PollEventFlag events, void* userdata) = 0;
+
+            //! Unregisters one socket from the poller.
+            //! @param[in] socket The socket to unregister.
+            //! @return Returns @ref BasicError::not_found if the socket is not registered.
+            virtual RV remove_socket(ISocket* socket) = 0;
+
+            //! Waits until at least one registered socket receives events or the timeout expires.
+            //! @param[out] out_events The buffer to receive events. At most `out_events.size()` events are reported in one call.
+            //! @param[in] timeout_ms The maximum time to wait in milliseconds. Specify `0` to return immediately, specify `U32_MAX` to
+            //! wait infinitely.
+            //! @return Returns the number of events written to `out_events`. Returns `0` if the timeout expires or the wait is interrupted by signals.
+            //! On macOS, read and write events of one socket may be reported in two separate events.
+            virtual R<usize> wait(Span<PollEvent> out_events, u32 timeout_ms) = 0;
+
+            //! Wakes up the thread that is blocked in @ref wait, so that @ref wait returns immediately.
+            //! @details If no thread is waiting, the next @ref wait call returns immediately.
+            //! @remark Unlike other functions of the poller, this function can be called from any thread.
+            virtual void wake() = 0;
+        };
+
+        //! Creates one new network poller.
+        //! @return Returns the created poller.
+        LUNA_NETWORK_API R<Ref<INetworkPoller>> new_poller();
+
         //! Specifies flag attributes of one address.
         enum class AddressInfoFlag : u8
         {
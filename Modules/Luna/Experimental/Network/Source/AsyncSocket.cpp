@@ -0,0 +1,244 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AsyncSocket.cpp
+* @author JXMaster
+* @date 2024/4/27
+*/
+#include "AsyncSocket.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/RingDeque.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Log.hpp>
+
+namespace Luna
+{
+    namespace Network
+    {
+        struct AsyncSocketIOOp
+        {
+            byte_t* m_buffer;
+            usize m_size;
+            usize m_transferred;
+            JobSystem::job_id_t m_job;
+            AsyncSocketIOResult* m_result;
+        };
+
+        struct AsyncSocketIORequest
+        {
+            Ref<ISocket> m_socket;
+            AsyncSocketIOOp m_op;
+            bool m_write;
+        };
+
+        // Pending operations of one socket, only accessed by the IO thread.
+        struct AsyncSocketState
+        {
+            Ref<ISocket> m_socket;
+            RingDeque<AsyncSocketIOOp> m_reads;
+            RingDeque<AsyncSocketIOOp> m_writes;
+            // Events that are registered to the poller.
+            PollEventFlag m_events = PollEventFlag::none;
+            bool m_registered = false;
+        };
+
+        // The maximum number of events handled by one wait.
+        constexpr usize ASYNC_SOCKET_MAX_EVENTS = 256;
+
+        Vector<AsyncSocketIORequest> g_async_socket_requests;
+        SpinLock g_async_socket_lock;
+        Ref<INetworkPoller> g_async_socket_poller;
+        Ref<IThread> g_async_socket_thread;
+        bool g_async_socket_exiting = false;
+
+        static void complete_async_socket_io(AsyncSocketIOOp& op, RV result)
+        {
+            op.m_result->result = result;
+            op.m_result->transferred_bytes = op.m_transferred;
+            JobSystem::finish_job_id(op.m_job);
+        }
+
+        // Unregisters the socket from the poller if it is registered.
+        static void unregister_async_socket(AsyncSocketState& state)
+        {
+            if (!state.m_registered) return;
+            state.m_registered = false;
+            RV r = g_async_socket_poller->remove_socket(state.m_socket);
+            // The state is dropped anyway, so the failure is only reported. The poller keeps one reference to the
+            // socket in that case, which is released when the poller is destroyed.
+            if (failed(r))
+            {
+                log_warning("Network", "Failed to unregister one socket from the async socket poller: %s", explain(r.errcode()));
+            }
+        }
+
+        // Performs pending operations of the socket until the socket is not ready, then updates events
+        // registered to the poller. Returns `false` if the socket has no pending operation and should be removed.
+        static bool process_async_socket(AsyncSocketState& state)
+        {
+            ISocket* socket = state.m_socket;
+            while (!state.m_reads.empty())
+            {
+                AsyncSocketIOOp& op = state.m_reads.front();
+                usize read_bytes = 0;
+                RV r = socket->read(op.m_buffer, op.m_size, &read_bytes);
+                if (failed(r) && r.errcode() == BasicError::not_ready()) break;
+                op.m_transferred = read_bytes;
+                complete_async_socket_io(op, r);
+                state.m_reads.pop_front();
+            }
+            while (!state.m_writes.empty())
+            {
+                AsyncSocketIOOp& op = state.m_writes.front();
+                usize write_bytes = 0;
+                RV r = socket->write(op.m_buffer + op.m_transferred, op.m_size - op.m_transferred, &write_bytes);
+                if (failed(r) && r.errcode() == BasicError::not_ready()) break;
+                op.m_transferred += write_bytes;
+                if (failed(r) || op.m_transferred == op.m_size)
+                {
+                    complete_async_socket_io(op, r);
+                    state.m_writes.pop_front();
+                }
+            }
+            PollEventFlag events = PollEventFlag::none;
+            if (!state.m_reads.empty()) set_flags(events, PollEventFlag::readable);
+            if (!state.m_writes.empty()) set_flags(events, PollEventFlag::writable);
+            RV r = ok;
+            if (events == PollEventFlag::none)
+            {
+                unregister_async_socket(state);
+                return false;
+            }
+            if (!state.m_registered)
+            {
+                r = g_async_socket_poller->add_socket(socket, events, nullptr);
+                state.m_registered = succeeded(r);
+            }
+            else if (events != state.m_events)
+            {
+                r = g_async_socket_poller->modify_socket(socket, events, nullptr);
+            }
+            if (failed(r))
+            {
+                // The socket cannot be watched, fail all pending operations.
+                for (auto& op : state.m_reads) complete_async_socket_io(op, r);
+                for (auto& op : state.m_writes) complete_async_socket_io(op, r);
+                state.m_reads.clear();
+                state.m_writes.clear();
+                unregister_async_socket(state);
+                return false;
+            }
+            state.m_events = events;
+            return true;
+        }
+
+        static void async_socket_thread_main(void*)
+        {
+            HashMap<ISocket*, AsyncSocketState> sockets;
+            Vector<AsyncSocketIORequest> requests;
+            Vector<PollEvent> events;
+            events.resize(ASYNC_SOCKET_MAX_EVENTS);
+            while (true)
+            {
+                bool exiting;
+                {
+                    LockGuard guard(g_async_socket_lock);
+                    requests.swap(g_async_socket_requests);
+                    exiting = g_async_socket_exiting;
+                }
+                for (auto& request : requests)
+                {
+                    auto iter = sockets.find(request.m_socket.get());
+                    if (iter == sockets.end())
+                    {
+                        AsyncSocketState state;
+                        state.m_socket = request.m_socket;
+                        iter = sockets.insert(make_pair(request.m_socket.get(), move(state))).first;
+                    }
+                    if (request.m_write) iter->second.m_writes.push_back(request.m_op);
+                    else iter->second.m_reads.push_back(request.m_op);
+                }
+                // Try new operations immediately, since the socket may already be ready.
+                for (auto& request : requests)
+                {
+                    auto iter = sockets.find(request.m_socket.get());
+                    if (iter != sockets.end() && !process_async_socket(iter->second))
+                    {
+                        sockets.erase(iter);
+                    }
+                }
+                requests.clear();
+                if (exiting)
+                {
+                    for (auto& socket : sockets)
+                    {
+                        AsyncSocketState& state = socket.second;
+                        for (auto& op : state.m_reads) complete_async_socket_io(op, BasicError::interrupted());
+                        for (auto& op : state.m_writes) complete_async_socket_io(op, BasicError::interrupted());
+                        unregister_async_socket(state);
+                    }
+                    return;
+                }
+                auto r = g_async_socket_poller->wait({ events.data(), events.size() }, U32_MAX);
+                if (failed(r)) continue;
+                for (usize i = 0; i < r.get(); ++i)
+                {
+                    auto iter = sockets.find(events[i].socket);
+                    if (iter != sockets.end() && !process_async_socket(iter->second))
+                    {
+                        sockets.erase(iter);
+                    }
+                }
+            }
+        }
+
+        R<JobSystem::job_id_t> submit_async_socket_io(ISocket* socket, void* buffer, usize size, bool write, AsyncSocketIOResult* out_result)
+        {
+            JobSystem::job_id_t job;
+            lutry
+            {
+                luexp(socket->set_blocking(false));
+                LockGuard guard(g_async_socket_lock);
+                // The IO thread is created when the first operation is submitted.
+                if (!g_async_socket_thread)
+                {
+                    luset(g_async_socket_poller, new_poller());
+                    g_async_socket_thread = new_thread(async_socket_thread_main, nullptr, "Async Socket IO Thread");
+                }
+                job = JobSystem::allocate_job_id();
+                AsyncSocketIORequest request;
+                request.m_socket = socket;
+                request.m_op.m_buffer = (byte_t*)buffer;
+                request.m_op.m_size = size;
+                request.m_op.m_transferred = 0;
+                request.m_op.m_job = job;
+                request.m_op.m_result = out_result;
+                request.m_write = write;
+                g_async_socket_requests.push_back(move(request));
+                guard.unlock();
+                g_async_socket_poller->wake();
+            }
+            lucatchret;
+            return job;
+        }
+
+        void async_socket_io_close()
+        {
+            if (!g_async_socket_thread) return;
+            {
+                LockGuard guard(g_async_socket_lock);
+                g_async_socket_exiting = true;
+            }
+            g_async_socket_poller->wake();
+            g_async_socket_thread->wait();
+            g_async_socket_thread = nullptr;
+            g_async_socket_poller = nullptr;
+            g_async_socket_requests.clear();
+            g_async_socket_requests.shrink_to_fit();
+            g_async_socket_exiting = false;
+        }
+    }
+}
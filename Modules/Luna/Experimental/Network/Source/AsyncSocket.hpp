@@ -0,0 +1,20 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file AsyncSocket.hpp
+* @author JXMaster
+* @date 2024/4/27
+*/
+#pragma once
+#include "../Network.hpp"
+
+namespace Luna
+{
+    namespace Network
+    {
+        R<JobSystem::job_id_t> submit_async_socket_io(ISocket* socket, void* buffer, usize size, bool write, AsyncSocketIOResult* out_result);
+        void async_socket_io_close();
+    }
+}
@@ -9,21 +9,69 @@
 */
 #include "../Network.hpp"
 #include <Luna/Runtime/Module.hpp>
+#include "AsyncSocket.hpp"
+#include "SocketUtils.hpp"
 namespace Luna
 {
     namespace Network
     {
+        // The size of the temporary buffer used by `send_file_by_copy`.
+        constexpr usize SEND_FILE_BUFFER_SIZE = 65536;
+
+        RV send_file_by_copy(ISocket* socket, IFile* file, u64 offset, u64 size, u64* sent_bytes)
+        {
+            u64 total = 0;
+            lutry
+            {
+                luexp(file->seek((i64)offset, SeekMode::begin));
+                Blob buffer((usize)min<u64>(size, SEND_FILE_BUFFER_SIZE));
+                while (total < size)
+                {
+                    usize read_bytes = 0;
+                    luexp(file->read(buffer.data(), (usize)min<u64>(size - total, buffer.size()), &read_bytes));
+                    if (!read_bytes) break;
+                    usize written = 0;
+                    while (written < read_bytes)
+                    {
+                        usize write_bytes = 0;
+                        RV r = socket->write((const byte_t*)buffer.data() + written, read_bytes - written, &write_bytes);
+                        written += write_bytes;
+                        if (failed(r))
+                        {
+                            total += written;
+                            luthrow(r.errcode());
+                        }
+                    }
+                    total += read_bytes;
+                }
+            }
+            lucatch
+            {
+                if (sent_bytes) *sent_bytes = total;
+                return luerr;
+            }
+            if (sent_bytes) *sent_bytes = total;
+            return ok;
+        }
+
         RV platform_init();
         void platform_close();
+        void register_telemetry_types();
         struct NetworkModule : public Module
         {
             virtual const c8* get_name() override { return "Network"; }
+            virtual RV on_register() override
+            {
+                return add_dependency_module(this, module_job_system());
+            }
             virtual RV on_init() override
             {
+                register_telemetry_types();
                 return platform_init();
             }
             virtual void on_close() override
             {
+                async_socket_io_close();
                 platform_close();
             }
         };
@@ -10,8 +10,11 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_NETWORK_API LUNA_EXPORT
 #include "../../../Network.hpp"
+#include "../../AsyncSocket.hpp"
+#include "../../SocketUtils.hpp"
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/Runtime/Interface.hpp>
+#include <Luna/Runtime/HashMap.hpp>
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -21,6 +24,17 @@
 #include <netinet/in.h>
 #include <netdb.h>
 #include <errno.h>
+#include <fcntl.h>
+#include <sys/uio.h>
+#ifdef LUNA_PLATFORM_LINUX
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/sendfile.h>
+#include <netinet/udp.h>
+#else
+#include <sys/event.h>
+#include <sys/time.h>
+#endif
 
 namespace Luna
 {
@@ -33,9 +47,12 @@ namespace Luna
 
             AddressFamily m_af;
             int m_socket;
+            // Set if UDP generic segmentation offload is not supported for this socket.
+            bool m_gso_disabled;
 
             Socket() :
-                m_socket(-1) {}
+                m_socket(-1),
+                m_gso_disabled(false) {}
             ~Socket()
             {
                 if(m_socket != -1)
@@ -51,6 +68,20 @@ namespace Luna
             virtual RV listen(i32 len) override;
             virtual RV connect(const SocketAddress& address) override;
             virtual R<Ref<ISocket>> accept(SocketAddress& address) override;
+            virtual RV set_blocking(bool blocking) override;
+            virtual RV send_v(Span<const SocketBuffer> buffers, usize* sent_bytes) override;
+            virtual RV recv_v(Span<const SocketBuffer> buffers, usize* received_bytes) override;
+            virtual RV send_file(IFile* file, u64 offset, u64 size, u64* sent_bytes) override;
+            virtual RV send_datagrams(Span<const Datagram> datagrams, usize* sent_datagrams) override;
+            virtual RV recv_datagrams(Span<Datagram> datagrams, usize* received_datagrams) override;
+            virtual R<JobSystem::job_id_t> read_async(void* buffer, usize size, AsyncSocketIOResult* out_result) override
+            {
+                return submit_async_socket_io(this, buffer, size, false, out_result);
+            }
+            virtual R<JobSystem::job_id_t> write_async(const void* buffer, usize size, AsyncSocketIOResult* out_result) override
+            {
+                return submit_async_socket_io(this, const_cast<void*>(buffer), size, true, out_result);
+            }
         };
 
         inline ErrCode translate_error(int err)
@@ -76,6 +107,12 @@ namespace Luna
             case ENETUNREACH: return NetworkError::network_unreachable();
             case EPROTOTYPE: return NetworkError::protocol_not_supported();
             case ETIMEDOUT: return BasicError::timeout();
+            case EAGAIN: return BasicError::not_ready();
+#if EWOULDBLOCK != EAGAIN
+            case EWOULDBLOCK: return BasicError::not_ready();
+#endif
+            case ENOENT: return BasicError::not_found();
+            case EEXIST: return BasicError::already_exists();
             default: return BasicError::bad_platform_call();
             }
         }
@@ -166,10 +203,642 @@ namespace Luna
             }
             return NetworkError::address_not_supported();
         }
+        RV Socket::set_blocking(bool blocking)
+        {
+            int flags = ::fcntl(m_socket, F_GETFL, 0);
+            if (flags == -1)
+            {
+                return translate_error(errno);
+            }
+            flags = blocking ? (flags & ~O_NONBLOCK) : (flags | O_NONBLOCK);
+            if (::fcntl(m_socket, F_SETFL, flags) == -1)
+            {
+                return translate_error(errno);
+            }
+            return ok;
+        }
+
+        // The number of buffers that are stored on stack when calling `sendmsg` and `recvmsg`.
+        constexpr usize SOCKET_STACK_BUFFERS = 16;
+
+        // Calls `func(iovec*, int)` with buffers converted to `iovec` array.
+        template <typename _Func>
+        static auto with_iovecs(Span<const SocketBuffer> buffers, _Func&& func)
+        {
+            iovec stack_iovecs[SOCKET_STACK_BUFFERS];
+            Vector<iovec> heap_iovecs;
+            iovec* iovecs = stack_iovecs;
+            if (buffers.size() > SOCKET_STACK_BUFFERS)
+            {
+                heap_iovecs.resize(buffers.size());
+                iovecs = heap_iovecs.data();
+            }
+            for (usize i = 0; i < buffers.size(); ++i)
+            {
+                iovecs[i].iov_base = buffers[i].data;
+                iovecs[i].iov_len = buffers[i].size;
+            }
+            return func(iovecs, (int)buffers.size());
+        }
+
+#ifdef MSG_NOSIGNAL
+        // Prevents `SIGPIPE` when the remote side closes the connection.
+        constexpr int SOCKET_SEND_FLAGS = MSG_NOSIGNAL;
+#else
+        constexpr int SOCKET_SEND_FLAGS = 0;
+#endif
+
+        RV Socket::send_v(Span<const SocketBuffer> buffers, usize* sent_bytes)
+        {
+            isize r = with_iovecs(buffers, [&](iovec* iovecs, int num_iovecs)
+            {
+                msghdr msg;
+                memzero(&msg, sizeof(msg));
+                msg.msg_iov = iovecs;
+                msg.msg_iovlen = num_iovecs;
+                return ::sendmsg(m_socket, &msg, SOCKET_SEND_FLAGS);
+            });
+            if (r == -1)
+            {
+                if (sent_bytes) *sent_bytes = 0;
+                return translate_error(errno);
+            }
+            if (sent_bytes) *sent_bytes = (usize)r;
+            return ok;
+        }
+        RV Socket::recv_v(Span<const SocketBuffer> buffers, usize* received_bytes)
+        {
+            isize r = with_iovecs(buffers, [&](iovec* iovecs, int num_iovecs)
+            {
+                msghdr msg;
+                memzero(&msg, sizeof(msg));
+                msg.msg_iov = iovecs;
+                msg.msg_iovlen = num_iovecs;
+                return ::recvmsg(m_socket, &msg, 0);
+            });
+            if (r == -1)
+            {
+                if (received_bytes) *received_bytes = 0;
+                return translate_error(errno);
+            }
+            if (received_bytes) *received_bytes = (usize)r;
+            return ok;
+        }
+        RV Socket::send_file(IFile* file, u64 offset, u64 size, u64* sent_bytes)
+        {
+            opaque_t handle = get_native_file_handle(file);
+            if (!handle)
+            {
+                return send_file_by_copy(this, file, offset, size, sent_bytes);
+            }
+            int fd = (int)(usize)handle;
+            u64 total = 0;
+            RV result = ok;
+            while (total < size)
+            {
+#ifdef LUNA_PLATFORM_LINUX
+                off_t off = (off_t)(offset + total);
+                isize r = ::sendfile(m_socket, fd, &off, (usize)(size - total));
+                if (r == -1)
+                {
+                    if (errno == EINTR) continue;
+                    result = translate_error(errno);
+                    break;
+                }
+                if (r == 0) break;
+                total += (u64)r;
+#else
+                off_t len = (off_t)(size - total);
+                int r = ::sendfile(fd, m_socket, (off_t)(offset + total), &len, nullptr, 0);
+                // `len` is set to the number of sent bytes even if the call fails.
+                total += (u64)len;
+                if (r == -1)
+                {
+                    if (errno == EINTR) continue;
+                    result = translate_error(errno);
+                    break;
+                }
+                if (len == 0) break;
+#endif
+            }
+            if (sent_bytes) *sent_bytes = total;
+            // Partial transfers on non-blocking sockets are reported as success.
+            if (failed(result) && total && result.errcode() == BasicError::not_ready()) return ok;
+            return result;
+        }
+
+        static bool encode_address(const SocketAddress& address, sockaddr_in& out)
+        {
+            if (address.family != AddressFamily::ipv4) return false;
+            memzero(&out, sizeof(out));
+            out.sin_family = AF_INET;
+            out.sin_port = htons(address.ipv4.port);
+            memcpy(&out.sin_addr.s_addr, &address.ipv4.address, 4);
+            return true;
+        }
+        static void decode_address(const sockaddr_storage& addr, SocketAddress& out)
+        {
+            memzero(&out, sizeof(SocketAddress));
+            if (addr.ss_family == AF_INET)
+            {
+                const sockaddr_in& addr_in = (const sockaddr_in&)addr;
+                out.family = AddressFamily::ipv4;
+                out.ipv4.port = ntohs(addr_in.sin_port);
+                memcpy(&out.ipv4.address, &addr_in.sin_addr.s_addr, 4);
+            }
+            else
+            {
+                out.family = AddressFamily::unspecified;
+            }
+        }
+
+#ifdef LUNA_PLATFORM_LINUX
+        // The maximum number of datagrams processed by one `sendmmsg` or `recvmmsg` call.
+        constexpr usize DATAGRAM_BATCH_SIZE = 64;
+#ifdef UDP_SEGMENT
+        // Limits of one UDP GSO message.
+        constexpr usize UDP_GSO_MAX_SEGMENTS = 64;
+        constexpr usize UDP_GSO_MAX_BYTES = 65000;
+#endif
+        RV Socket::send_datagrams(Span<const Datagram> datagrams, usize* sent_datagrams)
+        {
+            usize sent = 0;
+            RV result = ok;
+            bool stop = false;
+            while (sent < datagrams.size() && !stop)
+            {
+                mmsghdr msgs[DATAGRAM_BATCH_SIZE];
+                sockaddr_in addrs[DATAGRAM_BATCH_SIZE];
+                iovec iovs[DATAGRAM_BATCH_SIZE];
+                usize msg_datagrams[DATAGRAM_BATCH_SIZE];
+#ifdef UDP_SEGMENT
+                alignas(cmsghdr) byte_t controls[DATAGRAM_BATCH_SIZE][CMSG_SPACE(sizeof(u16))];
+                bool use_gso = false;
+#endif
+                usize num_msgs = 0;
+                usize i = sent;
+                // Every datagram uses one `iovec`, so one batch contains at most `DATAGRAM_BATCH_SIZE` datagrams.
+                while (i < datagrams.size() && i - sent < DATAGRAM_BATCH_SIZE)
+                {
+                    const Datagram& d = datagrams[i];
+                    if (!encode_address(d.address, addrs[num_msgs]))
+                    {
+                        result = NetworkError::address_not_supported();
+                        stop = true;
+                        break;
+                    }
+                    usize count = 1;
+#ifdef UDP_SEGMENT
+                    // Merge consecutive datagrams with the same size and address into one GSO message.
+                    if (!m_gso_disabled && d.size)
+                    {
+                        while (i + count < datagrams.size() && i + count - sent < DATAGRAM_BATCH_SIZE && 
+                            count < UDP_GSO_MAX_SEGMENTS && (count + 1) * d.size <= UDP_GSO_MAX_BYTES)
+                        {
+                            const Datagram& next = datagrams[i + count];
+                            if (next.size != d.size || next.address.family != d.address.family || next.address.ipv4.port != d.address.ipv4.port ||
+                                memcmp(&next.address.ipv4.address, &d.address.ipv4.address, sizeof(IPv4Address))) break;
+                            ++count;
+                        }
+                    }
+#endif
+                    iovec* msg_iovs = iovs + (i - sent);
+                    for (usize k = 0; k < count; ++k)
+                    {
+                        msg_iovs[k].iov_base = datagrams[i + k].data;
+                        msg_iovs[k].iov_len = datagrams[i + k].size;
+                    }
+                    msghdr& hdr = msgs[num_msgs].msg_hdr;
+                    memzero(&hdr, sizeof(msghdr));
+                    hdr.msg_name = &addrs[num_msgs];
+                    hdr.msg_namelen = sizeof(sockaddr_in);
+                    hdr.msg_iov = msg_iovs;
+                    hdr.msg_iovlen = count;
+#ifdef UDP_SEGMENT
+                    if (count > 1)
+                    {
+                        hdr.msg_control = controls[num_msgs];
+                        hdr.msg_controllen = sizeof(controls[num_msgs]);
+                        cmsghdr* cmsg = CMSG_FIRSTHDR(&hdr);
+                        cmsg->cmsg_level = SOL_UDP;
+                        cmsg->cmsg_type = UDP_SEGMENT;
+                        cmsg->cmsg_len = CMSG_LEN(sizeof(u16));
+                        u16 segment_size = (u16)d.size;
+                        memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(u16));
+                        use_gso = true;
+                    }
+#endif
+                    msgs[num_msgs].msg_len = 0;
+                    msg_datagrams[num_msgs] = count;
+                    ++num_msgs;
+                    i += count;
+                }
+                if (!num_msgs) break;
+                int r = ::sendmmsg(m_socket, msgs, (unsigned int)num_msgs, SOCKET_SEND_FLAGS);
+                if (r == -1)
+                {
+                    if (errno == EINTR) continue;
+#ifdef UDP_SEGMENT
+                    if (use_gso && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT))
+                    {
+                        // GSO is not supported by the system or the network device, retry without GSO.
+                        m_gso_disabled = true;
+                        stop = false;
+                        result = ok;
+                        continue;
+                    }
+#endif
+                    result = translate_error(errno);
+                    break;
+                }
+                for (int m = 0; m < r; ++m)
+                {
+                    sent += msg_datagrams[m];
+                }
+                if ((usize)r < num_msgs) break;
+            }
+            if (sent_datagrams) *sent_datagrams = sent;
+            return sent ? ok : result;
+        }
+        RV Socket::recv_datagrams(Span<Datagram> datagrams, usize* received_datagrams)
+        {
+            usize received = 0;
+            RV result = ok;
+            while (received < datagrams.size())
+            {
+                mmsghdr msgs[DATAGRAM_BATCH_SIZE];
+                sockaddr_storage addrs[DATAGRAM_BATCH_SIZE];
+                iovec iovs[DATAGRAM_BATCH_SIZE];
+                usize num_msgs = min(datagrams.size() - received, DATAGRAM_BATCH_SIZE);
+                for (usize i = 0; i < num_msgs; ++i)
+                {
+                    Datagram& d = datagrams[received + i];
+                    iovs[i].iov_base = d.data;
+                    iovs[i].iov_len = d.size;
+                    msghdr& hdr = msgs[i].msg_hdr;
+                    memzero(&hdr, sizeof(msghdr));
+                    hdr.msg_name = &addrs[i];
+                    hdr.msg_namelen = sizeof(sockaddr_storage);
+                    hdr.msg_iov = &iovs[i];
+                    hdr.msg_iovlen = 1;
+                    msgs[i].msg_len = 0;
+                }
+                // Only the first batch may block.
+                int flags = received ? MSG_DONTWAIT : MSG_WAITFORONE;
+                int r = ::recvmmsg(m_socket, msgs, (unsigned int)num_msgs, flags, nullptr);
+                if (r == -1)
+                {
+                    if (errno == EINTR && !received) continue;
+                    if (!received) result = translate_error(errno);
+                    break;
+                }
+                for (int i = 0; i < r; ++i)
+                {
+                    Datagram& d = datagrams[received + i];
+                    d.size = msgs[i].msg_len;
+                    decode_address(addrs[i], d.address);
+                }
+                received += (usize)r;
+                if ((usize)r < num_msgs) break;
+            }
+            if (received_datagrams) *received_datagrams = received;
+            return received ? ok : result;
+        }
+#else
+        RV Socket::send_datagrams(Span<const Datagram> datagrams, usize* sent_datagrams)
+        {
+            usize sent = 0;
+            RV result = ok;
+            while (sent < datagrams.size())
+            {
+                const Datagram& d = datagrams[sent];
+                sockaddr_in addr;
+                if (!encode_address(d.address, addr))
+                {
+                    result = NetworkError::address_not_supported();
+                    break;
+                }
+                isize r = ::sendto(m_socket, d.data, d.size, SOCKET_SEND_FLAGS, (const sockaddr*)&addr, sizeof(addr));
+                if (r == -1)
+                {
+                    if (errno == EINTR) continue;
+                    result = translate_error(errno);
+                    break;
+                }
+                ++sent;
+            }
+            if (sent_datagrams) *sent_datagrams = sent;
+            return sent ? ok : result;
+        }
+        RV Socket::recv_datagrams(Span<Datagram> datagrams, usize* received_datagrams)
+        {
+            usize received = 0;
+            RV result = ok;
+            while (received < datagrams.size())
+            {
+                Datagram& d = datagrams[received];
+                sockaddr_storage addr;
+                socklen_t addr_size = sizeof(addr);
+                // Only the first datagram may block.
+                isize r = ::recvfrom(m_socket, d.data, d.size, received ? MSG_DONTWAIT : 0, (sockaddr*)&addr, &addr_size);
+                if (r == -1)
+                {
+                    if (errno == EINTR && !received) continue;
+                    if (!received) result = translate_error(errno);
+                    break;
+                }
+                d.size = (usize)r;
+                decode_address(addr, d.address);
+                ++received;
+            }
+            if (received_datagrams) *received_datagrams = received;
+            return received ? ok : result;
+        }
+#endif
+
+        struct PollerEntry
+        {
+            Ref<ISocket> m_socket;
+            void* m_userdata;
+            PollEventFlag m_events;
+        };
+
+        struct Poller : INetworkPoller
+        {
+            lustruct("Network::Poller", "{8C3F5E21-47A9-4D0B-B612-95E0D7A4C3B8}");
+            luiimpl();
+
+            int m_fd;
+#ifdef LUNA_PLATFORM_LINUX
+            // The event file descriptor used to wake up `wait`.
+            int m_wake_fd;
+#endif
+            HashMap<ISocket*, PollerEntry> m_entries;
+#ifdef LUNA_PLATFORM_LINUX
+            Vector<epoll_event> m_events;
+#else
+            Vector<struct kevent> m_events;
+#endif
+
+#ifdef LUNA_PLATFORM_LINUX
+            Poller() :
+                m_fd(-1),
+                m_wake_fd(-1) {}
+#else
+            Poller() :
+                m_fd(-1) {}
+#endif
+            ~Poller()
+            {
+                if (m_fd != -1)
+                {
+                    ::close(m_fd);
+                    m_fd = -1;
+                }
+#ifdef LUNA_PLATFORM_LINUX
+                if (m_wake_fd != -1)
+                {
+                    ::close(m_wake_fd);
+                    m_wake_fd = -1;
+                }
+#endif
+            }
+            RV init();
+            RV update(ISocket* socket, PollEventFlag old_events, PollEventFlag new_events, int op);
+            virtual RV add_socket(ISocket* socket, PollEventFlag events, void* userdata) override;
+            virtual RV modify_socket(ISocket* socket, PollEventFlag events, void* userdata) override;
+            virtual RV remove_socket(ISocket* socket) override;
+            virtual R<usize> wait(Span<PollEvent> out_events, u32 timeout_ms) override;
+            virtual void wake() override;
+        };
+
+        inline int get_socket_fd(ISocket* socket)
+        {
+            return (int)(usize)socket->get_native_handle();
+        }
+
+#ifdef LUNA_PLATFORM_LINUX
+        RV Poller::init()
+        {
+            m_fd = ::epoll_create1(EPOLL_CLOEXEC);
+            if (m_fd == -1)
+            {
+                return translate_error(errno);
+            }
+            m_wake_fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+            if (m_wake_fd == -1)
+            {
+                return translate_error(errno);
+            }
+            // The wake event is identified by one null data pointer.
+            epoll_event ev;
+            memzero(&ev, sizeof(ev));
+            ev.events = EPOLLIN;
+            ev.data.ptr = nullptr;
+            if (::epoll_ctl(m_fd, EPOLL_CTL_ADD, m_wake_fd, &ev) == -1)
+            {
+                return translate_error(errno);
+            }
+            return ok;
+        }
+        // `op` is one of `EPOLL_CTL_ADD`, `EPOLL_CTL_MOD` and `EPOLL_CTL_DEL`.
+        RV Poller::update(ISocket* socket, PollEventFlag old_events, PollEventFlag new_events, int op)
+        {
+            epoll_event ev;
+            memzero(&ev, sizeof(ev));
+            ev.events = EPOLLRDHUP;
+            if (test_flags(new_events, PollEventFlag::readable)) ev.events |= EPOLLIN;
+            if (test_flags(new_events, PollEventFlag::writable)) ev.events |= EPOLLOUT;
+            ev.data.ptr = socket;
+            if (::epoll_ctl(m_fd, op, get_socket_fd(socket), &ev) == -1)
+            {
+                return translate_error(errno);
+            }
+            return ok;
+        }
+        R<usize> Poller::wait(Span<PollEvent> out_events, u32 timeout_ms)
+        {
+            if (out_events.empty()) return BasicError::bad_arguments();
+            m_events.resize(out_events.size());
+            int timeout = timeout_ms == U32_MAX ? -1 : (int)min<u32>(timeout_ms, I32_MAX);
+            int n = ::epoll_wait(m_fd, m_events.data(), (int)m_events.size(), timeout);
+            if (n == -1)
+            {
+                if (errno == EINTR) return 0;
+                return translate_error(errno);
+            }
+            usize num_events = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                const epoll_event& ev = m_events[i];
+                ISocket* socket = (ISocket*)ev.data.ptr;
+                if (!socket)
+                {
+                    u64 value;
+                    isize r = ::read(m_wake_fd, &value, sizeof(u64));
+                    (void)r;
+                    continue;
+                }
+                PollEvent& dst = out_events[num_events];
+                ++num_events;
+                dst.socket = socket;
+                dst.userdata = m_entries.find(socket)->second.m_userdata;
+                dst.events = PollEventFlag::none;
+                if (ev.events & EPOLLIN) set_flags(dst.events, PollEventFlag::readable);
+                if (ev.events & EPOLLOUT) set_flags(dst.events, PollEventFlag::writable);
+                if (ev.events & EPOLLERR) set_flags(dst.events, PollEventFlag::error);
+                if (ev.events & (EPOLLHUP | EPOLLRDHUP)) set_flags(dst.events, PollEventFlag::hang_up);
+            }
+            return num_events;
+        }
+        void Poller::wake()
+        {
+            u64 value = 1;
+            isize r = ::write(m_wake_fd, &value, sizeof(u64));
+            (void)r;
+        }
+        static constexpr int POLLER_OP_ADD = EPOLL_CTL_ADD;
+        static constexpr int POLLER_OP_MODIFY = EPOLL_CTL_MOD;
+        static constexpr int POLLER_OP_REMOVE = EPOLL_CTL_DEL;
+#else
+        RV Poller::init()
+        {
+            m_fd = ::kqueue();
+            if (m_fd == -1)
+            {
+                return translate_error(errno);
+            }
+            // The wake event is identified by one null user data pointer.
+            struct kevent ev;
+            EV_SET(&ev, 0, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, nullptr);
+            if (::kevent(m_fd, &ev, 1, nullptr, 0, nullptr) == -1)
+            {
+                return translate_error(errno);
+            }
+            return ok;
+        }
+        // kqueue watches read and write events by separate filters, so only filters whose states change are submitted.
+        RV Poller::update(ISocket* socket, PollEventFlag old_events, PollEventFlag new_events, int op)
+        {
+            struct kevent changes[2];
+            int num_changes = 0;
+            int fd = get_socket_fd(socket);
+            auto update_filter = [&](PollEventFlag flag, i16 filter)
+            {
+                bool was_set = test_flags(old_events, flag);
+                bool is_set = test_flags(new_events, flag);
+                if (was_set != is_set)
+                {
+                    EV_SET(&changes[num_changes], fd, filter, is_set ? EV_ADD : EV_DELETE, 0, 0, socket);
+                    ++num_changes;
+                }
+            };
+            update_filter(PollEventFlag::readable, EVFILT_READ);
+            update_filter(PollEventFlag::writable, EVFILT_WRITE);
+            if (num_changes && ::kevent(m_fd, changes, num_changes, nullptr, 0, nullptr) == -1)
+            {
+                return translate_error(errno);
+            }
+            return ok;
+        }
+        R<usize> Poller::wait(Span<PollEvent> out_events, u32 timeout_ms)
+        {
+            if (out_events.empty()) return BasicError::bad_arguments();
+            m_events.resize(out_events.size());
+            timespec timeout;
+            timeout.tv_sec = timeout_ms / 1000;
+            timeout.tv_nsec = (timeout_ms % 1000) * 1000000;
+            int n = ::kevent(m_fd, nullptr, 0, m_events.data(), (int)m_events.size(), timeout_ms == U32_MAX ? nullptr : &timeout);
+            if (n == -1)
+            {
+                if (errno == EINTR) return 0;
+                return translate_error(errno);
+            }
+            usize num_events = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                const struct kevent& ev = m_events[i];
+                if (ev.filter == EVFILT_USER) continue;
+                ISocket* socket = (ISocket*)ev.udata;
+                PollEvent& dst = out_events[num_events];
+                ++num_events;
+                dst.socket = socket;
+                dst.userdata = m_entries.find(socket)->second.m_userdata;
+                dst.events = PollEventFlag::none;
+                if (ev.filter == EVFILT_READ) set_flags(dst.events, PollEventFlag::readable);
+                if (ev.filter == EVFILT_WRITE) set_flags(dst.events, PollEventFlag::writable);
+                if (ev.flags & EV_ERROR) set_flags(dst.events, PollEventFlag::error);
+                if (ev.flags & EV_EOF) set_flags(dst.events, PollEventFlag::hang_up);
+            }
+            return num_events;
+        }
+        void Poller::wake()
+        {
+            struct kevent ev;
+            EV_SET(&ev, 0, EVFILT_USER, 0, NOTE_TRIGGER, 0, nullptr);
+            ::kevent(m_fd, &ev, 1, nullptr, 0, nullptr);
+        }
+        static constexpr int POLLER_OP_ADD = 0;
+        static constexpr int POLLER_OP_MODIFY = 1;
+        static constexpr int POLLER_OP_REMOVE = 2;
+#endif
+        RV Poller::add_socket(ISocket* socket, PollEventFlag events, void* userdata)
+        {
+            lutry
+            {
+                if (m_entries.find(socket) != m_entries.end()) return BasicError::already_exists();
+                luexp(update(socket, PollEventFlag::none, events, POLLER_OP_ADD));
+                PollerEntry entry;
+                entry.m_socket = socket;
+                entry.m_userdata = userdata;
+                entry.m_events = events;
+                m_entries.insert(make_pair(socket, move(entry)));
+            }
+            lucatchret;
+            return ok;
+        }
+        RV Poller::modify_socket(ISocket* socket, PollEventFlag events, void* userdata)
+        {
+            lutry
+            {
+                auto iter = m_entries.find(socket);
+                if (iter == m_entries.end()) return BasicError::not_found();
+                luexp(update(socket, iter->second.m_events, events, POLLER_OP_MODIFY));
+                iter->second.m_userdata = userdata;
+                iter->second.m_events = events;
+            }
+            lucatchret;
+            return ok;
+        }
+        RV Poller::remove_socket(ISocket* socket)
+        {
+            lutry
+            {
+                auto iter = m_entries.find(socket);
+                if (iter == m_entries.end()) return BasicError::not_found();
+                luexp(update(socket, iter->second.m_events, PollEventFlag::none, POLLER_OP_REMOVE));
+                m_entries.erase(iter);
+            }
+            lucatchret;
+            return ok;
+        }
+        LUNA_NETWORK_API R<Ref<INetworkPoller>> new_poller()
+        {
+            Ref<Poller> poller = new_object<Poller>();
+            lutry
+            {
+                luexp(poller->init());
+            }
+            lucatchret;
+            return Ref<INetworkPoller>(poller);
+        }
+
         RV platform_init()
         {
             register_boxed_type<Socket>();
             impl_interface_for_type<Socket, ISocket>();
+            register_boxed_type<Poller>();
+            impl_interface_for_type<Poller, INetworkPoller>();
             return ok;
         }
         void platform_close()
@@ -10,11 +10,16 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_NETWORK_API LUNA_EXPORT
 #include "../../../Network.hpp"
+#include "../../AsyncSocket.hpp"
+#include "../../SocketUtils.hpp"
 #include <Luna/Runtime/Module.hpp>
 #include <WinSock2.h>
 #include <Luna/Runtime/Unicode.hpp>
+#include <Luna/Runtime/HashMap.hpp>
 #include <ws2tcpip.h>
+#include <MSWSock.h>
 #pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "mswsock.lib")
 
 namespace Luna
 {
@@ -45,6 +50,20 @@ namespace Luna
             virtual RV listen(i32 len) override;
             virtual RV connect(const SocketAddress& address) override;
             virtual R<Ref<ISocket>> accept(SocketAddress& address) override;
+            virtual RV set_blocking(bool blocking) override;
+            virtual RV send_v(Span<const SocketBuffer> buffers, usize* sent_bytes) override;
+            virtual RV recv_v(Span<const SocketBuffer> buffers, usize* received_bytes) override;
+            virtual RV send_file(IFile* file, u64 offset, u64 size, u64* sent_bytes) override;
+            virtual RV send_datagrams(Span<const Datagram> datagrams, usize* sent_datagrams) override;
+            virtual RV recv_datagrams(Span<Datagram> datagrams, usize* received_datagrams) override;
+            virtual R<JobSystem::job_id_t> read_async(void* buffer, usize size, AsyncSocketIOResult* out_result) override
+            {
+                return submit_async_socket_io(this, buffer, size, false, out_result);
+            }
+            virtual R<JobSystem::job_id_t> write_async(const void* buffer, usize size, AsyncSocketIOResult* out_result) override
+            {
+                return submit_async_socket_io(this, const_cast<void*>(buffer), size, true, out_result);
+            }
         };
         inline ErrCode translate_error(int err)
         {
@@ -79,6 +98,7 @@ namespace Luna
             case WSAESOCKTNOSUPPORT: return BasicError::bad_arguments();
             case WSAEPROTONOSUPPORT: return NetworkError::protocol_not_supported();
             case WSATRY_AGAIN: return BasicError::not_ready();
+            case WSAEWOULDBLOCK: return BasicError::not_ready();
             case WSANO_RECOVERY: return BasicError::bad_arguments();
             case WSA_NOT_ENOUGH_MEMORY: return BasicError::out_of_memory();
             case WSAHOST_NOT_FOUND: return NetworkError::host_not_found();
@@ -184,10 +204,384 @@ namespace Luna
             }
             return NetworkError::address_not_supported();
         }
+        RV Socket::set_blocking(bool blocking)
+        {
+            u_long mode = blocking ? 0 : 1;
+            if (::ioctlsocket(m_socket, FIONBIO, &mode) == SOCKET_ERROR)
+            {
+                int err = WSAGetLastError();
+                return translate_error(err);
+            }
+            return ok;
+        }
+
+        // The number of buffers that are stored on stack when calling `WSASend` and `WSARecv`.
+        constexpr usize SOCKET_STACK_BUFFERS = 16;
+        // The maximum number of bytes sent by one `TransmitFile` call.
+        constexpr u64 TRANSMIT_FILE_MAX_SIZE = 1 << 30;
+
+        // Calls `func(WSABUF*, DWORD)` with buffers converted to `WSABUF` array.
+        template <typename _Func>
+        static auto with_wsabufs(Span<const SocketBuffer> buffers, _Func&& func)
+        {
+            WSABUF stack_bufs[SOCKET_STACK_BUFFERS];
+            Vector<WSABUF> heap_bufs;
+            WSABUF* bufs = stack_bufs;
+            if (buffers.size() > SOCKET_STACK_BUFFERS)
+            {
+                heap_bufs.resize(buffers.size());
+                bufs = heap_bufs.data();
+            }
+            for (usize i = 0; i < buffers.size(); ++i)
+            {
+                bufs[i].buf = (CHAR*)buffers[i].data;
+                bufs[i].len = (ULONG)buffers[i].size;
+            }
+            return func(bufs, (DWORD)buffers.size());
+        }
+
+        RV Socket::send_v(Span<const SocketBuffer> buffers, usize* sent_bytes)
+        {
+            DWORD sent = 0;
+            int r = with_wsabufs(buffers, [&](WSABUF* bufs, DWORD num_bufs)
+            {
+                return ::WSASend(m_socket, bufs, num_bufs, &sent, 0, nullptr, nullptr);
+            });
+            if (r == SOCKET_ERROR)
+            {
+                if (sent_bytes) *sent_bytes = 0;
+                int err = WSAGetLastError();
+                return translate_error(err);
+            }
+            if (sent_bytes) *sent_bytes = sent;
+            return ok;
+        }
+        RV Socket::recv_v(Span<const SocketBuffer> buffers, usize* received_bytes)
+        {
+            DWORD received = 0;
+            DWORD flags = 0;
+            int r = with_wsabufs(buffers, [&](WSABUF* bufs, DWORD num_bufs)
+            {
+                return ::WSARecv(m_socket, bufs, num_bufs, &received, &flags, nullptr, nullptr);
+            });
+            if (r == SOCKET_ERROR)
+            {
+                if (received_bytes) *received_bytes = 0;
+                int err = WSAGetLastError();
+                return translate_error(err);
+            }
+            if (received_bytes) *received_bytes = received;
+            return ok;
+        }
+        RV Socket::send_file(IFile* file, u64 offset, u64 size, u64* sent_bytes)
+        {
+            HANDLE handle = (HANDLE)get_native_file_handle(file);
+            if (!handle)
+            {
+                return send_file_by_copy(this, file, offset, size, sent_bytes);
+            }
+            u64 total = 0;
+            RV result = ok;
+            HANDLE event = ::CreateEventW(nullptr, TRUE, FALSE, nullptr);
+            if (!event)
+            {
+                if (sent_bytes) *sent_bytes = 0;
+                return BasicError::bad_platform_call();
+            }
+            while (total < size)
+            {
+                u64 pos = offset + total;
+                DWORD to_send = (DWORD)min<u64>(size - total, TRANSMIT_FILE_MAX_SIZE);
+                OVERLAPPED overlapped;
+                memzero(&overlapped);
+                overlapped.Offset = (DWORD)(pos & 0xFFFFFFFF);
+                overlapped.OffsetHigh = (DWORD)(pos >> 32);
+                overlapped.hEvent = event;
+                ::ResetEvent(event);
+                DWORD transferred = 0;
+                DWORD flags = 0;
+                if (!::TransmitFile(m_socket, handle, to_send, 0, &overlapped, nullptr, 0))
+                {
+                    int err = WSAGetLastError();
+                    // Sockets created by `socket` are overlapped, so the transfer may be pending.
+                    if ((err != WSA_IO_PENDING && err != ERROR_IO_PENDING) ||
+                        !::WSAGetOverlappedResult(m_socket, &overlapped, &transferred, TRUE, &flags))
+                    {
+                        err = WSAGetLastError();
+                        result = translate_error(err);
+                        break;
+                    }
+                }
+                else
+                {
+                    ::WSAGetOverlappedResult(m_socket, &overlapped, &transferred, TRUE, &flags);
+                }
+                total += transferred;
+                if (transferred < to_send) break;
+            }
+            ::CloseHandle(event);
+            if (sent_bytes) *sent_bytes = total;
+            return result;
+        }
+
+        static bool encode_address(const SocketAddress& address, sockaddr_in& out)
+        {
+            if (address.family != AddressFamily::ipv4) return false;
+            memzero(&out, sizeof(out));
+            out.sin_family = AF_INET;
+            out.sin_port = ::htons(address.ipv4.port);
+            memcpy(&out.sin_addr.S_un.S_un_b.s_b1, &address.ipv4.address, 4);
+            return true;
+        }
+        static void decode_address(const sockaddr_storage& addr, SocketAddress& out)
+        {
+            memzero(&out, sizeof(SocketAddress));
+            if (addr.ss_family == AF_INET)
+            {
+                const sockaddr_in& addr_in = (const sockaddr_in&)addr;
+                out.family = AddressFamily::ipv4;
+                out.ipv4.port = ::ntohs(addr_in.sin_port);
+                memcpy(&out.ipv4.address, &addr_in.sin_addr.S_un.S_un_b.s_b1, 4);
+            }
+            else
+            {
+                out.family = AddressFamily::unspecified;
+            }
+        }
+        // Windows does not provide batched datagram system calls, so datagrams are sent and received one by one.
+        RV Socket::send_datagrams(Span<const Datagram> datagrams, usize* sent_datagrams)
+        {
+            usize sent = 0;
+            RV result = ok;
+            while (sent < datagrams.size())
+            {
+                const Datagram& d = datagrams[sent];
+                sockaddr_in addr;
+                if (!encode_address(d.address, addr))
+                {
+                    result = NetworkError::address_not_supported();
+                    break;
+                }
+                int r = ::sendto(m_socket, (const char*)d.data, (int)d.size, 0, (const sockaddr*)&addr, sizeof(addr));
+                if (r == SOCKET_ERROR)
+                {
+                    int err = WSAGetLastError();
+                    result = translate_error(err);
+                    break;
+                }
+                ++sent;
+            }
+            if (sent_datagrams) *sent_datagrams = sent;
+            return sent ? ok : result;
+        }
+        RV Socket::recv_datagrams(Span<Datagram> datagrams, usize* received_datagrams)
+        {
+            usize received = 0;
+            RV result = ok;
+            while (received < datagrams.size())
+            {
+                if (received)
+                {
+                    // Only the first datagram may block.
+                    u_long available = 0;
+                    if (::ioctlsocket(m_socket, FIONREAD, &available) == SOCKET_ERROR || !available) break;
+                }
+                Datagram& d = datagrams[received];
+                sockaddr_storage addr;
+                int addr_size = sizeof(addr);
+                int r = ::recvfrom(m_socket, (char*)d.data, (int)d.size, 0, (sockaddr*)&addr, &addr_size);
+                if (r == SOCKET_ERROR)
+                {
+                    int err = WSAGetLastError();
+                    // The datagram is truncated.
+                    if (err == WSAEMSGSIZE)
+                    {
+                        decode_address(addr, d.address);
+                        ++received;
+                        continue;
+                    }
+                    if (!received) result = translate_error(err);
+                    break;
+                }
+                d.size = (usize)r;
+                decode_address(addr, d.address);
+                ++received;
+            }
+            if (received_datagrams) *received_datagrams = received;
+            return received ? ok : result;
+        }
+
+        // The poller is implemented by `WSAPoll`, which provides readiness notifications like `epoll` and `kqueue`.
+        // Sockets are stored in one dense array so that the array can be passed to `WSAPoll` directly.
+        // The first element is always one UDP socket connected to itself, which is used to wake up `WSAPoll`.
+        struct Poller : INetworkPoller
+        {
+            lustruct("Network::Poller", "{4F7A2C90-1B6E-4D35-A8C3-E05B92D716F4}");
+            luiimpl();
+
+            Vector<WSAPOLLFD> m_fds;
+            Vector<Ref<ISocket>> m_sockets;
+            Vector<void*> m_userdata;
+            HashMap<ISocket*, usize> m_indices;
+            SOCKET m_wake_socket;
+
+            Poller() :
+                m_wake_socket(INVALID_SOCKET) {}
+            ~Poller()
+            {
+                if (m_wake_socket != INVALID_SOCKET)
+                {
+                    closesocket(m_wake_socket);
+                    m_wake_socket = INVALID_SOCKET;
+                }
+            }
+            RV init();
+
+            virtual RV add_socket(ISocket* socket, PollEventFlag events, void* userdata) override;
+            virtual RV modify_socket(ISocket* socket, PollEventFlag events, void* userdata) override;
+            virtual RV remove_socket(ISocket* socket) override;
+            virtual R<usize> wait(Span<PollEvent> out_events, u32 timeout_ms) override;
+            virtual void wake() override;
+        };
+
+        inline SHORT encode_poll_events(PollEventFlag events)
+        {
+            SHORT r = 0;
+            if (test_flags(events, PollEventFlag::readable)) r |= POLLRDNORM;
+            if (test_flags(events, PollEventFlag::writable)) r |= POLLWRNORM;
+            return r;
+        }
+
+        RV Poller::init()
+        {
+            m_wake_socket = ::socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+            if (m_wake_socket == INVALID_SOCKET)
+            {
+                int err = WSAGetLastError();
+                return translate_error(err);
+            }
+            sockaddr_in addr;
+            memzero(&addr, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = ::htonl(INADDR_LOOPBACK);
+            addr.sin_port = 0;
+            int addr_size = sizeof(addr);
+            u_long mode = 1;
+            if (::bind(m_wake_socket, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+                ::getsockname(m_wake_socket, (sockaddr*)&addr, &addr_size) == SOCKET_ERROR ||
+                ::connect(m_wake_socket, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR ||
+                ::ioctlsocket(m_wake_socket, FIONBIO, &mode) == SOCKET_ERROR)
+            {
+                int err = WSAGetLastError();
+                return translate_error(err);
+            }
+            WSAPOLLFD fd;
+            fd.fd = m_wake_socket;
+            fd.events = POLLRDNORM;
+            fd.revents = 0;
+            m_fds.push_back(fd);
+            m_sockets.push_back(nullptr);
+            m_userdata.push_back(nullptr);
+            return ok;
+        }
+        RV Poller::add_socket(ISocket* socket, PollEventFlag events, void* userdata)
+        {
+            if (m_indices.find(socket) != m_indices.end()) return BasicError::already_exists();
+            WSAPOLLFD fd;
+            fd.fd = (SOCKET)socket->get_native_handle();
+            fd.events = encode_poll_events(events);
+            fd.revents = 0;
+            m_indices.insert(make_pair(socket, m_fds.size()));
+            m_fds.push_back(fd);
+            m_sockets.push_back(socket);
+            m_userdata.push_back(userdata);
+            return ok;
+        }
+        RV Poller::modify_socket(ISocket* socket, PollEventFlag events, void* userdata)
+        {
+            auto iter = m_indices.find(socket);
+            if (iter == m_indices.end()) return BasicError::not_found();
+            m_fds[iter->second].events = encode_poll_events(events);
+            m_userdata[iter->second] = userdata;
+            return ok;
+        }
+        RV Poller::remove_socket(ISocket* socket)
+        {
+            auto iter = m_indices.find(socket);
+            if (iter == m_indices.end()) return BasicError::not_found();
+            // Swap the last socket to fill the empty slot.
+            usize index = iter->second;
+            usize last = m_fds.size() - 1;
+            m_indices.erase(iter);
+            if (index != last)
+            {
+                m_fds[index] = m_fds[last];
+                m_sockets[index] = move(m_sockets[last]);
+                m_userdata[index] = m_userdata[last];
+                m_indices.find(m_sockets[index].get())->second = index;
+            }
+            m_fds.pop_back();
+            m_sockets.pop_back();
+            m_userdata.pop_back();
+            return ok;
+        }
+        R<usize> Poller::wait(Span<PollEvent> out_events, u32 timeout_ms)
+        {
+            if (out_events.empty()) return BasicError::bad_arguments();
+            INT timeout = timeout_ms == U32_MAX ? -1 : (INT)min<u32>(timeout_ms, I32_MAX);
+            int n = ::WSAPoll(m_fds.data(), (ULONG)m_fds.size(), timeout);
+            if (n == SOCKET_ERROR)
+            {
+                int err = WSAGetLastError();
+                return translate_error(err);
+            }
+            usize num_events = 0;
+            for (usize i = 0; i < m_fds.size() && n > 0 && num_events < out_events.size(); ++i)
+            {
+                SHORT revents = m_fds[i].revents;
+                if (!revents) continue;
+                --n;
+                if (i == 0)
+                {
+                    // Drain all wake signals.
+                    char buf[64];
+                    while (::recv(m_wake_socket, buf, sizeof(buf), 0) > 0) {}
+                    continue;
+                }
+                PollEvent& dst = out_events[num_events];
+                dst.socket = m_sockets[i].get();
+                dst.userdata = m_userdata[i];
+                dst.events = PollEventFlag::none;
+                if (revents & POLLRDNORM) set_flags(dst.events, PollEventFlag::readable);
+                if (revents & POLLWRNORM) set_flags(dst.events, PollEventFlag::writable);
+                if (revents & (POLLERR | POLLNVAL)) set_flags(dst.events, PollEventFlag::error);
+                if (revents & POLLHUP) set_flags(dst.events, PollEventFlag::hang_up);
+                ++num_events;
+            }
+            return num_events;
+        }
+        void Poller::wake()
+        {
+            char c = 0;
+            ::send(m_wake_socket, &c, 1, 0);
+        }
+        LUNA_NETWORK_API R<Ref<INetworkPoller>> new_poller()
+        {
+            Ref<Poller> poller = new_object<Poller>();
+            lutry
+            {
+                luexp(poller->init());
+            }
+            lucatchret;
+            return Ref<INetworkPoller>(poller);
+        }
+
         RV platform_init()
         {
             register_boxed_type<Socket>();
             impl_interface_for_type<Socket, ISocket>();
+            register_boxed_type<Poller>();
+            impl_interface_for_type<Poller, INetworkPoller>();
             WORD sock_version = MAKEWORD(2, 2);
             WSADATA data;
             auto r = WSAStartup(sock_version, &data);
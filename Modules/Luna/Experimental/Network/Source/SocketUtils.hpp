@@ -0,0 +1,20 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SocketUtils.hpp
+* @author JXMaster
+* @date 2024/4/27
+*/
+#pragma once
+#include "../Network.hpp"
+
+namespace Luna
+{
+    namespace Network
+    {
+        //! Sends file data by reading the file to one temporary buffer, used when the file does not have one platform handle.
+        RV send_file_by_copy(ISocket* socket, IFile* file, u64 offset, u64 size, u64* sent_bytes);
+    }
+}
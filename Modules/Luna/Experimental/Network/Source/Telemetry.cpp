@@ -0,0 +1,387 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Telemetry.cpp
+* @author JXMaster
+* @date 2024/4/28
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_NETWORK_API LUNA_EXPORT
+#include "../Telemetry.hpp"
+#include <Luna/Runtime/Profiler.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/LZ4.hpp>
+
+namespace Luna
+{
+    namespace Network
+    {
+        static RV write_all(IStream* stream, const void* data, usize size)
+        {
+            const byte_t* cur = (const byte_t*)data;
+            lutry
+            {
+                while (size)
+                {
+                    usize write_bytes = 0;
+                    luexp(stream->write(cur, size, &write_bytes));
+                    if (!write_bytes) return BasicError::end_of_file();
+                    cur += write_bytes;
+                    size -= write_bytes;
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+
+        struct TelemetryStreamer : ITelemetryStreamer
+        {
+            lustruct("Network::TelemetryStreamer", "{7D2A9F43-C8E1-4B56-A03F-5E91B6D4C278}");
+            luiimpl();
+
+            TelemetryDesc m_desc;
+            // The stream to write frames to. This is `nullptr` if no viewer is connected.
+            Ref<IStream> m_stream;
+            // The listening socket if the streamer is started as one server.
+            Ref<ISocket> m_listener;
+            Ref<IThread> m_thread;
+            usize m_callback_handle = USIZE_MAX;
+
+            // Protects all members below.
+            SpinLock m_lock;
+            // Buffers are allocated once, so that the profiler callback never allocates memory.
+            Vector<byte_t> m_pending;
+            usize m_pending_size = 0;
+            u64 m_pending_dropped_events = 0;
+            TelemetryStats m_stats;
+            // Events are captured only when this is `true`.
+            bool m_capturing = false;
+            bool m_exiting = false;
+
+            // Accessed only by the streaming thread.
+            Vector<byte_t> m_sending;
+            Vector<byte_t> m_compressed;
+
+            ~TelemetryStreamer()
+            {
+                stop();
+            }
+
+            static usize get_event_data_size(const ProfilerEvent& e)
+            {
+                switch (e.id)
+                {
+                case ProfilerEventId::MEMORY_ALLOCATE:
+                    return sizeof(u64) * 3 + sizeof(u32) * 2 + sizeof(u64) * ((const ProfilerEventData::MemoryAllocate*)e.data)->num_frames;
+                case ProfilerEventId::MEMORY_DEALLOCATE:
+                    return sizeof(u64);
+                case ProfilerEventId::SET_MEMORY_NAME:
+                    return sizeof(u64) + strlen(((const ProfilerEventData::SetMemoryName*)e.data)->name);
+                case ProfilerEventId::SET_MEMORY_TYPE:
+                    return sizeof(u64) + strlen(((const ProfilerEventData::SetMemoryType*)e.data)->type);
+                case ProfilerEventId::SET_MEMORY_DOMAIN:
+                    return sizeof(u64) + strlen(((const ProfilerEventData::SetMemoryDomain*)e.data)->domain);
+                case ProfilerEventId::CPU_ZONE_BEGIN:
+                {
+                    const c8* name = ((const ProfilerEventData::CpuZoneBegin*)e.data)->name;
+                    return name ? strlen(name) : 0;
+                }
+                default:
+                    return 0;
+                }
+            }
+
+            static byte_t* write_u64(byte_t* dst, u64 value)
+            {
+                memcpy(dst, &value, sizeof(u64));
+                return dst + sizeof(u64);
+            }
+
+            static byte_t* write_u32(byte_t* dst, u32 value)
+            {
+                memcpy(dst, &value, sizeof(u32));
+                return dst + sizeof(u32);
+            }
+
+            static byte_t* write_str(byte_t* dst, const c8* str, usize len)
+            {
+                memcpy(dst, str, len);
+                return dst + len;
+            }
+
+            static void encode_event_data(byte_t* dst, const ProfilerEvent& e, usize data_size)
+            {
+                switch (e.id)
+                {
+                case ProfilerEventId::MEMORY_ALLOCATE:
+                {
+                    auto data = (const ProfilerEventData::MemoryAllocate*)e.data;
+                    dst = write_u64(dst, (u64)(usize)data->ptr);
+                    dst = write_u64(dst, (u64)data->size);
+                    dst = write_u64(dst, (u64)data->sampled_size);
+                    dst = write_u32(dst, data->num_frames);
+                    dst = write_u32(dst, 0);
+                    for (u32 i = 0; i < data->num_frames; ++i) dst = write_u64(dst, (u64)data->frames[i]);
+                    break;
+                }
+                case ProfilerEventId::MEMORY_DEALLOCATE:
+                    write_u64(dst, (u64)(usize)((const ProfilerEventData::MemoryDeallocate*)e.data)->ptr);
+                    break;
+                case ProfilerEventId::SET_MEMORY_NAME:
+                {
+                    auto data = (const ProfilerEventData::SetMemoryName*)e.data;
+                    write_str(write_u64(dst, (u64)(usize)data->ptr), data->name, data_size - sizeof(u64));
+                    break;
+                }
+                case ProfilerEventId::SET_MEMORY_TYPE:
+                {
+                    auto data = (const ProfilerEventData::SetMemoryType*)e.data;
+                    write_str(write_u64(dst, (u64)(usize)data->ptr), data->type, data_size - sizeof(u64));
+                    break;
+                }
+                case ProfilerEventId::SET_MEMORY_DOMAIN:
+                {
+                    auto data = (const ProfilerEventData::SetMemoryDomain*)e.data;
+                    write_str(write_u64(dst, (u64)(usize)data->ptr), data->domain, data_size - sizeof(u64));
+                    break;
+                }
+                case ProfilerEventId::CPU_ZONE_BEGIN:
+                    write_str(dst, ((const ProfilerEventData::CpuZoneBegin*)e.data)->name, data_size);
+                    break;
+                default:
+                    break;
+                }
+            }
+
+            void on_profiler_events(Span<const ProfilerEvent> events)
+            {
+                LockGuard guard(m_lock);
+                if (!m_capturing) return;
+                for (const ProfilerEvent& e : events)
+                {
+                    usize data_size = get_event_data_size(e);
+                    usize record_size = sizeof(TelemetryEventHeader) + data_size;
+                    if (m_pending.size() - m_pending_size < record_size)
+                    {
+                        ++m_pending_dropped_events;
+                        ++m_stats.num_dropped_events;
+                        continue;
+                    }
+                    TelemetryEventHeader header;
+                    header.id = e.id;
+                    header.timestamp = e.timestamp;
+                    header.thread = (u64)(usize)e.thread;
+                    header.data_size = (u32)data_size;
+                    header.reserved = 0;
+                    byte_t* dst = m_pending.data() + m_pending_size;
+                    memcpy(dst, &header, sizeof(TelemetryEventHeader));
+                    encode_event_data(dst + sizeof(TelemetryEventHeader), e, data_size);
+                    m_pending_size += record_size;
+                    ++m_stats.num_events;
+                }
+            }
+
+            RV init(const TelemetryDesc& desc)
+            {
+                m_desc = desc;
+                // The frame size is stored in 32 bits.
+                m_desc.max_pending_bytes = min<usize>(m_desc.max_pending_bytes, U32_MAX / 2);
+                m_pending.resize(m_desc.max_pending_bytes);
+                m_sending.resize(m_desc.max_pending_bytes);
+                if (m_desc.compress) m_compressed.resize(LZ4::compress_bound(m_desc.max_pending_bytes));
+                m_callback_handle = register_profiler_batch_callback([this](Span<const ProfilerEvent> events) { on_profiler_events(events); });
+                return ok;
+            }
+
+            void start_thread()
+            {
+                m_thread = new_thread([](void* params) { ((TelemetryStreamer*)params)->run(); }, this, "Telemetry Thread");
+            }
+
+            RV write_stream_header()
+            {
+                TelemetryStreamHeader header;
+                header.magic = TELEMETRY_STREAM_MAGIC;
+                header.version = TELEMETRY_STREAM_VERSION;
+                header.ticks_per_second = get_ticks_per_second();
+                RV r = write_all(m_stream, &header, sizeof(TelemetryStreamHeader));
+                if (succeeded(r))
+                {
+                    LockGuard guard(m_lock);
+                    m_stats.sent_bytes += sizeof(TelemetryStreamHeader);
+                }
+                return r;
+            }
+
+            void set_capturing(bool capturing)
+            {
+                LockGuard guard(m_lock);
+                m_capturing = capturing;
+                m_stats.connected = capturing;
+                // Events captured for the last viewer are discarded.
+                m_pending_size = 0;
+                m_pending_dropped_events = 0;
+            }
+
+            // Sends all pending events as one frame.
+            RV flush()
+            {
+                usize raw_size;
+                u64 dropped_events;
+                {
+                    LockGuard guard(m_lock);
+                    m_pending.swap(m_sending);
+                    raw_size = m_pending_size;
+                    dropped_events = m_pending_dropped_events;
+                    m_pending_size = 0;
+                    m_pending_dropped_events = 0;
+                }
+                if (!raw_size && !dropped_events) return ok;
+                TelemetryFrameHeader header;
+                header.magic = TELEMETRY_FRAME_MAGIC;
+                header.flags = TelemetryFrameFlag::none;
+                header.raw_size = (u32)raw_size;
+                header.stored_size = (u32)raw_size;
+                header.num_dropped_events = dropped_events;
+                const byte_t* data = m_sending.data();
+                if (m_desc.compress && raw_size)
+                {
+                    usize compressed_size = LZ4::compress(m_sending.data(), raw_size, m_compressed.data(), m_compressed.size());
+                    // Stores the frame uncompressed if compression does not help.
+                    if (compressed_size && compressed_size < raw_size)
+                    {
+                        header.flags = TelemetryFrameFlag::lz4;
+                        header.stored_size = (u32)compressed_size;
+                        data = m_compressed.data();
+                    }
+                }
+                lutry
+                {
+                    luexp(write_all(m_stream, &header, sizeof(TelemetryFrameHeader)));
+                    luexp(write_all(m_stream, data, header.stored_size));
+                }
+                lucatchret;
+                LockGuard guard(m_lock);
+                ++m_stats.num_frames;
+                m_stats.raw_bytes += raw_size;
+                m_stats.sent_bytes += sizeof(TelemetryFrameHeader) + header.stored_size;
+                return ok;
+            }
+
+            void try_accept()
+            {
+                SocketAddress address;
+                auto r = m_listener->accept(address);
+                if (failed(r)) return;
+                Ref<ISocket> socket = r.get();
+                // Frames are sent by blocking writes, the socket buffer provides backpressure.
+                if (failed(socket->set_blocking(true))) return;
+                m_stream = socket;
+                if (failed(write_stream_header()))
+                {
+                    m_stream = nullptr;
+                    return;
+                }
+                set_capturing(true);
+            }
+
+            void run()
+            {
+                while (true)
+                {
+                    bool exiting;
+                    {
+                        LockGuard guard(m_lock);
+                        exiting = m_exiting;
+                    }
+                    if (m_stream)
+                    {
+                        if (failed(flush()))
+                        {
+                            set_capturing(false);
+                            m_stream = nullptr;
+                        }
+                    }
+                    if (exiting) break;
+                    if (!m_stream && m_listener) try_accept();
+                    if (!m_stream && !m_listener) break;
+                    sleep(m_desc.flush_interval_ms);
+                }
+                set_capturing(false);
+                m_stream = nullptr;
+                m_listener = nullptr;
+            }
+
+            virtual TelemetryStats get_stats() override
+            {
+                LockGuard guard(m_lock);
+                return m_stats;
+            }
+
+            virtual void stop() override
+            {
+                if (m_callback_handle != USIZE_MAX)
+                {
+                    unregister_profiler_batch_callback(m_callback_handle);
+                    m_callback_handle = USIZE_MAX;
+                }
+                if (m_thread)
+                {
+                    {
+                        LockGuard guard(m_lock);
+                        m_exiting = true;
+                    }
+                    m_thread->wait();
+                    m_thread = nullptr;
+                }
+            }
+        };
+
+        void register_telemetry_types()
+        {
+            register_boxed_type<TelemetryStreamer>();
+            impl_interface_for_type<TelemetryStreamer, ITelemetryStreamer>();
+        }
+
+        LUNA_NETWORK_API R<Ref<ITelemetryStreamer>> start_telemetry(IStream* stream, const TelemetryDesc& desc)
+        {
+            Ref<TelemetryStreamer> streamer = new_object<TelemetryStreamer>();
+            lutry
+            {
+                streamer->m_stream = stream;
+                luexp(streamer->write_stream_header());
+                luexp(streamer->init(desc));
+                streamer->set_capturing(true);
+                streamer->start_thread();
+            }
+            lucatchret;
+            return Ref<ITelemetryStreamer>(streamer);
+        }
+
+        LUNA_NETWORK_API R<Ref<ITelemetryStreamer>> start_telemetry_server(u16 port, const TelemetryDesc& desc)
+        {
+            Ref<TelemetryStreamer> streamer = new_object<TelemetryStreamer>();
+            lutry
+            {
+                lulet(listener, new_socket(AddressFamily::ipv4, SocketType::stream, Protocol::tcp));
+                SocketAddress address;
+                address.family = AddressFamily::ipv4;
+                address.ipv4.address = IPV4_ADDRESS_ANY;
+                address.ipv4.port = port;
+                luexp(listener->bind(address));
+                luexp(listener->listen(1));
+                // The streaming thread polls for viewers between frames.
+                luexp(listener->set_blocking(false));
+                streamer->m_listener = listener;
+                luexp(streamer->init(desc));
+                streamer->start_thread();
+            }
+            lucatchret;
+            return Ref<ITelemetryStreamer>(streamer);
+        }
+    }
+}
@@ -0,0 +1,152 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Telemetry.hpp
+* @author JXMaster
+* @date 2024/4/28
+*/
+#pragma once
+#include "Network.hpp"
+
+namespace Luna
+{
+    namespace Network
+    {
+        //! @addtogroup Network
+        //! @{
+
+        //! The magic number of the telemetry stream header ("LTLM" in little endian).
+        constexpr u32 TELEMETRY_STREAM_MAGIC = 0x4D4C544C;
+        //! The magic number of one telemetry frame header ("LTFR" in little endian).
+        constexpr u32 TELEMETRY_FRAME_MAGIC = 0x5246544C;
+        //! The version of the telemetry stream format.
+        constexpr u32 TELEMETRY_STREAM_VERSION = 1;
+
+        //! The header written at the beginning of every telemetry stream or connection.
+        struct TelemetryStreamHeader
+        {
+            //! Always @ref TELEMETRY_STREAM_MAGIC.
+            u32 magic;
+            //! Always @ref TELEMETRY_STREAM_VERSION.
+            u32 version;
+            //! The number of ticks per second, used to convert @ref ProfilerEvent::timestamp to seconds.
+            f64 ticks_per_second;
+        };
+
+        enum class TelemetryFrameFlag : u32
+        {
+            none = 0x00,
+            //! The frame data is compressed in LZ4 block format.
+            lz4 = 0x01,
+        };
+
+        //! The header of one telemetry frame.
+        //! @details Every frame header is followed by `stored_size` bytes of frame data. The decompressed frame data
+        //! contains `raw_size` bytes of event records. Every event record starts with one @ref TelemetryEventHeader,
+        //! followed by `data_size` bytes of event data:
+        //! * @ref ProfilerEventId::MEMORY_ALLOCATE: `u64 ptr`, `u64 size`, `u64 sampled_size`, `u32 num_frames`, `u32 reserved`,
+        //! then `u64 frames[num_frames]`.
+        //! * @ref ProfilerEventId::MEMORY_DEALLOCATE: `u64 ptr`.
+        //! * @ref ProfilerEventId::SET_MEMORY_NAME, @ref ProfilerEventId::SET_MEMORY_TYPE and @ref ProfilerEventId::SET_MEMORY_DOMAIN:
+        //! `u64 ptr`, then the string without null terminator.
+        //! * @ref ProfilerEventId::CPU_ZONE_BEGIN: the zone name without null terminator.
+        //! * All other events: no data, since the layout of user-defined event data is unknown.
+        //!
+        //! All values are stored in the byte order of the host that produces the stream.
+        struct TelemetryFrameHeader
+        {
+            //! Always @ref TELEMETRY_FRAME_MAGIC.
+            u32 magic;
+            //! The frame flags.
+            TelemetryFrameFlag flags;
+            //! The size of event records in bytes.
+            u32 raw_size;
+            //! The size of frame data that follows this header in bytes.
+            u32 stored_size;
+            //! The number of events dropped before events of this frame are captured.
+            u64 num_dropped_events;
+        };
+
+        //! The header of one event record in one telemetry frame.
+        struct TelemetryEventHeader
+        {
+            //! The event ID.
+            u64 id;
+            //! The event timestamp.
+            u64 timestamp;
+            //! The value that identifies the thread that submits this event.
+            u64 thread;
+            //! The size of event data that follows this header in bytes.
+            u32 data_size;
+            u32 reserved;
+        };
+
+        //! Describes one telemetry streamer.
+        struct TelemetryDesc
+        {
+            //! The maximum number of bytes of event records that can be buffered before they are sent.
+            //! @details Events are dropped and counted in @ref TelemetryFrameHeader::num_dropped_events if the buffer is full,
+            //! so that one slow receiver never blocks threads that submit events and the memory usage is bounded.
+            //! Two buffers of this size are allocated when the streamer is started.
+            usize max_pending_bytes = 16 * 1024 * 1024;
+            //! The interval between two frames in milliseconds.
+            u32 flush_interval_ms = 100;
+            //! Whether to compress frame data using LZ4.
+            bool compress = true;
+        };
+
+        //! Statistics of one telemetry streamer.
+        struct TelemetryStats
+        {
+            //! The number of events captured.
+            u64 num_events = 0;
+            //! The number of events dropped because the buffer is full.
+            u64 num_dropped_events = 0;
+            //! The number of frames sent.
+            u64 num_frames = 0;
+            //! The number of bytes of event records sent before compression.
+            u64 raw_bytes = 0;
+            //! The number of bytes sent, including headers.
+            u64 sent_bytes = 0;
+            //! Whether the streamer is connected to one receiver.
+            bool connected = false;
+        };
+
+        //! @interface ITelemetryStreamer
+        //! Streams profiler events to one stream or one remote viewer.
+        //! @details The streamer registers one profiler batch callback that encodes events to one fixed-size buffer,
+        //! and one background thread sends the buffer as one frame every @ref TelemetryDesc::flush_interval_ms milliseconds.
+        //! The callback never allocates memory or performs IO, so threads that submit events are not blocked by the receiver.
+        struct ITelemetryStreamer : virtual Interface
+        {
+            luiid("{B5E3A7C1-62D8-4F0A-9E14-3C7B8D2F5A96}");
+
+            //! Gets statistics of the streamer.
+            virtual TelemetryStats get_stats() = 0;
+
+            //! Stops streaming.
+            //! @details This function unregisters the profiler callback, sends all buffered events and stops the background thread.
+            //! This is called when the streamer is destroyed if it is not called by the user.
+            virtual void stop() = 0;
+        };
+
+        //! Starts streaming profiler events to one stream.
+        //! @details The stream header is written to the stream first, followed by frames. Streaming stops if writing to the stream fails.
+        //! @param[in] stream The stream to write to, for example, one file or one connected socket.
+        //! @param[in] desc The streamer descriptor.
+        //! @return Returns the started streamer.
+        LUNA_NETWORK_API R<Ref<ITelemetryStreamer>> start_telemetry(IStream* stream, const TelemetryDesc& desc = TelemetryDesc());
+
+        //! Starts one TCP server that streams profiler events to one remote viewer.
+        //! @details The server accepts at most one viewer at a time. Events are captured only when one viewer is connected, and
+        //! the stream header is sent to every newly connected viewer. If the connection is broken, the server waits for the next viewer.
+        //! @param[in] port The TCP port to listen on.
+        //! @param[in] desc The streamer descriptor.
+        //! @return Returns the started streamer.
+        LUNA_NETWORK_API R<Ref<ITelemetryStreamer>> start_telemetry_server(u16 port, const TelemetryDesc& desc = TelemetryDesc());
+
+        //! @}
+    }
+}
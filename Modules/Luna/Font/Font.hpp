@@ -153,7 +153,10 @@ namespace Luna
 
         //! Gets the default font object, which is embedded into the SDK and only supports for ASCII codepoint range.
         //! @details Currently LunaSDK uses Open Sans Regular as the embedded default font.
-        //! @return Returns the default font object.
+        //! @return Returns the default font object. Returns `nullptr` if the default font is excluded from the build by 
+        //! the `font_disable_default_font` build option, or if the default font cannot be loaded.
+        //! @remark The embedded font data is stored compressed, and is decompressed and parsed when this function is called 
+        //! for the first time. The loaded font object is cached and shared by all succeeding calls.
         LUNA_FONT_API IFontFile* get_default_font();
 
         //! @}
@@ -14,7 +14,13 @@ namespace Luna
 {
     namespace Font
     {
+#ifndef LUNA_FONT_DISABLE_DEFAULT_FONT
+        // The size of the decompressed font file data.
         extern const long int opensans_regular_ttf_size;
-        extern const unsigned char opensans_regular_ttf[];
+        // The size of the compressed font file data.
+        extern const long int opensans_regular_ttf_lz4_size;
+        // The font file data compressed in LZ4 block format.
+        extern const unsigned char opensans_regular_ttf_lz4[];
+#endif
     }
 }
\ No newline at end of file
@@ -10,31 +10,57 @@
 #include "FontFileTTF.hpp"
 #include "DefaultFont.hpp"
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/LZ4.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+#include <Luna/Runtime/Log.hpp>
 namespace Luna
 {
     namespace Font
     {
+        // The default font is decompressed and parsed when it is used for the first time.
+        // `g_default_font_ptr` is published after `g_default_font` is set, so that it can be read without locking.
         Ref<IFontFile> g_default_font;
+        IFontFile* volatile g_default_font_ptr;
+        Ref<IMutex> g_default_font_mtx;
+
         struct FontModule : public Module
         {
             virtual const c8* get_name() override { return "Font"; }
+            virtual ModuleInitFlag get_init_flags() override { return ModuleInitFlag::concurrent; }
             virtual RV on_init() override
             {
                 register_boxed_type<FontFileTTF>();
                 impl_interface_for_type<FontFileTTF, IFontFile>();
-                auto r = load_ttf_font_file((const byte_t*)opensans_regular_ttf, (usize)opensans_regular_ttf_size);
-                if (failed(r))
-                {
-                    return r.errcode();
-                }
-                g_default_font = r.get();
+                g_default_font_mtx = new_mutex();
                 return ok;
             }
             virtual void on_close() override
             {
-                g_default_font = nullptr;
+                g_default_font_ptr = nullptr;
+                g_default_font.reset();
+                g_default_font_mtx.reset();
             }
         };
+#ifndef LUNA_FONT_DISABLE_DEFAULT_FONT
+        static R<Ref<IFontFile>> load_default_font()
+        {
+            Ref<IFontFile> ret;
+            lutry
+            {
+                Blob data((usize)opensans_regular_ttf_size);
+                if (!LZ4::decompress(opensans_regular_ttf_lz4, (usize)opensans_regular_ttf_lz4_size, (byte_t*)data.data(), data.size()))
+                {
+                    return set_error(BasicError::bad_data(), "Failed to decompress the default font data.");
+                }
+                Ref<FontFileTTF> f = new_object<FontFileTTF>();
+                luexp(f->init(move(data)));
+                ret = f;
+            }
+            lucatchret;
+            return ret;
+        }
+#endif
         LUNA_FONT_API R<Ref<IFontFile>> load_ttf_font_file(const byte_t* data, usize data_size)
         {
             Ref<IFontFile> ret;
@@ -49,7 +75,25 @@ namespace Luna
         }
         LUNA_FONT_API IFontFile* get_default_font()
         {
+#ifdef LUNA_FONT_DISABLE_DEFAULT_FONT
+            return nullptr;
+#else
+            IFontFile* font = g_default_font_ptr;
+            if (font) return font;
+            MutexGuard guard(g_default_font_mtx);
+            if (!g_default_font)
+            {
+                auto r = load_default_font();
+                if (failed(r))
+                {
+                    log_error("Font", "%s", explain(r.errcode()));
+                    return nullptr;
+                }
+                g_default_font = r.get();
+                atom_exchange_pointer(&g_default_font_ptr, g_default_font.get());
+            }
             return g_default_font;
+#endif
         }
     }
     LUNA_FONT_API Module* module_font()
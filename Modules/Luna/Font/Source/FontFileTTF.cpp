@@ -18,12 +18,16 @@ namespace Luna
     {
         RV FontFileTTF::init(const byte_t* data, usize data_size)
         {
-            i32 i = stbtt_GetNumberOfFonts((const unsigned char*)data);
+            return init(Blob(data, data_size));
+        }
+        RV FontFileTTF::init(Blob&& data)
+        {
+            i32 i = stbtt_GetNumberOfFonts((const unsigned char*)data.data());
             if (i <= 0)
             {
                 return set_error(BasicError::bad_arguments(), "Create TTF font file failed because there is no font in the specified font file data.");
             }
-            m_data = Blob(data, data_size);
+            m_data = move(data);
             m_infos.reserve((u32)i);
             for (u32 j = 0; j < (u32)i; ++j)
             {
@@ -32,9 +36,45 @@ namespace Luna
                     stbtt_GetFontOffsetForIndex((const unsigned char*)m_data.data(), j));
                 info.userdata = nullptr;
                 m_infos.push_back(info);
+                m_caches.push_back(UniquePtr<FontCache>(memnew<FontCache>()));
+                build_bmp_glyphs(j);
             }
             return ok;
         }
+        static u16 read_u16_be(const u8* p)
+        {
+            return ((u16)p[0] << 8) | (u16)p[1];
+        }
+        void FontFileTTF::build_bmp_glyphs(u32 font_index)
+        {
+            const stbtt_fontinfo& info = m_infos[font_index];
+            auto& glyphs = m_caches[font_index]->m_bmp_glyphs;
+            glyphs.resize(65536, 0);
+            const u8* index_map = (const u8*)info.data + info.index_map;
+            if (info.index_map && read_u16_be(index_map) == 4)
+            {
+                // Segment mapping to delta values, only codepoints in segments need to be looked up.
+                u32 num_segments = read_u16_be(index_map + 6) / 2;
+                const u8* end_codes = index_map + 14;
+                const u8* start_codes = end_codes + num_segments * 2 + 2;
+                for (u32 i = 0; i < num_segments; ++i)
+                {
+                    u32 start = read_u16_be(start_codes + i * 2);
+                    u32 end = read_u16_be(end_codes + i * 2);
+                    for (u32 c = start; c <= end && c < 65536; ++c)
+                    {
+                        glyphs[c] = (u16)stbtt_FindGlyphIndex(&info, (int)c);
+                    }
+                }
+            }
+            else
+            {
+                for (u32 c = 0; c < 65536; ++c)
+                {
+                    glyphs[c] = (u16)stbtt_FindGlyphIndex(&info, (int)c);
+                }
+            }
+        }
         u32 FontFileTTF::get_num_fonts()
         {
             return u32(m_infos.size());
@@ -42,8 +82,22 @@ namespace Luna
         glyph_t FontFileTTF::find_glyph(u32 font_index, u32 codepoint)
         {
             lucheck_msg(font_index < m_infos.size(), "Invalid font index.");
+            auto& cache = *m_caches[font_index];
+            if (codepoint < 65536)
+            {
+                u16 glyph = cache.m_bmp_glyphs[codepoint];
+                return glyph ? (glyph_t)glyph : INVALID_GLYPH;
+            }
+            {
+                LockGuard guard(cache.m_lock);
+                auto iter = cache.m_ext_glyphs.find(codepoint);
+                if (iter != cache.m_ext_glyphs.end()) return iter->second;
+            }
             int glyph = stbtt_FindGlyphIndex(&m_infos[font_index], codepoint);
-            return glyph ? glyph : INVALID_GLYPH;
+            glyph_t r = glyph ? glyph : INVALID_GLYPH;
+            LockGuard guard(cache.m_lock);
+            cache.m_ext_glyphs.insert(make_pair(codepoint, r));
+            return r;
         }
         f32 FontFileTTF::scale_for_pixel_height(u32 font_index, f32 pixels)
         {
@@ -76,6 +130,18 @@ namespace Luna
             {
                 return;
             }
+            auto& cache = *m_caches[font_index];
+            {
+                LockGuard guard(cache.m_lock);
+                auto iter = cache.m_outlines.find(glyph);
+                if (iter != cache.m_outlines.end())
+                {
+                    out_commands.insert(out_commands.end(), Span<const i16>(iter->second.data(), iter->second.size()));
+                    return;
+                }
+            }
+            // Decodes the outline without holding the lock.
+            Vector<i16> commands;
             stbtt_vertex* vertices;
             int num_vertices = stbtt_GetGlyphShape(&m_infos[font_index], glyph, &vertices);
             for (int i = 0; i < num_vertices; ++i)
@@ -84,16 +150,19 @@ namespace Luna
                 switch (v.type)
                 {
                 case STBTT_vmove:
-                    out_commands.insert(out_commands.end(), { COMMAND_MOVE_TO, v.x, v.y }); break;
+                    commands.insert(commands.end(), { COMMAND_MOVE_TO, v.x, v.y }); break;
                 case STBTT_vline:
-                    out_commands.insert(out_commands.end(), { COMMAND_LINE_TO, v.x, v.y }); break;
+                    commands.insert(commands.end(), { COMMAND_LINE_TO, v.x, v.y }); break;
                 case STBTT_vcurve:
-                    out_commands.insert(out_commands.end(), { COMMAND_CURVE_TO, v.cx, v.cy, v.x, v.y }); break;
+                    commands.insert(commands.end(), { COMMAND_CURVE_TO, v.cx, v.cy, v.x, v.y }); break;
                 case STBTT_vcubic:
                     lupanic(); break;
                 }
             }
             if(vertices) stbtt_FreeShape(&m_infos[font_index], vertices);
+            out_commands.insert(out_commands.end(), Span<const i16>(commands.data(), commands.size()));
+            LockGuard guard(cache.m_lock);
+            cache.m_outlines.insert(make_pair(glyph, move(commands)));
         }
         RectI FontFileTTF::get_glyph_bounding_box(u32 font_index, glyph_t glyph)
         {
@@ -11,6 +11,9 @@
 #include "FontHeader.hpp"
 #include "StbTrueType.hpp"
 #include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/UniquePtr.hpp>
 
 namespace Luna
 {
@@ -24,9 +27,26 @@ namespace Luna
             Blob m_data;
             Vector<stbtt_fontinfo> m_infos;
 
+            // Cached lookup data of one font, so that repeated queries do not parse the font binary again.
+            struct FontCache
+            {
+                // The glyph index of every codepoint in the Basic Multilingual Plane, built when the font is loaded.
+                // 0 means that the codepoint is not mapped.
+                Vector<u16> m_bmp_glyphs;
+                // Glyph indices of codepoints outside the Basic Multilingual Plane, filled lazily.
+                HashMap<u32, glyph_t> m_ext_glyphs;
+                // Decoded outline commands of glyphs, filled lazily.
+                HashMap<glyph_t, Vector<i16>> m_outlines;
+                // Guards `m_ext_glyphs` and `m_outlines`.
+                SpinLock m_lock;
+            };
+            Vector<UniquePtr<FontCache>> m_caches;
+
             FontFileTTF() {}
 
             RV init(const byte_t* data, usize data_size);
+            RV init(Blob&& data);
+            void build_bmp_glyphs(u32 font_index);
             virtual Span<const byte_t> get_data() override
             {
                 return m_data.cspan();
@@ -1,6 +1,14 @@
 add_requires("stb")
 
+option("font_disable_default_font")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Whether to exclude the embedded default font from the Font module.")
+    add_defines("LUNA_FONT_DISABLE_DEFAULT_FONT")
+option_end()
+
 luna_sdk_module_target("Font")
+    add_options("font_disable_default_font")
     add_headerfiles("*.hpp", {prefixdir = "Luna/Font"})
     add_headerfiles("Source/**.hpp", {install = false})
     add_files("Source/**.cpp")
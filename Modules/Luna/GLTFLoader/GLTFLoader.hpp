@@ -0,0 +1,355 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file GLTFLoader.hpp
+* @author JXMaster
+* @date 2024/5/3
+*/
+#pragma once
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/Name.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Math/Vector.hpp>
+#include <Luna/Runtime/Result.hpp>
+
+#ifndef LUNA_GLTF_LOADER_API
+#define LUNA_GLTF_LOADER_API
+#endif
+
+namespace Luna
+{
+    namespace GLTFLoader
+    {
+        //! @addtogroup GLTFLoader GLTFLoader
+        //! GLTFLoader module provides functions to parse glTF 2.0 binary (.glb) file data.
+        //! @{
+
+        //! Specifies the data type of components of one accessor.
+        enum class ComponentType : u32
+        {
+            i8 = 5120,
+            u8 = 5121,
+            i16 = 5122,
+            u16 = 5123,
+            u32 = 5125,
+            f32 = 5126,
+        };
+
+        //! Specifies the number of components of every element of one accessor.
+        enum class AccessorType : u8
+        {
+            scalar = 0,
+            vec2,
+            vec3,
+            vec4,
+            mat2,
+            mat3,
+            mat4,
+        };
+
+        //! Specifies the topology of one primitive.
+        enum class PrimitiveMode : u8
+        {
+            points = 0,
+            lines = 1,
+            line_loop = 2,
+            line_strip = 3,
+            triangles = 4,
+            triangle_strip = 5,
+            triangle_fan = 6,
+        };
+
+        //! Gets the size of one component in bytes.
+        inline u32 get_component_size(ComponentType type)
+        {
+            switch (type)
+            {
+            case ComponentType::i8:
+            case ComponentType::u8: return 1;
+            case ComponentType::i16:
+            case ComponentType::u16: return 2;
+            case ComponentType::u32:
+            case ComponentType::f32: return 4;
+            default: lupanic(); return 0;
+            }
+        }
+
+        //! Gets the number of components of one element.
+        inline u32 get_num_components(AccessorType type)
+        {
+            switch (type)
+            {
+            case AccessorType::scalar: return 1;
+            case AccessorType::vec2: return 2;
+            case AccessorType::vec3: return 3;
+            case AccessorType::vec4: return 4;
+            case AccessorType::mat2: return 4;
+            case AccessorType::mat3: return 9;
+            case AccessorType::mat4: return 16;
+            default: lupanic(); return 0;
+            }
+        }
+
+        //! Describes one buffer view.
+        struct BufferView
+        {
+            //! The data of the buffer view.
+            //! @details For buffer views of the binary chunk, this points to the binary chunk of the file data directly. For
+            //! buffer views compressed by `EXT_meshopt_compression`, this points to the decoded data stored in @ref GLTFFile::decoded_data.
+            //! This is empty if the buffer view refers to one external buffer, which is not supported.
+            Span<const byte_t> data;
+            //! The stride between elements in bytes. `0` means that elements are tightly packed.
+            u32 byte_stride = 0;
+        };
+
+        //! Describes one accessor.
+        struct Accessor
+        {
+            //! The index of the buffer view. `-1` means that all elements are zeros.
+            i32 buffer_view = -1;
+            //! The offset of the first element relative to the start of the buffer view in bytes.
+            usize byte_offset = 0;
+            //! The component type.
+            ComponentType component_type = ComponentType::f32;
+            //! Whether integer components are normalized to [0, 1] (for unsigned types) or [-1, 1] (for signed types).
+            bool normalized = false;
+            //! Whether this accessor is one sparse accessor. Sparse accessors are not supported, and cannot be read.
+            bool sparse = false;
+            //! The number of components of every element.
+            AccessorType type = AccessorType::scalar;
+            //! The number of elements.
+            usize count = 0;
+        };
+
+        //! Describes one vertex attribute of one primitive.
+        struct Attribute
+        {
+            //! The attribute semantic, like `POSITION` or `TEXCOORD_0`.
+            Name name;
+            //! The index of the accessor that contains the attribute data.
+            u32 accessor;
+        };
+
+        //! Describes one primitive of one mesh.
+        struct Primitive
+        {
+            //! The vertex attributes.
+            Vector<Attribute> attributes;
+            //! The index of the accessor that contains indices. `-1` means that the primitive is not indexed.
+            i32 indices = -1;
+            //! The index of the material. `-1` means that the default material is used.
+            i32 material = -1;
+            //! The topology of the primitive.
+            PrimitiveMode mode = PrimitiveMode::triangles;
+            //! Whether the primitive is compressed by `KHR_draco_mesh_compression`.
+            //! @details Draco-compressed data is not decoded, accessors of such primitive refer to the uncompressed fallback data.
+            bool draco_compressed = false;
+
+            //! Finds one vertex attribute.
+            //! @param[in] name The attribute semantic.
+            //! @return Returns the index of the accessor of the attribute, or `-1` if the attribute is not found.
+            i32 find_attribute(const Name& name) const
+            {
+                for (auto& i : attributes)
+                {
+                    if (i.name == name) return (i32)i.accessor;
+                }
+                return -1;
+            }
+        };
+
+        //! Describes one mesh.
+        struct Mesh
+        {
+            //! The name of the mesh.
+            Name name;
+            //! The primitives of the mesh.
+            Vector<Primitive> primitives;
+        };
+
+        //! Describes one metallic-roughness material.
+        struct Material
+        {
+            //! The name of the material.
+            Name name;
+            //! The base color factor.
+            Float4U base_color_factor = Float4U(1.0f, 1.0f, 1.0f, 1.0f);
+            //! The metallic factor.
+            f32 metallic_factor = 1.0f;
+            //! The roughness factor.
+            f32 roughness_factor = 1.0f;
+            //! The emissive factor.
+            Float3U emissive_factor = Float3U(0.0f, 0.0f, 0.0f);
+            //! The index of the base color texture. `-1` means not used.
+            i32 base_color_texture = -1;
+            //! The index of the metallic-roughness texture. `-1` means not used.
+            i32 metallic_roughness_texture = -1;
+            //! The index of the normal texture. `-1` means not used.
+            i32 normal_texture = -1;
+            //! The index of the occlusion texture. `-1` means not used.
+            i32 occlusion_texture = -1;
+            //! The index of the emissive texture. `-1` means not used.
+            i32 emissive_texture = -1;
+            //! Whether back faces should be rendered.
+            bool double_sided = false;
+        };
+
+        //! Describes one texture.
+        struct Texture
+        {
+            //! The index of the image used by the texture. `-1` means not specified.
+            i32 source = -1;
+        };
+
+        //! Describes one image.
+        struct Image
+        {
+            //! The name of the image.
+            Name name;
+            //! The URI of the image if the image is stored in one external file.
+            Name uri;
+            //! The MIME type of the image if the image is stored in one buffer view.
+            Name mime_type;
+            //! The index of the buffer view that contains the image data. `-1` means that @ref uri is used.
+            i32 buffer_view = -1;
+        };
+
+        //! Describes one glTF file data.
+        struct GLTFFile
+        {
+            //! The mapped file if the file is loaded by @ref load_file. Buffer views point to the mapped data directly,
+            //! so the file is kept mapped as long as this object is alive.
+            Ref<IMappedFile> mapped_file;
+            //! The storage of decoded data of compressed buffer views.
+            Blob decoded_data;
+            //! The buffer views.
+            Vector<BufferView> buffer_views;
+            //! The accessors.
+            Vector<Accessor> accessors;
+            //! The meshes.
+            Vector<Mesh> meshes;
+            //! The materials.
+            Vector<Material> materials;
+            //! The textures.
+            Vector<Texture> textures;
+            //! The images.
+            Vector<Image> images;
+        };
+
+        //! Describes the data of one accessor in the buffer view.
+        struct AccessorData
+        {
+            //! The pointer to the first element.
+            const byte_t* data = nullptr;
+            //! The number of elements.
+            usize count = 0;
+            //! The stride between elements in bytes.
+            usize stride = 0;
+            //! The size of one element in bytes.
+            usize element_size = 0;
+        };
+
+        //! Provides typed access to elements of one accessor without copying the data.
+        template <typename _Ty>
+        struct AccessorView
+        {
+            const byte_t* m_data = nullptr;
+            usize m_count = 0;
+            usize m_stride = 0;
+
+            //! Gets the number of elements.
+            usize size() const { return m_count; }
+            //! Checks whether elements are tightly packed, so that they can be accessed by @ref span.
+            bool is_packed() const { return m_stride == sizeof(_Ty); }
+            //! Gets elements as one span.
+            //! @par Valid Usage
+            //! * @ref is_packed must be `true`.
+            Span<const _Ty> span() const
+            {
+                lucheck(is_packed());
+                return Span<const _Ty>((const _Ty*)m_data, m_count);
+            }
+            //! Gets one element.
+            const _Ty& operator[](usize i) const
+            {
+                lucheck(i < m_count);
+                return *(const _Ty*)(m_data + m_stride * i);
+            }
+        };
+
+        //! Loads glTF data from one glTF binary (.glb) file data.
+        //! @details The returned buffer views point to the binary chunk of `glb_data` directly, so `glb_data` must be valid
+        //! as long as the returned object is used. Buffer views compressed by `EXT_meshopt_compression` are decoded in parallel
+        //! using jobs of the job system. Buffers stored in external files or data URIs are not supported, accessors that refer
+        //! to such buffers cannot be read.
+        //! @param[in] glb_data The file data.
+        //! @return Returns the loaded glTF data.
+        //! @par Possible Errors
+        //! * @ref BasicError::format_error if the data is not valid glTF binary data.
+        //! * @ref BasicError::bad_data if compressed data cannot be decoded.
+        //! * @ref BasicError::not_supported if the file requires one extension that is not supported, like `KHR_draco_mesh_compression`.
+        LUNA_GLTF_LOADER_API R<GLTFFile> load(Span<const byte_t> glb_data);
+
+        //! Maps one glTF binary (.glb) file and loads glTF data from the mapped data.
+        //! @details See @ref load for details. The mapped file is stored in @ref GLTFFile::mapped_file.
+        //! @param[in] path The path of the file.
+        //! @return Returns the loaded glTF data.
+        LUNA_GLTF_LOADER_API R<GLTFFile> load_file(const c8* path);
+
+        //! Gets the data of one accessor.
+        //! @param[in] file The glTF data.
+        //! @param[in] accessor The index of the accessor.
+        //! @return Returns the accessor data. `data` is `nullptr` if the accessor does not have one buffer view.
+        //! @par Possible Errors
+        //! * @ref BasicError::not_supported if the accessor is one sparse accessor or refers to one external buffer.
+        LUNA_GLTF_LOADER_API R<AccessorData> get_accessor_data(const GLTFFile& file, u32 accessor);
+
+        //! Gets one typed view of one accessor.
+        //! @param[in] file The glTF data.
+        //! @param[in] accessor The index of the accessor.
+        //! @return Returns the accessor view.
+        //! @par Possible Errors
+        //! * @ref BasicError::bad_arguments if the element size of the accessor does not match the size of `_Ty`, or if the accessor
+        //! does not have one buffer view.
+        template <typename _Ty>
+        inline R<AccessorView<_Ty>> get_accessor_view(const GLTFFile& file, u32 accessor)
+        {
+            AccessorView<_Ty> ret;
+            lutry
+            {
+                lulet(data, get_accessor_data(file, accessor));
+                if (!data.data || data.element_size != sizeof(_Ty)) return BasicError::bad_arguments();
+                ret.m_data = data.data;
+                ret.m_count = data.count;
+                ret.m_stride = data.stride;
+            }
+            lucatchret;
+            return ret;
+        }
+
+        //! Reads elements of one accessor as floating-point numbers.
+        //! @details Integer components are converted to floating-point numbers, and are normalized if @ref Accessor::normalized
+        //! is `true`. If the accessor has less components than `num_components`, remaining components are set to `0`.
+        //! @param[in] file The glTF data.
+        //! @param[in] accessor The index of the accessor.
+        //! @param[out] dst The buffer to write to, which must have space for `count * num_components` numbers.
+        //! @param[in] num_components The number of components to write for every element.
+        LUNA_GLTF_LOADER_API RV read_accessor_f32(const GLTFFile& file, u32 accessor, f32* dst, u32 num_components);
+
+        //! Reads elements of one scalar accessor as 32-bit unsigned integers, which is usually used to read indices.
+        //! @param[in] file The glTF data.
+        //! @param[in] accessor The index of the accessor.
+        //! @param[out] dst The buffer to write to, which must have space for `count` numbers.
+        //! @par Possible Errors
+        //! * @ref BasicError::bad_arguments if the accessor is not one scalar accessor of unsigned integers.
+        LUNA_GLTF_LOADER_API RV read_accessor_u32(const GLTFFile& file, u32 accessor, u32* dst);
+
+        //! @}
+    }
+
+    struct Module;
+    LUNA_GLTF_LOADER_API Module* module_gltf_loader();
+}
@@ -0,0 +1,556 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file GLTFLoader.cpp
+* @author JXMaster
+* @date 2024/5/3
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+
+#define LUNA_GLTF_LOADER_API LUNA_EXPORT
+#include "../GLTFLoader.hpp"
+#include "MeshoptDecoder.hpp"
+#include <Luna/Runtime/Module.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
+#include <Luna/VariantUtils/JSON.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+
+namespace Luna
+{
+    namespace GLTFLoader
+    {
+        struct GLTFLoaderModule : public Module
+        {
+            virtual const c8* get_name() override { return "GLTFLoader"; }
+            virtual RV on_register() override
+            {
+                return add_dependency_modules(this, {module_variant_utils(), module_job_system()});
+            }
+        };
+
+        constexpr u32 GLB_MAGIC = 0x46546C67; // "glTF"
+        constexpr u32 GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+        constexpr u32 GLB_CHUNK_BIN = 0x004E4942; // "BIN\0"
+
+        template <typename _Ty>
+        inline _Ty load_unaligned(const byte_t* src)
+        {
+            _Ty r;
+            memcpy(&r, src, sizeof(_Ty));
+            return r;
+        }
+
+        enum class MeshoptMode : u8
+        {
+            attributes,
+            triangles,
+            indices,
+        };
+
+        enum class MeshoptFilter : u8
+        {
+            none,
+            octahedral,
+            quaternion,
+            exponential,
+        };
+
+        // One buffer view compressed by EXT_meshopt_compression.
+        struct CompressedBufferView
+        {
+            u32 buffer_view;
+            Span<const byte_t> src;
+            usize count;
+            usize stride;
+            usize decoded_offset;
+            MeshoptMode mode;
+            MeshoptFilter filter;
+        };
+
+        static bool decode_buffer_view(const CompressedBufferView& view, byte_t* dst)
+        {
+            bool r = false;
+            switch (view.mode)
+            {
+            case MeshoptMode::attributes:
+                r = decode_meshopt_vertices(dst, view.count, view.stride, view.src.data(), view.src.size());
+                break;
+            case MeshoptMode::triangles:
+                r = decode_meshopt_triangles(dst, view.count, view.stride, view.src.data(), view.src.size());
+                break;
+            case MeshoptMode::indices:
+                r = decode_meshopt_indices(dst, view.count, view.stride, view.src.data(), view.src.size());
+                break;
+            }
+            if (!r) return false;
+            switch (view.filter)
+            {
+            case MeshoptFilter::octahedral: apply_meshopt_octahedral_filter(dst, view.count, view.stride); break;
+            case MeshoptFilter::quaternion: apply_meshopt_quaternion_filter(dst, view.count); break;
+            case MeshoptFilter::exponential: apply_meshopt_exponential_filter(dst, view.count, view.stride); break;
+            default: break;
+            }
+            return true;
+        }
+
+        static R<CompressedBufferView> parse_compressed_buffer_view(const Variant& ext, const Vector<Span<const byte_t>>& buffers, u32 index)
+        {
+            CompressedBufferView r;
+            r.buffer_view = index;
+            u64 buffer = ext["buffer"].unum(U64_MAX);
+            u64 offset = ext["byteOffset"].unum(0);
+            u64 length = ext["byteLength"].unum(0);
+            if (buffer >= buffers.size() || offset + length > buffers[buffer].size())
+            {
+                return set_error(BasicError::format_error(), "The compressed data of buffer view %u is not in the binary chunk.", index);
+            }
+            r.src = Span<const byte_t>(buffers[buffer].data() + offset, (usize)length);
+            r.count = (usize)ext["count"].unum(0);
+            r.stride = (usize)ext["byteStride"].unum(0);
+            r.decoded_offset = 0;
+            Name mode = ext["mode"].str();
+            if (mode == "ATTRIBUTES")
+            {
+                r.mode = MeshoptMode::attributes;
+                if (!r.stride || r.stride > 256 || (r.stride % 4) != 0)
+                {
+                    return set_error(BasicError::format_error(), "Invalid byte stride of compressed buffer view %u.", index);
+                }
+            }
+            else if (mode == "TRIANGLES" || mode == "INDICES")
+            {
+                r.mode = mode == "TRIANGLES" ? MeshoptMode::triangles : MeshoptMode::indices;
+                if (r.stride != 2 && r.stride != 4)
+                {
+                    return set_error(BasicError::format_error(), "Invalid byte stride of compressed buffer view %u.", index);
+                }
+            }
+            else
+            {
+                return set_error(BasicError::format_error(), "Invalid compression mode of buffer view %u.", index);
+            }
+            Name filter = ext["filter"].str("NONE");
+            if (filter == "NONE") r.filter = MeshoptFilter::none;
+            else if (filter == "OCTAHEDRAL" && (r.stride == 4 || r.stride == 8)) r.filter = MeshoptFilter::octahedral;
+            else if (filter == "QUATERNION" && r.stride == 8) r.filter = MeshoptFilter::quaternion;
+            else if (filter == "EXPONENTIAL") r.filter = MeshoptFilter::exponential;
+            else
+            {
+                return set_error(BasicError::format_error(), "Invalid compression filter of buffer view %u.", index);
+            }
+            if (r.mode != MeshoptMode::attributes && r.filter != MeshoptFilter::none)
+            {
+                return set_error(BasicError::format_error(), "Invalid compression filter of buffer view %u.", index);
+            }
+            return r;
+        }
+
+        static i32 read_texture_index(const Variant& texture_info)
+        {
+            return texture_info.valid() ? (i32)texture_info["index"].inum(-1) : -1;
+        }
+
+        static R<AccessorType> parse_accessor_type(const Name& type)
+        {
+            if (type == "SCALAR") return AccessorType::scalar;
+            if (type == "VEC2") return AccessorType::vec2;
+            if (type == "VEC3") return AccessorType::vec3;
+            if (type == "VEC4") return AccessorType::vec4;
+            if (type == "MAT2") return AccessorType::mat2;
+            if (type == "MAT3") return AccessorType::mat3;
+            if (type == "MAT4") return AccessorType::mat4;
+            return BasicError::format_error();
+        }
+
+        static bool is_valid_component_type(u64 type)
+        {
+            return type == (u64)ComponentType::i8 || type == (u64)ComponentType::u8 ||
+                type == (u64)ComponentType::i16 || type == (u64)ComponentType::u16 ||
+                type == (u64)ComponentType::u32 || type == (u64)ComponentType::f32;
+        }
+
+        LUNA_GLTF_LOADER_API R<GLTFFile> load(Span<const byte_t> glb_data)
+        {
+            GLTFFile file;
+            lutry
+            {
+                // Parse GLB chunks.
+                if (glb_data.size() < 12 || load_unaligned<u32>(glb_data.data()) != GLB_MAGIC)
+                {
+                    return set_error(BasicError::format_error(), "The data is not glTF binary data.");
+                }
+                u32 version = load_unaligned<u32>(glb_data.data() + 4);
+                if (version != 2)
+                {
+                    return set_error(BasicError::not_supported(), "glTF binary version %u is not supported.", version);
+                }
+                usize length = min<usize>(load_unaligned<u32>(glb_data.data() + 8), glb_data.size());
+                Span<const byte_t> json_chunk;
+                Span<const byte_t> bin_chunk;
+                usize cur = 12;
+                while (length - cur >= 8)
+                {
+                    usize chunk_length = load_unaligned<u32>(glb_data.data() + cur);
+                    u32 chunk_type = load_unaligned<u32>(glb_data.data() + cur + 4);
+                    cur += 8;
+                    if (chunk_length > length - cur)
+                    {
+                        return set_error(BasicError::format_error(), "Invalid glTF binary chunk length.");
+                    }
+                    if (chunk_type == GLB_CHUNK_JSON && json_chunk.empty())
+                    {
+                        json_chunk = Span<const byte_t>(glb_data.data() + cur, chunk_length);
+                    }
+                    else if (chunk_type == GLB_CHUNK_BIN && bin_chunk.empty())
+                    {
+                        bin_chunk = Span<const byte_t>(glb_data.data() + cur, chunk_length);
+                    }
+                    cur += chunk_length;
+                }
+                if (json_chunk.empty())
+                {
+                    return set_error(BasicError::format_error(), "The glTF binary data does not have one JSON chunk.");
+                }
+                lulet(json_data, VariantUtils::read_json((const c8*)json_chunk.data(), json_chunk.size()));
+                const Variant& json = json_data;
+                for (auto& ext : json["extensionsRequired"].values())
+                {
+                    Name name = ext.str();
+                    if (name != "EXT_meshopt_compression" && name != "KHR_mesh_quantization")
+                    {
+                        return set_error(BasicError::not_supported(), "The required glTF extension %s is not supported.", name.c_str());
+                    }
+                }
+                // Only the buffer stored in the binary chunk is supported, which must be the first buffer.
+                Vector<Span<const byte_t>> buffers;
+                const Variant& json_buffers = json["buffers"];
+                for (usize i = 0; i < json_buffers.size(); ++i)
+                {
+                    const Variant& b = json_buffers[i];
+                    usize byte_length = (usize)b["byteLength"].unum(0);
+                    Span<const byte_t> data;
+                    if (i == 0 && !b.contains("uri") && byte_length <= bin_chunk.size())
+                    {
+                        data = Span<const byte_t>(bin_chunk.data(), byte_length);
+                    }
+                    buffers.push_back(data);
+                }
+                // Resolve buffer views.
+                Vector<CompressedBufferView> compressed_views;
+                usize decoded_size = 0;
+                const Variant& json_buffer_views = json["bufferViews"];
+                file.buffer_views.resize(json_buffer_views.size());
+                for (usize i = 0; i < json_buffer_views.size(); ++i)
+                {
+                    const Variant& v = json_buffer_views[i];
+                    BufferView& view = file.buffer_views[i];
+                    view.byte_stride = (u32)v["byteStride"].unum(0);
+                    u64 buffer = v["buffer"].unum(U64_MAX);
+                    u64 offset = v["byteOffset"].unum(0);
+                    u64 byte_length = v["byteLength"].unum(0);
+                    if (buffer >= buffers.size())
+                    {
+                        return set_error(BasicError::format_error(), "Invalid buffer index of buffer view %u.", (u32)i);
+                    }
+                    const Variant& ext = v["extensions"]["EXT_meshopt_compression"];
+                    if (ext.valid())
+                    {
+                        lulet(compressed, parse_compressed_buffer_view(ext, buffers, (u32)i));
+                        if (compressed.count * compressed.stride > byte_length)
+                        {
+                            return set_error(BasicError::format_error(), "The decoded data of buffer view %u exceeds its byte length.", (u32)i);
+                        }
+                        compressed.decoded_offset = decoded_size;
+                        decoded_size = align_upper(decoded_size + (usize)byte_length, 16);
+                        compressed_views.push_back(compressed);
+                    }
+                    else if (!buffers[buffer].empty())
+                    {
+                        if (offset + byte_length > buffers[buffer].size())
+                        {
+                            return set_error(BasicError::format_error(), "Buffer view %u exceeds the range of its buffer.", (u32)i);
+                        }
+                        view.data = Span<const byte_t>(buffers[buffer].data() + offset, (usize)byte_length);
+                    }
+                }
+                // Decode compressed buffer views in parallel.
+                if (!compressed_views.empty())
+                {
+                    file.decoded_data = Blob(decoded_size, 16);
+                    memzero(file.decoded_data.data(), decoded_size);
+                    byte_t* decoded_data = (byte_t*)file.decoded_data.data();
+                    for (auto& i : compressed_views)
+                    {
+                        usize byte_length = (usize)json_buffer_views[i.buffer_view]["byteLength"].unum(0);
+                        file.buffer_views[i.buffer_view].data = Span<const byte_t>(decoded_data + i.decoded_offset, byte_length);
+                    }
+                    Vector<u8> decoded;
+                    decoded.resize(compressed_views.size(), 0);
+                    JobSystem::parallel_for(0, compressed_views.size(), 1, [&](usize i)
+                    {
+                        decoded[i] = decode_buffer_view(compressed_views[i], decoded_data + compressed_views[i].decoded_offset) ? 1 : 0;
+                    });
+                    for (usize i = 0; i < compressed_views.size(); ++i)
+                    {
+                        if (!decoded[i])
+                        {
+                            return set_error(BasicError::bad_data(), "Failed to decode compressed buffer view %u.", compressed_views[i].buffer_view);
+                        }
+                    }
+                }
+                // Parse accessors.
+                const Variant& json_accessors = json["accessors"];
+                file.accessors.resize(json_accessors.size());
+                for (usize i = 0; i < json_accessors.size(); ++i)
+                {
+                    const Variant& a = json_accessors[i];
+                    Accessor& accessor = file.accessors[i];
+                    accessor.buffer_view = (i32)a["bufferView"].inum(-1);
+                    if (accessor.buffer_view >= (i32)file.buffer_views.size())
+                    {
+                        return set_error(BasicError::format_error(), "Invalid buffer view index of accessor %u.", (u32)i);
+                    }
+                    accessor.byte_offset = (usize)a["byteOffset"].unum(0);
+                    u64 component_type = a["componentType"].unum(0);
+                    if (!is_valid_component_type(component_type))
+                    {
+                        return set_error(BasicError::format_error(), "Invalid component type of accessor %u.", (u32)i);
+                    }
+                    accessor.component_type = (ComponentType)component_type;
+                    accessor.normalized = a["normalized"].boolean(false);
+                    accessor.sparse = a.contains("sparse");
+                    auto type = parse_accessor_type(a["type"].str());
+                    if (failed(type))
+                    {
+                        return set_error(BasicError::format_error(), "Invalid type of accessor %u.", (u32)i);
+                    }
+                    accessor.type = type.get();
+                    accessor.count = (usize)a["count"].unum(0);
+                }
+                // Parse meshes.
+                const Variant& json_meshes = json["meshes"];
+                file.meshes.resize(json_meshes.size());
+                for (usize i = 0; i < json_meshes.size(); ++i)
+                {
+                    const Variant& m = json_meshes[i];
+                    Mesh& mesh = file.meshes[i];
+                    mesh.name = m["name"].str();
+                    for (auto& p : m["primitives"].values())
+                    {
+                        mesh.primitives.push_back(Primitive());
+                        Primitive& primitive = mesh.primitives.back();
+                        for (auto& a : p["attributes"].key_values())
+                        {
+                            Attribute attribute;
+                            attribute.name = a.first;
+                            attribute.accessor = (u32)a.second.unum(U32_MAX);
+                            if (attribute.accessor >= file.accessors.size())
+                            {
+                                return set_error(BasicError::format_error(), "Invalid attribute accessor index of mesh %u.", (u32)i);
+                            }
+                            primitive.attributes.push_back(attribute);
+                        }
+                        primitive.indices = (i32)p["indices"].inum(-1);
+                        if (primitive.indices >= (i32)file.accessors.size())
+                        {
+                            return set_error(BasicError::format_error(), "Invalid index accessor index of mesh %u.", (u32)i);
+                        }
+                        primitive.material = (i32)p["material"].inum(-1);
+                        u64 mode = p["mode"].unum((u64)PrimitiveMode::triangles);
+                        if (mode > (u64)PrimitiveMode::triangle_fan)
+                        {
+                            return set_error(BasicError::format_error(), "Invalid primitive mode of mesh %u.", (u32)i);
+                        }
+                        primitive.mode = (PrimitiveMode)mode;
+                        primitive.draco_compressed = p["extensions"].contains("KHR_draco_mesh_compression");
+                    }
+                }
+                // Parse materials.
+                const Variant& json_materials = json["materials"];
+                file.materials.resize(json_materials.size());
+                for (usize i = 0; i < json_materials.size(); ++i)
+                {
+                    const Variant& m = json_materials[i];
+                    Material& material = file.materials[i];
+                    material.name = m["name"].str();
+                    const Variant& pbr = m["pbrMetallicRoughness"];
+                    const Variant& base_color_factor = pbr["baseColorFactor"];
+                    if (base_color_factor.size() == 4)
+                    {
+                        material.base_color_factor = Float4U((f32)base_color_factor[0].fnum(), (f32)base_color_factor[1].fnum(),
+                            (f32)base_color_factor[2].fnum(), (f32)base_color_factor[3].fnum());
+                    }
+                    material.metallic_factor = (f32)pbr["metallicFactor"].fnum(1.0);
+                    material.roughness_factor = (f32)pbr["roughnessFactor"].fnum(1.0);
+                    const Variant& emissive_factor = m["emissiveFactor"];
+                    if (emissive_factor.size() == 3)
+                    {
+                        material.emissive_factor = Float3U((f32)emissive_factor[0].fnum(), (f32)emissive_factor[1].fnum(), (f32)emissive_factor[2].fnum());
+                    }
+                    material.base_color_texture = read_texture_index(pbr["baseColorTexture"]);
+                    material.metallic_roughness_texture = read_texture_index(pbr["metallicRoughnessTexture"]);
+                    material.normal_texture = read_texture_index(m["normalTexture"]);
+                    material.occlusion_texture = read_texture_index(m["occlusionTexture"]);
+                    material.emissive_texture = read_texture_index(m["emissiveTexture"]);
+                    material.double_sided = m["doubleSided"].boolean(false);
+                }
+                // Parse textures and images.
+                const Variant& json_textures = json["textures"];
+                file.textures.resize(json_textures.size());
+                for (usize i = 0; i < json_textures.size(); ++i)
+                {
+                    file.textures[i].source = (i32)json_textures[i]["source"].inum(-1);
+                }
+                const Variant& json_images = json["images"];
+                file.images.resize(json_images.size());
+                for (usize i = 0; i < json_images.size(); ++i)
+                {
+                    const Variant& m = json_images[i];
+                    Image& image = file.images[i];
+                    image.name = m["name"].str();
+                    image.uri = m["uri"].str();
+                    image.mime_type = m["mimeType"].str();
+                    image.buffer_view = (i32)m["bufferView"].inum(-1);
+                }
+            }
+            lucatchret;
+            return file;
+        }
+
+        LUNA_GLTF_LOADER_API R<GLTFFile> load_file(const c8* path)
+        {
+            GLTFFile file;
+            lutry
+            {
+                lulet(mapped_file, map_file(path));
+                luset(file, load(Span<const byte_t>(mapped_file->get_data(), mapped_file->get_size())));
+                file.mapped_file = mapped_file;
+            }
+            lucatchret;
+            return file;
+        }
+
+        LUNA_GLTF_LOADER_API R<AccessorData> get_accessor_data(const GLTFFile& file, u32 accessor)
+        {
+            if (accessor >= file.accessors.size()) return BasicError::bad_arguments();
+            const Accessor& a = file.accessors[accessor];
+            if (a.sparse)
+            {
+                return set_error(BasicError::not_supported(), "Accessor %u is one sparse accessor, which is not supported.", accessor);
+            }
+            AccessorData r;
+            r.count = a.count;
+            r.element_size = get_component_size(a.component_type) * get_num_components(a.type);
+            r.stride = r.element_size;
+            if (a.buffer_view < 0) return r;
+            const BufferView& view = file.buffer_views[a.buffer_view];
+            if (!view.data.data())
+            {
+                return set_error(BasicError::not_supported(), "Accessor %u refers to one external buffer, which is not supported.", accessor);
+            }
+            if (view.byte_stride) r.stride = view.byte_stride;
+            if (a.count && a.byte_offset + r.stride * (a.count - 1) + r.element_size > view.data.size())
+            {
+                return set_error(BasicError::format_error(), "Accessor %u exceeds the range of its buffer view.", accessor);
+            }
+            r.data = view.data.data() + a.byte_offset;
+            return r;
+        }
+
+        inline f32 read_component_f32(const byte_t* src, ComponentType type, bool normalized)
+        {
+            switch (type)
+            {
+            case ComponentType::i8:
+            {
+                f32 v = (f32)load_unaligned<i8>(src);
+                return normalized ? max(v / 127.0f, -1.0f) : v;
+            }
+            case ComponentType::u8:
+            {
+                f32 v = (f32)load_unaligned<u8>(src);
+                return normalized ? v / 255.0f : v;
+            }
+            case ComponentType::i16:
+            {
+                f32 v = (f32)load_unaligned<i16>(src);
+                return normalized ? max(v / 32767.0f, -1.0f) : v;
+            }
+            case ComponentType::u16:
+            {
+                f32 v = (f32)load_unaligned<u16>(src);
+                return normalized ? v / 65535.0f : v;
+            }
+            case ComponentType::u32: return (f32)load_unaligned<u32>(src);
+            case ComponentType::f32: return load_unaligned<f32>(src);
+            default: lupanic(); return 0.0f;
+            }
+        }
+
+        LUNA_GLTF_LOADER_API RV read_accessor_f32(const GLTFFile& file, u32 accessor, f32* dst, u32 num_components)
+        {
+            lutry
+            {
+                lulet(data, get_accessor_data(file, accessor));
+                const Accessor& a = file.accessors[accessor];
+                u32 component_size = get_component_size(a.component_type);
+                u32 num_copy_components = min(get_num_components(a.type), num_components);
+                for (usize i = 0; i < data.count; ++i)
+                {
+                    f32* d = dst + i * num_components;
+                    u32 c = 0;
+                    if (data.data)
+                    {
+                        const byte_t* src = data.data + i * data.stride;
+                        for (; c < num_copy_components; ++c)
+                        {
+                            d[c] = read_component_f32(src + c * component_size, a.component_type, a.normalized);
+                        }
+                    }
+                    for (; c < num_components; ++c) d[c] = 0.0f;
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+
+        LUNA_GLTF_LOADER_API RV read_accessor_u32(const GLTFFile& file, u32 accessor, u32* dst)
+        {
+            lutry
+            {
+                lulet(data, get_accessor_data(file, accessor));
+                const Accessor& a = file.accessors[accessor];
+                if (a.type != AccessorType::scalar) return BasicError::bad_arguments();
+                if (!data.data)
+                {
+                    memzero(dst, sizeof(u32) * data.count);
+                    return ok;
+                }
+                switch (a.component_type)
+                {
+                case ComponentType::u8:
+                    for (usize i = 0; i < data.count; ++i) dst[i] = load_unaligned<u8>(data.data + i * data.stride);
+                    break;
+                case ComponentType::u16:
+                    for (usize i = 0; i < data.count; ++i) dst[i] = load_unaligned<u16>(data.data + i * data.stride);
+                    break;
+                case ComponentType::u32:
+                    for (usize i = 0; i < data.count; ++i) dst[i] = load_unaligned<u32>(data.data + i * data.stride);
+                    break;
+                default:
+                    return BasicError::bad_arguments();
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+    }
+
+    LUNA_GLTF_LOADER_API Module* module_gltf_loader()
+    {
+        static GLTFLoader::GLTFLoaderModule m;
+        return &m;
+    }
+}
@@ -0,0 +1,368 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file MeshoptDecoder.cpp
+* @author JXMaster
+* @date 2024/5/3
+*/
+#include "MeshoptDecoder.hpp"
+#include <Luna/Runtime/MemoryUtils.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
+#include <math.h>
+
+namespace Luna
+{
+    namespace GLTFLoader
+    {
+        // The format of the compressed data is specified by the EXT_meshopt_compression extension.
+
+        constexpr u8 VERTEX_HEADER = 0xA0;
+        constexpr u8 TRIANGLE_HEADER = 0xE0;
+        constexpr u8 SEQUENCE_HEADER = 0xD0;
+
+        constexpr usize BYTE_GROUP_SIZE = 16;
+        // The maximum number of bytes consumed by one byte group.
+        constexpr usize BYTE_GROUP_DECODE_LIMIT = 24;
+        constexpr usize VERTEX_BLOCK_SIZE_BYTES = 8192;
+        constexpr usize VERTEX_BLOCK_MAX_SIZE = 256;
+        constexpr usize VERTEX_TAIL_MIN_SIZE = 32;
+
+        inline u8 unzigzag8(u8 v)
+        {
+            return (u8)((0 - (v & 1)) ^ (v >> 1));
+        }
+
+        static const byte_t* decode_bytes_group(const byte_t* data, u8* dst, u32 bits_log2)
+        {
+            if (bits_log2 == 0)
+            {
+                memzero(dst, BYTE_GROUP_SIZE);
+                return data;
+            }
+            if (bits_log2 == 3)
+            {
+                memcpy(dst, data, BYTE_GROUP_SIZE);
+                return data + BYTE_GROUP_SIZE;
+            }
+            // Values are packed with 2 or 4 bits from the most significant bits, the value with all bits set is one sentinel
+            // that indicates that the value is stored in the next byte after packed values.
+            u32 bits = bits_log2 == 1 ? 2 : 4;
+            u32 sentinel = (1 << bits) - 1;
+            const byte_t* extra = data + BYTE_GROUP_SIZE * bits / 8;
+            for (u32 i = 0; i < BYTE_GROUP_SIZE; ++i)
+            {
+                u32 shift = 8 - bits - (i * bits) % 8;
+                u32 v = (data[i * bits / 8] >> shift) & sentinel;
+                dst[i] = v == sentinel ? *(extra++) : (u8)v;
+            }
+            return extra;
+        }
+
+        static const byte_t* decode_bytes(const byte_t* data, const byte_t* data_end, u8* dst, usize size)
+        {
+            // Every byte group has one 2-bit header.
+            usize header_size = (size / BYTE_GROUP_SIZE + 3) / 4;
+            if ((usize)(data_end - data) < header_size) return nullptr;
+            const byte_t* header = data;
+            data += header_size;
+            for (usize i = 0; i < size; i += BYTE_GROUP_SIZE)
+            {
+                if ((usize)(data_end - data) < BYTE_GROUP_DECODE_LIMIT) return nullptr;
+                usize group = i / BYTE_GROUP_SIZE;
+                u32 bits_log2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+                data = decode_bytes_group(data, dst + i, bits_log2);
+            }
+            return data;
+        }
+
+        bool decode_meshopt_vertices(byte_t* dst, usize count, usize stride, const byte_t* src, usize src_size)
+        {
+            if (!stride || stride > VERTEX_BLOCK_MAX_SIZE || (stride % 4) != 0) return false;
+            if (!src_size || src[0] != VERTEX_HEADER) return false;
+            // The tail stores the first vertex, which is used as the baseline of the first block.
+            usize tail_size = max(stride, VERTEX_TAIL_MIN_SIZE);
+            if (src_size < 1 + tail_size) return false;
+            const byte_t* data = src + 1;
+            const byte_t* data_end = src + src_size;
+            u8 last_vertex[VERTEX_BLOCK_MAX_SIZE];
+            memcpy(last_vertex, data_end - tail_size, stride);
+            usize block_size = min((VERTEX_BLOCK_SIZE_BYTES / stride) & ~(BYTE_GROUP_SIZE - 1), VERTEX_BLOCK_MAX_SIZE);
+            u8 buffer[VERTEX_BLOCK_MAX_SIZE];
+            u8 transposed[VERTEX_BLOCK_SIZE_BYTES];
+            for (usize offset = 0; offset < count; offset += block_size)
+            {
+                usize num_vertices = min(block_size, count - offset);
+                usize num_vertices_aligned = (num_vertices + BYTE_GROUP_SIZE - 1) & ~(BYTE_GROUP_SIZE - 1);
+                // Every byte of the vertex is stored separately as deltas to the same byte of the previous vertex.
+                for (usize k = 0; k < stride; ++k)
+                {
+                    data = decode_bytes(data, data_end, buffer, num_vertices_aligned);
+                    if (!data) return false;
+                    u8 p = last_vertex[k];
+                    for (usize i = 0; i < num_vertices; ++i)
+                    {
+                        u8 v = (u8)(unzigzag8(buffer[i]) + p);
+                        transposed[i * stride + k] = v;
+                        p = v;
+                    }
+                }
+                memcpy(dst + offset * stride, transposed, num_vertices * stride);
+                memcpy(last_vertex, transposed + stride * (num_vertices - 1), stride);
+            }
+            return (usize)(data_end - data) == tail_size;
+        }
+
+        inline u32 decode_vbyte(const byte_t*& data)
+        {
+            u8 lead = *(data++);
+            if (lead < 128) return lead;
+            u32 result = lead & 127;
+            u32 shift = 7;
+            for (u32 i = 0; i < 4; ++i)
+            {
+                u8 group = *(data++);
+                result |= (u32)(group & 127) << shift;
+                shift += 7;
+                if (group < 128) break;
+            }
+            return result;
+        }
+
+        inline u32 decode_index(const byte_t*& data, u32 last)
+        {
+            u32 v = decode_vbyte(data);
+            u32 d = (v >> 1) ^ (0 - (v & 1));
+            return last + d;
+        }
+
+        inline void write_index(byte_t* dst, usize i, usize stride, u32 index)
+        {
+            if (stride == 2) ((u16*)dst)[i] = (u16)index;
+            else ((u32*)dst)[i] = index;
+        }
+
+        inline void write_triangle(byte_t* dst, usize i, usize stride, u32 a, u32 b, u32 c)
+        {
+            write_index(dst, i, stride, a);
+            write_index(dst, i + 1, stride, b);
+            write_index(dst, i + 2, stride, c);
+        }
+
+        inline void push_vertex_fifo(u32* fifo, u32 v, usize& offset, usize cond = 1)
+        {
+            fifo[offset] = v;
+            offset = (offset + cond) & 15;
+        }
+
+        inline void push_edge_fifo(u32 (*fifo)[2], u32 a, u32 b, usize& offset)
+        {
+            fifo[offset][0] = a;
+            fifo[offset][1] = b;
+            offset = (offset + 1) & 15;
+        }
+
+        bool decode_meshopt_triangles(byte_t* dst, usize count, usize stride, const byte_t* src, usize src_size)
+        {
+            if ((stride != 2 && stride != 4) || (count % 3) != 0) return false;
+            // One code byte for every triangle and 16 bytes for the auxiliary code table.
+            if (src_size < 1 + count / 3 + 16) return false;
+            if ((src[0] & 0xF0) != TRIANGLE_HEADER) return false;
+            u32 version = src[0] & 0x0F;
+            if (version > 1) return false;
+            u32 edge_fifo[16][2];
+            u32 vertex_fifo[16];
+            memset(edge_fifo, 0xFF, sizeof(edge_fifo));
+            memset(vertex_fifo, 0xFF, sizeof(vertex_fifo));
+            usize edge_fifo_offset = 0;
+            usize vertex_fifo_offset = 0;
+            u32 next = 0;
+            u32 last = 0;
+            u32 fec_max = version >= 1 ? 13 : 15;
+            const byte_t* code = src + 1;
+            const byte_t* data = code + count / 3;
+            const byte_t* data_safe_end = src + src_size - 16;
+            const byte_t* code_aux_table = data_safe_end;
+            for (usize i = 0; i < count; i += 3)
+            {
+                // Every triangle consumes at most 16 data bytes.
+                if (data > data_safe_end) return false;
+                u8 code_tri = *(code++);
+                if (code_tri < 0xF0)
+                {
+                    // The triangle shares one edge with one recent triangle.
+                    u32 fe = code_tri >> 4;
+                    u32 a = edge_fifo[(edge_fifo_offset - 1 - fe) & 15][0];
+                    u32 b = edge_fifo[(edge_fifo_offset - 1 - fe) & 15][1];
+                    u32 fec = code_tri & 15;
+                    u32 c;
+                    if (fec < fec_max)
+                    {
+                        u32 cf = vertex_fifo[(vertex_fifo_offset - 1 - fec) & 15];
+                        c = fec == 0 ? next : cf;
+                        usize fec0 = fec == 0;
+                        next += (u32)fec0;
+                        write_triangle(dst, i, stride, a, b, c);
+                        push_vertex_fifo(vertex_fifo, c, vertex_fifo_offset, fec0);
+                    }
+                    else
+                    {
+                        // 13 and 14 are decoded as -1 and 1 relative to the last free index.
+                        last = c = fec != 15 ? last + (fec - (fec ^ 3)) : decode_index(data, last);
+                        write_triangle(dst, i, stride, a, b, c);
+                        push_vertex_fifo(vertex_fifo, c, vertex_fifo_offset);
+                    }
+                    push_edge_fifo(edge_fifo, c, b, edge_fifo_offset);
+                    push_edge_fifo(edge_fifo, a, c, edge_fifo_offset);
+                }
+                else
+                {
+                    u32 a, b, c;
+                    usize feb_push, fec_push;
+                    if (code_tri < 0xFE)
+                    {
+                        // The auxiliary code is read from the table.
+                        u8 code_aux = code_aux_table[code_tri & 15];
+                        u32 feb = code_aux >> 4;
+                        u32 fec = code_aux & 15;
+                        a = next++;
+                        u32 bf = vertex_fifo[(vertex_fifo_offset - feb) & 15];
+                        b = feb == 0 ? next : bf;
+                        feb_push = feb == 0;
+                        next += (u32)feb_push;
+                        u32 cf = vertex_fifo[(vertex_fifo_offset - fec) & 15];
+                        c = fec == 0 ? next : cf;
+                        fec_push = fec == 0;
+                        next += (u32)fec_push;
+                    }
+                    else
+                    {
+                        // The auxiliary code is read from data.
+                        u8 code_aux = *(data++);
+                        u32 fea = code_tri == 0xFE ? 0 : 15;
+                        u32 feb = code_aux >> 4;
+                        u32 fec = code_aux & 15;
+                        if (code_aux == 0) next = 0;
+                        a = fea == 0 ? next++ : 0;
+                        b = feb == 0 ? next++ : vertex_fifo[(vertex_fifo_offset - feb) & 15];
+                        c = fec == 0 ? next++ : vertex_fifo[(vertex_fifo_offset - fec) & 15];
+                        if (fea == 15) last = a = decode_index(data, last);
+                        if (feb == 15) last = b = decode_index(data, last);
+                        if (fec == 15) last = c = decode_index(data, last);
+                        feb_push = feb == 0 || feb == 15;
+                        fec_push = fec == 0 || fec == 15;
+                    }
+                    write_triangle(dst, i, stride, a, b, c);
+                    push_vertex_fifo(vertex_fifo, a, vertex_fifo_offset);
+                    push_vertex_fifo(vertex_fifo, b, vertex_fifo_offset, feb_push);
+                    push_vertex_fifo(vertex_fifo, c, vertex_fifo_offset, fec_push);
+                    push_edge_fifo(edge_fifo, b, a, edge_fifo_offset);
+                    push_edge_fifo(edge_fifo, c, b, edge_fifo_offset);
+                    push_edge_fifo(edge_fifo, a, c, edge_fifo_offset);
+                }
+            }
+            // All data bytes should be consumed.
+            return data == data_safe_end;
+        }
+
+        bool decode_meshopt_indices(byte_t* dst, usize count, usize stride, const byte_t* src, usize src_size)
+        {
+            if (stride != 2 && stride != 4) return false;
+            if (src_size < 1 + count + 4) return false;
+            if ((src[0] & 0xF0) != SEQUENCE_HEADER) return false;
+            u32 version = src[0] & 0x0F;
+            if (version > 1) return false;
+            const byte_t* data = src + 1;
+            const byte_t* data_safe_end = src + src_size - 4;
+            // Every index is stored as one delta to one of two baselines.
+            u32 last[2] = { 0, 0 };
+            for (usize i = 0; i < count; ++i)
+            {
+                if (data >= data_safe_end) return false;
+                u32 v = decode_vbyte(data);
+                u32 current = v & 1;
+                v >>= 1;
+                u32 d = (v >> 1) ^ (0 - (v & 1));
+                u32 index = last[current] + d;
+                last[current] = index;
+                write_index(dst, i, stride, index);
+            }
+            return data == data_safe_end;
+        }
+
+        template <typename _Ty>
+        static void apply_octahedral_filter(_Ty* data, usize count)
+        {
+            const f32 max_value = (f32)((1 << (sizeof(_Ty) * 8 - 1)) - 1);
+            for (usize i = 0; i < count; ++i)
+            {
+                // The third component stores the encoded value of 1.0.
+                f32 x = (f32)data[i * 4];
+                f32 y = (f32)data[i * 4 + 1];
+                f32 z = (f32)data[i * 4 + 2] - fabsf(x) - fabsf(y);
+                // Unfolds the octahedron for the lower hemisphere.
+                f32 t = z >= 0.0f ? 0.0f : z;
+                x += x >= 0.0f ? t : -t;
+                y += y >= 0.0f ? t : -t;
+                f32 s = max_value / sqrtf(x * x + y * y + z * z);
+                data[i * 4] = (_Ty)(i32)(x * s + (x >= 0.0f ? 0.5f : -0.5f));
+                data[i * 4 + 1] = (_Ty)(i32)(y * s + (y >= 0.0f ? 0.5f : -0.5f));
+                data[i * 4 + 2] = (_Ty)(i32)(z * s + (z >= 0.0f ? 0.5f : -0.5f));
+            }
+        }
+
+        void apply_meshopt_octahedral_filter(byte_t* data, usize count, usize stride)
+        {
+            if (stride == 4) apply_octahedral_filter((i8*)data, count);
+            else apply_octahedral_filter((i16*)data, count);
+        }
+
+        void apply_meshopt_quaternion_filter(byte_t* data, usize count)
+        {
+            i16* d = (i16*)data;
+            const f32 scale = 1.0f / sqrtf(2.0f);
+            for (usize i = 0; i < count; ++i)
+            {
+                // The last component stores the scale in high bits and the index of the omitted component in low 2 bits.
+                i32 sf = d[i * 4 + 3] | 3;
+                f32 ss = scale / (f32)sf;
+                f32 x = (f32)d[i * 4] * ss;
+                f32 y = (f32)d[i * 4 + 1] * ss;
+                f32 z = (f32)d[i * 4 + 2] * ss;
+                f32 ww = 1.0f - x * x - y * y - z * z;
+                f32 w = sqrtf(ww >= 0.0f ? ww : 0.0f);
+                i32 xf = (i32)(x * 32767.0f + (x >= 0.0f ? 0.5f : -0.5f));
+                i32 yf = (i32)(y * 32767.0f + (y >= 0.0f ? 0.5f : -0.5f));
+                i32 zf = (i32)(z * 32767.0f + (z >= 0.0f ? 0.5f : -0.5f));
+                i32 wf = (i32)(w * 32767.0f + 0.5f);
+                u32 qc = d[i * 4 + 3] & 3;
+                d[i * 4 + ((qc + 1) & 3)] = (i16)xf;
+                d[i * 4 + ((qc + 2) & 3)] = (i16)yf;
+                d[i * 4 + ((qc + 3) & 3)] = (i16)zf;
+                d[i * 4 + ((qc + 0) & 3)] = (i16)wf;
+            }
+        }
+
+        void apply_meshopt_exponential_filter(byte_t* data, usize count, usize stride)
+        {
+            u32* d = (u32*)data;
+            usize num_values = count * stride / 4;
+            for (usize i = 0; i < num_values; ++i)
+            {
+                // 24-bit signed mantissa and 8-bit signed exponent.
+                u32 v = d[i];
+                i32 m = (i32)(v << 8) >> 8;
+                i32 e = (i32)v >> 24;
+                union
+                {
+                    f32 f;
+                    u32 u;
+                } r;
+                r.u = (u32)(e + 127) << 23;
+                r.f = r.f * (f32)m;
+                d[i] = r.u;
+            }
+        }
+    }
+}
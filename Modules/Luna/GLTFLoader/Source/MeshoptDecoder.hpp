@@ -0,0 +1,32 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file MeshoptDecoder.hpp
+* @author JXMaster
+* @date 2024/5/3
+*/
+#pragma once
+#include <Luna/Runtime/Base.hpp>
+
+namespace Luna
+{
+    namespace GLTFLoader
+    {
+        // Decoders for buffer views compressed by EXT_meshopt_compression.
+        // All decoders return `false` if the data is malformed.
+
+        // Decodes data of mode `ATTRIBUTES`.
+        bool decode_meshopt_vertices(byte_t* dst, usize count, usize stride, const byte_t* src, usize src_size);
+        // Decodes data of mode `TRIANGLES`. `stride` is 2 or 4.
+        bool decode_meshopt_triangles(byte_t* dst, usize count, usize stride, const byte_t* src, usize src_size);
+        // Decodes data of mode `INDICES`. `stride` is 2 or 4.
+        bool decode_meshopt_indices(byte_t* dst, usize count, usize stride, const byte_t* src, usize src_size);
+
+        // Applies filters to decoded data of mode `ATTRIBUTES` in place.
+        void apply_meshopt_octahedral_filter(byte_t* data, usize count, usize stride);
+        void apply_meshopt_quaternion_filter(byte_t* data, usize count);
+        void apply_meshopt_exponential_filter(byte_t* data, usize count, usize stride);
+    }
+}
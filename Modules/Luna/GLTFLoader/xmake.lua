@@ -0,0 +1,5 @@
+luna_sdk_module_target("GLTFLoader")
+    add_headerfiles("*.hpp", {prefixdir = "Luna/GLTFLoader"})
+    add_files("Source/**.cpp")
+    add_deps("Runtime", "VariantUtils", "JobSystem")
+target_end()
\ No newline at end of file
@@ -0,0 +1,166 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file InputEvent.hpp
+* @author JXMaster
+* @date 2024/5/1
+*/
+#pragma once
+#include "KeyCode.hpp"
+#include "Controller.hpp"
+#include <Luna/Runtime/Span.hpp>
+
+#ifndef LUNA_HID_API
+#define LUNA_HID_API
+#endif
+
+namespace Luna
+{
+    namespace HID
+    {
+        //! @addtogroup HID
+        //! @{
+
+        //! Specifies the type of one input event.
+        enum class InputEventType : u8
+        {
+            //! One key is pressed. @ref InputEvent::key is valid.
+            key_down = 0,
+            //! One key is released. @ref InputEvent::key is valid.
+            key_up,
+            //! One character is input. @ref InputEvent::character is valid.
+            character,
+            //! The mouse cursor is moved. @ref InputEvent::position is valid.
+            mouse_move,
+            //! The mouse is moved while raw mouse motion is enabled. @ref InputEvent::delta is valid.
+            //! @details Every event reports the motion of one platform input message, deltas are never coalesced.
+            mouse_delta,
+            //! One mouse button is pressed. @ref InputEvent::mouse_button is valid.
+            mouse_down,
+            //! One mouse button is released. @ref InputEvent::mouse_button is valid.
+            mouse_up,
+            //! The mouse wheel is scrolled. @ref InputEvent::delta is valid.
+            mouse_wheel,
+            //! One controller is connected. @ref InputEvent::index is valid.
+            controller_connected,
+            //! One controller is disconnected. @ref InputEvent::index is valid.
+            controller_disconnected,
+            //! One controller button is pressed. @ref InputEvent::index and @ref InputEvent::controller_button are valid.
+            controller_button_down,
+            //! One controller button is released. @ref InputEvent::index and @ref InputEvent::controller_button are valid.
+            controller_button_up,
+            //! One controller axis is changed. @ref InputEvent::index and @ref InputEvent::axis are valid.
+            controller_axis,
+        };
+
+        //! Specifies one controller axis.
+        enum class ControllerAxis : u8
+        {
+            //! The x axis for left pad.
+            lx = 0,
+            //! The y axis for left pad.
+            ly,
+            //! The x axis for right pad.
+            rx,
+            //! The y axis for right pad.
+            ry,
+            //! The left trigger.
+            lt,
+            //! The right trigger.
+            rt,
+        };
+
+        //! The position reported by one input event.
+        struct InputEventPosition
+        {
+            i32 x;
+            i32 y;
+        };
+
+        //! The delta value reported by one input event.
+        struct InputEventDelta
+        {
+            f32 x;
+            f32 y;
+        };
+
+        //! The controller axis value reported by one input event.
+        struct InputEventAxis
+        {
+            ControllerAxis axis;
+            f32 value;
+        };
+
+        //! Describes one buffered input event.
+        struct InputEvent
+        {
+            //! The time when the event is received, in ticks returned by @ref get_ticks.
+            u64 timestamp;
+            //! The object that produces this event, like the window that receives the event. This may be `nullptr`.
+            void* source;
+            //! The event type.
+            InputEventType type;
+            //! The index of the controller for controller events.
+            u32 index;
+            union
+            {
+                //! The key for key events.
+                KeyCode key;
+                //! The input character for @ref InputEventType::character.
+                c32 character;
+                //! The mouse position relative to the client area of the window for @ref InputEventType::mouse_move.
+                InputEventPosition position;
+                //! The mouse motion for @ref InputEventType::mouse_delta, or the wheel delta for @ref InputEventType::mouse_wheel.
+                InputEventDelta delta;
+                //! The mouse button for mouse button events.
+                MouseButton mouse_button;
+                //! The controller button for controller button events.
+                ControllerButton controller_button;
+                //! The controller axis and its new value for @ref InputEventType::controller_axis.
+                InputEventAxis axis;
+            };
+        };
+
+        //! Enables the input event buffer.
+        //! @details When the input event buffer is enabled, input events received by the platform (for example, by windows of
+        //! the Window module) are appended to one lock-free ring buffer with high-precision timestamps, and can be read in bulk by
+        //! @ref read_input_events once per frame or from one dedicated input thread. This does not affect event callbacks of windows.
+        //! @param[in] capacity The maximum number of events that can be buffered. Events submitted when the buffer is full are dropped.
+        //! @par Valid Usage
+        //! * This must not be called when other threads are submitting or reading events.
+        LUNA_HID_API void enable_input_event_buffer(usize capacity = 4096);
+
+        //! Disables the input event buffer and discards all buffered events.
+        //! @par Valid Usage
+        //! * This must not be called when other threads are submitting or reading events.
+        LUNA_HID_API void disable_input_event_buffer();
+
+        //! Checks whether the input event buffer is enabled.
+        LUNA_HID_API bool is_input_event_buffer_enabled();
+
+        //! Appends one event to the input event buffer.
+        //! @details This is called by modules that receive input events from the platform, and can be called from any thread.
+        //! @param[in] e The event to append. If `e.timestamp` is `0`, the current time is used.
+        //! @return Returns `true` if the event is appended. Returns `false` if the buffer is not enabled or is full.
+        LUNA_HID_API bool submit_input_event(const InputEvent& e);
+
+        //! Reads events from the input event buffer in the order they are submitted.
+        //! @param[out] out_events The buffer to receive events.
+        //! @return Returns the number of events read.
+        LUNA_HID_API usize read_input_events(Span<InputEvent> out_events);
+
+        //! Gets the number of events dropped because the input event buffer is full.
+        LUNA_HID_API u64 get_num_dropped_input_events();
+
+        //! Polls states of controllers and submits one event for every change since the last poll.
+        //! @details Controllers are polled by @ref get_controller_state, so the latency of controller events is determined by
+        //! the frequency of calling this function. Calling this from one dedicated input thread with a high frequency gives the
+        //! lowest latency. Calls to this function must be synchronized.
+        //! @param[in] num_controllers The number of controllers to poll, starting from index 0.
+        LUNA_HID_API void poll_controller_events(u32 num_controllers = 4);
+
+        //! @}
+    }
+}
@@ -0,0 +1,134 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file InputEvent.cpp
+* @author JXMaster
+* @date 2024/5/1
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_HID_API LUNA_EXPORT
+#include "../InputEvent.hpp"
+#include <Luna/Runtime/MPMCQueue.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    namespace HID
+    {
+        MPMCQueue<InputEvent>* g_input_events = nullptr;
+        u64 volatile g_num_dropped_input_events = 0;
+        // Controller states of the last poll, accessed only by `poll_controller_events`.
+        Vector<ControllerInputState> g_last_controller_states;
+
+        LUNA_HID_API void enable_input_event_buffer(usize capacity)
+        {
+            disable_input_event_buffer();
+            g_input_events = memnew<MPMCQueue<InputEvent>>(capacity);
+            g_num_dropped_input_events = 0;
+        }
+        LUNA_HID_API void disable_input_event_buffer()
+        {
+            if (g_input_events)
+            {
+                memdelete(g_input_events);
+                g_input_events = nullptr;
+            }
+            g_last_controller_states.clear();
+            g_last_controller_states.shrink_to_fit();
+        }
+        LUNA_HID_API bool is_input_event_buffer_enabled()
+        {
+            return g_input_events != nullptr;
+        }
+        LUNA_HID_API bool submit_input_event(const InputEvent& e)
+        {
+            if (!g_input_events) return false;
+            bool pushed;
+            if (e.timestamp) pushed = g_input_events->push(e);
+            else
+            {
+                InputEvent ev = e;
+                ev.timestamp = get_ticks();
+                pushed = g_input_events->push(ev);
+            }
+            if (!pushed) atom_inc_u64(&g_num_dropped_input_events);
+            return pushed;
+        }
+        LUNA_HID_API usize read_input_events(Span<InputEvent> out_events)
+        {
+            if (!g_input_events) return 0;
+            usize i = 0;
+            while (i < out_events.size() && g_input_events->pop(out_events[i])) ++i;
+            return i;
+        }
+        LUNA_HID_API u64 get_num_dropped_input_events()
+        {
+            return g_num_dropped_input_events;
+        }
+        static void submit_controller_event(u64 timestamp, u32 index, InputEventType type)
+        {
+            InputEvent e;
+            e.timestamp = timestamp;
+            e.source = nullptr;
+            e.type = type;
+            e.index = index;
+            submit_input_event(e);
+        }
+        static void submit_controller_axis_event(u64 timestamp, u32 index, ControllerAxis axis, f32 last_value, f32 value)
+        {
+            if (last_value == value) return;
+            InputEvent e;
+            e.timestamp = timestamp;
+            e.source = nullptr;
+            e.type = InputEventType::controller_axis;
+            e.index = index;
+            e.axis.axis = axis;
+            e.axis.value = value;
+            submit_input_event(e);
+        }
+        LUNA_HID_API void poll_controller_events(u32 num_controllers)
+        {
+            if (!g_input_events) return;
+            if (g_last_controller_states.size() < num_controllers)
+            {
+                ControllerInputState state;
+                memzero(&state, sizeof(ControllerInputState));
+                g_last_controller_states.resize(num_controllers, state);
+            }
+            for (u32 i = 0; i < num_controllers; ++i)
+            {
+                ControllerInputState state = get_controller_state(i);
+                u64 timestamp = get_ticks();
+                ControllerInputState& last = g_last_controller_states[i];
+                if (state.connected != last.connected)
+                {
+                    submit_controller_event(timestamp, i, state.connected ? InputEventType::controller_connected : InputEventType::controller_disconnected);
+                }
+                u32 changed = (u32)state.buttons ^ (u32)last.buttons;
+                while (changed)
+                {
+                    u32 bit = changed & (~changed + 1);
+                    changed &= ~bit;
+                    InputEvent e;
+                    e.timestamp = timestamp;
+                    e.source = nullptr;
+                    e.type = ((u32)state.buttons & bit) ? InputEventType::controller_button_down : InputEventType::controller_button_up;
+                    e.index = i;
+                    e.controller_button = (ControllerButton)bit;
+                    submit_input_event(e);
+                }
+                submit_controller_axis_event(timestamp, i, ControllerAxis::lx, last.axis_lx, state.axis_lx);
+                submit_controller_axis_event(timestamp, i, ControllerAxis::ly, last.axis_ly, state.axis_ly);
+                submit_controller_axis_event(timestamp, i, ControllerAxis::rx, last.axis_rx, state.axis_rx);
+                submit_controller_axis_event(timestamp, i, ControllerAxis::ry, last.axis_ry, state.axis_ry);
+                submit_controller_axis_event(timestamp, i, ControllerAxis::lt, last.axis_lt, state.axis_lt);
+                submit_controller_axis_event(timestamp, i, ControllerAxis::rt, last.axis_rt, state.axis_rt);
+                last = state;
+            }
+        }
+    }
+}
@@ -13,6 +13,7 @@
 #include "ImGuizmo.h"
 #include <Luna/RHI/RHI.hpp>
 #include <Luna/Font/Font.hpp>
+#include <Luna/Runtime/Path.hpp>
 
 #ifndef LUNA_IMGUI_API
 #define LUNA_IMGUI_API
@@ -30,8 +31,30 @@ namespace Luna
 
         LUNA_IMGUI_API RV render_draw_data(ImDrawData* data, RHI::ICommandBuffer* cmd_buffer, RHI::ITexture* render_target);
 
+        //! Sets the font used by ImGui.
+        //! @param[in] font The font file. If this is `nullptr`, the default font is used.
+        //! @param[in] font_size The font size in pixels before DPI scaling.
+        //! @param[in] ranges The glyph ranges to bake into the font atlas. If this is empty, @ref get_glyph_ranges_default is used.
+        //! Glyphs out of these ranges can still be displayed after they are requested by @ref request_glyphs.
         LUNA_IMGUI_API RV set_font(Font::IFontFile* font = nullptr, f32 font_size = 18.0f, Span<Pair<c16, c16>> ranges = {});
 
+        //! Sets the directory used to store baked font atlases.
+        //! @details Baked font atlases are keyed by the hash of the font data, the font size and glyph ranges. When the font atlas is 
+        //! rebuilt, one matching atlas in this directory is loaded instead of rasterizing glyphs again, so that fonts with large 
+        //! glyph ranges (like CJK fonts) do not slow down every launch.
+        //! @param[in] dir The VFS directory path. If this is empty, baked font atlases are not stored. Default is empty.
+        //! This should be called before the font atlas is built.
+        LUNA_IMGUI_API void set_font_cache_dir(const Path& dir);
+
+        //! Requests glyphs that are not baked into the font atlas.
+        //! @details Requested glyphs are rasterized to one region of the font atlas reserved for dynamic glyphs, and only regions 
+        //! of new glyphs are copied to the font texture when @ref render_draw_data is called. If the region is full, the font 
+        //! atlas is rebuilt with all requested glyphs baked when @ref update_io is called. Characters entered by the user are 
+        //! requested automatically.
+        //! @param[in] text The UTF-8 text that contains glyphs to request.
+        //! @param[in] text_len The length of the text in bytes. If this is `USIZE_MAX`, the text must be null-terminated.
+        LUNA_IMGUI_API void request_glyphs(const c8* text, usize text_len = USIZE_MAX);
+
         LUNA_IMGUI_API Vector<Pair<c16, c16>> get_glyph_ranges_default();
         LUNA_IMGUI_API Vector<Pair<c16, c16>> get_glyph_ranges_greek();
         LUNA_IMGUI_API Vector<Pair<c16, c16>> get_glyph_ranges_korean();
@@ -0,0 +1,501 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ImGuiFont.cpp
+* @author JXMaster
+* @date 2024/4/22
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_IMGUI_API LUNA_EXPORT
+#include "ImGuiFont.hpp"
+#include "imgui_internal.h"
+#include <Luna/Runtime/Hash.hpp>
+#include <Luna/Runtime/HashSet.hpp>
+#include <Luna/Runtime/Unicode.hpp>
+#include <Luna/Runtime/StaticSerialization.hpp>
+#include <Luna/RHI/Utility.hpp>
+#include <Luna/VFS/VFS.hpp>
+
+namespace Luna
+{
+    namespace ImGuiUtils
+    {
+        // Increase this version when the cache file format is changed, so that existing cache files are not used.
+        constexpr u32 FONT_CACHE_VERSION = 1;
+        constexpr u32 FONT_CACHE_FILE_MAGIC = 0x544E464C; // "LFNT"
+
+        // The size of the atlas region reserved for glyphs rasterized at run time in pixels, the height
+        // of the region is scaled by the DPI scale factor.
+        constexpr u32 DYNAMIC_GLYPH_REGION_WIDTH = 256;
+        constexpr u32 DYNAMIC_GLYPH_REGION_HEIGHT = 256;
+        constexpr u32 DYNAMIC_GLYPH_REGION_MAX_HEIGHT = 1024;
+
+        struct FontCacheFileHeader
+        {
+            u32 magic;
+            u32 version;
+            u64 key;
+            u32 tex_width;
+            u32 tex_height;
+            u32 num_custom_rects;
+            u32 num_glyphs;
+            f32 ascent;
+            f32 descent;
+        };
+
+        struct FontCacheRect
+        {
+            u16 x;
+            u16 y;
+        };
+
+        struct FontCacheGlyph
+        {
+            u32 codepoint;
+            f32 x0, y0, x1, y1;
+            f32 u0, v0, u1, v1;
+            f32 advance_x;
+        };
+
+        struct DynamicGlyphUpload
+        {
+            u32 x;
+            u32 y;
+            u32 width;
+            u32 height;
+            Vector<u32> pixels;
+        };
+
+        Ref<RHI::ITexture> g_font_tex;
+        Ref<Font::IFontFile> g_font_file;
+        f32 g_font_size = 18.0f;
+        Vector<Pair<c16, c16>> g_font_ranges;
+        Path g_font_cache_dir;
+
+        // The glyph ranges used to build the atlas. This must be kept alive until the atlas is rebuilt.
+        ImVector<ImWchar> g_build_ranges;
+        // Glyphs that were rasterized at run time and are baked into the atlas because the dynamic region is full.
+        Vector<c16> g_baked_glyphs;
+
+        // The custom rect index of the dynamic region in the atlas.
+        int g_dynamic_region = -1;
+        // Glyphs are packed in rows in the dynamic region.
+        u32 g_dynamic_cursor_x;
+        u32 g_dynamic_cursor_y;
+        u32 g_dynamic_row_height;
+        // Glyphs rasterized to the dynamic region of the current atlas.
+        Vector<c16> g_dynamic_glyphs;
+        // Glyphs that are requested but not found in the font.
+        HashSet<c16> g_missing_glyphs;
+        bool g_dynamic_region_full = false;
+        Vector<DynamicGlyphUpload> g_dynamic_glyph_uploads;
+        Ref<RHI::ICommandBuffer> g_font_upload_cmdbuf;
+
+        static u32 get_copy_queue_index(RHI::IDevice* dev)
+        {
+            using namespace RHI;
+            u32 copy_queue_index = U32_MAX;
+            // Prefer a dedicated copy queue if present.
+            u32 num_queues = dev->get_num_command_queues();
+            for (u32 i = 0; i < num_queues; ++i)
+            {
+                auto desc = dev->get_command_queue_desc(i);
+                if (desc.type == CommandQueueType::graphics && copy_queue_index == U32_MAX)
+                {
+                    copy_queue_index = i;
+                }
+                else if (desc.type == CommandQueueType::copy)
+                {
+                    copy_queue_index = i;
+                    break;
+                }
+            }
+            return copy_queue_index;
+        }
+        static R<RHI::ICommandBuffer*> get_font_upload_command_buffer(RHI::IDevice* dev)
+        {
+            if (!g_font_upload_cmdbuf || g_font_upload_cmdbuf->get_device() != dev)
+            {
+                auto r = dev->new_command_buffer(get_copy_queue_index(dev));
+                if (failed(r)) return r.errcode();
+                g_font_upload_cmdbuf = r.get();
+            }
+            return g_font_upload_cmdbuf.get();
+        }
+        static u64 get_font_cache_key(Span<const byte_t> font_data, const ImFontConfig& cfg, const ImFontAtlasCustomRect& dynamic_region)
+        {
+            u64 h = memhash<u64>(font_data.data(), font_data.size());
+            u32 params[] = {
+                FONT_CACHE_VERSION, IMGUI_VERSION_NUM, (u32)cfg.OversampleH, (u32)cfg.OversampleV,
+                (u32)dynamic_region.Width, (u32)dynamic_region.Height
+            };
+            h = memhash<u64>(params, sizeof(params), h);
+            h = memhash<u64>(&cfg.SizePixels, sizeof(f32), h);
+            return memhash<u64>(g_build_ranges.Data, g_build_ranges.size_in_bytes(), h);
+        }
+        static Path get_font_cache_path(u64 key)
+        {
+            c8 buf[32];
+            snprintf(buf, 32, "%016llx", (unsigned long long)key);
+            Path ret = g_font_cache_dir;
+            ret.push_back(buf);
+            return ret;
+        }
+        // Restores the built atlas from the cache file. The atlas must have all fonts and custom rects added,
+        // and is not modified if the cache file cannot be used.
+        static bool read_font_cache_file(const Path& path, u64 key, ImFontAtlas* atlas)
+        {
+            auto file = VFS::map_file(path);
+            if (failed(file)) return false;
+            const byte_t* data = file.get()->get_data();
+            usize size = file.get()->get_size();
+            if (size < sizeof(FontCacheFileHeader)) return false;
+            FontCacheFileHeader header;
+            memcpy(&header, data, sizeof(FontCacheFileHeader));
+            if (header.magic != FONT_CACHE_FILE_MAGIC || header.version != FONT_CACHE_VERSION || header.key != key) return false;
+            if (header.num_custom_rects != (u32)atlas->CustomRects.Size) return false;
+            usize pixels_size = (usize)header.tex_width * (usize)header.tex_height;
+            if (size != sizeof(FontCacheFileHeader) + sizeof(FontCacheRect) * header.num_custom_rects +
+                sizeof(FontCacheGlyph) * header.num_glyphs + pixels_size) return false;
+            const byte_t* cur = data + sizeof(FontCacheFileHeader);
+            for (auto& rect : atlas->CustomRects)
+            {
+                FontCacheRect r;
+                memcpy(&r, cur, sizeof(FontCacheRect));
+                rect.X = r.x;
+                rect.Y = r.y;
+                cur += sizeof(FontCacheRect);
+            }
+            atlas->TexWidth = (int)header.tex_width;
+            atlas->TexHeight = (int)header.tex_height;
+            atlas->TexUvScale = ImVec2(1.0f / atlas->TexWidth, 1.0f / atlas->TexHeight);
+            ImFontConfig& cfg = atlas->ConfigData[0];
+            ImFont* font = cfg.DstFont;
+            ImFontAtlasBuildSetupFont(atlas, font, &cfg, header.ascent, header.descent);
+            for (u32 i = 0; i < header.num_glyphs; ++i)
+            {
+                FontCacheGlyph g;
+                memcpy(&g, cur, sizeof(FontCacheGlyph));
+                // Glyph metrics are stored after config adjustments are applied, so we pass `NULL` here.
+                font->AddGlyph(NULL, (ImWchar)g.codepoint, g.x0, g.y0, g.x1, g.y1, g.u0, g.v0, g.u1, g.v1, g.advance_x);
+                cur += sizeof(FontCacheGlyph);
+            }
+            atlas->TexPixelsAlpha8 = (unsigned char*)IM_ALLOC(pixels_size);
+            memcpy(atlas->TexPixelsAlpha8, cur, pixels_size);
+            // Renders default texture data and builds lookup tables like the font builder does.
+            ImFontAtlasBuildFinish(atlas);
+            return true;
+        }
+        static RV write_font_cache_file(const Path& path, u64 key, ImFontAtlas* atlas)
+        {
+            lutry
+            {
+                ImFont* font = atlas->Fonts[0];
+                FontCacheFileHeader header;
+                header.magic = FONT_CACHE_FILE_MAGIC;
+                header.version = FONT_CACHE_VERSION;
+                header.key = key;
+                header.tex_width = (u32)atlas->TexWidth;
+                header.tex_height = (u32)atlas->TexHeight;
+                header.num_custom_rects = (u32)atlas->CustomRects.Size;
+                header.num_glyphs = (u32)font->Glyphs.Size;
+                header.ascent = font->Ascent;
+                header.descent = font->Descent;
+                usize pixels_size = (usize)header.tex_width * (usize)header.tex_height;
+                Vector<byte_t> data;
+                data.reserve(sizeof(FontCacheFileHeader) + sizeof(FontCacheRect) * header.num_custom_rects +
+                    sizeof(FontCacheGlyph) * header.num_glyphs + pixels_size);
+                StaticBinaryWriter writer(data);
+                writer.write_value(header);
+                for (auto& rect : atlas->CustomRects)
+                {
+                    FontCacheRect r = { rect.X, rect.Y };
+                    writer.write_value(r);
+                }
+                for (auto& glyph : font->Glyphs)
+                {
+                    FontCacheGlyph g = { glyph.Codepoint, glyph.X0, glyph.Y0, glyph.X1, glyph.Y1,
+                        glyph.U0, glyph.V0, glyph.U1, glyph.V1, glyph.AdvanceX };
+                    writer.write_value(g);
+                }
+                writer.write(atlas->TexPixelsAlpha8, pixels_size);
+                auto r = VFS::create_dir(g_font_cache_dir);
+                if (failed(r) && r.errcode() != BasicError::already_exists()) return r.errcode();
+                luexp(VFS::write_file_atomically(path, data.cspan()));
+            }
+            lucatchret;
+            return ok;
+        }
+        RV rebuild_font(f32 render_scale, f32 display_scale)
+        {
+            using namespace RHI;
+            lutry
+            {
+                ImGuiIO& io = ::ImGui::GetIO();
+                ImFontAtlas* atlas = io.Fonts;
+                atlas->Clear();
+                Font::IFontFile* font = g_font_file ? g_font_file.get() : Font::get_default_font();
+                if (!font)
+                {
+                    return set_error(BasicError::not_supported(), "No font is set for ImGui, and the default font is not available.");
+                }
+                if (g_dynamic_region_full)
+                {
+                    // Bakes all glyphs rasterized at run time into the atlas, so that they do not need to be
+                    // rasterized again.
+                    g_baked_glyphs.insert(g_baked_glyphs.end(), Span<const c16>(g_dynamic_glyphs.data(), g_dynamic_glyphs.size()));
+                    g_dynamic_glyphs.clear();
+                    g_dynamic_region_full = false;
+                }
+                {
+                    ImFontGlyphRangesBuilder builder;
+                    if (g_font_ranges.empty())
+                    {
+                        builder.AddRanges(atlas->GetGlyphRangesDefault());
+                    }
+                    for (auto& range : g_font_ranges)
+                    {
+                        ImWchar r[3] = { (ImWchar)range.first, (ImWchar)range.second, 0 };
+                        builder.AddRanges(r);
+                    }
+                    for (c16 ch : g_baked_glyphs)
+                    {
+                        builder.AddChar((ImWchar)ch);
+                    }
+                    g_build_ranges.clear();
+                    builder.BuildRanges(&g_build_ranges);
+                }
+                usize font_size = font->get_data().size();
+                void* font_data = ImGui::MemAlloc(font_size);
+                memcpy(font_data, font->get_data().data(), font_size);
+                atlas->AddFontFromMemoryTTF(font_data, (int)font_size, g_font_size * render_scale, NULL, g_build_ranges.Data);
+                u32 region_height = min((u32)(DYNAMIC_GLYPH_REGION_HEIGHT * max(render_scale, 1.0f)), DYNAMIC_GLYPH_REGION_MAX_HEIGHT);
+                g_dynamic_region = atlas->AddCustomRectRegular((int)DYNAMIC_GLYPH_REGION_WIDTH, (int)region_height);
+                // Registers default custom rects and rounds font sizes, so that the atlas state matches the cached atlas.
+                ImFontAtlasBuildInit(atlas);
+                bool cache_hit = false;
+                u64 key = 0;
+                if (!g_font_cache_dir.empty())
+                {
+                    key = get_font_cache_key(font->get_data(), atlas->ConfigData[0], *atlas->GetCustomRectByIndex(g_dynamic_region));
+                    cache_hit = read_font_cache_file(get_font_cache_path(key), key, atlas);
+                }
+                if (!cache_hit)
+                {
+                    atlas->Build();
+                    if (!g_font_cache_dir.empty())
+                    {
+                        // Failing to write the cache only makes the next launch slower.
+                        auto _ = write_font_cache_file(get_font_cache_path(key), key, atlas);
+                    }
+                }
+                unsigned char* pixels;
+                int width, height;
+                atlas->GetTexDataAsRGBA32(&pixels, &width, &height);
+                io.FontGlobalScale = display_scale;
+                auto dev = get_main_device();
+                luset(g_font_tex, dev->new_texture(MemoryType::local, TextureDesc::tex2d(Format::rgba8_unorm,
+                    TextureUsageFlag::read_texture | TextureUsageFlag::copy_dest, width, height, 1, 1)));
+                u32 src_row_pitch = (u32)width * 4;
+                {
+                    lulet(upload_cmdbuf, get_font_upload_command_buffer(dev));
+                    luexp(copy_resource_data(upload_cmdbuf, {CopyResourceData::write_texture(g_font_tex, SubresourceIndex(0, 0), 0, 0, 0,
+                        pixels, src_row_pitch, src_row_pitch * height, width, height, 1)}));
+                }
+                atlas->TexID = (ITexture*)(g_font_tex);
+                // Rasterizes glyphs of the previous atlas to the new dynamic region.
+                g_dynamic_cursor_x = 0;
+                g_dynamic_cursor_y = 0;
+                g_dynamic_row_height = 0;
+                g_dynamic_glyph_uploads.clear();
+                Vector<c16> dynamic_glyphs = move(g_dynamic_glyphs);
+                g_dynamic_glyphs.clear();
+                bool glyph_added = false;
+                for (c16 ch : dynamic_glyphs)
+                {
+                    glyph_added |= add_dynamic_glyph(ch);
+                }
+                if (glyph_added)
+                {
+                    update_font_lookup_table();
+                    luexp(upload_dynamic_glyphs(dev));
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        bool is_font_rebuild_required()
+        {
+            return !g_font_tex || g_dynamic_region_full;
+        }
+        bool add_dynamic_glyph(c32 codepoint)
+        {
+            ImFontAtlas* atlas = ::ImGui::GetIO().Fonts;
+            // ImWchar is 16-bit, so glyphs out of the BMP cannot be displayed.
+            if (!g_font_tex || atlas->Fonts.empty() || codepoint > 0xFFFF || g_dynamic_region_full) return false;
+            c16 ch = (c16)codepoint;
+            ImFont* font = atlas->Fonts[0];
+            if (font->FindGlyphNoFallback((ImWchar)ch) || g_missing_glyphs.contains(ch)) return false;
+            Font::IFontFile* file = g_font_file ? g_font_file.get() : Font::get_default_font();
+            if (!file) return false;
+            Font::glyph_t glyph = file->find_glyph(0, ch);
+            if (glyph == Font::INVALID_GLYPH)
+            {
+                g_missing_glyphs.insert(ch);
+                return false;
+            }
+            const ImFontConfig& cfg = *font->ConfigData;
+            f32 scale = file->scale_for_pixel_height(0, cfg.SizePixels);
+            RectI box = file->get_glyph_bitmap_box(0, glyph, scale, scale, 0.0f, 0.0f);
+            u32 width = (u32)box.width;
+            u32 height = (u32)box.height;
+            u32 padding = (u32)atlas->TexGlyphPadding;
+            const ImFontAtlasCustomRect* region = atlas->GetCustomRectByIndex(g_dynamic_region);
+            if (g_dynamic_cursor_x + width + padding > region->Width)
+            {
+                g_dynamic_cursor_x = 0;
+                g_dynamic_cursor_y += g_dynamic_row_height;
+                g_dynamic_row_height = 0;
+            }
+            if (width + padding > region->Width || g_dynamic_cursor_y + height + padding > region->Height)
+            {
+                // The atlas is rebuilt with all dynamic glyphs baked before the next frame.
+                g_dynamic_glyphs.push_back(ch);
+                g_dynamic_region_full = true;
+                return false;
+            }
+            u32 x = region->X + g_dynamic_cursor_x;
+            u32 y = region->Y + g_dynamic_cursor_y;
+            g_dynamic_cursor_x += width + padding;
+            g_dynamic_row_height = max(g_dynamic_row_height, height + padding);
+            if (width && height)
+            {
+                Vector<u8> bitmap(width * height, 0);
+                file->render_glyph_bitmap(0, glyph, bitmap.data(), (i32)width, (i32)height, (i32)width, scale, scale, 0.0f, 0.0f);
+                DynamicGlyphUpload upload;
+                upload.x = x;
+                upload.y = y;
+                upload.width = width;
+                upload.height = height;
+                upload.pixels.resize(width * height);
+                for (u32 i = 0; i < width * height; ++i)
+                {
+                    upload.pixels[i] = IM_COL32(255, 255, 255, (u32)bitmap[i]);
+                }
+                // Keeps CPU-side atlas data consistent with the texture.
+                for (u32 row = 0; row < height; ++row)
+                {
+                    usize dst_offset = (usize)(y + row) * atlas->TexWidth + x;
+                    if (atlas->TexPixelsAlpha8) memcpy(atlas->TexPixelsAlpha8 + dst_offset, bitmap.data() + row * width, width);
+                    if (atlas->TexPixelsRGBA32) memcpy(atlas->TexPixelsRGBA32 + dst_offset, upload.pixels.data() + row * width, width * sizeof(u32));
+                }
+                g_dynamic_glyph_uploads.push_back(move(upload));
+            }
+            i32 advance_width, left_side_bearing;
+            file->get_glyph_hmetrics(0, glyph, &advance_width, &left_side_bearing);
+            // Matches the glyph placement of the font builder.
+            f32 x0 = (f32)box.offset_x + cfg.GlyphOffset.x;
+            f32 y0 = (f32)box.offset_y + cfg.GlyphOffset.y + IM_ROUND(font->Ascent);
+            // The tab glyph is appended by ImFont::BuildLookupTable if it is not the last glyph, so we remove it
+            // to prevent duplicated tab glyphs.
+            if (!font->Glyphs.empty() && font->Glyphs.back().Codepoint == '\t')
+            {
+                font->Glyphs.pop_back();
+            }
+            font->AddGlyph(&cfg, (ImWchar)ch, x0, y0, x0 + (f32)width, y0 + (f32)height,
+                x * atlas->TexUvScale.x, y * atlas->TexUvScale.y, (x + width) * atlas->TexUvScale.x, (y + height) * atlas->TexUvScale.y,
+                (f32)advance_width * scale);
+            g_dynamic_glyphs.push_back(ch);
+            return true;
+        }
+        void update_font_lookup_table()
+        {
+            ImFontAtlas* atlas = ::ImGui::GetIO().Fonts;
+            for (ImFont* font : atlas->Fonts)
+            {
+                if (font->DirtyLookupTables) font->BuildLookupTable();
+            }
+        }
+        RV upload_dynamic_glyphs(RHI::IDevice* device)
+        {
+            using namespace RHI;
+            if (g_dynamic_glyph_uploads.empty() || !g_font_tex) return ok;
+            lutry
+            {
+                Vector<CopyResourceData> copies;
+                copies.reserve(g_dynamic_glyph_uploads.size());
+                for (auto& upload : g_dynamic_glyph_uploads)
+                {
+                    u32 row_pitch = upload.width * sizeof(u32);
+                    copies.push_back(CopyResourceData::write_texture(g_font_tex, SubresourceIndex(0, 0), upload.x, upload.y, 0,
+                        upload.pixels.data(), row_pitch, row_pitch * upload.height, upload.width, upload.height, 1));
+                }
+                lulet(upload_cmdbuf, get_font_upload_command_buffer(device));
+                luexp(copy_resource_data(upload_cmdbuf, { copies.data(), copies.size() }));
+                g_dynamic_glyph_uploads.clear();
+            }
+            lucatchret;
+            return ok;
+        }
+        void close_font()
+        {
+            g_font_file = nullptr;
+            g_font_tex = nullptr;
+            g_font_upload_cmdbuf = nullptr;
+            g_font_ranges.clear();
+            g_font_ranges.shrink_to_fit();
+            g_font_cache_dir = Path();
+            g_build_ranges.clear();
+            g_baked_glyphs.clear();
+            g_baked_glyphs.shrink_to_fit();
+            g_dynamic_glyphs.clear();
+            g_dynamic_glyphs.shrink_to_fit();
+            g_missing_glyphs.clear();
+            g_missing_glyphs.shrink_to_fit();
+            g_dynamic_glyph_uploads.clear();
+            g_dynamic_glyph_uploads.shrink_to_fit();
+            g_dynamic_region_full = false;
+        }
+        LUNA_IMGUI_API RV set_font(Font::IFontFile* font, f32 font_size, Span<Pair<c16, c16>> ranges)
+        {
+            g_font_file = font;
+            g_font_size = font_size;
+            g_font_ranges.assign(ranges);
+            // Glyphs of the old font are not reused.
+            g_baked_glyphs.clear();
+            g_dynamic_glyphs.clear();
+            g_missing_glyphs.clear();
+            g_dynamic_region_full = false;
+            if(!g_active_window)
+            {
+                return rebuild_font(1.0f, 1.0f);
+            }
+            else
+            {
+                auto sz = g_active_window->get_size();
+                auto fb_sz = g_active_window->get_framebuffer_size();
+                f32 display_scale = (f32)sz.x / (f32)fb_sz.x;
+                return rebuild_font(g_active_window->get_dpi_scale_factor(), display_scale);
+            }
+        }
+        LUNA_IMGUI_API void set_font_cache_dir(const Path& dir)
+        {
+            g_font_cache_dir = dir;
+        }
+        LUNA_IMGUI_API void request_glyphs(const c8* text, usize text_len)
+        {
+            if (text_len == USIZE_MAX) text_len = strlen(text);
+            bool glyph_added = false;
+            usize i = 0;
+            while (i < text_len)
+            {
+                c32 ch = utf8_decode_char(text + i);
+                i += utf8_charlen(text + i);
+                if (ch >= 0x80) glyph_added |= add_dynamic_glyph(ch);
+            }
+            if (glyph_added) update_font_lookup_table();
+        }
+    }
+}
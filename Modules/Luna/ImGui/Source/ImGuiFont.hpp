@@ -0,0 +1,39 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file ImGuiFont.hpp
+* @author JXMaster
+* @date 2024/4/22
+*/
+#pragma once
+#include "../ImGui.hpp"
+
+namespace Luna
+{
+    namespace ImGuiUtils
+    {
+        extern Ref<Window::IWindow> g_active_window;
+        extern Ref<RHI::ITexture> g_font_tex;
+        extern Ref<Font::IFontFile> g_font_file;
+
+        // Rebuilds the font atlas and the font texture. The atlas is loaded from the font cache directory if possible.
+        RV rebuild_font(f32 render_scale, f32 display_scale);
+
+        // Checks whether the font atlas should be rebuilt before the next frame.
+        bool is_font_rebuild_required();
+
+        // Rasterizes the specified glyph to the dynamic region of the font atlas if the glyph is not in the atlas.
+        // Returns `true` if one new glyph is added to the font.
+        bool add_dynamic_glyph(c32 codepoint);
+
+        // Rebuilds the glyph lookup table of the font, this should be called after new glyphs are added.
+        void update_font_lookup_table();
+
+        // Copies glyphs rasterized after the last call to the font texture.
+        RV upload_dynamic_glyphs(RHI::IDevice* device);
+
+        void close_font();
+    }
+}
@@ -13,6 +13,7 @@
 #include <Luna/Runtime/Result.hpp>
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/HashMap.hpp>
 #include <Luna/HID/HID.hpp>
 #include <Luna/HID/Keyboard.hpp>
 #include <Luna/HID/Mouse.hpp>
@@ -20,6 +21,8 @@
 #include <Luna/Font/Font.hpp>
 #include <Luna/RHI/ShaderCompileHelper.hpp>
 #include <Luna/RHI/Utility.hpp>
+#include <Luna/VFS/VFS.hpp>
+#include "ImGuiFont.hpp"
 namespace Luna
 {
     template<>
@@ -38,10 +41,8 @@ namespace Luna
         Ref<Window::IWindow> g_active_window;
         u64 g_time;
 
-        Ref<RHI::IBuffer> g_vb;
-        Ref<RHI::IBuffer> g_ib;
-        usize g_vb_size;
-        usize g_ib_size;
+        //! Allocates vertex and index data every frame.
+        Ref<RHI::IUploadRingBuffer> g_upload_ring;
 
         ShaderCompiler::ShaderCompileResult g_vs_blob;
         ShaderCompiler::ShaderCompileResult g_ps_blob;
@@ -50,12 +51,25 @@ namespace Luna
         Ref<RHI::IPipelineLayout> g_playout;
         HashMap<RHI::Format, Ref<RHI::IPipelineState>> g_pso;
 
-        //! Expand when not enough.
-        Vector<Ref<RHI::IDescriptorSet>> g_desc_sets;
+        //! The descriptor set of one texture. Descriptor sets are written once when being created and reused
+        //! in succeeding frames.
+        struct TextureDescriptorSet
+        {
+            Ref<RHI::ITexture> texture;
+            Ref<RHI::IDescriptorSet> desc_set;
+            u64 last_used_frame;
+        };
+        HashMap<RHI::ITexture*, TextureDescriptorSet> g_texture_desc_sets;
+        //! Descriptor sets of textures that are not used in this number of frames are released.
+        //! This must be greater than the number of frames that may be processed by GPU at the same time.
+        constexpr u64 TEXTURE_DESC_SET_RELEASE_FRAMES = 8;
+        u64 g_frame_index = 0;
 
-        Ref<RHI::IBuffer> g_cb;
+        //! Per-frame arrays, kept between frames to avoid allocations.
+        Vector<RHI::TextureBarrier> g_texture_barriers;
+        Vector<RHI::IDescriptorSet*> g_draw_desc_sets;
 
-        Ref<RHI::ITexture> g_font_tex;
+        Ref<RHI::IBuffer> g_cb;
 
         const c8 IMGUI_VS_SOURCE[] = R"(
 cbuffer vertexBuffer : register(b0) 
@@ -148,9 +162,6 @@ float4 main(PS_INPUT input) : SV_Target
 
             g_time = get_ticks();
 
-            g_vb_size = 0;
-            g_ib_size = 0;
-
             io.BackendRendererName = "imgui_impl_luna_rhi";
             io.BackendFlags |= ImGuiBackendFlags_RendererHasVtxOffset;  // We can honor the ImDrawCmd::VtxOffset field, allowing for large meshes.
             io.BackendFlags |= ImGuiBackendFlags_RendererHasViewports;  // We can create multi-viewports on the Renderer side (optional)
@@ -191,6 +202,9 @@ float4 main(PS_INPUT input) : SV_Target
                     },
                     PipelineLayoutFlag::allow_input_assembler_input_layout)));
 
+                // Create upload ring buffer for vertex and index data.
+                luset(g_upload_ring, dev->new_upload_ring_buffer(UploadRingBufferDesc(1024 * 1024, 2, BufferUsageFlag::vertex_buffer | BufferUsageFlag::index_buffer)));
+
                 // Create constant buffer.
                 usize buffer_size_align = dev->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
                 luset(g_cb, dev->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::uniform_buffer, align_upper(sizeof(Float4x4), buffer_size_align))));
@@ -200,86 +214,6 @@ float4 main(PS_INPUT input) : SV_Target
             return ok;
         }
 
-        static RV rebuild_font(Font::IFontFile* font, f32 render_scale, f32 display_scale, Span<Pair<c16, c16>> ranges = {})
-        {
-            using namespace RHI;
-            lutry
-            {
-                ImGuiIO& io = ::ImGui::GetIO();
-                unsigned char* pixels;
-                int width, height;
-                io.Fonts->Clear();
-                if(!font)
-                {
-                    font = Font::get_default_font();
-                }
-                ImVector<ImWchar> build_ranges;
-                if(!ranges.empty())
-                {
-                    ImFontGlyphRangesBuilder builder;
-                    for(auto& range : ranges)
-                    {
-                        ImWchar r[4] = {(ImWchar)range.first, (ImWchar)range.second, 0, 0};
-                        builder.AddRanges(r);
-                    }
-                    builder.BuildRanges(&build_ranges);
-                }
-                usize font_size = font->get_data().size();
-                void* font_data = ImGui::MemAlloc(font_size);
-                memcpy(font_data, font->get_data().data(), font_size);
-                io.Fonts->AddFontFromMemoryTTF(const_cast<void*>(font_data), (int)font_size, 18.0f * render_scale, NULL, build_ranges.empty() ? NULL : build_ranges.Data);
-                io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height);
-                io.FontGlobalScale = display_scale;
-                auto dev = get_main_device();
-                luset(g_font_tex, dev->new_texture(MemoryType::local, TextureDesc::tex2d(Format::rgba8_unorm,
-                    TextureUsageFlag::read_texture | TextureUsageFlag::copy_dest, width, height, 1, 1)));
-                u32 src_row_pitch = (u32)width * 4;
-                {
-                    u32 copy_queue_index = U32_MAX;
-                    {
-                        // Prefer a dedicated copy queue if present.
-                        u32 num_queues = dev->get_num_command_queues();
-                        for (u32 i = 0; i < num_queues; ++i)
-                        {
-                            auto desc = dev->get_command_queue_desc(i);
-                            if (desc.type == CommandQueueType::graphics && copy_queue_index == U32_MAX)
-                            {
-                                copy_queue_index = i;
-                            }
-                            else if (desc.type == CommandQueueType::copy)
-                            {
-                                copy_queue_index = i;
-                                break;
-                            }
-                        }
-                    }
-                    lulet(upload_cmdbuf, dev->new_command_buffer(copy_queue_index));
-                    luexp(copy_resource_data(upload_cmdbuf, {CopyResourceData::write_texture(g_font_tex, SubresourceIndex(0, 0), 0, 0, 0, 
-                        pixels, src_row_pitch, src_row_pitch * height, width, height, 1)}));
-                }
-                io.Fonts->TexID = (ITexture*)(g_font_tex);
-            }
-            lucatchret;
-            return ok;
-        }
-
-        Ref<Font::IFontFile> g_font_file;
-
-        LUNA_IMGUI_API RV set_font(Font::IFontFile* font, f32 font_size, Span<Pair<c16, c16>> ranges)
-        {
-            g_font_file = font;
-            if(!g_active_window)
-            {
-                return rebuild_font(g_font_file, 1.0f, 1.0f, ranges);
-            }
-            else
-            {
-                auto sz = g_active_window->get_size();
-                auto fb_sz = g_active_window->get_framebuffer_size();
-                f32 display_scale = (f32)sz.x / (f32)fb_sz.x;
-                return rebuild_font(g_font_file, g_active_window->get_dpi_scale_factor(), display_scale, ranges);
-            }
-        }
         LUNA_IMGUI_API Vector<Pair<c16, c16>> get_glyph_ranges_default()
         {
             ImGuiIO& io = ::ImGui::GetIO();
@@ -391,9 +325,8 @@ float4 main(PS_INPUT input) : SV_Target
         static void close()
         {
             ImGui::DestroyContext();
-            g_font_file = nullptr;
-            g_vb = nullptr;
-            g_ib = nullptr;
+            close_font();
+            g_upload_ring = nullptr;
             g_vs_blob.data.clear();
             g_vs_blob.entry_point.reset();
             g_ps_blob.data.clear();
@@ -403,10 +336,13 @@ float4 main(PS_INPUT input) : SV_Target
             g_pso.clear();
             g_pso.shrink_to_fit();
             g_cb = nullptr;
-            g_font_tex = nullptr;
             g_desc_layout = nullptr;
-            g_desc_sets.clear();
-            g_desc_sets.shrink_to_fit();
+            g_texture_desc_sets.clear();
+            g_texture_desc_sets.shrink_to_fit();
+            g_texture_barriers.clear();
+            g_texture_barriers.shrink_to_fit();
+            g_draw_desc_sets.clear();
+            g_draw_desc_sets.shrink_to_fit();
         }
 
         inline ImGuiKey hid_key_to_imgui_key(HID::KeyCode key)
@@ -622,6 +558,11 @@ float4 main(PS_INPUT input) : SV_Target
         {
             ImGuiIO& io = ImGui::GetIO();
             io.AddInputCharacterUTF16((c16)character);
+            // Makes sure that characters entered by the user can be displayed.
+            if (add_dynamic_glyph(character))
+            {
+                update_font_lookup_table();
+            }
         }
 
         static void handle_dpi_changed(Window::IWindow* window, f32 dpi_scale)
@@ -629,7 +570,7 @@ float4 main(PS_INPUT input) : SV_Target
             auto sz = window->get_size();
             auto fb_sz = window->get_framebuffer_size();
             f32 display_scale = (f32)sz.x / (f32)fb_sz.x;
-            auto _ = rebuild_font(g_font_file, dpi_scale, display_scale);
+            auto _ = rebuild_font(dpi_scale, display_scale);
         }
 
         usize g_handle_mouse_move;
@@ -719,18 +660,19 @@ float4 main(PS_INPUT input) : SV_Target
             // Update OS mouse position
             update_hid_mouse();
 
-            if (!g_font_tex)
+            // The font atlas is also rebuilt if the dynamic glyph region of the atlas is full.
+            if (is_font_rebuild_required())
             {
                 if (g_active_window)
                 {
                     auto sz = g_active_window->get_size();
                     auto fb_sz = g_active_window->get_framebuffer_size();
                     f32 display_scale = (f32)sz.x / (f32)fb_sz.x;
-                    auto _ = rebuild_font(g_font_file, g_active_window->get_dpi_scale_factor(), display_scale);
+                    auto _ = rebuild_font(g_active_window->get_dpi_scale_factor(), display_scale);
                 }
                 else
                 {
-                    auto _ = rebuild_font(g_font_file, 1.0f, 1.0f);
+                    auto _ = rebuild_font(1.0f, 1.0f);
                 }
             }
         }
@@ -771,6 +713,42 @@ float4 main(PS_INPUT input) : SV_Target
             return iter->second.get();
         }
 
+        static R<TextureDescriptorSet*> get_texture_desc_set(RHI::IDevice* dev, RHI::ITexture* tex)
+        {
+            using namespace RHI;
+            auto iter = g_texture_desc_sets.find(tex);
+            if (iter != g_texture_desc_sets.end()) return &iter->second;
+            TextureDescriptorSet entry;
+            lutry
+            {
+                entry.texture = tex;
+                luset(entry.desc_set, dev->new_descriptor_set(DescriptorSetDesc(g_desc_layout)));
+                luexp(entry.desc_set->update_descriptors({
+                    WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(g_cb)),
+                    WriteDescriptorSet::read_texture_view(1, TextureViewDesc::tex2d(tex)),
+                    WriteDescriptorSet::sampler(2, SamplerDesc(Filter::linear, Filter::linear, Filter::linear, TextureAddressMode::clamp, TextureAddressMode::clamp, TextureAddressMode::clamp))
+                }));
+                entry.last_used_frame = U64_MAX;
+            }
+            lucatchret;
+            return &g_texture_desc_sets.insert(make_pair(tex, move(entry))).first->second;
+        }
+
+        static void release_unused_texture_desc_sets()
+        {
+            for (auto iter = g_texture_desc_sets.begin(); iter != g_texture_desc_sets.end();)
+            {
+                if (iter->second.last_used_frame + TEXTURE_DESC_SET_RELEASE_FRAMES < g_frame_index)
+                {
+                    iter = g_texture_desc_sets.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+        }
+
         LUNA_IMGUI_API RV render_draw_data(ImDrawData* draw_data, RHI::ICommandBuffer* cmd_buffer, RHI::ITexture* render_target)
         {
             using namespace RHI;
@@ -784,25 +762,18 @@ float4 main(PS_INPUT input) : SV_Target
                     return ok;
                 draw_data->ScaleClipRects(io.DisplayFramebufferScale);
                 
-                // Create and grow vertex/index buffers if needed
                 auto dev = cmd_buffer->get_device();
-                if (!g_vb || g_vb_size < (u32)draw_data->TotalVtxCount)
-                {
-                    g_vb_size = draw_data->TotalVtxCount + 5000;
-                    luset(g_vb, dev->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::vertex_buffer, g_vb_size * sizeof(ImDrawVert))));
-                }
-                if (!g_ib || g_ib_size < (u32)draw_data->TotalIdxCount)
-                {
-                    g_ib_size = draw_data->TotalIdxCount + 10000;
-                    luset(g_ib, dev->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::index_buffer, g_ib_size * sizeof(ImDrawIdx))));
-                }
+                // Copies glyphs rasterized in this frame to the font texture.
+                luexp(upload_dynamic_glyphs(dev));
+                // Allocate vertex/index buffers from the upload ring.
+                g_upload_ring->begin_frame();
+                u64 vb_size = max<u64>(draw_data->TotalVtxCount, 1) * sizeof(ImDrawVert);
+                u64 ib_size = max<u64>(draw_data->TotalIdxCount, 1) * sizeof(ImDrawIdx);
+                lulet(vb, g_upload_ring->allocate(vb_size, sizeof(ImDrawVert)));
+                lulet(ib, g_upload_ring->allocate(ib_size, sizeof(u32)));
                 // Upload vertex/index data into a single contiguous GPU buffer
-                ImDrawVert* vtx_resource = nullptr;
-                ImDrawIdx* idx_resource = nullptr;
-                luexp(g_vb->map(0, 0, (void**)&vtx_resource));
-                luexp(g_ib->map(0, 0, (void**)&idx_resource));
-                ImDrawVert* vtx_dst = vtx_resource;
-                ImDrawIdx* idx_dst = idx_resource;
+                ImDrawVert* vtx_dst = (ImDrawVert*)vb.data;
+                ImDrawIdx* idx_dst = (ImDrawIdx*)ib.data;
                 for (i32 n = 0; n < draw_data->CmdListsCount; ++n)
                 {
                     const ImDrawList* cmd_list = draw_data->CmdLists[n];
@@ -811,8 +782,6 @@ float4 main(PS_INPUT input) : SV_Target
                     vtx_dst += cmd_list->VtxBuffer.Size;
                     idx_dst += cmd_list->IdxBuffer.Size;
                 }
-                g_vb->unmap(0, (usize)vtx_dst - (usize)vtx_resource);
-                g_ib->unmap(0, (usize)idx_dst - (usize)idx_resource);
                 auto rt_desc = render_target->get_desc();
 
                 // Setup orthographic projection matrix into our constant buffer
@@ -836,29 +805,40 @@ float4 main(PS_INPUT input) : SV_Target
                     g_cb->unmap(0, sizeof(Float4x4));
                 }
 
-                Vector<TextureBarrier> barriers;
-                barriers.push_back({ render_target, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::color_attachment_write, ResourceBarrierFlag::none });
+                // Resolves descriptor sets for all draw commands, and emits one barrier for every texture used in this frame.
+                ++g_frame_index;
+                g_texture_barriers.clear();
+                g_draw_desc_sets.clear();
+                g_texture_barriers.push_back({ render_target, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::color_attachment_write, ResourceBarrierFlag::none });
                 for (i32 n = 0; n < draw_data->CmdListsCount; ++n)
                 {
                     const ImDrawList* cmd_list = draw_data->CmdLists[n];
                     for (i32 cmd_i = 0; cmd_i < cmd_list->CmdBuffer.Size; ++cmd_i)
                     {
                         const ImDrawCmd* pcmd = &cmd_list->CmdBuffer[cmd_i];
-                        barriers.push_back({ (ITexture*)pcmd->TextureId, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none });
+                        if (pcmd->UserCallback) continue;
+                        lulet(entry, get_texture_desc_set(dev, (ITexture*)pcmd->TextureId));
+                        if (entry->last_used_frame != g_frame_index)
+                        {
+                            entry->last_used_frame = g_frame_index;
+                            g_texture_barriers.push_back({ entry->texture, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none });
+                        }
+                        g_draw_desc_sets.push_back(entry->desc_set);
                     }
                 }
+                release_unused_texture_desc_sets();
                 cmd_buffer->begin_event("ImGui");
                 cmd_buffer->resource_barrier({},
-                    { barriers.data(), barriers.size() });
+                    { g_texture_barriers.data(), g_texture_barriers.size() });
 
                 RenderPassDesc desc;
                 desc.color_attachments[0] = ColorAttachment(render_target, LoadOp::load, StoreOp::store);
                 cmd_buffer->begin_render_pass(desc);
 
                 cmd_buffer->set_viewport(Viewport(0.0f, 0.0f, fb_width, fb_height, 0.0f, 1.0f));
-                VertexBufferView vbv = VertexBufferView(g_vb, 0, (u32)(g_vb_size * sizeof(ImDrawVert)), sizeof(ImDrawVert));
+                VertexBufferView vbv = VertexBufferView(vb.buffer, vb.offset, (u32)vb.size, sizeof(ImDrawVert));
                 cmd_buffer->set_vertex_buffers(0, { &vbv, 1 });
-                cmd_buffer->set_index_buffer({g_ib, 0, (u32)(g_ib_size * sizeof(ImDrawIdx)), sizeof(ImDrawIdx) == 2 ? Format::r16_uint : Format::r32_uint});
+                cmd_buffer->set_index_buffer({ib.buffer, ib.offset, (u32)ib.size, sizeof(ImDrawIdx) == 2 ? Format::r16_uint : Format::r32_uint});
                 lulet(pso, get_pso(rt_desc.format));
                 cmd_buffer->set_graphics_pipeline_state(pso);
                 cmd_buffer->set_graphics_pipeline_layout(g_playout);
@@ -870,6 +850,7 @@ float4 main(PS_INPUT input) : SV_Target
                 Float2 clip_off = { draw_data->DisplayPos.x, draw_data->DisplayPos.y };
 
                 u32 num_draw_calls = 0;
+                IDescriptorSet* bound_desc_set = nullptr;
 
                 for (i32 n = 0; n < draw_data->CmdListsCount; ++n)
                 {
@@ -880,6 +861,8 @@ float4 main(PS_INPUT input) : SV_Target
                         if (pcmd->UserCallback)
                         {
                             pcmd->UserCallback(cmd_list, pcmd);
+                            // The callback may bind its own descriptor sets.
+                            bound_desc_set = nullptr;
                         }
                         else
                         {
@@ -892,19 +875,13 @@ float4 main(PS_INPUT input) : SV_Target
                                 (i32)(clip_min.y),
                                 (i32)(clip_max.x - clip_min.x),
                                 (i32)(clip_max.y - clip_min.y) };
-                            while (g_desc_sets.size() <= num_draw_calls)
+                            // Descriptor sets are bound only when the texture changes.
+                            IDescriptorSet* vs = g_draw_desc_sets[num_draw_calls];
+                            if (vs != bound_desc_set)
                             {
-                                lulet(new_vs, dev->new_descriptor_set(DescriptorSetDesc(g_desc_layout)));
-                                g_desc_sets.push_back(new_vs);
+                                cmd_buffer->set_graphics_descriptor_sets(0, { &vs, 1 });
+                                bound_desc_set = vs;
                             }
-                            IDescriptorSet* vs = g_desc_sets[num_draw_calls];
-                            usize cb_align = dev->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
-                            luexp(vs->update_descriptors({
-                                WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(g_cb)),
-                                WriteDescriptorSet::read_texture_view(1, TextureViewDesc::tex2d((ITexture*)pcmd->TextureId)),
-                                WriteDescriptorSet::sampler(2, SamplerDesc(Filter::linear, Filter::linear, Filter::linear, TextureAddressMode::clamp, TextureAddressMode::clamp, TextureAddressMode::clamp))
-                                }));
-                            cmd_buffer->set_graphics_descriptor_sets(0, { &vs, 1 });
                             cmd_buffer->set_scissor_rect(r);
                             cmd_buffer->draw_indexed(pcmd->ElemCount, pcmd->IdxOffset + idx_offset, pcmd->VtxOffset + vtx_offset);
                             ++num_draw_calls;
@@ -926,7 +903,7 @@ float4 main(PS_INPUT input) : SV_Target
             virtual const c8* get_name() override { return "ImGui"; }
             virtual RV on_register() override
             {
-                return add_dependency_modules(this, {module_rhi(), module_hid(), module_font(), module_shader_compiler(), module_window()} );
+                return add_dependency_modules(this, {module_rhi(), module_hid(), module_font(), module_shader_compiler(), module_window(), module_vfs()} );
             }
             virtual RV on_init() override
             {
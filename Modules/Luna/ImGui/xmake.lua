@@ -5,5 +5,5 @@ luna_sdk_module_target("ImGui")
     add_files("Source/**.cpp")
     add_includedirs(".")
     add_defines("LUNA_IMGUI_IMPL")
-    add_deps("Window", "Runtime", "RHI", "HID", "Font", "ShaderCompiler")
+    add_deps("Window", "Runtime", "RHI", "HID", "Font", "ShaderCompiler", "VFS")
 target_end()
@@ -0,0 +1,81 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BlockCompression.hpp
+* @author JXMaster
+* @date 2024/4/16
+* @brief Block compression encoders for DDS images.
+*/
+#pragma once
+#include "DDSImage.hpp"
+
+namespace Luna
+{
+    namespace Image
+    {
+        //! @addtogroup Image
+        //! @{
+
+        //! Checks whether the specified format can be used as the destination format of block compression.
+        //! @param[in] format The format to check.
+        //! @return Returns `true` if pixels can be compressed to the specified format by @ref compress_blocks,
+        //! returns `false` otherwise.
+        //! @details The following formats are supported:
+        //! * @ref DDSFormat::bc1_typeless, @ref DDSFormat::bc1_unorm, @ref DDSFormat::bc1_unorm_srgb
+        //! * @ref DDSFormat::bc3_typeless, @ref DDSFormat::bc3_unorm, @ref DDSFormat::bc3_unorm_srgb
+        //! * @ref DDSFormat::bc4_typeless, @ref DDSFormat::bc4_unorm
+        //! * @ref DDSFormat::bc5_typeless, @ref DDSFormat::bc5_unorm
+        //! * @ref DDSFormat::bc7_typeless, @ref DDSFormat::bc7_unorm, @ref DDSFormat::bc7_unorm_srgb
+        inline bool is_block_compression_supported(DDSFormat format)
+        {
+            switch(format)
+            {
+            case DDSFormat::bc1_typeless:
+            case DDSFormat::bc1_unorm:
+            case DDSFormat::bc1_unorm_srgb:
+            case DDSFormat::bc3_typeless:
+            case DDSFormat::bc3_unorm:
+            case DDSFormat::bc3_unorm_srgb:
+            case DDSFormat::bc4_typeless:
+            case DDSFormat::bc4_unorm:
+            case DDSFormat::bc5_typeless:
+            case DDSFormat::bc5_unorm:
+            case DDSFormat::bc7_typeless:
+            case DDSFormat::bc7_unorm:
+            case DDSFormat::bc7_unorm_srgb:
+                return true;
+            default:
+                return false;
+            }
+        }
+
+        //! Compresses one region of RGBA8 pixels to block-compressed data.
+        //! @param[in] format The block-compressed format to compress to. The format must be supported by @ref is_block_compression_supported.
+        //! @param[in] src The source pixels. Every pixel is stored as four 8-bit unsigned normalized components in RGBA order.
+        //! @param[in] src_row_pitch The number of bytes to advance between every two rows of source pixels.
+        //! @param[in] width The width of the region in pixels.
+        //! @param[in] height The height of the region in pixels.
+        //! @param[out] dst The buffer to write compressed blocks to. The buffer must be large enough to hold `(width + 3) / 4` blocks
+        //! for every `(height + 3) / 4` block rows.
+        //! @param[in] dst_row_pitch The number of bytes to advance between every two rows of blocks in `dst`.
+        //! @details Pixels outside of the region are clamped to the nearest edge pixel when filling partial blocks.
+        //!
+        //! Every block row is encoded independently, so one region can be split to multiple regions at 4-pixel row boundaries
+        //! and compressed on multiple threads in parallel.
+        //! @par Valid Usage
+        //! * `format` must be supported by @ref is_block_compression_supported.
+        LUNA_IMAGE_API RV compress_blocks(DDSFormat format, const void* src, usize src_row_pitch, u32 width, u32 height, void* dst, usize dst_row_pitch);
+
+        //! Compresses all subresources of one DDS image.
+        //! @param[in] src The image to compress. The format of the image must be @ref DDSFormat::r8g8b8a8_unorm or
+        //! @ref DDSFormat::r8g8b8a8_unorm_srgb.
+        //! @param[in] dst_format The block-compressed format to compress to.
+        //! @return Returns the compressed image, which has the same dimension, size, array size and mip levels as `src`.
+        //! Returns @ref BasicError::not_supported if the format of `src` or `dst_format` is not supported.
+        LUNA_IMAGE_API R<DDSImage> compress_dds_image(const DDSImage& src, DDSFormat dst_format);
+
+        //! @}
+    }
+}
@@ -500,6 +500,25 @@ namespace Luna
                 desc({}) {}
         };
 
+        //! Represents one DDS image whose pixel data is referenced from external memory rather than owned by the image object.
+        //! @details DDS image views are created by @ref read_dds_image_view, which references pixel data in the DDS file data
+        //! directly without copying them. This is usually used with memory-mapped files (see @ref IMappedFile), so that only
+        //! subresources that are actually read are loaded from the file by the system.
+        struct DDSImageView
+        {
+            //! The image descriptor.
+            DDSImageDesc desc;
+            //! The pointer to the beginning of the image pixel data. Subresource data offsets are relative to this pointer.
+            //! This memory is not owned by the view, and must be valid when the view is used.
+            const byte_t* data;
+            //! An array of subresource descriptors.
+            Array<DDSSubresource> subresources;
+
+            DDSImageView() :
+                desc({}),
+                data(nullptr) {}
+        };
+
         //! Creates one new DDS image object that can be saved later.
         //! @param[in] desc The DDS image descriptor.
         //! @return Returns the created DDS image. The pixel memory of the returned DDS image is allocated but uninitialized, 
@@ -515,6 +534,12 @@ namespace Luna
         //! @param[in] data_size The size of the image file data in bytes.
         //! @return Returns the read DDS image.
         LUNA_IMAGE_API R<DDSImage> read_dds_image(const void* data, usize data_size);
+        //! Reads DDS image view from DDS image file data without copying pixel data.
+        //! @param[in] data The image file data. The data must be valid when the returned view is used.
+        //! @param[in] data_size The size of the image file data in bytes.
+        //! @return Returns the image view that references pixel data in `data`.
+        //! Returns @ref BasicError::end_of_file if `data` does not contain all subresources described by the file header.
+        LUNA_IMAGE_API R<DDSImageView> read_dds_image_view(const void* data, usize data_size);
         //! Writes the DDS image to one DDS file.
         //! @param[in] stream The stream to write file data to.
         //! @param[in] image The DDS image to write.
@@ -68,6 +68,16 @@ namespace Luna
             //! Format with four components of 32-bit floating-point number.
             //! Supported only by .hdr
             rgba32_float,
+
+            //! Format with one component of 16-bit floating-point number.
+            //! Can only be used as the desired format when reading .hdr files, pixels are converted from 32-bit floating-point numbers.
+            r16_float,
+            //! Format with two components of 16-bit floating-point number.
+            //! Can only be used as the desired format when reading .hdr files, pixels are converted from 32-bit floating-point numbers.
+            rg16_float,
+            //! Format with four components of 16-bit floating-point number.
+            //! Can only be used as the desired format when reading .hdr files, pixels are converted from 32-bit floating-point numbers.
+            rgba16_float,
         };
 
         //! Gets the size of one pixel of the specified format in bytes.
@@ -81,16 +91,19 @@ namespace Luna
                 return 1;
             case ImageFormat::rg8_unorm:
             case ImageFormat::r16_unorm:
+            case ImageFormat::r16_float:
                 return 2;
             case ImageFormat::rgb8_unorm:
                 return 3;
             case ImageFormat::rgba8_unorm:
             case ImageFormat::rg16_unorm:
+            case ImageFormat::rg16_float:
             case ImageFormat::r32_float:
                 return 4;
             case ImageFormat::rgb16_unorm:
                 return 6;
             case ImageFormat::rgba16_unorm:
+            case ImageFormat::rgba16_float:
             case ImageFormat::rg32_float:
                 return 8;
             case ImageFormat::rgb32_float:
@@ -128,6 +141,22 @@ namespace Luna
         //! @return Returns one blob that contains the image pixel data.
         //! Pixels are arranged in row-major order, and there is no padding between every two rows of data.
         LUNA_IMAGE_API R<Blob> read_image_file(const void* data, usize data_size, ImageFormat desired_format, ImageDesc& out_desc);
+        //! Reads pixel data from image file data and writes pixels to the specified memory.
+        //! @details This can be used to decode pixels to upload buffers directly, so that pixels are not copied to one intermediate blob
+        //! before being copied to the upload buffer. This function can be called on multiple threads concurrently to decode multiple images
+        //! in parallel.
+        //! @param[in] data The image file data. Image file formats are detected from data automatically.
+        //! @param[in] data_size The size of the image file data in bytes.
+        //! @param[in] desired_format The desired pixel format for data written to `dst`.
+        //! If this does not matches the actual format of the file, pixel format conversion will be performed automatically.
+        //! @param[out] dst The memory to write pixel data to. Pixels are arranged in row-major order, and every row starts at 
+        //! `dst_row_pitch` bytes after the previous row.
+        //! @param[in] dst_row_pitch The number of bytes to advance between every two rows of pixels in `dst`. This must not be smaller than
+        //! the size of one row of pixels.
+        //! @param[in] dst_size The size of the memory pointed by `dst` in bytes.
+        //! @param[out] out_desc The image description for the written pixel data.
+        //! @return Returns @ref BasicError::out_of_range if `dst_size` is not large enough to hold all pixels.
+        LUNA_IMAGE_API RV read_image_file_to(const void* data, usize data_size, ImageFormat desired_format, void* dst, usize dst_row_pitch, usize dst_size, ImageDesc& out_desc);
 
         //! Writes the image data to one PNG file.
         //! @param[in] stream The stream to write file data to.
@@ -0,0 +1,93 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ImageProcessing.hpp
+* @author JXMaster
+* @date 2024/4/17
+* @brief CPU kernels for mip generation and pixel format conversion.
+*/
+#pragma once
+#include "Image.hpp"
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    namespace Image
+    {
+        //! @addtogroup Image
+        //! @{
+
+        //! Specifies the filter used to generate mips.
+        enum class MipFilter : u8
+        {
+            //! Every destination pixel is the average of source pixels covered by it.
+            box = 0,
+            //! Kaiser-windowed sinc filter, which keeps more details than the box filter but may produce ringing
+            //! artifacts near sharp edges.
+            kaiser = 1,
+        };
+
+        //! Specifies additional options of image processing functions.
+        enum class ImageProcessFlag : u8
+        {
+            none = 0,
+            //! Color components of 8-bit normalized formats are encoded in sRGB color space. These components are converted to
+            //! linear color space before being processed, and are converted back to sRGB color space when being stored.
+            //! Alpha components are always linear.
+            srgb = 0x01,
+            //! Multiplies color components by the alpha component when converting formats.
+            premultiply_alpha = 0x02,
+        };
+
+        //! Converts pixels from one format to another format.
+        //! @details Every pixel is converted to four 32-bit floating-point components, then converted to the destination format.
+        //! Components that do not exist in the source format are filled with `0` for color components and `1` for the alpha component,
+        //! and components that do not exist in the destination format are discarded. Values are clamped when being stored to normalized formats.
+        //!
+        //! Rows of the image are converted on multiple threads using the job system.
+        //! @param[in] src_desc The description of the source image.
+        //! @param[in] src The source pixels.
+        //! @param[in] src_row_pitch The number of bytes to advance between every two rows of source pixels.
+        //! @param[in] dst_format The destination pixel format.
+        //! @param[out] dst The memory to write converted pixels to. The memory must be large enough to hold `src_desc.height` rows.
+        //! @param[in] dst_row_pitch The number of bytes to advance between every two rows of destination pixels.
+        //! @param[in] flags Additional options.
+        //! @return Returns @ref BasicError::bad_arguments if `src_desc.format` or `dst_format` is @ref ImageFormat::unknown.
+        LUNA_IMAGE_API RV convert_image_format(const ImageDesc& src_desc, const void* src, usize src_row_pitch,
+            ImageFormat dst_format, void* dst, usize dst_row_pitch, ImageProcessFlag flags = ImageProcessFlag::none);
+
+        //! Generates the next mip level of one image.
+        //! @details The size of the generated mip is `max(src_desc.width / 2, 1)` by `max(src_desc.height / 2, 1)`, and the format of the
+        //! generated mip is the same as the source image. Pixels outside of the source image are clamped to the edge of the image.
+        //!
+        //! Rows of the generated mip are split to tiles and generated on multiple threads using the job system.
+        //! @param[in] src_desc The description of the source image.
+        //! @param[in] src The source pixels.
+        //! @param[in] src_row_pitch The number of bytes to advance between every two rows of source pixels.
+        //! @param[out] dst The memory to write generated pixels to.
+        //! @param[in] dst_row_pitch The number of bytes to advance between every two rows of generated pixels.
+        //! @param[in] filter The filter used to generate the mip.
+        //! @param[in] flags Additional options. @ref ImageProcessFlag::premultiply_alpha is ignored.
+        //! @return Returns @ref BasicError::bad_arguments if `src_desc.format` is @ref ImageFormat::unknown.
+        LUNA_IMAGE_API RV generate_mip(const ImageDesc& src_desc, const void* src, usize src_row_pitch, void* dst, usize dst_row_pitch,
+            MipFilter filter = MipFilter::box, ImageProcessFlag flags = ImageProcessFlag::none);
+
+        //! Generates the mip chain of one image.
+        //! @details Every mip is generated from the previous mip by calling @ref generate_mip.
+        //! @param[in] desc The description of the image.
+        //! @param[in] data The pixels of the most detailed mip.
+        //! @param[in] row_pitch The number of bytes to advance between every two rows of pixels in `data`.
+        //! @param[in] mip_levels The number of mips to generate, including the most detailed mip. If this is `0`, the full mip chain
+        //! is generated.
+        //! @param[in] filter The filter used to generate mips.
+        //! @param[in] flags Additional options. @ref ImageProcessFlag::premultiply_alpha is ignored.
+        //! @return Returns pixels of all mips, including one copy of the most detailed mip. Pixels of every mip are arranged in row-major order,
+        //! and there is no padding between every two rows of data.
+        LUNA_IMAGE_API R<Vector<Blob>> generate_mip_chain(const ImageDesc& desc, const void* data, usize row_pitch, u32 mip_levels = 0,
+            MipFilter filter = MipFilter::box, ImageProcessFlag flags = ImageProcessFlag::none);
+
+        //! @}
+    }
+}
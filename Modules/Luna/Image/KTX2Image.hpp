@@ -0,0 +1,60 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file KTX2Image.hpp
+* @author JXMaster
+* @date 2024/4/18
+* @brief Reads and writes KTX2 texture container files.
+*/
+#pragma once
+#include "DDSImage.hpp"
+
+namespace Luna
+{
+    namespace Image
+    {
+        //! @addtogroup Image
+        //! @{
+
+        //! Gets the Vulkan format (`VkFormat`) value that is used to store the specified DDS format in KTX2 files.
+        //! @param[in] format The DDS format.
+        //! @return Returns the Vulkan format value. Returns `0` (`VK_FORMAT_UNDEFINED`) if the format cannot be stored in KTX2 files.
+        LUNA_IMAGE_API u32 dds_to_ktx2_format(DDSFormat format);
+        //! Gets the DDS format that represents the specified Vulkan format (`VkFormat`) value used in KTX2 files.
+        //! @param[in] vk_format The Vulkan format value.
+        //! @return Returns the DDS format. Returns @ref DDSFormat::unknown if the format is not supported.
+        LUNA_IMAGE_API DDSFormat ktx2_to_dds_format(u32 vk_format);
+
+        //! Checks whether the specified file data is one KTX2 file.
+        //! @param[in] data The file data.
+        //! @param[in] data_size The size of the file data in bytes.
+        //! @return Returns `true` if the data starts with the KTX2 file identifier, returns `false` otherwise.
+        LUNA_IMAGE_API bool is_ktx2_file(const void* data, usize data_size);
+
+        //! Reads image description from KTX2 file data.
+        //! @param[in] data The image file data.
+        //! @param[in] data_size The size of the image file data in bytes.
+        //! @return Returns the read image description. KTX2 cube maps are described by @ref DDSFlag::texturecube,
+        //! and @ref DDSImageDesc::array_size is the number of array layers multiplied by the number of faces.
+        //! Returns @ref BasicError::not_supported if the file uses supercompression or one format that cannot be
+        //! represented by @ref DDSFormat.
+        LUNA_IMAGE_API R<DDSImageDesc> read_ktx2_image_file_desc(const void* data, usize data_size);
+        //! Reads image data from KTX2 file data.
+        //! @param[in] data The image file data.
+        //! @param[in] data_size The size of the image file data in bytes.
+        //! @return Returns the read image, which has the same subresource layout as images created by @ref new_dds_image.
+        //! Returns @ref BasicError::not_supported if the file uses supercompression or one format that cannot be
+        //! represented by @ref DDSFormat.
+        LUNA_IMAGE_API R<DDSImage> read_ktx2_image(const void* data, usize data_size);
+        //! Writes the image to one KTX2 file.
+        //! @param[in] stream The stream to write file data to.
+        //! @param[in] image The image to write.
+        //! @return Returns @ref BasicError::not_supported if the image format cannot be stored in KTX2 files.
+        //! @details The image is written without supercompression, and one basic data format descriptor is generated from the image format.
+        LUNA_IMAGE_API RV write_ktx2_file(ISeekableStream* stream, const DDSImage& image);
+
+        //! @}
+    }
+}
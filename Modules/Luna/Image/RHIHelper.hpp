@@ -38,6 +38,9 @@ namespace Luna
             case ImageFormat::rg32_float: return ImageFormat::rg32_float;
             case ImageFormat::rgb32_float: return ImageFormat::rgba32_float;
             case ImageFormat::rgba32_float: return ImageFormat::rgba32_float;
+            case ImageFormat::r16_float: return ImageFormat::r16_float;
+            case ImageFormat::rg16_float: return ImageFormat::rg16_float;
+            case ImageFormat::rgba16_float: return ImageFormat::rgba16_float;
             default: lupanic(); return format;
             }
         }
@@ -60,6 +63,9 @@ namespace Luna
             case ImageFormat::rg32_float: return RHI::Format::rg32_float;
             case ImageFormat::rgb32_float: return RHI::Format::rgba32_float;
             case ImageFormat::rgba32_float: return RHI::Format::rgba32_float;
+            case ImageFormat::r16_float: return RHI::Format::r16_float;
+            case ImageFormat::rg16_float: return RHI::Format::rg16_float;
+            case ImageFormat::rgba16_float: return RHI::Format::rgba16_float;
             default: lupanic(); return RHI::Format::unknown;
             }
         }
@@ -80,6 +86,9 @@ namespace Luna
             case RHI::Format::r32_float: return ImageFormat::r32_float;
             case RHI::Format::rg32_float: return ImageFormat::rg32_float;
             case RHI::Format::rgba32_float: return ImageFormat::rgba32_float;
+            case RHI::Format::r16_float: return ImageFormat::r16_float;
+            case RHI::Format::rg16_float: return ImageFormat::rg16_float;
+            case RHI::Format::rgba16_float: return ImageFormat::rgba16_float;
             default: return ImageFormat::unknown;
             }
         }
@@ -0,0 +1,407 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BlockCompression.cpp
+* @author JXMaster
+* @date 2024/4/16
+*/
+#include "Image.hpp"
+#include "../BlockCompression.hpp"
+#include <Luna/Runtime/Math/Math.hpp>
+
+namespace Luna
+{
+    namespace Image
+    {
+        using encode_block_func_t = void(const u8 (*pixels)[4], u8* dst);
+
+        // Loads one 4x4 block of pixels. Pixels outside of the image are clamped to the edge of the image.
+        static void load_block(const u8* src, usize src_row_pitch, u32 width, u32 height, u32 block_x, u32 block_y, u8 (*pixels)[4])
+        {
+            for(u32 y = 0; y < 4; ++y)
+            {
+                u32 py = min(block_y * 4 + y, height - 1);
+                const u8* row = src + src_row_pitch * py;
+                for(u32 x = 0; x < 4; ++x)
+                {
+                    u32 px = min(block_x * 4 + x, width - 1);
+                    const u8* pixel = row + px * 4;
+                    u8* dst = pixels[y * 4 + x];
+                    dst[0] = pixel[0];
+                    dst[1] = pixel[1];
+                    dst[2] = pixel[2];
+                    dst[3] = pixel[3];
+                }
+            }
+        }
+
+        // Finds two endpoints of the line that fits the first `_NumChannels` channels of 16 pixels best.
+        // The line is the principal axis of pixel values, and the endpoints are inset slightly to reduce the
+        // error of pixels between the endpoints.
+        template <u32 _NumChannels>
+        static void find_endpoints(const u8 (*pixels)[4], f32* out_e0, f32* out_e1)
+        {
+            f32 mean[_NumChannels] = {};
+            for(u32 i = 0; i < 16; ++i)
+            {
+                for(u32 c = 0; c < _NumChannels; ++c) mean[c] += (f32)pixels[i][c];
+            }
+            for(u32 c = 0; c < _NumChannels; ++c) mean[c] /= 16.0f;
+            f32 cov[_NumChannels][_NumChannels] = {};
+            for(u32 i = 0; i < 16; ++i)
+            {
+                f32 d[_NumChannels];
+                for(u32 c = 0; c < _NumChannels; ++c) d[c] = (f32)pixels[i][c] - mean[c];
+                for(u32 a = 0; a < _NumChannels; ++a)
+                {
+                    for(u32 b = 0; b < _NumChannels; ++b) cov[a][b] += d[a] * d[b];
+                }
+            }
+            // Power iteration.
+            f32 axis[_NumChannels];
+            for(u32 c = 0; c < _NumChannels; ++c) axis[c] = 1.0f;
+            for(u32 iter = 0; iter < 8; ++iter)
+            {
+                f32 v[_NumChannels] = {};
+                for(u32 a = 0; a < _NumChannels; ++a)
+                {
+                    for(u32 b = 0; b < _NumChannels; ++b) v[a] += cov[a][b] * axis[b];
+                }
+                f32 scale = 0.0f;
+                for(u32 c = 0; c < _NumChannels; ++c) scale = max(scale, fabsf(v[c]));
+                // All pixels have the same value.
+                if(scale < 1e-6f) break;
+                for(u32 c = 0; c < _NumChannels; ++c) axis[c] = v[c] / scale;
+            }
+            // Finds pixels with minimum and maximum projections on the axis.
+            f32 min_t = F32_INFINITY;
+            f32 max_t = -F32_INFINITY;
+            u32 min_i = 0;
+            u32 max_i = 0;
+            for(u32 i = 0; i < 16; ++i)
+            {
+                f32 t = 0.0f;
+                for(u32 c = 0; c < _NumChannels; ++c) t += ((f32)pixels[i][c] - mean[c]) * axis[c];
+                if(t < min_t) { min_t = t; min_i = i; }
+                if(t > max_t) { max_t = t; max_i = i; }
+            }
+            for(u32 c = 0; c < _NumChannels; ++c)
+            {
+                f32 e0 = (f32)pixels[max_i][c];
+                f32 e1 = (f32)pixels[min_i][c];
+                f32 inset = (e0 - e1) / 16.0f;
+                out_e0[c] = clamp(e0 - inset, 0.0f, 255.0f);
+                out_e1[c] = clamp(e1 + inset, 0.0f, 255.0f);
+            }
+        }
+
+        static u16 pack_565(const f32* color)
+        {
+            u32 r = (u32)clamp((i32)(color[0] * 31.0f / 255.0f + 0.5f), 0, 31);
+            u32 g = (u32)clamp((i32)(color[1] * 63.0f / 255.0f + 0.5f), 0, 63);
+            u32 b = (u32)clamp((i32)(color[2] * 31.0f / 255.0f + 0.5f), 0, 31);
+            return (u16)((r << 11) | (g << 5) | b);
+        }
+        static void unpack_565(u16 color, i32* out_color)
+        {
+            i32 r = (color >> 11) & 0x1F;
+            i32 g = (color >> 5) & 0x3F;
+            i32 b = color & 0x1F;
+            out_color[0] = (r << 3) | (r >> 2);
+            out_color[1] = (g << 2) | (g >> 4);
+            out_color[2] = (b << 3) | (b >> 2);
+        }
+        template <u32 _NumChannels>
+        static u32 find_nearest(const u8* pixel, const i32 (*palette)[4], u32 palette_size)
+        {
+            u32 best = 0;
+            i32 best_error = I32_MAX;
+            for(u32 i = 0; i < palette_size; ++i)
+            {
+                i32 error = 0;
+                for(u32 c = 0; c < _NumChannels; ++c)
+                {
+                    i32 d = (i32)pixel[c] - palette[i][c];
+                    error += d * d;
+                }
+                if(error < best_error)
+                {
+                    best_error = error;
+                    best = i;
+                }
+            }
+            return best;
+        }
+
+        // Encodes the color block of BC1, BC2 and BC3 using the 4-color mode.
+        static void encode_color_block(const u8 (*pixels)[4], u8* dst)
+        {
+            f32 e0[3];
+            f32 e1[3];
+            find_endpoints<3>(pixels, e0, e1);
+            u16 c0 = pack_565(e0);
+            u16 c1 = pack_565(e1);
+            // The 4-color mode is used only if c0 > c1.
+            if(c0 < c1)
+            {
+                u16 t = c0;
+                c0 = c1;
+                c1 = t;
+            }
+            u32 indices = 0;
+            if(c0 != c1)
+            {
+                i32 palette[4][4];
+                unpack_565(c0, palette[0]);
+                unpack_565(c1, palette[1]);
+                for(u32 c = 0; c < 3; ++c)
+                {
+                    palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+                    palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+                }
+                for(u32 i = 0; i < 16; ++i)
+                {
+                    indices |= find_nearest<3>(pixels[i], palette, 4) << (i * 2);
+                }
+            }
+            dst[0] = (u8)(c0 & 0xFF);
+            dst[1] = (u8)(c0 >> 8);
+            dst[2] = (u8)(c1 & 0xFF);
+            dst[3] = (u8)(c1 >> 8);
+            dst[4] = (u8)(indices & 0xFF);
+            dst[5] = (u8)((indices >> 8) & 0xFF);
+            dst[6] = (u8)((indices >> 16) & 0xFF);
+            dst[7] = (u8)(indices >> 24);
+        }
+
+        // Encodes one channel of 16 pixels to one BC4 block using the 8-value mode.
+        static void encode_channel_block(const u8 (*pixels)[4], u32 channel, u8* dst)
+        {
+            u8 a0 = 0;
+            u8 a1 = 255;
+            for(u32 i = 0; i < 16; ++i)
+            {
+                a0 = max(a0, pixels[i][channel]);
+                a1 = min(a1, pixels[i][channel]);
+            }
+            u64 indices = 0;
+            if(a0 != a1)
+            {
+                i32 palette[8][4];
+                palette[0][0] = a0;
+                palette[1][0] = a1;
+                for(u32 i = 2; i < 8; ++i)
+                {
+                    palette[i][0] = ((8 - (i32)i) * a0 + ((i32)i - 1) * a1) / 7;
+                }
+                for(u32 i = 0; i < 16; ++i)
+                {
+                    u8 value = pixels[i][channel];
+                    indices |= ((u64)find_nearest<1>(&value, palette, 8)) << (i * 3);
+                }
+            }
+            dst[0] = a0;
+            dst[1] = a1;
+            for(u32 i = 0; i < 6; ++i)
+            {
+                dst[2 + i] = (u8)((indices >> (i * 8)) & 0xFF);
+            }
+        }
+
+        static void encode_bc1_block(const u8 (*pixels)[4], u8* dst)
+        {
+            encode_color_block(pixels, dst);
+        }
+        static void encode_bc3_block(const u8 (*pixels)[4], u8* dst)
+        {
+            encode_channel_block(pixels, 3, dst);
+            encode_color_block(pixels, dst + 8);
+        }
+        static void encode_bc4_block(const u8 (*pixels)[4], u8* dst)
+        {
+            encode_channel_block(pixels, 0, dst);
+        }
+        static void encode_bc5_block(const u8 (*pixels)[4], u8* dst)
+        {
+            encode_channel_block(pixels, 0, dst);
+            encode_channel_block(pixels, 1, dst + 8);
+        }
+
+        struct BitWriter
+        {
+            u8* m_data;
+            u32 m_pos = 0;
+
+            BitWriter(u8* data) : m_data(data)
+            {
+                for(u32 i = 0; i < 16; ++i) m_data[i] = 0;
+            }
+            void write(u32 value, u32 num_bits)
+            {
+                for(u32 i = 0; i < num_bits; ++i, ++m_pos)
+                {
+                    if((value >> i) & 1) m_data[m_pos >> 3] |= (u8)(1 << (m_pos & 7));
+                }
+            }
+        };
+
+        // Encodes one BC7 block using mode 6, which stores one RGBA line with 7-bit endpoints, one p-bit per endpoint
+        // and 4-bit indices.
+        static void encode_bc7_block(const u8 (*pixels)[4], u8* dst)
+        {
+            constexpr i32 weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+            f32 endpoints[2][4];
+            find_endpoints<4>(pixels, endpoints[0], endpoints[1]);
+            // Quantizes endpoints to 7 bits and chooses the p-bit with the least error for every endpoint.
+            u32 quantized[2][4];
+            u32 p_bits[2];
+            for(u32 e = 0; e < 2; ++e)
+            {
+                f32 best_error = F32_INFINITY;
+                for(u32 p = 0; p < 2; ++p)
+                {
+                    u32 q[4];
+                    f32 error = 0.0f;
+                    for(u32 c = 0; c < 4; ++c)
+                    {
+                        q[c] = (u32)clamp((i32)((endpoints[e][c] - (f32)p) / 2.0f + 0.5f), 0, 127);
+                        f32 d = (f32)((q[c] << 1) | p) - endpoints[e][c];
+                        error += d * d;
+                    }
+                    if(error < best_error)
+                    {
+                        best_error = error;
+                        p_bits[e] = p;
+                        for(u32 c = 0; c < 4; ++c) quantized[e][c] = q[c];
+                    }
+                }
+            }
+            i32 palette[16][4];
+            for(u32 c = 0; c < 4; ++c)
+            {
+                i32 e0 = (i32)((quantized[0][c] << 1) | p_bits[0]);
+                i32 e1 = (i32)((quantized[1][c] << 1) | p_bits[1]);
+                for(u32 i = 0; i < 16; ++i)
+                {
+                    palette[i][c] = ((64 - weights[i]) * e0 + weights[i] * e1 + 32) >> 6;
+                }
+            }
+            u32 indices[16];
+            for(u32 i = 0; i < 16; ++i)
+            {
+                indices[i] = find_nearest<4>(pixels[i], palette, 16);
+            }
+            // The most significant bit of the index of the first pixel is implicitly zero, swap endpoints if needed.
+            if(indices[0] & 8)
+            {
+                for(u32 c = 0; c < 4; ++c)
+                {
+                    u32 t = quantized[0][c];
+                    quantized[0][c] = quantized[1][c];
+                    quantized[1][c] = t;
+                }
+                u32 t = p_bits[0];
+                p_bits[0] = p_bits[1];
+                p_bits[1] = t;
+                for(u32 i = 0; i < 16; ++i) indices[i] = 15 - indices[i];
+            }
+            BitWriter writer(dst);
+            writer.write(1 << 6, 7);
+            for(u32 c = 0; c < 4; ++c)
+            {
+                writer.write(quantized[0][c], 7);
+                writer.write(quantized[1][c], 7);
+            }
+            writer.write(p_bits[0], 1);
+            writer.write(p_bits[1], 1);
+            writer.write(indices[0], 3);
+            for(u32 i = 1; i < 16; ++i)
+            {
+                writer.write(indices[i], 4);
+            }
+        }
+
+        static encode_block_func_t* get_encode_block_func(DDSFormat format, usize& out_block_size)
+        {
+            switch(format)
+            {
+            case DDSFormat::bc1_typeless:
+            case DDSFormat::bc1_unorm:
+            case DDSFormat::bc1_unorm_srgb:
+                out_block_size = 8;
+                return encode_bc1_block;
+            case DDSFormat::bc3_typeless:
+            case DDSFormat::bc3_unorm:
+            case DDSFormat::bc3_unorm_srgb:
+                out_block_size = 16;
+                return encode_bc3_block;
+            case DDSFormat::bc4_typeless:
+            case DDSFormat::bc4_unorm:
+                out_block_size = 8;
+                return encode_bc4_block;
+            case DDSFormat::bc5_typeless:
+            case DDSFormat::bc5_unorm:
+                out_block_size = 16;
+                return encode_bc5_block;
+            case DDSFormat::bc7_typeless:
+            case DDSFormat::bc7_unorm:
+            case DDSFormat::bc7_unorm_srgb:
+                out_block_size = 16;
+                return encode_bc7_block;
+            default:
+                out_block_size = 0;
+                return nullptr;
+            }
+        }
+
+        LUNA_IMAGE_API RV compress_blocks(DDSFormat format, const void* src, usize src_row_pitch, u32 width, u32 height, void* dst, usize dst_row_pitch)
+        {
+            usize block_size;
+            encode_block_func_t* encode_block = get_encode_block_func(format, block_size);
+            if(!encode_block) return BasicError::not_supported();
+            if(!width || !height) return ok;
+            u32 num_blocks_x = (width + 3) / 4;
+            u32 num_blocks_y = (height + 3) / 4;
+            u8 pixels[16][4];
+            for(u32 y = 0; y < num_blocks_y; ++y)
+            {
+                u8* dst_row = (u8*)dst + dst_row_pitch * y;
+                for(u32 x = 0; x < num_blocks_x; ++x)
+                {
+                    load_block((const u8*)src, src_row_pitch, width, height, x, y, pixels);
+                    encode_block(pixels, dst_row + block_size * x);
+                }
+            }
+            return ok;
+        }
+        LUNA_IMAGE_API R<DDSImage> compress_dds_image(const DDSImage& src, DDSFormat dst_format)
+        {
+            DDSImage dst;
+            lutry
+            {
+                if(src.desc.format != DDSFormat::r8g8b8a8_unorm && src.desc.format != DDSFormat::r8g8b8a8_unorm_srgb)
+                {
+                    return BasicError::not_supported();
+                }
+                if(!is_block_compression_supported(dst_format)) return BasicError::not_supported();
+                DDSImageDesc desc = src.desc;
+                desc.format = dst_format;
+                luset(dst, new_dds_image(desc));
+                for(usize i = 0; i < src.subresources.size(); ++i)
+                {
+                    const DDSSubresource& s = src.subresources[i];
+                    const DDSSubresource& d = dst.subresources[i];
+                    for(u32 z = 0; z < s.depth; ++z)
+                    {
+                        luexp(compress_blocks(dst_format, (const u8*)src.data.data() + s.data_offset + s.slice_pitch * z, s.row_pitch, s.width, s.height,
+                            (u8*)dst.data.data() + d.data_offset + d.slice_pitch * z, d.row_pitch));
+                    }
+                }
+            }
+            lucatchret;
+            return dst;
+        }
+    }
+}
@@ -8,7 +8,7 @@
 * @date 2023/11/5
 */
 #include "Image.hpp"
-#include "../DDSImage.hpp"
+#include "DDSImage.hpp"
 
 namespace Luna
 {
@@ -489,9 +489,8 @@ namespace Luna
                 return false;
             }
         }
-        RV init_dds_image(DDSImage& image)
+        RV validate_dds_image_desc(const DDSImageDesc& desc)
         {
-            auto& desc = image.desc;
             u32 mip_levels = desc.mip_levels;
             switch(desc.dimension)
             {
@@ -521,10 +520,17 @@ namespace Luna
                 default:
                     return BasicError::not_supported();
             }
+            return ok;
+        }
+        RV init_dds_image(DDSImage& image)
+        {
+            auto r = validate_dds_image_desc(image.desc);
+            if(failed(r)) return r;
+            auto& desc = image.desc;
             image.subresources.clear();
             image.data.clear();
             usize pixel_size, num_images;
-            auto r = determine_image_array(desc, num_images, pixel_size);
+            r = determine_image_array(desc, num_images, pixel_size);
             if(failed(r)) return r;
             image.subresources.assign(num_images);
             image.data = Blob(pixel_size, 16);
@@ -678,6 +684,31 @@ namespace Luna
             lucatchret;
             return r;
         }
+        LUNA_IMAGE_API R<DDSImageView> read_dds_image_view(const void* data, usize data_size)
+        {
+            DDSImageView r;
+            lutry
+            {
+                luset(r.desc, read_dds_image_file_desc(data, data_size));
+                usize offset = sizeof(u32) + sizeof(DDSHeader) + sizeof(DDSHeaderDXT10);
+                luexp(validate_dds_image_desc(r.desc));
+                usize pixel_size, num_images;
+                luexp(determine_image_array(r.desc, num_images, pixel_size));
+                if(pixel_size > data_size - offset)
+                {
+                    return BasicError::end_of_file();
+                }
+                // Subresources are referenced from the file data directly, so they have the same layout as the file.
+                r.data = (const byte_t*)data + offset;
+                r.subresources.assign(num_images);
+                if(!setup_image_array(r.data, pixel_size, r.desc, r.subresources))
+                {
+                    return BasicError::failure();
+                }
+            }
+            lucatchret;
+            return r;
+        }
         constexpr u32 DDS_SURFACE_FLAGS_TEXTURE = 0x00001000; // DDSCAPS_TEXTURE
         constexpr u32 DDS_SURFACE_FLAGS_MIPMAP = 0x00400008; // DDSCAPS_COMPLEX | DDSCAPS_MIPMAP
         constexpr u32 DDS_SURFACE_FLAGS_CUBEMAP = 0x00000008;// DDSCAPS_COMPLEX
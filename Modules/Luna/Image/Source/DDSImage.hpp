@@ -0,0 +1,22 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file DDSImage.hpp
+* @author JXMaster
+* @date 2024/4/18
+*/
+#pragma once
+#include "../DDSImage.hpp"
+
+namespace Luna
+{
+    namespace Image
+    {
+        // Computes the tightly-packed row pitch and slice pitch of one subresource.
+        RV compute_pitch(DDSFormat format, usize width, usize height, usize& row_pitch, usize& slice_pitch);
+        // Checks whether the image size, array size and mip levels are valid for the image dimension.
+        RV validate_dds_image_desc(const DDSImageDesc& desc);
+    }
+}
@@ -11,6 +11,9 @@
 #include "IO/STBImage.hpp"
 #include "IO/STBImageWrite.hpp"
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/MemoryUtils.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+#include "../ImageProcessing.hpp"
 
 namespace Luna
 {
@@ -146,12 +149,38 @@ namespace Luna
                 return 0;
             }
         }
-        LUNA_IMAGE_API R<Blob> read_image_file(const void* data, usize data_size, ImageFormat desired_format, ImageDesc& out_desc)
+        // stb_image cannot decode to 16-bit floating-point formats, so such formats are decoded as
+        // 32-bit floating-point formats first, then converted.
+        inline ImageFormat get_decode_format(ImageFormat format)
         {
-            // Use stb_image library to load image.
-
-            // Prefetch the data info.
-            Blob ret;
+            switch (format)
+            {
+            case ImageFormat::r16_float: return ImageFormat::r32_float;
+            case ImageFormat::rg16_float: return ImageFormat::rg32_float;
+            case ImageFormat::rgba16_float: return ImageFormat::rgba32_float;
+            default: return format;
+            }
+        }
+        // Decodes pixels using stb_image. The returned memory is allocated by `memalloc` and should be freed by `stbi_image_free`.
+        static void* stbi_read_image(const void* data, usize data_size, ImageFormat desired_format, ImageDesc& out_desc)
+        {
+            ImageFormat decode_format = get_decode_format(desired_format);
+            if (decode_format != desired_format)
+            {
+                void* decoded = stbi_read_image(data, data_size, decode_format, out_desc);
+                if (!decoded) return nullptr;
+                void* converted = memalloc((usize)out_desc.width * out_desc.height * pixel_size(desired_format));
+                auto r = convert_image_format(out_desc, decoded, (usize)out_desc.width * pixel_size(decode_format),
+                    desired_format, converted, (usize)out_desc.width * pixel_size(desired_format));
+                stbi_image_free(decoded);
+                if (failed(r))
+                {
+                    memfree(converted);
+                    return nullptr;
+                }
+                out_desc.format = desired_format;
+                return converted;
+            }
             void* read_data;
             int out_x, out_y, out_comp;
             if (is_hdr(desired_format))
@@ -166,18 +195,44 @@ namespace Luna
             {
                 read_data = stbi_load_from_memory((const unsigned char*)data, (int)data_size, &out_x, &out_y, &out_comp, get_comp(desired_format));
             }
+            if (read_data)
+            {
+                out_desc.width = out_x;
+                out_desc.height = out_y;
+                out_desc.format = desired_format;
+            }
+            return read_data;
+        }
+        LUNA_IMAGE_API R<Blob> read_image_file(const void* data, usize data_size, ImageFormat desired_format, ImageDesc& out_desc)
+        {
+            void* read_data = stbi_read_image(data, data_size, desired_format, out_desc);
             if (!read_data)
             {
                 return ImageError::file_parse_error();
             }
-            out_desc.width = out_x;
-            out_desc.height = out_y;
-            out_desc.format = desired_format;
-            ret.resize(out_desc.width * out_desc.height * pixel_size(out_desc.format));
-            memcpy(ret.data(), read_data, ret.size());
-            stbi_image_free(read_data);
+            // stb_image allocates memory using `memalloc`, so we can transfer the ownership to the blob directly
+            // without copying pixels.
+            Blob ret;
+            ret.attach(read_data, (usize)out_desc.width * out_desc.height * pixel_size(out_desc.format), 0);
             return ret;
         }
+        LUNA_IMAGE_API RV read_image_file_to(const void* data, usize data_size, ImageFormat desired_format, void* dst, usize dst_row_pitch, usize dst_size, ImageDesc& out_desc)
+        {
+            void* read_data = stbi_read_image(data, data_size, desired_format, out_desc);
+            if (!read_data)
+            {
+                return ImageError::file_parse_error();
+            }
+            usize src_row_pitch = (usize)out_desc.width * pixel_size(out_desc.format);
+            if (dst_row_pitch < src_row_pitch || (out_desc.height && dst_row_pitch * (out_desc.height - 1) + src_row_pitch > dst_size))
+            {
+                stbi_image_free(read_data);
+                return BasicError::out_of_range();
+            }
+            memcpy_bitmap(dst, read_data, src_row_pitch, out_desc.height, dst_row_pitch, src_row_pitch);
+            stbi_image_free(read_data);
+            return ok;
+        }
 
         inline bool check_png_format(ImageFormat format)
         {
@@ -303,6 +358,10 @@ namespace Luna
         struct ImageModule : public Module
         {
             virtual const c8* get_name() override { return "Image"; }
+            virtual RV on_register() override
+            {
+                return add_dependency_module(this, module_job_system());
+            }
             virtual RV on_init() override
             {
                 stbi_init();
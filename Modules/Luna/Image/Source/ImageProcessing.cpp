@@ -0,0 +1,433 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ImageProcessing.cpp
+* @author JXMaster
+* @date 2024/4/17
+*/
+#include "Image.hpp"
+#include "../ImageProcessing.hpp"
+#include <Luna/Runtime/Math/Vector.hpp>
+#include <Luna/Runtime/Math/Simd.hpp>
+#include <Luna/Runtime/MemoryUtils.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+
+namespace Luna
+{
+    namespace Image
+    {
+        // The number of rows processed by one job.
+        constexpr u32 ROWS_PER_TILE = 16;
+        // The half width of the Kaiser filter in destination pixels.
+        constexpr f32 KAISER_WIDTH = 3.0f;
+        constexpr f32 KAISER_ALPHA = 4.0f;
+
+        enum class ComponentType : u8
+        {
+            u8_unorm,
+            u16_unorm,
+            f16,
+            f32,
+        };
+        static ComponentType get_component_type(ImageFormat format)
+        {
+            switch (format)
+            {
+            case ImageFormat::r8_unorm:
+            case ImageFormat::rg8_unorm:
+            case ImageFormat::rgb8_unorm:
+            case ImageFormat::rgba8_unorm:
+                return ComponentType::u8_unorm;
+            case ImageFormat::r16_unorm:
+            case ImageFormat::rg16_unorm:
+            case ImageFormat::rgb16_unorm:
+            case ImageFormat::rgba16_unorm:
+                return ComponentType::u16_unorm;
+            case ImageFormat::r16_float:
+            case ImageFormat::rg16_float:
+            case ImageFormat::rgba16_float:
+                return ComponentType::f16;
+            default:
+                return ComponentType::f32;
+            }
+        }
+        static u32 get_num_components(ImageFormat format)
+        {
+            switch (format)
+            {
+            case ImageFormat::r8_unorm:
+            case ImageFormat::r16_unorm:
+            case ImageFormat::r16_float:
+            case ImageFormat::r32_float:
+                return 1;
+            case ImageFormat::rg8_unorm:
+            case ImageFormat::rg16_unorm:
+            case ImageFormat::rg16_float:
+            case ImageFormat::rg32_float:
+                return 2;
+            case ImageFormat::rgb8_unorm:
+            case ImageFormat::rgb16_unorm:
+            case ImageFormat::rgb32_float:
+                return 3;
+            case ImageFormat::rgba8_unorm:
+            case ImageFormat::rgba16_unorm:
+            case ImageFormat::rgba16_float:
+            case ImageFormat::rgba32_float:
+                return 4;
+            default:
+                return 0;
+            }
+        }
+
+        f32 f16_to_f32(u16 value)
+        {
+            u32 sign = ((u32)value & 0x8000) << 16;
+            u32 exp = ((u32)value >> 10) & 0x1F;
+            u32 mant = (u32)value & 0x3FF;
+            u32 bits;
+            if (exp == 0)
+            {
+                if (mant == 0) bits = sign;
+                else
+                {
+                    // Subnormal numbers are normalized.
+                    exp = 127 - 15 + 1;
+                    while (!(mant & 0x400))
+                    {
+                        mant <<= 1;
+                        --exp;
+                    }
+                    mant &= 0x3FF;
+                    bits = sign | (exp << 23) | (mant << 13);
+                }
+            }
+            else if (exp == 31)
+            {
+                // Infinity or NaN.
+                bits = sign | 0x7F800000 | (mant << 13);
+            }
+            else
+            {
+                bits = sign | ((exp + 127 - 15) << 23) | (mant << 13);
+            }
+            f32 r;
+            memcpy(&r, &bits, sizeof(f32));
+            return r;
+        }
+        u16 f32_to_f16(f32 value)
+        {
+            u32 bits;
+            memcpy(&bits, &value, sizeof(f32));
+            u32 sign = (bits >> 16) & 0x8000;
+            u32 exp = (bits >> 23) & 0xFF;
+            u32 mant = bits & 0x7FFFFF;
+            // Infinity or NaN.
+            if (exp == 0xFF) return (u16)(sign | 0x7C00 | (mant ? 0x200 : 0));
+            i32 e = (i32)exp - 127 + 15;
+            // Overflow.
+            if (e >= 31) return (u16)(sign | 0x7C00);
+            if (e <= 0)
+            {
+                // Subnormal or zero.
+                if (e < -10) return (u16)sign;
+                mant |= 0x800000;
+                u32 shift = (u32)(14 - e);
+                u32 r = mant >> shift;
+                u32 rem = mant & ((1u << shift) - 1);
+                u32 halfway = 1u << (shift - 1);
+                // Round to nearest even.
+                if (rem > halfway || (rem == halfway && (r & 1))) ++r;
+                return (u16)(sign | r);
+            }
+            u32 r = sign | ((u32)e << 10) | (mant >> 13);
+            u32 rem = mant & 0x1FFF;
+            // Round to nearest even. The carry may propagate to the exponent, which is still correct.
+            if (rem > 0x1000 || (rem == 0x1000 && (r & 1))) ++r;
+            return (u16)r;
+        }
+
+        static const f32* get_srgb_to_linear_table()
+        {
+            struct Table
+            {
+                f32 values[256];
+                Table()
+                {
+                    for (u32 i = 0; i < 256; ++i)
+                    {
+                        f32 c = (f32)i / 255.0f;
+                        values[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+                    }
+                }
+            };
+            static Table table;
+            return table.values;
+        }
+        static f32 linear_to_srgb(f32 c)
+        {
+            return c <= 0.0031308f ? c * 12.92f : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+        }
+
+        // Loads one row of pixels as 32-bit floating-point RGBA values.
+        static void load_row(ImageFormat format, const void* src, u32 count, Float4* dst, bool srgb)
+        {
+            u32 num_components = get_num_components(format);
+            ComponentType type = get_component_type(format);
+            const f32* srgb_table = get_srgb_to_linear_table();
+            for (u32 i = 0; i < count; ++i)
+            {
+                f32 v[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+                for (u32 c = 0; c < num_components; ++c)
+                {
+                    usize index = (usize)i * num_components + c;
+                    switch (type)
+                    {
+                    case ComponentType::u8_unorm:
+                    {
+                        u8 value = ((const u8*)src)[index];
+                        v[c] = (srgb && c < 3) ? srgb_table[value] : (f32)value / 255.0f;
+                        break;
+                    }
+                    case ComponentType::u16_unorm: v[c] = (f32)((const u16*)src)[index] / 65535.0f; break;
+                    case ComponentType::f16: v[c] = f16_to_f32(((const u16*)src)[index]); break;
+                    case ComponentType::f32: v[c] = ((const f32*)src)[index]; break;
+                    }
+                }
+                dst[i] = Float4(v[0], v[1], v[2], v[3]);
+            }
+        }
+        // Stores one row of 32-bit floating-point RGBA values to the specified format.
+        static void store_row(ImageFormat format, const Float4* src, u32 count, void* dst, bool srgb)
+        {
+            u32 num_components = get_num_components(format);
+            ComponentType type = get_component_type(format);
+            for (u32 i = 0; i < count; ++i)
+            {
+                for (u32 c = 0; c < num_components; ++c)
+                {
+                    usize index = (usize)i * num_components + c;
+                    f32 v = src[i].m[c];
+                    switch (type)
+                    {
+                    case ComponentType::u8_unorm:
+                        v = clamp(v, 0.0f, 1.0f);
+                        if (srgb && c < 3) v = linear_to_srgb(v);
+                        ((u8*)dst)[index] = (u8)(v * 255.0f + 0.5f);
+                        break;
+                    case ComponentType::u16_unorm: ((u16*)dst)[index] = (u16)(clamp(v, 0.0f, 1.0f) * 65535.0f + 0.5f); break;
+                    case ComponentType::f16: ((u16*)dst)[index] = f32_to_f16(v); break;
+                    case ComponentType::f32: ((f32*)dst)[index] = v; break;
+                    }
+                }
+            }
+        }
+        // dst[i] += src[i] * weight
+        static void accumulate_row(Float4* dst, const Float4* src, u32 count, f32 weight)
+        {
+#ifdef LUNA_SIMD
+            using namespace Simd;
+            float4 w = dup_f4(weight);
+            for (u32 i = 0; i < count; ++i)
+            {
+                store_f4(dst[i].m, muladd_f4(load_f4(src[i].m), w, load_f4(dst[i].m)));
+            }
+#else
+            for (u32 i = 0; i < count; ++i)
+            {
+                dst[i] += src[i] * weight;
+            }
+#endif
+        }
+        static void premultiply_row(Float4* pixels, u32 count)
+        {
+            for (u32 i = 0; i < count; ++i)
+            {
+                f32 a = pixels[i].w;
+                pixels[i] = Float4(pixels[i].x * a, pixels[i].y * a, pixels[i].z * a, a);
+            }
+        }
+
+        LUNA_IMAGE_API RV convert_image_format(const ImageDesc& src_desc, const void* src, usize src_row_pitch,
+            ImageFormat dst_format, void* dst, usize dst_row_pitch, ImageProcessFlag flags)
+        {
+            if (src_desc.format == ImageFormat::unknown || dst_format == ImageFormat::unknown) return BasicError::bad_arguments();
+            if (src_desc.format == dst_format && flags == ImageProcessFlag::none)
+            {
+                memcpy_bitmap(dst, src, (usize)src_desc.width * pixel_size(dst_format), src_desc.height, dst_row_pitch, src_row_pitch);
+                return ok;
+            }
+            bool srgb = test_flags(flags, ImageProcessFlag::srgb);
+            bool premultiply = test_flags(flags, ImageProcessFlag::premultiply_alpha);
+            u32 num_tiles = (src_desc.height + ROWS_PER_TILE - 1) / ROWS_PER_TILE;
+            JobSystem::parallel_for(0, num_tiles, 1, [&](usize tile)
+            {
+                Vector<Float4> row;
+                row.resize(src_desc.width);
+                u32 begin = (u32)tile * ROWS_PER_TILE;
+                u32 end = min(begin + ROWS_PER_TILE, src_desc.height);
+                for (u32 y = begin; y < end; ++y)
+                {
+                    load_row(src_desc.format, (const u8*)src + src_row_pitch * y, src_desc.width, row.data(), srgb);
+                    if (premultiply) premultiply_row(row.data(), src_desc.width);
+                    store_row(dst_format, row.data(), src_desc.width, (u8*)dst + dst_row_pitch * y, srgb);
+                }
+            });
+            return ok;
+        }
+
+        // The zero-order modified Bessel function of the first kind.
+        static f32 bessel_i0(f32 x)
+        {
+            f32 sum = 1.0f;
+            f32 term = 1.0f;
+            for (u32 k = 1; k < 20; ++k)
+            {
+                term *= x / (2.0f * k);
+                sum += term * term;
+            }
+            return sum;
+        }
+        // `x` is the distance to the filter center in destination pixels.
+        static f32 kaiser_filter(f32 x)
+        {
+            f32 t = x / KAISER_WIDTH;
+            if (fabsf(t) >= 1.0f) return 0.0f;
+            f32 window = bessel_i0(KAISER_ALPHA * sqrtf(1.0f - t * t)) / bessel_i0(KAISER_ALPHA);
+            f32 sinc = fabsf(x) < 1e-6f ? 1.0f : sinf(PI * x) / (PI * x);
+            return sinc * window;
+        }
+        // The source pixels and weights used to compute every destination pixel along one axis.
+        struct FilterWeights
+        {
+            // The first element and the number of elements in `indices` and `weights` for every destination pixel.
+            Vector<Pair<u32, u32>> ranges;
+            Vector<u32> indices;
+            Vector<f32> weights;
+        };
+        static void compute_filter_weights(MipFilter filter, u32 src_size, u32 dst_size, FilterWeights& out)
+        {
+            f32 scale = (f32)src_size / (f32)dst_size;
+            f32 radius = filter == MipFilter::box ? scale * 0.5f : KAISER_WIDTH * scale;
+            out.ranges.resize(dst_size);
+            for (u32 i = 0; i < dst_size; ++i)
+            {
+                f32 center = ((f32)i + 0.5f) * scale;
+                i32 begin = (i32)floorf(center - radius);
+                i32 end = (i32)ceilf(center + radius);
+                u32 first = (u32)out.weights.size();
+                f32 sum = 0.0f;
+                for (i32 j = begin; j < end; ++j)
+                {
+                    f32 w;
+                    if (filter == MipFilter::box)
+                    {
+                        // The coverage of the source pixel.
+                        w = min((f32)(j + 1), center + radius) - max((f32)j, center - radius);
+                    }
+                    else
+                    {
+                        w = kaiser_filter(((f32)j + 0.5f - center) / scale);
+                    }
+                    if (w == 0.0f) continue;
+                    out.indices.push_back((u32)clamp(j, 0, (i32)src_size - 1));
+                    out.weights.push_back(w);
+                    sum += w;
+                }
+                for (usize k = first; k < out.weights.size(); ++k) out.weights[k] /= sum;
+                out.ranges[i] = make_pair(first, (u32)out.weights.size() - first);
+            }
+        }
+
+        LUNA_IMAGE_API RV generate_mip(const ImageDesc& src_desc, const void* src, usize src_row_pitch, void* dst, usize dst_row_pitch,
+            MipFilter filter, ImageProcessFlag flags)
+        {
+            if (src_desc.format == ImageFormat::unknown) return BasicError::bad_arguments();
+            u32 src_width = src_desc.width;
+            u32 src_height = src_desc.height;
+            u32 dst_width = max<u32>(src_width / 2, 1);
+            u32 dst_height = max<u32>(src_height / 2, 1);
+            FilterWeights weights_x;
+            FilterWeights weights_y;
+            compute_filter_weights(filter, src_width, dst_width, weights_x);
+            compute_filter_weights(filter, src_height, dst_height, weights_y);
+            bool srgb = test_flags(flags, ImageProcessFlag::srgb);
+            u32 num_tiles = (dst_height + ROWS_PER_TILE - 1) / ROWS_PER_TILE;
+            JobSystem::parallel_for(0, num_tiles, 1, [&](usize tile)
+            {
+                Vector<Float4> src_row;
+                Vector<Float4> column_sums;
+                Vector<Float4> dst_row;
+                src_row.resize(src_width);
+                column_sums.resize(src_width);
+                dst_row.resize(dst_width);
+                u32 begin = (u32)tile * ROWS_PER_TILE;
+                u32 end = min(begin + ROWS_PER_TILE, dst_height);
+                for (u32 y = begin; y < end; ++y)
+                {
+                    // Filters vertically.
+                    for (auto& v : column_sums) v = Float4(0.0f, 0.0f, 0.0f, 0.0f);
+                    auto range_y = weights_y.ranges[y];
+                    for (u32 k = range_y.first; k < range_y.first + range_y.second; ++k)
+                    {
+                        load_row(src_desc.format, (const u8*)src + src_row_pitch * weights_y.indices[k], src_width, src_row.data(), srgb);
+                        accumulate_row(column_sums.data(), src_row.data(), src_width, weights_y.weights[k]);
+                    }
+                    // Filters horizontally.
+                    for (u32 x = 0; x < dst_width; ++x)
+                    {
+                        Float4 sum(0.0f, 0.0f, 0.0f, 0.0f);
+                        auto range_x = weights_x.ranges[x];
+                        for (u32 k = range_x.first; k < range_x.first + range_x.second; ++k)
+                        {
+                            accumulate_row(&sum, &column_sums[weights_x.indices[k]], 1, weights_x.weights[k]);
+                        }
+                        dst_row[x] = sum;
+                    }
+                    store_row(src_desc.format, dst_row.data(), dst_width, (u8*)dst + dst_row_pitch * y, srgb);
+                }
+            });
+            return ok;
+        }
+
+        LUNA_IMAGE_API R<Vector<Blob>> generate_mip_chain(const ImageDesc& desc, const void* data, usize row_pitch, u32 mip_levels,
+            MipFilter filter, ImageProcessFlag flags)
+        {
+            Vector<Blob> mips;
+            lutry
+            {
+                if (desc.format == ImageFormat::unknown) return BasicError::bad_arguments();
+                if (!mip_levels)
+                {
+                    u32 size = max(desc.width, desc.height);
+                    mip_levels = 1;
+                    while (size > 1)
+                    {
+                        size >>= 1;
+                        ++mip_levels;
+                    }
+                }
+                usize src_row_size = (usize)desc.width * pixel_size(desc.format);
+                Blob mip0(src_row_size * desc.height);
+                memcpy_bitmap(mip0.data(), data, src_row_size, desc.height, src_row_size, row_pitch);
+                mips.push_back(move(mip0));
+                ImageDesc mip_desc = desc;
+                for (u32 i = 1; i < mip_levels; ++i)
+                {
+                    ImageDesc dst_desc = mip_desc;
+                    dst_desc.width = max<u32>(mip_desc.width / 2, 1);
+                    dst_desc.height = max<u32>(mip_desc.height / 2, 1);
+                    usize dst_row_size = (usize)dst_desc.width * pixel_size(desc.format);
+                    Blob mip(dst_row_size * dst_desc.height);
+                    luexp(generate_mip(mip_desc, mips.back().data(), (usize)mip_desc.width * pixel_size(desc.format),
+                        mip.data(), dst_row_size, filter, flags));
+                    mips.push_back(move(mip));
+                    mip_desc = dst_desc;
+                }
+            }
+            lucatchret;
+            return mips;
+        }
+    }
+}
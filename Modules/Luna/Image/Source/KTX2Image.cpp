@@ -0,0 +1,453 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file KTX2Image.cpp
+* @author JXMaster
+* @date 2024/4/18
+*/
+#include "Image.hpp"
+#include "DDSImage.hpp"
+#include "../KTX2Image.hpp"
+#include <Luna/Runtime/MemoryUtils.hpp>
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    namespace Image
+    {
+        constexpr u8 KTX2_IDENTIFIER[12] = { 0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32, 0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A };
+        // Mapped to file structure directly.
+        struct KTX2Header
+        {
+            u8 identifier[12];
+            u32 vk_format;
+            u32 type_size;
+            u32 pixel_width;
+            u32 pixel_height;
+            u32 pixel_depth;
+            u32 layer_count;
+            u32 face_count;
+            u32 level_count;
+            u32 supercompression_scheme;
+            u32 dfd_byte_offset;
+            u32 dfd_byte_length;
+            u32 kvd_byte_offset;
+            u32 kvd_byte_length;
+            u64 sgd_byte_offset;
+            u64 sgd_byte_length;
+        };
+        static_assert(sizeof(KTX2Header) == 80, "KTX2 header size check failed!");
+        struct KTX2LevelIndex
+        {
+            u64 byte_offset;
+            u64 byte_length;
+            u64 uncompressed_byte_length;
+        };
+        static_assert(sizeof(KTX2LevelIndex) == 24, "KTX2 level index size check failed!");
+
+        // Color models used by the data format descriptor.
+        constexpr u8 KHR_DF_MODEL_RGBSDA = 1;
+        constexpr u8 KHR_DF_MODEL_BC1A = 128;
+        constexpr u8 KHR_DF_MODEL_BC2 = 129;
+        constexpr u8 KHR_DF_MODEL_BC3 = 130;
+        constexpr u8 KHR_DF_MODEL_BC4 = 131;
+        constexpr u8 KHR_DF_MODEL_BC5 = 132;
+        constexpr u8 KHR_DF_MODEL_BC6H = 133;
+        constexpr u8 KHR_DF_MODEL_BC7 = 134;
+        // Channel IDs used by samples of the data format descriptor.
+        constexpr u8 CH_R = 0;
+        constexpr u8 CH_G = 1;
+        constexpr u8 CH_B = 2;
+        constexpr u8 CH_A = 15;
+        // Sample qualifiers.
+        constexpr u8 KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10;
+        constexpr u8 KHR_DF_SAMPLE_DATATYPE_SIGNED = 0x40;
+        constexpr u8 KHR_DF_SAMPLE_DATATYPE_FLOAT = 0x80;
+
+        enum class KTX2ValueType : u8
+        {
+            unorm,
+            snorm,
+            uint,
+            sint,
+            sfloat,
+            ufloat,
+        };
+        struct KTX2FormatInfo
+        {
+            DDSFormat dds_format;
+            u32 vk_format;
+            u8 color_model;
+            KTX2ValueType value_type;
+            bool srgb;
+            // The number of bytes of one pixel, or one block for block-compressed formats.
+            u8 block_size;
+            // Channels in memory order, from the lowest bit to the highest bit.
+            u8 num_channels;
+            u8 channels[4];
+            u8 bits[4];
+        };
+        using VT = KTX2ValueType;
+        static const KTX2FormatInfo g_ktx2_formats[] = {
+            { DDSFormat::r32g32b32a32_float, 109, KHR_DF_MODEL_RGBSDA, VT::sfloat, false, 16, 4, {CH_R, CH_G, CH_B, CH_A}, {32, 32, 32, 32} },
+            { DDSFormat::r32g32b32a32_uint, 107, KHR_DF_MODEL_RGBSDA, VT::uint, false, 16, 4, {CH_R, CH_G, CH_B, CH_A}, {32, 32, 32, 32} },
+            { DDSFormat::r32g32b32a32_sint, 108, KHR_DF_MODEL_RGBSDA, VT::sint, false, 16, 4, {CH_R, CH_G, CH_B, CH_A}, {32, 32, 32, 32} },
+            { DDSFormat::r32g32b32_float, 106, KHR_DF_MODEL_RGBSDA, VT::sfloat, false, 12, 3, {CH_R, CH_G, CH_B}, {32, 32, 32} },
+            { DDSFormat::r32g32b32_uint, 104, KHR_DF_MODEL_RGBSDA, VT::uint, false, 12, 3, {CH_R, CH_G, CH_B}, {32, 32, 32} },
+            { DDSFormat::r32g32b32_sint, 105, KHR_DF_MODEL_RGBSDA, VT::sint, false, 12, 3, {CH_R, CH_G, CH_B}, {32, 32, 32} },
+            { DDSFormat::r16g16b16a16_float, 97, KHR_DF_MODEL_RGBSDA, VT::sfloat, false, 8, 4, {CH_R, CH_G, CH_B, CH_A}, {16, 16, 16, 16} },
+            { DDSFormat::r16g16b16a16_unorm, 91, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 8, 4, {CH_R, CH_G, CH_B, CH_A}, {16, 16, 16, 16} },
+            { DDSFormat::r16g16b16a16_uint, 95, KHR_DF_MODEL_RGBSDA, VT::uint, false, 8, 4, {CH_R, CH_G, CH_B, CH_A}, {16, 16, 16, 16} },
+            { DDSFormat::r16g16b16a16_snorm, 92, KHR_DF_MODEL_RGBSDA, VT::snorm, false, 8, 4, {CH_R, CH_G, CH_B, CH_A}, {16, 16, 16, 16} },
+            { DDSFormat::r16g16b16a16_sint, 96, KHR_DF_MODEL_RGBSDA, VT::sint, false, 8, 4, {CH_R, CH_G, CH_B, CH_A}, {16, 16, 16, 16} },
+            { DDSFormat::r32g32_float, 103, KHR_DF_MODEL_RGBSDA, VT::sfloat, false, 8, 2, {CH_R, CH_G}, {32, 32} },
+            { DDSFormat::r32g32_uint, 101, KHR_DF_MODEL_RGBSDA, VT::uint, false, 8, 2, {CH_R, CH_G}, {32, 32} },
+            { DDSFormat::r32g32_sint, 102, KHR_DF_MODEL_RGBSDA, VT::sint, false, 8, 2, {CH_R, CH_G}, {32, 32} },
+            { DDSFormat::r10g10b10a2_unorm, 64, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 4, 4, {CH_R, CH_G, CH_B, CH_A}, {10, 10, 10, 2} },
+            { DDSFormat::r10g10b10a2_uint, 68, KHR_DF_MODEL_RGBSDA, VT::uint, false, 4, 4, {CH_R, CH_G, CH_B, CH_A}, {10, 10, 10, 2} },
+            { DDSFormat::r11g11b10_float, 122, KHR_DF_MODEL_RGBSDA, VT::ufloat, false, 4, 3, {CH_R, CH_G, CH_B}, {11, 11, 10} },
+            { DDSFormat::r8g8b8a8_unorm, 37, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 4, 4, {CH_R, CH_G, CH_B, CH_A}, {8, 8, 8, 8} },
+            { DDSFormat::r8g8b8a8_unorm_srgb, 43, KHR_DF_MODEL_RGBSDA, VT::unorm, true, 4, 4, {CH_R, CH_G, CH_B, CH_A}, {8, 8, 8, 8} },
+            { DDSFormat::r8g8b8a8_uint, 41, KHR_DF_MODEL_RGBSDA, VT::uint, false, 4, 4, {CH_R, CH_G, CH_B, CH_A}, {8, 8, 8, 8} },
+            { DDSFormat::r8g8b8a8_snorm, 38, KHR_DF_MODEL_RGBSDA, VT::snorm, false, 4, 4, {CH_R, CH_G, CH_B, CH_A}, {8, 8, 8, 8} },
+            { DDSFormat::r8g8b8a8_sint, 42, KHR_DF_MODEL_RGBSDA, VT::sint, false, 4, 4, {CH_R, CH_G, CH_B, CH_A}, {8, 8, 8, 8} },
+            { DDSFormat::b8g8r8a8_unorm, 44, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 4, 4, {CH_B, CH_G, CH_R, CH_A}, {8, 8, 8, 8} },
+            { DDSFormat::b8g8r8a8_unorm_srgb, 50, KHR_DF_MODEL_RGBSDA, VT::unorm, true, 4, 4, {CH_B, CH_G, CH_R, CH_A}, {8, 8, 8, 8} },
+            { DDSFormat::r16g16_float, 83, KHR_DF_MODEL_RGBSDA, VT::sfloat, false, 4, 2, {CH_R, CH_G}, {16, 16} },
+            { DDSFormat::r16g16_unorm, 77, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 4, 2, {CH_R, CH_G}, {16, 16} },
+            { DDSFormat::r16g16_uint, 81, KHR_DF_MODEL_RGBSDA, VT::uint, false, 4, 2, {CH_R, CH_G}, {16, 16} },
+            { DDSFormat::r16g16_snorm, 78, KHR_DF_MODEL_RGBSDA, VT::snorm, false, 4, 2, {CH_R, CH_G}, {16, 16} },
+            { DDSFormat::r16g16_sint, 82, KHR_DF_MODEL_RGBSDA, VT::sint, false, 4, 2, {CH_R, CH_G}, {16, 16} },
+            { DDSFormat::r32_float, 100, KHR_DF_MODEL_RGBSDA, VT::sfloat, false, 4, 1, {CH_R}, {32} },
+            { DDSFormat::r32_uint, 98, KHR_DF_MODEL_RGBSDA, VT::uint, false, 4, 1, {CH_R}, {32} },
+            { DDSFormat::r32_sint, 99, KHR_DF_MODEL_RGBSDA, VT::sint, false, 4, 1, {CH_R}, {32} },
+            { DDSFormat::r8g8_unorm, 16, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 2, 2, {CH_R, CH_G}, {8, 8} },
+            { DDSFormat::r8g8_uint, 20, KHR_DF_MODEL_RGBSDA, VT::uint, false, 2, 2, {CH_R, CH_G}, {8, 8} },
+            { DDSFormat::r8g8_snorm, 17, KHR_DF_MODEL_RGBSDA, VT::snorm, false, 2, 2, {CH_R, CH_G}, {8, 8} },
+            { DDSFormat::r8g8_sint, 21, KHR_DF_MODEL_RGBSDA, VT::sint, false, 2, 2, {CH_R, CH_G}, {8, 8} },
+            { DDSFormat::r16_float, 76, KHR_DF_MODEL_RGBSDA, VT::sfloat, false, 2, 1, {CH_R}, {16} },
+            { DDSFormat::r16_unorm, 70, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 2, 1, {CH_R}, {16} },
+            { DDSFormat::r16_uint, 74, KHR_DF_MODEL_RGBSDA, VT::uint, false, 2, 1, {CH_R}, {16} },
+            { DDSFormat::r16_snorm, 71, KHR_DF_MODEL_RGBSDA, VT::snorm, false, 2, 1, {CH_R}, {16} },
+            { DDSFormat::r16_sint, 75, KHR_DF_MODEL_RGBSDA, VT::sint, false, 2, 1, {CH_R}, {16} },
+            { DDSFormat::r8_unorm, 9, KHR_DF_MODEL_RGBSDA, VT::unorm, false, 1, 1, {CH_R}, {8} },
+            { DDSFormat::r8_uint, 13, KHR_DF_MODEL_RGBSDA, VT::uint, false, 1, 1, {CH_R}, {8} },
+            { DDSFormat::r8_snorm, 10, KHR_DF_MODEL_RGBSDA, VT::snorm, false, 1, 1, {CH_R}, {8} },
+            { DDSFormat::r8_sint, 14, KHR_DF_MODEL_RGBSDA, VT::sint, false, 1, 1, {CH_R}, {8} },
+            // Channel IDs of block-compressed formats are defined by their color models.
+            { DDSFormat::bc1_unorm, 133, KHR_DF_MODEL_BC1A, VT::unorm, false, 8, 1, {1}, {64} },
+            { DDSFormat::bc1_unorm_srgb, 134, KHR_DF_MODEL_BC1A, VT::unorm, true, 8, 1, {1}, {64} },
+            { DDSFormat::bc2_unorm, 135, KHR_DF_MODEL_BC2, VT::unorm, false, 16, 2, {15, 0}, {64, 64} },
+            { DDSFormat::bc2_unorm_srgb, 136, KHR_DF_MODEL_BC2, VT::unorm, true, 16, 2, {15, 0}, {64, 64} },
+            { DDSFormat::bc3_unorm, 137, KHR_DF_MODEL_BC3, VT::unorm, false, 16, 2, {15, 0}, {64, 64} },
+            { DDSFormat::bc3_unorm_srgb, 138, KHR_DF_MODEL_BC3, VT::unorm, true, 16, 2, {15, 0}, {64, 64} },
+            { DDSFormat::bc4_unorm, 139, KHR_DF_MODEL_BC4, VT::unorm, false, 8, 1, {0}, {64} },
+            { DDSFormat::bc4_snorm, 140, KHR_DF_MODEL_BC4, VT::snorm, false, 8, 1, {0}, {64} },
+            { DDSFormat::bc5_unorm, 141, KHR_DF_MODEL_BC5, VT::unorm, false, 16, 2, {0, 1}, {64, 64} },
+            { DDSFormat::bc5_snorm, 142, KHR_DF_MODEL_BC5, VT::snorm, false, 16, 2, {0, 1}, {64, 64} },
+            { DDSFormat::bc6h_uf16, 143, KHR_DF_MODEL_BC6H, VT::ufloat, false, 16, 1, {0}, {128} },
+            { DDSFormat::bc6h_sf16, 144, KHR_DF_MODEL_BC6H, VT::sfloat, false, 16, 1, {0}, {128} },
+            { DDSFormat::bc7_unorm, 145, KHR_DF_MODEL_BC7, VT::unorm, false, 16, 1, {0}, {128} },
+            { DDSFormat::bc7_unorm_srgb, 146, KHR_DF_MODEL_BC7, VT::unorm, true, 16, 1, {0}, {128} },
+        };
+        static const KTX2FormatInfo* get_ktx2_format_info(DDSFormat format)
+        {
+            // Typeless formats are stored as their UNORM variants.
+            switch (format)
+            {
+            case DDSFormat::bc1_typeless: format = DDSFormat::bc1_unorm; break;
+            case DDSFormat::bc2_typeless: format = DDSFormat::bc2_unorm; break;
+            case DDSFormat::bc3_typeless: format = DDSFormat::bc3_unorm; break;
+            case DDSFormat::bc4_typeless: format = DDSFormat::bc4_unorm; break;
+            case DDSFormat::bc5_typeless: format = DDSFormat::bc5_unorm; break;
+            case DDSFormat::bc7_typeless: format = DDSFormat::bc7_unorm; break;
+            case DDSFormat::r8g8b8a8_typeless: format = DDSFormat::r8g8b8a8_unorm; break;
+            case DDSFormat::b8g8r8a8_typeless: format = DDSFormat::b8g8r8a8_unorm; break;
+            default: break;
+            }
+            for (auto& info : g_ktx2_formats)
+            {
+                if (info.dds_format == format) return &info;
+            }
+            return nullptr;
+        }
+        LUNA_IMAGE_API u32 dds_to_ktx2_format(DDSFormat format)
+        {
+            auto info = get_ktx2_format_info(format);
+            return info ? info->vk_format : 0;
+        }
+        LUNA_IMAGE_API DDSFormat ktx2_to_dds_format(u32 vk_format)
+        {
+            for (auto& info : g_ktx2_formats)
+            {
+                if (info.vk_format == vk_format) return info.dds_format;
+            }
+            return DDSFormat::unknown;
+        }
+        LUNA_IMAGE_API bool is_ktx2_file(const void* data, usize data_size)
+        {
+            return data && data_size >= sizeof(KTX2_IDENTIFIER) && !memcmp(data, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+        }
+        LUNA_IMAGE_API R<DDSImageDesc> read_ktx2_image_file_desc(const void* data, usize data_size)
+        {
+            lucheck(data && data_size);
+#ifndef LUNA_PLATFORM_LITTLE_ENDIAN
+            return set_error(BasicError::not_supported(), "read_ktx2_image_file_desc is not implemented on big endian platforms");
+#else
+            if (data_size < sizeof(KTX2Header))
+            {
+                return set_error(BasicError::bad_data(), "Invalid KTX2 file data.");
+            }
+            if (!is_ktx2_file(data, data_size))
+            {
+                return set_error(BasicError::bad_data(), "KTX2 file identifier check failed.");
+            }
+            const KTX2Header* header = (const KTX2Header*)data;
+            if (header->supercompression_scheme != 0)
+            {
+                return set_error(BasicError::not_supported(), "KTX2 supercompression scheme %u is not supported.", header->supercompression_scheme);
+            }
+            DDSImageDesc desc;
+            memzero(&desc);
+            desc.format = ktx2_to_dds_format(header->vk_format);
+            if (desc.format == DDSFormat::unknown)
+            {
+                return set_error(BasicError::not_supported(), "KTX2 format %u is not supported.", header->vk_format);
+            }
+            if (header->face_count != 1 && header->face_count != 6)
+            {
+                return BasicError::bad_data();
+            }
+            desc.width = header->pixel_width;
+            desc.height = max<u32>(header->pixel_height, 1);
+            desc.depth = max<u32>(header->pixel_depth, 1);
+            desc.array_size = max<u32>(header->layer_count, 1) * header->face_count;
+            // Level count 0 requests the loader to generate mips, which is not done here.
+            desc.mip_levels = max<u32>(header->level_count, 1);
+            if (header->pixel_depth) desc.dimension = DDSDimension::tex3d;
+            else if (header->pixel_height) desc.dimension = DDSDimension::tex2d;
+            else desc.dimension = DDSDimension::tex1d;
+            desc.flags = header->face_count == 6 ? DDSFlag::texturecube : DDSFlag::none;
+            auto r = validate_dds_image_desc(desc);
+            if (failed(r)) return r.errcode();
+            return desc;
+#endif
+        }
+        LUNA_IMAGE_API R<DDSImage> read_ktx2_image(const void* data, usize data_size)
+        {
+            DDSImage r;
+            lutry
+            {
+                DDSImageDesc desc;
+                luset(desc, read_ktx2_image_file_desc(data, data_size));
+                usize level_index_size = sizeof(KTX2LevelIndex) * desc.mip_levels;
+                if (data_size < sizeof(KTX2Header) + level_index_size)
+                {
+                    return BasicError::end_of_file();
+                }
+                const KTX2LevelIndex* levels = (const KTX2LevelIndex*)((const byte_t*)data + sizeof(KTX2Header));
+                luset(r, new_dds_image(desc));
+                for (u32 mip = 0; mip < desc.mip_levels; ++mip)
+                {
+                    const KTX2LevelIndex& level = levels[mip];
+                    if (level.byte_offset > data_size || level.byte_length > data_size - level.byte_offset)
+                    {
+                        return BasicError::end_of_file();
+                    }
+                    // Images in one level are ordered by layers then faces, which matches the array slice order of DDS images.
+                    const byte_t* src = (const byte_t*)data + level.byte_offset;
+                    usize level_size = 0;
+                    for (u32 item = 0; item < desc.array_size; ++item)
+                    {
+                        auto& subresource = r.subresources[calc_dds_subresoruce_index(mip, item, desc.mip_levels)];
+                        level_size += subresource.slice_pitch * subresource.depth;
+                    }
+                    if (level_size != level.byte_length)
+                    {
+                        return BasicError::bad_data();
+                    }
+                    for (u32 item = 0; item < desc.array_size; ++item)
+                    {
+                        auto& subresource = r.subresources[calc_dds_subresoruce_index(mip, item, desc.mip_levels)];
+                        usize size = subresource.slice_pitch * subresource.depth;
+                        memcpy((byte_t*)r.data.data() + subresource.data_offset, src, size);
+                        src += size;
+                    }
+                }
+            }
+            lucatchret;
+            return r;
+        }
+
+        static u32 get_ktx2_type_size(const KTX2FormatInfo& info)
+        {
+            if (info.color_model != KHR_DF_MODEL_RGBSDA) return 1;
+            // Packed formats.
+            if (info.bits[0] != info.bits[info.num_channels - 1]) return 4;
+            return info.bits[0] / 8;
+        }
+        static void get_ktx2_sample_range(const KTX2FormatInfo& info, u32 bits, u32& lower, u32& upper)
+        {
+            // Samples of block-compressed formats use the full 32-bit range.
+            if (info.color_model != KHR_DF_MODEL_RGBSDA) bits = 32;
+            switch (info.value_type)
+            {
+            case KTX2ValueType::unorm:
+                lower = 0;
+                upper = bits >= 32 ? U32_MAX : (1u << bits) - 1;
+                break;
+            case KTX2ValueType::snorm:
+                upper = bits >= 32 ? 0x7FFFFFFF : (1u << (bits - 1)) - 1;
+                lower = (u32)(-(i32)upper);
+                break;
+            case KTX2ValueType::uint: lower = 0; upper = 1; break;
+            case KTX2ValueType::sint: lower = U32_MAX; upper = 1; break;
+            // -1.0f and 1.0f.
+            case KTX2ValueType::sfloat: lower = 0xBF800000; upper = 0x3F800000; break;
+            case KTX2ValueType::ufloat: lower = 0; upper = 0x3F800000; break;
+            }
+        }
+        // Builds the data format descriptor, including the leading total size field.
+        static Vector<u32> build_ktx2_dfd(const KTX2FormatInfo& info)
+        {
+            Vector<u32> dfd;
+            bool compressed = info.color_model != KHR_DF_MODEL_RGBSDA;
+            u32 block_size = 24 + 16 * info.num_channels;
+            dfd.push_back(4 + block_size);
+            // Vendor ID and descriptor type are both 0 (Khronos basic descriptor).
+            dfd.push_back(0);
+            // Version number 2 of the basic descriptor.
+            dfd.push_back(2 | (block_size << 16));
+            // Color model, BT.709 color primaries, transfer function and straight alpha.
+            dfd.push_back((u32)info.color_model | (1u << 8) | ((info.srgb ? 2u : 1u) << 16));
+            // Texel block dimensions minus one.
+            dfd.push_back(compressed ? 0x0303 : 0);
+            // Bytes of plane 0.
+            dfd.push_back(info.block_size);
+            dfd.push_back(0);
+            u32 bit_offset = 0;
+            for (u32 i = 0; i < info.num_channels; ++i)
+            {
+                u8 channel_type = info.channels[i];
+                if (info.value_type == KTX2ValueType::snorm || info.value_type == KTX2ValueType::sint || info.value_type == KTX2ValueType::sfloat)
+                {
+                    channel_type |= KHR_DF_SAMPLE_DATATYPE_SIGNED;
+                }
+                if (info.value_type == KTX2ValueType::sfloat || info.value_type == KTX2ValueType::ufloat)
+                {
+                    channel_type |= KHR_DF_SAMPLE_DATATYPE_FLOAT;
+                }
+                // Alpha channels are always linear.
+                if (info.srgb && info.channels[i] == CH_A && !compressed)
+                {
+                    channel_type |= KHR_DF_SAMPLE_DATATYPE_LINEAR;
+                }
+                dfd.push_back(bit_offset | ((u32)(info.bits[i] - 1) << 16) | ((u32)channel_type << 24));
+                // Sample position.
+                dfd.push_back(0);
+                u32 lower, upper;
+                get_ktx2_sample_range(info, info.bits[i], lower, upper);
+                dfd.push_back(lower);
+                dfd.push_back(upper);
+                bit_offset += info.bits[i];
+            }
+            return dfd;
+        }
+        static RV write_ktx2_padding(ISeekableStream* stream, usize size)
+        {
+            const u8 zeros[16] = { 0 };
+            luassert(size <= 16);
+            return size ? stream->write(zeros, size) : ok;
+        }
+        LUNA_IMAGE_API RV write_ktx2_file(ISeekableStream* stream, const DDSImage& image)
+        {
+            lutry
+            {
+                const DDSImageDesc& desc = image.desc;
+                const KTX2FormatInfo* info = get_ktx2_format_info(desc.format);
+                if (!info) return BasicError::not_supported();
+                if (image.subresources.size() != (usize)desc.array_size * desc.mip_levels)
+                {
+                    return BasicError::bad_arguments();
+                }
+                u32 face_count = test_flags(desc.flags, DDSFlag::texturecube) ? 6 : 1;
+                u32 layer_count = desc.array_size / face_count;
+                Vector<u32> dfd = build_ktx2_dfd(*info);
+                KTX2Header header;
+                memzero(&header);
+                memcpy(header.identifier, KTX2_IDENTIFIER, sizeof(KTX2_IDENTIFIER));
+                header.vk_format = info->vk_format;
+                header.type_size = get_ktx2_type_size(*info);
+                header.pixel_width = desc.width;
+                header.pixel_height = desc.dimension == DDSDimension::tex1d ? 0 : desc.height;
+                header.pixel_depth = desc.dimension == DDSDimension::tex3d ? desc.depth : 0;
+                header.layer_count = layer_count > 1 ? layer_count : 0;
+                header.face_count = face_count;
+                header.level_count = desc.mip_levels;
+                header.supercompression_scheme = 0;
+                header.dfd_byte_offset = (u32)(sizeof(KTX2Header) + sizeof(KTX2LevelIndex) * desc.mip_levels);
+                header.dfd_byte_length = (u32)(dfd.size() * sizeof(u32));
+                // Level data must be aligned to the least common multiple of the texel block size and 4.
+                usize alignment = info->block_size % 4 == 0 ? info->block_size : info->block_size * (info->block_size % 2 == 0 ? 2 : 4);
+                Vector<KTX2LevelIndex> levels;
+                levels.resize(desc.mip_levels);
+                // Levels are stored from the smallest mip to the largest mip.
+                usize offset = header.dfd_byte_offset + header.dfd_byte_length;
+                for (u32 i = desc.mip_levels; i > 0; --i)
+                {
+                    u32 mip = i - 1;
+                    offset = align_upper(offset, alignment);
+                    usize level_size = 0;
+                    for (u32 item = 0; item < desc.array_size; ++item)
+                    {
+                        auto& subresource = image.subresources[calc_dds_subresoruce_index(mip, item, desc.mip_levels)];
+                        usize row_pitch, slice_pitch;
+                        luexp(compute_pitch(desc.format, subresource.width, subresource.height, row_pitch, slice_pitch));
+                        level_size += slice_pitch * subresource.depth;
+                    }
+                    levels[mip].byte_offset = offset;
+                    levels[mip].byte_length = level_size;
+                    levels[mip].uncompressed_byte_length = level_size;
+                    offset += level_size;
+                }
+                luexp(stream->write(&header, sizeof(KTX2Header)));
+                luexp(stream->write(levels.data(), sizeof(KTX2LevelIndex) * levels.size()));
+                luexp(stream->write(dfd.data(), dfd.size() * sizeof(u32)));
+                offset = header.dfd_byte_offset + header.dfd_byte_length;
+                for (u32 i = desc.mip_levels; i > 0; --i)
+                {
+                    u32 mip = i - 1;
+                    luexp(write_ktx2_padding(stream, (usize)levels[mip].byte_offset - offset));
+                    offset = (usize)levels[mip].byte_offset;
+                    for (u32 item = 0; item < desc.array_size; ++item)
+                    {
+                        auto& subresource = image.subresources[calc_dds_subresoruce_index(mip, item, desc.mip_levels)];
+                        usize row_pitch, slice_pitch;
+                        luexp(compute_pitch(desc.format, subresource.width, subresource.height, row_pitch, slice_pitch));
+                        if (subresource.row_pitch < row_pitch || subresource.data_offset >= image.data.size())
+                        {
+                            return BasicError::bad_arguments();
+                        }
+                        // KTX2 stores rows without padding.
+                        usize num_rows = slice_pitch / row_pitch;
+                        const u8* src = (const u8*)image.data.data() + subresource.data_offset;
+                        for (u32 z = 0; z < subresource.depth; ++z)
+                        {
+                            const u8* row = src + subresource.slice_pitch * z;
+                            for (usize y = 0; y < num_rows; ++y)
+                            {
+                                luexp(stream->write(row, row_pitch));
+                                row += subresource.row_pitch;
+                            }
+                        }
+                        offset += slice_pitch * subresource.depth;
+                    }
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+    }
+}
@@ -9,10 +9,19 @@
 */
 #pragma once
 #include <Luna/Runtime/Base.hpp>
+#include <Luna/Runtime/Interface.hpp>
+#include <Luna/Runtime/Ref.hpp>
+#include <Luna/Runtime/Span.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/Profiler.hpp>
 #ifndef LUNA_JOBSYSTEM_API
 #define LUNA_JOBSYSTEM_API
 #endif
 
+#if (defined(LUNA_ENABLE_JOB_SYSTEM_PROFILER) || (LUNA_DEBUG_LEVEL >= LUNA_DEBUG_LEVEL_PROFILE))
+#define LUNA_JOB_SYSTEM_PROFILER_ENABLED
+#endif
+
 namespace Luna
 {
     namespace JobSystem
@@ -22,6 +31,8 @@ namespace Luna
         //! @{
         
         //! Identifies one job that can be waited.
+        //! @remark Job IDs of finished jobs are recycled by the job system. One job ID can still be used to check the state of 
+        //! the job after the job is finished, but it may compare equal to one job ID allocated afterwards.
         using job_id_t = u64;
 
         //! A special ID that identifies one invalid job.
@@ -31,6 +42,72 @@ namespace Luna
         //! @param[in] params The parameter passed to @ref submit_job.
         using job_func_t = void(void* params);
 
+        //! Specifies the priority of one job.
+        enum class JobPriority : u8
+        {
+            //! Jobs that are critical to frame latency. High priority jobs are always consumed before normal and background jobs.
+            high = 0,
+            //! The default priority.
+            normal = 1,
+            //! Jobs that can be delayed, background jobs are consumed only when no high or normal job is available.
+            background = 2,
+            //! Jobs that may block the thread for a long time, like file IO. IO jobs are executed only by IO workers reserved by 
+            //! @ref JobSystemConfig::num_io_workers, so that they never occupy normal workers. If no IO worker is reserved, IO jobs are 
+            //! executed as background jobs.
+            io = 3,
+        };
+
+        //! Describes the configuration of the job system.
+        struct JobSystemConfig
+        {
+            //! The number of worker threads created for executing normal jobs.
+            //! If this is `U32_MAX`, `get_processors_count() - 1` workers are created, so that every processor runs one worker 
+            //! thread together with the main thread.
+            u32 num_workers = U32_MAX;
+            //! The processor affinity masks of worker threads. The Nth element is used as the affinity mask of the Nth worker thread.
+            //! See @ref IThread::set_affinity for details about the mask format.
+            //! @details If this is empty and `pin_workers` is `true`, the Nth worker is pinned to the (N + 1)th logical processor, 
+            //! leaving the first processor for the main thread. If this is empty and `pin_workers` is `false`, workers are 
+            //! scheduled by the system freely. Masks are copied when @ref set_config is called, so the memory does not need to be valid 
+            //! after @ref set_config returns.
+            //! 
+            //! Pinned workers steal jobs from workers in the same cache domain (see @ref get_processor_cache_domain) before
+            //! stealing jobs from workers in other cache domains.
+            Span<const u64> worker_affinities;
+            //! Whether to pin worker threads to processors if `worker_affinities` is empty.
+            bool pin_workers = false;
+            //! The processor affinity mask of IO worker threads. `0` means that IO workers can run on all processors.
+            u64 io_worker_affinity = 0;
+            //! The number of worker threads reserved for IO jobs.
+            u32 num_io_workers = 2;
+            //! Whether to run jobs on fibers in worker threads.
+            //! @details If this is `true`, every job executed by one worker thread is run on one fiber. When the job calls @ref wait_job
+            //! for one unfinished job, the fiber of the job is suspended and the worker continues to run other jobs on other fibers. The 
+            //! suspended fiber is resumed, possibly on another worker thread, when the waited job is finished. This prevents the stack 
+            //! of one worker from growing when jobs wait for other jobs, and prevents one waiting job from being blocked by unrelated jobs 
+            //! executed by the waiting thread.
+            //! 
+            //! If this is `false`, @ref wait_job executes other jobs on the stack of the waiting thread until the waited job is finished.
+            //! 
+            //! Jobs running on fibers may be resumed on another thread after calling @ref wait_job, so they must not keep thread-local 
+            //! data or hold locks that are bound to threads across @ref wait_job calls. Jobs executed by IO workers and user threads are 
+            //! never run on fibers.
+            bool enable_fibers = false;
+            //! The stack size of every job fiber. If this is `0`, the default fiber stack size is used.
+            u32 fiber_stack_size = 0;
+            //! The number of times one idle worker thread polls job queues before it is parked.
+            //! @details Idle workers poll job queues with exponential backoff for this many times before they are parked, 
+            //! so that jobs submitted shortly after the worker becomes idle can be picked up without waking the thread from the 
+            //! operating system. Set this to `0` to park idle workers immediately.
+            u32 worker_spin_count = 64;
+        };
+
+        //! Sets the configuration of the job system.
+        //! @param[in] config The configuration to set.
+        //! @par Valid Usage
+        //! * This must be called before the job system module is initialized. The configuration takes effect when the module is initialized.
+        LUNA_JOBSYSTEM_API void set_config(const JobSystemConfig& config);
+
         //! Allocates one job ID, so that other threads can wait for it by calling @ref wait_job.
         //! @return Returns the allocated job ID.
         //! @remark This function is called internally by the job system for all jobs submitted by @ref submit_job, so the user doesn't need to call this function manually.
@@ -54,15 +131,78 @@ namespace Luna
         //! job will wait this job as well.
         //! @return Returns the parameter block pointer of the created job. The parameter block data is uninitialized and should be 
         //! initialized by the user.
+        //! @remark Parameter blocks of small jobs are allocated from thread-local, size-classed free lists, and are given back to the free 
+        //! lists when jobs are finished, so creating small jobs does not call @ref memalloc in most cases.
         LUNA_JOBSYSTEM_API void* new_job(job_func_t* func, usize param_size, usize param_alignment, void* parent = nullptr);
 
+        //! @interface IJobArena
+        //! Represents one linear memory arena that can be used to allocate parameter blocks for jobs.
+        //! @details Parameter blocks allocated from one arena are not freed when jobs are finished. Instead, all memory allocated from the 
+        //! arena is reclaimed when @ref IJobArena::reset is called, which is usually called once per frame.
+        //! @threadsafe
+        struct IJobArena : virtual Interface
+        {
+            luiid("{a3404796-2f7c-4d4f-b1ba-151c08babf8b}");
+
+            //! Reclaims all memory allocated from this arena, so that the memory can be reused by new jobs.
+            //! @details The memory blocks of the arena are kept and reused after reset.
+            //! @par Valid Usage
+            //! * All jobs allocated from this arena must be finished before this function is called.
+            //! * No other thread can allocate jobs from this arena when this function is called.
+            virtual void reset() = 0;
+        };
+
+        //! Creates a new job arena.
+        //! @param[in] block_size The size of one memory block of the arena. The arena allocates new blocks when 
+        //! the current block is exhausted.
+        //! @return Returns the created job arena.
+        LUNA_JOBSYSTEM_API Ref<IJobArena> new_job_arena(usize block_size = 65536);
+
+        //! Creates a new job whose parameter block is allocated from the specified job arena.
+        //! @param[in] arena The job arena to allocate the parameter block from. The arena is not retained by the job, 
+        //! so the user should keep the arena alive until the job is finished.
+        //! @param[in] func The job callback function to invoke.
+        //! @param[in] param_size The size of the parameter block.
+        //! @param[in] param_alignment The alignment of the parameter block.
+        //! @param[in] parent The optional parameter pointer of the parent job. See @ref new_job for details.
+        //! @return Returns the parameter block pointer of the created job. The parameter block data is uninitialized and should be 
+        //! initialized by the user.
+        LUNA_JOBSYSTEM_API void* new_job(IJobArena* arena, job_func_t* func, usize param_size, usize param_alignment, void* parent = nullptr);
+
         //! Submits the job to the job system.
         //! @param[in] params The parameter block pointer of the job. Every job can only be submitted once.
         //! If the parameter block is not trivially destructable, the user must destruct the parameter block manually at the end of the
         //! job callback function.
+        //! @param[in] priority The priority of the job.
         //! @return Returns the job ID for the submitted job, which can be used to wait for the job using @ref wait_job, or check whether
         //! the job is finished using @ref is_job_finished.
-        LUNA_JOBSYSTEM_API job_id_t submit_job(void* params);
+        LUNA_JOBSYSTEM_API job_id_t submit_job(void* params, JobPriority priority = JobPriority::normal);
+
+        //! Submits the job to the job system, and schedules the job only after all the specified jobs are finished.
+        //! @param[in] params The parameter block pointer of the job. Every job can only be submitted once.
+        //! @param[in] wait_jobs The IDs of jobs that must be finished before this job can be executed. This can be both job IDs
+        //! returned by @ref submit_job and job IDs allocated by @ref allocate_job_id. Invalid or finished job IDs are ignored.
+        //! @param[in] priority The priority of the job.
+        //! @return Returns the job ID for the submitted job. The returned job ID can be waited by other jobs and threads 
+        //! before the job is scheduled, so one dependency graph can be built by submitting jobs in order.
+        //! @remark This function does not block the current thread. When the last job in `wait_jobs` is finished, the job 
+        //! is pushed to the job queue of the thread that finishes it.
+        LUNA_JOBSYSTEM_API job_id_t submit_job(void* params, Span<const job_id_t> wait_jobs, JobPriority priority = JobPriority::normal);
+
+        //! Submits multiple jobs to the job system at once.
+        //! @param[in] jobs The parameter block pointers of jobs to submit. Every job can only be submitted once.
+        //! @param[out] out_job_ids If not `nullptr`, this should point to an array with at least `jobs.size()` elements, 
+        //! and receives the job IDs of submitted jobs in the same order as `jobs`.
+        //! @param[in] priority The priority of all submitted jobs.
+        //! @remark This function behaves like calling @ref submit_job for every job, but wakes up the required number of parked
+        //! workers only once after all jobs are pushed, which is cheaper than waking workers one by one.
+        LUNA_JOBSYSTEM_API void submit_jobs(Span<void*> jobs, job_id_t* out_job_ids = nullptr, JobPriority priority = JobPriority::normal);
+
+        //! Sets the name of the job, which is reported in job system profiler events.
+        //! @param[in] params The parameter block pointer of the job.
+        //! @param[in] name The name of the job. The string is referred by the job directly without being copied, so it must be valid 
+        //! until the job is finished. String literals are recommended.
+        LUNA_JOBSYSTEM_API void set_job_name(void* params, const c8* name);
 
         //! Fetches the job ID assigned with the specified job.
         //! @param[in] params The parameter block pointer of the job.
@@ -72,8 +212,91 @@ namespace Luna
 
         //! Blocks the current thread to wait for the job to finish.
         //! @param[in] job The job ID to wait. If this is @ref INVALID_JOB_ID, this call returns immediately.
+        //! @remark If this is called by one job running on one fiber (see @ref JobSystemConfig::enable_fibers), the fiber is suspended
+        //! until the job is finished, and the worker thread executes other jobs meanwhile. Otherwise, the current thread executes other 
+        //! jobs until the job is finished.
         LUNA_JOBSYSTEM_API void wait_job(job_id_t job);
 
+        //! The statistics of one thread that executes jobs.
+        //! @details All time values are measured in ticks. Use @ref get_ticks_per_second to convert them to seconds.
+        struct WorkerStats
+        {
+            //! `true` if the thread is one worker thread created by the job system, `false` if the thread is one user 
+            //! thread that submits or waits for jobs.
+            bool is_worker;
+            //! `true` if the thread is one IO worker thread.
+            bool is_io_worker;
+            //! The number of jobs executed by this thread.
+            u64 num_jobs_executed;
+            //! The number of jobs stolen from other threads.
+            u64 num_steals;
+            //! The number of times this thread tries to steal jobs from all other threads but finds no job.
+            u64 num_failed_steals;
+            //! The number of times this worker is parked because no job is available.
+            u64 num_parks;
+            //! The time spent on executing jobs.
+            u64 busy_ticks;
+            //! The time spent on being parked.
+            u64 parked_ticks;
+            //! The number of jobs in the job queues of this thread when the statistics are fetched.
+            usize num_queued_jobs;
+        };
+
+        //! Gets statistics of all threads that execute jobs.
+        //! @return Returns one statistics entry for every thread context of the job system.
+        //! @remark Counters are updated by every thread without synchronization, so the returned values may be slightly 
+        //! outdated. Counters are accumulated from the time the job system is initialized, the user can compute rates by 
+        //! computing differences between two snapshots.
+        LUNA_JOBSYSTEM_API Vector<WorkerStats> get_worker_stats();
+
+        //! Profiler event IDs emitted by the job system.
+        //! @remark Job system profiler events are only emitted if `LUNA_JOB_SYSTEM_PROFILER_ENABLED` is defined, which is defined
+        //! in debug and profile builds, or when `LUNA_ENABLE_JOB_SYSTEM_PROFILER` is defined. @ref get_worker_stats is always available.
+        namespace ProfilerEventId
+        {
+            //! Emitted when one job starts to execute. The event data is @ref ProfilerEventData::JobBegin.
+            constexpr u64 JOB_BEGIN = strhash64("JOB_SYSTEM_JOB_BEGIN");
+            //! Emitted when one job finishes executing its callback function. The event data is @ref ProfilerEventData::JobEnd.
+            constexpr u64 JOB_END = strhash64("JOB_SYSTEM_JOB_END");
+            //! Emitted when one thread steals one job from another thread. The event data is @ref ProfilerEventData::JobSteal.
+            constexpr u64 JOB_STEAL = strhash64("JOB_SYSTEM_JOB_STEAL");
+            //! Emitted when one thread tries to steal jobs from all other threads but finds no job. This event has no data.
+            constexpr u64 JOB_STEAL_FAILED = strhash64("JOB_SYSTEM_JOB_STEAL_FAILED");
+            //! Emitted when one worker thread is going to be parked. This event has no data.
+            constexpr u64 WORKER_PARK = strhash64("JOB_SYSTEM_WORKER_PARK");
+            //! Emitted when one parked worker thread is woken up. This event has no data.
+            constexpr u64 WORKER_UNPARK = strhash64("JOB_SYSTEM_WORKER_UNPARK");
+        }
+        namespace ProfilerEventData
+        {
+            //! The job begin event data.
+            struct JobBegin
+            {
+                //! The ID of the job.
+                job_id_t job;
+                //! The name of the job set by @ref set_job_name, or `nullptr` if the job does not have a name.
+                const c8* name;
+            };
+            //! The job end event data.
+            struct JobEnd
+            {
+                //! The ID of the job.
+                job_id_t job;
+            };
+            //! The job steal event data.
+            struct JobSteal
+            {
+                //! The ID of the stolen job.
+                job_id_t job;
+            };
+        }
+
+        //! Gets the number of jobs that are submitted but not yet consumed in the job queue of the current thread.
+        //! @return Returns the number of jobs in the job queue of the current thread. 
+        //! @remark The returned value is an estimation since other threads may steal jobs from the queue at any time. 
+        //! This is mainly used by scheduling algorithms like lazy binary splitting to decide whether to generate more jobs for idle threads.
+        LUNA_JOBSYSTEM_API usize get_num_local_jobs();
+
         //! Checks whether the specified job is finished.
         //! @param[in] job The job ID to check. If this is @ref INVALID_JOB_ID, this call always return `true`.
         //! @return Returns `true` if the job is finished, `false` otherwise.
@@ -0,0 +1,177 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Parallel.hpp
+* @author JXMaster
+* @date 2024/3/5
+*/
+#pragma once
+#include "JobSystem.hpp"
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Thread.hpp>
+
+namespace Luna
+{
+    namespace JobSystem
+    {
+        //! @addtogroup JobSystem
+        //! @{
+
+        namespace Impl
+        {
+            inline usize get_parallel_grain_size(usize count, usize grain)
+            {
+                if (grain) return grain;
+                // Generates about 8 chunks per processor, so that the work can be balanced between threads.
+                usize num_chunks = (usize)get_processors_count() * 8;
+                return max<usize>(count / num_chunks, 1);
+            }
+
+            template <typename _Ctx>
+            struct ParallelRangeJob
+            {
+                _Ctx* ctx;
+                usize begin;
+                usize end;
+            };
+
+            //! Executes the range using lazy binary splitting: the job processes its range in chunks of `grain` size, and splits
+            //! the remaining range in half whenever the local job queue is empty, so that idle threads can steal the split range.
+            template <typename _Ctx>
+            void parallel_range_job(void* params)
+            {
+                ParallelRangeJob<_Ctx>* job = (ParallelRangeJob<_Ctx>*)params;
+                _Ctx* ctx = job->ctx;
+                usize begin = job->begin;
+                usize end = job->end;
+                typename _Ctx::local_state_t state = ctx->begin_range();
+                while (begin < end)
+                {
+                    if (end - begin > ctx->grain && get_num_local_jobs() == 0)
+                    {
+                        usize mid = begin + (end - begin) / 2;
+                        ParallelRangeJob<_Ctx>* split = (ParallelRangeJob<_Ctx>*)new_job(parallel_range_job<_Ctx>,
+                            sizeof(ParallelRangeJob<_Ctx>), alignof(ParallelRangeJob<_Ctx>), params);
+                        split->ctx = ctx;
+                        split->begin = mid;
+                        split->end = end;
+                        submit_job(split);
+                        end = mid;
+                        continue;
+                    }
+                    usize chunk_end = min(begin + ctx->grain, end);
+                    ctx->execute(state, begin, chunk_end);
+                    begin = chunk_end;
+                }
+                ctx->end_range(state);
+            }
+
+            template <typename _Ctx>
+            void run_parallel_range(_Ctx* ctx, usize begin, usize end)
+            {
+                ParallelRangeJob<_Ctx>* job = (ParallelRangeJob<_Ctx>*)new_job(parallel_range_job<_Ctx>,
+                    sizeof(ParallelRangeJob<_Ctx>), alignof(ParallelRangeJob<_Ctx>));
+                job->ctx = ctx;
+                job->begin = begin;
+                job->end = end;
+                // Jobs generated by splitting are children of the root job, so waiting for the root job waits for all of them.
+                wait_job(submit_job(job));
+            }
+
+            template <typename _Func>
+            struct ParallelForContext
+            {
+                using local_state_t = bool;
+                _Func* func;
+                usize grain;
+
+                local_state_t begin_range() { return true; }
+                void execute(local_state_t&, usize begin, usize end)
+                {
+                    for (usize i = begin; i < end; ++i)
+                    {
+                        (*func)(i);
+                    }
+                }
+                void end_range(local_state_t&) {}
+            };
+
+            template <typename _Ty, typename _Func, typename _ReduceFunc>
+            struct ParallelReduceContext
+            {
+                using local_state_t = _Ty;
+                _Func* func;
+                _ReduceFunc* reduce;
+                const _Ty* identity;
+                _Ty result;
+                SpinLock lock;
+                usize grain;
+
+                local_state_t begin_range() { return *identity; }
+                void execute(local_state_t& state, usize begin, usize end)
+                {
+                    for (usize i = begin; i < end; ++i)
+                    {
+                        state = (*reduce)(move(state), (*func)(i));
+                    }
+                }
+                void end_range(local_state_t& state)
+                {
+                    LockGuard guard(lock);
+                    result = (*reduce)(move(result), move(state));
+                }
+            };
+        }
+
+        //! Invokes the specified function for every index in [`begin`, `end`) using multiple threads.
+        //! @param[in] begin The first index to process.
+        //! @param[in] end The index after the last index to process.
+        //! @param[in] grain The minimum number of indices processed by one job at a time.
+        //! If this is `0`, the grain size is computed from the number of indices and the number of processors.
+        //! @param[in] func The function to invoke. The function signature must be `void(usize index)`. The function may be
+        //! called on multiple threads concurrently.
+        //! @remark This function blocks until all indices are processed. The current thread also executes jobs while waiting.
+        //!
+        //! The range is split lazily: one job only splits its remaining range when its local job queue is empty, so that
+        //! the number of generated jobs adapts to the number of idle threads. The function object is referred by all jobs
+        //! directly and is never copied, so the function captures are never allocated on heap.
+        template <typename _Func>
+        void parallel_for(usize begin, usize end, usize grain, _Func&& func)
+        {
+            if (begin >= end) return;
+            Impl::ParallelForContext<remove_reference_t<_Func>> ctx;
+            ctx.func = &func;
+            ctx.grain = Impl::get_parallel_grain_size(end - begin, grain);
+            Impl::run_parallel_range(&ctx, begin, end);
+        }
+
+        //! Computes one value for every index in [`begin`, `end`) and reduces all values into one value using multiple threads.
+        //! @param[in] begin The first index to process.
+        //! @param[in] end The index after the last index to process.
+        //! @param[in] grain The minimum number of indices processed by one job at a time.
+        //! If this is `0`, the grain size is computed from the number of indices and the number of processors.
+        //! @param[in] identity The identity value of the reduce operation, for example, `0` for additions and `1` for multiplications.
+        //! @param[in] func The function that computes one value for one index. The function signature must be `_Ty(usize index)`.
+        //! @param[in] reduce The function that reduces two values into one value. The function signature must be `_Ty(_Ty a, _Ty b)`.
+        //! The reduce function must be associative and commutative, since partial results are combined in the order that jobs finish.
+        //! @return Returns the reduced value. Returns `identity` if the range is empty.
+        //! @remark This function blocks until all indices are processed. See remarks of @ref parallel_for for details.
+        template <typename _Ty, typename _Func, typename _ReduceFunc>
+        _Ty parallel_reduce(usize begin, usize end, usize grain, const _Ty& identity, _Func&& func, _ReduceFunc&& reduce)
+        {
+            if (begin >= end) return identity;
+            Impl::ParallelReduceContext<_Ty, remove_reference_t<_Func>, remove_reference_t<_ReduceFunc>> ctx;
+            ctx.func = &func;
+            ctx.reduce = &reduce;
+            ctx.identity = &identity;
+            ctx.result = identity;
+            ctx.grain = Impl::get_parallel_grain_size(end - begin, grain);
+            Impl::run_parallel_range(&ctx, begin, end);
+            return move(ctx.result);
+        }
+
+        //! @}
+    }
+}
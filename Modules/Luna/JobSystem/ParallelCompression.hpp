@@ -0,0 +1,72 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ParallelCompression.hpp
+* @author JXMaster
+* @date 2024/5/13
+*/
+#pragma once
+#include "Parallel.hpp"
+#include <Luna/Runtime/Compression.hpp>
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    namespace JobSystem
+    {
+        //! @addtogroup JobSystem
+        //! @{
+
+        //! Compresses data into one compression frame using multiple threads.
+        //! @details Blocks of one compression frame are compressed independently, so every block is compressed by one job.
+        //! The output is the same as @ref compress_frame, and can be decompressed by @ref decompress_frame or
+        //! @ref new_decompression_stream.
+        //! @param[in] src The data to compress.
+        //! @param[in] src_size The size of the data to compress.
+        //! @param[in] desc The compression descriptor.
+        //! @return Returns the compression frame.
+        //! @remark This function blocks until all blocks are compressed. The current thread also executes jobs while waiting.
+        inline R<Blob> compress_frame_parallel(const void* src, usize src_size, const CompressionDesc& desc = CompressionDesc())
+        {
+            if (!desc.block_size || desc.block_size >= COMPRESSION_BLOCK_UNCOMPRESSED) return BasicError::bad_arguments();
+            usize num_blocks = (src_size + desc.block_size - 1) / desc.block_size;
+            usize block_bound = get_compress_frame_block_bound(desc.format, desc.block_size);
+            Blob ret(sizeof(CompressionFrameHeader) + num_blocks * block_bound + sizeof(CompressionBlockHeader));
+            byte_t* dst = (byte_t*)ret.data();
+            CompressionFrameHeader header;
+            memzero(&header);
+            header.magic = COMPRESSION_FRAME_MAGIC;
+            header.format = desc.format;
+            header.block_size = desc.block_size;
+            memcpy(dst, &header, sizeof(CompressionFrameHeader));
+            // Every block is compressed into its own slot, then slots are packed in order.
+            byte_t* slots = dst + sizeof(CompressionFrameHeader);
+            Vector<usize> block_sizes;
+            block_sizes.resize(num_blocks);
+            parallel_for(0, num_blocks, 1, [&](usize i)
+            {
+                usize offset = i * desc.block_size;
+                usize size = min<usize>(desc.block_size, src_size - offset);
+                block_sizes[i] = compress_frame_block(desc, (const byte_t*)src + offset, size, slots + i * block_bound);
+            });
+            usize size = sizeof(CompressionFrameHeader);
+            for (usize i = 0; i < num_blocks; ++i)
+            {
+                // Packed data never goes beyond the slot, so the slot can be moved forward safely.
+                memmove(dst + size, slots + i * block_bound, block_sizes[i]);
+                size += block_sizes[i];
+            }
+            CompressionBlockHeader end;
+            end.stored_size = 0;
+            end.raw_size = 0;
+            memcpy(dst + size, &end, sizeof(CompressionBlockHeader));
+            size += sizeof(CompressionBlockHeader);
+            ret.resize(size);
+            return ret;
+        }
+
+        //! @}
+    }
+}
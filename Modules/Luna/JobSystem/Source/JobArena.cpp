@@ -0,0 +1,106 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file JobArena.cpp
+* @author JXMaster
+* @date 2024/3/4
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_JOBSYSTEM_API LUNA_EXPORT
+#include "JobArena.hpp"
+#include <Luna/Runtime/Atomic.hpp>
+
+namespace Luna
+{
+    namespace JobSystem
+    {
+        constexpr usize JOB_ARENA_BLOCK_ALIGNMENT = 64;
+
+        JobArena::~JobArena()
+        {
+            for (JobArenaBlock* block : m_used_blocks)
+            {
+                memfree(block, JOB_ARENA_BLOCK_ALIGNMENT);
+            }
+            for (JobArenaBlock* block : m_free_blocks)
+            {
+                memfree(block, JOB_ARENA_BLOCK_ALIGNMENT);
+            }
+        }
+        JobArenaBlock* JobArena::new_block(usize capacity)
+        {
+            JobArenaBlock* block = (JobArenaBlock*)memalloc(sizeof(JobArenaBlock) + capacity, JOB_ARENA_BLOCK_ALIGNMENT);
+            block->m_capacity = capacity;
+            block->m_used = 0;
+            return block;
+        }
+        void* JobArena::allocate(usize size, usize alignment)
+        {
+            usize reserve_size = size + alignment - 1;
+            if (reserve_size > m_block_size)
+            {
+                // Allocate one dedicated block for large allocations.
+                JobArenaBlock* block = new_block(reserve_size);
+                block->m_used = reserve_size;
+                LockGuard guard(m_lock);
+                m_used_blocks.push_back(block);
+                return (void*)align_upper((usize)block->get_data(), alignment);
+            }
+            while (true)
+            {
+                JobArenaBlock* block = m_current;
+                if (block)
+                {
+                    usize end = atom_add_usize(&block->m_used, (isize)reserve_size);
+                    if (end <= block->m_capacity)
+                    {
+                        usize begin = (usize)block->get_data() + end - reserve_size;
+                        return (void*)align_upper(begin, alignment);
+                    }
+                }
+                // The current block is exhausted, switch to the next block.
+                LockGuard guard(m_lock);
+                if (m_current == block)
+                {
+                    JobArenaBlock* next_block;
+                    if (!m_free_blocks.empty())
+                    {
+                        next_block = m_free_blocks.back();
+                        m_free_blocks.pop_back();
+                    }
+                    else
+                    {
+                        next_block = new_block(m_block_size);
+                    }
+                    m_used_blocks.push_back(next_block);
+                    atom_exchange_pointer(&m_current, next_block);
+                }
+            }
+        }
+        void JobArena::reset()
+        {
+            LockGuard guard(m_lock);
+            for (JobArenaBlock* block : m_used_blocks)
+            {
+                if (block->m_capacity == m_block_size)
+                {
+                    block->m_used = 0;
+                    m_free_blocks.push_back(block);
+                }
+                else
+                {
+                    memfree(block, JOB_ARENA_BLOCK_ALIGNMENT);
+                }
+            }
+            m_used_blocks.clear();
+            m_current = nullptr;
+        }
+        LUNA_JOBSYSTEM_API Ref<IJobArena> new_job_arena(usize block_size)
+        {
+            Ref<JobArena> arena = new_object<JobArena>(block_size);
+            return arena;
+        }
+    }
+}
@@ -0,0 +1,59 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file JobArena.hpp
+* @author JXMaster
+* @date 2024/3/4
+*/
+#pragma once
+#include "../JobSystem.hpp"
+#include <Luna/Runtime/TypeInfo.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    namespace JobSystem
+    {
+        struct JobArenaBlock
+        {
+            usize m_capacity;
+            // The number of bytes consumed from this block. This may exceed `m_capacity` when the
+            // block is exhausted.
+            volatile usize m_used;
+
+            void* get_data() const
+            {
+                return (void*)((usize)this + sizeof(JobArenaBlock));
+            }
+        };
+
+        struct JobArena : IJobArena
+        {
+            lustruct("JobSystem::JobArena", "{2d53b08b-d2a4-4c91-8e76-36324549e056}");
+            luiimpl();
+
+            usize m_block_size;
+            JobArenaBlock* volatile m_current;
+            // Locked only when switching blocks or resetting the arena.
+            SpinLock m_lock;
+            // Blocks that have been used since last reset, including the current block.
+            Vector<JobArenaBlock*> m_used_blocks;
+            // Blocks that are reclaimed by `reset` and can be reused.
+            Vector<JobArenaBlock*> m_free_blocks;
+
+            JobArena(usize block_size) :
+                m_block_size(block_size),
+                m_current(nullptr) {}
+            ~JobArena();
+
+            JobArenaBlock* new_block(usize capacity);
+            //! Allocates memory from the arena. This can be called from multiple threads.
+            void* allocate(usize size, usize alignment);
+
+            virtual void reset() override;
+        };
+    }
+}
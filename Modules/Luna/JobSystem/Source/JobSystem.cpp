@@ -10,79 +10,160 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_JOBSYSTEM_API LUNA_EXPORT
 #include "../JobSystem.hpp"
-#include <Luna/Runtime/RingDeque.hpp>
+#include <Luna/Runtime/Vector.hpp>
 #include <Luna/Runtime/SpinLock.hpp>
-#include <Luna/Runtime/Signal.hpp>
+#include <Luna/Runtime/Futex.hpp>
+#include <Luna/Runtime/RingDeque.hpp>
 #include <Luna/Runtime/Random.hpp>
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Fiber.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/PerfCounter.hpp>
+#include "WorkStealingQueue.hpp"
+#include "JobArena.hpp"
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+#include <xmmintrin.h>
+#endif
 
 namespace Luna
 {
     namespace JobSystem
     {
         // Used to record job states even when the job context is destroyed.
-        static SpinLock g_job_state_map_lock;
-        static job_id_t g_next_job_id;
-        static RingDeque<u64> g_job_state_map;
-        static usize g_job_state_map_offset;
-        constexpr usize JOBS_PER_CHUNK = 64;
+        // Every job ID is composed by one slot index (low 32 bits) and the generation of the slot (high 32 bits) when
+        // the ID is allocated. Finishing one job ID increases the generation of its slot, so one job ID is finished if the
+        // generation of its slot does not equal to the generation stored in the ID. Free slots are recycled by one lock-free
+        // stack, so allocating, finishing and polling job IDs never take any lock.
+        struct JobWaitNode;
+        struct JobSlot
+        {
+            volatile u32 m_generation;
+            // The index of the next free slot plus one, or 0 if this is the last free slot.
+            volatile u32 m_next_free;
+            // Jobs that wait for this job ID to be finished before they can be scheduled. 
+            // The lock is per slot, so only the finishing thread and threads that are adding 
+            // new waiting jobs to the same job ID contend for it.
+            SpinLock m_wait_list_lock;
+            JobWaitNode* m_wait_list = nullptr;
+        };
+        constexpr u32 JOB_SLOTS_PER_CHUNK = 1024;
+        constexpr u32 MAX_JOB_SLOT_CHUNKS = 4096;
+        // Chunks are never freed before the job system is closed, so reading one slot is always safe.
+        static JobSlot* volatile g_job_slot_chunks[MAX_JOB_SLOT_CHUNKS];
+        static volatile u32 g_num_job_slots;
+        // The ABA tag (high 32 bits) and the index plus one of the first free slot (low 32 bits).
+        static volatile u64 g_free_job_slots;
         inline void init_job_state_map()
         {
-            g_next_job_id = 0;
-            g_job_state_map_offset = 0;
+            memzero((void*)g_job_slot_chunks, sizeof(g_job_slot_chunks));
+            g_num_job_slots = 0;
+            g_free_job_slots = 0;
         }
         inline void close_job_state_map()
         {
-            g_job_state_map.clear();
-            g_job_state_map.shrink_to_fit();
+            for (u32 i = 0; i < MAX_JOB_SLOT_CHUNKS; ++i)
+            {
+                if (g_job_slot_chunks[i])
+                {
+                    memfree(g_job_slot_chunks[i]);
+                    g_job_slot_chunks[i] = nullptr;
+                }
+            }
         }
-        inline job_id_t job_state_map_begin()
+        inline JobSlot* get_job_slot(u32 index)
         {
-            return g_job_state_map_offset * JOBS_PER_CHUNK;
+            return &(g_job_slot_chunks[index / JOB_SLOTS_PER_CHUNK][index % JOB_SLOTS_PER_CHUNK]);
         }
-        inline job_id_t job_state_map_end()
+        inline JobSlot* new_job_slot(u32 index)
         {
-            return (g_job_state_map_offset + g_job_state_map.size()) * JOBS_PER_CHUNK;
+            u32 chunk_index = index / JOB_SLOTS_PER_CHUNK;
+            luassert_msg_always(chunk_index < MAX_JOB_SLOT_CHUNKS, "Too many unfinished jobs.");
+            JobSlot* chunk = g_job_slot_chunks[chunk_index];
+            if (!chunk)
+            {
+                JobSlot* new_chunk = (JobSlot*)memalloc(sizeof(JobSlot) * JOB_SLOTS_PER_CHUNK);
+                for (u32 i = 0; i < JOB_SLOTS_PER_CHUNK; ++i)
+                {
+                    new (new_chunk + i) JobSlot();
+                    // Generation 0 is never used so that one valid job ID is never 0.
+                    new_chunk[i].m_generation = 1;
+                    new_chunk[i].m_next_free = 0;
+                }
+                chunk = atom_compare_exchange_pointer(&g_job_slot_chunks[chunk_index], new_chunk, nullptr);
+                if (chunk)
+                {
+                    // Installed by another thread.
+                    memfree(new_chunk);
+                }
+                else
+                {
+                    chunk = new_chunk;
+                }
+            }
+            return &chunk[index % JOB_SLOTS_PER_CHUNK];
         }
         LUNA_JOBSYSTEM_API job_id_t allocate_job_id()
         {
-            LockGuard guard(g_job_state_map_lock);
-            job_id_t r = g_next_job_id;
-            ++g_next_job_id;
-            if (r >= job_state_map_end())
+            u64 head = g_free_job_slots;
+            while (head & U32_MAX)
             {
-                g_job_state_map.push_back(0);
+                u32 index = (u32)(head & U32_MAX) - 1;
+                // The slot may be reused by other threads at this time, which causes the
+                // following compare exchange to fail since the tag is changed.
+                u64 next = (((head >> 32) + 1) << 32) | get_job_slot(index)->m_next_free;
+                u64 prev = atom_compare_exchange_u64(&g_free_job_slots, next, head);
+                if (prev == head)
+                {
+                    return ((u64)get_job_slot(index)->m_generation << 32) | index;
+                }
+                head = prev;
             }
-            return r;
+            // Allocate one new slot.
+            u32 index = atom_inc_u32(&g_num_job_slots) - 1;
+            JobSlot* slot = new_job_slot(index);
+            return ((u64)slot->m_generation << 32) | index;
         }
+        static void notify_waiting_jobs(JobWaitNode* node);
         LUNA_JOBSYSTEM_API void finish_job_id(job_id_t id)
         {
-            LockGuard guard(g_job_state_map_lock);
-            luassert(id >= job_state_map_begin() && id < job_state_map_end());
-            usize chunk_index = id / JOBS_PER_CHUNK - g_job_state_map_offset;
-            usize bit_offset = id % JOBS_PER_CHUNK;
-            u64* chunk = &(g_job_state_map[chunk_index]);
-            bit_set(chunk, bit_offset);
-            if (chunk_index == 0)
+            u32 index = (u32)(id & U32_MAX);
+            u32 generation = (u32)(id >> 32);
+            luassert(index < g_num_job_slots);
+            JobSlot* slot = get_job_slot(index);
+            u32 new_generation = generation + 1;
+            if (!new_generation) new_generation = 1;
+            u32 prev_generation = atom_compare_exchange_u32(&slot->m_generation, new_generation, generation);
+            lucheck_msg(prev_generation == generation, "The job ID is already finished.");
+            // Finishing one job twice must not wake its waiting jobs again.
+            if (prev_generation != generation) return;
+            // Takes all waiting jobs. Since the generation is already changed, no job can be added to the list
+            // after this.
+            slot->m_wait_list_lock.lock();
+            JobWaitNode* wait_list = slot->m_wait_list;
+            slot->m_wait_list = nullptr;
+            slot->m_wait_list_lock.unlock();
+            // Gives back the slot.
+            u64 head = g_free_job_slots;
+            while (true)
             {
-                while (*chunk == U64_MAX)
-                {
-                    ++g_job_state_map_offset;
-                    g_job_state_map.pop_front();
-                    if (g_job_state_map.empty()) break;
-                    chunk = &g_job_state_map.front();
-                }
+                slot->m_next_free = (u32)(head & U32_MAX);
+                u64 next = (((head >> 32) + 1) << 32) | (index + 1);
+                u64 prev = atom_compare_exchange_u64(&g_free_job_slots, next, head);
+                if (prev == head) break;
+                head = prev;
+            }
+            if (wait_list)
+            {
+                notify_waiting_jobs(wait_list);
             }
         }
         LUNA_JOBSYSTEM_API bool is_job_finished(job_id_t id)
         {
-            LockGuard guard(g_job_state_map_lock);
-            if (id < job_state_map_begin()) return true;
-            if (id >= job_state_map_end()) return false;
-            usize chunk_index = id / JOBS_PER_CHUNK - g_job_state_map_offset;
-            usize bit_offset = id % JOBS_PER_CHUNK;
-            u64* chunk = &(g_job_state_map[chunk_index]);
-            return bit_test(chunk, bit_offset);
+            if (id == INVALID_JOB_ID) return true;
+            u32 index = (u32)(id & U32_MAX);
+            u32 generation = (u32)(id >> 32);
+            luassert(index < g_num_job_slots);
+            return get_job_slot(index)->m_generation != generation;
         }
 
         struct JobHeader
@@ -91,7 +172,13 @@ namespace Luna
             job_func_t* m_func;
             JobHeader* m_parent;
             usize m_alignment;
+            // The size class of the memory block of this job, or one of `JOB_SIZE_CLASS_HEAP` 
+            // and `JOB_SIZE_CLASS_ARENA`.
+            u32 m_size_class;
             volatile u32 m_unfinished_jobs;
+            JobPriority m_priority;
+            // The name set by `set_job_name`.
+            const c8* m_name;
 
             bool is_completed() const
             {
@@ -113,142 +200,434 @@ namespace Luna
             return (JobHeader*)(((usize)params) - sizeof(JobHeader));
         }
 
-        LUNA_JOBSYSTEM_API void* new_job(job_func_t* func, usize param_size, usize param_alignment, void* parent)
+        struct JobWaitList;
+        // One node is added to the slot wait list of every job ID that one job waits for.
+        struct JobWaitNode
         {
-            // Allocate extra padding space for storing job header.
-            param_alignment = max(param_alignment, MAX_ALIGN);
-            usize padding_size = JobHeader::get_padding_size(param_alignment);
-            void* mem = memalloc(param_size + padding_size, param_alignment);
-            void* params = (void*)((usize)mem + padding_size);
-            JobHeader* job = get_job_header(params);
-            new (job) JobHeader();
-            job->m_id = INVALID_JOB_ID;
-            job->m_func = func;
-            job->m_parent = nullptr;
-            job->m_alignment = param_alignment;
-            job->m_unfinished_jobs = 1;
-            if (parent)
+            JobWaitList* m_list;
+            JobWaitNode* m_next;
+        };
+        struct JobFiber;
+        // Records one job that is submitted with waiting job IDs, or one suspended fiber that waits for one job ID.
+        struct JobWaitList
+        {
+            // Only one of `m_job` and `m_fiber` is not `nullptr`.
+            JobHeader* m_job;
+            JobFiber* m_fiber;
+            // The size class of the memory block of this list.
+            u32 m_size_class;
+            // The number of unfinished job IDs this job waits for, plus one additional count held by the submitting 
+            // thread until all nodes are added.
+            volatile u32 m_num_waits;
+
+            JobWaitNode* get_nodes() const
             {
-                job->m_parent = get_job_header(parent);
-                atom_inc_u32(&(job->m_parent->m_unfinished_jobs));
+                return (JobWaitNode*)((usize)this + sizeof(JobWaitList));
             }
-            return params;
-        }
+        };
+
+        // Size classes for job memory blocks. Blocks larger than the largest size class are allocated from heap directly.
+        constexpr usize JOB_SIZE_CLASSES[] = { 64, 128, 256, 512, 1024, 2048 };
+        constexpr u32 NUM_JOB_SIZE_CLASSES = sizeof(JOB_SIZE_CLASSES) / sizeof(usize);
+        constexpr u32 JOB_SIZE_CLASS_HEAP = U32_MAX;
+        constexpr u32 JOB_SIZE_CLASS_ARENA = U32_MAX - 1;
+        // The alignment of pooled job memory blocks.
+        constexpr usize JOB_BLOCK_ALIGNMENT = 64;
+        // The maximum number of free blocks cached by one thread for every size class.
+        constexpr u32 MAX_CACHED_JOB_BLOCKS = 256;
+
+        // One thread-local free list of job memory blocks.
+        struct JobBlockCache
+        {
+            // Every free block stores the pointer to the next free block in its first bytes.
+            void* m_free_list = nullptr;
+            u32 m_num_blocks = 0;
+
+            ~JobBlockCache()
+            {
+                while (m_free_list)
+                {
+                    void* next = *((void**)m_free_list);
+                    memfree(m_free_list, JOB_BLOCK_ALIGNMENT);
+                    m_free_list = next;
+                }
+            }
+        };
+
+        // The number of job queues every thread has, one for every priority that is executed by normal workers.
+        constexpr u32 NUM_JOB_QUEUES = (u32)JobPriority::background + 1;
 
         struct WorkerThreadContext
         {
-            SpinLock m_lock;
-            RingDeque<JobHeader*> m_jobs;
-            Ref<ISignal> m_wake_signal;
-            bool m_thread_dead = false;
+            WorkStealingQueue<JobHeader*> m_jobs[NUM_JOB_QUEUES];
+            // Free lists for job memory blocks. Since jobs may be finished on threads other than the thread
+            // that allocates them, blocks are given back to the free list of the thread that finishes the job.
+            JobBlockCache m_block_caches[NUM_JOB_SIZE_CLASSES];
+            // 1 if the thread that owns this context is dead, so that this context can be reused by
+            // another thread.
+            volatile u32 m_thread_dead = 0;
+            // The seed used to select victims when stealing jobs.
+            u32 m_steal_seed;
+            // The cache domain of the processors that the owning thread is pinned to, or `U32_MAX` if the thread
+            // is not pinned.
+            u32 m_cache_domain = U32_MAX;
+            // The fiber of the worker thread that runs the scheduling loop if fibers are enabled.
+            Ref<IFiber> m_scheduler_fiber;
+            // The job fiber that is running on this thread, or `nullptr` if this thread is running the scheduling loop.
+            JobFiber* m_current_fiber = nullptr;
+            // Statistics of this thread. They are only written by the owning thread, and are read by `get_worker_stats` 
+            // without synchronization.
+            WorkerStats m_stats;
+            // The number of jobs that are being executed on the stack of this thread. Only the outermost job is timed, so 
+            // jobs nested by `wait_job` are not counted twice.
+            u32 m_job_depth = 0;
+
+            WorkerThreadContext()
+            {
+                memzero(&m_stats, sizeof(WorkerStats));
+            }
+
+            u32 next_steal_index()
+            {
+                // xorshift32.
+                u32 x = m_steal_seed;
+                x ^= x << 13;
+                x ^= x >> 17;
+                x ^= x << 5;
+                m_steal_seed = x;
+                return x;
+            }
         };
 
+        // The immutable snapshot of all worker thread contexts. The list is replaced as a whole when 
+        // new contexts are added, so that thieves can read it without any lock.
+        struct WorkerThreadContextList
+        {
+            Vector<WorkerThreadContext*> m_contexts;
+            // Prior lists are retired and are freed when the job system is closed, since they may still be read by thieves.
+            WorkerThreadContextList* m_prev = nullptr;
+        };
+
+        // Serializes adding new contexts. Reading contexts does not require this lock.
         static SpinLock g_worker_thread_contexts_lock;
-        static Vector<WorkerThreadContext*> g_worker_thread_contexts;
+        static WorkerThreadContextList* volatile g_worker_thread_contexts;
         static Vector<Ref<IThread>> g_worker_threads;
-        static SpinLock g_sleep_worker_threads_lock;
-        static Vector<WorkerThreadContext*> g_sleep_worker_threads;
+        // Parked worker threads wait on one shared semaphore. `g_num_sleeping_workers` records the number of workers that 
+        // are parked or are going to be parked and have not been claimed by any waker, so that wakers can claim and wake 
+        // multiple workers at once without taking any lock.
+        static volatile u32 g_num_sleeping_workers;
+        static FutexSemaphore g_worker_wake_semaphore;
         static opaque_t g_worker_thread_tls;
         static bool g_job_system_exiting;
+        static JobSystemConfig g_config;
+        static Vector<u64> g_worker_affinities;
+
+        // One fiber that runs jobs if fibers are enabled.
+        struct JobFiber
+        {
+            Ref<IFiber> m_fiber;
+            // The job to execute when the fiber is switched to.
+            JobHeader* m_job = nullptr;
+            // The job ID that the fiber is going to wait when the fiber switches back to the scheduler.
+            job_id_t m_wait_job = INVALID_JOB_ID;
+        };
+        static SpinLock g_fibers_lock;
+        static Vector<JobFiber*> g_free_fibers;
+        static Vector<JobFiber*> g_fibers;
+        // Suspended fibers whose waiting jobs are finished. They are resumed before any new job is started.
+        static SpinLock g_ready_fibers_lock;
+        static RingDeque<JobFiber*> g_ready_fibers;
+        static volatile u32 g_num_ready_fibers;
+
+        // IO jobs are stored in one global queue, and are only consumed by IO workers, so that blocking IO 
+        // jobs never occupy normal workers.
+        static SpinLock g_io_jobs_lock;
+        static RingDeque<JobHeader*> g_io_jobs;
+        static FutexSemaphore g_io_jobs_semaphore;
+        static Vector<Ref<IThread>> g_io_worker_threads;
 
         static void worker_thread_tls_dtor(void* params)
         {
-            // Marks this context to be dead, so that it will be removed 
-            // when the queue is clear, or when the system is shut down.
+            // Marks this context to be dead, so that it can be reused by new threads. 
+            // Jobs remaining in the queue can still be stolen by other threads.
             WorkerThreadContext* ctx = (WorkerThreadContext*)params;
-            ctx->m_thread_dead = true;
+            atom_exchange_u32(&ctx->m_thread_dead, 1);
         }
         static void worker_thread_run(void* params);
+        static void io_worker_thread_run(void* params);
+        LUNA_JOBSYSTEM_API void set_config(const JobSystemConfig& config)
+        {
+            g_config = config;
+            // Copy masks so that the user memory does not need to be valid after this call.
+            g_worker_affinities.assign(config.worker_affinities);
+            g_config.worker_affinities = {};
+        }
+        static u64 get_worker_affinity(u32 worker_index, u32 num_processors)
+        {
+            if (worker_index < g_worker_affinities.size())
+            {
+                return g_worker_affinities[worker_index];
+            }
+            if (g_worker_affinities.empty() && g_config.pin_workers)
+            {
+                u32 processor = (worker_index + 1) % num_processors;
+                return processor < 64 ? (u64)1 << processor : 0;
+            }
+            return 0;
+        }
+        static u32 get_affinity_cache_domain(u64 affinity, u32 num_processors)
+        {
+            // The thread is in one cache domain only if all processors it can run on are in the same domain.
+            u32 domain = U32_MAX;
+            for (u32 i = 0; i < min<u32>(num_processors, 64); ++i)
+            {
+                if (!(affinity & ((u64)1 << i))) continue;
+                u32 d = get_processor_cache_domain(i);
+                if (domain == U32_MAX) domain = d;
+                else if (domain != d) return U32_MAX;
+            }
+            return domain;
+        }
+        // The number of jobs in all job queues, including the IO queue.
+        perf_counter_t g_queued_jobs_counter = 0;
+        // The number of jobs stolen from queues of other threads.
+        perf_counter_t g_stolen_jobs_counter = 0;
         RV job_system_init()
         {
+            g_queued_jobs_counter = register_perf_counter("JobSystem.QueuedJobs", PerfCounterType::gauge);
+            g_stolen_jobs_counter = register_perf_counter("JobSystem.StolenJobs", PerfCounterType::counter);
             init_job_state_map();
             g_job_system_exiting = false;
+            g_worker_thread_contexts = memnew<WorkerThreadContextList>();
             g_worker_thread_tls = tls_alloc(worker_thread_tls_dtor);
+            g_num_sleeping_workers = 0;
+            g_num_ready_fibers = 0;
             // Emit worker threads.
             u32 processor_count = get_processors_count();
-            for (u32 i = 0; i < processor_count - 1; ++i)
+            u32 num_workers = g_config.num_workers == U32_MAX ? processor_count - 1 : g_config.num_workers;
+            for (u32 i = 0; i < num_workers; ++i)
             {
-                Ref<IThread> worker = new_thread(worker_thread_run, nullptr);
+                u64 affinity = get_worker_affinity(i, processor_count);
+                u32 cache_domain = affinity ? get_affinity_cache_domain(affinity, processor_count) : U32_MAX;
+                Ref<IThread> worker = new_thread(worker_thread_run, (void*)(usize)cache_domain);
+                if (affinity)
+                {
+                    // Failing to set affinity is not fatal, the worker is scheduled by the system in such case.
+                    auto _ = worker->set_affinity(affinity);
+                }
                 g_worker_threads.push_back(worker);
             }
-            // Consume job id 0, so any valid job will never have ID 0.
-            job_id_t dummy = allocate_job_id();
-            finish_job_id(dummy);
+            if (g_config.num_io_workers)
+            {
+                for (u32 i = 0; i < g_config.num_io_workers; ++i)
+                {
+                    Ref<IThread> worker = new_thread(io_worker_thread_run, nullptr, "JobSystem IO Worker");
+                    if (g_config.io_worker_affinity)
+                    {
+                        // Same as worker threads, failing to set affinity is not fatal.
+                        auto _ = worker->set_affinity(g_config.io_worker_affinity);
+                    }
+                    g_io_worker_threads.push_back(worker);
+                }
+            }
             return ok;
         }
         void job_system_close()
         {
             g_job_system_exiting = true;
-            // Wake up all sleep threads.
-            for (auto& t : g_sleep_worker_threads)
+            atom_memory_barrier();
+            // Wake up all sleep threads. Every worker consumes at most one permit before it checks the exiting flag.
+            for (usize i = 0; i < g_worker_threads.size(); ++i)
             {
-                t->m_wake_signal->trigger();
+                g_worker_wake_semaphore.release();
+            }
+            for (usize i = 0; i < g_io_worker_threads.size(); ++i)
+            {
+                g_io_jobs_semaphore.release();
             }
             // Wait for all threads to exit.
             g_worker_threads.clear();
             g_worker_threads.shrink_to_fit();
+            g_io_worker_threads.clear();
+            g_io_worker_threads.shrink_to_fit();
+            g_io_jobs.clear();
+            g_io_jobs.shrink_to_fit();
+            // Fibers that are still suspended when the job system is closed are discarded.
+            for (JobFiber* f : g_fibers)
+            {
+                memdelete(f);
+            }
+            g_fibers.clear();
+            g_fibers.shrink_to_fit();
+            g_free_fibers.clear();
+            g_free_fibers.shrink_to_fit();
+            g_ready_fibers.clear();
+            g_ready_fibers.shrink_to_fit();
             // Clean up contexts.
             tls_free(g_worker_thread_tls);
             g_worker_thread_contexts_lock.lock();
-            for (WorkerThreadContext* ctx : g_worker_thread_contexts)
+            for (WorkerThreadContext* ctx : g_worker_thread_contexts->m_contexts)
             {
                 memdelete(ctx);
             }
-            g_worker_thread_contexts.clear();
-            g_worker_thread_contexts.shrink_to_fit();
+            WorkerThreadContextList* list = g_worker_thread_contexts;
+            while (list)
+            {
+                WorkerThreadContextList* prev = list->m_prev;
+                memdelete(list);
+                list = prev;
+            }
+            g_worker_thread_contexts = nullptr;
             g_worker_thread_contexts_lock.unlock();
-            g_sleep_worker_threads.clear();
-            g_sleep_worker_threads.shrink_to_fit();
             close_job_state_map();
         }
+        static WorkerThreadContext* new_worker_context()
+        {
+            // Reuse contexts of dead threads firstly.
+            WorkerThreadContextList* list = g_worker_thread_contexts;
+            for (WorkerThreadContext* ctx : list->m_contexts)
+            {
+                if (ctx->m_thread_dead && atom_compare_exchange_u32(&ctx->m_thread_dead, 0, 1) == 1)
+                {
+                    ctx->m_cache_domain = U32_MAX;
+                    memzero(&ctx->m_stats, sizeof(WorkerStats));
+                    return ctx;
+                }
+            }
+            WorkerThreadContext* ctx = memnew<WorkerThreadContext>();
+            ctx->m_steal_seed = random_u32() | 1;
+            // Publish one new context list that includes the new context.
+            LockGuard guard(g_worker_thread_contexts_lock);
+            WorkerThreadContextList* new_list = memnew<WorkerThreadContextList>();
+            new_list->m_contexts = g_worker_thread_contexts->m_contexts;
+            new_list->m_contexts.push_back(ctx);
+            new_list->m_prev = g_worker_thread_contexts;
+            atom_exchange_pointer(&g_worker_thread_contexts, new_list);
+            return ctx;
+        }
         static WorkerThreadContext* get_current_thread_worker_context()
         {
             WorkerThreadContext* ctx = (WorkerThreadContext*)tls_get(g_worker_thread_tls);
             if (!ctx)
             {
                 // For working on user-created threads.
-                ctx = memnew<WorkerThreadContext>();
+                ctx = new_worker_context();
                 tls_set(g_worker_thread_tls, ctx);
-                g_worker_thread_contexts_lock.lock();
-                g_worker_thread_contexts.push_back(ctx);
-                g_worker_thread_contexts_lock.unlock();
             }
             return ctx;
         }
-        inline JobHeader* steal_job(WorkerThreadContext* current_ctx)
+        static void* allocate_job_block(usize size, usize alignment, u32& size_class)
         {
-            LockGuard guard(g_worker_thread_contexts_lock);
-            if (g_worker_thread_contexts.empty()) return nullptr;
-            u32 rand_index = random_u32() % (u32)g_worker_thread_contexts.size();
-            usize i = 0;
-            while (i < g_worker_thread_contexts.size())
-            {
-                u32 index = (rand_index + i) % (u32)g_worker_thread_contexts.size();
-                WorkerThreadContext* steal_ctx = g_worker_thread_contexts[index];
-                if (steal_ctx == current_ctx)
-                {
-                    ++i;
-                    continue;
-                }
-                steal_ctx->m_lock.lock();
-                if (steal_ctx->m_thread_dead && steal_ctx->m_jobs.empty())
+            if (alignment <= JOB_BLOCK_ALIGNMENT)
+            {
+                for (u32 i = 0; i < NUM_JOB_SIZE_CLASSES; ++i)
                 {
-                    // Remove this context.
-                    steal_ctx->m_lock.unlock();
-                    g_worker_thread_contexts.erase(g_worker_thread_contexts.begin() + index);
-                    memdelete(steal_ctx);
+                    if (size <= JOB_SIZE_CLASSES[i])
+                    {
+                        size_class = i;
+                        JobBlockCache& cache = get_current_thread_worker_context()->m_block_caches[i];
+                        void* block = cache.m_free_list;
+                        if (block)
+                        {
+                            cache.m_free_list = *((void**)block);
+                            --cache.m_num_blocks;
+                            return block;
+                        }
+                        return memalloc(JOB_SIZE_CLASSES[i], JOB_BLOCK_ALIGNMENT);
+                    }
                 }
-                else
+            }
+            size_class = JOB_SIZE_CLASS_HEAP;
+            return memalloc(size, alignment);
+        }
+        static void free_job_block(void* block, u32 size_class, usize alignment)
+        {
+            if (size_class == JOB_SIZE_CLASS_ARENA)
+            {
+                // Reclaimed when the arena is reset.
+                return;
+            }
+            if (size_class == JOB_SIZE_CLASS_HEAP)
+            {
+                memfree(block, alignment);
+                return;
+            }
+            JobBlockCache& cache = get_current_thread_worker_context()->m_block_caches[size_class];
+            if (cache.m_num_blocks >= MAX_CACHED_JOB_BLOCKS)
+            {
+                memfree(block, JOB_BLOCK_ALIGNMENT);
+                return;
+            }
+            *((void**)block) = cache.m_free_list;
+            cache.m_free_list = block;
+            ++cache.m_num_blocks;
+        }
+        static void* init_job(void* mem, usize padding_size, job_func_t* func, usize param_alignment, u32 size_class, void* parent)
+        {
+            void* params = (void*)((usize)mem + padding_size);
+            JobHeader* job = get_job_header(params);
+            new (job) JobHeader();
+            job->m_id = INVALID_JOB_ID;
+            job->m_func = func;
+            job->m_parent = nullptr;
+            job->m_alignment = param_alignment;
+            job->m_size_class = size_class;
+            job->m_unfinished_jobs = 1;
+            job->m_priority = JobPriority::normal;
+            job->m_name = nullptr;
+            if (parent)
+            {
+                job->m_parent = get_job_header(parent);
+                atom_inc_u32(&(job->m_parent->m_unfinished_jobs));
+            }
+            return params;
+        }
+        LUNA_JOBSYSTEM_API void* new_job(job_func_t* func, usize param_size, usize param_alignment, void* parent)
+        {
+            // Allocate extra padding space for storing job header.
+            param_alignment = max(param_alignment, MAX_ALIGN);
+            usize padding_size = JobHeader::get_padding_size(param_alignment);
+            u32 size_class;
+            void* mem = allocate_job_block(param_size + padding_size, param_alignment, size_class);
+            return init_job(mem, padding_size, func, param_alignment, size_class, parent);
+        }
+        LUNA_JOBSYSTEM_API void* new_job(IJobArena* arena, job_func_t* func, usize param_size, usize param_alignment, void* parent)
+        {
+            lucheck(arena);
+            param_alignment = max(param_alignment, MAX_ALIGN);
+            usize padding_size = JobHeader::get_padding_size(param_alignment);
+            JobArena* a = cast_object<JobArena>(arena->get_object());
+            void* mem = a->allocate(param_size + padding_size, param_alignment);
+            return init_job(mem, padding_size, func, param_alignment, JOB_SIZE_CLASS_ARENA, parent);
+        }
+        inline JobHeader* steal_job(WorkerThreadContext* current_ctx, u32 queue)
+        {
+            WorkerThreadContextList* list = g_worker_thread_contexts;
+            usize num_contexts = list->m_contexts.size();
+            if (num_contexts <= 1) return nullptr;
+            usize rand_index = current_ctx->next_steal_index() % num_contexts;
+            u32 domain = current_ctx->m_cache_domain;
+            // If the current thread is pinned, tries victims in the same cache domain firstly, then victims in other domains.
+            for (u32 pass = domain == U32_MAX ? 1 : 0; pass < 2; ++pass)
+            {
+                for (usize i = 0; i < num_contexts; ++i)
                 {
-                    JobHeader* job = nullptr;
-                    if (!steal_ctx->m_jobs.empty())
+                    WorkerThreadContext* steal_ctx = list->m_contexts[(rand_index + i) % num_contexts];
+                    if (steal_ctx == current_ctx) continue;
+                    if (pass == 0 && steal_ctx->m_cache_domain != domain) continue;
+                    if (pass == 1 && domain != U32_MAX && steal_ctx->m_cache_domain == domain) continue;
+                    JobHeader* job;
+                    if (steal_ctx->m_jobs[queue].steal(job))
                     {
-                        job = steal_ctx->m_jobs.front();
-                        steal_ctx->m_jobs.pop_front();
+                        ++current_ctx->m_stats.num_steals;
+                        perf_counter_add(g_stolen_jobs_counter, 1);
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+                        ProfilerEventData::JobSteal* data = allocate_profiler_event_data<ProfilerEventData::JobSteal>();
+                        data->job = job->m_id;
+                        submit_profiler_event(ProfilerEventId::JOB_STEAL);
+#endif
+                        return job;
                     }
-                    steal_ctx->m_lock.unlock();
-                    if (job) return job;
-                    ++i;
                 }
             }
             return nullptr;
@@ -256,26 +635,31 @@ namespace Luna
         static JobHeader* consume_job()
         {
             WorkerThreadContext* ctx = get_current_thread_worker_context();
-            ctx->m_lock.lock();
-            if (ctx->m_jobs.empty())
+            // Jobs with higher priorities are consumed firstly, from both the local queue and queues of other threads.
+            for (u32 i = 0; i < NUM_JOB_QUEUES; ++i)
             {
-                ctx->m_lock.unlock();
+                JobHeader* job;
+                if (ctx->m_jobs[i].pop(job))
+                {
+                    perf_counter_add(g_queued_jobs_counter, -1);
+                    return job;
+                }
                 // Steal jobs from other threads.
-                JobHeader* job = steal_job(ctx);
-                if (!job)
+                job = steal_job(ctx, i);
+                if (job)
                 {
-                    yield_current_thread();
-                    return nullptr;
+                    perf_counter_add(g_queued_jobs_counter, -1);
+                    return job;
                 }
-                return job;
             }
-            else
+            if (g_worker_thread_contexts->m_contexts.size() > 1)
             {
-                JobHeader* job = ctx->m_jobs.back();
-                ctx->m_jobs.pop_back();
-                ctx->m_lock.unlock();
-                return job;
+                ++ctx->m_stats.num_failed_steals;
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+                submit_profiler_event(ProfilerEventId::JOB_STEAL_FAILED);
+#endif
             }
+            return nullptr;
         }
         static void finish_job(JobHeader* job)
         {
@@ -288,83 +672,486 @@ namespace Luna
                 }
                 finish_job_id(job->m_id);
                 usize alignment = job->m_alignment;
+                u32 size_class = job->m_size_class;
                 usize padding_size = JobHeader::get_padding_size(alignment);
                 void* raw_ptr = (void*)((usize)job->get_params() - padding_size);
                 job->~JobHeader();
-                memfree(raw_ptr, alignment);
+                free_job_block(raw_ptr, size_class, alignment);
             }
         }
         static void execute_job(JobHeader* job)
         {
-            job->m_func(job->get_params());
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+            job_id_t id = job->m_id;
+            {
+                ProfilerEventData::JobBegin* data = allocate_profiler_event_data<ProfilerEventData::JobBegin>();
+                data->job = id;
+                data->name = job->m_name;
+                submit_profiler_event(ProfilerEventId::JOB_BEGIN);
+            }
+#endif
+            {
+                LUNA_PROFILE_ZONE(job->m_name ? job->m_name : "Job");
+                job->m_func(job->get_params());
+            }
             finish_job(job);
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+            {
+                ProfilerEventData::JobEnd* data = allocate_profiler_event_data<ProfilerEventData::JobEnd>();
+                data->job = id;
+                submit_profiler_event(ProfilerEventId::JOB_END);
+            }
+#endif
         }
-        static void worker_thread_sleep()
+        // Executes the job on the stack of the current thread and records statistics.
+        static void run_job(WorkerThreadContext* ctx, JobHeader* job)
         {
-            WorkerThreadContext* ctx = get_current_thread_worker_context();
-            if (!ctx->m_wake_signal) ctx->m_wake_signal = new_signal(false);
-            // Add the current thread to sleep list.
-            g_sleep_worker_threads_lock.lock();
-            g_sleep_worker_threads.push_back(ctx);
-            g_sleep_worker_threads_lock.unlock();
-            ctx->m_wake_signal->wait();
+            ++ctx->m_stats.num_jobs_executed;
+            if (ctx->m_job_depth++ == 0)
+            {
+                u64 begin_time = get_ticks();
+                execute_job(job);
+                ctx->m_stats.busy_ticks += get_ticks() - begin_time;
+            }
+            else
+            {
+                execute_job(job);
+            }
+            --ctx->m_job_depth;
+        }
+        inline void cpu_pause()
+        {
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+            _mm_pause();
+#elif (defined(LUNA_PLATFORM_ARM32) || defined(LUNA_PLATFORM_ARM64)) && !defined(LUNA_COMPILER_MSVC)
+            __asm__ __volatile__("yield");
+#endif
+        }
+        static bool has_pending_jobs()
+        {
+            if (g_num_ready_fibers) return true;
+            WorkerThreadContextList* list = g_worker_thread_contexts;
+            for (WorkerThreadContext* ctx : list->m_contexts)
+            {
+                for (auto& jobs : ctx->m_jobs)
+                {
+                    if (!jobs.empty()) return true;
+                }
+            }
+            return false;
+        }
+        // Wakes up at most `count` parked worker threads.
+        static void wake_workers(u32 count)
+        {
+            // Jobs pushed before this call must be visible before we read the sleeper count, or one worker 
+            // that is going to sleep may miss both the new job and the wake up.
+            atom_memory_barrier();
+            u32 num_sleeping = g_num_sleeping_workers;
+            u32 num_wake;
+            while (true)
+            {
+                if (!num_sleeping) return;
+                num_wake = min(num_sleeping, count);
+                u32 prev = atom_compare_exchange_u32(&g_num_sleeping_workers, num_sleeping - num_wake, num_sleeping);
+                if (prev == num_sleeping) break;
+                num_sleeping = prev;
+            }
+            for (u32 i = 0; i < num_wake; ++i)
+            {
+                g_worker_wake_semaphore.release();
+            }
+        }
+        static void worker_thread_sleep(WorkerThreadContext* ctx)
+        {
+            atom_inc_u32(&g_num_sleeping_workers);
+            // Checks jobs again after the worker is registered as sleeping, so jobs pushed before the waker reads the 
+            // sleeper count are never missed.
+            if (has_pending_jobs() || g_job_system_exiting)
+            {
+                // Cancels sleeping. If the count is already claimed by one waker, consumes the permit released by it.
+                u32 num_sleeping = g_num_sleeping_workers;
+                while (num_sleeping)
+                {
+                    u32 prev = atom_compare_exchange_u32(&g_num_sleeping_workers, num_sleeping - 1, num_sleeping);
+                    if (prev == num_sleeping) return;
+                    num_sleeping = prev;
+                }
+            }
+            ++ctx->m_stats.num_parks;
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+            submit_profiler_event(ProfilerEventId::WORKER_PARK);
+#endif
+            u64 begin_time = get_ticks();
+            g_worker_wake_semaphore.acquire();
+            ctx->m_stats.parked_ticks += get_ticks() - begin_time;
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+            submit_profiler_event(ProfilerEventId::WORKER_UNPARK);
+#endif
+        }
+        static void job_fiber_run(void* params)
+        {
+            JobFiber* f = (JobFiber*)params;
+            while (true)
+            {
+                execute_job(f->m_job);
+                f->m_job = nullptr;
+                // Switches back to the scheduler of the thread that runs this fiber now, which may not
+                // be the thread that starts this job if the job has been suspended.
+                switch_to_fiber(get_current_thread_worker_context()->m_scheduler_fiber);
+            }
+        }
+        static JobFiber* acquire_fiber()
+        {
+            LockGuard guard(g_fibers_lock);
+            if (!g_free_fibers.empty())
+            {
+                JobFiber* f = g_free_fibers.back();
+                g_free_fibers.pop_back();
+                return f;
+            }
+            JobFiber* f = memnew<JobFiber>();
+            f->m_fiber = new_fiber(job_fiber_run, f, g_config.fiber_stack_size);
+            g_fibers.push_back(f);
+            return f;
+        }
+        static JobFiber* pop_ready_fiber()
+        {
+            if (!g_num_ready_fibers) return nullptr;
+            LockGuard guard(g_ready_fibers_lock);
+            if (g_ready_fibers.empty()) return nullptr;
+            JobFiber* f = g_ready_fibers.front();
+            g_ready_fibers.pop_front();
+            atom_dec_u32(&g_num_ready_fibers);
+            return f;
+        }
+        static void wait_fiber(JobFiber* f);
+        // Runs one job fiber on the current thread until the fiber finishes its job or is suspended.
+        static void run_fiber(WorkerThreadContext* ctx, JobFiber* f)
+        {
+            ctx->m_current_fiber = f;
+            u64 begin_time = get_ticks();
+            switch_to_fiber(f->m_fiber);
+            // The scheduler fiber is never resumed on other threads, so `ctx` is still valid here.
+            ctx->m_stats.busy_ticks += get_ticks() - begin_time;
+            ctx->m_current_fiber = nullptr;
+            if (f->m_wait_job != INVALID_JOB_ID)
+            {
+                // The fiber is suspended. Its context is saved now, so it is safe to let other threads resume it.
+                wait_fiber(f);
+            }
+            else
+            {
+                LockGuard guard(g_fibers_lock);
+                g_free_fibers.push_back(f);
+            }
         }
         static void worker_thread_run(void* params)
         {
+            WorkerThreadContext* ctx = get_current_thread_worker_context();
+            ctx->m_cache_domain = (u32)(usize)params;
+            ctx->m_stats.is_worker = true;
+            if (g_config.enable_fibers)
+            {
+                ctx->m_scheduler_fiber = convert_thread_to_fiber();
+            }
+            u32 num_spins = 0;
             while (!g_job_system_exiting)
             {
+                JobFiber* ready_fiber = pop_ready_fiber();
+                if (ready_fiber)
+                {
+                    run_fiber(ctx, ready_fiber);
+                    num_spins = 0;
+                    continue;
+                }
                 JobHeader* job = consume_job();
                 if (job)
                 {
-                    execute_job(job);
+                    if (ctx->m_scheduler_fiber)
+                    {
+                        JobFiber* f = acquire_fiber();
+                        f->m_job = job;
+                        ++ctx->m_stats.num_jobs_executed;
+                        run_fiber(ctx, f);
+                    }
+                    else
+                    {
+                        run_job(ctx, job);
+                    }
+                    num_spins = 0;
+                }
+                else if (num_spins < g_config.worker_spin_count)
+                {
+                    // Spins with exponential backoff before parking, and yields the processor time slice in the 
+                    // last half of the spin phase.
+                    if (num_spins < g_config.worker_spin_count / 2)
+                    {
+                        u32 num_pauses = 1 << min(num_spins, 6u);
+                        for (u32 i = 0; i < num_pauses; ++i) cpu_pause();
+                    }
+                    else
+                    {
+                        yield_current_thread();
+                    }
+                    ++num_spins;
                 }
                 else
                 {
-                    worker_thread_sleep();
+                    worker_thread_sleep(ctx);
+                    num_spins = 0;
                 }
             }
+            if (ctx->m_scheduler_fiber)
+            {
+                ctx->m_scheduler_fiber.reset();
+                convert_fiber_to_thread();
+            }
         }
-        LUNA_JOBSYSTEM_API job_id_t submit_job(void* params)
+        static void io_worker_thread_run(void* params)
+        {
+            WorkerThreadContext* ctx = get_current_thread_worker_context();
+            ctx->m_stats.is_worker = true;
+            ctx->m_stats.is_io_worker = true;
+            while (true)
+            {
+                g_io_jobs_semaphore.acquire();
+                if (g_job_system_exiting) break;
+                g_io_jobs_lock.lock();
+                JobHeader* job = g_io_jobs.front();
+                g_io_jobs.pop_front();
+                g_io_jobs_lock.unlock();
+                perf_counter_add(g_queued_jobs_counter, -1);
+                run_job(ctx, job);
+            }
+        }
+        // Pushes the job to the job queue without waking up workers.
+        // Returns `true` if the job is pushed to the queue of normal workers, returns `false` if the job is pushed to the IO queue.
+        static bool push_job(JobHeader* job)
+        {
+            perf_counter_add(g_queued_jobs_counter, 1);
+            if (job->m_priority == JobPriority::io && !g_io_worker_threads.empty())
+            {
+                g_io_jobs_lock.lock();
+                g_io_jobs.push_back(job);
+                g_io_jobs_lock.unlock();
+                g_io_jobs_semaphore.release();
+                return false;
+            }
+            // IO jobs are executed as background jobs if no IO worker is reserved.
+            u32 queue = min((u32)job->m_priority, (u32)JobPriority::background);
+            WorkerThreadContext* ctx = get_current_thread_worker_context();
+            ctx->m_jobs[queue].push(job);
+            return true;
+        }
+        static void enqueue_job(JobHeader* job)
+        {
+            if (push_job(job))
+            {
+                wake_workers(1);
+            }
+        }
+        static void release_wait_list(JobWaitList* list)
+        {
+            if (atom_dec_u32(&list->m_num_waits) == 0)
+            {
+                // All waiting job IDs are finished, schedules the job or resumes the fiber.
+                JobHeader* job = list->m_job;
+                JobFiber* fiber = list->m_fiber;
+                free_job_block(list, list->m_size_class, alignof(JobWaitList));
+                if (job)
+                {
+                    enqueue_job(job);
+                }
+                else
+                {
+                    g_ready_fibers_lock.lock();
+                    g_ready_fibers.push_back(fiber);
+                    atom_inc_u32(&g_num_ready_fibers);
+                    g_ready_fibers_lock.unlock();
+                    wake_workers(1);
+                }
+            }
+        }
+        static void notify_waiting_jobs(JobWaitNode* node)
+        {
+            while (node)
+            {
+                // The node may be freed after the list is released.
+                JobWaitNode* next = node->m_next;
+                release_wait_list(node->m_list);
+                node = next;
+            }
+        }
+        LUNA_JOBSYSTEM_API job_id_t submit_job(void* params, JobPriority priority)
         {
             JobHeader* job = get_job_header(params);
             job_id_t id = allocate_job_id();
             job->m_id = id;
-            WorkerThreadContext* ctx = get_current_thread_worker_context();
-            LockGuard lock(ctx->m_lock);
-            ctx->m_jobs.push_back(job);
-            // Wake up one worker thread if any.
-            g_sleep_worker_threads_lock.lock();
-            if (!g_sleep_worker_threads.empty())
+            job->m_priority = priority;
+            enqueue_job(job);
+            return id;
+        }
+        // Adds the node to the wait list of the job ID. Returns `false` if the job ID is already finished, in which case
+        // the node is not added.
+        static bool add_wait_node(job_id_t wait_job, JobWaitNode* node)
+        {
+            if (wait_job == INVALID_JOB_ID) return false;
+            u32 index = (u32)(wait_job & U32_MAX);
+            u32 generation = (u32)(wait_job >> 32);
+            luassert(index < g_num_job_slots);
+            JobSlot* slot = get_job_slot(index);
+            LockGuard guard(slot->m_wait_list_lock);
+            if (slot->m_generation != generation) return false;
+            node->m_next = slot->m_wait_list;
+            slot->m_wait_list = node;
+            return true;
+        }
+        LUNA_JOBSYSTEM_API job_id_t submit_job(void* params, Span<const job_id_t> wait_jobs, JobPriority priority)
+        {
+            if (wait_jobs.empty())
             {
-                WorkerThreadContext* worker = g_sleep_worker_threads.back();
-                g_sleep_worker_threads.pop_back();
-                worker->m_wake_signal->trigger();
+                return submit_job(params, priority);
             }
-            g_sleep_worker_threads_lock.unlock();
+            JobHeader* job = get_job_header(params);
+            job_id_t id = allocate_job_id();
+            job->m_id = id;
+            job->m_priority = priority;
+            u32 size_class;
+            JobWaitList* list = (JobWaitList*)allocate_job_block(sizeof(JobWaitList) + sizeof(JobWaitNode) * wait_jobs.size(), alignof(JobWaitList), size_class);
+            list->m_job = job;
+            list->m_fiber = nullptr;
+            list->m_size_class = size_class;
+            list->m_num_waits = (u32)wait_jobs.size() + 1;
+            JobWaitNode* nodes = list->get_nodes();
+            for (usize i = 0; i < wait_jobs.size(); ++i)
+            {
+                nodes[i].m_list = list;
+                if (!add_wait_node(wait_jobs[i], nodes + i))
+                {
+                    atom_dec_u32(&list->m_num_waits);
+                }
+            }
+            // Releases the additional count.
+            release_wait_list(list);
             return id;
         }
+        static void wait_fiber(JobFiber* f)
+        {
+            job_id_t wait_job = f->m_wait_job;
+            f->m_wait_job = INVALID_JOB_ID;
+            u32 size_class;
+            JobWaitList* list = (JobWaitList*)allocate_job_block(sizeof(JobWaitList) + sizeof(JobWaitNode), alignof(JobWaitList), size_class);
+            list->m_job = nullptr;
+            list->m_fiber = f;
+            list->m_size_class = size_class;
+            list->m_num_waits = 1;
+            JobWaitNode* node = list->get_nodes();
+            node->m_list = list;
+            if (!add_wait_node(wait_job, node))
+            {
+                // The job is finished before the wait is registered, resumes the fiber directly.
+                release_wait_list(list);
+            }
+        }
+        LUNA_JOBSYSTEM_API void submit_jobs(Span<void*> jobs, job_id_t* out_job_ids, JobPriority priority)
+        {
+            u32 num_pushed = 0;
+            for (usize i = 0; i < jobs.size(); ++i)
+            {
+                JobHeader* job = get_job_header(jobs[i]);
+                job_id_t id = allocate_job_id();
+                job->m_id = id;
+                job->m_priority = priority;
+                if (push_job(job)) ++num_pushed;
+                if (out_job_ids) out_job_ids[i] = id;
+            }
+            if (num_pushed)
+            {
+                wake_workers(num_pushed);
+            }
+        }
+        LUNA_JOBSYSTEM_API void set_job_name(void* params, const c8* name)
+        {
+            JobHeader* job = get_job_header(params);
+            job->m_name = name;
+        }
         LUNA_JOBSYSTEM_API job_id_t get_current_job_id(void* params)
         {
             JobHeader* job = get_job_header(params);
             return job->m_id;
         }
+        LUNA_JOBSYSTEM_API usize get_num_local_jobs()
+        {
+            WorkerThreadContext* ctx = get_current_thread_worker_context();
+            usize r = 0;
+            for (auto& jobs : ctx->m_jobs)
+            {
+                r += jobs.size();
+            }
+            return r;
+        }
         LUNA_JOBSYSTEM_API void wait_job(job_id_t job)
         {
+            WorkerThreadContext* ctx = get_current_thread_worker_context();
+            if (ctx->m_current_fiber)
+            {
+                if (is_job_finished(job)) return;
+                // Suspends the current fiber. The scheduler registers the wait after the fiber is switched out.
+                JobFiber* fiber = ctx->m_current_fiber;
+                fiber->m_wait_job = job;
+#ifdef LUNA_CPU_PROFILER_ENABLED
+                // The fiber may be resumed on another thread, so the zone of the job is ended on this thread
+                // and begun again on the resuming thread.
+                const c8* zone_name = fiber->m_job->m_name ? fiber->m_job->m_name : "Job";
+                profiler_zone_end();
+#endif
+                switch_to_fiber(ctx->m_scheduler_fiber);
+                // The fiber is resumed after the job is finished, possibly on another thread, so `ctx` 
+                // must not be used any more.
+#ifdef LUNA_CPU_PROFILER_ENABLED
+                profiler_zone_begin(zone_name);
+#endif
+                return;
+            }
             while (!is_job_finished(job))
             {
                 JobHeader* next_job = consume_job();
                 if (next_job)
                 {
-                    execute_job(next_job);
+                    run_job(ctx, next_job);
+                }
+                else
+                {
+                    yield_current_thread();
                 }
             }
         }
+        LUNA_JOBSYSTEM_API Vector<WorkerStats> get_worker_stats()
+        {
+            WorkerThreadContextList* list = g_worker_thread_contexts;
+            Vector<WorkerStats> r;
+            r.reserve(list->m_contexts.size());
+            for (WorkerThreadContext* ctx : list->m_contexts)
+            {
+                if (ctx->m_thread_dead) continue;
+                WorkerStats stats = ctx->m_stats;
+                stats.num_queued_jobs = 0;
+                for (auto& jobs : ctx->m_jobs)
+                {
+                    stats.num_queued_jobs += jobs.size();
+                }
+                r.push_back(stats);
+            }
+            return r;
+        }
 
         struct JobSystemModule : public Module
         {
             virtual const c8* get_name() override { return "JobSystem"; }
             virtual RV on_init() override
             {
+                register_boxed_type<JobArena>();
+                impl_interface_for_type<JobArena, IJobArena>();
                 return job_system_init();
             }
             virtual void on_close() override
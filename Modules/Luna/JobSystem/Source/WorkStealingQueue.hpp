@@ -0,0 +1,167 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file WorkStealingQueue.hpp
+* @author JXMaster
+* @date 2024/3/2
+*/
+#pragma once
+#include <Luna/Runtime/Atomic.hpp>
+#include <Luna/Runtime/Memory.hpp>
+#include <Luna/Runtime/Assert.hpp>
+
+namespace Luna
+{
+    namespace JobSystem
+    {
+        //! A lock-free work-stealing deque based on the Chase-Lev algorithm.
+        //! @details The queue is owned by one thread, which is the only thread that may call `push` and `pop`.
+        //! `pop` returns items in LIFO order. Any other thread may call `steal` to take items from the opposite end
+        //! of the queue in FIFO order.
+        //!
+        //! The internal circular buffer grows on demand. Old buffers may still be read by thieves after one grow,
+        //! so they are retired instead of freed, and released only when the queue is destroyed.
+        template <typename _Ty>
+        class WorkStealingQueue
+        {
+            struct Buffer
+            {
+                usize m_capacity;
+                Buffer* m_prev;
+                _Ty volatile m_items[1];
+
+                static Buffer* alloc(usize capacity, Buffer* prev)
+                {
+                    Buffer* buf = (Buffer*)memalloc(sizeof(Buffer) + sizeof(_Ty) * (capacity - 1), alignof(Buffer));
+                    buf->m_capacity = capacity;
+                    buf->m_prev = prev;
+                    return buf;
+                }
+                _Ty get(usize index) const
+                {
+                    return m_items[index & (m_capacity - 1)];
+                }
+                void put(usize index, _Ty item)
+                {
+                    m_items[index & (m_capacity - 1)] = item;
+                }
+            };
+
+            // `m_top` and `m_bottom` are placed in different cache lines so that the owner and thieves
+            // do not invalidate each other's cache line on every operation.
+            alignas(64) usize volatile m_top;
+            alignas(64) usize volatile m_bottom;
+            Buffer* volatile m_buffer;
+
+            Buffer* grow(Buffer* buf, usize bottom, usize top)
+            {
+                Buffer* new_buf = Buffer::alloc(buf->m_capacity * 2, buf);
+                for (usize i = top; i != bottom; ++i)
+                {
+                    new_buf->put(i, buf->get(i));
+                }
+                atom_exchange_pointer(&m_buffer, new_buf);
+                return new_buf;
+            }
+        public:
+            static_assert(is_trivially_copyable_v<_Ty>, "WorkStealingQueue only supports trivially copyable items.");
+
+            //! Constructs one empty queue.
+            //! @param[in] initial_capacity The initial capacity of the queue. This must be power of two.
+            WorkStealingQueue(usize initial_capacity = 256) :
+                m_top(0),
+                m_bottom(0)
+            {
+                luassert(initial_capacity && (initial_capacity & (initial_capacity - 1)) == 0);
+                m_buffer = Buffer::alloc(initial_capacity, nullptr);
+            }
+            WorkStealingQueue(const WorkStealingQueue&) = delete;
+            WorkStealingQueue& operator=(const WorkStealingQueue&) = delete;
+            ~WorkStealingQueue()
+            {
+                Buffer* buf = m_buffer;
+                while (buf)
+                {
+                    Buffer* prev = buf->m_prev;
+                    memfree(buf, alignof(Buffer));
+                    buf = prev;
+                }
+            }
+            //! Gets an estimated number of items in the queue.
+            //! @details The returned value may be outdated as soon as this function returns if other threads are
+            //! accessing the queue.
+            usize size() const
+            {
+                isize size = (isize)(m_bottom - m_top);
+                return size > 0 ? (usize)size : 0;
+            }
+            //! Checks whether the queue is empty. See remarks of @ref size for details.
+            bool empty() const
+            {
+                return size() == 0;
+            }
+            //! Pushes one item to the bottom of the queue. Only the owner thread can call this function.
+            void push(_Ty item)
+            {
+                usize b = m_bottom;
+                usize t = m_top;
+                Buffer* buf = m_buffer;
+                if (b - t >= buf->m_capacity)
+                {
+                    buf = grow(buf, b, t);
+                }
+                buf->put(b, item);
+                // The item must be visible before the new bottom is visible.
+                atom_memory_barrier();
+                m_bottom = b + 1;
+            }
+            //! Pops one item from the bottom of the queue. Only the owner thread can call this function.
+            //! @param[out] item The popped item.
+            //! @return Returns `true` if one item is popped, returns `false` if the queue is empty.
+            bool pop(_Ty& item)
+            {
+                usize b = m_bottom - 1;
+                Buffer* buf = m_buffer;
+                m_bottom = b;
+                // The new bottom must be visible to thieves before we read top.
+                atom_memory_barrier();
+                usize t = m_top;
+                if ((isize)(b - t) < 0)
+                {
+                    // The queue is empty.
+                    m_bottom = t;
+                    return false;
+                }
+                item = buf->get(b);
+                if (b != t)
+                {
+                    // More than one item in the queue, no race with thieves.
+                    return true;
+                }
+                // This is the last item, race with thieves by advancing top.
+                bool succeeded = atom_compare_exchange_usize(&m_top, t + 1, t) == t;
+                m_bottom = t + 1;
+                return succeeded;
+            }
+            //! Steals one item from the top of the queue. Any thread can call this function.
+            //! @param[out] item The stolen item.
+            //! @return Returns `true` if one item is stolen. Returns `false` if the queue is empty, or if
+            //! the item is taken by another thread during this call.
+            bool steal(_Ty& item)
+            {
+                usize t = m_top;
+                atom_memory_barrier();
+                usize b = m_bottom;
+                if ((isize)(b - t) <= 0)
+                {
+                    return false;
+                }
+                Buffer* buf = m_buffer;
+                item = buf->get(t);
+                return atom_compare_exchange_usize(&m_top, t + 1, t) == t;
+            }
+        };
+    }
+}
@@ -1,5 +1,6 @@
 luna_sdk_module_target("JobSystem")
     add_headerfiles("*.hpp", {prefixdir = "Luna/JobSystem"})
+    add_headerfiles("Source/**.hpp", {install = false})
     add_files("Source/**.cpp")
     add_deps("Runtime")
 target_end()
\ No newline at end of file
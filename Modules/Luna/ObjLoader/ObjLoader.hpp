@@ -64,6 +64,13 @@ namespace Luna
             // ID(0 = off. positive value
             // = group id)
             Vector<u32> smoothing_group_ids;
+            //! The unique vertices of this mesh, which can be used to build one vertex buffer directly.
+            //! @details This is built only if @ref LoadDesc::build_unique_vertices is `true`. Vertices are ordered by their 
+            //! first appearance in @ref indices.
+            Vector<Index> unique_vertices;
+            //! The index of the vertex in @ref unique_vertices for every element in @ref indices.
+            //! @details This is built only if @ref LoadDesc::build_unique_vertices is `true`.
+            Vector<u32> vertex_indices;
         };
 
         //! Describes the lines data of one shape.
@@ -117,11 +124,30 @@ namespace Luna
             Array<Shape> shapes;
         };
 
+        //! Specifies options for loading OBJ files.
+        struct LoadDesc
+        {
+            //! The size, in bytes, of one chunk of the OBJ file data.
+            //! @details The file data is split into chunks of roughly this size at line boundaries, and chunks are parsed in parallel 
+            //! by jobs of the job system. Files not larger than this are parsed on the calling thread.
+            usize chunk_size = 4 * 1024 * 1024;
+            //! Whether to build @ref Mesh::unique_vertices and @ref Mesh::vertex_indices for every mesh.
+            //! @details If this is `true`, vertices of different meshes are deduplicated in parallel, so that the user does not need 
+            //! to deduplicate vertices to build indexed vertex buffers. If de-indexed vertices are required, @ref Mesh::indices can be 
+            //! used directly.
+            bool build_unique_vertices = false;
+        };
+
         //! Loads mesh from OBJ file data.
+        //! @details The following OBJ statements are supported: `v` (with optional vertex colors), `vn`, `vt`, `f`, `l`, `p`, `o`, `g`, 
+        //! `usemtl` and `s`. Other statements are ignored. Every `o` and `g` statement starts one new shape, shapes without any element 
+        //! are not returned.
         //! @param[in] obj_file The object file (.obj) data.
-        //! @param[in] mtl_file The material file (.mtl) data. This is optional.
+        //! @param[in] mtl_file The material file (.mtl) data. This is optional. Only material names declared by `newmtl` are read from 
+        //! the file, which are used to resolve material IDs of `usemtl` statements. Faces whose material is not found use material ID `-1`.
+        //! @param[in] desc The load options.
         //! @return Returns the loaded mesh data.
-        LUNA_OBJ_LOADER_API R<ObjMesh> load(Span<const byte_t> obj_file, Span<const byte_t> mtl_file = {});
+        LUNA_OBJ_LOADER_API R<ObjMesh> load(Span<const byte_t> obj_file, Span<const byte_t> mtl_file = {}, const LoadDesc& desc = LoadDesc());
 
         //! @}
     }
@@ -2,7 +2,7 @@
 * This file is a portion of Luna SDK.
 * For conditions of distribution and use, see the disclaimer
 * and license in LICENSE.txt
-* 
+*
 * @file ObjLoader.cpp
 * @author JXMaster
 * @date 2020/5/12
@@ -11,132 +11,671 @@
 
 #define LUNA_OBJ_LOADER_API LUNA_EXPORT
 #include "../ObjLoader.hpp"
-#include "tiny_obj_loader.h"
 #include <Luna/Runtime/Module.hpp>
-
-#include <filesystem>
-#include <iostream>
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
 
 namespace Luna
 {
     namespace ObjLoader
     {
-        static_assert(sizeof(Index) == sizeof(tinyobj::index_t), "Index size does not match");
-
         struct ObjLoaderModule : public Module
         {
             virtual const c8* get_name() override { return "ObjLoader"; }
+            virtual RV on_register() override
+            {
+                return add_dependency_modules(this, {module_job_system()});
+            }
         };
 
-        void copy_shape(Shape& dst, const tinyobj::shape_t& src)
+        template <typename _Func>
+        struct ParallelForJob
         {
-            dst.name = Name(src.name.c_str());
-            
-            // Copy mesh.
-            dst.mesh.indices.resize(src.mesh.indices.size());
-            if (dst.mesh.indices.size())
+            _Func* m_func;
+            u32 m_index;
+
+            static void run(void* params)
             {
-                memcpy(&dst.mesh.indices[0], &src.mesh.indices[0], dst.mesh.indices.size() * sizeof(Index));
+                ParallelForJob* job = (ParallelForJob*)params;
+                (*job->m_func)(job->m_index);
             }
-            dst.mesh.num_face_vertices.resize(src.mesh.num_face_vertices.size());
-            if (dst.mesh.num_face_vertices.size())
+        };
+
+        // Calls `func(i)` for every `i` in [0, `n`) using jobs, and waits for all calls to finish.
+        template <typename _Func>
+        static void parallel_for(u32 n, _Func& func)
+        {
+            if (n == 1)
             {
-                memcpy(&dst.mesh.num_face_vertices[0], &src.mesh.num_face_vertices[0], dst.mesh.num_face_vertices.size() * sizeof(u8));
+                func(0);
+                return;
             }
-            dst.mesh.material_ids.resize(src.mesh.material_ids.size());
-            if (dst.mesh.material_ids.size())
+            using job_t = ParallelForJob<_Func>;
+            Vector<void*> jobs;
+            jobs.reserve(n);
+            for (u32 i = 0; i < n; ++i)
             {
-                memcpy(&dst.mesh.material_ids[0], &src.mesh.material_ids[0], dst.mesh.material_ids.size() * sizeof(i32));
+                job_t* job = (job_t*)JobSystem::new_job(job_t::run, sizeof(job_t), alignof(job_t));
+                job->m_func = &func;
+                job->m_index = i;
+                JobSystem::set_job_name(job, "ObjLoader");
+                jobs.push_back(job);
             }
-            dst.mesh.smoothing_group_ids.resize(src.mesh.smoothing_group_ids.size());
-            if (dst.mesh.smoothing_group_ids.size())
+            Vector<JobSystem::job_id_t> job_ids;
+            job_ids.resize(n);
+            JobSystem::submit_jobs({jobs.data(), jobs.size()}, job_ids.data());
+            for (auto job : job_ids) JobSystem::wait_job(job);
+        }
+
+        inline bool is_space(c8 c)
+        {
+            return c == ' ' || c == '\t' || c == '\r';
+        }
+        inline bool is_digit(c8 c)
+        {
+            return c >= '0' && c <= '9';
+        }
+        inline const c8* skip_spaces(const c8* p, const c8* end)
+        {
+            while (p < end && is_space(*p)) ++p;
+            return p;
+        }
+        inline const c8* find_line_end(const c8* p, const c8* end)
+        {
+            const c8* r = (const c8*)memchr(p, '\n', end - p);
+            return r ? r : end;
+        }
+        // Returns the string from `p` to `end` with leading and trailing spaces removed.
+        inline Name read_name(const c8* p, const c8* end)
+        {
+            p = skip_spaces(p, end);
+            while (end > p && is_space(*(end - 1))) --end;
+            return Name(p, end - p);
+        }
+        // Checks whether the statement in [`p`, `end`) starts with the specified keyword followed by one space or the line end.
+        // If `true` is returned, `p` is advanced to the end of the keyword.
+        inline bool match_keyword(const c8*& p, const c8* end, const c8* keyword)
+        {
+            const c8* s = p;
+            while (*keyword)
             {
-                memcpy(&dst.mesh.smoothing_group_ids[0], &src.mesh.smoothing_group_ids[0], dst.mesh.smoothing_group_ids.size() * sizeof(i32));
+                if (s == end || *s != *keyword) return false;
+                ++s;
+                ++keyword;
             }
+            if (s != end && !is_space(*s)) return false;
+            p = s;
+            return true;
+        }
+
+        enum class LineType : u8
+        {
+            other,
+            vertex,
+            normal,
+            texcoord,
+        };
 
-            // Copy lines.
-            dst.lines.indices.resize(src.lines.indices.size());
-            if (dst.lines.indices.size())
+        // Gets the type of one line, `p` should point to the first non-space character of the line.
+        // This is shared by the counting pass and the parsing pass, so that both passes count vertex attributes equally.
+        inline LineType get_line_type(const c8* p, const c8* end)
+        {
+            if (p == end || *p != 'v') return LineType::other;
+            if (p + 1 < end && is_space(p[1])) return LineType::vertex;
+            if (p + 2 < end && is_space(p[2]))
             {
-                memcpy(&dst.lines.indices[0], &src.lines.indices[0], dst.lines.indices.size() * sizeof(Index));
+                if (p[1] == 'n') return LineType::normal;
+                if (p[1] == 't') return LineType::texcoord;
             }
-            dst.lines.num_line_vertices.resize(src.lines.num_line_vertices.size());
-            if (dst.lines.num_line_vertices.size())
+            return LineType::other;
+        }
+
+        static const f64 g_pow10[] = {
+            1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+            1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+        };
+
+        // Parses one decimal floating-point number without locale and error checking overhead of `strtod`.
+        // Up to 19 significant digits are used, which is far beyond the precision of `f32`.
+        static bool parse_f32(const c8*& p, const c8* end, f32& out)
+        {
+            const c8* s = skip_spaces(p, end);
+            bool negative = false;
+            if (s < end && (*s == '-' || *s == '+'))
             {
-                memcpy(&dst.lines.num_line_vertices[0], &src.lines.num_line_vertices[0], dst.lines.num_line_vertices.size() * sizeof(i32));
+                negative = *s == '-';
+                ++s;
             }
-
-            // Copy points.
-            dst.points.indices.resize(src.points.indices.size());
-            if (dst.points.indices.size())
+            u64 mantissa = 0;
+            i32 exponent = 0;
+            u32 num_digits = 0;
+            bool has_digits = false;
+            while (s < end && is_digit(*s))
             {
-                memcpy(&dst.points.indices[0], &src.points.indices[0], dst.points.indices.size() * sizeof(Index));
+                if (num_digits < 19)
+                {
+                    mantissa = mantissa * 10 + (*s - '0');
+                    if (mantissa) ++num_digits;
+                }
+                else ++exponent;
+                has_digits = true;
+                ++s;
+            }
+            if (s < end && *s == '.')
+            {
+                ++s;
+                while (s < end && is_digit(*s))
+                {
+                    if (num_digits < 19)
+                    {
+                        mantissa = mantissa * 10 + (*s - '0');
+                        if (mantissa) ++num_digits;
+                        --exponent;
+                    }
+                    has_digits = true;
+                    ++s;
+                }
+            }
+            if (!has_digits) return false;
+            if (s < end && (*s == 'e' || *s == 'E'))
+            {
+                const c8* e = s + 1;
+                bool negative_exponent = false;
+                if (e < end && (*e == '-' || *e == '+'))
+                {
+                    negative_exponent = *e == '-';
+                    ++e;
+                }
+                if (e < end && is_digit(*e))
+                {
+                    i32 value = 0;
+                    while (e < end && is_digit(*e))
+                    {
+                        if (value < 10000) value = value * 10 + (*e - '0');
+                        ++e;
+                    }
+                    exponent += negative_exponent ? -value : value;
+                    s = e;
+                }
             }
+            f64 value = (f64)mantissa;
+            if (value != 0.0)
+            {
+                while (exponent > 22)
+                {
+                    value *= 1e22;
+                    exponent -= 22;
+                }
+                while (exponent < -22)
+                {
+                    value /= 1e22;
+                    exponent += 22;
+                }
+                value = exponent < 0 ? value / g_pow10[-exponent] : value * g_pow10[exponent];
+            }
+            out = (f32)(negative ? -value : value);
+            p = s;
+            return true;
+        }
+        static bool parse_i32(const c8*& p, const c8* end, i32& out)
+        {
+            const c8* s = p;
+            bool negative = false;
+            if (s < end && (*s == '-' || *s == '+'))
+            {
+                negative = *s == '-';
+                ++s;
+            }
+            if (s == end || !is_digit(*s)) return false;
+            i64 value = 0;
+            while (s < end && is_digit(*s))
+            {
+                value = value * 10 + (*s - '0');
+                if (value > I32_MAX) return false;
+                ++s;
+            }
+            out = (i32)(negative ? -value : value);
+            p = s;
+            return true;
+        }
+        // Converts one OBJ index (1-based, or negative to refer relative to the end) to one 0-based index.
+        // `current` is the number of elements declared before the statement, `total` is the number of elements in the file.
+        inline bool resolve_index(i32 index, usize current, usize total, i32& out)
+        {
+            if (index > 0) out = index - 1;
+            else if (index < 0 && (usize)(-(i64)index) <= current) out = (i32)((i64)current + index);
+            else return false;
+            return (usize)out < total;
         }
 
-        LUNA_OBJ_LOADER_API R<ObjMesh> load(Span<const byte_t> obj_file, Span<const byte_t> mtl_file)
+        // Used for faces parsed before the first `usemtl` or `s` statement of one chunk, whose values are determined
+        // by statements in previous chunks.
+        constexpr i32 INHERITED_MATERIAL_ID = -2;
+        constexpr u32 INHERITED_SMOOTHING_GROUP_ID = U32_MAX;
+
+        // The shape data parsed from one chunk.
+        struct ChunkShape
         {
+            Name name;
+            // `false` if the data continues the last shape of the previous chunk.
+            bool new_shape = false;
+            Mesh mesh;
+            Lines lines;
+            Points points;
 
-            std::string obj_source((const c8*)obj_file.data(), obj_file.size());
-            std::string mtl_source;
-            if (!mtl_file.empty())
+            bool empty() const
             {
-                mtl_source.assign((const c8*)mtl_file.data(), mtl_file.size());
+                return mesh.indices.empty() && lines.indices.empty() && points.indices.empty();
             }
+        };
 
-            tinyobj::ObjReader reader;
+        // One range of the OBJ file data split at line boundaries.
+        struct Chunk
+        {
+            const c8* m_begin;
+            const c8* m_end;
+            // Counted by the counting pass.
+            usize m_num_vertices = 0;
+            usize m_num_normals = 0;
+            usize m_num_texcoords = 0;
+            usize m_num_lines = 0;
+            // Filled by prefix sums of the counting pass results.
+            usize m_first_vertex = 0;
+            usize m_first_normal = 0;
+            usize m_first_texcoord = 0;
+            usize m_first_line = 0;
+            // Filled by the parsing pass.
+            Vector<ChunkShape> m_shapes;
+            i32 m_material_id = INHERITED_MATERIAL_ID;
+            u32 m_smoothing_group_id = INHERITED_SMOOTHING_GROUP_ID;
+            // The 1-based line number of the first invalid statement, `0` if all statements are valid.
+            usize m_error_line = 0;
+        };
 
-            bool ret = reader.ParseFromString(obj_source, mtl_source);
+        static void count_chunk(Chunk& chunk)
+        {
+            const c8* p = chunk.m_begin;
+            const c8* end = chunk.m_end;
+            while (p < end)
+            {
+                const c8* line_end = find_line_end(p, end);
+                switch (get_line_type(skip_spaces(p, line_end), line_end))
+                {
+                case LineType::vertex: ++chunk.m_num_vertices; break;
+                case LineType::normal: ++chunk.m_num_normals; break;
+                case LineType::texcoord: ++chunk.m_num_texcoords; break;
+                default: break;
+                }
+                ++chunk.m_num_lines;
+                p = line_end + 1;
+            }
+        }
+
+        struct ParseContext
+        {
+            Float3U* m_vertices;
+            Float3U* m_colors;
+            Float3U* m_normals;
+            Float2U* m_texcoords;
+            usize m_num_vertices;
+            usize m_num_normals;
+            usize m_num_texcoords;
+            const HashMap<Name, i32>* m_materials;
+        };
 
-            if (!ret)
+        // Parses indices of one `f`, `l` or `p` statement.
+        static bool parse_indices(const c8* p, const c8* end, const ParseContext& ctx, usize num_vertices, usize num_normals, usize num_texcoords,
+            bool allow_normals, Vector<Index>& out_indices, usize& out_count)
+        {
+            out_count = 0;
+            while (true)
             {
-                auto& warn = reader.Warning();
-                auto& err = reader.Error();
-                if (!err.empty())
+                p = skip_spaces(p, end);
+                if (p == end) break;
+                Index index;
+                index.normal_index = -1;
+                index.texcoord_index = -1;
+                i32 value;
+                if (!parse_i32(p, end, value) || !resolve_index(value, num_vertices, ctx.m_num_vertices, index.vertex_index)) return false;
+                if (p < end && *p == '/')
                 {
-                    return set_error(BasicError::format_error(), err.c_str());
+                    ++p;
+                    if (p < end && *p != '/' && !is_space(*p))
+                    {
+                        if (!parse_i32(p, end, value) || !resolve_index(value, num_texcoords, ctx.m_num_texcoords, index.texcoord_index)) return false;
+                    }
+                    if (p < end && *p == '/')
+                    {
+                        if (!allow_normals) return false;
+                        ++p;
+                        if (!parse_i32(p, end, value) || !resolve_index(value, num_normals, ctx.m_num_normals, index.normal_index)) return false;
+                    }
                 }
-                return BasicError::format_error();
+                if (p < end && !is_space(*p)) return false;
+                out_indices.push_back(index);
+                ++out_count;
             }
+            return true;
+        }
 
-            const tinyobj::attrib_t& attrib = reader.GetAttrib();
-            const std::vector<tinyobj::shape_t>& shapes = reader.GetShapes();
-            const std::vector<tinyobj::material_t>& meterials = reader.GetMaterials();
+        static void parse_chunk(Chunk& chunk, const ParseContext& ctx)
+        {
+            usize num_vertices = chunk.m_first_vertex;
+            usize num_normals = chunk.m_first_normal;
+            usize num_texcoords = chunk.m_first_texcoord;
+            usize line = chunk.m_first_line;
+            i32 material_id = INHERITED_MATERIAL_ID;
+            u32 smoothing_group_id = INHERITED_SMOOTHING_GROUP_ID;
+            chunk.m_shapes.emplace_back();
+            ChunkShape* shape = &chunk.m_shapes.back();
+            const c8* p = chunk.m_begin;
+            const c8* end = chunk.m_end;
+            while (p < end)
+            {
+                const c8* line_end = find_line_end(p, end);
+                ++line;
+                const c8* s = skip_spaces(p, line_end);
+                bool valid = true;
+                switch (get_line_type(s, line_end))
+                {
+                case LineType::vertex:
+                {
+                    ++s;
+                    Float3U& v = ctx.m_vertices[num_vertices];
+                    valid = parse_f32(s, line_end, v.x) && parse_f32(s, line_end, v.y) && parse_f32(s, line_end, v.z);
+                    // The fourth value is either the weight, which is ignored, or the red channel of the vertex color.
+                    Float3U color;
+                    if (valid && parse_f32(s, line_end, color.x) && parse_f32(s, line_end, color.y) && parse_f32(s, line_end, color.z))
+                    {
+                        ctx.m_colors[num_vertices] = color;
+                    }
+                    ++num_vertices;
+                    break;
+                }
+                case LineType::normal:
+                {
+                    s += 2;
+                    Float3U& n = ctx.m_normals[num_normals];
+                    valid = parse_f32(s, line_end, n.x) && parse_f32(s, line_end, n.y) && parse_f32(s, line_end, n.z);
+                    ++num_normals;
+                    break;
+                }
+                case LineType::texcoord:
+                {
+                    s += 2;
+                    Float2U& t = ctx.m_texcoords[num_texcoords];
+                    valid = parse_f32(s, line_end, t.x);
+                    if (valid && !parse_f32(s, line_end, t.y)) t.y = 0.0f;
+                    ++num_texcoords;
+                    break;
+                }
+                default:
+                {
+                    usize count;
+                    if (match_keyword(s, line_end, "f"))
+                    {
+                        valid = parse_indices(s, line_end, ctx, num_vertices, num_normals, num_texcoords, true, shape->mesh.indices, count);
+                        if (valid && count >= 3 && count <= 255)
+                        {
+                            shape->mesh.num_face_vertices.push_back((u8)count);
+                            shape->mesh.material_ids.push_back(material_id);
+                            shape->mesh.smoothing_group_ids.push_back(smoothing_group_id);
+                        }
+                        else valid = false;
+                    }
+                    else if (match_keyword(s, line_end, "l"))
+                    {
+                        valid = parse_indices(s, line_end, ctx, num_vertices, num_normals, num_texcoords, false, shape->lines.indices, count);
+                        if (valid && count >= 2) shape->lines.num_line_vertices.push_back((i32)count);
+                        else valid = false;
+                    }
+                    else if (match_keyword(s, line_end, "p"))
+                    {
+                        valid = parse_indices(s, line_end, ctx, num_vertices, num_normals, num_texcoords, false, shape->points.indices, count);
+                    }
+                    else if (match_keyword(s, line_end, "o") || match_keyword(s, line_end, "g"))
+                    {
+                        // Empty shapes are reused, so that `o` and `g` statements that follow each other produce only one shape.
+                        if (!shape->empty())
+                        {
+                            chunk.m_shapes.emplace_back();
+                            shape = &chunk.m_shapes.back();
+                        }
+                        shape->name = read_name(s, line_end);
+                        shape->new_shape = true;
+                    }
+                    else if (match_keyword(s, line_end, "usemtl"))
+                    {
+                        auto iter = ctx.m_materials->find(read_name(s, line_end));
+                        material_id = iter == ctx.m_materials->end() ? -1 : iter->second;
+                    }
+                    else if (match_keyword(s, line_end, "s"))
+                    {
+                        s = skip_spaces(s, line_end);
+                        i32 value;
+                        smoothing_group_id = (parse_i32(s, line_end, value) && value > 0) ? (u32)value : 0;
+                    }
+                    break;
+                }
+                }
+                if (!valid)
+                {
+                    chunk.m_error_line = line;
+                    return;
+                }
+                p = line_end + 1;
+            }
+            chunk.m_material_id = material_id;
+            chunk.m_smoothing_group_id = smoothing_group_id;
+        }
 
-            ObjMesh obj;
+        static HashMap<Name, i32> parse_materials(Span<const byte_t> mtl_file)
+        {
+            HashMap<Name, i32> materials;
+            const c8* p = (const c8*)mtl_file.data();
+            const c8* end = p + mtl_file.size();
+            while (p < end)
+            {
+                const c8* line_end = find_line_end(p, end);
+                const c8* s = skip_spaces(p, line_end);
+                if (match_keyword(s, line_end, "newmtl"))
+                {
+                    materials.insert(make_pair(read_name(s, line_end), (i32)materials.size()));
+                }
+                p = line_end + 1;
+            }
+            return materials;
+        }
 
-            auto& attributes = obj.attributes;
+        template <typename _Ty>
+        static void append(Vector<_Ty>& dst, Vector<_Ty>& src)
+        {
+            if (dst.empty()) dst = move(src);
+            else dst.insert(dst.end(), src.data(), src.data() + src.size());
+        }
+
+        // Deduplicates vertices of one mesh using one open addressing hash table of vertex indices,
+        // which is much faster than node-based hash maps for large meshes.
+        static void build_unique_vertices(Mesh& mesh)
+        {
+            usize num_indices = mesh.indices.size();
+            mesh.unique_vertices.clear();
+            mesh.vertex_indices.resize(num_indices);
+            if (!num_indices) return;
+            usize capacity = 16;
+            while (capacity < num_indices * 2) capacity <<= 1;
+            Vector<u32> table;
+            table.resize(capacity, U32_MAX);
+            usize mask = capacity - 1;
+            for (usize i = 0; i < num_indices; ++i)
+            {
+                const Index& index = mesh.indices[i];
+                u64 h = ((u64)(u32)index.vertex_index * 0x9E3779B97F4A7C15ULL) ^
+                    ((u64)(u32)index.normal_index * 0xC2B2AE3D27D4EB4FULL) ^
+                    ((u64)(u32)index.texcoord_index * 0x165667B19E3779F9ULL);
+                usize slot = (usize)(h ^ (h >> 32)) & mask;
+                while (true)
+                {
+                    u32 vertex = table[slot];
+                    if (vertex == U32_MAX)
+                    {
+                        vertex = (u32)mesh.unique_vertices.size();
+                        mesh.unique_vertices.push_back(index);
+                        table[slot] = vertex;
+                        mesh.vertex_indices[i] = vertex;
+                        break;
+                    }
+                    if (mesh.unique_vertices[vertex] == index)
+                    {
+                        mesh.vertex_indices[i] = vertex;
+                        break;
+                    }
+                    slot = (slot + 1) & mask;
+                }
+            }
+        }
 
-            // Copy attributes.
-            attributes.vertices.assign(attrib.vertices.size() / 3);
-            attributes.normals.assign(attrib.normals.size() / 3);
-            attributes.texcoords.assign(attrib.texcoords.size() / 2);
-            attributes.colors.assign(attrib.colors.size() / 3);
+        LUNA_OBJ_LOADER_API R<ObjMesh> load(Span<const byte_t> obj_file, Span<const byte_t> mtl_file, const LoadDesc& desc)
+        {
+            ObjMesh obj;
+            if (obj_file.empty()) return obj;
 
-            if (attributes.vertices.size())
+            // Split the file at line boundaries.
+            Vector<Chunk> chunks;
+            const c8* data = (const c8*)obj_file.data();
+            const c8* data_end = data + obj_file.size();
+            usize chunk_size = desc.chunk_size ? desc.chunk_size : obj_file.size();
+            const c8* p = data;
+            while (p < data_end)
             {
-                memcpy(&attributes.vertices[0], &attrib.vertices[0], sizeof(Float3U) * attributes.vertices.size());
+                const c8* chunk_end = data_end;
+                if ((usize)(data_end - p) > chunk_size)
+                {
+                    chunk_end = find_line_end(p + chunk_size, data_end);
+                    if (chunk_end < data_end) ++chunk_end;
+                }
+                chunks.emplace_back();
+                Chunk& chunk = chunks.back();
+                chunk.m_begin = p;
+                chunk.m_end = chunk_end;
+                p = chunk_end;
             }
-            if (attributes.normals.size())
+            u32 num_chunks = (u32)chunks.size();
+
+            // Count vertex attributes of every chunk, so that every chunk can write attributes to their final positions,
+            // and can resolve relative indices directly.
+            auto count_func = [&](u32 i) { count_chunk(chunks[i]); };
+            parallel_for(num_chunks, count_func);
+            usize num_vertices = 0;
+            usize num_normals = 0;
+            usize num_texcoords = 0;
+            usize num_lines = 0;
+            for (Chunk& chunk : chunks)
             {
-                memcpy(&attributes.normals[0], &attrib.normals[0], sizeof(Float3U) * attributes.normals.size());
+                chunk.m_first_vertex = num_vertices;
+                chunk.m_first_normal = num_normals;
+                chunk.m_first_texcoord = num_texcoords;
+                chunk.m_first_line = num_lines;
+                num_vertices += chunk.m_num_vertices;
+                num_normals += chunk.m_num_normals;
+                num_texcoords += chunk.m_num_texcoords;
+                num_lines += chunk.m_num_lines;
             }
-            if (attributes.texcoords.size())
+            if (num_vertices > (usize)I32_MAX || num_normals > (usize)I32_MAX || num_texcoords > (usize)I32_MAX)
             {
-                memcpy(&attributes.texcoords[0], &attrib.texcoords[0], sizeof(Float2U) * attributes.texcoords.size());
+                return set_error(BasicError::format_error(), "The number of vertex attributes exceeds the limit of 32-bit indices.");
             }
-            if (attributes.colors.size())
+            auto& attributes = obj.attributes;
+            attributes.vertices.assign(num_vertices);
+            attributes.colors.assign(num_vertices, Float3U(1.0f, 1.0f, 1.0f));
+            attributes.normals.assign(num_normals);
+            attributes.texcoords.assign(num_texcoords);
+
+            // Parse chunks.
+            HashMap<Name, i32> materials = parse_materials(mtl_file);
+            ParseContext ctx;
+            ctx.m_vertices = attributes.vertices.data();
+            ctx.m_colors = attributes.colors.data();
+            ctx.m_normals = attributes.normals.data();
+            ctx.m_texcoords = attributes.texcoords.data();
+            ctx.m_num_vertices = num_vertices;
+            ctx.m_num_normals = num_normals;
+            ctx.m_num_texcoords = num_texcoords;
+            ctx.m_materials = &materials;
+            auto parse_func = [&](u32 i) { parse_chunk(chunks[i], ctx); };
+            parallel_for(num_chunks, parse_func);
+            for (Chunk& chunk : chunks)
             {
-                memcpy(&attributes.colors[0], &attrib.colors[0], sizeof(Float3U) * attributes.colors.size());
+                if (chunk.m_error_line)
+                {
+                    return set_error(BasicError::format_error(), "Invalid OBJ statement at line %llu.", (u64)chunk.m_error_line);
+                }
             }
 
-            // Copy shape information.
-            obj.shapes.assign(shapes.size());
-            for (usize i = 0; i < shapes.size(); ++i)
+            // Merge shapes of all chunks.
+            Vector<Shape> shapes;
+            i32 material_id = -1;
+            u32 smoothing_group_id = 0;
+            for (Chunk& chunk : chunks)
             {
-                copy_shape(obj.shapes[i], shapes[i]);
+                // Only faces before the first `usemtl` or `s` statement of the chunk inherit values from previous chunks.
+                bool material_resolved = false;
+                bool smoothing_group_resolved = false;
+                for (ChunkShape& src : chunk.m_shapes)
+                {
+                    for (usize i = 0; i < src.mesh.material_ids.size() && !(material_resolved && smoothing_group_resolved); ++i)
+                    {
+                        if (!material_resolved)
+                        {
+                            if (src.mesh.material_ids[i] == INHERITED_MATERIAL_ID) src.mesh.material_ids[i] = material_id;
+                            else material_resolved = true;
+                        }
+                        if (!smoothing_group_resolved)
+                        {
+                            if (src.mesh.smoothing_group_ids[i] == INHERITED_SMOOTHING_GROUP_ID) src.mesh.smoothing_group_ids[i] = smoothing_group_id;
+                            else smoothing_group_resolved = true;
+                        }
+                    }
+                    if (src.new_shape || shapes.empty())
+                    {
+                        shapes.emplace_back();
+                        shapes.back().name = src.name;
+                    }
+                    Shape& dst = shapes.back();
+                    append(dst.mesh.indices, src.mesh.indices);
+                    append(dst.mesh.num_face_vertices, src.mesh.num_face_vertices);
+                    append(dst.mesh.material_ids, src.mesh.material_ids);
+                    append(dst.mesh.smoothing_group_ids, src.mesh.smoothing_group_ids);
+                    append(dst.lines.indices, src.lines.indices);
+                    append(dst.lines.num_line_vertices, src.lines.num_line_vertices);
+                    append(dst.points.indices, src.points.indices);
+                }
+                if (chunk.m_material_id != INHERITED_MATERIAL_ID) material_id = chunk.m_material_id;
+                if (chunk.m_smoothing_group_id != INHERITED_SMOOTHING_GROUP_ID) smoothing_group_id = chunk.m_smoothing_group_id;
             }
+            chunks.clear();
+            usize num_shapes = 0;
+            for (Shape& shape : shapes)
+            {
+                if (!shape.mesh.indices.empty() || !shape.lines.indices.empty() || !shape.points.indices.empty()) ++num_shapes;
+            }
+            obj.shapes.assign(num_shapes);
+            num_shapes = 0;
+            for (Shape& shape : shapes)
+            {
+                if (!shape.mesh.indices.empty() || !shape.lines.indices.empty() || !shape.points.indices.empty())
+                {
+                    obj.shapes[num_shapes] = move(shape);
+                    ++num_shapes;
+                }
+            }
+            shapes.clear();
 
+            if (desc.build_unique_vertices)
+            {
+                auto unique_func = [&](u32 i) { build_unique_vertices(obj.shapes[i].mesh); };
+                parallel_for((u32)obj.shapes.size(), unique_func);
+            }
             return obj;
         }
     }
@@ -146,4 +685,4 @@ namespace Luna
         static ObjLoader::ObjLoaderModule m;
         return &m;
     }
-}
\ No newline at end of file
+}
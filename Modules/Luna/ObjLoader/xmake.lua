@@ -1,5 +1,5 @@
 luna_sdk_module_target("ObjLoader")
     add_headerfiles("*.hpp", {prefixdir = "Luna/ObjLoader"})
     add_files("Source/**.cpp")
-    add_deps("Runtime")
+    add_deps("Runtime", "JobSystem")
 target_end()
\ No newline at end of file
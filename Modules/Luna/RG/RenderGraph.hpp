@@ -9,6 +9,7 @@
 */
 #pragma once
 #include "RenderPass.hpp"
+#include <Luna/Runtime/Variant.hpp>
 
 namespace Luna
 {
@@ -17,6 +18,21 @@ namespace Luna
         //! @addtogroup RG
         //! @{
         
+        //! Specifies flags of one render pass in one render graph.
+        enum class RenderGraphPassFlag : u8
+        {
+            none = 0x00,
+            //! This render pass only records compute and copy commands, and can be executed on the async compute queue
+            //! specified by @ref RenderGraphCompileConfig::async_compute_queue, so that it can overlap with graphics passes
+            //! that do not depend on it. This flag is ignored if async compute is not enabled when compiling the render graph.
+            async_compute = 0x01,
+            //! This render pass only records copy commands, and can be executed on the async copy queue specified by 
+            //! @ref RenderGraphCompileConfig::async_copy_queue, so that it can overlap with passes on other queues that do not depend on it.
+            //! If async copy is not enabled, the render pass is executed on the async compute queue if async compute is enabled, 
+            //! otherwise this flag is ignored.
+            async_copy = 0x02,
+        };
+
         //! Describes one render pass node in one render graph.
         struct RenderGraphPassNode
         {
@@ -24,20 +40,25 @@ namespace Luna
             Name name;
             //! The render pass type.
             Name type;
+            //! The render pass flags.
+            RenderGraphPassFlag flags = RenderGraphPassFlag::none;
         };
 
         //! Specifies the residency type of one resource in one render graph.
         enum class RenderGraphResourceType : u8
         {
             //! This resource is used to hold temporal data during the render graph execution.
-            //! The render graph allocates this resource at first access, and releases the resource after last 
-            //! access.
+            //! The render graph creates this resource when the graph is being compiled, and places transient resources 
+            //! whose lifetimes (from first access to last access) do not overlap in the same device memory, so that 
+            //! no resource is created when the render graph is executed. Data of transient resources is not preserved 
+            //! between render graph executions.
             transient = 0,
             //! This resource is persistent. Such resources are used to hold data between render graph executions.
             //! The render graph allocates this resource when the graph is being compiled, 
             //! and does not release it after the render graph execution is finished.
             //! 
-            //! This resource will be released when the render graph is destructed or recompiled.
+            //! This resource will be released when the render graph is destructed, or is recompiled with a different resource descriptor
+            //! for this resource. If the descriptor is not changed, the resource and its data are kept when the render graph is recompiled.
             persistent = 1,
             //! This resource is imported to the render graph. 
             //! The render graph does not manage the resource lifetime.
@@ -98,6 +119,85 @@ namespace Luna
             //! Whether to enable render pass time profiling. If this is `true`, the render graph creates one query heap
             //! that can be used by the render pass object to record start and end time of the render pass.
             bool enable_time_profiling = false;
+            //! The index of the command queue used to execute render passes with @ref RenderGraphPassFlag::async_compute.
+            //! The command queue must be one @ref RHI::CommandQueueType::compute or @ref RHI::CommandQueueType::graphics queue
+            //! other than the queue of the command buffer passed to @ref IRenderGraph::execute.
+            //! If this is `U32_MAX`, async compute is disabled and all render passes are executed on the command buffer passed to 
+            //! @ref IRenderGraph::execute.
+            u32 async_compute_queue = U32_MAX;
+            //! The index of the command queue used to execute render passes with @ref RenderGraphPassFlag::async_copy.
+            //! The command queue must be one @ref RHI::CommandQueueType::copy, @ref RHI::CommandQueueType::compute or
+            //! @ref RHI::CommandQueueType::graphics queue other than the queue of the command buffer passed to @ref IRenderGraph::execute
+            //! and `async_compute_queue`.
+            //! If this is `U32_MAX`, async copy is disabled.
+            u32 async_copy_queue = U32_MAX;
+            //! Whether to record render passes on multiple threads.
+            //! @details If this is `true`, enabled render passes are split into groups of continuous passes, and passes of different groups 
+            //! are recorded concurrently into different command buffers managed by the render graph using the job system. Command buffers
+            //! are submitted in pass order, so the execution order of render passes and their dependencies are not changed.
+            //! 
+            //! Groups are recorded into primary command buffers rather than secondary command buffers created by 
+            //! @ref RHI::IDevice::new_secondary_command_buffer, since every render pass records resource barriers and debug events 
+            //! and begins its own render, compute or copy passes, while secondary command buffers can only record draw commands 
+            //! in one render pass begun by @ref RHI::ICommandBuffer::begin_parallel_render_pass. Render passes that record many 
+            //! draw calls into one render pass can use secondary command buffers themselves to split recording further.
+            //! 
+            //! Render passes recorded concurrently must not modify shared states without synchronization.
+            bool enable_parallel_recording = false;
+            //! The number of executions that one temporary resource released by render passes is kept in the temporary resource pool
+            //! without being reused. Resources that are not reused in this number of executions are destroyed.
+            //! See @ref IRenderPassContext::allocate_temporary_resource for details.
+            u32 temporary_resource_lifetime = 1;
+        };
+
+        //! Describes statistics of one enabled render pass in one render graph.
+        struct RenderGraphPassStats
+        {
+            //! The index of the render pass in @ref RenderGraphDesc::passes.
+            usize pass;
+            //! The GPU time of the render pass in the last execution, measured in GPU ticks. See @ref IRenderGraph::get_pass_time_intervals
+            //! for details. This is `0` if @ref RenderGraphCompileConfig::enable_time_profiling is `false`.
+            u64 gpu_time;
+            //! The CPU time used to record the render pass in the last execution, measured in CPU ticks. 
+            //! Use @ref get_ticks_per_second to convert ticks to seconds.
+            u64 cpu_time;
+            //! The number of buffer barriers issued by the render graph before the render pass in the last execution.
+            u32 num_buffer_barriers;
+            //! The number of texture barriers issued by the render graph before the render pass in the last execution.
+            u32 num_texture_barriers;
+        };
+
+        //! Describes statistics of one resource in one render graph.
+        struct RenderGraphResourceStats
+        {
+            //! The index of the first render pass that accesses the resource in @ref RenderGraphDesc::passes.
+            //! This is `USIZE_MAX` if the resource is not accessed by any enabled render pass.
+            usize first_pass;
+            //! The index of the last render pass that accesses the resource in @ref RenderGraphDesc::passes.
+            usize last_pass;
+            //! The estimated memory size of the resource in bytes.
+            u64 size;
+            //! The index of the transient heap in @ref RenderGraphStats::transient_heap_sizes that the resource is placed in.
+            //! This is `USIZE_MAX` if the resource is not one transient resource, or is not accessed.
+            usize heap;
+        };
+
+        //! Describes statistics of one render graph.
+        struct RenderGraphStats
+        {
+            //! The statistics of every enabled render pass in execution order.
+            Vector<RenderGraphPassStats> passes;
+            //! The statistics of every resource, in the same order as @ref RenderGraphDesc::resources.
+            Vector<RenderGraphResourceStats> resources;
+            //! The size of every device memory that transient resources are placed in.
+            Vector<u64> transient_heap_sizes;
+            //! The estimated memory size required if every transient resource is created in its own memory (without aliasing).
+            u64 transient_memory_size_without_aliasing;
+            //! The memory size used by all transient resources (with aliasing), which is the sum of @ref transient_heap_sizes.
+            u64 transient_memory_size;
+            //! The maximum estimated memory size of transient resources that are accessed by one render pass or that are alive 
+            //! when one render pass is executed. This is the lower bound of @ref transient_memory_size.
+            u64 transient_memory_peak;
         };
 
         //! @interface IRenderGraph
@@ -128,12 +228,49 @@ namespace Luna
             //! output resources.
             //! 3. Determines the lifetime of every transient resource.
             //! 4. Initialize resource descriptors using user-defined descriptors.
-            //! 5. Calls the compile callback of every render pass in execution order to get render pass objects.
-            //! 6. Create persistent resources.
+            //! 5. Calls the compile callback of every render pass in execution order to get render pass objects, and records 
+            //! resource states declared by render pass parameters (see @ref RenderPassTypeParameter::texture_state and 
+            //! @ref RenderPassTypeParameter::buffer_state). Barriers for these states are issued in one batch before every pass 
+            //! is executed, so render passes do not need to issue barriers for resources bound to such parameters.
+            //! 
+            //! If one render pass is compiled in the last compilation with the same render pass type, the same connections and the same 
+            //! descriptors of connected resources, and is not marked by @ref mark_render_pass_dirty, the compile callback is not called, and 
+            //! the render pass object and resource descriptors produced by the last compilation are reused. So changing one part of the 
+            //! render graph only recompiles render passes affected by the change.
+            //! 6. Create persistent resources. Persistent resources whose descriptors are not changed since the last compilation are reused.
             //! 7. Create time query heap if needed.
+            //! 8. Split render passes into command buffer segments if async queues or parallel recording is enabled, and assign passes 
+            //! of every segment to command buffers.
+            //! 9. Place transient resources in device memory based on their lifetimes and create them.
+            //! 
+            //! If one compile cache is set by @ref set_compile_cache and the cache is produced from the same render graph descriptor and
+            //! compilation configuration, step 2 and 3 are skipped and results are read from the cache. In step 9, the cached memory 
+            //! layout of transient resources is used if the resolved descriptors of all transient resources match the cached ones.
             //! @param[in] config The compilation configuration.
             virtual RV compile(const RenderGraphCompileConfig& config) = 0;
 
+            //! Marks one render pass as dirty, so that the compile callback of the render pass is always called in the next @ref compile.
+            //! @details Call this if the compile callback of the render pass depends on states other than descriptors of connected resources, 
+            //! and such states are changed.
+            //! @param[in] index The index of the render pass to mark.
+            virtual void mark_render_pass_dirty(usize index) = 0;
+
+            //! Gets the compile cache of the last compilation.
+            //! @details The compile cache contains one hash of the render graph descriptor and compilation configuration, the enabled 
+            //! render passes, the lifetime of every resource, the resolved resource descriptors and the memory layout of transient resources.
+            //! The cache can be serialized (for example, using `VariantUtils::write_json`), and set by @ref set_compile_cache in the next 
+            //! run of the application to skip analysis steps of @ref compile.
+            //! @return Returns the compile cache.
+            //! @par Possible Errors
+            //! * BasicError::bad_calling_time if the render graph is not compiled.
+            virtual R<Variant> get_compile_cache() = 0;
+
+            //! Sets the compile cache used by succeeding compilations.
+            //! @details The cache is ignored if it is produced from a different render graph descriptor or compilation configuration, 
+            //! so it is always safe to set one cache even if the render graph may be changed.
+            //! @param[in] cache The compile cache returned by @ref get_compile_cache.
+            virtual void set_compile_cache(const Variant& cache) = 0;
+
             //! Gets all enabled render passes.
             //! @details This should be called after @ref compile, or no render pass will be returned.
             //! @param[out] render_passes Returns the array of indices of enabled render passes.
@@ -157,8 +294,25 @@ namespace Luna
             //! Executes the render graph.
             //! @details This will execute all enabled render passes in order.
             //! @param[in] cmdbuf The command buffer used to record render commands of this render graph.
+            //! @details If async compute or async copy is enabled and at least one enabled render pass is executed on async queues
+            //! (see @ref RenderGraphPassFlag::async_compute and @ref RenderGraphPassFlag::async_copy), render passes are split into 
+            //! segments of continuous passes that are executed on the same queue, and every segment is recorded into one command buffer 
+            //! managed by the render graph and submitted to the queue of `cmdbuf`, @ref RenderGraphCompileConfig::async_compute_queue or
+            //! @ref RenderGraphCompileConfig::async_copy_queue by this function. One segment waits for the last segment on another queue
+            //! that accesses resources accessed by the segment, and waits are skipped if the waited segment is already waited directly or 
+            //! indirectly by prior segments on the same queue, so async passes can overlap with independent passes on other queues.
+            //! Resource states and queue ownership transfers between queues are handled by the RHI when command buffers are submitted.
+            //! The last segment submitted to the queue of `cmdbuf` always waits for all async segments, so commands recorded into 
+            //! `cmdbuf` after this function returns can access all resources of the render graph, and `cmdbuf` itself does not 
+            //! receive render pass commands.
+            //! 
+            //! If @ref RenderGraphCompileConfig::enable_parallel_recording is `true`, render passes are recorded into command buffers managed 
+            //! by the render graph on multiple threads, and the command buffers are submitted by this function in pass order. In such case,
+            //! `cmdbuf` does not receive render pass commands either.
             //! @par Valid Usage
             //! * @ref compile must be called before calling this function.
+            //! * If async queues or parallel recording is enabled, commands recorded into `cmdbuf` before calling this function are executed 
+            //! after render passes, so render passes must not depend on such commands.
             virtual RV execute(RHI::ICommandBuffer* cmdbuf) = 0;
 
             //! Gets one persistent resource.
@@ -173,6 +327,22 @@ namespace Luna
             //! every time span in this array maps to the corresponding render pass returned by @ref get_enabled_render_passes.
             //! The time is measured in GPU ticks, and can be converted to seconds by dividing with @ref RHI::IDevice::get_command_queue_timestamp_frequency.
             virtual RV get_pass_time_intervals(Vector<u64>& pass_times) = 0;
+
+            //! Gets the begin and end timestamps of every active render pass.
+            //! @param[out] pass_timestamps The array to receive the timestamps. Two timestamps are written for every active render pass,
+            //! the timestamp of the beginning of the pass and the timestamp of the end of the pass, in the same order as render passes returned by
+            //! @ref get_enabled_render_passes. 
+            //! The timestamps are measured in GPU ticks, and can be converted to seconds by dividing with @ref RHI::IDevice::get_command_queue_timestamp_frequency.
+            //! Unlike @ref get_pass_time_intervals, the timestamps can be used to place passes onto one timeline.
+            virtual RV get_pass_timestamps(Vector<u64>& pass_timestamps) = 0;
+
+            //! Gets statistics of the render graph, including GPU and CPU time of every render pass, barriers issued by the render graph,
+            //! lifetimes of resources and memory used by transient resources.
+            //! @details Memory statistics are updated when the render graph is compiled, and time and barrier statistics are updated 
+            //! when the render graph is executed. GPU time is read from the timestamp query heap, so the last execution must be finished 
+            //! by GPU before calling this.
+            //! @param[out] stats Returns the statistics.
+            virtual RV get_stats(RenderGraphStats& stats) = 0;
         };
 
         //! Creates one new render graph.
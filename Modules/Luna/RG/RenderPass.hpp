@@ -89,6 +89,25 @@ namespace Luna
             //! @param[in] name The name of the output resource.
             //! @return Returns the fetched output resource. Returns `nullptr` if not found.
             virtual RHI::IResource* get_output(const Name& name) = 0;
+
+            //! Gets the load operation that should be used if the specified input or output texture is bound as one render pass attachment.
+            //! @details The operation is determined from the lifetime of the resource: if the resource is one transient resource and this
+            //! render pass is the first enabled pass that accesses it, the resource content is undefined, and @ref RHI::LoadOp::dont_care
+            //! is returned so that tile-based GPUs can skip loading the attachment from memory. Otherwise, @ref RHI::LoadOp::load is returned.
+            //! 
+            //! Render passes that clear the attachment should use @ref RHI::LoadOp::clear directly.
+            //! @param[in] name The name of the input or output resource.
+            //! @return Returns the load operation to use.
+            virtual RHI::LoadOp get_attachment_load_op(const Name& name) = 0;
+
+            //! Gets the store operation that should be used if the specified input or output texture is bound as one render pass attachment.
+            //! @details The operation is determined from the lifetime of the resource: if the resource is one transient resource that is 
+            //! not marked as @ref RenderGraphResourceFlag::output and this render pass is the last enabled pass that accesses it, the resource 
+            //! content is not used anymore, and @ref RHI::StoreOp::dont_care is returned so that tile-based GPUs can skip writing the 
+            //! attachment back to memory. Otherwise, @ref RHI::StoreOp::store is returned.
+            //! @param[in] name The name of the input or output resource.
+            //! @return Returns the store operation to use.
+            virtual RHI::StoreOp get_attachment_store_op(const Name& name) = 0;
             
             //! Gets the timestamp query heap used to track the running time of the render pass.
             //! @param[out] begin_index If not `nullptr`, returns the query heap index to write the beginning timestamp of the render pass.
@@ -100,6 +119,10 @@ namespace Luna
             //! Allocates new temporary resource that exists only in the current pass.
             //! @details The allocated The resource will be released when the pass is finished, or the user can 
             //! release it manually using @ref release_temporary_resource.
+            //! 
+            //! Released resources are pooled by the render graph using the hash of their descriptors, so allocating one resource with 
+            //! the same descriptor in succeeding executions returns the pooled resource without creating new resources. Pooled resources 
+            //! that are not reused in @ref RenderGraphCompileConfig::temporary_resource_lifetime executions are destroyed.
             virtual R<Ref<RHI::IResource>> allocate_temporary_resource(const ResourceDesc& desc) = 0;
 
             //! Releases the temporary resource allocated from @ref allocate_temporary_resource.
@@ -171,6 +194,20 @@ namespace Luna
             Name name;
             //! A short description of the parameter, this is used only for visualizing and debugging purpose.
             Name desc;
+            //! The state that the render pass uses the texture bound to this parameter in.
+            //! @details If this is not @ref RHI::TextureStateFlag::automatic, the render graph transitions the texture to this 
+            //! state before the render pass is executed, so the render pass does not need to issue barriers for the texture.
+            //! Barriers of all resources of one render pass are batched into one barrier call. 
+            //! 
+            //! Keep this as @ref RHI::TextureStateFlag::automatic if the render pass uses the texture in multiple states or
+            //! transitions subresources of the texture separately, in which case the render pass should issue barriers itself.
+            RHI::TextureStateFlag texture_state = RHI::TextureStateFlag::automatic;
+            //! The state that the render pass uses the buffer bound to this parameter in.
+            //! @details This works the same as `texture_state`, but for buffers.
+            RHI::BufferStateFlag buffer_state = RHI::BufferStateFlag::automatic;
+            //! Whether the render pass overwrites all content of the resource bound to this parameter, so that the old content
+            //! does not need to be preserved when the resource is transitioned. Used only if `texture_state` or `buffer_state` is specified.
+            bool discard_content = false;
         };
         
         //! Describes one render pass type
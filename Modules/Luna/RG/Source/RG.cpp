@@ -13,22 +13,28 @@
 #include <Luna/Runtime/Module.hpp>
 #include "RenderGraph.hpp"
 #include "../RG.hpp"
+#include <Luna/JobSystem/JobSystem.hpp>
 namespace Luna
 {
     namespace RG
     {
+        perf_counter_t g_transient_memory_counter = 0;
+
         struct RGModule : public Module
         {
             virtual const c8* get_name() override { return "RG"; }
             virtual RV on_register() override
             {
-                return add_dependency_module(this, module_rhi());
+                return add_dependency_modules(this, {module_rhi(), module_job_system()});
             }
             virtual RV on_init() override
             {
                 register_boxed_type<RenderGraph>();
-                impl_interface_for_type<RenderGraph, IRenderGraph, IRenderPassContext, IRenderGraphCompiler>();
+                impl_interface_for_type<RenderGraph, IRenderGraph, IRenderGraphCompiler>();
+                register_boxed_type<RenderPassContext>();
+                impl_interface_for_type<RenderPassContext, IRenderPassContext>();
                 g_render_pass_types_mtx = new_mutex();
+                g_transient_memory_counter = register_perf_counter("RG.TransientMemory", PerfCounterType::gauge, "bytes");
                 return ok;
             }
             virtual void on_close() override
@@ -36,6 +42,7 @@ namespace Luna
                 g_render_pass_types.clear();
                 g_render_pass_types.shrink_to_fit();
                 g_render_pass_types_mtx.reset();
+                g_transient_memory_counter = 0;
             }
         };
     }
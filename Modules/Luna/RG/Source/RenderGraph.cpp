@@ -11,6 +11,11 @@
 #define LUNA_RG_API LUNA_EXPORT
 #include "RenderGraph.hpp"
 #include "RenderPass.hpp"
+#include <Luna/Runtime/InlineVector.hpp>
+#include <Luna/Runtime/Profiler.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
 
 namespace Luna
 {
@@ -33,10 +38,13 @@ namespace Luna
             usize first_access = USIZE_MAX;
             // The index of the node that last accesses the resource.
             usize last_access = 0;
-            // All passes that writes to this resource.
-            Vector<usize> write_passes;
+            // All passes that writes to this resource. Most resources are written by only a few passes.
+            InlineVector<usize, 4> write_passes;
         };
-
+    }
+    template <> struct is_trivially_relocatable<RG::ResourceTrackData> : false_type {};
+    namespace RG
+    {
         inline bool is_resource_desc_valid(const ResourceDesc& desc)
         {
             // The resource size cannot be 0, which means unintialized.
@@ -59,10 +67,158 @@ namespace Luna
             return true;
         }
 
+        inline u64 estimate_resource_size(const ResourceDesc& desc)
+        {
+            if (desc.type == ResourceType::buffer) return desc.buffer.size;
+            auto& tex = desc.texture;
+            u64 size = (u64)tex.width * max<u32>(tex.height, 1) * max<u32>(tex.depth, 1) * max<u32>(tex.array_size, 1) *
+                max<u32>(tex.sample_count, 1) * RHI::bits_per_pixel(tex.format) / 8;
+            // The full mip chain takes about one third of the size of the first mip.
+            if (tex.mip_levels != 1) size += size / 3;
+            return size;
+        }
+
+        static bool is_resource_map_equal(const HashMap<Name, usize>& lhs, const HashMap<Name, usize>& rhs)
+        {
+            if (lhs.size() != rhs.size()) return false;
+            for (auto& i : lhs)
+            {
+                auto iter = rhs.find(i.first);
+                if (iter == rhs.end() || iter->second != i.second) return false;
+            }
+            return true;
+        }
+
+        // Checks whether the render pass object compiled in the last compilation can be reused by the current compilation.
+        static bool is_pass_reusable(const RenderGraph::PassData& old_pass, const RenderGraph::PassData& pass)
+        {
+            if (old_pass.m_dirty || !old_pass.m_render_pass || old_pass.m_type != pass.m_type) return false;
+            if (!is_resource_map_equal(old_pass.m_input_resources, pass.m_input_resources) ||
+                !is_resource_map_equal(old_pass.m_output_resources, pass.m_output_resources)) return false;
+            if (old_pass.m_descs_before_compile.size() != pass.m_descs_before_compile.size()) return false;
+            for (auto& desc : pass.m_descs_before_compile)
+            {
+                bool found = false;
+                for (auto& old_desc : old_pass.m_descs_before_compile)
+                {
+                    if (old_desc.first == desc.first)
+                    {
+                        if (!is_resource_desc_equal(old_desc.second, desc.second)) return false;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) return false;
+            }
+            return true;
+        }
+
+        static Variant encode_resource_desc(const ResourceDesc& desc)
+        {
+            Variant ret(VariantType::object);
+            ret["type"] = (u64)desc.type;
+            ret["memory_type"] = (u64)desc.memory_type;
+            if (desc.type == ResourceType::buffer)
+            {
+                ret["size"] = desc.buffer.size;
+                ret["usages"] = (u64)desc.buffer.usages;
+                ret["flags"] = (u64)desc.buffer.flags;
+            }
+            else
+            {
+                auto& t = desc.texture;
+                ret["texture_type"] = (u64)t.type;
+                ret["format"] = (u64)t.format;
+                ret["width"] = (u64)t.width;
+                ret["height"] = (u64)t.height;
+                ret["depth"] = (u64)t.depth;
+                ret["array_size"] = (u64)t.array_size;
+                ret["mip_levels"] = (u64)t.mip_levels;
+                ret["sample_count"] = (u64)t.sample_count;
+                ret["usages"] = (u64)t.usages;
+                ret["flags"] = (u64)t.flags;
+            }
+            return ret;
+        }
+
+        static ResourceDesc decode_resource_desc(const Variant& data)
+        {
+            ResourceDesc ret;
+            memzero(&ret);
+            ret.type = (ResourceType)data["type"].unum();
+            ret.memory_type = (RHI::MemoryType)data["memory_type"].unum();
+            if (ret.type == ResourceType::buffer)
+            {
+                ret.buffer.size = data["size"].unum();
+                ret.buffer.usages = (RHI::BufferUsageFlag)data["usages"].unum();
+                ret.buffer.flags = (RHI::ResourceFlag)data["flags"].unum();
+            }
+            else
+            {
+                auto& t = ret.texture;
+                t.type = (RHI::TextureType)data["texture_type"].unum();
+                t.format = (RHI::Format)data["format"].unum();
+                t.width = (u32)data["width"].unum();
+                t.height = (u32)data["height"].unum();
+                t.depth = (u32)data["depth"].unum();
+                t.array_size = (u32)data["array_size"].unum();
+                t.mip_levels = (u32)data["mip_levels"].unum();
+                t.sample_count = (u32)data["sample_count"].unum();
+                t.usages = (RHI::TextureUsageFlag)data["usages"].unum();
+                t.flags = (RHI::ResourceFlag)data["flags"].unum();
+            }
+            return ret;
+        }
+
+        // Computes the hash of everything that affects analysis results of the compilation.
+        static u64 hash_compile_desc(const RenderGraphDesc& desc, const RenderGraphCompileConfig& config)
+        {
+            u64 h = 0;
+            auto hash_name = [&](const Name& name) { h = strhash64(name ? name.c_str() : "", h); };
+            auto hash_value = [&](const auto& value) { h = memhash64(&value, sizeof(value), h); };
+            hash_value((u64)desc.passes.size());
+            for (auto& pass : desc.passes)
+            {
+                hash_name(pass.name);
+                hash_name(pass.type);
+                hash_value(pass.flags);
+            }
+            hash_value((u64)desc.resources.size());
+            for (auto& res : desc.resources)
+            {
+                hash_value(res.type);
+                hash_value(res.flags);
+                hash_name(res.name);
+                hash_value((u64)hash_resource_desc(res.desc));
+            }
+            hash_value((u64)desc.input_connections.size());
+            for (auto& c : desc.input_connections)
+            {
+                hash_value((u64)c.pass);
+                hash_name(c.parameter);
+                hash_value((u64)c.resource);
+            }
+            hash_value((u64)desc.output_connections.size());
+            for (auto& c : desc.output_connections)
+            {
+                hash_value((u64)c.pass);
+                hash_name(c.parameter);
+                hash_value((u64)c.resource);
+            }
+            // Resources accessed by async passes are placed differently.
+            hash_value(config.async_compute_queue != U32_MAX);
+            hash_value(config.async_copy_queue != U32_MAX);
+            return h;
+        }
+
         RV RenderGraph::compile(const RenderGraphCompileConfig& config)
         {
             lutry
             {
+                // Data of the last compilation is kept, so that render pass objects and resources that are not affected by changes 
+                // can be reused.
+                Vector<PassData> old_pass_data = move(m_pass_data);
+                Vector<ResourceData> old_resource_data = move(m_resource_data);
                 m_resource_data.clear();
                 m_resource_data.resize(m_desc.resources.size());
                 m_pass_data.clear();
@@ -80,56 +236,90 @@ namespace Luna
                     auto& res = resource_track_data[i.resource];
                     res.write_passes.push_back(i.pass);
                 }
-                // Cull out unrequired passes.
-                // Scan the resource to find output resources, all passes that writes to output resources should be enabled.
-                for(usize i = 0; i < m_desc.resources.size(); ++i)
+                // Use the compile cache if it is produced from the same descriptor and configuration.
+                m_compile_hash = hash_compile_desc(m_desc, config);
+                const Variant* cache = nullptr;
+                if (m_compile_cache.type() == VariantType::object && m_compile_cache["hash"].unum() == m_compile_hash &&
+                    m_compile_cache["passes"].size() == m_desc.passes.size() && m_compile_cache["resources"].size() == m_desc.resources.size())
+                {
+                    cache = &m_compile_cache;
+                }
+                if (cache)
                 {
-                    if(test_flags(m_desc.resources[i].flags, RenderGraphResourceFlag::output))
+                    // Read culling and lifetime results from the cache.
+                    auto& passes = (*cache)["passes"];
+                    for (usize i = 0; i < m_pass_data.size(); ++i)
                     {
-                        for(usize pass : resource_track_data[i].write_passes)
-                        {
-                            m_pass_data[pass].m_enabled = true;
-                        }
+                        m_pass_data[i].m_enabled = passes[i].boolean();
+                    }
+                    auto& resources = (*cache)["resources"];
+                    for (usize i = 0; i < resource_track_data.size(); ++i)
+                    {
+                        resource_track_data[i].first_access = (usize)resources[i]["first_access"].unum(USIZE_MAX);
+                        resource_track_data[i].last_access = (usize)resources[i]["last_access"].unum();
                     }
                 }
-                // Scan the pass queue in reverse order, all passes that write to input resources of enabled passes should also be enabled.
-                for(usize i = 0; i < m_desc.passes.size(); ++i)
+                else
                 {
-                    auto& pass = m_pass_data[m_desc.passes.size() - i - 1];
-                    if(pass.m_enabled)
+                    // Cull out unrequired passes.
+                    // Scan the resource to find output resources, all passes that writes to output resources should be enabled.
+                    for(usize i = 0; i < m_desc.resources.size(); ++i)
                     {
-                        for(auto r : pass.m_input_resources)
+                        if(test_flags(m_desc.resources[i].flags, RenderGraphResourceFlag::output))
                         {
-                            for(usize prior_pass : resource_track_data[r.second].write_passes)
+                            for(usize pass : resource_track_data[i].write_passes)
                             {
-                                m_pass_data[prior_pass].m_enabled = true;
+                                m_pass_data[pass].m_enabled = true;
                             }
                         }
                     }
-                }
-                // Determine transient resource lifetime.
-                for (auto& i : m_desc.input_connections)
-                {
-                    if (m_pass_data[i.pass].m_enabled)
+                    // Scan the pass queue in reverse order, all passes that write to input resources of enabled passes should also be enabled.
+                    for(usize i = 0; i < m_desc.passes.size(); ++i)
                     {
-                        auto& res = resource_track_data[i.resource];
-                        res.first_access = min(res.first_access, i.pass);
-                        res.last_access = max(res.last_access, i.pass);
-                    }   
-                }
-                for (auto& i : m_desc.output_connections)
-                {
-                    if (m_pass_data[i.pass].m_enabled)
+                        auto& pass = m_pass_data[m_desc.passes.size() - i - 1];
+                        if(pass.m_enabled)
+                        {
+                            for(auto r : pass.m_input_resources)
+                            {
+                                for(usize prior_pass : resource_track_data[r.second].write_passes)
+                                {
+                                    m_pass_data[prior_pass].m_enabled = true;
+                                }
+                            }
+                        }
+                    }
+                    // Determine transient resource lifetime.
+                    for (auto& i : m_desc.input_connections)
                     {
-                        auto& res = resource_track_data[i.resource];
-                        res.first_access = min(res.first_access, i.pass);
-                        res.last_access = max(res.last_access, i.pass);
+                        if (m_pass_data[i.pass].m_enabled)
+                        {
+                            auto& res = resource_track_data[i.resource];
+                            res.first_access = min(res.first_access, i.pass);
+                            res.last_access = max(res.last_access, i.pass);
+                        }   
+                    }
+                    for (auto& i : m_desc.output_connections)
+                    {
+                        if (m_pass_data[i.pass].m_enabled)
+                        {
+                            auto& res = resource_track_data[i.resource];
+                            res.first_access = min(res.first_access, i.pass);
+                            res.last_access = max(res.last_access, i.pass);
+                        }
                     }
                 }
                 // Apply user-defined descs.
                 for(usize i = 0; i < m_desc.resources.size(); ++i)
                 {
-                    m_resource_data[i].m_resource_desc = m_desc.resources[i].desc;
+                    auto& res = m_resource_data[i];
+                    res.m_resource_desc = m_desc.resources[i].desc;
+                    res.m_type = m_desc.resources[i].type;
+                    // External resources set before compiling are kept.
+                    if(res.m_type == RenderGraphResourceType::external && i < old_resource_data.size() && 
+                        old_resource_data[i].m_type == RenderGraphResourceType::external)
+                    {
+                        res.m_resource = old_resource_data[i].m_resource;
+                    }
                 }
                 // Compile every node in execution order.
                 u32 num_enabled_passes = 0;
@@ -138,6 +328,7 @@ namespace Luna
                     m_current_compile_pass = i;
                     if(m_pass_data[i].m_enabled)
                     {
+                        m_pass_data[i].m_time_query_index = num_enabled_passes;
                         ++num_enabled_passes;
                         MutexGuard guard(g_render_pass_types_mtx);
                         auto iter = g_render_pass_types.find(m_desc.passes[i].type);
@@ -145,7 +336,65 @@ namespace Luna
                         {
                             return set_error(BasicError::not_found(), "Render pass type \"%s\" is not found.", m_desc.passes[i].type.c_str());
                         }
-                        luexp(iter->compile(iter->userdata.get(), this));
+                        auto& pass = m_pass_data[i];
+                        pass.m_type = m_desc.passes[i].type;
+                        auto record_descs = [&](Vector<Pair<usize, ResourceDesc>>& descs)
+                        {
+                            descs.clear();
+                            for (auto& r : pass.m_input_resources) descs.push_back(make_pair(r.second, m_resource_data[r.second].m_resource_desc));
+                            for (auto& r : pass.m_output_resources) descs.push_back(make_pair(r.second, m_resource_data[r.second].m_resource_desc));
+                        };
+                        record_descs(pass.m_descs_before_compile);
+                        if (i < old_pass_data.size() && is_pass_reusable(old_pass_data[i], pass))
+                        {
+                            // Reuses the render pass object of the last compilation.
+                            auto& old_pass = old_pass_data[i];
+                            pass.m_render_pass = old_pass.m_render_pass;
+                            pass.m_descs_after_compile = move(old_pass.m_descs_after_compile);
+                            for (auto& desc : pass.m_descs_after_compile)
+                            {
+                                m_resource_data[desc.first].m_resource_desc = desc.second;
+                            }
+                        }
+                        else
+                        {
+                            luexp(iter->compile(iter->userdata.get(), this));
+                            record_descs(pass.m_descs_after_compile);
+                        }
+                        // Collect resource states declared by parameters.
+                        auto add_resource_state = [&](const RenderPassTypeParameter& param, const HashMap<Name, usize>& resources)
+                        {
+                            if (param.texture_state == RHI::TextureStateFlag::automatic && param.buffer_state == RHI::BufferStateFlag::automatic) return;
+                            auto res = resources.find(param.name);
+                            if (res == resources.end()) return;
+                            for (auto& state : pass.m_resource_states)
+                            {
+                                if (state.m_resource == res->second)
+                                {
+                                    // One resource is bound to multiple parameters, combine states.
+                                    if (param.texture_state != RHI::TextureStateFlag::automatic)
+                                    {
+                                        state.m_texture_state = state.m_texture_state == RHI::TextureStateFlag::automatic ? 
+                                            param.texture_state : state.m_texture_state | param.texture_state;
+                                    }
+                                    if (param.buffer_state != RHI::BufferStateFlag::automatic)
+                                    {
+                                        state.m_buffer_state = state.m_buffer_state == RHI::BufferStateFlag::automatic ? 
+                                            param.buffer_state : state.m_buffer_state | param.buffer_state;
+                                    }
+                                    state.m_discard_content = state.m_discard_content && param.discard_content;
+                                    return;
+                                }
+                            }
+                            PassResourceState state;
+                            state.m_resource = res->second;
+                            state.m_texture_state = param.texture_state;
+                            state.m_buffer_state = param.buffer_state;
+                            state.m_discard_content = param.discard_content;
+                            pass.m_resource_states.push_back(state);
+                        };
+                        for (auto& param : iter->input_parameters) add_resource_state(param, pass.m_input_resources);
+                        for (auto& param : iter->output_parameters) add_resource_state(param, pass.m_output_resources);
                     }
                 }
                 // Resolve transient resource lifetime.
@@ -155,7 +404,6 @@ namespace Luna
                     if(m_desc.resources[i].type == RenderGraphResourceType::transient && res.first_access != USIZE_MAX)
                     {
                         m_pass_data[resource_track_data[i].first_access].m_create_resources.push_back(i);
-                        m_pass_data[resource_track_data[i].last_access].m_release_resources.push_back(i);
                     }
                 }
                 // Create persistent resources.
@@ -166,6 +414,13 @@ namespace Luna
                         auto& res = m_resource_data[i];
                         if(is_resource_desc_valid(res.m_resource_desc))
                         {
+                            // Reuses the resource of the last compilation if the descriptor is not changed.
+                            if (i < old_resource_data.size() && old_resource_data[i].m_type == RenderGraphResourceType::persistent && 
+                                old_resource_data[i].m_resource && is_resource_desc_equal(old_resource_data[i].m_resource_desc, res.m_resource_desc))
+                            {
+                                res.m_resource = old_resource_data[i].m_resource;
+                                continue;
+                            }
                             if (res.m_resource_desc.type == ResourceType::buffer)
                             {
                                 luset(res.m_resource, m_device->new_buffer(res.m_resource_desc.memory_type, res.m_resource_desc.buffer));
@@ -195,6 +450,375 @@ namespace Luna
                     }
                 }
                 m_num_enabled_passes = num_enabled_passes;
+                // Split passes into segments if async queues or parallel recording is enabled.
+                m_queues[ASYNC_COMPUTE_QUEUE] = config.async_compute_queue;
+                m_queues[ASYNC_COPY_QUEUE] = config.async_copy_queue;
+                m_parallel_recording = config.enable_parallel_recording;
+                m_temporary_resource_lifetime = config.temporary_resource_lifetime;
+                m_segments.clear();
+                bool has_async_pass = false;
+                for(usize i = 0; i < m_pass_data.size(); ++i)
+                {
+                    auto& pass = m_pass_data[i];
+                    pass.m_queue = GRAPHICS_QUEUE;
+                    if(!pass.m_enabled) continue;
+                    auto flags = m_desc.passes[i].flags;
+                    if(test_flags(flags, RenderGraphPassFlag::async_copy) && m_queues[ASYNC_COPY_QUEUE] != U32_MAX)
+                    {
+                        pass.m_queue = ASYNC_COPY_QUEUE;
+                    }
+                    // Copy passes can also be executed on the async compute queue if the async copy queue is not available.
+                    else if(test_flags(flags, RenderGraphPassFlag::async_compute | RenderGraphPassFlag::async_copy) && m_queues[ASYNC_COMPUTE_QUEUE] != U32_MAX)
+                    {
+                        pass.m_queue = ASYNC_COMPUTE_QUEUE;
+                    }
+                    has_async_pass |= pass.m_queue != GRAPHICS_QUEUE;
+                }
+                if(has_async_pass)
+                {
+                    // The last enabled pass that accesses every resource.
+                    Vector<usize> last_access_pass(m_desc.resources.size(), USIZE_MAX);
+                    // `synced[a][b]` is the last segment on queue `b` that is known to be finished by queue `a`, either by waiting
+                    // the segment directly, or by waiting one segment that has waited the segment.
+                    usize synced[NUM_QUEUES][NUM_QUEUES];
+                    for(auto& i : synced) for(auto& j : i) j = USIZE_MAX;
+                    // `synced` of every segment when the segment is finished.
+                    Vector<usize> segment_synced;
+                    // The last segment on every queue.
+                    usize last_segment[NUM_QUEUES] = { USIZE_MAX, USIZE_MAX, USIZE_MAX };
+                    auto is_synced = [](usize synced_segment, usize segment)
+                    {
+                        return synced_segment != USIZE_MAX && synced_segment >= segment;
+                    };
+                    auto wait_segment = [&](SegmentData& segment, usize waited)
+                    {
+                        u8 queue = segment.m_queue;
+                        u8 waited_queue = m_segments[waited].m_queue;
+                        segment.m_wait_segments[waited_queue] = waited;
+                        synced[queue][waited_queue] = waited;
+                        // Segments waited by the waited segment are also finished.
+                        for(usize q = 0; q < NUM_QUEUES; ++q)
+                        {
+                            usize s = segment_synced[waited * NUM_QUEUES + q];
+                            if(q != queue && s != USIZE_MAX && !is_synced(synced[queue][q], s)) synced[queue][q] = s;
+                        }
+                    };
+                    for(usize i = 0; i < m_pass_data.size(); ++i)
+                    {
+                        auto& pass = m_pass_data[i];
+                        if(!pass.m_enabled) continue;
+                        u8 queue = pass.m_queue;
+                        if(m_segments.empty() || m_segments.back().m_queue != queue)
+                        {
+                            SegmentData segment;
+                            segment.m_first_pass = i;
+                            segment.m_queue = queue;
+                            m_segments.push_back(segment);
+                            segment_synced.resize(m_segments.size() * NUM_QUEUES, USIZE_MAX);
+                        }
+                        auto& segment = m_segments.back();
+                        segment.m_end_pass = i + 1;
+                        pass.m_segment = m_segments.size() - 1;
+                        last_segment[queue] = pass.m_segment;
+                        // Find the last segment on every other queue that accesses resources of this pass.
+                        usize dependencies[NUM_QUEUES] = { USIZE_MAX, USIZE_MAX, USIZE_MAX };
+                        auto track_access = [&](usize resource)
+                        {
+                            usize prior_pass = last_access_pass[resource];
+                            if(prior_pass != USIZE_MAX && m_pass_data[prior_pass].m_queue != queue)
+                            {
+                                usize prior_segment = m_pass_data[prior_pass].m_segment;
+                                usize& dependency = dependencies[m_pass_data[prior_pass].m_queue];
+                                dependency = dependency == USIZE_MAX ? prior_segment : max(dependency, prior_segment);
+                            }
+                            last_access_pass[resource] = i;
+                        };
+                        for(auto& r : pass.m_input_resources) track_access(r.second);
+                        for(auto& r : pass.m_output_resources) track_access(r.second);
+                        // Segments that are already known to be finished need not be waited again.
+                        for(usize q = 0; q < NUM_QUEUES; ++q)
+                        {
+                            if(dependencies[q] != USIZE_MAX && !is_synced(synced[queue][q], dependencies[q]))
+                            {
+                                wait_segment(segment, dependencies[q]);
+                            }
+                        }
+                        for(usize q = 0; q < NUM_QUEUES; ++q)
+                        {
+                            segment_synced[pass.m_segment * NUM_QUEUES + q] = synced[queue][q];
+                        }
+                    }
+                    // The last graphics segment waits for all async segments, so that commands recorded after the render graph
+                    // can access all resources.
+                    for(usize q = 0; q < NUM_QUEUES; ++q)
+                    {
+                        if(q == GRAPHICS_QUEUE || last_segment[q] == USIZE_MAX || is_synced(synced[GRAPHICS_QUEUE][q], last_segment[q])) continue;
+                        if(m_segments.back().m_queue != GRAPHICS_QUEUE)
+                        {
+                            SegmentData segment;
+                            segment.m_first_pass = m_pass_data.size();
+                            segment.m_end_pass = m_pass_data.size();
+                            segment.m_queue = GRAPHICS_QUEUE;
+                            m_segments.push_back(segment);
+                            segment_synced.resize(m_segments.size() * NUM_QUEUES, USIZE_MAX);
+                        }
+                        wait_segment(m_segments.back(), last_segment[q]);
+                    }
+                    // Every wait has one fence signaled by the waited segment.
+                    usize num_fences = 0;
+                    for(auto& segment : m_segments)
+                    {
+                        for(usize q = 0; q < NUM_QUEUES; ++q)
+                        {
+                            usize waited = segment.m_wait_segments[q];
+                            if(waited == USIZE_MAX) continue;
+                            segment.m_wait_fences[q] = num_fences;
+                            m_segments[waited].m_signal_fences[segment.m_queue] = num_fences;
+                            ++num_fences;
+                        }
+                    }
+                    while(m_fences.size() < num_fences)
+                    {
+                        lulet(fence, m_device->new_fence());
+                        m_fences.push_back(fence);
+                    }
+                }
+                else if(m_parallel_recording && num_enabled_passes)
+                {
+                    // All passes are recorded into command buffers managed by the render graph.
+                    SegmentData segment;
+                    segment.m_first_pass = 0;
+                    segment.m_end_pass = m_pass_data.size();
+                    segment.m_queue = GRAPHICS_QUEUE;
+                    m_segments.push_back(segment);
+                    for(auto& pass : m_pass_data)
+                    {
+                        if(pass.m_enabled) pass.m_segment = 0;
+                    }
+                }
+                // Assign passes of every segment to contexts. If parallel recording is enabled, passes of one segment are split into 
+                // groups of continuous passes that are recorded concurrently into different command buffers. Command buffers of one 
+                // segment are submitted in pass order, so the execution order of passes is not changed. Groups use primary command 
+                // buffers, since secondary command buffers cannot record barriers or begin passes, which every render pass may do.
+                for(auto& n : m_num_contexts) n = 0;
+                usize max_contexts_per_segment = m_parallel_recording ? (usize)get_processors_count() : 1;
+                for(auto& segment : m_segments)
+                {
+                    usize num_segment_passes = 0;
+                    for(usize i = segment.m_first_pass; i < segment.m_end_pass; ++i)
+                    {
+                        if(m_pass_data[i].m_enabled) ++num_segment_passes;
+                    }
+                    segment.m_first_context = m_num_contexts[segment.m_queue];
+                    segment.m_num_contexts = max<usize>(min(num_segment_passes, max_contexts_per_segment), 1);
+                    usize index = 0;
+                    for(usize i = segment.m_first_pass; i < segment.m_end_pass; ++i)
+                    {
+                        if(!m_pass_data[i].m_enabled) continue;
+                        m_pass_data[i].m_context = segment.m_first_context + index * segment.m_num_contexts / num_segment_passes;
+                        ++index;
+                    }
+                    m_num_contexts[segment.m_queue] += segment.m_num_contexts;
+                }
+                // Place transient resources. This is performed after segments are determined, since resources accessed by
+                // async passes are placed differently.
+                Vector<Pair<usize, usize>> lifetimes;
+                lifetimes.reserve(resource_track_data.size());
+                for(usize i = 0; i < resource_track_data.size(); ++i)
+                {
+                    auto& res = resource_track_data[i];
+                    lifetimes.push_back(make_pair(res.first_access, res.last_access));
+                    m_resource_data[i].m_first_access = res.first_access;
+                    m_resource_data[i].m_last_access = res.last_access;
+                }
+                luexp(place_transient_resources({lifetimes.data(), lifetimes.size()}, cache));
+            }
+            lucatchret;
+            return ok;
+        }
+        RV RenderGraph::place_transient_resources(Span<const Pair<usize, usize>> lifetimes, const Variant* cache)
+        {
+            lutry
+            {
+                // Resources accessed by async passes may be accessed at the same time as resources accessed by 
+                // passes on other queues, so they are placed in exclusive heaps.
+                Vector<bool> async_access(m_desc.resources.size(), false);
+                for (auto& i : m_desc.input_connections)
+                {
+                    if (m_pass_data[i.pass].m_queue != GRAPHICS_QUEUE) async_access[i.resource] = true;
+                }
+                for (auto& i : m_desc.output_connections)
+                {
+                    if (m_pass_data[i.pass].m_queue != GRAPHICS_QUEUE) async_access[i.resource] = true;
+                }
+                Vector<usize> resources;
+                for (usize i = 0; i < m_desc.resources.size(); ++i)
+                {
+                    if (m_desc.resources[i].type != RenderGraphResourceType::transient || lifetimes[i].first == USIZE_MAX) continue;
+                    auto& desc = m_resource_data[i].m_resource_desc;
+                    if (!is_resource_desc_valid(desc))
+                    {
+                        return set_error(BasicError::bad_data(), "Cannot create transient resource %s because the resource layout is not specified.", m_desc.resources[i].name.c_str());
+                    }
+                    if (desc.type == ResourceType::texture) desc.texture.flags |= RHI::ResourceFlag::allow_aliasing;
+                    else desc.buffer.flags |= RHI::ResourceFlag::allow_aliasing;
+                    resources.push_back(i);
+                }
+                // Assigns resources to heaps in the order of first access, so that every resource can reuse 
+                // heaps whose resources are no longer accessed (interval partitioning).
+                sort(resources.begin(), resources.end(), [&](usize lhs, usize rhs) { return lifetimes[lhs].first < lifetimes[rhs].first; });
+                struct HeapPlacement
+                {
+                    RHI::MemoryType memory_type;
+                    Vector<usize> resources;
+                    // The last pass that accesses resources in this heap.
+                    usize last_access;
+                    // The estimated size of the largest resource in this heap.
+                    u64 estimated_size;
+                    bool exclusive;
+                };
+                Vector<HeapPlacement> heaps;
+                Vector<RHI::BufferDesc> buffers;
+                Vector<RHI::TextureDesc> textures;
+                auto collect_descs = [&](const Vector<usize>& heap_resources)
+                {
+                    buffers.clear();
+                    textures.clear();
+                    for (usize i : heap_resources)
+                    {
+                        auto& desc = m_resource_data[i].m_resource_desc;
+                        if (desc.type == ResourceType::texture) textures.push_back(desc.texture);
+                        else buffers.push_back(desc.buffer);
+                    }
+                };
+                if (cache)
+                {
+                    // Use the cached layout if resolved descriptors of all transient resources are not changed.
+                    auto& cached_resources = (*cache)["resources"];
+                    for (usize res : resources)
+                    {
+                        auto& cached = cached_resources[res];
+                        auto& desc = m_resource_data[res].m_resource_desc;
+                        usize heap_index = (usize)cached["heap"].unum(USIZE_MAX);
+                        if (heap_index >= resources.size() || !is_resource_desc_equal(decode_resource_desc(cached["desc"]), desc))
+                        {
+                            cache = nullptr;
+                            break;
+                        }
+                        if (heap_index >= heaps.size())
+                        {
+                            usize first_new_heap = heaps.size();
+                            heaps.resize(heap_index + 1);
+                            for (usize i = first_new_heap; i < heaps.size(); ++i) heaps[i].memory_type = desc.memory_type;
+                        }
+                        auto& heap = heaps[heap_index];
+                        if (!heap.resources.empty() && heap.memory_type != desc.memory_type)
+                        {
+                            cache = nullptr;
+                            break;
+                        }
+                        heap.memory_type = desc.memory_type;
+                        heap.resources.push_back(res);
+                    }
+                    if (!cache) heaps.clear();
+                }
+                for (usize res : resources)
+                {
+                    if (cache) break;
+                    auto& desc = m_resource_data[res].m_resource_desc;
+                    u64 size = estimate_resource_size(desc);
+                    usize best_heap = USIZE_MAX;
+                    u64 best_growth = U64_MAX;
+                    if (!async_access[res])
+                    {
+                        for (usize i = 0; i < heaps.size(); ++i)
+                        {
+                            auto& heap = heaps[i];
+                            if (heap.exclusive || heap.memory_type != desc.memory_type || heap.last_access >= lifetimes[res].first) continue;
+                            // Prefers the heap that grows least, then the smallest heap.
+                            u64 growth = size > heap.estimated_size ? size - heap.estimated_size : 0;
+                            if (best_heap != USIZE_MAX && (growth > best_growth ||
+                                (growth == best_growth && heap.estimated_size >= heaps[best_heap].estimated_size))) continue;
+                            collect_descs(heap.resources);
+                            if (desc.type == ResourceType::texture) textures.push_back(desc.texture);
+                            else buffers.push_back(desc.buffer);
+                            if (!m_device->is_resources_aliasing_compatible(desc.memory_type, 
+                                {buffers.data(), buffers.size()}, {textures.data(), textures.size()})) continue;
+                            best_heap = i;
+                            best_growth = growth;
+                        }
+                    }
+                    if (best_heap == USIZE_MAX)
+                    {
+                        HeapPlacement heap;
+                        heap.memory_type = desc.memory_type;
+                        heap.last_access = 0;
+                        heap.estimated_size = 0;
+                        heap.exclusive = async_access[res];
+                        heaps.push_back(move(heap));
+                        best_heap = heaps.size() - 1;
+                    }
+                    auto& heap = heaps[best_heap];
+                    heap.resources.push_back(res);
+                    heap.last_access = lifetimes[res].second;
+                    heap.estimated_size = max(heap.estimated_size, size);
+                }
+                // Creates heaps and resources.
+                auto create_resources = [&](RHI::IDeviceMemory* memory, const Vector<usize>& heap_resources) -> RV
+                {
+                    lutry
+                    {
+                        for (usize i : heap_resources)
+                        {
+                            auto& res = m_resource_data[i];
+                            res.m_heap = m_transient_heaps.size();
+                            if (res.m_resource_desc.type == ResourceType::texture)
+                            {
+                                luset(res.m_resource, m_device->new_aliasing_texture(memory, res.m_resource_desc.texture));
+                            }
+                            else
+                            {
+                                luset(res.m_resource, m_device->new_aliasing_buffer(memory, res.m_resource_desc.buffer));
+                            }
+                            if (m_desc.resources[i].name) res.m_resource->set_name(m_desc.resources[i].name.c_str());
+                        }
+                    }
+                    lucatchret;
+                    return ok;
+                };
+                Vector<Ref<RHI::IDeviceMemory>> old_heaps = move(m_transient_heaps);
+                m_transient_heaps.clear();
+                for (auto& heap : heaps)
+                {
+                    if (heap.resources.empty()) continue;
+                    Ref<RHI::IDeviceMemory> memory;
+                    // Reuses heaps created by the last compilation if possible, so that recompiling the render graph 
+                    // with similar resources does not allocate memory again.
+                    for (auto iter = old_heaps.begin(); iter != old_heaps.end(); ++iter)
+                    {
+                        if ((*iter)->get_memory_type() == heap.memory_type && succeeded(create_resources(*iter, heap.resources)))
+                        {
+                            memory = *iter;
+                            old_heaps.erase(iter);
+                            break;
+                        }
+                    }
+                    if (!memory)
+                    {
+                        collect_descs(heap.resources);
+                        auto r = m_device->allocate_memory(heap.memory_type, {buffers.data(), buffers.size()}, {textures.data(), textures.size()});
+                        RV created = failed(r) ? RV(r.errcode()) : create_resources(r.get(), heap.resources);
+                        // The cached layout may be incompatible with the current device, place resources again without the cache.
+                        if (failed(created) && cache) return place_transient_resources(lifetimes, nullptr);
+                        luexp(created);
+                        memory = r.get();
+                    }
+                    m_transient_heaps.push_back(move(memory));
+                }
+                u64 transient_memory_size = 0;
+                for (auto& heap : m_transient_heaps) transient_memory_size += heap->get_size();
+                perf_counter_add(g_transient_memory_counter, (i64)transient_memory_size - (i64)m_transient_memory_size);
+                m_transient_memory_size = transient_memory_size;
             }
             lucatchret;
             return ok;
@@ -210,61 +834,232 @@ namespace Luna
                 }
             }
         }
-        RV RenderGraph::execute(RHI::ICommandBuffer* cmdbuf)
+        RV RenderGraph::execute_pass(RenderPassContext* ctx, usize pass)
         {
             lutry
             {
-                m_transient_memory.clear();
-                m_cmdbuf = cmdbuf;
-                m_current_time_query_index = 0;
-                for(usize i = 0; i < m_pass_data.size(); ++i)
+                auto& data = m_pass_data[pass];
+                ctx->m_current_pass = pass;
+                // Issues aliasing barriers for transient resources that are first accessed by this pass.
+                Vector<RHI::BufferBarrier> buffer_barriers;
+                Vector<RHI::TextureBarrier> texture_barriers;
+                auto find_resource_state = [&](usize resource) -> const PassResourceState*
                 {
-                    auto& data = m_pass_data[i];
-                    if(!data.m_enabled) continue;
-                    // Allocates resources.
-                    Vector<RHI::BufferBarrier> buffer_barriers;
-                    Vector<RHI::TextureBarrier> texture_barriers;
-                    for(usize h : data.m_create_resources)
+                    for (auto& state : data.m_resource_states)
                     {
-                        auto& res = m_resource_data[h];
-                        if(is_resource_desc_valid(res.m_resource_desc))
+                        if (state.m_resource == resource) return &state;
+                    }
+                    return nullptr;
+                };
+                for(usize h : data.m_create_resources)
+                {
+                    // Transient resources are created when the render graph is compiled. Attach them to the command buffer 
+                    // so that they are kept alive until the GPU finishes using them even if the render graph is recompiled.
+                    auto& res = m_resource_data[h];
+                    ctx->m_cmdbuf->attach_device_object(res.m_resource);
+                    // Transitions the resource to the declared state along with the aliasing barrier.
+                    auto state = find_resource_state(h);
+                    if (res.m_resource_desc.type == ResourceType::texture)
+                    {
+                        Ref<RHI::ITexture> tex = res.m_resource;
+                        auto after = state && state->m_texture_state != RHI::TextureStateFlag::automatic ? state->m_texture_state : RHI::TextureStateFlag::none;
+                        texture_barriers.push_back({ tex, RHI::TEXTURE_BARRIER_ALL_SUBRESOURCES, RHI::TextureStateFlag::automatic, after, RHI::ResourceBarrierFlag::aliasing });
+                    }
+                    else
+                    {
+                        Ref<RHI::IBuffer> buf = res.m_resource;
+                        auto after = state && state->m_buffer_state != RHI::BufferStateFlag::automatic ? state->m_buffer_state : RHI::BufferStateFlag::none;
+                        buffer_barriers.push_back({ buf, RHI::BufferStateFlag::automatic, after, RHI::ResourceBarrierFlag::aliasing });
+                    }
+                }
+                // Transitions resources to states declared by the pass.
+                for (auto& state : data.m_resource_states)
+                {
+                    bool created = false;
+                    for (usize h : data.m_create_resources)
+                    {
+                        if (h == state.m_resource)
                         {
-                            luset(res.m_resource, allocate_transient_resource(res.m_resource_desc));
-                            cmdbuf->attach_device_object(res.m_resource);
-                            if(m_desc.resources[h].name) res.m_resource->set_name(m_desc.resources[h].name.c_str());
+                            created = true;
+                            break;
                         }
-                        else
+                    }
+                    if (created) continue;
+                    RHI::IResource* resource = m_resource_data[state.m_resource].m_resource;
+                    if (!resource) continue;
+                    auto flags = state.m_discard_content ? RHI::ResourceBarrierFlag::discard_content : RHI::ResourceBarrierFlag::none;
+                    Ref<RHI::ITexture> tex = resource;
+                    if (tex)
+                    {
+                        if (state.m_texture_state != RHI::TextureStateFlag::automatic)
                         {
-                            return set_error(BasicError::bad_data(), "Cannot create transient resource %s because the resource layout is not specified.", m_desc.resources[h].name.c_str());
+                            texture_barriers.push_back({ tex, RHI::TEXTURE_BARRIER_ALL_SUBRESOURCES, RHI::TextureStateFlag::automatic, state.m_texture_state, flags });
                         }
-                        if (res.m_resource_desc.type == ResourceType::texture)
+                    }
+                    else
+                    {
+                        Ref<RHI::IBuffer> buf = resource;
+                        if (buf && state.m_buffer_state != RHI::BufferStateFlag::automatic)
                         {
-                            Ref<RHI::ITexture> tex = res.m_resource;
-                            texture_barriers.push_back({ tex, RHI::TEXTURE_BARRIER_ALL_SUBRESOURCES, RHI::TextureStateFlag::automatic, RHI::TextureStateFlag::none, RHI::ResourceBarrierFlag::aliasing });
+                            buffer_barriers.push_back({ buf, RHI::BufferStateFlag::automatic, state.m_buffer_state, flags });
                         }
-                        else
+                    }
+                }
+                auto cmdbuf = ctx->m_cmdbuf.get();
+                u64 begin_time = get_ticks();
+                data.m_num_buffer_barriers = (u32)buffer_barriers.size();
+                data.m_num_texture_barriers = (u32)texture_barriers.size();
+                if (!buffer_barriers.empty() || !texture_barriers.empty()) cmdbuf->resource_barrier({ buffer_barriers.data(), buffer_barriers.size() }, {texture_barriers.data(), texture_barriers.size()});
+                if (m_desc.passes[pass].name) cmdbuf->begin_event(m_desc.passes[pass].name.c_str());
+                {
+                    LUNA_PROFILE_ZONE(m_desc.passes[pass].name ? m_desc.passes[pass].name.c_str() : "RenderPass");
+                    luexp(data.m_render_pass->execute(ctx));
+                }
+                if (m_desc.passes[pass].name) cmdbuf->end_event();
+                data.m_cpu_time = get_ticks() - begin_time;
+                for(auto& res : ctx->m_temporary_resources)
+                {
+                    ctx->release_transient_resource(res.m_desc, res.m_resource);
+                }
+                ctx->m_temporary_resources.clear();
+            }
+            lucatchret;
+            return ok;
+        }
+        RV RenderGraph::prepare_segments(u32 graphics_queue)
+        {
+            lutry
+            {
+                auto prepare_contexts = [&](Vector<Ref<RenderPassContext>>& contexts, usize num_contexts, u32 queue, const c8* name) -> RV
+                {
+                    lutry
+                    {
+                        if(contexts.size() < num_contexts) contexts.resize(num_contexts);
+                        for(usize i = 0; i < num_contexts; ++i)
                         {
-                            Ref<RHI::IBuffer> buf = res.m_resource;
-                            buffer_barriers.push_back({ buf, RHI::BufferStateFlag::automatic, RHI::BufferStateFlag::none, RHI::ResourceBarrierFlag::aliasing });
+                            auto& ctx = contexts[i];
+                            if(!ctx)
+                            {
+                                ctx = new_object<RenderPassContext>();
+                                ctx->m_graph = this;
+                            }
+                            if(ctx->m_cmdbuf && ctx->m_cmdbuf->get_command_queue_index() == queue)
+                            {
+                                // Wait for the last execution before reusing the command buffer.
+                                if(ctx->m_submitted) ctx->m_cmdbuf->wait();
+                                luexp(ctx->m_cmdbuf->reset());
+                            }
+                            else
+                            {
+                                if(ctx->m_cmdbuf && ctx->m_submitted) ctx->m_cmdbuf->wait();
+                                luset(ctx->m_cmdbuf, m_device->new_command_buffer(queue));
+                                ctx->m_cmdbuf->set_name(name);
+                            }
+                            ctx->m_submitted = false;
                         }
                     }
-                    if (!buffer_barriers.empty() || !texture_barriers.empty()) cmdbuf->resource_barrier({ buffer_barriers.data(), buffer_barriers.size() }, {texture_barriers.data(), texture_barriers.size()});
-                    m_current_pass = i;
-                    if (m_desc.passes[i].name) cmdbuf->begin_event(m_desc.passes[i].name.c_str());
-                    luexp(m_pass_data[i].m_render_pass->execute(this));
-                    if (m_desc.passes[i].name) cmdbuf->end_event();
-                    for(auto& res : m_temporary_resources)
+                    lucatchret;
+                    return ok;
+                };
+                m_queues[GRAPHICS_QUEUE] = graphics_queue;
+                const c8* names[NUM_QUEUES] = { "RenderGraph", "RenderGraph (Async Compute)", "RenderGraph (Async Copy)" };
+                for(usize q = 0; q < NUM_QUEUES; ++q)
+                {
+                    luexp(prepare_contexts(m_contexts[q], m_num_contexts[q], m_queues[q], names[q]));
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        RV RenderGraph::execute(RHI::ICommandBuffer* cmdbuf)
+        {
+            lutry
+            {
+                // Free temporary resources that are not reused in the last execution are released.
+                ++m_execution_index;
+                if(m_context) m_context->release_unused_resources();
+                for(auto& contexts : m_contexts)
+                {
+                    for(auto& ctx : contexts) if(ctx) ctx->release_unused_resources();
+                }
+                if(m_segments.empty())
+                {
+                    if(!m_context)
                     {
-                        release_transient_resource(res);
+                        m_context = new_object<RenderPassContext>();
+                        m_context->m_graph = this;
                     }
-                    m_temporary_resources.clear();
-                    // Release resources.
-                    for(usize h : data.m_release_resources)
+                    m_context->m_cmdbuf = cmdbuf;
+                    for(usize i = 0; i < m_pass_data.size(); ++i)
                     {
-                        auto& res = m_resource_data[h];
-                        release_transient_resource(res.m_resource);
+                        if(m_pass_data[i].m_enabled)
+                        {
+                            luexp(execute_pass(m_context, i));
+                        }
+                    }
+                    m_context->m_cmdbuf.reset();
+                }
+                else
+                {
+                    luexp(prepare_segments(cmdbuf->get_command_queue_index()));
+                    // Records passes of every context. Contexts of all queues are indexed in queue order.
+                    auto record_context = [&](usize index)
+                    {
+                        u8 queue = 0;
+                        while(index >= m_num_contexts[queue])
+                        {
+                            index -= m_num_contexts[queue];
+                            ++queue;
+                        }
+                        RenderPassContext* ctx = m_contexts[queue][index];
+                        ctx->m_result = ok;
+                        for(usize i = 0; i < m_pass_data.size(); ++i)
+                        {
+                            auto& pass = m_pass_data[i];
+                            if(pass.m_enabled && pass.m_queue == queue && pass.m_context == index)
+                            {
+                                ctx->m_result = execute_pass(ctx, i);
+                                if(failed(ctx->m_result)) break;
+                            }
+                        }
+                    };
+                    usize num_contexts = 0;
+                    for(usize n : m_num_contexts) num_contexts += n;
+                    if(m_parallel_recording)
+                    {
+                        JobSystem::parallel_for(0, num_contexts, 1, record_context);
+                    }
+                    else
+                    {
+                        for(usize i = 0; i < num_contexts; ++i) record_context(i);
+                    }
+                    for(usize q = 0; q < NUM_QUEUES; ++q)
+                    {
+                        for(usize i = 0; i < m_num_contexts[q]; ++i) luexp(m_contexts[q][i]->m_result);
+                    }
+                    // Submits command buffers in segment order. The first command buffer of one segment waits for fences, and 
+                    // the last command buffer of one segment signals fences.
+                    for(auto& segment : m_segments)
+                    {
+                        RHI::IFence* wait_fences[NUM_QUEUES];
+                        RHI::IFence* signal_fences[NUM_QUEUES];
+                        usize num_wait_fences = 0;
+                        usize num_signal_fences = 0;
+                        for(usize q = 0; q < NUM_QUEUES; ++q)
+                        {
+                            if(segment.m_wait_fences[q] != USIZE_MAX) wait_fences[num_wait_fences++] = m_fences[segment.m_wait_fences[q]];
+                            if(segment.m_signal_fences[q] != USIZE_MAX) signal_fences[num_signal_fences++] = m_fences[segment.m_signal_fences[q]];
+                        }
+                        auto& contexts = m_contexts[segment.m_queue];
+                        for(usize i = 0; i < segment.m_num_contexts; ++i)
+                        {
+                            auto& ctx = contexts[segment.m_first_context + i];
+                            Span<RHI::IFence*> waits = i == 0 ? Span<RHI::IFence*>(wait_fences, num_wait_fences) : Span<RHI::IFence*>();
+                            Span<RHI::IFence*> signals = i + 1 == segment.m_num_contexts ? Span<RHI::IFence*>(signal_fences, num_signal_fences) : Span<RHI::IFence*>();
+                            luexp(ctx->m_cmdbuf->submit(waits, signals, true));
+                            ctx->m_submitted = true;
+                        }
                     }
-                    ++m_current_time_query_index;
                 }
             }
             lucatchret;
@@ -288,25 +1083,278 @@ namespace Luna
             lucatchret;
             return ok;
         }
-        R<Ref<RHI::IResource>> RenderGraph::allocate_temporary_resource(const ResourceDesc& desc)
+        RV RenderGraph::get_pass_timestamps(Vector<u64>& pass_timestamps)
+        {
+            lutry
+            {
+                pass_timestamps.clear();
+                if (m_enable_time_profiling)
+                {
+                    pass_timestamps.resize((usize)m_num_enabled_passes * 2, 0);
+                    luexp(m_time_query_heap->get_timestamp_values(0, m_num_enabled_passes * 2, pass_timestamps.data()));
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        R<Variant> RenderGraph::get_compile_cache()
+        {
+            if (m_pass_data.size() != m_desc.passes.size() || m_resource_data.size() != m_desc.resources.size())
+            {
+                return set_error(BasicError::bad_calling_time(), "The render graph must be compiled before getting the compile cache.");
+            }
+            Variant ret(VariantType::object);
+            ret["hash"] = m_compile_hash;
+            Variant passes(VariantType::array);
+            for (auto& pass : m_pass_data)
+            {
+                passes.push_back(Variant(pass.m_enabled));
+            }
+            ret["passes"] = move(passes);
+            Variant resources(VariantType::array);
+            for (auto& data : m_resource_data)
+            {
+                Variant res(VariantType::object);
+                res["first_access"] = (u64)data.m_first_access;
+                res["last_access"] = (u64)data.m_last_access;
+                res["heap"] = (u64)data.m_heap;
+                res["desc"] = encode_resource_desc(data.m_resource_desc);
+                resources.push_back(move(res));
+            }
+            ret["resources"] = move(resources);
+            return ret;
+        }
+        RV RenderGraph::get_stats(RenderGraphStats& stats)
+        {
+            lutry
+            {
+                stats.passes.clear();
+                Vector<u64> times;
+                if (m_enable_time_profiling)
+                {
+                    luexp(get_pass_time_intervals(times));
+                }
+                for (usize i = 0; i < m_pass_data.size(); ++i)
+                {
+                    auto& data = m_pass_data[i];
+                    if (!data.m_enabled) continue;
+                    RenderGraphPassStats pass;
+                    pass.pass = i;
+                    pass.gpu_time = data.m_time_query_index < times.size() ? times[data.m_time_query_index] : 0;
+                    pass.cpu_time = data.m_cpu_time;
+                    pass.num_buffer_barriers = data.m_num_buffer_barriers;
+                    pass.num_texture_barriers = data.m_num_texture_barriers;
+                    stats.passes.push_back(pass);
+                }
+                stats.resources.clear();
+                stats.transient_memory_size_without_aliasing = 0;
+                for (auto& data : m_resource_data)
+                {
+                    RenderGraphResourceStats res;
+                    res.first_pass = data.m_first_access;
+                    res.last_pass = data.m_last_access;
+                    res.size = is_resource_desc_valid(data.m_resource_desc) ? estimate_resource_size(data.m_resource_desc) : 0;
+                    res.heap = data.m_heap;
+                    if (res.heap != USIZE_MAX) stats.transient_memory_size_without_aliasing += res.size;
+                    stats.resources.push_back(res);
+                }
+                stats.transient_heap_sizes.clear();
+                stats.transient_memory_size = 0;
+                for (auto& heap : m_transient_heaps)
+                {
+                    u64 size = heap->get_size();
+                    stats.transient_heap_sizes.push_back(size);
+                    stats.transient_memory_size += size;
+                }
+                // Sum sizes of transient resources alive at every pass.
+                stats.transient_memory_peak = 0;
+                for (usize i = 0; i < m_pass_data.size(); ++i)
+                {
+                    if (!m_pass_data[i].m_enabled) continue;
+                    u64 size = 0;
+                    for (auto& res : stats.resources)
+                    {
+                        if (res.heap != USIZE_MAX && res.first_pass <= i && res.last_pass >= i) size += res.size;
+                    }
+                    stats.transient_memory_peak = max(stats.transient_memory_peak, size);
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        R<Ref<RHI::IResource>> RenderPassContext::allocate_transient_resource(const ResourceDesc& desc)
+        {
+            // Try to reuse one resource with the same descriptor.
+            auto bucket = m_temporary_resource_pool.find(hash_resource_desc(desc));
+            if (bucket != m_temporary_resource_pool.end())
+            {
+                auto& resources = bucket->second;
+                for (auto iter = resources.begin(); iter != resources.end(); ++iter)
+                {
+                    if (is_resource_desc_equal(iter->m_desc, desc))
+                    {
+                        Ref<RHI::IResource> ret = iter->m_resource;
+                        resources.erase(iter);
+                        if (resources.empty()) m_temporary_resource_pool.erase(bucket);
+                        return ret;
+                    }
+                }
+            }
+            // Try to reuse the memory of one resource.
+            RHI::IDevice* device = m_graph->m_device;
+            Ref<RHI::IResource> ret;
+            for (bucket = m_temporary_resource_pool.begin(); bucket != m_temporary_resource_pool.end(); ++bucket)
+            {
+                auto& resources = bucket->second;
+                for (auto iter = resources.begin(); iter != resources.end(); ++iter)
+                {
+                    RHI::IDeviceMemory* memory = iter->m_resource->get_memory();
+                    if (desc.type == ResourceType::texture)
+                    {
+                        auto r = device->new_aliasing_texture(memory, desc.texture);
+                        if (succeeded(r)) ret = r.get();
+                    }
+                    else
+                    {
+                        auto r = device->new_aliasing_buffer(memory, desc.buffer);
+                        if (succeeded(r)) ret = r.get();
+                    }
+                    if (ret)
+                    {
+                        resources.erase(iter);
+                        if (resources.empty()) m_temporary_resource_pool.erase(bucket);
+                        break;
+                    }
+                }
+                if (ret) break;
+            }
+            if (!ret)
+            {
+                // Try to allocate one new block.
+                if (desc.type == ResourceType::texture)
+                {
+                    auto tex = desc.texture;
+                    tex.flags |= RHI::ResourceFlag::allow_aliasing;
+                    auto r = device->new_texture(desc.memory_type, tex);
+                    if (failed(r)) return r.errcode();
+                    ret = r.get();
+                }
+                else
+                {
+                    auto buffer = desc.buffer;
+                    buffer.flags |= RHI::ResourceFlag::allow_aliasing;
+                    auto r = device->new_buffer(desc.memory_type, buffer);
+                    if (failed(r)) return r.errcode();
+                    ret = r.get();
+                }
+            }
+            return ret;
+        }
+        void RenderPassContext::release_transient_resource(const ResourceDesc& desc, RHI::IResource* resource)
+        {
+            FreeTemporaryResource res;
+            res.m_desc = desc;
+            res.m_resource = resource;
+            res.m_release_execution = m_graph->m_execution_index;
+            usize h = hash_resource_desc(desc);
+            auto bucket = m_temporary_resource_pool.find(h);
+            if (bucket == m_temporary_resource_pool.end())
+            {
+                bucket = m_temporary_resource_pool.insert(make_pair(h, Vector<FreeTemporaryResource>())).first;
+            }
+            bucket->second.push_back(move(res));
+        }
+        void RenderPassContext::release_unused_resources()
+        {
+            u64 lifetime = m_graph->m_temporary_resource_lifetime;
+            auto bucket = m_temporary_resource_pool.begin();
+            while (bucket != m_temporary_resource_pool.end())
+            {
+                auto& resources = bucket->second;
+                auto iter = resources.begin();
+                while (iter != resources.end())
+                {
+                    if (iter->m_release_execution + lifetime < m_graph->m_execution_index) iter = resources.erase(iter);
+                    else ++iter;
+                }
+                if (resources.empty()) bucket = m_temporary_resource_pool.erase(bucket);
+                else ++bucket;
+            }
+        }
+        RHI::IResource* RenderPassContext::get_input(const Name& name)
+        {
+            auto& data = m_graph->m_pass_data[m_current_pass];
+            auto iter = data.m_input_resources.find(name);
+            if(iter == data.m_input_resources.end()) return nullptr;
+            auto h = iter->second;
+            return m_graph->m_resource_data[h].m_resource;
+        }
+        RHI::IResource* RenderPassContext::get_output(const Name& name)
+        {
+            auto& data = m_graph->m_pass_data[m_current_pass];
+            auto iter = data.m_output_resources.find(name);
+            if(iter == data.m_output_resources.end()) return nullptr;
+            auto h = iter->second;
+            return m_graph->m_resource_data[h].m_resource;
+        }
+        usize RenderPassContext::get_pass_resource(const Name& name)
+        {
+            auto& data = m_graph->m_pass_data[m_current_pass];
+            auto iter = data.m_output_resources.find(name);
+            if(iter != data.m_output_resources.end()) return iter->second;
+            iter = data.m_input_resources.find(name);
+            if(iter != data.m_input_resources.end()) return iter->second;
+            return USIZE_MAX;
+        }
+        RHI::LoadOp RenderPassContext::get_attachment_load_op(const Name& name)
+        {
+            usize res = get_pass_resource(name);
+            if(res == USIZE_MAX || m_graph->m_desc.resources[res].type != RenderGraphResourceType::transient) return RHI::LoadOp::load;
+            return m_graph->m_resource_data[res].m_first_access < m_current_pass ? RHI::LoadOp::load : RHI::LoadOp::dont_care;
+        }
+        RHI::StoreOp RenderPassContext::get_attachment_store_op(const Name& name)
+        {
+            usize res = get_pass_resource(name);
+            if(res == USIZE_MAX) return RHI::StoreOp::store;
+            auto& node = m_graph->m_desc.resources[res];
+            if(node.type != RenderGraphResourceType::transient || test_flags(node.flags, RenderGraphResourceFlag::output)) return RHI::StoreOp::store;
+            return m_graph->m_resource_data[res].m_last_access > m_current_pass ? RHI::StoreOp::store : RHI::StoreOp::dont_care;
+        }
+        RHI::IQueryHeap* RenderPassContext::get_timestamp_query_heap(u32* begin_index, u32* end_index)
+        {
+            if(m_graph->m_enable_time_profiling)
+            {
+                u32 index = m_graph->m_pass_data[m_current_pass].m_time_query_index;
+                if(begin_index) *begin_index = index * 2;
+                if(end_index) *end_index = index * 2 + 1;
+                return m_graph->m_time_query_heap;
+            }
+            if(begin_index) *begin_index = 0;
+            if(end_index) *end_index = 0;
+            return nullptr;
+        }
+        R<Ref<RHI::IResource>> RenderPassContext::allocate_temporary_resource(const ResourceDesc& desc)
         {
             Ref<RHI::IResource> ret;
             lutry
             {
                 luset(ret, allocate_transient_resource(desc));
-                m_temporary_resources.push_back(ret);
+                TemporaryResource res;
+                res.m_desc = desc;
+                res.m_resource = ret;
+                m_temporary_resources.push_back(move(res));
                 m_cmdbuf->attach_device_object(ret); // Prevent this resource object being freed before execution.
             }
             lucatchret;
             return ret;
         }
-        void RenderGraph::release_temporary_resource(RHI::IResource* res)
+        void RenderPassContext::release_temporary_resource(RHI::IResource* res)
         {
             for(auto iter = m_temporary_resources.begin(); iter != m_temporary_resources.end(); ++iter)
             {
-                if(iter->get() == res)
+                if(iter->m_resource.get() == res)
                 {
-                    release_transient_resource(res);
+                    release_transient_resource(iter->m_desc, res);
                     m_temporary_resources.erase(iter);
                     return;
                 }
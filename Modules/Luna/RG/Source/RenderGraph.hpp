@@ -9,33 +9,196 @@
 */
 #pragma once
 #include "../RenderGraph.hpp"
+#include <Luna/Runtime/PerfCounter.hpp>
 namespace Luna
 {
     namespace RG
     {
-        struct RenderGraph : IRenderGraph, IRenderGraphCompiler, IRenderPassContext
+        inline bool is_resource_desc_equal(const ResourceDesc& lhs, const ResourceDesc& rhs)
+        {
+            if (lhs.type != rhs.type || lhs.memory_type != rhs.memory_type) return false;
+            if (lhs.type == ResourceType::buffer)
+            {
+                return lhs.buffer.size == rhs.buffer.size && lhs.buffer.usages == rhs.buffer.usages && lhs.buffer.flags == rhs.buffer.flags;
+            }
+            auto& l = lhs.texture;
+            auto& r = rhs.texture;
+            return l.type == r.type && l.format == r.format && l.width == r.width && l.height == r.height && l.depth == r.depth &&
+                l.array_size == r.array_size && l.mip_levels == r.mip_levels && l.sample_count == r.sample_count &&
+                l.usages == r.usages && l.flags == r.flags;
+        }
+
+        inline usize hash_resource_desc(const ResourceDesc& desc)
+        {
+            usize h = memhash(&desc.type, sizeof(desc.type));
+            h = memhash(&desc.memory_type, sizeof(desc.memory_type), h);
+            if (desc.type == ResourceType::buffer)
+            {
+                h = memhash(&desc.buffer.size, sizeof(desc.buffer.size), h);
+                h = memhash(&desc.buffer.usages, sizeof(desc.buffer.usages), h);
+                return memhash(&desc.buffer.flags, sizeof(desc.buffer.flags), h);
+            }
+            auto& t = desc.texture;
+            h = memhash(&t.type, sizeof(t.type), h);
+            h = memhash(&t.format, sizeof(t.format), h);
+            // `width`, `height`, `depth`, `array_size`, `mip_levels` and `sample_count` are continuous `u32` values without padding.
+            h = memhash(&t.width, sizeof(u32) * 6, h);
+            h = memhash(&t.usages, sizeof(t.usages), h);
+            return memhash(&t.flags, sizeof(t.flags), h);
+        }
+
+        struct RenderGraph;
+
+        // The total size of transient heaps of all render graphs.
+        extern perf_counter_t g_transient_memory_counter;
+
+        // Records render passes into one command buffer. Render passes recorded by different contexts can be recorded 
+        // on different threads concurrently.
+        struct RenderPassContext : IRenderPassContext
+        {
+            lustruct("RG::RenderPassContext", "{3d0c6f4b-8a2e-4c71-9b5d-e17a64f02c93}");
+            luiimpl();
+
+            RenderGraph* m_graph;
+            Ref<RHI::ICommandBuffer> m_cmdbuf;
+            // Whether the command buffer is submitted and should be waited before reusing. This is used only if the command 
+            // buffer is managed by the render graph.
+            bool m_submitted = false;
+            // The index of the pass being recorded.
+            usize m_current_pass;
+            // The result of recording passes of this context on one worker thread.
+            RV m_result;
+
+            struct TemporaryResource
+            {
+                ResourceDesc m_desc;
+                Ref<RHI::IResource> m_resource;
+            };
+            // Temporary resources allocated by the current pass.
+            Vector<TemporaryResource> m_temporary_resources;
+
+            // One temporary resource that is released and can be reused by succeeding allocations.
+            struct FreeTemporaryResource
+            {
+                ResourceDesc m_desc;
+                Ref<RHI::IResource> m_resource;
+                // The index of the execution that releases this resource.
+                u64 m_release_execution;
+            };
+            // Temporary resources released by passes recorded by this context, grouped by the hash of their descriptors. Temporary 
+            // resources are kept between executions, so that passes that allocate the same temporary resources every frame do not 
+            // create resources again. Every context has its own pool, so that contexts can be recorded concurrently, and resources 
+            // are never shared by two queues.
+            HashMap<usize, Vector<FreeTemporaryResource>> m_temporary_resource_pool;
+
+            R<Ref<RHI::IResource>> allocate_transient_resource(const ResourceDesc& desc);
+            void release_transient_resource(const ResourceDesc& desc, RHI::IResource* resource);
+            // Releases pooled temporary resources that are not reused in the last `m_graph->m_temporary_resource_lifetime` executions.
+            void release_unused_resources();
+
+            virtual RHI::ICommandBuffer* get_command_buffer() override { return m_cmdbuf; }
+            virtual RHI::IResource* get_input(const Name& name) override;
+            virtual RHI::IResource* get_output(const Name& name) override;
+            virtual RHI::LoadOp get_attachment_load_op(const Name& name) override;
+            virtual RHI::StoreOp get_attachment_store_op(const Name& name) override;
+            // Gets the index of the input or output resource of the current pass, or `USIZE_MAX` if not found.
+            usize get_pass_resource(const Name& name);
+            virtual RHI::IQueryHeap* get_timestamp_query_heap(u32* begin_index, u32* end_index) override;
+            virtual R<Ref<RHI::IResource>> allocate_temporary_resource(const ResourceDesc& desc) override;
+            virtual void release_temporary_resource(RHI::IResource* res) override;
+        };
+
+        struct RenderGraph : IRenderGraph, IRenderGraphCompiler
         {
             lustruct("RG::RenderGraph", "{feefd806-4b82-48cd-b350-f8fc9387fc65}");
             luiimpl();
 
+            ~RenderGraph()
+            {
+                perf_counter_add(g_transient_memory_counter, -(i64)m_transient_memory_size);
+            }
+
             Ref<RHI::IDevice> m_device;
             RenderGraphDesc m_desc;
 
+            // The queues that render passes can be executed on.
+            static constexpr u8 GRAPHICS_QUEUE = 0;
+            static constexpr u8 ASYNC_COMPUTE_QUEUE = 1;
+            static constexpr u8 ASYNC_COPY_QUEUE = 2;
+            static constexpr usize NUM_QUEUES = 3;
+
+            // The state that one render pass uses one resource in, declared by render pass parameters.
+            struct PassResourceState
+            {
+                usize m_resource;
+                RHI::TextureStateFlag m_texture_state;
+                RHI::BufferStateFlag m_buffer_state;
+                bool m_discard_content;
+            };
             // Produced by compiling the render graph.
             struct PassData
             {
                 HashMap<Name, usize> m_input_resources;
                 HashMap<Name, usize> m_output_resources;
-                // The indices of `m_transient_resources` that should be released when this node is finished.
+                // The indices of transient resources that are first accessed by this node. Aliasing barriers are 
+                // issued for these resources before this node is executed.
                 Vector<usize> m_create_resources;
-                Vector<usize> m_release_resources;
+                // The resource states declared by parameters of this pass. The render graph issues barriers for these 
+                // resources before this pass is executed.
+                Vector<PassResourceState> m_resource_states;
                 Ref<IRenderPass> m_render_pass;
+                // The render pass type that compiles this pass.
+                Name m_type;
+                // Descriptors of resources connected to this pass before and after the compile callback is called. If descriptors before 
+                // the compile callback are not changed in the next compilation, the render pass object is reused, and descriptors after 
+                // the compile callback are applied directly.
+                Vector<Pair<usize, ResourceDesc>> m_descs_before_compile;
+                Vector<Pair<usize, ResourceDesc>> m_descs_after_compile;
                 bool m_enabled = false;
+                // Whether this pass should be recompiled in the next compilation.
+                bool m_dirty = false;
+                // Statistics of the last execution.
+                u64 m_cpu_time = 0;
+                u32 m_num_buffer_barriers = 0;
+                u32 m_num_texture_barriers = 0;
+                // The queue that this pass is executed on.
+                u8 m_queue = GRAPHICS_QUEUE;
+                // The index of the segment that contains this pass.
+                usize m_segment = USIZE_MAX;
+                // The index of the context in `m_contexts[m_queue]` that records this pass.
+                usize m_context = 0;
+                // The index of the timestamp query pair of this pass.
+                u32 m_time_query_index = 0;
+            };
+            // One range of enabled passes that are executed on the same queue in one command buffer.
+            struct SegmentData
+            {
+                // The range of passes in `m_pass_data`, disabled passes in the range are skipped.
+                usize m_first_pass;
+                usize m_end_pass;
+                u8 m_queue;
+                // The index of the segment on every other queue to wait before executing this segment, or `USIZE_MAX` if not needed.
+                usize m_wait_segments[NUM_QUEUES] = { USIZE_MAX, USIZE_MAX, USIZE_MAX };
+                // The index of the fence in `m_fences` to wait for every element of `m_wait_segments`.
+                usize m_wait_fences[NUM_QUEUES] = { USIZE_MAX, USIZE_MAX, USIZE_MAX };
+                // The index of the fence in `m_fences` to signal for segments on every other queue that waits this segment, 
+                // or `USIZE_MAX` if not needed. Fences are binary, so every wait has its own fence.
+                usize m_signal_fences[NUM_QUEUES] = { USIZE_MAX, USIZE_MAX, USIZE_MAX };
+                // The range of contexts in `m_contexts[m_queue]` that record passes of this segment.
+                // Command buffers of these contexts are submitted in order.
+                usize m_first_context;
+                usize m_num_contexts = 1;
             };
             struct ResourceData
             {
                 ResourceDesc m_resource_desc;
                 Ref<RHI::IResource> m_resource;
+                RenderGraphResourceType m_type = RenderGraphResourceType::transient;
+                // The first and last pass that accesses this resource, `m_first_access` is `USIZE_MAX` if not accessed.
+                usize m_first_access = USIZE_MAX;
+                usize m_last_access = 0;
+                // The index of the heap in `m_transient_heaps` that this resource is placed in, or `USIZE_MAX` if not placed.
+                usize m_heap = USIZE_MAX;
             };
             Vector<PassData> m_pass_data;
             Vector<ResourceData> m_resource_data;
@@ -43,77 +206,52 @@ namespace Luna
 
             Ref<RHI::IQueryHeap> m_time_query_heap;
             u32 m_time_query_heap_capacity = 0;
-            u32 m_current_time_query_index = 0;
             u32 m_num_enabled_passes;
 
+            // Segment context. `m_segments` is empty if neither async queues nor parallel recording is used.
+            // The command queue index of every queue, the graphics queue index is fetched from the command buffer passed to `execute`.
+            u32 m_queues[NUM_QUEUES] = { U32_MAX, U32_MAX, U32_MAX };
+            bool m_parallel_recording = false;
+            u32 m_temporary_resource_lifetime = 1;
+            Vector<SegmentData> m_segments;
+            // The number of contexts used by segments on every queue.
+            usize m_num_contexts[NUM_QUEUES] = { 0, 0, 0 };
+            // Contexts and fences are kept between compilations since they may still be used by the GPU.
+            Vector<Ref<RenderPassContext>> m_contexts[NUM_QUEUES];
+            Vector<Ref<RHI::IFence>> m_fences;
+            // Device memory that transient resources are placed in. Transient resources whose lifetimes do not overlap share one
+            // device memory. Transient heaps and resources are created when the render graph is compiled, and are kept between executions.
+            Vector<Ref<RHI::IDeviceMemory>> m_transient_heaps;
+            // The total size of `m_transient_heaps`, which is added to `g_transient_memory_counter`.
+            u64 m_transient_memory_size = 0;
+
             // Compile context.
             usize m_current_compile_pass;
+            // The hash of the render graph descriptor and compilation configuration of the last compilation.
+            u64 m_compile_hash = 0;
+            // The compile cache set by the user.
+            Variant m_compile_cache;
 
             // Execution context.
-            Ref<RHI::ICommandBuffer> m_cmdbuf;
-            Vector<Ref<RHI::IResource>> m_temporary_resources;
-            usize m_current_pass;
+            // The context used to record passes into the command buffer passed to `execute` if `m_segments` is empty.
+            Ref<RenderPassContext> m_context;
+            // The index of the current execution.
+            u64 m_execution_index = 0;
 
-            Vector<Ref<RHI::IDeviceMemory>> m_transient_memory;
-            R<Ref<RHI::IResource>> allocate_transient_resource(const ResourceDesc& desc)
-            {
-                // Try to reuse one memory block.
-                Ref<RHI::IResource> ret;
-                auto iter = m_transient_memory.begin();
-                while (iter != m_transient_memory.end())
-                {
-                    if (desc.type == ResourceType::texture)
-                    {
-                        auto r = m_device->new_aliasing_texture(*iter, desc.texture);
-                        if (succeeded(r))
-                        {
-                            ret = r.get();
-                            m_transient_memory.erase(iter);
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        auto r = m_device->new_aliasing_buffer(*iter, desc.buffer);
-                        if (succeeded(r))
-                        {
-                            ret = r.get();
-                            m_transient_memory.erase(iter);
-                            break;
-                        }
-                    }
-                    ++iter;
-                }
-                if (!ret)
-                {
-                    // Try to allocate one new block.
-                    if (desc.type == ResourceType::texture)
-                    {
-                        auto tex = desc.texture;
-                        tex.flags |= RHI::ResourceFlag::allow_aliasing;
-                        auto r = m_device->new_texture(desc.memory_type, tex);
-                        if (failed(r)) return r.errcode();
-                        ret = r.get();
-                    }
-                    else
-                    {
-                        auto buffer = desc.buffer;
-                        buffer.flags |= RHI::ResourceFlag::allow_aliasing;
-                        auto r = m_device->new_buffer(desc.memory_type, buffer);
-                        if (failed(r)) return r.errcode();
-                        ret = r.get();
-                    }
-                }
-                return ret;
-            }
-            void release_transient_resource(RHI::IResource* resource)
-            {
-                m_transient_memory.push_back(resource->get_memory());
-            }
+            // Places transient resources in transient heaps and creates them. `lifetimes` stores the index of the first and 
+            // last pass that accesses every resource, the first index is `USIZE_MAX` if the resource is not accessed.
+            // If `cache` is not `nullptr`, the memory layout stored in the compile cache is used if possible.
+            RV place_transient_resources(Span<const Pair<usize, usize>> lifetimes, const Variant* cache);
+            RV execute_pass(RenderPassContext* ctx, usize pass);
+            RV prepare_segments(u32 graphics_queue);
             virtual RHI::IDevice* get_device() override { return m_device.get(); }
             virtual const RenderGraphDesc& get_desc() override { return m_desc; }
             virtual void set_desc(const RenderGraphDesc& desc) override { m_desc = desc; }
             virtual RV compile(const RenderGraphCompileConfig& config) override;
+            virtual void mark_render_pass_dirty(usize index) override
+            {
+                if(index < m_pass_data.size()) m_pass_data[index].m_dirty = true;
+            }
             virtual void get_enabled_render_passes(Vector<usize>& render_passes) override;
             virtual IRenderPass* get_render_pass(usize index) override
             {
@@ -136,6 +274,13 @@ namespace Luna
                 return nullptr;
             }
             virtual RV get_pass_time_intervals(Vector<u64>& pass_time_intervals) override;
+            virtual RV get_pass_timestamps(Vector<u64>& pass_timestamps) override;
+            virtual RV get_stats(RenderGraphStats& stats) override;
+            virtual R<Variant> get_compile_cache() override;
+            virtual void set_compile_cache(const Variant& cache) override
+            {
+                m_compile_cache = cache;
+            }
 
             virtual usize get_input_resource(const Name& name) override
             {
@@ -166,38 +311,6 @@ namespace Luna
             {
                 m_pass_data[m_current_compile_pass].m_render_pass = render_pass;
             }
-
-            virtual RHI::ICommandBuffer* get_command_buffer() override { return m_cmdbuf; }
-            virtual RHI::IResource* get_input(const Name& name) override
-            {
-                auto& data = m_pass_data[m_current_pass];
-                auto iter = data.m_input_resources.find(name);
-                if(iter == data.m_input_resources.end()) return nullptr;
-                auto h = iter->second;
-                return m_resource_data[h].m_resource;
-            }
-            virtual RHI::IResource* get_output(const Name& name) override
-            {
-                auto& data = m_pass_data[m_current_pass];
-                auto iter = data.m_output_resources.find(name);
-                if(iter == data.m_output_resources.end()) return nullptr;
-                auto h = iter->second;
-                return m_resource_data[h].m_resource;
-            }
-            virtual RHI::IQueryHeap* get_timestamp_query_heap(u32* begin_index, u32* end_index) override
-            {
-                if(m_enable_time_profiling)
-                {
-                    if(begin_index) *begin_index = m_current_time_query_index * 2;
-                    if(end_index) *end_index = m_current_time_query_index * 2 + 1;
-                    return m_time_query_heap;
-                }
-                if(begin_index) *begin_index = 0;
-                if(end_index) *end_index = 0;
-                return nullptr;
-            }
-            virtual R<Ref<RHI::IResource>> allocate_temporary_resource(const ResourceDesc& desc) override;
-            virtual void release_temporary_resource(RHI::IResource* res) override;
         };
     }
 }
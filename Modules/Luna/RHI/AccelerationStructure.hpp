@@ -0,0 +1,207 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AccelerationStructure.hpp
+* @author JXMaster
+* @date 2024/4/8
+* @brief Ray tracing acceleration structures.
+*/
+#pragma once
+#include "Buffer.hpp"
+#include "Texture.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! @addtogroup RHI
+        //! @{
+
+        //! Specifies the type of one acceleration structure.
+        enum class AccelerationStructureType : u8
+        {
+            //! The bottom-level acceleration structure, which contains geometries of one or more meshes.
+            bottom_level = 0,
+            //! The top-level acceleration structure, which contains instances of bottom-level acceleration structures.
+            top_level = 1,
+        };
+
+        //! Specifies additional flags for building one acceleration structure.
+        enum class AccelerationStructureBuildFlag : u8
+        {
+            none = 0x00,
+            //! Allows the acceleration structure to be updated (refitted) by succeeding builds using
+            //! the acceleration structure as the update source.
+            allow_update = 0x01,
+            //! Prefers faster ray tracing performance at the cost of longer build time.
+            prefer_fast_trace = 0x02,
+            //! Prefers faster build time at the cost of ray tracing performance. This is preferred for acceleration
+            //! structures that are rebuilt every frame.
+            prefer_fast_build = 0x04,
+            //! Minimizes memory consumption of the acceleration structure and scratch buffer at the cost of
+            //! build time and ray tracing performance.
+            minimize_memory = 0x08,
+        };
+
+        //! Specifies additional flags for one ray tracing geometry.
+        enum class RayTracingGeometryFlag : u8
+        {
+            none = 0x00,
+            //! The geometry does not invoke any-hit shaders, and is treated as opaque by ray queries.
+            opaque = 0x01,
+            //! The any-hit shader is invoked at most once for every primitive of this geometry.
+            no_duplicate_any_hit_invocation = 0x02,
+        };
+
+        //! Describes one triangle geometry in one bottom-level acceleration structure.
+        struct RayTracingGeometryDesc
+        {
+            //! The buffer that contains vertex positions.
+            //! This buffer must be created with @ref BufferUsageFlag::acceleration_structure_build_input.
+            IBuffer* vertex_buffer = nullptr;
+            //! The offset, in bytes, of the first vertex from the beginning of `vertex_buffer`.
+            u64 vertex_buffer_offset = 0;
+            //! The stride, in bytes, between two vertices in `vertex_buffer`.
+            u32 vertex_stride = 0;
+            //! The number of vertices in `vertex_buffer`.
+            u32 num_vertices = 0;
+            //! The format of vertex positions. Only the first three components are used.
+            //! This can be @ref Format::rgb32_float, @ref Format::rg32_float, @ref Format::rgba16_float,
+            //! @ref Format::rg16_float, @ref Format::rgba16_snorm or @ref Format::rg16_snorm.
+            Format vertex_format = Format::rgb32_float;
+            //! The buffer that contains vertex indices. Specify `nullptr` if the geometry is not indexed,
+            //! in which case every three vertices form one triangle.
+            //! This buffer must be created with @ref BufferUsageFlag::acceleration_structure_build_input.
+            IBuffer* index_buffer = nullptr;
+            //! The offset, in bytes, of the first index from the beginning of `index_buffer`.
+            u64 index_buffer_offset = 0;
+            //! The number of indices in `index_buffer`.
+            u32 num_indices = 0;
+            //! The format of indices. This must be @ref Format::r16_uint or @ref Format::r32_uint.
+            Format index_format = Format::r32_uint;
+            //! The geometry flags.
+            RayTracingGeometryFlag flags = RayTracingGeometryFlag::opaque;
+        };
+
+        //! Specifies additional flags for one ray tracing instance.
+        //! @details These flags match `D3D12_RAYTRACING_INSTANCE_FLAGS` and `VkGeometryInstanceFlagsKHR`.
+        enum class RayTracingInstanceFlag : u8
+        {
+            none = 0x00,
+            //! Disables face culling for this instance.
+            triangle_cull_disable = 0x01,
+            //! Treats counter-clockwise triangles as front-facing for this instance.
+            triangle_front_counter_clockwise = 0x02,
+            //! Treats all geometries of this instance as opaque.
+            force_opaque = 0x04,
+            //! Treats all geometries of this instance as non-opaque.
+            force_non_opaque = 0x08,
+        };
+
+        //! The data layout of one ray tracing instance in the instance buffer used to build top-level acceleration structures.
+        //! @details This matches `D3D12_RAYTRACING_INSTANCE_DESC` and `VkAccelerationStructureInstanceKHR`, so that instance
+        //! data can be written to upload buffers or generated by compute shaders directly.
+        struct RayTracingInstanceDesc
+        {
+            //! The 3x4 row-major object-to-world transform matrix of this instance.
+            f32 transform[3][4];
+            //! The user-defined instance ID that can be read by shaders.
+            u32 instance_id : 24;
+            //! The visibility mask of this instance. The instance is skipped if the result of bitwise AND between this mask
+            //! and the ray mask is zero.
+            u32 instance_mask : 8;
+            //! The hit group index offset of this instance. This is not used by inline ray queries.
+            u32 instance_contribution_to_hit_group_index : 24;
+            //! A combination of @ref RayTracingInstanceFlag flags.
+            u32 flags : 8;
+            //! The GPU address of the bottom-level acceleration structure of this instance, fetched from
+            //! @ref IAccelerationStructure::get_gpu_address.
+            u64 acceleration_structure;
+        };
+        static_assert(sizeof(RayTracingInstanceDesc) == 64, "Incorrect RayTracingInstanceDesc size.");
+
+        //! Describes inputs used to build one acceleration structure.
+        struct AccelerationStructureBuildInputs
+        {
+            //! The type of the acceleration structure to build.
+            AccelerationStructureType type = AccelerationStructureType::bottom_level;
+            //! The build flags.
+            AccelerationStructureBuildFlag flags = AccelerationStructureBuildFlag::none;
+            //! The geometries of the acceleration structure. Used only if `type` is @ref AccelerationStructureType::bottom_level.
+            Span<const RayTracingGeometryDesc> geometries;
+            //! The buffer that contains @ref RayTracingInstanceDesc instances. Used only if `type` is @ref AccelerationStructureType::top_level.
+            //! This buffer must be created with @ref BufferUsageFlag::acceleration_structure_build_input.
+            IBuffer* instance_buffer = nullptr;
+            //! The offset, in bytes, of the first instance from the beginning of `instance_buffer`. This must be aligned to 16 bytes.
+            u64 instance_buffer_offset = 0;
+            //! The number of instances in `instance_buffer`.
+            u32 num_instances = 0;
+
+            AccelerationStructureBuildInputs() = default;
+            //! Creates inputs for one bottom-level acceleration structure.
+            AccelerationStructureBuildInputs(Span<const RayTracingGeometryDesc> geometries,
+                AccelerationStructureBuildFlag flags = AccelerationStructureBuildFlag::none) :
+                type(AccelerationStructureType::bottom_level),
+                flags(flags),
+                geometries(geometries) {}
+            //! Creates inputs for one top-level acceleration structure.
+            AccelerationStructureBuildInputs(IBuffer* instance_buffer, u64 instance_buffer_offset, u32 num_instances,
+                AccelerationStructureBuildFlag flags = AccelerationStructureBuildFlag::none) :
+                type(AccelerationStructureType::top_level),
+                flags(flags),
+                instance_buffer(instance_buffer),
+                instance_buffer_offset(instance_buffer_offset),
+                num_instances(num_instances) {}
+        };
+
+        //! Describes memory sizes required to build one acceleration structure.
+        struct AccelerationStructureSizes
+        {
+            //! The size, in bytes, of the acceleration structure. Use this as @ref AccelerationStructureDesc::size when
+            //! creating the acceleration structure.
+            u64 acceleration_structure_size;
+            //! The size, in bytes, of the scratch buffer range required to build the acceleration structure.
+            u64 build_scratch_size;
+            //! The size, in bytes, of the scratch buffer range required to update the acceleration structure.
+            u64 update_scratch_size;
+            //! The alignment, in bytes, of the scratch buffer offset.
+            u64 scratch_alignment;
+        };
+
+        //! Describes one acceleration structure.
+        struct AccelerationStructureDesc
+        {
+            //! The type of the acceleration structure.
+            AccelerationStructureType type;
+            //! The size, in bytes, of the acceleration structure.
+            u64 size;
+
+            AccelerationStructureDesc() = default;
+            AccelerationStructureDesc(AccelerationStructureType type, u64 size) :
+                type(type),
+                size(size) {}
+        };
+
+        //! @interface IAccelerationStructure
+        //! Represents one ray tracing acceleration structure that can be traversed by ray queries in shaders.
+        //! @details Acceleration structures are created by @ref IDevice::new_acceleration_structure, built by
+        //! @ref ICommandBuffer::build_acceleration_structure, and bound to shaders using @ref DescriptorType::acceleration_structure
+        //! descriptors. Shaders use `RaytracingAccelerationStructure` and `RayQuery` objects to trace rays against
+        //! the acceleration structure, which requires shader model 6.5 or later.
+        struct IAccelerationStructure : virtual IDeviceChild
+        {
+            luiid("{A2E47D19-6C3B-4F85-9E0A-D5B18F2C7436}");
+
+            //! Gets the descriptor of this acceleration structure.
+            virtual AccelerationStructureDesc get_desc() = 0;
+
+            //! Gets the GPU address of this acceleration structure, which is used in @ref RayTracingInstanceDesc::acceleration_structure
+            //! to reference bottom-level acceleration structures.
+            virtual u64 get_gpu_address() = 0;
+        };
+
+        //! @}
+    }
+}
@@ -0,0 +1,98 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BindlessResourceTable.hpp
+* @author JXMaster
+* @date 2024/4/2
+*/
+#pragma once
+#include "DescriptorSet.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! @addtogroup RHI
+        //! @{
+
+        //! The index value that represents one invalid bindless resource index.
+        constexpr u32 INVALID_BINDLESS_INDEX = U32_MAX;
+
+        //! Describes one bindless resource table.
+        struct BindlessResourceTableDesc
+        {
+            //! The maximum number of texture views that can be registered to the table at the same time.
+            u32 max_textures = 2048;
+            //! The maximum number of structured buffer views that can be registered to the table at the same time.
+            u32 max_buffers = 256;
+            //! The shader visibility of resources in the table.
+            ShaderVisibilityFlag shader_visibility_flags = ShaderVisibilityFlag::all;
+
+            BindlessResourceTableDesc() {}
+            BindlessResourceTableDesc(u32 max_textures, u32 max_buffers,
+                ShaderVisibilityFlag shader_visibility_flags = ShaderVisibilityFlag::all) :
+                max_textures(max_textures),
+                max_buffers(max_buffers),
+                shader_visibility_flags(shader_visibility_flags) {}
+        };
+
+        //! @interface IBindlessResourceTable
+        //! Represents one table of texture and buffer views that can be accessed by shaders using indices.
+        //! @details The bindless resource table is one descriptor set that contains one array of 2D texture views
+        //! and one array of structured buffer views. Resources are registered to the table once and receive one stable index,
+        //! shaders can then access the resource by indexing the array, so that only the index (for example, by one
+        //! uniform buffer or instance data) needs to be changed between draw calls rather than the descriptor set.
+        //!
+        //! The texture view array is bound to binding slot 0 and contains @ref BindlessResourceTableDesc::max_textures descriptors,
+        //! the buffer view array is bound to binding slot `max_textures` and contains @ref BindlessResourceTableDesc::max_buffers
+        //! descriptors. Use `Luna/RHI/Shaders/Bindless.hlsl` to declare matching arrays in shaders.
+        //!
+        //! Creating bindless resource tables requires @ref DeviceFeature::unbound_descriptor_array.
+        //!
+        //! Registering and unregistering resources are thread-safe, but the user should not register or unregister
+        //! resources when command buffers that use the table are being recorded or executed. The user should also make sure that shaders
+        //! only access indices of registered resources, accessing unregistered indices results in undefined behavior.
+        struct IBindlessResourceTable : virtual IDeviceChild
+        {
+            luiid("{6E0C8D27-3B5F-4A19-9D42-E1F7B6C5A380}");
+
+            //! Gets the descriptor set layout of the table. This can be used to create pipeline layouts that use the table.
+            virtual IDescriptorSetLayout* get_descriptor_set_layout() = 0;
+
+            //! Gets the descriptor set of the table. This can be bound to command buffers like other descriptor sets.
+            virtual IDescriptorSet* get_descriptor_set() = 0;
+
+            //! Gets the binding slot of the buffer view array.
+            virtual u32 get_buffer_binding_slot() = 0;
+
+            //! Registers one texture view to the table.
+            //! @param[in] desc The texture view to register. The view type must be @ref TextureViewType::tex2d or
+            //! @ref TextureViewType::unspecified for 2D textures.
+            //! @return Returns the index of the texture view in the texture view array. The index is valid until
+            //! @ref unregister_texture is called with the index.
+            //! @par Valid Usage
+            //! * The texture must be valid until it is unregistered.
+            virtual R<u32> register_texture(const TextureViewDesc& desc) = 0;
+
+            //! Registers one structured buffer view to the table.
+            //! @param[in] desc The buffer view to register.
+            //! @return Returns the index of the buffer view in the buffer view array. The index is valid until
+            //! @ref unregister_buffer is called with the index.
+            //! @par Valid Usage
+            //! * The buffer must be valid until it is unregistered.
+            virtual R<u32> register_buffer(const BufferViewDesc& desc) = 0;
+
+            //! Unregisters one texture view from the table. The index may be reused by succeeding registrations.
+            //! @param[in] index The index returned by @ref register_texture.
+            virtual void unregister_texture(u32 index) = 0;
+
+            //! Unregisters one buffer view from the table. The index may be reused by succeeding registrations.
+            //! @param[in] index The index returned by @ref register_buffer.
+            virtual void unregister_buffer(u32 index) = 0;
+        };
+
+        //! @}
+    }
+}
@@ -37,6 +37,12 @@ namespace Luna
             index_buffer = 0x40,
             //! Allows this resource to be bound as a buffer providing indirect draw arguments.
             indirect_buffer = 0x80,
+            //! Allows this resource to be used as vertex, index or instance buffer when building acceleration structures.
+            //! This can only be set if @ref DeviceFeature::ray_tracing is supported.
+            acceleration_structure_build_input = 0x100,
+            //! Allows this resource to be used as scratch buffer when building acceleration structures.
+            //! This can only be set if @ref DeviceFeature::ray_tracing is supported.
+            acceleration_structure_scratch = 0x200,
         };
 
         //! Describes one @ref IBuffer object.
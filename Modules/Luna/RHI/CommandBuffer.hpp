@@ -16,6 +16,7 @@
 #include "QueryHeap.hpp"
 #include <Luna/Runtime/Span.hpp>
 #include "Fence.hpp"
+#include "AccelerationStructure.hpp"
 
 namespace Luna
 {
@@ -82,6 +83,10 @@ namespace Luna
             copy_dest = 0x0800,
             //! Used as a copy source.
             copy_source = 0x1000,
+            //! Used as vertex, index or instance buffer when building acceleration structures.
+            acceleration_structure_build_input = 0x2000,
+            //! Used as scratch buffer when building acceleration structures.
+            acceleration_structure_scratch = 0x4000,
             //! If this is specified as the before state, the system determines the before state automatically using the last state 
             //! specified in the same command buffer for the resource. If this is the first time the resource is used in the current
             //! command buffer, the system loads the resource's global state automatically.
@@ -130,6 +135,8 @@ namespace Luna
             copy_source = 0x0800,
             //! Used for swap chain presentation.
             present = 0x1000,
+            //! Used as the shading rate image of one render pass.
+            shading_rate_image = 0x2000,
             //! If this is specified as the before state, the system determines the before state automatically using the last state 
             //! specified in the same command buffer for the resource. If this is the first time the resource is used in the current
             //! command buffer, the system loads the resource's global state automatically.
@@ -363,6 +370,40 @@ namespace Luna
             //! be stored.
             counting = 1,
         };
+        //! Specifies the number of pixels shaded by one pixel shader invocation.
+        //! @details The value of every enumeration is `(log2(width) << 2) | log2(height)`, which is also the
+        //! value that should be stored in shading rate images.
+        enum class ShadingRate : u8
+        {
+            //! One invocation per pixel.
+            rate_1x1 = 0x00,
+            //! One invocation per 1x2 pixels.
+            rate_1x2 = 0x01,
+            //! One invocation per 2x1 pixels.
+            rate_2x1 = 0x04,
+            //! One invocation per 2x2 pixels.
+            rate_2x2 = 0x05,
+            //! One invocation per 2x4 pixels. Devices that do not support this rate use @ref rate_2x2 instead.
+            rate_2x4 = 0x06,
+            //! One invocation per 4x2 pixels. Devices that do not support this rate use @ref rate_2x2 instead.
+            rate_4x2 = 0x09,
+            //! One invocation per 4x4 pixels. Devices that do not support this rate use @ref rate_2x2 instead.
+            rate_4x4 = 0x0A,
+        };
+        //! Specifies how to combine two shading rates.
+        enum class ShadingRateCombiner : u8
+        {
+            //! Uses the first shading rate and ignores the second one.
+            passthrough = 0,
+            //! Uses the second shading rate and ignores the first one.
+            override = 1,
+            //! Uses the finer shading rate of two shading rates.
+            min = 2,
+            //! Uses the coarser shading rate of two shading rates.
+            max = 3,
+            //! Multiplies the width and height of two shading rates.
+            sum = 4,
+        };
         //! Describes one render pass.
         struct RenderPassDesc
         {
@@ -392,6 +433,16 @@ namespace Luna
             //! The sample count for every pixel of the render pass.
             //! Specify any value greater than 1 enables MSAA.
             u8 sample_count = 1;
+            //! The screen-space shading rate image used in this render pass if not `nullptr`.
+            //! @details The shading rate image must be one 2D texture with @ref Format::r8_uint format created with 
+            //! @ref TextureUsageFlag::shading_rate_image, and must be in @ref TextureStateFlag::shading_rate_image state.
+            //! Every texel of the image stores one @ref ShadingRate value for one tile of pixels, whose size is 
+            //! reported by @ref DeviceFeature::shading_rate_image_tile_size.
+            //! 
+            //! This can only be specified if @ref DeviceFeature::shading_rate_image_tile_size is not 0. When specified, 
+            //! the shading rate of the render pass is initialized to @ref ShadingRate::rate_1x1 with the image combiner 
+            //! set to @ref ShadingRateCombiner::override, so that the shading rate image takes effect.
+            ITexture* shading_rate_image = nullptr;
         };
         //! Describes one compute pass.
         struct ComputePassDesc
@@ -462,6 +513,62 @@ namespace Luna
                 size(size),
                 format(format) {}
         };
+        //! The indirect argument layout used by @ref ICommandBuffer::draw_indirect.
+        //! This matches `VkDrawIndirectCommand`, `D3D12_DRAW_ARGUMENTS` and `MTLDrawPrimitivesIndirectArguments`.
+        struct DrawIndirectArguments
+        {
+            u32 vertex_count_per_instance;
+            u32 instance_count;
+            u32 start_vertex_location;
+            u32 start_instance_location;
+        };
+        //! The indirect argument layout used by @ref ICommandBuffer::draw_indexed_indirect.
+        //! This matches `VkDrawIndexedIndirectCommand`, `D3D12_DRAW_INDEXED_ARGUMENTS` and `MTLDrawIndexedPrimitivesIndirectArguments`.
+        struct DrawIndexedIndirectArguments
+        {
+            u32 index_count_per_instance;
+            u32 instance_count;
+            u32 start_index_location;
+            i32 base_vertex_location;
+            u32 start_instance_location;
+        };
+        //! The indirect argument layout used by @ref ICommandBuffer::dispatch_indirect.
+        //! This matches `VkDispatchIndirectCommand`, `D3D12_DISPATCH_ARGUMENTS` and `MTLDispatchThreadgroupsIndirectArguments`.
+        struct DispatchIndirectArguments
+        {
+            u32 thread_group_count_x;
+            u32 thread_group_count_y;
+            u32 thread_group_count_z;
+        };
+
+        //! The statistics of commands recorded in one command buffer.
+        //! @details Counters are accumulated from the last @ref ICommandBuffer::reset call. Commands recorded in secondary command buffers 
+        //! are counted by secondary command buffers themselves, and are not included in the statistics of the primary command buffer.
+        struct CommandBufferStatistics
+        {
+            //! The number of draw calls, including indexed, instanced and indirect draws and mesh shader dispatches.
+            //! Every indirect draw call is counted as one draw call regardless of its draw count.
+            u32 num_draws = 0;
+            //! The number of compute dispatches, including indirect dispatches.
+            u32 num_dispatches = 0;
+            //! The number of buffer and texture barriers passed to @ref ICommandBuffer::resource_barrier, before barriers are merged.
+            u32 num_barriers = 0;
+            //! The number of pipeline states bound.
+            u32 num_pipeline_state_binds = 0;
+            //! The number of descriptor sets bound.
+            u32 num_descriptor_set_binds = 0;
+            //! The number of render passes, including parallel render passes.
+            u32 num_render_passes = 0;
+            //! The number of compute passes.
+            u32 num_compute_passes = 0;
+            //! The number of copy passes.
+            u32 num_copy_passes = 0;
+            //! The number of copy commands.
+            u32 num_copies = 0;
+            //! The number of acceleration structure builds.
+            u32 num_acceleration_structure_builds = 0;
+        };
+
         //! @interface ICommandBuffer
         //! Used to allocate memory for commands, record commands, submitting 
         //! commands to GPU and tracks the state of the submitted commands.
@@ -494,6 +601,13 @@ namespace Luna
             //! will not be released before GPU finishes accessing them.
             virtual void attach_device_object(IDeviceChild* obj) = 0;
 
+            //! Gets the statistics of commands recorded in this command buffer since the last @ref reset call.
+            //! @details This can be used to check how many draws, dispatches, barriers and binds are recorded every frame.
+            //! When `LUNA_RHI_PROFILER_ENABLED` is defined, the statistics are also emitted in @ref ProfilerEventId::COMMAND_BUFFER_SUBMIT
+            //! profiler events when the command buffer is submitted.
+            //! @return Returns the statistics of this command buffer.
+            virtual CommandBufferStatistics get_statistics() = 0;
+
             //! Begins a new event. This is for use in diagnostic tools like RenderDoc, PIX, XCode, etc to group commands into hierarchical
             //! sections.
             virtual void begin_event(const c8* event_name) = 0;
@@ -510,6 +624,7 @@ namespace Luna
             //! * set_index_buffer
             //! * set_graphics_descriptor_set
             //! * set_graphics_descriptor_sets
+            //! * set_graphics_constants
             //! * set_viewport
             //! * set_viewports
             //! * set_scissor_rect
@@ -520,6 +635,9 @@ namespace Luna
             //! * draw_indexed
             //! * draw_instanced
             //! * draw_indexed_instanced
+            //! * draw_indirect
+            //! * draw_indexed_indirect
+            //! * dispatch_mesh
             //! * clear_color_attachment
             //! * clear_depth_stencil_attachment
             //! 
@@ -529,6 +647,52 @@ namespace Luna
             //! * resource_barrier
             virtual void begin_render_pass(const RenderPassDesc& desc) = 0;
 
+            //! Begins a render pass whose commands are recorded by secondary command buffers.
+            //! @param[in] desc The render pass descriptor object.
+            //! @param[in] secondary_command_buffers The secondary command buffers that record commands of this render pass.
+            //! Commands recorded by secondary command buffers are executed in the order they are specified in this array.
+            //! @details After this function returns, every secondary command buffer in `secondary_command_buffers` is in render pass 
+            //! state, and can be recorded by one different thread concurrently. The recording of one secondary command buffer is finished 
+            //! by calling @ref end_render_pass on the secondary command buffer. After all secondary command buffers have finished recording, 
+            //! the user should call @ref end_render_pass on this command buffer to execute commands in secondary command buffers and finish 
+            //! the render pass.
+            //! 
+            //! Only the following functions can be called on secondary command buffers:
+            //! * set_graphics_pipeline_layout
+            //! * set_graphics_pipeline_state
+            //! * set_vertex_buffers
+            //! * set_index_buffer
+            //! * set_graphics_descriptor_set
+            //! * set_graphics_descriptor_sets
+            //! * set_graphics_constants
+            //! * set_viewport
+            //! * set_viewports
+            //! * set_scissor_rect
+            //! * set_scissor_rects
+            //! * set_blend_factor
+            //! * set_stencil_ref
+            //! * draw
+            //! * draw_indexed
+            //! * draw_instanced
+            //! * draw_indexed_instanced
+            //! * draw_indirect
+            //! * draw_indexed_indirect
+            //! * end_render_pass
+            //! 
+            //! Secondary command buffers are implemented using secondary command buffers on Vulkan, bundles on Direct3D 12 and 
+            //! render command encoders created from one parallel render command encoder on Metal.
+            //! @par Valid Usage
+            //! * Every command buffer in `secondary_command_buffers` must be created by @ref IDevice::new_secondary_command_buffer
+            //! using the same command queue index as this command buffer.
+            //! * This command buffer must be one primary command buffer.
+            //! * No commands other than @ref end_render_pass can be recorded to this command buffer until the render pass ends.
+            //! * `set_viewport`, `set_viewports`, `set_scissor_rect`, `set_scissor_rects`, `set_blend_factor` and `set_stencil_ref` 
+            //! must be called before the first draw call on secondary command buffers, and can be called at most once per secondary command 
+            //! buffer in one render pass, since Direct3D 12 bundles inherit these states from the primary command list.
+            //! * Occlusion queries cannot be used in secondary command buffers.
+            //! * Secondary command buffers must not be used by other render passes until this command buffer has finished execution.
+            virtual void begin_parallel_render_pass(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers) = 0;
+
             //! Sets the graphic pipeline layout.
             //! @param[in] pipeline_layout The pipeline layout to set.
             virtual void set_graphics_pipeline_layout(IPipelineLayout* pipeline_layout) = 0;
@@ -564,6 +728,16 @@ namespace Luna
             //! * This must be called after @ref set_graphics_pipeline_state and @ref set_graphics_pipeline_layout.
             virtual void set_graphics_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) = 0;
 
+            //! Sets pipeline constants to be used by the graphic pipeline.
+            //! @param[in] first_constant The index of the first 32-bit constant to set.
+            //! @param[in] num_constants The number of 32-bit constants to set.
+            //! @param[in] data The constant data. The data is copied into the command buffer when this function is called.
+            //! @par Valid Usage
+            //! * This must be called after @ref set_graphics_pipeline_layout.
+            //! * `first_constant + num_constants` must not be greater than @ref PipelineLayoutDesc::num_constants of the bound
+            //! pipeline layout.
+            virtual void set_graphics_constants(u32 first_constant, u32 num_constants, const void* data) = 0;
+
             //! Bind one viewport to the rasterizer stage of the pipeline.
             //! @details This operation behaves the same as calling @ref set_viewports with only one viewport.
             //! @param[in] viewport The viewport to set.
@@ -597,6 +771,22 @@ namespace Luna
             //! @param[in] stencil_ref The stencil reference value to set.
             virtual void set_stencil_ref(u32 stencil_ref) = 0;
 
+            //! Sets the per-draw shading rate of succeeding draw calls.
+            //! @details The final shading rate is computed by combining the per-draw shading rate with the per-primitive 
+            //! shading rate (`SV_ShadingRate` written by the vertex shader) using `primitive_combiner`, then combining the 
+            //! result with the shading rate fetched from the shading rate image using `image_combiner`.
+            //! 
+            //! This requires @ref DeviceFeature::variable_rate_shading. Combiners other than @ref ShadingRateCombiner::passthrough
+            //! requires @ref DeviceFeature::shading_rate_image_tile_size to be non-zero.
+            //! 
+            //! The shading rate is reset to @ref ShadingRate::rate_1x1 when a new render pass begins.
+            //! @param[in] rate The per-draw shading rate.
+            //! @param[in] primitive_combiner The combiner used to combine the per-draw and per-primitive shading rate.
+            //! @param[in] image_combiner The combiner used to combine the result of `primitive_combiner` and the shading rate image.
+            virtual void set_shading_rate(ShadingRate rate, 
+                ShadingRateCombiner primitive_combiner = ShadingRateCombiner::passthrough, 
+                ShadingRateCombiner image_combiner = ShadingRateCombiner::passthrough) = 0;
+
             //! Draw primitives.
             //! @param[in] vertex_count The number of vertices to draw.
             //! @param[in] start_vertex_location The position of the first vertex to draw. Vertices in range
@@ -634,6 +824,51 @@ namespace Luna
             //! Instance data in range [`start_instance_location`, `start_instance_location + instance_count`) will be used.
             virtual void draw_indexed_instanced(u32 index_count_per_instance, u32 instance_count, u32 start_index_location,
                 i32 base_vertex_location, u32 start_instance_location) = 0;
+
+            //! Draws non-indexed primitives using arguments read from one buffer.
+            //! @param[in] buffer The buffer that contains @ref DrawIndirectArguments records.
+            //! @param[in] offset The offset, in bytes, of the first record in `buffer`.
+            //! @param[in] max_draw_count The maximum number of draws to perform. If `count_buffer` is `nullptr`, 
+            //! exactly `max_draw_count` draws are performed.
+            //! @param[in] stride The distance, in bytes, between two succeeding records in `buffer`.
+            //! @param[in] count_buffer If not `nullptr`, the actual number of draws is read from one `u32` value in this buffer, 
+            //! and is clamped to `max_draw_count`.
+            //! @param[in] count_buffer_offset The offset, in bytes, of the draw count value in `count_buffer`.
+            //! @par Valid Usage
+            //! * `buffer` and `count_buffer` must be created with @ref BufferUsageFlag::indirect_buffer, and must be in 
+            //! @ref BufferStateFlag::indirect_argument state.
+            //! * `stride` must be a multiple of 4 and must not be smaller than `sizeof(DrawIndirectArguments)`.
+            //! * If `count_buffer` is not `nullptr`, @ref DeviceFeature::indirect_draw_count must be supported.
+            virtual void draw_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride = sizeof(DrawIndirectArguments),
+                IBuffer* count_buffer = nullptr, u64 count_buffer_offset = 0) = 0;
+
+            //! Draws indexed primitives using arguments read from one buffer.
+            //! @param[in] buffer The buffer that contains @ref DrawIndexedIndirectArguments records.
+            //! @param[in] offset The offset, in bytes, of the first record in `buffer`.
+            //! @param[in] max_draw_count The maximum number of draws to perform. If `count_buffer` is `nullptr`, 
+            //! exactly `max_draw_count` draws are performed.
+            //! @param[in] stride The distance, in bytes, between two succeeding records in `buffer`.
+            //! @param[in] count_buffer If not `nullptr`, the actual number of draws is read from one `u32` value in this buffer, 
+            //! and is clamped to `max_draw_count`.
+            //! @param[in] count_buffer_offset The offset, in bytes, of the draw count value in `count_buffer`.
+            //! @par Valid Usage
+            //! * `buffer` and `count_buffer` must be created with @ref BufferUsageFlag::indirect_buffer, and must be in 
+            //! @ref BufferStateFlag::indirect_argument state.
+            //! * `stride` must be a multiple of 4 and must not be smaller than `sizeof(DrawIndexedIndirectArguments)`.
+            //! * If `count_buffer` is not `nullptr`, @ref DeviceFeature::indirect_draw_count must be supported.
+            virtual void draw_indexed_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride = sizeof(DrawIndexedIndirectArguments),
+                IBuffer* count_buffer = nullptr, u64 count_buffer_offset = 0) = 0;
+
+            //! Dispatches mesh shader work using the bound mesh pipeline state.
+            //! @param[in] thread_group_count_x The number of thread groups to emit in the first dimension.
+            //! @param[in] thread_group_count_y The number of thread groups to emit in the second dimension.
+            //! @param[in] thread_group_count_z The number of thread groups to emit in the third dimension.
+            //! @details Thread groups are emitted to the amplification shader if the bound pipeline state has one, or to the 
+            //! mesh shader otherwise.
+            //! @par Valid Usage
+            //! * @ref DeviceFeature::mesh_shader must be supported.
+            //! * The bound pipeline state must be created by @ref IDevice::new_mesh_pipeline_state.
+            virtual void dispatch_mesh(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) = 0;
             
             //! Starts one occlusion query.
             //! @param[in] mode The working mode of the new occlusion query.
@@ -648,6 +883,10 @@ namespace Luna
             virtual void end_occlusion_query(u32 index) = 0;
 
             //! Finishes the current render pass.
+            //! @details If this is called on one secondary command buffer, this finishes recording the secondary command buffer. 
+            //! If this is called on one primary command buffer whose render pass is begun by @ref begin_parallel_render_pass, 
+            //! this executes all secondary command buffers of the render pass and finishes the render pass, all secondary command buffers 
+            //! must finish recording before this is called.
             virtual void end_render_pass() = 0;
 
             //! Begins a compute pass.
@@ -656,7 +895,10 @@ namespace Luna
             //! * set_compute_pipeline_state
             //! * set_compute_descriptor_set
             //! * set_compute_descriptor_sets
+            //! * set_compute_constants
             //! * dispatch
+            //! * dispatch_indirect
+            //! * build_acceleration_structure
             //! @param[in] desc The compute pass descriptor.
             virtual void begin_compute_pass(const ComputePassDesc& desc = ComputePassDesc()) = 0;
 
@@ -685,12 +927,53 @@ namespace Luna
             //! * This must be called after @ref set_computes_pipeline_state and @ref set_computes_pipeline_layout.
             virtual void set_compute_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) = 0;
 
+            //! Sets pipeline constants to be used by the compute pipeline.
+            //! @param[in] first_constant The index of the first 32-bit constant to set.
+            //! @param[in] num_constants The number of 32-bit constants to set.
+            //! @param[in] data The constant data. The data is copied into the command buffer when this function is called.
+            //! @par Valid Usage
+            //! * This must be called after @ref set_compute_pipeline_layout.
+            //! * `first_constant + num_constants` must not be greater than @ref PipelineLayoutDesc::num_constants of the bound
+            //! pipeline layout.
+            virtual void set_compute_constants(u32 first_constant, u32 num_constants, const void* data) = 0;
+
             //! Dispatches one compute task.
             //! @param[in] thread_group_count_x The number of thread groups to emit in the first dimension.
             //! @param[in] thread_group_count_y The number of thread groups to emit in the second dimension.
             //! @param[in] thread_group_count_z The number of thread groups to emit in the third dimension.
             virtual void dispatch(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) = 0;
 
+            //! Dispatches one compute task using arguments read from one buffer.
+            //! @param[in] buffer The buffer that contains one @ref DispatchIndirectArguments record.
+            //! @param[in] offset The offset, in bytes, of the record in `buffer`.
+            //! @par Valid Usage
+            //! * `buffer` must be created with @ref BufferUsageFlag::indirect_buffer, and must be in 
+            //! @ref BufferStateFlag::indirect_argument state.
+            virtual void dispatch_indirect(IBuffer* buffer, u64 offset) = 0;
+
+            //! Builds or updates one acceleration structure.
+            //! @param[in] dst The acceleration structure to build.
+            //! @param[in] inputs The build inputs.
+            //! @param[in] scratch_buffer The scratch buffer used to build the acceleration structure.
+            //! @param[in] scratch_buffer_offset The offset, in bytes, of the scratch buffer range from the beginning of `scratch_buffer`.
+            //! @param[in] update_src If not `nullptr`, updates (refits) `update_src` with new vertex positions or instance data in `inputs`,
+            //! and writes the result to `dst`. `update_src` may be equal to `dst` to update the acceleration structure in place.
+            //! @details The command buffer inserts one barrier after every build, so that the built acceleration structure can be used by
+            //! succeeding builds and ray queries in succeeding dispatches and draws without additional barriers.
+            //! @par Valid Usage
+            //! * @ref DeviceFeature::ray_tracing must be supported.
+            //! * `dst` must have the same type as `inputs.type`, and its size must not be smaller than the size returned by 
+            //! @ref IDevice::get_acceleration_structure_sizes for `inputs`.
+            //! * Vertex, index and instance buffers in `inputs` must be in @ref BufferStateFlag::acceleration_structure_build_input state.
+            //! * `scratch_buffer` must be created with @ref BufferUsageFlag::acceleration_structure_scratch, must be in 
+            //! @ref BufferStateFlag::acceleration_structure_scratch state, and the scratch range must not be smaller than the build or 
+            //! update scratch size returned by @ref IDevice::get_acceleration_structure_sizes. `scratch_buffer_offset` must be aligned to
+            //! @ref AccelerationStructureSizes::scratch_alignment.
+            //! * If `update_src` is not `nullptr`, `update_src` must be built with @ref AccelerationStructureBuildFlag::allow_update, and
+            //! `inputs` must have the same flags, geometries and the same number of primitives as the inputs used to build `update_src`.
+            virtual void build_acceleration_structure(IAccelerationStructure* dst, const AccelerationStructureBuildInputs& inputs,
+                IBuffer* scratch_buffer, u64 scratch_buffer_offset, IAccelerationStructure* update_src = nullptr) = 0;
+
             //! Ends a compute pass.
             virtual void end_compute_pass() = 0;
 
@@ -786,6 +1069,10 @@ namespace Luna
             //! Issues one resource barrier that synchronizes GPU pipeline access to multiple resources.
             //! @param[in] buffer_barriers The buffer barriers to submitl.
             //! @param[in] texture_barriers The texture barriers to submit.
+            //! @remark Barriers are not recorded immediately, but are deferred until the next command that accesses resources
+            //! (draw, dispatch, copy and beginning of one render pass) or submission. Barriers issued by successive calls are
+            //! merged into one native barrier call, transitions of one resource between two accesses are merged into one transition,
+            //! and transitions that do not change the resource state and only synchronize read accesses are removed.
             virtual void resource_barrier(Span<const BufferBarrier> buffer_barriers, Span<const TextureBarrier> texture_barriers) = 0;
 
             //! Submits the recorded commands in this command buffer to the attached command queue.
@@ -797,6 +1084,15 @@ namespace Luna
             //! from host side. If this is `false`, the command buffer cannot be waited from host, and the behavior of 
             //! calling @ref ICommandBuffer::wait is undefined. Setting this to `false` may improve queue performance, and 
             //! the command buffer can still be waited by other command buffers using fences.
+            //! @param[in] wait_values The values to wait for fences in `wait_fences`. If not empty, this must have the same number of
+            //! elements as `wait_fences`, and every @ref FenceType::timeline fence waits until its value is greater than or equal to the
+            //! value of the same index. Values for @ref FenceType::binary fences are ignored.
+            //! @param[in] signal_values The values to set to fences in `signal_fences`. If not empty, this must have the same number of
+            //! elements as `signal_fences`, and every @ref FenceType::timeline fence is set to the value of the same index. Values for
+            //! @ref FenceType::binary fences are ignored.
+            //! @par Valid Usage
+            //! * If `wait_fences` contains timeline fences, `wait_values` must not be empty.
+            //! * If `signal_fences` contains timeline fences, `signal_values` must not be empty.
             //! 
             //! @remark Command buffers submitted to the same command queue are processed by their submission order without overlapping, so
             //! that one command buffer will not be executed until all previous command buffers in the same command queue are 
@@ -804,7 +1100,8 @@ namespace Luna
             //! 
             //! If `signal_fences` is not empty, the system guarantees that all commands in the submission is finished, and all 
             //! writes to the memory in the submission is made visible before fences are signaled.
-            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting) = 0;
+            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting,
+                Span<const u64> wait_values = {}, Span<const u64> signal_values = {}) = 0;
         };
 
         //! @}
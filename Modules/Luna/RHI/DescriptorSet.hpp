@@ -10,6 +10,7 @@
 #pragma once
 #include "PipelineState.hpp"
 #include "Buffer.hpp"
+#include "AccelerationStructure.hpp"
 #include <Luna/Runtime/Math/Vector.hpp>
 #ifndef LUNA_RHI_API
 #define LUNA_RHI_API
@@ -361,6 +362,10 @@ namespace Luna
                 //! This array must have at least `num_descs` elements, and will be used 
                 //! if `type` is @ref DescriptorType::sampler.
                 const SamplerDesc* samplers;
+                //! The pointer to top-level acceleration structures array to be written.
+                //! This array must have at least `num_descs` elements, and will be used 
+                //! if `type` is @ref DescriptorType::acceleration_structure.
+                IAccelerationStructure* const* acceleration_structures;
             };
             
             static WriteDescriptorSet uniform_buffer_view(u32 binding_slot, const BufferViewDesc& desc)
@@ -483,6 +488,26 @@ namespace Luna
                 ret.samplers = descs.data();
                 return ret;
             }
+            static WriteDescriptorSet acceleration_structure(u32 binding_slot, IAccelerationStructure* const& acceleration_structure)
+            {
+                WriteDescriptorSet ret;
+                ret.binding_slot = binding_slot;
+                ret.first_array_index = 0;
+                ret.type = DescriptorType::acceleration_structure;
+                ret.num_descs = 1;
+                ret.acceleration_structures = &acceleration_structure;
+                return ret;
+            }
+            static WriteDescriptorSet acceleration_structure_array(u32 binding_slot, u32 first_array_index, Span<IAccelerationStructure* const> acceleration_structures)
+            {
+                WriteDescriptorSet ret;
+                ret.binding_slot = binding_slot;
+                ret.first_array_index = first_array_index;
+                ret.type = DescriptorType::acceleration_structure;
+                ret.num_descs = (u32)acceleration_structures.size();
+                ret.acceleration_structures = acceleration_structures.data();
+                return ret;
+            }
         };
 
         //! @interface IDescriptorSet
@@ -499,6 +524,36 @@ namespace Luna
             virtual RV update_descriptors(Span<const WriteDescriptorSet> writes) = 0;
         };
 
+        //! @interface IDescriptorSetArena
+        //! Represents one linear allocator that allocates transient descriptor sets.
+        //! @details Descriptor sets allocated from one arena are not freed individually, instead, all descriptor sets
+        //! allocated from the arena are freed together when @ref reset is called. This makes allocating descriptor sets 
+        //! that are used only in one frame much cheaper than @ref IDevice::new_descriptor_set, since the arena allocates descriptors 
+        //! from its own descriptor memory without locking device-wide descriptor pools.
+        //! 
+        //! The typical usage is to create one arena for every command buffer or every frame in flight, allocate descriptor sets
+        //! from the arena when recording commands, and reset the arena after the fence of the frame is signaled.
+        //! 
+        //! Descriptor set arenas are not thread-safe, the user should create one arena for every thread that allocates descriptor sets.
+        struct IDescriptorSetArena : virtual IDeviceChild
+        {
+            luiid("{7C3A9E15-2B84-4D6F-A0C1-E95F3B7D2846}");
+
+            //! Allocates one descriptor set from this arena.
+            //! @param[in] desc The descriptor object.
+            //! @return Returns the allocated descriptor set object.
+            //! @par Valid Usage
+            //! * The allocated descriptor set must not be used after @ref reset is called, even if the descriptor set object 
+            //! is still alive.
+            virtual R<Ref<IDescriptorSet>> new_descriptor_set(const DescriptorSetDesc& desc) = 0;
+
+            //! Frees all descriptor sets allocated from this arena, so that the descriptor memory can be reused.
+            //! @par Valid Usage
+            //! * All command buffers that use descriptor sets allocated from this arena must be finished by GPU before 
+            //! this is called.
+            virtual void reset() = 0;
+        };
+
         //! @}
     }
 }
\ No newline at end of file
@@ -57,6 +57,12 @@ namespace Luna
             //! Specifies one sampler.
             //! This descriptor is supported in all shaders.
             sampler,
+            //! Specifies one top-level acceleration structure, which allows tracing rays using ray queries.
+            //! This descriptor is supported in all shaders, and requires @ref DeviceFeature::ray_tracing.
+            //! 
+            //! To represent one acceleration structure, use the following parameter types in shader source code with register type `t`:
+            //! * RaytracingAccelerationStructure
+            acceleration_structure,
         };
 
         //! Specifies the texture view type, which is how render pipeline interprets texture data.
@@ -94,8 +100,12 @@ namespace Luna
             pixel = 0x02,
             //! The compute shader can access descriptors in the specified binding.
             compute = 0x04,
+            //! The mesh shader can access descriptors in the specified binding.
+            mesh = 0x08,
+            //! The amplification shader can access descriptors in the specified binding.
+            amplification = 0x10,
             //! All shaders can access descriptors in the specified binding.
-            all = vertex | pixel | compute
+            all = vertex | pixel | compute | mesh | amplification
         };
 
         //! Describes one binding in one descriptor set.
@@ -187,6 +197,16 @@ namespace Luna
                 r.shader_visibility_flags = shader_visibility_flags;
                 return r;
             }
+            static DescriptorSetLayoutBinding acceleration_structure(u32 binding_slot, u32 num_descs, ShaderVisibilityFlag shader_visibility_flags)
+            {
+                DescriptorSetLayoutBinding r;
+                r.binding_slot = binding_slot;
+                r.num_descs = num_descs;
+                r.type = DescriptorType::acceleration_structure;
+                r.texture_view_type = TextureViewType::unspecified;
+                r.shader_visibility_flags = shader_visibility_flags;
+                return r;
+            }
         };
 
         //! Specifies additional flags for one descriptor set layout.
@@ -196,6 +216,10 @@ namespace Luna
             //! Enable variable-sized descriptors array for the last binding (the binding with 
             //! the largest `binding_slot` value).
             variable_descriptors = 1,
+            //! Allow descriptors in the descriptor set to be left unwritten if they are not accessed by shaders.
+            //! This is required if shaders index descriptor arrays dynamically and only some elements of the array 
+            //! are written.
+            partially_bound = 2,
         };
 
         //! Specifies one descriptor set layout.
@@ -11,16 +11,24 @@
 #include "PipelineLayout.hpp"
 #include "PipelineState.hpp"
 #include "DescriptorSet.hpp"
+#include "BindlessResourceTable.hpp"
+#include "UploadRingBuffer.hpp"
 #include "CommandBuffer.hpp"
 #include "SwapChain.hpp"
 #include "Fence.hpp"
 #include "QueryHeap.hpp"
 #include "Adapter.hpp"
+#include <Luna/Runtime/Event.hpp>
+#include <Luna/Runtime/Profiler.hpp>
 
 #ifndef LUNA_RHI_API
 #define LUNA_RHI_API
 #endif
 
+#if (defined(LUNA_ENABLE_RHI_PROFILER) || (LUNA_DEBUG_LEVEL >= LUNA_DEBUG_LEVEL_PROFILE))
+#define LUNA_RHI_PROFILER_ENABLED
+#endif
+
 namespace Luna
 {
     namespace RHI
@@ -37,6 +45,25 @@ namespace Luna
             pixel_shader_write,
             //! The alignment requiremtn for the buffer data start location and size.
             uniform_buffer_data_alignment,
+            //! Allow specifying `count_buffer` when calling @ref ICommandBuffer::draw_indirect and
+            //! @ref ICommandBuffer::draw_indexed_indirect.
+            indirect_draw_count,
+            //! Allow creating fences with @ref FenceType::timeline.
+            timeline_fence,
+            //! Allow creating mesh pipeline states using @ref IDevice::new_mesh_pipeline_state and calling 
+            //! @ref ICommandBuffer::dispatch_mesh.
+            mesh_shader,
+            //! Allow creating and building acceleration structures, and tracing rays against acceleration structures using ray queries
+            //! in shaders.
+            ray_tracing,
+            //! Allow calling @ref ICommandBuffer::set_shading_rate to set per-draw shading rates.
+            variable_rate_shading,
+            //! The tile size, in pixels, of every texel in the shading rate image. If this is 0, shading rate images 
+            //! (@ref RenderPassDesc::shading_rate_image) are not supported.
+            shading_rate_image_tile_size,
+            //! Allow creating reserved resources using @ref IDevice::new_reserved_buffer and @ref IDevice::new_reserved_texture,
+            //! and mapping their tiles using @ref IDevice::update_tile_mappings.
+            reserved_resources,
         };
 
         //! Represents the device feature check result.
@@ -50,6 +77,20 @@ namespace Luna
                 bool pixel_shader_write;
                 //! The feature check result of @ref DeviceFeature::uniform_buffer_data_alignment.
                 u32 uniform_buffer_data_alignment;
+                //! The feature check result of @ref DeviceFeature::indirect_draw_count.
+                bool indirect_draw_count;
+                //! The feature check result of @ref DeviceFeature::timeline_fence.
+                bool timeline_fence;
+                //! The feature check result of @ref DeviceFeature::mesh_shader.
+                bool mesh_shader;
+                //! The feature check result of @ref DeviceFeature::ray_tracing.
+                bool ray_tracing;
+                //! The feature check result of @ref DeviceFeature::variable_rate_shading.
+                bool variable_rate_shading;
+                //! The feature check result of @ref DeviceFeature::shading_rate_image_tile_size.
+                u32 shading_rate_image_tile_size;
+                //! The feature check result of @ref DeviceFeature::reserved_resources.
+                bool reserved_resources;
             };
         };
 
@@ -86,7 +127,67 @@ namespace Luna
                 flags(flags) {}
         };
 
+        //! Describes memory usage and budget of one memory heap of the device.
+        struct MemoryHeapBudget
+        {
+            //! The number of bytes of memory blocks allocated from this heap by the device. Resources are suballocated from memory blocks,
+            //! so some bytes may not be occupied by any resource.
+            u64 block_bytes = 0;
+            //! The number of bytes of memory occupied by resources and device memory objects in this heap.
+            u64 allocation_bytes = 0;
+            //! The number of bytes of memory of this heap currently used by the process, including memory allocated by the platform
+            //! and other libraries.
+            u64 usage = 0;
+            //! The number of bytes of memory of this heap that the process can use without degrading performance. `usage` may exceed this
+            //! value, in which case the system may start demoting or paging out memory of the process.
+            u64 budget = 0;
+        };
+
+        //! Describes memory usage and budget of one device.
+        struct DeviceMemoryBudget
+        {
+            //! The budget of the memory that is local to the device (video memory). On devices with unified memory architecture,
+            //! this is the budget of the whole memory.
+            MemoryHeapBudget local;
+            //! The budget of the memory that is not local to the device but can be accessed by the device (system memory).
+            //! On devices with unified memory architecture, all fields are `0`.
+            MemoryHeapBudget non_local;
+        };
+
+        //! The statistics of objects created by one device.
+        //! @details Counters are accumulated from the time the device is created. The user can compute per-frame values 
+        //! by computing differences between two snapshots, which can be used to catch per-frame allocation regressions.
+        struct DeviceStatistics
+        {
+            //! The number of buffers created, including aliasing and reserved buffers.
+            u64 num_buffers_created = 0;
+            //! The number of buffers destroyed.
+            u64 num_buffers_destroyed = 0;
+            //! The number of textures created, including aliasing and reserved textures and back buffers of swap chains.
+            u64 num_textures_created = 0;
+            //! The number of textures destroyed.
+            u64 num_textures_destroyed = 0;
+            //! The number of bytes of device memory allocated for every memory type, indexed by @ref MemoryType.
+            //! This includes memory allocated for committed resources, @ref IDevice::allocate_memory and @ref IDevice::allocate_tile_memory.
+            u64 allocated_bytes[3] = { 0, 0, 0 };
+            //! The number of bytes of device memory freed for every memory type, indexed by @ref MemoryType.
+            u64 freed_bytes[3] = { 0, 0, 0 };
+            //! The number of descriptor sets created by @ref IDevice::new_descriptor_set. Descriptor sets allocated from 
+            //! descriptor set arenas are not included.
+            u64 num_descriptor_sets_created = 0;
+            //! The number of descriptors written by @ref IDescriptorSet::update_descriptors.
+            u64 num_descriptor_writes = 0;
+            //! The number of pipeline states created.
+            u64 num_pipeline_states_created = 0;
+            //! The number of command buffers submitted.
+            u64 num_command_buffers_submitted = 0;
+        };
+
         struct IAdapter;
+        struct IDevice;
+
+        //! The handler for memory budget change event.
+        using memory_budget_change_event_handler_t = void(IDevice* device, const DeviceMemoryBudget& budget);
 
         //! @interface IDevice
         //! Represents one logical graphic device on the platform.
@@ -162,21 +263,127 @@ namespace Luna
             //! @return Returns the created texture object.
             virtual R<Ref<ITexture>> new_aliasing_texture(IDeviceMemory* device_memory, const TextureDesc& desc, const ClearValue* optimized_clear_value = nullptr) = 0;
 
+            //! Creates one reserved buffer, which reserves address space for the buffer without allocating memory for it.
+            //! @details Memory of reserved buffers are mapped in tiles of @ref RESERVED_RESOURCE_TILE_SIZE bytes by @ref update_tile_mappings. 
+            //! Tiles that are not mapped must not be accessed by GPU.
+            //! @param[in] desc The descriptor object.
+            //! @return Returns the created buffer object. Returns @ref BasicError::not_supported if 
+            //! @ref DeviceFeature::reserved_resources is not supported.
+            virtual R<Ref<IBuffer>> new_reserved_buffer(const BufferDesc& desc) = 0;
+
+            //! Creates one reserved texture, which reserves address space for the texture without allocating memory for it.
+            //! @details Memory of reserved textures are mapped in tiles by @ref update_tile_mappings. Call @ref get_reserved_texture_tiling
+            //! to get the tile shape of the texture. Tiles that are not mapped must not be accessed by GPU, shaders can use
+            //! one feedback buffer to record tiles that are requested but not mapped, so that they can be mapped in later frames.
+            //! @param[in] desc The descriptor object. The texture must be one 2D texture that is not multi-sampled, and cannot be used
+            //! as color or depth stencil attachments.
+            //! @return Returns the created texture object. Returns @ref BasicError::not_supported if 
+            //! @ref DeviceFeature::reserved_resources is not supported or the texture cannot be reserved on this platform.
+            virtual R<Ref<ITexture>> new_reserved_texture(const TextureDesc& desc) = 0;
+
+            //! Gets the tile layout of one reserved texture.
+            //! @param[in] texture The reserved texture created by @ref new_reserved_texture.
+            //! @return Returns the tile layout of the texture.
+            virtual ReservedTextureTiling get_reserved_texture_tiling(ITexture* texture) = 0;
+
+            //! Allocates device memory that can be mapped to tiles of reserved resources.
+            //! @param[in] num_tiles The number of tiles to allocate. The memory size is `num_tiles * RESERVED_RESOURCE_TILE_SIZE`.
+            //! @return Returns the allocated memory. Returns @ref BasicError::not_supported if 
+            //! @ref DeviceFeature::reserved_resources is not supported.
+            virtual R<Ref<IDeviceMemory>> allocate_tile_memory(u32 num_tiles) = 0;
+
+            //! Updates tile mappings of one reserved resource.
+            //! @details The update is performed on the specified command queue, and is visible to command buffers submitted to 
+            //! the same command queue after this call returns. The user must ensure that tiles being remapped are not accessed by GPU 
+            //! when the update is performed.
+            //! @param[in] command_queue_index The index of the command queue to perform the update.
+            //! @param[in] resource The reserved buffer or texture to update.
+            //! @param[in] mappings The tile mappings to update.
+            virtual RV update_tile_mappings(u32 command_queue_index, IResource* resource, Span<const TileMapping> mappings) = 0;
+
+            //! Gets memory sizes required to build one acceleration structure.
+            //! @param[in] inputs The build inputs. Only the type, flags, the number of geometries, vertices, indices and instances
+            //! and formats are used, buffers are not accessed.
+            //! @return Returns the memory sizes required to build the acceleration structure. Builds and updates using inputs with
+            //! the same or fewer primitives can use the same sizes.
+            //! @par Valid Usage
+            //! * @ref DeviceFeature::ray_tracing must be supported.
+            virtual AccelerationStructureSizes get_acceleration_structure_sizes(const AccelerationStructureBuildInputs& inputs) = 0;
+
+            //! Creates one new acceleration structure.
+            //! @param[in] desc The descriptor object. Use @ref get_acceleration_structure_sizes to query the size.
+            //! @return Returns the created acceleration structure. The acceleration structure is not usable until it is built by 
+            //! @ref ICommandBuffer::build_acceleration_structure. Returns @ref BasicError::not_supported if 
+            //! @ref DeviceFeature::ray_tracing is not supported.
+            virtual R<Ref<IAccelerationStructure>> new_acceleration_structure(const AccelerationStructureDesc& desc) = 0;
+
+            //! Gets the current memory usage and budget of this device.
+            //! @details The user may query the budget periodically (for example, once per frame) to decide whether to stream in more
+            //! resources or evict unused resources, so that the memory usage of the application stays within the budget.
+            //! @return Returns the memory usage and budget of this device.
+            virtual DeviceMemoryBudget get_memory_budget() = 0;
+
+            //! Gets the memory budget change event of this device.
+            //! @details This event is emitted by @ref update_memory_budget when the budget of one memory heap reported by the system changes,
+            //! or when the memory usage of one heap exceeds its budget or falls back below its budget.
+            //! @return Returns one reference of the event object.
+            virtual Event<memory_budget_change_event_handler_t>& get_memory_budget_change_event() = 0;
+
+            //! Fetches the latest memory budget from the system, and emits the memory budget change event if the budget changes.
+            //! @details The user should call this periodically (for example, once per frame), so that the application can respond to budget 
+            //! changes, like streaming out unused resources, before the system starts paging memory of the application.
+            //! @remark This function is not thread-safe. It should be called from the thread that registers handlers of the memory
+            //! budget change event.
+            virtual void update_memory_budget() = 0;
+
             //! Creates one new pipeline layout.
             //! @param[in] desc The descriptor object.
             //! @return Returns the created pipeline layout object.
             virtual R<Ref<IPipelineLayout>> new_pipeline_layout(const PipelineLayoutDesc& desc) = 0;
 
+            //! Creates one new pipeline cache.
+            //! @param[in] initial_data The initial data of the pipeline cache, which is fetched by @ref IPipelineCache::get_data 
+            //! previously. Specify one empty span to create one empty pipeline cache. If the initial data is not compatible with the 
+            //! current device or driver, the data will be discarded and one empty pipeline cache will be created.
+            //! @return Returns the created pipeline cache object.
+            virtual R<Ref<IPipelineCache>> new_pipeline_cache(Span<const byte_t> initial_data) = 0;
+
             //! Creates one new graphic pipeline state.
             //! @param[in] desc The descriptor object.
             //! @return Returns the created graphic pipeline state object.
+            //! @remark This function is thread-safe, multiple pipeline states can be created from multiple threads concurrently.
             virtual R<Ref<IPipelineState>> new_graphics_pipeline_state(const GraphicsPipelineStateDesc& desc) = 0;
 
             //! Creates one compute pipeline state.
             //! @param[in] desc The descriptor object.
             //! @return Returns the created compute pipeline state object.
+            //! @remark This function is thread-safe, multiple pipeline states can be created from multiple threads concurrently.
             virtual R<Ref<IPipelineState>> new_compute_pipeline_state(const ComputePipelineStateDesc& desc) = 0;
 
+            //! Creates one mesh pipeline state.
+            //! @param[in] desc The descriptor object.
+            //! @return Returns the created mesh pipeline state object. Returns @ref BasicError::not_supported if 
+            //! @ref DeviceFeature::mesh_shader is not supported.
+            //! @remark This function is thread-safe, multiple pipeline states can be created from multiple threads concurrently.
+            virtual R<Ref<IPipelineState>> new_mesh_pipeline_state(const MeshPipelineStateDesc& desc) = 0;
+
+            //! Creates one new graphic pipeline state asynchronously.
+            //! @details The pipeline state is created by one job system worker thread with @ref JobSystem::JobPriority::background
+            //! priority, so that the user can keep rendering with one fallback pipeline state until the request is finished.
+            //! @param[in] desc The descriptor object. All data referred by the descriptor object is copied, so the user can release 
+            //! such data after this function returns.
+            //! @return Returns the request object that can be used to wait for and fetch the created pipeline state.
+            //! @remark This function is thread-safe.
+            virtual Ref<IPipelineStateRequest> new_graphics_pipeline_state_async(const GraphicsPipelineStateDesc& desc) = 0;
+
+            //! Creates one new compute pipeline state asynchronously.
+            //! @details See @ref new_graphics_pipeline_state_async for details.
+            //! @param[in] desc The descriptor object. All data referred by the descriptor object is copied, so the user can release 
+            //! such data after this function returns.
+            //! @return Returns the request object that can be used to wait for and fetch the created pipeline state.
+            //! @remark This function is thread-safe.
+            virtual Ref<IPipelineStateRequest> new_compute_pipeline_state_async(const ComputePipelineStateDesc& desc) = 0;
+
             //! Creates one new descriptor set layout object that can be used to create descriptor sets.
             //! @param[in] desc The descriptor object.
             //! @return Returns the created descriptor set layout object.
@@ -187,6 +394,22 @@ namespace Luna
             //! @return Returns the created descriptor set object.
             virtual R<Ref<IDescriptorSet>> new_descriptor_set(const DescriptorSetDesc& desc) = 0;
 
+            //! Creates one new descriptor set arena that can be used to allocate transient descriptor sets.
+            //! @return Returns the created descriptor set arena object.
+            virtual R<Ref<IDescriptorSetArena>> new_descriptor_set_arena() = 0;
+
+            //! Creates one new bindless resource table that can be used to access resources by indices in shaders.
+            //! @param[in] desc The descriptor object.
+            //! @return Returns the created bindless resource table object.
+            //! @par Valid Usage
+            //! * @ref DeviceFeature::unbound_descriptor_array must be supported by the device.
+            virtual R<Ref<IBindlessResourceTable>> new_bindless_resource_table(const BindlessResourceTableDesc& desc) = 0;
+
+            //! Creates one new upload ring buffer that can be used to allocate transient upload data every frame.
+            //! @param[in] desc The descriptor object.
+            //! @return Returns the created upload ring buffer object.
+            virtual R<Ref<IUploadRingBuffer>> new_upload_ring_buffer(const UploadRingBufferDesc& desc) = 0;
+
             //! Gets the number of command queues of the device.
             //! @return Returns the number of command queues of the device.
             virtual u32 get_num_command_queues() = 0;
@@ -206,6 +429,19 @@ namespace Luna
             //! * `command_queue_index` must be in range [`0`, `get_num_command_queues()`).
             virtual R<Ref<ICommandBuffer>> new_command_buffer(u32 command_queue_index) = 0;
 
+            //! Creates one secondary command buffer that records render pass commands in parallel with other command buffers.
+            //! @param[in] command_queue_index The index of the command queue of the primary command buffers that execute 
+            //! this command buffer.
+            //! @return Returns the created command buffer object.
+            //! @details Secondary command buffers cannot be submitted directly, they can only be recorded in render passes begun by
+            //! @ref ICommandBuffer::begin_parallel_render_pass, and are executed by primary command buffers. Every secondary command 
+            //! buffer owns its command allocator, so multiple secondary command buffers can be recorded by multiple threads concurrently.
+            //! See @ref ICommandBuffer::begin_parallel_render_pass for details.
+            //! @par Valid Usage
+            //! * `command_queue_index` must be in range [`0`, `get_num_command_queues()`).
+            //! * The command queue specified by `command_queue_index` must be one graphics queue.
+            virtual R<Ref<ICommandBuffer>> new_secondary_command_buffer(u32 command_queue_index) = 0;
+
             //! Gets the GPU timestamp frequency of the specified command queue. 
             //! The timestamp frequency is measured in ticks per second.
             //! @param[in] command_queue_index The index of the command queue to check.
@@ -220,8 +456,12 @@ namespace Luna
             virtual R<Ref<IQueryHeap>> new_query_heap(const QueryHeapDesc& desc) = 0;
 
             //! Creates one new fence that can be used to synchronize execution of multiple command buffers.
+            //! @param[in] type The type of the fence.
+            //! @param[in] initial_value The initial value of the fence. This is used only if `type` is @ref FenceType::timeline.
             //! @return Returns the created fence object.
-            virtual R<Ref<IFence>> new_fence() = 0;
+            //! @par Valid Usage
+            //! * If `type` is @ref FenceType::timeline, @ref DeviceFeature::timeline_fence must be supported.
+            virtual R<Ref<IFence>> new_fence(FenceType type = FenceType::binary, u64 initial_value = 0) = 0;
 
             //! Creates one swap chain and binds it to the specified window.
             //! @param[in] command_queue_index The command queue attached to the swap chain. Present commands will only be 
@@ -233,8 +473,58 @@ namespace Luna
             //! * `command_queue_index` must be in range [`0`, `get_num_command_queues()`).
             //! * The swap chain specified by `command_queue_index` must have @ref CommandQueueFlag::presenting being set.
             virtual R<Ref<ISwapChain>> new_swap_chain(u32 command_queue_index, Window::IWindow* window, const SwapChainDesc& desc) = 0;
+
+            //! Gets the statistics of objects created by this device.
+            //! @return Returns the statistics of this device.
+            //! @remark Counters are updated by multiple threads using atomic operations, so the returned values may be slightly outdated.
+            virtual DeviceStatistics get_statistics() = 0;
         };
 
+        //! Profiler event IDs emitted by the RHI module.
+        //! @remark RHI profiler events are only emitted if `LUNA_RHI_PROFILER_ENABLED` is defined, which is defined
+        //! in debug and profile builds, or when `LUNA_ENABLE_RHI_PROFILER` is defined. @ref IDevice::get_statistics and 
+        //! @ref ICommandBuffer::get_statistics are always available.
+        namespace ProfilerEventId
+        {
+            //! Emitted when one command buffer is submitted. The event data is @ref ProfilerEventData::CommandBufferSubmit.
+            constexpr u64 COMMAND_BUFFER_SUBMIT = strhash64("RHI_COMMAND_BUFFER_SUBMIT");
+            //! Emitted when one device memory block is allocated. The event data is @ref ProfilerEventData::DeviceMemoryAllocate.
+            constexpr u64 DEVICE_MEMORY_ALLOCATE = strhash64("RHI_DEVICE_MEMORY_ALLOCATE");
+            //! Emitted when one device memory block is freed. The event data is @ref ProfilerEventData::DeviceMemoryFree.
+            constexpr u64 DEVICE_MEMORY_FREE = strhash64("RHI_DEVICE_MEMORY_FREE");
+        }
+        namespace ProfilerEventData
+        {
+            //! The command buffer submit event data.
+            struct CommandBufferSubmit
+            {
+                //! The submitted command buffer.
+                ICommandBuffer* command_buffer;
+                //! The statistics of the submitted command buffer.
+                CommandBufferStatistics statistics;
+            };
+            //! The device memory allocate event data.
+            struct DeviceMemoryAllocate
+            {
+                //! The device that allocates the memory.
+                IDevice* device;
+                //! The memory type.
+                MemoryType memory_type;
+                //! The number of bytes allocated.
+                u64 size;
+            };
+            //! The device memory free event data.
+            struct DeviceMemoryFree
+            {
+                //! The device that frees the memory.
+                IDevice* device;
+                //! The memory type.
+                MemoryType memory_type;
+                //! The number of bytes freed.
+                u64 size;
+            };
+        }
+
         //! Creates one device using the specified adapter.
         //! @param[in] adapter The adapter used for creating the device.
         //! @return Returns the created device object.
@@ -16,6 +16,17 @@ namespace Luna
         //! @addtogroup RHI
         //! @{
         
+        //! Specifies the type of one fence.
+        enum class FenceType : u8
+        {
+            //! The fence has two states: signaled and unsignaled. Signal and wait operations on the fence must occur in 1:1 pairs.
+            binary = 0,
+            //! The fence has one 64-bit unsigned integer value that increases monotonically. Signal operations set the fence value,
+            //! and wait operations wait until the fence value is greater than or equal to the specified value.
+            //! Creating timeline fences requires @ref DeviceFeature::timeline_fence.
+            timeline = 1,
+        };
+
         //! @interface IFence
         //! Represents a synchronization object that can be used to synchronize commands executed in different command queues.
         //! @details A fence is a synchronization primitive that can be used to insert a dependency between queue operations. 
@@ -30,10 +41,37 @@ namespace Luna
         //! the user must ensure that signal operations and wait operations on the same fence should occur in discrete 1:1 pairs 
         //! (every two signal operations should have one wait operations in between, every two wait operations should one signal 
         //! operations in between).
+        //!
+        //! The behavior above applies to @ref FenceType::binary fences. @ref FenceType::timeline fences hold one 64-bit value instead, 
+        //! every signal operation sets the fence value to the value specified by the operation, and every wait operation waits until the 
+        //! fence value is greater than or equal to the value specified by the operation without changing the fence value. 
+        //! Timeline fences can be signaled and waited any number of times, and can also be signaled and waited from host, so one timeline 
+        //! fence can track the progress of all work submitted to one command queue: for example, signaling the frame index 
+        //! when submitting every frame, then resources used by one frame can be reclaimed when @ref get_completed_value is not
+        //! less than the frame index.
         struct IFence : virtual IDeviceChild
         {
             luiid("{126700A9-A8CC-45FE-AC5F-C68879B8D7FD}");
 
+            //! Gets the type of this fence.
+            virtual FenceType get_type() = 0;
+
+            //! Gets the current value of this fence.
+            //! @return Returns the current value of this fence. Returns `0` if this is not one @ref FenceType::timeline fence.
+            virtual u64 get_completed_value() = 0;
+
+            //! Blocks the current thread until the value of this fence is greater than or equal to the specified value.
+            //! @param[in] value The value to wait for.
+            //! @par Valid Usage
+            //! * This fence must be one @ref FenceType::timeline fence.
+            virtual RV wait(u64 value) = 0;
+
+            //! Sets the value of this fence from host.
+            //! @param[in] value The value to set. 
+            //! @par Valid Usage
+            //! * This fence must be one @ref FenceType::timeline fence.
+            //! * `value` must be greater than the current value of this fence and values of all pending signal operations of this fence.
+            virtual RV signal(u64 value) = 0;
         };
 
         //! @}
@@ -0,0 +1,45 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file PipelineCache.hpp
+* @author JXMaster
+* @date 2024/3/30
+*/
+#pragma once
+#include "DeviceChild.hpp"
+#include <Luna/Runtime/Blob.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! @addtogroup RHI
+        //! @{
+
+        //! @interface IPipelineCache
+        //! Represents one pipeline cache that stores compiled pipeline states, so that creating the same
+        //! pipeline state again can skip shader compilation.
+        //! @details The pipeline cache is implemented using `VkPipelineCache` on Vulkan, `ID3D12PipelineLibrary` on 
+        //! Direct3D 12 and `MTLBinaryArchive` on Metal. The user can specify one pipeline cache when creating pipeline states 
+        //! by setting @ref GraphicsPipelineStateDesc::pipeline_cache or @ref ComputePipelineStateDesc::pipeline_cache, 
+        //! pipeline states created in this way will be looked up from and added to the pipeline cache.
+        //! 
+        //! The pipeline cache data can be fetched by @ref get_data and saved to disk, and can be used to 
+        //! initialize the pipeline cache by @ref IDevice::new_pipeline_cache the next time the application starts.
+        //! 
+        //! Pipeline caches are thread-safe, one pipeline cache can be used to create pipeline states from multiple threads.
+        struct IPipelineCache : virtual IDeviceChild
+        {
+            luiid("{2B2D4C7A-8E6F-4D4B-9C1B-53A6E1F2D9A4}");
+
+            //! Gets the serialized data of the pipeline cache.
+            //! @return Returns the serialized data of the pipeline cache. The data contains all pipeline states 
+            //! created using this cache and pipeline states loaded from the initial data.
+            virtual R<Blob> get_data() = 0;
+        };
+
+        //! @}
+    }
+}
@@ -31,6 +31,15 @@ namespace Luna
             deny_pixel_shader_access = 0x04,
         };
 
+        //! The maximum number of 32-bit pipeline constants that can be specified in one pipeline layout.
+        constexpr u32 MAX_PIPELINE_CONSTANTS = 32;
+
+        //! The register space of pipeline constants in HLSL.
+        //! @details Pipeline constants should be declared as `[[vk::push_constant]] ConstantBuffer<T> name : register(b0, space15);`
+        //! in HLSL, see `Luna/RHI/Shaders/PipelineConstants.hlsl`. On Metal, pipeline constants are bound to buffer slot 15, so
+        //! pipeline layouts with constants can have at most 15 descriptor sets.
+        constexpr u32 PIPELINE_CONSTANTS_REGISTER_SPACE = 15;
+
         //! Describes one pipeline layout.
         struct PipelineLayoutDesc
         {
@@ -39,13 +48,27 @@ namespace Luna
             Span<IDescriptorSetLayout*> descriptor_set_layouts;
             //! Attribute flags of this pipeline layout.
             PipelineLayoutFlag flags;
+            //! The number of 32-bit constants that can be set by @ref ICommandBuffer::set_graphics_constants
+            //! or @ref ICommandBuffer::set_compute_constants. 
+            //! @details Pipeline constants are implemented using push constants on Vulkan, root constants on Direct3D 12 and 
+            //! inline constant data (`setVertexBytes`, `setFragmentBytes` and `setBytes`) on Metal, they are recorded into the 
+            //! command buffer directly, so setting them does not require updating descriptor sets.
+            //! 
+            //! This must not be greater than @ref MAX_PIPELINE_CONSTANTS.
+            u32 num_constants = 0;
+            //! The shaders that can access pipeline constants.
+            ShaderVisibilityFlag constants_shader_visibility_flags = ShaderVisibilityFlag::all;
 
             PipelineLayoutDesc() = default;
             PipelineLayoutDesc(
                 Span<IDescriptorSetLayout*> descriptor_set_layouts,
-                PipelineLayoutFlag flags = PipelineLayoutFlag::none) :
+                PipelineLayoutFlag flags = PipelineLayoutFlag::none,
+                u32 num_constants = 0,
+                ShaderVisibilityFlag constants_shader_visibility_flags = ShaderVisibilityFlag::all) :
                 descriptor_set_layouts(descriptor_set_layouts),
-                flags(flags) {}
+                flags(flags),
+                num_constants(num_constants),
+                constants_shader_visibility_flags(constants_shader_visibility_flags) {}
         };
 
         //! @interface IPipelineLayout
@@ -10,7 +10,10 @@
 #pragma once
 #include "Texture.hpp"
 #include "PipelineLayout.hpp"
+#include "PipelineCache.hpp"
 #include <Luna/Runtime/Span.hpp>
+#include <Luna/Runtime/Waitable.hpp>
+#include <Luna/Runtime/Ref.hpp>
 #include <Luna/Runtime/Math/Vector.hpp>
 namespace Luna
 {
@@ -58,6 +61,8 @@ namespace Luna
             IPipelineLayout* pipeline_layout = nullptr;
             //! The compute shader data.
             ShaderData cs;
+            //! The pipeline cache used to create this pipeline state. Specify `nullptr` to not use pipeline cache.
+            IPipelineCache* pipeline_cache = nullptr;
             //! The number of threads in one thread group in X dimension for Metal backend.
             //! @details This is used only if the RHI backend is @ref BackendType::metal, since metal shader files
             //! does not include thread group size.
@@ -513,6 +518,8 @@ namespace Luna
             InputLayoutDesc input_layout;
             //! The compatible pipeline layout configurations.
             IPipelineLayout* pipeline_layout = nullptr;
+            //! The pipeline cache used to create this pipeline state. Specify `nullptr` to not use pipeline cache.
+            IPipelineCache* pipeline_cache = nullptr;
             //! The vertex shader data.
             ShaderData vs;
             //! The pixel shader data.
@@ -541,6 +548,42 @@ namespace Luna
             u32 sample_count = 1;
         };
 
+        //! Describes pipeline configurations of one mesh pipeline, which replaces the input assembler and vertex shader stages
+        //! of the graphics pipeline with amplification and mesh shader stages.
+        //! @details Mesh pipeline states are bound using @ref ICommandBuffer::set_graphics_pipeline_state like graphics pipeline 
+        //! states, and are executed using @ref ICommandBuffer::dispatch_mesh. Creating mesh pipeline states requires @ref DeviceFeature::mesh_shader.
+        struct MeshPipelineStateDesc
+        {
+            //! The compatible pipeline layout configurations.
+            IPipelineLayout* pipeline_layout = nullptr;
+            //! The pipeline cache used to create this pipeline state. Specify `nullptr` to not use pipeline cache.
+            IPipelineCache* pipeline_cache = nullptr;
+            //! The amplification (task) shader data. Specify @ref ShaderDataFormat::none to not use amplification shader, 
+            //! in which case mesh shader thread groups are dispatched directly by @ref ICommandBuffer::dispatch_mesh.
+            ShaderData as;
+            //! The mesh shader data.
+            ShaderData ms;
+            //! The pixel shader data.
+            ShaderData ps;
+            //! The rasterizer configurations.
+            RasterizerDesc rasterizer_state;
+            //! The configurations of depth stencil stage.
+            DepthStencilDesc depth_stencil_state;
+            //! The configurations of blend stage.
+            BlendDesc blend_state;
+            //! The number of attachments that can be set. This must be a value between [`1`, `8`].
+            u8 num_color_attachments = 0;
+            //! The color attachment formats.
+            //! Only [`0`, `num_color_attachments`) elements in this array will be used, other 
+            //! elements will be ignored.
+            Format color_formats[8] = { Format::unknown };
+            //! The depth stencil attachment format.
+            //! This must be @ref Format::unknown if depth stencil attachment is not used.
+            Format depth_stencil_format = Format::unknown;
+            //! Specify the sample count. This must be `1` if MSAA is not used.
+            u32 sample_count = 1;
+        };
+
         //! @interface IPipelineState
         //! Represents one pipeline state object that stores pipeline configurations that can be 
         //! applied to one pipeline in one call.
@@ -551,6 +594,20 @@ namespace Luna
 
         };
 
+        //! @interface IPipelineStateRequest
+        //! Represents one pipeline state that is being created asynchronously.
+        //! @details The request is signaled when the pipeline state creation is finished, successfully or not.
+        struct IPipelineStateRequest : virtual IWaitable
+        {
+            luiid("{4E8B1D0A-7F26-4C93-A5E2-D0B8C61F3A57}");
+
+            //! Gets the creation result of the pipeline state.
+            //! @details This function blocks the current thread until the creation is finished. Call @ref IWaitable::try_wait 
+            //! to check whether the creation is finished without blocking.
+            //! @return Returns the created pipeline state, or the error code if the creation failed.
+            virtual R<Ref<IPipelineState>> get_result() = 0;
+        };
+
         //! @}
     }
 }
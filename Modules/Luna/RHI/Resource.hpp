@@ -47,6 +47,84 @@ namespace Luna
             bool operator==(const SubresourceIndex& rhs) const { return mip_slice == rhs.mip_slice && array_slice == rhs.array_slice; }
         };
 
+        //! The size, in bytes, of one tile of reserved resources.
+        //! @details Reserved resources are created without memory, and their memory is mapped in tiles by 
+        //! @ref IDevice::update_tile_mappings.
+        constexpr u64 RESERVED_RESOURCE_TILE_SIZE = 65536;
+
+        //! Describes the tile layout of one reserved texture.
+        struct ReservedTextureTiling
+        {
+            //! The width of one tile in texels.
+            u32 tile_width;
+            //! The height of one tile in texels.
+            u32 tile_height;
+            //! The depth of one tile in texels.
+            u32 tile_depth;
+            //! The number of mips that can be mapped in tiles. Mips in [`num_standard_mips`, `mip_levels`) are too small
+            //! to be mapped in tiles, and are packed into one mip tail that must be mapped as a whole.
+            u32 num_standard_mips;
+            //! The number of tiles used by the mip tail of one array slice. This is `0` if the texture does not have a mip tail.
+            //! If the platform uses one mip tail for all array slices, the mip tail is mapped using array slice `0` only.
+            u32 num_packed_mip_tiles;
+        };
+
+        //! Describes one tile mapping update of one reserved resource.
+        struct TileMapping
+        {
+            //! The subresource to map for textures. Ignored for buffers. 
+            //! If `subresource.mip_slice` is equal to @ref ReservedTextureTiling::num_standard_mips, 
+            //! this mapping updates the mip tail of the array slice, in which case `x` is the first tile to map
+            //! in the mip tail and `width` is the number of tiles to map.
+            SubresourceIndex subresource = SubresourceIndex(0, 0);
+            //! The X coordinate of the first tile to map, in tiles. For buffers, this is the index of the first tile to map.
+            u32 x = 0;
+            //! The Y coordinate of the first tile to map, in tiles. Ignored for buffers and mip tails.
+            u32 y = 0;
+            //! The Z coordinate of the first tile to map, in tiles. Ignored for buffers and mip tails.
+            u32 z = 0;
+            //! The number of tiles to map in X dimension. For buffers and mip tails, this is the number of tiles to map.
+            u32 width = 1;
+            //! The number of tiles to map in Y dimension. Ignored for buffers and mip tails.
+            u32 height = 1;
+            //! The number of tiles to map in Z dimension. Ignored for buffers and mip tails.
+            u32 depth = 1;
+            //! The device memory to map tiles to. The memory must be allocated by @ref IDevice::allocate_tile_memory.
+            //! Specify `nullptr` to unmap tiles.
+            IDeviceMemory* memory = nullptr;
+            //! The offset, in bytes, of the first tile in `memory`. This must be a multiple of @ref RESERVED_RESOURCE_TILE_SIZE.
+            //! Tiles of the mapped region are mapped to consecutive tiles of `memory` in X, Y, Z order.
+            u64 memory_offset = 0;
+
+            TileMapping() = default;
+            //! Creates one mapping for tiles of one buffer.
+            static TileMapping buffer(u32 first_tile, u32 num_tiles, IDeviceMemory* memory, u64 memory_offset)
+            {
+                TileMapping r;
+                r.x = first_tile;
+                r.width = num_tiles;
+                r.memory = memory;
+                r.memory_offset = memory_offset;
+                return r;
+            }
+            //! Creates one mapping for one region of tiles of one texture subresource.
+            static TileMapping texture(SubresourceIndex subresource, u32 x, u32 y, u32 z, u32 width, u32 height, u32 depth,
+                IDeviceMemory* memory, u64 memory_offset)
+            {
+                TileMapping r;
+                r.subresource = subresource;
+                r.x = x;
+                r.y = y;
+                r.z = z;
+                r.width = width;
+                r.height = height;
+                r.depth = depth;
+                r.memory = memory;
+                r.memory_offset = memory_offset;
+                return r;
+            }
+        };
+
         //! @interface IResource
         //! Represents a memory region that can be accessed by GPU.
         struct IResource : virtual IDeviceChild
@@ -54,6 +132,8 @@ namespace Luna
             luiid("{D67C47CD-1FF3-4FA4-82FE-773EC5C8AD2A}");
 
             //! Gets the device memory object that holds memory of this resource.
+            //! @return Returns the device memory object. Returns `nullptr` for reserved resources, whose memory 
+            //! is mapped in tiles by @ref IDevice::update_tile_mappings.
             virtual IDeviceMemory* get_memory() = 0;
         };
 
@@ -64,7 +144,7 @@ namespace Luna
     {
         usize operator()(const RHI::SubresourceIndex& value)
         {
-            return memhash(&value, sizeof(RHI::SubresourceIndex));
+            return (usize)wyhash(&value, sizeof(RHI::SubresourceIndex));
         }
     };
 }
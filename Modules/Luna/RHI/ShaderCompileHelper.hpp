@@ -10,6 +10,8 @@
 #pragma once
 #include "RHI.hpp"
 #include <Luna/ShaderCompiler/ShaderCompiler.hpp>
+#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Hash.hpp>
 
 namespace Luna
 {
@@ -66,6 +68,226 @@ namespace Luna
             desc.metal_numthreads_z = compile_result.metal_numthreads_z;
         }
 
+        //! Adds descriptor set layout bindings for resources accessed by one shader using shader reflection data.
+        //! @param[in] reflection The reflection data of the shader.
+        //! @param[in] shader_visibility_flags The shader visibility flags of the shader.
+        //! @param[in] set The index of the descriptor set to add bindings for. Resources in other register spaces are ignored.
+        //! @param[in,out] bindings The bindings array to add bindings to. If one binding slot is already in the array, 
+        //! `shader_visibility_flags` is added to the existing binding, so that bindings of all shaders in one pipeline can be 
+        //! merged by calling this function for every shader.
+        //! @remark Unbounded descriptor arrays are added with `num_descs` set to `0`, the user should set the maximum number of 
+        //! descriptors and @ref DescriptorSetLayoutFlag::variable_descriptors for such bindings manually.
+        inline void get_descriptor_set_layout_bindings_from_reflection(const ShaderCompiler::ShaderReflection& reflection, 
+            ShaderVisibilityFlag shader_visibility_flags, u32 set, Vector<DescriptorSetLayoutBinding>& bindings)
+        {
+            for (auto& res : reflection.resources)
+            {
+                if (res.set != set) continue;
+                bool found = false;
+                for (auto& binding : bindings)
+                {
+                    if (binding.binding_slot == res.binding)
+                    {
+                        binding.shader_visibility_flags |= shader_visibility_flags;
+                        found = true;
+                        break;
+                    }
+                }
+                if (found) continue;
+                DescriptorSetLayoutBinding binding;
+                binding.binding_slot = res.binding;
+                binding.num_descs = res.num_descs;
+                binding.shader_visibility_flags = shader_visibility_flags;
+                binding.texture_view_type = TextureViewType::unspecified;
+                switch (res.type)
+                {
+                case ShaderCompiler::ShaderResourceType::uniform_buffer: binding.type = DescriptorType::uniform_buffer_view; break;
+                case ShaderCompiler::ShaderResourceType::read_buffer: binding.type = DescriptorType::read_buffer_view; break;
+                case ShaderCompiler::ShaderResourceType::read_write_buffer: binding.type = DescriptorType::read_write_buffer_view; break;
+                case ShaderCompiler::ShaderResourceType::read_texture: binding.type = DescriptorType::read_texture_view; break;
+                case ShaderCompiler::ShaderResourceType::read_write_texture: binding.type = DescriptorType::read_write_texture_view; break;
+                case ShaderCompiler::ShaderResourceType::sampler: binding.type = DescriptorType::sampler; break;
+                case ShaderCompiler::ShaderResourceType::acceleration_structure: binding.type = DescriptorType::acceleration_structure; break;
+                }
+                switch (res.texture_dimension)
+                {
+                case ShaderCompiler::ShaderTextureDimension::none: break;
+                case ShaderCompiler::ShaderTextureDimension::tex1d: binding.texture_view_type = TextureViewType::tex1d; break;
+                case ShaderCompiler::ShaderTextureDimension::tex2d: binding.texture_view_type = TextureViewType::tex2d; break;
+                case ShaderCompiler::ShaderTextureDimension::tex2dms: binding.texture_view_type = TextureViewType::tex2dms; break;
+                case ShaderCompiler::ShaderTextureDimension::tex3d: binding.texture_view_type = TextureViewType::tex3d; break;
+                case ShaderCompiler::ShaderTextureDimension::texcube: binding.texture_view_type = TextureViewType::texcube; break;
+                case ShaderCompiler::ShaderTextureDimension::tex1darray: binding.texture_view_type = TextureViewType::tex1darray; break;
+                case ShaderCompiler::ShaderTextureDimension::tex2darray: binding.texture_view_type = TextureViewType::tex2darray; break;
+                case ShaderCompiler::ShaderTextureDimension::tex2dmsarray: binding.texture_view_type = TextureViewType::tex2dmsarray; break;
+                case ShaderCompiler::ShaderTextureDimension::texcubearray: binding.texture_view_type = TextureViewType::texcubearray; break;
+                }
+                bindings.push_back(binding);
+            }
+        }
+
+        //! Describes one shader in one pipeline for creating pipeline layouts from shader reflection data.
+        struct ShaderReflectionStage
+        {
+            //! The reflection data of the shader.
+            const ShaderCompiler::ShaderReflection* reflection;
+            //! The shader visibility flags of the shader.
+            ShaderVisibilityFlag shader_visibility_flags;
+        };
+
+        //! Creates descriptor set layouts and pipeline layouts from shader reflection data, and shares layouts with identical 
+        //! descriptors between all pipelines that request layouts from the same cache.
+        //! @details Sharing layouts allows descriptor sets created for one pipeline to be used by all pipelines with compatible layouts.
+        //! @threadsafe
+        struct ShaderLayoutCache
+        {
+            //! Initializes the cache.
+            //! @param[in] device The device used to create layouts.
+            void init(IDevice* device)
+            {
+                m_device = device;
+                m_mtx = new_mutex();
+            }
+            //! Releases all cached layouts.
+            void reset()
+            {
+                MutexGuard guard(m_mtx);
+                m_descriptor_set_layouts.clear();
+                m_pipeline_layouts.clear();
+            }
+            //! Gets one descriptor set layout with the specified bindings, and creates the layout if not exists.
+            //! @param[in] desc The descriptor set layout descriptor.
+            //! @return Returns the descriptor set layout.
+            R<Ref<IDescriptorSetLayout>> get_descriptor_set_layout(const DescriptorSetLayoutDesc& desc)
+            {
+                MutexGuard guard(m_mtx);
+                return get_descriptor_set_layout_locked(desc);
+            }
+            //! Gets one pipeline layout that matches resources accessed by the specified shaders, and creates the layout if not exists.
+            //! @details One descriptor set layout is created for every register space from `0` to the largest register space used by 
+            //! shaders, register spaces not used by shaders get empty descriptor set layouts.
+            //! @param[in] shaders The shaders in the pipeline.
+            //! @param[in] flags The pipeline layout flags.
+            //! @param[out] out_descriptor_set_layouts If not `nullptr`, receives descriptor set layouts of the pipeline layout,
+            //! ordered by register spaces.
+            //! @return Returns the pipeline layout.
+            R<Ref<IPipelineLayout>> get_pipeline_layout(Span<const ShaderReflectionStage> shaders, PipelineLayoutFlag flags,
+                Vector<Ref<IDescriptorSetLayout>>* out_descriptor_set_layouts = nullptr)
+            {
+                MutexGuard guard(m_mtx);
+                PipelineLayoutEntry entry;
+                entry.flags = flags;
+                entry.num_constants = 0;
+                entry.constants_shader_visibility_flags = ShaderVisibilityFlag::none;
+                u32 num_sets = 0;
+                for (auto& shader : shaders)
+                {
+                    for (auto& res : shader.reflection->resources) num_sets = max(num_sets, res.set + 1);
+                    if (shader.reflection->num_constants)
+                    {
+                        entry.num_constants = max(entry.num_constants, shader.reflection->num_constants);
+                        entry.constants_shader_visibility_flags |= shader.shader_visibility_flags;
+                    }
+                }
+                lutry
+                {
+                    for (u32 set = 0; set < num_sets; ++set)
+                    {
+                        Vector<DescriptorSetLayoutBinding> bindings;
+                        for (auto& shader : shaders)
+                        {
+                            get_descriptor_set_layout_bindings_from_reflection(*shader.reflection, shader.shader_visibility_flags, set, bindings);
+                        }
+                        sort(bindings.begin(), bindings.end(), [](const DescriptorSetLayoutBinding& lhs, const DescriptorSetLayoutBinding& rhs)
+                        {
+                            return lhs.binding_slot < rhs.binding_slot;
+                        });
+                        lulet(dlayout, get_descriptor_set_layout_locked(DescriptorSetLayoutDesc({ bindings.data(), bindings.size() })));
+                        entry.descriptor_set_layouts.push_back(dlayout);
+                    }
+                    if (!entry.num_constants) entry.constants_shader_visibility_flags = ShaderVisibilityFlag::all;
+                    if (out_descriptor_set_layouts) *out_descriptor_set_layouts = entry.descriptor_set_layouts;
+                    for (auto& e : m_pipeline_layouts)
+                    {
+                        if (e.flags == entry.flags && e.num_constants == entry.num_constants &&
+                            e.constants_shader_visibility_flags == entry.constants_shader_visibility_flags &&
+                            e.descriptor_set_layouts.size() == entry.descriptor_set_layouts.size() &&
+                            equal(e.descriptor_set_layouts.begin(), e.descriptor_set_layouts.end(), entry.descriptor_set_layouts.begin()))
+                        {
+                            return e.layout;
+                        }
+                    }
+                    Vector<IDescriptorSetLayout*> dlayouts;
+                    for (auto& dlayout : entry.descriptor_set_layouts) dlayouts.push_back(dlayout.get());
+                    luset(entry.layout, m_device->new_pipeline_layout(PipelineLayoutDesc({ dlayouts.data(), dlayouts.size() },
+                        flags, entry.num_constants, entry.constants_shader_visibility_flags)));
+                    m_pipeline_layouts.push_back(entry);
+                }
+                lucatchret;
+                return entry.layout;
+            }
+        private:
+            struct DescriptorSetLayoutEntry
+            {
+                u64 hash;
+                Vector<DescriptorSetLayoutBinding> bindings;
+                DescriptorSetLayoutFlag flags;
+                Ref<IDescriptorSetLayout> layout;
+            };
+            struct PipelineLayoutEntry
+            {
+                Vector<Ref<IDescriptorSetLayout>> descriptor_set_layouts;
+                PipelineLayoutFlag flags;
+                u32 num_constants;
+                ShaderVisibilityFlag constants_shader_visibility_flags;
+                Ref<IPipelineLayout> layout;
+            };
+            Ref<IDevice> m_device;
+            Ref<IMutex> m_mtx;
+            Vector<DescriptorSetLayoutEntry> m_descriptor_set_layouts;
+            Vector<PipelineLayoutEntry> m_pipeline_layouts;
+
+            static bool is_binding_equal(const DescriptorSetLayoutBinding& lhs, const DescriptorSetLayoutBinding& rhs)
+            {
+                return lhs.binding_slot == rhs.binding_slot && lhs.num_descs == rhs.num_descs && lhs.type == rhs.type &&
+                    lhs.texture_view_type == rhs.texture_view_type && lhs.shader_visibility_flags == rhs.shader_visibility_flags;
+            }
+            R<Ref<IDescriptorSetLayout>> get_descriptor_set_layout_locked(const DescriptorSetLayoutDesc& desc)
+            {
+                u64 h = memhash64(&desc.flags, sizeof(desc.flags));
+                for (auto& binding : desc.bindings)
+                {
+                    u32 values[5] = { binding.binding_slot, binding.num_descs, (u32)binding.type, (u32)binding.texture_view_type, (u32)binding.shader_visibility_flags };
+                    h = memhash64(values, sizeof(values), h);
+                }
+                for (auto& e : m_descriptor_set_layouts)
+                {
+                    if (e.hash != h || e.flags != desc.flags || e.bindings.size() != desc.bindings.size()) continue;
+                    bool match = true;
+                    for (usize i = 0; i < e.bindings.size(); ++i)
+                    {
+                        if (!is_binding_equal(e.bindings[i], desc.bindings[i]))
+                        {
+                            match = false;
+                            break;
+                        }
+                    }
+                    if (match) return e.layout;
+                }
+                DescriptorSetLayoutEntry entry;
+                entry.hash = h;
+                entry.bindings.assign(desc.bindings);
+                entry.flags = desc.flags;
+                lutry
+                {
+                    luset(entry.layout, m_device->new_descriptor_set_layout(desc));
+                }
+                lucatchret;
+                m_descriptor_set_layouts.push_back(entry);
+                return entry.layout;
+            }
+        };
+
         //! @}
     }
 }
@@ -0,0 +1,41 @@
+// Declares resource arrays that match the layout of RHI::IBindlessResourceTable.
+// Define the following macros before including this file (or pass them as shader compile definitions) if the 
+// default values are not used:
+// * LUNA_BINDLESS_SET: The descriptor set index the bindless resource table is bound to. Default is 0.
+// * LUNA_BINDLESS_MAX_TEXTURES: BindlessResourceTableDesc::max_textures. Default is 2048.
+// * LUNA_BINDLESS_MAX_BUFFERS: BindlessResourceTableDesc::max_buffers. Default is 256.
+// * LUNA_BINDLESS_BUFFER_TYPE: The element type of structured buffers. Default is uint.
+#ifndef LUNA_BINDLESS_HLSL
+#define LUNA_BINDLESS_HLSL
+
+#ifndef LUNA_BINDLESS_SET
+#define LUNA_BINDLESS_SET 0
+#endif
+#ifndef LUNA_BINDLESS_MAX_TEXTURES
+#define LUNA_BINDLESS_MAX_TEXTURES 2048
+#endif
+#ifndef LUNA_BINDLESS_MAX_BUFFERS
+#define LUNA_BINDLESS_MAX_BUFFERS 256
+#endif
+#ifndef LUNA_BINDLESS_BUFFER_TYPE
+#define LUNA_BINDLESS_BUFFER_TYPE uint
+#endif
+
+#define LUNA_BINDLESS_CONCAT_IMPL(a, b) a##b
+#define LUNA_BINDLESS_CONCAT(a, b) LUNA_BINDLESS_CONCAT_IMPL(a, b)
+
+// Matches RHI::INVALID_BINDLESS_INDEX.
+static const uint INVALID_BINDLESS_INDEX = 0xFFFFFFFF;
+
+Texture2D g_bindless_textures[LUNA_BINDLESS_MAX_TEXTURES] : register(t0, LUNA_BINDLESS_CONCAT(space, LUNA_BINDLESS_SET));
+StructuredBuffer<LUNA_BINDLESS_BUFFER_TYPE> g_bindless_buffers[LUNA_BINDLESS_MAX_BUFFERS] : 
+    register(LUNA_BINDLESS_CONCAT(t, LUNA_BINDLESS_MAX_TEXTURES), LUNA_BINDLESS_CONCAT(space, LUNA_BINDLESS_SET));
+
+// Fetches the texture registered by RHI::IBindlessResourceTable::register_texture.
+// The index may be different between threads in one wave.
+#define BINDLESS_TEXTURE(index) g_bindless_textures[NonUniformResourceIndex(index)]
+// Fetches the buffer registered by RHI::IBindlessResourceTable::register_buffer.
+// The index may be different between threads in one wave.
+#define BINDLESS_BUFFER(index) g_bindless_buffers[NonUniformResourceIndex(index)]
+
+#endif
@@ -0,0 +1,9 @@
+// Declares pipeline constants set by ICommandBuffer::set_graphics_constants and ICommandBuffer::set_compute_constants.
+// `type` is one structure whose size must not be greater than PipelineLayoutDesc::num_constants * 4 bytes.
+#ifndef LUNA_PIPELINE_CONSTANTS_HLSL
+#define LUNA_PIPELINE_CONSTANTS_HLSL
+
+// Matches RHI::PIPELINE_CONSTANTS_REGISTER_SPACE.
+#define LUNA_PIPELINE_CONSTANTS(type, name) [[vk::push_constant]] ConstantBuffer<type> name : register(b0, space15)
+
+#endif
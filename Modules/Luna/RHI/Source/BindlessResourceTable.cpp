@@ -0,0 +1,146 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BindlessResourceTable.cpp
+* @author JXMaster
+* @date 2024/4/2
+*/
+#include "BindlessResourceTable.hpp"
+#include <Luna/Runtime/SpinLock.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        // Allocates indices in range [0, capacity). Freed indices are reused first.
+        struct BindlessIndexAllocator
+        {
+            u32 m_capacity = 0;
+            u32 m_next = 0;
+            Vector<u32> m_free_indices;
+
+            R<u32> allocate()
+            {
+                if (!m_free_indices.empty())
+                {
+                    u32 index = m_free_indices.back();
+                    m_free_indices.pop_back();
+                    return index;
+                }
+                if (m_next >= m_capacity) return BasicError::out_of_resource();
+                return m_next++;
+            }
+            void free(u32 index)
+            {
+                lucheck(index < m_next);
+                m_free_indices.push_back(index);
+            }
+        };
+
+        struct BindlessResourceTable : IBindlessResourceTable
+        {
+            lustruct("RHI::BindlessResourceTable", "{B1D3A6F2-5E47-4C98-8A0D-7F21C4E9B356}");
+            luiimpl();
+
+            Ref<IDevice> m_device;
+            Ref<IDescriptorSetLayout> m_layout;
+            Ref<IDescriptorSet> m_descriptor_set;
+            u32 m_buffer_binding_slot;
+            SpinLock m_lock;
+            BindlessIndexAllocator m_textures;
+            BindlessIndexAllocator m_buffers;
+
+            RV init(const BindlessResourceTableDesc& desc)
+            {
+                lutry
+                {
+                    if (!desc.max_textures || !desc.max_buffers) return BasicError::bad_arguments();
+                    if (!m_device->check_feature(DeviceFeature::unbound_descriptor_array).unbound_descriptor_array)
+                    {
+                        return BasicError::not_supported();
+                    }
+                    m_buffer_binding_slot = desc.max_textures;
+                    DescriptorSetLayoutBinding bindings[] = {
+                        DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 0, desc.max_textures, desc.shader_visibility_flags),
+                        DescriptorSetLayoutBinding::read_buffer_view(m_buffer_binding_slot, desc.max_buffers, desc.shader_visibility_flags)
+                    };
+                    luset(m_layout, m_device->new_descriptor_set_layout(DescriptorSetLayoutDesc({ bindings, 2 }, DescriptorSetLayoutFlag::partially_bound)));
+                    luset(m_descriptor_set, m_device->new_descriptor_set(DescriptorSetDesc(m_layout.get())));
+                    m_textures.m_capacity = desc.max_textures;
+                    m_buffers.m_capacity = desc.max_buffers;
+                }
+                lucatchret;
+                return ok;
+            }
+
+            virtual IDevice* get_device() override { return m_device.get(); }
+            virtual void set_name(const c8* name) override { m_descriptor_set->set_name(name); }
+            virtual IDescriptorSetLayout* get_descriptor_set_layout() override { return m_layout.get(); }
+            virtual IDescriptorSet* get_descriptor_set() override { return m_descriptor_set.get(); }
+            virtual u32 get_buffer_binding_slot() override { return m_buffer_binding_slot; }
+            virtual R<u32> register_texture(const TextureViewDesc& desc) override
+            {
+                u32 index;
+                lutry
+                {
+                    LockGuard guard(m_lock);
+                    luset(index, m_textures.allocate());
+                    auto r = m_descriptor_set->update_descriptors({ WriteDescriptorSet::read_texture_view_array(0, index, { &desc, 1 }) });
+                    if (failed(r))
+                    {
+                        m_textures.free(index);
+                        return r.errcode();
+                    }
+                }
+                lucatchret;
+                return index;
+            }
+            virtual R<u32> register_buffer(const BufferViewDesc& desc) override
+            {
+                u32 index;
+                lutry
+                {
+                    LockGuard guard(m_lock);
+                    luset(index, m_buffers.allocate());
+                    auto r = m_descriptor_set->update_descriptors({ WriteDescriptorSet::read_buffer_view_array(m_buffer_binding_slot, index, { &desc, 1 }) });
+                    if (failed(r))
+                    {
+                        m_buffers.free(index);
+                        return r.errcode();
+                    }
+                }
+                lucatchret;
+                return index;
+            }
+            virtual void unregister_texture(u32 index) override
+            {
+                LockGuard guard(m_lock);
+                m_textures.free(index);
+            }
+            virtual void unregister_buffer(u32 index) override
+            {
+                LockGuard guard(m_lock);
+                m_buffers.free(index);
+            }
+        };
+
+        R<Ref<IBindlessResourceTable>> new_bindless_resource_table(IDevice* device, const BindlessResourceTableDesc& desc)
+        {
+            Ref<BindlessResourceTable> table = new_object<BindlessResourceTable>();
+            table->m_device = device;
+            lutry
+            {
+                luexp(table->init(desc));
+            }
+            lucatchret;
+            return Ref<IBindlessResourceTable>(table);
+        }
+        void register_bindless_resource_table_types()
+        {
+            register_boxed_type<BindlessResourceTable>();
+            impl_interface_for_type<BindlessResourceTable, IBindlessResourceTable, IDeviceChild>();
+        }
+    }
+}
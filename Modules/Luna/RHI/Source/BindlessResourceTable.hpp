@@ -0,0 +1,22 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file BindlessResourceTable.hpp
+* @author JXMaster
+* @date 2024/4/2
+*/
+#pragma once
+#include "../Device.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! Creates one bindless resource table using descriptor sets created from `device`.
+        //! Used by all backends to implement `IDevice::new_bindless_resource_table`.
+        R<Ref<IBindlessResourceTable>> new_bindless_resource_table(IDevice* device, const BindlessResourceTableDesc& desc);
+        void register_bindless_resource_table_types();
+    }
+}
@@ -0,0 +1,98 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file AccelerationStructure.cpp
+* @author JXMaster
+* @date 2024/4/8
+*/
+#include "AccelerationStructure.hpp"
+#include "Resource.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        RV AccelerationStructure::init(const AccelerationStructureDesc& desc)
+        {
+            lutry
+            {
+                m_desc = desc;
+                // Acceleration structures are stored in buffers that allow unordered access, and must stay in 
+                // D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE state for their whole lifetime.
+                D3D12_RESOURCE_DESC rd = encode_buffer_desc(BufferDesc(BufferUsageFlag::read_write_buffer, desc.size));
+                D3D12MA::ALLOCATION_DESC allocation_desc{};
+                allocation_desc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+                m_memory = new_object<DeviceMemory>();
+                m_memory->m_device = m_device;
+                m_memory->m_memory_type = MemoryType::local;
+                luexp(encode_hresult(m_device->m_allocator->CreateResource(
+                    &allocation_desc, &rd, D3D12_RESOURCE_STATE_RAYTRACING_ACCELERATION_STRUCTURE, NULL, 
+                    &m_memory->m_allocation, IID_PPV_ARGS(&m_res)
+                )));
+                m_device->m_statistics.on_memory_allocated(m_device, MemoryType::local, m_memory->get_size());
+            }
+            lucatchret;
+            return ok;
+        }
+        inline D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS encode_acceleration_structure_build_flags(AccelerationStructureBuildFlag flags)
+        {
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAGS r = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_NONE;
+            if (test_flags(flags, AccelerationStructureBuildFlag::allow_update)) r |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_ALLOW_UPDATE;
+            if (test_flags(flags, AccelerationStructureBuildFlag::prefer_fast_trace)) r |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_TRACE;
+            if (test_flags(flags, AccelerationStructureBuildFlag::prefer_fast_build)) r |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PREFER_FAST_BUILD;
+            if (test_flags(flags, AccelerationStructureBuildFlag::minimize_memory)) r |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_MINIMIZE_MEMORY;
+            return r;
+        }
+        inline D3D12_GPU_VIRTUAL_ADDRESS get_buffer_address(IBuffer* buffer, u64 offset)
+        {
+            if (!buffer) return 0;
+            BufferResource* res = cast_object<BufferResource>(buffer->get_object());
+            return res->m_res->GetGPUVirtualAddress() + offset;
+        }
+        void encode_acceleration_structure_inputs(const AccelerationStructureBuildInputs& src, 
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& dst, Vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geometries)
+        {
+            dst.Flags = encode_acceleration_structure_build_flags(src.flags);
+            dst.DescsLayout = D3D12_ELEMENTS_LAYOUT_ARRAY;
+            if (src.type == AccelerationStructureType::top_level)
+            {
+                dst.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL;
+                dst.NumDescs = src.num_instances;
+                dst.InstanceDescs = get_buffer_address(src.instance_buffer, src.instance_buffer_offset);
+                return;
+            }
+            dst.Type = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL;
+            geometries.resize(src.geometries.size());
+            for (usize i = 0; i < src.geometries.size(); ++i)
+            {
+                auto& s = src.geometries[i];
+                auto& d = geometries[i];
+                d.Type = D3D12_RAYTRACING_GEOMETRY_TYPE_TRIANGLES;
+                d.Flags = D3D12_RAYTRACING_GEOMETRY_FLAG_NONE;
+                if (test_flags(s.flags, RayTracingGeometryFlag::opaque)) d.Flags |= D3D12_RAYTRACING_GEOMETRY_FLAG_OPAQUE;
+                if (test_flags(s.flags, RayTracingGeometryFlag::no_duplicate_any_hit_invocation)) d.Flags |= D3D12_RAYTRACING_GEOMETRY_FLAG_NO_DUPLICATE_ANYHIT_INVOCATION;
+                d.Triangles.Transform3x4 = 0;
+                d.Triangles.VertexFormat = encode_format(s.vertex_format);
+                d.Triangles.VertexCount = s.num_vertices;
+                d.Triangles.VertexBuffer.StartAddress = get_buffer_address(s.vertex_buffer, s.vertex_buffer_offset);
+                d.Triangles.VertexBuffer.StrideInBytes = s.vertex_stride;
+                if (s.index_buffer)
+                {
+                    d.Triangles.IndexFormat = encode_format(s.index_format);
+                    d.Triangles.IndexCount = s.num_indices;
+                    d.Triangles.IndexBuffer = get_buffer_address(s.index_buffer, s.index_buffer_offset);
+                }
+                else
+                {
+                    d.Triangles.IndexFormat = DXGI_FORMAT_UNKNOWN;
+                    d.Triangles.IndexCount = 0;
+                    d.Triangles.IndexBuffer = 0;
+                }
+            }
+            dst.NumDescs = (UINT)geometries.size();
+            dst.pGeometryDescs = geometries.data();
+        }
+    }
+}
@@ -0,0 +1,43 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file AccelerationStructure.hpp
+* @author JXMaster
+* @date 2024/4/8
+*/
+#pragma once
+#include "D3D12Common.hpp"
+#include "Device.hpp"
+#include "DeviceMemory.hpp"
+#include "../../AccelerationStructure.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct AccelerationStructure : IAccelerationStructure
+        {
+            lustruct("RHI::AccelerationStructure", "{5B8E2C41-9A07-4D36-B1F3-E46D0A9C7F28}");
+            luiimpl();
+
+            Ref<Device> m_device;
+            ComPtr<ID3D12Resource> m_res;
+            Ref<DeviceMemory> m_memory;
+            AccelerationStructureDesc m_desc;
+
+            RV init(const AccelerationStructureDesc& desc);
+
+            virtual IDevice* get_device() override { return m_device; }
+            virtual void set_name(const c8* name) override { set_object_name(m_res.Get(), name); }
+            virtual AccelerationStructureDesc get_desc() override { return m_desc; }
+            virtual u64 get_gpu_address() override { return m_res->GetGPUVirtualAddress(); }
+        };
+
+        //! Encodes acceleration structure build inputs. `geometries` stores geometry descriptors referenced by `dst`, 
+        //! and must be alive until `dst` is consumed.
+        void encode_acceleration_structure_inputs(const AccelerationStructureBuildInputs& src, 
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS& dst, Vector<D3D12_RAYTRACING_GEOMETRY_DESC>& geometries);
+    }
+}
@@ -10,6 +10,7 @@
 #include "CommandBuffer.hpp"
 #include "QueryHeap.hpp"
 #include "Fence.hpp"
+#include "AccelerationStructure.hpp"
 
 namespace Luna
 {
@@ -37,6 +38,13 @@ namespace Luna
                 m_barriers.push_back(aliasing);
                 return;
             }
+            auto iter = m_buffer_barrier_indices.find(buffer);
+            if (iter != m_buffer_barrier_indices.end())
+            {
+                // Merge with the transition recorded in the same batch.
+                m_barriers[iter->second].Transition.StateAfter = after;
+                return;
+            }
             D3D12_RESOURCE_BARRIER t;
             t.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
             t.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
@@ -48,6 +56,7 @@ namespace Luna
             if (t.Transition.StateBefore == D3D12_RESOURCE_STATE_COMMON) return;
             t.Transition.Subresource = 0;
             t.Transition.pResource = buffer->m_res.Get();
+            m_buffer_barrier_indices.insert(make_pair(buffer, m_barriers.size()));
             m_barriers.push_back(t);
         }
         inline bool is_texture_implicit_promotable(D3D12_RESOURCE_STATES state)
@@ -79,6 +88,16 @@ namespace Luna
                 m_barriers.push_back(aliasing);
                 return;
             }
+            TextureKey key;
+            key.m_res = texture;
+            key.m_subres = subresource;
+            auto iter = m_texture_barrier_indices.find(key);
+            if (iter != m_texture_barrier_indices.end())
+            {
+                // Merge with the transition recorded in the same batch.
+                m_barriers[iter->second].Transition.StateAfter = after;
+                return;
+            }
             D3D12_RESOURCE_BARRIER t;
             t.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
             t.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
@@ -96,6 +115,7 @@ namespace Luna
             }
             t.Transition.Subresource = subresource;
             t.Transition.pResource = texture->m_res.Get();
+            m_texture_barrier_indices.insert(make_pair(key, m_barriers.size()));
             m_barriers.push_back(t);
         }
         void ResourceStateTrackingSystem::pack_buffer_internal(BufferResource* buffer, const BufferBarrier& barrier, D3D12_RESOURCE_STATES recorded_before_state)
@@ -185,6 +205,33 @@ namespace Luna
                 }
             }
         }
+        void ResourceStateTrackingSystem::remove_redundant_barriers()
+        {
+            usize i = 0;
+            while (i < m_barriers.size())
+            {
+                auto& b = m_barriers[i];
+                if (b.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && b.Transition.StateBefore == b.Transition.StateAfter)
+                {
+                    if (b.Transition.StateBefore & D3D12_RESOURCE_STATE_UNORDERED_ACCESS)
+                    {
+                        // Unordered access writes before the merged transitions still need to be synchronized.
+                        ID3D12Resource* res = b.Transition.pResource;
+                        b.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+                        b.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+                        b.UAV.pResource = res;
+                        ++i;
+                    }
+                    else
+                    {
+                        m_barriers.erase(m_barriers.begin() + i);
+                    }
+                }
+                else ++i;
+            }
+            m_buffer_barrier_indices.clear();
+            m_texture_barrier_indices.clear();
+        }
         void ResourceStateTrackingSystem::resolve()
         {
             begin_new_barrier_batch();
@@ -215,14 +262,33 @@ namespace Luna
                 }
             }
         }
-        RV CommandBuffer::init()
+        RV CommandBuffer::init(bool bundle)
         {
             HRESULT hr;
             auto& queue = m_device->m_command_queues[m_queue];
+            if (bundle)
+            {
+                m_bundle = true;
+                hr = m_device->m_device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_BUNDLE, IID_PPV_ARGS(&m_ca));
+                if (FAILED(hr)) return encode_hresult(hr);
+                hr = m_device->m_device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_BUNDLE, m_ca.Get(), NULL, IID_PPV_ARGS(&m_li));
+                if (FAILED(hr)) return encode_hresult(hr);
+                if (FAILED(m_li.As(&m_li6))) m_li6.Reset();
+                if (FAILED(m_li.As(&m_li4))) m_li4.Reset();
+                if (FAILED(m_li.As(&m_li5))) m_li5.Reset();
+                // Bundles are reset when `begin_parallel_render_pass` is called.
+                hr = m_li->Close();
+                if (FAILED(hr)) return encode_hresult(hr);
+                m_cmdlist_closed = true;
+                return ok;
+            }
             hr = m_device->m_device->CreateCommandAllocator(encode_command_queue_type(queue->m_desc.type), IID_PPV_ARGS(&m_ca));
             if (FAILED(hr)) return encode_hresult(hr);
             hr = m_device->m_device->CreateCommandList(0, encode_command_queue_type(queue->m_desc.type), m_ca.Get(), NULL, IID_PPV_ARGS(&m_li));
             if (FAILED(hr)) return encode_hresult(hr);
+            if (FAILED(m_li.As(&m_li6))) m_li6.Reset();
+            if (FAILED(m_li.As(&m_li4))) m_li4.Reset();
+            if (FAILED(m_li.As(&m_li5))) m_li5.Reset();
             hr = m_device->m_device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence));
             if (FAILED(hr)) return encode_hresult(hr);
             m_event = ::CreateEventA(NULL, TRUE, TRUE, NULL);
@@ -233,6 +299,33 @@ namespace Luna
             m_wait_value = 1;    // The fist wait value.
             return ok;
         }
+        RV CommandBuffer::begin_bundle(const RenderPassContext& render_pass_context)
+        {
+            lutsassert();
+            if (!m_cmdlist_closed)
+            {
+                HRESULT hr = m_li->Close();
+                if (FAILED(hr)) return encode_hresult(hr);
+                m_cmdlist_closed = true;
+            }
+            HRESULT hr = m_ca->Reset();
+            if (FAILED(hr)) return encode_hresult(hr);
+            hr = m_li->Reset(m_ca.Get(), NULL);
+            if (FAILED(hr)) return encode_hresult(hr);
+            m_cmdlist_closed = false;
+            m_objs.clear();
+            m_vbs.clear();
+            m_ib.reset();
+            m_heap_set = false;
+            m_graphics_pipeline_layout.reset();
+            m_bundle_viewports.clear();
+            m_bundle_scissor_rects.clear();
+            m_statistics = CommandBufferStatistics();
+            m_render_pass_context.m_valid = true;
+            m_render_pass_context.m_tex_size = render_pass_context.m_tex_size;
+            m_render_pass_context.m_num_color_attachments = 0;
+            return ok;
+        }
         void CommandBuffer::write_timestamp(IQueryHeap* heap, u32 index)
         {
             lutsassert();
@@ -258,6 +351,7 @@ namespace Luna
         RV CommandBuffer::reset()
         {
             lutsassert();
+            lucheck_msg(!m_bundle, "Secondary command buffers cannot be reset directly.");
             if (!m_cmdlist_closed)
             {
                 HRESULT hr = m_li->Close();
@@ -276,12 +370,16 @@ namespace Luna
             m_heap_set = false;
             m_graphics_pipeline_layout.reset();
             m_compute_pipeline_layout.reset();
+            m_statistics = CommandBufferStatistics();
             return ok;
         }
         void CommandBuffer::begin_render_pass(const RenderPassDesc& desc)
         {
             lutsassert();
+            ++m_statistics.num_render_passes;
+            lucheck_msg(!m_bundle, "begin_render_pass cannot be called on secondary command buffers.");
             assert_no_context();
+            flush_barriers();
             lutry
             {
                 m_occlusion_query_heap_attachment = desc.occlusion_query_heap;
@@ -405,12 +503,59 @@ namespace Luna
                         m_render_pass_context.m_resolve_attachments[i] = desc.resolve_attachments[i];
                     }
                 }
+                // Reset shading rate.
+                m_render_pass_context.m_shading_rate_image_bound = false;
+                if (m_li5 && m_device->m_variable_shading_rate_tier != D3D12_VARIABLE_SHADING_RATE_TIER_NOT_SUPPORTED)
+                {
+                    if (desc.shading_rate_image)
+                    {
+                        lucheck_msg(m_device->m_shading_rate_image_tile_size, "RenderPassDesc::shading_rate_image requires DeviceFeature::shading_rate_image_tile_size.");
+                        TextureResource* tex = cast_object<TextureResource>(desc.shading_rate_image->get_object());
+                        D3D12_SHADING_RATE_COMBINER combiners[2] = { D3D12_SHADING_RATE_COMBINER_PASSTHROUGH, D3D12_SHADING_RATE_COMBINER_OVERRIDE };
+                        m_li5->RSSetShadingRate(D3D12_SHADING_RATE_1X1, combiners);
+                        m_li5->RSSetShadingRateImage(tex->m_res.Get());
+                        m_render_pass_context.m_shading_rate_image_bound = true;
+                    }
+                    else
+                    {
+                        m_li5->RSSetShadingRate(D3D12_SHADING_RATE_1X1, nullptr);
+                    }
+                }
+                else
+                {
+                    lucheck_msg(!desc.shading_rate_image, "RenderPassDesc::shading_rate_image requires DeviceFeature::shading_rate_image_tile_size.");
+                }
             }
             lucatch
             {
 
             }
         }
+        void CommandBuffer::begin_parallel_render_pass(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers)
+        {
+            lutsassert();
+            begin_render_pass(desc);
+            // Bundles must use the same descriptor heaps as the command list that executes them.
+            if (!m_heap_set)
+            {
+                ID3D12DescriptorHeap* heaps[2];
+                heaps[0] = m_device->m_cbv_srv_uav_heap.m_heap.Get();
+                heaps[1] = m_device->m_sampler_heap.m_heap.Get();
+                m_li->SetDescriptorHeaps(2, heaps);
+                m_heap_set = true;
+            }
+            for (ICommandBuffer* cmdbuf : secondary_command_buffers)
+            {
+                CommandBuffer* bundle = cast_object<CommandBuffer>(cmdbuf->get_object());
+                lucheck_msg(bundle->m_bundle, "Only secondary command buffers can be used in begin_parallel_render_pass.");
+                auto r = bundle->begin_bundle(m_render_pass_context);
+                if (failed(r))
+                {
+                    lupanic_msg_always("Failed to begin the secondary command buffer.");
+                }
+                m_bundles.push_back(bundle);
+            }
+        }
         void CommandBuffer::set_graphics_pipeline_layout(IPipelineLayout* pipeline_layout)
         {
             lutsassert();
@@ -423,6 +568,7 @@ namespace Luna
         void CommandBuffer::set_graphics_pipeline_state(IPipelineState* pso)
         {
             lutsassert();
+            ++m_statistics.num_pipeline_state_binds;
             assert_graphcis_context();
             PipelineState* p = cast_object<PipelineState>(pso->get_object());
             m_li->SetPipelineState(p->m_pso.Get());
@@ -483,6 +629,7 @@ namespace Luna
         void CommandBuffer::set_graphics_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets)
         {
             lutsassert();
+            m_statistics.num_descriptor_set_binds += (u32)descriptor_sets.size();
             assert_graphcis_context();
             lucheck_msg(m_graphics_pipeline_layout, "Graphics pipeline layout must be set before Graphic Descriptor Set can be bound!");
             lucheck_msg(m_graphics_pipeline_layout->m_descriptor_set_layouts.size() >= start_index + descriptor_sets.size(), "The binding index out of range specified by the pipeline layout.");
@@ -521,6 +668,14 @@ namespace Luna
                 }
             }
         }
+        void CommandBuffer::set_graphics_constants(u32 first_constant, u32 num_constants, const void* data)
+        {
+            lutsassert();
+            assert_graphcis_context();
+            lucheck_msg(m_graphics_pipeline_layout, "Graphics pipeline layout must be set before graphics constants can be set.");
+            lucheck_msg(m_graphics_pipeline_layout->m_constants_root_parameter_index != U32_MAX, "The pipeline layout does not have constants.");
+            m_li->SetGraphicsRoot32BitConstants(m_graphics_pipeline_layout->m_constants_root_parameter_index, num_constants, data, first_constant);
+        }
         void CommandBuffer::set_viewports(Span<const Viewport> viewports)
         {
             lutsassert();
@@ -535,6 +690,11 @@ namespace Luna
                 vs[i].TopLeftY =  viewports[i].top_left_y;
                 vs[i].Width = viewports[i].width;
             }
+            if (m_bundle)
+            {
+                m_bundle_viewports.assign(Span<D3D12_VIEWPORT>(vs, viewports.size()));
+                return;
+            }
             m_li->RSSetViewports((UINT)viewports.size(), vs);
         }
         void CommandBuffer::set_scissor_rects(Span<const RectI> rects)
@@ -550,6 +710,11 @@ namespace Luna
                 rs[i].top = rects[i].offset_y;
                 rs[i].bottom = rects[i].offset_y + rects[i].height;
             }
+            if (m_bundle)
+            {
+                m_bundle_scissor_rects.assign(Span<D3D12_RECT>(rs, rects.size()));
+                return;
+            }
             m_li->RSSetScissorRects((UINT)rects.size(), rs);
         }
         void CommandBuffer::set_blend_factor(const Float4U& blend_factor)
@@ -565,19 +730,94 @@ namespace Luna
             assert_graphcis_context();
             m_li->OMSetStencilRef(stencil_ref);
         }
+        inline D3D12_SHADING_RATE_COMBINER encode_shading_rate_combiner(ShadingRateCombiner combiner)
+        {
+            switch (combiner)
+            {
+            case ShadingRateCombiner::passthrough: return D3D12_SHADING_RATE_COMBINER_PASSTHROUGH;
+            case ShadingRateCombiner::override: return D3D12_SHADING_RATE_COMBINER_OVERRIDE;
+            case ShadingRateCombiner::min: return D3D12_SHADING_RATE_COMBINER_MIN;
+            case ShadingRateCombiner::max: return D3D12_SHADING_RATE_COMBINER_MAX;
+            case ShadingRateCombiner::sum: return D3D12_SHADING_RATE_COMBINER_SUM;
+            default: lupanic(); return D3D12_SHADING_RATE_COMBINER_PASSTHROUGH;
+            }
+        }
+        void CommandBuffer::set_shading_rate(ShadingRate rate, ShadingRateCombiner primitive_combiner, ShadingRateCombiner image_combiner)
+        {
+            lutsassert();
+            assert_graphcis_context();
+            lucheck_msg(m_li5 && m_device->m_variable_shading_rate_tier != D3D12_VARIABLE_SHADING_RATE_TIER_NOT_SUPPORTED, 
+                "set_shading_rate requires DeviceFeature::variable_rate_shading.");
+            if (!m_device->m_additional_shading_rates_supported && 
+                (rate == ShadingRate::rate_2x4 || rate == ShadingRate::rate_4x2 || rate == ShadingRate::rate_4x4))
+            {
+                rate = ShadingRate::rate_2x2;
+            }
+            // ShadingRate values match D3D12_SHADING_RATE values.
+            D3D12_SHADING_RATE r = (D3D12_SHADING_RATE)rate;
+            if (m_device->m_variable_shading_rate_tier >= D3D12_VARIABLE_SHADING_RATE_TIER_2)
+            {
+                D3D12_SHADING_RATE_COMBINER combiners[2] = { encode_shading_rate_combiner(primitive_combiner), encode_shading_rate_combiner(image_combiner) };
+                m_li5->RSSetShadingRate(r, combiners);
+            }
+            else
+            {
+                // Combiners must be `nullptr` in tier 1.
+                m_li5->RSSetShadingRate(r, nullptr);
+            }
+        }
         void CommandBuffer::draw_indexed_instanced(u32 index_count_per_instance, u32 instance_count, u32 start_index_location, i32 base_vertex_location, u32 start_instance_location)
         {
             lutsassert();
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_li->DrawIndexedInstanced(index_count_per_instance, instance_count, start_index_location, base_vertex_location, start_instance_location);
         }
+        void CommandBuffer::execute_indirect(D3D12_INDIRECT_ARGUMENT_TYPE type, IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+            IBuffer* count_buffer, u64 count_buffer_offset)
+        {
+            auto signature = m_device->get_command_signature(type, stride);
+            if (failed(signature))
+            {
+                lupanic_msg("Failed to create D3D12 command signature.");
+                return;
+            }
+            BufferResource* res = cast_object<BufferResource>(buffer->get_object());
+            ID3D12Resource* count_res = count_buffer ? cast_object<BufferResource>(count_buffer->get_object())->m_res.Get() : nullptr;
+            m_li->ExecuteIndirect(signature.get(), max_draw_count, res->m_res.Get(), offset, count_res, count_buffer_offset);
+        }
+        void CommandBuffer::draw_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+            IBuffer* count_buffer, u64 count_buffer_offset)
+        {
+            lutsassert();
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            execute_indirect(D3D12_INDIRECT_ARGUMENT_TYPE_DRAW, buffer, offset, max_draw_count, stride, count_buffer, count_buffer_offset);
+        }
+        void CommandBuffer::draw_indexed_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+            IBuffer* count_buffer, u64 count_buffer_offset)
+        {
+            lutsassert();
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            execute_indirect(D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED, buffer, offset, max_draw_count, stride, count_buffer, count_buffer_offset);
+        }
         void CommandBuffer::draw_instanced(u32 vertex_count_per_instance, u32 instance_count, u32 start_vertex_location,
             u32 start_instance_location)
         {
             lutsassert();
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_li->DrawInstanced(vertex_count_per_instance, instance_count, start_vertex_location, start_instance_location);
         }
+        void CommandBuffer::dispatch_mesh(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z)
+        {
+            lutsassert();
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            lucheck_msg(m_li6, "dispatch_mesh requires DeviceFeature::mesh_shader.");
+            m_li6->DispatchMesh(thread_group_count_x, thread_group_count_y, thread_group_count_z);
+        }
         void CommandBuffer::begin_occlusion_query(OcclusionQueryMode mode, u32 index)
         {
             lutsassert();
@@ -598,6 +838,33 @@ namespace Luna
         {
             lutsassert();
             assert_graphcis_context();
+            if (m_bundle)
+            {
+                HRESULT hr = m_li->Close();
+                if (FAILED(hr))
+                {
+                    lupanic_msg_always("ID3D12GraphicsCommandList::Close failed.");
+                }
+                m_cmdlist_closed = true;
+                m_render_pass_context.m_valid = false;
+                return;
+            }
+            for (auto& bundle : m_bundles)
+            {
+                lucheck_msg(bundle->m_cmdlist_closed, "All secondary command buffers must finish recording before end_render_pass is called.");
+                if (!bundle->m_bundle_viewports.empty())
+                {
+                    m_li->RSSetViewports((UINT)bundle->m_bundle_viewports.size(), bundle->m_bundle_viewports.data());
+                }
+                if (!bundle->m_bundle_scissor_rects.empty())
+                {
+                    m_li->RSSetScissorRects((UINT)bundle->m_bundle_scissor_rects.size(), bundle->m_bundle_scissor_rects.data());
+                }
+                m_li->ExecuteBundle(bundle->m_li.Get());
+                // Keeps bundles alive until this command buffer is reset.
+                attach_device_object(bundle.get());
+            }
+            m_bundles.clear();
             // Emit barrier.
             Vector<D3D12_RESOURCE_BARRIER> barriers;
             for (u32 i = 0; i < m_render_pass_context.m_num_color_attachments; ++i)
@@ -677,6 +944,11 @@ namespace Luna
             {
                 end_pipeline_statistics_query(m_pipeline_statistics_query_heap_attachment, m_pipeline_statistics_query_index);
             }
+            if (m_render_pass_context.m_shading_rate_image_bound)
+            {
+                m_li5->RSSetShadingRateImage(nullptr);
+                m_render_pass_context.m_shading_rate_image_bound = false;
+            }
             m_occlusion_query_heap_attachment = nullptr;
             m_timestamp_query_heap_attachment = nullptr;
             m_timestamp_query_begin_index = DONT_QUERY;
@@ -688,6 +960,7 @@ namespace Luna
         void CommandBuffer::begin_compute_pass(const ComputePassDesc& desc)
         {
             lutsassert();
+            ++m_statistics.num_compute_passes;
             assert_no_context();
             m_compute_pass_begin = true;
             m_timestamp_query_heap_attachment = desc.timestamp_query_heap;
@@ -715,6 +988,7 @@ namespace Luna
         }
         void CommandBuffer::set_compute_pipeline_state(IPipelineState* pso)
         {
+            ++m_statistics.num_pipeline_state_binds;
             PipelineState* p = cast_object<PipelineState>(pso->get_object());
             lutsassert();
             assert_compute_context();
@@ -723,6 +997,7 @@ namespace Luna
         void CommandBuffer::set_compute_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets)
         {
             lutsassert();
+            m_statistics.num_descriptor_set_binds += (u32)descriptor_sets.size();
             assert_compute_context();
             lucheck_msg(m_compute_pipeline_layout, "Compute pipeline layout must be set before Compute Descriptor Set can be attached.");
             lucheck_msg(m_compute_pipeline_layout->m_descriptor_set_layouts.size() > start_index, "The binding index out of range specified by the pipeline layout.");
@@ -761,12 +1036,59 @@ namespace Luna
                 }
             }
         }
+        void CommandBuffer::set_compute_constants(u32 first_constant, u32 num_constants, const void* data)
+        {
+            lutsassert();
+            assert_compute_context();
+            lucheck_msg(m_compute_pipeline_layout, "Compute pipeline layout must be set before compute constants can be set.");
+            lucheck_msg(m_compute_pipeline_layout->m_constants_root_parameter_index != U32_MAX, "The pipeline layout does not have constants.");
+            m_li->SetComputeRoot32BitConstants(m_compute_pipeline_layout->m_constants_root_parameter_index, num_constants, data, first_constant);
+        }
         void CommandBuffer::dispatch(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z)
         {
             lutsassert();
+            ++m_statistics.num_dispatches;
             assert_compute_context();
+            flush_barriers();
             m_li->Dispatch(thread_group_count_x, thread_group_count_y, thread_group_count_z);
         }
+        void CommandBuffer::dispatch_indirect(IBuffer* buffer, u64 offset)
+        {
+            lutsassert();
+            ++m_statistics.num_dispatches;
+            assert_compute_context();
+            flush_barriers();
+            execute_indirect(D3D12_INDIRECT_ARGUMENT_TYPE_DISPATCH, buffer, offset, 1, sizeof(DispatchIndirectArguments), nullptr, 0);
+        }
+        void CommandBuffer::build_acceleration_structure(IAccelerationStructure* dst, const AccelerationStructureBuildInputs& inputs,
+            IBuffer* scratch_buffer, u64 scratch_buffer_offset, IAccelerationStructure* update_src)
+        {
+            lutsassert();
+            ++m_statistics.num_acceleration_structure_builds;
+            assert_compute_context();
+            lucheck_msg(m_li4, "build_acceleration_structure requires DeviceFeature::ray_tracing.");
+            flush_barriers();
+            AccelerationStructure* d = cast_object<AccelerationStructure>(dst->get_object());
+            BufferResource* scratch = cast_object<BufferResource>(scratch_buffer->get_object());
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_DESC desc = {};
+            Vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometries;
+            encode_acceleration_structure_inputs(inputs, desc.Inputs, geometries);
+            if (update_src)
+            {
+                AccelerationStructure* src = cast_object<AccelerationStructure>(update_src->get_object());
+                desc.Inputs.Flags |= D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BUILD_FLAG_PERFORM_UPDATE;
+                desc.SourceAccelerationStructureData = src->m_res->GetGPUVirtualAddress();
+            }
+            desc.DestAccelerationStructureData = d->m_res->GetGPUVirtualAddress();
+            desc.ScratchAccelerationStructureData = scratch->m_res->GetGPUVirtualAddress() + scratch_buffer_offset;
+            m_li4->BuildRaytracingAccelerationStructure(&desc, 0, nullptr);
+            // Succeeding builds and shaders may read the acceleration structure.
+            D3D12_RESOURCE_BARRIER barrier;
+            barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+            barrier.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE;
+            barrier.UAV.pResource = d->m_res.Get();
+            m_li->ResourceBarrier(1, &barrier);
+        }
         void CommandBuffer::end_compute_pass()
         {
             lutsassert();
@@ -789,6 +1111,7 @@ namespace Luna
         void CommandBuffer::begin_copy_pass(const CopyPassDesc& desc)
         {
             lutsassert();
+            ++m_statistics.num_copy_passes;
             assert_no_context();
             m_copy_pass_begin = true;
             m_timestamp_query_heap_attachment = desc.timestamp_query_heap;
@@ -802,7 +1125,9 @@ namespace Luna
         void CommandBuffer::copy_resource(IResource* dst, IResource* src)
         {
             lutsassert();
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             lucheck(dst && src);
             {
                 BufferResource* d = cast_object<BufferResource>(dst->get_object());
@@ -828,7 +1153,9 @@ namespace Luna
             u64 copy_bytes)
         {
             lutsassert();
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             BufferResource* d = cast_object<BufferResource>(dst->get_object());
             BufferResource* s = cast_object<BufferResource>(src->get_object());
             m_li->CopyBufferRegion(d->m_res.Get(), dst_offset, s->m_res.Get(), src_offset, copy_bytes);
@@ -839,7 +1166,9 @@ namespace Luna
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
             lutsassert();
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             TextureResource* d = cast_object<TextureResource>(dst->get_object());
             TextureResource* s = cast_object<TextureResource>(src->get_object());
             D3D12_TEXTURE_COPY_LOCATION dsttex;
@@ -865,7 +1194,9 @@ namespace Luna
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
             lutsassert();
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             TextureResource* d = cast_object<TextureResource>(dst->get_object());
             BufferResource* s = cast_object<BufferResource>(src->get_object());
             D3D12_TEXTURE_COPY_LOCATION dsttex;
@@ -897,7 +1228,9 @@ namespace Luna
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
             lutsassert();
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             BufferResource* d = cast_object<BufferResource>(dst->get_object());
             TextureResource* s = cast_object<TextureResource>(src->get_object());
             D3D12_TEXTURE_COPY_LOCATION dsttex;
@@ -939,8 +1272,10 @@ namespace Luna
         void CommandBuffer::resource_barrier(Span<const BufferBarrier> buffer_barriers, Span<const TextureBarrier> texture_barriers)
         {
             lutsassert();
+            m_statistics.num_barriers += (u32)(buffer_barriers.size() + texture_barriers.size());
             assert_non_render_pass();
-            m_tracking_system.begin_new_barrier_batch();
+            // Barriers are deferred to the next command that accesses resources, so that barriers of successive 
+            // calls are submitted in one call.
             for (auto& barrier : buffer_barriers)
             {
                 m_tracking_system.pack_buffer(barrier);
@@ -949,15 +1284,24 @@ namespace Luna
             {
                 m_tracking_system.pack_texture(barrier);
             }
+        }
+        void CommandBuffer::flush_barriers()
+        {
+            if (m_tracking_system.m_barriers.empty()) return;
+            m_tracking_system.remove_redundant_barriers();
             if (!m_tracking_system.m_barriers.empty())
             {
                 m_li->ResourceBarrier((UINT)m_tracking_system.m_barriers.size(), m_tracking_system.m_barriers.data());
             }
+            m_tracking_system.begin_new_barrier_batch();
         }
-        RV CommandBuffer::submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting)
+        RV CommandBuffer::submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting,
+            Span<const u64> wait_values, Span<const u64> signal_values)
         {
             lutsassert();
+            lucheck_msg(!m_bundle, "Secondary command buffers cannot be submitted directly.");
             assert_no_context();
+            flush_barriers();
             HRESULT hr;
             hr = m_li->Close();
             if (FAILED(hr)) return encode_hresult(hr);
@@ -965,10 +1309,11 @@ namespace Luna
 
             auto& queue = m_device->m_command_queues[m_queue];
 
-            for (IFence* f : wait_fences)
+            for (usize i = 0; i < wait_fences.size(); ++i)
             {
-                Fence* fence = cast_object<Fence>(f->get_object());
-                queue->m_command_queue->Wait(fence->m_fence.Get(), fence->m_wait_value);
+                Fence* fence = cast_object<Fence>(wait_fences[i]->get_object());
+                u64 value = fence->m_type == FenceType::timeline ? wait_values[i] : fence->m_wait_value;
+                queue->m_command_queue->Wait(fence->m_fence.Get(), value);
             }
 
             // Resolve barriers.
@@ -1013,13 +1358,22 @@ namespace Luna
                 hr = queue->m_command_queue->Signal(m_fence.Get(), m_wait_value);
                 if (FAILED(hr)) return encode_hresult(hr);
             }
-            for (IFence* f : signal_fences)
+            for (usize i = 0; i < signal_fences.size(); ++i)
             {
-                Fence* fence = cast_object<Fence>(f->get_object());
-                ++fence->m_wait_value;
-                hr = queue->m_command_queue->Signal(fence->m_fence.Get(), fence->m_wait_value);
+                Fence* fence = cast_object<Fence>(signal_fences[i]->get_object());
+                u64 value;
+                if (fence->m_type == FenceType::timeline)
+                {
+                    value = signal_values[i];
+                }
+                else
+                {
+                    value = ++fence->m_wait_value;
+                }
+                hr = queue->m_command_queue->Signal(fence->m_fence.Get(), value);
                 if (FAILED(hr)) return encode_hresult(hr);
             }
+            m_device->m_statistics.on_command_buffer_submitted(this, m_statistics);
             return ok;
         }
     }
@@ -56,6 +56,10 @@ namespace Luna
 
             //! Packed barriers.
             Vector<D3D12_RESOURCE_BARRIER> m_barriers;
+            //! The index of the transition barrier of every resource in the current batch. Successive transitions of one resource
+            //! in the same batch are merged into one transition, since the resource is not accessed between them.
+            HashMap<BufferResource*, usize> m_buffer_barrier_indices;
+            HashMap<TextureKey, usize> m_texture_barrier_indices;
 
             ResourceStateTrackingSystem() {}
 
@@ -73,13 +77,19 @@ namespace Luna
                 m_unresolved_texture_states.clear();
                 m_current_buffer_states.clear();
                 m_current_texture_states.clear();
+                begin_new_barrier_batch();
             }
 
             void begin_new_barrier_batch()
             {
                 m_barriers.clear();
+                m_buffer_barrier_indices.clear();
+                m_texture_barrier_indices.clear();
             }
 
+            //! Removes transitions whose before and after states become equal after merging from the current batch.
+            void remove_redundant_barriers();
+
             /*R<ResourceState> get_state(Resource* res, u32 subresource)
             {
                 ResourceKey k;
@@ -112,6 +122,7 @@ namespace Luna
             ResolveAttachment m_resolve_attachments[8];
             ID3D12DescriptorHeap* m_depth_stencil_attachment = nullptr;
             u8 m_num_color_attachments;
+            bool m_shading_rate_image_bound = false;
         };
 
         struct CommandBuffer : ICommandBuffer
@@ -128,6 +139,12 @@ namespace Luna
 
             ComPtr<ID3D12CommandAllocator> m_ca;
             ComPtr<ID3D12GraphicsCommandList> m_li;
+            // Used to dispatch mesh shaders, may be `nullptr` if mesh shaders are not supported.
+            ComPtr<ID3D12GraphicsCommandList6> m_li6;
+            // Used to build acceleration structures, may be `nullptr` if ray tracing is not supported.
+            ComPtr<ID3D12GraphicsCommandList4> m_li4;
+            // Used to set shading rates, may be `nullptr` if variable rate shading is not supported.
+            ComPtr<ID3D12GraphicsCommandList5> m_li5;
 
             //! The fence used for wait/set from GPU 
             ComPtr<ID3D12Fence> m_fence;
@@ -170,6 +187,17 @@ namespace Luna
 
             bool m_heap_set;
 
+            //! Whether this command buffer is one secondary command buffer implemented by one bundle.
+            bool m_bundle = false;
+            //! The bundles to execute when the current render pass ends.
+            Vector<Ref<CommandBuffer>> m_bundles;
+            //! Viewports and scissor rects set on bundles. Bundles cannot set these states, so they are 
+            //! set on the primary command list before the bundle is executed.
+            Vector<D3D12_VIEWPORT> m_bundle_viewports;
+            Vector<D3D12_RECT> m_bundle_scissor_rects;
+
+            CommandBufferStatistics m_statistics;
+
             CommandBuffer() :
                 m_event(NULL),
                 m_cmdlist_closed(false),
@@ -184,7 +212,12 @@ namespace Luna
                 }
             }
 
-            RV init();
+            RV init(bool bundle = false);
+            //! Begins recording one bundle in the render pass of the primary command buffer.
+            RV begin_bundle(const RenderPassContext& render_pass_context);
+
+            void execute_indirect(D3D12_INDIRECT_ARGUMENT_TYPE type, IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+                IBuffer* count_buffer, u64 count_buffer_offset);
 
             void assert_graphcis_context()
             {
@@ -206,11 +239,14 @@ namespace Luna
             {
                 lucheck_msg(!m_render_pass_context.m_valid && !m_copy_pass_begin && !m_compute_pass_begin, "This command cannot be only be submitted when no pass is open");
             }
+            //! Records all barriers deferred by `resource_barrier` in one call.
+            void flush_barriers();
             void write_timestamp(IQueryHeap* heap, u32 index);
             void begin_pipeline_statistics_query(IQueryHeap* heap, u32 index);
             void end_pipeline_statistics_query(IQueryHeap* heap, u32 index);
             virtual void wait() override
             {
+                if (m_bundle) return;
                 DWORD res = ::WaitForSingleObject(m_event, INFINITE);
                 if (res != WAIT_OBJECT_0)
                 {
@@ -219,6 +255,7 @@ namespace Luna
             }
             virtual bool try_wait() override
             {
+                if (m_bundle) return true;
                 DWORD res = ::WaitForSingleObject(m_event, 0);
                 if (res == WAIT_OBJECT_0)
                 {
@@ -240,6 +277,10 @@ namespace Luna
             {
                 m_objs.push_back(obj);
             }
+            virtual CommandBufferStatistics get_statistics() override
+            {
+                return m_statistics;
+            }
             virtual void begin_event(const c8* event_name) override
             {
                 usize len = utf8_to_utf16_len(event_name);
@@ -252,6 +293,7 @@ namespace Luna
                 m_li->EndEvent();
             }
             virtual void begin_render_pass(const RenderPassDesc& desc) override;
+            virtual void begin_parallel_render_pass(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers) override;
             virtual void set_graphics_pipeline_layout(IPipelineLayout* pipeline_layout) override;
             virtual void set_graphics_pipeline_state(IPipelineState* pso) override;
             virtual void set_vertex_buffers(u32 start_slot, Span<const VertexBufferView> views) override;
@@ -261,6 +303,7 @@ namespace Luna
                 set_graphics_descriptor_sets(start_index, { &descriptor_set, 1 });
             }
             virtual void set_graphics_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) override;
+            virtual void set_graphics_constants(u32 first_constant, u32 num_constants, const void* data) override;
             virtual void set_viewport(const Viewport& viewport) override
             {
                 set_viewports({ &viewport, 1 });
@@ -273,6 +316,7 @@ namespace Luna
             virtual void set_scissor_rects(Span<const RectI> rects) override;
             virtual void set_blend_factor(const Float4U& blend_factor) override;
             virtual void set_stencil_ref(u32 stencil_ref) override;
+            virtual void set_shading_rate(ShadingRate rate, ShadingRateCombiner primitive_combiner, ShadingRateCombiner image_combiner) override;
             virtual void draw(u32 vertex_count, u32 start_vertex_location) override
             {
                 draw_instanced(vertex_count, 1, start_vertex_location, 0);
@@ -283,8 +327,13 @@ namespace Luna
             }
             virtual void draw_indexed_instanced(u32 index_count_per_instance, u32 instance_count, u32 start_index_location,
                 i32 base_vertex_location, u32 start_instance_location) override;
+            virtual void draw_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+                IBuffer* count_buffer, u64 count_buffer_offset) override;
+            virtual void draw_indexed_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+                IBuffer* count_buffer, u64 count_buffer_offset) override;
             virtual void draw_instanced(u32 vertex_count_per_instance, u32 instance_count, u32 start_vertex_location,
                 u32 start_instance_location) override;
+            virtual void dispatch_mesh(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) override;
             virtual void begin_occlusion_query(OcclusionQueryMode mode, u32 index) override;
             virtual void end_occlusion_query(u32 index) override;
             virtual void end_render_pass() override;
@@ -296,7 +345,11 @@ namespace Luna
                 set_compute_descriptor_sets(start_index, { &descriptor_set, 1 });
             }
             virtual void set_compute_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) override;
+            virtual void set_compute_constants(u32 first_constant, u32 num_constants, const void* data) override;
             virtual void dispatch(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) override;
+            virtual void dispatch_indirect(IBuffer* buffer, u64 offset) override;
+            virtual void build_acceleration_structure(IAccelerationStructure* dst, const AccelerationStructureBuildInputs& inputs,
+                IBuffer* scratch_buffer, u64 scratch_buffer_offset, IAccelerationStructure* update_src) override;
             virtual void end_compute_pass() override;
             virtual void begin_copy_pass(const CopyPassDesc& desc) override;
             virtual void copy_resource(IResource* dst, IResource* src) override;
@@ -318,7 +371,8 @@ namespace Luna
                 u32 copy_width, u32 copy_height, u32 copy_depth) override;
             virtual void end_copy_pass() override;
             virtual void resource_barrier(Span<const BufferBarrier> buffer_barriers, Span<const TextureBarrier> texture_barriers) override;
-            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting) override;
+            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting,
+                Span<const u64> wait_values, Span<const u64> signal_values) override;
         };
     }
 }
\ No newline at end of file
@@ -41,11 +41,13 @@ namespace Luna
                 test_flags(s, BufferStateFlag::uniform_buffer_ps))  r |= D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER;
             if (test_flags(s, BufferStateFlag::index_buffer)) r |= D3D12_RESOURCE_STATE_INDEX_BUFFER;
             if (test_flags(s, BufferStateFlag::shader_write_ps) ||
-                test_flags(s, BufferStateFlag::shader_write_cs)) r |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
+                test_flags(s, BufferStateFlag::shader_write_cs) ||
+                test_flags(s, BufferStateFlag::acceleration_structure_scratch)) r |= D3D12_RESOURCE_STATE_UNORDERED_ACCESS;
             if((r & D3D12_RESOURCE_STATE_UNORDERED_ACCESS) == 0)
             {
                 if (test_flags(s, BufferStateFlag::shader_read_vs) ||
-                    test_flags(s, BufferStateFlag::shader_read_cs)) r |= D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
+                    test_flags(s, BufferStateFlag::shader_read_cs) ||
+                    test_flags(s, BufferStateFlag::acceleration_structure_build_input)) r |= D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE;
                 if (test_flags(s, BufferStateFlag::shader_read_ps)) r |= D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE;
             }
             if (test_flags(s, BufferStateFlag::copy_dest)) r |= D3D12_RESOURCE_STATE_COPY_DEST;
@@ -71,6 +73,7 @@ namespace Luna
             }
             if (test_flags(s, TextureStateFlag::copy_dest)) r |= D3D12_RESOURCE_STATE_COPY_DEST;
             if (test_flags(s, TextureStateFlag::copy_source)) r |= D3D12_RESOURCE_STATE_COPY_SOURCE;
+            if (test_flags(s, TextureStateFlag::shading_rate_image)) r |= D3D12_RESOURCE_STATE_SHADING_RATE_SOURCE;
             if (test_flags(s, TextureStateFlag::present)) r |= D3D12_RESOURCE_STATE_PRESENT;
             return r;
         }
@@ -160,7 +163,8 @@ namespace Luna
             rd.SampleDesc.Quality = 0;
             rd.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
             rd.Flags = D3D12_RESOURCE_FLAG_NONE;
-            if ((desc.usages & BufferUsageFlag::read_write_buffer) != BufferUsageFlag::none)
+            if (test_flags(desc.usages, BufferUsageFlag::read_write_buffer) || 
+                test_flags(desc.usages, BufferUsageFlag::acceleration_structure_scratch))
             {
                 rd.Flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
             }
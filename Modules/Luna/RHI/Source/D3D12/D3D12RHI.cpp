@@ -24,8 +24,11 @@
 #include "SwapChain.hpp"
 #include "DescriptorSet.hpp"
 #include "DescriptorSetLayout.hpp"
+#include "DescriptorSetArena.hpp"
 #include "QueryHeap.hpp"
+#include "PipelineCache.hpp"
 #include "Fence.hpp"
+#include "AccelerationStructure.hpp"
 #include "Adapter.hpp"
 
 namespace Luna
@@ -59,10 +62,16 @@ namespace Luna
             impl_interface_for_type<DescriptorSetLayout, IDescriptorSetLayout, IDeviceChild>();
             register_boxed_type<DescriptorSet>();
             impl_interface_for_type<DescriptorSet, IDescriptorSet, IDeviceChild>();
+            register_boxed_type<DescriptorSetArena>();
+            impl_interface_for_type<DescriptorSetArena, IDescriptorSetArena, IDeviceChild>();
             register_boxed_type<QueryHeap>();
             impl_interface_for_type<QueryHeap, IQueryHeap, IDeviceChild>();
+            register_boxed_type<PipelineCache>();
+            impl_interface_for_type<PipelineCache, IPipelineCache, IDeviceChild>();
             register_boxed_type<Fence>();
             impl_interface_for_type<Fence, IFence, IDeviceChild>();
+            register_boxed_type<AccelerationStructure>();
+            impl_interface_for_type<AccelerationStructure, IAccelerationStructure, IDeviceChild>();
 
             HRESULT hr = ::CreateDXGIFactory1(IID_PPV_ARGS(&g_dxgi));
             if (FAILED(hr))
@@ -11,26 +11,32 @@
 #define LUNA_RHI_API LUNA_EXPORT
 #include "DescriptorSet.hpp"
 #include "DescriptorSetLayout.hpp"
+#include "AccelerationStructure.hpp"
 
 namespace Luna
 {
     namespace RHI
     {
-        RV DescriptorSet::init(const DescriptorSetDesc& desc)
+        RV DescriptorSet::init(const DescriptorSetDesc& desc, DescriptorSetArena* arena)
         {
             DescriptorSetLayout* layout = static_cast<DescriptorSetLayout*>(desc.layout->get_object());
             {
                 m_view_heap_size = layout->m_view_heap.m_size;
                 if(layout->m_view_heap.m_variable) m_view_heap_size += desc.num_variable_descriptors;
-                if (m_view_heap_size) m_view_heap_offset = m_device->m_cbv_srv_uav_heap.allocate_descs(m_view_heap_size);
+                if (m_view_heap_size) m_view_heap_offset = arena ? 
+                    arena->m_view_heap.allocate_descs(m_view_heap_size) : 
+                    m_device->m_cbv_srv_uav_heap.allocate_descs(m_view_heap_size);
                 else m_view_heap_offset = 0;
             }
             {
                 m_sampler_heap_size = layout->m_sampler_heap.m_size;
                 if (layout->m_sampler_heap.m_variable) m_sampler_heap_size += desc.num_variable_descriptors;
-                if (m_sampler_heap_size) m_sampler_heap_offset = m_device->m_sampler_heap.allocate_descs(m_sampler_heap_size);
+                if (m_sampler_heap_size) m_sampler_heap_offset = arena ? 
+                    arena->m_sampler_heap.allocate_descs(m_sampler_heap_size) : 
+                    m_device->m_sampler_heap.allocate_descs(m_sampler_heap_size);
                 else m_sampler_heap_offset = 0;
             }
+            m_transient = arena != nullptr;
             for (auto i = 0; i < layout->m_bindings.size(); ++i)
             {
                 auto& binding = layout->m_bindings[i];
@@ -40,6 +46,7 @@ namespace Luna
         }
         DescriptorSet::~DescriptorSet()
         {
+            if (m_transient) return;
             if (m_view_heap_size)
             {
                 m_device->m_cbv_srv_uav_heap.free_descs(m_view_heap_offset, m_view_heap_size);
@@ -51,6 +58,7 @@ namespace Luna
         }
         RV DescriptorSet::update_descriptors(Span<const WriteDescriptorSet> writes)
         {
+            m_device->m_statistics.on_descriptors_written(writes);
             for (auto& write : writes)
             {
                 switch (write.type)
@@ -73,6 +81,9 @@ namespace Luna
                 case DescriptorType::sampler:
                     set_sampler_array(write.binding_slot, write.first_array_index, write.num_descs, write.samplers);
                     break;
+                case DescriptorType::acceleration_structure:
+                    set_acceleration_structure_array(write.binding_slot, write.first_array_index, write.num_descs, write.acceleration_structures);
+                    break;
                 }
             }
             return ok;
@@ -336,5 +347,27 @@ namespace Luna
                 m_device->m_device->CreateSampler(&d, h);
             }
         }
+        void DescriptorSet::set_acceleration_structure_array(u32 binding_slot, u32 offset, u32 num_descs, IAccelerationStructure* const* acceleration_structures)
+        {
+            lutsassert();
+            auto iter = m_bound_index_to_offset.find(binding_slot);
+            lucheck_msg(iter != m_bound_index_to_offset.end(), "Invalid binding slot");
+            u32 index = iter->second;
+            for (usize i = 0; i < num_descs; ++i)
+            {
+                AccelerationStructure* as = cast_object<AccelerationStructure>(acceleration_structures[i]->get_object());
+                lucheck(as);
+                usize addr = m_device->m_cbv_srv_uav_heap.m_cpu_handle.ptr + (m_view_heap_offset + index + offset + i) * m_device->m_cbv_srv_uav_heap.m_descriptor_size;
+                D3D12_CPU_DESCRIPTOR_HANDLE h;
+                h.ptr = addr;
+                D3D12_SHADER_RESOURCE_VIEW_DESC d;
+                d.Format = DXGI_FORMAT_UNKNOWN;
+                d.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+                d.ViewDimension = D3D12_SRV_DIMENSION_RAYTRACING_ACCELERATION_STRUCTURE;
+                d.RaytracingAccelerationStructure.Location = as->m_res->GetGPUVirtualAddress();
+                // The resource must be NULL for acceleration structure views, the address is specified in the view descriptor.
+                m_device->m_device->CreateShaderResourceView(nullptr, &d, h);
+            }
+        }
     }
 }
\ No newline at end of file
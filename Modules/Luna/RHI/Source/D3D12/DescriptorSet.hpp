@@ -12,6 +12,7 @@
 #include "Device.hpp"
 #include "Resource.hpp"
 #include "PipelineLayout.hpp"
+#include "DescriptorSetArena.hpp"
 
 namespace Luna
 {
@@ -31,9 +32,13 @@ namespace Luna
             u32 m_view_heap_size;
             u32 m_sampler_heap_size;
 
+            // `true` if descriptors of this set are allocated from one descriptor set arena, 
+            // and should not be freed individually.
+            bool m_transient = false;
+
             HashMap<u32, u32> m_bound_index_to_offset;
 
-            RV init(const DescriptorSetDesc& desc);
+            RV init(const DescriptorSetDesc& desc, DescriptorSetArena* arena = nullptr);
             ~DescriptorSet();
 
             virtual IDevice* get_device() override
@@ -49,6 +54,7 @@ namespace Luna
             void set_buffer_uav_array(u32 binding_slot, u32 offset, u32 num_descs, const BufferViewDesc* descs);
             void set_texture_uav_array(u32 binding_slot, u32 offset, u32 num_descs, const TextureViewDesc* descs);
             void set_sampler_array(u32 binding_slot, u32 offset, u32 num_samplers, const SamplerDesc* samplers);
+            void set_acceleration_structure_array(u32 binding_slot, u32 offset, u32 num_descs, IAccelerationStructure* const* acceleration_structures);
         };
     }
 }
\ No newline at end of file
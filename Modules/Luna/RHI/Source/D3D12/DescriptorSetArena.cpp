@@ -0,0 +1,85 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file DescriptorSetArena.cpp
+* @author JXMaster
+* @date 2024/4/1
+*/
+#include "DescriptorSetArena.hpp"
+#include "DescriptorSet.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        u32 DescriptorArenaHeap::allocate_descs(u32 count)
+        {
+            while (m_current_chunk < m_chunks.size())
+            {
+                Chunk& chunk = m_chunks[m_current_chunk];
+                if (chunk.size - m_current_offset >= count)
+                {
+                    u32 ret = chunk.offset + m_current_offset;
+                    m_current_offset += count;
+                    return ret;
+                }
+                ++m_current_chunk;
+                m_current_offset = 0;
+            }
+            // Allocates one new chunk from the device heap. Only this operation locks the device heap.
+            Chunk chunk;
+            chunk.size = max(count, m_chunk_size);
+            chunk.offset = m_heap->allocate_descs(chunk.size);
+            m_chunks.push_back(chunk);
+            m_current_chunk = m_chunks.size() - 1;
+            m_current_offset = count;
+            return chunk.offset;
+        }
+        void DescriptorArenaHeap::reset()
+        {
+            m_current_chunk = 0;
+            m_current_offset = 0;
+        }
+        void DescriptorArenaHeap::release()
+        {
+            for (auto& chunk : m_chunks)
+            {
+                m_heap->free_descs(chunk.offset, chunk.size);
+            }
+            m_chunks.clear();
+            reset();
+        }
+        void DescriptorSetArena::init()
+        {
+            m_view_heap.m_heap = &m_device->m_cbv_srv_uav_heap;
+            m_view_heap.m_chunk_size = 1024;
+            m_sampler_heap.m_heap = &m_device->m_sampler_heap;
+            m_sampler_heap.m_chunk_size = 64;
+        }
+        DescriptorSetArena::~DescriptorSetArena()
+        {
+            m_view_heap.release();
+            m_sampler_heap.release();
+        }
+        R<Ref<IDescriptorSet>> DescriptorSetArena::new_descriptor_set(const DescriptorSetDesc& desc)
+        {
+            lutsassert();
+            Ref<DescriptorSet> ds = new_object<DescriptorSet>();
+            ds->m_device = m_device;
+            RV r = ds->init(desc, this);
+            if (!r.valid())
+            {
+                return r.errcode();
+            }
+            return Ref<IDescriptorSet>(ds);
+        }
+        void DescriptorSetArena::reset()
+        {
+            lutsassert();
+            m_view_heap.reset();
+            m_sampler_heap.reset();
+        }
+    }
+}
@@ -0,0 +1,61 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file DescriptorSetArena.hpp
+* @author JXMaster
+* @date 2024/4/1
+*/
+#pragma once
+#include "Device.hpp"
+#include <Luna/Runtime/TSAssert.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! Suballocates descriptors linearly from chunks of one shader-visible descriptor heap.
+        struct DescriptorArenaHeap
+        {
+            struct Chunk
+            {
+                u32 offset;
+                u32 size;
+            };
+            ShaderSourceDescriptorHeap* m_heap = nullptr;
+            u32 m_chunk_size = 0;
+            Vector<Chunk> m_chunks;
+            // The chunk that descriptors are allocated from.
+            usize m_current_chunk = 0;
+            // The number of descriptors allocated from the current chunk.
+            u32 m_current_offset = 0;
+
+            u32 allocate_descs(u32 count);
+            void reset();
+            void release();
+        };
+
+        struct DescriptorSetArena : IDescriptorSetArena
+        {
+            lustruct("RHI::DescriptorSetArena", "{3F8D6A21-B07E-4C59-9E14-D25A7C0B86F3}");
+            luiimpl();
+            lutsassert_lock();
+
+            Ref<Device> m_device;
+            DescriptorArenaHeap m_view_heap;
+            DescriptorArenaHeap m_sampler_heap;
+
+            void init();
+            ~DescriptorSetArena();
+
+            virtual IDevice* get_device() override
+            {
+                return m_device.as<IDevice>();
+            }
+            virtual void set_name(const c8* name) override {}
+            virtual R<Ref<IDescriptorSet>> new_descriptor_set(const DescriptorSetDesc& desc) override;
+            virtual void reset() override;
+        };
+    }
+}
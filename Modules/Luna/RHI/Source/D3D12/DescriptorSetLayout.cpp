@@ -18,6 +18,7 @@ namespace Luna
             {
             case DescriptorType::read_buffer_view:
             case DescriptorType::read_texture_view:
+            case DescriptorType::acceleration_structure:
                 return D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
             case DescriptorType::read_write_buffer_view:
             case DescriptorType::read_write_texture_view:
@@ -41,6 +42,12 @@ namespace Luna
             case ShaderVisibilityFlag::vertex:
                 return D3D12_SHADER_VISIBILITY_VERTEX;
                 break;
+            case ShaderVisibilityFlag::mesh:
+                return D3D12_SHADER_VISIBILITY_MESH;
+                break;
+            case ShaderVisibilityFlag::amplification:
+                return D3D12_SHADER_VISIBILITY_AMPLIFICATION;
+                break;
             default:
                 return D3D12_SHADER_VISIBILITY_ALL;
             }
@@ -75,6 +82,7 @@ namespace Luna
                 case DescriptorType::read_write_buffer_view:
                 case DescriptorType::read_write_texture_view:
                 case DescriptorType::uniform_buffer_view:
+                case DescriptorType::acceleration_structure:
                     binding.target_heap = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV; break;
                 case DescriptorType::sampler:
                     binding.target_heap = D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER; break;
@@ -148,7 +156,8 @@ namespace Luna
                 desc_type == DescriptorType::read_texture_view ||
                 desc_type == DescriptorType::read_write_buffer_view ||
                 desc_type == DescriptorType::read_write_texture_view ||
-                desc_type == DescriptorType::uniform_buffer_view)
+                desc_type == DescriptorType::uniform_buffer_view ||
+                desc_type == DescriptorType::acceleration_structure)
                 ) return true;
             if ((root_type == D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER) && (
                 desc_type == DescriptorType::sampler
@@ -174,6 +183,7 @@ namespace Luna
             case DescriptorType::read_write_buffer_view:
             case DescriptorType::read_write_texture_view:
             case DescriptorType::uniform_buffer_view:
+            case DescriptorType::acceleration_structure:
                 info.m_type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
                 break;
             case DescriptorType::sampler:
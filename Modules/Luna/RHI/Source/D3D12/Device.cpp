@@ -11,8 +11,10 @@
 #define LUNA_RHI_API LUNA_EXPORT
 #include "Device.hpp"
 #include "PipelineState.hpp"
+#include "PipelineCache.hpp"
 #include "Resource.hpp"
 #include "DescriptorSet.hpp"
+#include "DescriptorSetArena.hpp"
 #include "PipelineLayout.hpp"
 #include "DescriptorSetLayout.hpp"
 #include "QueryHeap.hpp"
@@ -20,6 +22,7 @@
 #include "Fence.hpp"
 #include "SwapChain.hpp"
 #include "Adapter.hpp"
+#include "AccelerationStructure.hpp"
 
 namespace Luna
 {
@@ -188,6 +191,7 @@ namespace Luna
             lutry
             {
                 m_adapter = adapter;
+                if (FAILED(m_adapter.As(&m_adapter3))) m_adapter3.Reset();
                 luexp(encode_hresult(::D3D12CreateDevice(adapter, D3D_FEATURE_LEVEL_11_0, IID_PPV_ARGS(&m_device))));
                 D3D12MA::ALLOCATOR_DESC allocator_desc{};
                 allocator_desc.pDevice = m_device.Get();
@@ -197,6 +201,32 @@ namespace Luna
                 luexp(encode_hresult(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &m_feature_options, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))));
                 m_architecture.NodeIndex = 0;
                 luexp(encode_hresult(m_device->CheckFeatureSupport(D3D12_FEATURE_ARCHITECTURE, &m_architecture, sizeof(D3D12_FEATURE_DATA_ARCHITECTURE))));
+                if (FAILED(m_device.As(&m_device2))) m_device2.Reset();
+                {
+                    D3D12_FEATURE_DATA_D3D12_OPTIONS7 options7{};
+                    m_mesh_shader_supported = m_device2 && 
+                        SUCCEEDED(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS7, &options7, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS7))) &&
+                        options7.MeshShaderTier != D3D12_MESH_SHADER_TIER_NOT_SUPPORTED;
+                }
+                if (FAILED(m_device.As(&m_device5))) m_device5.Reset();
+                {
+                    // Ray queries require ray tracing tier 1.1.
+                    D3D12_FEATURE_DATA_D3D12_OPTIONS5 options5{};
+                    m_ray_tracing_supported = m_device5 &&
+                        SUCCEEDED(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS5, &options5, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS5))) &&
+                        options5.RaytracingTier >= D3D12_RAYTRACING_TIER_1_1;
+                }
+                {
+                    D3D12_FEATURE_DATA_D3D12_OPTIONS6 options6{};
+                    if (SUCCEEDED(m_device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS6, &options6, sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS6))))
+                    {
+                        m_variable_shading_rate_tier = options6.VariableShadingRateTier;
+                        // Shading rate images are only supported in tier 2.
+                        m_shading_rate_image_tile_size = options6.VariableShadingRateTier >= D3D12_VARIABLE_SHADING_RATE_TIER_2 ? 
+                            options6.ShadingRateImageTileSize : 0;
+                        m_additional_shading_rates_supported = options6.AdditionalShadingRatesSupported == TRUE;
+                    }
+                }
                 {
                     // Create 1 direct queue, 2 compute queues and 2 copy queues.
                     CommandQueueDesc desc;
@@ -243,6 +273,27 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        R<ID3D12CommandSignature*> Device::get_command_signature(D3D12_INDIRECT_ARGUMENT_TYPE type, u32 stride)
+        {
+            u64 key = ((u64)type << 32) | (u64)stride;
+            LockGuard guard(m_command_signatures_lock);
+            auto iter = m_command_signatures.find(key);
+            if (iter != m_command_signatures.end()) return iter->second.Get();
+            D3D12_INDIRECT_ARGUMENT_DESC argument;
+            argument.Type = type;
+            D3D12_COMMAND_SIGNATURE_DESC desc;
+            desc.ByteStride = stride;
+            desc.NumArgumentDescs = 1;
+            desc.pArgumentDescs = &argument;
+            desc.NodeMask = 0;
+            ComPtr<ID3D12CommandSignature> signature;
+            // The root signature is not required since the command signature only changes draw or dispatch arguments.
+            HRESULT hr = m_device->CreateCommandSignature(&desc, nullptr, IID_PPV_ARGS(&signature));
+            if (FAILED(hr)) return encode_hresult(hr).errcode();
+            ID3D12CommandSignature* r = signature.Get();
+            m_command_signatures.insert(make_pair(key, move(signature)));
+            return r;
+        }
         DeviceFeatureData Device::check_feature(DeviceFeature feature)
         {
             DeviceFeatureData ret;
@@ -257,6 +308,27 @@ namespace Luna
             case DeviceFeature::uniform_buffer_data_alignment:
                 ret.uniform_buffer_data_alignment = 256;
                 break;
+            case DeviceFeature::indirect_draw_count:
+                ret.indirect_draw_count = true;
+                break;
+            case DeviceFeature::timeline_fence:
+                ret.timeline_fence = true;
+                break;
+            case DeviceFeature::mesh_shader:
+                ret.mesh_shader = m_mesh_shader_supported;
+                break;
+            case DeviceFeature::ray_tracing:
+                ret.ray_tracing = m_ray_tracing_supported;
+                break;
+            case DeviceFeature::variable_rate_shading:
+                ret.variable_rate_shading = m_variable_shading_rate_tier != D3D12_VARIABLE_SHADING_RATE_TIER_NOT_SUPPORTED;
+                break;
+            case DeviceFeature::shading_rate_image_tile_size:
+                ret.shading_rate_image_tile_size = m_shading_rate_image_tile_size;
+                break;
+            case DeviceFeature::reserved_resources:
+                ret.reserved_resources = is_reserved_resources_supported();
+                break;
             default: lupanic();
             }
             return ret;
@@ -277,6 +349,7 @@ namespace Luna
         {
             Ref<BufferResource> res = new_object<BufferResource>();
             res->m_device = this;
+            m_statistics.on_buffer_created();
             RV r = res->init_as_committed(memory_type, desc);
             if (!r.valid())
             {
@@ -288,6 +361,7 @@ namespace Luna
         {
             Ref<TextureResource> res = new_object<TextureResource>();
             res->m_device = this;
+            m_statistics.on_texture_created();
             RV r = res->init_as_committed(memory_type, desc, optimized_clear_value);
             if (!r.valid())
             {
@@ -365,6 +439,7 @@ namespace Luna
                 auto memory = new_object<DeviceMemory>();
                 memory->m_device = this;
                 luexp(memory->init(memory_type, allocation_desc, allocation_info));
+                ret = memory;
             }
             lucatchret;
             return ret;
@@ -377,6 +452,7 @@ namespace Luna
                 DeviceMemory* memory = cast_object<DeviceMemory>(device_memory->get_object());
                 Ref<BufferResource> res = new_object<BufferResource>();
                 res->m_device = this;
+                m_statistics.on_buffer_created();
                 luexp(res->init_as_aliasing(desc, memory));
                 ret = res;
             }
@@ -391,12 +467,226 @@ namespace Luna
                 DeviceMemory * memory = cast_object<DeviceMemory>(device_memory->get_object());
                 Ref<TextureResource> res = new_object<TextureResource>();
                 res->m_device = this;
+                m_statistics.on_texture_created();
                 luexp(res->init_as_aliasing(desc, memory, optimized_clear_value));
                 ret = res;
             }
             lucatchret;
             return ret;
         }
+        R<Ref<IBuffer>> Device::new_reserved_buffer(const BufferDesc& desc)
+        {
+            if (!is_reserved_resources_supported()) return BasicError::not_supported();
+            Ref<IBuffer> ret;
+            lutry
+            {
+                Ref<BufferResource> res = new_object<BufferResource>();
+                res->m_device = this;
+                m_statistics.on_buffer_created();
+                luexp(res->init_as_reserved(desc));
+                ret = res;
+            }
+            lucatchret;
+            return ret;
+        }
+        R<Ref<ITexture>> Device::new_reserved_texture(const TextureDesc& desc)
+        {
+            if (!is_reserved_resources_supported()) return BasicError::not_supported();
+            if (desc.type != TextureType::tex2d || desc.sample_count != 1 || is_render_target_or_depth_stencil_texture(desc))
+            {
+                return BasicError::not_supported();
+            }
+            Ref<ITexture> ret;
+            lutry
+            {
+                Ref<TextureResource> res = new_object<TextureResource>();
+                res->m_device = this;
+                m_statistics.on_texture_created();
+                luexp(res->init_as_reserved(desc));
+                ret = res;
+            }
+            lucatchret;
+            return ret;
+        }
+        ReservedTextureTiling Device::get_reserved_texture_tiling(ITexture* texture)
+        {
+            TextureResource* res = cast_object<TextureResource>(texture->get_object());
+            UINT num_tiles = 0;
+            D3D12_PACKED_MIP_INFO packed_mip_info;
+            D3D12_TILE_SHAPE tile_shape;
+            UINT num_subresource_tilings = 0;
+            m_device->GetResourceTiling(res->m_res.Get(), &num_tiles, &packed_mip_info, &tile_shape, &num_subresource_tilings, 0, nullptr);
+            ReservedTextureTiling ret;
+            ret.tile_width = tile_shape.WidthInTexels;
+            ret.tile_height = tile_shape.HeightInTexels;
+            ret.tile_depth = tile_shape.DepthInTexels;
+            ret.num_standard_mips = packed_mip_info.NumStandardMips;
+            ret.num_packed_mip_tiles = packed_mip_info.NumPackedMips ? packed_mip_info.NumTilesForPackedMips : 0;
+            return ret;
+        }
+        R<Ref<IDeviceMemory>> Device::allocate_tile_memory(u32 num_tiles)
+        {
+            if (!is_reserved_resources_supported()) return BasicError::not_supported();
+            Ref<IDeviceMemory> ret;
+            lutry
+            {
+                D3D12MA::ALLOCATION_DESC allocation_desc{};
+                allocation_desc.HeapType = D3D12_HEAP_TYPE_DEFAULT;
+                if (m_feature_options.ResourceHeapTier < D3D12_RESOURCE_HEAP_TIER_2)
+                {
+                    // Heaps can only support resources from a single resource category, use the memory for textures.
+                    allocation_desc.ExtraHeapFlags = D3D12_HEAP_FLAG_DENY_BUFFERS | D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES;
+                }
+                D3D12_RESOURCE_ALLOCATION_INFO allocation_info;
+                allocation_info.SizeInBytes = (u64)num_tiles * RESERVED_RESOURCE_TILE_SIZE;
+                allocation_info.Alignment = RESERVED_RESOURCE_TILE_SIZE;
+                auto memory = new_object<DeviceMemory>();
+                memory->m_device = this;
+                luexp(memory->init(MemoryType::local, allocation_desc, allocation_info));
+                ret = memory;
+            }
+            lucatchret;
+            return ret;
+        }
+        RV Device::update_tile_mappings(u32 command_queue_index, IResource* resource, Span<const TileMapping> mappings)
+        {
+            lucheck(command_queue_index < m_command_queues.size());
+            ID3D12Resource* res;
+            u32 num_standard_mips = 0;
+            u32 mip_levels = 1;
+            bool is_texture = false;
+            {
+                BufferResource* buffer = cast_object<BufferResource>(resource->get_object());
+                if (buffer)
+                {
+                    res = buffer->m_res.Get();
+                }
+                else
+                {
+                    TextureResource* texture = cast_object<TextureResource>(resource->get_object());
+                    lucheck(texture);
+                    res = texture->m_res.Get();
+                    mip_levels = texture->m_desc.mip_levels;
+                    num_standard_mips = get_reserved_texture_tiling(texture).num_standard_mips;
+                    is_texture = true;
+                }
+            }
+            auto& queue = m_command_queues[command_queue_index];
+            LockGuard guard(queue->m_lock);
+            // D3D12 requires all ranges of one call to be mapped to the same heap, so every mapping is updated separately.
+            for (auto& mapping : mappings)
+            {
+                D3D12_TILED_RESOURCE_COORDINATE coord{};
+                D3D12_TILE_REGION_SIZE region{};
+                coord.X = mapping.x;
+                if (is_texture && mapping.subresource.mip_slice < num_standard_mips)
+                {
+                    coord.Y = mapping.y;
+                    coord.Z = mapping.z;
+                    coord.Subresource = calc_subresource_index(mapping.subresource.mip_slice, mapping.subresource.array_slice, mip_levels);
+                    region.UseBox = TRUE;
+                    region.Width = mapping.width;
+                    region.Height = (UINT16)mapping.height;
+                    region.Depth = (UINT16)mapping.depth;
+                    region.NumTiles = mapping.width * mapping.height * mapping.depth;
+                }
+                else
+                {
+                    // Buffers and mip tails are mapped by tile indices.
+                    coord.Subresource = is_texture ? calc_subresource_index(num_standard_mips, mapping.subresource.array_slice, mip_levels) : 0;
+                    region.UseBox = FALSE;
+                    region.NumTiles = mapping.width;
+                }
+                D3D12_TILE_RANGE_FLAGS range_flags = D3D12_TILE_RANGE_FLAG_NONE;
+                ID3D12Heap* heap = nullptr;
+                UINT heap_range_start_offset = 0;
+                UINT range_tile_count = region.NumTiles;
+                if (mapping.memory)
+                {
+                    DeviceMemory* memory = cast_object<DeviceMemory>(mapping.memory->get_object());
+                    heap = memory->m_allocation->GetHeap();
+                    heap_range_start_offset = (UINT)((memory->m_allocation->GetOffset() + mapping.memory_offset) / RESERVED_RESOURCE_TILE_SIZE);
+                }
+                else
+                {
+                    range_flags = D3D12_TILE_RANGE_FLAG_NULL;
+                }
+                queue->m_command_queue->UpdateTileMappings(res, 1, &coord, &region, heap, 1, &range_flags, 
+                    &heap_range_start_offset, &range_tile_count, D3D12_TILE_MAPPING_FLAG_NONE);
+            }
+            return ok;
+        }
+        AccelerationStructureSizes Device::get_acceleration_structure_sizes(const AccelerationStructureBuildInputs& inputs)
+        {
+            lucheck_msg(m_ray_tracing_supported, "get_acceleration_structure_sizes requires DeviceFeature::ray_tracing.");
+            D3D12_BUILD_RAYTRACING_ACCELERATION_STRUCTURE_INPUTS d{};
+            Vector<D3D12_RAYTRACING_GEOMETRY_DESC> geometries;
+            encode_acceleration_structure_inputs(inputs, d, geometries);
+            D3D12_RAYTRACING_ACCELERATION_STRUCTURE_PREBUILD_INFO info{};
+            m_device5->GetRaytracingAccelerationStructurePrebuildInfo(&d, &info);
+            AccelerationStructureSizes ret;
+            ret.acceleration_structure_size = align_upper(info.ResultDataMaxSizeInBytes, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+            ret.build_scratch_size = align_upper(info.ScratchDataSizeInBytes, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+            ret.update_scratch_size = align_upper(info.UpdateScratchDataSizeInBytes, D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT);
+            ret.scratch_alignment = D3D12_RAYTRACING_ACCELERATION_STRUCTURE_BYTE_ALIGNMENT;
+            return ret;
+        }
+        R<Ref<IAccelerationStructure>> Device::new_acceleration_structure(const AccelerationStructureDesc& desc)
+        {
+            if (!m_ray_tracing_supported) return BasicError::not_supported();
+            Ref<IAccelerationStructure> ret;
+            lutry
+            {
+                Ref<AccelerationStructure> res = new_object<AccelerationStructure>();
+                res->m_device = this;
+                luexp(res->init(desc));
+                ret = res;
+            }
+            lucatchret;
+            return ret;
+        }
+        inline void encode_memory_heap_budget(MemoryHeapBudget& dst, const D3D12MA::Budget& src)
+        {
+            dst.block_bytes = src.Stats.BlockBytes;
+            dst.allocation_bytes = src.Stats.AllocationBytes;
+            dst.usage = src.UsageBytes;
+            dst.budget = src.BudgetBytes;
+        }
+        DeviceMemoryBudget Device::get_memory_budget()
+        {
+            D3D12MA::Budget local_budget;
+            D3D12MA::Budget non_local_budget;
+            m_allocator->GetBudget(&local_budget, &non_local_budget);
+            DeviceMemoryBudget ret;
+            encode_memory_heap_budget(ret.local, local_budget);
+            encode_memory_heap_budget(ret.non_local, non_local_budget);
+            if (m_adapter3)
+            {
+                // Query the latest usage and budget from DXGI directly, since the allocator only 
+                // refreshes its cached budget periodically.
+                DXGI_QUERY_VIDEO_MEMORY_INFO info;
+                if (SUCCEEDED(m_adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_LOCAL, &info)))
+                {
+                    ret.local.usage = info.CurrentUsage;
+                    ret.local.budget = info.Budget;
+                }
+                if (SUCCEEDED(m_adapter3->QueryVideoMemoryInfo(0, DXGI_MEMORY_SEGMENT_GROUP_NON_LOCAL, &info)))
+                {
+                    ret.non_local.usage = info.CurrentUsage;
+                    ret.non_local.budget = info.Budget;
+                }
+            }
+            return ret;
+        }
+        void Device::update_memory_budget()
+        {
+            DeviceMemoryBudget budget = get_memory_budget();
+            if (is_memory_budget_changed(m_last_memory_budget, budget))
+            {
+                m_last_memory_budget = budget;
+                m_memory_budget_change_event(this, budget);
+            }
+        }
         R<Ref<IPipelineLayout>> Device::new_pipeline_layout(const PipelineLayoutDesc& desc)
         {
             Ref<PipelineLayout> playout = new_object<PipelineLayout>();
@@ -408,11 +698,20 @@ namespace Luna
             lucatchret;
             return Ref<IPipelineLayout>(playout);
         }
+        R<Ref<IPipelineCache>> Device::new_pipeline_cache(Span<const byte_t> initial_data)
+        {
+            Ref<PipelineCache> cache = new_object<PipelineCache>();
+            cache->m_device = this;
+            auto r = cache->init(initial_data);
+            if(failed(r)) return r.errcode();
+            return Ref<IPipelineCache>(cache);
+        }
         R<Ref<IPipelineState>> Device::new_graphics_pipeline_state(const GraphicsPipelineStateDesc& desc)
         {
             Ref<PipelineState> s = new_object<PipelineState>(this);
             auto r = s->init_graphic(desc);
             if(failed(r)) return r.errcode();
+            m_statistics.on_pipeline_state_created();
             return Ref<IPipelineState>(s);
         }
         R<Ref<IPipelineState>> Device::new_compute_pipeline_state(const ComputePipelineStateDesc& desc)
@@ -420,6 +719,16 @@ namespace Luna
             Ref<PipelineState> s = new_object<PipelineState>(this);
             auto r = s->init_compute(desc);
             if(failed(r)) return r.errcode();
+            m_statistics.on_pipeline_state_created();
+            return Ref<IPipelineState>(s);
+        }
+        R<Ref<IPipelineState>> Device::new_mesh_pipeline_state(const MeshPipelineStateDesc& desc)
+        {
+            if (!m_mesh_shader_supported) return BasicError::not_supported();
+            Ref<PipelineState> s = new_object<PipelineState>(this);
+            auto r = s->init_mesh(desc);
+            if(failed(r)) return r.errcode();
+            m_statistics.on_pipeline_state_created();
             return Ref<IPipelineState>(s);
         }
         R<Ref<IDescriptorSetLayout>> Device::new_descriptor_set_layout(const DescriptorSetLayoutDesc& desc)
@@ -438,8 +747,16 @@ namespace Luna
             {
                 return r.errcode();
             }
+            m_statistics.on_descriptor_set_created();
             return Ref<IDescriptorSet>(ds);
         }
+        R<Ref<IDescriptorSetArena>> Device::new_descriptor_set_arena()
+        {
+            Ref<DescriptorSetArena> arena = new_object<DescriptorSetArena>();
+            arena->m_device = this;
+            arena->init();
+            return Ref<IDescriptorSetArena>(arena);
+        }
         u32 Device::get_num_command_queues()
         {
             return (u32)m_command_queues.size();
@@ -460,6 +777,18 @@ namespace Luna
             lucatchret;
             return Ref<ICommandBuffer>(buffer);
         }
+        R<Ref<ICommandBuffer>> Device::new_secondary_command_buffer(u32 command_queue_index)
+        {
+            Ref<CommandBuffer> buffer = new_object<CommandBuffer>();
+            lutry
+            {
+                buffer->m_device = this;
+                buffer->m_queue = command_queue_index;
+                luexp(buffer->init(true));
+            }
+            lucatchret;
+            return Ref<ICommandBuffer>(buffer);
+        }
         R<f64> Device::get_command_queue_timestamp_frequency(u32 command_queue_index)
         {
             UINT64 t;
@@ -478,11 +807,11 @@ namespace Luna
             }
             return Ref<IQueryHeap>(heap);
         }
-        R<Ref<IFence>> Device::new_fence()
+        R<Ref<IFence>> Device::new_fence(FenceType type, u64 initial_value)
         {
             Ref<Fence> fence = new_object<Fence>();
             fence->m_device = this;
-            RV r = fence->init();
+            RV r = fence->init(type, initial_value);
             if (!r.valid())
             {
                 return r.errcode();
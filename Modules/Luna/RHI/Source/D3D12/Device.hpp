@@ -12,11 +12,15 @@
 #include "D3D12Common.hpp"
 #include "d3d12.h"
 #include "../../Device.hpp"
+#include "../PipelineStateRequest.hpp"
+#include "../BindlessResourceTable.hpp"
+#include "../UploadRingBuffer.hpp"
 #include <Luna/Runtime/Mutex.hpp>
 #include <Luna/Runtime/RingDeque.hpp>
 #include <Luna/Runtime/List.hpp>
 #include <Luna/Runtime/SpinLock.hpp>
 #include <Luna/Runtime/UniquePtr.hpp>
+#include <Luna/Runtime/HashMap.hpp>
 
 namespace Luna
 {
@@ -85,10 +89,21 @@ namespace Luna
             luiimpl();
 
             ComPtr<IDXGIAdapter> m_adapter;
+            // Used to query video memory info, may be `nullptr` on old systems.
+            ComPtr<IDXGIAdapter3> m_adapter3;
             ComPtr<ID3D12Device> m_device;
+            // Used to create mesh pipeline states, may be `nullptr` on old systems.
+            ComPtr<ID3D12Device2> m_device2;
+            // Used to query acceleration structure sizes, may be `nullptr` on old systems.
+            ComPtr<ID3D12Device5> m_device5;
 
             D3D12_FEATURE_DATA_D3D12_OPTIONS m_feature_options;
             D3D12_FEATURE_DATA_ARCHITECTURE m_architecture;
+            bool m_mesh_shader_supported = false;
+            bool m_ray_tracing_supported = false;
+            D3D12_VARIABLE_SHADING_RATE_TIER m_variable_shading_rate_tier = D3D12_VARIABLE_SHADING_RATE_TIER_NOT_SUPPORTED;
+            u32 m_shading_rate_image_tile_size = 0;
+            bool m_additional_shading_rates_supported = false;
 
             //! Global heap for allocating descriptor sets.
             ShaderSourceDescriptorHeap m_cbv_srv_uav_heap;
@@ -101,6 +116,25 @@ namespace Luna
             // Memory Allocator.
             ComPtr<D3D12MA::Allocator> m_allocator;
 
+            // Command signatures used by indirect commands, keyed by argument type and stride.
+            // Memory budget.
+            Event<memory_budget_change_event_handler_t> m_memory_budget_change_event;
+            DeviceMemoryBudget m_last_memory_budget;
+
+            // Statistics.
+            DeviceStatisticsCounters m_statistics;
+
+            SpinLock m_command_signatures_lock;
+            HashMap<u64, ComPtr<ID3D12CommandSignature>> m_command_signatures;
+
+            R<ID3D12CommandSignature*> get_command_signature(D3D12_INDIRECT_ARGUMENT_TYPE type, u32 stride);
+
+            // Tier 2 is required so that reading unmapped tiles is well-defined.
+            bool is_reserved_resources_supported() const
+            {
+                return m_feature_options.TiledResourcesTier >= D3D12_TILED_RESOURCES_TIER_2;
+            }
+
             ~Device();
 
             R<UniquePtr<CommandQueue>> new_command_queue(const CommandQueueDesc& desc);
@@ -115,18 +149,49 @@ namespace Luna
             virtual R<Ref<IDeviceMemory>> allocate_memory(MemoryType memory_type, Span<const BufferDesc> buffers, Span<const TextureDesc> textures) override;
             virtual R<Ref<IBuffer>> new_aliasing_buffer(IDeviceMemory* device_memory, const BufferDesc& desc) override;
             virtual R<Ref<ITexture>> new_aliasing_texture(IDeviceMemory* device_memory, const TextureDesc& desc, const ClearValue* optimized_clear_value) override;
+            virtual R<Ref<IBuffer>> new_reserved_buffer(const BufferDesc& desc) override;
+            virtual R<Ref<ITexture>> new_reserved_texture(const TextureDesc& desc) override;
+            virtual ReservedTextureTiling get_reserved_texture_tiling(ITexture* texture) override;
+            virtual R<Ref<IDeviceMemory>> allocate_tile_memory(u32 num_tiles) override;
+            virtual RV update_tile_mappings(u32 command_queue_index, IResource* resource, Span<const TileMapping> mappings) override;
+            virtual AccelerationStructureSizes get_acceleration_structure_sizes(const AccelerationStructureBuildInputs& inputs) override;
+            virtual R<Ref<IAccelerationStructure>> new_acceleration_structure(const AccelerationStructureDesc& desc) override;
+            virtual DeviceMemoryBudget get_memory_budget() override;
+            virtual Event<memory_budget_change_event_handler_t>& get_memory_budget_change_event() override { return m_memory_budget_change_event; }
+            virtual void update_memory_budget() override;
             virtual R<Ref<IPipelineLayout>> new_pipeline_layout(const PipelineLayoutDesc& desc) override;
+            virtual R<Ref<IPipelineCache>> new_pipeline_cache(Span<const byte_t> initial_data) override;
             virtual R<Ref<IPipelineState>> new_graphics_pipeline_state(const GraphicsPipelineStateDesc& desc) override;
             virtual R<Ref<IPipelineState>> new_compute_pipeline_state(const ComputePipelineStateDesc& desc) override;
+            virtual R<Ref<IPipelineState>> new_mesh_pipeline_state(const MeshPipelineStateDesc& desc) override;
+            virtual Ref<IPipelineStateRequest> new_graphics_pipeline_state_async(const GraphicsPipelineStateDesc& desc) override
+            {
+                return new_graphics_pipeline_state_request(this, desc);
+            }
+            virtual Ref<IPipelineStateRequest> new_compute_pipeline_state_async(const ComputePipelineStateDesc& desc) override
+            {
+                return new_compute_pipeline_state_request(this, desc);
+            }
             virtual R<Ref<IDescriptorSetLayout>> new_descriptor_set_layout(const DescriptorSetLayoutDesc& desc) override;
             virtual R<Ref<IDescriptorSet>> new_descriptor_set(const DescriptorSetDesc& desc) override;
+            virtual R<Ref<IDescriptorSetArena>> new_descriptor_set_arena() override;
+            virtual R<Ref<IBindlessResourceTable>> new_bindless_resource_table(const BindlessResourceTableDesc& desc) override
+            {
+                return RHI::new_bindless_resource_table(this, desc);
+            }
+            virtual R<Ref<IUploadRingBuffer>> new_upload_ring_buffer(const UploadRingBufferDesc& desc) override
+            {
+                return RHI::new_upload_ring_buffer(this, desc);
+            }
             virtual u32 get_num_command_queues() override;
             virtual CommandQueueDesc get_command_queue_desc(u32 command_queue_index) override;
             virtual R<Ref<ICommandBuffer>> new_command_buffer(u32 command_queue_index) override;
+            virtual R<Ref<ICommandBuffer>> new_secondary_command_buffer(u32 command_queue_index) override;
             virtual R<f64> get_command_queue_timestamp_frequency(u32 command_queue_index) override;
             virtual R<Ref<IQueryHeap>> new_query_heap(const QueryHeapDesc& desc) override;
-            virtual R<Ref<IFence>> new_fence() override;
+            virtual R<Ref<IFence>> new_fence(FenceType type, u64 initial_value) override;
             virtual R<Ref<ISwapChain>> new_swap_chain(u32 command_queue_index, Window::IWindow* window, const SwapChainDesc& desc) override;
+            virtual DeviceStatistics get_statistics() override { return m_statistics.m_statistics; }
         };
     }
 }
\ No newline at end of file
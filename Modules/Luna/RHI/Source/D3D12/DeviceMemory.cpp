@@ -18,6 +18,7 @@ namespace Luna
             m_memory_type = memory_type;
             auto hr = m_device->m_allocator->AllocateMemory(&allocation_desc, &allocation_info, &m_allocation);
             if(FAILED(hr)) return encode_hresult(hr);
+            m_device->m_statistics.on_memory_allocated(m_device, m_memory_type, get_size());
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
             memory_profiler_allocate(m_allocation.Get(), get_size());
             memory_profiler_set_memory_domain(m_allocation.Get(), "GPU", 3);
@@ -27,6 +28,10 @@ namespace Luna
         }
         DeviceMemory::~DeviceMemory()
         {
+            if (m_allocation)
+            {
+                m_device->m_statistics.on_memory_freed(m_device, m_memory_type, get_size());
+            }
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
             memory_profiler_deallocate(m_allocation.Get());
 #endif
@@ -12,14 +12,29 @@ namespace Luna
 {
     namespace RHI
     {
-        RV Fence::init()
+        RV Fence::init(FenceType type, u64 initial_value)
         {
+            m_type = type;
             lutry
             {
-                luexp(encode_hresult(m_device->m_device->CreateFence(m_wait_value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence))));
+                // Binary fences are emulated by increasing the fence value for every signal operation.
+                u64 value = type == FenceType::timeline ? initial_value : m_wait_value;
+                luexp(encode_hresult(m_device->m_device->CreateFence(value, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&m_fence))));
             }
             lucatchret;
             return ok;
         }
+        RV Fence::wait(u64 value)
+        {
+            lucheck_msg(m_type == FenceType::timeline, "Only timeline fences can be waited from host.");
+            if (m_fence->GetCompletedValue() >= value) return ok;
+            // Passing `NULL` as the event handle blocks the current thread until the value is reached.
+            return encode_hresult(m_fence->SetEventOnCompletion(value, NULL));
+        }
+        RV Fence::signal(u64 value)
+        {
+            lucheck_msg(m_type == FenceType::timeline, "Only timeline fences can be signaled from host.");
+            return encode_hresult(m_fence->Signal(value));
+        }
     }
 }
\ No newline at end of file
@@ -20,11 +20,17 @@ namespace Luna
 
             Ref<Device> m_device;
             ComPtr<ID3D12Fence> m_fence;
+            FenceType m_type;
+            // The value signaled by the last signal operation of one binary fence.
             u64 m_wait_value = 0;
 
-            RV init();
+            RV init(FenceType type, u64 initial_value);
             virtual IDevice* get_device() override { return m_device; }
             virtual void set_name(const c8* name) override { set_object_name(m_fence.Get(), name); }
+            virtual FenceType get_type() override { return m_type; }
+            virtual u64 get_completed_value() override { return m_type == FenceType::timeline ? m_fence->GetCompletedValue() : 0; }
+            virtual RV wait(u64 value) override;
+            virtual RV signal(u64 value) override;
         };
     }
 }
\ No newline at end of file
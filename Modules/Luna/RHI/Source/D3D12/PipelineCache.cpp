@@ -0,0 +1,123 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file PipelineCache.cpp
+* @author JXMaster
+* @date 2024/3/30
+*/
+#include "PipelineCache.hpp"
+#include <Luna/Runtime/Hash.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        RV PipelineCache::init(Span<const byte_t> initial_data)
+        {
+            m_mutex = new_mutex();
+            ComPtr<ID3D12Device1> device;
+            if (FAILED(m_device->m_device.As(&device)))
+            {
+                // Pipeline libraries are not supported, pipeline states will be created without cache.
+                return ok;
+            }
+            if (!initial_data.empty())
+            {
+                m_initial_data = Blob(initial_data.data(), initial_data.size());
+                HRESULT hr = device->CreatePipelineLibrary(m_initial_data.data(), m_initial_data.size(), IID_PPV_ARGS(&m_library));
+                if (SUCCEEDED(hr)) return ok;
+                // The data is created by another driver or adapter, discard it.
+                m_initial_data.clear();
+            }
+            HRESULT hr = device->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&m_library));
+            if (FAILED(hr))
+            {
+                // The driver does not support pipeline libraries.
+                m_library.Reset();
+            }
+            return ok;
+        }
+        static void get_pipeline_name(u64 key, wchar_t name[17])
+        {
+            constexpr const c8* digits = "0123456789ABCDEF";
+            for (u32 i = 0; i < 16; ++i)
+            {
+                name[i] = (wchar_t)digits[(key >> ((15 - i) * 4)) & 0x0F];
+            }
+            name[16] = 0;
+        }
+        static u64 hash_shader_bytecode(const D3D12_SHADER_BYTECODE& code, u64 h)
+        {
+            h = memhash64(&code.BytecodeLength, sizeof(code.BytecodeLength), h);
+            return code.BytecodeLength ? memhash64(code.pShaderBytecode, code.BytecodeLength, h) : h;
+        }
+        ComPtr<ID3D12PipelineState> PipelineCache::load_graphics_pipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, u64 root_signature_hash, u64& key)
+        {
+            // Hashes all states that are not pointers, then hashes data referred by pointers.
+            D3D12_GRAPHICS_PIPELINE_STATE_DESC d = desc;
+            d.pRootSignature = nullptr;
+            d.VS = d.PS = d.DS = d.HS = d.GS = {};
+            d.InputLayout.pInputElementDescs = nullptr;
+            d.StreamOutput.pSODeclaration = nullptr;
+            d.StreamOutput.pBufferStrides = nullptr;
+            d.CachedPSO = {};
+            u64 h = memhash64(&d, sizeof(d), root_signature_hash);
+            h = hash_shader_bytecode(desc.VS, h);
+            h = hash_shader_bytecode(desc.PS, h);
+            for (u32 i = 0; i < desc.InputLayout.NumElements; ++i)
+            {
+                D3D12_INPUT_ELEMENT_DESC e = desc.InputLayout.pInputElementDescs[i];
+                h = memhash64(e.SemanticName, strlen(e.SemanticName), h);
+                e.SemanticName = nullptr;
+                h = memhash64(&e, sizeof(e), h);
+            }
+            key = h;
+            ComPtr<ID3D12PipelineState> pso;
+            if (!m_library) return pso;
+            wchar_t name[17];
+            get_pipeline_name(key, name);
+            MutexGuard guard(m_mutex);
+            if (FAILED(m_library->LoadGraphicsPipeline(name, &desc, IID_PPV_ARGS(&pso))))
+            {
+                pso.Reset();
+            }
+            return pso;
+        }
+        ComPtr<ID3D12PipelineState> PipelineCache::load_compute_pipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, u64 root_signature_hash, u64& key)
+        {
+            u64 h = memhash64(&desc.Flags, sizeof(desc.Flags), root_signature_hash);
+            h = memhash64(&desc.NodeMask, sizeof(desc.NodeMask), h);
+            key = hash_shader_bytecode(desc.CS, h);
+            ComPtr<ID3D12PipelineState> pso;
+            if (!m_library) return pso;
+            wchar_t name[17];
+            get_pipeline_name(key, name);
+            MutexGuard guard(m_mutex);
+            if (FAILED(m_library->LoadComputePipeline(name, &desc, IID_PPV_ARGS(&pso))))
+            {
+                pso.Reset();
+            }
+            return pso;
+        }
+        void PipelineCache::store_pipeline(u64 key, ID3D12PipelineState* pso)
+        {
+            if (!m_library) return;
+            wchar_t name[17];
+            get_pipeline_name(key, name);
+            MutexGuard guard(m_mutex);
+            // This fails with E_INVALIDARG if the pipeline is already stored by other threads, which is fine.
+            m_library->StorePipeline(name, pso);
+        }
+        R<Blob> PipelineCache::get_data()
+        {
+            if (!m_library) return Blob();
+            MutexGuard guard(m_mutex);
+            Blob data(m_library->GetSerializedSize());
+            HRESULT hr = m_library->Serialize(data.data(), data.size());
+            if (FAILED(hr)) return encode_hresult(hr).errcode();
+            return data;
+        }
+    }
+}
@@ -0,0 +1,49 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file PipelineCache.hpp
+* @author JXMaster
+* @date 2024/3/30
+*/
+#pragma once
+#include "Device.hpp"
+#include "D3D12Common.hpp"
+#include <Luna/Runtime/Mutex.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct PipelineCache : IPipelineCache
+        {
+            lustruct("RHI::PipelineCache", "{C5A1E7D2-3B94-4F60-8E1A-72D9B0C4F615}");
+            luiimpl();
+
+            Ref<Device> m_device;
+            // `nullptr` if the device does not support pipeline libraries. In such case, 
+            // all pipeline states are created without cache.
+            ComPtr<ID3D12PipelineLibrary> m_library;
+            // The pipeline library references the initial data directly, so the data must be kept alive.
+            Blob m_initial_data;
+            Ref<IMutex> m_mutex;
+
+            RV init(Span<const byte_t> initial_data);
+
+            //! Loads one graphics pipeline state from the library. Returns `nullptr` if not found.
+            ComPtr<ID3D12PipelineState> load_graphics_pipeline(const D3D12_GRAPHICS_PIPELINE_STATE_DESC& desc, u64 root_signature_hash, u64& key);
+            //! Loads one compute pipeline state from the library. Returns `nullptr` if not found.
+            ComPtr<ID3D12PipelineState> load_compute_pipeline(const D3D12_COMPUTE_PIPELINE_STATE_DESC& desc, u64 root_signature_hash, u64& key);
+            //! Stores one pipeline state created by `key` to the library.
+            void store_pipeline(u64 key, ID3D12PipelineState* pso);
+
+            virtual IDevice* get_device() override
+            {
+                return m_device.as<IDevice>();
+            }
+            virtual void set_name(const c8* name) override { if (m_library) set_object_name(m_library.Get(), name); }
+            virtual R<Blob> get_data() override;
+        };
+    }
+}
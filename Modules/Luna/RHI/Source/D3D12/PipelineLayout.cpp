@@ -9,6 +9,7 @@
 */
 #include "PipelineLayout.hpp"
 #include "DescriptorSetLayout.hpp"
+#include <Luna/Runtime/Hash.hpp>
 
 namespace Luna
 {
@@ -50,6 +51,25 @@ namespace Luna
                 }
                 m_descriptor_set_layouts.push_back(move(info));
             }
+            if (desc.num_constants)
+            {
+                lucheck(desc.num_constants <= MAX_PIPELINE_CONSTANTS);
+                D3D12_ROOT_PARAMETER param;
+                param.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+                switch (desc.constants_shader_visibility_flags)
+                {
+                case ShaderVisibilityFlag::vertex: param.ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX; break;
+                case ShaderVisibilityFlag::pixel: param.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL; break;
+                case ShaderVisibilityFlag::mesh: param.ShaderVisibility = D3D12_SHADER_VISIBILITY_MESH; break;
+                case ShaderVisibilityFlag::amplification: param.ShaderVisibility = D3D12_SHADER_VISIBILITY_AMPLIFICATION; break;
+                default: param.ShaderVisibility = D3D12_SHADER_VISIBILITY_ALL; break;
+                }
+                param.Constants.ShaderRegister = 0;
+                param.Constants.RegisterSpace = PIPELINE_CONSTANTS_REGISTER_SPACE;
+                param.Constants.Num32BitValues = desc.num_constants;
+                m_constants_root_parameter_index = (u32)parameters.size();
+                parameters.push_back(param);
+            }
             d.NumParameters = (UINT)parameters.size();
             d.pParameters = parameters.data();
             d.Flags = D3D12_ROOT_SIGNATURE_FLAG_DENY_DOMAIN_SHADER_ROOT_ACCESS |
@@ -74,6 +94,7 @@ namespace Luna
             {
                 return set_error(encode_hresult(hr).errcode(), "Failed to create D3D12 root signature: %s", err->GetBufferPointer());
             }
+            m_rs_hash = memhash64(b->GetBufferPointer(), b->GetBufferSize());
             hr = m_device->m_device->CreateRootSignature(0, b->GetBufferPointer(), b->GetBufferSize(), IID_PPV_ARGS(&m_rs));
             if (FAILED(hr))
             {
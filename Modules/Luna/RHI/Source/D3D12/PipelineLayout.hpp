@@ -24,6 +24,8 @@ namespace Luna
 
             Ref<Device> m_device;
             ComPtr<ID3D12RootSignature> m_rs;
+            // The hash of the serialized root signature, used to identify pipeline states in pipeline caches.
+            u64 m_rs_hash = 0;
 
             struct DescriptorSetLayoutInfo
             {
@@ -33,6 +35,8 @@ namespace Luna
                 Vector<D3D12_DESCRIPTOR_HEAP_TYPE> m_memory_types;
             };
             Vector<DescriptorSetLayoutInfo> m_descriptor_set_layouts;
+            //! The root parameter index of pipeline constants, or `U32_MAX` if the layout does not have constants.
+            u32 m_constants_root_parameter_index = U32_MAX;
 
             PipelineLayout() {}
 
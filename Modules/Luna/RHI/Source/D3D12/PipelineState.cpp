@@ -9,6 +9,7 @@
 */
 #include "PipelineState.hpp"
 #include "D3D12Common.hpp"
+#include "PipelineCache.hpp"
 
 #include <Luna/Runtime/Vector.hpp>
 
@@ -140,11 +141,82 @@ namespace Luna
             }
         }
 
+        inline void encode_blend_desc(D3D12_BLEND_DESC& dst, const BlendDesc& src)
+        {
+            dst.AlphaToCoverageEnable = src.alpha_to_coverage_enable ? TRUE : FALSE;
+            dst.IndependentBlendEnable = src.independent_blend_enable ? TRUE : FALSE;
+            for (u32 i = 0; i < 8; ++i)
+            {
+                if (dst.IndependentBlendEnable)
+                {
+                    encode_target_blend_desc(dst.RenderTarget[i], src.attachments[i]);
+                }
+                else
+                {
+                    encode_target_blend_desc(dst.RenderTarget[i], src.attachments[0]);
+                }
+            }
+        }
+
+        inline void encode_rasterizer_desc(D3D12_RASTERIZER_DESC& dst, const RasterizerDesc& src, u32 sample_count)
+        {
+            switch (src.fill_mode)
+            {
+            case FillMode::solid:
+                dst.FillMode = D3D12_FILL_MODE_SOLID;
+                break;
+            case FillMode::wireframe:
+                dst.FillMode = D3D12_FILL_MODE_WIREFRAME;
+                break;
+            }
+            switch (src.cull_mode)
+            {
+            case CullMode::back:
+                dst.CullMode = D3D12_CULL_MODE_BACK;
+                break;
+            case CullMode::front:
+                dst.CullMode = D3D12_CULL_MODE_FRONT;
+                break;
+            case CullMode::none:
+                dst.CullMode = D3D12_CULL_MODE_NONE;
+                break;
+            }
+            dst.ForcedSampleCount = 0;
+            dst.FrontCounterClockwise = src.front_counter_clockwise ? TRUE : FALSE;
+            dst.DepthBias = src.depth_bias;
+            dst.DepthBiasClamp = src.depth_bias_clamp;
+            dst.SlopeScaledDepthBias = src.slope_scaled_depth_bias;
+            dst.DepthClipEnable = src.depth_clip_enable ? TRUE : FALSE;
+            dst.MultisampleEnable = sample_count == 1 ? FALSE : TRUE;
+            dst.AntialiasedLineEnable = TRUE;
+            dst.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
+        }
+
+        inline void encode_depth_stencil_desc(D3D12_DEPTH_STENCIL_DESC& dst, const DepthStencilDesc& src)
+        {
+            dst.DepthEnable = src.depth_test_enable ? TRUE : FALSE;
+            dst.DepthWriteMask = src.depth_write_enable ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+            dst.DepthFunc = encode_compare_function(src.depth_func);
+            dst.StencilEnable = src.stencil_enable ? TRUE : FALSE;
+            dst.StencilReadMask = src.stencil_read_mask;
+            dst.StencilWriteMask = src.stencil_write_mask;
+            dst.FrontFace.StencilFailOp = encode_stencil_op(src.front_face.stencil_fail_op);
+            dst.FrontFace.StencilDepthFailOp = encode_stencil_op(src.front_face.stencil_depth_fail_op);
+            dst.FrontFace.StencilPassOp = encode_stencil_op(src.front_face.stencil_pass_op);
+            dst.FrontFace.StencilFunc = encode_compare_function(src.front_face.stencil_func);
+            dst.BackFace.StencilFailOp = encode_stencil_op(src.back_face.stencil_fail_op);
+            dst.BackFace.StencilDepthFailOp = encode_stencil_op(src.back_face.stencil_depth_fail_op);
+            dst.BackFace.StencilPassOp = encode_stencil_op(src.back_face.stencil_pass_op);
+            dst.BackFace.StencilFunc = encode_compare_function(src.back_face.stencil_func);
+        }
+
         RV PipelineState::init_graphic(const GraphicsPipelineStateDesc& desc)
         {
             m_is_graphics = true;
             PipelineLayout* playout = static_cast<PipelineLayout*>(desc.pipeline_layout->get_object());
             D3D12_GRAPHICS_PIPELINE_STATE_DESC d;
+            // Clears padding bytes so that the descriptor can be hashed by pipeline caches.
+            memzero(&d);
             d.pRootSignature = playout->m_rs.Get();
             if(desc.vs.format != ShaderDataFormat::none)
             {
@@ -178,71 +250,10 @@ namespace Luna
             d.StreamOutput.RasterizedStream = 0;
             d.StreamOutput.pSODeclaration = nullptr;
 
-            {
-                d.BlendState.AlphaToCoverageEnable = desc.blend_state.alpha_to_coverage_enable ? TRUE : FALSE;
-                d.BlendState.IndependentBlendEnable = desc.blend_state.independent_blend_enable ? TRUE : FALSE;
-                for (u32 i = 0; i < 8; ++i)
-                {
-                    if (d.BlendState.IndependentBlendEnable)
-                    {
-                        encode_target_blend_desc(d.BlendState.RenderTarget[i], desc.blend_state.attachments[i]);
-                    }
-                    else
-                    {
-                        encode_target_blend_desc(d.BlendState.RenderTarget[i], desc.blend_state.attachments[0]);
-                    }
-                }
-                d.SampleMask = 0xFFFFFFFF;
-            }
-            {
-                switch (desc.rasterizer_state.fill_mode)
-                {
-                case FillMode::solid:
-                    d.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
-                    break;
-                case FillMode::wireframe:
-                    d.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME;
-                    break;
-                }
-                switch (desc.rasterizer_state.cull_mode)
-                {
-                case CullMode::back:
-                    d.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
-                    break;
-                case CullMode::front:
-                    d.RasterizerState.CullMode = D3D12_CULL_MODE_FRONT;
-                    break;
-                case CullMode::none:
-                    d.RasterizerState.CullMode = D3D12_CULL_MODE_NONE;
-                    break;
-                }
-                d.RasterizerState.ForcedSampleCount = 0;
-                d.RasterizerState.FrontCounterClockwise = desc.rasterizer_state.front_counter_clockwise ? TRUE : FALSE;
-                d.RasterizerState.DepthBias = desc.rasterizer_state.depth_bias;
-                d.RasterizerState.DepthBiasClamp = desc.rasterizer_state.depth_bias_clamp;
-                d.RasterizerState.SlopeScaledDepthBias = desc.rasterizer_state.slope_scaled_depth_bias;
-                d.RasterizerState.DepthClipEnable = desc.rasterizer_state.depth_clip_enable ? TRUE : FALSE;
-                d.RasterizerState.MultisampleEnable = desc.sample_count == 1 ? FALSE : TRUE;
-                d.RasterizerState.AntialiasedLineEnable = TRUE;
-                d.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF;
-            }
-
-            {
-                d.DepthStencilState.DepthEnable = desc.depth_stencil_state.depth_test_enable ? TRUE : FALSE;
-                d.DepthStencilState.DepthWriteMask = desc.depth_stencil_state.depth_write_enable ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
-                d.DepthStencilState.DepthFunc = encode_compare_function(desc.depth_stencil_state.depth_func);
-                d.DepthStencilState.StencilEnable = desc.depth_stencil_state.stencil_enable ? TRUE : FALSE;
-                d.DepthStencilState.StencilReadMask = desc.depth_stencil_state.stencil_read_mask;
-                d.DepthStencilState.StencilWriteMask = desc.depth_stencil_state.stencil_write_mask;
-                d.DepthStencilState.FrontFace.StencilFailOp = encode_stencil_op(desc.depth_stencil_state.front_face.stencil_fail_op);
-                d.DepthStencilState.FrontFace.StencilDepthFailOp = encode_stencil_op(desc.depth_stencil_state.front_face.stencil_depth_fail_op);
-                d.DepthStencilState.FrontFace.StencilPassOp = encode_stencil_op(desc.depth_stencil_state.front_face.stencil_pass_op);
-                d.DepthStencilState.FrontFace.StencilFunc = encode_compare_function(desc.depth_stencil_state.front_face.stencil_func);
-                d.DepthStencilState.BackFace.StencilFailOp = encode_stencil_op(desc.depth_stencil_state.back_face.stencil_fail_op);
-                d.DepthStencilState.BackFace.StencilDepthFailOp = encode_stencil_op(desc.depth_stencil_state.back_face.stencil_depth_fail_op);
-                d.DepthStencilState.BackFace.StencilPassOp = encode_stencil_op(desc.depth_stencil_state.back_face.stencil_pass_op);
-                d.DepthStencilState.BackFace.StencilFunc = encode_compare_function(desc.depth_stencil_state.back_face.stencil_func);
-            }
+            encode_blend_desc(d.BlendState, desc.blend_state);
+            d.SampleMask = 0xFFFFFFFF;
+            encode_rasterizer_desc(d.RasterizerState, desc.rasterizer_state, desc.sample_count);
+            encode_depth_stencil_desc(d.DepthStencilState, desc.depth_stencil_state);
 
             Vector<D3D12_INPUT_ELEMENT_DESC> input_elements;
             if (desc.input_layout.attributes.size())
@@ -330,11 +341,19 @@ namespace Luna
             d.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
             d.CachedPSO.CachedBlobSizeInBytes = 0;
             d.CachedPSO.pCachedBlob = nullptr;
+            PipelineCache* cache = desc.pipeline_cache ? cast_object<PipelineCache>(desc.pipeline_cache->get_object()) : nullptr;
+            u64 cache_key = 0;
+            if (cache)
+            {
+                m_pso = cache->load_graphics_pipeline(d, playout->m_rs_hash, cache_key);
+                if (m_pso) return ok;
+            }
             HRESULT hr = m_device->m_device->CreateGraphicsPipelineState(&d, IID_PPV_ARGS(&m_pso));
             if (FAILED(hr))
             {
                 return encode_hresult(hr);
             }
+            if (cache) cache->store_pipeline(cache_key, m_pso.Get());
             return ok;
         }
         RV PipelineState::init_compute(const ComputePipelineStateDesc& desc)
@@ -342,6 +361,7 @@ namespace Luna
             m_is_graphics = false;
             PipelineLayout* playout = static_cast<PipelineLayout*>(desc.pipeline_layout->get_object());
             D3D12_COMPUTE_PIPELINE_STATE_DESC d;
+            memzero(&d);
             d.pRootSignature = playout->m_rs.Get();
             d.CachedPSO.CachedBlobSizeInBytes = 0;
             d.CachedPSO.pCachedBlob = nullptr;
@@ -352,11 +372,95 @@ namespace Luna
             fill_shader_data(d.CS, desc.cs.data);
             d.Flags = D3D12_PIPELINE_STATE_FLAG_NONE;
             d.NodeMask = 0;
+            PipelineCache* cache = desc.pipeline_cache ? cast_object<PipelineCache>(desc.pipeline_cache->get_object()) : nullptr;
+            u64 cache_key = 0;
+            if (cache)
+            {
+                m_pso = cache->load_compute_pipeline(d, playout->m_rs_hash, cache_key);
+                if (m_pso) return ok;
+            }
             HRESULT hr = m_device->m_device->CreateComputePipelineState(&d, IID_PPV_ARGS(&m_pso));
             if (FAILED(hr))
             {
                 return encode_hresult(hr);
             }
+            if (cache) cache->store_pipeline(cache_key, m_pso.Get());
+            return ok;
+        }
+
+        // One subobject of the pipeline state stream. Every subobject is pointer-aligned and starts with its type.
+        template <D3D12_PIPELINE_STATE_SUBOBJECT_TYPE _Type, typename _Ty>
+        struct alignas(void*) PipelineStateSubobject
+        {
+            D3D12_PIPELINE_STATE_SUBOBJECT_TYPE type = _Type;
+            _Ty value;
+        };
+
+        struct MeshPipelineStateStream
+        {
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_ROOT_SIGNATURE, ID3D12RootSignature*> root_signature;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_AS, D3D12_SHADER_BYTECODE> as;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_MS, D3D12_SHADER_BYTECODE> ms;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_PS, D3D12_SHADER_BYTECODE> ps;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_BLEND, D3D12_BLEND_DESC> blend;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_MASK, UINT> sample_mask;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RASTERIZER, D3D12_RASTERIZER_DESC> rasterizer;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL, D3D12_DEPTH_STENCIL_DESC> depth_stencil;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_RENDER_TARGET_FORMATS, D3D12_RT_FORMAT_ARRAY> rtv_formats;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_DEPTH_STENCIL_FORMAT, DXGI_FORMAT> dsv_format;
+            PipelineStateSubobject<D3D12_PIPELINE_STATE_SUBOBJECT_TYPE_SAMPLE_DESC, DXGI_SAMPLE_DESC> sample_desc;
+        };
+
+        RV PipelineState::init_mesh(const MeshPipelineStateDesc& desc)
+        {
+            m_is_graphics = true;
+            PipelineLayout* playout = static_cast<PipelineLayout*>(desc.pipeline_layout->get_object());
+            MeshPipelineStateStream d;
+            d.root_signature.value = playout->m_rs.Get();
+            if (desc.as.format != ShaderDataFormat::none)
+            {
+                if (desc.as.format != ShaderDataFormat::dxil || desc.as.data.empty())
+                {
+                    return set_error(BasicError::bad_arguments(), "The amplification shader data must be in ShaderDataFormat::dxil format and must not be empty for D3D12 backend.");
+                }
+                fill_shader_data(d.as.value, desc.as.data);
+            }
+            else
+            {
+                fill_shader_data(d.as.value, {});
+            }
+            if (desc.ms.format != ShaderDataFormat::dxil || desc.ms.data.empty())
+            {
+                return set_error(BasicError::bad_arguments(), "The mesh shader data must be in ShaderDataFormat::dxil format and must not be empty for D3D12 backend.");
+            }
+            fill_shader_data(d.ms.value, desc.ms.data);
+            if (desc.ps.format != ShaderDataFormat::dxil || desc.ps.data.empty())
+            {
+                return set_error(BasicError::bad_arguments(), "The pixel shader data must be in ShaderDataFormat::dxil format and must not be empty for D3D12 backend.");
+            }
+            fill_shader_data(d.ps.value, desc.ps.data);
+            encode_blend_desc(d.blend.value, desc.blend_state);
+            d.sample_mask.value = 0xFFFFFFFF;
+            encode_rasterizer_desc(d.rasterizer.value, desc.rasterizer_state, desc.sample_count);
+            encode_depth_stencil_desc(d.depth_stencil.value, desc.depth_stencil_state);
+            d.rtv_formats.value.NumRenderTargets = desc.num_color_attachments;
+            for (u32 i = 0; i < 8; ++i)
+            {
+                d.rtv_formats.value.RTFormats[i] = i < desc.num_color_attachments ? encode_format(desc.color_formats[i]) : DXGI_FORMAT_UNKNOWN;
+            }
+            d.dsv_format.value = encode_format(desc.depth_stencil_format);
+            d.sample_desc.value.Count = desc.sample_count;
+            d.sample_desc.value.Quality = desc.sample_count == 1 ? 0 : 1;
+            // Mesh pipeline states are not stored in pipeline caches, since ID3D12PipelineLibrary::LoadGraphicsPipeline 
+            // only accepts D3D12_GRAPHICS_PIPELINE_STATE_DESC.
+            D3D12_PIPELINE_STATE_STREAM_DESC stream_desc;
+            stream_desc.SizeInBytes = sizeof(d);
+            stream_desc.pPipelineStateSubobjectStream = &d;
+            HRESULT hr = m_device->m_device2->CreatePipelineState(&stream_desc, IID_PPV_ARGS(&m_pso));
+            if (FAILED(hr))
+            {
+                return encode_hresult(hr);
+            }
             return ok;
         }
     }
@@ -40,6 +40,7 @@ namespace Luna
 
             RV init_graphic(const GraphicsPipelineStateDesc& desc);
             RV init_compute(const ComputePipelineStateDesc& desc);
+            RV init_mesh(const MeshPipelineStateDesc& desc);
         };
     }
 }
\ No newline at end of file
@@ -44,6 +44,7 @@ namespace Luna
                     &allocation_desc,
                     &rd, state, NULL, &m_memory->m_allocation, IID_PPV_ARGS(&m_res)
                 )));
+                m_device->m_statistics.on_memory_allocated(m_device, memory_type, m_memory->get_size());
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
                 memory_profiler_allocate(m_memory->m_allocation.Get(), m_memory->get_size());
                 memory_profiler_set_memory_domain(m_memory->m_allocation.Get(), "GPU", 3);
@@ -84,6 +85,18 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        RV BufferResource::init_as_reserved(const BufferDesc& desc)
+        {
+            lutry
+            {
+                m_desc = desc;
+                D3D12_RESOURCE_DESC rd = encode_buffer_desc(desc);
+                luexp(encode_hresult(m_device->m_device->CreateReservedResource(
+                    &rd, D3D12_RESOURCE_STATE_COMMON, NULL, IID_PPV_ARGS(&m_res))));
+            }
+            lucatchret;
+            return ok;
+        }
         RV BufferResource::map(usize read_begin, usize read_end, void** data)
         {
             lutsassert();
@@ -264,6 +277,7 @@ namespace Luna
         }
         TextureResource::~TextureResource()
         {
+            m_device->m_statistics.on_texture_destroyed();
             for (auto& rtv : m_rtvs)
             {
                 m_device->m_rtv_heap.free_view(rtv.second.Get());
@@ -321,6 +335,7 @@ namespace Luna
                     &allocation_desc,
                     &rd, state, pcv, &m_memory->m_allocation, IID_PPV_ARGS(&m_res)
                 )));
+                m_device->m_statistics.on_memory_allocated(m_device, memory_type, m_memory->get_size());
                 auto created_desc = m_res->GetDesc();
                 m_desc.mip_levels = created_desc.MipLevels;
                 post_init();
@@ -387,6 +402,22 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        RV TextureResource::init_as_reserved(const TextureDesc& desc)
+        {
+            lutry
+            {
+                m_desc = desc;
+                luexp(validate_texture_desc(m_desc));
+                D3D12_RESOURCE_DESC rd = encode_texture_desc(m_desc);
+                // Reserved textures must use the standard 64KB tile layout.
+                rd.Layout = D3D12_TEXTURE_LAYOUT_64KB_UNDEFINED_SWIZZLE;
+                luexp(encode_hresult(m_device->m_device->CreateReservedResource(
+                    &rd, D3D12_RESOURCE_STATE_COMMON, NULL, IID_PPV_ARGS(&m_res))));
+                post_init();
+            }
+            lucatchret;
+            return ok;
+        }
         void TextureResource::post_init()
         {
             m_states.resize(count_subresources(), D3D12_RESOURCE_STATE_COMMON);
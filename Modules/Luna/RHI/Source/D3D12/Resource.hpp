@@ -31,6 +31,12 @@ namespace Luna
 
             RV init_as_committed(MemoryType memory_type, const BufferDesc& desc);
             RV init_as_aliasing(const BufferDesc& desc, DeviceMemory* memory);
+            RV init_as_reserved(const BufferDesc& desc);
+
+            ~BufferResource()
+            {
+                m_device->m_statistics.on_buffer_destroyed();
+            }
 
             virtual IDevice* get_device() override { return m_device; }
             virtual void set_name(const c8* name) override { m_name = name; set_object_name(m_res.Get(), name); }
@@ -66,6 +72,7 @@ namespace Luna
             }
             RV init_as_committed(MemoryType memory_type, const TextureDesc& desc, const ClearValue* optimized_clear_value);
             RV init_as_aliasing(const TextureDesc& desc, DeviceMemory* memory, const ClearValue* optimized_clear_value);
+            RV init_as_reserved(const TextureDesc& desc);
             void post_init();
 
             virtual IDevice* get_device() override { return m_device; }
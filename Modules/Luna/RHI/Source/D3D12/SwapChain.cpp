@@ -30,6 +30,7 @@ namespace Luna
                 }
                 m_back_buffer = new_object<TextureResource>();
                 m_back_buffer->m_device = device;
+                device->m_statistics.on_texture_created();
                 m_back_buffer->m_res = resource;
                 D3D12_RESOURCE_DESC desc = resource->GetDesc();
                 TextureUsageFlag usages = TextureUsageFlag::none;
@@ -87,7 +88,7 @@ namespace Luna
             d.Scaling = DXGI_SCALING_NONE;
             d.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
             d.AlphaMode = DXGI_ALPHA_MODE_UNSPECIFIED;
-            d.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+            d.Flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH | DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
             HWND hwnd = query_interface<Window::IWin32Window>(window->get_object())->get_hwnd();
             lutry
             {
@@ -97,6 +98,7 @@ namespace Luna
                     d.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
                 }
                 luexp(encode_hresult(dxgifac->CreateSwapChainForHwnd(m_device->m_command_queues[queue_index]->m_command_queue.Get(), hwnd, &d, NULL, NULL, &m_sc)));
+                luexp(set_max_frame_latency());
                 luexp(reset_back_buffer_resources());
             }
             lucatchret;
@@ -109,6 +111,26 @@ namespace Luna
                 WaitForSingleObject(back_buffer.m_event, INFINITE);
                 back_buffer.m_back_buffer->m_res.Reset();
             }
+            if (m_frame_latency_waitable != NULL)
+            {
+                CloseHandle(m_frame_latency_waitable);
+                m_frame_latency_waitable = NULL;
+            }
+        }
+        RV SwapChain::set_max_frame_latency()
+        {
+            lutry
+            {
+                ComPtr<IDXGISwapChain2> sc2;
+                luexp(encode_hresult(m_sc.As(&sc2)));
+                luexp(encode_hresult(sc2->SetMaximumFrameLatency(get_max_frame_latency(m_desc))));
+                if (m_frame_latency_waitable == NULL)
+                {
+                    m_frame_latency_waitable = sc2->GetFrameLatencyWaitableObject();
+                }
+            }
+            lucatchret;
+            return ok;
         }
         RV SwapChain::reset_back_buffer_resources()
         {
@@ -153,6 +175,7 @@ namespace Luna
             lutry
             {
                 auto queue = m_device->m_command_queues[m_queue]->m_command_queue.Get();
+                u64 begin_time = get_ticks();
                 luexp(encode_hresult(m_sc->Present(m_desc.vertical_synchronized ? 1 : 0, m_present_flags)));
                 auto& back_buffer = m_back_buffers[m_current_back_buffer];
                 ++back_buffer.m_wait_value;
@@ -160,10 +183,21 @@ namespace Luna
                 luexp(encode_hresult(back_buffer.m_fence->SetEventOnCompletion(back_buffer.m_wait_value, back_buffer.m_event)));
                 luexp(encode_hresult(queue->Signal(back_buffer.m_fence.Get(), back_buffer.m_wait_value)));
                 m_current_back_buffer = (m_current_back_buffer + 1) % (m_desc.buffer_count);
+                on_present(begin_time, get_ticks());
             }
             lucatchret;
             return ok;
         }
+        RV SwapChain::wait_for_next_frame()
+        {
+            lutsassert();
+            if (m_frame_latency_waitable == NULL) return ok;
+            u64 begin_time = get_ticks();
+            DWORD r = WaitForSingleObjectEx(m_frame_latency_waitable, 1000, TRUE);
+            on_wait(begin_time, get_ticks());
+            if (r == WAIT_FAILED) return BasicError::bad_platform_call();
+            return ok;
+        }
         RV SwapChain::reset(const SwapChainDesc& desc)
         {
             lutsassert();
@@ -200,13 +234,14 @@ namespace Luna
             }
             lutry
             {
-                DXGI_SWAP_CHAIN_FLAG flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH;
+                UINT flags = DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH | DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
                 if (m_allow_tearing)
                 {
                     flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
                 }
                 luexp(encode_hresult(m_sc->ResizeBuffers(modified_desc.buffer_count, modified_desc.width, modified_desc.height, encode_format(modified_desc.format), flags)));
                 m_desc = modified_desc;
+                luexp(set_max_frame_latency());
                 luexp(reset_back_buffer_resources());
             }
             lucatchret;
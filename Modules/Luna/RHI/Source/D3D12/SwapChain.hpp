@@ -52,7 +52,7 @@ namespace Luna
             }
         };
 
-        struct SwapChain : ISwapChain
+        struct SwapChain : ISwapChain, SwapChainStatsCounters
         {
             lustruct("RHI::SwapChain", "{067d14fa-59c7-4f66-8fb0-1981d90a5a45}");
             luiimpl();
@@ -65,6 +65,7 @@ namespace Luna
             SwapChainDesc m_desc;
             BOOL m_allow_tearing = FALSE;
             UINT m_present_flags = 0;
+            HANDLE m_frame_latency_waitable = NULL;
 
             Vector<SwapChainResource> m_back_buffers;
             u32 m_current_back_buffer;
@@ -78,6 +79,8 @@ namespace Luna
 
             //! Called when the back buffer is resized or when the swap chain is initialized.
             RV reset_back_buffer_resources();
+            //! Applies `m_desc.max_frame_latency` to the swap chain.
+            RV set_max_frame_latency();
 
             virtual IDevice* get_device() override
             {
@@ -101,6 +104,8 @@ namespace Luna
             virtual R<ITexture*> get_current_back_buffer() override;
             virtual RV present() override;
             virtual RV reset(const SwapChainDesc& desc) override;
+            virtual RV wait_for_next_frame() override;
+            virtual SwapChainStats get_stats() override { return m_stats; }
         };
     }
 }
\ No newline at end of file
@@ -19,27 +19,33 @@ namespace Luna
     namespace RHI
     {
         constexpr NS::UInteger MTLCounterDontSample = ((NS::UInteger)-1);
-        RV CommandBuffer::init(u32 command_queue_index)
+        RV CommandBuffer::init(u32 command_queue_index, bool secondary)
         {
             AutoreleasePool pool;
             m_command_queue_index = command_queue_index;
+            m_secondary = secondary;
+            if(secondary) return ok;
             m_buffer = retain(m_device->m_queues[command_queue_index].queue->commandBuffer());
             if(!m_buffer) return BasicError::bad_platform_call();
             return ok;
         }
         void CommandBuffer::wait()
         {
+            if(m_secondary) return;
             m_buffer->waitUntilCompleted();
         }
         bool CommandBuffer::try_wait()
         {
+            if(m_secondary) return true;
             auto status = m_buffer->status();
             return status == MTL::CommandBufferStatusCompleted || status == MTL::CommandBufferStatusError;
         }
         RV CommandBuffer::reset()
         {
+            lucheck_msg(!m_secondary, "Secondary command buffers cannot be reset directly.");
             AutoreleasePool pool;
             m_objs.clear();
+            m_statistics = CommandBufferStatistics();
             m_buffer = retain(m_device->m_queues[m_command_queue_index].queue->commandBuffer());
             if(!m_buffer) return BasicError::bad_platform_call();
             return ok;
@@ -58,8 +64,10 @@ namespace Luna
         {
             m_buffer->popDebugGroup();
         }
-        void CommandBuffer::begin_render_pass(const RenderPassDesc& desc)
+        void CommandBuffer::begin_render_pass_internal(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers)
         {
+            ++m_statistics.num_render_passes;
+            lucheck_msg(!m_secondary, "begin_render_pass cannot be called on secondary command buffers.");
             lucheck_msg(!m_render && !m_compute && !m_blit, "begin_render_pass can only be called when no other pass is open.");
             AutoreleasePool pool;
             NSPtr<MTL::RenderPassDescriptor> d = box(MTL::RenderPassDescriptor::alloc()->init());
@@ -181,7 +189,40 @@ namespace Luna
             d->setRenderTargetWidth(width);
             d->setRenderTargetHeight(height);
             d->setDefaultRasterSampleCount(desc.sample_count);
-            m_render = retain(m_buffer->renderCommandEncoder(d.get()));
+            if(secondary_command_buffers.empty())
+            {
+                m_render = retain(m_buffer->renderCommandEncoder(d.get()));
+            }
+            else
+            {
+                // Render command encoders created from one parallel render command encoder are executed in their creation order, 
+                // so the encoder of this command buffer is created last to record commands that should be executed at the end of the pass.
+                m_parallel_render = retain(m_buffer->parallelRenderCommandEncoder(d.get()));
+                for(ICommandBuffer* cmdbuf : secondary_command_buffers)
+                {
+                    CommandBuffer* secondary = cast_object<CommandBuffer>(cmdbuf->get_object());
+                    lucheck_msg(secondary->m_secondary, "Only secondary command buffers can be used in begin_parallel_render_pass.");
+                    secondary->m_objs.clear();
+                    secondary->m_statistics = CommandBufferStatistics();
+                    secondary->m_render = retain(m_parallel_render->renderCommandEncoder());
+                    attach_device_object(secondary);
+                }
+                m_render = retain(m_parallel_render->renderCommandEncoder());
+                if(m_pipeline_statistics_query_heap || m_timestamp_query_heap)
+                {
+                    // Samples the begin counters using the first encoder, so that they are executed before all secondary command buffers.
+                    CommandBuffer* first = cast_object<CommandBuffer>(secondary_command_buffers[0]->get_object());
+                    if(m_pipeline_statistics_query_heap && test_flags(m_device->m_counter_sampling_support_flags, CounterSamplingSupportFlag::draw))
+                    {
+                        first->m_render->sampleCountersInBuffer(m_pipeline_statistics_query_heap->m_buffer.get(), m_pipeline_statistics_query_index * 2, true);
+                    }
+                    if(m_timestamp_query_heap && test_flags(m_device->m_counter_sampling_support_flags, CounterSamplingSupportFlag::draw))
+                    {
+                        first->m_render->sampleCountersInBuffer(m_timestamp_query_heap->m_buffer.get(), m_timestamp_begin_query_index, true);
+                    }
+                }
+                return;
+            }
             if(m_pipeline_statistics_query_heap && test_flags(m_device->m_counter_sampling_support_flags, CounterSamplingSupportFlag::draw))
             {
                 m_render->sampleCountersInBuffer(m_pipeline_statistics_query_heap->m_buffer.get(), m_pipeline_statistics_query_index * 2, true);
@@ -197,6 +238,7 @@ namespace Luna
         }
         void CommandBuffer::set_graphics_pipeline_state(IPipelineState* pso)
         {
+            ++m_statistics.num_pipeline_state_binds;
             assert_graphcis_context();
             RenderPipelineState* p = cast_object<RenderPipelineState>(pso->get_object());
             m_render->setRenderPipelineState(p->m_pso.get());
@@ -229,6 +271,7 @@ namespace Luna
         }
         void CommandBuffer::set_graphics_descriptor_set(u32 index, IDescriptorSet* descriptor_set)
         {
+            ++m_statistics.num_descriptor_set_binds;
             lucheck_msg(index < 16, "Invalid descriptor set index range. Descriptor set index range must be in [0, 16) on Metal.");
             assert_graphcis_context();
             DescriptorSet* set = cast_object<DescriptorSet>(descriptor_set->get_object());
@@ -246,11 +289,12 @@ namespace Luna
                 }
                 m_render->useResources(resources.data(), resources.size(), binding.m_usages, binding.m_render_stages);
             }
-            m_render->setVertexBuffer(set->m_buffer.get(), 0, index);
-            m_render->setFragmentBuffer(set->m_buffer.get(), 0, index);
+            m_render->setVertexBuffer(set->m_buffer.get(), set->m_buffer_offset, index);
+            m_render->setFragmentBuffer(set->m_buffer.get(), set->m_buffer_offset, index);
         }
         void CommandBuffer::set_graphics_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets)
         {
+            m_statistics.num_descriptor_set_binds += (u32)descriptor_sets.size();
             lucheck_msg(start_index + descriptor_sets.size() < 16, "Invalid descriptor set index range. Descriptor set index range must be in [0, 16) on Metal.");
             assert_graphcis_context();
             MTL::Buffer** buffers = (MTL::Buffer**)alloca(sizeof(MTL::Buffer*) * descriptor_sets.size());
@@ -260,7 +304,7 @@ namespace Luna
             {
                 DescriptorSet* set = cast_object<DescriptorSet>(descriptor_sets[i]->get_object());
                 buffers[i] = set->m_buffer.get();
-                offsets[i] = 0;
+                offsets[i] = set->m_buffer_offset;
                 for(auto& binding : set->m_bindings)
                 {
                     if(binding.m_resources.empty()) continue;
@@ -278,6 +322,15 @@ namespace Luna
             m_render->setVertexBuffers(buffers, offsets, NS::Range::Make(start_index, (NS::UInteger)descriptor_sets.size()));
             m_render->setFragmentBuffers(buffers, offsets, NS::Range::Make(start_index, (NS::UInteger)descriptor_sets.size()));
         }
+        void CommandBuffer::set_graphics_constants(u32 first_constant, u32 num_constants, const void* data)
+        {
+            assert_graphcis_context();
+            lucheck(first_constant + num_constants <= MAX_PIPELINE_CONSTANTS);
+            memcpy(m_graphics_constants + first_constant, data, sizeof(u32) * num_constants);
+            usize size = sizeof(u32) * (first_constant + num_constants);
+            m_render->setVertexBytes(m_graphics_constants, size, PIPELINE_CONSTANTS_SLOT);
+            m_render->setFragmentBytes(m_graphics_constants, size, PIPELINE_CONSTANTS_SLOT);
+        }
         void CommandBuffer::set_viewport(const Viewport& viewport)
         {
             assert_graphcis_context();
@@ -344,11 +397,13 @@ namespace Luna
         }
         void CommandBuffer::draw(u32 vertex_count, u32 start_vertex_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_render->drawPrimitives(m_primitive_type, (NS::UInteger)start_vertex_location, (NS::UInteger)vertex_count);
         }
         void CommandBuffer::draw_indexed(u32 index_count, u32 start_index_location, i32 base_vertex_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             Buffer* buffer = cast_object<Buffer>(m_index_buffer_view.buffer->get_object());
             MTL::IndexType type = encode_index_type(m_index_buffer_view.format);
@@ -359,6 +414,7 @@ namespace Luna
         void CommandBuffer::draw_instanced(u32 vertex_count_per_instance, u32 instance_count, u32 start_vertex_location,
                 u32 start_instance_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_render->drawPrimitives(m_primitive_type, (NS::UInteger)start_vertex_location, (NS::UInteger)vertex_count_per_instance, 
                 (NS::UInteger)instance_count, (NS::UInteger)start_instance_location);
@@ -366,6 +422,7 @@ namespace Luna
         void CommandBuffer::draw_indexed_instanced(u32 index_count_per_instance, u32 instance_count, u32 start_index_location,
                 i32 base_vertex_location, u32 start_instance_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             Buffer* buffer = cast_object<Buffer>(m_index_buffer_view.buffer->get_object());
             MTL::IndexType type = encode_index_type(m_index_buffer_view.format);
@@ -373,6 +430,34 @@ namespace Luna
             m_render->drawIndexedPrimitives(m_primitive_type, (NS::UInteger)index_count_per_instance, type, 
                 buffer->m_buffer.get(), (NS::UInteger)start_index_location, instance_count, (NS::Integer)base_vertex_location, start_instance_location);
         }
+        void CommandBuffer::draw_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+            IBuffer* count_buffer, u64 count_buffer_offset)
+        {
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            lucheck_msg(!count_buffer, "DeviceFeature::indirect_draw_count is not supported.");
+            Buffer* b = cast_object<Buffer>(buffer->get_object());
+            // Metal reads one argument record per draw call, so multi-draws are emitted as separate draw calls.
+            for (u32 i = 0; i < max_draw_count; ++i)
+            {
+                m_render->drawPrimitives(m_primitive_type, b->m_buffer.get(), (NS::UInteger)(offset + (u64)stride * i));
+            }
+        }
+        void CommandBuffer::draw_indexed_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+            IBuffer* count_buffer, u64 count_buffer_offset)
+        {
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            lucheck_msg(!count_buffer, "DeviceFeature::indirect_draw_count is not supported.");
+            Buffer* b = cast_object<Buffer>(buffer->get_object());
+            Buffer* index_buffer = cast_object<Buffer>(m_index_buffer_view.buffer->get_object());
+            MTL::IndexType type = encode_index_type(m_index_buffer_view.format);
+            for (u32 i = 0; i < max_draw_count; ++i)
+            {
+                m_render->drawIndexedPrimitives(m_primitive_type, type, index_buffer->m_buffer.get(), (NS::UInteger)m_index_buffer_view.offset,
+                    b->m_buffer.get(), (NS::UInteger)(offset + (u64)stride * i));
+            }
+        }
         void CommandBuffer::begin_occlusion_query(OcclusionQueryMode mode, u32 index)
         {
             assert_graphcis_context();
@@ -391,6 +476,12 @@ namespace Luna
         void CommandBuffer::end_render_pass()
         {
             assert_graphcis_context();
+            if(m_secondary)
+            {
+                m_render->endEncoding();
+                m_render.reset();
+                return;
+            }
             if(m_timestamp_query_heap && test_flags(m_device->m_counter_sampling_support_flags, CounterSamplingSupportFlag::draw))
             {
                 if(m_timestamp_end_query_index != DONT_QUERY)
@@ -412,9 +503,15 @@ namespace Luna
             }
             m_render->endEncoding();
             m_render.reset();
+            if(m_parallel_render)
+            {
+                m_parallel_render->endEncoding();
+                m_parallel_render.reset();
+            }
         }
         void CommandBuffer::begin_compute_pass(const ComputePassDesc& desc)
         {
+            ++m_statistics.num_compute_passes;
             lucheck_msg(!m_render && !m_compute && !m_blit, "begin_compute_pass can only be called when no other pass is open.");
             AutoreleasePool pool;
             NSPtr<MTL::ComputePassDescriptor> d = box(MTL::ComputePassDescriptor::alloc()->init());
@@ -477,6 +574,7 @@ namespace Luna
         }
         void CommandBuffer::set_compute_pipeline_state(IPipelineState* pso)
         {
+            ++m_statistics.num_pipeline_state_binds;
             assert_compute_context();
             ComputePipelineState* p = cast_object<ComputePipelineState>(pso->get_object());
             m_compute->setComputePipelineState(p->m_pso.get());
@@ -484,6 +582,7 @@ namespace Luna
         }
         void CommandBuffer::set_compute_descriptor_set(u32 index, IDescriptorSet* descriptor_set)
         {
+            ++m_statistics.num_descriptor_set_binds;
             assert_compute_context();
             DescriptorSet* set = cast_object<DescriptorSet>(descriptor_set->get_object());
             Vector<MTL::Resource*> resources;
@@ -500,10 +599,11 @@ namespace Luna
                 }
                 m_compute->useResources(resources.data(), resources.size(), binding.m_usages);
             }
-            m_compute->setBuffer(set->m_buffer.get(), 0, index);
+            m_compute->setBuffer(set->m_buffer.get(), set->m_buffer_offset, index);
         }
         void CommandBuffer::set_compute_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets)
         {
+            m_statistics.num_descriptor_set_binds += (u32)descriptor_sets.size();
             assert_compute_context();
             MTL::Buffer** buffers = (MTL::Buffer**)alloca(sizeof(MTL::Buffer*) * descriptor_sets.size());
             NS::UInteger* offsets = (NS::UInteger*)alloca(sizeof(NS::UInteger) * descriptor_sets.size());
@@ -512,7 +612,7 @@ namespace Luna
             {
                 DescriptorSet* set = cast_object<DescriptorSet>(descriptor_sets[i]->get_object());
                 buffers[i] = set->m_buffer.get();
-                offsets[i] = 0;
+                offsets[i] = set->m_buffer_offset;
                 for(auto& binding : set->m_bindings)
                 {
                     if(binding.m_resources.empty()) continue;
@@ -529,12 +629,28 @@ namespace Luna
             }
             m_compute->setBuffers(buffers, offsets, NS::Range::Make(start_index, (NS::UInteger)descriptor_sets.size()));
         }
+        void CommandBuffer::set_compute_constants(u32 first_constant, u32 num_constants, const void* data)
+        {
+            assert_compute_context();
+            lucheck(first_constant + num_constants <= MAX_PIPELINE_CONSTANTS);
+            memcpy(m_compute_constants + first_constant, data, sizeof(u32) * num_constants);
+            m_compute->setBytes(m_compute_constants, sizeof(u32) * (first_constant + num_constants), PIPELINE_CONSTANTS_SLOT);
+        }
         void CommandBuffer::dispatch(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z)
         {
+            ++m_statistics.num_dispatches;
             assert_compute_context();
             m_compute->dispatchThreadgroups(MTL::Size::Make(thread_group_count_x, thread_group_count_y, thread_group_count_z), 
                 MTL::Size::Make(m_num_threads_per_group.x, m_num_threads_per_group.y, m_num_threads_per_group.z));
         }
+        void CommandBuffer::dispatch_indirect(IBuffer* buffer, u64 offset)
+        {
+            ++m_statistics.num_dispatches;
+            assert_compute_context();
+            Buffer* b = cast_object<Buffer>(buffer->get_object());
+            m_compute->dispatchThreadgroups(b->m_buffer.get(), (NS::UInteger)offset, 
+                MTL::Size::Make(m_num_threads_per_group.x, m_num_threads_per_group.y, m_num_threads_per_group.z));
+        }
         void CommandBuffer::end_compute_pass()
         {
             assert_compute_context();
@@ -562,6 +678,7 @@ namespace Luna
         }
         void CommandBuffer::begin_copy_pass(const CopyPassDesc& desc)
         {
+            ++m_statistics.num_copy_passes;
             lucheck_msg(!m_render && !m_compute && !m_blit, "begin_copy_pass can only be called when no other pass is open.");
             AutoreleasePool pool;
             NSPtr<MTL::BlitPassDescriptor> d = box(MTL::BlitPassDescriptor::alloc()->init());
@@ -595,6 +712,7 @@ namespace Luna
         }
         void CommandBuffer::copy_resource(IResource* dst, IResource* src)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
             {
                 Buffer* d = cast_object<Buffer>(dst->get_object());
@@ -619,6 +737,7 @@ namespace Luna
             IBuffer* src, u64 src_offset,
             u64 copy_bytes)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
             Buffer* d = cast_object<Buffer>(dst->get_object());
             Buffer* s = cast_object<Buffer>(src->get_object());
@@ -629,6 +748,7 @@ namespace Luna
             ITexture* src, SubresourceIndex src_subresource, u32 src_x, u32 src_y, u32 src_z,
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
             Texture* d = cast_object<Texture>(dst->get_object());
             Texture* s = cast_object<Texture>(src->get_object());
@@ -641,6 +761,7 @@ namespace Luna
             IBuffer* src, u64 src_offset, u32 src_row_pitch, u32 src_slice_pitch,
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
             Texture* d = cast_object<Texture>(dst->get_object());
             Buffer* s = cast_object<Buffer>(src->get_object());
@@ -653,6 +774,7 @@ namespace Luna
             ITexture* src, SubresourceIndex src_subresource, u32 src_x, u32 src_y, u32 src_z,
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
             Buffer* d = cast_object<Buffer>(dst->get_object());
             Texture* s = cast_object<Texture>(src->get_object());
@@ -677,6 +799,7 @@ namespace Luna
         }
         void CommandBuffer::resource_barrier(Span<const BufferBarrier> buffer_barriers, Span<const TextureBarrier> texture_barriers)
         {
+            m_statistics.num_barriers += (u32)(buffer_barriers.size() + texture_barriers.size());
              if(m_compute)
              {
                  usize num_resources = buffer_barriers.size() + texture_barriers.size();
@@ -697,32 +820,60 @@ namespace Luna
                  m_compute->memoryBarrier(resources, i);
              }
         }
-        RV CommandBuffer::submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting)
+        RV CommandBuffer::submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting,
+            Span<const u64> wait_values, Span<const u64> signal_values)
         {
+            lucheck_msg(!m_secondary, "Secondary command buffers cannot be submitted directly.");
             AutoreleasePool pool;
             if(!wait_fences.empty())
             {
                 MTL::CommandBuffer* wait_buffer = m_device->m_queues[m_command_queue_index].queue->commandBuffer();
-                MTL::BlitCommandEncoder* encoder = wait_buffer->blitCommandEncoder();
-                for(IFence* fence : wait_fences)
+                // Shared events are waited outside of encoders.
+                bool has_binary_fence = false;
+                for(usize i = 0; i < wait_fences.size(); ++i)
                 {
-                    Fence* f = cast_object<Fence>(fence->get_object());
-                    encoder->waitForFence(f->m_fence.get());
+                    Fence* f = cast_object<Fence>(wait_fences[i]->get_object());
+                    if(f->m_type == FenceType::timeline) wait_buffer->encodeWait(f->m_event.get(), wait_values[i]);
+                    else has_binary_fence = true;
+                }
+                if(has_binary_fence)
+                {
+                    MTL::BlitCommandEncoder* encoder = wait_buffer->blitCommandEncoder();
+                    for(IFence* fence : wait_fences)
+                    {
+                        Fence* f = cast_object<Fence>(fence->get_object());
+                        if(f->m_type == FenceType::binary) encoder->waitForFence(f->m_fence.get());
+                    }
+                    encoder->endEncoding();
                 }
-                encoder->endEncoding();
                 wait_buffer->commit();
             }
             if(!signal_fences.empty())
             {
-                MTL::BlitCommandEncoder* encoder = m_buffer->blitCommandEncoder();
+                bool has_binary_fence = false;
                 for(IFence* fence : signal_fences)
                 {
                     Fence* f = cast_object<Fence>(fence->get_object());
-                    encoder->updateFence(f->m_fence.get());
+                    if(f->m_type == FenceType::binary) has_binary_fence = true;
+                }
+                if(has_binary_fence)
+                {
+                    MTL::BlitCommandEncoder* encoder = m_buffer->blitCommandEncoder();
+                    for(IFence* fence : signal_fences)
+                    {
+                        Fence* f = cast_object<Fence>(fence->get_object());
+                        if(f->m_type == FenceType::binary) encoder->updateFence(f->m_fence.get());
+                    }
+                    encoder->endEncoding();
+                }
+                for(usize i = 0; i < signal_fences.size(); ++i)
+                {
+                    Fence* f = cast_object<Fence>(signal_fences[i]->get_object());
+                    if(f->m_type == FenceType::timeline) m_buffer->encodeSignalEvent(f->m_event.get(), signal_values[i]);
                 }
-                encoder->endEncoding();
             }
             m_buffer->commit();
+            m_device->m_statistics.on_command_buffer_submitted(this, m_statistics);
             return ok;
         }
     }
@@ -26,15 +26,26 @@ namespace Luna
 
             // The attached graphic objects.
             Vector<Ref<IDeviceChild>> m_objs;
+            CommandBufferStatistics m_statistics;
 
             NSPtr<MTL::RenderCommandEncoder> m_render;
             NSPtr<MTL::ComputeCommandEncoder> m_compute;
             NSPtr<MTL::BlitCommandEncoder> m_blit;
 
+            // Whether this is one secondary command buffer. Secondary command buffers only have render command encoders 
+            // created from the parallel render command encoder of primary command buffers.
+            bool m_secondary = false;
+            // The parallel render command encoder of the current render pass begun by `begin_parallel_render_pass`.
+            NSPtr<MTL::ParallelRenderCommandEncoder> m_parallel_render;
+
             IndexBufferView m_index_buffer_view;
             MTL::PrimitiveType m_primitive_type;
 
             UInt3U m_num_threads_per_group;
+
+            // Shadow copies of pipeline constants, since Metal can only set constants as a whole.
+            u32 m_graphics_constants[MAX_PIPELINE_CONSTANTS];
+            u32 m_compute_constants[MAX_PIPELINE_CONSTANTS];
             
             // Used if stage boundary counter sample is not supported.
             CounterSampleQueryHeap* m_timestamp_query_heap = nullptr;
@@ -44,7 +55,8 @@ namespace Luna
             u32 m_pipeline_statistics_query_index = DONT_QUERY;
             
 
-            RV init(u32 command_queue_index);
+            RV init(u32 command_queue_index, bool secondary = false);
+            void begin_render_pass_internal(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers);
 
             void assert_graphcis_context()
             {
@@ -68,33 +80,54 @@ namespace Luna
             }
 
             virtual IDevice* get_device() override { return m_device; }
-            virtual void set_name(const c8* name) override  { set_object_name(m_buffer.get(), name); }
+            virtual void set_name(const c8* name) override  { if(m_buffer) set_object_name(m_buffer.get(), name); }
             virtual void wait() override;
             virtual bool try_wait() override;
             virtual u32 get_command_queue_index() override { return m_command_queue_index; }
             virtual RV reset() override;
             virtual void attach_device_object(IDeviceChild* obj) override;
+            virtual CommandBufferStatistics get_statistics() override { return m_statistics; }
             virtual void begin_event(const c8* event_name) override;
             virtual void end_event() override;
-            virtual void begin_render_pass(const RenderPassDesc& desc) override;
+            virtual void begin_render_pass(const RenderPassDesc& desc) override
+            {
+                begin_render_pass_internal(desc, {});
+            }
+            virtual void begin_parallel_render_pass(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers) override
+            {
+                begin_render_pass_internal(desc, secondary_command_buffers);
+            }
             virtual void set_graphics_pipeline_layout(IPipelineLayout* pipeline_layout) override;
             virtual void set_graphics_pipeline_state(IPipelineState* pso) override;
             virtual void set_vertex_buffers(u32 start_slot, Span<const VertexBufferView> views) override;
             virtual void set_index_buffer(const IndexBufferView& view) override;
             virtual void set_graphics_descriptor_set(u32 index, IDescriptorSet* descriptor_set) override;
             virtual void set_graphics_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) override;
+            virtual void set_graphics_constants(u32 first_constant, u32 num_constants, const void* data) override;
             virtual void set_viewport(const Viewport& viewport) override;
             virtual void set_viewports(Span<const Viewport> viewports) override;
             virtual void set_scissor_rect(const RectI& rect) override;
             virtual void set_scissor_rects(Span<const RectI> rects) override;
             virtual void set_blend_factor(const Float4U& blend_factor) override;
             virtual void set_stencil_ref(u32 stencil_ref) override;
+            virtual void set_shading_rate(ShadingRate rate, ShadingRateCombiner primitive_combiner, ShadingRateCombiner image_combiner) override
+            {
+                lupanic_msg("set_shading_rate is not supported by Metal backend.");
+            }
             virtual void draw(u32 vertex_count, u32 start_vertex_location) override;
             virtual void draw_indexed(u32 index_count, u32 start_index_location, i32 base_vertex_location) override;
             virtual void draw_instanced(u32 vertex_count_per_instance, u32 instance_count, u32 start_vertex_location,
                 u32 start_instance_location) override;
+            virtual void dispatch_mesh(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) override
+            {
+                lupanic_msg("dispatch_mesh is not supported by Metal backend.");
+            }
             virtual void draw_indexed_instanced(u32 index_count_per_instance, u32 instance_count, u32 start_index_location,
                 i32 base_vertex_location, u32 start_instance_location) override;
+            virtual void draw_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+                IBuffer* count_buffer, u64 count_buffer_offset) override;
+            virtual void draw_indexed_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+                IBuffer* count_buffer, u64 count_buffer_offset) override;
             virtual void begin_occlusion_query(OcclusionQueryMode mode, u32 index) override;
             virtual void end_occlusion_query(u32 index) override;
             virtual void end_render_pass() override;
@@ -103,7 +136,14 @@ namespace Luna
             virtual void set_compute_pipeline_state(IPipelineState* pso) override;
             virtual void set_compute_descriptor_set(u32 index, IDescriptorSet* descriptor_set) override;
             virtual void set_compute_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) override;
+            virtual void set_compute_constants(u32 first_constant, u32 num_constants, const void* data) override;
             virtual void dispatch(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) override;
+            virtual void dispatch_indirect(IBuffer* buffer, u64 offset) override;
+            virtual void build_acceleration_structure(IAccelerationStructure* dst, const AccelerationStructureBuildInputs& inputs,
+                IBuffer* scratch_buffer, u64 scratch_buffer_offset, IAccelerationStructure* update_src) override
+            {
+                lupanic_msg("build_acceleration_structure is not supported by Metal backend.");
+            }
             virtual void end_compute_pass() override;
             virtual void begin_copy_pass(const CopyPassDesc& desc) override;
             virtual void copy_resource(IResource* dst, IResource* src) override;
@@ -125,7 +165,8 @@ namespace Luna
                 u32 copy_width, u32 copy_height, u32 copy_depth) override;
             virtual void end_copy_pass() override;
             virtual void resource_barrier(Span<const BufferBarrier> buffer_barriers, Span<const TextureBarrier> texture_barriers) override;
-            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting) override;
+            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting,
+                Span<const u64> wait_values, Span<const u64> signal_values) override;
         };
     }
 }
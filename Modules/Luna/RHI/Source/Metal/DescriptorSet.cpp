@@ -13,7 +13,25 @@ namespace Luna
 {
     namespace RHI
     {
-        RV DescriptorSet::init(const DescriptorSetDesc& desc)
+        RV DescriptorSet::allocate_buffer(DescriptorSetArena* arena, usize size)
+        {
+            if(arena)
+            {
+                auto r = arena->allocate(size);
+                if(failed(r)) return r.errcode();
+                m_buffer = retain(r.get().first);
+                m_buffer_offset = r.get().second;
+                return ok;
+            }
+            m_buffer = box(m_device->m_device->newBuffer(size, encode_resource_options(MemoryType::upload)));
+            if(!m_buffer)
+            {
+                return BasicError::bad_platform_call();
+            }
+            m_buffer_offset = 0;
+            return ok;
+        }
+        RV DescriptorSet::init(const DescriptorSetDesc& desc, DescriptorSetArena* arena)
         {
             AutoreleasePool pool;
             m_layout = cast_object<DescriptorSetLayout>(desc.layout);
@@ -58,11 +76,8 @@ namespace Luna
                 {
                     num_arguments += desc.num_variable_descriptors;
                 }
-                m_buffer = box(m_device->m_device->newBuffer(sizeof(u64) * num_arguments, encode_resource_options(MemoryType::upload)));
-                if(!m_buffer)
-                {
-                    return BasicError::bad_platform_call();
-                }
+                auto r = allocate_buffer(arena, sizeof(u64) * num_arguments);
+                if(failed(r)) return r.errcode();
             }
             else
             {
@@ -72,12 +87,9 @@ namespace Luna
                     return BasicError::bad_platform_call();
                 }
                 NS::UInteger length = m_encoder->encodedLength();
-                m_buffer = box(m_device->m_device->newBuffer(length, encode_resource_options(MemoryType::upload)));
-                if(!m_buffer)
-                {
-                    return BasicError::bad_platform_call();
-                }
-                m_encoder->setArgumentBuffer(m_buffer.get(), 0);
+                auto r = allocate_buffer(arena, length);
+                if(failed(r)) return r.errcode();
+                m_encoder->setArgumentBuffer(m_buffer.get(), m_buffer_offset);
             }
             return ok;
         }
@@ -143,12 +155,13 @@ namespace Luna
         }
         RV DescriptorSet::update_descriptors(Span<const WriteDescriptorSet> writes)
         {
+            m_device->m_statistics.on_descriptors_written(writes);
             lutry
             {
                 u64* data = nullptr;
                 if (m_device->m_support_metal_3_family)
                 {
-                    data = (u64*)m_buffer->contents();
+                    data = (u64*)((u8*)m_buffer->contents() + m_buffer_offset);
                 }
                 for(auto& write : writes)
                 {
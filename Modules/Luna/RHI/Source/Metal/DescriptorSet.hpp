@@ -11,6 +11,7 @@
 #include "Device.hpp"
 #include "DescriptorSetLayout.hpp"
 #include "TextureView.hpp"
+#include "DescriptorSetArena.hpp"
 
 namespace Luna
 {
@@ -33,14 +34,18 @@ namespace Luna
             Ref<Device> m_device;
             Ref<DescriptorSetLayout> m_layout;
             NSPtr<MTL::Buffer> m_buffer;
+            // The offset of the argument buffer data in `m_buffer`. This is not zero if the set is allocated from one 
+            // descriptor set arena.
+            usize m_buffer_offset = 0;
             NSPtr<MTL::ArgumentEncoder> m_encoder; // Used only if the platform does not support metal 3.
             
             Array<DescriptorSetBinding> m_bindings;
             
-            RV init(const DescriptorSetDesc& desc);
+            RV init(const DescriptorSetDesc& desc, DescriptorSetArena* arena = nullptr);
 
             HashMap<u32, NSPtr<MTL::SamplerState>> m_samplers;
 
+            RV allocate_buffer(DescriptorSetArena* arena, usize size);
             usize calc_binding_index(u32 binding_slot) const;
             
             virtual IDevice* get_device() override { return m_device; }
@@ -0,0 +1,62 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DescriptorSetArena.cpp
+* @author JXMaster
+* @date 2024/4/1
+*/
+#include "DescriptorSetArena.hpp"
+#include "DescriptorSet.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        constexpr usize ARGUMENT_BUFFER_BLOCK_SIZE = 65536;
+        // Argument buffer offsets must be aligned to 256 bytes on some platforms.
+        constexpr usize ARGUMENT_BUFFER_ALIGNMENT = 256;
+
+        R<Pair<MTL::Buffer*, usize>> DescriptorSetArena::allocate(usize size)
+        {
+            size = align_upper(size, ARGUMENT_BUFFER_ALIGNMENT);
+            while (m_current_buffer < m_buffers.size())
+            {
+                MTL::Buffer* buffer = m_buffers[m_current_buffer].get();
+                if (buffer->length() - m_current_offset >= size)
+                {
+                    usize offset = m_current_offset;
+                    m_current_offset += size;
+                    return make_pair(buffer, offset);
+                }
+                ++m_current_buffer;
+                m_current_offset = 0;
+            }
+            NSPtr<MTL::Buffer> buffer = box(m_device->m_device->newBuffer(max(size, ARGUMENT_BUFFER_BLOCK_SIZE), encode_resource_options(MemoryType::upload)));
+            if (!buffer) return BasicError::bad_platform_call();
+            m_buffers.push_back(buffer);
+            m_current_buffer = m_buffers.size() - 1;
+            m_current_offset = size;
+            return make_pair(buffer.get(), (usize)0);
+        }
+        R<Ref<IDescriptorSet>> DescriptorSetArena::new_descriptor_set(const DescriptorSetDesc& desc)
+        {
+            Ref<IDescriptorSet> ret;
+            lutry
+            {
+                Ref<DescriptorSet> o = new_object<DescriptorSet>();
+                o->m_device = m_device;
+                luexp(o->init(desc, this));
+                ret = o;
+            }
+            lucatchret;
+            return ret;
+        }
+        void DescriptorSetArena::reset()
+        {
+            m_current_buffer = 0;
+            m_current_offset = 0;
+        }
+    }
+}
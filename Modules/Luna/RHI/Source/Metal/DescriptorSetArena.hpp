@@ -0,0 +1,39 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DescriptorSetArena.hpp
+* @author JXMaster
+* @date 2024/4/1
+*/
+#pragma once
+#include "Device.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct DescriptorSetArena : IDescriptorSetArena
+        {
+            lustruct("RHI::DescriptorSetArena", "{E1B5047C-9A3D-4E62-8F07-6C4D2B9A13E8}");
+            luiimpl();
+
+            Ref<Device> m_device;
+            // Argument buffers that descriptor set data are allocated from.
+            Vector<NSPtr<MTL::Buffer>> m_buffers;
+            // The buffer that descriptor set data are allocated from.
+            usize m_current_buffer = 0;
+            // The number of bytes allocated from the current buffer.
+            usize m_current_offset = 0;
+
+            //! Allocates `size` bytes of argument buffer memory.
+            R<Pair<MTL::Buffer*, usize>> allocate(usize size);
+
+            virtual IDevice* get_device() override { return m_device; }
+            virtual void set_name(const c8* name) override  { }
+            virtual R<Ref<IDescriptorSet>> new_descriptor_set(const DescriptorSetDesc& desc) override;
+            virtual void reset() override;
+        };
+    }
+}
@@ -16,7 +16,9 @@
 #include "CommandBuffer.hpp"
 #include "PipelineLayout.hpp"
 #include "PipelineState.hpp"
+#include "PipelineCache.hpp"
 #include "DescriptorSet.hpp"
+#include "DescriptorSetArena.hpp"
 #include "QueryHeap.hpp"
 #include "Fence.hpp"
 #include "SwapChain.hpp"
@@ -128,6 +130,27 @@ namespace Luna
             case DeviceFeature::uniform_buffer_data_alignment:
                 ret.uniform_buffer_data_alignment = 0;
                 break;
+            case DeviceFeature::indirect_draw_count:
+                ret.indirect_draw_count = false;
+                break;
+            case DeviceFeature::timeline_fence:
+                ret.timeline_fence = true;
+                break;
+            case DeviceFeature::mesh_shader:
+                ret.mesh_shader = false;
+                break;
+            case DeviceFeature::ray_tracing:
+                ret.ray_tracing = false;
+                break;
+            case DeviceFeature::variable_rate_shading:
+                ret.variable_rate_shading = false;
+                break;
+            case DeviceFeature::shading_rate_image_tile_size:
+                ret.shading_rate_image_tile_size = 0;
+                break;
+            case DeviceFeature::reserved_resources:
+                ret.reserved_resources = false;
+                break;
             default: lupanic();
             }
             return ret;
@@ -150,6 +173,7 @@ namespace Luna
             {
                 Ref<Buffer> buffer = new_object<Buffer>();
                 buffer->m_device = this;
+                m_statistics.on_buffer_created();
                 luexp(buffer->init_as_committed(memory_type, desc));
                 ret = buffer;
             }
@@ -163,6 +187,7 @@ namespace Luna
             {
                 Ref<Texture> texture = new_object<Texture>();
                 texture->m_device = this;
+                m_statistics.on_texture_created();
                 luexp(texture->init_as_committed(memory_type, desc));
                 ret = texture;
             }
@@ -196,6 +221,7 @@ namespace Luna
             {
                 Ref<Buffer> buffer = new_object<Buffer>();
                 buffer->m_device = this;
+                m_statistics.on_buffer_created();
                 luexp(buffer->init_as_aliasing(device_memory, desc));
                 ret = buffer;
             }
@@ -209,12 +235,34 @@ namespace Luna
             {
                 Ref<Texture> texture = new_object<Texture>();
                 texture->m_device = this;
+                m_statistics.on_texture_created();
                 luexp(texture->init_as_aliasing(device_memory, desc));
                 ret = texture;
             }
             lucatchret;
             return ret;
         }
+        DeviceMemoryBudget Device::get_memory_budget()
+        {
+            // Metal devices use unified memory, and the device does not report block statistics, so all
+            // memory allocated by the device is reported as both occupied and used.
+            DeviceMemoryBudget ret;
+            u64 allocated = (u64)m_device->currentAllocatedSize();
+            ret.local.block_bytes = allocated;
+            ret.local.allocation_bytes = allocated;
+            ret.local.usage = allocated;
+            ret.local.budget = (u64)m_device->recommendedMaxWorkingSetSize();
+            return ret;
+        }
+        void Device::update_memory_budget()
+        {
+            DeviceMemoryBudget budget = get_memory_budget();
+            if (is_memory_budget_changed(m_last_memory_budget, budget))
+            {
+                m_last_memory_budget = budget;
+                m_memory_budget_change_event(this, budget);
+            }
+        }
         R<Ref<IPipelineLayout>> Device::new_pipeline_layout(const PipelineLayoutDesc& desc)
         {
             Ref<IPipelineLayout> ret;
@@ -228,6 +276,19 @@ namespace Luna
             lucatchret;
             return ret;
         }
+        R<Ref<IPipelineCache>> Device::new_pipeline_cache(Span<const byte_t> initial_data)
+        {
+            Ref<IPipelineCache> ret;
+            lutry
+            {
+                Ref<PipelineCache> o = new_object<PipelineCache>();
+                o->m_device = this;
+                luexp(o->init(initial_data));
+                ret = o;
+            }
+            lucatchret;
+            return ret;
+        }
         R<Ref<IPipelineState>> Device::new_graphics_pipeline_state(const GraphicsPipelineStateDesc& desc)
         {
             Ref<IPipelineState> ret;
@@ -236,6 +297,7 @@ namespace Luna
                 Ref<RenderPipelineState> o = new_object<RenderPipelineState>();
                 o->m_device = this;
                 luexp(o->init(desc));
+                m_statistics.on_pipeline_state_created();
                 ret = o;
             }
             lucatchret;
@@ -249,11 +311,18 @@ namespace Luna
                 Ref<ComputePipelineState> o = new_object<ComputePipelineState>();
                 o->m_device = this;
                 luexp(o->init(desc));
+                m_statistics.on_pipeline_state_created();
                 ret = o;
             }
             lucatchret;
             return ret;
         }
+        R<Ref<IPipelineState>> Device::new_mesh_pipeline_state(const MeshPipelineStateDesc& desc)
+        {
+            // Metal mesh pipelines require object and mesh functions compiled from MSL, which are not produced by the 
+            // shader compiler yet.
+            return BasicError::not_supported();
+        }
         R<Ref<IDescriptorSetLayout>> Device::new_descriptor_set_layout(const DescriptorSetLayoutDesc& desc)
         {
             Ref<IDescriptorSetLayout> ret;
@@ -275,11 +344,18 @@ namespace Luna
                 Ref<DescriptorSet> o = new_object<DescriptorSet>();
                 o->m_device = this;
                 luexp(o->init(desc));
+                m_statistics.on_descriptor_set_created();
                 ret = o;
             }
             lucatchret;
             return ret;
         }
+        R<Ref<IDescriptorSetArena>> Device::new_descriptor_set_arena()
+        {
+            Ref<DescriptorSetArena> o = new_object<DescriptorSetArena>();
+            o->m_device = this;
+            return Ref<IDescriptorSetArena>(o);
+        }
         u32 Device::get_num_command_queues()
         {
             return (u32)m_queues.size();
@@ -301,6 +377,19 @@ namespace Luna
             lucatchret;
             return ret;
         }
+        R<Ref<ICommandBuffer>> Device::new_secondary_command_buffer(u32 command_queue_index)
+        {
+            Ref<ICommandBuffer> ret;
+            lutry
+            {
+                Ref<CommandBuffer> buf = new_object<CommandBuffer>();
+                buf->m_device = this;
+                luexp(buf->init(command_queue_index, true));
+                ret = buf;
+            }
+            lucatchret;
+            return ret;
+        }
         R<f64> Device::get_command_queue_timestamp_frequency(u32 command_queue_index)
         {
             if(m_timestamp_frequency == 0.0)
@@ -342,14 +431,14 @@ namespace Luna
             lucatchret;
             return ret;
         }
-        R<Ref<IFence>> Device::new_fence()
+        R<Ref<IFence>> Device::new_fence(FenceType type, u64 initial_value)
         {
             Ref<IFence> ret;
             lutry
             {
                 Ref<Fence> fence = new_object<Fence>();
                 fence->m_device = this;
-                luexp(fence->init());
+                luexp(fence->init(type, initial_value));
                 ret = fence;
             }
             lucatchret;
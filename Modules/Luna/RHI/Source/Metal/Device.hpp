@@ -9,6 +9,9 @@
 */
 #pragma once
 #include "Common.hpp"
+#include "../PipelineStateRequest.hpp"
+#include "../BindlessResourceTable.hpp"
+#include "../UploadRingBuffer.hpp"
 #include "../../Device.hpp"
 namespace Luna
 {
@@ -44,6 +47,12 @@ namespace Luna
             CounterSamplingSupportFlag m_counter_sampling_support_flags = CounterSamplingSupportFlag::none;
             bool m_support_metal_3_family;
 
+            Event<memory_budget_change_event_handler_t> m_memory_budget_change_event;
+            DeviceMemoryBudget m_last_memory_budget;
+
+            // Statistics.
+            DeviceStatisticsCounters m_statistics;
+
             RV init();
 
             MTL::SizeAndAlign get_buffer_size(MemoryType memory_type, const BufferDesc& desc);
@@ -60,18 +69,74 @@ namespace Luna
             virtual R<Ref<IDeviceMemory>> allocate_memory(MemoryType memory_type, Span<const BufferDesc> buffers, Span<const TextureDesc> textures) override;
             virtual R<Ref<IBuffer>> new_aliasing_buffer(IDeviceMemory* device_memory, const BufferDesc& desc) override;
             virtual R<Ref<ITexture>> new_aliasing_texture(IDeviceMemory* device_memory, const TextureDesc& desc, const ClearValue* optimized_clear_value) override;
+            virtual R<Ref<IBuffer>> new_reserved_buffer(const BufferDesc& desc) override
+            {
+                return BasicError::not_supported();
+            }
+            virtual R<Ref<ITexture>> new_reserved_texture(const TextureDesc& desc) override
+            {
+                return BasicError::not_supported();
+            }
+            virtual ReservedTextureTiling get_reserved_texture_tiling(ITexture* texture) override
+            {
+                ReservedTextureTiling r;
+                memzero(&r, sizeof(ReservedTextureTiling));
+                return r;
+            }
+            virtual R<Ref<IDeviceMemory>> allocate_tile_memory(u32 num_tiles) override
+            {
+                return BasicError::not_supported();
+            }
+            virtual RV update_tile_mappings(u32 command_queue_index, IResource* resource, Span<const TileMapping> mappings) override
+            {
+                return BasicError::not_supported();
+            }
+            virtual AccelerationStructureSizes get_acceleration_structure_sizes(const AccelerationStructureBuildInputs& inputs) override
+            {
+                AccelerationStructureSizes r;
+                memzero(&r, sizeof(AccelerationStructureSizes));
+                return r;
+            }
+            virtual R<Ref<IAccelerationStructure>> new_acceleration_structure(const AccelerationStructureDesc& desc) override
+            {
+                return BasicError::not_supported();
+            }
+            virtual DeviceMemoryBudget get_memory_budget() override;
+            virtual Event<memory_budget_change_event_handler_t>& get_memory_budget_change_event() override { return m_memory_budget_change_event; }
+            virtual void update_memory_budget() override;
             virtual R<Ref<IPipelineLayout>> new_pipeline_layout(const PipelineLayoutDesc& desc) override;
+            virtual R<Ref<IPipelineCache>> new_pipeline_cache(Span<const byte_t> initial_data) override;
             virtual R<Ref<IPipelineState>> new_graphics_pipeline_state(const GraphicsPipelineStateDesc& desc) override;
             virtual R<Ref<IPipelineState>> new_compute_pipeline_state(const ComputePipelineStateDesc& desc) override;
+            virtual R<Ref<IPipelineState>> new_mesh_pipeline_state(const MeshPipelineStateDesc& desc) override;
+            virtual Ref<IPipelineStateRequest> new_graphics_pipeline_state_async(const GraphicsPipelineStateDesc& desc) override
+            {
+                return new_graphics_pipeline_state_request(this, desc);
+            }
+            virtual Ref<IPipelineStateRequest> new_compute_pipeline_state_async(const ComputePipelineStateDesc& desc) override
+            {
+                return new_compute_pipeline_state_request(this, desc);
+            }
             virtual R<Ref<IDescriptorSetLayout>> new_descriptor_set_layout(const DescriptorSetLayoutDesc& desc) override;
             virtual R<Ref<IDescriptorSet>> new_descriptor_set(const DescriptorSetDesc& desc) override;
+            virtual R<Ref<IDescriptorSetArena>> new_descriptor_set_arena() override;
+            virtual R<Ref<IBindlessResourceTable>> new_bindless_resource_table(const BindlessResourceTableDesc& desc) override
+            {
+                return RHI::new_bindless_resource_table(this, desc);
+            }
+            virtual R<Ref<IUploadRingBuffer>> new_upload_ring_buffer(const UploadRingBufferDesc& desc) override
+            {
+                return RHI::new_upload_ring_buffer(this, desc);
+            }
             virtual u32 get_num_command_queues() override;
             virtual CommandQueueDesc get_command_queue_desc(u32 command_queue_index) override;
             virtual R<Ref<ICommandBuffer>> new_command_buffer(u32 command_queue_index) override;
+            virtual R<Ref<ICommandBuffer>> new_secondary_command_buffer(u32 command_queue_index) override;
             virtual R<f64> get_command_queue_timestamp_frequency(u32 command_queue_index) override;
             virtual R<Ref<IQueryHeap>> new_query_heap(const QueryHeapDesc& desc) override;
-            virtual R<Ref<IFence>> new_fence() override;
+            virtual R<Ref<IFence>> new_fence(FenceType type, u64 initial_value) override;
             virtual R<Ref<ISwapChain>> new_swap_chain(u32 command_queue_index, Window::IWindow* window, const SwapChainDesc& desc) override;
+            virtual DeviceStatistics get_statistics() override { return m_statistics.m_statistics; }
         };
 
         extern Ref<IDevice> g_main_device;
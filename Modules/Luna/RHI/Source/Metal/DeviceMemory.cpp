@@ -20,6 +20,7 @@ namespace Luna
                 m_heap = box(m_device->m_device->newHeap(desc));
                 if(!m_heap) return BasicError::bad_platform_call();
                 m_size = m_heap->size();
+                m_device->m_statistics.on_memory_allocated(m_device, m_memory_type, m_size);
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
                 memory_profiler_allocate(m_heap.get(), m_size);
                 memory_profiler_set_memory_domain(m_heap.get(), "GPU", 3);
@@ -31,6 +32,7 @@ namespace Luna
         }
         DeviceMemory::~DeviceMemory()
         {
+            if(m_size) m_device->m_statistics.on_memory_freed(m_device, m_memory_type, m_size);
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
             if(m_heap) memory_profiler_deallocate(m_heap.get());
 #endif
@@ -22,7 +22,7 @@ namespace Luna
             Ref<Device> m_device;
             NSPtr<MTL::Heap> m_heap; // This may be `nullptr`, which represents one non-sharable memory.
             MemoryType m_memory_type;
-            u64 m_size;
+            u64 m_size = 0;
 
             RV init(MTL::HeapDescriptor* desc);
             ~DeviceMemory();
@@ -8,14 +8,39 @@
 * @date 2023/8/3
 */
 #include "Fence.hpp"
+#include <Luna/Runtime/Thread.hpp>
 
 namespace Luna
 {
     namespace RHI
     {
-        RV Fence::init()
+        RV Fence::init(FenceType type, u64 initial_value)
         {
-            m_fence = box(m_device->m_device->newFence());
+            m_type = type;
+            if(type == FenceType::timeline)
+            {
+                m_event = box(m_device->m_device->newSharedEvent());
+                m_event->setSignaledValue(initial_value);
+            }
+            else
+            {
+                m_fence = box(m_device->m_device->newFence());
+            }
+            return ok;
+        }
+        RV Fence::wait(u64 value)
+        {
+            lucheck_msg(m_type == FenceType::timeline, "Only timeline fences can be waited from host.");
+            while(m_event->signaledValue() < value)
+            {
+                yield_current_thread();
+            }
+            return ok;
+        }
+        RV Fence::signal(u64 value)
+        {
+            lucheck_msg(m_type == FenceType::timeline, "Only timeline fences can be signaled from host.");
+            m_event->setSignaledValue(value);
             return ok;
         }
     }
@@ -20,12 +20,24 @@ namespace Luna
             luiimpl();
 
             Ref<Device> m_device;
+            FenceType m_type;
+            // Used by binary fences.
             NSPtr<MTL::Fence> m_fence;
+            // Used by timeline fences.
+            NSPtr<MTL::SharedEvent> m_event;
 
-            RV init();
+            RV init(FenceType type, u64 initial_value);
 
             virtual IDevice* get_device() override { return m_device; }
-            virtual void set_name(const c8* name) override  { set_object_name(m_fence.get(), name); }
+            virtual void set_name(const c8* name) override
+            {
+                if(m_fence) set_object_name(m_fence.get(), name);
+                if(m_event) set_object_name(m_event.get(), name);
+            }
+            virtual FenceType get_type() override { return m_type; }
+            virtual u64 get_completed_value() override { return m_event ? m_event->signaledValue() : 0; }
+            virtual RV wait(u64 value) override;
+            virtual RV signal(u64 value) override;
         };
     }
 }
\ No newline at end of file
@@ -14,9 +14,11 @@
 #include "Adapter.hpp"
 #include "CommandBuffer.hpp"
 #include "DescriptorSet.hpp"
+#include "DescriptorSetArena.hpp"
 #include "Resource.hpp"
 #include "Fence.hpp"
 #include "PipelineState.hpp"
+#include "PipelineCache.hpp"
 #include "QueryHeap.hpp"
 #include "PipelineLayout.hpp"
 #include "SwapChain.hpp"
@@ -34,6 +36,8 @@ namespace Luna
                 impl_interface_for_type<CommandBuffer, ICommandBuffer, IDeviceChild, IWaitable>();
                 register_boxed_type<DescriptorSet>();
                 impl_interface_for_type<DescriptorSet, IDescriptorSet, IDeviceChild>();
+                register_boxed_type<DescriptorSetArena>();
+                impl_interface_for_type<DescriptorSetArena, IDescriptorSetArena, IDeviceChild>();
                 register_boxed_type<DescriptorSetLayout>();
                 impl_interface_for_type<DescriptorSetLayout, IDescriptorSetLayout, IDeviceChild>();
                 register_boxed_type<Device>();
@@ -46,6 +50,8 @@ namespace Luna
                 impl_interface_for_type<RenderPipelineState, IPipelineState, IDeviceChild>();
                 register_boxed_type<ComputePipelineState>();
                 impl_interface_for_type<ComputePipelineState, IPipelineState, IDeviceChild>();
+                register_boxed_type<PipelineCache>();
+                impl_interface_for_type<PipelineCache, IPipelineCache, IDeviceChild>();
                 register_boxed_type<BufferQueryHeap>();
                 impl_interface_for_type<BufferQueryHeap, IQueryHeap, IDeviceChild>();
                 register_boxed_type<CounterSampleQueryHeap>();
@@ -0,0 +1,90 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PipelineCache.cpp
+* @author JXMaster
+* @date 2024/3/30
+*/
+#include "PipelineCache.hpp"
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Random.hpp>
+#include <stdlib.h>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        static NS::URL* get_file_url(const String& path)
+        {
+            return NS::URL::fileURLWithPath(NS::String::string(path.c_str(), NS::UTF8StringEncoding));
+        }
+        RV PipelineCache::init(Span<const byte_t> initial_data)
+        {
+            lutry
+            {
+                AutoreleasePool pool;
+                m_mutex = new_mutex();
+                const c8* temp_dir = getenv("TMPDIR");
+                String path = temp_dir ? temp_dir : "/tmp";
+                if (path.empty() || path.back() != '/') path.push_back('/');
+                Guid guid = random_guid();
+                c8 filename[64];
+                snprintf(filename, 64, "LunaPipelineCache_%016llx%016llx", (unsigned long long)guid.high, (unsigned long long)guid.low);
+                path.append(filename);
+                // The archive may map the initial data file, so we serialize the archive to another file.
+                m_initial_data_path = path;
+                m_initial_data_path.append("_initial.metallib");
+                m_serialize_path = path;
+                m_serialize_path.append(".metallib");
+                NSPtr<MTL::BinaryArchiveDescriptor> d = box(MTL::BinaryArchiveDescriptor::alloc()->init());
+                NS::Error* err = nullptr;
+                if (!initial_data.empty())
+                {
+                    lulet(f, open_file(m_initial_data_path.c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+                    luexp(f->write(initial_data.data(), initial_data.size()));
+                    f.reset();
+                    d->setUrl(get_file_url(m_initial_data_path));
+                    m_archive = box(m_device->m_device->newBinaryArchive(d.get(), &err));
+                    if (m_archive) return ok;
+                    // The data is created by another device or OS version, discard it.
+                    d->setUrl(nullptr);
+                }
+                m_archive = box(m_device->m_device->newBinaryArchive(d.get(), &err));
+                if (!m_archive)
+                {
+                    NS::String* err_desc = err->description();
+                    return set_error(BasicError::bad_platform_call(), "%s", err_desc->cString(NS::UTF8StringEncoding));
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        PipelineCache::~PipelineCache()
+        {
+            m_archive.reset();
+            if (!m_initial_data_path.empty()) delete_file(m_initial_data_path.c_str());
+            if (!m_serialize_path.empty()) delete_file(m_serialize_path.c_str());
+        }
+        R<Blob> PipelineCache::get_data()
+        {
+            Blob data;
+            lutry
+            {
+                AutoreleasePool pool;
+                NS::Error* err = nullptr;
+                MutexGuard guard(m_mutex);
+                if (!m_archive->serializeToURL(get_file_url(m_serialize_path), &err))
+                {
+                    NS::String* err_desc = err->description();
+                    return set_error(BasicError::bad_platform_call(), "%s", err_desc->cString(NS::UTF8StringEncoding));
+                }
+                lulet(f, open_file(m_serialize_path.c_str(), FileOpenFlag::read, FileCreationMode::open_existing));
+                luset(data, load_file_data(f));
+            }
+            lucatchret;
+            return data;
+        }
+    }
+}
@@ -0,0 +1,40 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PipelineCache.hpp
+* @author JXMaster
+* @date 2024/3/30
+*/
+#pragma once
+#include "Device.hpp"
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/Mutex.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct PipelineCache : IPipelineCache
+        {
+            lustruct("RHI::PipelineCache", "{0E4D7B19-6A2C-4F85-9D3E-B1C8A5F27640}");
+            luiimpl();
+
+            Ref<Device> m_device;
+            NSPtr<MTL::BinaryArchive> m_archive;
+            Ref<IMutex> m_mutex;
+            // Binary archives can only be loaded from and serialized to files, so we use 
+            // temporary files to transfer the archive data.
+            String m_initial_data_path;
+            String m_serialize_path;
+
+            RV init(Span<const byte_t> initial_data);
+            ~PipelineCache();
+
+            virtual IDevice* get_device() override { return m_device; }
+            virtual void set_name(const c8* name) override { }
+            virtual R<Blob> get_data() override;
+        };
+    }
+}
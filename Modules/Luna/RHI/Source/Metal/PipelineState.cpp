@@ -8,6 +8,7 @@
 * @date 2023/7/25
 */
 #include "PipelineState.hpp"
+#include "PipelineCache.hpp"
 #include <Luna/VariantUtils/JSON.hpp>
 
 namespace Luna
@@ -166,12 +167,23 @@ namespace Luna
                 d->setRasterizationEnabled(true);
                 d->setInputPrimitiveTopology(encode_primitive_topology(desc.primitive_topology));
                 d->setRasterSampleCount(desc.sample_count);
+                PipelineCache* cache = desc.pipeline_cache ? cast_object<PipelineCache>(desc.pipeline_cache->get_object()) : nullptr;
+                if(cache)
+                {
+                    d->setBinaryArchives(NS::Array::array(cache->m_archive.get()));
+                }
                 m_pso = box(m_device->m_device->newRenderPipelineState(d.get(), &err));
                 if(!m_pso)
                 {
                     NS::String* err_desc = err->description();
                     return set_error(BasicError::bad_platform_call(), "%s", err_desc->cString(NS::UTF8StringEncoding));
                 }
+                if(cache)
+                {
+                    // Failing to add functions to the archive only affects caching, so the error is ignored.
+                    MutexGuard guard(cache->m_mutex);
+                    cache->m_archive->addRenderPipelineFunctions(d.get(), &err);
+                }
                 switch(desc.rasterizer_state.fill_mode)
                 {
                     case FillMode::solid: m_fill_mode = MTL::TriangleFillModeFill; break;
@@ -267,12 +279,22 @@ namespace Luna
                 NSPtr<MTL::ComputePipelineDescriptor> d = box(MTL::ComputePipelineDescriptor::alloc()->init());
                 d->setComputeFunction(cs_func.get());
                 d->setMaxCallStackDepth(256);
+                PipelineCache* cache = desc.pipeline_cache ? cast_object<PipelineCache>(desc.pipeline_cache->get_object()) : nullptr;
+                if(cache)
+                {
+                    d->setBinaryArchives(NS::Array::array(cache->m_archive.get()));
+                }
                 m_pso = box(m_device->m_device->newComputePipelineState(d.get(), MTL::PipelineOptionNone, nullptr, &err));
                 if(!m_pso)
                 {
                     NS::String* err_desc = err->description();
                     return set_error(BasicError::bad_platform_call(), "%s", err_desc->cString(NS::UTF8StringEncoding));
                 }
+                if(cache)
+                {
+                    MutexGuard guard(cache->m_mutex);
+                    cache->m_archive->addComputePipelineFunctions(d.get(), &err);
+                }
                 m_num_threads_per_group = UInt3U(desc.metal_numthreads_x, desc.metal_numthreads_y, desc.metal_numthreads_z);
             }
             lucatchret;
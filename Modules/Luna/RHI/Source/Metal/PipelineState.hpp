@@ -14,6 +14,8 @@ namespace Luna
     namespace RHI
     {
         constexpr usize VERTEX_BUFFER_SLOT_OFFSET = 16;
+        // The buffer slot of pipeline constants, see `PIPELINE_CONSTANTS_REGISTER_SPACE`.
+        constexpr usize PIPELINE_CONSTANTS_SLOT = PIPELINE_CONSTANTS_REGISTER_SPACE;
         struct RenderPipelineState : IPipelineState
         {
             lustruct("RHI::RenderPipelineState", "{78f9f67e-c86f-4c84-bba5-9bf05dac905b}");
@@ -30,6 +30,7 @@ namespace Luna
                     m_memory->m_device = m_device;
                     m_memory->m_memory_type = memory_type;
                     m_memory->m_size = m_buffer->allocatedSize();
+                    m_device->m_statistics.on_memory_allocated(m_device, memory_type, m_memory->m_size);
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
                     memory_profiler_allocate(m_buffer.get(), m_memory->get_size());
                     memory_profiler_set_memory_domain(m_buffer.get(), "GPU", 3);
@@ -53,6 +54,7 @@ namespace Luna
         }
         Buffer::~Buffer()
         {
+            m_device->m_statistics.on_buffer_destroyed();
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
             if(!m_memory->m_heap) memory_profiler_deallocate(m_buffer.get());
 #endif
@@ -83,6 +85,7 @@ namespace Luna
                     m_memory->m_device = m_device;
                     m_memory->m_memory_type = memory_type;
                     m_memory->m_size = m_texture->allocatedSize();
+                    m_device->m_statistics.on_memory_allocated(m_device, memory_type, m_memory->m_size);
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
                     memory_profiler_allocate(m_texture.get(), m_memory->get_size());
                     memory_profiler_set_memory_domain(m_texture.get(), "GPU", 3);
@@ -112,6 +115,7 @@ namespace Luna
         }
         Texture::~Texture()
         {
+            m_device->m_statistics.on_texture_destroyed();
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
             if(m_memory && !m_memory->m_heap) memory_profiler_deallocate(m_texture.get());
 #endif
@@ -47,6 +47,7 @@ namespace Luna
                 MTL::Texture* texture = m_current_drawable->texture();
                 Ref<Texture> tex = new_object<Texture>();
                 tex->m_device = m_device;
+                m_device->m_statistics.on_texture_created();
                 tex->m_texture = retain(texture);
                 tex->m_desc.type = TextureType::tex2d;
                 tex->m_desc.format = decode_pixel_format(texture->pixelFormat());
@@ -70,6 +71,7 @@ namespace Luna
                 {
                     luexp(get_current_back_buffer());
                 }
+                u64 begin_time = get_ticks();
                 AutoreleasePool pool;
                 MTL::CommandQueue* queue = m_device->m_queues[m_command_queue_index].queue.get();
                 MTL::CommandBuffer* buffer = queue->commandBuffer();
@@ -77,6 +79,16 @@ namespace Luna
                 buffer->commit();
                 m_current_back_buffer.reset();
                 m_current_drawable.reset();
+                u32 max_frame_latency = get_max_frame_latency(m_desc);
+                if(m_present_command_buffers.size() != max_frame_latency)
+                {
+                    m_present_command_buffers.clear();
+                    m_present_command_buffers.resize(max_frame_latency);
+                    m_present_command_buffer_index = 0;
+                }
+                m_present_command_buffers[m_present_command_buffer_index] = retain(buffer);
+                m_present_command_buffer_index = (m_present_command_buffer_index + 1) % max_frame_latency;
+                on_present(begin_time, get_ticks());
             }
             lucatchret;
             return ok;
@@ -107,5 +119,21 @@ namespace Luna
             m_desc = new_desc;
             return ok;
         }
+        RV SwapChain::wait_for_next_frame()
+        {
+            u64 begin_time = get_ticks();
+            if(!m_present_command_buffers.empty())
+            {
+                // Waits for the command buffer that presents the frame `max_frame_latency` frames before.
+                auto& buffer = m_present_command_buffers[m_present_command_buffer_index];
+                if(buffer)
+                {
+                    buffer->waitUntilCompleted();
+                    buffer.reset();
+                }
+            }
+            on_wait(begin_time, get_ticks());
+            return ok;
+        }
     }
 }
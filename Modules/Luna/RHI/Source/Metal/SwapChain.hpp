@@ -15,7 +15,7 @@ namespace Luna
 {
     namespace RHI
     {
-        struct SwapChain : ISwapChain
+        struct SwapChain : ISwapChain, SwapChainStatsCounters
         {
             lustruct("RHI::SwapChain", "{b0aba649-630a-44f7-9053-24711a974505}");
             luiimpl();
@@ -31,6 +31,10 @@ namespace Luna
 
             u32 m_command_queue_index;
 
+            // The command buffers that present the last `max_frame_latency` frames, used by `wait_for_next_frame`.
+            Vector<NSPtr<MTL::CommandBuffer>> m_present_command_buffers;
+            u32 m_present_command_buffer_index = 0;
+
             void init_metal_layer(const SwapChainDesc& desc);
 
             RV init(u32 command_queue_index, Window::IWindow* window, const SwapChainDesc& desc);
@@ -42,6 +46,8 @@ namespace Luna
             virtual R<ITexture*> get_current_back_buffer() override;
             virtual RV present() override;
             virtual RV reset(const SwapChainDesc& desc) override;
+            virtual RV wait_for_next_frame() override;
+            virtual SwapChainStats get_stats() override { return m_stats; }
         };
 
         void bind_layer_to_window(Window::IWindow* window, CA::MetalLayer* layer, u32 buffer_count);
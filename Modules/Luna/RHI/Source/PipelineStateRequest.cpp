@@ -0,0 +1,123 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file PipelineStateRequest.cpp
+* @author JXMaster
+* @date 2024/3/31
+*/
+#include "PipelineStateRequest.hpp"
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct PipelineStateRequest : IPipelineStateRequest
+        {
+            lustruct("RHI::PipelineStateRequest", "{9A6C2E41-D8B3-4F07-8E15-3C7A0B2D96F4}");
+            luiimpl();
+
+            Ref<IDevice> m_device;
+            bool m_is_graphics;
+            GraphicsPipelineStateDesc m_graphics_desc;
+            ComputePipelineStateDesc m_compute_desc;
+            // Keeps all data referred by the descriptor alive.
+            Ref<IPipelineLayout> m_pipeline_layout;
+            Ref<IPipelineCache> m_pipeline_cache;
+            Blob m_shader_data[2];
+            Vector<InputBindingDesc> m_input_bindings;
+            Vector<InputAttributeDesc> m_input_attributes;
+            Vector<Name> m_semantic_names;
+
+            JobSystem::job_id_t m_job_id = JobSystem::INVALID_JOB_ID;
+            R<Ref<IPipelineState>> m_result = BasicError::not_ready();
+
+            void copy_shader_data(ShaderData& data, usize index)
+            {
+                if (data.data.empty()) return;
+                m_shader_data[index] = Blob(data.data.data(), data.data.size());
+                data.data = m_shader_data[index].cspan();
+            }
+
+            virtual void wait() override
+            {
+                JobSystem::wait_job(m_job_id);
+            }
+            virtual bool try_wait() override
+            {
+                return JobSystem::is_job_finished(m_job_id);
+            }
+            virtual R<Ref<IPipelineState>> get_result() override
+            {
+                wait();
+                return m_result;
+            }
+        };
+
+        static void pipeline_state_request_job(void* params)
+        {
+            PipelineStateRequest* request = *(PipelineStateRequest**)params;
+            if (request->m_is_graphics)
+            {
+                request->m_result = request->m_device->new_graphics_pipeline_state(request->m_graphics_desc);
+            }
+            else
+            {
+                request->m_result = request->m_device->new_compute_pipeline_state(request->m_compute_desc);
+            }
+            // Releases the reference added in `submit_pipeline_state_request`.
+            object_release(request);
+        }
+        static Ref<IPipelineStateRequest> submit_pipeline_state_request(PipelineStateRequest* request)
+        {
+            object_retain(request);
+            void* job = JobSystem::new_job(pipeline_state_request_job, sizeof(PipelineStateRequest*), alignof(PipelineStateRequest*));
+            *(PipelineStateRequest**)job = request;
+            request->m_job_id = JobSystem::submit_job(job, JobSystem::JobPriority::background);
+            return Ref<IPipelineStateRequest>(request);
+        }
+        Ref<IPipelineStateRequest> new_graphics_pipeline_state_request(IDevice* device, const GraphicsPipelineStateDesc& desc)
+        {
+            Ref<PipelineStateRequest> request = new_object<PipelineStateRequest>();
+            request->m_device = device;
+            request->m_is_graphics = true;
+            GraphicsPipelineStateDesc& d = request->m_graphics_desc;
+            d = desc;
+            request->m_pipeline_layout = desc.pipeline_layout;
+            request->m_pipeline_cache = desc.pipeline_cache;
+            request->copy_shader_data(d.vs, 0);
+            request->copy_shader_data(d.ps, 1);
+            request->m_input_bindings.assign(desc.input_layout.bindings);
+            request->m_input_attributes.assign(desc.input_layout.attributes);
+            request->m_semantic_names.reserve(request->m_input_attributes.size());
+            for (auto& attribute : request->m_input_attributes)
+            {
+                request->m_semantic_names.push_back(Name(attribute.semantic_name));
+                attribute.semantic_name = request->m_semantic_names.back().c_str();
+            }
+            d.input_layout.bindings = { request->m_input_bindings.data(), request->m_input_bindings.size() };
+            d.input_layout.attributes = { request->m_input_attributes.data(), request->m_input_attributes.size() };
+            return submit_pipeline_state_request(request.get());
+        }
+        Ref<IPipelineStateRequest> new_compute_pipeline_state_request(IDevice* device, const ComputePipelineStateDesc& desc)
+        {
+            Ref<PipelineStateRequest> request = new_object<PipelineStateRequest>();
+            request->m_device = device;
+            request->m_is_graphics = false;
+            ComputePipelineStateDesc& d = request->m_compute_desc;
+            d = desc;
+            request->m_pipeline_layout = desc.pipeline_layout;
+            request->m_pipeline_cache = desc.pipeline_cache;
+            request->copy_shader_data(d.cs, 0);
+            return submit_pipeline_state_request(request.get());
+        }
+        void register_pipeline_state_request_types()
+        {
+            register_boxed_type<PipelineStateRequest>();
+            impl_interface_for_type<PipelineStateRequest, IPipelineStateRequest, IWaitable>();
+        }
+    }
+}
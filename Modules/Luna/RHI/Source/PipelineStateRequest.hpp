@@ -0,0 +1,25 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file PipelineStateRequest.hpp
+* @author JXMaster
+* @date 2024/3/31
+*/
+#pragma once
+#include "../Device.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! Creates one request that creates the graphics pipeline state using `device` on job system worker threads.
+        //! Used by all backends to implement `IDevice::new_graphics_pipeline_state_async`.
+        Ref<IPipelineStateRequest> new_graphics_pipeline_state_request(IDevice* device, const GraphicsPipelineStateDesc& desc);
+        //! Creates one request that creates the compute pipeline state using `device` on job system worker threads.
+        //! Used by all backends to implement `IDevice::new_compute_pipeline_state_async`.
+        Ref<IPipelineStateRequest> new_compute_pipeline_state_request(IDevice* device, const ComputePipelineStateDesc& desc);
+        void register_pipeline_state_request_types();
+    }
+}
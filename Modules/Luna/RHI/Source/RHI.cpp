@@ -12,24 +12,40 @@
 #include "RHI.hpp"
 #include <Luna/Runtime/Module.hpp>
 #include "../DescriptorSet.hpp"
+#include "PipelineStateRequest.hpp"
+#include "BindlessResourceTable.hpp"
+#include "UploadRingBuffer.hpp"
+#include "UploadManager.hpp"
+#include <Luna/JobSystem/JobSystem.hpp>
 namespace Luna
 {
     namespace RHI
     {
+        perf_counter_t g_resources_created_counter = 0;
+        perf_counter_t g_allocated_bytes_counter = 0;
+
         struct RHIModule : public Module
         {
             virtual const c8* get_name() override { return "RHI"; }
             virtual RV on_register() override
             {
-                return add_dependency_module(this, module_window());
+                return add_dependency_modules(this, {module_window(), module_job_system()});
             }
             virtual RV on_init() override
             {
+                register_pipeline_state_request_types();
+                register_bindless_resource_table_types();
+                register_upload_ring_buffer_types();
+                register_upload_manager_types();
+                g_resources_created_counter = register_perf_counter("RHI.ResourcesCreated", PerfCounterType::counter);
+                g_allocated_bytes_counter = register_perf_counter("RHI.AllocatedBytes", PerfCounterType::gauge, "bytes");
                 return render_api_init();
             }
             virtual void on_close() override
             {
                 render_api_close();
+                g_resources_created_counter = 0;
+                g_allocated_bytes_counter = 0;
             }
         };
     }
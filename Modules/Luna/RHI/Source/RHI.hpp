@@ -10,6 +10,10 @@
 */
 #pragma once
 #include "../RHI.hpp"
+#include <Luna/Runtime/Atomic.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/PerfCounter.hpp>
+#include <Luna/Runtime/AllocationTracker.hpp>
 
 namespace Luna
 {
@@ -20,6 +24,117 @@ namespace Luna
         //! Implemented by the rendering API to clean up the rendering infrastructure.
         void render_api_close();
 
+        //! Checks whether the memory budget change event should be emitted for the new budget.
+        inline bool is_memory_budget_changed(const DeviceMemoryBudget& last, const DeviceMemoryBudget& current)
+        {
+            auto heap_changed = [](const MemoryHeapBudget& l, const MemoryHeapBudget& c)
+            {
+                return l.budget != c.budget || (l.usage > l.budget) != (c.usage > c.budget);
+            };
+            return heap_changed(last.local, current.local) || heap_changed(last.non_local, current.non_local);
+        }
+        //! Process-wide performance counters published by all devices.
+        extern perf_counter_t g_resources_created_counter;
+        extern perf_counter_t g_allocated_bytes_counter;
+
+        //! The device statistics counters shared by all backends.
+        struct DeviceStatisticsCounters
+        {
+            DeviceStatistics m_statistics;
+
+            void on_buffer_created()
+            {
+                atom_inc_u64(&m_statistics.num_buffers_created);
+                perf_counter_add(g_resources_created_counter, 1);
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+                allocation_tracker_record_object_creation("RHI::IBuffer");
+#endif
+            }
+            void on_buffer_destroyed() { atom_inc_u64(&m_statistics.num_buffers_destroyed); }
+            void on_texture_created()
+            {
+                atom_inc_u64(&m_statistics.num_textures_created);
+                perf_counter_add(g_resources_created_counter, 1);
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+                allocation_tracker_record_object_creation("RHI::ITexture");
+#endif
+            }
+            void on_texture_destroyed() { atom_inc_u64(&m_statistics.num_textures_destroyed); }
+            void on_memory_allocated(IDevice* device, MemoryType memory_type, u64 size)
+            {
+                atom_add_u64(&m_statistics.allocated_bytes[(u8)memory_type], (i64)size);
+                perf_counter_add(g_allocated_bytes_counter, (i64)size);
+#ifdef LUNA_RHI_PROFILER_ENABLED
+                auto data = allocate_profiler_event_data<ProfilerEventData::DeviceMemoryAllocate>();
+                data->device = device;
+                data->memory_type = memory_type;
+                data->size = size;
+                submit_profiler_event(ProfilerEventId::DEVICE_MEMORY_ALLOCATE);
+#endif
+            }
+            void on_memory_freed(IDevice* device, MemoryType memory_type, u64 size)
+            {
+                atom_add_u64(&m_statistics.freed_bytes[(u8)memory_type], (i64)size);
+                perf_counter_add(g_allocated_bytes_counter, -(i64)size);
+#ifdef LUNA_RHI_PROFILER_ENABLED
+                auto data = allocate_profiler_event_data<ProfilerEventData::DeviceMemoryFree>();
+                data->device = device;
+                data->memory_type = memory_type;
+                data->size = size;
+                submit_profiler_event(ProfilerEventId::DEVICE_MEMORY_FREE);
+#endif
+            }
+            void on_descriptor_set_created()
+            {
+                atom_inc_u64(&m_statistics.num_descriptor_sets_created);
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+                allocation_tracker_record_object_creation("RHI::IDescriptorSet");
+#endif
+            }
+            void on_descriptors_written(Span<const WriteDescriptorSet> writes)
+            {
+                u64 num_descs = 0;
+                for (auto& write : writes) num_descs += write.num_descs;
+                atom_add_u64(&m_statistics.num_descriptor_writes, (i64)num_descs);
+            }
+            void on_pipeline_state_created()
+            {
+                atom_inc_u64(&m_statistics.num_pipeline_states_created);
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+                allocation_tracker_record_object_creation("RHI::IPipelineState");
+#endif
+            }
+            void on_command_buffer_submitted(ICommandBuffer* command_buffer, const CommandBufferStatistics& statistics)
+            {
+                atom_inc_u64(&m_statistics.num_command_buffers_submitted);
+#ifdef LUNA_RHI_PROFILER_ENABLED
+                auto data = allocate_profiler_event_data<ProfilerEventData::CommandBufferSubmit>();
+                data->command_buffer = command_buffer;
+                data->statistics = statistics;
+                submit_profiler_event(ProfilerEventId::COMMAND_BUFFER_SUBMIT);
+#endif
+            }
+        };
+        //! The swap chain statistics counters shared by all backends.
+        struct SwapChainStatsCounters
+        {
+            SwapChainStats m_stats = {};
+
+            //! Called with the time range of one `wait_for_next_frame` call.
+            void on_wait(u64 begin_time, u64 end_time)
+            {
+                m_stats.last_wait_duration = end_time - begin_time;
+                m_stats.total_wait_duration += end_time - begin_time;
+            }
+            //! Called with the time range of one successful `present` call.
+            void on_present(u64 begin_time, u64 end_time)
+            {
+                if (m_stats.num_presents) m_stats.last_present_interval = end_time - m_stats.last_present_time;
+                ++m_stats.num_presents;
+                m_stats.last_present_time = end_time;
+                m_stats.last_present_duration = end_time - begin_time;
+            }
+        };
         inline u32 calc_mip_levels(u32 width, u32 height, u32 depth)
         {
             return 1 + (u32)floorf(log2f((f32)max(width, max(height, depth))));
@@ -0,0 +1,340 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file UploadManager.cpp
+* @author JXMaster
+* @date 2024/4/6
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_RHI_API LUNA_EXPORT
+#include "../UploadManager.hpp"
+#include "UploadManager.hpp"
+#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Thread.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct StagingPage
+        {
+            Ref<IBuffer> buffer;
+            void* data = nullptr;
+            u64 size = 0;
+            // The allocation offset in the page.
+            u64 offset = 0;
+        };
+
+        struct UploadBatch
+        {
+            Ref<ICommandBuffer> command_buffer;
+            Vector<StagingPage> pages;
+            // Finished when the batch is completed by the GPU.
+            JobSystem::job_id_t job_id;
+            // The number of texture writes that are begun but not ended.
+            u32 num_pending_writes = 0;
+        };
+
+        struct UploadManager : IUploadManager
+        {
+            lustruct("RHI::UploadManager", "{0D6A8E42-7B19-4C35-A2F7-51E9C3B84D60}");
+            luiimpl();
+
+            Ref<IDevice> m_device;
+            UploadManagerDesc m_desc;
+            u32 m_queue = 0;
+            Ref<IMutex> m_mutex;
+            // The batch that accepts new copies, or `nullptr` if no copy is enqueued since the last submission.
+            UploadBatch* m_current = nullptr;
+            Vector<StagingPage> m_free_pages;
+            Vector<Ref<ICommandBuffer>> m_free_command_buffers;
+
+            ~UploadManager()
+            {
+                if (m_current)
+                {
+                    for (auto& page : m_current->pages) page.buffer->unmap(0, 0);
+                    JobSystem::finish_job_id(m_current->job_id);
+                    memdelete(m_current);
+                    m_current = nullptr;
+                }
+                for (auto& page : m_free_pages) page.buffer->unmap(0, 0);
+            }
+
+            RV init(const UploadManagerDesc& desc)
+            {
+                m_desc = desc;
+                m_mutex = new_mutex();
+                if (desc.command_queue_index != U32_MAX)
+                {
+                    if (desc.command_queue_index >= m_device->get_num_command_queues()) return BasicError::bad_arguments();
+                    m_queue = desc.command_queue_index;
+                    return ok;
+                }
+                u32 graphics_queue = U32_MAX;
+                u32 num_queues = m_device->get_num_command_queues();
+                for (u32 i = 0; i < num_queues; ++i)
+                {
+                    auto type = m_device->get_command_queue_desc(i).type;
+                    if (type == CommandQueueType::copy)
+                    {
+                        m_queue = i;
+                        return ok;
+                    }
+                    if (type == CommandQueueType::graphics && graphics_queue == U32_MAX)
+                    {
+                        graphics_queue = i;
+                    }
+                }
+                if (graphics_queue == U32_MAX) return BasicError::not_supported();
+                m_queue = graphics_queue;
+                return ok;
+            }
+            // Called with `m_mutex` locked.
+            R<UploadBatch*> get_current_batch()
+            {
+                if (m_current) return m_current;
+                Ref<ICommandBuffer> command_buffer;
+                if (!m_free_command_buffers.empty())
+                {
+                    command_buffer = m_free_command_buffers.back();
+                    m_free_command_buffers.pop_back();
+                }
+                else
+                {
+                    auto r = m_device->new_command_buffer(m_queue);
+                    if (failed(r)) return r.errcode();
+                    command_buffer = r.get();
+                    command_buffer->set_name("UploadManager");
+                }
+                m_current = memnew<UploadBatch>();
+                m_current->command_buffer = command_buffer;
+                m_current->job_id = JobSystem::allocate_job_id();
+                command_buffer->begin_copy_pass();
+                return m_current;
+            }
+            // Called with `m_mutex` locked.
+            R<StagingPage*> allocate_staging(UploadBatch* batch, u64 size, u64 alignment, u64& offset)
+            {
+                if (!batch->pages.empty())
+                {
+                    StagingPage& page = batch->pages.back();
+                    u64 aligned = align_upper(page.offset, alignment);
+                    if (aligned + size <= page.size)
+                    {
+                        offset = aligned;
+                        page.offset = aligned + size;
+                        return &page;
+                    }
+                }
+                StagingPage page;
+                if (size <= m_desc.staging_page_size && !m_free_pages.empty())
+                {
+                    page = move(m_free_pages.back());
+                    m_free_pages.pop_back();
+                }
+                else
+                {
+                    page.size = max(size, m_desc.staging_page_size);
+                    auto buffer = m_device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::copy_source, page.size));
+                    if (failed(buffer)) return buffer.errcode();
+                    page.buffer = buffer.get();
+                    auto r = page.buffer->map(0, 0, &page.data);
+                    if (failed(r)) return r.errcode();
+                }
+                page.offset = size;
+                offset = 0;
+                batch->pages.push_back(move(page));
+                return &batch->pages.back();
+            }
+            // Called when the batch is completed by the GPU.
+            void recycle_batch(UploadBatch* batch)
+            {
+                JobSystem::finish_job_id(batch->job_id);
+                MutexGuard guard(m_mutex);
+                for (auto& page : batch->pages)
+                {
+                    if (page.size == m_desc.staging_page_size && m_free_pages.size() < m_desc.max_cached_pages)
+                    {
+                        page.offset = 0;
+                        m_free_pages.push_back(move(page));
+                    }
+                    else
+                    {
+                        page.buffer->unmap(0, 0);
+                    }
+                }
+                if (succeeded(batch->command_buffer->reset()))
+                {
+                    m_free_command_buffers.push_back(batch->command_buffer);
+                }
+                memdelete(batch);
+            }
+
+            virtual IDevice* get_device() override { return m_device.get(); }
+            virtual void set_name(const c8* name) override {}
+            virtual u32 get_command_queue_index() override { return m_queue; }
+            virtual R<JobSystem::job_id_t> enqueue(Span<const CopyResourceData> copies) override;
+            virtual R<UploadTextureWriteRegion> begin_texture_write(ITexture* dst, SubresourceIndex dst_subresource, u32 dst_x, u32 dst_y, u32 dst_z,
+                u32 copy_width, u32 copy_height, u32 copy_depth) override;
+            virtual void end_texture_write(const UploadTextureWriteRegion& region) override;
+            virtual R<JobSystem::job_id_t> submit(Span<IFence*> signal_fences) override;
+        };
+
+        R<JobSystem::job_id_t> UploadManager::enqueue(Span<const CopyResourceData> copies)
+        {
+            MutexGuard guard(m_mutex);
+            JobSystem::job_id_t ret;
+            lutry
+            {
+                lulet(batch, get_current_batch());
+                ret = batch->job_id;
+                ICommandBuffer* command_buffer = batch->command_buffer;
+                for (auto& copy : copies)
+                {
+                    if (copy.op == ResourceDataCopyOp::write_buffer)
+                    {
+                        auto& desc = copy.write_buffer_desc;
+                        u64 offset;
+                        lulet(page, allocate_staging(batch, desc.copy_size, 16, offset));
+                        memcpy((u8*)page->data + (usize)offset, desc.src, desc.copy_size);
+                        BufferBarrier barrier(desc.dst, BufferStateFlag::automatic, BufferStateFlag::copy_dest);
+                        command_buffer->resource_barrier({ &barrier, 1 }, {});
+                        command_buffer->copy_buffer(desc.dst, desc.dst_offset, page->buffer, offset, desc.copy_size);
+                    }
+                    else if (copy.op == ResourceDataCopyOp::write_texture)
+                    {
+                        auto& desc = copy.write_texture_desc;
+                        u64 size, alignment, row_pitch, slice_pitch;
+                        Format format = desc.dst->get_desc().format;
+                        m_device->get_texture_data_placement_info(desc.copy_width, desc.copy_height, desc.copy_depth,
+                            format, &size, &alignment, &row_pitch, &slice_pitch);
+                        u64 offset;
+                        lulet(page, allocate_staging(batch, size, alignment, offset));
+                        usize copy_size_per_row = bits_per_pixel(format) * desc.copy_width / 8;
+                        memcpy_bitmap3d((u8*)page->data + (usize)offset, desc.src,
+                            copy_size_per_row, desc.copy_height, desc.copy_depth,
+                            (usize)row_pitch, desc.src_row_pitch, (usize)slice_pitch, desc.src_slice_pitch);
+                        TextureBarrier barrier(desc.dst, desc.dst_subresource, TextureStateFlag::automatic, TextureStateFlag::copy_dest);
+                        command_buffer->resource_barrier({}, { &barrier, 1 });
+                        command_buffer->copy_buffer_to_texture(desc.dst, desc.dst_subresource, desc.dst_x, desc.dst_y, desc.dst_z,
+                            page->buffer, offset, (u32)row_pitch, (u32)slice_pitch, desc.copy_width, desc.copy_height, desc.copy_depth);
+                    }
+                    else
+                    {
+                        return set_error(BasicError::bad_arguments(), "Only write operations can be enqueued to upload managers.");
+                    }
+                }
+            }
+            lucatchret;
+            return ret;
+        }
+
+        R<UploadTextureWriteRegion> UploadManager::begin_texture_write(ITexture* dst, SubresourceIndex dst_subresource, u32 dst_x, u32 dst_y, u32 dst_z,
+            u32 copy_width, u32 copy_height, u32 copy_depth)
+        {
+            MutexGuard guard(m_mutex);
+            UploadTextureWriteRegion ret;
+            lutry
+            {
+                lulet(batch, get_current_batch());
+                u64 size, alignment, row_pitch, slice_pitch;
+                Format format = dst->get_desc().format;
+                m_device->get_texture_data_placement_info(copy_width, copy_height, copy_depth,
+                    format, &size, &alignment, &row_pitch, &slice_pitch);
+                u64 offset;
+                lulet(page, allocate_staging(batch, size, alignment, offset));
+                // The copy command is executed only after the batch is submitted, and the batch is submitted only after all
+                // writes in the batch are ended, so we can record the command before the staging memory is written.
+                TextureBarrier barrier(dst, dst_subresource, TextureStateFlag::automatic, TextureStateFlag::copy_dest);
+                batch->command_buffer->resource_barrier({}, { &barrier, 1 });
+                batch->command_buffer->copy_buffer_to_texture(dst, dst_subresource, dst_x, dst_y, dst_z,
+                    page->buffer, offset, (u32)row_pitch, (u32)slice_pitch, copy_width, copy_height, copy_depth);
+                ++batch->num_pending_writes;
+                ret.data = (u8*)page->data + (usize)offset;
+                ret.row_pitch = (usize)row_pitch;
+                ret.slice_pitch = (usize)slice_pitch;
+                ret.job_id = batch->job_id;
+                ret.batch = batch;
+            }
+            lucatchret;
+            return ret;
+        }
+
+        void UploadManager::end_texture_write(const UploadTextureWriteRegion& region)
+        {
+            MutexGuard guard(m_mutex);
+            UploadBatch* batch = (UploadBatch*)region.batch;
+            luassert(batch->num_pending_writes);
+            --batch->num_pending_writes;
+        }
+
+        struct UploadWaitJob
+        {
+            Ref<UploadManager> manager;
+            UploadBatch* batch;
+        };
+        static void upload_wait_job(void* params)
+        {
+            UploadWaitJob* job = (UploadWaitJob*)params;
+            job->batch->command_buffer->wait();
+            job->manager->recycle_batch(job->batch);
+            job->~UploadWaitJob();
+        }
+
+        R<JobSystem::job_id_t> UploadManager::submit(Span<IFence*> signal_fences)
+        {
+            MutexGuard guard(m_mutex);
+            if (!m_current && signal_fences.empty()) return JobSystem::INVALID_JOB_ID;
+            JobSystem::job_id_t ret;
+            lutry
+            {
+                lulet(batch, get_current_batch());
+                m_current = nullptr;
+                // Waits for threads that are still writing staging memory of this batch. New writes go to the next batch
+                // since `m_current` is reset.
+                while (batch->num_pending_writes)
+                {
+                    guard.unlock();
+                    yield_current_thread();
+                    guard.lock(m_mutex);
+                }
+                batch->command_buffer->end_copy_pass();
+                auto r = batch->command_buffer->submit({}, signal_fences, true);
+                if (failed(r))
+                {
+                    guard.unlock();
+                    recycle_batch(batch);
+                    return r.errcode();
+                }
+                // Waits for the command buffer on one IO worker, so that normal workers are not blocked.
+                void* job = JobSystem::new_job(upload_wait_job, sizeof(UploadWaitJob), alignof(UploadWaitJob));
+                new (job) UploadWaitJob{ this, batch };
+                JobSystem::set_job_name(job, "UploadManager::wait");
+                JobSystem::submit_job(job, JobSystem::JobPriority::io);
+                ret = batch->job_id;
+            }
+            lucatchret;
+            return ret;
+        }
+
+        LUNA_RHI_API R<Ref<IUploadManager>> new_upload_manager(IDevice* device, const UploadManagerDesc& desc)
+        {
+            Ref<UploadManager> manager = new_object<UploadManager>();
+            manager->m_device = device;
+            lutry
+            {
+                luexp(manager->init(desc));
+            }
+            lucatchret;
+            return Ref<IUploadManager>(manager);
+        }
+        void register_upload_manager_types()
+        {
+            register_boxed_type<UploadManager>();
+            impl_interface_for_type<UploadManager, IUploadManager, IDeviceChild>();
+        }
+    }
+}
@@ -0,0 +1,18 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file UploadManager.hpp
+* @author JXMaster
+* @date 2024/4/6
+*/
+#pragma once
+
+namespace Luna
+{
+    namespace RHI
+    {
+        void register_upload_manager_types();
+    }
+}
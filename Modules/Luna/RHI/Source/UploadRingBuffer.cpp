@@ -0,0 +1,166 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file UploadRingBuffer.cpp
+* @author JXMaster
+* @date 2024/4/5
+*/
+#include "UploadRingBuffer.hpp"
+#include <Luna/Runtime/SpinLock.hpp>
+
+namespace Luna
+{
+    namespace RHI
+    {
+        // One persistently mapped upload buffer.
+        struct UploadPage
+        {
+            Ref<IBuffer> buffer;
+            void* data = nullptr;
+            u64 size = 0;
+        };
+
+        struct UploadFrame
+        {
+            // The first page is reused between frames, other pages are created when the first page is full,
+            // and are released when the frame is reused.
+            Vector<UploadPage> pages;
+            // The allocation offset in the last page.
+            u64 offset = 0;
+        };
+
+        struct UploadRingBuffer : IUploadRingBuffer
+        {
+            lustruct("RHI::UploadRingBuffer", "{7A2F4E91-C5B8-4D03-9E16-3B80D4F2A657}");
+            luiimpl();
+
+            Ref<IDevice> m_device;
+            UploadRingBufferDesc m_desc;
+            Vector<UploadFrame> m_frames;
+            u32 m_current_frame = 0;
+            SpinLock m_lock;
+
+            R<UploadPage> new_page(u64 size)
+            {
+                UploadPage page;
+                lutry
+                {
+                    luset(page.buffer, m_device->new_buffer(MemoryType::upload, BufferDesc(m_desc.usages, size)));
+                    luexp(page.buffer->map(0, 0, &page.data));
+                    page.size = size;
+                }
+                lucatchret;
+                return page;
+            }
+            static void release_page(UploadPage& page)
+            {
+                if (page.buffer)
+                {
+                    page.buffer->unmap(0, 0);
+                    page.buffer.reset();
+                    page.data = nullptr;
+                }
+            }
+            RV init(const UploadRingBufferDesc& desc)
+            {
+                lutry
+                {
+                    if (!desc.frame_size || !desc.num_frames) return BasicError::bad_arguments();
+                    m_desc = desc;
+                    m_frames.resize(desc.num_frames);
+                    for (auto& frame : m_frames)
+                    {
+                        lulet(page, new_page(desc.frame_size));
+                        frame.pages.push_back(move(page));
+                    }
+                }
+                lucatchret;
+                return ok;
+            }
+            ~UploadRingBuffer()
+            {
+                for (auto& frame : m_frames)
+                {
+                    for (auto& page : frame.pages) release_page(page);
+                }
+            }
+
+            virtual IDevice* get_device() override { return m_device.get(); }
+            virtual void set_name(const c8* name) override {}
+            virtual u32 get_num_frames() override { return m_desc.num_frames; }
+            virtual void begin_frame() override
+            {
+                LockGuard guard(m_lock);
+                m_current_frame = (m_current_frame + 1) % m_desc.num_frames;
+                UploadFrame& frame = m_frames[m_current_frame];
+                frame.offset = 0;
+                if (frame.pages.size() > 1)
+                {
+                    // The frame overflowed last time, replaces all pages with one page that can hold all data of the last time,
+                    // so that the frame does not overflow again if the data size does not grow.
+                    u64 total_size = 0;
+                    for (auto& page : frame.pages)
+                    {
+                        total_size += page.size;
+                        release_page(page);
+                    }
+                    frame.pages.clear();
+                    auto page = new_page(total_size);
+                    if (failed(page))
+                    {
+                        // Falls back to the initial size, and creates additional pages when needed.
+                        page = new_page(m_desc.frame_size);
+                    }
+                    if (succeeded(page))
+                    {
+                        frame.pages.push_back(move(page.get()));
+                    }
+                }
+            }
+            virtual R<UploadRingBufferAllocation> allocate(u64 size, u64 alignment) override
+            {
+                lucheck(alignment);
+                UploadRingBufferAllocation ret;
+                lutry
+                {
+                    LockGuard guard(m_lock);
+                    UploadFrame& frame = m_frames[m_current_frame];
+                    u64 offset = (frame.offset + alignment - 1) / alignment * alignment;
+                    if (frame.pages.empty() || offset + size > frame.pages.back().size)
+                    {
+                        lulet(page, new_page(max(size, m_desc.frame_size)));
+                        frame.pages.push_back(move(page));
+                        offset = 0;
+                    }
+                    UploadPage& page = frame.pages.back();
+                    ret.buffer = page.buffer.get();
+                    ret.offset = offset;
+                    ret.size = size;
+                    ret.data = (u8*)page.data + offset;
+                    frame.offset = offset + size;
+                }
+                lucatchret;
+                return ret;
+            }
+        };
+
+        R<Ref<IUploadRingBuffer>> new_upload_ring_buffer(IDevice* device, const UploadRingBufferDesc& desc)
+        {
+            Ref<UploadRingBuffer> ring = new_object<UploadRingBuffer>();
+            ring->m_device = device;
+            lutry
+            {
+                luexp(ring->init(desc));
+            }
+            lucatchret;
+            return Ref<IUploadRingBuffer>(ring);
+        }
+        void register_upload_ring_buffer_types()
+        {
+            register_boxed_type<UploadRingBuffer>();
+            impl_interface_for_type<UploadRingBuffer, IUploadRingBuffer, IDeviceChild>();
+        }
+    }
+}
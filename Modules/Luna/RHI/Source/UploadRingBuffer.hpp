@@ -0,0 +1,22 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file UploadRingBuffer.hpp
+* @author JXMaster
+* @date 2024/4/5
+*/
+#pragma once
+#include "../Device.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! Creates one upload ring buffer using upload buffers created from `device`.
+        //! Used by all backends to implement `IDevice::new_upload_ring_buffer`.
+        R<Ref<IUploadRingBuffer>> new_upload_ring_buffer(IDevice* device, const UploadRingBufferDesc& desc);
+        void register_upload_ring_buffer_types();
+    }
+}
@@ -0,0 +1,155 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AccelerationStructure.cpp
+* @author JXMaster
+* @date 2024/4/8
+*/
+#include "AccelerationStructure.hpp"
+#include "Resource.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        RV AccelerationStructure::init(const AccelerationStructureDesc& desc)
+        {
+            lutry
+            {
+                m_desc = desc;
+                VkBufferCreateInfo create_info{};
+                create_info.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+                create_info.size = desc.size;
+                create_info.usage = VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_STORAGE_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+                create_info.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+                VmaAllocationCreateInfo allocation{};
+                encode_allocation_info(allocation, MemoryType::local, false);
+                auto memory = new_object<DeviceMemory>();
+                memory->m_device = m_device;
+                memory->m_memory_type = MemoryType::local;
+                m_memory = memory;
+                luexp(encode_vk_result(vmaCreateBuffer(m_device->m_allocator, &create_info, &allocation, &m_buffer, &m_memory->m_allocation, &m_memory->m_allocation_info)));
+                m_device->m_statistics.on_memory_allocated(m_device, MemoryType::local, m_memory->get_size());
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+                memory_profiler_allocate(&m_memory->m_allocation, m_memory->get_size());
+                memory_profiler_set_memory_domain(&m_memory->m_allocation, "GPU", 3);
+                memory_profiler_set_memory_type(&m_memory->m_allocation, "Acceleration Structure", 22);
+#endif
+                VkAccelerationStructureCreateInfoKHR as_create_info{};
+                as_create_info.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_CREATE_INFO_KHR;
+                as_create_info.buffer = m_buffer;
+                as_create_info.offset = 0;
+                as_create_info.size = desc.size;
+                as_create_info.type = desc.type == AccelerationStructureType::top_level ? 
+                    VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR : VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+                luexp(encode_vk_result(m_device->m_funcs.vkCreateAccelerationStructureKHR(m_device->m_device, &as_create_info, nullptr, &m_as)));
+                VkAccelerationStructureDeviceAddressInfoKHR address_info{};
+                address_info.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_DEVICE_ADDRESS_INFO_KHR;
+                address_info.accelerationStructure = m_as;
+                m_address = m_device->m_funcs.vkGetAccelerationStructureDeviceAddressKHR(m_device->m_device, &address_info);
+            }
+            lucatchret;
+            return ok;
+        }
+        AccelerationStructure::~AccelerationStructure()
+        {
+            if (m_as != VK_NULL_HANDLE)
+            {
+                m_device->m_funcs.vkDestroyAccelerationStructureKHR(m_device->m_device, m_as, nullptr);
+                m_as = VK_NULL_HANDLE;
+            }
+            if (m_buffer != VK_NULL_HANDLE)
+            {
+                m_device->m_funcs.vkDestroyBuffer(m_device->m_device, m_buffer, nullptr);
+                m_buffer = VK_NULL_HANDLE;
+            }
+        }
+        void AccelerationStructure::set_name(const c8* name)
+        {
+            if (g_enable_validation_layer)
+            {
+                VkDebugUtilsObjectNameInfoEXT nameInfo = {};
+                nameInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_OBJECT_NAME_INFO_EXT;
+                nameInfo.objectType = VK_OBJECT_TYPE_ACCELERATION_STRUCTURE_KHR;
+                nameInfo.objectHandle = (uint64_t)m_as;
+                nameInfo.pObjectName = name;
+                vkSetDebugUtilsObjectNameEXT(m_device->m_device, &nameInfo);
+            }
+        }
+        inline VkBuildAccelerationStructureFlagsKHR encode_acceleration_structure_build_flags(AccelerationStructureBuildFlag flags)
+        {
+            VkBuildAccelerationStructureFlagsKHR r = 0;
+            if (test_flags(flags, AccelerationStructureBuildFlag::allow_update)) r |= VK_BUILD_ACCELERATION_STRUCTURE_ALLOW_UPDATE_BIT_KHR;
+            if (test_flags(flags, AccelerationStructureBuildFlag::prefer_fast_trace)) r |= VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_TRACE_BIT_KHR;
+            if (test_flags(flags, AccelerationStructureBuildFlag::prefer_fast_build)) r |= VK_BUILD_ACCELERATION_STRUCTURE_PREFER_FAST_BUILD_BIT_KHR;
+            if (test_flags(flags, AccelerationStructureBuildFlag::minimize_memory)) r |= VK_BUILD_ACCELERATION_STRUCTURE_LOW_MEMORY_BIT_KHR;
+            return r;
+        }
+        inline VkDeviceAddress get_buffer_address(Device* device, IBuffer* buffer, u64 offset)
+        {
+            if (!buffer) return 0;
+            BufferResource* res = cast_object<BufferResource>(buffer->get_object());
+            VkBufferDeviceAddressInfo info{};
+            info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+            info.buffer = res->m_buffer;
+            return device->m_funcs.vkGetBufferDeviceAddress(device->m_device, &info) + offset;
+        }
+        void encode_acceleration_structure_inputs(Device* device, const AccelerationStructureBuildInputs& src,
+            VkAccelerationStructureBuildGeometryInfoKHR& dst, Vector<VkAccelerationStructureGeometryKHR>& geometries, 
+            Vector<u32>& primitive_counts)
+        {
+            dst.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_GEOMETRY_INFO_KHR;
+            dst.flags = encode_acceleration_structure_build_flags(src.flags);
+            dst.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_BUILD_KHR;
+            if (src.type == AccelerationStructureType::top_level)
+            {
+                dst.type = VK_ACCELERATION_STRUCTURE_TYPE_TOP_LEVEL_KHR;
+                VkAccelerationStructureGeometryKHR d{};
+                d.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+                d.geometryType = VK_GEOMETRY_TYPE_INSTANCES_KHR;
+                d.geometry.instances.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_INSTANCES_DATA_KHR;
+                d.geometry.instances.arrayOfPointers = VK_FALSE;
+                d.geometry.instances.data.deviceAddress = get_buffer_address(device, src.instance_buffer, src.instance_buffer_offset);
+                geometries.push_back(d);
+                primitive_counts.push_back(src.num_instances);
+            }
+            else
+            {
+                dst.type = VK_ACCELERATION_STRUCTURE_TYPE_BOTTOM_LEVEL_KHR;
+                geometries.reserve(src.geometries.size());
+                primitive_counts.reserve(src.geometries.size());
+                for (auto& s : src.geometries)
+                {
+                    VkAccelerationStructureGeometryKHR d{};
+                    d.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_KHR;
+                    d.geometryType = VK_GEOMETRY_TYPE_TRIANGLES_KHR;
+                    d.flags = 0;
+                    if (test_flags(s.flags, RayTracingGeometryFlag::opaque)) d.flags |= VK_GEOMETRY_OPAQUE_BIT_KHR;
+                    if (test_flags(s.flags, RayTracingGeometryFlag::no_duplicate_any_hit_invocation)) d.flags |= VK_GEOMETRY_NO_DUPLICATE_ANY_HIT_INVOCATION_BIT_KHR;
+                    auto& t = d.geometry.triangles;
+                    t.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_GEOMETRY_TRIANGLES_DATA_KHR;
+                    t.vertexFormat = encode_format(s.vertex_format);
+                    t.vertexData.deviceAddress = get_buffer_address(device, s.vertex_buffer, s.vertex_buffer_offset);
+                    t.vertexStride = s.vertex_stride;
+                    t.maxVertex = s.num_vertices ? s.num_vertices - 1 : 0;
+                    if (s.index_buffer)
+                    {
+                        t.indexType = s.index_format == Format::r16_uint ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+                        t.indexData.deviceAddress = get_buffer_address(device, s.index_buffer, s.index_buffer_offset);
+                        primitive_counts.push_back(s.num_indices / 3);
+                    }
+                    else
+                    {
+                        t.indexType = VK_INDEX_TYPE_NONE_KHR;
+                        primitive_counts.push_back(s.num_vertices / 3);
+                    }
+                    geometries.push_back(d);
+                }
+            }
+            dst.geometryCount = (u32)geometries.size();
+            dst.pGeometries = geometries.data();
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AccelerationStructure.hpp
+* @author JXMaster
+* @date 2024/4/8
+*/
+#pragma once
+#include "DeviceMemory.hpp"
+#include "../../AccelerationStructure.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct AccelerationStructure : IAccelerationStructure
+        {
+            lustruct("RHI::AccelerationStructure", "{0E6B3F52-8D14-4A97-B2C5-7F19A3D6E840}");
+            luiimpl();
+
+            Ref<Device> m_device;
+            AccelerationStructureDesc m_desc;
+            // The buffer that stores the acceleration structure.
+            VkBuffer m_buffer = VK_NULL_HANDLE;
+            Ref<DeviceMemory> m_memory;
+            VkAccelerationStructureKHR m_as = VK_NULL_HANDLE;
+            VkDeviceAddress m_address = 0;
+
+            RV init(const AccelerationStructureDesc& desc);
+            ~AccelerationStructure();
+
+            virtual IDevice* get_device() override { return m_device.get(); }
+            virtual void set_name(const c8* name) override;
+            virtual AccelerationStructureDesc get_desc() override { return m_desc; }
+            virtual u64 get_gpu_address() override { return m_address; }
+        };
+
+        //! Encodes acceleration structure build inputs. `geometries` stores geometry descriptors referenced by `dst`, 
+        //! and must be alive until `dst` is consumed. `primitive_counts` receives the number of primitives (triangles or instances)
+        //! of every geometry.
+        void encode_acceleration_structure_inputs(Device* device, const AccelerationStructureBuildInputs& src,
+            VkAccelerationStructureBuildGeometryInfoKHR& dst, Vector<VkAccelerationStructureGeometryKHR>& geometries, 
+            Vector<u32>& primitive_counts);
+    }
+}
@@ -14,6 +14,7 @@
 #include "DescriptorSet.hpp"
 #include "QueryHeap.hpp"
 #include "Fence.hpp"
+#include "AccelerationStructure.hpp"
 #include "Instance.hpp"
 #include "../RHI.hpp"
 namespace Luna
@@ -90,7 +91,7 @@ namespace Luna
                 m_semaphore = VK_NULL_HANDLE;
             }
         }
-        RV CommandBuffer::init(u32 command_queue_index)
+        RV CommandBuffer::init(u32 command_queue_index, bool secondary)
         {
             lutry
             {
@@ -102,6 +103,20 @@ namespace Luna
                 pool_info.flags = 0;
                 pool_info.queueFamilyIndex = m_queue.queue_family_index;
                 luexp(encode_vk_result(m_device->m_funcs.vkCreateCommandPool(m_device->m_device, &pool_info, nullptr, &m_command_pool)));
+                if (secondary)
+                {
+                    // Secondary command buffers only record commands in render passes, and are begun by 
+                    // `begin_parallel_render_pass` of primary command buffers.
+                    m_secondary = true;
+                    m_recording = false;
+                    VkCommandBufferAllocateInfo alloc_info{};
+                    alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+                    alloc_info.commandPool = m_command_pool;
+                    alloc_info.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY;
+                    alloc_info.commandBufferCount = 1;
+                    luexp(encode_vk_result(m_device->m_funcs.vkAllocateCommandBuffers(m_device->m_device, &alloc_info, &m_command_buffer)));
+                    return ok;
+                }
                 VkCommandBufferAllocateInfo alloc_info{};
                 alloc_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
                 alloc_info.commandPool = m_command_pool;
@@ -163,6 +178,38 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        RV CommandBuffer::begin_secondary_command_buffer(VkRenderPass render_pass, VkFramebuffer framebuffer, u32 width, u32 height)
+        {
+            lutry
+            {
+                if (m_recording)
+                {
+                    luexp(encode_vk_result(m_device->m_funcs.vkEndCommandBuffer(m_command_buffer)));
+                    m_recording = false;
+                }
+                luexp(encode_vk_result(m_device->m_funcs.vkResetCommandPool(m_device->m_device, m_command_pool, 0)));
+                VkCommandBufferInheritanceInfo inheritance_info{};
+                inheritance_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+                inheritance_info.renderPass = render_pass;
+                inheritance_info.subpass = 0;
+                inheritance_info.framebuffer = framebuffer;
+                VkCommandBufferBeginInfo begin_info{};
+                begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+                begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+                begin_info.pInheritanceInfo = &inheritance_info;
+                luexp(encode_vk_result(m_device->m_funcs.vkBeginCommandBuffer(m_command_buffer, &begin_info)));
+                m_recording = true;
+                m_objs.clear();
+                m_graphics_pipeline_layout = nullptr;
+                m_rt_width = width;
+                m_rt_height = height;
+                m_render_pass_begin = true;
+                m_statistics = CommandBufferStatistics();
+                reset_shading_rate();
+            }
+            lucatchret;
+            return ok;
+        }
         R<QueueTransferTracker*> CommandBuffer::get_transfer_tracker(u32 queue_family_index)
         {
             QueueTransferTracker* ret;
@@ -201,14 +248,17 @@ namespace Luna
         }
         void CommandBuffer::wait()
         {
+            if (m_secondary) return;
             auto r = m_device->m_funcs.vkWaitForFences(m_device->m_device, 1, &m_fence, VK_TRUE, U64_MAX);
         }
         bool CommandBuffer::try_wait()
         {
+            if (m_secondary) return true;
             return m_device->m_funcs.vkGetFenceStatus(m_device->m_device, m_fence) == VK_SUCCESS;
         }
         RV CommandBuffer::reset()
         {
+            lucheck_msg(!m_secondary, "Secondary command buffers cannot be reset directly.");
             lutry
             {
                 luexp(encode_vk_result(m_device->m_funcs.vkResetFences(m_device->m_device, 1, &m_fence)));
@@ -226,6 +276,7 @@ namespace Luna
                 m_rt_height = 0;
                 m_graphics_pipeline_layout = nullptr;
                 m_compute_pipeline_layout = nullptr;
+                m_statistics = CommandBufferStatistics();
                 for (VkFramebuffer fbo : m_fbos)
                 {
                     m_device->m_funcs.vkDestroyFramebuffer(m_device->m_device, fbo, nullptr);
@@ -322,9 +373,13 @@ namespace Luna
             device->m_funcs.vkCreateFramebuffer(device->m_device, &info, nullptr, &fbo);
             return fbo;
         }
-        void CommandBuffer::begin_render_pass(const RenderPassDesc& desc)
+        void CommandBuffer::begin_render_pass_internal(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers)
         {
+            ++m_statistics.num_render_passes;
+            lucheck_msg(!m_secondary, "begin_render_pass cannot be called on secondary command buffers.");
             lucheck_msg(!m_render_pass_begin && !m_copy_pass_begin && !m_compute_pass_begin, "begin_render_pass can only be called when no other pass is open.");
+            lucheck_msg(!desc.shading_rate_image, "RenderPassDesc::shading_rate_image requires DeviceFeature::shading_rate_image_tile_size.");
+            flush_barriers();
             lutry
             {
                 RenderPassKey rp;
@@ -471,7 +526,22 @@ namespace Luna
                 {
                     begin_pipeline_statistics_query(m_pipeline_statistics_query_heap_attachment, m_pipeline_statistics_query_index);
                 }
-                m_device->m_funcs.vkCmdBeginRenderPass(m_command_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+                if (secondary_command_buffers.empty())
+                {
+                    m_device->m_funcs.vkCmdBeginRenderPass(m_command_buffer, &begin_info, VK_SUBPASS_CONTENTS_INLINE);
+                    reset_shading_rate();
+                }
+                else
+                {
+                    m_device->m_funcs.vkCmdBeginRenderPass(m_command_buffer, &begin_info, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+                    for (ICommandBuffer* cmdbuf : secondary_command_buffers)
+                    {
+                        CommandBuffer* secondary = cast_object<CommandBuffer>(cmdbuf->get_object());
+                        lucheck_msg(secondary->m_secondary, "Only secondary command buffers can be used in begin_parallel_render_pass.");
+                        luexp(secondary->begin_secondary_command_buffer(render_pass, fbo, width, height));
+                        m_secondary_command_buffers.push_back(secondary);
+                    }
+                }
                 m_rt_width = width;
                 m_rt_height = height;
                 m_num_color_attachments = num_color_attachments;
@@ -483,6 +553,16 @@ namespace Luna
 
             }
         }
+        void CommandBuffer::reset_shading_rate()
+        {
+            // Graphics pipelines use dynamic fragment shading rate if supported, which must be set before drawing.
+            if (m_device->m_supports_fragment_shading_rate)
+            {
+                VkExtent2D fragment_size = { 1, 1 };
+                VkFragmentShadingRateCombinerOpKHR combiner_ops[2] = { VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR, VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR };
+                m_device->m_funcs.vkCmdSetFragmentShadingRateKHR(m_command_buffer, &fragment_size, combiner_ops);
+            }
+        }
         void CommandBuffer::set_graphics_pipeline_layout(IPipelineLayout* pipeline_layout)
         {
             assert_graphcis_context();
@@ -490,6 +570,7 @@ namespace Luna
         }
         void CommandBuffer::set_graphics_pipeline_state(IPipelineState* pso)
         {
+            ++m_statistics.num_pipeline_state_binds;
             assert_graphcis_context();
             PipelineState* ps = (PipelineState*)pso->get_object();
             m_device->m_funcs.vkCmdBindPipeline(m_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, ps->m_pipeline);
@@ -525,6 +606,7 @@ namespace Luna
         }
         void CommandBuffer::set_graphics_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets)
         {
+            m_statistics.num_descriptor_set_binds += (u32)descriptor_sets.size();
             assert_graphcis_context();
             VkPipelineLayout layout = VK_NULL_HANDLE;
             PipelineLayout* playout = (PipelineLayout*)m_graphics_pipeline_layout->get_object();
@@ -538,6 +620,13 @@ namespace Luna
             m_device->m_funcs.vkCmdBindDescriptorSets(m_command_buffer, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 
                 start_index, (u32)descriptor_sets.size(), sets, 0, nullptr);
         }
+        void CommandBuffer::set_graphics_constants(u32 first_constant, u32 num_constants, const void* data)
+        {
+            assert_graphcis_context();
+            PipelineLayout* playout = (PipelineLayout*)m_graphics_pipeline_layout->get_object();
+            m_device->m_funcs.vkCmdPushConstants(m_command_buffer, playout->m_pipeline_layout, playout->m_constants_stage_flags,
+                first_constant * sizeof(u32), num_constants * sizeof(u32), data);
+        }
         void CommandBuffer::set_viewport(const Viewport& viewport)
         {
             set_viewports({ &viewport, 1 });
@@ -609,30 +698,88 @@ namespace Luna
             assert_graphcis_context();
             m_device->m_funcs.vkCmdSetStencilReference(m_command_buffer, VK_STENCIL_FACE_FRONT_AND_BACK, stencil_ref);
         }
+        void CommandBuffer::set_shading_rate(ShadingRate rate, ShadingRateCombiner primitive_combiner, ShadingRateCombiner image_combiner)
+        {
+            assert_graphcis_context();
+            lucheck_msg(m_device->m_supports_fragment_shading_rate, "set_shading_rate requires DeviceFeature::variable_rate_shading.");
+            // Shading rate images are not supported, so combiners are ignored.
+            VkExtent2D fragment_size;
+            fragment_size.width = 1 << (((u8)rate >> 2) & 0x03);
+            fragment_size.height = 1 << ((u8)rate & 0x03);
+            VkFragmentShadingRateCombinerOpKHR combiner_ops[2] = { VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR, VK_FRAGMENT_SHADING_RATE_COMBINER_OP_KEEP_KHR };
+            m_device->m_funcs.vkCmdSetFragmentShadingRateKHR(m_command_buffer, &fragment_size, combiner_ops);
+        }
         void CommandBuffer::draw(u32 vertex_count, u32 start_vertex_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_device->m_funcs.vkCmdDraw(m_command_buffer, vertex_count, 1, start_vertex_location, 0);
         }
         void CommandBuffer::draw_indexed(u32 index_count, u32 start_index_location, i32 base_vertex_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_device->m_funcs.vkCmdDrawIndexed(m_command_buffer, index_count, 1, start_index_location, base_vertex_location, 0);
         }
         void CommandBuffer::draw_instanced(u32 vertex_count_per_instance, u32 instance_count, u32 start_vertex_location,
             u32 start_instance_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_device->m_funcs.vkCmdDraw(m_command_buffer, vertex_count_per_instance * instance_count, instance_count,
                 start_vertex_location, start_instance_location);
         }
+        void CommandBuffer::dispatch_mesh(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z)
+        {
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            lucheck_msg(m_device->m_supports_mesh_shader, "dispatch_mesh requires DeviceFeature::mesh_shader.");
+            m_device->m_funcs.vkCmdDrawMeshTasksEXT(m_command_buffer, thread_group_count_x, thread_group_count_y, thread_group_count_z);
+        }
         void CommandBuffer::draw_indexed_instanced(u32 index_count_per_instance, u32 instance_count, u32 start_index_location,
             i32 base_vertex_location, u32 start_instance_location)
         {
+            ++m_statistics.num_draws;
             assert_graphcis_context();
             m_device->m_funcs.vkCmdDrawIndexed(m_command_buffer, index_count_per_instance * instance_count, instance_count, 
                 start_index_location, base_vertex_location, start_instance_location);
         }
+        void CommandBuffer::draw_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+            IBuffer* count_buffer, u64 count_buffer_offset)
+        {
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            BufferResource* res = cast_object<BufferResource>(buffer->get_object());
+            if (count_buffer)
+            {
+                lucheck_msg(m_device->m_supports_draw_indirect_count, "DeviceFeature::indirect_draw_count is not supported.");
+                BufferResource* count_res = cast_object<BufferResource>(count_buffer->get_object());
+                m_device->m_funcs.vkCmdDrawIndirectCountKHR(m_command_buffer, res->m_buffer, offset, 
+                    count_res->m_buffer, count_buffer_offset, max_draw_count, stride);
+            }
+            else
+            {
+                m_device->m_funcs.vkCmdDrawIndirect(m_command_buffer, res->m_buffer, offset, max_draw_count, stride);
+            }
+        }
+        void CommandBuffer::draw_indexed_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+            IBuffer* count_buffer, u64 count_buffer_offset)
+        {
+            ++m_statistics.num_draws;
+            assert_graphcis_context();
+            BufferResource* res = cast_object<BufferResource>(buffer->get_object());
+            if (count_buffer)
+            {
+                lucheck_msg(m_device->m_supports_draw_indirect_count, "DeviceFeature::indirect_draw_count is not supported.");
+                BufferResource* count_res = cast_object<BufferResource>(count_buffer->get_object());
+                m_device->m_funcs.vkCmdDrawIndexedIndirectCountKHR(m_command_buffer, res->m_buffer, offset, 
+                    count_res->m_buffer, count_buffer_offset, max_draw_count, stride);
+            }
+            else
+            {
+                m_device->m_funcs.vkCmdDrawIndexedIndirect(m_command_buffer, res->m_buffer, offset, max_draw_count, stride);
+            }
+        }
         void CommandBuffer::begin_occlusion_query(OcclusionQueryMode mode, u32 index)
         {
             assert_graphcis_context();
@@ -649,6 +796,30 @@ namespace Luna
         void CommandBuffer::end_render_pass()
         {
             assert_graphcis_context();
+            if (m_secondary)
+            {
+                m_device->m_funcs.vkEndCommandBuffer(m_command_buffer);
+                m_recording = false;
+                m_render_pass_begin = false;
+                m_graphics_pipeline_layout = nullptr;
+                m_rt_width = 0;
+                m_rt_height = 0;
+                return;
+            }
+            if (!m_secondary_command_buffers.empty())
+            {
+                VkCommandBuffer* buffers = (VkCommandBuffer*)alloca(sizeof(VkCommandBuffer) * m_secondary_command_buffers.size());
+                for (usize i = 0; i < m_secondary_command_buffers.size(); ++i)
+                {
+                    CommandBuffer* secondary = m_secondary_command_buffers[i].get();
+                    lucheck_msg(!secondary->m_recording, "All secondary command buffers must finish recording before end_render_pass is called.");
+                    buffers[i] = secondary->m_command_buffer;
+                    // Keeps secondary command buffers alive until this command buffer is reset.
+                    attach_device_object(secondary);
+                }
+                m_device->m_funcs.vkCmdExecuteCommands(m_command_buffer, (u32)m_secondary_command_buffers.size(), buffers);
+                m_secondary_command_buffers.clear();
+            }
             m_device->m_funcs.vkCmdEndRenderPass(m_command_buffer);
             if (m_timestamp_query_heap_attachment && m_timestamp_query_end_index != DONT_QUERY)
             {
@@ -675,6 +846,7 @@ namespace Luna
         }
         void CommandBuffer::begin_compute_pass(const ComputePassDesc& desc)
         {
+            ++m_statistics.num_compute_passes;
             lucheck_msg(!m_render_pass_begin && !m_copy_pass_begin && !m_compute_pass_begin, "begin_compute_pass can only be called when no other pass is open.");
             m_compute_pass_begin = true;
             m_timestamp_query_heap_attachment = desc.timestamp_query_heap;
@@ -698,12 +870,14 @@ namespace Luna
         }
         void CommandBuffer::set_compute_pipeline_state(IPipelineState* pso)
         {
+            ++m_statistics.num_pipeline_state_binds;
             assert_compute_context();
             PipelineState* ps = (PipelineState*)pso->get_object();
             m_device->m_funcs.vkCmdBindPipeline(m_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, ps->m_pipeline);
         }
         void CommandBuffer::set_compute_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets)
         {
+            m_statistics.num_descriptor_set_binds += (u32)descriptor_sets.size();
             assert_compute_context();
             VkPipelineLayout layout = VK_NULL_HANDLE;
             PipelineLayout* playout = (PipelineLayout*)m_compute_pipeline_layout->get_object();
@@ -717,11 +891,71 @@ namespace Luna
             m_device->m_funcs.vkCmdBindDescriptorSets(m_command_buffer, VK_PIPELINE_BIND_POINT_COMPUTE, layout,
                 start_index, (u32)descriptor_sets.size(), sets, 0, nullptr);
         }
+        void CommandBuffer::set_compute_constants(u32 first_constant, u32 num_constants, const void* data)
+        {
+            assert_compute_context();
+            PipelineLayout* playout = (PipelineLayout*)m_compute_pipeline_layout->get_object();
+            m_device->m_funcs.vkCmdPushConstants(m_command_buffer, playout->m_pipeline_layout, playout->m_constants_stage_flags,
+                first_constant * sizeof(u32), num_constants * sizeof(u32), data);
+        }
         void CommandBuffer::dispatch(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z)
         {
+            ++m_statistics.num_dispatches;
             assert_compute_context();
+            flush_barriers();
             m_device->m_funcs.vkCmdDispatch(m_command_buffer, thread_group_count_x, thread_group_count_y, thread_group_count_z);
         }
+        void CommandBuffer::dispatch_indirect(IBuffer* buffer, u64 offset)
+        {
+            ++m_statistics.num_dispatches;
+            assert_compute_context();
+            flush_barriers();
+            BufferResource* res = cast_object<BufferResource>(buffer->get_object());
+            m_device->m_funcs.vkCmdDispatchIndirect(m_command_buffer, res->m_buffer, offset);
+        }
+        void CommandBuffer::build_acceleration_structure(IAccelerationStructure* dst, const AccelerationStructureBuildInputs& inputs,
+            IBuffer* scratch_buffer, u64 scratch_buffer_offset, IAccelerationStructure* update_src)
+        {
+            ++m_statistics.num_acceleration_structure_builds;
+            assert_compute_context();
+            lucheck_msg(m_device->m_supports_ray_tracing, "build_acceleration_structure requires DeviceFeature::ray_tracing.");
+            flush_barriers();
+            AccelerationStructure* d = cast_object<AccelerationStructure>(dst->get_object());
+            BufferResource* scratch = cast_object<BufferResource>(scratch_buffer->get_object());
+            VkAccelerationStructureBuildGeometryInfoKHR build_info{};
+            Vector<VkAccelerationStructureGeometryKHR> geometries;
+            Vector<u32> primitive_counts;
+            encode_acceleration_structure_inputs(m_device, inputs, build_info, geometries, primitive_counts);
+            if (update_src)
+            {
+                AccelerationStructure* src = cast_object<AccelerationStructure>(update_src->get_object());
+                build_info.mode = VK_BUILD_ACCELERATION_STRUCTURE_MODE_UPDATE_KHR;
+                build_info.srcAccelerationStructure = src->m_as;
+            }
+            build_info.dstAccelerationStructure = d->m_as;
+            VkBufferDeviceAddressInfo scratch_address_info{};
+            scratch_address_info.sType = VK_STRUCTURE_TYPE_BUFFER_DEVICE_ADDRESS_INFO;
+            scratch_address_info.buffer = scratch->m_buffer;
+            build_info.scratchData.deviceAddress = m_device->m_funcs.vkGetBufferDeviceAddress(m_device->m_device, &scratch_address_info) + scratch_buffer_offset;
+            Vector<VkAccelerationStructureBuildRangeInfoKHR> ranges;
+            ranges.resize(primitive_counts.size());
+            for (usize i = 0; i < primitive_counts.size(); ++i)
+            {
+                ranges[i].primitiveCount = primitive_counts[i];
+                ranges[i].primitiveOffset = 0;
+                ranges[i].firstVertex = 0;
+                ranges[i].transformOffset = 0;
+            }
+            const VkAccelerationStructureBuildRangeInfoKHR* p_ranges = ranges.data();
+            m_device->m_funcs.vkCmdBuildAccelerationStructuresKHR(m_command_buffer, 1, &build_info, &p_ranges);
+            // Succeeding builds and shaders may read the acceleration structure.
+            VkMemoryBarrier barrier{};
+            barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+            barrier.srcAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
+            barrier.dstAccessMask = VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR | VK_ACCESS_SHADER_READ_BIT;
+            m_device->m_funcs.vkCmdPipelineBarrier(m_command_buffer, VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR,
+                VK_PIPELINE_STAGE_ALL_COMMANDS_BIT, 0, 1, &barrier, 0, nullptr, 0, nullptr);
+        }
         void CommandBuffer::end_compute_pass()
         {
             lucheck_msg(m_compute_pass_begin, "Calling end_compute_pass without prior call to begin_compute_pass.");
@@ -742,6 +976,7 @@ namespace Luna
         }
         void CommandBuffer::begin_copy_pass(const CopyPassDesc& desc)
         {
+            ++m_statistics.num_copy_passes;
             lucheck_msg(!m_render_pass_begin && !m_copy_pass_begin && !m_compute_pass_begin, "begin_copy_pass can only be called when no other pass is open.");
             m_copy_pass_begin = true;
             m_timestamp_query_heap_attachment = desc.timestamp_query_heap;
@@ -754,7 +989,9 @@ namespace Luna
         }
         void CommandBuffer::copy_resource(IResource* dst, IResource* src)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             BufferResource* s = cast_object<BufferResource>(src->get_object());
             BufferResource* d = cast_object<BufferResource>(dst->get_object());
             if (s && d)
@@ -802,7 +1039,9 @@ namespace Luna
             IBuffer* src, u64 src_offset,
             u64 copy_bytes)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             BufferResource* s = cast_object<BufferResource>(src->get_object());
             BufferResource* d = cast_object<BufferResource>(dst->get_object());
             VkBufferCopy copy{};
@@ -816,7 +1055,9 @@ namespace Luna
             ITexture* src, SubresourceIndex src_subresource, u32 src_x, u32 src_y, u32 src_z,
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             ImageResource* s = cast_object<ImageResource>(src->get_object());
             ImageResource* d = cast_object<ImageResource>(dst->get_object());
             // The copy is performed one per mips.
@@ -850,7 +1091,9 @@ namespace Luna
             IBuffer* src, u64 src_offset, u32 src_row_pitch, u32 src_slice_pitch,
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             BufferResource* s = cast_object<BufferResource>(src->get_object());
             ImageResource* d = cast_object<ImageResource>(dst->get_object());
             VkBufferImageCopy copy{};
@@ -877,7 +1120,9 @@ namespace Luna
             ITexture* src, SubresourceIndex src_subresource, u32 src_x, u32 src_y, u32 src_z,
             u32 copy_width, u32 copy_height, u32 copy_depth)
         {
+            ++m_statistics.num_copies;
             assert_copy_context();
+            flush_barriers();
             ImageResource* s = cast_object<ImageResource>(src->get_object());
             BufferResource* d = cast_object<BufferResource>(dst->get_object());
             VkBufferImageCopy copy{};
@@ -913,8 +1158,10 @@ namespace Luna
         }
         void CommandBuffer::resource_barrier(Span<const BufferBarrier> buffer_barriers, Span<const TextureBarrier> texture_barriers)
         {
+            m_statistics.num_barriers += (u32)(buffer_barriers.size() + texture_barriers.size());
             assert_non_render_pass();
-            m_track_system.begin_new_barriers_batch();
+            // Barriers are deferred to the next command that accesses resources, so that barriers of successive 
+            // calls are merged into one pipeline barrier.
             for (auto& barrier : buffer_barriers)
             {
                 m_track_system.pack_buffer(barrier);
@@ -923,6 +1170,11 @@ namespace Luna
             {
                 m_track_system.pack_image(barrier);
             }
+        }
+        void CommandBuffer::flush_barriers()
+        {
+            if (m_track_system.m_buffer_barriers.empty() && m_track_system.m_image_barriers.empty()) return;
+            m_track_system.remove_redundant_barriers();
             if (!m_track_system.m_buffer_barriers.empty() || !m_track_system.m_image_barriers.empty())
             {
                 if (m_track_system.m_src_stage_flags == 0)
@@ -938,13 +1190,17 @@ namespace Luna
                     m_track_system.m_buffer_barriers.size(), m_track_system.m_buffer_barriers.data(),
                     m_track_system.m_image_barriers.size(), m_track_system.m_image_barriers.data());
             }
+            m_track_system.begin_new_barriers_batch();
         }
-        RV CommandBuffer::submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting)
+        RV CommandBuffer::submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting,
+            Span<const u64> wait_values, Span<const u64> signal_values)
         {
+            lucheck_msg(!m_secondary, "Secondary command buffers cannot be submitted directly.");
             lucheck_msg(!m_render_pass_begin && !m_copy_pass_begin && !m_compute_pass_begin, "submit can only be called when no render, compute or copy pass is open.");
             if (!m_recording) return BasicError::bad_calling_time();
             lutry
             {
+                flush_barriers();
                 // Finish barrier.
                 m_track_system.generate_finish_barriers();
                 if (!m_track_system.m_buffer_barriers.empty() || !m_track_system.m_image_barriers.empty())
@@ -1006,11 +1262,17 @@ namespace Luna
                     }
                 }
                 // Submit the command buffer.
+                // Values of binary semaphores are ignored, including semaphores of queue ownership transfers.
+                Vector<u64> wait_semaphore_values(wait_semaphores.size(), 0);
+                bool has_timeline_semaphore = false;
                 for (usize i = 0; i < wait_fences.size(); ++i)
                 {
                     Fence* fence = (Fence*)wait_fences[i]->get_object();
                     wait_semaphores.push_back(fence->m_semaphore);
                     wait_stages.push_back(VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+                    bool timeline = fence->m_type == FenceType::timeline;
+                    wait_semaphore_values.push_back(timeline ? wait_values[i] : 0);
+                    has_timeline_semaphore |= timeline;
                 }
                 VkSubmitInfo submit{};
                 submit.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
@@ -1019,16 +1281,31 @@ namespace Luna
                 submit.pWaitDstStageMask = wait_stages.data();
                 submit.signalSemaphoreCount = (u32)signal_fences.size();
                 VkSemaphore* signal_semaphores = nullptr;
+                u64* signal_semaphore_values = nullptr;
                 if (!signal_fences.empty())
                 {
                     signal_semaphores = (VkSemaphore*)alloca(sizeof(VkSemaphore) * signal_fences.size());
+                    signal_semaphore_values = (u64*)alloca(sizeof(u64) * signal_fences.size());
                     for (usize i = 0; i < signal_fences.size(); ++i)
                     {
                         Fence* fence = (Fence*)signal_fences[i]->get_object();
                         signal_semaphores[i] = fence->m_semaphore;
+                        bool timeline = fence->m_type == FenceType::timeline;
+                        signal_semaphore_values[i] = timeline ? signal_values[i] : 0;
+                        has_timeline_semaphore |= timeline;
                     }
                 }
                 submit.pSignalSemaphores = signal_semaphores;
+                VkTimelineSemaphoreSubmitInfo timeline_info{};
+                if (has_timeline_semaphore)
+                {
+                    timeline_info.sType = VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO;
+                    timeline_info.waitSemaphoreValueCount = (u32)wait_semaphore_values.size();
+                    timeline_info.pWaitSemaphoreValues = wait_semaphore_values.data();
+                    timeline_info.signalSemaphoreValueCount = (u32)signal_fences.size();
+                    timeline_info.pSignalSemaphoreValues = signal_semaphore_values;
+                    submit.pNext = &timeline_info;
+                }
                 VkCommandBuffer buffers[2] = { m_resolve_buffer , m_command_buffer };
                 if (resolve_enabled)
                 {
@@ -1048,6 +1325,8 @@ namespace Luna
                 MutexGuard guard(m_queue.queue_mtx);
                 luexp(encode_vk_result(m_device->m_funcs.vkQueueSubmit(m_queue.queue, 1, &submit, fence)));
                 m_track_system.apply();
+                guard.unlock();
+                m_device->m_statistics.on_command_buffer_submitted(this, m_statistics);
             }
             lucatchret;
             return ok;
@@ -51,6 +51,8 @@ namespace Luna
             // The attached graphic objects.
             Vector<Ref<IDeviceChild>> m_objs;
 
+            CommandBufferStatistics m_statistics;
+
             // Controled by begin_render_pass/end_render_pass.
             bool m_render_pass_begin = false;
             u32 m_rt_width = 0;
@@ -77,10 +79,19 @@ namespace Luna
 
             bool m_recording = true;
 
-            RV init(u32 command_queue_index);
+            // Whether this is one secondary command buffer.
+            bool m_secondary = false;
+            // Secondary command buffers of the current render pass begun by `begin_parallel_render_pass`.
+            Vector<Ref<CommandBuffer>> m_secondary_command_buffers;
+
+            RV init(u32 command_queue_index, bool secondary = false);
             ~CommandBuffer();
 
             RV begin_command_buffer();
+            //! Begins recording one secondary command buffer that continues the specified render pass.
+            RV begin_secondary_command_buffer(VkRenderPass render_pass, VkFramebuffer framebuffer, u32 width, u32 height);
+            void begin_render_pass_internal(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers);
+            void reset_shading_rate();
 
             R<QueueTransferTracker*> get_transfer_tracker(u32 queue_family_index);
 
@@ -100,6 +111,8 @@ namespace Luna
             {
                 lucheck_msg(!m_render_pass_begin, "This command cannot be submitted between begin_render_pass and end_render_pass.");
             }
+            //! Records all barriers deferred by `resource_barrier` as one pipeline barrier.
+            void flush_barriers();
             void write_timestamp(IQueryHeap* heap, u32 index);
             void begin_pipeline_statistics_query(IQueryHeap* heap, u32 index);
             void end_pipeline_statistics_query(IQueryHeap* heap, u32 index);
@@ -111,9 +124,18 @@ namespace Luna
             virtual u32 get_command_queue_index() override { return m_queue_index; }
             virtual RV reset() override;
             virtual void attach_device_object(IDeviceChild* obj) override;
+            virtual CommandBufferStatistics get_statistics() override { return m_statistics; }
             virtual void begin_event(const c8* event_name) override;
             virtual void end_event() override;
-            virtual void begin_render_pass(const RenderPassDesc& desc) override;
+            virtual void begin_render_pass(const RenderPassDesc& desc) override
+            {
+                begin_render_pass_internal(desc, {});
+            }
+            virtual void begin_parallel_render_pass(const RenderPassDesc& desc, Span<ICommandBuffer*> secondary_command_buffers) override
+            {
+                lucheck_msg(!m_secondary, "begin_parallel_render_pass cannot be called on secondary command buffers.");
+                begin_render_pass_internal(desc, secondary_command_buffers);
+            }
             virtual void set_graphics_pipeline_layout(IPipelineLayout* pipeline_layout) override;
             virtual void set_graphics_pipeline_state(IPipelineState* pso) override;
             virtual void set_vertex_buffers(u32 start_slot, Span<const VertexBufferView> views) override;
@@ -123,18 +145,25 @@ namespace Luna
                 set_graphics_descriptor_sets(start_index, { &descriptor_set, 1 });
             }
             virtual void set_graphics_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) override;
+            virtual void set_graphics_constants(u32 first_constant, u32 num_constants, const void* data) override;
             virtual void set_viewport(const Viewport& viewport) override;
             virtual void set_viewports(Span<const Viewport> viewports) override;
             virtual void set_scissor_rect(const RectI& rect) override;
             virtual void set_scissor_rects(Span<const RectI> rects) override;
             virtual void set_blend_factor(const Float4U& blend_factor) override;
             virtual void set_stencil_ref(u32 stencil_ref) override;
+            virtual void set_shading_rate(ShadingRate rate, ShadingRateCombiner primitive_combiner, ShadingRateCombiner image_combiner) override;
             virtual void draw(u32 vertex_count, u32 start_vertex_location) override;
             virtual void draw_indexed(u32 index_count, u32 start_index_location, i32 base_vertex_location) override;
             virtual void draw_instanced(u32 vertex_count_per_instance, u32 instance_count, u32 start_vertex_location,
                 u32 start_instance_location) override;
+            virtual void dispatch_mesh(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) override;
             virtual void draw_indexed_instanced(u32 index_count_per_instance, u32 instance_count, u32 start_index_location,
                 i32 base_vertex_location, u32 start_instance_location) override;
+            virtual void draw_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+                IBuffer* count_buffer, u64 count_buffer_offset) override;
+            virtual void draw_indexed_indirect(IBuffer* buffer, u64 offset, u32 max_draw_count, u32 stride,
+                IBuffer* count_buffer, u64 count_buffer_offset) override;
             virtual void begin_occlusion_query(OcclusionQueryMode mode, u32 index) override;
             virtual void end_occlusion_query(u32 index) override;
             virtual void end_render_pass() override;
@@ -146,7 +175,11 @@ namespace Luna
                 set_compute_descriptor_sets(start_index, { &descriptor_set, 1 });
             }
             virtual void set_compute_descriptor_sets(u32 start_index, Span<IDescriptorSet*> descriptor_sets) override;
+            virtual void set_compute_constants(u32 first_constant, u32 num_constants, const void* data) override;
             virtual void dispatch(u32 thread_group_count_x, u32 thread_group_count_y, u32 thread_group_count_z) override;
+            virtual void dispatch_indirect(IBuffer* buffer, u64 offset) override;
+            virtual void build_acceleration_structure(IAccelerationStructure* dst, const AccelerationStructureBuildInputs& inputs,
+                IBuffer* scratch_buffer, u64 scratch_buffer_offset, IAccelerationStructure* update_src) override;
             virtual void end_compute_pass() override;
             virtual void begin_copy_pass(const CopyPassDesc& desc) override;
             virtual void copy_resource(IResource* dst, IResource* src) override;
@@ -168,7 +201,8 @@ namespace Luna
                 u32 copy_width, u32 copy_height, u32 copy_depth) override;
             virtual void end_copy_pass() override;
             virtual void resource_barrier(Span<const BufferBarrier> buffer_barriers, Span<const TextureBarrier> texture_barriers) override;
-            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting) override;
+            virtual RV submit(Span<IFence*> wait_fences, Span<IFence*> signal_fences, bool allow_host_waiting,
+                Span<const u64> wait_values, Span<const u64> signal_values) override;
         };
     }
 }
\ No newline at end of file
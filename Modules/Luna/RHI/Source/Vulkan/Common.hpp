@@ -237,6 +237,17 @@ namespace Luna
             if (test_flags(mask, ColorWriteMask::alpha)) r |= VK_COLOR_COMPONENT_A_BIT;
             return r;
         }
+        inline VkShaderStageFlags encode_shader_stage_flags(ShaderVisibilityFlag flags)
+        {
+            if (flags == ShaderVisibilityFlag::all) return VK_SHADER_STAGE_ALL;
+            VkShaderStageFlags r = 0;
+            if (test_flags(flags, ShaderVisibilityFlag::vertex)) r |= VK_SHADER_STAGE_VERTEX_BIT;
+            if (test_flags(flags, ShaderVisibilityFlag::pixel)) r |= VK_SHADER_STAGE_FRAGMENT_BIT;
+            if (test_flags(flags, ShaderVisibilityFlag::compute)) r |= VK_SHADER_STAGE_COMPUTE_BIT;
+            if (test_flags(flags, ShaderVisibilityFlag::mesh)) r |= VK_SHADER_STAGE_MESH_BIT_EXT;
+            if (test_flags(flags, ShaderVisibilityFlag::amplification)) r |= VK_SHADER_STAGE_TASK_BIT_EXT;
+            return r;
+        }
         inline VkAttachmentLoadOp encode_load_op(LoadOp op)
         {
             switch (op)
@@ -287,6 +298,10 @@ namespace Luna
             if (test_flags(desc.usages, BufferUsageFlag::index_buffer)) dst.usage |= VK_BUFFER_USAGE_INDEX_BUFFER_BIT;
             if (test_flags(desc.usages, BufferUsageFlag::vertex_buffer)) dst.usage |= VK_BUFFER_USAGE_VERTEX_BUFFER_BIT;
             if (test_flags(desc.usages, BufferUsageFlag::indirect_buffer)) dst.usage |= VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+            if (test_flags(desc.usages, BufferUsageFlag::acceleration_structure_build_input)) 
+                dst.usage |= VK_BUFFER_USAGE_ACCELERATION_STRUCTURE_BUILD_INPUT_READ_ONLY_BIT_KHR | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
+            if (test_flags(desc.usages, BufferUsageFlag::acceleration_structure_scratch)) 
+                dst.usage |= VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_SHADER_DEVICE_ADDRESS_BIT;
             dst.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
         }
         inline void encode_image_create_info(VkImageCreateInfo& dst, const TextureDesc& desc)
@@ -360,6 +375,9 @@ namespace Luna
                 test_flags(state, BufferStateFlag::shader_write_cs)) f |= VK_ACCESS_SHADER_WRITE_BIT;
             if (test_flags(state, BufferStateFlag::copy_dest)) f |= VK_ACCESS_TRANSFER_WRITE_BIT;
             if (test_flags(state, BufferStateFlag::copy_source)) f |= VK_ACCESS_TRANSFER_READ_BIT;
+            if (test_flags(state, BufferStateFlag::acceleration_structure_build_input)) f |= VK_ACCESS_SHADER_READ_BIT;
+            if (test_flags(state, BufferStateFlag::acceleration_structure_scratch)) 
+                f |= VK_ACCESS_ACCELERATION_STRUCTURE_READ_BIT_KHR | VK_ACCESS_ACCELERATION_STRUCTURE_WRITE_BIT_KHR;
             return f;
         }
         inline VkAccessFlags encode_access_flags(TextureStateFlag state)
@@ -515,6 +533,11 @@ namespace Luna
             {
                 flags |= VK_PIPELINE_STAGE_TRANSFER_BIT;
             }
+            if (test_flags(state, BufferStateFlag::acceleration_structure_build_input) ||
+                test_flags(state, BufferStateFlag::acceleration_structure_scratch))
+            {
+                flags |= VK_PIPELINE_STAGE_ACCELERATION_STRUCTURE_BUILD_BIT_KHR;
+            }
             return flags;
         }
         inline VkPipelineStageFlags determine_pipeline_stage_flags(TextureStateFlag state, CommandQueueType queue_type)
@@ -630,6 +653,7 @@ namespace Luna
             case DescriptorType::read_texture_view: return VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE;
             case DescriptorType::read_write_texture_view: return VK_DESCRIPTOR_TYPE_STORAGE_IMAGE;
             case DescriptorType::sampler: return VK_DESCRIPTOR_TYPE_SAMPLER;
+            case DescriptorType::acceleration_structure: return VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR;
             }
             lupanic();
             return VK_DESCRIPTOR_TYPE_SAMPLER;
@@ -9,11 +9,12 @@
 */
 #include "DescriptorSet.hpp"
 #include "Resource.hpp"
+#include "AccelerationStructure.hpp"
 namespace Luna
 {
     namespace RHI
     {
-        RV DescriptorSet::init(const DescriptorSetDesc& desc)
+        RV DescriptorSet::init(const DescriptorSetDesc& desc, DescriptorSetArena* arena)
         {
             lutry
             {
@@ -32,15 +33,23 @@ namespace Luna
                     variable_info.descriptorSetCount = 1;
                     alloc_info.pNext = &variable_info;
                 }
-                MutexGuard guard(m_device->m_desc_pool_mtx);
-                luexp(encode_vk_result(m_device->m_funcs.vkAllocateDescriptorSets(m_device->m_device, &alloc_info, &m_desc_set)));
+                if (arena)
+                {
+                    luset(m_desc_set, arena->allocate(alloc_info));
+                    m_transient = true;
+                }
+                else
+                {
+                    MutexGuard guard(m_device->m_desc_pool_mtx);
+                    luexp(encode_vk_result(m_device->m_funcs.vkAllocateDescriptorSets(m_device->m_device, &alloc_info, &m_desc_set)));
+                }
             }
             lucatchret;
             return ok;
         }
         DescriptorSet::~DescriptorSet()
         {
-            if (m_desc_set != VK_NULL_HANDLE)
+            if (m_desc_set != VK_NULL_HANDLE && !m_transient)
             {
                 MutexGuard guard(m_device->m_desc_pool_mtx);
                 m_device->m_funcs.vkFreeDescriptorSets(m_device->m_device, m_device->m_desc_pool, 1, &m_desc_set);
@@ -49,6 +58,7 @@ namespace Luna
         }
         RV DescriptorSet::update_descriptors(Span<const WriteDescriptorSet> writes)
         {
+            m_device->m_statistics.on_descriptors_written(writes);
             lutry
             {
                 VkWriteDescriptorSet* d_writes = nullptr;
@@ -147,6 +157,27 @@ namespace Luna
                             }
                         }
                         break;
+                        case DescriptorType::acceleration_structure:
+                        {
+                            if (d.descriptorCount)
+                            {
+                                VkAccelerationStructureKHR* handles = (VkAccelerationStructureKHR*)alloca(sizeof(VkAccelerationStructureKHR) * d.descriptorCount);
+                                for (u32 j = 0; j < d.descriptorCount; ++j)
+                                {
+                                    AccelerationStructure* as = cast_object<AccelerationStructure>(s.acceleration_structures[j]->get_object());
+                                    handles[j] = as->m_as;
+                                }
+                                // Acceleration structures are specified by one extension structure rather than pBufferInfo/pImageInfo.
+                                VkWriteDescriptorSetAccelerationStructureKHR* info = 
+                                    (VkWriteDescriptorSetAccelerationStructureKHR*)alloca(sizeof(VkWriteDescriptorSetAccelerationStructureKHR));
+                                memzero(info, sizeof(VkWriteDescriptorSetAccelerationStructureKHR));
+                                info->sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET_ACCELERATION_STRUCTURE_KHR;
+                                info->accelerationStructureCount = d.descriptorCount;
+                                info->pAccelerationStructures = handles;
+                                d.pNext = info;
+                            }
+                        }
+                        break;
                         }
                     }
                 }
@@ -11,6 +11,7 @@
 #include "DescriptorSetLayout.hpp"
 #include "ImageView.hpp"
 #include "Sampler.hpp"
+#include "DescriptorSetArena.hpp"
 
 namespace Luna
 {
@@ -26,10 +27,12 @@ namespace Luna
             Ref<DescriptorSetLayout> m_layout;
 
             VkDescriptorSet m_desc_set = VK_NULL_HANDLE;
+            // `true` if this set is allocated from one descriptor set arena, and should not be freed individually.
+            bool m_transient = false;
 
             HashMap<u32, Ref<Sampler>> m_samplers;
 
-            RV init(const DescriptorSetDesc& desc);
+            RV init(const DescriptorSetDesc& desc, DescriptorSetArena* arena = nullptr);
             ~DescriptorSet();
 
             virtual IDevice* get_device() override { return m_device.get(); }
@@ -0,0 +1,97 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DescriptorSetArena.cpp
+* @author JXMaster
+* @date 2024/4/1
+*/
+#include "DescriptorSetArena.hpp"
+#include "DescriptorSet.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        DescriptorSetArena::~DescriptorSetArena()
+        {
+            for (VkDescriptorPool pool : m_pools)
+            {
+                m_device->m_funcs.vkDestroyDescriptorPool(m_device->m_device, pool, nullptr);
+            }
+            m_pools.clear();
+        }
+        R<VkDescriptorPool> DescriptorSetArena::new_pool()
+        {
+            VkDescriptorPoolSize pool_sizes[6] = {
+                {VK_DESCRIPTOR_TYPE_SAMPLER, 256},
+                {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 2048},
+                {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 256},
+                {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 2048},
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 256},
+                {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 16}
+            };
+            VkDescriptorPoolCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+            // Acceleration structure descriptors can only be used if VK_KHR_acceleration_structure is enabled.
+            create_info.poolSizeCount = m_device->m_supports_ray_tracing ? 6 : 5;
+            create_info.pPoolSizes = pool_sizes;
+            create_info.flags = 0;
+            create_info.maxSets = 1024;
+            VkDescriptorPool pool = VK_NULL_HANDLE;
+            auto r = encode_vk_result(m_device->m_funcs.vkCreateDescriptorPool(m_device->m_device, &create_info, nullptr, &pool));
+            if (failed(r)) return r.errcode();
+            m_pools.push_back(pool);
+            return pool;
+        }
+        R<VkDescriptorSet> DescriptorSetArena::allocate(VkDescriptorSetAllocateInfo& alloc_info)
+        {
+            VkDescriptorSet set = VK_NULL_HANDLE;
+            lutry
+            {
+                if (m_pools.empty())
+                {
+                    luexp(new_pool());
+                }
+                alloc_info.descriptorPool = m_pools[m_current_pool];
+                VkResult result = m_device->m_funcs.vkAllocateDescriptorSets(m_device->m_device, &alloc_info, &set);
+                if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL)
+                {
+                    // Switches to the next pool.
+                    ++m_current_pool;
+                    if (m_current_pool == m_pools.size())
+                    {
+                        luexp(new_pool());
+                    }
+                    alloc_info.descriptorPool = m_pools[m_current_pool];
+                    result = m_device->m_funcs.vkAllocateDescriptorSets(m_device->m_device, &alloc_info, &set);
+                }
+                luexp(encode_vk_result(result));
+            }
+            lucatchret;
+            return set;
+        }
+        R<Ref<IDescriptorSet>> DescriptorSetArena::new_descriptor_set(const DescriptorSetDesc& desc)
+        {
+            Ref<IDescriptorSet> ret;
+            lutry
+            {
+                auto set = new_object<DescriptorSet>();
+                set->m_device = m_device;
+                luexp(set->init(desc, this));
+                ret = set;
+            }
+            lucatchret;
+            return ret;
+        }
+        void DescriptorSetArena::reset()
+        {
+            for (usize i = 0; i < m_pools.size() && i <= m_current_pool; ++i)
+            {
+                m_device->m_funcs.vkResetDescriptorPool(m_device->m_device, m_pools[i], 0);
+            }
+            m_current_pool = 0;
+        }
+    }
+}
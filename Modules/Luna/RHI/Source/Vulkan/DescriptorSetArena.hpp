@@ -0,0 +1,42 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DescriptorSetArena.hpp
+* @author JXMaster
+* @date 2024/4/1
+*/
+#pragma once
+#include "Device.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct DescriptorSetArena : IDescriptorSetArena
+        {
+            lustruct("RHI::DescriptorSetArena", "{A4E07C93-5D1B-4F28-B6E3-8C92D0F1A75E}");
+            luiimpl();
+
+            Ref<Device> m_device;
+            Name m_name;
+            // Descriptor pools owned by this arena. Pools are created without `VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT`
+            // and are reset as a whole.
+            Vector<VkDescriptorPool> m_pools;
+            // The index of the pool that descriptor sets are allocated from.
+            usize m_current_pool = 0;
+
+            ~DescriptorSetArena();
+
+            R<VkDescriptorPool> new_pool();
+            //! Allocates one descriptor set from the current pool, switches to the next pool if the current pool is full.
+            R<VkDescriptorSet> allocate(VkDescriptorSetAllocateInfo& alloc_info);
+
+            virtual IDevice* get_device() override { return m_device.get(); }
+            virtual void set_name(const c8* name) override { m_name = name; }
+            virtual R<Ref<IDescriptorSet>> new_descriptor_set(const DescriptorSetDesc& desc) override;
+            virtual void reset() override;
+        };
+    }
+}
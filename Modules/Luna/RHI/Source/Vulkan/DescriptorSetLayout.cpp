@@ -18,26 +18,7 @@ namespace Luna
             dst.binding = src.binding_slot;
             dst.descriptorCount = src.num_descs;
             dst.descriptorType = encode_descriptor_type(src.type);
-            if (src.shader_visibility_flags == ShaderVisibilityFlag::all)
-            {
-                dst.stageFlags = VK_SHADER_STAGE_ALL;
-            }
-            else
-            {
-                dst.stageFlags = 0;
-                if (test_flags(src.shader_visibility_flags, ShaderVisibilityFlag::vertex))
-                {
-                    dst.stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
-                }
-                if (test_flags(src.shader_visibility_flags, ShaderVisibilityFlag::pixel))
-                {
-                    dst.stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
-                }
-                if (test_flags(src.shader_visibility_flags, ShaderVisibilityFlag::compute))
-                {
-                    dst.stageFlags |= VK_SHADER_STAGE_COMPUTE_BIT;
-                }
-            }
+            dst.stageFlags = encode_shader_stage_flags(src.shader_visibility_flags);
             dst.pImmutableSamplers = nullptr;
         }
         RV DescriptorSetLayout::init(const DescriptorSetLayoutDesc& desc)
@@ -64,13 +45,26 @@ namespace Luna
                     info.bindingCount = 0;
                 }
                 VkDescriptorSetLayoutBindingFlagsCreateInfo binding_flags{};
-                if (test_flags(desc.flags, DescriptorSetLayoutFlag::variable_descriptors) && info.bindingCount)
+                bool variable_descriptors = test_flags(desc.flags, DescriptorSetLayoutFlag::variable_descriptors);
+                bool partially_bound = test_flags(desc.flags, DescriptorSetLayoutFlag::partially_bound);
+                if ((variable_descriptors || partially_bound) && info.bindingCount)
                 {
                     binding_flags.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
                     binding_flags.bindingCount = info.bindingCount;
                     auto flags = (VkDescriptorBindingFlags*)alloca(sizeof(VkDescriptorBindingFlags) * info.bindingCount);
                     memzero(flags, sizeof(VkDescriptorBindingFlags) * info.bindingCount);
-                    flags[info.bindingCount - 1] |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT;
+                    if (partially_bound)
+                    {
+                        for (u32 i = 0; i < info.bindingCount; ++i)
+                        {
+                            flags[i] |= VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT;
+                        }
+                    }
+                    if (variable_descriptors)
+                    {
+                        flags[info.bindingCount - 1] |= VK_DESCRIPTOR_BINDING_VARIABLE_DESCRIPTOR_COUNT_BIT_EXT;
+                    }
+                    binding_flags.pBindingFlags = flags;
                     info.pNext = &binding_flags;
                 }
                 luexp(encode_vk_result(m_device->m_funcs.vkCreateDescriptorSetLayout(m_device->m_device, &info, nullptr, &m_layout)));
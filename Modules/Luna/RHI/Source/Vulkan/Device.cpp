@@ -15,13 +15,16 @@
 #include "PipelineLayout.hpp"
 #include "DescriptorSetLayout.hpp"
 #include "DescriptorSet.hpp"
+#include "DescriptorSetArena.hpp"
 #include "CommandBuffer.hpp"
 #include "Resource.hpp"
 #include "Fence.hpp"
 #include "PipelineState.hpp"
+#include "PipelineCache.hpp"
 #include "QueryHeap.hpp"
 #include "ResourceStateTrackingSystem.hpp"
 #include "SwapChain.hpp"
+#include "AccelerationStructure.hpp"
 namespace Luna
 {
     namespace RHI
@@ -61,6 +64,103 @@ namespace Luna
                 m_supports_descriptor_indexing = true;
             }
 
+            // VK_EXT_memory_budget requires vkGetPhysicalDeviceMemoryProperties2, which is core in Vulkan 1.1.
+            m_supports_memory_budget = false;
+            if (g_vk_version >= VK_API_VERSION_1_1)
+            {
+                for (auto& extension : m_extension_properties)
+                {
+                    if (strcmp(extension.extensionName, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME) == 0)
+                    {
+                        m_supports_memory_budget = true;
+                        enabled_extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+                        break;
+                    }
+                }
+            }
+
+            m_supports_draw_indirect_count = false;
+            for (auto& extension : m_extension_properties)
+            {
+                if (strcmp(extension.extensionName, VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME) == 0)
+                {
+                    m_supports_draw_indirect_count = true;
+                    enabled_extensions.push_back(VK_KHR_DRAW_INDIRECT_COUNT_EXTENSION_NAME);
+                    break;
+                }
+            }
+
+            // VK_EXT_mesh_shader requires SPIR-V 1.4, which is core in Vulkan 1.2.
+            m_supports_mesh_shader = false;
+            if (g_vk_version >= VK_API_VERSION_1_2)
+            {
+                for (auto& extension : m_extension_properties)
+                {
+                    if (strcmp(extension.extensionName, VK_EXT_MESH_SHADER_EXTENSION_NAME) == 0)
+                    {
+                        m_supports_mesh_shader = true;
+                        enabled_extensions.push_back(VK_EXT_MESH_SHADER_EXTENSION_NAME);
+                        break;
+                    }
+                }
+            }
+
+            // Ray queries require SPIR-V 1.4 and buffer device addresses, which are core in Vulkan 1.2.
+            m_supports_ray_tracing = false;
+            if (g_vk_version >= VK_API_VERSION_1_2)
+            {
+                bool acceleration_structure = false;
+                bool deferred_host_operations = false;
+                bool ray_query = false;
+                for (auto& extension : m_extension_properties)
+                {
+                    if (strcmp(extension.extensionName, VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME) == 0) acceleration_structure = true;
+                    else if (strcmp(extension.extensionName, VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME) == 0) deferred_host_operations = true;
+                    else if (strcmp(extension.extensionName, VK_KHR_RAY_QUERY_EXTENSION_NAME) == 0) ray_query = true;
+                }
+                if (acceleration_structure && deferred_host_operations && ray_query)
+                {
+                    m_supports_ray_tracing = true;
+                    enabled_extensions.push_back(VK_KHR_ACCELERATION_STRUCTURE_EXTENSION_NAME);
+                    enabled_extensions.push_back(VK_KHR_DEFERRED_HOST_OPERATIONS_EXTENSION_NAME);
+                    enabled_extensions.push_back(VK_KHR_RAY_QUERY_EXTENSION_NAME);
+                }
+            }
+
+            // VK_KHR_fragment_shading_rate requires VK_KHR_create_renderpass2, which is core in Vulkan 1.2.
+            m_supports_fragment_shading_rate = false;
+            if (g_vk_version >= VK_API_VERSION_1_2)
+            {
+                for (auto& extension : m_extension_properties)
+                {
+                    if (strcmp(extension.extensionName, VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME) == 0)
+                    {
+                        m_supports_fragment_shading_rate = true;
+                        enabled_extensions.push_back(VK_KHR_FRAGMENT_SHADING_RATE_EXTENSION_NAME);
+                        break;
+                    }
+                }
+            }
+
+            // VK_KHR_present_wait and VK_KHR_present_id features are queried by vkGetPhysicalDeviceFeatures2, which is core in Vulkan 1.1.
+            m_supports_present_wait = false;
+            if (g_vk_version >= VK_API_VERSION_1_1)
+            {
+                bool present_id = false;
+                bool present_wait = false;
+                for (auto& extension : m_extension_properties)
+                {
+                    if (strcmp(extension.extensionName, VK_KHR_PRESENT_ID_EXTENSION_NAME) == 0) present_id = true;
+                    else if (strcmp(extension.extensionName, VK_KHR_PRESENT_WAIT_EXTENSION_NAME) == 0) present_wait = true;
+                }
+                if (present_id && present_wait)
+                {
+                    m_supports_present_wait = true;
+                    enabled_extensions.push_back(VK_KHR_PRESENT_ID_EXTENSION_NAME);
+                    enabled_extensions.push_back(VK_KHR_PRESENT_WAIT_EXTENSION_NAME);
+                }
+            }
+
             m_desc_pool_mtx = new_mutex();
             m_physical_device = physical_device;
             vkGetPhysicalDeviceProperties(physical_device, &m_physical_device_properties);
@@ -94,6 +194,140 @@ namespace Luna
             create_info.ppEnabledLayerNames = g_enabled_layers.data();
             create_info.enabledExtensionCount = (u32)enabled_extensions.size();
             create_info.ppEnabledExtensionNames = enabled_extensions.data();
+            // Enable descriptor indexing features used by unbound and partially bound descriptor arrays.
+            VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptor_indexing_features{};
+            descriptor_indexing_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+            if (m_supports_descriptor_indexing && g_vk_version >= VK_API_VERSION_1_1)
+            {
+                VkPhysicalDeviceFeatures2 features2{};
+                features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features2.pNext = &descriptor_indexing_features;
+                vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+                m_supports_descriptor_indexing = descriptor_indexing_features.runtimeDescriptorArray &&
+                    descriptor_indexing_features.descriptorBindingPartiallyBound &&
+                    descriptor_indexing_features.descriptorBindingVariableDescriptorCount;
+                last->pNext = &descriptor_indexing_features;
+                last = (VkStructureHeader*)&descriptor_indexing_features;
+            }
+            else
+            {
+                // Features cannot be queried without `vkGetPhysicalDeviceFeatures2`.
+                m_supports_descriptor_indexing = false;
+            }
+            // Timeline semaphores are used by timeline fences. Only the core version in Vulkan 1.2 is used, so that 
+            // `vkWaitSemaphores` and other functions can be called without the KHR suffix.
+            VkPhysicalDeviceTimelineSemaphoreFeatures timeline_semaphore_features{};
+            timeline_semaphore_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES;
+            m_supports_timeline_semaphore = false;
+            if (g_vk_version >= VK_API_VERSION_1_2)
+            {
+                VkPhysicalDeviceFeatures2 features2{};
+                features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features2.pNext = &timeline_semaphore_features;
+                vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+                m_supports_timeline_semaphore = timeline_semaphore_features.timelineSemaphore == VK_TRUE;
+                if (m_supports_timeline_semaphore)
+                {
+                    last->pNext = &timeline_semaphore_features;
+                    last = (VkStructureHeader*)&timeline_semaphore_features;
+                }
+            }
+            // Enable task and mesh shaders. Multiview and fragment shading rate support for mesh shaders are not used.
+            VkPhysicalDeviceMeshShaderFeaturesEXT mesh_shader_features{};
+            mesh_shader_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MESH_SHADER_FEATURES_EXT;
+            if (m_supports_mesh_shader)
+            {
+                VkPhysicalDeviceFeatures2 features2{};
+                features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features2.pNext = &mesh_shader_features;
+                vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+                m_supports_mesh_shader = mesh_shader_features.meshShader == VK_TRUE && mesh_shader_features.taskShader == VK_TRUE;
+                if (m_supports_mesh_shader)
+                {
+                    mesh_shader_features.pNext = nullptr;
+                    mesh_shader_features.multiviewMeshShader = VK_FALSE;
+                    mesh_shader_features.primitiveFragmentShadingRateMeshShader = VK_FALSE;
+                    last->pNext = &mesh_shader_features;
+                    last = (VkStructureHeader*)&mesh_shader_features;
+                }
+            }
+            // Enable acceleration structures and ray queries. Acceleration structures are built on device only, so host 
+            // commands and capture replay features are not used.
+            VkPhysicalDeviceBufferDeviceAddressFeatures buffer_device_address_features{};
+            buffer_device_address_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_BUFFER_DEVICE_ADDRESS_FEATURES;
+            VkPhysicalDeviceAccelerationStructureFeaturesKHR acceleration_structure_features{};
+            acceleration_structure_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_FEATURES_KHR;
+            VkPhysicalDeviceRayQueryFeaturesKHR ray_query_features{};
+            ray_query_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_RAY_QUERY_FEATURES_KHR;
+            memzero(&m_acceleration_structure_properties);
+            m_acceleration_structure_properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ACCELERATION_STRUCTURE_PROPERTIES_KHR;
+            if (m_supports_ray_tracing)
+            {
+                VkPhysicalDeviceFeatures2 features2{};
+                features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features2.pNext = &buffer_device_address_features;
+                buffer_device_address_features.pNext = &acceleration_structure_features;
+                acceleration_structure_features.pNext = &ray_query_features;
+                vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+                m_supports_ray_tracing = buffer_device_address_features.bufferDeviceAddress == VK_TRUE &&
+                    acceleration_structure_features.accelerationStructure == VK_TRUE &&
+                    ray_query_features.rayQuery == VK_TRUE;
+                if (m_supports_ray_tracing)
+                {
+                    buffer_device_address_features.bufferDeviceAddressCaptureReplay = VK_FALSE;
+                    buffer_device_address_features.bufferDeviceAddressMultiDevice = VK_FALSE;
+                    acceleration_structure_features.accelerationStructureCaptureReplay = VK_FALSE;
+                    acceleration_structure_features.accelerationStructureIndirectBuild = VK_FALSE;
+                    acceleration_structure_features.accelerationStructureHostCommands = VK_FALSE;
+                    ray_query_features.pNext = nullptr;
+                    last->pNext = &buffer_device_address_features;
+                    last = (VkStructureHeader*)&ray_query_features;
+                    VkPhysicalDeviceProperties2 properties2{};
+                    properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+                    properties2.pNext = &m_acceleration_structure_properties;
+                    vkGetPhysicalDeviceProperties2(physical_device, &properties2);
+                    m_acceleration_structure_properties.pNext = nullptr;
+                }
+            }
+            // Enable per-draw fragment shading rates. Shading rate attachments require VkRenderPass2 and are not used.
+            VkPhysicalDeviceFragmentShadingRateFeaturesKHR fragment_shading_rate_features{};
+            fragment_shading_rate_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FRAGMENT_SHADING_RATE_FEATURES_KHR;
+            if (m_supports_fragment_shading_rate)
+            {
+                VkPhysicalDeviceFeatures2 features2{};
+                features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features2.pNext = &fragment_shading_rate_features;
+                vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+                m_supports_fragment_shading_rate = fragment_shading_rate_features.pipelineFragmentShadingRate == VK_TRUE;
+                if (m_supports_fragment_shading_rate)
+                {
+                    fragment_shading_rate_features.pNext = nullptr;
+                    fragment_shading_rate_features.primitiveFragmentShadingRate = VK_FALSE;
+                    fragment_shading_rate_features.attachmentFragmentShadingRate = VK_FALSE;
+                    last->pNext = &fragment_shading_rate_features;
+                    last = (VkStructureHeader*)&fragment_shading_rate_features;
+                }
+            }
+            // Enable present IDs and waiting for presents, which are used by swap chains to limit frame latency.
+            VkPhysicalDevicePresentIdFeaturesKHR present_id_features{};
+            present_id_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_ID_FEATURES_KHR;
+            VkPhysicalDevicePresentWaitFeaturesKHR present_wait_features{};
+            present_wait_features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PRESENT_WAIT_FEATURES_KHR;
+            if (m_supports_present_wait)
+            {
+                VkPhysicalDeviceFeatures2 features2{};
+                features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+                features2.pNext = &present_id_features;
+                present_id_features.pNext = &present_wait_features;
+                vkGetPhysicalDeviceFeatures2(physical_device, &features2);
+                m_supports_present_wait = present_id_features.presentId == VK_TRUE && present_wait_features.presentWait == VK_TRUE;
+                if (m_supports_present_wait)
+                {
+                    present_wait_features.pNext = nullptr;
+                    last->pNext = &present_id_features;
+                    last = (VkStructureHeader*)&present_wait_features;
+                }
+            }
             auto r = encode_vk_result(vkCreateDevice(physical_device, &create_info, nullptr, &m_device));
             volkLoadDeviceTable(&m_funcs, m_device);
             if (failed(r))
@@ -101,11 +335,18 @@ namespace Luna
                 return r.errcode();
             }
             // Fetch command queue.
+            u32 queue_family_count = 0;
+            vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, nullptr);
+            VkQueueFamilyProperties* queue_family_properties = (VkQueueFamilyProperties*)alloca(sizeof(VkQueueFamilyProperties) * queue_family_count);
+            vkGetPhysicalDeviceQueueFamilyProperties(physical_device, &queue_family_count, queue_family_properties);
+            bool sparse_binding_queue_present = false;
             for (usize i = 0; i < queue_families.size(); ++i)
             {
                 CommandQueue queue;
                 queue.desc = queue_families[i].desc;
                 queue.queue_family_index = queue_families[i].index;
+                queue.sparse_binding = (queue_family_properties[queue_families[i].index].queueFlags & VK_QUEUE_SPARSE_BINDING_BIT) != 0;
+                if (queue.sparse_binding) sparse_binding_queue_present = true;
                 for (usize j = 0; j < queue_families[i].num_queues; ++j)
                 {
                     queue.queue_index_in_family = j;
@@ -115,6 +356,11 @@ namespace Luna
                     m_queues.push_back(queue);
                 }
             }
+            // Sparse features are enabled along with all other core features.
+            m_supports_sparse_residency = sparse_binding_queue_present &&
+                m_physical_device_features.sparseBinding == VK_TRUE &&
+                m_physical_device_features.sparseResidencyBuffer == VK_TRUE &&
+                m_physical_device_features.sparseResidencyImage2D == VK_TRUE;
             r = init_descriptor_pools();
             if (failed(r))
             {
@@ -132,16 +378,18 @@ namespace Luna
         }
         RV Device::init_descriptor_pools()
         {
-            VkDescriptorPoolSize pool_sizes[5] = {
+            VkDescriptorPoolSize pool_sizes[6] = {
                 {VK_DESCRIPTOR_TYPE_SAMPLER, 1024},
                 {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 8192},
                 {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1024},
                 {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 8192},
-                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1024}
+                {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1024},
+                {VK_DESCRIPTOR_TYPE_ACCELERATION_STRUCTURE_KHR, 64}
             };
             VkDescriptorPoolCreateInfo create_info{};
             create_info.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-            create_info.poolSizeCount = 5;
+            // Acceleration structure descriptors can only be used if VK_KHR_acceleration_structure is enabled.
+            create_info.poolSizeCount = m_supports_ray_tracing ? 6 : 5;
             create_info.pPoolSizes = pool_sizes;
             create_info.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
             create_info.maxSets = 8192;
@@ -154,6 +402,16 @@ namespace Luna
             allocator_create_info.physicalDevice = m_physical_device;
             allocator_create_info.device = m_device;
             allocator_create_info.instance = g_vk_instance;
+            if (m_supports_memory_budget)
+            {
+                // Query the budget from the system rather than estimating it from allocations of this device.
+                allocator_create_info.flags |= VMA_ALLOCATOR_CREATE_EXT_MEMORY_BUDGET_BIT;
+            }
+            if (m_supports_ray_tracing)
+            {
+                // Acceleration structure build inputs and scratch buffers are referenced by device addresses.
+                allocator_create_info.flags |= VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
+            }
             VmaVulkanFunctions funcs{};
             funcs.vkGetInstanceProcAddr = vkGetInstanceProcAddr;
             funcs.vkGetDeviceProcAddr = vkGetDeviceProcAddr;
@@ -296,6 +554,27 @@ namespace Luna
             case DeviceFeature::uniform_buffer_data_alignment:
                 ret.uniform_buffer_data_alignment = (u32)m_physical_device_properties.limits.minUniformBufferOffsetAlignment;
                 break;
+            case DeviceFeature::indirect_draw_count:
+                ret.indirect_draw_count = m_supports_draw_indirect_count;
+                break;
+            case DeviceFeature::timeline_fence:
+                ret.timeline_fence = m_supports_timeline_semaphore;
+                break;
+            case DeviceFeature::mesh_shader:
+                ret.mesh_shader = m_supports_mesh_shader;
+                break;
+            case DeviceFeature::ray_tracing:
+                ret.ray_tracing = m_supports_ray_tracing;
+                break;
+            case DeviceFeature::variable_rate_shading:
+                ret.variable_rate_shading = m_supports_fragment_shading_rate;
+                break;
+            case DeviceFeature::shading_rate_image_tile_size:
+                ret.shading_rate_image_tile_size = 0;
+                break;
+            case DeviceFeature::reserved_resources:
+                ret.reserved_resources = m_supports_sparse_residency;
+                break;
             default: lupanic();
             }
             return ret;
@@ -318,6 +597,7 @@ namespace Luna
             {
                 auto res = new_object<BufferResource>();
                 res->m_device = this;
+                m_statistics.on_buffer_created();
                 luexp(res->init_as_committed(memory_type, desc));
                 ret = res;
             }
@@ -331,6 +611,7 @@ namespace Luna
             {
                 auto res = new_object<ImageResource>();
                 res->m_device = this;
+                m_statistics.on_texture_created();
                 luexp(res->init_as_committed(memory_type, desc));
                 ret = res;
             }
@@ -398,6 +679,7 @@ namespace Luna
                 DeviceMemory* memory = cast_object<DeviceMemory>(device_memory->get_object());
                 auto res = new_object<BufferResource>();
                 res->m_device = this;
+                m_statistics.on_buffer_created();
                 luexp(res->init_as_aliasing(desc, memory));
                 ret = res;
             }
@@ -412,12 +694,261 @@ namespace Luna
                 DeviceMemory* memory = cast_object<DeviceMemory>(device_memory->get_object());
                 auto res = new_object<ImageResource>();
                 res->m_device = this;
+                m_statistics.on_texture_created();
                 luexp(res->init_as_aliasing(desc, memory));
                 ret = res;
             }
             lucatchret;
             return ret;
         }
+        R<Ref<IBuffer>> Device::new_reserved_buffer(const BufferDesc& desc)
+        {
+            if (!m_supports_sparse_residency) return BasicError::not_supported();
+            Ref<IBuffer> ret;
+            lutry
+            {
+                auto res = new_object<BufferResource>();
+                res->m_device = this;
+                m_statistics.on_buffer_created();
+                luexp(res->init_as_reserved(desc));
+                ret = res;
+            }
+            lucatchret;
+            return ret;
+        }
+        R<Ref<ITexture>> Device::new_reserved_texture(const TextureDesc& desc)
+        {
+            if (!m_supports_sparse_residency) return BasicError::not_supported();
+            if (desc.type != TextureType::tex2d || desc.sample_count != 1 || 
+                test_flags(desc.usages, TextureUsageFlag::color_attachment) ||
+                test_flags(desc.usages, TextureUsageFlag::depth_stencil_attachment))
+            {
+                return BasicError::not_supported();
+            }
+            Ref<ITexture> ret;
+            lutry
+            {
+                auto res = new_object<ImageResource>();
+                res->m_device = this;
+                m_statistics.on_texture_created();
+                luexp(res->init_as_reserved(desc));
+                ret = res;
+            }
+            lucatchret;
+            return ret;
+        }
+        ReservedTextureTiling Device::get_reserved_texture_tiling(ITexture* texture)
+        {
+            ImageResource* res = cast_object<ImageResource>(texture->get_object());
+            lucheck_msg(res->m_is_reserved, "get_reserved_texture_tiling requires one reserved texture.");
+            auto& requirements = res->m_sparse_requirements;
+            ReservedTextureTiling ret;
+            ret.tile_width = requirements.formatProperties.imageGranularity.width;
+            ret.tile_height = requirements.formatProperties.imageGranularity.height;
+            ret.tile_depth = requirements.formatProperties.imageGranularity.depth;
+            ret.num_standard_mips = min(requirements.imageMipTailFirstLod, res->m_desc.mip_levels);
+            ret.num_packed_mip_tiles = ret.num_standard_mips < res->m_desc.mip_levels ? 
+                (u32)(requirements.imageMipTailSize / RESERVED_RESOURCE_TILE_SIZE) : 0;
+            return ret;
+        }
+        R<Ref<IDeviceMemory>> Device::allocate_tile_memory(u32 num_tiles)
+        {
+            if (!m_supports_sparse_residency) return BasicError::not_supported();
+            Ref<IDeviceMemory> ret;
+            lutry
+            {
+                VkMemoryRequirements memory_requirements;
+                memory_requirements.size = (u64)num_tiles * RESERVED_RESOURCE_TILE_SIZE;
+                memory_requirements.alignment = RESERVED_RESOURCE_TILE_SIZE;
+                memory_requirements.memoryTypeBits = U32_MAX;
+                auto memory = new_object<DeviceMemory>();
+                memory->m_device = this;
+                luexp(memory->init(MemoryType::local, false, memory_requirements));
+                ret = memory;
+            }
+            lucatchret;
+            return ret;
+        }
+        RV Device::update_tile_mappings(u32 command_queue_index, IResource* resource, Span<const TileMapping> mappings)
+        {
+            lucheck(command_queue_index < m_queues.size());
+            auto& queue = m_queues[command_queue_index];
+            if (!queue.sparse_binding) return BasicError::not_supported();
+            BufferResource* buffer = cast_object<BufferResource>(resource->get_object());
+            ImageResource* image = buffer ? nullptr : cast_object<ImageResource>(resource->get_object());
+            lucheck(buffer || image);
+            Vector<VkSparseMemoryBind> memory_binds;
+            Vector<VkSparseImageMemoryBind> image_binds;
+            u32 num_standard_mips = image ? get_reserved_texture_tiling(image).num_standard_mips : 0;
+            for (auto& mapping : mappings)
+            {
+                VkDeviceMemory memory = VK_NULL_HANDLE;
+                VkDeviceSize memory_offset = 0;
+                if (mapping.memory)
+                {
+                    DeviceMemory* m = cast_object<DeviceMemory>(mapping.memory->get_object());
+                    memory = m->m_allocation_info.deviceMemory;
+                    memory_offset = m->m_allocation_info.offset + mapping.memory_offset;
+                }
+                if (buffer)
+                {
+                    VkSparseMemoryBind bind{};
+                    bind.resourceOffset = (u64)mapping.x * RESERVED_RESOURCE_TILE_SIZE;
+                    bind.size = (u64)mapping.width * RESERVED_RESOURCE_TILE_SIZE;
+                    bind.memory = memory;
+                    bind.memoryOffset = memory_offset;
+                    memory_binds.push_back(bind);
+                }
+                else if (mapping.subresource.mip_slice >= num_standard_mips)
+                {
+                    // Mip tails are bound as opaque memory ranges.
+                    auto& requirements = image->m_sparse_requirements;
+                    VkSparseMemoryBind bind{};
+                    bind.resourceOffset = requirements.imageMipTailOffset + (u64)mapping.x * RESERVED_RESOURCE_TILE_SIZE;
+                    if (!(requirements.formatProperties.flags & VK_SPARSE_IMAGE_FORMAT_SINGLE_MIPTAIL_BIT))
+                    {
+                        bind.resourceOffset += mapping.subresource.array_slice * requirements.imageMipTailStride;
+                    }
+                    bind.size = (u64)mapping.width * RESERVED_RESOURCE_TILE_SIZE;
+                    bind.memory = memory;
+                    bind.memoryOffset = memory_offset;
+                    memory_binds.push_back(bind);
+                }
+                else
+                {
+                    auto& granularity = image->m_sparse_requirements.formatProperties.imageGranularity;
+                    u32 mip_width = max<u32>(image->m_desc.width >> mapping.subresource.mip_slice, 1);
+                    u32 mip_height = max<u32>(image->m_desc.height >> mapping.subresource.mip_slice, 1);
+                    u32 mip_depth = max<u32>(image->m_desc.depth >> mapping.subresource.mip_slice, 1);
+                    VkSparseImageMemoryBind bind{};
+                    bind.subresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+                    bind.subresource.mipLevel = mapping.subresource.mip_slice;
+                    bind.subresource.arrayLayer = mapping.subresource.array_slice;
+                    bind.offset.x = (i32)(mapping.x * granularity.width);
+                    bind.offset.y = (i32)(mapping.y * granularity.height);
+                    bind.offset.z = (i32)(mapping.z * granularity.depth);
+                    // The extent must either be a multiple of the granularity or reach the edge of the subresource.
+                    bind.extent.width = min((mapping.x + mapping.width) * granularity.width, mip_width) - bind.offset.x;
+                    bind.extent.height = min((mapping.y + mapping.height) * granularity.height, mip_height) - bind.offset.y;
+                    bind.extent.depth = min((mapping.z + mapping.depth) * granularity.depth, mip_depth) - bind.offset.z;
+                    bind.memory = memory;
+                    bind.memoryOffset = memory_offset;
+                    image_binds.push_back(bind);
+                }
+            }
+            VkSparseBufferMemoryBindInfo buffer_bind_info{};
+            VkSparseImageOpaqueMemoryBindInfo image_opaque_bind_info{};
+            VkSparseImageMemoryBindInfo image_bind_info{};
+            VkBindSparseInfo bind_info{};
+            bind_info.sType = VK_STRUCTURE_TYPE_BIND_SPARSE_INFO;
+            if (buffer)
+            {
+                buffer_bind_info.buffer = buffer->m_buffer;
+                buffer_bind_info.bindCount = (u32)memory_binds.size();
+                buffer_bind_info.pBinds = memory_binds.data();
+                bind_info.bufferBindCount = 1;
+                bind_info.pBufferBinds = &buffer_bind_info;
+            }
+            else
+            {
+                if (!memory_binds.empty())
+                {
+                    image_opaque_bind_info.image = image->m_image;
+                    image_opaque_bind_info.bindCount = (u32)memory_binds.size();
+                    image_opaque_bind_info.pBinds = memory_binds.data();
+                    bind_info.imageOpaqueBindCount = 1;
+                    bind_info.pImageOpaqueBinds = &image_opaque_bind_info;
+                }
+                if (!image_binds.empty())
+                {
+                    image_bind_info.image = image->m_image;
+                    image_bind_info.bindCount = (u32)image_binds.size();
+                    image_bind_info.pBinds = image_binds.data();
+                    bind_info.imageBindCount = 1;
+                    bind_info.pImageBinds = &image_bind_info;
+                }
+            }
+            // Sparse binding operations are not ordered with command buffers submitted to the same queue, so 
+            // we wait for the binding to complete before returning.
+            VkFence fence = VK_NULL_HANDLE;
+            VkFenceCreateInfo fence_create_info{};
+            fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+            RV r = encode_vk_result(m_funcs.vkCreateFence(m_device, &fence_create_info, nullptr, &fence));
+            if (failed(r)) return r;
+            {
+                MutexGuard guard(queue.queue_mtx);
+                r = encode_vk_result(m_funcs.vkQueueBindSparse(queue.queue, 1, &bind_info, fence));
+            }
+            if (succeeded(r))
+            {
+                r = encode_vk_result(m_funcs.vkWaitForFences(m_device, 1, &fence, VK_TRUE, U64_MAX));
+            }
+            m_funcs.vkDestroyFence(m_device, fence, nullptr);
+            return r;
+        }
+        AccelerationStructureSizes Device::get_acceleration_structure_sizes(const AccelerationStructureBuildInputs& inputs)
+        {
+            AccelerationStructureSizes ret;
+            memzero(&ret);
+            if (!m_supports_ray_tracing) return ret;
+            VkAccelerationStructureBuildGeometryInfoKHR build_info{};
+            Vector<VkAccelerationStructureGeometryKHR> geometries;
+            Vector<u32> max_primitive_counts;
+            encode_acceleration_structure_inputs(this, inputs, build_info, geometries, max_primitive_counts);
+            VkAccelerationStructureBuildSizesInfoKHR sizes{};
+            sizes.sType = VK_STRUCTURE_TYPE_ACCELERATION_STRUCTURE_BUILD_SIZES_INFO_KHR;
+            m_funcs.vkGetAccelerationStructureBuildSizesKHR(m_device, VK_ACCELERATION_STRUCTURE_BUILD_TYPE_DEVICE_KHR, 
+                &build_info, max_primitive_counts.data(), &sizes);
+            // Acceleration structures must be placed at 256-byte aligned offsets.
+            ret.acceleration_structure_size = align_upper(sizes.accelerationStructureSize, 256);
+            ret.scratch_alignment = max<u64>(m_acceleration_structure_properties.minAccelerationStructureScratchOffsetAlignment, 1);
+            ret.build_scratch_size = align_upper(sizes.buildScratchSize, ret.scratch_alignment);
+            ret.update_scratch_size = align_upper(sizes.updateScratchSize, ret.scratch_alignment);
+            return ret;
+        }
+        R<Ref<IAccelerationStructure>> Device::new_acceleration_structure(const AccelerationStructureDesc& desc)
+        {
+            if (!m_supports_ray_tracing) return BasicError::not_supported();
+            Ref<IAccelerationStructure> ret;
+            lutry
+            {
+                auto as = new_object<AccelerationStructure>();
+                as->m_device = this;
+                luexp(as->init(desc));
+                ret = as;
+            }
+            lucatchret;
+            return ret;
+        }
+        DeviceMemoryBudget Device::get_memory_budget()
+        {
+            VkPhysicalDeviceMemoryProperties memory_properties;
+            vkGetPhysicalDeviceMemoryProperties(m_physical_device, &memory_properties);
+            VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+            vmaGetHeapBudgets(m_allocator, budgets);
+            DeviceMemoryBudget ret;
+            for (u32 i = 0; i < memory_properties.memoryHeapCount; ++i)
+            {
+                MemoryHeapBudget& dst = (memory_properties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? ret.local : ret.non_local;
+                dst.block_bytes += budgets[i].statistics.blockBytes;
+                dst.allocation_bytes += budgets[i].statistics.allocationBytes;
+                dst.usage += budgets[i].usage;
+                dst.budget += budgets[i].budget;
+            }
+            return ret;
+        }
+        void Device::update_memory_budget()
+        {
+            // VMA refreshes the budget fetched from VK_EXT_memory_budget when the frame index changes.
+            ++m_memory_budget_frame_index;
+            vmaSetCurrentFrameIndex(m_allocator, m_memory_budget_frame_index);
+            DeviceMemoryBudget budget = get_memory_budget();
+            if (is_memory_budget_changed(m_last_memory_budget, budget))
+            {
+                m_last_memory_budget = budget;
+                m_memory_budget_change_event(this, budget);
+            }
+        }
         R<Ref<IPipelineLayout>> Device::new_pipeline_layout(const PipelineLayoutDesc& desc)
         {
             Ref<IPipelineLayout> ret;
@@ -431,6 +962,19 @@ namespace Luna
             lucatchret;
             return ret;
         }
+        R<Ref<IPipelineCache>> Device::new_pipeline_cache(Span<const byte_t> initial_data)
+        {
+            Ref<IPipelineCache> ret;
+            lutry
+            {
+                auto cache = new_object<PipelineCache>();
+                cache->m_device = this;
+                luexp(cache->init(initial_data));
+                ret = cache;
+            }
+            lucatchret;
+            return ret;
+        }
         R<Ref<IPipelineState>> Device::new_graphics_pipeline_state(const GraphicsPipelineStateDesc& desc)
         {
             Ref<IPipelineState> ret;
@@ -439,6 +983,7 @@ namespace Luna
                 auto layout = new_object<PipelineState>();
                 layout->m_device = this;
                 luexp(layout->init_as_graphics(desc));
+                m_statistics.on_pipeline_state_created();
                 ret = layout;
             }
             lucatchret;
@@ -452,6 +997,22 @@ namespace Luna
                 auto layout = new_object<PipelineState>();
                 layout->m_device = this;
                 luexp(layout->init_as_compute(desc));
+                m_statistics.on_pipeline_state_created();
+                ret = layout;
+            }
+            lucatchret;
+            return ret;
+        }
+        R<Ref<IPipelineState>> Device::new_mesh_pipeline_state(const MeshPipelineStateDesc& desc)
+        {
+            if (!m_supports_mesh_shader) return BasicError::not_supported();
+            Ref<IPipelineState> ret;
+            lutry
+            {
+                auto layout = new_object<PipelineState>();
+                layout->m_device = this;
+                luexp(layout->init_as_mesh(desc));
+                m_statistics.on_pipeline_state_created();
                 ret = layout;
             }
             lucatchret;
@@ -478,11 +1039,18 @@ namespace Luna
                 auto set = new_object<DescriptorSet>();
                 set->m_device = this;
                 luexp(set->init(desc));
+                m_statistics.on_descriptor_set_created();
                 ret = set;
             }
             lucatchret;
             return ret;
         }
+        R<Ref<IDescriptorSetArena>> Device::new_descriptor_set_arena()
+        {
+            auto arena = new_object<DescriptorSetArena>();
+            arena->m_device = this;
+            return Ref<IDescriptorSetArena>(arena);
+        }
         u32 Device::get_num_command_queues()
         {
             return (u32)m_queues.size();
@@ -505,6 +1073,19 @@ namespace Luna
             lucatchret;
             return ret;
         }
+        R<Ref<ICommandBuffer>> Device::new_secondary_command_buffer(u32 command_queue_index)
+        {
+            Ref<ICommandBuffer> ret;
+            lutry
+            {
+                auto buf = new_object<CommandBuffer>();
+                buf->m_device = this;
+                luexp(buf->init(command_queue_index, true));
+                ret = buf;
+            }
+            lucatchret;
+            return ret;
+        }
         R<f64> Device::get_command_queue_timestamp_frequency(u32 command_queue_index)
         {
             f64 period = m_physical_device_properties.limits.timestampPeriod;
@@ -523,14 +1104,14 @@ namespace Luna
             lucatchret;
             return ret;
         }
-        R<Ref<IFence>> Device::new_fence()
+        R<Ref<IFence>> Device::new_fence(FenceType type, u64 initial_value)
         {
             Ref<IFence> ret;
             lutry
             {
                 auto fence = new_object<Fence>();
                 fence->m_device = this;
-                luexp(fence->init());
+                luexp(fence->init(type, initial_value));
                 ret = fence;
             }
             lucatchret;
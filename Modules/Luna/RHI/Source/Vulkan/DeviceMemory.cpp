@@ -21,6 +21,7 @@ namespace Luna
             encode_allocation_info(allocation, memory_type, allow_aliasing);
             RV res = encode_vk_result(vmaAllocateMemory(m_device->m_allocator, &pVkMemoryRequirements, &allocation, &m_allocation, &m_allocation_info));
             if(failed(res)) return res;
+            m_device->m_statistics.on_memory_allocated(m_device, m_memory_type, get_size());
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
             memory_profiler_allocate(&m_allocation, get_size());
             memory_profiler_set_memory_domain(&m_allocation, "GPU", 3);
@@ -32,6 +33,7 @@ namespace Luna
         {
             if (m_allocation != VK_NULL_HANDLE)
             {
+                m_device->m_statistics.on_memory_freed(m_device, m_memory_type, get_size());
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
                 memory_profiler_deallocate(&m_allocation);
 #endif
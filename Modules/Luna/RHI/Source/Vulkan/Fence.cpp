@@ -13,12 +13,48 @@ namespace Luna
 {
     namespace RHI
     {
-        RV Fence::init()
+        RV Fence::init(FenceType type, u64 initial_value)
         {
+            m_type = type;
             VkSemaphoreCreateInfo info{};
             info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+            VkSemaphoreTypeCreateInfo type_info{};
+            if (type == FenceType::timeline)
+            {
+                if (!m_device->m_supports_timeline_semaphore) return BasicError::not_supported();
+                type_info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO;
+                type_info.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE;
+                type_info.initialValue = initial_value;
+                info.pNext = &type_info;
+            }
             return encode_vk_result(m_device->m_funcs.vkCreateSemaphore(m_device->m_device, &info, nullptr, &m_semaphore));
         }
+        u64 Fence::get_completed_value()
+        {
+            if (m_type != FenceType::timeline) return 0;
+            u64 value = 0;
+            m_device->m_funcs.vkGetSemaphoreCounterValue(m_device->m_device, m_semaphore, &value);
+            return value;
+        }
+        RV Fence::wait(u64 value)
+        {
+            lucheck_msg(m_type == FenceType::timeline, "Only timeline fences can be waited from host.");
+            VkSemaphoreWaitInfo info{};
+            info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO;
+            info.semaphoreCount = 1;
+            info.pSemaphores = &m_semaphore;
+            info.pValues = &value;
+            return encode_vk_result(m_device->m_funcs.vkWaitSemaphores(m_device->m_device, &info, U64_MAX));
+        }
+        RV Fence::signal(u64 value)
+        {
+            lucheck_msg(m_type == FenceType::timeline, "Only timeline fences can be signaled from host.");
+            VkSemaphoreSignalInfo info{};
+            info.sType = VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO;
+            info.semaphore = m_semaphore;
+            info.value = value;
+            return encode_vk_result(m_device->m_funcs.vkSignalSemaphore(m_device->m_device, &info));
+        }
         Fence::~Fence()
         {
             if (m_semaphore != VK_NULL_HANDLE)
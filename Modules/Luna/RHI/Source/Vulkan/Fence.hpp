@@ -21,13 +21,18 @@ namespace Luna
 
             Ref<Device> m_device;
             VkSemaphore m_semaphore = VK_NULL_HANDLE;
+            FenceType m_type;
             Name m_name;
 
-            RV init();
+            RV init(FenceType type, u64 initial_value);
             ~Fence();
 
             virtual IDevice* get_device() override { return m_device.get(); }
             virtual void set_name(const c8* name) override { m_name = name; }
+            virtual FenceType get_type() override { return m_type; }
+            virtual u64 get_completed_value() override;
+            virtual RV wait(u64 value) override;
+            virtual RV signal(u64 value) override;
         };
     }
 }
\ No newline at end of file
@@ -0,0 +1,68 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PipelineCache.cpp
+* @author JXMaster
+* @date 2024/3/30
+*/
+#include "PipelineCache.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! Checks whether the pipeline cache data is created by the same device and driver.
+        static bool is_pipeline_cache_data_compatible(const VkPhysicalDeviceProperties& properties, Span<const byte_t> data)
+        {
+            // The header layout is defined by VK_PIPELINE_CACHE_HEADER_VERSION_ONE.
+            constexpr usize header_size = 16 + VK_UUID_SIZE;
+            if (data.size() < header_size) return false;
+            u32 header[4];
+            memcpy(header, data.data(), sizeof(header));
+            if (header[0] < header_size || header[1] != VK_PIPELINE_CACHE_HEADER_VERSION_ONE) return false;
+            if (header[2] != properties.vendorID || header[3] != properties.deviceID) return false;
+            return memcmp(data.data() + 16, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+        }
+        RV PipelineCache::init(Span<const byte_t> initial_data)
+        {
+            VkPipelineCacheCreateInfo create_info{};
+            create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+            // Some drivers do not validate the initial data, so we discard the data that is not created 
+            // by this device to prevent undefined behavior.
+            if (is_pipeline_cache_data_compatible(m_device->m_physical_device_properties, initial_data))
+            {
+                create_info.initialDataSize = initial_data.size();
+                create_info.pInitialData = initial_data.data();
+            }
+            return encode_vk_result(m_device->m_funcs.vkCreatePipelineCache(m_device->m_device, &create_info, nullptr, &m_pipeline_cache));
+        }
+        PipelineCache::~PipelineCache()
+        {
+            if (m_pipeline_cache != VK_NULL_HANDLE)
+            {
+                m_device->m_funcs.vkDestroyPipelineCache(m_device->m_device, m_pipeline_cache, nullptr);
+                m_pipeline_cache = VK_NULL_HANDLE;
+            }
+        }
+        R<Blob> PipelineCache::get_data()
+        {
+            Blob data;
+            lutry
+            {
+                size_t size = 0;
+                luexp(encode_vk_result(m_device->m_funcs.vkGetPipelineCacheData(m_device->m_device, m_pipeline_cache, &size, nullptr)));
+                data = Blob(size);
+                luexp(encode_vk_result(m_device->m_funcs.vkGetPipelineCacheData(m_device->m_device, m_pipeline_cache, &size, data.data())));
+                // The cache may shrink between two calls.
+                if (size != data.size())
+                {
+                    data = Blob(data.data(), size);
+                }
+            }
+            lucatchret;
+            return data;
+        }
+    }
+}
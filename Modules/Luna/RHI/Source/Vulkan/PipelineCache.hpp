@@ -0,0 +1,34 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PipelineCache.hpp
+* @author JXMaster
+* @date 2024/3/30
+*/
+#pragma once
+#include "Device.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        struct PipelineCache : IPipelineCache
+        {
+            lustruct("RHI::PipelineCache", "{6F3B8E52-0C1D-4A7E-B5D4-9E2A7C41F08B}");
+            luiimpl();
+
+            Ref<Device> m_device;
+            Name m_name;
+            VkPipelineCache m_pipeline_cache = VK_NULL_HANDLE;
+
+            RV init(Span<const byte_t> initial_data);
+            ~PipelineCache();
+
+            virtual IDevice* get_device() override { return m_device.get(); }
+            virtual void set_name(const c8* name) override { m_name = name; }
+            virtual R<Blob> get_data() override;
+        };
+    }
+}
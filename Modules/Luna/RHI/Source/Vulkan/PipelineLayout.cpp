@@ -36,8 +36,22 @@ namespace Luna
                     create_info.pSetLayouts = layouts;
                     create_info.setLayoutCount = (u32)desc.descriptor_set_layouts.size();
                 }
-                create_info.pushConstantRangeCount = 0;
-                create_info.pPushConstantRanges = nullptr;
+                VkPushConstantRange push_constant_range{};
+                if (desc.num_constants)
+                {
+                    lucheck(desc.num_constants <= MAX_PIPELINE_CONSTANTS);
+                    m_constants_stage_flags = encode_shader_stage_flags(desc.constants_shader_visibility_flags);
+                    push_constant_range.stageFlags = m_constants_stage_flags;
+                    push_constant_range.offset = 0;
+                    push_constant_range.size = desc.num_constants * sizeof(u32);
+                    create_info.pushConstantRangeCount = 1;
+                    create_info.pPushConstantRanges = &push_constant_range;
+                }
+                else
+                {
+                    create_info.pushConstantRangeCount = 0;
+                    create_info.pPushConstantRanges = nullptr;
+                }
                 luexp(encode_vk_result(m_device->m_funcs.vkCreatePipelineLayout(m_device->m_device, &create_info, nullptr, &m_pipeline_layout)));
             }
             lucatchret;
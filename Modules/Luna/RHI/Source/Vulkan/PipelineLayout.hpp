@@ -21,6 +21,7 @@ namespace Luna
             Ref<Device> m_device;
             Name m_name;
             VkPipelineLayout m_pipeline_layout = VK_NULL_HANDLE;
+            VkShaderStageFlags m_constants_stage_flags = 0;
 
             RV init(const PipelineLayoutDesc& desc);
             ~PipelineLayout();
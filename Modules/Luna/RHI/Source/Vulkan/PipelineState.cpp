@@ -8,6 +8,7 @@
 * @date 2023/4/23
 */
 #include "PipelineState.hpp"
+#include "PipelineCache.hpp"
 #include "PipelineLayout.hpp"
 
 namespace Luna
@@ -38,129 +39,22 @@ namespace Luna
                 }
             }
         };
-        RV PipelineState::init_as_graphics(const GraphicsPipelineStateDesc& desc)
+        inline VkPipelineCache get_vk_pipeline_cache(IPipelineCache* cache)
+        {
+            if (!cache) return VK_NULL_HANDLE;
+            return cast_object<PipelineCache>(cache->get_object())->m_pipeline_cache;
+        }
+        // Fills states shared by graphics and mesh pipelines and creates the pipeline.
+        template <typename _Desc>
+        RV create_graphics_pipeline(Device* device, VkGraphicsPipelineCreateInfo& create_info, const _Desc& desc, VkPipeline& pipeline)
         {
             lutry
             {
-                VkGraphicsPipelineCreateInfo create_info{};
-                create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
-                create_info.flags = 0;
-                // vs, hs, ds, gs, ps.
-                VkPipelineShaderStageCreateInfo stages[5] = { {} };
-                VkShaderModule shader_modles[5] = { VK_NULL_HANDLE };
-                u32 num_stages = 0;
-                ShaderModule vs;
-                ShaderModule ps;
-                if(desc.vs.format != ShaderDataFormat::none)
-                {
-                    if(desc.vs.format != ShaderDataFormat::spirv)
-                    {
-                        return set_error(BasicError::bad_arguments(), "The data format of vertex shader must be ShaderDataFormat::spirv for Vulkan backend!");
-                    }
-                    if(desc.vs.data.empty())
-                    {
-                        return set_error(BasicError::bad_arguments(), "The vertex shader data is empty.");
-                    }
-                    luexp(vs.init(m_device, desc.vs.data));
-                    shader_modles[num_stages] = vs.shader_module;
-                    auto& dst = stages[num_stages];
-                    dst.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-                    dst.stage = VK_SHADER_STAGE_VERTEX_BIT;
-                    dst.module = shader_modles[num_stages];
-                    dst.pName = desc.vs.entry_point.c_str();
-                    dst.flags = 0;
-                    dst.pSpecializationInfo = nullptr;
-                    ++num_stages;
-                }
-                if (desc.ps.format != ShaderDataFormat::none)
-                {
-                    if(desc.ps.format != ShaderDataFormat::spirv)
-                    {
-                        return set_error(BasicError::bad_arguments(), "The data format of pixel shader must be ShaderDataFormat::spirv for Vulkan backend!");
-                    }
-                    if(desc.ps.data.empty())
-                    {
-                        return set_error(BasicError::bad_arguments(), "The pixel shader data is empty.");
-                    }
-                    luexp(ps.init(m_device, desc.ps.data));
-                    shader_modles[num_stages] = ps.shader_module;
-                    auto& dst = stages[num_stages];
-                    dst.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-                    dst.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-                    dst.module = shader_modles[num_stages];
-                    dst.pName = desc.ps.entry_point.c_str();
-                    dst.flags = 0;
-                    dst.pSpecializationInfo = nullptr;
-                    ++num_stages;
-                }
-                create_info.pStages = stages;
-                create_info.stageCount = num_stages;
-                // Vertex input.
-                VkPipelineVertexInputStateCreateInfo vertex_input{};
-                vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-                if (desc.input_layout.bindings.empty())
-                {
-                    vertex_input.vertexBindingDescriptionCount = 0;
-                    vertex_input.pVertexBindingDescriptions = nullptr;
-                }
-                else
-                {
-                    VkVertexInputBindingDescription* descs = (VkVertexInputBindingDescription*)alloca(
-                        sizeof(VkVertexInputBindingDescription) * desc.input_layout.bindings.size());
-                    memzero(descs, sizeof(VkVertexInputBindingDescription) * desc.input_layout.bindings.size());
-                    for (usize i = 0; i < desc.input_layout.bindings.size(); ++i)
-                    {
-                        auto& dst = descs[i];
-                        auto& src = desc.input_layout.bindings[i];
-                        dst.binding = src.binding_slot;
-                        dst.stride = src.element_size;
-                        switch (src.input_rate)
-                        {
-                        case InputRate::per_vertex:
-                            dst.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; break;
-                        case InputRate::per_instance:
-                            dst.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE; break;
-                        }
-                    }
-                    vertex_input.vertexBindingDescriptionCount = (u32)desc.input_layout.bindings.size();
-                    vertex_input.pVertexBindingDescriptions = descs;
-                }
-                if (desc.input_layout.attributes.empty())
-                {
-                    vertex_input.vertexAttributeDescriptionCount = 0;
-                    vertex_input.pVertexAttributeDescriptions = nullptr;
-                }
-                else
-                {
-                    VkVertexInputAttributeDescription* descs = (VkVertexInputAttributeDescription*)alloca(
-                        sizeof(VkVertexInputAttributeDescription) * desc.input_layout.attributes.size());
-                    memzero(descs, sizeof(VkVertexInputAttributeDescription) * desc.input_layout.attributes.size());
-                    for (usize i = 0; i < desc.input_layout.attributes.size(); ++i)
-                    {
-                        auto& dst = descs[i];
-                        auto& src = desc.input_layout.attributes[i];
-                        dst.location = src.location;
-                        dst.binding = src.binding_slot;
-                        dst.format = encode_format(src.format);
-                        dst.offset = src.offset;
-                    }
-                    vertex_input.vertexAttributeDescriptionCount = (u32)desc.input_layout.attributes.size();
-                    vertex_input.pVertexAttributeDescriptions = descs;
-                }
-                create_info.pVertexInputState = &vertex_input;
-                // input assembly.
-                VkPipelineInputAssemblyStateCreateInfo input_assembly{};
-                input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
-                input_assembly.topology = encode_primitive_topology(desc.primitive_topology);
-                input_assembly.primitiveRestartEnable = desc.ib_strip_cut_value == IndexBufferStripCutValue::disabled ? VK_FALSE : VK_TRUE;
-                create_info.pInputAssemblyState = &input_assembly;
-                // tessllation
-                create_info.pTessellationState = nullptr;
                 // viewports.
                 VkPipelineViewportStateCreateInfo viewport{};
                 viewport.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
-                viewport.viewportCount = m_device->m_physical_device_properties.limits.maxViewports;
-                viewport.scissorCount = m_device->m_physical_device_properties.limits.maxViewports;
+                viewport.viewportCount = device->m_physical_device_properties.limits.maxViewports;
+                viewport.scissorCount = device->m_physical_device_properties.limits.maxViewports;
                 create_info.pViewportState = &viewport;
                 // rasterization
                 VkPipelineRasterizationStateCreateInfo rasterizer{};
@@ -252,12 +146,14 @@ namespace Luna
                     VK_DYNAMIC_STATE_VIEWPORT,
                     VK_DYNAMIC_STATE_SCISSOR,
                     VK_DYNAMIC_STATE_BLEND_CONSTANTS,
-                    VK_DYNAMIC_STATE_STENCIL_REFERENCE
+                    VK_DYNAMIC_STATE_STENCIL_REFERENCE,
+                    VK_DYNAMIC_STATE_FRAGMENT_SHADING_RATE_KHR
                 };
                 VkPipelineDynamicStateCreateInfo synamic_state_create_info{};
                 synamic_state_create_info.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO;
                 synamic_state_create_info.pDynamicStates = dynamic_states;
-                synamic_state_create_info.dynamicStateCount = 4;
+                // The fragment shading rate state can only be used if VK_KHR_fragment_shading_rate is enabled.
+                synamic_state_create_info.dynamicStateCount = device->m_supports_fragment_shading_rate ? 5 : 4;
                 create_info.pDynamicState = &synamic_state_create_info;
                 // pipeline layout.
                 PipelineLayout* playout = (PipelineLayout*)desc.pipeline_layout->get_object();
@@ -281,11 +177,160 @@ namespace Luna
                 }
                 render_pass.sample_count = (u8)desc.sample_count;
                 render_pass.depth_stencil_read_only = !desc.depth_stencil_state.depth_write_enable;
-                LockGuard guard(m_device->m_render_pass_pool_lock);
-                luset(create_info.renderPass, m_device->m_render_pass_pool.get_render_pass(render_pass));
+                LockGuard guard(device->m_render_pass_pool_lock);
+                luset(create_info.renderPass, device->m_render_pass_pool.get_render_pass(render_pass));
                 guard.unlock();
                 create_info.subpass = 0;
-                luexp(encode_vk_result(m_device->m_funcs.vkCreateGraphicsPipelines(m_device->m_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &m_pipeline)));
+                luexp(encode_vk_result(device->m_funcs.vkCreateGraphicsPipelines(device->m_device, get_vk_pipeline_cache(desc.pipeline_cache), 1, &create_info, nullptr, &pipeline)));
+            }
+            lucatchret;
+            return ok;
+        }
+        RV load_shader_stage(Device* device, const ShaderData& data, VkShaderStageFlagBits stage, const c8* stage_name,
+            ShaderModule& shader_module, VkPipelineShaderStageCreateInfo* stages, u32& num_stages)
+        {
+            if (data.format != ShaderDataFormat::spirv)
+            {
+                return set_error(BasicError::bad_arguments(), "The data format of %s shader must be ShaderDataFormat::spirv for Vulkan backend!", stage_name);
+            }
+            if (data.data.empty())
+            {
+                return set_error(BasicError::bad_arguments(), "The %s shader data is empty.", stage_name);
+            }
+            lutry
+            {
+                luexp(shader_module.init(device, data.data));
+                auto& dst = stages[num_stages];
+                dst.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                dst.stage = stage;
+                dst.module = shader_module.shader_module;
+                dst.pName = data.entry_point.c_str();
+                dst.flags = 0;
+                dst.pSpecializationInfo = nullptr;
+                ++num_stages;
+            }
+            lucatchret;
+            return ok;
+        }
+        RV PipelineState::init_as_graphics(const GraphicsPipelineStateDesc& desc)
+        {
+            lutry
+            {
+                VkGraphicsPipelineCreateInfo create_info{};
+                create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                create_info.flags = 0;
+                // vs, hs, ds, gs, ps.
+                VkPipelineShaderStageCreateInfo stages[5] = { {} };
+                VkShaderModule shader_modles[5] = { VK_NULL_HANDLE };
+                u32 num_stages = 0;
+                ShaderModule vs;
+                ShaderModule ps;
+                if(desc.vs.format != ShaderDataFormat::none)
+                {
+                    if(desc.vs.format != ShaderDataFormat::spirv)
+                    {
+                        return set_error(BasicError::bad_arguments(), "The data format of vertex shader must be ShaderDataFormat::spirv for Vulkan backend!");
+                    }
+                    if(desc.vs.data.empty())
+                    {
+                        return set_error(BasicError::bad_arguments(), "The vertex shader data is empty.");
+                    }
+                    luexp(vs.init(m_device, desc.vs.data));
+                    shader_modles[num_stages] = vs.shader_module;
+                    auto& dst = stages[num_stages];
+                    dst.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                    dst.stage = VK_SHADER_STAGE_VERTEX_BIT;
+                    dst.module = shader_modles[num_stages];
+                    dst.pName = desc.vs.entry_point.c_str();
+                    dst.flags = 0;
+                    dst.pSpecializationInfo = nullptr;
+                    ++num_stages;
+                }
+                if (desc.ps.format != ShaderDataFormat::none)
+                {
+                    if(desc.ps.format != ShaderDataFormat::spirv)
+                    {
+                        return set_error(BasicError::bad_arguments(), "The data format of pixel shader must be ShaderDataFormat::spirv for Vulkan backend!");
+                    }
+                    if(desc.ps.data.empty())
+                    {
+                        return set_error(BasicError::bad_arguments(), "The pixel shader data is empty.");
+                    }
+                    luexp(ps.init(m_device, desc.ps.data));
+                    shader_modles[num_stages] = ps.shader_module;
+                    auto& dst = stages[num_stages];
+                    dst.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+                    dst.stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+                    dst.module = shader_modles[num_stages];
+                    dst.pName = desc.ps.entry_point.c_str();
+                    dst.flags = 0;
+                    dst.pSpecializationInfo = nullptr;
+                    ++num_stages;
+                }
+                create_info.pStages = stages;
+                create_info.stageCount = num_stages;
+                // Vertex input.
+                VkPipelineVertexInputStateCreateInfo vertex_input{};
+                vertex_input.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
+                if (desc.input_layout.bindings.empty())
+                {
+                    vertex_input.vertexBindingDescriptionCount = 0;
+                    vertex_input.pVertexBindingDescriptions = nullptr;
+                }
+                else
+                {
+                    VkVertexInputBindingDescription* descs = (VkVertexInputBindingDescription*)alloca(
+                        sizeof(VkVertexInputBindingDescription) * desc.input_layout.bindings.size());
+                    memzero(descs, sizeof(VkVertexInputBindingDescription) * desc.input_layout.bindings.size());
+                    for (usize i = 0; i < desc.input_layout.bindings.size(); ++i)
+                    {
+                        auto& dst = descs[i];
+                        auto& src = desc.input_layout.bindings[i];
+                        dst.binding = src.binding_slot;
+                        dst.stride = src.element_size;
+                        switch (src.input_rate)
+                        {
+                        case InputRate::per_vertex:
+                            dst.inputRate = VK_VERTEX_INPUT_RATE_VERTEX; break;
+                        case InputRate::per_instance:
+                            dst.inputRate = VK_VERTEX_INPUT_RATE_INSTANCE; break;
+                        }
+                    }
+                    vertex_input.vertexBindingDescriptionCount = (u32)desc.input_layout.bindings.size();
+                    vertex_input.pVertexBindingDescriptions = descs;
+                }
+                if (desc.input_layout.attributes.empty())
+                {
+                    vertex_input.vertexAttributeDescriptionCount = 0;
+                    vertex_input.pVertexAttributeDescriptions = nullptr;
+                }
+                else
+                {
+                    VkVertexInputAttributeDescription* descs = (VkVertexInputAttributeDescription*)alloca(
+                        sizeof(VkVertexInputAttributeDescription) * desc.input_layout.attributes.size());
+                    memzero(descs, sizeof(VkVertexInputAttributeDescription) * desc.input_layout.attributes.size());
+                    for (usize i = 0; i < desc.input_layout.attributes.size(); ++i)
+                    {
+                        auto& dst = descs[i];
+                        auto& src = desc.input_layout.attributes[i];
+                        dst.location = src.location;
+                        dst.binding = src.binding_slot;
+                        dst.format = encode_format(src.format);
+                        dst.offset = src.offset;
+                    }
+                    vertex_input.vertexAttributeDescriptionCount = (u32)desc.input_layout.attributes.size();
+                    vertex_input.pVertexAttributeDescriptions = descs;
+                }
+                create_info.pVertexInputState = &vertex_input;
+                // input assembly.
+                VkPipelineInputAssemblyStateCreateInfo input_assembly{};
+                input_assembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
+                input_assembly.topology = encode_primitive_topology(desc.primitive_topology);
+                input_assembly.primitiveRestartEnable = desc.ib_strip_cut_value == IndexBufferStripCutValue::disabled ? VK_FALSE : VK_TRUE;
+                create_info.pInputAssemblyState = &input_assembly;
+                // tessllation
+                create_info.pTessellationState = nullptr;
+                luexp(create_graphics_pipeline(m_device, create_info, desc, m_pipeline));
             }    
             lucatchret;
             return ok;
@@ -313,7 +358,40 @@ namespace Luna
                 // pipeline layout.
                 PipelineLayout* playout = (PipelineLayout*)desc.pipeline_layout->get_object();
                 create_info.layout = playout->m_pipeline_layout;
-                luexp(encode_vk_result(m_device->m_funcs.vkCreateComputePipelines(m_device->m_device, VK_NULL_HANDLE, 1, &create_info, nullptr, &m_pipeline)));
+                luexp(encode_vk_result(m_device->m_funcs.vkCreateComputePipelines(m_device->m_device, get_vk_pipeline_cache(desc.pipeline_cache), 1, &create_info, nullptr, &m_pipeline)));
+            }
+            lucatchret;
+            return ok;
+        }
+        RV PipelineState::init_as_mesh(const MeshPipelineStateDesc& desc)
+        {
+            lutry
+            {
+                VkGraphicsPipelineCreateInfo create_info{};
+                create_info.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+                create_info.flags = 0;
+                // task, mesh, fragment.
+                VkPipelineShaderStageCreateInfo stages[3] = { {} };
+                u32 num_stages = 0;
+                ShaderModule as;
+                ShaderModule ms;
+                ShaderModule ps;
+                if (desc.as.format != ShaderDataFormat::none)
+                {
+                    luexp(load_shader_stage(m_device, desc.as, VK_SHADER_STAGE_TASK_BIT_EXT, "amplification", as, stages, num_stages));
+                }
+                luexp(load_shader_stage(m_device, desc.ms, VK_SHADER_STAGE_MESH_BIT_EXT, "mesh", ms, stages, num_stages));
+                if (desc.ps.format != ShaderDataFormat::none)
+                {
+                    luexp(load_shader_stage(m_device, desc.ps, VK_SHADER_STAGE_FRAGMENT_BIT, "pixel", ps, stages, num_stages));
+                }
+                create_info.pStages = stages;
+                create_info.stageCount = num_stages;
+                // Vertex input and input assembly states are ignored by mesh pipelines.
+                create_info.pVertexInputState = nullptr;
+                create_info.pInputAssemblyState = nullptr;
+                create_info.pTessellationState = nullptr;
+                luexp(create_graphics_pipeline(m_device, create_info, desc, m_pipeline));
             }
             lucatchret;
             return ok;
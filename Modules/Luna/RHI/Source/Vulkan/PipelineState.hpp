@@ -25,6 +25,7 @@ namespace Luna
 
             RV init_as_graphics(const GraphicsPipelineStateDesc& desc);
             RV init_as_compute(const ComputePipelineStateDesc& desc);
+            RV init_as_mesh(const MeshPipelineStateDesc& desc);
             ~PipelineState();
 
             virtual IDevice* get_device() override { return m_device.get(); }
@@ -51,17 +51,17 @@ namespace Luna
     {
         usize operator()(const RHI::RenderPassKey& k) const
         {
-            usize h = memhash<usize>(k.color_formats, sizeof(RHI::Format) * 8);
-            h = memhash<usize>(k.resolve_formats, sizeof(RHI::Format) * 8, h);
-            h = memhash<usize>(&k.depth_stencil_format, sizeof(RHI::Format), h);
-            h = memhash<usize>(k.color_load_ops, sizeof(RHI::LoadOp) * 8, h);
-            h = memhash<usize>(k.color_store_ops, sizeof(RHI::StoreOp) * 8, h);
-            h = memhash<usize>(&k.depth_load_op, sizeof(RHI::LoadOp), h);
-            h = memhash<usize>(&k.depth_store_op, sizeof(RHI::StoreOp), h);
-            h = memhash<usize>(&k.stencil_load_op, sizeof(RHI::LoadOp), h);
-            h = memhash<usize>(&k.stencil_store_op, sizeof(RHI::StoreOp), h);
-            h = memhash<usize>(&k.sample_count, sizeof(u8), h);
-            return h;
+            u64 h = wyhash(k.color_formats, sizeof(RHI::Format) * 8);
+            h = wyhash(k.resolve_formats, sizeof(RHI::Format) * 8, h);
+            h = wyhash(&k.depth_stencil_format, sizeof(RHI::Format), h);
+            h = wyhash(k.color_load_ops, sizeof(RHI::LoadOp) * 8, h);
+            h = wyhash(k.color_store_ops, sizeof(RHI::StoreOp) * 8, h);
+            h = wyhash(&k.depth_load_op, sizeof(RHI::LoadOp), h);
+            h = wyhash(&k.depth_store_op, sizeof(RHI::StoreOp), h);
+            h = wyhash(&k.stencil_load_op, sizeof(RHI::LoadOp), h);
+            h = wyhash(&k.stencil_store_op, sizeof(RHI::StoreOp), h);
+            h = wyhash(&k.sample_count, sizeof(u8), h);
+            return (usize)h;
         }
     };
 
@@ -28,6 +28,7 @@ namespace Luna
                 memory->m_memory_type = memory_type;
                 m_memory = memory;
                 luexp(encode_vk_result(vmaCreateBuffer(m_device->m_allocator, &create_info, &allocation, &m_buffer, &m_memory->m_allocation, &m_memory->m_allocation_info)));
+                m_device->m_statistics.on_memory_allocated(m_device, memory_type, m_memory->get_size());
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
                 memory_profiler_allocate(&m_memory->m_allocation, m_memory->get_size());
                 memory_profiler_set_memory_domain(&m_memory->m_allocation, "GPU", 3);
@@ -68,8 +69,28 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        RV BufferResource::init_as_reserved(const BufferDesc& desc)
+        {
+            lutry
+            {
+                m_desc = desc;
+                VkBufferCreateInfo create_info{};
+                encode_buffer_create_info(create_info, m_desc);
+                create_info.flags |= VK_BUFFER_CREATE_SPARSE_BINDING_BIT | VK_BUFFER_CREATE_SPARSE_RESIDENCY_BIT;
+                luexp(encode_vk_result(m_device->m_funcs.vkCreateBuffer(m_device->m_device, &create_info, nullptr, &m_buffer)));
+                VkMemoryRequirements memory_requirements;
+                m_device->m_funcs.vkGetBufferMemoryRequirements(m_device->m_device, m_buffer, &memory_requirements);
+                if (memory_requirements.alignment != RESERVED_RESOURCE_TILE_SIZE)
+                {
+                    return BasicError::not_supported();
+                }
+            }
+            lucatchret;
+            return ok;
+        }
         BufferResource::~BufferResource()
         {
+            m_device->m_statistics.on_buffer_destroyed();
             if (m_buffer != VK_NULL_HANDLE)
             {
                 m_device->m_funcs.vkDestroyBuffer(m_device->m_device, m_buffer, nullptr);
@@ -152,6 +173,7 @@ namespace Luna
                 memory->m_memory_type = memory_type;
                 m_memory = memory;
                 luexp(encode_vk_result(vmaCreateImage(m_device->m_allocator, &create_info, &allocation, &m_image, &m_memory->m_allocation, &m_memory->m_allocation_info)));
+                m_device->m_statistics.on_memory_allocated(m_device, memory_type, m_memory->get_size());
                 post_init();
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
                 memory_profiler_allocate(&m_memory->m_allocation, m_memory->get_size());
@@ -195,8 +217,46 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        RV ImageResource::init_as_reserved(const TextureDesc& desc)
+        {
+            lutry
+            {
+                m_desc = desc;
+                luexp(validate_texture_desc(m_desc));
+                VkImageCreateInfo create_info{};
+                encode_image_create_info(create_info, m_desc);
+                create_info.flags |= VK_IMAGE_CREATE_SPARSE_BINDING_BIT | VK_IMAGE_CREATE_SPARSE_RESIDENCY_BIT;
+                luexp(encode_vk_result(m_device->m_funcs.vkCreateImage(m_device->m_device, &create_info, nullptr, &m_image)));
+                m_is_reserved = true;
+                VkMemoryRequirements memory_requirements;
+                m_device->m_funcs.vkGetImageMemoryRequirements(m_device->m_device, m_image, &memory_requirements);
+                if (memory_requirements.alignment != RESERVED_RESOURCE_TILE_SIZE)
+                {
+                    return BasicError::not_supported();
+                }
+                u32 num_requirements = 0;
+                m_device->m_funcs.vkGetImageSparseMemoryRequirements(m_device->m_device, m_image, &num_requirements, nullptr);
+                Vector<VkSparseImageMemoryRequirements> requirements(num_requirements);
+                m_device->m_funcs.vkGetImageSparseMemoryRequirements(m_device->m_device, m_image, &num_requirements, requirements.data());
+                bool found = false;
+                for (auto& r : requirements)
+                {
+                    if (r.formatProperties.aspectMask & VK_IMAGE_ASPECT_COLOR_BIT)
+                    {
+                        m_sparse_requirements = r;
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) return BasicError::not_supported();
+                post_init();
+            }
+            lucatchret;
+            return ok;
+        }
         ImageResource::~ImageResource()
         {
+            m_device->m_statistics.on_texture_destroyed();
             if (m_image != VK_NULL_HANDLE && !m_is_image_externally_managed)
             {
                 m_device->m_funcs.vkDestroyImage(m_device->m_device, m_image, nullptr);
@@ -30,6 +30,7 @@ namespace Luna
 
             RV init_as_committed(MemoryType memory_type, const BufferDesc& desc);
             RV init_as_aliasing(const BufferDesc& desc, DeviceMemory* memory);
+            RV init_as_reserved(const BufferDesc& desc);
             ~BufferResource();
 
             virtual IDevice* get_device() override { return m_device.get(); }
@@ -69,11 +70,17 @@ namespace Luna
             // true if this is a swap chain resource.
             bool m_is_image_externally_managed = false;
 
+            // true if this is a reserved resource, whose memory is bound in tiles.
+            bool m_is_reserved = false;
+            // The sparse memory requirements of the color aspect. Valid only for reserved resources.
+            VkSparseImageMemoryRequirements m_sparse_requirements;
+
             R<ImageView*> get_image_view(const TextureViewDesc& create_info);
 
             void post_init();
             RV init_as_committed(MemoryType memory_type, const TextureDesc& desc);
             RV init_as_aliasing(const TextureDesc& desc, DeviceMemory* memory);
+            RV init_as_reserved(const TextureDesc& desc);
             ~ImageResource();
 
             u32 count_subresources() const
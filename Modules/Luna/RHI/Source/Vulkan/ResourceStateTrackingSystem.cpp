@@ -13,9 +13,23 @@ namespace Luna
 {
     namespace RHI
     {
+        constexpr VkAccessFlags WRITE_ACCESS_FLAGS = VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT |
+            VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT | VK_ACCESS_HOST_WRITE_BIT | VK_ACCESS_MEMORY_WRITE_BIT;
+
         void ResourceStateTrackingSystem::append_buffer(BufferResource* res, VkAccessFlags before, VkAccessFlags after,
             u32 before_queue_family_index, u32 after_queue_family_index)
         {
+            auto iter = m_buffer_barrier_indices.find(res);
+            if (iter != m_buffer_barrier_indices.end() && 
+                before_queue_family_index == VK_QUEUE_FAMILY_IGNORED && after_queue_family_index == VK_QUEUE_FAMILY_IGNORED)
+            {
+                VkBufferMemoryBarrier& merged = m_buffer_barriers[iter->second];
+                if (merged.srcQueueFamilyIndex == merged.dstQueueFamilyIndex)
+                {
+                    merged.dstAccessMask = after;
+                    return;
+                }
+            }
             if (before == 0 && after == 0 && before_queue_family_index == after_queue_family_index)
             {
                 return;
@@ -29,11 +43,27 @@ namespace Luna
             barrier.buffer = res->m_buffer;
             barrier.offset = 0;
             barrier.size = VK_WHOLE_SIZE;
+            m_buffer_barrier_indices.insert_or_assign(res, m_buffer_barriers.size());
             m_buffer_barriers.push_back(barrier);
         }
         void ResourceStateTrackingSystem::append_image(ImageResource* res, const SubresourceIndex& subresource, const ImageState& before, const ImageState& after,
             u32 before_queue_family_index, u32 after_queue_family_index)
         {
+            ImageResourceKey key;
+            key.m_res = res;
+            key.m_subres = subresource;
+            auto iter = m_image_barrier_indices.find(key);
+            if (iter != m_image_barrier_indices.end() &&
+                before_queue_family_index == VK_QUEUE_FAMILY_IGNORED && after_queue_family_index == VK_QUEUE_FAMILY_IGNORED)
+            {
+                VkImageMemoryBarrier& merged = m_image_barriers[iter->second];
+                if (merged.srcQueueFamilyIndex == merged.dstQueueFamilyIndex)
+                {
+                    merged.dstAccessMask = after.access_flags;
+                    merged.newLayout = after.image_layout;
+                    return;
+                }
+            }
             if (before.access_flags == 0 && after.access_flags == 0
                 && before.image_layout == after.image_layout
                 && before_queue_family_index == after_queue_family_index)
@@ -65,6 +95,7 @@ namespace Luna
             barrier.subresourceRange.baseArrayLayer = subresource.array_slice;
             barrier.subresourceRange.levelCount = 1;
             barrier.subresourceRange.layerCount = 1;
+            m_image_barrier_indices.insert_or_assign(key, m_image_barriers.size());
             m_image_barriers.push_back(barrier);
         }
         void ResourceStateTrackingSystem::pack_buffer_internal(BufferResource* res, const BufferBarrier& barrier, 
@@ -208,6 +239,37 @@ namespace Luna
                 }
             }
         }
+        void ResourceStateTrackingSystem::remove_redundant_barriers()
+        {
+            // Read-to-read transitions without layout changes do not need synchronization, while same-state barriers 
+            // that contain write accesses are kept, since they order successive writes.
+            auto is_redundant = [](VkAccessFlags src, VkAccessFlags dst, u32 src_queue, u32 dst_queue)
+            {
+                return src == dst && !(src & WRITE_ACCESS_FLAGS) && src_queue == dst_queue;
+            };
+            usize i = 0;
+            while (i < m_buffer_barriers.size())
+            {
+                auto& b = m_buffer_barriers[i];
+                if (is_redundant(b.srcAccessMask, b.dstAccessMask, b.srcQueueFamilyIndex, b.dstQueueFamilyIndex))
+                {
+                    m_buffer_barriers.erase(m_buffer_barriers.begin() + i);
+                }
+                else ++i;
+            }
+            i = 0;
+            while (i < m_image_barriers.size())
+            {
+                auto& b = m_image_barriers[i];
+                if (b.oldLayout == b.newLayout && is_redundant(b.srcAccessMask, b.dstAccessMask, b.srcQueueFamilyIndex, b.dstQueueFamilyIndex))
+                {
+                    m_image_barriers.erase(m_image_barriers.begin() + i);
+                }
+                else ++i;
+            }
+            m_buffer_barrier_indices.clear();
+            m_image_barrier_indices.clear();
+        }
         void ResourceStateTrackingSystem::resolve()
         {
             begin_new_barriers_batch();
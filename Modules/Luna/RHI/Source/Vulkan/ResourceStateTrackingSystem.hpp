@@ -84,6 +84,10 @@ namespace Luna
 
             Vector<VkBufferMemoryBarrier> m_buffer_barriers;
             Vector<VkImageMemoryBarrier> m_image_barriers;
+            //! The index of the barrier of every resource in the current batch. Successive transitions of one resource
+            //! in the same batch are merged into one barrier, since the resource is not accessed between them.
+            HashMap<BufferResource*, usize> m_buffer_barrier_indices;
+            HashMap<ImageResourceKey, usize> m_image_barrier_indices;
             VkPipelineStageFlags m_src_stage_flags = 0;
             VkPipelineStageFlags m_dst_stage_flags = 0;
             HashMap<u32, QueueTransferBarriers> m_queue_transfer_barriers;
@@ -96,12 +100,15 @@ namespace Luna
                 m_unresolved_image_states.clear();
                 m_current_buffer_states.clear();
                 m_current_image_states.clear();
+                begin_new_barriers_batch();
             }
 
             void begin_new_barriers_batch()
             {
                 m_buffer_barriers.clear();
                 m_image_barriers.clear();
+                m_buffer_barrier_indices.clear();
+                m_image_barrier_indices.clear();
                 m_src_stage_flags = 0;
                 m_dst_stage_flags = 0;
                 m_queue_transfer_barriers.clear();
@@ -140,6 +147,9 @@ namespace Luna
             void pack_buffer(const BufferBarrier& barrier);
             void pack_image(const TextureBarrier& barrier);
 
+            //! Removes barriers that do not change the layout and only synchronize read accesses from the current batch.
+            void remove_redundant_barriers();
+
             //! Resolves all unresolved transitions into m_transitions based on their current state.
             void resolve();
 
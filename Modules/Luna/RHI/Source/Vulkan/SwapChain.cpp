@@ -85,6 +85,16 @@ namespace Luna
                 m_device->m_funcs.vkDestroySwapchainKHR(m_device->m_device, m_swap_chain, nullptr);
                 m_swap_chain = VK_NULL_HANDLE;
             }
+            clean_up_frame_fences();
+        }
+        void SwapChain::clean_up_frame_fences()
+        {
+            for (VkFence fence : m_frame_fences)
+            {
+                m_device->m_funcs.vkDestroyFence(m_device->m_device, fence, nullptr);
+            }
+            m_frame_fences.clear();
+            m_frame_fence_index = 0;
         }
         RV SwapChain::create_swap_chain(const SwapChainDesc& desc)
         {
@@ -141,6 +151,7 @@ namespace Luna
                 {
                     auto res = new_object<ImageResource>();
                     res->m_device = m_device;
+                    m_device->m_statistics.on_texture_created();
                     res->m_desc = desc;
                     res->m_image = images[i];
                     res->m_global_states.emplace_back();
@@ -148,6 +159,22 @@ namespace Luna
                     m_swap_chain_images.push_back(res);
                 }
                 m_back_buffer_fetched = false;
+                // Present IDs are counted per swap chain.
+                m_present_id = 0;
+                if (!m_device->m_supports_present_wait)
+                {
+                    // Fences are created in signaled state so that waiting for frames that are not presented returns immediately.
+                    VkFenceCreateInfo fence_create_info{};
+                    fence_create_info.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+                    fence_create_info.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+                    u32 num_fences = get_max_frame_latency(m_desc);
+                    for (u32 i = 0; i < num_fences; ++i)
+                    {
+                        VkFence fence;
+                        luexp(encode_vk_result(m_device->m_funcs.vkCreateFence(m_device->m_device, &fence_create_info, nullptr, &fence)));
+                        m_frame_fences.push_back(fence);
+                    }
+                }
             }
             lucatchret;
             return ok;
@@ -198,15 +225,43 @@ namespace Luna
                     // To fetch m_current_back_buffer
                     lulet(back_buffer, get_current_back_buffer());
                 }
+                u64 begin_time = get_ticks();
                 VkPresentInfoKHR present_info{};
                 present_info.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
                 present_info.waitSemaphoreCount = 0;
                 present_info.swapchainCount = 1;
                 present_info.pSwapchains = &m_swap_chain;
                 present_info.pImageIndices = &m_current_back_buffer;
+                VkPresentIdKHR present_id{};
+                u64 present_id_value = m_present_id + 1;
+                if (m_device->m_supports_present_wait)
+                {
+                    present_id.sType = VK_STRUCTURE_TYPE_PRESENT_ID_KHR;
+                    present_id.swapchainCount = 1;
+                    present_id.pPresentIds = &present_id_value;
+                    present_info.pNext = &present_id;
+                }
+                else
+                {
+                    // The fence is waited here if `wait_for_next_frame` is not called since the fence is submitted.
+                    VkFence fence = m_frame_fences[m_frame_fence_index];
+                    luexp(encode_vk_result(m_device->m_funcs.vkWaitForFences(m_device->m_device, 1, &fence, VK_TRUE, UINT64_MAX)));
+                    luexp(encode_vk_result(m_device->m_funcs.vkResetFences(m_device->m_device, 1, &fence)));
+                }
                 MutexGuard guard(m_queue.queue_mtx);
-                luexp(encode_vk_result(m_device->m_funcs.vkQueuePresentKHR(m_queue.queue, &present_info)));
+                auto present_r = encode_vk_result(m_device->m_funcs.vkQueuePresentKHR(m_queue.queue, &present_info));
+                if (!m_device->m_supports_present_wait)
+                {
+                    // One empty submission signals the fence when all work submitted before presenting is finished.
+                    // The fence is submitted even if presenting fails, so that it will not be waited forever.
+                    luexp(encode_vk_result(m_device->m_funcs.vkQueueSubmit(m_queue.queue, 0, nullptr, m_frame_fences[m_frame_fence_index])));
+                    m_frame_fence_index = (m_frame_fence_index + 1) % (u32)m_frame_fences.size();
+                }
+                guard.unlock();
+                luexp(present_r);
                 m_back_buffer_fetched = false;
+                m_present_id = present_id_value;
+                on_present(begin_time, get_ticks());
             }
             lucatchret;
             return ok;
@@ -227,5 +282,28 @@ namespace Luna
             lucatchret;
             return ok;
         }
+        RV SwapChain::wait_for_next_frame()
+        {
+            u64 begin_time = get_ticks();
+            VkResult r = VK_SUCCESS;
+            // Waits at most one second, so that the application is not blocked when the window is not visible.
+            constexpr u64 timeout = 1000000000;
+            if (m_device->m_supports_present_wait)
+            {
+                // Waits until at most `max_frame_latency - 1` presented frames are not displayed.
+                u32 max_frame_latency = get_max_frame_latency(m_desc);
+                if (m_present_id >= max_frame_latency)
+                {
+                    r = m_device->m_funcs.vkWaitForPresentKHR(m_device->m_device, m_swap_chain, m_present_id - max_frame_latency + 1, timeout);
+                }
+            }
+            else if (!m_frame_fences.empty())
+            {
+                r = m_device->m_funcs.vkWaitForFences(m_device->m_device, 1, &m_frame_fences[m_frame_fence_index], VK_TRUE, timeout);
+            }
+            on_wait(begin_time, get_ticks());
+            if (r == VK_TIMEOUT) return ok;
+            return encode_vk_result(r);
+        }
     }
-}
\ No newline at end of file
+}
@@ -15,7 +15,7 @@ namespace Luna
 {
     namespace RHI
     {
-        struct SwapChain : ISwapChain
+        struct SwapChain : ISwapChain, SwapChainStatsCounters
         {
             lustruct("RHI::SwapChain", "{E62614A8-3AB3-46D1-8DD8-80671C571FBC}");
             luiimpl();
@@ -36,9 +36,16 @@ namespace Luna
             u32 m_current_back_buffer;
             bool m_back_buffer_fetched = false;
 
+            // The ID of the last presented frame, used if `VK_KHR_present_wait` is supported.
+            u64 m_present_id = 0;
+            // Fences signaled when the GPU finishes work submitted before presenting, used if `VK_KHR_present_wait` is not supported.
+            Vector<VkFence> m_frame_fences;
+            u32 m_frame_fence_index = 0;
+
             RV init(const CommandQueue& queue, Window::IWindow* window, const SwapChainDesc& desc);
             
             void clean_up_swap_chain();
+            void clean_up_frame_fences();
             RV create_swap_chain(const SwapChainDesc& desc);
             
             ~SwapChain();
@@ -50,6 +57,8 @@ namespace Luna
             virtual R<ITexture*> get_current_back_buffer() override;
             virtual RV present() override;
             virtual RV reset(const SwapChainDesc& desc) override;
+            virtual RV wait_for_next_frame() override;
+            virtual SwapChainStats get_stats() override { return m_stats; }
         };
     }
 }
\ No newline at end of file
@@ -17,14 +17,17 @@
 #include "CommandBuffer.hpp"
 #include "DescriptorSet.hpp"
 #include "DescriptorSetLayout.hpp"
+#include "DescriptorSetArena.hpp"
 #include "Device.hpp"
 #include "Fence.hpp"
 #include "PipelineState.hpp"
+#include "PipelineCache.hpp"
 #include "QueryHeap.hpp"
 #include "Resource.hpp"
 #include "Sampler.hpp"
 #include "PipelineLayout.hpp"
 #include "SwapChain.hpp"
+#include "AccelerationStructure.hpp"
 namespace Luna
 {
     namespace RHI
@@ -35,6 +38,8 @@ namespace Luna
             Ref<Window::IWindow> dummy_window;
             lutry
             {
+                register_boxed_type<AccelerationStructure>();
+                impl_interface_for_type<AccelerationStructure, IAccelerationStructure, IDeviceChild>();
                 register_boxed_type<Adapter>();
                 impl_interface_for_type<Adapter, IAdapter>();
                 register_boxed_type<CommandBuffer>();
@@ -43,6 +48,8 @@ namespace Luna
                 impl_interface_for_type<DescriptorSet, IDescriptorSet, IDeviceChild>();
                 register_boxed_type<DescriptorSetLayout>();
                 impl_interface_for_type<DescriptorSetLayout, IDescriptorSetLayout, IDeviceChild>();
+                register_boxed_type<DescriptorSetArena>();
+                impl_interface_for_type<DescriptorSetArena, IDescriptorSetArena, IDeviceChild>();
                 register_boxed_type<Device>();
                 impl_interface_for_type<Device, IDevice>();
                 register_boxed_type<DeviceMemory>();
@@ -52,6 +59,8 @@ namespace Luna
                 register_boxed_type<ImageView>();
                 register_boxed_type<PipelineState>();
                 impl_interface_for_type<PipelineState, IPipelineState, IDeviceChild>();
+                register_boxed_type<PipelineCache>();
+                impl_interface_for_type<PipelineCache, IPipelineCache, IDeviceChild>();
                 register_boxed_type<QueryHeap>();
                 impl_interface_for_type<QueryHeap, IQueryHeap, IDeviceChild>();
                 register_boxed_type<BufferResource>();
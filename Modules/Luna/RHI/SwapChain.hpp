@@ -34,6 +34,10 @@ namespace Luna
             Format format;
             //! Whether to synchronize frame image presentation to vertical blanks of the monitor.
             bool vertical_synchronized;
+            //! The maximum number of frames that can be queued for presenting, which is waited by @ref ISwapChain::wait_for_next_frame.
+            //! @details Smaller values reduce the latency between rendering one frame and displaying it, but may cause the GPU to 
+            //! idle between frames. Specify 0 to use `buffer_count - 1`, with a minimum of 1.
+            u32 max_frame_latency;
 
             SwapChainDesc() = default;
             SwapChainDesc(
@@ -41,13 +45,39 @@ namespace Luna
                 u32 height,
                 u32 buffer_count,
                 Format format,
-                bool vertical_synchronized
+                bool vertical_synchronized,
+                u32 max_frame_latency = 0
             ) :
                 width(width),
                 height(height),
                 buffer_count(buffer_count),
                 format(format),
-                vertical_synchronized(vertical_synchronized) {}
+                vertical_synchronized(vertical_synchronized),
+                max_frame_latency(max_frame_latency) {}
+        };
+
+        //! Gets the maximum frame latency used by one swap chain.
+        inline u32 get_max_frame_latency(const SwapChainDesc& desc)
+        {
+            if (desc.max_frame_latency) return desc.max_frame_latency;
+            return desc.buffer_count > 2 ? desc.buffer_count - 1 : 1;
+        }
+
+        //! Describes presenting statistics of one swap chain. All time values are in ticks returned by @ref get_ticks.
+        struct SwapChainStats
+        {
+            //! The number of frames presented since the swap chain is created.
+            u64 num_presents;
+            //! The time when the last @ref ISwapChain::present call returns.
+            u64 last_present_time;
+            //! The time between the last two @ref ISwapChain::present calls.
+            u64 last_present_interval;
+            //! The time spent in the last @ref ISwapChain::present call.
+            u64 last_present_duration;
+            //! The time the last @ref ISwapChain::wait_for_next_frame call blocks the thread.
+            u64 last_wait_duration;
+            //! The total time that @ref ISwapChain::wait_for_next_frame calls block the thread.
+            u64 total_wait_duration;
         };
 
         //! @interface ISwapChain
@@ -78,6 +108,20 @@ namespace Luna
             //! The user must ensure that all writes to the current back buffer is completed before calling `present` to present the back buffer.
             virtual RV present() = 0;
 
+            //! Blocks the current thread until the number of frames queued for presenting is smaller than 
+            //! @ref SwapChainDesc::max_frame_latency, so that one new frame can be rendered without being queued behind other frames.
+            //! @details Calling this at the beginning of every frame, before input is sampled, minimizes the latency between sampling input 
+            //! and displaying the frame that reflects the input. The following platform features are used when available:
+            //! * D3D12: the frame latency waitable object of the swap chain.
+            //! * Vulkan: `VK_KHR_present_wait`, which waits until frames are actually displayed. If the extension is not supported,
+            //! the function waits for the GPU to finish the work submitted before presenting the frame.
+            //! * Metal: the completion of command buffers that present drawables. The number of drawables is also limited by 
+            //! @ref SwapChainDesc::buffer_count.
+            virtual RV wait_for_next_frame() = 0;
+
+            //! Gets presenting statistics of the swap chain.
+            virtual SwapChainStats get_stats() = 0;
+
             //! Resets the swap chain.
             //! @param[in] desc The new swap chain descriptor object.
             virtual RV reset(const SwapChainDesc& desc) = 0;
@@ -306,6 +306,9 @@ namespace Luna
             resolve_attachment = 0x40,
             //! Allows this texture to be bound as a texture cube view.
             cube = 0x80,
+            //! Allows this texture to be bound as the shading rate image of one render pass.
+            //! See @ref RenderPassDesc::shading_rate_image for details.
+            shading_rate_image = 0x100,
         };
 
         //! Describes one texture resource.
@@ -0,0 +1,124 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file UploadManager.hpp
+* @author JXMaster
+* @date 2024/4/6
+* @brief The upload manager uploads resource data asynchronously using one copy command queue.
+*/
+#pragma once
+#include "Utility.hpp"
+#include "Device.hpp"
+#include <Luna/JobSystem/JobSystem.hpp>
+#ifndef LUNA_RHI_API
+#define LUNA_RHI_API
+#endif
+namespace Luna
+{
+    namespace RHI
+    {
+        //! @addtogroup RHI
+        //! @{
+
+        //! Describes one upload manager.
+        struct UploadManagerDesc
+        {
+            //! The index of the command queue used to submit copy commands.
+            //! If this is `U32_MAX`, the first command queue with @ref CommandQueueType::copy type is used, or the first
+            //! command queue with @ref CommandQueueType::graphics type is used if the device does not have copy queues.
+            u32 command_queue_index = U32_MAX;
+            //! The size, in bytes, of every staging buffer page. Copies larger than this size use dedicated staging buffers.
+            u64 staging_page_size = 16 * 1024 * 1024;
+            //! The maximum number of free staging buffer pages that are kept by the manager for reusing.
+            u32 max_cached_pages = 8;
+        };
+
+        //! Describes one staging memory region allocated by @ref IUploadManager::begin_texture_write.
+        struct UploadTextureWriteRegion
+        {
+            //! The pointer to the staging memory. The user should write texture data to this memory before calling
+            //! @ref IUploadManager::end_texture_write.
+            void* data;
+            //! The number of bytes to advance between every two rows of texture data in the staging memory.
+            usize row_pitch;
+            //! The number of bytes to advance between every two slices of texture data in the staging memory.
+            usize slice_pitch;
+            //! The job ID of the batch that contains this write. The job ID is finished when the batch is submitted
+            //! and completed by the GPU.
+            JobSystem::job_id_t job_id;
+            //! The batch that contains this write, used internally by the upload manager.
+            opaque_t batch;
+        };
+
+        //! @interface IUploadManager
+        //! Uploads data from host memory to buffer and texture resources asynchronously using one copy command queue.
+        //! @details Copy operations are enqueued by @ref enqueue, which copies data to staging buffers and records copy commands
+        //! immediately, so the source memory can be released after @ref enqueue returns. Enqueued copies are then submitted by @ref submit
+        //! in one batch. Every batch has one job ID that is finished when all copies in the batch are completed by the GPU, so the user can
+        //! wait for uploaded data using @ref JobSystem::wait_job, check it using @ref JobSystem::is_job_finished, or use it as one dependency 
+        //! of other jobs.
+        //! Staging buffers and command buffers are reused by succeeding batches after the batch is completed.
+        //!
+        //! Resources written by the upload manager are in @ref BufferStateFlag::copy_dest or @ref TextureStateFlag::copy_dest state when the
+        //! copy completes, use @ref BufferStateFlag::automatic or @ref TextureStateFlag::automatic as the before state when transitioning them
+        //! on other queues.
+        struct IUploadManager : virtual IDeviceChild
+        {
+            luiid("{9E3B5C71-2D84-4A6F-8C19-B07E4D2F6A53}");
+
+            //! Gets the index of the command queue used by this manager.
+            virtual u32 get_command_queue_index() = 0;
+
+            //! Enqueues copy operations to the current batch.
+            //! @param[in] copies The copy operations to enqueue. Only @ref ResourceDataCopyOp::write_buffer and
+            //! @ref ResourceDataCopyOp::write_texture are allowed.
+            //! @return Returns the job ID of the batch that contains the enqueued copies. The job ID is finished when the batch is submitted
+            //! and completed by the GPU.
+            //! @remark This function is thread-safe. Copies enqueued by multiple threads may be submitted in one batch by any thread calling
+            //! @ref submit, so every thread should wait for the job ID returned by this function rather than the one returned by @ref submit.
+            virtual R<JobSystem::job_id_t> enqueue(Span<const CopyResourceData> copies) = 0;
+
+            //! Allocates staging memory for one texture write, and enqueues the copy from the staging memory to the texture
+            //! to the current batch.
+            //! @details Unlike @ref enqueue, which copies data from user memory to the staging memory, this function lets the
+            //! user write data to the staging memory directly, for example, by decoding image files to the staging memory.
+            //! The staging memory is written without locking the manager, so multiple threads can write their data in parallel.
+            //! @param[in] dst The texture to write.
+            //! @param[in] dst_subresource The subresource of the texture to write.
+            //! @param[in] dst_x The X position of the first pixel to write.
+            //! @param[in] dst_y The Y position of the first pixel to write.
+            //! @param[in] dst_z The Z position of the first pixel to write.
+            //! @param[in] copy_width The width of the region to write.
+            //! @param[in] copy_height The height of the region to write.
+            //! @param[in] copy_depth The depth of the region to write.
+            //! @return Returns the allocated staging memory region.
+            //! @remark This function is thread-safe. Every successful call to this function must be paired with one call to
+            //! @ref end_texture_write. @ref submit blocks until all writes in the submitted batch are ended.
+            virtual R<UploadTextureWriteRegion> begin_texture_write(ITexture* dst, SubresourceIndex dst_subresource, u32 dst_x, u32 dst_y, u32 dst_z,
+                u32 copy_width, u32 copy_height, u32 copy_depth) = 0;
+
+            //! Notifies the manager that the staging memory allocated by @ref begin_texture_write is written.
+            //! @param[in] region The region returned by @ref begin_texture_write.
+            //! @remark This function is thread-safe.
+            virtual void end_texture_write(const UploadTextureWriteRegion& region) = 0;
+
+            //! Submits all copy operations enqueued since the last submission to the copy queue.
+            //! @param[in] signal_fences The fences to signal when the copies are completed. Other command queues can wait for these fences
+            //! to consume uploaded data without blocking the host.
+            //! @return Returns the job ID of the submitted batch.
+            //! Returns @ref JobSystem::INVALID_JOB_ID if no copy is enqueued and `signal_fences` is empty.
+            //! @remark This function is thread-safe.
+            virtual R<JobSystem::job_id_t> submit(Span<IFence*> signal_fences = {}) = 0;
+        };
+
+        //! Creates one new upload manager.
+        //! @param[in] device The device that owns resources to upload.
+        //! @param[in] desc The upload manager descriptor.
+        //! @return Returns the created upload manager.
+        LUNA_RHI_API R<Ref<IUploadManager>> new_upload_manager(IDevice* device, const UploadManagerDesc& desc = UploadManagerDesc());
+
+        //! @}
+    }
+}
@@ -0,0 +1,91 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file UploadRingBuffer.hpp
+* @author JXMaster
+* @date 2024/4/5
+*/
+#pragma once
+#include "Buffer.hpp"
+
+namespace Luna
+{
+    namespace RHI
+    {
+        //! @addtogroup RHI
+        //! @{
+
+        //! Describes one upload ring buffer.
+        struct UploadRingBufferDesc
+        {
+            //! The initial size, in bytes, of the upload buffer of every frame.
+            //! @details If allocations of one frame exceed this size, the ring buffer creates additional upload buffers for the frame,
+            //! and enlarges the upload buffer of the frame to hold all allocations when the frame is reused.
+            u64 frame_size = 1024 * 1024;
+            //! The number of frames that can be in flight at the same time.
+            u32 num_frames = 2;
+            //! The usages of upload buffers created by the ring buffer.
+            BufferUsageFlag usages = BufferUsageFlag::copy_source | BufferUsageFlag::uniform_buffer | BufferUsageFlag::read_buffer |
+                BufferUsageFlag::vertex_buffer | BufferUsageFlag::index_buffer;
+
+            UploadRingBufferDesc() {}
+            UploadRingBufferDesc(u64 frame_size, u32 num_frames,
+                BufferUsageFlag usages = BufferUsageFlag::copy_source | BufferUsageFlag::uniform_buffer | BufferUsageFlag::read_buffer |
+                BufferUsageFlag::vertex_buffer | BufferUsageFlag::index_buffer) :
+                frame_size(frame_size),
+                num_frames(num_frames),
+                usages(usages) {}
+        };
+
+        //! Describes one allocation from one upload ring buffer.
+        struct UploadRingBufferAllocation
+        {
+            //! The buffer that contains the allocated range. The buffer is kept alive by the ring buffer.
+            IBuffer* buffer;
+            //! The offset, in bytes, of the allocated range from the beginning of `buffer`.
+            u64 offset;
+            //! The size, in bytes, of the allocated range.
+            u64 size;
+            //! The pointer to the mapped memory of the allocated range, which can be written by the host directly.
+            void* data;
+        };
+
+        //! @interface IUploadRingBuffer
+        //! Represents one ring of persistently mapped upload buffers that can be used to allocate transient data uploaded to GPU every frame,
+        //! like uniform buffer data, dynamic vertex and index data and staging data for copy commands.
+        //! @details The ring buffer contains one upload buffer for every frame in flight. Every call to @ref begin_frame switches to the next
+        //! buffer in the ring, allocations are performed by increasing one offset in the buffer of the current frame, and are reclaimed all together
+        //! when the frame buffer is reused by @ref begin_frame after @ref UploadRingBufferDesc::num_frames frames.
+        //! Since upload buffers are mapped persistently, the user writes data to @ref UploadRingBufferAllocation::data directly without calling
+        //! @ref IBuffer::map and @ref IBuffer::unmap.
+        struct IUploadRingBuffer : virtual IDeviceChild
+        {
+            luiid("{4C1E2B8A-93D7-4F56-B0A3-6D85E2F17C94}");
+
+            //! Gets the number of frames of the ring buffer.
+            virtual u32 get_num_frames() = 0;
+
+            //! Begins one new frame and reclaims all allocations of the frame that is begun @ref UploadRingBufferDesc::num_frames
+            //! frames earlier.
+            //! @par Valid Usage
+            //! * All command buffers that use allocations of the reclaimed frame must have finished execution. This is satisfied if the user
+            //! waits for command buffers of one frame before beginning the frame that is `num_frames` frames later, or before resetting
+            //! the command buffers.
+            //! * This must not be called when other threads are calling @ref allocate.
+            virtual void begin_frame() = 0;
+
+            //! Allocates one memory range from the current frame.
+            //! @param[in] size The size, in bytes, of the range to allocate.
+            //! @param[in] alignment The alignment, in bytes, of the offset of the allocated range. This can be any non-zero value, so
+            //! that structured buffer elements can be aligned to their element size. Use @ref DeviceFeature::uniform_buffer_data_alignment
+            //! for uniform buffer data.
+            //! @return Returns the allocated range.
+            //! @remark This function is thread-safe.
+            virtual R<UploadRingBufferAllocation> allocate(u64 size, u64 alignment = 16) = 0;
+        };
+
+        //! @}
+    }
+}
@@ -8,6 +8,7 @@ option_end()
 luna_sdk_module_target("RHI")
     add_options("rhi_api", "rhi_debug")
     add_headerfiles("*.hpp", {prefixdir = "Luna/RHI"})
+    add_headerfiles("Shaders/*.hlsl", {prefixdir = "Luna/RHI/Shaders"})
     add_headerfiles("Source/*.hpp", {install = false})
     add_files("Source/*.cpp")
     if is_config("rhi_api", "D3D12") then
@@ -27,6 +28,6 @@ luna_sdk_module_target("RHI")
         add_frameworks("Foundation", "QuartzCore", "Metal")
         add_deps("VariantUtils")
     end
-    add_deps("Runtime", "Window")
+    add_deps("Runtime", "Window", "JobSystem")
 target_end()
 
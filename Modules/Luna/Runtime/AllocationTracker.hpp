@@ -0,0 +1,162 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AllocationTracker.hpp
+* @author JXMaster
+* @date 2024/5/21
+*/
+#pragma once
+#include "Span.hpp"
+
+#ifndef LUNA_RUNTIME_API
+#define LUNA_RUNTIME_API
+#endif
+
+#if (defined(LUNA_ENABLE_ALLOCATION_TRACKER) || (LUNA_DEBUG_LEVEL >= LUNA_DEBUG_LEVEL_DEBUG))
+#define LUNA_ALLOCATION_TRACKER_ENABLED
+#endif
+
+namespace Luna
+{
+    //! @addtogroup RuntimeProfiler
+    //! @{
+
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+
+    //! The maximum number of call stack frames captured for one allocation offender.
+    constexpr u32 MAX_ALLOCATION_OFFENDER_FRAMES = 32;
+
+    //! The maximum number of allocation offenders kept by the allocation tracker.
+    constexpr u32 MAX_ALLOCATION_OFFENDERS = 64;
+
+    //! The allocation statistics of one thread in one frame.
+    struct AllocationFrameStats
+    {
+        //! The index of the thread. Threads are indexed in the order they first record one allocation, starting from `0`.
+        u32 thread_index;
+        //! The number of @ref memalloc calls, including @ref memrealloc calls that allocate new memory blocks.
+        u64 num_allocations;
+        //! The number of @ref memfree calls, including @ref memrealloc calls that free old memory blocks.
+        u64 num_deallocations;
+        //! The number of bytes requested by allocations.
+        u64 allocated_bytes;
+        //! The number of objects recorded by @ref allocation_tracker_record_object_creation, like RHI resources.
+        u64 num_objects_created;
+        //! The number of allocations and object creations performed in allocation-free sections.
+        u64 num_violations;
+    };
+
+    //! Describes one allocation or object creation performed in one allocation-free section.
+    struct AllocationOffender
+    {
+        //! The index of the frame when the offender is recorded.
+        u64 frame_index;
+        //! The index of the thread that performs the allocation.
+        u32 thread_index;
+        //! The name of the innermost allocation-free section.
+        const c8* section;
+        //! The allocated size in bytes. This is `0` for object creations.
+        usize size;
+        //! The object type name for object creations, or `nullptr` for memory allocations.
+        const c8* object_type;
+        //! The number of valid frames in `frames`.
+        u32 num_frames;
+        //! The call stack frames captured when the allocation happens, which can be resolved by @ref stack_backtrace_symbols.
+        opaque_t frames[MAX_ALLOCATION_OFFENDER_FRAMES];
+    };
+
+    //! Enables or disables the allocation tracker.
+    //! @details The allocation tracker is disabled by default. When enabled, every @ref memalloc, @ref memrealloc and @ref memfree
+    //! call and every call to @ref allocation_tracker_record_object_creation is counted for the calling thread, which takes one
+    //! uncontended lock of the thread, so that counts of one frame are exact even if other threads allocate when the frame ends.
+    //! Memory allocated by the Runtime module internally is not counted.
+    //! @param[in] enabled `true` to enable the tracker, `false` to disable the tracker.
+    LUNA_RUNTIME_API void allocation_tracker_set_enabled(bool enabled);
+
+    //! Checks whether the allocation tracker is enabled.
+    LUNA_RUNTIME_API bool allocation_tracker_is_enabled();
+
+    //! Marks one frame boundary.
+    //! @details Counts of all threads since the last call to this function are saved as the statistics of the last frame, which
+    //! can be fetched by @ref allocation_tracker_get_last_frame_stats, and counts of all threads are reset. This should be called
+    //! once at the beginning of every frame.
+    LUNA_RUNTIME_API void allocation_tracker_new_frame();
+
+    //! Gets the index of the current frame, which is the number of @ref allocation_tracker_new_frame calls.
+    LUNA_RUNTIME_API u64 allocation_tracker_get_frame_index();
+
+    //! Gets allocation statistics of the last frame.
+    //! @param[out] stats The buffer that receives statistics of every thread, ordered by thread index. Threads that have exited
+    //! are not reported.
+    //! @return Returns the number of threads that have statistics. If this is greater than the size of `stats`, only statistics of
+    //! the first `stats.size()` threads are written.
+    //! @remark This function does not allocate memory, so it can be called in allocation-free sections.
+    LUNA_RUNTIME_API usize allocation_tracker_get_last_frame_stats(Span<AllocationFrameStats> stats);
+
+    //! Records one object creation for the calling thread.
+    //! @details Modules call this function when creating objects that should not be created every frame, like RHI resources and
+    //! descriptor sets, even if the object memory is not allocated by @ref memalloc.
+    //! @param[in] type The object type name. The string is referred by pointer and is not copied, so it should be one string literal.
+    LUNA_RUNTIME_API void allocation_tracker_record_object_creation(const c8* type);
+
+    //! Begins one allocation-free section on the current thread.
+    //! @details Every allocation or object creation performed on the current thread in allocation-free sections is recorded as
+    //! one offender with its call stack, and triggers one assertion failure if enabled by @ref allocation_tracker_set_assert_on_violation.
+    //! Sections of one thread can be nested, every call to this function must be paired with one call to
+    //! @ref allocation_tracker_end_section on the same thread. Sections are checked only when the tracker is enabled.
+    //!
+    //! The user usually uses @ref LUNA_ALLOCATION_FREE_SCOPE instead of calling this function directly.
+    //! @param[in] name The name of the section. The string is referred by pointer and is not copied, so it should be one string literal.
+    LUNA_RUNTIME_API void allocation_tracker_begin_section(const c8* name);
+
+    //! Ends the last allocation-free section begun by @ref allocation_tracker_begin_section on the current thread.
+    LUNA_RUNTIME_API void allocation_tracker_end_section();
+
+    //! Sets whether one assertion failure is triggered when one allocation-free section allocates.
+    //! @details The assertion is disabled by default, in which case offenders are only recorded.
+    LUNA_RUNTIME_API void allocation_tracker_set_assert_on_violation(bool enabled);
+
+    //! Gets recorded allocation offenders.
+    //! @param[out] offenders The buffer that receives offenders, ordered from the oldest to the newest.
+    //! @return Returns the number of recorded offenders. If this is greater than the size of `offenders`, only the first
+    //! `offenders.size()` offenders are written.
+    //! @remark At most @ref MAX_ALLOCATION_OFFENDERS offenders are kept, offenders recorded after that are only counted in
+    //! @ref AllocationFrameStats::num_violations.
+    LUNA_RUNTIME_API usize allocation_tracker_get_offenders(Span<AllocationOffender> offenders);
+
+    //! Clears all recorded allocation offenders.
+    LUNA_RUNTIME_API void allocation_tracker_clear_offenders();
+
+    //! Begins one allocation-free section when constructed, and ends the section when destructed.
+    struct AllocationFreeScope
+    {
+        AllocationFreeScope(const c8* name)
+        {
+            allocation_tracker_begin_section(name);
+        }
+        ~AllocationFreeScope()
+        {
+            allocation_tracker_end_section();
+        }
+        AllocationFreeScope(const AllocationFreeScope&) = delete;
+        AllocationFreeScope& operator=(const AllocationFreeScope&) = delete;
+    };
+
+#define LUNA_ALLOCATION_FREE_SCOPE_CONCAT_IMPL(a, b) a##b
+#define LUNA_ALLOCATION_FREE_SCOPE_CONCAT(a, b) LUNA_ALLOCATION_FREE_SCOPE_CONCAT_IMPL(a, b)
+
+    //! Declares that the current scope should not allocate memory or create objects.
+    //! @details This macro expands to nothing if @ref LUNA_ALLOCATION_TRACKER_ENABLED is not defined.
+    //! @param[in] name The name of the section. See @ref allocation_tracker_begin_section for details.
+#define LUNA_ALLOCATION_FREE_SCOPE(name) ::Luna::AllocationFreeScope LUNA_ALLOCATION_FREE_SCOPE_CONCAT(_luna_allocation_free_scope_, __LINE__)(name)
+
+#else
+
+#define LUNA_ALLOCATION_FREE_SCOPE(name)
+
+#endif
+
+    //! @}
+}
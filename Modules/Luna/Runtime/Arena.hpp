@@ -0,0 +1,266 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Arena.hpp
+* @author JXMaster
+* @date 2024/3/10
+*/
+#pragma once
+#include "Assert.hpp"
+#include "Memory.hpp"
+#include "MemoryUtils.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeMemory
+    //! @{
+
+    //! Records one allocation position of one @ref Arena, which can be used to free all memory allocated after the position.
+    struct ArenaMarker
+    {
+        void* page = nullptr;
+        usize cursor = 0;
+    };
+
+    //! One bump-pointer memory arena that allocates memory blocks from pages linearly.
+    //! @details Memory blocks allocated from one arena are not freed individually. Instead, all memory blocks are freed together when
+    //! @ref reset is called, or all memory blocks allocated after one marker are freed when @ref rewind is called. Pages are kept
+    //! by the arena after reset, so that allocating memory from one arena is nearly free after the first frame.
+    //!
+    //! The arena is not thread-safe. Use one arena for every thread if memory needs to be allocated from multiple threads.
+    class Arena
+    {
+    public:
+        //! Constructs one arena.
+        //! @param[in] page_size The default size of pages allocated by this arena. Allocations larger than this size
+        //! use dedicated pages.
+        Arena(usize page_size = 64_kb) :
+            m_first_page(nullptr),
+            m_current_page(nullptr),
+            m_cursor(0),
+            m_end(0),
+            m_page_size(page_size) {}
+        Arena(const Arena&) = delete;
+        Arena& operator=(const Arena&) = delete;
+        ~Arena()
+        {
+            Page* page = m_first_page;
+            while (page)
+            {
+                Page* next = page->m_next;
+                memfree(page);
+                page = next;
+            }
+        }
+        //! Allocates one memory block from the arena.
+        //! @param[in] size The size of the memory block to allocate.
+        //! @param[in] alignment The alignment of the memory block to allocate. If this is `0`, @ref MAX_ALIGN is used.
+        //! @return Returns the allocated memory block. Returns `nullptr` if `size` is `0` or if failed to allocate memory.
+        void* allocate(usize size, usize alignment = 0)
+        {
+            if (!size) return nullptr;
+            if (alignment < MAX_ALIGN) alignment = MAX_ALIGN;
+            usize ptr = align_upper(m_cursor, alignment);
+            if (m_current_page && ptr + size <= m_end)
+            {
+                m_cursor = ptr + size;
+                return (void*)ptr;
+            }
+            // Finds one existing page that can hold the allocation.
+            Page* page = m_current_page ? m_current_page->m_next : m_first_page;
+            while (page)
+            {
+                ptr = align_upper(page->begin(), alignment);
+                if (ptr + size <= page->end())
+                {
+                    break;
+                }
+                page = page->m_next;
+            }
+            if (!page)
+            {
+                usize page_size = sizeof(Page) + (m_page_size > size + alignment ? m_page_size : size + alignment);
+                page = (Page*)memalloc(page_size);
+                if (!page) return nullptr;
+                page->m_size = page_size - sizeof(Page);
+                // Inserts the new page after the current page, so that it can be reused after reset.
+                if (m_current_page)
+                {
+                    page->m_next = m_current_page->m_next;
+                    m_current_page->m_next = page;
+                }
+                else
+                {
+                    page->m_next = m_first_page;
+                    m_first_page = page;
+                }
+                ptr = align_upper(page->begin(), alignment);
+            }
+            m_current_page = page;
+            m_cursor = ptr + size;
+            m_end = page->end();
+            return (void*)ptr;
+        }
+        //! Frees the memory block if the memory block is the last memory block allocated from the arena.
+        //! @param[in] ptr The memory block to free.
+        //! @param[in] size The size of the memory block passed to @ref allocate.
+        //! @return Returns `true` if the memory block is freed. Returns `false` if the memory block is not the last allocated
+        //! memory block, in such case the memory block will be freed when the arena is reset.
+        bool deallocate_last(void* ptr, usize size)
+        {
+            if (!ptr || (usize)ptr + size != m_cursor) return false;
+            m_cursor = (usize)ptr;
+            return true;
+        }
+        //! Gets one marker that records the current allocation position of the arena.
+        ArenaMarker get_marker() const
+        {
+            ArenaMarker r;
+            r.page = m_current_page;
+            r.cursor = m_cursor;
+            return r;
+        }
+        //! Frees all memory blocks allocated after the specified marker is fetched.
+        //! @param[in] marker The marker returned by @ref get_marker.
+        //! @par Valid Usage
+        //! * `marker` must be fetched from this arena after the last call to @ref reset, and must not be fetched after
+        //! any marker that is rewound to.
+        void rewind(const ArenaMarker& marker)
+        {
+            m_current_page = (Page*)marker.page;
+            m_cursor = marker.cursor;
+            m_end = m_current_page ? m_current_page->end() : 0;
+        }
+        //! Frees all memory blocks allocated from this arena. The pages are kept for new allocations.
+        void reset()
+        {
+            m_current_page = nullptr;
+            m_cursor = 0;
+            m_end = 0;
+        }
+        //! Gets the total size of pages allocated by this arena.
+        usize get_reserved_size() const
+        {
+            usize r = 0;
+            for (Page* page = m_first_page; page; page = page->m_next)
+            {
+                r += page->m_size;
+            }
+            return r;
+        }
+    private:
+        struct Page
+        {
+            Page* m_next;
+            usize m_size;
+            usize begin() const { return (usize)(this + 1); }
+            usize end() const { return begin() + m_size; }
+        };
+        Page* m_first_page;
+        Page* m_current_page;
+        usize m_cursor;
+        usize m_end;
+        usize m_page_size;
+    };
+
+    //! Records the allocation position of one arena when constructed, and rewinds the arena to the position when destructed.
+    class ArenaScope
+    {
+    public:
+        ArenaScope(Arena& arena) :
+            m_arena(arena),
+            m_marker(arena.get_marker()) {}
+        ArenaScope(const ArenaScope&) = delete;
+        ArenaScope& operator=(const ArenaScope&) = delete;
+        ~ArenaScope()
+        {
+            m_arena.rewind(m_marker);
+        }
+    private:
+        Arena& m_arena;
+        ArenaMarker m_marker;
+    };
+
+    //! The allocator that allocates memory from one @ref Arena. This can be used for containers defined in Runtime module.
+    //! @details Deallocating memory from this allocator does nothing, the memory is freed when the arena is reset or rewound. The
+    //! arena must be valid when any container that uses this allocator is alive.
+    //!
+    //! If the allocator is default-constructed, it allocates memory by calling @ref memalloc, and deallocates memory by calling
+    //! @ref memfree like @ref Allocator.
+    class ArenaAllocator
+    {
+    public:
+        ArenaAllocator() :
+            m_arena(nullptr) {}
+        ArenaAllocator(Arena& arena) :
+            m_arena(&arena) {}
+        template <typename _Ty>
+        _Ty* allocate(usize n = 1)
+        {
+            return m_arena ? (_Ty*)m_arena->allocate(sizeof(_Ty) * n, alignof(_Ty)) : (_Ty*)memalloc(sizeof(_Ty) * n, alignof(_Ty));
+        }
+        template <typename _Ty>
+        void deallocate(_Ty* ptr, usize n = 1)
+        {
+            if (!m_arena) memfree(ptr, alignof(_Ty));
+        }
+        //! Gets the arena bound to this allocator.
+        Arena* get_arena() const
+        {
+            return m_arena;
+        }
+        bool operator==(const ArenaAllocator& rhs) const
+        {
+            return m_arena == rhs.m_arena;
+        }
+        bool operator!=(const ArenaAllocator& rhs) const
+        {
+            return m_arena != rhs.m_arena;
+        }
+    private:
+        Arena* m_arena;
+    };
+
+    //! The allocator that allocates memory from one @ref Arena in stack order.
+    //! @details This behaves like @ref ArenaAllocator, but deallocating the last allocated memory block from the arena frees the
+    //! memory block immediately, so that temporary buffers that are allocated and freed in LIFO order do not consume the arena. Use
+    //! @ref ArenaScope to free all memory blocks allocated in one scope.
+    class StackAllocator
+    {
+    public:
+        StackAllocator() :
+            m_arena(nullptr) {}
+        StackAllocator(Arena& arena) :
+            m_arena(&arena) {}
+        template <typename _Ty>
+        _Ty* allocate(usize n = 1)
+        {
+            return m_arena ? (_Ty*)m_arena->allocate(sizeof(_Ty) * n, alignof(_Ty)) : (_Ty*)memalloc(sizeof(_Ty) * n, alignof(_Ty));
+        }
+        template <typename _Ty>
+        void deallocate(_Ty* ptr, usize n = 1)
+        {
+            if (m_arena) m_arena->deallocate_last(ptr, sizeof(_Ty) * n);
+            else memfree(ptr, alignof(_Ty));
+        }
+        //! Gets the arena bound to this allocator.
+        Arena* get_arena() const
+        {
+            return m_arena;
+        }
+        bool operator==(const StackAllocator& rhs) const
+        {
+            return m_arena == rhs.m_arena;
+        }
+        bool operator!=(const StackAllocator& rhs) const
+        {
+            return m_arena != rhs.m_arena;
+        }
+    private:
+        Arena* m_arena;
+    };
+
+    //! @}
+}
@@ -106,7 +106,7 @@ namespace Luna
     //! @details This operation cannot be interrupted by system thread switching.
     //! @param[in] base The pointer to the variable that needs to be changed.
     //! @param[in] v The value that needs to be added to the variable.
-    //! @return Returns the value of the variable before this operation.
+    //! @return Returns the value of the variable after this operation.
     usize atom_add_usize(usize volatile* base, isize v);
 
     //! Atomically replace the value of the variable with the value provided.
@@ -207,5 +207,11 @@ namespace Luna
     //! @remark See remarks of @ref atom_compare_exchange_i32 for details.
     usize atom_compare_exchange_usize(usize volatile* dst, usize exchange, usize comperand);
 
+    //! Issues one full memory barrier.
+    //! @details All memory reads and writes issued before this call are guaranteed to be visible to other processors
+    //! before any memory read or write issued after this call. This also prevents the compiler from reordering 
+    //! memory accesses across the call.
+    void atom_memory_barrier();
+
     //! @}
 }
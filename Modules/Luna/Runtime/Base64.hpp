@@ -9,6 +9,7 @@
 */
 #pragma once
 #include "Base.hpp"
+#include "Stream.hpp"
 
 #ifndef LUNA_RUNTIME_API
 #define LUNA_RUNTIME_API
@@ -61,5 +62,13 @@ namespace Luna
     //! @return Returns the number of bytes decoded into the `dst` buffer.
     LUNA_RUNTIME_API usize base64_decode(void* dst, usize dst_max_bytes, const c8* src, usize src_size_chars = USIZE_MAX);
 
+    //! Encodes a binary data to a base64 string and writes the string to one stream.
+    //! @details The data is encoded in chunks, so that the encoded string is never stored in memory as a whole.
+    //! The null-terminator is not written to the stream.
+    //! @param[in] stream The stream to write the encoded string to.
+    //! @param[in] src The source binary data.
+    //! @param[in] src_size_bytes The size of the source binary data in bytes.
+    LUNA_RUNTIME_API RV base64_encode_to_stream(IStream* stream, const void* src, usize src_size_bytes);
+
     //! @}
 }
\ No newline at end of file
@@ -0,0 +1,169 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BufferedStream.hpp
+* @author JXMaster
+* @date 2024/5/12
+*/
+#pragma once
+#include "Stream.hpp"
+#include "Span.hpp"
+#include "Memory.hpp"
+#include "MemoryUtils.hpp"
+#include "VirtualMemory.hpp"
+
+namespace Luna
+{
+    //! @addtogroup Runtime
+    //! @{
+
+    //! Reads one stream through one large user-mode buffer.
+    //! @details Parsers that read small pieces of data at a time should read the stream through this adapter, so that
+    //! the underlying stream is only called once for every buffer refill. Buffered data can be accessed directly by
+    //! @ref peek and @ref consume without copying it to another buffer.
+    //!
+    //! This adapter reads data from the underlying stream ahead of the data consumed, so the cursor of the underlying
+    //! stream is undefined when the adapter is being used.
+    class BufferedStream
+    {
+        IStream* m_stream;
+        byte_t* m_buffer;
+        usize m_capacity;
+        // The range of data that is read from the stream but not consumed.
+        usize m_begin = 0;
+        usize m_end = 0;
+        bool m_eof = false;
+
+    public:
+        //! Constructs one buffered stream.
+        //! @param[in] stream The stream to read data from. The stream must be valid until the buffered stream is destructed.
+        //! @param[in] buffer_size The size of the buffer. This will be rounded up to times of the system page size, and the
+        //! buffer is aligned to the system page size.
+        BufferedStream(IStream* stream, usize buffer_size = 64_kb) :
+            m_stream(stream)
+        {
+            usize page_size = get_page_size();
+            m_capacity = align_upper(max<usize>(buffer_size, 1), page_size);
+            m_buffer = (byte_t*)memalloc(m_capacity, page_size);
+        }
+        BufferedStream(const BufferedStream&) = delete;
+        BufferedStream(BufferedStream&&) = delete;
+        BufferedStream& operator=(const BufferedStream&) = delete;
+        BufferedStream& operator=(BufferedStream&&) = delete;
+        ~BufferedStream()
+        {
+            memfree(m_buffer, get_page_size());
+        }
+        //! Gets the underlying stream.
+        IStream* get_stream() const { return m_stream; }
+        //! Gets the size of the buffer.
+        usize get_capacity() const { return m_capacity; }
+        //! Gets data that is buffered but not consumed without reading the underlying stream.
+        Span<const byte_t> get_buffered_data() const
+        {
+            return Span<const byte_t>(m_buffer + m_begin, m_end - m_begin);
+        }
+        //! Checks whether the underlying stream reaches its end and all buffered data is consumed.
+        bool is_eof() const
+        {
+            return m_eof && m_begin == m_end;
+        }
+        //! Reads data from the underlying stream until at least `size` bytes are buffered or the end of the stream is reached.
+        //! @details This does not consume any data. Buffered data is moved to the beginning of the buffer if the remaining space
+        //! is not enough, so pointers returned by previous calls are invalidated.
+        //! @param[in] size The number of bytes to buffer. This is clamped to the buffer size.
+        //! @return Returns all buffered data. The returned data may be smaller than `size` only if the end of the stream is reached.
+        R<Span<const byte_t>> peek(usize size)
+        {
+            size = min(size, m_capacity);
+            if (m_end - m_begin < size && !m_eof)
+            {
+                if (m_capacity - m_begin < size)
+                {
+                    memmove(m_buffer, m_buffer + m_begin, m_end - m_begin);
+                    m_end -= m_begin;
+                    m_begin = 0;
+                }
+                lutry
+                {
+                    while (m_end - m_begin < size)
+                    {
+                        // Always fills the whole free space, so that small peeks do not call the stream frequently.
+                        usize read_bytes = 0;
+                        luexp(m_stream->read(m_buffer + m_end, m_capacity - m_end, &read_bytes));
+                        if (!read_bytes)
+                        {
+                            m_eof = true;
+                            break;
+                        }
+                        m_end += read_bytes;
+                    }
+                }
+                lucatchret;
+            }
+            return get_buffered_data();
+        }
+        //! Marks buffered data as consumed.
+        //! @param[in] size The number of bytes to consume. This must not be greater than the size of buffered data.
+        void consume(usize size)
+        {
+            luassert(size <= m_end - m_begin);
+            m_begin += size;
+            if (m_begin == m_end)
+            {
+                m_begin = 0;
+                m_end = 0;
+            }
+        }
+        //! Reads data and consumes them.
+        //! @details Buffered data is copied first. If the remaining data to read is not smaller than the buffer size, the data
+        //! is read from the underlying stream to `buffer` directly.
+        //! @param[in] buffer The buffer to accept the read data.
+        //! @param[in] size The size, in bytes, to read.
+        //! @param[out] read_bytes If not `nullptr`, the actual size of bytes being read is set to this parameter. This may
+        //! be smaller than `size` only if the end of the stream is reached.
+        RV read(void* buffer, usize size, usize* read_bytes = nullptr)
+        {
+            byte_t* dst = (byte_t*)buffer;
+            usize total = 0;
+            lutry
+            {
+                while (total < size)
+                {
+                    usize buffered = m_end - m_begin;
+                    if (buffered)
+                    {
+                        usize copy_size = min(buffered, size - total);
+                        memcpy(dst + total, m_buffer + m_begin, copy_size);
+                        consume(copy_size);
+                        total += copy_size;
+                        continue;
+                    }
+                    if (m_eof) break;
+                    if (size - total >= m_capacity)
+                    {
+                        usize stream_read_bytes = 0;
+                        luexp(m_stream->read(dst + total, size - total, &stream_read_bytes));
+                        if (!stream_read_bytes) m_eof = true;
+                        total += stream_read_bytes;
+                    }
+                    else
+                    {
+                        luexp(peek(size - total));
+                    }
+                }
+            }
+            lucatch
+            {
+                if (read_bytes) *read_bytes = total;
+                return luerr;
+            }
+            if (read_bytes) *read_bytes = total;
+            return ok;
+        }
+    };
+
+    //! @}
+}
@@ -0,0 +1,101 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file CPU.hpp
+* @author JXMaster
+* @date 2024/5/5
+* @brief CPU feature query APIs.
+*/
+#pragma once
+#include "Base.hpp"
+
+#ifndef LUNA_RUNTIME_API
+#define LUNA_RUNTIME_API
+#endif
+
+//! @def LUNA_TARGET_AVX2
+//! Marks one function to be compiled with AVX2 and FMA3 instructions enabled, regardless of the instruction set 
+//! selected for the translation unit. 
+//! @details Functions marked with this can use AVX2 and FMA3 intrinsics directly, and must only be called when 
+//! @ref CPUFeatureFlag::avx2 and @ref CPUFeatureFlag::fma3 are supported by the processor. Such functions should 
+//! have internal linkage, so that they will not be merged with functions of the same name compiled for other instruction sets.
+//! @def LUNA_TARGET_SSSE3
+//! Marks one function to be compiled with SSSE3 instructions enabled, regardless of the instruction set 
+//! selected for the translation unit. 
+//! @details This has the same usage as @ref LUNA_TARGET_AVX2, and functions marked with this must only be called when 
+//! @ref CPUFeatureFlag::ssse3 is supported by the processor.
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+#if defined(LUNA_COMPILER_GCC) || defined(LUNA_COMPILER_CLANG)
+#define LUNA_TARGET_AVX2 __attribute__((target("avx2,fma")))
+#define LUNA_TARGET_SSSE3 __attribute__((target("ssse3")))
+#else
+// MSVC allows using AVX2 intrinsics in any function.
+#define LUNA_TARGET_AVX2
+#define LUNA_TARGET_SSSE3
+#endif
+#endif
+
+namespace Luna
+{
+    //! @addtogroup Runtime
+    //! @{
+    
+    //! Specifies instruction set extensions supported by the processor.
+    enum class CPUFeatureFlag : u64
+    {
+        none = 0,
+        //! x86 SSE2 instructions.
+        sse2 = 1ULL << 0,
+        //! x86 SSE3 instructions.
+        sse3 = 1ULL << 1,
+        //! x86 SSSE3 instructions.
+        ssse3 = 1ULL << 2,
+        //! x86 SSE4.1 instructions.
+        sse4_1 = 1ULL << 3,
+        //! x86 SSE4.2 instructions.
+        sse4_2 = 1ULL << 4,
+        //! x86 POPCNT instruction.
+        popcnt = 1ULL << 5,
+        //! x86 AVX instructions. This is reported only if the operating system saves AVX registers on context switches.
+        avx = 1ULL << 6,
+        //! x86 AVX2 instructions.
+        avx2 = 1ULL << 7,
+        //! x86 FMA3 instructions.
+        fma3 = 1ULL << 8,
+        //! x86 F16C instructions.
+        f16c = 1ULL << 9,
+        //! x86 BMI1 instructions.
+        bmi1 = 1ULL << 10,
+        //! x86 BMI2 instructions.
+        bmi2 = 1ULL << 11,
+        //! x86 AVX-512 Foundation instructions. This is reported only if the operating system saves AVX-512 registers on context switches.
+        avx512f = 1ULL << 12,
+        //! x86 AVX-512 Doubleword and Quadword instructions.
+        avx512dq = 1ULL << 13,
+        //! x86 AVX-512 Byte and Word instructions.
+        avx512bw = 1ULL << 14,
+        //! x86 AVX-512 Vector Length extensions.
+        avx512vl = 1ULL << 15,
+        //! ARM Advanced SIMD (Neon) instructions.
+        neon = 1ULL << 32,
+        //! ARM CRC32 instructions.
+        crc32 = 1ULL << 33,
+    };
+
+    //! Gets instruction set extensions supported by the processor.
+    //! @return Returns one combination of @ref CPUFeatureFlag that represents supported instruction set extensions.
+    //! @remark The returned value is detected once when the runtime is initialized, so calling this function is cheap.
+    LUNA_RUNTIME_API CPUFeatureFlag get_cpu_features();
+
+    //! Checks whether the processor supports all specified instruction set extensions.
+    //! @param[in] features The instruction set extensions to check.
+    //! @return Returns `true` if all instruction set extensions in `features` are supported. Returns `false` otherwise.
+    inline bool is_cpu_feature_supported(CPUFeatureFlag features)
+    {
+        return test_flags(get_cpu_features(), features);
+    }
+
+    //! @}
+}
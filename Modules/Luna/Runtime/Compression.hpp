@@ -0,0 +1,178 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Compression.hpp
+* @author JXMaster
+* @date 2024/5/13
+*/
+#pragma once
+#include "Stream.hpp"
+#include "Ref.hpp"
+#include "Blob.hpp"
+#include "Span.hpp"
+#include "MemoryUtils.hpp"
+
+#ifndef LUNA_RUNTIME_API
+#define LUNA_RUNTIME_API
+#endif
+
+namespace Luna
+{
+    //! @addtogroup Runtime
+    //! @{
+    //! @defgroup RuntimeCompression Data compression
+    //! @}
+
+    //! @addtogroup RuntimeCompression
+    //! @{
+
+    //! Specifies the compression format.
+    enum class CompressionFormat : u8
+    {
+        //! Data is stored without compression.
+        none = 0,
+        //! Data is compressed in LZ4 block format. See @ref LZ4 for details.
+        lz4 = 1,
+    };
+
+    //! The magic number of one compression frame, which is "LUCF" in little-endian.
+    constexpr u32 COMPRESSION_FRAME_MAGIC = 0x4643554C;
+
+    //! The header of one compression frame.
+    //! @details One compression frame stores one header, followed by multiple blocks that are compressed independently,
+    //! so that blocks can be compressed and decompressed in parallel. Every block starts with one @ref CompressionBlockHeader,
+    //! and the frame ends with one block header whose sizes are both `0`. All integers are stored in little-endian.
+    struct CompressionFrameHeader
+    {
+        //! Must be @ref COMPRESSION_FRAME_MAGIC.
+        u32 magic;
+        //! The compression format of all blocks.
+        CompressionFormat format;
+        u8 reserved[3];
+        //! The maximum decompressed size of one block.
+        u32 block_size;
+    };
+
+    //! If this bit is set in @ref CompressionBlockHeader::stored_size, the block data is stored without compression.
+    constexpr u32 COMPRESSION_BLOCK_UNCOMPRESSED = 0x80000000;
+
+    //! The header of one block in one compression frame.
+    struct CompressionBlockHeader
+    {
+        //! The size of the block data following this header, combined with @ref COMPRESSION_BLOCK_UNCOMPRESSED if the block
+        //! data is not compressed.
+        u32 stored_size;
+        //! The decompressed size of the block data.
+        u32 raw_size;
+    };
+
+    //! Describes how to compress one compression frame.
+    struct CompressionDesc
+    {
+        //! The compression format.
+        CompressionFormat format = CompressionFormat::lz4;
+        //! The maximum decompressed size of one block. Larger blocks compress better, while smaller blocks can be
+        //! compressed and decompressed with more threads. This must be smaller than 2GB.
+        u32 block_size = (u32)256_kb;
+        //! The optional dictionary used by all blocks. Compressing small blocks with one dictionary built from similar data
+        //! improves compression ratio significantly. The same dictionary must be provided when decompressing data.
+        //! Only the last 64KB of the dictionary is used for LZ4.
+        Span<const byte_t> dictionary;
+    };
+
+    //! Gets the maximum compressed size of data of the specified size.
+    //! @param[in] format The compression format.
+    //! @param[in] src_size The size of the data to compress.
+    //! @return Returns the maximum compressed size.
+    LUNA_RUNTIME_API usize get_compress_bound(CompressionFormat format, usize src_size);
+
+    //! Compresses one block of data.
+    //! @param[in] format The compression format.
+    //! @param[in] src The data to compress. The data size must be smaller than 4GB.
+    //! @param[in] src_size The size of the data to compress.
+    //! @param[in] dst The buffer to write compressed data to.
+    //! @param[in] dst_capacity The size of `dst`. Specify one size not smaller than @ref get_compress_bound to make sure
+    //! that compression always succeeds.
+    //! @param[in] dictionary The optional dictionary to compress the data.
+    //! @return Returns the compressed size.
+    //! @par Possible Errors
+    //! * @ref BasicError::insufficient_user_buffer If `dst_capacity` is not large enough to hold compressed data.
+    LUNA_RUNTIME_API R<usize> compress(CompressionFormat format, const void* src, usize src_size, void* dst, usize dst_capacity,
+        Span<const byte_t> dictionary = Span<const byte_t>());
+
+    //! Decompresses one block of data compressed by @ref compress.
+    //! @param[in] format The compression format.
+    //! @param[in] src The compressed data.
+    //! @param[in] src_size The size of the compressed data.
+    //! @param[in] dst The buffer to write decompressed data to.
+    //! @param[in] dst_size The decompressed size, which must be recorded by the user when compressing data.
+    //! @param[in] dictionary The dictionary used to compress the data.
+    //! @par Possible Errors
+    //! * @ref BasicError::format_error If the compressed data is corrupted.
+    LUNA_RUNTIME_API RV decompress(CompressionFormat format, const void* src, usize src_size, void* dst, usize dst_size,
+        Span<const byte_t> dictionary = Span<const byte_t>());
+
+    //! Gets the maximum size written by @ref compress_frame_block.
+    //! @param[in] format The compression format.
+    //! @param[in] src_size The size of the data to compress.
+    LUNA_RUNTIME_API usize get_compress_frame_block_bound(CompressionFormat format, usize src_size);
+
+    //! Compresses one block of one compression frame, including its block header.
+    //! @details This can be used to compress blocks of one frame on multiple threads, see @ref compress_frame for the frame layout.
+    //! @param[in] desc The compression descriptor.
+    //! @param[in] src The block data to compress. The data size must not be greater than @ref CompressionDesc::block_size.
+    //! @param[in] src_size The size of the data to compress.
+    //! @param[in] dst The buffer to write the block to, which must not be smaller than @ref get_compress_frame_block_bound.
+    //! @return Returns the number of bytes written to `dst`.
+    LUNA_RUNTIME_API usize compress_frame_block(const CompressionDesc& desc, const void* src, usize src_size, void* dst);
+
+    //! Compresses data into one compression frame.
+    //! @param[in] src The data to compress.
+    //! @param[in] src_size The size of the data to compress.
+    //! @param[in] desc The compression descriptor.
+    //! @return Returns the compression frame.
+    LUNA_RUNTIME_API R<Blob> compress_frame(const void* src, usize src_size, const CompressionDesc& desc = CompressionDesc());
+
+    //! Decompresses data from one compression frame.
+    //! @param[in] src The compression frame.
+    //! @param[in] src_size The size of the compression frame.
+    //! @param[in] dictionary The dictionary used to compress the frame.
+    //! @return Returns the decompressed data.
+    //! @par Possible Errors
+    //! * @ref BasicError::format_error If the frame is corrupted.
+    LUNA_RUNTIME_API R<Blob> decompress_frame(const void* src, usize src_size, Span<const byte_t> dictionary = Span<const byte_t>());
+
+    //! @interface ICompressionStream
+    //! Represents one write-only stream that compresses written data into one compression frame and writes the frame to
+    //! another stream.
+    //! @details Data is buffered until one block is filled, so the target stream is only written once for every block.
+    struct ICompressionStream : virtual IStream
+    {
+        luiid("{8d2f6a31-c4e7-4b09-9a5c-73e1d2b04f86}");
+
+        //! Compresses all buffered data and writes the end of the frame to the target stream.
+        //! @details Writing data after this is called fails. If this is not called, this is called when the stream is
+        //! destructed, with errors ignored.
+        virtual RV finish() = 0;
+    };
+
+    //! Creates one stream that compresses written data into one compression frame.
+    //! @param[in] target The stream to write the compression frame to.
+    //! @param[in] desc The compression descriptor. The dictionary is copied to the stream.
+    //! @return Returns the created stream.
+    LUNA_RUNTIME_API Ref<ICompressionStream> new_compression_stream(IStream* target, const CompressionDesc& desc = CompressionDesc());
+
+    //! Creates one read-only stream that decompresses data from one compression frame.
+    //! @details The frame header is read from `source` when the stream is created. Every block is read from `source`
+    //! and decompressed when the previous block is consumed.
+    //! @param[in] source The stream to read the compression frame from.
+    //! @param[in] dictionary The dictionary used to compress the frame. The dictionary is copied to the stream.
+    //! @return Returns the created stream.
+    //! @par Possible Errors
+    //! * @ref BasicError::format_error If the frame header is invalid.
+    LUNA_RUNTIME_API R<Ref<IStream>> new_decompression_stream(IStream* source, Span<const byte_t> dictionary = Span<const byte_t>());
+
+    //! @}
+}
@@ -20,7 +20,10 @@ namespace Luna
     template <typename _Func, typename _Alloc = Allocator>
     class Event
     {
-        Vector<Pair<usize, Function<_Func>>, _Alloc> m_handlers;
+        // Handlers and their handles are stored in separate arrays, so that handlers are invoked by iterating 
+        // one contiguous array.
+        Vector<Function<_Func>, _Alloc> m_handlers;
+        Vector<usize, _Alloc> m_handles;
         usize m_next_handle = 0;
     public:
         //! Removes all handlers registered to this event.
@@ -28,15 +31,20 @@ namespace Luna
         {
             m_handlers.clear();
             m_handlers.shrink_to_fit();
+            m_handles.clear();
+            m_handles.shrink_to_fit();
         }
         //! Triggers this event and invokes all handlers.
-        //! @param[in] args Event arguments that will be broadcasted to every handler of this event. 
+        //! @param[in] args Event arguments that will be broadcasted to every handler of this event. Arguments are 
+        //! passed to every handler as lvalues, so that they are not moved by one handler before other handlers are invoked.
         template <typename... _Args>
         void operator()(_Args&&... args)
         {
-            for (auto& handler : m_handlers)
+            const Function<_Func>* handlers = m_handlers.data();
+            usize num_handlers = m_handlers.size();
+            for (usize i = 0; i < num_handlers; ++i)
             {
-                handler.second(forward<_Args>(args)...);
+                handlers[i](args...);
             }
         }
         //! Adds one new handler to the event.
@@ -45,7 +53,8 @@ namespace Luna
         usize add_handler(const Function<_Func>& func)
         {
             usize handle = m_next_handle++;
-            m_handlers.push_back(make_pair(handle, func));
+            m_handlers.push_back(func);
+            m_handles.push_back(handle);
             return handle;
         }
         //! Adds one new handler to the event.
@@ -54,18 +63,20 @@ namespace Luna
         usize add_handler(Function<_Func>&& func)
         {
             usize handle = m_next_handle++;
-            m_handlers.push_back(make_pair(handle, move(func)));
+            m_handlers.push_back(move(func));
+            m_handles.push_back(handle);
             return handle;
         }
         //! Removes one registered handler.
         //! @param[in] handle The integer returned by @ref add_handler for the handler to remove.
         void remove_handler(usize handle)
         {
-            for (auto iter = m_handlers.begin(); iter != m_handlers.end(); ++iter)
+            for (usize i = 0; i < m_handles.size(); ++i)
             {
-                if (iter->first == handle)
+                if (m_handles[i] == handle)
                 {
-                    m_handlers.erase(iter);
+                    m_handles.erase(m_handles.begin() + i);
+                    m_handlers.erase(m_handlers.begin() + i);
                     break;
                 }
             }
@@ -0,0 +1,63 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Fiber.hpp
+* @author JXMaster
+* @date 2024/3/8
+*/
+#pragma once
+#include "Base.hpp"
+#include "Interface.hpp"
+#include "Ref.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeThread
+    //! @{
+
+    //! @interface IFiber
+    //! Represents one fiber, which is one execution context with its own call stack that is scheduled by the user instead of
+    //! the system.
+    //! @details One fiber can be run on any thread that is converted to fiber by @ref convert_thread_to_fiber. Switching fibers
+    //! only saves and restores registers and stacks, so it is much cheaper than switching threads.
+    struct IFiber : virtual Interface
+    {
+        luiid("{7d3a4d1c-3b4f-4e9b-9b8f-6e2f0e9a5c31}");
+    };
+
+    //! Converts the current thread to one fiber, so that it can switch to other fibers.
+    //! @return Returns the fiber object that represents the current thread. The returned object can be used to switch back to
+    //! the thread from other fibers.
+    //! @par Valid Usage
+    //! * The current thread must not be converted to fiber.
+    //! * @ref convert_fiber_to_thread must be called on the same thread before the thread exits.
+    LUNA_RUNTIME_API Ref<IFiber> convert_thread_to_fiber();
+
+    //! Converts the current thread back from fiber.
+    //! @par Valid Usage
+    //! * The current thread must be converted to fiber by @ref convert_thread_to_fiber, and must be running the fiber returned by
+    //! @ref convert_thread_to_fiber.
+    LUNA_RUNTIME_API void convert_fiber_to_thread();
+
+    //! Creates one new fiber.
+    //! @param[in] entry_func The function to invoke when the fiber is switched to for the first time.
+    //! The function must never return. To stop executing one fiber, switch to another fiber instead.
+    //! @param[in] params The additional parameter passed to the callback.
+    //! @param[in] stack_size The stack size of the fiber. If this is `0`, the default stack size (256KB) is used.
+    //! @return Returns the new created fiber. The fiber is not executed until @ref switch_to_fiber is called for it.
+    //! @remark The fiber must not be released when it is running.
+    LUNA_RUNTIME_API Ref<IFiber> new_fiber(void(*entry_func)(void* params), void* params, u32 stack_size = 0);
+
+    //! Suspends the current fiber and runs the specified fiber on the current thread.
+    //! @param[in] fiber The fiber to run.
+    //! @par Valid Usage
+    //! * The current thread must be converted to fiber by @ref convert_thread_to_fiber.
+    //! * `fiber` must not be running on any thread.
+    //! @remark One fiber suspended on one thread can be resumed on another thread. In such case, the fiber must not cache
+    //! any thread-local data across @ref switch_to_fiber calls.
+    LUNA_RUNTIME_API void switch_to_fiber(IFiber* fiber);
+
+    //! @}
+}
@@ -10,6 +10,7 @@
 #pragma once
 #include "Stream.hpp"
 #include "Ref.hpp"
+#include "Span.hpp"
 namespace Luna
 {
     //! @addtogroup Runtime
@@ -48,6 +49,10 @@ namespace Luna
         //! @details The user-mode buffer can be used to buffer the data read from file or to be written to file, 
         //! thus reduce system calls if lots of small-sized reads/writes need to be performed.
         user_buffering = 0x04,
+        //! Hints that the file will be read sequentially from the beginning to the end.
+        //! @details The system may read data ahead of the cursor more aggressively and release cached pages
+        //! earlier for such files. This is only a hint, and random access is still allowed.
+        sequential_scan = 0x08,
     };
 
     //! Specifies file creation mmode.
@@ -144,6 +149,76 @@ namespace Luna
     //! * `file` must be opened with @ref FileOpenFlag::read flag.
     LUNA_RUNTIME_API R<Blob> load_file_data(IFile* file);
 
+    //! Gets the platform handle of one file opened by @ref open_file.
+    //! @param[in] file The file.
+    //! @return Returns the platform handle of the file, which can be reinterpreted to `HANDLE` on Windows platforms, 
+    //! and to `int` file descriptor on POSIX platforms. Returns `nullptr` if the file is not opened by @ref open_file.
+    //! @remark The returned handle is owned by the file object, and must not be closed by the user. If the file is opened with 
+    //! @ref FileOpenFlag::user_buffering, data cached in the user-space buffer is not visible from the returned handle.
+    LUNA_RUNTIME_API opaque_t get_native_file_handle(IFile* file);
+
+    //! Describes one asynchronous file read operation submitted by @ref submit_async_file_reads.
+    struct AsyncFileReadDesc
+    {
+        //! The file to read. The file must be opened by @ref open_file with @ref FileOpenFlag::read.
+        IFile* file;
+        //! The offset, in bytes, from the beginning of the file to read data from.
+        u64 offset;
+        //! The buffer to write read data to. The buffer must be valid until @ref on_complete is called.
+        void* buffer;
+        //! The number of bytes to read.
+        usize size;
+        //! Called when the read operation is finished.
+        //! @param[in] userdata The user data pointer specified in @ref userdata.
+        //! @param[in] result The result of the read operation.
+        //! @param[in] read_bytes The number of bytes actually read. This may be smaller than @ref size if 
+        //! the end of the file is reached.
+        void (*on_complete)(void* userdata, RV result, usize read_bytes);
+        //! The user data pointer passed to @ref on_complete.
+        void* userdata;
+    };
+
+    //! Submits a batch of asynchronous file read operations.
+    //! @details Read operations are performed by dedicated IO threads using positional reads, so multiple read operations 
+    //! of the same file can be processed concurrently, and the calling thread never blocks on IO. Completion callbacks are called 
+    //! from IO threads, and may be called in any order.
+    //! 
+    //! The file cursor of one file is unspecified while read operations of the file are pending. The file is retained until all 
+    //! read operations of the file are finished.
+    //! @param[in] reads The read operations to submit.
+    //! @par Possible Errors
+    //! * @ref BasicError::not_supported if any file is not opened by @ref open_file. No read operation will be submitted in such case.
+    LUNA_RUNTIME_API RV submit_async_file_reads(Span<const AsyncFileReadDesc> reads);
+
+    //! @interface IMappedFile
+    //! Represents one file that is mapped to the process address space for reading.
+    //! @details The file data can be read directly from the mapped memory without being copied to one user buffer. 
+    //! Pages of the file are loaded by the system when they are accessed, and are shared with the system file cache.
+    struct IMappedFile : virtual Interface
+    {
+        luiid("{3b7e6f1d-a5c2-4e98-b014-8d2f6c9a7e53}");
+
+        //! Gets the pointer to the mapped file data.
+        //! @return Returns the pointer to the mapped file data. The pointer is valid until the mapped file object is released.
+        //! Returns `nullptr` if the file is empty.
+        virtual const byte_t* get_data() = 0;
+
+        //! Gets the size of the mapped file data.
+        //! @return Returns the size of the mapped file data in bytes.
+        virtual usize get_size() = 0;
+    };
+
+    //! Maps one file to the process address space for reading.
+    //! @param[in] path The path of the file.
+    //! @return Returns the mapped file object.
+    //! @remark The mapped data reflects the file content when the file is mapped. The behavior is undefined if the 
+    //! file is truncated by other processes while it is mapped.
+    //! @par Possible Errors
+    //! * @ref BasicError::access_denied
+    //! * @ref BasicError::not_found
+    //! * @ref BasicError::bad_platform_call for all errors that cannot be identified.
+    LUNA_RUNTIME_API R<Ref<IMappedFile>> map_file(const c8* path);
+
     //! Gets the file attribute.
     //! @param[in] path The path of the file.
     //! @return Returns the file attribute structure.
@@ -332,189 +332,272 @@ namespace Luna
     template <typename _Func>
     struct Function;
 
+    //! The size, in bytes, of the inline storage of @ref Function. Callable objects not larger than this size are stored in 
+    //! the function wrapper directly without allocating memory from heap.
+    constexpr usize FUNCTION_INLINE_SIZE = sizeof(usize) * 3;
+
+    namespace Impl
+    {
+        union FunctionStorage
+        {
+            // Used if the function object is allocated from heap.
+            void* m_heap;
+            // Used if the function object is stored inline.
+            alignas(usize) byte_t m_buffer[FUNCTION_INLINE_SIZE];
+        };
+
+        template <typename _Ty>
+        inline constexpr bool function_is_inline_v = sizeof(_Ty) <= FUNCTION_INLINE_SIZE && 
+            alignof(usize) % alignof(_Ty) == 0 && is_trivially_relocatable_v<_Ty>;
+    }
+
     //! A function wrapper that can store one callable object, and enable coping, moving and invoking of such callable object.
     //! @details The callable object can be a function pointer or a function object (types that overloads `operator()`).
+    //! Function pointers and function objects not larger than @ref FUNCTION_INLINE_SIZE bytes are stored in the wrapper directly, 
+    //! so that no memory is allocated for them. Function objects stored in the wrapper must be trivially relocatable, see 
+    //! @ref is_trivially_relocatable for details.
     template <typename _R, typename... _Args>
     struct Function<_R(_Args...)>
     {
     private:
-        enum class Type : u8
-        {
-            // The function is empty.
-            empty = 0,
-            // The function contains one function pointer.
-            function = 1,
-            // The function contains one function object.
-            object = 2,
+        using function_t = _R(_Args...);
+        using storage_t = Impl::FunctionStorage;
+        // Operations for one specific callable type.
+        struct Manager
+        {
+            _R(*invoke)(storage_t& self, _Args... args);
+            // Copy-constructs the callable object from `src` to `dst`.
+            void (*copy)(storage_t& dst, const storage_t& src);
+            // Destructs the callable object.
+            void (*destroy)(storage_t& self);
         };
-        struct ICallable
+        template <typename _Ty, bool _Inline = Impl::function_is_inline_v<_Ty>>
+        struct ManagerImpl
         {
-            virtual ~ICallable() {}
-            virtual _R invoke(_Args... args) = 0;
-            virtual ICallable* clone() const = 0;
+            static _Ty* get(const storage_t& s) { return (_Ty*)s.m_buffer; }
+            static _R invoke(storage_t& self, _Args... args) { return (*get(self))(forward<_Args>(args)...); }
+            static void copy(storage_t& dst, const storage_t& src) { new ((void*)dst.m_buffer) _Ty(*get(src)); }
+            static void destroy(storage_t& self) { get(self)->~_Ty(); }
+            template <typename _Ty2>
+            static void construct(storage_t& self, _Ty2&& value) { new ((void*)self.m_buffer) _Ty(forward<_Ty2>(value)); }
         };
         template <typename _Ty>
-        struct Callable : ICallable
+        struct ManagerImpl<_Ty, false>
         {
-            Callable(const _Ty& obj) :
-                m_obj(obj) {}
-            Callable(_Ty&& obj) :
-                m_obj(move(obj)) {}
-            virtual _R invoke(_Args... args) override
-            {
-                return m_obj(forward<_Args>(args)...);
-            }
-            virtual ICallable* clone() const override
-            {
-                return memnew<Callable>(m_obj);
-            }
-            _Ty m_obj;
+            static _Ty* get(const storage_t& s) { return (_Ty*)s.m_heap; }
+            static _R invoke(storage_t& self, _Args... args) { return (*get(self))(forward<_Args>(args)...); }
+            static void copy(storage_t& dst, const storage_t& src) { dst.m_heap = memnew<_Ty>(*get(src)); }
+            static void destroy(storage_t& self) { memdelete(get(self)); }
+            template <typename _Ty2>
+            static void construct(storage_t& self, _Ty2&& value) { self.m_heap = memnew<_Ty>(forward<_Ty2>(value)); }
         };
-        using function_t = _R(_Args...);
-        Type m_type;
-        union
+        template <typename _Ty>
+        static const Manager* get_manager()
         {
-            // Used if this is a normal function.
-            function_t* m_func;
-            // Used if this is a function object.
-            ICallable* m_callable;
-        };
+            static constexpr Manager manager = { &ManagerImpl<_Ty>::invoke, &ManagerImpl<_Ty>::copy, &ManagerImpl<_Ty>::destroy };
+            return &manager;
+        }
+        // `nullptr` if the function is empty.
+        const Manager* m_manager;
+        mutable storage_t m_storage;
+
         void internal_clear()
         {
-            if (m_type == Type::object) memdelete(m_callable);
+            if (m_manager)
+            {
+                m_manager->destroy(m_storage);
+                m_manager = nullptr;
+            }
+        }
+        void internal_copy(const Function& rhs)
+        {
+            m_manager = rhs.m_manager;
+            if (m_manager) m_manager->copy(m_storage, rhs.m_storage);
+        }
+        void internal_move(Function& rhs)
+        {
+            // Callable objects are trivially relocatable, so they can be moved by copying bytes.
+            m_manager = rhs.m_manager;
+            m_storage = rhs.m_storage;
+            rhs.m_manager = nullptr;
         }
+        template <typename _Ty>
+        void internal_assign(_Ty&& value)
+        {
+            using value_t = remove_cv_t<remove_reference_t<_Ty>>;
+            ManagerImpl<value_t>::construct(m_storage, forward<_Ty>(value));
+            m_manager = get_manager<value_t>();
+        }
+        template <typename _Ty>
+        using enable_if_callable_t = enable_if_t<!is_same_v<remove_cv_t<remove_reference_t<_Ty>>, Function>, int>;
     public:
         using result_type = _R;
         //! Constructs an empty function wrapper.
         Function() :
-            m_type(Type::empty),
-            m_func(nullptr) {}
+            m_manager(nullptr) {}
         //! Constructs an empty function wrapper with `nullptr`.
         Function(nullptr_t ) :
-            m_type(Type::empty),
-            m_func(nullptr) {}
+            m_manager(nullptr) {}
         //! Constructs an function wrapper by coping from another function object.
         //! @param[in] rhs The function object to copy from.
-        Function(const Function& rhs) :
-            m_type(rhs.m_type)
+        Function(const Function& rhs)
         {
-            if (m_type == Type::object) m_callable = rhs.m_callable->clone();
-            else m_func = rhs.m_func;
+            internal_copy(rhs);
         }
         //! Constructs an function wrapper by moving from another function object.
         //! @param[in] rhs The function object to move from.
-        Function(Function&& rhs) :
-            m_type(rhs.m_type)
+        Function(Function&& rhs)
         {
-            if (m_type == Type::object)
-            {
-                m_callable = rhs.m_callable;
-                rhs.m_callable = nullptr;
-            }
-            else
-            {
-                m_func = rhs.m_func;
-                rhs.m_func = nullptr;
-            }
-            rhs.m_type = Type::empty;
+            internal_move(rhs);
         }
         //! Constructs an function wrapper using one function pointer.
         //! @param[in] func The function pointer to assign.
         Function(function_t* func) :
-            m_type(Type::function),
-            m_func(func) {}
+            m_manager(nullptr)
+        {
+            if (func) internal_assign(func);
+        }
         //! Constructs an function wrapper using one function object.
         //! @param[in] value The function object to assign. The function object will be copy-constructed into the wrapper.
-        template <typename _Ty>
-        Function(_Ty&& value) :
-            m_type(Type::object),
-            m_callable(memnew<Callable<remove_cv_t<remove_reference_t<_Ty>>>>(forward<_Ty>(value))) {}
+        template <typename _Ty, enable_if_callable_t<_Ty> = 0>
+        Function(_Ty&& value)
+        {
+            internal_assign(forward<_Ty>(value));
+        }
         ~Function()
         {
             internal_clear();
         }
         Function& operator=(const Function& rhs)
         {
-            internal_clear();
-            m_type = rhs.m_type;
-            if (m_type == Type::object) m_callable = rhs.m_callable->clone();
-            else m_func = rhs.m_func;
+            if (this != &rhs)
+            {
+                internal_clear();
+                internal_copy(rhs);
+            }
             return *this;
         }
         Function& operator=(Function&& rhs)
         {
-            internal_clear();
-            m_type = rhs.m_type;
-            if (m_type == Type::object)
-            {
-                m_callable = rhs.m_callable;
-                rhs.m_callable = nullptr;
-            }
-            else
+            if (this != &rhs)
             {
-                m_func = rhs.m_func;
-                rhs.m_func = nullptr;
+                internal_clear();
+                internal_move(rhs);
             }
-            rhs.m_type = Type::empty;
+            return *this;
+        }
+        Function& operator=(nullptr_t)
+        {
+            internal_clear();
             return *this;
         }
         Function& operator=(function_t* func)
         {
             internal_clear();
-            m_type = Type::function;
-            m_func = func;
+            if (func) internal_assign(func);
             return *this;
         }
-        template <typename _Ty>
+        template <typename _Ty, enable_if_callable_t<_Ty> = 0>
         Function& operator=(_Ty&& value)
         {
             internal_clear();
-            m_type = Type::object;
-            m_callable = memnew<Callable<remove_cv_t<remove_reference_t<_Ty>>>>(forward<_Ty>(value));
+            internal_assign(forward<_Ty>(value));
             return *this;
         }
         //! Swaps the data of this function wrapper with another function wrapper.
         //! @param[in] rhs The function wrapper to swap with.
         void swap(Function& rhs)
         {
-            auto type = m_type;
-            void* data;
-            if (type == Type::function) data = m_func;
-            else if (type == Type::object) data = m_callable;
-            else data = nullptr;
-
-            m_type = rhs.m_type;
-            if (m_type == Type::function) m_func = rhs.m_func;
-            else if (m_type == Type::object) m_callable = rhs.m_callable;
-            else m_func = nullptr;
-
-            rhs.m_type = type;
-            if (rhs.m_type == Type::function) rhs.m_func = (function_t*)data;
-            else if (rhs.m_type == Type::object) rhs.m_callable = (ICallable*)data;
-            else rhs.m_func = nullptr;
+            const Manager* manager = m_manager;
+            storage_t storage = m_storage;
+            m_manager = rhs.m_manager;
+            m_storage = rhs.m_storage;
+            rhs.m_manager = manager;
+            rhs.m_storage = storage;
         }
         //! Tests whether this function wrapper is empty.
         //! @return Return `true` if this function wrapper is empty, that is, contains no callable object. 
         //! Return `false` otherwise.
         bool empty() const
         {
-            return m_type == Type::empty;
+            return m_manager == nullptr;
         }
         //! Tests whether this function wrapper is non-empty.
         //! @return Return `true` if this function wrapper is non-empty, that is, contains one callable object. 
         //! Return `false` otherwise.
         operator bool() const
         {
-            return m_type != Type::empty;
+            return m_manager != nullptr;
         }
         //! Invokes the function wrapper. This will invoke the callable object that is stored in the function.
         //! @param[in] args The arguments passed to the callable object.
         //! @return Returns the return value of the callable object if `_R` is not `void`. Returns nothing otherwise.
         _R operator()(_Args... args) const
         {
-            lucheck_msg(m_type != Type::empty, "Try to invoke one empty Function.");
-            if (m_type == Type::function) return m_func(forward<_Args>(args)...);
-            else return m_callable->invoke(forward<_Args>(args)...);
+            lucheck_msg(m_manager, "Try to invoke one empty Function.");
+            return m_manager->invoke(m_storage, forward<_Args>(args)...);
+        }
+    };
+
+    template <typename _Func>
+    struct FunctionRef;
+
+    //! A non-owning reference to one callable object.
+    //! @details Unlike @ref Function, this does not copy the callable object nor allocate memory, so it is suitable for 
+    //! passing callbacks that are invoked synchronously before the called function returns.
+    //! @par Valid Usage
+    //! * The referred callable object must be valid when the function reference is invoked.
+    template <typename _R, typename... _Args>
+    struct FunctionRef<_R(_Args...)>
+    {
+    private:
+        using function_t = _R(_Args...);
+        _R(*m_invoke)(void* obj, _Args... args);
+        void* m_obj;
+
+        template <typename _Ty>
+        static _R invoke_object(void* obj, _Args... args)
+        {
+            return (*(_Ty*)obj)(forward<_Args>(args)...);
+        }
+        static _R invoke_function(void* obj, _Args... args)
+        {
+            return ((function_t*)obj)(forward<_Args>(args)...);
+        }
+    public:
+        using result_type = _R;
+        //! Constructs one empty function reference.
+        FunctionRef() :
+            m_invoke(nullptr),
+            m_obj(nullptr) {}
+        //! Constructs one function reference that refers to one function.
+        //! @param[in] func The function to refer.
+        FunctionRef(function_t* func) :
+            m_invoke(func ? &invoke_function : nullptr),
+            m_obj((void*)func) {}
+        //! Constructs one function reference that refers to one callable object.
+        //! @param[in] value The callable object to refer. The callable object is not copied.
+        template <typename _Ty, enable_if_t<!is_same_v<remove_cv_t<remove_reference_t<_Ty>>, FunctionRef>, int> = 0>
+        FunctionRef(_Ty&& value) :
+            m_invoke(&invoke_object<remove_reference_t<_Ty>>),
+            m_obj((void*)addressof(value)) {}
+        //! Tests whether this function reference is empty.
+        bool empty() const
+        {
+            return m_invoke == nullptr;
+        }
+        //! Tests whether this function reference is non-empty.
+        operator bool() const
+        {
+            return m_invoke != nullptr;
+        }
+        //! Invokes the referred callable object.
+        //! @param[in] args The arguments passed to the callable object.
+        //! @return Returns the return value of the callable object if `_R` is not `void`. Returns nothing otherwise.
+        _R operator()(_Args... args) const
+        {
+            lucheck_msg(m_invoke, "Try to invoke one empty FunctionRef.");
+            return m_invoke(m_obj, forward<_Args>(args)...);
         }
     };
 
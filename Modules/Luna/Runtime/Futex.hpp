@@ -0,0 +1,250 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Futex.hpp
+* @author JXMaster
+* @date 2024/5/11
+*/
+#pragma once
+#include "Base.hpp"
+#include "Atomic.hpp"
+
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+#include <emmintrin.h>
+#endif
+
+#ifndef LUNA_RUNTIME_API
+#define LUNA_RUNTIME_API
+#endif
+
+namespace Luna
+{
+    //! @addtogroup RuntimeThread
+    //! @{
+
+    //! Blocks the current thread while the value at the specified address equals to `expected`.
+    //! @details This function is implemented by `futex` on Linux and Android, `WaitOnAddress` on Windows and `__ulock_wait`
+    //! on macOS and iOS. The value is compared atomically with going to sleep, so one wake call that happens after the
+    //! value is changed is never missed. The function may return spuriously, so the caller should check the value again
+    //! after this function returns.
+    //! @param[in] address The address of the value to wait.
+    //! @param[in] expected The value that blocks the current thread.
+    //! @param[in] timeout_ms The maximum time to wait in milliseconds. Specify `U32_MAX` to wait infinitely.
+    //! @return Returns `false` if the wait times out, returns `true` otherwise.
+    LUNA_RUNTIME_API bool futex_wait(u32 volatile* address, u32 expected, u32 timeout_ms = U32_MAX);
+    //! Wakes up at most one thread that is blocked by @ref futex_wait on the specified address.
+    //! @param[in] address The address to wake.
+    LUNA_RUNTIME_API void futex_wake_one(u32 volatile* address);
+    //! Wakes up all threads that are blocked by @ref futex_wait on the specified address.
+    //! @param[in] address The address to wake.
+    LUNA_RUNTIME_API void futex_wake_all(u32 volatile* address);
+
+    //! A non-recursive mutex that stores its state in one 32-bit integer.
+    //! @details Unlike @ref IMutex, this mutex is not one interface object, so it does not allocate memory and can be embedded
+    //! into other objects and global variables directly. Locking one unlocked mutex and unlocking one mutex that no thread
+    //! waits for are performed in user mode by one atomic operation. When the mutex is locked, the waiting thread spins
+    //! for a short time before going to sleep by @ref futex_wait, so that short critical sections do not cause
+    //! context switches.
+    //!
+    //! Locking the same mutex from the same thread twice causes deadlock.
+    //! This can be used with @ref LockGuard.
+    class FutexMutex
+    {
+        // 0: unlocked, 1: locked without waiters, 2: locked and there may be waiters.
+        u32 volatile m_state;
+
+        static constexpr u32 NUM_SPINS = 128;
+    public:
+        //! Constructs one mutex. The mutex is unlocked after creation.
+        FutexMutex() : m_state(0) {}
+        FutexMutex(const FutexMutex&) = delete;
+        FutexMutex(FutexMutex&&) = delete;
+        FutexMutex& operator=(const FutexMutex&) = delete;
+        FutexMutex& operator=(FutexMutex&&) = delete;
+        //! Tries to lock the mutex.
+        //! @return Returns `true` if the mutex is successfully locked when the function returns. Returns
+        //! `false` otherwise.
+        bool try_lock()
+        {
+            return atom_compare_exchange_u32(&m_state, 1, 0) == 0;
+        }
+        //! Locks the mutex.
+        //! @details This function blocks the current thread until the mutex is successfully locked.
+        void lock()
+        {
+            u32 state = atom_compare_exchange_u32(&m_state, 1, 0);
+            if (state == 0) return;
+            for (u32 i = 0; i < NUM_SPINS && state == 1; ++i)
+            {
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+                _mm_pause();
+#endif
+                state = atom_compare_exchange_u32(&m_state, 1, 0);
+                if (state == 0) return;
+            }
+            // Marks the mutex as contended, so that the owner wakes one waiter when unlocking.
+            while (atom_exchange_u32(&m_state, 2) != 0)
+            {
+                futex_wait(&m_state, 2);
+            }
+        }
+        //! Unlocks the mutex.
+        void unlock()
+        {
+            if (atom_exchange_u32(&m_state, 0) == 2)
+            {
+                futex_wake_one(&m_state);
+            }
+        }
+    };
+
+    //! A condition variable that works with @ref FutexMutex.
+    //! @details Waiting threads are parked on one sequence number that is increased by every notification, so
+    //! one notification that happens after the waiting thread releases the mutex is never missed. Waiting threads
+    //! may be waken up spuriously, so the caller should check the condition in one loop.
+    class FutexConditionVariable
+    {
+        u32 volatile m_sequence;
+    public:
+        //! Constructs one condition variable.
+        FutexConditionVariable() : m_sequence(0) {}
+        FutexConditionVariable(const FutexConditionVariable&) = delete;
+        FutexConditionVariable(FutexConditionVariable&&) = delete;
+        FutexConditionVariable& operator=(const FutexConditionVariable&) = delete;
+        FutexConditionVariable& operator=(FutexConditionVariable&&) = delete;
+        //! Releases the mutex, blocks the current thread until the condition variable is notified, then locks the mutex again.
+        //! @param[in] mtx The mutex locked by the current thread.
+        void wait(FutexMutex& mtx)
+        {
+            u32 sequence = m_sequence;
+            mtx.unlock();
+            futex_wait(&m_sequence, sequence);
+            mtx.lock();
+        }
+        //! Wakes up at most one waiting thread.
+        void notify_one()
+        {
+            atom_inc_u32(&m_sequence);
+            futex_wake_one(&m_sequence);
+        }
+        //! Wakes up all waiting threads.
+        void notify_all()
+        {
+            atom_inc_u32(&m_sequence);
+            futex_wake_all(&m_sequence);
+        }
+    };
+
+    //! A signal that stores its state in one 32-bit integer.
+    //! @details This provides the same functionality as @ref ISignal, but is not one interface object, so it can be
+    //! embedded into other objects directly. Triggering one signal that no thread waits for does not call the system.
+    class FutexSignal
+    {
+        // 1 if the signal is triggered, 0 otherwise.
+        u32 volatile m_state;
+        // The number of threads that may be waiting.
+        u32 volatile m_num_waiters;
+        bool m_manual_reset;
+    public:
+        //! Constructs one signal. The signal is not triggered after creation.
+        //! @param[in] manual_reset If `false`, the signal is reset automatically when one waiting thread is passed.
+        //! If `true`, the signal stays in triggered state and passes all waiting threads until @ref reset is called.
+        explicit FutexSignal(bool manual_reset = false) : m_state(0), m_num_waiters(0), m_manual_reset(manual_reset) {}
+        FutexSignal(const FutexSignal&) = delete;
+        FutexSignal(FutexSignal&&) = delete;
+        FutexSignal& operator=(const FutexSignal&) = delete;
+        FutexSignal& operator=(FutexSignal&&) = delete;
+        //! Checks whether the signal is triggered without blocking. Resets the signal if it is triggered and
+        //! is not one manual reset signal.
+        //! @return Returns `true` if the signal is triggered, returns `false` otherwise.
+        bool try_wait()
+        {
+            if (m_manual_reset) return m_state != 0;
+            return atom_compare_exchange_u32(&m_state, 0, 1) == 1;
+        }
+        //! Blocks the current thread until the signal is triggered. Resets the signal if it is not one
+        //! manual reset signal.
+        void wait()
+        {
+            while (!try_wait())
+            {
+                atom_inc_u32(&m_num_waiters);
+                futex_wait(&m_state, 0);
+                atom_dec_u32(&m_num_waiters);
+            }
+        }
+        //! Triggers the signal and wakes up waiting threads.
+        void trigger()
+        {
+            atom_exchange_u32(&m_state, 1);
+            if (m_num_waiters)
+            {
+                if (m_manual_reset) futex_wake_all(&m_state);
+                else futex_wake_one(&m_state);
+            }
+        }
+        //! Resets the signal to non-triggered state.
+        void reset()
+        {
+            atom_exchange_u32(&m_state, 0);
+        }
+    };
+
+    //! A counting semaphore that stores its state in one 32-bit integer.
+    //! @details This provides the same functionality as @ref ISemaphore, but is not one interface object, so it can be
+    //! embedded into other objects directly. Acquiring one semaphore whose count is not zero and releasing one semaphore
+    //! that no thread waits for do not call the system.
+    class FutexSemaphore
+    {
+        // The available count.
+        u32 volatile m_count;
+        // The number of threads that may be waiting.
+        u32 volatile m_num_waiters;
+    public:
+        //! Constructs one semaphore.
+        //! @param[in] initial_count The initial count of the semaphore.
+        explicit FutexSemaphore(u32 initial_count = 0) : m_count(initial_count), m_num_waiters(0) {}
+        FutexSemaphore(const FutexSemaphore&) = delete;
+        FutexSemaphore(FutexSemaphore&&) = delete;
+        FutexSemaphore& operator=(const FutexSemaphore&) = delete;
+        FutexSemaphore& operator=(FutexSemaphore&&) = delete;
+        //! Tries to decrease the count by one without blocking.
+        //! @return Returns `true` if the count is decreased, returns `false` if the count is zero.
+        bool try_acquire()
+        {
+            u32 count = m_count;
+            while (count)
+            {
+                u32 old = atom_compare_exchange_u32(&m_count, count - 1, count);
+                if (old == count) return true;
+                count = old;
+            }
+            return false;
+        }
+        //! Blocks the current thread until the count is not zero, then decreases the count by one.
+        void acquire()
+        {
+            while (!try_acquire())
+            {
+                atom_inc_u32(&m_num_waiters);
+                futex_wait(&m_count, 0);
+                atom_dec_u32(&m_num_waiters);
+            }
+        }
+        //! Increases the count and wakes up waiting threads.
+        //! @param[in] count The number to add to the count.
+        void release(u32 count = 1)
+        {
+            atom_add_u32(&m_count, (i32)count);
+            if (m_num_waiters)
+            {
+                if (count == 1) futex_wake_one(&m_count);
+                else futex_wake_all(&m_count);
+            }
+        }
+    };
+
+    //! @}
+}
@@ -9,6 +9,11 @@
 */
 #pragma once
 #include "Base.hpp"
+
+#if defined(LUNA_COMPILER_MSVC) && (defined(LUNA_PLATFORM_X86_64) || defined(LUNA_PLATFORM_ARM64))
+#include <intrin.h>
+#endif
+
 namespace Luna
 {
     namespace Impl
@@ -231,6 +236,54 @@ namespace Luna
         {
             return crc64_table[index];
         }
+
+        //! Computes the 128-bit product of `a` and `b`, and stores the lower and higher 64 bits back to `a` and `b`.
+        inline void wymum(u64& a, u64& b)
+        {
+#if defined(__SIZEOF_INT128__)
+            __uint128_t r = a;
+            r *= b;
+            a = (u64)r;
+            b = (u64)(r >> 64);
+#elif defined(LUNA_COMPILER_MSVC) && defined(LUNA_PLATFORM_X86_64)
+            a = _umul128(a, b, &b);
+#elif defined(LUNA_COMPILER_MSVC) && defined(LUNA_PLATFORM_ARM64)
+            u64 lo = a * b;
+            b = __umulh(a, b);
+            a = lo;
+#else
+            u64 ha = a >> 32, hb = b >> 32, la = (u32)a, lb = (u32)b;
+            u64 rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+            u64 t = rl + (rm0 << 32);
+            u64 c = t < rl ? 1 : 0;
+            u64 lo = t + (rm1 << 32);
+            c += lo < t ? 1 : 0;
+            b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+            a = lo;
+#endif
+        }
+        inline u64 wymix(u64 a, u64 b)
+        {
+            wymum(a, b);
+            return a ^ b;
+        }
+        inline u64 wyr8(const u8* p)
+        {
+            u64 v;
+            memcpy(&v, p, 8);
+            return v;
+        }
+        inline u64 wyr4(const u8* p)
+        {
+            u32 v;
+            memcpy(&v, p, 4);
+            return v;
+        }
+        inline u64 wyr3(const u8* p, usize k)
+        {
+            return (((u64)p[0]) << 16) | (((u64)p[k >> 1]) << 8) | p[k - 1];
+        }
+        constexpr u64 wyhash_secret[4] = { 0x2d358dccaa6c78a5ULL, 0x8bb84b93962eacc9ULL, 0x4b33a62ed433d4a3ULL, 0x4d5a2da51de1aa47ULL };
     }
 
     //! @addtogroup Runtime
@@ -243,7 +296,8 @@ namespace Luna
     
     //! Computes a hash code for the specified binary data.
     //! @details This is the basic hash function that uses crc32 hash algorithm to hash 
-    //! any kind of binary data stream to a single hash value.
+    //! any kind of binary data stream to a single hash value. Prefer @ref wyhash for hashing keys at run time, 
+    //! which is much faster for data longer than a few bytes.
     //! @param[in] data A pointer to the data to be hashed.
     //! @param[in] size The length of the data in bytes.
     //! @param[in] h A initial hash value. If this is a new hash, set to 0 (which
@@ -377,5 +431,70 @@ namespace Luna
         return strhash<u64>(s, h);
     }
 
+    //! Computes a 64-bit hash code for the specified binary data using the wyhash algorithm.
+    //! @details Unlike @ref memhash, which hashes data byte by byte using crc tables, this function hashes data 
+    //! 8 or 16 bytes at a time, so it is much faster for hashing strings and binary keys at run time. This is used
+    //! by hash functions of @ref String, @ref Name and @ref Path, and should be preferred when hashing keys for containers.
+    //! 
+    //! The hash code may be different on platforms with different endianness, so it should not be stored persistently.
+    //! Use @ref memhash or @ref strhash if the hash code needs to be computed at compile time.
+    //! @param[in] data A pointer to the data to be hashed.
+    //! @param[in] size The length of the data in bytes.
+    //! @param[in] seed A initial hash value. See @ref memhash for details.
+    //! @return Returns the hash code of the data.
+    inline u64 wyhash(const void* data, usize size, u64 seed = 0)
+    {
+        using namespace Impl;
+        const u8* p = (const u8*)data;
+        seed ^= wymix(seed ^ wyhash_secret[0], wyhash_secret[1]);
+        u64 a, b;
+        if (size <= 16)
+        {
+            if (size >= 4)
+            {
+                a = (wyr4(p) << 32) | wyr4(p + ((size >> 3) << 2));
+                b = (wyr4(p + size - 4) << 32) | wyr4(p + size - 4 - ((size >> 3) << 2));
+            }
+            else if (size > 0)
+            {
+                a = wyr3(p, size);
+                b = 0;
+            }
+            else
+            {
+                a = b = 0;
+            }
+        }
+        else
+        {
+            usize i = size;
+            if (i >= 48)
+            {
+                u64 see1 = seed, see2 = seed;
+                do
+                {
+                    seed = wymix(wyr8(p) ^ wyhash_secret[1], wyr8(p + 8) ^ seed);
+                    see1 = wymix(wyr8(p + 16) ^ wyhash_secret[2], wyr8(p + 24) ^ see1);
+                    see2 = wymix(wyr8(p + 32) ^ wyhash_secret[3], wyr8(p + 40) ^ see2);
+                    p += 48;
+                    i -= 48;
+                } while (i >= 48);
+                seed ^= see1 ^ see2;
+            }
+            while (i > 16)
+            {
+                seed = wymix(wyr8(p) ^ wyhash_secret[1], wyr8(p + 8) ^ seed);
+                i -= 16;
+                p += 16;
+            }
+            a = wyr8(p + i - 16);
+            b = wyr8(p + i - 8);
+        }
+        a ^= wyhash_secret[1];
+        b ^= seed;
+        wymum(a, b);
+        return wymix(a ^ wyhash_secret[0] ^ size, b ^ wyhash_secret[1]);
+    }
+
     //! @}
 }
@@ -8,7 +8,7 @@
 * @date 2022/5/1
 */
 #pragma once
-#include "Impl/RobinHoodHashTable.hpp"
+#include "Impl/SwissHashTable.hpp"
 #include "TypeInfo.hpp"
 
 namespace Luna
@@ -18,7 +18,8 @@ namespace Luna
     
     //! An container that contains key-value pairs with unique keys using open-addressing hashing algorithm.
     //! @remark LunaSDK provides two kinds of hashing-based containers: open-addressing containers and closed-addressing containers.
-    //! The following containers are open-addressing containers, implemented using Robinhood hashing:
+    //! The following containers are open-addressing containers, implemented using one control byte per slot and probing slots in groups 
+    //! of 16 (accelerated by SSE2 or Neon if available):
     //! 
     //! 1. @ref HashMap
     //! 2. @ref HashSet
@@ -65,12 +66,12 @@ namespace Luna
         using const_reference = const value_type&;
         using pointer = value_type*;
         using const_pointer = const value_type*;
-        using iterator = RobinHoodHashing::Iterator<value_type, false>;
-        using const_iterator = RobinHoodHashing::Iterator<value_type, true>;
+        using iterator = SwissHashing::Iterator<value_type, false>;
+        using const_iterator = SwissHashing::Iterator<value_type, true>;
 
     private:
 
-        using table_type = RobinHoodHashing::HashTable<key_type, value_type, Impl::MapExtractKey<key_type, value_type>, hasher, key_equal, allocator_type>;
+        using table_type = SwissHashing::HashTable<key_type, value_type, Impl::MapExtractKey<key_type, value_type>, hasher, key_equal, allocator_type>;
 
         table_type m_base;
 
@@ -134,4 +134,8 @@ namespace Luna
         return __sync_val_compare_and_swap(dest, comperand, exchange);
     }
 
+    inline void atom_memory_barrier()
+    {
+        __sync_synchronize();
+    }
 }
\ No newline at end of file
@@ -161,4 +161,8 @@ namespace Luna
     }
 #endif
 
+    inline void atom_memory_barrier()
+    {
+        MemoryBarrier();
+    }
 }
\ No newline at end of file
@@ -0,0 +1,407 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SoAVector.inl
+* @author JXMaster
+* @date 2024/3/11
+*/
+#pragma once
+#include "../SoAVector.hpp"
+
+namespace Luna
+{
+    template <typename _Alloc, typename... _Tys>
+    inline BasicSoAVector<_Alloc, _Tys...>::BasicSoAVector() :
+        m_allocator_and_buffer(allocator_type(), nullptr),
+        m_size(0),
+        m_capacity(0)
+    {
+        memzero(m_columns, sizeof(m_columns));
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline BasicSoAVector<_Alloc, _Tys...>::BasicSoAVector(const allocator_type& alloc) :
+        m_allocator_and_buffer(alloc, nullptr),
+        m_size(0),
+        m_capacity(0)
+    {
+        memzero(m_columns, sizeof(m_columns));
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline BasicSoAVector<_Alloc, _Tys...>::BasicSoAVector(const BasicSoAVector& rhs) :
+        m_allocator_and_buffer(rhs.m_allocator_and_buffer.first(), nullptr),
+        m_size(0),
+        m_capacity(0)
+    {
+        memzero(m_columns, sizeof(m_columns));
+        if (!rhs.empty())
+        {
+            m_allocator_and_buffer.second() = internal_allocate(rhs.m_size, m_columns);
+            m_capacity = rhs.m_size;
+            internal_copy_construct(indices_t(), rhs);
+            m_size = rhs.m_size;
+        }
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline BasicSoAVector<_Alloc, _Tys...>::BasicSoAVector(BasicSoAVector&& rhs) :
+        m_allocator_and_buffer(move(rhs.m_allocator_and_buffer.first()), rhs.m_allocator_and_buffer.second()),
+        m_size(rhs.m_size),
+        m_capacity(rhs.m_capacity)
+    {
+        memcpy(m_columns, rhs.m_columns, sizeof(m_columns));
+        rhs.m_allocator_and_buffer.second() = nullptr;
+        memzero(rhs.m_columns, sizeof(rhs.m_columns));
+        rhs.m_size = 0;
+        rhs.m_capacity = 0;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline BasicSoAVector<_Alloc, _Tys...>& BasicSoAVector<_Alloc, _Tys...>::operator=(const BasicSoAVector& rhs)
+    {
+        if (this != &rhs)
+        {
+            clear();
+            reserve(rhs.m_size);
+            internal_copy_construct(indices_t(), rhs);
+            m_size = rhs.m_size;
+        }
+        return *this;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline BasicSoAVector<_Alloc, _Tys...>& BasicSoAVector<_Alloc, _Tys...>::operator=(BasicSoAVector&& rhs)
+    {
+        if (this != &rhs)
+        {
+            internal_free_buffer();
+            m_allocator_and_buffer.first() = move(rhs.m_allocator_and_buffer.first());
+            m_allocator_and_buffer.second() = rhs.m_allocator_and_buffer.second();
+            memcpy(m_columns, rhs.m_columns, sizeof(m_columns));
+            m_size = rhs.m_size;
+            m_capacity = rhs.m_capacity;
+            rhs.m_allocator_and_buffer.second() = nullptr;
+            memzero(rhs.m_columns, sizeof(rhs.m_columns));
+            rhs.m_size = 0;
+            rhs.m_capacity = 0;
+        }
+        return *this;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline BasicSoAVector<_Alloc, _Tys...>::~BasicSoAVector()
+    {
+        internal_free_buffer();
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline usize BasicSoAVector<_Alloc, _Tys...>::size() const
+    {
+        return m_size;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline usize BasicSoAVector<_Alloc, _Tys...>::capacity() const
+    {
+        return m_capacity;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline bool BasicSoAVector<_Alloc, _Tys...>::empty() const
+    {
+        return m_size == 0;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::reserve(usize new_cap)
+    {
+        if (new_cap > m_capacity)
+        {
+            internal_reallocate(new_cap);
+        }
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::resize(usize n)
+    {
+        reserve(n);
+        if (n > m_size)
+        {
+            internal_default_construct(indices_t(), m_size, n);
+        }
+        else if (n < m_size)
+        {
+            internal_destruct(indices_t(), n, m_size);
+        }
+        m_size = n;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::shrink_to_fit()
+    {
+        if (m_capacity == m_size) return;
+        if (!m_size)
+        {
+            internal_free_buffer();
+            return;
+        }
+        internal_reallocate(m_size);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::clear()
+    {
+        internal_destruct(indices_t(), 0, m_size);
+        m_size = 0;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::reference BasicSoAVector<_Alloc, _Tys...>::operator[](usize n)
+    {
+        lucheck(n < m_size);
+        return internal_get(indices_t(), n);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::const_reference BasicSoAVector<_Alloc, _Tys...>::operator[](usize n) const
+    {
+        lucheck(n < m_size);
+        return internal_get(indices_t(), n);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::reference BasicSoAVector<_Alloc, _Tys...>::at(usize n)
+    {
+        lucheck(n < m_size);
+        return internal_get(indices_t(), n);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::const_reference BasicSoAVector<_Alloc, _Tys...>::at(usize n) const
+    {
+        lucheck(n < m_size);
+        return internal_get(indices_t(), n);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::reference BasicSoAVector<_Alloc, _Tys...>::front()
+    {
+        lucheck(!empty());
+        return internal_get(indices_t(), 0);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::const_reference BasicSoAVector<_Alloc, _Tys...>::front() const
+    {
+        lucheck(!empty());
+        return internal_get(indices_t(), 0);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::reference BasicSoAVector<_Alloc, _Tys...>::back()
+    {
+        lucheck(!empty());
+        return internal_get(indices_t(), m_size - 1);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::const_reference BasicSoAVector<_Alloc, _Tys...>::back() const
+    {
+        lucheck(!empty());
+        return internal_get(indices_t(), m_size - 1);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize _I>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::template column_type<_I>* BasicSoAVector<_Alloc, _Tys...>::column_data()
+    {
+        return (column_type<_I>*)m_columns[_I];
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize _I>
+    inline const typename BasicSoAVector<_Alloc, _Tys...>::template column_type<_I>* BasicSoAVector<_Alloc, _Tys...>::column_data() const
+    {
+        return (const column_type<_I>*)m_columns[_I];
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize _I>
+    inline Span<typename BasicSoAVector<_Alloc, _Tys...>::template column_type<_I>> BasicSoAVector<_Alloc, _Tys...>::column()
+    {
+        return Span<column_type<_I>>(column_data<_I>(), m_size);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize _I>
+    inline Span<const typename BasicSoAVector<_Alloc, _Tys...>::template column_type<_I>> BasicSoAVector<_Alloc, _Tys...>::column() const
+    {
+        return Span<const column_type<_I>>(column_data<_I>(), m_size);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <typename... _Args>
+    inline void BasicSoAVector<_Alloc, _Tys...>::emplace_back(_Args&&... args)
+    {
+        static_assert(sizeof...(_Args) == num_columns, "One argument must be specified for every column.");
+        internal_expand_reserve(m_size + 1);
+        internal_construct_back(indices_t(), forward<_Args>(args)...);
+        ++m_size;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::push_back(const value_type& val)
+    {
+        internal_expand_reserve(m_size + 1);
+        internal_copy_back(indices_t(), val);
+        ++m_size;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::push_back(value_type&& val)
+    {
+        internal_expand_reserve(m_size + 1);
+        internal_move_back(indices_t(), val);
+        ++m_size;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::pop_back()
+    {
+        lucheck(!empty());
+        internal_destruct(indices_t(), m_size - 1, m_size);
+        --m_size;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::erase(usize n)
+    {
+        lucheck(n < m_size);
+        internal_erase(indices_t(), n);
+        --m_size;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::swap_erase(usize n)
+    {
+        lucheck(n < m_size);
+        internal_swap_erase(indices_t(), n);
+        --m_size;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::swap(BasicSoAVector& rhs)
+    {
+        BasicSoAVector tmp(move(*this));
+        *this = move(rhs);
+        rhs = move(tmp);
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::allocator_type BasicSoAVector<_Alloc, _Tys...>::get_allocator() const
+    {
+        return m_allocator_and_buffer.first();
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline usize BasicSoAVector<_Alloc, _Tys...>::internal_num_blocks(usize capacity)
+    {
+        usize r = 0;
+        for (usize i = 0; i < num_columns; ++i)
+        {
+            r += (column_sizes[i] * capacity + SOA_COLUMN_ALIGNMENT - 1) / SOA_COLUMN_ALIGNMENT;
+        }
+        return r;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline SoAVectorImpl::ColumnBlock* BasicSoAVector<_Alloc, _Tys...>::internal_allocate(usize capacity, void** columns)
+    {
+        SoAVectorImpl::ColumnBlock* buffer = m_allocator_and_buffer.first().template allocate<SoAVectorImpl::ColumnBlock>(internal_num_blocks(capacity));
+        SoAVectorImpl::ColumnBlock* cur = buffer;
+        for (usize i = 0; i < num_columns; ++i)
+        {
+            columns[i] = cur;
+            cur += (column_sizes[i] * capacity + SOA_COLUMN_ALIGNMENT - 1) / SOA_COLUMN_ALIGNMENT;
+        }
+        return buffer;
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_free(SoAVectorImpl::ColumnBlock* buffer, usize capacity)
+    {
+        m_allocator_and_buffer.first().template deallocate<SoAVectorImpl::ColumnBlock>(buffer, internal_num_blocks(capacity));
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_free_buffer()
+    {
+        clear();
+        if (m_allocator_and_buffer.second())
+        {
+            internal_free(m_allocator_and_buffer.second(), m_capacity);
+            m_allocator_and_buffer.second() = nullptr;
+            memzero(m_columns, sizeof(m_columns));
+            m_capacity = 0;
+        }
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_expand_reserve(usize new_least_cap)
+    {
+        if (new_least_cap > m_capacity)
+        {
+            reserve(max(max(new_least_cap, m_capacity * 2), (usize)4));    // Double the size by default.
+        }
+    }
+    template <typename _Alloc, typename... _Tys>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_reallocate(usize new_cap)
+    {
+        void* new_columns[num_columns];
+        SoAVectorImpl::ColumnBlock* new_buffer = internal_allocate(new_cap, new_columns);
+        if (m_allocator_and_buffer.second())
+        {
+            internal_relocate(indices_t(), new_columns);
+            internal_free(m_allocator_and_buffer.second(), m_capacity);
+        }
+        m_allocator_and_buffer.second() = new_buffer;
+        memcpy(m_columns, new_columns, sizeof(m_columns));
+        m_capacity = new_cap;
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_relocate(SoAVectorImpl::IndexSequence<_Is...>, void** dst_columns)
+    {
+        (copy_relocate_range(column_data<_Is>(), column_data<_Is>() + m_size, (column_type<_Is>*)dst_columns[_Is]), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_copy_construct(SoAVectorImpl::IndexSequence<_Is...>, const BasicSoAVector& rhs)
+    {
+        (copy_construct_range(rhs.column_data<_Is>(), rhs.column_data<_Is>() + rhs.m_size, column_data<_Is>()), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_default_construct(SoAVectorImpl::IndexSequence<_Is...>, usize first, usize last)
+    {
+        (default_construct_range(column_data<_Is>() + first, column_data<_Is>() + last), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_destruct(SoAVectorImpl::IndexSequence<_Is...>, usize first, usize last)
+    {
+        (destruct_range(column_data<_Is>() + first, column_data<_Is>() + last), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is, typename... _Args>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_construct_back(SoAVectorImpl::IndexSequence<_Is...>, _Args&&... args)
+    {
+        (new (column_data<_Is>() + m_size) column_type<_Is>(forward<_Args>(args)), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_copy_back(SoAVectorImpl::IndexSequence<_Is...>, const value_type& val)
+    {
+        (new (column_data<_Is>() + m_size) column_type<_Is>(get<_Is>(val)), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_move_back(SoAVectorImpl::IndexSequence<_Is...>, value_type& val)
+    {
+        (new (column_data<_Is>() + m_size) column_type<_Is>(move(get<_Is>(val))), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_erase(SoAVectorImpl::IndexSequence<_Is...>, usize n)
+    {
+        (move_assign_range(column_data<_Is>() + n + 1, column_data<_Is>() + m_size, column_data<_Is>() + n), ...);
+        (destruct(column_data<_Is>() + m_size - 1), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline void BasicSoAVector<_Alloc, _Tys...>::internal_swap_erase(SoAVectorImpl::IndexSequence<_Is...>, usize n)
+    {
+        if (n != m_size - 1)
+        {
+            ((column_data<_Is>()[n] = move(column_data<_Is>()[m_size - 1])), ...);
+        }
+        (destruct(column_data<_Is>() + m_size - 1), ...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::reference BasicSoAVector<_Alloc, _Tys...>::internal_get(SoAVectorImpl::IndexSequence<_Is...>, usize n)
+    {
+        return reference(column_data<_Is>()[n]...);
+    }
+    template <typename _Alloc, typename... _Tys>
+    template <usize... _Is>
+    inline typename BasicSoAVector<_Alloc, _Tys...>::const_reference BasicSoAVector<_Alloc, _Tys...>::internal_get(SoAVectorImpl::IndexSequence<_Is...>, usize n) const
+    {
+        return const_reference(column_data<_Is>()[n]...);
+    }
+}
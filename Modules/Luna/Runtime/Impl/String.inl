@@ -14,111 +14,61 @@ namespace Luna
 {
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString() :
-        m_allocator_and_buffer(allocator_type(), nullptr),
+        m_allocator_and_buffer(allocator_type(), Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
         m_size(0),
-        m_capacity(0) {}
+        m_capacity(INLINE_CAPACITY) {}
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr),
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
         m_size(0),
-        m_capacity(0) {}
+        m_capacity(INLINE_CAPACITY) {}
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(usize count, value_type ch, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr),
-        m_size(count),
-        m_capacity(count)
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        if (count)
-        {
-            m_allocator_and_buffer.second() = allocate(count + 1);
-            for (value_type* i = m_allocator_and_buffer.second(); i < m_allocator_and_buffer.second() + m_size; ++i)
-            {
-                *i = ch;
-            }
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
-        }
-        else
-        {
-            m_allocator_and_buffer.second() = nullptr;
-        }
+        assign(count, ch);
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(const BasicString& rhs, usize pos, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr)
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        usize count = rhs.size() - pos;
-        m_size = count;
-        m_capacity = count;
-        if (count)
-        {
-            m_allocator_and_buffer.second() = allocate(count + 1);
-            memcpy(m_allocator_and_buffer.second(), rhs.c_str() + pos, sizeof(value_type) * count);
-            m_allocator_and_buffer.second()[count] = (value_type)0;
-        }
-        else
-        {
-            m_allocator_and_buffer.second() = nullptr;
-        }
+        internal_init(rhs.c_str() + pos, rhs.size() - pos);
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(const BasicString& rhs, usize pos, usize count, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr)
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
         count = (count == npos) ? rhs.size() - pos : count;
-        m_size = count;
-        m_capacity = count;
-        if (count)
-        {
-            m_allocator_and_buffer.second() = allocate(count + 1);
-            memcpy(m_allocator_and_buffer.second(), rhs.c_str() + pos, sizeof(value_type) * count);
-            m_allocator_and_buffer.second()[count] = (value_type)0;
-        }
-        else
-        {
-            m_allocator_and_buffer.second() = nullptr;
-        }
+        internal_init(rhs.c_str() + pos, count);
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(const value_type* s, usize count, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr),
-        m_size(count),
-        m_capacity(count)
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        if (count)
-        {
-            m_allocator_and_buffer.second() = allocate(count + 1);
-            memcpy(m_allocator_and_buffer.second(), s, sizeof(value_type) * count);
-            m_allocator_and_buffer.second()[count] = (value_type)0;
-        }
-        else
-        {
-            m_allocator_and_buffer.second() = nullptr;
-        }
+        internal_init(s, count);
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(const value_type* s, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr)
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        usize count = strlength(s);
-        m_size = count;
-        m_capacity = count;
-        if (count)
-        {
-            m_allocator_and_buffer.second() = allocate(count + 1);
-            memcpy(m_allocator_and_buffer.second(), s, sizeof(value_type) * count);
-            m_allocator_and_buffer.second()[count] = (value_type)0;
-        }
-        else
-        {
-            m_allocator_and_buffer.second() = nullptr;
-        }
+        internal_init(s, strlength(s));
     }
     template <typename _Char, typename _Alloc>
     template <typename _InputIt>
     inline BasicString<_Char, _Alloc>::BasicString(_InputIt first, _InputIt last, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr),
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
         m_size(0),
-        m_capacity(0)
+        m_capacity(INLINE_CAPACITY)
     {
         for (; first != last; ++first)
         {
@@ -127,181 +77,93 @@ namespace Luna
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(const BasicString& rhs) :
-        m_allocator_and_buffer(rhs.m_allocator_and_buffer.first(), nullptr)
+        m_allocator_and_buffer(rhs.m_allocator_and_buffer.first(), Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        if (!rhs.empty())
-        {
-            m_size = rhs.m_size;
-            m_capacity = rhs.m_size;
-            m_allocator_and_buffer.second() = allocate(m_size + 1);
-            memcpy(m_allocator_and_buffer.second(), rhs.m_allocator_and_buffer.second(), sizeof(value_type) * (m_size + 1));
-        }
-        else
-        {
-            m_size = 0;
-            m_capacity = 0;
-            m_allocator_and_buffer.second() = nullptr;
-        }
+        internal_init(rhs.c_str(), rhs.m_size);
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(const BasicString& rhs, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr)
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        if (!rhs.empty())
-        {
-            m_size = rhs.m_size;
-            m_capacity = rhs.m_size;
-            m_allocator_and_buffer.second() = allocate(m_size + 1);
-            memcpy(m_allocator_and_buffer.second(), rhs.m_allocator_and_buffer.second(), sizeof(value_type) * (m_size + 1));
-        }
-        else
-        {
-            m_size = 0;
-            m_capacity = 0;
-            m_allocator_and_buffer.second() = nullptr;
-        }
+        internal_init(rhs.c_str(), rhs.m_size);
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(BasicString&& rhs) :
-        m_allocator_and_buffer(move(rhs.m_allocator_and_buffer.first()), rhs.m_allocator_and_buffer.second()),
-        m_size(rhs.m_size),
-        m_capacity(rhs.m_capacity)
+        m_allocator_and_buffer(move(rhs.m_allocator_and_buffer.first()), Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        rhs.m_allocator_and_buffer.second() = nullptr;
-        rhs.m_size = 0;
-        rhs.m_capacity = 0;
+        internal_take(rhs);
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(BasicString&& rhs, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr)
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        if (m_allocator_and_buffer.first() == rhs.m_allocator_and_buffer.first())
+        if (rhs.is_inline() || m_allocator_and_buffer.first() == rhs.m_allocator_and_buffer.first())
         {
-            m_allocator_and_buffer.second() = rhs.m_allocator_and_buffer.second();
-            m_size = rhs.m_size;
-            m_capacity = rhs.m_capacity;
-            rhs.m_allocator_and_buffer.second() = nullptr;
-            rhs.m_size = 0;
-            rhs.m_capacity = 0;
+            internal_take(rhs);
         }
         else
         {
-            if (!rhs.empty())
-            {
-                m_size = rhs.m_size;
-                m_capacity = rhs.m_size;
-                m_allocator_and_buffer.second() = allocate(m_size + 1);
-                memcpy(m_allocator_and_buffer.second(), rhs.m_allocator_and_buffer.second(), sizeof(value_type) * (m_size + 1));
-                rhs.clear();
-            }
-            else
-            {
-                m_size = 0;
-                m_capacity = 0;
-                m_allocator_and_buffer.second() = nullptr;
-            }
+            internal_init(rhs.c_str(), rhs.m_size);
+            rhs.clear();
         }
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>::BasicString(InitializerList<value_type> ilist, const allocator_type& alloc) :
-        m_allocator_and_buffer(alloc, nullptr),
-        m_size(ilist.size()),
-        m_capacity(ilist.size())
+        m_allocator_and_buffer(alloc, Impl::StringBuffer<_Char, INLINE_CAPACITY>()),
+        m_size(0),
+        m_capacity(INLINE_CAPACITY)
     {
-        if (m_size)
-        {
-            m_allocator_and_buffer.second() = allocate(ilist.size() + 1);
-            value_type* i = m_allocator_and_buffer.second();
-            for (auto iter = ilist.begin(); iter != ilist.end(); ++iter)
-            {
-                *i = *iter;
-                ++i;
-            }
-            m_allocator_and_buffer.second()[m_size] = 0;
-        }
+        internal_init(ilist.begin(), ilist.size());
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>& BasicString<_Char, _Alloc>::operator=(const BasicString& rhs)
     {
-        free_buffer();
-        if (!rhs.empty())
+        if (this != &rhs)
         {
-            reserve(rhs.m_size);
-            memcpy(m_allocator_and_buffer.second(), rhs.c_str(), (rhs.size() + 1) * sizeof(value_type));
-            m_size = rhs.size();
+            assign(rhs.c_str(), rhs.size());
         }
         return *this;
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>& BasicString<_Char, _Alloc>::operator=(BasicString&& rhs)
     {
-        free_buffer();
-        if (m_allocator_and_buffer.first() == rhs.m_allocator_and_buffer.first())
+        if (this == &rhs) return *this;
+        if (rhs.is_inline() || m_allocator_and_buffer.first() == rhs.m_allocator_and_buffer.first())
         {
-            Luna::swap(m_allocator_and_buffer.second(), rhs.m_allocator_and_buffer.second());
-            Luna::swap(m_size, rhs.m_size);
-            Luna::swap(m_capacity, rhs.m_capacity);
+            free_buffer();
+            internal_take(rhs);
         }
         else
         {
-            if (!rhs.empty())
-            {
-                m_size = rhs.m_size;
-                m_capacity = rhs.m_size;
-                m_allocator_and_buffer.second() = allocate(m_size + 1);
-                memcpy(m_allocator_and_buffer.second(), rhs.m_allocator_and_buffer.second(), sizeof(value_type) * (m_size + 1));
-                rhs.clear();
-            }
+            assign(rhs.c_str(), rhs.size());
+            rhs.clear();
         }
         return *this;
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>& BasicString<_Char, _Alloc>::operator=(const value_type* s)
     {
-        clear();
-        usize count = strlen(s);
-        reserve(count);
-        if (count)
-        {
-            memcpy(m_allocator_and_buffer.second(), s, sizeof(value_type) * count);
-
-        }
-        m_size = count;
-        if (m_allocator_and_buffer.second())
-        {
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
-        }
+        assign(s);
         return *this;
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>& BasicString<_Char, _Alloc>::operator=(value_type ch)
     {
-        clear();
-        reserve(1);
-        m_allocator_and_buffer.second()[0] = ch;
-        m_size = 1;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        assign(&ch, 1);
         return *this;
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc>& BasicString<_Char, _Alloc>::operator=(InitializerList<value_type> ilist)
     {
-        clear();
-        reserve(ilist.size());
-        if (ilist.size())
-        {
-            value_type* i = m_allocator_and_buffer.second();
-            for (auto iter = ilist.begin(); iter != ilist.end(); ++iter)
-            {
-                *i = *iter;
-                ++i;
-            }
-        }
-        m_size = ilist.size();
-        if (m_allocator_and_buffer.second())
-        {
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
-        }
+        assign(ilist.begin(), ilist.size());
         return *this;
     }
     template <typename _Char, typename _Alloc>
@@ -309,54 +171,52 @@ namespace Luna
     {
         free_buffer();
     }
-    //! May returns `nullptr` if the string is empty.
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::pointer BasicString<_Char, _Alloc>::data()
     {
-        return m_allocator_and_buffer.second();
+        return internal_data();
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_pointer BasicString<_Char, _Alloc>::data() const
     {
-        return m_allocator_and_buffer.second();
+        return internal_data();
     }
-    //! Unlike `data`, this call always returns a valid string, not `nullptr`, even if the string is empty.
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_pointer BasicString<_Char, _Alloc>::c_str() const
     {
-        return m_allocator_and_buffer.second() ? m_allocator_and_buffer.second() : Impl::StringTraits<value_type>::null_string;
+        return internal_data();
     }
     // Returns a pointer to the first element. Can only be `nullptr` if `size` and `capacity` is both 0.
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::iterator BasicString<_Char, _Alloc>::begin()
     {
-        return m_allocator_and_buffer.second();
+        return internal_data();
     }
     // Returns a pointer to the element next to the last element. Can only be `nullptr` if `size` and `capacity` is both 0.
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::iterator BasicString<_Char, _Alloc>::end()
     {
-        return m_allocator_and_buffer.second() + m_size;
+        return internal_data() + m_size;
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_iterator BasicString<_Char, _Alloc>::begin() const
     {
-        return m_allocator_and_buffer.second();
+        return internal_data();
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_iterator BasicString<_Char, _Alloc>::end() const
     {
-        return m_allocator_and_buffer.second() + m_size;
+        return internal_data() + m_size;
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_iterator BasicString<_Char, _Alloc>::cbegin() const
     {
-        return m_allocator_and_buffer.second();
+        return internal_data();
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_iterator BasicString<_Char, _Alloc>::cend() const
     {
-        return m_allocator_and_buffer.second() + m_size;
+        return internal_data() + m_size;
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::reverse_iterator BasicString<_Char, _Alloc>::rbegin()
@@ -414,12 +274,12 @@ namespace Luna
         if (new_cap > m_capacity)
         {
             value_type* new_buf = allocate(new_cap + 1);
-            if (m_allocator_and_buffer.second())
+            memcpy(new_buf, internal_data(), sizeof(value_type) * (m_size + 1));
+            if (!is_inline())
             {
-                copy_relocate_range(begin(), end() + 1, new_buf);
-                deallocate(m_allocator_and_buffer.second(), m_capacity);
+                deallocate(m_allocator_and_buffer.second().heap_chars, m_capacity);
             }
-            m_allocator_and_buffer.second() = new_buf;
+            m_allocator_and_buffer.second().heap_chars = new_buf;
             m_capacity = new_cap;
         }
     }
@@ -429,104 +289,100 @@ namespace Luna
         reserve(n);
         if (n > m_size)
         {
-            fill_construct_range(m_allocator_and_buffer.second() + m_size, m_allocator_and_buffer.second() + n, v);
+            fill_construct_range(internal_data() + m_size, internal_data() + n, v);
         }
         m_size = n;
-        m_allocator_and_buffer.second()[n] = (value_type)0;
+        internal_data()[n] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::shrink_to_fit()
     {
-        if (m_capacity != m_size)
+        if (is_inline() || m_capacity == m_size) return;
+        value_type* old_buf = m_allocator_and_buffer.second().heap_chars;
+        usize old_capacity = m_capacity;
+        if (m_size <= INLINE_CAPACITY)
         {
-            if (!m_size)
-            {
-                free_buffer();
-            }
-            else
-            {
-                value_type* new_buf = allocate(m_size + 1);
-                if (m_allocator_and_buffer.second())
-                {
-                    memcpy(new_buf, m_allocator_and_buffer.second(), sizeof(value_type) * (m_size + 1));
-                    deallocate(m_allocator_and_buffer.second(), m_capacity);
-                }
-                m_allocator_and_buffer.second() = new_buf;
-                m_capacity = m_size;
-            }
+            // Moves characters back to the inline buffer.
+            memcpy(m_allocator_and_buffer.second().inline_chars, old_buf, sizeof(value_type) * (m_size + 1));
+            m_capacity = INLINE_CAPACITY;
         }
+        else
+        {
+            value_type* new_buf = allocate(m_size + 1);
+            memcpy(new_buf, old_buf, sizeof(value_type) * (m_size + 1));
+            m_allocator_and_buffer.second().heap_chars = new_buf;
+            m_capacity = m_size;
+        }
+        deallocate(old_buf, old_capacity);
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::reference BasicString<_Char, _Alloc>::operator[] (usize n)
     {
         luassert(n < m_size);
-        return m_allocator_and_buffer.second()[n];
+        return internal_data()[n];
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_reference BasicString<_Char, _Alloc>::operator[] (usize n) const
     {
         luassert(n < m_size);
-        return m_allocator_and_buffer.second()[n];
+        return internal_data()[n];
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::reference BasicString<_Char, _Alloc>::at(usize n)
     {
         luassert(n < m_size);
-        return m_allocator_and_buffer.second()[n];
+        return internal_data()[n];
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_reference BasicString<_Char, _Alloc>::at(usize n) const
     {
         luassert(n < m_size);
-        return m_allocator_and_buffer.second()[n];
+        return internal_data()[n];
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::reference BasicString<_Char, _Alloc>::front()
     {
         luassert(!empty());
-        return m_allocator_and_buffer.second()[0];
+        return internal_data()[0];
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_reference BasicString<_Char, _Alloc>::front() const
     {
         luassert(!empty());
-        return m_allocator_and_buffer.second()[0];
+        return internal_data()[0];
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::reference BasicString<_Char, _Alloc>::back()
     {
         luassert(!empty());
-        return m_allocator_and_buffer.second()[m_size - 1];
+        return internal_data()[m_size - 1];
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::const_reference BasicString<_Char, _Alloc>::back() const
     {
         luassert(!empty());
-        return m_allocator_and_buffer.second()[m_size - 1];
+        return internal_data()[m_size - 1];
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::clear()
     {
-        if (m_allocator_and_buffer.second())
-        {
-            m_allocator_and_buffer.second()[0] = (value_type)0;
-        }
+        internal_data()[0] = (value_type)0;
         m_size = 0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::push_back(value_type ch)
     {
         internal_expand_reserve(size() + 1);
-        m_allocator_and_buffer.second()[m_size] = ch;
+        internal_data()[m_size] = ch;
         ++m_size;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::pop_back()
     {
         luassert(!empty());
         --m_size;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::assign(usize count, value_type ch)
@@ -535,8 +391,8 @@ namespace Luna
         reserve(count);
         if (count)
         {
-            fill_construct_range(m_allocator_and_buffer.second(), m_allocator_and_buffer.second() + count, ch);
-            m_allocator_and_buffer.second()[count] = (value_type)0;
+            fill_construct_range(internal_data(), internal_data() + count, ch);
+            internal_data()[count] = (value_type)0;
         }
         m_size = count;
     }
@@ -553,21 +409,15 @@ namespace Luna
         reserve(count);
         if (count)
         {
-            memcpy(m_allocator_and_buffer.second(), str.c_str() + pos, count * sizeof(value_type));
-            m_allocator_and_buffer.second()[count] = (value_type)0;
+            memcpy(internal_data(), str.c_str() + pos, count * sizeof(value_type));
+            internal_data()[count] = (value_type)0;
         }
         m_size = count;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::assign(BasicString&& str)
     {
-        free_buffer();
-        m_allocator_and_buffer.second() = str.m_allocator_and_buffer.second();
-        m_capacity = str.m_capacity;
-        m_size = str.m_size;
-        str.m_allocator_and_buffer.second() = nullptr;
-        str.m_capacity = 0;
-        str.m_size = 0;
+        *this = move(str);
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::assign(const value_type* s, usize count)
@@ -576,8 +426,8 @@ namespace Luna
         reserve(count);
         if (count)
         {
-            memcpy(m_allocator_and_buffer.second(), s, count * sizeof(value_type));
-            m_allocator_and_buffer.second()[count] = (value_type)0;
+            memcpy(internal_data(), s, count * sizeof(value_type));
+            internal_data()[count] = (value_type)0;
             m_size = count;
         }
     }
@@ -589,8 +439,8 @@ namespace Luna
         reserve(count);
         if (count)
         {
-            memcpy(m_allocator_and_buffer.second(), s, count * sizeof(value_type));
-            m_allocator_and_buffer.second()[count] = (value_type)0;
+            memcpy(internal_data(), s, count * sizeof(value_type));
+            internal_data()[count] = (value_type)0;
             m_size = count;
         }
     }
@@ -616,11 +466,11 @@ namespace Luna
         internal_expand_reserve(m_size + count);
         if (index != m_size)
         {
-            memmove(m_allocator_and_buffer.second() + index + count, m_allocator_and_buffer.second() + index, sizeof(value_type) * (m_size - index));
+            memmove(internal_data() + index + count, internal_data() + index, sizeof(value_type) * (m_size - index));
         }
-        fill_construct_range(m_allocator_and_buffer.second() + index, m_allocator_and_buffer.second() + index + count, ch);
+        fill_construct_range(internal_data() + index, internal_data() + index + count, ch);
         m_size += count;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::insert(usize index, const value_type* s)
@@ -630,11 +480,11 @@ namespace Luna
         internal_expand_reserve(m_size + count);
         if (index != m_size)
         {
-            memmove(m_allocator_and_buffer.second() + index + count, m_allocator_and_buffer.second() + index, sizeof(value_type) * (m_size - index));
+            memmove(internal_data() + index + count, internal_data() + index, sizeof(value_type) * (m_size - index));
         }
-        memcpy(m_allocator_and_buffer.second() + index, s, sizeof(value_type) * count);
+        memcpy(internal_data() + index, s, sizeof(value_type) * count);
         m_size += count;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::insert(usize index, const value_type* s, usize count)
@@ -643,11 +493,11 @@ namespace Luna
         internal_expand_reserve(m_size + count);
         if (index != m_size)
         {
-            memmove(m_allocator_and_buffer.second() + index + count, m_allocator_and_buffer.second() + index, sizeof(value_type) * (m_size - index));
+            memmove(internal_data() + index + count, internal_data() + index, sizeof(value_type) * (m_size - index));
         }
-        memcpy(m_allocator_and_buffer.second() + index, s, sizeof(value_type) * count);
+        memcpy(internal_data() + index, s, sizeof(value_type) * count);
         m_size += count;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::insert(usize index, const BasicString& str)
@@ -657,11 +507,11 @@ namespace Luna
         internal_expand_reserve(m_size + count);
         if (index != m_size)
         {
-            memmove(m_allocator_and_buffer.second() + index + count, m_allocator_and_buffer.second() + index, sizeof(value_type) * (m_size - index));
+            memmove(internal_data() + index + count, internal_data() + index, sizeof(value_type) * (m_size - index));
         }
-        memcpy(m_allocator_and_buffer.second() + index, str.c_str(), sizeof(value_type) * count);
+        memcpy(internal_data() + index, str.c_str(), sizeof(value_type) * count);
         m_size += count;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::insert(usize index, const BasicString& str, usize index_str, usize count)
@@ -671,49 +521,49 @@ namespace Luna
         internal_expand_reserve(m_size + count);
         if (index != m_size)
         {
-            memmove(m_allocator_and_buffer.second() + index + count, m_allocator_and_buffer.second() + index, sizeof(value_type) * (m_size - index));
+            memmove(internal_data() + index + count, internal_data() + index, sizeof(value_type) * (m_size - index));
         }
-        memcpy(m_allocator_and_buffer.second() + index, str.c_str() + index_str, sizeof(value_type) * count);
+        memcpy(internal_data() + index, str.c_str() + index_str, sizeof(value_type) * count);
         m_size += count;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::iterator BasicString<_Char, _Alloc>::insert(const_iterator pos, value_type ch)
     {
-        luassert(((usize)pos >= (usize)m_allocator_and_buffer.second()) && ((usize)pos <= (usize)(m_allocator_and_buffer.second() + m_size)));
+        luassert(((usize)pos >= (usize)internal_data()) && ((usize)pos <= (usize)(internal_data() + m_size)));
         usize index = pos - cbegin();
         internal_expand_reserve(m_size + 1);
         auto mpos = begin() + index;
         if (mpos != end())
         {
-            memmove(m_allocator_and_buffer.second() + index + 1, m_allocator_and_buffer.second() + index, sizeof(value_type) * (m_size - index));
+            memmove(internal_data() + index + 1, internal_data() + index, sizeof(value_type) * (m_size - index));
         }
-        m_allocator_and_buffer.second()[index] = ch;
+        internal_data()[index] = ch;
         ++m_size;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
         return mpos;
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::iterator BasicString<_Char, _Alloc>::insert(const_iterator pos, usize count, value_type ch)
     {
-        luassert(((usize)pos >= (usize)m_allocator_and_buffer.second()) && ((usize)pos <= (usize)(m_allocator_and_buffer.second() + m_size)));
+        luassert(((usize)pos >= (usize)internal_data()) && ((usize)pos <= (usize)(internal_data() + m_size)));
         usize index = pos - cbegin();
         internal_expand_reserve(m_size + count);
         auto mpos = begin() + index;
         if (mpos != end())
         {
-            memmove(m_allocator_and_buffer.second() + index + count, m_allocator_and_buffer.second() + index, sizeof(value_type) * (m_size - index));
+            memmove(internal_data() + index + count, internal_data() + index, sizeof(value_type) * (m_size - index));
         }
-        fill_construct_range(m_allocator_and_buffer.second() + index, m_allocator_and_buffer.second() + index + count, ch);
+        fill_construct_range(internal_data() + index, internal_data() + index + count, ch);
         m_size += count;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
         return mpos;
     }
     template <typename _Char, typename _Alloc>
     template <typename _InputIt>
     inline typename BasicString<_Char, _Alloc>::iterator BasicString<_Char, _Alloc>::insert(const_iterator pos, _InputIt first, _InputIt last)
     {
-        luassert(((usize)pos >= (usize)m_allocator_and_buffer.second()) && ((usize)pos <= (usize)(m_allocator_and_buffer.second() + m_size)));
+        luassert(((usize)pos >= (usize)internal_data()) && ((usize)pos <= (usize)(internal_data() + m_size)));
         usize index = pos - cbegin();
         for (auto iter = first; iter != last; ++iter)
         {
@@ -734,34 +584,34 @@ namespace Luna
         luassert(index + count <= m_size);
         if ((index + count) != m_size)
         {
-            memmove(m_allocator_and_buffer.second() + index, m_allocator_and_buffer.second() + index + count, sizeof(value_type) * (m_size - index - count));
+            memmove(internal_data() + index, internal_data() + index + count, sizeof(value_type) * (m_size - index - count));
         }
         m_size -= count;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::iterator BasicString<_Char, _Alloc>::erase(const_iterator pos)
     {
-        luassert(((usize)pos >= (usize)m_allocator_and_buffer.second()) && ((usize)pos < (usize)(m_allocator_and_buffer.second() + m_size)));
+        luassert(((usize)pos >= (usize)internal_data()) && ((usize)pos < (usize)(internal_data() + m_size)));
         if (pos != (end() - 1))
         {
             move_relocate_range((value_type*)pos + 1, (value_type*)end(), (value_type*)pos);
         }
         --m_size;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
         return const_cast<iterator>(pos);
     }
     template <typename _Char, typename _Alloc>
     inline typename BasicString<_Char, _Alloc>::iterator BasicString<_Char, _Alloc>::erase(const_iterator first, const_iterator last)
     {
-        luassert(((usize)first >= (usize)m_allocator_and_buffer.second()) && ((usize)first < (usize)(m_allocator_and_buffer.second() + m_size)));
-        luassert(((usize)last >= (usize)m_allocator_and_buffer.second()) && ((usize)last <= (usize)(m_allocator_and_buffer.second() + m_size)));
+        luassert(((usize)first >= (usize)internal_data()) && ((usize)first < (usize)(internal_data() + m_size)));
+        luassert(((usize)last >= (usize)internal_data()) && ((usize)last <= (usize)(internal_data() + m_size)));
         if (last != end())
         {
             move_relocate_range((value_type*)last, (value_type*)end(), (value_type*)first);
         }
         m_size -= (last - first);
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
         return const_cast<iterator>(first);
     }
     template <typename _Char, typename _Alloc>
@@ -777,9 +627,9 @@ namespace Luna
         if (count)
         {
             internal_expand_reserve(m_size + count);
-            fill_construct_range(m_allocator_and_buffer.second() + m_size, m_allocator_and_buffer.second() + m_size + count, ch);
+            fill_construct_range(internal_data() + m_size, internal_data() + m_size + count, ch);
             m_size += count;
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
+            internal_data()[m_size] = (value_type)0;
         }
     }
     template <typename _Char, typename _Alloc>
@@ -788,9 +638,9 @@ namespace Luna
         if (!str.empty())
         {
             internal_expand_reserve(m_size + str.size());
-            memcpy(m_allocator_and_buffer.second() + m_size, str.c_str(), str.size() * sizeof(value_type));
+            memcpy(internal_data() + m_size, str.c_str(), str.size() * sizeof(value_type));
             m_size += str.size();
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
+            internal_data()[m_size] = (value_type)0;
         }
     }
     template <typename _Char, typename _Alloc>
@@ -800,9 +650,9 @@ namespace Luna
         if (count)
         {
             internal_expand_reserve(m_size + count);
-            memcpy(m_allocator_and_buffer.second() + m_size, str.c_str() + pos, count * sizeof(value_type));
+            memcpy(internal_data() + m_size, str.c_str() + pos, count * sizeof(value_type));
             m_size += count;
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
+            internal_data()[m_size] = (value_type)0;
         }
     }
     template <typename _Char, typename _Alloc>
@@ -811,9 +661,9 @@ namespace Luna
         if (count)
         {
             internal_expand_reserve(m_size + count);
-            memcpy(m_allocator_and_buffer.second() + m_size, s, count * sizeof(value_type));
+            memcpy(internal_data() + m_size, s, count * sizeof(value_type));
             m_size += count;
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
+            internal_data()[m_size] = (value_type)0;
         }
     }
     template <typename _Char, typename _Alloc>
@@ -823,9 +673,9 @@ namespace Luna
         if (count)
         {
             internal_expand_reserve(m_size + count);
-            memcpy(m_allocator_and_buffer.second() + m_size, s, count * sizeof(value_type));
+            memcpy(internal_data() + m_size, s, count * sizeof(value_type));
             m_size += count;
-            m_allocator_and_buffer.second()[m_size] = (value_type)0;
+            internal_data()[m_size] = (value_type)0;
         }
     }
     template <typename _Char, typename _Alloc>
@@ -886,15 +736,15 @@ namespace Luna
         {
             internal_expand_reserve(m_size + delta);
         }
-        memmove(m_allocator_and_buffer.second() + pos + str.size(), m_allocator_and_buffer.second() + pos + count, sizeof(value_type) * (m_size - pos - count));
-        memcpy(m_allocator_and_buffer.second() + pos, str.c_str(), sizeof(value_type) * str.size());
+        memmove(internal_data() + pos + str.size(), internal_data() + pos + count, sizeof(value_type) * (m_size - pos - count));
+        memcpy(internal_data() + pos, str.c_str(), sizeof(value_type) * str.size());
         m_size += delta;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::replace(const_iterator first, const_iterator last, const BasicString& str)
     {
-        usize pos = first - m_allocator_and_buffer.second();
+        usize pos = first - internal_data();
         usize count = last - first;
         replace(pos, count, str);
     }
@@ -908,16 +758,16 @@ namespace Luna
         {
             internal_expand_reserve(m_size + delta);
         }
-        memmove(m_allocator_and_buffer.second() + pos + count2, m_allocator_and_buffer.second() + pos + count, sizeof(value_type) * (m_size - pos - count));
-        memcpy(m_allocator_and_buffer.second() + pos, str.c_str() + pos2, sizeof(value_type) * count2);
+        memmove(internal_data() + pos + count2, internal_data() + pos + count, sizeof(value_type) * (m_size - pos - count));
+        memcpy(internal_data() + pos, str.c_str() + pos2, sizeof(value_type) * count2);
         m_size += delta;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     template <typename _InputIt>
     inline void BasicString<_Char, _Alloc>::replace(const_iterator first, const_iterator last, _InputIt first2, _InputIt last2)
     {
-        usize pos = first - m_allocator_and_buffer.second();
+        usize pos = first - internal_data();
         erase(first, last);
         insert(begin() + pos, first2, last2);
     }
@@ -930,15 +780,15 @@ namespace Luna
         {
             internal_expand_reserve(m_size + delta);
         }
-        memmove(m_allocator_and_buffer.second() + pos + count2, m_allocator_and_buffer.second() + pos + count, sizeof(value_type) * (m_size - pos - count));
-        memcpy(m_allocator_and_buffer.second() + pos, cstr, sizeof(value_type) * count2);
+        memmove(internal_data() + pos + count2, internal_data() + pos + count, sizeof(value_type) * (m_size - pos - count));
+        memcpy(internal_data() + pos, cstr, sizeof(value_type) * count2);
         m_size += delta;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::replace(const_iterator first, const_iterator last, const value_type* cstr, usize count2)
     {
-        usize pos = first - m_allocator_and_buffer.second();
+        usize pos = first - internal_data();
         usize count = last - first;
         replace(pos, count, cstr, count2);
     }
@@ -952,7 +802,7 @@ namespace Luna
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::replace(const_iterator first, const_iterator last, const value_type* cstr)
     {
-        usize pos = first - m_allocator_and_buffer.second();
+        usize pos = first - internal_data();
         usize count = last - first;
         replace(pos, count, cstr);
     }
@@ -965,29 +815,29 @@ namespace Luna
         {
             internal_expand_reserve(m_size + delta);
         }
-        memmove(m_allocator_and_buffer.second() + pos + count2, m_allocator_and_buffer.second() + pos + count, sizeof(value_type) * (m_size - pos - count));
-        fill_construct_range(m_allocator_and_buffer.second() + pos, m_allocator_and_buffer.second() + pos + count2, ch);
+        memmove(internal_data() + pos + count2, internal_data() + pos + count, sizeof(value_type) * (m_size - pos - count));
+        fill_construct_range(internal_data() + pos, internal_data() + pos + count2, ch);
         m_size += delta;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::replace(const_iterator first, const_iterator last, usize count2, value_type ch)
     {
-        usize pos = first - m_allocator_and_buffer.second();
+        usize pos = first - internal_data();
         usize count = last - first;
         replace(pos, count, count2, ch);
     }
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::replace(const_iterator first, const_iterator last, InitializerList<value_type> ilist)
     {
-        usize pos = first - m_allocator_and_buffer.second();
+        usize pos = first - internal_data();
         usize count = last - first;
         isize delta = ilist.size() - count;
         if (delta > 0)
         {
             internal_expand_reserve(m_size + delta);
         }
-        memmove(m_allocator_and_buffer.second() + pos + ilist.size(), m_allocator_and_buffer.second() + pos + count, sizeof(value_type) * (m_size - pos - count));
+        memmove(internal_data() + pos + ilist.size(), internal_data() + pos + count, sizeof(value_type) * (m_size - pos - count));
         auto iter = const_cast<iterator>(first);
         for (auto& i : ilist)
         {
@@ -995,21 +845,21 @@ namespace Luna
             ++iter;
         }
         m_size += delta;
-        m_allocator_and_buffer.second()[m_size] = (value_type)0;
+        internal_data()[m_size] = (value_type)0;
     }
     template <typename _Char, typename _Alloc>
     inline BasicString<_Char, _Alloc> BasicString<_Char, _Alloc>::substr(usize pos, usize count) const
     {
         luassert(pos <= m_size);
         count = min(count, m_size - pos);
-        return BasicString(m_allocator_and_buffer.second() + pos, count, m_allocator_and_buffer.first());
+        return BasicString(internal_data() + pos, count, m_allocator_and_buffer.first());
     }
     template <typename _Char, typename _Alloc>
     inline usize BasicString<_Char, _Alloc>::copy(value_type* dst, usize count, usize pos) const
     {
         luassert(pos <= m_size);
         count = min(count, m_size - pos);
-        memcpy(dst, m_allocator_and_buffer.second() + pos, sizeof(value_type) * count);
+        memcpy(dst, internal_data() + pos, sizeof(value_type) * count);
         return count;
     }
     template <typename _Char, typename _Alloc>
@@ -1094,13 +944,36 @@ namespace Luna
     template <typename _Char, typename _Alloc>
     inline void BasicString<_Char, _Alloc>::free_buffer()
     {
-        if (m_allocator_and_buffer.second())
+        if (!is_inline())
         {
-            deallocate(m_allocator_and_buffer.second(), m_capacity);
-            m_allocator_and_buffer.second() = nullptr;
+            deallocate(m_allocator_and_buffer.second().heap_chars, m_capacity);
         }
+        m_allocator_and_buffer.second().inline_chars[0] = (value_type)0;
         m_size = 0;
-        m_capacity = 0;
+        m_capacity = INLINE_CAPACITY;
+    }
+    template <typename _Char, typename _Alloc>
+    inline void BasicString<_Char, _Alloc>::internal_init(const value_type* s, usize count)
+    {
+        reserve(count);
+        value_type* buf = internal_data();
+        if (count)
+        {
+            memcpy(buf, s, sizeof(value_type) * count);
+        }
+        buf[count] = (value_type)0;
+        m_size = count;
+    }
+    template <typename _Char, typename _Alloc>
+    inline void BasicString<_Char, _Alloc>::internal_take(BasicString& rhs)
+    {
+        // The buffer union is copied as a whole, which copies either the inline characters or the heap pointer.
+        m_allocator_and_buffer.second() = rhs.m_allocator_and_buffer.second();
+        m_size = rhs.m_size;
+        m_capacity = rhs.m_capacity;
+        rhs.m_allocator_and_buffer.second().inline_chars[0] = (value_type)0;
+        rhs.m_size = 0;
+        rhs.m_capacity = INLINE_CAPACITY;
     }
     template <typename _Char, typename _Alloc>
     inline usize BasicString<_Char, _Alloc>::strlength(const _Char* s)
@@ -0,0 +1,887 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SwissHashTable.hpp
+* @author JXMaster
+* @date 2024/3/11
+* @brief A hash table implementation that probes slots in groups using one byte of control data per slot.
+*/
+#pragma once
+#include "../Base.hpp"
+#include "../Functional.hpp"
+#include "../Algorithm.hpp"
+#include "../Allocator.hpp"
+#include "../MemoryUtils.hpp"
+#include "HashTableBase.hpp"
+#include <cmath> // for ceilf
+
+#ifndef LUNA_DISABLE_SIMD
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+#define LUNA_SWISS_HASHING_SSE2
+#include <emmintrin.h>
+#elif defined(LUNA_PLATFORM_ARM64)
+#define LUNA_SWISS_HASHING_NEON
+#include <arm_neon.h>
+#endif
+#endif
+
+#ifdef LUNA_COMPILER_MSVC
+#include <intrin.h>
+#endif
+
+namespace Luna
+{
+    namespace SwissHashing
+    {
+        // Every slot of the table has one control byte. The control byte of one slot that holds one element
+        // stores the lower 7 bits of the element hash (H2), so the high bit is not set. Other slots set the high bit.
+
+        //! The slot is empty, probing stops at groups that contain at least one empty slot.
+        constexpr u8 CTRL_EMPTY = 0x80;
+        //! The slot was occupied and then erased, probing should continue when this slot is encountered.
+        constexpr u8 CTRL_DELETED = 0xFE;
+        //! Pads the last group after the last slot, which is never matched.
+        constexpr u8 CTRL_SENTINEL = 0xFF;
+
+        //! The number of slots that are probed together.
+        constexpr usize GROUP_WIDTH = 16;
+
+        constexpr usize INITIAL_BUFFER_SIZE = 16;
+        constexpr f32 INITIAL_LOAD_FACTOR = 0.875f;
+
+        inline bool is_full(u8 ctrl)
+        {
+            return (ctrl & 0x80) == 0;
+        }
+
+        //! Mixes the hash code returned by the hasher, since hash codes of integers and pointers
+        //! are not uniformly distributed.
+        inline usize mix_hash(usize h)
+        {
+#ifdef LUNA_PLATFORM_64BIT
+            h ^= h >> 33;
+            h *= 0xff51afd7ed558ccdULL;
+            h ^= h >> 33;
+#else
+            h ^= h >> 16;
+            h *= 0x85ebca6b;
+            h ^= h >> 13;
+            h *= 0xc2b2ae35;
+            h ^= h >> 16;
+#endif
+            return h;
+        }
+        //! Gets the hash bits used to choose the first group to probe.
+        inline usize h1(usize h)
+        {
+            return h >> 7;
+        }
+        //! Gets the hash bits stored in the control byte.
+        inline u8 h2(usize h)
+        {
+            return (u8)(h & 0x7F);
+        }
+        inline usize num_groups(usize buffer_size)
+        {
+            return (buffer_size + GROUP_WIDTH - 1) / GROUP_WIDTH;
+        }
+        //! Gets the size of the control byte buffer, which is padded to a multiple of @ref GROUP_WIDTH.
+        inline usize ctrl_size(usize buffer_size)
+        {
+            return num_groups(buffer_size) * GROUP_WIDTH;
+        }
+        inline void init_ctrl(u8* ctrl, usize buffer_size)
+        {
+            memset(ctrl, CTRL_EMPTY, buffer_size);
+            memset(ctrl + buffer_size, CTRL_SENTINEL, ctrl_size(buffer_size) - buffer_size);
+        }
+
+        //! Gets the index of the lowest set bit. `mask` must not be `0`.
+        inline u32 lowest_bit_index(u32 mask)
+        {
+#if defined(LUNA_COMPILER_GCC) || defined(LUNA_COMPILER_CLANG)
+            return (u32)__builtin_ctz(mask);
+#elif defined(LUNA_COMPILER_MSVC)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return (u32)index;
+#else
+            u32 index = 0;
+            while (!(mask & 1))
+            {
+                mask >>= 1;
+                ++index;
+            }
+            return index;
+#endif
+        }
+
+        //! Matches control bytes of one group. Every function returns one bit mask, the Nth bit
+        //! of the mask is set if the Nth slot of the group matches.
+        struct Group
+        {
+#if defined(LUNA_SWISS_HASHING_SSE2)
+            __m128i m_ctrl;
+            Group(const u8* ctrl) :
+                m_ctrl(_mm_loadu_si128((const __m128i*)ctrl)) {}
+            u32 match(u8 h2) const
+            {
+                return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8((char)h2)));
+            }
+            u32 match_empty() const
+            {
+                return (u32)_mm_movemask_epi8(_mm_cmpeq_epi8(m_ctrl, _mm_set1_epi8((char)CTRL_EMPTY)));
+            }
+            u32 match_empty_or_deleted() const
+            {
+                // CTRL_EMPTY and CTRL_DELETED are the only values less than CTRL_SENTINEL when compared as signed bytes.
+                return (u32)_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8((char)CTRL_SENTINEL), m_ctrl));
+            }
+#elif defined(LUNA_SWISS_HASHING_NEON)
+            uint8x16_t m_ctrl;
+            Group(const u8* ctrl) :
+                m_ctrl(vld1q_u8(ctrl)) {}
+            static u32 to_mask(uint8x16_t cmp)
+            {
+                static const u8 bits[16] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+                uint8x16_t masked = vandq_u8(cmp, vld1q_u8(bits));
+                return (u32)vaddv_u8(vget_low_u8(masked)) | ((u32)vaddv_u8(vget_high_u8(masked)) << 8);
+            }
+            u32 match(u8 h2) const
+            {
+                return to_mask(vceqq_u8(m_ctrl, vdupq_n_u8(h2)));
+            }
+            u32 match_empty() const
+            {
+                return to_mask(vceqq_u8(m_ctrl, vdupq_n_u8(CTRL_EMPTY)));
+            }
+            u32 match_empty_or_deleted() const
+            {
+                return to_mask(vcltq_s8(vreinterpretq_s8_u8(m_ctrl), vdupq_n_s8((i8)CTRL_SENTINEL)));
+            }
+#else
+            u8 m_ctrl[GROUP_WIDTH];
+            Group(const u8* ctrl)
+            {
+                memcpy(m_ctrl, ctrl, GROUP_WIDTH);
+            }
+            u32 match(u8 h2) const
+            {
+                u32 r = 0;
+                for (u32 i = 0; i < GROUP_WIDTH; ++i) r |= (m_ctrl[i] == h2 ? 1 : 0) << i;
+                return r;
+            }
+            u32 match_empty() const
+            {
+                return match(CTRL_EMPTY);
+            }
+            u32 match_empty_or_deleted() const
+            {
+                u32 r = 0;
+                for (u32 i = 0; i < GROUP_WIDTH; ++i) r |= (m_ctrl[i] == CTRL_EMPTY || m_ctrl[i] == CTRL_DELETED ? 1 : 0) << i;
+                return r;
+            }
+#endif
+        };
+
+        //! Visits groups of one table in probing order. Every group is visited at most once.
+        struct ProbeSequence
+        {
+            usize m_group;
+            usize m_num_groups;
+            usize m_num_probed;
+
+            ProbeSequence(usize h, usize num_groups) :
+                m_group(h1(h) % num_groups),
+                m_num_groups(num_groups),
+                m_num_probed(0) {}
+            //! Gets the index of the first slot of the current group.
+            usize offset() const
+            {
+                return m_group * GROUP_WIDTH;
+            }
+            //! Moves to the next group. Returns `false` if all groups are visited.
+            bool next()
+            {
+                if (++m_num_probed == m_num_groups) return false;
+                ++m_group;
+                if (m_group == m_num_groups) m_group = 0;
+                return true;
+            }
+        };
+
+        //! Finds the first empty or deleted slot to insert the element with the specified hash.
+        //! The table must have at least one empty or deleted slot.
+        inline usize find_insert_slot(const u8* ctrl, usize buffer_size, usize h)
+        {
+            ProbeSequence seq(h, num_groups(buffer_size));
+            while (true)
+            {
+                u32 mask = Group(ctrl + seq.offset()).match_empty_or_deleted();
+                if (mask)
+                {
+                    return seq.offset() + lowest_bit_index(mask);
+                }
+                bool r = seq.next();
+                luassert(r);
+                (void)r;
+            }
+        }
+
+        //! Marks one slot as not occupied.
+        //! @return Returns `true` if the slot is marked as deleted, returns `false` if the slot is marked as empty.
+        inline bool erase_ctrl(u8* ctrl, usize index)
+        {
+            // If the group of this slot already has one empty slot, no probing passes this group,
+            // so the slot can be marked as empty directly.
+            usize group_offset = index - index % GROUP_WIDTH;
+            if (Group(ctrl + group_offset).match_empty())
+            {
+                ctrl[index] = CTRL_EMPTY;
+                return false;
+            }
+            ctrl[index] = CTRL_DELETED;
+            return true;
+        }
+
+        template <typename _Ty, bool _Const>
+        struct Iterator
+        {
+            using value_type = _Ty;
+            using pointer = conditional_t<_Const, const value_type*, value_type*>;
+            using reference = conditional_t<_Const, const value_type&, value_type&>;
+            using iterator_category = forward_iterator_tag;
+
+            pointer m_value;
+            u8* m_ctrl;
+            u8* m_end;    // to present shifting above end.
+
+            Iterator(pointer value, u8* ctrl, u8* end) :
+                m_value(value),
+                m_ctrl(ctrl),
+                m_end(end) {}
+            Iterator(const Iterator<_Ty, false>& rhs)
+            {
+                m_value = rhs.m_value;
+                m_ctrl = rhs.m_ctrl;
+                m_end = rhs.m_end;
+            }
+            reference operator*() const
+            {
+                return *m_value;
+            }
+            pointer operator->() const
+            {
+                return m_value;
+            }
+            Iterator& operator++()
+            {
+                do
+                {
+                    ++m_value;
+                    ++m_ctrl;
+                } while ((m_ctrl != m_end) && !is_full(*m_ctrl));
+                return *this;
+            }
+            Iterator operator++(int)
+            {
+                Iterator temp(*this);
+                ++*this;
+                return temp;
+            }
+            bool operator==(const Iterator& rhs) const
+            {
+                return m_ctrl == rhs.m_ctrl;
+            }
+            bool operator!=(const Iterator& rhs) const
+            {
+                return m_ctrl != rhs.m_ctrl;
+            }
+        };
+
+        template <typename _Kty,
+            typename _Vty,
+            typename _ExtractKey,                // MapExtractKey for UnorderedMap, SetExtractKey for UnorderedSet.
+            typename _Hash = hash<_Kty>,        // Used to hash the key value.
+            typename _KeyEqual = equal_to<_Kty>,
+            typename _Alloc = Allocator>    // Used to compare the element.
+        class HashTable
+        {
+        public:
+            using key_type = _Kty;
+            using value_type = _Vty;
+            using allocator_type = _Alloc;
+            using hasher = _Hash;
+            using key_equal = _KeyEqual;
+            using reference = value_type&;
+            using const_reference = const value_type&;
+            using pointer = value_type*;
+            using const_pointer = const value_type*;
+            using iterator = Iterator<value_type, false>;
+            using const_iterator = Iterator<value_type, true>;
+            using extract_key = _ExtractKey;
+
+            // -------------------- Begin of ABI compatible part --------------------
+
+            //! A pointer to the hash table, which is an array of elements.
+            OptionalPair<allocator_type, value_type*> m_allocator_and_value_buffer;
+            //! A pointer to control byte buffer, whose size is padded to `ctrl_size(m_buffer_size)`.
+            u8* m_ctrl;
+            //! The the size of value buffer.
+            usize m_buffer_size;
+            //! The number of elements in the hash table.
+            usize m_size;
+            //! The number of slots marked as @ref CTRL_DELETED.
+            usize m_num_deleted;
+            //! The maximum load factor of the table, which determines how often the rehashing
+            //! will occur. The load factor can be calculated by `m_size / m_buffer_size`, which is
+            //! (0.0, 1.0]. Deleted slots are counted when determining whether rehashing is needed.
+            f32 m_max_load_factor;
+
+            // --------------------  End of ABI compatible part  --------------------
+
+        private:
+            template <typename _Ty>
+            _Ty* allocate(usize n)
+            {
+                return m_allocator_and_value_buffer.first().template allocate<_Ty>(n);
+            }
+            template <typename _Ty>
+            void deallocate(_Ty* ptr, usize n)
+            {
+                m_allocator_and_value_buffer.first().template deallocate<_Ty>(ptr, n);
+            }
+            u8* internal_alloc_ctrl_buffer(usize buffer_size)
+            {
+                u8* buf = allocate<u8>(ctrl_size(buffer_size));
+                init_ctrl(buf, buffer_size);
+                return buf;
+            }
+            void internal_free_table()
+            {
+                if (m_allocator_and_value_buffer.second())
+                {
+                    deallocate<value_type>(m_allocator_and_value_buffer.second(), m_buffer_size);
+                    deallocate<u8>(m_ctrl, ctrl_size(m_buffer_size));
+                    m_allocator_and_value_buffer.second() = nullptr;
+                }
+            }
+            void internal_destruct_values()
+            {
+                for (usize i = 0; i < m_buffer_size; ++i)
+                {
+                    if (is_full(m_ctrl[i]))
+                    {
+                        (m_allocator_and_value_buffer.second() + i)->~value_type();
+                    }
+                }
+            }
+            void internal_clear()
+            {
+                if (!m_allocator_and_value_buffer.second()) return;
+                internal_destruct_values();
+                init_ctrl(m_ctrl, m_buffer_size);
+                m_size = 0;
+                m_num_deleted = 0;
+            }
+            void internal_clear_and_free_table()
+            {
+                if (m_allocator_and_value_buffer.second())
+                {
+                    internal_destruct_values();
+                }
+                internal_free_table();
+                m_buffer_size = 0;
+                m_size = 0;
+                m_num_deleted = 0;
+            }
+            template <bool _Move, typename _Table>
+            void internal_copy_table(_Table& rhs)
+            {
+                m_allocator_and_value_buffer.second() = allocate<value_type>(rhs.m_buffer_size);
+                m_ctrl = allocate<u8>(ctrl_size(rhs.m_buffer_size));
+                memcpy(m_ctrl, rhs.m_ctrl, ctrl_size(rhs.m_buffer_size));
+                m_buffer_size = rhs.m_buffer_size;
+                for (usize i = 0; i < rhs.m_buffer_size; ++i)
+                {
+                    if (is_full(rhs.m_ctrl[i]))
+                    {
+                        if (_Move) move_construct(m_allocator_and_value_buffer.second() + i, rhs.m_allocator_and_value_buffer.second() + i);
+                        else copy_construct(m_allocator_and_value_buffer.second() + i, rhs.m_allocator_and_value_buffer.second() + i);
+                    }
+                }
+                m_size = rhs.m_size;
+                m_num_deleted = rhs.m_num_deleted;
+            }
+            void internal_rehash(usize new_buffer_size)
+            {
+                value_type* value_buf = allocate<value_type>(new_buffer_size);
+                u8* ctrl = internal_alloc_ctrl_buffer(new_buffer_size);
+                for (usize i = 0; i < m_buffer_size; ++i)
+                {
+                    if (!is_full(m_ctrl[i])) continue;
+                    value_type* src = m_allocator_and_value_buffer.second() + i;
+                    usize h = hash_key(extract_key()(*src));
+                    usize pos = find_insert_slot(ctrl, new_buffer_size, h);
+                    ctrl[pos] = h2(h);
+                    copy_relocate(value_buf + pos, src);
+                }
+                internal_free_table();
+                m_allocator_and_value_buffer.second() = value_buf;
+                m_ctrl = ctrl;
+                m_buffer_size = new_buffer_size;
+                m_num_deleted = 0;
+            }
+        public:
+            bool empty() const
+            {
+                return m_size == 0;
+            }
+            usize size() const
+            {
+                return m_size;
+            }
+            usize hash_table_size() const
+            {
+                return m_buffer_size;
+            }
+            f32 load_factor() const
+            {
+                if (!m_buffer_size)
+                {
+                    return 0.0f;
+                }
+                return (f32)m_size / (f32)m_buffer_size;
+            }
+            f32 max_load_factor() const
+            {
+                return m_max_load_factor;
+            }
+            void clear()
+            {
+                internal_clear();
+            }
+            void shrink_to_fit()
+            {
+                usize desired_size = (usize)ceilf((f32)m_size / m_max_load_factor);
+                if (desired_size == 0)
+                {
+                    internal_clear_and_free_table();
+                    return;
+                }
+                rehash(desired_size);
+            }
+            hasher hash_function() const
+            {
+                return hasher();
+            }
+            key_equal key_eq() const
+            {
+                return key_equal();
+            }
+            //! The number of elements this hash table can hold before next rehash.
+            usize capacity() const
+            {
+                return (usize)floorf(m_max_load_factor * m_buffer_size);
+            }
+            void rehash(usize new_buffer_size)
+            {
+                new_buffer_size = max(max(new_buffer_size, (usize)(ceilf((f32)m_size / m_max_load_factor))), INITIAL_BUFFER_SIZE);
+                if (new_buffer_size == m_buffer_size && !m_num_deleted)
+                {
+                    return;
+                }
+                internal_rehash(new_buffer_size);
+            }
+            void reserve(usize new_cap)
+            {
+                usize current_cap = capacity();
+                if (new_cap > current_cap)
+                {
+                    rehash((usize)ceilf((f32)new_cap / m_max_load_factor));
+                }
+            }
+            void max_load_factor(f32 ml)
+            {
+                lucheck(ml > 0.0f && ml <= 1.0f);
+                m_max_load_factor = ml;
+                if (load_factor() > max_load_factor())
+                {
+                    rehash(0);
+                }
+            }
+            HashTable() :
+                m_allocator_and_value_buffer(allocator_type(), nullptr),
+                m_ctrl(nullptr),
+                m_buffer_size(0),
+                m_size(0),
+                m_num_deleted(0),
+                m_max_load_factor(INITIAL_LOAD_FACTOR) {}
+            HashTable(const allocator_type& alloc) :
+                m_allocator_and_value_buffer(alloc, nullptr),
+                m_ctrl(nullptr),
+                m_buffer_size(0),
+                m_size(0),
+                m_num_deleted(0),
+                m_max_load_factor(INITIAL_LOAD_FACTOR) {}
+            HashTable(const HashTable& rhs) :
+                m_allocator_and_value_buffer(allocator_type(), nullptr),
+                m_ctrl(nullptr),
+                m_buffer_size(0),
+                m_size(0),
+                m_num_deleted(0),
+                m_max_load_factor(rhs.m_max_load_factor)
+            {
+                if (!rhs.empty())
+                {
+                    internal_copy_table<false>(rhs);
+                }
+            }
+            HashTable(const HashTable& rhs, const allocator_type& alloc) :
+                m_allocator_and_value_buffer(alloc, nullptr),
+                m_ctrl(nullptr),
+                m_buffer_size(0),
+                m_size(0),
+                m_num_deleted(0),
+                m_max_load_factor(rhs.m_max_load_factor)
+            {
+                if (!rhs.empty())
+                {
+                    internal_copy_table<false>(rhs);
+                }
+            }
+            HashTable(HashTable&& rhs) :
+                m_allocator_and_value_buffer(move(rhs.m_allocator_and_value_buffer.first()), rhs.m_allocator_and_value_buffer.second()),
+                m_ctrl(rhs.m_ctrl),
+                m_buffer_size(rhs.m_buffer_size),
+                m_size(rhs.m_size),
+                m_num_deleted(rhs.m_num_deleted),
+                m_max_load_factor(rhs.m_max_load_factor)
+            {
+                rhs.m_allocator_and_value_buffer.second() = nullptr;
+                rhs.m_ctrl = nullptr;
+                rhs.m_buffer_size = 0;
+                rhs.m_size = 0;
+                rhs.m_num_deleted = 0;
+            }
+            HashTable(HashTable&& rhs, const allocator_type& alloc) :
+                m_allocator_and_value_buffer(alloc, nullptr),
+                m_ctrl(nullptr),
+                m_buffer_size(0),
+                m_size(0),
+                m_num_deleted(0),
+                m_max_load_factor(rhs.m_max_load_factor)
+            {
+                if (m_allocator_and_value_buffer.first() == rhs.m_allocator_and_value_buffer.first())
+                {
+                    m_allocator_and_value_buffer.second() = rhs.m_allocator_and_value_buffer.second();
+                    m_ctrl = rhs.m_ctrl;
+                    m_buffer_size = rhs.m_buffer_size;
+                    m_size = rhs.m_size;
+                    m_num_deleted = rhs.m_num_deleted;
+                    rhs.m_allocator_and_value_buffer.second() = nullptr;
+                    rhs.m_ctrl = nullptr;
+                    rhs.m_buffer_size = 0;
+                    rhs.m_size = 0;
+                    rhs.m_num_deleted = 0;
+                }
+                else if (!rhs.empty())
+                {
+                    internal_copy_table<true>(rhs);
+                    rhs.clear();
+                }
+            }
+            HashTable& operator=(const HashTable& rhs)
+            {
+                if (this == &rhs) return *this;
+                internal_clear_and_free_table();
+                m_max_load_factor = rhs.m_max_load_factor;
+                if (!rhs.empty())
+                {
+                    internal_copy_table<false>(rhs);
+                }
+                return *this;
+            }
+            HashTable& operator=(HashTable&& rhs)
+            {
+                if (this == &rhs) return *this;
+                internal_clear_and_free_table();
+                m_max_load_factor = rhs.m_max_load_factor;
+                if (m_allocator_and_value_buffer.first() == rhs.m_allocator_and_value_buffer.first())
+                {
+                    m_allocator_and_value_buffer.second() = rhs.m_allocator_and_value_buffer.second();
+                    m_ctrl = rhs.m_ctrl;
+                    m_buffer_size = rhs.m_buffer_size;
+                    m_size = rhs.m_size;
+                    m_num_deleted = rhs.m_num_deleted;
+                    rhs.m_allocator_and_value_buffer.second() = nullptr;
+                    rhs.m_ctrl = nullptr;
+                    rhs.m_buffer_size = 0;
+                    rhs.m_size = 0;
+                    rhs.m_num_deleted = 0;
+                }
+                else if (!rhs.empty())
+                {
+                    internal_copy_table<true>(rhs);
+                    rhs.clear();
+                }
+                return *this;
+            }
+            ~HashTable()
+            {
+                internal_clear_and_free_table();
+            }
+            iterator begin()
+            {
+                if (!m_allocator_and_value_buffer.second())
+                {
+                    return iterator(nullptr, nullptr, nullptr);
+                }
+                iterator i(m_allocator_and_value_buffer.second(), m_ctrl, m_ctrl + m_buffer_size);
+                if (!is_full(m_ctrl[0])) ++i;
+                return i;
+            }
+            const_iterator begin() const
+            {
+                if (!m_allocator_and_value_buffer.second())
+                {
+                    return const_iterator(nullptr, nullptr, nullptr);
+                }
+                const_iterator i(m_allocator_and_value_buffer.second(), m_ctrl, m_ctrl + m_buffer_size);
+                if (!is_full(m_ctrl[0])) ++i;
+                return i;
+            }
+            const_iterator cbegin() const
+            {
+                return begin();
+            }
+            iterator end()
+            {
+                if (!m_allocator_and_value_buffer.second())
+                {
+                    return iterator(nullptr, nullptr, nullptr);
+                }
+                return iterator(m_allocator_and_value_buffer.second() + m_buffer_size, m_ctrl + m_buffer_size, m_ctrl + m_buffer_size);
+            }
+            const_iterator end() const
+            {
+                if (!m_allocator_and_value_buffer.second())
+                {
+                    return const_iterator(nullptr, nullptr, nullptr);
+                }
+                return const_iterator(m_allocator_and_value_buffer.second() + m_buffer_size, m_ctrl + m_buffer_size, m_ctrl + m_buffer_size);
+            }
+            const_iterator cend() const
+            {
+                return end();
+            }
+        private:
+            //! Called in single insertion operations such as insert & emplace,
+            //! this call reserves enough spaces so rehash will not happen often.
+            void increment_reserve(usize new_cap)
+            {
+                usize current_capacity = capacity();
+                if (new_cap > current_capacity)
+                {
+                    new_cap = max(new_cap, current_capacity * 2);
+                    rehash((usize)ceilf((f32)new_cap / m_max_load_factor));
+                }
+            }
+            //! Ensures that one new element can be inserted. Deleted slots are purged without growing
+            //! the table if the table is not nearly full.
+            void prepare_insert()
+            {
+                usize current_capacity = capacity();
+                if (m_size + m_num_deleted + 1 <= current_capacity) return;
+                if (m_num_deleted && (m_size + 1) * 32 <= current_capacity * 25)
+                {
+                    internal_rehash(m_buffer_size);
+                    return;
+                }
+                increment_reserve(m_size + 1);
+            }
+            //! Finds the slot of the element with the specified key. Returns `USIZE_MAX` if not found.
+            usize internal_find_slot(const key_type& key, usize h) const
+            {
+                if (!m_buffer_size) return USIZE_MAX;
+                ProbeSequence seq(h, num_groups(m_buffer_size));
+                u8 tag = h2(h);
+                do
+                {
+                    Group group(m_ctrl + seq.offset());
+                    u32 mask = group.match(tag);
+                    while (mask)
+                    {
+                        usize pos = seq.offset() + lowest_bit_index(mask);
+                        if (key_equal()(key, extract_key()(m_allocator_and_value_buffer.second()[pos])))
+                        {
+                            return pos;
+                        }
+                        mask &= mask - 1;
+                    }
+                    if (group.match_empty()) break;
+                } while (seq.next());
+                return USIZE_MAX;
+            }
+            iterator internal_find(const key_type& key, usize h)
+            {
+                usize pos = internal_find_slot(key, h);
+                if (pos == USIZE_MAX) return end();
+                return iterator(m_allocator_and_value_buffer.second() + pos, m_ctrl + pos, m_ctrl + m_buffer_size);
+            }
+            const_iterator internal_find(const key_type& key, usize h) const
+            {
+                usize pos = internal_find_slot(key, h);
+                if (pos == USIZE_MAX) return end();
+                return const_iterator(m_allocator_and_value_buffer.second() + pos, m_ctrl + pos, m_ctrl + m_buffer_size);
+            }
+            usize hash_key(const key_type& key) const
+            {
+                return mix_hash(hasher()(key));
+            }
+            //! Moves the element to one free slot of the table.
+            iterator internal_insert_relocate(usize h, value_type* value)
+            {
+                prepare_insert();
+                usize pos = find_insert_slot(m_ctrl, m_buffer_size, h);
+                if (m_ctrl[pos] == CTRL_DELETED) --m_num_deleted;
+                m_ctrl[pos] = h2(h);
+                copy_relocate(m_allocator_and_value_buffer.second() + pos, value);
+                ++m_size;
+                return iterator(m_allocator_and_value_buffer.second() + pos, m_ctrl + pos, m_ctrl + m_buffer_size);
+            }
+            template <typename... _Args>
+            iterator internal_insert(usize h, _Args&&... args)
+            {
+                // The value is constructed before rehashing, since arguments may refer to elements in the table.
+                Unconstructed<value_type> value;
+                value.construct(forward<_Args>(args)...);
+                return internal_insert_relocate(h, &(value.get()));
+            }
+
+        public:
+            iterator find(const key_type& key)
+            {
+                usize h = hash_key(key);
+                return internal_find(key, h);
+            }
+            const_iterator find(const key_type& key) const
+            {
+                usize h = hash_key(key);
+                return internal_find(key, h);
+            }
+            bool contains(const key_type& key) const
+            {
+                usize h = hash_key(key);
+                return internal_find_slot(key, h) != USIZE_MAX;
+            }
+            Pair<iterator, bool> insert(const value_type& value)
+            {
+                usize h = hash_key(extract_key()(value));
+                auto iter = internal_find(extract_key()(value), h);
+                if (iter != end())
+                {
+                    return make_pair(iter, false);
+                }
+                return make_pair(internal_insert(h, value), true);
+            }
+            Pair<iterator, bool> insert(value_type&& value)
+            {
+                usize h = hash_key(extract_key()(value));
+                auto iter = internal_find(extract_key()(value), h);
+                if (iter != end())
+                {
+                    return make_pair(iter, false);
+                }
+                return make_pair(internal_insert(h, move(value)), true);
+            }
+            Pair<iterator, bool> insert_or_assign(const value_type& value)
+            {
+                usize h = hash_key(extract_key()(value));
+                auto iter = internal_find(extract_key()(value), h);
+                if (iter != end())
+                {
+                    (*iter) = value;
+                    return make_pair(iter, false);
+                }
+                return make_pair(internal_insert(h, value), true);
+            }
+            Pair<iterator, bool> insert_or_assign(value_type&& value)
+            {
+                usize h = hash_key(extract_key()(value));
+                auto iter = internal_find(extract_key()(value), h);
+                if (iter != end())
+                {
+                    (*iter) = move(value);
+                    return make_pair(iter, false);
+                }
+                return make_pair(internal_insert(h, move(value)), true);
+            }
+            template <typename _M>
+            Pair<iterator, bool> insert_or_assign(const key_type& key, _M&& value)
+            {
+                usize h = hash_key(key);
+                auto iter = internal_find(key, h);
+                if (iter != end())
+                {
+                    iter->second = forward<_M>(value);
+                    return make_pair(iter, false);
+                }
+                return make_pair(internal_insert(h, key, forward<_M>(value)), true);
+            }
+            template <typename _M>
+            Pair<iterator, bool> insert_or_assign(key_type&& key, _M&& value)
+            {
+                usize h = hash_key(key);
+                auto iter = internal_find(key, h);
+                if (iter != end())
+                {
+                    iter->second = forward<_M>(value);
+                    return make_pair(iter, false);
+                }
+                return make_pair(internal_insert(h, move(key), forward<_M>(value)), true);
+            }
+            template <typename... _Args>
+            Pair<iterator, bool> emplace(_Args&&... args)
+            {
+                Unconstructed<value_type> value;
+                value.construct(forward<_Args>(args)...);
+                usize h = hash_key(extract_key()(value.get()));
+                iterator iter = internal_find(extract_key()(value.get()), h);
+                if (iter != end())
+                {
+                    value.destruct();
+                    return make_pair(iter, false);
+                }
+                return make_pair(internal_insert_relocate(h, &(value.get())), true);
+            }
+            iterator erase(const_iterator pos)
+            {
+                value_type* value = const_cast<value_type*>(pos.m_value);
+                u8* ctrl = pos.m_ctrl;
+                destruct(value);
+                if (erase_ctrl(m_ctrl, ctrl - m_ctrl)) ++m_num_deleted;
+                --m_size;
+                iterator i(value, ctrl, m_ctrl + m_buffer_size);
+                ++i;
+                return i;
+            }
+            usize erase(const key_type& key)
+            {
+                auto iter = find(key);
+                if (iter != end())
+                {
+                    erase(iter);
+                    return 1;
+                }
+                return 0;
+            }
+            allocator_type get_allocator() const
+            {
+                return m_allocator_and_value_buffer.first();
+            }
+        };
+    }
+}
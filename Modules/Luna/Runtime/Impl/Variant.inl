@@ -91,6 +91,47 @@ namespace Luna
     {
         do_construct(type);
     }
+    inline Variant::Variant(VariantType type, usize capacity, Arena* arena)
+    {
+        do_construct(type);
+        if (!capacity) return;
+        if (type == VariantType::object)
+        {
+            if (arena && capacity <= BIG_OBJECT_THRESHOLD)
+            {
+                m_obj = (Pair<const Name, Variant>*)arena->allocate(sizeof(Pair<const Name, Variant>) * capacity, alignof(Pair<const Name, Variant>));
+                m_array_or_object_header.m_capacity = (u16)capacity;
+                set_flags(m_object_flag, ObjectFlag::arena);
+            }
+            else if (capacity <= BIG_OBJECT_THRESHOLD)
+            {
+                m_obj = (Pair<const Name, Variant>*)memalloc(sizeof(Pair<const Name, Variant>) * capacity);
+                m_array_or_object_header.m_capacity = (u16)capacity;
+            }
+            else
+            {
+                do_small_obj_reserve(capacity);
+            }
+        }
+        else if (type == VariantType::array)
+        {
+            if (arena && capacity <= (usize)U16_MAX)
+            {
+                m_arr = (Variant*)arena->allocate(sizeof(Variant) * capacity, alignof(Variant));
+                m_array_or_object_header.m_capacity = (u16)capacity;
+                set_flags(m_array_flag, ArrayFlag::arena);
+            }
+            else if (capacity <= (usize)U16_MAX)
+            {
+                m_arr = (Variant*)memalloc(sizeof(Variant) * capacity);
+                m_array_or_object_header.m_capacity = (u16)capacity;
+            }
+            else
+            {
+                do_small_arr_reserve(capacity);
+            }
+        }
+    }
     inline Variant::Variant(const Variant& rhs)
     {
         do_construct(rhs);
@@ -707,7 +748,7 @@ namespace Luna
                 if (m_obj)
                 {
                     destruct_range(m_obj, m_obj + m_array_or_object_header.m_size);
-                    memfree(m_obj);
+                    if (!test_flags(m_object_flag, ObjectFlag::arena)) memfree(m_obj);
                 }
             }
             break;
@@ -721,7 +762,7 @@ namespace Luna
                 if (m_arr)
                 {
                     destruct_range(m_arr, m_arr + m_array_or_object_header.m_size);
-                    memfree(m_arr);
+                    if (!test_flags(m_array_flag, ArrayFlag::arena)) memfree(m_arr);
                 }
             }
             break;
@@ -793,6 +834,7 @@ namespace Luna
             }
             else
             {
+                reset_flags(m_object_flag, ObjectFlag::arena);
                 m_array_or_object_header.m_size = rhs.m_array_or_object_header.m_size;
                 m_array_or_object_header.m_capacity = rhs.m_array_or_object_header.m_capacity;
                 m_obj = (Pair<const Name, Variant>*)memalloc(
@@ -808,6 +850,7 @@ namespace Luna
             }
             else
             {
+                reset_flags(m_array_flag, ArrayFlag::arena);
                 m_array_or_object_header.m_size = rhs.m_array_or_object_header.m_size;
                 m_array_or_object_header.m_capacity = rhs.m_array_or_object_header.m_capacity;
                 m_arr = (Variant*)memalloc(sizeof(Variant) * m_array_or_object_header.m_capacity);
@@ -1063,8 +1106,9 @@ namespace Luna
                 if (m_arr)
                 {
                     copy_relocate_range(m_arr, m_arr + (usize)m_array_or_object_header.m_size, new_buf);
-                    memfree(m_arr);
+                    if (!test_flags(m_array_flag, ArrayFlag::arena)) memfree(m_arr);
                 }
+                reset_flags(m_array_flag, ArrayFlag::arena);
                 m_arr = new_buf;
                 m_array_or_object_header.m_capacity = (u16)new_cap;
                 return false;
@@ -1080,7 +1124,8 @@ namespace Luna
                     new_arr->push_back(move(m_arr[i]));
                 }
                 destruct_range(m_arr, m_arr + (usize)m_array_or_object_header.m_size);
-                memfree(m_arr);
+                if (!test_flags(m_array_flag, ArrayFlag::arena)) memfree(m_arr);
+                reset_flags(m_array_flag, ArrayFlag::arena);
                 m_arr = nullptr;
                 m_big_arr = new_arr;
                 return true;
@@ -1099,8 +1144,9 @@ namespace Luna
                 if (m_obj)
                 {
                     copy_relocate_range(m_obj, m_obj + (usize)m_array_or_object_header.m_size, new_buf);
-                    memfree(m_obj);
+                    if (!test_flags(m_object_flag, ObjectFlag::arena)) memfree(m_obj);
                 }
+                reset_flags(m_object_flag, ObjectFlag::arena);
                 m_obj = new_buf;
                 m_array_or_object_header.m_capacity = (u16)new_cap;
                 return false;
@@ -1115,7 +1161,8 @@ namespace Luna
                     new_obj->insert(move(m_obj[i]));
                 }
                 destruct_range(m_obj, m_obj + (usize)m_array_or_object_header.m_size);
-                memfree(m_obj);
+                if (!test_flags(m_object_flag, ObjectFlag::arena)) memfree(m_obj);
+                reset_flags(m_object_flag, ObjectFlag::arena);
                 m_obj = nullptr;
                 m_big_obj = new_obj;
                 return true;
@@ -36,6 +36,30 @@ namespace Luna
         void* (*cast_to_interface)(object_t obj);
     };
 
+    //! The interned ID of one interface or type GUID.
+    //! @details Interned IDs are small sequential integers assigned to GUIDs by the runtime, which are used to index 
+    //! per-type interface dispatch tables directly.
+    using interface_id_t = u32;
+
+    //! The invalid interned ID.
+    constexpr interface_id_t INVALID_INTERFACE_ID = U32_MAX;
+
+    //! Gets the interned ID of one GUID.
+    //! @details The same GUID always gets the same ID in one process, and one new ID will be assigned if the GUID is not interned.
+    //! @param[in] guid The GUID to intern.
+    //! @return Returns the interned ID of the GUID.
+    LUNA_RUNTIME_API interface_id_t get_interface_id(const Guid& guid);
+
+    //! Gets the interned ID of one interface or type.
+    //! @details The ID is fetched from the runtime only once, and is cached in one static variable for later calls.
+    //! @return Returns the interned ID of `_Ity::__guid`.
+    template <typename _Ity>
+    interface_id_t get_interface_id()
+    {
+        static const interface_id_t id = get_interface_id(_Ity::__guid);
+        return id;
+    }
+
     //! Registers one interface implementation.
     //! @param[in] desc The interface implementation descriptor.
     LUNA_RUNTIME_API void impl_interface_for_type(const InterfaceImplDesc& desc);
@@ -74,6 +98,21 @@ namespace Luna
     //! Returns `nullptr` if the specified interface is not implemented by the specified boxed object.
     LUNA_RUNTIME_API void* query_interface(object_t object, const Guid& iid);
 
+    //! Gets one interface pointer from one pointer to one boxed object that implements the interface.
+    //! @param[in] object The pointer to the boxed object to query interface from.
+    //! @param[in] iid The interned ID of the interface GUID to query.
+    //! @return Returns one pointer that can be safely reinterpreted to the specified interface pointer.
+    //! Returns `nullptr` if the specified interface is not implemented by the specified boxed object.
+    LUNA_RUNTIME_API void* query_interface_by_id(object_t object, interface_id_t iid);
+
+    //! Casts one boxed object to the specified type, or queries the specified interface from the object if the object is not
+    //! the specified type or derived types of the specified type.
+    //! @param[in] object The pointer to the boxed object to cast.
+    //! @param[in] iid The interned ID of the type or interface GUID.
+    //! @return Returns `object` if the boxed object is the specified type or derived types of the specified type. Returns 
+    //! the interface pointer if the boxed object implements the specified interface. Returns `nullptr` otherwise.
+    LUNA_RUNTIME_API void* cast_object_or_query_interface(object_t object, interface_id_t iid);
+
     //! Gets one interface pointer from one pointer to one boxed object that implements the interface.
     //! @param[in] object The pointer to the boxed object to query interface from.
     //! @return Returns the specified interface pointer for the boxed object.
@@ -87,7 +126,7 @@ namespace Luna
     template <typename _Ity>
     _Ity* query_interface(object_t object)
     {
-        return object ? (_Ity*)query_interface(object, _Ity::__guid) : nullptr;
+        return object ? (_Ity*)query_interface_by_id(object, get_interface_id<_Ity>()) : nullptr;
     }
 
     //! @interface Interface
@@ -0,0 +1,230 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file LZ4.hpp
+* @author JXMaster
+* @date 2024/3/23
+*/
+#pragma once
+#include "Base.hpp"
+#include "MemoryUtils.hpp"
+
+namespace Luna
+{
+    //! @addtogroup Runtime
+    //! @{
+
+    //! One minimal codec for LZ4 block format (https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md).
+    //! @details The compressor uses one single-entry hash table, which trades compression ratio for speed.
+    namespace LZ4
+    {
+        constexpr usize MIN_MATCH = 4;
+        // The last match must start at least 12 bytes before the end of the block.
+        constexpr usize MFLIMIT = 12;
+        // The last 5 bytes of the block are always literals.
+        constexpr usize LAST_LITERALS = 5;
+        constexpr usize MAX_DISTANCE = 65535;
+        constexpr u32 HASH_LOG = 12;
+
+        //! Gets the maximum compressed size of data of the specified size.
+        inline usize compress_bound(usize size)
+        {
+            return size + size / 255 + 16;
+        }
+
+        inline u32 load_u32(const byte_t* p)
+        {
+            u32 v;
+            memcpy(&v, p, sizeof(u32));
+            return v;
+        }
+
+        inline byte_t* write_length(byte_t* op, usize len)
+        {
+            while (len >= 255)
+            {
+                *op++ = 255;
+                len -= 255;
+            }
+            *op++ = (byte_t)len;
+            return op;
+        }
+
+        inline u32 hash_sequence(u32 seq)
+        {
+            return (seq * 2654435761U) >> (32 - HASH_LOG);
+        }
+
+        //! Compresses data to LZ4 block format, allowing matches to refer to data placed before the data to compress.
+        //! @param[in] src The data to compress. The source size must be smaller than 4GB.
+        //! @param[in] src_size The size of the data to compress in bytes.
+        //! @param[in] prefix_size The size of the data placed right before `src` that can be referred by matches. This data
+        //! is not compressed, and must be provided as the dictionary when decompressing. Only the last 64KB of the prefix can be
+        //! referred, so this should not be greater than @ref MAX_DISTANCE.
+        //! @param[in] dst The buffer to write compressed data to.
+        //! @param[in] dst_capacity The size of `dst` in bytes. Specify one size not smaller than @ref compress_bound to make sure that
+        //! compression always succeeds.
+        //! @return Returns the compressed size, or `0` if the compressed data does not fit in `dst_capacity`.
+        inline usize compress_with_prefix(const byte_t* src, usize src_size, usize prefix_size, byte_t* dst, usize dst_capacity)
+        {
+            const byte_t* base = src - prefix_size;
+            const byte_t* ip = src;
+            const byte_t* anchor = src;
+            const byte_t* iend = src + src_size;
+            byte_t* op = dst;
+            byte_t* oend = dst + dst_capacity;
+            if (src_size > MFLIMIT)
+            {
+                const byte_t* mflimit = iend - MFLIMIT;
+                const byte_t* matchlimit = iend - LAST_LITERALS;
+                u32 table[1 << HASH_LOG];
+                memzero(table, sizeof(table));
+                // Indexes the prefix so that the first sequences of the source can match it.
+                for (const byte_t* p = base; p + MIN_MATCH <= src; ++p)
+                {
+                    table[hash_sequence(load_u32(p))] = (u32)(p - base);
+                }
+                while (ip < mflimit)
+                {
+                    u32 seq = load_u32(ip);
+                    u32 h = hash_sequence(seq);
+                    const byte_t* ref = base + table[h];
+                    table[h] = (u32)(ip - base);
+                    if (ref >= ip || (usize)(ip - ref) > MAX_DISTANCE || load_u32(ref) != seq)
+                    {
+                        ++ip;
+                        continue;
+                    }
+                    const byte_t* mp = ip + MIN_MATCH;
+                    const byte_t* rp = ref + MIN_MATCH;
+                    while (mp < matchlimit && *mp == *rp)
+                    {
+                        ++mp;
+                        ++rp;
+                    }
+                    usize lit_len = (usize)(ip - anchor);
+                    usize match_len = (usize)(mp - ip) - MIN_MATCH;
+                    if ((usize)(oend - op) < 1 + lit_len / 255 + 1 + lit_len + 2 + match_len / 255 + 1) return 0;
+                    byte_t* token = op++;
+                    *token = (byte_t)(min<usize>(lit_len, 15) << 4);
+                    if (lit_len >= 15) op = write_length(op, lit_len - 15);
+                    memcpy(op, anchor, lit_len);
+                    op += lit_len;
+                    usize offset = (usize)(ip - ref);
+                    *op++ = (byte_t)(offset & 0xFF);
+                    *op++ = (byte_t)(offset >> 8);
+                    *token |= (byte_t)min<usize>(match_len, 15);
+                    if (match_len >= 15) op = write_length(op, match_len - 15);
+                    ip = mp;
+                    anchor = ip;
+                }
+            }
+            // Writes last literals.
+            usize lit_len = (usize)(iend - anchor);
+            if ((usize)(oend - op) < 1 + lit_len / 255 + 1 + lit_len) return 0;
+            *op++ = (byte_t)(min<usize>(lit_len, 15) << 4);
+            if (lit_len >= 15) op = write_length(op, lit_len - 15);
+            memcpy(op, anchor, lit_len);
+            op += lit_len;
+            return (usize)(op - dst);
+        }
+
+        //! Compresses data to LZ4 block format.
+        //! @param[in] src The data to compress. The source size must be smaller than 4GB.
+        //! @param[in] src_size The size of the data to compress in bytes.
+        //! @param[in] dst The buffer to write compressed data to.
+        //! @param[in] dst_capacity The size of `dst` in bytes. Specify one size not smaller than @ref compress_bound to make sure that 
+        //! compression always succeeds.
+        //! @return Returns the compressed size, or `0` if the compressed data does not fit in `dst_capacity`.
+        inline usize compress(const byte_t* src, usize src_size, byte_t* dst, usize dst_capacity)
+        {
+            return compress_with_prefix(src, src_size, 0, dst, dst_capacity);
+        }
+
+        //! Decompresses data in LZ4 block format that is compressed by @ref compress_with_prefix.
+        //! @param[in] src The compressed data.
+        //! @param[in] src_size The size of the compressed data in bytes.
+        //! @param[in] dst The buffer to write decompressed data to.
+        //! @param[in] dst_size The size of the decompressed data in bytes.
+        //! @param[in] dict The prefix data used when compressing the data. This does not need to be placed before `dst`.
+        //! @param[in] dict_size The size of `dict` in bytes.
+        //! @return Returns `false` if the compressed data is corrupted or does not decompress to exactly `dst_size` bytes.
+        inline bool decompress_with_dict(const byte_t* src, usize src_size, byte_t* dst, usize dst_size, const byte_t* dict, usize dict_size)
+        {
+            const byte_t* dict_end = dict + dict_size;
+            const byte_t* ip = src;
+            const byte_t* iend = src + src_size;
+            byte_t* op = dst;
+            byte_t* oend = dst + dst_size;
+            while (ip < iend)
+            {
+                u32 token = *ip++;
+                usize lit_len = token >> 4;
+                if (lit_len == 15)
+                {
+                    byte_t b;
+                    do
+                    {
+                        if (ip >= iend) return false;
+                        b = *ip++;
+                        lit_len += b;
+                    } while (b == 255);
+                }
+                if ((usize)(iend - ip) < lit_len || (usize)(oend - op) < lit_len) return false;
+                memcpy(op, ip, lit_len);
+                op += lit_len;
+                ip += lit_len;
+                // The last sequence only contains literals.
+                if (ip == iend) break;
+                if (iend - ip < 2) return false;
+                usize offset = (usize)ip[0] | ((usize)ip[1] << 8);
+                ip += 2;
+                if (offset == 0 || offset > (usize)(op - dst) + dict_size) return false;
+                usize match_len = token & 0x0F;
+                if (match_len == 15)
+                {
+                    byte_t b;
+                    do
+                    {
+                        if (ip >= iend) return false;
+                        b = *ip++;
+                        match_len += b;
+                    } while (b == 255);
+                }
+                match_len += MIN_MATCH;
+                if ((usize)(oend - op) < match_len) return false;
+                usize i = 0;
+                if (offset > (usize)(op - dst))
+                {
+                    // Copies the part of the match that is in the dictionary.
+                    const byte_t* match = dict_end - (offset - (usize)(op - dst));
+                    usize dict_len = min<usize>((usize)(dict_end - match), match_len);
+                    memcpy(op, match, dict_len);
+                    i = dict_len;
+                }
+                // The match may overlap with the output, so bytes are copied one by one.
+                for (; i < match_len; ++i)
+                {
+                    op[i] = *(op + i - offset);
+                }
+                op += match_len;
+            }
+            return op == oend;
+        }
+
+        //! Decompresses data in LZ4 block format.
+        //! @param[in] src The compressed data.
+        //! @param[in] src_size The size of the compressed data in bytes.
+        //! @param[in] dst The buffer to write decompressed data to.
+        //! @param[in] dst_size The size of the decompressed data in bytes.
+        //! @return Returns `false` if the compressed data is corrupted or does not decompress to exactly `dst_size` bytes.
+        inline bool decompress(const byte_t* src, usize src_size, byte_t* dst, usize dst_size)
+        {
+            return decompress_with_dict(src, src_size, dst, dst_size, nullptr, 0);
+        }
+    }
+
+    //! @}
+}
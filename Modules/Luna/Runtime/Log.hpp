@@ -60,6 +60,13 @@ namespace Luna
     //! @param[in] format The log message format.
     //! @param[in] args Arguments used to format the log message.
     LUNA_RUNTIME_API void logv(LogVerbosity verbosity, const c8* tag, const c8* format, VarList args);
+
+    //! Logs one message that is already formatted.
+    //! @details The message is passed to log handlers directly without being formatted or copied.
+    //! @param[in] verbosity The log verbosity.
+    //! @param[in] tag The log tag. Used by the implementation to filter logs.
+    //! @param[in] message The log message.
+    LUNA_RUNTIME_API void log_message(LogVerbosity verbosity, const c8* tag, StringView message);
     
     //! Outputs one log message with @ref LogVerbosity::verbose verbosity.
     //! @param[in] tag The log tag. Used by the implementation to filter logs.
@@ -107,6 +114,117 @@ namespace Luna
     //! @param[in] args Arguments used to format the log message.
     LUNA_RUNTIME_API void logv_error(const c8* tag, const c8* format, VarList args);
 
+    namespace Impl
+    {
+        //! Type codes of arguments stored in deferred log records.
+        enum class DeferredLogArgType : u8
+        {
+            signed_int = 1,
+            unsigned_int = 2,
+            floating_point = 3,
+            string = 4,
+            pointer = 5,
+        };
+
+        template <typename _Ty>
+        inline usize get_deferred_log_arg_size(const _Ty& arg)
+        {
+            static_assert(is_arithmetic_v<_Ty> || is_enum_v<_Ty> || is_pointer_v<_Ty>, "Deferred log arguments must be arithmetic types, enumerations, strings or pointers.");
+            return 1 + 8;
+        }
+        inline usize get_deferred_log_arg_size(const c8* arg)
+        {
+            return 1 + sizeof(u32) + (arg ? strlen(arg) : 0);
+        }
+        inline usize get_deferred_log_arg_size(c8* arg)
+        {
+            return get_deferred_log_arg_size((const c8*)arg);
+        }
+
+        template <typename _Ty>
+        inline void write_deferred_log_arg(u8*& dst, const _Ty& arg)
+        {
+            DeferredLogArgType type;
+            u64 value;
+            if constexpr (is_floating_point_v<_Ty>)
+            {
+                type = DeferredLogArgType::floating_point;
+                f64 v = (f64)arg;
+                memcpy(&value, &v, sizeof(f64));
+            }
+            else if constexpr (is_pointer_v<_Ty>)
+            {
+                type = DeferredLogArgType::pointer;
+                value = (u64)(usize)arg;
+            }
+            else if constexpr (is_enum_v<_Ty>)
+            {
+                type = DeferredLogArgType::signed_int;
+                value = (u64)(i64)arg;
+            }
+            else if constexpr (is_signed_v<_Ty>)
+            {
+                type = DeferredLogArgType::signed_int;
+                value = (u64)(i64)arg;
+            }
+            else
+            {
+                type = DeferredLogArgType::unsigned_int;
+                value = (u64)arg;
+            }
+            *dst = (u8)type;
+            memcpy(dst + 1, &value, sizeof(u64));
+            dst += 1 + sizeof(u64);
+        }
+        inline void write_deferred_log_arg(u8*& dst, const c8* arg)
+        {
+            u32 len = arg ? (u32)strlen(arg) : 0;
+            *dst = (u8)DeferredLogArgType::string;
+            memcpy(dst + 1, &len, sizeof(u32));
+            if (len) memcpy(dst + 1 + sizeof(u32), arg, len);
+            dst += 1 + sizeof(u32) + len;
+        }
+        inline void write_deferred_log_arg(u8*& dst, c8* arg)
+        {
+            write_deferred_log_arg(dst, (const c8*)arg);
+        }
+
+        //! Allocates one deferred log record in the log ring buffer of the current thread.
+        //! @param[in] size The size of the record.
+        //! @return Returns the record buffer, or `nullptr` if the log system is not initialized.
+        LUNA_RUNTIME_API void* begin_deferred_log(usize size);
+        //! Submits the record allocated by @ref begin_deferred_log.
+        LUNA_RUNTIME_API void end_deferred_log();
+    }
+
+    //! Logs one message without formatting it on the calling thread.
+    //! @details This function stores pointers to `tag` and `format` along with raw argument values into one log ring buffer of
+    //! the calling thread, which does not need any lock and is much cheaper than formatting the message. The message is formatted 
+    //! on the log writer thread later and dispatched to log handlers on that thread. This can be used for high-frequency diagnostics.
+    //! 
+    //! Deferred logs of one thread are dispatched in order, but may be dispatched after logs that are emitted later by 
+    //! other log functions. Call @ref flush_log_to_file to wait for deferred logs to be dispatched.
+    //! @param[in] verbosity The log verbosity.
+    //! @param[in] tag The log tag. This must point to one string with static storage duration, like one string literal.
+    //! @param[in] format The log message format. This must point to one string with static storage duration, like one string literal.
+    //! Conversion specifiers are supported except `%n` and `*` width and precision. Arguments are formatted based on their types stored in 
+    //! the record, so length modifiers are not required.
+    //! @param[in] args Arguments used to format the log message. Arguments must be arithmetic types, enumerations, strings or pointers. 
+    //! Strings are copied into the record when this function is called.
+    template <typename... _Args>
+    inline void log_deferred(LogVerbosity verbosity, const c8* tag, const c8* format, const _Args&... args)
+    {
+        usize size = 1 + sizeof(const c8*) * 2 + (Impl::get_deferred_log_arg_size(args) + ... + 0);
+        u8* dst = (u8*)Impl::begin_deferred_log(size);
+        if (!dst) return;
+        *dst = (u8)verbosity;
+        memcpy(dst + 1, &tag, sizeof(const c8*));
+        memcpy(dst + 1 + sizeof(const c8*), &format, sizeof(const c8*));
+        dst += 1 + sizeof(const c8*) * 2;
+        (Impl::write_deferred_log_arg(dst, args), ...);
+        Impl::end_deferred_log();
+    }
+
     //! Registers one custom log handler that will be called when a new log message is spawned.
     //! @param[in] handler The handler to register.
     //! @return Returns one handler identifier that can be used to register the handler.
@@ -129,14 +247,28 @@ namespace Luna
     //! @param[in] file The file path of the log file. The file path may be absolute or relative to the current working directory.
     //! @remark If the log file path is not set by the user, the default log file path will be `"./Log.txt"`.
     LUNA_RUNTIME_API void set_log_file(const c8* file);
+    //! Sets the rotation policy of the log file.
+    //! @details When the log file needs to be rotated, the current log file is renamed to `<file>.1`, the existing `<file>.1` 
+    //! is renamed to `<file>.2`, and so on, and one new log file is created. Backup files whose index is greater than `max_backup_files`
+    //! are discarded.
+    //! @param[in] max_file_size The maximum size of the log file in bytes. The log file is rotated before it grows larger than this size.
+    //! Specify `0` to disable size-based rotation.
+    //! @param[in] max_file_age The maximum number of seconds one log file is written to since it is opened. The log file is rotated
+    //! when new logs are written after this time. Specify `0` to disable time-based rotation.
+    //! @param[in] max_backup_files The maximum number of backup files to keep. If this is `0`, the log file is deleted when it is rotated.
+    LUNA_RUNTIME_API void set_log_file_rotation(u64 max_file_size, u64 max_file_age, u32 max_backup_files);
     //! Sets the maximum log verbosity level that will be outputted to the log file.
     //! @param[in] verbosity Specifies the maximum log verbosity level that will be outputted to the log file.
     LUNA_RUNTIME_API void set_log_to_file_verbosity(LogVerbosity verbosity);
-    //! Flushes the log-to-file cache and writes all cached logs to the log file.
-    //! @remark For performance reasons, when logging-to-file is enabled, log messages will be cached in a log buffer and written
-    //! to the log file in one call when the buffer is full. The user can also call @ref flush_log_to_file to flush the cache
-    //! manually when needed.
-    LUNA_RUNTIME_API void flush_log_to_file();
+    //! Waits for all logs emitted before this call to be written to the log file.
+    //! @details Deferred logs emitted by @ref log_deferred before this call are also dispatched before this function returns.
+    //! @details For performance reasons, when logging-to-file is enabled, log messages are copied to one log ring buffer and 
+    //! written to the log file by one dedicated writer thread, so threads that emit logs never wait for file IO unless the ring buffer
+    //! is full. The user can call @ref flush_log_to_file to make sure that logs are written to the log file, for example, before
+    //! the application crashes.
+    //! @param[in] timeout_milliseconds The maximum time to wait in milliseconds. Specify `U32_MAX` to wait until all logs are written.
+    //! @return Returns `true` if all logs emitted before this call are written to the log file. Returns `false` if the time is out.
+    LUNA_RUNTIME_API bool flush_log_to_file(u32 timeout_milliseconds = U32_MAX);
 
     //! @}
 }
\ No newline at end of file
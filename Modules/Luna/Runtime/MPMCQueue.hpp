@@ -0,0 +1,202 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file MPMCQueue.hpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#pragma once
+#include "Allocator.hpp"
+#include "Atomic.hpp"
+#include "Assert.hpp"
+#include "MemoryUtils.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeContainer
+    //! @{
+
+    //! One bounded lock-free first-in-first-out queue that can be used by multiple producer threads and multiple consumer threads.
+    //! @details The queue allocates one fixed circular buffer when constructed, and never allocates memory after that.
+    //! Every slot of the buffer stores one sequence number that tells whether the slot is ready to be written by producers or
+    //! read by consumers, so producers and consumers only need one compare-and-swap operation on the shared index to claim one slot.
+    //!
+    //! If there is only one producer thread and one consumer thread, use @ref SPSCQueue instead, which is cheaper.
+    //! @tparam _Ty The element type of the queue.
+    //! @tparam _Alloc The allocator type of the queue.
+    template <typename _Ty, typename _Alloc = Allocator>
+    class MPMCQueue
+    {
+        struct Cell
+        {
+            usize volatile m_sequence;
+            alignas(_Ty) u8 m_data[sizeof(_Ty)];
+
+            _Ty* get() { return (_Ty*)m_data; }
+        };
+    public:
+        using value_type = _Ty;
+        using allocator_type = _Alloc;
+
+        //! Constructs one empty queue.
+        //! @param[in] capacity The maximum number of elements that can be stored in the queue. This will be rounded up to
+        //! power of two, and must not be smaller than `2`.
+        //! @param[in] alloc The allocator to use.
+        MPMCQueue(usize capacity, const allocator_type& alloc = allocator_type()) :
+            m_enqueue_pos(0),
+            m_dequeue_pos(0),
+            m_allocator_and_buffer(alloc, nullptr)
+        {
+            usize cap = 2;
+            while (cap < capacity) cap <<= 1;
+            m_mask = cap - 1;
+            Cell* buf = m_allocator_and_buffer.first().template allocate<Cell>(cap);
+            for (usize i = 0; i < cap; ++i)
+            {
+                buf[i].m_sequence = i;
+            }
+            m_allocator_and_buffer.second() = buf;
+        }
+        MPMCQueue(const MPMCQueue&) = delete;
+        MPMCQueue& operator=(const MPMCQueue&) = delete;
+        ~MPMCQueue()
+        {
+            Cell* buf = m_allocator_and_buffer.second();
+            for (usize i = m_dequeue_pos; i != m_enqueue_pos; ++i)
+            {
+                Cell& cell = buf[i & m_mask];
+                if (cell.m_sequence == i + 1)
+                {
+                    cell.get()->~value_type();
+                }
+            }
+            m_allocator_and_buffer.first().template deallocate<Cell>(buf, m_mask + 1);
+        }
+        //! Gets the maximum number of elements that can be stored in the queue.
+        usize capacity() const
+        {
+            return m_mask + 1;
+        }
+        //! Gets an estimated number of elements in the queue.
+        //! @details The returned value may be outdated as soon as this function returns if other threads are
+        //! accessing the queue.
+        usize size() const
+        {
+            usize dequeue_pos = m_dequeue_pos;
+            usize enqueue_pos = m_enqueue_pos;
+            isize size = (isize)(enqueue_pos - dequeue_pos);
+            return size > 0 ? (usize)size : 0;
+        }
+        //! Checks whether the queue is empty. See remarks of @ref size for details.
+        bool empty() const
+        {
+            return size() == 0;
+        }
+        //! Constructs one element at the back of the queue. This function can be called from multiple threads.
+        //! @param[in] args The arguments to construct the element.
+        //! @return Returns `true` if the element is pushed, returns `false` if the queue is full. The element is not
+        //! constructed if the queue is full.
+        template <typename... _Args>
+        bool emplace(_Args&&... args)
+        {
+            Cell* buf = m_allocator_and_buffer.second();
+            Cell* cell;
+            usize pos = m_enqueue_pos;
+            while (true)
+            {
+                cell = buf + (pos & m_mask);
+                usize seq = cell->m_sequence;
+                isize diff = (isize)(seq - pos);
+                if (diff == 0)
+                {
+                    // The slot is free, try to claim it.
+                    usize prev = atom_compare_exchange_usize(&m_enqueue_pos, pos + 1, pos);
+                    if (prev == pos) break;
+                    pos = prev;
+                }
+                else if (diff < 0)
+                {
+                    // The slot still holds the element pushed one round before, so the queue is full.
+                    return false;
+                }
+                else
+                {
+                    // Another producer has claimed the slot.
+                    pos = m_enqueue_pos;
+                }
+            }
+            new (cell->get()) value_type(forward<_Args>(args)...);
+            // Publishes the element to consumers.
+            atom_exchange_usize(&cell->m_sequence, pos + 1);
+            return true;
+        }
+        //! Pushes one element to the back of the queue. This function can be called from multiple threads.
+        //! @param[in] val The element to push.
+        //! @return Returns `true` if the element is pushed, returns `false` if the queue is full.
+        bool push(const value_type& val)
+        {
+            return emplace(val);
+        }
+        //! Pushes one element to the back of the queue. This function can be called from multiple threads.
+        //! @param[in] val The element to push. The element is moved only if this function returns `true`.
+        //! @return Returns `true` if the element is pushed, returns `false` if the queue is full.
+        bool push(value_type&& val)
+        {
+            return emplace(move(val));
+        }
+        //! Pops one element from the front of the queue. This function can be called from multiple threads.
+        //! @param[out] val The popped element.
+        //! @return Returns `true` if one element is popped, returns `false` if the queue is empty.
+        bool pop(value_type& val)
+        {
+            Cell* buf = m_allocator_and_buffer.second();
+            Cell* cell;
+            usize pos = m_dequeue_pos;
+            while (true)
+            {
+                cell = buf + (pos & m_mask);
+                usize seq = cell->m_sequence;
+                isize diff = (isize)(seq - (pos + 1));
+                if (diff == 0)
+                {
+                    // The slot holds one published element, try to claim it.
+                    usize prev = atom_compare_exchange_usize(&m_dequeue_pos, pos + 1, pos);
+                    if (prev == pos) break;
+                    pos = prev;
+                }
+                else if (diff < 0)
+                {
+                    // The slot is not published yet, so the queue is empty.
+                    return false;
+                }
+                else
+                {
+                    // Another consumer has claimed the slot.
+                    pos = m_dequeue_pos;
+                }
+            }
+            value_type* elem = cell->get();
+            val = move(*elem);
+            elem->~value_type();
+            // Releases the slot to producers of the next round.
+            atom_exchange_usize(&cell->m_sequence, pos + m_mask + 1);
+            return true;
+        }
+        //! Gets one copy of the allocator of the queue.
+        allocator_type get_allocator() const
+        {
+            return m_allocator_and_buffer.first();
+        }
+    private:
+        // The producer and consumer indices are placed in different cache lines so that producers and
+        // consumers do not invalidate each other's cache line on every operation.
+        alignas(64) usize volatile m_enqueue_pos;
+        alignas(64) usize volatile m_dequeue_pos;
+        alignas(64) OptionalPair<allocator_type, Cell*> m_allocator_and_buffer;
+        usize m_mask;
+    };
+
+    //! @}
+}
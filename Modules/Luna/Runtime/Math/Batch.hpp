@@ -0,0 +1,131 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Batch.hpp
+* @author JXMaster
+* @date 2024/5/5
+* @brief Math operations that process arrays of vectors and matrices.
+ */
+#pragma once
+#include "Transform.hpp"
+
+#ifndef LUNA_RUNTIME_API
+#define LUNA_RUNTIME_API
+#endif
+
+namespace Luna
+{
+    //! @addtogroup RuntimeMath
+    //! @{
+    //! @defgroup RuntimeMathBatch Batch operations
+    //! @}
+
+    //! @addtogroup RuntimeMathBatch
+    //! @{
+
+    //! Transforms points by one matrix.
+    //! @details
+    //! ```
+    //! FOR i := 0 to count - 1
+    //!     dst[i] := mul(Float4(src[i], 1), m).xyz
+    //! ENDFOR
+    //! ```
+    //! @param[in] m The transform matrix.
+    //! @param[in] src The points to transform.
+    //! @param[out] dst The buffer to write transformed points to. This can be the same as `src`.
+    //! @param[in] count The number of points to transform.
+    LUNA_RUNTIME_API void transform_points(const Float4x4& m, const Float3U* src, Float3U* dst, usize count);
+
+    //! Transforms directions by one matrix. The translation part of the matrix is ignored.
+    //! @details
+    //! ```
+    //! FOR i := 0 to count - 1
+    //!     dst[i] := mul(Float4(src[i], 0), m).xyz
+    //! ENDFOR
+    //! ```
+    //! To transform normals, pass the inverse transpose of the matrix that transforms points.
+    //! @param[in] m The transform matrix.
+    //! @param[in] src The directions to transform.
+    //! @param[out] dst The buffer to write transformed directions to. This can be the same as `src`.
+    //! @param[in] count The number of directions to transform.
+    LUNA_RUNTIME_API void transform_directions(const Float4x4& m, const Float3U* src, Float3U* dst, usize count);
+
+    //! Multiplies matrices element-wise.
+    //! @details
+    //! ```
+    //! FOR i := 0 to count - 1
+    //!     dst[i] := mul(a[i], b[i])
+    //! ENDFOR
+    //! ```
+    //! @param[in] a The left-hand matrices.
+    //! @param[in] b The right-hand matrices.
+    //! @param[out] dst The buffer to write results to. This can be the same as `a` or `b`.
+    //! @param[in] count The number of matrices to multiply.
+    LUNA_RUNTIME_API void mul_matrices(const Float4x4* a, const Float4x4* b, Float4x4* dst, usize count);
+
+    //! Multiplies matrices by one matrix.
+    //! @details
+    //! ```
+    //! FOR i := 0 to count - 1
+    //!     dst[i] := mul(a[i], b)
+    //! ENDFOR
+    //! ```
+    //! @param[in] a The left-hand matrices.
+    //! @param[in] b The right-hand matrix.
+    //! @param[out] dst The buffer to write results to. This can be the same as `a`.
+    //! @param[in] count The number of matrices to multiply.
+    LUNA_RUNTIME_API void mul_matrices(const Float4x4* a, const Float4x4& b, Float4x4* dst, usize count);
+
+    //! Builds 3D affine matrices from arrays of translations, rotations and scalings.
+    //! @details
+    //! ```
+    //! FOR i := 0 to count - 1
+    //!     dst[i] := AffineMatrix::make(translations[i], rotations[i], scalings[i])
+    //! ENDFOR
+    //! ```
+    //! @param[in] translations The translation vectors.
+    //! @param[in] rotations The rotation quaternions.
+    //! @param[in] scalings The scaling vectors.
+    //! @param[out] dst The buffer to write built matrices to.
+    //! @param[in] count The number of matrices to build.
+    LUNA_RUNTIME_API void make_affine_matrices(const Float3U* translations, const Float4U* rotations, const Float3U* scalings, Float4x4* dst, usize count);
+
+    //! Transforms axis-aligned bounding boxes by matrices, and computes axis-aligned bounding boxes of transformed boxes.
+    //! @param[in] matrices The transform matrices. Every bounding box is transformed by the matrix with the same index.
+    //! @param[in] mins The minimum points of bounding boxes.
+    //! @param[in] maxs The maximum points of bounding boxes.
+    //! @param[out] dst_mins The buffer to write minimum points of transformed bounding boxes to.
+    //! @param[out] dst_maxs The buffer to write maximum points of transformed bounding boxes to.
+    //! @param[in] count The number of bounding boxes to transform.
+    LUNA_RUNTIME_API void transform_aabbs(const Float4x4* matrices, const Float3U* mins, const Float3U* maxs, Float3U* dst_mins, Float3U* dst_maxs, usize count);
+
+    //! Represents one view frustum by six planes.
+    //! @details Every plane is stored as (a, b, c, d), so that points (x, y, z) that satisfy `a * x + b * y + c * z + d >= 0` 
+    //! are on the inner side of the plane.
+    struct Frustum
+    {
+        //! The left, right, bottom, top, near and far planes of the frustum.
+        Float4 planes[6];
+    };
+
+    //! Extracts frustum planes from one view-projection matrix.
+    //! @param[in] view_to_proj The matrix that transforms points to the clip space. The clip space should use [0, 1] depth range.
+    //! @return Returns the frustum whose planes are in the space before the transformation.
+    LUNA_RUNTIME_API Frustum make_frustum(const Float4x4& view_to_proj);
+
+    //! Tests whether axis-aligned bounding boxes intersect with one frustum.
+    //! @details The test is conservative: boxes that are outside of the frustum may be reported as visible if they are 
+    //! near to the frustum corners, but boxes that intersect with the frustum are never reported as not visible.
+    //! @param[in] frustum The frustum to test.
+    //! @param[in] mins The minimum points of bounding boxes.
+    //! @param[in] maxs The maximum points of bounding boxes.
+    //! @param[out] results The buffer to write test results to. Every element is set to `1` if the bounding box 
+    //! intersects with the frustum, or `0` otherwise.
+    //! @param[in] count The number of bounding boxes to test.
+    //! @return Returns the number of bounding boxes that intersect with the frustum.
+    LUNA_RUNTIME_API usize test_aabbs_in_frustum(const Frustum& frustum, const Float3U* mins, const Float3U* maxs, u8* results, usize count);
+
+    //! @}
+}
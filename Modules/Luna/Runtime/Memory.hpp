@@ -57,8 +57,10 @@ namespace Luna
     //! new memory block must be the same.
     //! @return Returns one pointer to the reallocated memory block.
     //! Returns `nullptr` if the allocation is failed. In such case, the old memory block (if have) is not changed.
-    //! @details This function allocates a new memory block with the specified size and alignment
-    //! requirement, copies the data from the old memory block to the new one, and frees the old memory block.
+    //! @details If the old memory block is large enough to hold `size` bytes, this function returns `ptr` directly.
+    //! Otherwise, this function tries to extend the old memory block in place (or remap its pages for large memory blocks), and 
+    //! falls back to allocating a new memory block, copying the data from the old memory block to the new one, and freeing the 
+    //! old memory block if the old memory block cannot be extended. The returned pointer may be equal to or different from `ptr`.
     //! @par Valid Usage
     //! * If `ptr` is not `nullptr`, `ptr` **must** be allocated by a prior call to @ref memalloc or @ref memrealloc.
     //! * If `ptr` is not `nullptr`, `alignment` **must** be equal to `alignment` passed to @ref memalloc or @ref memrealloc which allocates `ptr`.
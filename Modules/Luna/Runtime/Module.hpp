@@ -26,6 +26,22 @@ namespace Luna
     //! @addtogroup RuntimeModule
     //! @{
 
+    //! Specifies how one module is initialized by the module system.
+    enum class ModuleInitFlag : u32
+    {
+        none = 0x00,
+        //! The module can be initialized on one worker thread concurrently with other modules once all 
+        //! its dependency modules are initialized.
+        //! @details Modules without this flag are always initialized on the thread that calls the 
+        //! initialization function. Set this flag only if @ref Module::on_init of this module does not access 
+        //! thread-affine states, like windows or thread-local objects created on the main thread.
+        concurrent = 0x01,
+        //! The module is initialized lazily.
+        //! @details @ref init_modules does not initialize lazy modules unless they are required by other modules being 
+        //! initialized. The user should call @ref init_module before the module is used for the first time.
+        lazy = 0x02,
+    };
+
     //! The module interface that should be implemented by the user.
     struct Module
     {
@@ -38,7 +54,12 @@ namespace Luna
         virtual RV on_register() { return ok; }
 
         //! Called when the module is initialized.
+        //! @remark If @ref get_init_flags returns @ref ModuleInitFlag::concurrent, this may be called from one worker thread.
         virtual RV on_init() { return ok; }
+
+        //! Gets the flags that control how this module is initialized.
+        //! @return Returns the initialization flags of this module.
+        virtual ModuleInitFlag get_init_flags() { return ModuleInitFlag::none; }
         
         //! Called when the module is closed.
         virtual void on_close() {}
@@ -128,6 +149,11 @@ namespace Luna
     LUNA_RUNTIME_API RV init_module(Module* handle);
 
     //! @brief Initializes all uninitialized modules.
+    //! @details Modules are initialized by their dependency order. Modules with @ref ModuleInitFlag::concurrent are 
+    //! initialized on worker threads concurrently with other modules whose dependencies are resolved, while other modules 
+    //! are initialized on the calling thread. The time spent on initializing every module is recorded in the log.
+    //! @remark Modules with @ref ModuleInitFlag::lazy are not initialized by this function unless they are dependencies 
+    //! of other modules being initialized.
     LUNA_RUNTIME_API RV init_modules();
     
     //! @}
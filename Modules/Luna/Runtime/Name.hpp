@@ -60,6 +60,14 @@ namespace Luna
     //! For end user, prefer using @ref Name objects instead of calling these APIs directly.
     LUNA_RUNTIME_API const c8* intern_name(const c8* name, usize count);
 
+    //! Interns the specified name string.
+    //! @param[in] name The name string view.
+    //! @return Returns the interned name string. See @ref intern_name for details.
+    inline const c8* intern_name(StringView name)
+    {
+        return intern_name(name.data(), name.size());
+    }
+
     //! Increases the reference count of the name string by 1.
     //! @param[in] name The pointer of the string. If this is `nullptr`, this call does nothing.
     //! @par Valid Usage
@@ -116,6 +124,10 @@ namespace Luna
         //! @param[in] count The number of characters in the string used to create the name.
         Name(const c8* name, usize count) :
             m_str(intern_name(name, count)) {}
+        //! Constructs one name from one string view.
+        //! @param[in] str The string view.
+        Name(StringView str) :
+            m_str(intern_name(str.data(), str.size())) {}
         //! Constructs one name from one string.
         //! @param[in] str The name string.
         Name(const String& str) :
@@ -119,6 +119,52 @@ namespace Luna
     //! * `object_ptr` must points to one memory returned by @ref object_alloc.
     LUNA_RUNTIME_API bool object_retain_if_not_expired(object_t object_ptr);
 
+    //! Sets whether the boxed object is thread-confined.
+    //! @details The reference counters of one thread-confined object are modified using non-atomic operations, which is much cheaper
+    //! than atomic operations, but requires all strong and weak references to the object to be created, copied and released from one
+    //! thread, which is called the owning thread of the object. The owning thread is set to the current thread when the object becomes
+    //! thread-confined. In debug build, modifying the reference counters of one thread-confined object from one thread other
+    //! than its owning thread triggers one assertion failure.
+    //! 
+    //! To pass one thread-confined object to another thread, call this function with `thread_confined` set to `false` on the owning thread
+    //! before passing the object, then optionally call this function with `thread_confined` set to `true` on the new thread.
+    //! @param[in] object_ptr The object pointer.
+    //! @param[in] thread_confined Whether the object is thread-confined.
+    //! @par Valid Usage
+    //! * `object_ptr` must points to one memory returned by @ref object_alloc.
+    //! * The reference counters of the object must not be modified by other threads when this function is called.
+    LUNA_RUNTIME_API void object_set_thread_confined(object_t object_ptr, bool thread_confined);
+
+    //! Checks whether the boxed object is thread-confined.
+    //! @param[in] object_ptr The object pointer.
+    //! @return Returns `true` if the boxed object is thread-confined, returns `false` otherwise.
+    //! @par Valid Usage
+    //! * `object_ptr` must points to one memory returned by @ref object_alloc.
+    LUNA_RUNTIME_API bool object_is_thread_confined(object_t object_ptr);
+
+    //! Checks whether the boxed object can be accessed from the current thread.
+    //! @details One object can be accessed from the current thread if the object is not thread-confined, or if the current thread
+    //! is the owning thread of the object. The owning thread is tracked only in debug build, this function always returns `true` in
+    //! other builds, so this function should only be used for debug checks.
+    //! @param[in] object_ptr The object pointer.
+    //! @return Returns `true` if the boxed object can be accessed from the current thread, returns `false` otherwise.
+    //! @par Valid Usage
+    //! * `object_ptr` must points to one memory returned by @ref object_alloc.
+    LUNA_RUNTIME_API bool object_is_accessible_from_current_thread(object_t object_ptr);
+
+    //! Sets whether boxed objects of the specified type are thread-confined when allocated.
+    //! @details If `thread_confined` is `true`, every boxed object of this type allocated by @ref object_alloc after this call
+    //! is thread-confined, and is owned by the thread that allocates the object. See @ref object_set_thread_confined for details.
+    //! Boxed objects allocated before this call are not affected.
+    //! @param[in] type The type to set.
+    //! @param[in] thread_confined Whether boxed objects of this type are thread-confined.
+    LUNA_RUNTIME_API void set_type_thread_confined(typeinfo_t type, bool thread_confined);
+
+    //! Checks whether boxed objects of the specified type are thread-confined when allocated.
+    //! @param[in] type The type to check.
+    //! @return Returns `true` if boxed objects of the specified type are thread-confined when allocated, returns `false` otherwise.
+    LUNA_RUNTIME_API bool is_type_thread_confined(typeinfo_t type);
+
     //! Gets the type object of the boxed object.
     //! @param[in] object_ptr The object pointer.
     //! @return Returns the type object of the boxed object.
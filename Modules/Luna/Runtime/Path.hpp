@@ -116,6 +116,165 @@ namespace Luna
             }
             return i;
         }
+
+        //! The array that stores name nodes of one path. The first `_N` nodes are stored in the array object directly.
+        //! @details Unlike @ref InlineVector, this array does not hold one pointer to its own inline storage, so it stays trivially 
+        //! relocatable like @ref Name, and types that contain paths can still be relocated by copying bytes.
+        template <usize _N>
+        class NodeArray
+        {
+            usize m_size;
+            usize m_capacity;
+            union
+            {
+                Name* m_heap_buffer;
+                alignas(Name) u8 m_inline_buffer[sizeof(Name) * _N];
+            };
+
+            bool is_inline() const { return m_capacity <= _N; }
+            void free_buffer()
+            {
+                if (!is_inline()) memfree(m_heap_buffer, alignof(Name));
+                m_capacity = _N;
+            }
+        public:
+            NodeArray() :
+                m_size(0),
+                m_capacity(_N) {}
+            NodeArray(const NodeArray& rhs) :
+                m_size(0),
+                m_capacity(_N)
+            {
+                *this = rhs;
+            }
+            NodeArray(NodeArray&& rhs) :
+                m_size(0),
+                m_capacity(_N)
+            {
+                *this = move(rhs);
+            }
+            ~NodeArray()
+            {
+                clear();
+                free_buffer();
+            }
+            NodeArray& operator=(const NodeArray& rhs)
+            {
+                if (this == &rhs) return *this;
+                clear();
+                reserve(rhs.m_size);
+                Name* dst = data();
+                const Name* src = rhs.data();
+                for (usize i = 0; i < rhs.m_size; ++i)
+                {
+                    new (dst + i) Name(src[i]);
+                }
+                m_size = rhs.m_size;
+                return *this;
+            }
+            NodeArray& operator=(NodeArray&& rhs)
+            {
+                if (this == &rhs) return *this;
+                clear();
+                free_buffer();
+                if (rhs.is_inline())
+                {
+                    // Names are trivially relocatable, so nodes can be moved by copying bytes.
+                    memcpy(m_inline_buffer, rhs.m_inline_buffer, sizeof(Name) * rhs.m_size);
+                }
+                else
+                {
+                    m_heap_buffer = rhs.m_heap_buffer;
+                    m_capacity = rhs.m_capacity;
+                    rhs.m_capacity = _N;
+                }
+                m_size = rhs.m_size;
+                rhs.m_size = 0;
+                return *this;
+            }
+            Name* data() { return is_inline() ? (Name*)m_inline_buffer : m_heap_buffer; }
+            const Name* data() const { return is_inline() ? (const Name*)m_inline_buffer : m_heap_buffer; }
+            usize size() const { return m_size; }
+            bool empty() const { return m_size == 0; }
+            void reserve(usize new_cap)
+            {
+                if (new_cap <= m_capacity) return;
+                new_cap = max(new_cap, m_capacity * 2);
+                Name* new_buffer = (Name*)memalloc(sizeof(Name) * new_cap, alignof(Name));
+                memcpy((void*)new_buffer, (const void*)data(), sizeof(Name) * m_size);
+                free_buffer();
+                m_heap_buffer = new_buffer;
+                m_capacity = new_cap;
+            }
+            Name& operator[](usize index) { luassert(index < m_size); return data()[index]; }
+            const Name& operator[](usize index) const { luassert(index < m_size); return data()[index]; }
+            Name& front() { return (*this)[0]; }
+            const Name& front() const { return (*this)[0]; }
+            Name& back() { return (*this)[m_size - 1]; }
+            const Name& back() const { return (*this)[m_size - 1]; }
+            Name* begin() { return data(); }
+            const Name* begin() const { return data(); }
+            const Name* cbegin() const { return data(); }
+            Name* end() { return data() + m_size; }
+            const Name* end() const { return data() + m_size; }
+            const Name* cend() const { return data() + m_size; }
+            ReverseIterator<Name*> rbegin() { return ReverseIterator<Name*>(end()); }
+            ReverseIterator<const Name*> rbegin() const { return ReverseIterator<const Name*>(end()); }
+            ReverseIterator<const Name*> crbegin() const { return ReverseIterator<const Name*>(end()); }
+            ReverseIterator<Name*> rend() { return ReverseIterator<Name*>(begin()); }
+            ReverseIterator<const Name*> rend() const { return ReverseIterator<const Name*>(begin()); }
+            ReverseIterator<const Name*> crend() const { return ReverseIterator<const Name*>(begin()); }
+            void push_back(const Name& value)
+            {
+                // `value` may refer to one node of this array, so copy it before the buffer is reallocated.
+                Name tmp(value);
+                push_back(move(tmp));
+            }
+            void push_back(Name&& value)
+            {
+                reserve(m_size + 1);
+                new (data() + m_size) Name(move(value));
+                ++m_size;
+            }
+            void pop_back()
+            {
+                luassert(m_size);
+                --m_size;
+                data()[m_size].~Name();
+            }
+            void clear()
+            {
+                Name* d = data();
+                for (usize i = 0; i < m_size; ++i) d[i].~Name();
+                m_size = 0;
+            }
+            Name* erase(const Name* pos)
+            {
+                return erase(pos, pos + 1);
+            }
+            Name* erase(const Name* first, const Name* last)
+            {
+                Name* d = data();
+                Name* dst = d + (first - d);
+                Name* src = d + (last - d);
+                Name* e = d + m_size;
+                usize num_erased = (usize)(last - first);
+                Name* ret = dst;
+                while (src != e)
+                {
+                    *dst = move(*src);
+                    ++dst;
+                    ++src;
+                }
+                while (dst != e)
+                {
+                    dst->~Name();
+                    ++dst;
+                }
+                m_size -= num_erased;
+                return ret;
+            }
+        };
     }
 
     //! A container that contains a sequence of names that describe one path.
@@ -140,9 +299,17 @@ namespace Luna
     //! a directory but does not ends with a separator, the `EPathFlag::directory` will not be set for that path. The path object will
     //! not use runtime system calls like `file_attribute` to determine if one path is valid or represents a directory, it is the user's
     //! responsibility to check it before using it.
+    //! 
+    //! Name nodes are stored in one small buffer in the path object, so paths with no more than @ref NUM_INLINE_NODES nodes can be constructed, copied 
+    //! and concatenated without allocating memory. Copying one path only increases reference counts of its names, and comparing 
+    //! two paths compares name pointers instead of strings.
     class Path
     {
-        Vector<Name> m_nodes;
+    public:
+        //! The number of name nodes that can be stored in the path object without allocating memory.
+        static constexpr usize NUM_INLINE_NODES = 6;
+    private:
+        PathImpl::NodeArray<NUM_INLINE_NODES> m_nodes;
         Name m_root;
         PathFlag m_flags;
 
@@ -553,7 +720,7 @@ namespace Luna
         {
             auto& name = m_nodes.back();
             const c8* str = name.c_str();
-            usize sz = strlen(str);
+            usize sz = name.size();
             usize i = sz - 1;    // points to the last valid char.
             // Finds the length of the extension.
             while (i)
@@ -594,7 +761,7 @@ namespace Luna
                     buf[filename_len + 1 + i] = (c8)tolower(buf[filename_len + 1 + i]);
                 }
             }
-            name = Name(buf);;
+            name = Name(buf, new_filename_len);
         }
         //! Appends the extension.
         //! @details The system adds one extension separator (".") between extension and filename automatically.
@@ -613,7 +780,7 @@ namespace Luna
         {
             auto& name = m_nodes.back();
             const c8* str = name.c_str();
-            usize sz = strlen(str);
+            usize sz = name.size();
             c8* buf = (c8*)alloca(sizeof(c8) * (sz + count + 2));
             // copy original namec8
             memcpy(buf, str, sz * sizeof(c8));
@@ -622,7 +789,7 @@ namespace Luna
             memcpy(buf + sz + 1, new_extension, count * sizeof(c8));
             // ends with NULL.
             buf[sz + count + 1] = 0;
-            name = Name(buf);
+            name = Name(buf, sz + count + 1);
         }
         //! Removes the extension.
         //! @details The extension separator (".") is removed as well in this operation.
@@ -872,13 +1039,13 @@ namespace Luna
             if (m_root)
             {
                 id = m_root.id();
-                h = memhash<usize>(&id, sizeof(u64), h);
-                h = strhash<usize>("://", h);// To deferent "A://B" from "/A/B"
+                h = (usize)wyhash(&id, sizeof(u64), h);
+                h = (usize)wyhash("://", 3, h);// To deferent "A://B" from "/A/B"
             }
             for (auto& i : m_nodes)
             {
                 id = i.id();
-                h = memhash<usize>(&id, sizeof(u64), h);
+                h = (usize)wyhash(&id, sizeof(u64), h);
             }
             return h;
         }
@@ -0,0 +1,94 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PerfCounter.hpp
+* @author JXMaster
+* @date 2024/5/20
+*/
+#pragma once
+#include "Base.hpp"
+
+#ifndef LUNA_RUNTIME_API
+#define LUNA_RUNTIME_API
+#endif
+
+namespace Luna
+{
+    //! @addtogroup RuntimeProfiler
+    //! @{
+
+    //! Specifies how values of one performance counter are interpreted.
+    enum class PerfCounterType : u8
+    {
+        //! The counter accumulates the number of times one event happens, like the number of bytes read.
+        //! The value only increases, and tools usually display the increase rate of the value per second.
+        counter = 0,
+        //! The counter records the current level of one quantity, like the number of jobs in queues.
+        //! Tools usually display the value directly.
+        gauge = 1,
+    };
+
+    //! The handle of one performance counter.
+    //! @details The handle is `0` if the counter is not registered. Updating counters with one null handle does nothing,
+    //! so handles can be stored in global variables that are initialized to `0` when the system starts.
+    using perf_counter_t = u32;
+
+    //! The maximum number of performance counters that can be registered.
+    constexpr u32 MAX_PERF_COUNTERS = 256;
+
+    //! Describes one registered performance counter.
+    struct PerfCounterDesc
+    {
+        //! The name of the counter, like `JobSystem.QueuedJobs`. By convention, the part before the first `.`
+        //! is the name of the module that publishes the counter.
+        const c8* name;
+        //! The unit of the counter value, like `bytes`. This may be `nullptr` if the value is one plain number.
+        const c8* unit;
+        //! The counter type.
+        PerfCounterType type;
+    };
+
+    //! Registers one performance counter.
+    //! @param[in] name The name of the counter.
+    //! @param[in] type The type of the counter.
+    //! @param[in] unit The unit of the counter value. May be `nullptr`.
+    //! @return Returns the handle of the counter. If one counter with the same name is already registered, returns
+    //! the handle of the existing counter. Returns `0` if @ref MAX_PERF_COUNTERS counters are already registered.
+    //! @remark Strings passed to this function are copied, and counters are never unregistered until @ref Luna::close
+    //! is called, so that handles can be cached in global variables.
+    LUNA_RUNTIME_API perf_counter_t register_perf_counter(const c8* name, PerfCounterType type, const c8* unit = nullptr);
+
+    //! Adds one value to the performance counter.
+    //! @details The value is added to the thread-local storage of the calling thread without any atomic operation or
+    //! lock, so this function can be called in hot paths. @ref get_perf_counter_value sums values of all threads.
+    //! Gauges may also be updated by this function, by adding `1` when one item is added and `-1` when one item is
+    //! removed on any thread.
+    //! @param[in] counter The counter handle.
+    //! @param[in] delta The value to add.
+    LUNA_RUNTIME_API void perf_counter_add(perf_counter_t counter, i64 delta);
+
+    //! Sets the value of one gauge.
+    //! @param[in] counter The counter handle.
+    //! @param[in] value The value to set.
+    //! @remark The gauge should be updated by either this function or @ref perf_counter_add, but not both, since
+    //! this function does not reset values added by @ref perf_counter_add.
+    LUNA_RUNTIME_API void perf_counter_set(perf_counter_t counter, i64 value);
+
+    //! Gets the current value of one performance counter.
+    //! @details This function sums values of all threads, including threads that have exited. Values added by other
+    //! threads are not synchronized, so values added recently may not be visible to this function.
+    LUNA_RUNTIME_API i64 get_perf_counter_value(perf_counter_t counter);
+
+    //! Gets the number of registered performance counters. Counters are enumerated by handles from `1` to the returned
+    //! number, in the order they are registered.
+    LUNA_RUNTIME_API u32 get_num_perf_counters();
+
+    //! Gets the description of one performance counter.
+    //! @param[in] counter The counter handle.
+    //! @return Returns the description. Strings of the description are valid until @ref Luna::close is called.
+    LUNA_RUNTIME_API PerfCounterDesc get_perf_counter_desc(perf_counter_t counter);
+
+    //! @}
+}
@@ -0,0 +1,143 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Pool.hpp
+* @author JXMaster
+* @date 2024/3/10
+*/
+#pragma once
+#include "Assert.hpp"
+#include "Memory.hpp"
+#include "MemoryUtils.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeMemory
+    //! @{
+
+    //! One memory pool that allocates fixed-size memory blocks for one type from one free list.
+    //! @details Memory blocks are allocated from chunks, chunks are freed only when the pool is destructed.
+    //! The pool is not thread-safe.
+    //! @tparam _Ty The type of the object to allocate. Every memory block is large enough to hold one instance of this type.
+    template <typename _Ty>
+    class Pool
+    {
+    public:
+        //! Constructs one pool.
+        //! @param[in] blocks_per_chunk The number of memory blocks to allocate when the free list is empty.
+        Pool(usize blocks_per_chunk = 64) :
+            m_free_list(nullptr),
+            m_chunks(nullptr),
+            m_blocks_per_chunk(blocks_per_chunk ? blocks_per_chunk : 1) {}
+        Pool(const Pool&) = delete;
+        Pool& operator=(const Pool&) = delete;
+        ~Pool()
+        {
+            Chunk* chunk = m_chunks;
+            while (chunk)
+            {
+                Chunk* next = chunk->m_next;
+                memfree(chunk, CHUNK_ALIGNMENT);
+                chunk = next;
+            }
+        }
+        //! Allocates one memory block from the pool.
+        //! @return Returns the allocated memory block, which is uninitialized. Returns `nullptr` if failed to allocate memory.
+        _Ty* allocate()
+        {
+            if (!m_free_list)
+            {
+                Chunk* chunk = (Chunk*)memalloc(CHUNK_HEADER_SIZE + sizeof(Block) * m_blocks_per_chunk, CHUNK_ALIGNMENT);
+                if (!chunk) return nullptr;
+                chunk->m_next = m_chunks;
+                m_chunks = chunk;
+                Block* blocks = (Block*)((usize)chunk + CHUNK_HEADER_SIZE);
+                for (usize i = m_blocks_per_chunk; i > 0; --i)
+                {
+                    blocks[i - 1].m_next = m_free_list;
+                    m_free_list = blocks + i - 1;
+                }
+            }
+            Block* block = m_free_list;
+            m_free_list = block->m_next;
+            return (_Ty*)block;
+        }
+        //! Frees one memory block allocated from this pool.
+        //! @param[in] ptr The memory block returned by @ref allocate. If this is `nullptr`, this function does nothing.
+        void deallocate(_Ty* ptr)
+        {
+            if (!ptr) return;
+            Block* block = (Block*)ptr;
+            block->m_next = m_free_list;
+            m_free_list = block;
+        }
+    private:
+        union Block
+        {
+            Block* m_next;
+            alignas(_Ty) u8 m_data[sizeof(_Ty)];
+        };
+        struct Chunk
+        {
+            Chunk* m_next;
+        };
+        static constexpr usize CHUNK_ALIGNMENT = alignof(Block) > alignof(Chunk) ? alignof(Block) : alignof(Chunk);
+        static constexpr usize CHUNK_HEADER_SIZE = align_upper(sizeof(Chunk), alignof(Block));
+
+        Block* m_free_list;
+        Chunk* m_chunks;
+        usize m_blocks_per_chunk;
+    };
+
+    //! The allocator that allocates memory from one @ref Pool. This can be used for containers defined in Runtime module.
+    //! @details Allocations that fit in one memory block of the pool (like nodes of node-based containers) are allocated from the pool,
+    //! other allocations fall back to @ref memalloc. The pool must be valid when any container that uses this allocator is alive.
+    //!
+    //! If the allocator is default-constructed, all allocations fall back to @ref memalloc.
+    //! @tparam _Ty The type of the pool object.
+    template <typename _Ty>
+    class PoolAllocator
+    {
+    public:
+        PoolAllocator() :
+            m_pool(nullptr) {}
+        PoolAllocator(Pool<_Ty>& pool) :
+            m_pool(&pool) {}
+        template <typename _U>
+        _U* allocate(usize n = 1)
+        {
+            if (fits_in_pool<_U>(n)) return (_U*)m_pool->allocate();
+            return (_U*)memalloc(sizeof(_U) * n, alignof(_U));
+        }
+        template <typename _U>
+        void deallocate(_U* ptr, usize n = 1)
+        {
+            if (fits_in_pool<_U>(n)) m_pool->deallocate((_Ty*)ptr);
+            else memfree(ptr, alignof(_U));
+        }
+        //! Gets the pool bound to this allocator.
+        Pool<_Ty>* get_pool() const
+        {
+            return m_pool;
+        }
+        bool operator==(const PoolAllocator& rhs) const
+        {
+            return m_pool == rhs.m_pool;
+        }
+        bool operator!=(const PoolAllocator& rhs) const
+        {
+            return m_pool != rhs.m_pool;
+        }
+    private:
+        template <typename _U>
+        bool fits_in_pool(usize n) const
+        {
+            return m_pool && sizeof(_U) * n <= sizeof(_Ty) && alignof(_U) <= alignof(_Ty);
+        }
+        Pool<_Ty>* m_pool;
+    };
+
+    //! @}
+}
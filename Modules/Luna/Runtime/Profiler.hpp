@@ -10,6 +10,8 @@
 #pragma once
 #include "Functional.hpp"
 #include "Name.hpp"
+#include "Result.hpp"
+#include "Span.hpp"
 
 #ifndef LUNA_RUNTIME_API
 #define LUNA_RUNTIME_API
@@ -19,6 +21,10 @@
 #define LUNA_MEMORY_PROFILER_ENABLED
 #endif
 
+#if (defined(LUNA_ENABLE_CPU_PROFILER) || (LUNA_DEBUG_LEVEL >= LUNA_DEBUG_LEVEL_PROFILE))
+#define LUNA_CPU_PROFILER_ENABLED
+#endif
+
 namespace Luna
 {
     struct IThread;
@@ -88,6 +94,42 @@ namespace Luna
     //! to unregister. 
     LUNA_RUNTIME_API void unregister_profiler_callback(usize handler_id);
 
+    using on_profiler_event_batch_t = void(Span<const ProfilerEvent> events);
+
+    //! Registers one profiler callback function that receives events in batches.
+    //! @details In immediate mode, every event is dispatched to batch callbacks as one span with one event when it is submitted.
+    //! In batch mode, events are dispatched to batch callbacks by @ref flush_profiler_events as spans of events submitted by the same thread.
+    //! @param[in] handler The callback function object to register.
+    //! @return Returns one handle that can be used to unregister the callback function.
+    LUNA_RUNTIME_API usize register_profiler_batch_callback(const Function<on_profiler_event_batch_t>& handler);
+    //! Unregisters one profiler callback function registered by @ref register_profiler_batch_callback.
+    //! @param[in] handler_id The handler that returned by @ref register_profiler_batch_callback for the callback function 
+    //! to unregister. 
+    LUNA_RUNTIME_API void unregister_profiler_batch_callback(usize handler_id);
+
+    //! Enables or disables the batch mode of the profiler.
+    //! @details By default, the profiler works in immediate mode, where every event is dispatched to all callbacks on the submitting thread
+    //! when @ref submit_profiler_event is called, which requires locking the callback list for every event. In batch mode, events are appended
+    //! to one event buffer of the submitting thread without any lock, and are dispatched only when @ref flush_profiler_events is called, 
+    //! which should be called periodically or at the end of every frame. Events that are not flushed are kept in memory, so the memory usage 
+    //! grows if events are never flushed.
+    //! 
+    //! When batch mode is disabled, all pending events are flushed by this function.
+    //! @param[in] enabled `true` to enable batch mode, `false` to disable batch mode.
+    LUNA_RUNTIME_API void set_profiler_batch_mode(bool enabled);
+
+    //! Checks whether the batch mode of the profiler is enabled.
+    LUNA_RUNTIME_API bool is_profiler_batch_mode();
+
+    //! Dispatches all events buffered in batch mode to profiler callbacks on the current thread.
+    //! @details Events submitted by one thread are always dispatched in submission order, but events of different threads
+    //! are not ordered. Callbacks registered by @ref register_profiler_callback are called for every event, and callbacks registered by 
+    //! @ref register_profiler_batch_callback are called for every span of events. @ref ProfilerEvent::thread of one event may refer to one thread
+    //! that has exited when the event is dispatched, so it should only be used for identifying threads.
+    //! 
+    //! This function can be called from any thread, calls from multiple threads are serialized.
+    LUNA_RUNTIME_API void flush_profiler_events();
+
     namespace ProfilerEventId
     {
         //! The memory allocation event ID.
@@ -100,6 +142,10 @@ namespace Luna
         constexpr u64 SET_MEMORY_TYPE = strhash64("SET_MEMORY_TYPE");
         //! The set memory domain event ID.
         constexpr u64 SET_MEMORY_DOMAIN = strhash64("SET_MEMORY_DOMAIN");
+        //! The CPU zone begin event ID.
+        constexpr u64 CPU_ZONE_BEGIN = strhash64("CPU_ZONE_BEGIN");
+        //! The CPU zone end event ID. This event does not have event data.
+        constexpr u64 CPU_ZONE_END = strhash64("CPU_ZONE_END");
     }
     namespace ProfilerEventData
     {
@@ -110,6 +156,17 @@ namespace Luna
             void* ptr;
             //! The size of the memory.
             usize size;
+            //! The number of bytes this memory block represents in profiler statistics.
+            //! @details If sampling is disabled, this is always equal to `size`. If sampling is enabled, only sampled memory blocks 
+            //! emit allocation events, and this is the estimated total size of all allocations this sample stands for, so that summing 
+            //! this value of all alive memory blocks gives an unbiased estimation of the memory usage. See @ref memory_profiler_set_sampling
+            //! for details.
+            usize sampled_size;
+            //! The number of call stack frames in `frames`. This is `0` if stack capture is disabled.
+            u32 num_frames;
+            //! The call stack frames captured when the memory is allocated, which can be resolved by @ref stack_backtrace_symbols.
+            //! The frame buffer is allocated along with this structure, and is valid so long as this structure is valid.
+            const opaque_t* frames;
         };
         //!  @brief The memory deallocation event data.
         struct MemoryDeallocate
@@ -152,6 +209,12 @@ namespace Luna
             //! so long as this structure is valid.
             const c8 domain[1];
         };
+        //! The CPU zone begin event data.
+        struct CpuZoneBegin
+        {
+            //! The name of the zone.
+            const c8* name;
+        };
     }
 
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
@@ -161,6 +224,9 @@ namespace Luna
     //! @param[in] size The size of the memory block, in bytes.
     //! @remark Memory allocations through `memalloc` call this internally when memory profiling is enabled, thus the user does not
     //! need to call this again.
+    //! 
+    //! If sampling is enabled by @ref memory_profiler_set_sampling, the memory block is recorded and the event is emitted only if 
+    //! the memory block is sampled.
     LUNA_RUNTIME_API void memory_profiler_allocate(void* ptr, usize size);
 
     //! Emits one @ref PROFILER_EVENT_ID_MEMORY_DEALLOCATE profiler event.
@@ -192,7 +258,124 @@ namespace Luna
     //! @param[in] str_size The size of the name, not including the null terminator. If this is `USIZE_MAX`, the size is determined by the system
     //! using @ref strlen.
     LUNA_RUNTIME_API void memory_profiler_set_memory_domain(void* ptr, const c8* domain, usize str_size = USIZE_MAX);
+
+    //! Sets the sampling mode of the memory profiler.
+    //! @details By default, the memory profiler records every memory allocation, which is precise but slow. If `sample_interval` 
+    //! is not `0`, the memory profiler samples allocations so that one in every `sample_interval` allocated bytes on average is 
+    //! recorded. The distance between two samples follows one exponential distribution, so allocations are sampled with probability 
+    //! proportional to their sizes and no allocation pattern can bias the result. Only sampled memory blocks emit 
+    //! @ref ProfilerEventId::MEMORY_ALLOCATE, @ref ProfilerEventId::MEMORY_DEALLOCATE, @ref ProfilerEventId::SET_MEMORY_NAME, 
+    //! @ref ProfilerEventId::SET_MEMORY_TYPE and @ref ProfilerEventId::SET_MEMORY_DOMAIN events, and 
+    //! @ref ProfilerEventData::MemoryAllocate::sampled_size of every sampled block tells the estimated number of bytes it stands for.
+    //! 
+    //! Memory blocks that are recorded before sampling settings are changed still emit deallocation events when they are freed.
+    //! @param[in] sample_interval The average number of bytes between two sampled allocations. Specify `0` to record every allocation.
+    //! @param[in] num_stack_frames The maximum number of call stack frames to capture for every recorded allocation. Specify `0` to 
+    //! disable stack capture.
+    LUNA_RUNTIME_API void memory_profiler_set_sampling(usize sample_interval, u32 num_stack_frames = 0);
+
+    //! Gets the sampling interval set by @ref memory_profiler_set_sampling.
+    //! @return Returns the average number of bytes between two sampled allocations, or `0` if every allocation is recorded.
+    LUNA_RUNTIME_API usize memory_profiler_get_sample_interval();
+
+    //! Aggregate memory counters maintained by the memory profiler.
+    //! @details All values are computed from recorded memory blocks, weighted by @ref ProfilerEventData::MemoryAllocate::sampled_size,
+    //! so they are exact if sampling is disabled, and are unbiased estimations if sampling is enabled.
+    struct MemoryProfilerCounters
+    {
+        //! The number of memory blocks allocated.
+        u64 num_allocations = 0;
+        //! The number of memory blocks deallocated.
+        u64 num_deallocations = 0;
+        //! The number of bytes allocated.
+        u64 allocated_bytes = 0;
+        //! The number of bytes deallocated.
+        u64 deallocated_bytes = 0;
+    };
+
+    //! Gets aggregate counters of all memory blocks recorded by the memory profiler.
+    //! @details Counters are kept in thread-local storage of every thread that allocates or frees memory, so maintaining them does not 
+    //! need any atomic operation. This function sums counters of all threads, including threads that have exited.
+    //! @return Returns the aggregate counters.
+    LUNA_RUNTIME_API MemoryProfilerCounters memory_profiler_get_counters();
+
+    //! Gets aggregate counters of memory blocks of the specified domain.
+    //! @details Memory blocks are counted to one domain when @ref memory_profiler_set_memory_domain is called for them.
+    //! Counters of one thread can track at most 256 distinct domains and types, blocks of more domains and types are 
+    //! not counted.
+    //! @param[in] domain The domain name.
+    //! @param[in] str_size The size of the name, not including the null terminator. If this is `USIZE_MAX`, the size is determined by the system
+    //! using @ref strlen.
+    //! @return Returns the aggregate counters.
+    LUNA_RUNTIME_API MemoryProfilerCounters memory_profiler_get_domain_counters(const c8* domain, usize str_size = USIZE_MAX);
+
+    //! Gets aggregate counters of memory blocks of the specified type.
+    //! @details Memory blocks are counted to one type when @ref memory_profiler_set_memory_type is called for them.
+    //! See remarks of @ref memory_profiler_get_domain_counters for details.
+    //! @param[in] type The type name.
+    //! @param[in] str_size The size of the name, not including the null terminator. If this is `USIZE_MAX`, the size is determined by the system
+    //! using @ref strlen.
+    //! @return Returns the aggregate counters.
+    LUNA_RUNTIME_API MemoryProfilerCounters memory_profiler_get_type_counters(const c8* type, usize str_size = USIZE_MAX);
+#endif
+
+    //! Begins one CPU timing zone on the current thread.
+    //! @details This function emits one @ref ProfilerEventId::CPU_ZONE_BEGIN profiler event, and records the begin time of the zone
+    //! if one trace capture is started by @ref begin_profiler_trace_capture. Zones of one thread must be nested, every call to this function
+    //! must be paired with one call to @ref profiler_zone_end on the same thread.
+    //! 
+    //! The user usually uses @ref LUNA_PROFILE_ZONE instead of calling this function directly.
+    //! @param[in] name The name of the zone. The string is referred by pointer and is not copied, so it must be valid until the
+    //! current trace capture is ended, like one string literal or the string of one @ref Name that is alive.
+    LUNA_RUNTIME_API void profiler_zone_begin(const c8* name);
+
+    //! Ends the last CPU timing zone begun by @ref profiler_zone_begin on the current thread.
+    //! @details This function emits one @ref ProfilerEventId::CPU_ZONE_END profiler event.
+    LUNA_RUNTIME_API void profiler_zone_end();
+
+    //! Begins one CPU timing zone when constructed, and ends the zone when destructed.
+    struct ProfilerZone
+    {
+        ProfilerZone(const c8* name)
+        {
+            profiler_zone_begin(name);
+        }
+        ~ProfilerZone()
+        {
+            profiler_zone_end();
+        }
+        ProfilerZone(const ProfilerZone&) = delete;
+        ProfilerZone& operator=(const ProfilerZone&) = delete;
+    };
+
+#define LUNA_PROFILE_ZONE_CONCAT_IMPL(a, b) a##b
+#define LUNA_PROFILE_ZONE_CONCAT(a, b) LUNA_PROFILE_ZONE_CONCAT_IMPL(a, b)
+
+#ifdef LUNA_CPU_PROFILER_ENABLED
+    //! Records one CPU timing zone that lasts until the end of the current scope.
+    //! @details This macro expands to nothing if @ref LUNA_CPU_PROFILER_ENABLED is not defined.
+    //! @param[in] name The name of the zone. See @ref profiler_zone_begin for details.
+#define LUNA_PROFILE_ZONE(name) ::Luna::ProfilerZone LUNA_PROFILE_ZONE_CONCAT(_luna_profile_zone_, __LINE__)(name)
+#else
+#define LUNA_PROFILE_ZONE(name)
 #endif
 
+    //! Starts one trace capture.
+    //! @details When one trace capture is started, begin and end times of all CPU zones of all threads are recorded, until
+    //! @ref end_profiler_trace_capture is called. Records of the last capture are discarded.
+    //! Calling this function when one capture is already started restarts the capture.
+    LUNA_RUNTIME_API void begin_profiler_trace_capture();
+
+    //! Checks whether one trace capture is started.
+    LUNA_RUNTIME_API bool is_profiler_trace_capturing();
+
+    //! Ends the current trace capture and writes all records to one file.
+    //! @details The file is written in the Chrome trace event JSON format, which can be opened by `chrome://tracing` and the 
+    //! Perfetto UI (https://ui.perfetto.dev), so zones of all threads can be inspected on one timeline. Zones that are not ended when
+    //! the capture is ended are closed at the end time of the capture.
+    //! @param[in] path The path of the file to write. The file will be created or overwritten.
+    //! If this is `nullptr`, the capture is ended and all records are discarded.
+    LUNA_RUNTIME_API RV end_profiler_trace_capture(const c8* path);
+
     //! @}
 }
\ No newline at end of file
@@ -10,6 +10,7 @@
 #pragma once
 #include "Interface.hpp"
 #include "Ref.hpp"
+#include "Span.hpp"
 namespace Luna
 {
     //! @addtogroup Runtime
@@ -54,13 +55,34 @@ namespace Luna
         //! Generates one random GUID (Globally Unique Identifier).
         //! @return Returns the generated GUID.
         virtual Guid gen_guid() = 0;
+        //! Fills the specified buffer with random 32-bit unsigned integers.
+        //! @details This is faster than calling @ref gen_u32 for every element, since the generator is called
+        //! without virtual dispatch.
+        //! @param[out] dst The buffer to fill.
+        virtual void gen_u32s(Span<u32> dst) = 0;
+        //! Fills the specified buffer with random 32-bit floating-point numbers.
+        //! @param[out] dst The buffer to fill.
+        //! @param[in] range_begin The minimum number that will be generated.
+        //! @param[in] range_end The maximum number that will be generated.
+        virtual void gen_f32s(Span<f32> dst, f32 range_begin, f32 range_end) = 0;
     };
 
     //! Creates one new random number generator.
+    //! @details The generator uses the Mersenne Twister engine (`std::mt19937`), which generates the same sequence 
+    //! as `std::mt19937` for the same seed.
     //! @param[in] initial_seed The initial seed for the generator.
     //! @return Returns the created random number generator.
     LUNA_RUNTIME_API Ref<IRandom> new_random_number_generator(u32 initial_seed);
+    //! Creates one new fast random number generator.
+    //! @details The generator uses the xoshiro256** algorithm, which has only 32 bytes of state and is several times 
+    //! faster than the generator created by @ref new_random_number_generator. Use this for generating large amount
+    //! of numbers, like noise textures and sample patterns.
+    //! @param[in] initial_seed The initial seed for the generator.
+    //! @return Returns the created random number generator.
+    LUNA_RUNTIME_API Ref<IRandom> new_fast_random_number_generator(u32 initial_seed);
     //! Generates one random 32-bit unsigned integer.
+    //! @details All global random functions use one generator per thread, so they can be called from multiple threads 
+    //! without contention. The generator of every thread is seeded differently when it is first used by the thread.
     //! @return Returns the generated number.
     LUNA_RUNTIME_API u32 random_u32();
     //! Generates one random 32-bit signed integer.
@@ -119,13 +119,10 @@ namespace Luna
 
         _Ty* m_vtable;
 
-        static void* internal_query_interface(object_t obj, const Guid& guid)
+        template <typename _Rty>
+        static void* internal_query_interface(object_t obj)
         {
-            if (object_is_type(obj, get_type_by_guid(guid)))
-            {
-                return obj;
-            }
-            return query_interface(obj, guid);
+            return cast_object_or_query_interface(obj, get_interface_id<_Rty>());
         }
 
         template <bool _HasGetObject>
@@ -195,7 +192,7 @@ namespace Luna
             internal_clear();
             if (ptr)
             {
-                m_vtable = (_Ty*)internal_query_interface(ptr, _Ty::__guid);
+                m_vtable = (_Ty*)internal_query_interface<_Ty>(ptr);
                 if (!m_vtable) object_release(ptr);
             }
         }
@@ -236,7 +233,7 @@ namespace Luna
         Ref(const Ref<_Rty>& rhs)
         {
             object_t obj = rhs.object();
-            m_vtable = obj ? (_Ty*)internal_query_interface(obj, _Ty::__guid) : nullptr;
+            m_vtable = obj ? (_Ty*)internal_query_interface<_Ty>(obj) : nullptr;
             internal_addref();
         }
         //! Assigns this reference by coping the pointer from another reference of one different type.
@@ -251,7 +248,7 @@ namespace Luna
         {
             internal_clear();
             object_t obj = rhs.object();
-            m_vtable = obj ? (_Ty*)internal_query_interface(obj, _Ty::__guid) : nullptr;
+            m_vtable = obj ? (_Ty*)internal_query_interface<_Ty>(obj) : nullptr;
             internal_addref();
             return *this;
         }
@@ -265,7 +262,7 @@ namespace Luna
         Ref(Ref<_Rty>&& rhs)
         {
             object_t obj = rhs.detach();
-            m_vtable = obj ? (_Ty*)internal_query_interface(obj, _Ty::__guid) : nullptr;
+            m_vtable = obj ? (_Ty*)internal_query_interface<_Ty>(obj) : nullptr;
             if (obj && !m_vtable) object_release(obj);
         }
         //! Assigns this reference by moving the pointer from another reference of one different type.
@@ -281,7 +278,7 @@ namespace Luna
         {
             internal_clear();
             object_t obj = rhs.detach();
-            m_vtable = obj ? (_Ty*)internal_query_interface(obj, _Ty::__guid) : nullptr;
+            m_vtable = obj ? (_Ty*)internal_query_interface<_Ty>(obj) : nullptr;
             if (obj && !m_vtable) object_release(obj);
             return *this;
         }
@@ -325,7 +322,7 @@ namespace Luna
         {
             if (rhs)
             {
-                m_vtable = (_Ty*)internal_query_interface(rhs.get(), _Ty::__guid);
+                m_vtable = (_Ty*)internal_query_interface<_Ty>(rhs.get());
                 internal_addref();
             }
             else
@@ -344,7 +341,7 @@ namespace Luna
             object_t ptr = rhs.detach();
             if (ptr)
             {
-                m_vtable = (_Ty*)internal_query_interface(ptr, _Ty::__guid);
+                m_vtable = (_Ty*)internal_query_interface<_Ty>(ptr);
                 if (!m_vtable) object_release(ptr);
             }
             else
@@ -364,7 +361,7 @@ namespace Luna
             internal_clear();
             if (rhs)
             {
-                m_vtable = (_Ty*)internal_query_interface(rhs.get(), _Ty::__guid);
+                m_vtable = (_Ty*)internal_query_interface<_Ty>(rhs.get());
                 internal_addref();
             }
             return *this;
@@ -383,7 +380,7 @@ namespace Luna
             object_t ptr = rhs.detach();
             if (ptr)
             {
-                m_vtable = (_Ty*)internal_query_interface(ptr, _Ty::__guid);
+                m_vtable = (_Ty*)internal_query_interface<_Ty>(ptr);
                 if (!m_vtable) object_release(ptr);
             }
             return *this;
@@ -427,7 +424,7 @@ namespace Luna
         {
             auto obj = object();
             if (!obj) return nullptr;
-            return (_Rty*)internal_query_interface(obj, _Rty::__guid);
+            return (_Rty*)internal_query_interface<_Rty>(obj);
         }
     };
 
@@ -669,12 +666,12 @@ namespace Luna
         //! Constructs one weak reference from one strong reference of the same type.
         //! @details The weak reference counter of the new boxed object, if not null, will be increased.
         //! @param[in] rhs The reference to set.
-        WeakRef(const Ref<_Ty>& rhs) : m_vtable(rhs.vtable()) { internal_addref(); }
+        WeakRef(const Ref<_Ty>& rhs) : m_vtable((_Ty*)rhs) { internal_addref(); }
         //! Assigns this reference by coping the pointer from one strong reference of the same type.
         //! @details The weak reference counter of the new boxed object, if not null, will be increased.
         //! The weak reference counter of the original boxed object, if not null, will be decreased before assignment.
         //! @param[in] rhs The reference to set.
-        WeakRef& operator=(const Ref<_Ty>& rhs) { internal_clear(); m_vtable = rhs.get(); internal_addref(); return *this; }
+        WeakRef& operator=(const Ref<_Ty>& rhs) { internal_clear(); m_vtable = (_Ty*)rhs; internal_addref(); return *this; }
         //! Compares two references for equality. 
         //! @details Two references are equal if their underlying pointers are either equal or both invalid.
         //! @param[in] rhs The reference to compare with.
@@ -712,5 +709,91 @@ namespace Luna
         }
     };
 
+    //! The non-owning view to one boxed object that does not modify the reference counters of the object.
+    //! @details Creating, copying and destroying one borrowed reference are as cheap as doing so for one raw pointer, so borrowed
+    //! references can be used to collect and iterate over objects that are kept alive by strong references elsewhere, for example,
+    //! collecting objects into one temporary list in one frame. The user must ensure that the boxed object is kept alive by other strong 
+    //! references when the borrowed reference is used, and should call @ref pin to create one strong reference if the object is needed
+    //! after that.
+    //! 
+    //! In debug build, accessing the boxed object through one borrowed reference checks that the object is not expired, and that the object
+    //! is not thread-confined to one thread other than the current thread. See @ref object_set_thread_confined for details.
+    template <typename _Ty>
+    class BorrowedRef
+    {
+        static constexpr bool has_get_object = is_base_of_v<Interface, _Ty>;
+
+        template <bool _HasGetObject>
+        struct InterfaceAdapter;
+        template <> struct InterfaceAdapter<true>
+        {
+            static object_t get_object(_Ty* obj) { return obj ? obj->get_object() : nullptr; }
+        };
+        template <> struct InterfaceAdapter<false>
+        {
+            static object_t get_object(_Ty* obj) { return (object_t)obj; }
+        };
+
+        _Ty* m_vtable;
+
+        void check_access() const
+        {
+#ifdef LUNA_DEBUG
+            object_t obj = object();
+            luassert_msg(!object_expired(obj), "One expired object is accessed through one borrowed reference.");
+            luassert_msg(object_is_accessible_from_current_thread(obj), "One thread-confined object is accessed through one borrowed reference from one thread other than its owning thread.");
+#endif
+        }
+    public:
+        //! Constructs one null reference.
+        BorrowedRef() : m_vtable(nullptr) {}
+        //! Constructs one borrowed reference from one strong reference.
+        //! @details The reference counter of the boxed object is not modified.
+        //! @param[in] rhs The strong reference to borrow from.
+        BorrowedRef(const Ref<_Ty>& rhs) : m_vtable((_Ty*)rhs) {}
+        //! Constructs one borrowed reference from one native pointer.
+        //! @details The reference counter of the boxed object is not modified.
+        //! @param[in] ptr The native pointer to borrow.
+        BorrowedRef(_Ty* ptr) : m_vtable(ptr) {}
+        //! Resets the reference to null.
+        void reset() { m_vtable = nullptr; }
+        //! Checks whether this reference is valid.
+        //! @details One borrowed reference is valid when it is not null.
+        //! @return Returns `true` when the reference is valid. Returns `false` otherwise.
+        bool valid() const { return m_vtable != nullptr; }
+        //! Gets the boxed object.
+        //! @return Returns one pointer to the boxed object. Returns `nullptr` if the reference is null.
+        object_t object() const { return InterfaceAdapter<has_get_object>::get_object(m_vtable); }
+        //! Gets the boxed object casted to `_Ty`.
+        //! @return Returns the interface or object pointer of the boxed object.
+        //! @remark See remarks of @ref Ref::get for details.
+        _Ty* get() const { luassert(m_vtable); check_access(); return m_vtable; }
+        //! Gets the boxed object casted to `_Ty`.
+        //! @return Returns the interface or object pointer of the boxed object.
+        _Ty* operator->() const { return get(); }
+        //! Gets the boxed object casted to `_Ty`.
+        //! @return Returns the interface or object pointer of the boxed object. Returns `nullptr` if the reference is not valid.
+        operator _Ty* () const { return m_vtable; }
+        //! Checks whether this reference is valid.
+        //! @return Returns `true` when the reference is valid. Returns `false` otherwise.
+        operator bool() const { return valid(); }
+        //! Compares two references for equality. 
+        //! @param[in] rhs The reference to compare with.
+        //! @return Returns `true` if two references are equal. Returns `false` otherwise.
+        bool operator== (const BorrowedRef& rhs) const { return m_vtable == rhs.m_vtable; }
+        //! Compares two references for non-equality.
+        //! @param[in] rhs The reference to compare with.
+        //! @return Returns `true` if two references are not equal. Returns `false` otherwise.
+        bool operator!= (const BorrowedRef& rhs) const { return m_vtable != rhs.m_vtable; }
+        //! Creates one strong reference from this borrowed reference.
+        //! @details The strong reference counter of the boxed object, if not null, will be increased.
+        //! @return Returns the created strong reference. Returns one null reference if this reference is null.
+        Ref<_Ty> pin() const
+        {
+            if (m_vtable) check_access();
+            return Ref<_Ty>(m_vtable);
+        }
+    };
+
     //! @}
 }
\ No newline at end of file
@@ -0,0 +1,153 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SPSCQueue.hpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#pragma once
+#include "Allocator.hpp"
+#include "Atomic.hpp"
+#include "Assert.hpp"
+#include "MemoryUtils.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeContainer
+    //! @{
+
+    //! One bounded lock-free first-in-first-out queue that can be used by one producer thread and one consumer thread.
+    //! @details The queue allocates one fixed circular buffer when constructed, and never allocates memory after that.
+    //! Only one thread may call @ref push and @ref emplace, and only one thread may call @ref pop at the same time,
+    //! the producer thread and the consumer thread can be different threads. Use @ref MPMCQueue if multiple producers
+    //! or consumers are required.
+    //! @tparam _Ty The element type of the queue.
+    //! @tparam _Alloc The allocator type of the queue.
+    template <typename _Ty, typename _Alloc = Allocator>
+    class SPSCQueue
+    {
+    public:
+        using value_type = _Ty;
+        using allocator_type = _Alloc;
+
+        //! Constructs one empty queue.
+        //! @param[in] capacity The maximum number of elements that can be stored in the queue. This will be rounded up to
+        //! power of two.
+        //! @param[in] alloc The allocator to use.
+        SPSCQueue(usize capacity, const allocator_type& alloc = allocator_type()) :
+            m_tail(0),
+            m_cached_head(0),
+            m_head(0),
+            m_cached_tail(0),
+            m_allocator_and_buffer(alloc, nullptr)
+        {
+            usize cap = 1;
+            while (cap < capacity) cap <<= 1;
+            m_mask = cap - 1;
+            m_allocator_and_buffer.second() = m_allocator_and_buffer.first().template allocate<value_type>(cap);
+        }
+        SPSCQueue(const SPSCQueue&) = delete;
+        SPSCQueue& operator=(const SPSCQueue&) = delete;
+        ~SPSCQueue()
+        {
+            value_type* buf = m_allocator_and_buffer.second();
+            for (usize i = m_head; i != m_tail; ++i)
+            {
+                buf[i & m_mask].~value_type();
+            }
+            m_allocator_and_buffer.first().template deallocate<value_type>(buf, m_mask + 1);
+        }
+        //! Gets the maximum number of elements that can be stored in the queue.
+        usize capacity() const
+        {
+            return m_mask + 1;
+        }
+        //! Gets an estimated number of elements in the queue.
+        //! @details The returned value may be outdated as soon as this function returns if other threads are
+        //! accessing the queue.
+        usize size() const
+        {
+            usize head = m_head;
+            usize tail = m_tail;
+            isize size = (isize)(tail - head);
+            return size > 0 ? (usize)size : 0;
+        }
+        //! Checks whether the queue is empty. See remarks of @ref size for details.
+        bool empty() const
+        {
+            return size() == 0;
+        }
+        //! Constructs one element at the back of the queue. Only the producer thread can call this function.
+        //! @param[in] args The arguments to construct the element.
+        //! @return Returns `true` if the element is pushed, returns `false` if the queue is full. The element is not
+        //! constructed if the queue is full.
+        template <typename... _Args>
+        bool emplace(_Args&&... args)
+        {
+            usize tail = m_tail;
+            if (tail - m_cached_head > m_mask)
+            {
+                // Only reads the head modified by the consumer when the cached head shows that the queue is full, so
+                // that the producer does not touch the consumer's cache line on every push.
+                m_cached_head = m_head;
+                if (tail - m_cached_head > m_mask) return false;
+            }
+            new (m_allocator_and_buffer.second() + (tail & m_mask)) value_type(forward<_Args>(args)...);
+            // The element must be visible before the new tail is visible.
+            atom_exchange_usize(&m_tail, tail + 1);
+            return true;
+        }
+        //! Pushes one element to the back of the queue. Only the producer thread can call this function.
+        //! @param[in] val The element to push.
+        //! @return Returns `true` if the element is pushed, returns `false` if the queue is full.
+        bool push(const value_type& val)
+        {
+            return emplace(val);
+        }
+        //! Pushes one element to the back of the queue. Only the producer thread can call this function.
+        //! @param[in] val The element to push. The element is moved only if this function returns `true`.
+        //! @return Returns `true` if the element is pushed, returns `false` if the queue is full.
+        bool push(value_type&& val)
+        {
+            return emplace(move(val));
+        }
+        //! Pops one element from the front of the queue. Only the consumer thread can call this function.
+        //! @param[out] val The popped element.
+        //! @return Returns `true` if one element is popped, returns `false` if the queue is empty.
+        bool pop(value_type& val)
+        {
+            usize head = m_head;
+            if (head == m_cached_tail)
+            {
+                m_cached_tail = m_tail;
+                if (head == m_cached_tail) return false;
+                // The element must not be read before the new tail is read.
+                atom_memory_barrier();
+            }
+            value_type* elem = m_allocator_and_buffer.second() + (head & m_mask);
+            val = move(*elem);
+            elem->~value_type();
+            // The element must be consumed before the slot can be reused by the producer.
+            atom_exchange_usize(&m_head, head + 1);
+            return true;
+        }
+        //! Gets one copy of the allocator of the queue.
+        allocator_type get_allocator() const
+        {
+            return m_allocator_and_buffer.first();
+        }
+    private:
+        // The producer and consumer indices are placed in different cache lines so that the producer and the
+        // consumer do not invalidate each other's cache line on every operation.
+        alignas(64) usize volatile m_tail;
+        usize m_cached_head;
+        alignas(64) usize volatile m_head;
+        usize m_cached_tail;
+        alignas(64) OptionalPair<allocator_type, value_type*> m_allocator_and_buffer;
+        usize m_mask;
+    };
+
+    //! @}
+}
@@ -8,7 +8,7 @@
 * @date 2022/5/1
 */
 #pragma once
-#include "Impl/RobinHoodHashTable.hpp"
+#include "Impl/SwissHashTable.hpp"
 
 namespace Luna
 {
@@ -46,11 +46,11 @@ namespace Luna
         using const_reference = const value_type&;
         using pointer = value_type*;
         using const_pointer = const value_type*;
-        using iterator = RobinHoodHashing::Iterator<value_type, false>;
-        using const_iterator = RobinHoodHashing::Iterator<value_type, true>;
+        using iterator = SwissHashing::Iterator<value_type, false>;
+        using const_iterator = SwissHashing::Iterator<value_type, true>;
 
     private:
-        using table_type = RobinHoodHashing::HashTable<key_type, value_type, extract_key, hasher, key_equal, allocator_type>;
+        using table_type = SwissHashing::HashTable<key_type, value_type, extract_key, hasher, key_equal, allocator_type>;
         table_type m_base;
 
         SelfIndexedHashMap(table_type&& base) :
@@ -0,0 +1,271 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SoAVector.hpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#pragma once
+#include "Algorithm.hpp"
+#include "Allocator.hpp"
+#include "Assert.hpp"
+#include "MemoryUtils.hpp"
+#include "Span.hpp"
+#include "Tuple.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeContainer
+    //! @{
+
+    //! The alignment of every column array of @ref BasicSoAVector, in bytes.
+    //! @details This is large enough for loading or storing one 256-bit SIMD vector from column arrays directly.
+    constexpr usize SOA_COLUMN_ALIGNMENT = 32;
+
+    namespace SoAVectorImpl
+    {
+        template <usize... _Is>
+        struct IndexSequence {};
+
+        template <usize _N, usize... _Is>
+        struct MakeIndexSequence : MakeIndexSequence<_N - 1, _N - 1, _Is...> {};
+
+        template <usize... _Is>
+        struct MakeIndexSequence<0, _Is...>
+        {
+            using type = IndexSequence<_Is...>;
+        };
+
+        // Column arrays are allocated in units of this type so that every column array is aligned.
+        struct alignas(SOA_COLUMN_ALIGNMENT) ColumnBlock
+        {
+            u8 m_data[SOA_COLUMN_ALIGNMENT];
+        };
+    }
+
+    //! A container that stores a continuous array of elements in structure-of-arrays layout.
+    //! @details Every element of the container is composed by one value of every type in `_Tys`, but values of
+    //! different types are not stored together. Instead, values of every type are stored in one dedicated array called
+    //! column, so that loops that only access some of the values of every element do not load unused values into cache,
+    //! and values in one column can be loaded and stored using SIMD instructions directly.
+    //!
+    //! Every column array is aligned to @ref SOA_COLUMN_ALIGNMENT bytes, and the size of every column array is padded
+    //! to multiple of @ref SOA_COLUMN_ALIGNMENT bytes, so that one aligned SIMD load or store starting at any aligned
+    //! position in range [`column_data<I>()`, `column_data<I>() + size()`) does not exceed the column memory. For example,
+    //! if the column type is `f32`, `Simd::load_f4(column_data<I>() + i)` is valid for every `i` that is multiple of 4 and
+    //! less than `size()`. Values in the padding area are not initialized and must not be used.
+    //!
+    //! Elements are accessed using tuple-like proxies, which are @ref Tuple objects that store references to the values
+    //! of the element, use @ref get to access every value of one proxy.
+    //!
+    //! All column arrays are allocated in one memory block, so adding elements to one SoA vector allocates memory only when
+    //! the capacity is exceeded, like @ref Vector.
+    //! @tparam _Alloc The memory allocator used by the container.
+    //! @tparam _Tys The value types of every column. At least one type must be specified.
+    template <typename _Alloc, typename... _Tys>
+    class BasicSoAVector
+    {
+        static_assert(sizeof...(_Tys) > 0, "BasicSoAVector must have at least one column.");
+    public:
+        using allocator_type = _Alloc;
+        using value_type = Tuple<_Tys...>;
+        using reference = Tuple<_Tys&...>;
+        using const_reference = Tuple<const _Tys&...>;
+        //! The value type of the specified column.
+        template <usize _I>
+        using column_type = typename TupleElement<_I, Tuple<_Tys...>>::type;
+        //! The number of columns.
+        static constexpr usize num_columns = sizeof...(_Tys);
+
+        //! Constructs an empty vector.
+        BasicSoAVector();
+        //! Constructs an empty vector with an custom allocator.
+        //! @param[in] alloc The allocator to use. The allocator object will be copy-constructed into the vector.
+        BasicSoAVector(const allocator_type& alloc);
+        //! Constructs one vector by coping all elements from another vector.
+        //! @param[in] rhs The vector to copy elements from.
+        BasicSoAVector(const BasicSoAVector& rhs);
+        //! Constructs one vector by moving all elements from another vector.
+        //! @details No element object will be moved, the moved vector will be empty.
+        //! @param[in] rhs The vector to move elements from.
+        BasicSoAVector(BasicSoAVector&& rhs);
+        //! Replaces elements of the vector by coping elements from another vector.
+        //! @param[in] rhs The vector to copy elements from.
+        //! @return Returns `*this`.
+        BasicSoAVector& operator=(const BasicSoAVector& rhs);
+        //! Replaces elements of the vector by moving elements from another vector.
+        //! @param[in] rhs The vector to move elements from. This vector will be empty after this operation.
+        //! @return Returns `*this`.
+        BasicSoAVector& operator=(BasicSoAVector&& rhs);
+        ~BasicSoAVector();
+        //! Gets the size of the vector, that is, the number of elements in the vector.
+        //! @return Returns the size of the vector.
+        usize size() const;
+        //! Gets the capacity of the vector, that is, the number of elements the vector can hold without reallocating memory.
+        //! @return Returns the capacity of the vector.
+        usize capacity() const;
+        //! Checks whether this vector is empty, that is, the size of this vector is `0`.
+        //! @return Returns `true` if this vector is empty, returns `false` otherwise.
+        bool empty() const;
+        //! Increases the capacity of the vector to a value greater than or equal to `new_cap`, so that it can hold at least
+        //! `new_cap` elements without reallocating memory.
+        //! @details If `new_cap` is smaller than or equal to the current capacity, this function does nothing.
+        //! Pointers to elements and column spans are invalidated if the capacity is increased.
+        //! @param[in] new_cap The new capacity value to reserve.
+        void reserve(usize new_cap);
+        //! Resizes the vector.
+        //! @details New values are default-initialized.
+        //! @param[in] n The new size of the vector.
+        void resize(usize n);
+        //! Reduces the capacity of the vector so that capacity equals to the size of the vector.
+        //! @details If the vector is empty, all memory used by the vector is freed.
+        void shrink_to_fit();
+        //! Removes all elements from the vector, but keeps the vector capacity.
+        void clear();
+        //! Accesses the element at the specified position.
+        //! @param[in] n The index of the element.
+        //! @return Returns one tuple that references values of the element.
+        //! @par Valid Usage
+        //! * `n` must be in range [`0`, `size()`).
+        reference operator[](usize n);
+        //! Accesses the element at the specified position.
+        //! @param[in] n The index of the element.
+        //! @return Returns one tuple that references values of the element.
+        //! @par Valid Usage
+        //! * `n` must be in range [`0`, `size()`).
+        const_reference operator[](usize n) const;
+        //! Accesses the element at the specified position.
+        //! @param[in] n The index of the element.
+        //! @return Returns one tuple that references values of the element.
+        //! @par Valid Usage
+        //! * `n` must be in range [`0`, `size()`).
+        reference at(usize n);
+        //! Accesses the element at the specified position.
+        //! @param[in] n The index of the element.
+        //! @return Returns one tuple that references values of the element.
+        //! @par Valid Usage
+        //! * `n` must be in range [`0`, `size()`).
+        const_reference at(usize n) const;
+        //! Gets the first element in the vector.
+        //! @return Returns one tuple that references values of the first element.
+        //! @par Valid Usage
+        //! * `empty()` must be `false`.
+        reference front();
+        //! Gets the first element in the vector.
+        //! @return Returns one tuple that references values of the first element.
+        //! @par Valid Usage
+        //! * `empty()` must be `false`.
+        const_reference front() const;
+        //! Gets the last element in the vector.
+        //! @return Returns one tuple that references values of the last element.
+        //! @par Valid Usage
+        //! * `empty()` must be `false`.
+        reference back();
+        //! Gets the last element in the vector.
+        //! @return Returns one tuple that references values of the last element.
+        //! @par Valid Usage
+        //! * `empty()` must be `false`.
+        const_reference back() const;
+        //! Gets one pointer to the array of the specified column.
+        //! @return Returns one pointer to the array of the specified column. The pointer is aligned to @ref SOA_COLUMN_ALIGNMENT.
+        //! Returns `nullptr` if the capacity of the vector is `0`.
+        template <usize _I>
+        column_type<_I>* column_data();
+        //! Gets one pointer to the array of the specified column.
+        //! @return Returns one pointer to the array of the specified column. The pointer is aligned to @ref SOA_COLUMN_ALIGNMENT.
+        //! Returns `nullptr` if the capacity of the vector is `0`.
+        template <usize _I>
+        const column_type<_I>* column_data() const;
+        //! Gets one span of all values of the specified column.
+        //! @return Returns one span of all values of the specified column.
+        template <usize _I>
+        Span<column_type<_I>> column();
+        //! Gets one span of all values of the specified column.
+        //! @return Returns one span of all values of the specified column.
+        template <usize _I>
+        Span<const column_type<_I>> column() const;
+        //! Constructs one element at the end of the vector.
+        //! @param[in] args The arguments to construct values of the element. One argument must be specified for every column,
+        //! every value is constructed by `column_type<I>(arg_I)`.
+        template <typename... _Args>
+        void emplace_back(_Args&&... args);
+        //! Pushes one element at the end of the vector.
+        //! @param[in] val The values of the element to push. Values are copy-constructed into the vector.
+        void push_back(const value_type& val);
+        //! Pushes one element at the end of the vector.
+        //! @param[in] val The values of the element to push. Values are move-constructed into the vector.
+        void push_back(value_type&& val);
+        //! Removes the last element of the vector.
+        //! @par Valid Usage
+        //! * `empty()` must be `false`.
+        void pop_back();
+        //! Removes one element from the vector.
+        //! @details Elements after the removed element are moved forward to fill the gap.
+        //! @param[in] n The index of the element to remove.
+        //! @par Valid Usage
+        //! * `n` must be in range [`0`, `size()`).
+        void erase(usize n);
+        //! Removes one element from the vector, then relocates the last element of the vector to the position of the removed element.
+        //! @details This can be used to prevent moving elements when the element order is not significant.
+        //! @param[in] n The index of the element to remove.
+        //! @par Valid Usage
+        //! * `n` must be in range [`0`, `size()`).
+        void swap_erase(usize n);
+        //! Swaps elements of this vector with the specified vector.
+        //! @param[in] rhs The vector to swap elements with.
+        void swap(BasicSoAVector& rhs);
+        //! Gets the allocator of the vector.
+        //! @return Returns one copy of the allocator of the vector.
+        allocator_type get_allocator() const;
+    private:
+        using indices_t = typename SoAVectorImpl::MakeIndexSequence<num_columns>::type;
+        static constexpr usize column_sizes[] = { sizeof(_Tys)... };
+
+        // The memory block of all columns.
+        OptionalPair<allocator_type, SoAVectorImpl::ColumnBlock*> m_allocator_and_buffer;
+        // The pointer to every column array in the memory block.
+        void* m_columns[num_columns];
+        usize m_size;
+        usize m_capacity;
+
+        static usize internal_num_blocks(usize capacity);
+        SoAVectorImpl::ColumnBlock* internal_allocate(usize capacity, void** columns);
+        void internal_free(SoAVectorImpl::ColumnBlock* buffer, usize capacity);
+        void internal_free_buffer();
+        void internal_expand_reserve(usize new_least_cap);
+        void internal_reallocate(usize new_cap);
+        template <usize... _Is>
+        void internal_relocate(SoAVectorImpl::IndexSequence<_Is...>, void** dst_columns);
+        template <usize... _Is>
+        void internal_copy_construct(SoAVectorImpl::IndexSequence<_Is...>, const BasicSoAVector& rhs);
+        template <usize... _Is>
+        void internal_default_construct(SoAVectorImpl::IndexSequence<_Is...>, usize first, usize last);
+        template <usize... _Is>
+        void internal_destruct(SoAVectorImpl::IndexSequence<_Is...>, usize first, usize last);
+        template <usize... _Is, typename... _Args>
+        void internal_construct_back(SoAVectorImpl::IndexSequence<_Is...>, _Args&&... args);
+        template <usize... _Is>
+        void internal_copy_back(SoAVectorImpl::IndexSequence<_Is...>, const value_type& val);
+        template <usize... _Is>
+        void internal_move_back(SoAVectorImpl::IndexSequence<_Is...>, value_type& val);
+        template <usize... _Is>
+        void internal_erase(SoAVectorImpl::IndexSequence<_Is...>, usize n);
+        template <usize... _Is>
+        void internal_swap_erase(SoAVectorImpl::IndexSequence<_Is...>, usize n);
+        template <usize... _Is>
+        reference internal_get(SoAVectorImpl::IndexSequence<_Is...>, usize n);
+        template <usize... _Is>
+        const_reference internal_get(SoAVectorImpl::IndexSequence<_Is...>, usize n) const;
+    };
+
+    //! The structure-of-arrays vector that uses the default allocator.
+    //! @details See @ref BasicSoAVector for details.
+    template <typename... _Tys>
+    using SoAVector = BasicSoAVector<Allocator, _Tys...>;
+
+    //! @}
+}
+
+#include "Impl/SoAVector.inl"
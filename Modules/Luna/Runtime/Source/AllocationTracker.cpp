@@ -0,0 +1,267 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AllocationTracker.cpp
+* @author JXMaster
+* @date 2024/5/21
+*/
+#include "../PlatformDefines.hpp"
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "Memory.hpp"
+#include "../SpinLock.hpp"
+#include "../Atomic.hpp"
+#include "OS.hpp"
+
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+namespace Luna
+{
+    // Allocation counts of one thread.
+    // Counts are written by the owning thread and are reset by `allocation_tracker_new_frame`, so they are protected by
+    // one per-thread lock, which is uncontended except at frame boundaries.
+    struct AllocationTrackerThreadContext
+    {
+        SpinLock m_lock;
+        AllocationFrameStats m_current_frame = {};
+        AllocationFrameStats m_last_frame = {};
+        // The stack of allocation-free section names.
+        const c8* m_sections[32];
+        u32 m_num_sections = 0;
+        // Prevents recursive recording when recording itself allocates, for example when the assertion handler runs.
+        bool m_recording = false;
+        AllocationTrackerThreadContext* m_prev_context = nullptr;
+        AllocationTrackerThreadContext* m_next_context = nullptr;
+    };
+
+    bool volatile g_allocation_tracker_enabled = false;
+    bool g_allocation_tracker_assert_on_violation = false;
+    bool g_allocation_tracker_inited = false;
+    opaque_t g_allocation_tracker_tls;
+    // Protects the context list and the frame index.
+    SpinLock g_allocation_tracker_lock;
+    AllocationTrackerThreadContext* g_allocation_tracker_contexts = nullptr;
+    u32 g_allocation_tracker_next_thread_index = 0;
+    u64 g_allocation_tracker_frame_index = 0;
+    SpinLock g_allocation_offenders_lock;
+    AllocationOffender g_allocation_offenders[MAX_ALLOCATION_OFFENDERS];
+    u32 g_num_allocation_offenders = 0;
+
+    static void allocation_tracker_thread_context_dtor(void* data)
+    {
+        AllocationTrackerThreadContext* ctx = (AllocationTrackerThreadContext*)data;
+        if (!ctx) return;
+        LockGuard guard(g_allocation_tracker_lock);
+        if (ctx->m_prev_context) ctx->m_prev_context->m_next_context = ctx->m_next_context;
+        else g_allocation_tracker_contexts = ctx->m_next_context;
+        if (ctx->m_next_context) ctx->m_next_context->m_prev_context = ctx->m_prev_context;
+        guard.unlock();
+        OS::memdelete(ctx);
+    }
+
+    static AllocationTrackerThreadContext* get_allocation_tracker_thread_context()
+    {
+        AllocationTrackerThreadContext* ctx = (AllocationTrackerThreadContext*)OS::tls_get(g_allocation_tracker_tls);
+        if (!ctx)
+        {
+            ctx = OS::memnew<AllocationTrackerThreadContext>();
+            OS::tls_set(g_allocation_tracker_tls, ctx);
+            LockGuard guard(g_allocation_tracker_lock);
+            ctx->m_current_frame.thread_index = g_allocation_tracker_next_thread_index++;
+            ctx->m_last_frame.thread_index = ctx->m_current_frame.thread_index;
+            // Keeps the list ordered by thread index, so that statistics are reported in a stable order.
+            AllocationTrackerThreadContext* tail = g_allocation_tracker_contexts;
+            while (tail && tail->m_next_context) tail = tail->m_next_context;
+            ctx->m_prev_context = tail;
+            if (tail) tail->m_next_context = ctx;
+            else g_allocation_tracker_contexts = ctx;
+        }
+        return ctx;
+    }
+
+    static void record_allocation_offender(AllocationTrackerThreadContext* ctx, usize size, const c8* object_type)
+    {
+        LockGuard guard(g_allocation_offenders_lock);
+        if (g_num_allocation_offenders < MAX_ALLOCATION_OFFENDERS)
+        {
+            AllocationOffender& offender = g_allocation_offenders[g_num_allocation_offenders];
+            offender.frame_index = g_allocation_tracker_frame_index;
+            offender.thread_index = ctx->m_current_frame.thread_index;
+            offender.section = ctx->m_sections[min<u32>(ctx->m_num_sections, 32) - 1];
+            offender.size = size;
+            offender.object_type = object_type;
+            offender.num_frames = OS::stack_backtrace(Span<opaque_t>(offender.frames, MAX_ALLOCATION_OFFENDER_FRAMES));
+            ++g_num_allocation_offenders;
+        }
+    }
+
+    // Records one event for the current thread. `size` is the allocated size for allocations, `object_type` is not `nullptr`
+    // for object creations, and both are `0` for deallocations.
+    static void allocation_tracker_record(usize size, const c8* object_type, bool deallocation)
+    {
+        if (!g_allocation_tracker_inited) return;
+        AllocationTrackerThreadContext* ctx = get_allocation_tracker_thread_context();
+        if (ctx->m_recording) return;
+        ctx->m_recording = true;
+        bool violated = false;
+        {
+            LockGuard guard(ctx->m_lock);
+            AllocationFrameStats& stats = ctx->m_current_frame;
+            if (deallocation)
+            {
+                ++stats.num_deallocations;
+            }
+            else
+            {
+                if (object_type) ++stats.num_objects_created;
+                else
+                {
+                    ++stats.num_allocations;
+                    stats.allocated_bytes += size;
+                }
+                // Freeing memory in allocation-free sections is allowed, since it is usually one deferred release.
+                if (ctx->m_num_sections)
+                {
+                    ++stats.num_violations;
+                    violated = true;
+                }
+            }
+        }
+        if (violated)
+        {
+            record_allocation_offender(ctx, size, object_type);
+            if (g_allocation_tracker_assert_on_violation)
+            {
+                lupanic_msg_always("Memory is allocated or one object is created in one allocation-free section.");
+            }
+        }
+        ctx->m_recording = false;
+    }
+
+    void allocation_tracker_record_allocation(usize size)
+    {
+        allocation_tracker_record(size, nullptr, false);
+    }
+
+    void allocation_tracker_record_deallocation()
+    {
+        allocation_tracker_record(0, nullptr, true);
+    }
+
+    void allocation_tracker_init()
+    {
+        g_allocation_tracker_tls = OS::tls_alloc(allocation_tracker_thread_context_dtor);
+        g_allocation_tracker_inited = true;
+    }
+
+    void allocation_tracker_close()
+    {
+        g_allocation_tracker_enabled = false;
+        g_allocation_tracker_inited = false;
+        // Contexts of threads that are still alive are freed here, since TLS destructors are not called after the
+        // slot is freed.
+        AllocationTrackerThreadContext* ctx = g_allocation_tracker_contexts;
+        while (ctx)
+        {
+            AllocationTrackerThreadContext* next = ctx->m_next_context;
+            OS::memdelete(ctx);
+            ctx = next;
+        }
+        g_allocation_tracker_contexts = nullptr;
+        OS::tls_free(g_allocation_tracker_tls);
+        g_allocation_tracker_next_thread_index = 0;
+        g_allocation_tracker_frame_index = 0;
+        g_num_allocation_offenders = 0;
+    }
+
+    LUNA_RUNTIME_API void allocation_tracker_set_enabled(bool enabled)
+    {
+        g_allocation_tracker_enabled = enabled && g_allocation_tracker_inited;
+    }
+
+    LUNA_RUNTIME_API bool allocation_tracker_is_enabled()
+    {
+        return g_allocation_tracker_enabled;
+    }
+
+    LUNA_RUNTIME_API void allocation_tracker_new_frame()
+    {
+        LockGuard guard(g_allocation_tracker_lock);
+        for (AllocationTrackerThreadContext* ctx = g_allocation_tracker_contexts; ctx; ctx = ctx->m_next_context)
+        {
+            LockGuard ctx_guard(ctx->m_lock);
+            u32 thread_index = ctx->m_current_frame.thread_index;
+            ctx->m_last_frame = ctx->m_current_frame;
+            ctx->m_current_frame = {};
+            ctx->m_current_frame.thread_index = thread_index;
+        }
+        ++g_allocation_tracker_frame_index;
+    }
+
+    LUNA_RUNTIME_API u64 allocation_tracker_get_frame_index()
+    {
+        return g_allocation_tracker_frame_index;
+    }
+
+    LUNA_RUNTIME_API usize allocation_tracker_get_last_frame_stats(Span<AllocationFrameStats> stats)
+    {
+        LockGuard guard(g_allocation_tracker_lock);
+        usize num_threads = 0;
+        for (AllocationTrackerThreadContext* ctx = g_allocation_tracker_contexts; ctx; ctx = ctx->m_next_context)
+        {
+            if (num_threads < stats.size())
+            {
+                LockGuard ctx_guard(ctx->m_lock);
+                stats[num_threads] = ctx->m_last_frame;
+            }
+            ++num_threads;
+        }
+        return num_threads;
+    }
+
+    LUNA_RUNTIME_API void allocation_tracker_record_object_creation(const c8* type)
+    {
+        if (!g_allocation_tracker_enabled) return;
+        allocation_tracker_record(0, type, false);
+    }
+
+    LUNA_RUNTIME_API void allocation_tracker_begin_section(const c8* name)
+    {
+        if (!g_allocation_tracker_inited) return;
+        AllocationTrackerThreadContext* ctx = get_allocation_tracker_thread_context();
+        // Sections deeper than the name stack are still counted, and are reported with the name of the innermost recorded section.
+        if (ctx->m_num_sections < 32) ctx->m_sections[ctx->m_num_sections] = name;
+        ++ctx->m_num_sections;
+    }
+
+    LUNA_RUNTIME_API void allocation_tracker_end_section()
+    {
+        if (!g_allocation_tracker_inited) return;
+        AllocationTrackerThreadContext* ctx = get_allocation_tracker_thread_context();
+        luassert(ctx->m_num_sections);
+        --ctx->m_num_sections;
+    }
+
+    LUNA_RUNTIME_API void allocation_tracker_set_assert_on_violation(bool enabled)
+    {
+        g_allocation_tracker_assert_on_violation = enabled;
+    }
+
+    LUNA_RUNTIME_API usize allocation_tracker_get_offenders(Span<AllocationOffender> offenders)
+    {
+        LockGuard guard(g_allocation_offenders_lock);
+        usize num_copied = min<usize>(offenders.size(), g_num_allocation_offenders);
+        for (usize i = 0; i < num_copied; ++i)
+        {
+            offenders[i] = g_allocation_offenders[i];
+        }
+        return g_num_allocation_offenders;
+    }
+
+    LUNA_RUNTIME_API void allocation_tracker_clear_offenders()
+    {
+        LockGuard guard(g_allocation_offenders_lock);
+        g_num_allocation_offenders = 0;
+    }
+}
+#endif
@@ -0,0 +1,123 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AsyncFile.cpp
+* @author JXMaster
+* @date 2024/3/22
+*/
+#include "../PlatformDefines.hpp"
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "File.hpp"
+#include "../RingDeque.hpp"
+#include "../SpinLock.hpp"
+#include "../Semaphore.hpp"
+#include "../Thread.hpp"
+
+namespace Luna
+{
+    struct AsyncFileReadTask
+    {
+        Ref<IFile> m_file;
+        opaque_t m_handle;
+        u64 m_offset;
+        void* m_buffer;
+        usize m_size;
+        void (*m_on_complete)(void* userdata, RV result, usize read_bytes);
+        void* m_userdata;
+    };
+
+    // The number of IO threads. Several reads are kept in flight at the same time so that
+    // the storage device can process them in parallel.
+    constexpr u32 ASYNC_FILE_IO_THREADS = 4;
+
+    RingDeque<AsyncFileReadTask> g_async_file_tasks;
+    SpinLock g_async_file_lock;
+    // Counts tasks in the queue, plus one for every IO thread when IO threads should exit.
+    Ref<ISemaphore> g_async_file_semaphore;
+    Vector<Ref<IThread>> g_async_file_threads;
+    bool g_async_file_exiting = false;
+
+    static void async_file_thread_main(void*)
+    {
+        while (true)
+        {
+            g_async_file_semaphore->wait();
+            AsyncFileReadTask task;
+            {
+                LockGuard guard(g_async_file_lock);
+                if (g_async_file_tasks.empty())
+                {
+                    // Pending tasks are always finished before exiting.
+                    if (g_async_file_exiting) return;
+                    continue;
+                }
+                task = move(g_async_file_tasks.front());
+                g_async_file_tasks.pop_front();
+            }
+            usize read_bytes = 0;
+            RV r = OS::read_file_at(task.m_handle, task.m_offset, task.m_buffer, task.m_size, &read_bytes);
+            task.m_on_complete(task.m_userdata, r, read_bytes);
+        }
+    }
+
+    LUNA_RUNTIME_API RV submit_async_file_reads(Span<const AsyncFileReadDesc> reads)
+    {
+        for (auto& read : reads)
+        {
+            if (!cast_object<File>(read.file->get_object())) return BasicError::not_supported();
+        }
+        LockGuard guard(g_async_file_lock);
+        // IO threads are created when the first read is submitted.
+        if (g_async_file_threads.empty())
+        {
+            g_async_file_semaphore = new_semaphore(0, I32_MAX);
+            for (u32 i = 0; i < ASYNC_FILE_IO_THREADS; ++i)
+            {
+                g_async_file_threads.push_back(new_thread(async_file_thread_main, nullptr, "Async File IO Thread"));
+            }
+        }
+        for (auto& read : reads)
+        {
+            AsyncFileReadTask task;
+            task.m_file = read.file;
+            task.m_handle = cast_object<File>(read.file->get_object())->m_file;
+            task.m_offset = read.offset;
+            task.m_buffer = read.buffer;
+            task.m_size = read.size;
+            task.m_on_complete = read.on_complete;
+            task.m_userdata = read.userdata;
+            g_async_file_tasks.push_back(move(task));
+        }
+        guard.unlock();
+        for (usize i = 0; i < reads.size(); ++i)
+        {
+            g_async_file_semaphore->release();
+        }
+        return ok;
+    }
+
+    void async_file_close()
+    {
+        if (g_async_file_threads.empty()) return;
+        {
+            LockGuard guard(g_async_file_lock);
+            g_async_file_exiting = true;
+        }
+        for (usize i = 0; i < g_async_file_threads.size(); ++i)
+        {
+            g_async_file_semaphore->release();
+        }
+        for (auto& t : g_async_file_threads)
+        {
+            t->wait();
+        }
+        g_async_file_threads.clear();
+        g_async_file_threads.shrink_to_fit();
+        g_async_file_tasks.clear();
+        g_async_file_tasks.shrink_to_fit();
+        g_async_file_semaphore = nullptr;
+        g_async_file_exiting = false;
+    }
+}
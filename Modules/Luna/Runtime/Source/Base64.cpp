@@ -10,6 +10,15 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_RUNTIME_API LUNA_EXPORT
 #include "../Base64.hpp"
+#include "../CPU.hpp"
+
+#ifdef LUNA_TARGET_SSSE3
+#include <immintrin.h>
+#endif
+#if !defined(LUNA_DISABLE_SIMD) && defined(LUNA_PLATFORM_ARM64)
+#define LUNA_BASE64_NEON
+#include <arm_neon.h>
+#endif
 
 namespace Luna
 {
@@ -50,7 +59,7 @@ namespace Luna
     }
 
 
-    LUNA_RUNTIME_API usize base64_encode(c8* dst, usize dst_max_chars, const void* src, usize src_size_bytes)
+    static usize base64_encode_scalar(c8* dst, usize dst_max_chars, const void* src, usize src_size_bytes)
     {
         u8 data_tuple[3];
         u8 str_tuple[4];
@@ -84,7 +93,7 @@ namespace Luna
         return str_cur;
     }
 
-    LUNA_RUNTIME_API usize base64_decode(void* dst, usize dst_max_bytes, const c8* src, usize src_size_chars)
+    static usize base64_decode_scalar(void* dst, usize dst_max_bytes, const c8* src, usize src_size_chars)
     {
         u8 str_tuple[4];
         u8 padding;
@@ -120,4 +129,300 @@ namespace Luna
         }
         return data_cur;
     }
+
+    // Vectorized kernels encode or decode the leading part of the data and return the number of source bytes or 
+    // characters processed, the remaining part is processed by the scalar implementation. Encoding kernels always 
+    // process times of 3 bytes and decoding kernels always process times of 4 characters, so the scalar 
+    // implementation can continue from where the kernel stops. Decoding kernels stop at the first block that contains 
+    // padding or invalid characters, so that such blocks are handled by the scalar implementation.
+#ifdef LUNA_TARGET_SSSE3
+    // Based on "Faster Base64 Encoding and Decoding using AVX2 Instructions" by Wojciech Muła and Daniel Lemire.
+    LUNA_TARGET_SSSE3 static inline __m128i base64_encode_lookup_ssse3(__m128i indices)
+    {
+        // Maps every 6-bit index to the offset added to the index to get the character.
+        const __m128i shift_lut = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        __m128i result = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        __m128i less = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+        result = _mm_or_si128(result, _mm_and_si128(less, _mm_set1_epi8(13)));
+        return _mm_add_epi8(_mm_shuffle_epi8(shift_lut, result), indices);
+    }
+    LUNA_TARGET_SSSE3 static usize base64_encode_ssse3(c8* dst, usize dst_max_chars, const u8* src, usize src_size)
+    {
+        const __m128i shuffle = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        usize i = 0;
+        usize o = 0;
+        // Loads 16 bytes and encodes 12 of them to 16 characters.
+        while (src_size - i >= 16 && dst_max_chars - o > 16)
+        {
+            __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i)), shuffle);
+            __m128i t0 = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+            __m128i t1 = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+            _mm_storeu_si128((__m128i*)(dst + o), base64_encode_lookup_ssse3(_mm_or_si128(t0, t1)));
+            i += 12;
+            o += 16;
+        }
+        return i;
+    }
+    LUNA_TARGET_SSSE3 static usize base64_decode_ssse3(u8* dst, usize dst_max_bytes, const c8* src, usize src_size)
+    {
+        const __m128i lut_lo = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m128i lut_hi = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i lut_roll = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m128i mask_2f = _mm_set1_epi8(0x2f);
+        const __m128i shuffle = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        usize i = 0;
+        usize o = 0;
+        // Decodes 16 characters to 12 bytes, but writes 16 bytes.
+        while (src_size - i >= 16 && dst_max_bytes - o >= 16)
+        {
+            __m128i in = _mm_loadu_si128((const __m128i*)(src + i));
+            __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(in, 4), mask_2f);
+            __m128i lo_nibbles = _mm_and_si128(in, mask_2f);
+            __m128i hi = _mm_shuffle_epi8(lut_hi, hi_nibbles);
+            __m128i lo = _mm_shuffle_epi8(lut_lo, lo_nibbles);
+            if (_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_and_si128(lo, hi), _mm_setzero_si128()))) break;
+            __m128i eq_2f = _mm_cmpeq_epi8(in, mask_2f);
+            __m128i roll = _mm_shuffle_epi8(lut_roll, _mm_add_epi8(eq_2f, hi_nibbles));
+            in = _mm_add_epi8(in, roll);
+            in = _mm_maddubs_epi16(in, _mm_set1_epi32(0x01400140));
+            in = _mm_madd_epi16(in, _mm_set1_epi32(0x00011000));
+            _mm_storeu_si128((__m128i*)(dst + o), _mm_shuffle_epi8(in, shuffle));
+            i += 16;
+            o += 12;
+        }
+        return i;
+    }
+#endif
+#ifdef LUNA_TARGET_AVX2
+    LUNA_TARGET_AVX2 static inline __m256i base64_encode_lookup_avx2(__m256i indices)
+    {
+        const __m256i shift_lut = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+            'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+            '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        __m256i result = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+        __m256i less = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+        result = _mm256_or_si256(result, _mm256_and_si256(less, _mm256_set1_epi8(13)));
+        return _mm256_add_epi8(_mm256_shuffle_epi8(shift_lut, result), indices);
+    }
+    LUNA_TARGET_AVX2 static usize base64_encode_avx2(c8* dst, usize dst_max_chars, const u8* src, usize src_size)
+    {
+        const __m256i shuffle = _mm256_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1,
+            10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+        usize i = 0;
+        usize o = 0;
+        // Loads 12 bytes into every 128-bit lane and encodes 24 bytes to 32 characters.
+        while (src_size - i >= 28 && dst_max_chars - o > 32)
+        {
+            __m256i in = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(src + i))),
+                _mm_loadu_si128((const __m128i*)(src + i + 12)), 1);
+            in = _mm256_shuffle_epi8(in, shuffle);
+            __m256i t0 = _mm256_mulhi_epu16(_mm256_and_si256(in, _mm256_set1_epi32(0x0fc0fc00)), _mm256_set1_epi32(0x04000040));
+            __m256i t1 = _mm256_mullo_epi16(_mm256_and_si256(in, _mm256_set1_epi32(0x003f03f0)), _mm256_set1_epi32(0x01000010));
+            _mm256_storeu_si256((__m256i*)(dst + o), base64_encode_lookup_avx2(_mm256_or_si256(t0, t1)));
+            i += 24;
+            o += 32;
+        }
+        // Processes the remaining data that is not enough for one 256-bit block.
+        return i + base64_encode_ssse3(dst + o, dst_max_chars - o, src + i, src_size - i);
+    }
+    LUNA_TARGET_AVX2 static usize base64_decode_avx2(u8* dst, usize dst_max_bytes, const c8* src, usize src_size)
+    {
+        const __m256i lut_lo = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A,
+            0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+        const __m256i lut_hi = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+            0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i lut_roll = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+            0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i mask_2f = _mm256_set1_epi8(0x2f);
+        const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        // Packs 12 bytes of both lanes together.
+        const __m256i permute = _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7);
+        usize i = 0;
+        usize o = 0;
+        // Decodes 32 characters to 24 bytes, but writes 32 bytes.
+        while (src_size - i >= 32 && dst_max_bytes - o >= 32)
+        {
+            __m256i in = _mm256_loadu_si256((const __m256i*)(src + i));
+            __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(in, 4), mask_2f);
+            __m256i lo_nibbles = _mm256_and_si256(in, mask_2f);
+            __m256i hi = _mm256_shuffle_epi8(lut_hi, hi_nibbles);
+            __m256i lo = _mm256_shuffle_epi8(lut_lo, lo_nibbles);
+            if (!_mm256_testz_si256(lo, hi)) break;
+            __m256i eq_2f = _mm256_cmpeq_epi8(in, mask_2f);
+            __m256i roll = _mm256_shuffle_epi8(lut_roll, _mm256_add_epi8(eq_2f, hi_nibbles));
+            in = _mm256_add_epi8(in, roll);
+            in = _mm256_maddubs_epi16(in, _mm256_set1_epi32(0x01400140));
+            in = _mm256_madd_epi16(in, _mm256_set1_epi32(0x00011000));
+            in = _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(in, shuffle), permute);
+            _mm256_storeu_si256((__m256i*)(dst + o), in);
+            i += 32;
+            o += 24;
+        }
+        return i + base64_decode_ssse3(dst + o, dst_max_bytes - o, src + i, src_size - i);
+    }
+#endif
+#ifdef LUNA_BASE64_NEON
+    static usize base64_encode_neon(c8* dst, usize dst_max_chars, const u8* src, usize src_size)
+    {
+        const u8* chars = (const u8*)Impl::base64_encode_chars;
+        uint8x16x4_t lut;
+        lut.val[0] = vld1q_u8(chars);
+        lut.val[1] = vld1q_u8(chars + 16);
+        lut.val[2] = vld1q_u8(chars + 32);
+        lut.val[3] = vld1q_u8(chars + 48);
+        const uint8x16_t mask = vdupq_n_u8(0x3F);
+        usize i = 0;
+        usize o = 0;
+        // Deinterleaves 48 bytes to 3 vectors and encodes them to 64 characters.
+        while (src_size - i >= 48 && dst_max_chars - o > 64)
+        {
+            uint8x16x3_t in = vld3q_u8(src + i);
+            uint8x16x4_t out;
+            out.val[0] = vshrq_n_u8(in.val[0], 2);
+            out.val[1] = vandq_u8(vorrq_u8(vshrq_n_u8(in.val[1], 4), vshlq_n_u8(in.val[0], 4)), mask);
+            out.val[2] = vandq_u8(vorrq_u8(vshrq_n_u8(in.val[2], 6), vshlq_n_u8(in.val[1], 2)), mask);
+            out.val[3] = vandq_u8(in.val[2], mask);
+            out.val[0] = vqtbl4q_u8(lut, out.val[0]);
+            out.val[1] = vqtbl4q_u8(lut, out.val[1]);
+            out.val[2] = vqtbl4q_u8(lut, out.val[2]);
+            out.val[3] = vqtbl4q_u8(lut, out.val[3]);
+            vst4q_u8((u8*)(dst + o), out);
+            i += 48;
+            o += 64;
+        }
+        return i;
+    }
+    // Maps ASCII characters to 6-bit values, invalid characters are mapped to 0xFF.
+    struct Base64DecodeTable
+    {
+        u8 values[128];
+        constexpr Base64DecodeTable() :
+            values{}
+        {
+            for (usize i = 0; i < 128; ++i) values[i] = 0xFF;
+            for (u8 i = 0; i < 64; ++i) values[(u8)Impl::base64_encode_chars[i]] = i;
+        }
+    };
+    static constexpr Base64DecodeTable g_base64_decode_table;
+    static usize base64_decode_neon(u8* dst, usize dst_max_bytes, const c8* src, usize src_size)
+    {
+        const u8* table = g_base64_decode_table.values;
+        uint8x16x4_t lut_lo, lut_hi;
+        lut_lo.val[0] = vld1q_u8(table);
+        lut_lo.val[1] = vld1q_u8(table + 16);
+        lut_lo.val[2] = vld1q_u8(table + 32);
+        lut_lo.val[3] = vld1q_u8(table + 48);
+        lut_hi.val[0] = vld1q_u8(table + 64);
+        lut_hi.val[1] = vld1q_u8(table + 80);
+        lut_hi.val[2] = vld1q_u8(table + 96);
+        lut_hi.val[3] = vld1q_u8(table + 112);
+        const uint8x16_t offset = vdupq_n_u8(64);
+        const uint8x16_t high_bit = vdupq_n_u8(0x80);
+        usize i = 0;
+        usize o = 0;
+        // Deinterleaves 64 characters to 4 vectors and decodes them to 48 bytes.
+        while (src_size - i >= 64 && dst_max_bytes - o >= 48)
+        {
+            uint8x16x4_t in = vld4q_u8((const u8*)(src + i));
+            uint8x16x4_t d;
+            uint8x16_t error = vdupq_n_u8(0);
+            for (usize k = 0; k < 4; ++k)
+            {
+                // Characters that are not smaller than 128 are looked up as 0 by both lookups, so they are checked separately.
+                d.val[k] = vqtbx4q_u8(vqtbl4q_u8(lut_lo, in.val[k]), lut_hi, vsubq_u8(in.val[k], offset));
+                error = vorrq_u8(error, vorrq_u8(d.val[k], vandq_u8(in.val[k], high_bit)));
+            }
+            if (vmaxvq_u8(error) > 63) break;
+            uint8x16x3_t out;
+            out.val[0] = vorrq_u8(vshlq_n_u8(d.val[0], 2), vshrq_n_u8(d.val[1], 4));
+            out.val[1] = vorrq_u8(vshlq_n_u8(d.val[1], 4), vshrq_n_u8(d.val[2], 2));
+            out.val[2] = vorrq_u8(vshlq_n_u8(d.val[2], 6), d.val[3]);
+            vst3q_u8(dst + o, out);
+            i += 64;
+            o += 48;
+        }
+        return i;
+    }
+#else
+    static usize base64_encode_none(c8* dst, usize dst_max_chars, const u8* src, usize src_size)
+    {
+        return 0;
+    }
+    static usize base64_decode_none(u8* dst, usize dst_max_bytes, const c8* src, usize src_size)
+    {
+        return 0;
+    }
+#endif
+
+    // Implementations selected by `base64_init` based on instruction sets supported by the processor.
+#ifdef LUNA_BASE64_NEON
+    static usize(*g_base64_encode)(c8*, usize, const u8*, usize) = base64_encode_neon;
+    static usize(*g_base64_decode)(u8*, usize, const c8*, usize) = base64_decode_neon;
+#else
+    static usize(*g_base64_encode)(c8*, usize, const u8*, usize) = base64_encode_none;
+    static usize(*g_base64_decode)(u8*, usize, const c8*, usize) = base64_decode_none;
+#endif
+
+    void base64_init()
+    {
+#ifdef LUNA_TARGET_AVX2
+        if (is_cpu_feature_supported(CPUFeatureFlag::avx2))
+        {
+            g_base64_encode = base64_encode_avx2;
+            g_base64_decode = base64_decode_avx2;
+        }
+        else if (is_cpu_feature_supported(CPUFeatureFlag::ssse3))
+        {
+            g_base64_encode = base64_encode_ssse3;
+            g_base64_decode = base64_decode_ssse3;
+        }
+#endif
+    }
+
+    LUNA_RUNTIME_API usize base64_encode(c8* dst, usize dst_max_chars, const void* src, usize src_size_bytes)
+    {
+        const u8* data = (const u8*)src;
+        usize i = g_base64_encode(dst, dst_max_chars, data, src_size_bytes);
+        usize o = i / 3 * 4;
+        return o + base64_encode_scalar(dst + o, dst_max_chars - o, data + i, src_size_bytes - i);
+    }
+
+    LUNA_RUNTIME_API usize base64_decode(void* dst, usize dst_max_bytes, const c8* src, usize src_size_chars)
+    {
+        // The vectorized kernels must not read beyond the null terminator.
+        usize src_size = src_size_chars == USIZE_MAX ? strlen(src) : src_size_chars;
+        if (src_size_chars != USIZE_MAX)
+        {
+            const c8* end = (const c8*)memchr(src, 0, src_size);
+            if (end) src_size = end - src;
+        }
+        u8* data = (u8*)dst;
+        usize i = g_base64_decode(data, dst_max_bytes, src, src_size);
+        usize o = i / 4 * 3;
+        return o + base64_decode_scalar(data + o, dst_max_bytes - o, src + i, src_size - i);
+    }
+
+    LUNA_RUNTIME_API RV base64_encode_to_stream(IStream* stream, const void* src, usize src_size_bytes)
+    {
+        // Encodes 3072 bytes at a time, which produces 4096 characters.
+        constexpr usize CHUNK_SIZE = 3072;
+        c8 buf[base64_get_encoded_size(CHUNK_SIZE) + 1];
+        const u8* data = (const u8*)src;
+        lutry
+        {
+            while (src_size_bytes)
+            {
+                usize size = min(src_size_bytes, CHUNK_SIZE);
+                usize num_chars = base64_encode(buf, base64_get_encoded_size(CHUNK_SIZE) + 1, data, size);
+                luexp(stream->write(buf, num_chars * sizeof(c8)));
+                data += size;
+                src_size_bytes -= size;
+            }
+        }
+        lucatchret;
+        return ok;
+    }
 }
\ No newline at end of file
@@ -10,10 +10,19 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_RUNTIME_API LUNA_EXPORT
 #include "../Base85.hpp"
+#include "../CPU.hpp"
+
+#ifdef LUNA_TARGET_SSSE3
+#include <immintrin.h>
+#endif
+#if !defined(LUNA_DISABLE_SIMD) && defined(LUNA_PLATFORM_ARM64)
+#define LUNA_BASE85_NEON
+#include <arm_neon.h>
+#endif
 
 namespace Luna
 {
-    LUNA_RUNTIME_API usize base85_encode(c8* dst, usize dst_max_chars, const void* src, usize src_size_bytes)
+    static usize base85_encode_scalar(c8* dst, usize dst_max_chars, const void* src, usize src_size_bytes)
     {
         u8 str_tuple[5];
         u32 data_int;
@@ -48,14 +57,14 @@ namespace Luna
         dst[str_cur] = 0;
         return str_cur;
     }
-    LUNA_RUNTIME_API usize base85_decode(void* dst, usize dst_max_bytes, const c8* src, usize src_size_chars)
+
+    static usize base85_decode_scalar(void* dst, usize dst_max_bytes, const c8* src, usize src_size_chars)
     {
         u8 str_tuple[5];
         u32 data_int;
         usize data_cur{ 0 };
         usize str_cur{ 0 };
         u8* data_buf = reinterpret_cast<u8*>(dst);
-        if (src_size_chars == USIZE_MAX) src_size_chars = strlen(src);
         while (data_cur + 4 <= dst_max_bytes && str_cur + 5 <= src_size_chars)
         {
             const c8* src_begin = src + str_cur;
@@ -76,4 +85,228 @@ namespace Luna
         }
         return data_cur;
     }
+
+    // Vectorized kernels encode or decode the leading part of the data and return the number of source bytes or 
+    // characters processed, the remaining part is processed by the scalar implementation. Every 4 bytes are 
+    // converted to one 32-bit big-endian integer, and are encoded to 5 base-85 digits, so 16 bytes are processed 
+    // as 4 integers at a time.
+#ifdef LUNA_TARGET_SSSE3
+    // Divides unsigned 32-bit integers by 85 using multiplication: x / 85 == (x * 0xC0C0C0C1) >> 38 for all 32-bit x.
+    LUNA_TARGET_SSSE3 static inline __m128i base85_div85_ssse3(__m128i x)
+    {
+        const __m128i magic = _mm_set1_epi32((i32)0xC0C0C0C1);
+        __m128i even = _mm_srli_epi64(_mm_mul_epu32(x, magic), 38);
+        __m128i odd = _mm_srli_epi64(_mm_mul_epu32(_mm_srli_epi64(x, 32), magic), 38);
+        return _mm_or_si128(even, _mm_slli_epi64(odd, 32));
+    }
+    LUNA_TARGET_SSSE3 static inline __m128i base85_mul85_ssse3(__m128i x)
+    {
+        // x * 85 == x * 64 + x * 16 + x * 4 + x.
+        return _mm_add_epi32(_mm_add_epi32(_mm_slli_epi32(x, 6), _mm_slli_epi32(x, 4)), _mm_add_epi32(_mm_slli_epi32(x, 2), x));
+    }
+    LUNA_TARGET_SSSE3 static usize base85_encode_ssse3(c8* dst, usize dst_max_chars, const u8* src, usize src_size)
+    {
+        const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        // Interleaves the first 4 digits (`a`) and the last digit (`b`) of every integer.
+        const __m128i shuffle_a0 = _mm_setr_epi8(0, 1, 2, 3, -1, 4, 5, 6, 7, -1, 8, 9, 10, 11, -1, 12);
+        const __m128i shuffle_b0 = _mm_setr_epi8(-1, -1, -1, -1, 0, -1, -1, -1, -1, 4, -1, -1, -1, -1, 8, -1);
+        const __m128i shuffle_a1 = _mm_setr_epi8(13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i shuffle_b1 = _mm_setr_epi8(-1, -1, -1, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i offset = _mm_set1_epi8(33);
+        usize i = 0;
+        usize o = 0;
+        // Encodes 16 bytes to 20 characters.
+        while (src_size - i >= 16 && dst_max_chars - o > 20)
+        {
+            __m128i x = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(src + i)), bswap);
+            __m128i q1 = base85_div85_ssse3(x);
+            __m128i q2 = base85_div85_ssse3(q1);
+            __m128i q3 = base85_div85_ssse3(q2);
+            __m128i q4 = base85_div85_ssse3(q3);
+            __m128i d4 = _mm_sub_epi32(x, base85_mul85_ssse3(q1));
+            __m128i d3 = _mm_sub_epi32(q1, base85_mul85_ssse3(q2));
+            __m128i d2 = _mm_sub_epi32(q2, base85_mul85_ssse3(q3));
+            __m128i d1 = _mm_sub_epi32(q3, base85_mul85_ssse3(q4));
+            __m128i a = _mm_or_si128(_mm_or_si128(q4, _mm_slli_epi32(d1, 8)), _mm_or_si128(_mm_slli_epi32(d2, 16), _mm_slli_epi32(d3, 24)));
+            a = _mm_add_epi8(a, offset);
+            __m128i b = _mm_add_epi8(d4, offset);
+            __m128i out0 = _mm_or_si128(_mm_shuffle_epi8(a, shuffle_a0), _mm_shuffle_epi8(b, shuffle_b0));
+            __m128i out1 = _mm_or_si128(_mm_shuffle_epi8(a, shuffle_a1), _mm_shuffle_epi8(b, shuffle_b1));
+            _mm_storeu_si128((__m128i*)(dst + o), out0);
+            i32 tail = _mm_cvtsi128_si32(out1);
+            memcpy(dst + o + 16, &tail, 4);
+            i += 16;
+            o += 20;
+        }
+        return i;
+    }
+    LUNA_TARGET_SSSE3 static usize base85_decode_ssse3(u8* dst, usize dst_max_bytes, const c8* src, usize src_size)
+    {
+        const __m128i bswap = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+        // Gathers the first 4 digits (`a`) and the last digit (`b`) of every integer from 2 overlapped loads.
+        const __m128i shuffle_a0 = _mm_setr_epi8(0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, -1, -1, -1, -1);
+        const __m128i shuffle_a1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 11, 12, 13, 14);
+        const __m128i shuffle_b0 = _mm_setr_epi8(4, -1, -1, -1, 9, -1, -1, -1, 14, -1, -1, -1, -1, -1, -1, -1);
+        const __m128i shuffle_b1 = _mm_setr_epi8(-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 15, -1, -1, -1);
+        const __m128i offset = _mm_set1_epi8(33);
+        const __m128i byte_mask = _mm_set1_epi32(0xFF);
+        usize i = 0;
+        usize o = 0;
+        // Decodes 20 characters to 16 bytes.
+        while (src_size - i >= 20 && dst_max_bytes - o >= 16)
+        {
+            __m128i v0 = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(src + i)), offset);
+            __m128i v1 = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(src + i + 4)), offset);
+            __m128i a = _mm_or_si128(_mm_shuffle_epi8(v0, shuffle_a0), _mm_shuffle_epi8(v1, shuffle_a1));
+            __m128i b = _mm_or_si128(_mm_shuffle_epi8(v0, shuffle_b0), _mm_shuffle_epi8(v1, shuffle_b1));
+            __m128i x = _mm_and_si128(a, byte_mask);
+            x = _mm_add_epi32(base85_mul85_ssse3(x), _mm_and_si128(_mm_srli_epi32(a, 8), byte_mask));
+            x = _mm_add_epi32(base85_mul85_ssse3(x), _mm_and_si128(_mm_srli_epi32(a, 16), byte_mask));
+            x = _mm_add_epi32(base85_mul85_ssse3(x), _mm_srli_epi32(a, 24));
+            x = _mm_add_epi32(base85_mul85_ssse3(x), b);
+            _mm_storeu_si128((__m128i*)(dst + o), _mm_shuffle_epi8(x, bswap));
+            i += 20;
+            o += 16;
+        }
+        return i;
+    }
+#endif
+#ifdef LUNA_BASE85_NEON
+    static inline uint32x4_t base85_div85_neon(uint32x4_t x)
+    {
+        const uint32x2_t magic = vdup_n_u32(0xC0C0C0C1);
+        uint64x2_t lo = vshrq_n_u64(vmull_u32(vget_low_u32(x), magic), 38);
+        uint64x2_t hi = vshrq_n_u64(vmull_u32(vget_high_u32(x), magic), 38);
+        return vcombine_u32(vmovn_u64(lo), vmovn_u64(hi));
+    }
+    static usize base85_encode_neon(c8* dst, usize dst_max_chars, const u8* src, usize src_size)
+    {
+        // Indices into the table of the first 4 digits (`a`, 0-15) and the last digit (`b`, 16-31) of every integer.
+        alignas(16) static constexpr u8 shuffle0[16] = { 0, 1, 2, 3, 16, 4, 5, 6, 7, 20, 8, 9, 10, 11, 24, 12 };
+        alignas(16) static constexpr u8 shuffle1[16] = { 13, 14, 15, 28, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255 };
+        const uint8x16_t idx0 = vld1q_u8(shuffle0);
+        const uint8x16_t idx1 = vld1q_u8(shuffle1);
+        const uint8x16_t offset = vdupq_n_u8(33);
+        usize i = 0;
+        usize o = 0;
+        while (src_size - i >= 16 && dst_max_chars - o > 20)
+        {
+            uint32x4_t x = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(src + i)));
+            uint32x4_t q1 = base85_div85_neon(x);
+            uint32x4_t q2 = base85_div85_neon(q1);
+            uint32x4_t q3 = base85_div85_neon(q2);
+            uint32x4_t q4 = base85_div85_neon(q3);
+            uint32x4_t d4 = vmlsq_n_u32(x, q1, 85);
+            uint32x4_t d3 = vmlsq_n_u32(q1, q2, 85);
+            uint32x4_t d2 = vmlsq_n_u32(q2, q3, 85);
+            uint32x4_t d1 = vmlsq_n_u32(q3, q4, 85);
+            uint32x4_t a = vorrq_u32(vorrq_u32(q4, vshlq_n_u32(d1, 8)), vorrq_u32(vshlq_n_u32(d2, 16), vshlq_n_u32(d3, 24)));
+            uint8x16x2_t t;
+            t.val[0] = vaddq_u8(vreinterpretq_u8_u32(a), offset);
+            t.val[1] = vaddq_u8(vreinterpretq_u8_u32(d4), offset);
+            vst1q_u8((u8*)(dst + o), vqtbl2q_u8(t, idx0));
+            u32 tail = vgetq_lane_u32(vreinterpretq_u32_u8(vqtbl2q_u8(t, idx1)), 0);
+            memcpy(dst + o + 16, &tail, 4);
+            i += 16;
+            o += 20;
+        }
+        return i;
+    }
+    static usize base85_decode_neon(u8* dst, usize dst_max_bytes, const c8* src, usize src_size)
+    {
+        // Indices into 2 overlapped loads (0-15 and 16-31) of the first 4 digits (`a`) and the last digit (`b`) of every integer.
+        alignas(16) static constexpr u8 shuffle_a[16] = { 0, 1, 2, 3, 5, 6, 7, 8, 10, 11, 12, 13, 27, 28, 29, 30 };
+        alignas(16) static constexpr u8 shuffle_b[16] = { 4, 255, 255, 255, 9, 255, 255, 255, 14, 255, 255, 255, 31, 255, 255, 255 };
+        const uint8x16_t idx_a = vld1q_u8(shuffle_a);
+        const uint8x16_t idx_b = vld1q_u8(shuffle_b);
+        const uint8x16_t offset = vdupq_n_u8(33);
+        const uint32x4_t byte_mask = vdupq_n_u32(0xFF);
+        usize i = 0;
+        usize o = 0;
+        while (src_size - i >= 20 && dst_max_bytes - o >= 16)
+        {
+            uint8x16x2_t t;
+            t.val[0] = vsubq_u8(vld1q_u8((const u8*)(src + i)), offset);
+            t.val[1] = vsubq_u8(vld1q_u8((const u8*)(src + i + 4)), offset);
+            uint32x4_t a = vreinterpretq_u32_u8(vqtbl2q_u8(t, idx_a));
+            uint32x4_t b = vreinterpretq_u32_u8(vqtbl2q_u8(t, idx_b));
+            uint32x4_t x = vandq_u32(a, byte_mask);
+            x = vmlaq_n_u32(vandq_u32(vshrq_n_u32(a, 8), byte_mask), x, 85);
+            x = vmlaq_n_u32(vandq_u32(vshrq_n_u32(a, 16), byte_mask), x, 85);
+            x = vmlaq_n_u32(vshrq_n_u32(a, 24), x, 85);
+            x = vmlaq_n_u32(b, x, 85);
+            vst1q_u8(dst + o, vrev32q_u8(vreinterpretq_u8_u32(x)));
+            i += 20;
+            o += 16;
+        }
+        return i;
+    }
+#else
+    static usize base85_encode_none(c8* dst, usize dst_max_chars, const u8* src, usize src_size)
+    {
+        return 0;
+    }
+    static usize base85_decode_none(u8* dst, usize dst_max_bytes, const c8* src, usize src_size)
+    {
+        return 0;
+    }
+#endif
+
+    // Implementations selected by `base85_init` based on instruction sets supported by the processor.
+#ifdef LUNA_BASE85_NEON
+    static usize(*g_base85_encode)(c8*, usize, const u8*, usize) = base85_encode_neon;
+    static usize(*g_base85_decode)(u8*, usize, const c8*, usize) = base85_decode_neon;
+#else
+    static usize(*g_base85_encode)(c8*, usize, const u8*, usize) = base85_encode_none;
+    static usize(*g_base85_decode)(u8*, usize, const c8*, usize) = base85_decode_none;
+#endif
+
+    void base85_init()
+    {
+#ifdef LUNA_TARGET_SSSE3
+        if (is_cpu_feature_supported(CPUFeatureFlag::ssse3))
+        {
+            g_base85_encode = base85_encode_ssse3;
+            g_base85_decode = base85_decode_ssse3;
+        }
+#endif
+    }
+
+    LUNA_RUNTIME_API usize base85_encode(c8* dst, usize dst_max_chars, const void* src, usize src_size_bytes)
+    {
+        const u8* data = (const u8*)src;
+        usize i = g_base85_encode(dst, dst_max_chars, data, src_size_bytes);
+        usize o = base85_get_encoded_size(i);
+        return o + base85_encode_scalar(dst + o, dst_max_chars - o, data + i, src_size_bytes - i);
+    }
+
+    LUNA_RUNTIME_API usize base85_decode(void* dst, usize dst_max_bytes, const c8* src, usize src_size_chars)
+    {
+        if (src_size_chars == USIZE_MAX) src_size_chars = strlen(src);
+        u8* data = (u8*)dst;
+        usize i = g_base85_decode(data, dst_max_bytes, src, src_size_chars);
+        usize o = base85_get_decoded_size(i);
+        return o + base85_decode_scalar(data + o, dst_max_bytes - o, src + i, src_size_chars - i);
+    }
+
+    LUNA_RUNTIME_API RV base85_encode_to_stream(IStream* stream, const void* src, usize src_size_bytes)
+    {
+        // Encodes 4096 bytes at a time, which produces 5120 characters.
+        constexpr usize CHUNK_SIZE = 4096;
+        c8 buf[base85_get_encoded_size(CHUNK_SIZE) + 1];
+        const u8* data = (const u8*)src;
+        lutry
+        {
+            while (src_size_bytes)
+            {
+                usize size = min(src_size_bytes, CHUNK_SIZE);
+                usize num_chars = base85_encode(buf, base85_get_encoded_size(CHUNK_SIZE) + 1, data, size);
+                luexp(stream->write(buf, num_chars * sizeof(c8)));
+                data += size;
+                src_size_bytes -= size;
+            }
+        }
+        lucatchret;
+        return ok;
+    }
 }
\ No newline at end of file
@@ -0,0 +1,431 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Batch.cpp
+* @author JXMaster
+* @date 2024/5/5
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "../Math/Batch.hpp"
+#include "../Math/SimdTransform.hpp"
+#include "../CPU.hpp"
+
+#ifdef LUNA_TARGET_AVX2
+#include <immintrin.h>
+#endif
+
+namespace Luna
+{
+#ifdef LUNA_SIMD
+    namespace Simd
+    {
+        static inline float4 LUNA_SIMD_CALL load_f3u(const Float3U& v, f32 w)
+        {
+            return set_f4(v.x, v.y, v.z, w);
+        }
+        static inline void LUNA_SIMD_CALL store_f3u(Float3U& dst, float4 v)
+        {
+            alignas(16) f32 buf[4];
+            store_f4(buf, v);
+            dst = Float3U(buf[0], buf[1], buf[2]);
+        }
+        static inline float4 LUNA_SIMD_CALL abs_f4(float4 v)
+        {
+            return max_f4(v, sub_f4(setzero_f4(), v));
+        }
+    }
+#endif
+    static void transform_points_generic(const Float4x4& m, const Float3U* src, Float3U* dst, usize count)
+    {
+#ifdef LUNA_SIMD
+        using namespace Simd;
+        float4 r0 = load_f4(m.r[0].m);
+        float4 r1 = load_f4(m.r[1].m);
+        float4 r2 = load_f4(m.r[2].m);
+        float4 r3 = load_f4(m.r[3].m);
+        for (usize i = 0; i < count; ++i)
+        {
+            float4 r = muladd_f4(dup_f4(src[i].x), r0, r3);
+            r = muladd_f4(dup_f4(src[i].y), r1, r);
+            r = muladd_f4(dup_f4(src[i].z), r2, r);
+            store_f3u(dst[i], r);
+        }
+#else
+        for (usize i = 0; i < count; ++i)
+        {
+            Float3U p = src[i];
+            dst[i] = Float3U(
+                p.x * m.r[0].x + p.y * m.r[1].x + p.z * m.r[2].x + m.r[3].x,
+                p.x * m.r[0].y + p.y * m.r[1].y + p.z * m.r[2].y + m.r[3].y,
+                p.x * m.r[0].z + p.y * m.r[1].z + p.z * m.r[2].z + m.r[3].z);
+        }
+#endif
+    }
+    static void transform_directions_generic(const Float4x4& m, const Float3U* src, Float3U* dst, usize count)
+    {
+#ifdef LUNA_SIMD
+        using namespace Simd;
+        float4 r0 = load_f4(m.r[0].m);
+        float4 r1 = load_f4(m.r[1].m);
+        float4 r2 = load_f4(m.r[2].m);
+        for (usize i = 0; i < count; ++i)
+        {
+            float4 r = mul_f4(dup_f4(src[i].x), r0);
+            r = muladd_f4(dup_f4(src[i].y), r1, r);
+            r = muladd_f4(dup_f4(src[i].z), r2, r);
+            store_f3u(dst[i], r);
+        }
+#else
+        for (usize i = 0; i < count; ++i)
+        {
+            Float3U p = src[i];
+            dst[i] = Float3U(
+                p.x * m.r[0].x + p.y * m.r[1].x + p.z * m.r[2].x,
+                p.x * m.r[0].y + p.y * m.r[1].y + p.z * m.r[2].y,
+                p.x * m.r[0].z + p.y * m.r[1].z + p.z * m.r[2].z);
+        }
+#endif
+    }
+    static void mul_matrices_generic(const Float4x4* a, const Float4x4* b, Float4x4* dst, usize count)
+    {
+#ifdef LUNA_SIMD
+        using namespace Simd;
+        for (usize i = 0; i < count; ++i)
+        {
+            float4x4 r = matmul_f4x4(load_f4x4(a[i].r[0].m), load_f4x4(b[i].r[0].m));
+            store_f4x4(dst[i].r[0].m, r);
+        }
+#else
+        for (usize i = 0; i < count; ++i)
+        {
+            dst[i] = mul(a[i], b[i]);
+        }
+#endif
+    }
+    static void mul_matrices_one_generic(const Float4x4* a, const Float4x4& b, Float4x4* dst, usize count)
+    {
+#ifdef LUNA_SIMD
+        using namespace Simd;
+        // The right-hand matrix is loaded only once.
+        float4x4 mb = load_f4x4(b.r[0].m);
+        for (usize i = 0; i < count; ++i)
+        {
+            float4x4 r = matmul_f4x4(load_f4x4(a[i].r[0].m), mb);
+            store_f4x4(dst[i].r[0].m, r);
+        }
+#else
+        for (usize i = 0; i < count; ++i)
+        {
+            dst[i] = mul(a[i], b);
+        }
+#endif
+    }
+    LUNA_RUNTIME_API void make_affine_matrices(const Float3U* translations, const Float4U* rotations, const Float3U* scalings, Float4x4* dst, usize count)
+    {
+#ifdef LUNA_SIMD
+        using namespace Simd;
+        for (usize i = 0; i < count; ++i)
+        {
+            float4 t = load_f3u(translations[i], 1.0f);
+            float4 r = set_f4(rotations[i].x, rotations[i].y, rotations[i].z, rotations[i].w);
+            float4 s = load_f3u(scalings[i], 0.0f);
+            store_f4x4(dst[i].r[0].m, transform3d_f4x4(t, r, s));
+        }
+#else
+        for (usize i = 0; i < count; ++i)
+        {
+            dst[i] = AffineMatrix::make(Float3(translations[i]), Float4(rotations[i]), Float3(scalings[i]));
+        }
+#endif
+    }
+    LUNA_RUNTIME_API void transform_aabbs(const Float4x4* matrices, const Float3U* mins, const Float3U* maxs, Float3U* dst_mins, Float3U* dst_maxs, usize count)
+    {
+        // Transforms the center and the extent of every box separately, the extent of the 
+        // transformed box is the sum of absolute values of the transformed axes.
+#ifdef LUNA_SIMD
+        using namespace Simd;
+        float4 half = dup_f4(0.5f);
+        for (usize i = 0; i < count; ++i)
+        {
+            const Float4x4& m = matrices[i];
+            float4 r0 = load_f4(m.r[0].m);
+            float4 r1 = load_f4(m.r[1].m);
+            float4 r2 = load_f4(m.r[2].m);
+            float4 r3 = load_f4(m.r[3].m);
+            float4 bmin = load_f3u(mins[i], 0.0f);
+            float4 bmax = load_f3u(maxs[i], 0.0f);
+            float4 center = mul_f4(add_f4(bmin, bmax), half);
+            float4 extent = mul_f4(sub_f4(bmax, bmin), half);
+            float4 c = muladd_f4(dupx_f4(center), r0, r3);
+            c = muladd_f4(dupy_f4(center), r1, c);
+            c = muladd_f4(dupz_f4(center), r2, c);
+            float4 e = mul_f4(dupx_f4(extent), abs_f4(r0));
+            e = muladd_f4(dupy_f4(extent), abs_f4(r1), e);
+            e = muladd_f4(dupz_f4(extent), abs_f4(r2), e);
+            store_f3u(dst_mins[i], sub_f4(c, e));
+            store_f3u(dst_maxs[i], add_f4(c, e));
+        }
+#else
+        for (usize i = 0; i < count; ++i)
+        {
+            const Float4x4& m = matrices[i];
+            Float3 center = (Float3(mins[i]) + Float3(maxs[i])) * 0.5f;
+            Float3 extent = (Float3(maxs[i]) - Float3(mins[i])) * 0.5f;
+            Float3 c = m.r[3].xyz() + m.r[0].xyz() * center.x + m.r[1].xyz() * center.y + m.r[2].xyz() * center.z;
+            Float3 e;
+            for (u32 j = 0; j < 3; ++j)
+            {
+                e.m[j] = fabsf(m.r[0].m[j]) * extent.x + fabsf(m.r[1].m[j]) * extent.y + fabsf(m.r[2].m[j]) * extent.z;
+            }
+            dst_mins[i] = c - e;
+            dst_maxs[i] = c + e;
+        }
+#endif
+    }
+    LUNA_RUNTIME_API Frustum make_frustum(const Float4x4& view_to_proj)
+    {
+        // Points are transformed by `mul(p, view_to_proj)`, so every clip space component is the dot product 
+        // of the point and one column of the matrix.
+        const Float4x4& m = view_to_proj;
+        Float4 c0(m.r[0].x, m.r[1].x, m.r[2].x, m.r[3].x);
+        Float4 c1(m.r[0].y, m.r[1].y, m.r[2].y, m.r[3].y);
+        Float4 c2(m.r[0].z, m.r[1].z, m.r[2].z, m.r[3].z);
+        Float4 c3(m.r[0].w, m.r[1].w, m.r[2].w, m.r[3].w);
+        Frustum f;
+        f.planes[0] = c3 + c0;    // -w <= x
+        f.planes[1] = c3 - c0;    // x <= w
+        f.planes[2] = c3 + c1;    // -w <= y
+        f.planes[3] = c3 - c1;    // y <= w
+        f.planes[4] = c2;         // 0 <= z
+        f.planes[5] = c3 - c2;    // z <= w
+        return f;
+    }
+    static usize test_aabbs_in_frustum_generic(const Frustum& frustum, const Float3U* mins, const Float3U* maxs, u8* results, usize count)
+    {
+        // For every plane, only the box corner that is farthest along the plane normal needs to be tested.
+        usize num_visible = 0;
+        usize i = 0;
+#ifdef LUNA_SIMD
+        using namespace Simd;
+        // Tests 4 boxes at a time, with box components stored in SoA layout.
+        float4 zero = setzero_f4();
+        for (; i + 4 <= count; i += 4)
+        {
+            const Float3U* mn = mins + i;
+            const Float3U* mx = maxs + i;
+            float4 min_x = set_f4(mn[0].x, mn[1].x, mn[2].x, mn[3].x);
+            float4 min_y = set_f4(mn[0].y, mn[1].y, mn[2].y, mn[3].y);
+            float4 min_z = set_f4(mn[0].z, mn[1].z, mn[2].z, mn[3].z);
+            float4 max_x = set_f4(mx[0].x, mx[1].x, mx[2].x, mx[3].x);
+            float4 max_y = set_f4(mx[0].y, mx[1].y, mx[2].y, mx[3].y);
+            float4 max_z = set_f4(mx[0].z, mx[1].z, mx[2].z, mx[3].z);
+            int4 outside = castf_i4(zero);
+            for (u32 p = 0; p < 6; ++p)
+            {
+                const Float4& plane = frustum.planes[p];
+                float4 d = dup_f4(plane.w);
+                d = muladd_f4(plane.x >= 0.0f ? max_x : min_x, dup_f4(plane.x), d);
+                d = muladd_f4(plane.y >= 0.0f ? max_y : min_y, dup_f4(plane.y), d);
+                d = muladd_f4(plane.z >= 0.0f ? max_z : min_z, dup_f4(plane.z), d);
+                outside = or_i4(outside, cmplt_f4(d, zero));
+            }
+            i32 mask = maskint_i4(outside);
+            for (u32 k = 0; k < 4; ++k)
+            {
+                u8 visible = (mask & (1 << k)) ? 0 : 1;
+                results[i + k] = visible;
+                num_visible += visible;
+            }
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            u8 visible = 1;
+            for (u32 p = 0; p < 6; ++p)
+            {
+                const Float4& plane = frustum.planes[p];
+                f32 d = plane.w +
+                    plane.x * (plane.x >= 0.0f ? maxs[i].x : mins[i].x) +
+                    plane.y * (plane.y >= 0.0f ? maxs[i].y : mins[i].y) +
+                    plane.z * (plane.z >= 0.0f ? maxs[i].z : mins[i].z);
+                if (d < 0.0f)
+                {
+                    visible = 0;
+                    break;
+                }
+            }
+            results[i] = visible;
+            num_visible += visible;
+        }
+        return num_visible;
+    }
+
+#ifdef LUNA_TARGET_AVX2
+    // Variants that process 8 elements at a time with AVX2 and FMA3 instructions. These are selected 
+    // in `batch_init` only if the processor supports them, so that binaries built for the baseline 
+    // instruction set still use wide registers on newer processors.
+    LUNA_TARGET_AVX2 static void transform_vectors_avx2(const Float4x4& m, const Float3U* src, Float3U* dst, usize count, f32 w)
+    {
+        // Loads 8 vectors in SoA layout by gathering components with a stride of 3 floats.
+        const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+        __m256 m00 = _mm256_set1_ps(m.r[0].x), m01 = _mm256_set1_ps(m.r[0].y), m02 = _mm256_set1_ps(m.r[0].z);
+        __m256 m10 = _mm256_set1_ps(m.r[1].x), m11 = _mm256_set1_ps(m.r[1].y), m12 = _mm256_set1_ps(m.r[1].z);
+        __m256 m20 = _mm256_set1_ps(m.r[2].x), m21 = _mm256_set1_ps(m.r[2].y), m22 = _mm256_set1_ps(m.r[2].z);
+        __m256 m30 = _mm256_set1_ps(m.r[3].x * w), m31 = _mm256_set1_ps(m.r[3].y * w), m32 = _mm256_set1_ps(m.r[3].z * w);
+        usize i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const f32* p = &src[i].x;
+            __m256 x = _mm256_i32gather_ps(p, stride, 4);
+            __m256 y = _mm256_i32gather_ps(p + 1, stride, 4);
+            __m256 z = _mm256_i32gather_ps(p + 2, stride, 4);
+            __m256 rx = _mm256_fmadd_ps(z, m20, _mm256_fmadd_ps(y, m10, _mm256_fmadd_ps(x, m00, m30)));
+            __m256 ry = _mm256_fmadd_ps(z, m21, _mm256_fmadd_ps(y, m11, _mm256_fmadd_ps(x, m01, m31)));
+            __m256 rz = _mm256_fmadd_ps(z, m22, _mm256_fmadd_ps(y, m12, _mm256_fmadd_ps(x, m02, m32)));
+            alignas(32) f32 ox[8], oy[8], oz[8];
+            _mm256_store_ps(ox, rx);
+            _mm256_store_ps(oy, ry);
+            _mm256_store_ps(oz, rz);
+            for (u32 k = 0; k < 8; ++k)
+            {
+                dst[i + k] = Float3U(ox[k], oy[k], oz[k]);
+            }
+        }
+        if (i < count)
+        {
+            if (w != 0.0f) transform_points_generic(m, src + i, dst + i, count - i);
+            else transform_directions_generic(m, src + i, dst + i, count - i);
+        }
+    }
+    LUNA_TARGET_AVX2 static void transform_points_avx2(const Float4x4& m, const Float3U* src, Float3U* dst, usize count)
+    {
+        transform_vectors_avx2(m, src, dst, count, 1.0f);
+    }
+    LUNA_TARGET_AVX2 static void transform_directions_avx2(const Float4x4& m, const Float3U* src, Float3U* dst, usize count)
+    {
+        transform_vectors_avx2(m, src, dst, count, 0.0f);
+    }
+    // Multiplies two rows of `a` at a time. `b` must be loaded before `dst` is written, since they may alias.
+    LUNA_TARGET_AVX2 static inline void mul_matrix_avx2(const Float4x4& a, __m256 b0, __m256 b1, __m256 b2, __m256 b3, Float4x4& dst)
+    {
+        __m256 a01 = _mm256_loadu_ps(a.r[0].m);
+        __m256 a23 = _mm256_loadu_ps(a.r[2].m);
+        __m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        __m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(1, 1, 1, 1)), b1, r01);
+        r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(1, 1, 1, 1)), b1, r23);
+        r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(2, 2, 2, 2)), b2, r01);
+        r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(2, 2, 2, 2)), b2, r23);
+        r01 = _mm256_fmadd_ps(_mm256_shuffle_ps(a01, a01, _MM_SHUFFLE(3, 3, 3, 3)), b3, r01);
+        r23 = _mm256_fmadd_ps(_mm256_shuffle_ps(a23, a23, _MM_SHUFFLE(3, 3, 3, 3)), b3, r23);
+        _mm256_storeu_ps(dst.r[0].m, r01);
+        _mm256_storeu_ps(dst.r[2].m, r23);
+    }
+    LUNA_TARGET_AVX2 static void mul_matrices_avx2(const Float4x4* a, const Float4x4* b, Float4x4* dst, usize count)
+    {
+        for (usize i = 0; i < count; ++i)
+        {
+            __m256 b0 = _mm256_broadcast_ps((const __m128*)b[i].r[0].m);
+            __m256 b1 = _mm256_broadcast_ps((const __m128*)b[i].r[1].m);
+            __m256 b2 = _mm256_broadcast_ps((const __m128*)b[i].r[2].m);
+            __m256 b3 = _mm256_broadcast_ps((const __m128*)b[i].r[3].m);
+            mul_matrix_avx2(a[i], b0, b1, b2, b3, dst[i]);
+        }
+    }
+    LUNA_TARGET_AVX2 static void mul_matrices_one_avx2(const Float4x4* a, const Float4x4& b, Float4x4* dst, usize count)
+    {
+        __m256 b0 = _mm256_broadcast_ps((const __m128*)b.r[0].m);
+        __m256 b1 = _mm256_broadcast_ps((const __m128*)b.r[1].m);
+        __m256 b2 = _mm256_broadcast_ps((const __m128*)b.r[2].m);
+        __m256 b3 = _mm256_broadcast_ps((const __m128*)b.r[3].m);
+        for (usize i = 0; i < count; ++i)
+        {
+            mul_matrix_avx2(a[i], b0, b1, b2, b3, dst[i]);
+        }
+    }
+    LUNA_TARGET_AVX2 static usize test_aabbs_in_frustum_avx2(const Frustum& frustum, const Float3U* mins, const Float3U* maxs, u8* results, usize count)
+    {
+        const __m256i stride = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+        __m256 zero = _mm256_setzero_ps();
+        usize num_visible = 0;
+        usize i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            const f32* mn = &mins[i].x;
+            const f32* mx = &maxs[i].x;
+            __m256 min_x = _mm256_i32gather_ps(mn, stride, 4);
+            __m256 min_y = _mm256_i32gather_ps(mn + 1, stride, 4);
+            __m256 min_z = _mm256_i32gather_ps(mn + 2, stride, 4);
+            __m256 max_x = _mm256_i32gather_ps(mx, stride, 4);
+            __m256 max_y = _mm256_i32gather_ps(mx + 1, stride, 4);
+            __m256 max_z = _mm256_i32gather_ps(mx + 2, stride, 4);
+            __m256 outside = zero;
+            for (u32 p = 0; p < 6; ++p)
+            {
+                const Float4& plane = frustum.planes[p];
+                __m256 d = _mm256_set1_ps(plane.w);
+                d = _mm256_fmadd_ps(plane.x >= 0.0f ? max_x : min_x, _mm256_set1_ps(plane.x), d);
+                d = _mm256_fmadd_ps(plane.y >= 0.0f ? max_y : min_y, _mm256_set1_ps(plane.y), d);
+                d = _mm256_fmadd_ps(plane.z >= 0.0f ? max_z : min_z, _mm256_set1_ps(plane.z), d);
+                outside = _mm256_or_ps(outside, _mm256_cmp_ps(d, zero, _CMP_LT_OQ));
+            }
+            i32 mask = _mm256_movemask_ps(outside);
+            for (u32 k = 0; k < 8; ++k)
+            {
+                u8 visible = (mask & (1 << k)) ? 0 : 1;
+                results[i + k] = visible;
+                num_visible += visible;
+            }
+        }
+        if (i < count)
+        {
+            num_visible += test_aabbs_in_frustum_generic(frustum, mins + i, maxs + i, results + i, count - i);
+        }
+        return num_visible;
+    }
+#endif
+
+    // Implementations selected by `batch_init` based on instruction sets supported by the processor.
+    static void(*g_transform_points)(const Float4x4&, const Float3U*, Float3U*, usize) = transform_points_generic;
+    static void(*g_transform_directions)(const Float4x4&, const Float3U*, Float3U*, usize) = transform_directions_generic;
+    static void(*g_mul_matrices)(const Float4x4*, const Float4x4*, Float4x4*, usize) = mul_matrices_generic;
+    static void(*g_mul_matrices_one)(const Float4x4*, const Float4x4&, Float4x4*, usize) = mul_matrices_one_generic;
+    static usize(*g_test_aabbs_in_frustum)(const Frustum&, const Float3U*, const Float3U*, u8*, usize) = test_aabbs_in_frustum_generic;
+
+    void batch_init()
+    {
+#ifdef LUNA_TARGET_AVX2
+        if (is_cpu_feature_supported(CPUFeatureFlag::avx2 | CPUFeatureFlag::fma3))
+        {
+            g_transform_points = transform_points_avx2;
+            g_transform_directions = transform_directions_avx2;
+            g_mul_matrices = mul_matrices_avx2;
+            g_mul_matrices_one = mul_matrices_one_avx2;
+            g_test_aabbs_in_frustum = test_aabbs_in_frustum_avx2;
+        }
+#endif
+    }
+    LUNA_RUNTIME_API void transform_points(const Float4x4& m, const Float3U* src, Float3U* dst, usize count)
+    {
+        g_transform_points(m, src, dst, count);
+    }
+    LUNA_RUNTIME_API void transform_directions(const Float4x4& m, const Float3U* src, Float3U* dst, usize count)
+    {
+        g_transform_directions(m, src, dst, count);
+    }
+    LUNA_RUNTIME_API void mul_matrices(const Float4x4* a, const Float4x4* b, Float4x4* dst, usize count)
+    {
+        g_mul_matrices(a, b, dst, count);
+    }
+    LUNA_RUNTIME_API void mul_matrices(const Float4x4* a, const Float4x4& b, Float4x4* dst, usize count)
+    {
+        g_mul_matrices_one(a, b, dst, count);
+    }
+    LUNA_RUNTIME_API usize test_aabbs_in_frustum(const Frustum& frustum, const Float3U* mins, const Float3U* maxs, u8* results, usize count)
+    {
+        return g_test_aabbs_in_frustum(frustum, mins, maxs, results, count);
+    }
+}
@@ -360,77 +360,39 @@ namespace Luna
         lucatchret;
         return ok;
     }
-    inline usize robinhood_insert(usize h, typeinfo_t value_type, usize value_size, usize value_alignment, void* src_buf, void* value_buf, RobinHoodHashing::ControlBlock* cb_buf, usize buffer_size)
+    //! Inserts one value to one free slot of the table and relocates the value to the slot.
+    inline void swiss_insert(usize h, typeinfo_t value_type, usize value_size, void* src_buf, void* value_buf, u8* ctrl, usize buffer_size)
     {
-        luassert(h != RobinHoodHashing::EMPTY_SLOT && !RobinHoodHashing::is_tombstone(h));
-        // Extract current data.
-        usize pos = h % buffer_size;
-        usize dist = 0;
-        usize ret_pos = USIZE_MAX;
-        void* temp_v = alloca(value_size + value_alignment);
-        temp_v = (void*)align_upper((usize)temp_v, value_alignment);
-        while (true)
-        {
-            if (cb_buf[pos].m_hash == RobinHoodHashing::EMPTY_SLOT)
-            {
-                cb_buf[pos].m_hash = h;
-                void* dst = (void*)((usize)value_buf + pos * value_size);
-                relocate_type(value_type, dst, src_buf);
-                if (ret_pos == USIZE_MAX) ret_pos = pos;
-                break;
-            }
-            usize existing_dist = RobinHoodHashing::probe_distance(cb_buf[pos].m_hash, pos, buffer_size);
-            if ((existing_dist <= dist) && RobinHoodHashing::is_tombstone(cb_buf[pos].m_hash))
-            {
-                cb_buf[pos].m_hash = h;
-                void* dst = (void*)((usize)value_buf + pos * value_size);
-                relocate_type(value_type, dst, src_buf);
-                if (ret_pos == USIZE_MAX) ret_pos = pos;
-                break;
-            }
-            if (existing_dist < dist)
-            {
-                usize temp_h = cb_buf[pos].m_hash;
-                cb_buf[pos].m_hash = h;
-                h = temp_h;
-                void* dst = (void*)((usize)value_buf + pos * value_size);
-                relocate_type(value_type, temp_v, dst);
-                relocate_type(value_type, dst, src_buf);
-                relocate_type(value_type, src_buf, temp_v);
-                dist = existing_dist;
-                if (ret_pos == USIZE_MAX) ret_pos = pos;
-            }
-            ++pos;
-            ++dist;
-            if (pos == buffer_size)
-                pos = 0;
-        }
-        return ret_pos;
+        usize pos = SwissHashing::find_insert_slot(ctrl, buffer_size, h);
+        ctrl[pos] = SwissHashing::h2(h);
+        void* dst = (void*)((usize)value_buf + pos * value_size);
+        relocate_type(value_type, dst, src_buf);
     }
     struct HashTableData
     {
         void* m_value_buffer;
-        RobinHoodHashing::ControlBlock* m_cb_buffer;
+        u8* m_ctrl;
         usize m_buffer_size;
         usize m_size;
+        usize m_num_deleted;
         f32 m_max_load_factor;
 
         void clear_and_free_table(typeinfo_t value_type)
         {
-            for (usize i = 0; i < m_buffer_size; ++i)
-            {
-                usize h = m_cb_buffer[i].m_hash;
-                if (h == RobinHoodHashing::EMPTY_SLOT || RobinHoodHashing::is_tombstone(h)) continue;
-                destruct_type(value_type, (void*)((usize)m_value_buffer + i * get_type_size(value_type)));
-            }
             if (m_value_buffer)
             {
-                memfree(m_value_buffer);
-                memfree(m_cb_buffer);
+                for (usize i = 0; i < m_buffer_size; ++i)
+                {
+                    if (!SwissHashing::is_full(m_ctrl[i])) continue;
+                    destruct_type(value_type, (void*)((usize)m_value_buffer + i * get_type_size(value_type)));
+                }
+                memfree(m_value_buffer, get_type_alignment(value_type));
+                memfree(m_ctrl);
                 m_value_buffer = nullptr;
             }
             m_buffer_size = 0;
             m_size = 0;
+            m_num_deleted = 0;
         }
         f32 load_factor()
         {
@@ -440,46 +402,48 @@ namespace Luna
             }
             return (f32)m_size / (f32)m_buffer_size;
         }
-        void rehash(typeinfo_t value_type, usize new_buffer_size)
+        void rehash(typeinfo_t key_type, typeinfo_t value_type, usize new_buffer_size)
         {
-            new_buffer_size = max(max(new_buffer_size, (usize)(ceilf((f32)m_size / m_max_load_factor))), RobinHoodHashing::INITIAL_BUFFER_SIZE);
-            if (new_buffer_size == m_buffer_size)
+            new_buffer_size = max(max(new_buffer_size, (usize)(ceilf((f32)m_size / m_max_load_factor))), SwissHashing::INITIAL_BUFFER_SIZE);
+            if (new_buffer_size == m_buffer_size && !m_num_deleted)
             {
                 return;
             }
             usize value_size = get_type_size(value_type);
             usize value_alignment = get_type_alignment(value_type);
             void* value_buf = memalloc(new_buffer_size * value_size, value_alignment);
-            RobinHoodHashing::ControlBlock* cb_buf = (RobinHoodHashing::ControlBlock*)memalloc(new_buffer_size * sizeof(RobinHoodHashing::ControlBlock));
-            memzero(cb_buf, new_buffer_size * sizeof(RobinHoodHashing::ControlBlock));
+            u8* ctrl = (u8*)memalloc(SwissHashing::ctrl_size(new_buffer_size));
+            SwissHashing::init_ctrl(ctrl, new_buffer_size);
             for (usize i = 0; i < m_buffer_size; ++i)
             {
-                usize h = m_cb_buffer[i].m_hash;
-                if (h == RobinHoodHashing::EMPTY_SLOT || RobinHoodHashing::is_tombstone(h)) continue;
+                if (!SwissHashing::is_full(m_ctrl[i])) continue;
                 void* src = (void*)((usize)m_value_buffer + i * value_size);
-                robinhood_insert(h, value_type, value_size, value_alignment, src, value_buf, cb_buf, new_buffer_size);
+                // The key is always the first member of the value.
+                usize h = SwissHashing::mix_hash(hash_type(key_type, src));
+                swiss_insert(h, value_type, value_size, src, value_buf, ctrl, new_buffer_size);
             }
             if (m_value_buffer)
             {
-                memfree(m_value_buffer);
-                memfree(m_cb_buffer);
+                memfree(m_value_buffer, value_alignment);
+                memfree(m_ctrl);
                 m_value_buffer = nullptr;
             }
             m_value_buffer = value_buf;
-            m_cb_buffer = cb_buf;
+            m_ctrl = ctrl;
             m_buffer_size = new_buffer_size;
+            m_num_deleted = 0;
         }
         usize capacity() const
         {
             return (usize)floorf(m_max_load_factor * m_buffer_size);
         }
-        void increment_reserve(typeinfo_t value_type, usize new_cap)
+        void increment_reserve(typeinfo_t key_type, typeinfo_t value_type, usize new_cap)
         {
             usize current_capacity = capacity();
-            if (new_cap > current_capacity)
+            if (new_cap + m_num_deleted > current_capacity)
             {
                 new_cap = max(new_cap, current_capacity * 2);
-                rehash(value_type, (usize)ceilf((f32)new_cap / m_max_load_factor));
+                rehash(key_type, value_type, (usize)ceilf((f32)new_cap / m_max_load_factor));
             }
         }
         R<Variant> do_serialize(typeinfo_t value_type) const
@@ -490,8 +454,7 @@ namespace Luna
             {
                 for (usize i = 0; i < m_buffer_size; ++i)
                 {
-                    usize h = m_cb_buffer[i].m_hash;
-                    if (h != RobinHoodHashing::EMPTY_SLOT && !RobinHoodHashing::is_tombstone(h))
+                    if (SwissHashing::is_full(m_ctrl[i]))
                     {
                         const void* v = (const void*)((usize)m_value_buffer + value_size * i);
                         lulet(var, serialize(value_type, v));
@@ -532,10 +495,11 @@ namespace Luna
     {
         HashTableData* d = (HashTableData*)inst;
         d->m_value_buffer = nullptr;
-        d->m_cb_buffer = nullptr;
+        d->m_ctrl = nullptr;
         d->m_buffer_size = 0;
         d->m_size = 0;
-        d->m_max_load_factor = RobinHoodHashing::INITIAL_LOAD_FACTOR;
+        d->m_num_deleted = 0;
+        d->m_max_load_factor = SwissHashing::INITIAL_LOAD_FACTOR;
     }
     static void hashmap_dtor(typeinfo_t type, void* inst)
     {
@@ -553,27 +517,22 @@ namespace Luna
     inline void hashtable_copy_ctor(typeinfo_t value_type, HashTableData* dest, HashTableData* src)
     {
         dest->m_value_buffer = nullptr;
-        dest->m_cb_buffer = nullptr;
+        dest->m_ctrl = nullptr;
         dest->m_buffer_size = 0;
         dest->m_size = 0;
-        dest->m_max_load_factor = RobinHoodHashing::INITIAL_LOAD_FACTOR;
-        usize value_size = get_type_size(value_type);
+        dest->m_num_deleted = 0;
         dest->m_max_load_factor = src->m_max_load_factor;
-        if (dest->load_factor() > dest->m_max_load_factor)
-        {
-            dest->rehash(value_type, 0);
-        }
+        usize value_size = get_type_size(value_type);
         if (src->m_size)
         {
+            usize ctrl_size = SwissHashing::ctrl_size(src->m_buffer_size);
             dest->m_value_buffer = memalloc(src->m_buffer_size * value_size, get_type_alignment(value_type));
-            dest->m_cb_buffer = (RobinHoodHashing::ControlBlock*)memalloc(src->m_buffer_size * sizeof(RobinHoodHashing::ControlBlock));
-            memzero(dest->m_cb_buffer, src->m_buffer_size * sizeof(RobinHoodHashing::ControlBlock));
+            dest->m_ctrl = (u8*)memalloc(ctrl_size);
+            memcpy(dest->m_ctrl, src->m_ctrl, ctrl_size);
             dest->m_buffer_size = src->m_buffer_size;
             for (usize i = 0; i < src->m_buffer_size; ++i)
             {
-                usize h = src->m_cb_buffer[i].m_hash;
-                dest->m_cb_buffer[i].m_hash = h;
-                if (h != RobinHoodHashing::EMPTY_SLOT && !RobinHoodHashing::is_tombstone(h))
+                if (SwissHashing::is_full(src->m_ctrl[i]))
                 {
                     void* dest_buf = (void*)((usize)dest->m_value_buffer + i * value_size);
                     void* src_buf = (void*)((usize)src->m_value_buffer + i * value_size);
@@ -581,6 +540,7 @@ namespace Luna
                 }
             }
             dest->m_size = src->m_size;
+            dest->m_num_deleted = src->m_num_deleted;
         }
     }
     static void hashmap_copy_ctor(typeinfo_t type, void* dest, void* src)
@@ -600,8 +560,10 @@ namespace Luna
         HashTableData* srcd = (HashTableData*)src;
         memcpy(destd, srcd, sizeof(HashTableData));
         srcd->m_value_buffer = nullptr;
+        srcd->m_ctrl = nullptr;
         srcd->m_buffer_size = 0;
         srcd->m_size = 0;
+        srcd->m_num_deleted = 0;
     }
     static void hashmap_copy_assign(typeinfo_t type, void* dest, void* src)
     {
@@ -630,11 +592,6 @@ namespace Luna
         typeinfo_t value_type = make_hashmap_value_type(generic_arguments[0], generic_arguments[1]);
         return d->do_serialize(value_type);
     }
-    inline usize alter_hash(usize h)
-    {
-        if (h == RobinHoodHashing::EMPTY_SLOT) ++h;
-        return h & ~RobinHoodHashing::TOMBSTONE_BIT;
-    }
     static RV hashmap_deserialize(typeinfo_t type, void* inst, const Variant& data)
     {
         lutry
@@ -652,9 +609,9 @@ namespace Luna
                 construct_type(value_type, value_buffer);
                 luexp(deserialize(value_type, value_buffer, v));
                 // Extract key type.
-                usize h = alter_hash(hash_type(key_type, value_buffer));
-                d->increment_reserve(value_type, d->m_size + 1);
-                robinhood_insert(h, value_type, value_size, value_alignment, value_buffer, d->m_value_buffer, d->m_cb_buffer, d->m_buffer_size);
+                usize h = SwissHashing::mix_hash(hash_type(key_type, value_buffer));
+                d->increment_reserve(key_type, value_type, d->m_size + 1);
+                swiss_insert(h, value_type, value_size, value_buffer, d->m_value_buffer, d->m_ctrl, d->m_buffer_size);
                 ++d->m_size;
             }
         }
@@ -682,9 +639,9 @@ namespace Luna
                 construct_type(value_type, value_buffer);
                 luexp(deserialize(value_type, value_buffer, v));
                 // Extract key type.
-                usize h = alter_hash(hash_type(value_type, value_buffer));
-                d->increment_reserve(value_type, d->m_size + 1);
-                robinhood_insert(h, value_type, value_size, value_alignment, value_buffer, d->m_value_buffer, d->m_cb_buffer, d->m_buffer_size);
+                usize h = SwissHashing::mix_hash(hash_type(value_type, value_buffer));
+                d->increment_reserve(value_type, value_type, d->m_size + 1);
+                swiss_insert(h, value_type, value_size, value_buffer, d->m_value_buffer, d->m_ctrl, d->m_buffer_size);
                 ++d->m_size;
             }
         }
@@ -896,6 +853,8 @@ namespace Luna
             serial.serialize_func = serialize_string;
             serial.deserialize_func = deserialize_string;
             set_serializable(type, &serial);
+            set_equatable(type, default_equal_to<String>);
+            set_hashable(type, default_hash<String>);
         }
         // Name
         {
@@ -0,0 +1,146 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file CPU.cpp
+* @author JXMaster
+* @date 2024/5/5
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "../CPU.hpp"
+
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+#ifdef LUNA_COMPILER_MSVC
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#endif
+
+#if defined(LUNA_PLATFORM_ARM64) && defined(LUNA_PLATFORM_LINUX)
+#include <sys/auxv.h>
+#include <asm/hwcap.h>
+#endif
+
+namespace Luna
+{
+    static CPUFeatureFlag g_cpu_features = CPUFeatureFlag::none;
+
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+    static void cpuid(u32 leaf, u32 subleaf, u32 regs[4])
+    {
+#ifdef LUNA_COMPILER_MSVC
+        int r[4];
+        __cpuidex(r, (int)leaf, (int)subleaf);
+        for (u32 i = 0; i < 4; ++i) regs[i] = (u32)r[i];
+#else
+        if (!__get_cpuid_count(leaf, subleaf, &regs[0], &regs[1], &regs[2], &regs[3]))
+        {
+            regs[0] = regs[1] = regs[2] = regs[3] = 0;
+        }
+#endif
+    }
+    static u64 xgetbv0()
+    {
+#ifdef LUNA_COMPILER_MSVC
+        return (u64)_xgetbv(0);
+#else
+        u32 eax, edx;
+        __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+        return ((u64)edx << 32) | eax;
+#endif
+    }
+    static CPUFeatureFlag detect_cpu_features()
+    {
+        CPUFeatureFlag r = CPUFeatureFlag::none;
+        u32 regs[4];
+        cpuid(0, 0, regs);
+        u32 max_leaf = regs[0];
+        if (max_leaf < 1) return r;
+        cpuid(1, 0, regs);
+        u32 ecx1 = regs[2];
+        u32 edx1 = regs[3];
+        if (edx1 & (1 << 26)) set_flags(r, CPUFeatureFlag::sse2);
+        if (ecx1 & (1 << 0)) set_flags(r, CPUFeatureFlag::sse3);
+        if (ecx1 & (1 << 9)) set_flags(r, CPUFeatureFlag::ssse3);
+        if (ecx1 & (1 << 19)) set_flags(r, CPUFeatureFlag::sse4_1);
+        if (ecx1 & (1 << 20)) set_flags(r, CPUFeatureFlag::sse4_2);
+        if (ecx1 & (1 << 23)) set_flags(r, CPUFeatureFlag::popcnt);
+        // AVX registers can only be used if the operating system saves them on context switches, 
+        // which is reported by XCR0 when OSXSAVE is set.
+        bool os_avx = false;
+        bool os_avx512 = false;
+        if ((ecx1 & (1 << 27)) && (ecx1 & (1 << 28)))
+        {
+            u64 xcr0 = xgetbv0();
+            os_avx = (xcr0 & 0x06) == 0x06;
+            os_avx512 = os_avx && (xcr0 & 0xE0) == 0xE0;
+        }
+        if (os_avx)
+        {
+            set_flags(r, CPUFeatureFlag::avx);
+            if (ecx1 & (1 << 12)) set_flags(r, CPUFeatureFlag::fma3);
+            if (ecx1 & (1 << 29)) set_flags(r, CPUFeatureFlag::f16c);
+        }
+        if (max_leaf >= 7)
+        {
+            cpuid(7, 0, regs);
+            u32 ebx7 = regs[1];
+            if (ebx7 & (1 << 3)) set_flags(r, CPUFeatureFlag::bmi1);
+            if (ebx7 & (1 << 8)) set_flags(r, CPUFeatureFlag::bmi2);
+            if (os_avx && (ebx7 & (1 << 5))) set_flags(r, CPUFeatureFlag::avx2);
+            if (os_avx512 && (ebx7 & (1 << 16)))
+            {
+                set_flags(r, CPUFeatureFlag::avx512f);
+                if (ebx7 & (1 << 17)) set_flags(r, CPUFeatureFlag::avx512dq);
+                if (ebx7 & (1 << 30)) set_flags(r, CPUFeatureFlag::avx512bw);
+                if (ebx7 & (1u << 31)) set_flags(r, CPUFeatureFlag::avx512vl);
+            }
+        }
+        return r;
+    }
+#elif defined(LUNA_PLATFORM_ARM64)
+    static CPUFeatureFlag detect_cpu_features()
+    {
+        // Advanced SIMD is mandatory on AArch64.
+        CPUFeatureFlag r = CPUFeatureFlag::neon;
+#if defined(LUNA_PLATFORM_LINUX)
+        unsigned long hwcap = getauxval(AT_HWCAP);
+        if (hwcap & HWCAP_CRC32) set_flags(r, CPUFeatureFlag::crc32);
+#elif defined(LUNA_PLATFORM_MACOS) || defined(LUNA_PLATFORM_IOS)
+        // All Apple processors support CRC32 instructions.
+        set_flags(r, CPUFeatureFlag::crc32);
+#elif defined(__ARM_FEATURE_CRC32)
+        set_flags(r, CPUFeatureFlag::crc32);
+#endif
+        return r;
+    }
+#else
+    static CPUFeatureFlag detect_cpu_features()
+    {
+        CPUFeatureFlag r = CPUFeatureFlag::none;
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+        set_flags(r, CPUFeatureFlag::neon);
+#endif
+        return r;
+    }
+#endif
+
+    void batch_init();
+    void base64_init();
+    void base85_init();
+
+    void cpu_init()
+    {
+        g_cpu_features = detect_cpu_features();
+        batch_init();
+        base64_init();
+        base85_init();
+    }
+    LUNA_RUNTIME_API CPUFeatureFlag get_cpu_features()
+    {
+        return g_cpu_features;
+    }
+}
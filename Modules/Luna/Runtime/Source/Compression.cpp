@@ -0,0 +1,378 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Compression.cpp
+* @author JXMaster
+* @date 2024/5/13
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "Compression.hpp"
+#include "../LZ4.hpp"
+
+namespace Luna
+{
+    Span<const byte_t> get_effective_dictionary(CompressionFormat format, Span<const byte_t> dictionary)
+    {
+        if (format != CompressionFormat::lz4) return Span<const byte_t>();
+        // LZ4 matches cannot refer to data farther than 64KB.
+        usize size = min<usize>(dictionary.size(), LZ4::MAX_DISTANCE);
+        return Span<const byte_t>(dictionary.data() + dictionary.size() - size, size);
+    }
+    usize encode_compression_block(CompressionFormat format, const byte_t* src, usize src_size, usize prefix_size, byte_t* dst)
+    {
+        CompressionBlockHeader header;
+        header.raw_size = (u32)src_size;
+        byte_t* data = dst + sizeof(CompressionBlockHeader);
+        usize compressed_size = 0;
+        if (format == CompressionFormat::lz4)
+        {
+            compressed_size = LZ4::compress_with_prefix(src, src_size, prefix_size, data, LZ4::compress_bound(src_size));
+        }
+        // Stores data without compression if compression does not reduce the size.
+        if (!compressed_size || compressed_size >= src_size)
+        {
+            memcpy(data, src, src_size);
+            header.stored_size = (u32)src_size | COMPRESSION_BLOCK_UNCOMPRESSED;
+            compressed_size = src_size;
+        }
+        else
+        {
+            header.stored_size = (u32)compressed_size;
+        }
+        memcpy(dst, &header, sizeof(CompressionBlockHeader));
+        return sizeof(CompressionBlockHeader) + compressed_size;
+    }
+    RV decode_compression_block(CompressionFormat format, const CompressionBlockHeader& header, const byte_t* data,
+        Span<const byte_t> dictionary, byte_t* dst)
+    {
+        usize stored_size = header.stored_size & ~COMPRESSION_BLOCK_UNCOMPRESSED;
+        if (header.stored_size & COMPRESSION_BLOCK_UNCOMPRESSED)
+        {
+            if (stored_size != header.raw_size) return set_error(BasicError::format_error(), "Invalid compression block size.");
+            memcpy(dst, data, stored_size);
+            return ok;
+        }
+        if (format == CompressionFormat::lz4)
+        {
+            if (!LZ4::decompress_with_dict(data, stored_size, dst, header.raw_size, dictionary.data(), dictionary.size()))
+            {
+                return set_error(BasicError::format_error(), "The compressed data is corrupted.");
+            }
+            return ok;
+        }
+        return set_error(BasicError::format_error(), "Unknown compression format %u.", (u32)format);
+    }
+    LUNA_RUNTIME_API usize get_compress_bound(CompressionFormat format, usize src_size)
+    {
+        switch (format)
+        {
+        case CompressionFormat::lz4: return LZ4::compress_bound(src_size);
+        default: return src_size;
+        }
+    }
+    LUNA_RUNTIME_API R<usize> compress(CompressionFormat format, const void* src, usize src_size, void* dst, usize dst_capacity,
+        Span<const byte_t> dictionary)
+    {
+        if (format == CompressionFormat::none)
+        {
+            if (dst_capacity < src_size) return BasicError::insufficient_user_buffer();
+            memcpy(dst, src, src_size);
+            return src_size;
+        }
+        if (format != CompressionFormat::lz4) return BasicError::bad_arguments();
+        usize compressed_size;
+        dictionary = get_effective_dictionary(format, dictionary);
+        if (dictionary.empty())
+        {
+            compressed_size = LZ4::compress((const byte_t*)src, src_size, (byte_t*)dst, dst_capacity);
+        }
+        else
+        {
+            // The dictionary must be placed right before the data to be referred by matches.
+            Blob scratch(dictionary.size() + src_size);
+            byte_t* scratch_data = (byte_t*)scratch.data();
+            memcpy(scratch_data, dictionary.data(), dictionary.size());
+            memcpy(scratch_data + dictionary.size(), src, src_size);
+            compressed_size = LZ4::compress_with_prefix(scratch_data + dictionary.size(), src_size, dictionary.size(), (byte_t*)dst, dst_capacity);
+        }
+        if (!compressed_size) return BasicError::insufficient_user_buffer();
+        return compressed_size;
+    }
+    LUNA_RUNTIME_API RV decompress(CompressionFormat format, const void* src, usize src_size, void* dst, usize dst_size,
+        Span<const byte_t> dictionary)
+    {
+        if (format == CompressionFormat::none)
+        {
+            if (src_size != dst_size) return set_error(BasicError::format_error(), "The compressed data is corrupted.");
+            memcpy(dst, src, src_size);
+            return ok;
+        }
+        if (format != CompressionFormat::lz4) return BasicError::bad_arguments();
+        dictionary = get_effective_dictionary(format, dictionary);
+        if (!LZ4::decompress_with_dict((const byte_t*)src, src_size, (byte_t*)dst, dst_size, dictionary.data(), dictionary.size()))
+        {
+            return set_error(BasicError::format_error(), "The compressed data is corrupted.");
+        }
+        return ok;
+    }
+    LUNA_RUNTIME_API usize get_compress_frame_block_bound(CompressionFormat format, usize src_size)
+    {
+        return sizeof(CompressionBlockHeader) + max(get_compress_bound(format, src_size), src_size);
+    }
+    LUNA_RUNTIME_API usize compress_frame_block(const CompressionDesc& desc, const void* src, usize src_size, void* dst)
+    {
+        luassert(src_size <= desc.block_size);
+        Span<const byte_t> dictionary = get_effective_dictionary(desc.format, desc.dictionary);
+        if (dictionary.empty())
+        {
+            return encode_compression_block(desc.format, (const byte_t*)src, src_size, 0, (byte_t*)dst);
+        }
+        Blob scratch(dictionary.size() + src_size);
+        byte_t* scratch_data = (byte_t*)scratch.data();
+        memcpy(scratch_data, dictionary.data(), dictionary.size());
+        memcpy(scratch_data + dictionary.size(), src, src_size);
+        return encode_compression_block(desc.format, scratch_data + dictionary.size(), src_size, dictionary.size(), (byte_t*)dst);
+    }
+    LUNA_RUNTIME_API R<Blob> compress_frame(const void* src, usize src_size, const CompressionDesc& desc)
+    {
+        if (!desc.block_size || desc.block_size >= COMPRESSION_BLOCK_UNCOMPRESSED) return BasicError::bad_arguments();
+        usize num_blocks = (src_size + desc.block_size - 1) / desc.block_size;
+        Blob ret(sizeof(CompressionFrameHeader) + num_blocks * get_compress_frame_block_bound(desc.format, desc.block_size) + sizeof(CompressionBlockHeader));
+        CompressionFrameHeader header;
+        memzero(&header);
+        header.magic = COMPRESSION_FRAME_MAGIC;
+        header.format = desc.format;
+        header.block_size = desc.block_size;
+        memcpy(ret.data(), &header, sizeof(CompressionFrameHeader));
+        usize size = sizeof(CompressionFrameHeader);
+        for (usize offset = 0; offset < src_size; offset += desc.block_size)
+        {
+            usize block_size = min<usize>(desc.block_size, src_size - offset);
+            size += compress_frame_block(desc, (const byte_t*)src + offset, block_size, (byte_t*)ret.data() + size);
+        }
+        CompressionBlockHeader end;
+        end.stored_size = 0;
+        end.raw_size = 0;
+        memcpy((byte_t*)ret.data() + size, &end, sizeof(CompressionBlockHeader));
+        size += sizeof(CompressionBlockHeader);
+        ret.resize(size);
+        return ret;
+    }
+    LUNA_RUNTIME_API R<Blob> decompress_frame(const void* src, usize src_size, Span<const byte_t> dictionary)
+    {
+        const byte_t* cur = (const byte_t*)src;
+        const byte_t* end = cur + src_size;
+        CompressionFrameHeader header;
+        if (src_size < sizeof(CompressionFrameHeader)) return set_error(BasicError::format_error(), "Invalid compression frame header.");
+        memcpy(&header, cur, sizeof(CompressionFrameHeader));
+        cur += sizeof(CompressionFrameHeader);
+        if (header.magic != COMPRESSION_FRAME_MAGIC) return set_error(BasicError::format_error(), "Invalid compression frame header.");
+        dictionary = get_effective_dictionary(header.format, dictionary);
+        // Computes the decompressed size first, so that the output is allocated once.
+        usize raw_size = 0;
+        for (const byte_t* p = cur;;)
+        {
+            CompressionBlockHeader block;
+            if ((usize)(end - p) < sizeof(CompressionBlockHeader)) return set_error(BasicError::format_error(), "Unexpected end of compression frame.");
+            memcpy(&block, p, sizeof(CompressionBlockHeader));
+            p += sizeof(CompressionBlockHeader);
+            if (!block.stored_size && !block.raw_size) break;
+            usize stored_size = block.stored_size & ~COMPRESSION_BLOCK_UNCOMPRESSED;
+            if (block.raw_size > header.block_size || (usize)(end - p) < stored_size)
+            {
+                return set_error(BasicError::format_error(), "Invalid compression block size.");
+            }
+            p += stored_size;
+            raw_size += block.raw_size;
+        }
+        Blob ret(raw_size);
+        usize offset = 0;
+        lutry
+        {
+            while (true)
+            {
+                CompressionBlockHeader block;
+                memcpy(&block, cur, sizeof(CompressionBlockHeader));
+                cur += sizeof(CompressionBlockHeader);
+                if (!block.stored_size && !block.raw_size) break;
+                luexp(decode_compression_block(header.format, block, cur, dictionary, (byte_t*)ret.data() + offset));
+                cur += block.stored_size & ~COMPRESSION_BLOCK_UNCOMPRESSED;
+                offset += block.raw_size;
+            }
+        }
+        lucatchret;
+        return ret;
+    }
+
+    CompressionStream::~CompressionStream()
+    {
+        if (!m_finished)
+        {
+            auto _ = finish();
+        }
+    }
+    RV CompressionStream::flush_block()
+    {
+        lutry
+        {
+            if (!m_header_written)
+            {
+                CompressionFrameHeader header;
+                memzero(&header);
+                header.magic = COMPRESSION_FRAME_MAGIC;
+                header.format = m_format;
+                header.block_size = m_block_size;
+                luexp(m_target->write(&header, sizeof(CompressionFrameHeader)));
+                m_header_written = true;
+            }
+            if (m_buffered_size)
+            {
+                usize size = encode_compression_block(m_format, m_buffer.data() + m_prefix_size, m_buffered_size, m_prefix_size, m_compressed.data());
+                luexp(m_target->write(m_compressed.data(), size));
+                m_buffered_size = 0;
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+    RV CompressionStream::write(const void* buffer, usize size, usize* write_bytes)
+    {
+        if (write_bytes) *write_bytes = 0;
+        if (m_finished) return BasicError::bad_calling_time();
+        const byte_t* src = (const byte_t*)buffer;
+        usize written = 0;
+        lutry
+        {
+            while (written < size)
+            {
+                usize copy_size = min<usize>(size - written, m_block_size - m_buffered_size);
+                memcpy(m_buffer.data() + m_prefix_size + m_buffered_size, src + written, copy_size);
+                m_buffered_size += copy_size;
+                written += copy_size;
+                if (write_bytes) *write_bytes = written;
+                if (m_buffered_size == m_block_size)
+                {
+                    luexp(flush_block());
+                }
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+    RV CompressionStream::finish()
+    {
+        if (m_finished) return ok;
+        m_finished = true;
+        lutry
+        {
+            luexp(flush_block());
+            CompressionBlockHeader end;
+            end.stored_size = 0;
+            end.raw_size = 0;
+            luexp(m_target->write(&end, sizeof(CompressionBlockHeader)));
+        }
+        lucatchret;
+        return ok;
+    }
+    LUNA_RUNTIME_API Ref<ICompressionStream> new_compression_stream(IStream* target, const CompressionDesc& desc)
+    {
+        luassert(target && desc.block_size && desc.block_size < COMPRESSION_BLOCK_UNCOMPRESSED);
+        Ref<CompressionStream> ret = new_object<CompressionStream>();
+        ret->m_target = target;
+        ret->m_format = desc.format;
+        ret->m_block_size = desc.block_size;
+        Span<const byte_t> dictionary = get_effective_dictionary(desc.format, desc.dictionary);
+        ret->m_prefix_size = dictionary.size();
+        ret->m_buffer.resize(dictionary.size() + desc.block_size);
+        memcpy(ret->m_buffer.data(), dictionary.data(), dictionary.size());
+        ret->m_compressed.resize(get_compress_frame_block_bound(desc.format, desc.block_size));
+        return ret;
+    }
+
+    RV DecompressionStream::read_next_block()
+    {
+        lutry
+        {
+            CompressionBlockHeader header;
+            usize read_bytes;
+            luexp(m_source->read(&header, sizeof(CompressionBlockHeader), &read_bytes));
+            if (read_bytes != sizeof(CompressionBlockHeader)) return set_error(BasicError::format_error(), "Unexpected end of compression frame.");
+            m_block_pos = 0;
+            if (!header.stored_size && !header.raw_size)
+            {
+                m_block.clear();
+                m_end = true;
+                return ok;
+            }
+            usize stored_size = header.stored_size & ~COMPRESSION_BLOCK_UNCOMPRESSED;
+            if (header.raw_size > m_block_size || stored_size > get_compress_frame_block_bound(m_format, m_block_size))
+            {
+                return set_error(BasicError::format_error(), "Invalid compression block size.");
+            }
+            m_compressed.resize(stored_size);
+            luexp(m_source->read(m_compressed.data(), stored_size, &read_bytes));
+            if (read_bytes != stored_size) return set_error(BasicError::format_error(), "Unexpected end of compression frame.");
+            m_block.resize(header.raw_size);
+            luexp(decode_compression_block(m_format, header, m_compressed.data(),
+                Span<const byte_t>(m_dictionary.data(), m_dictionary.size()), m_block.data()));
+        }
+        lucatchret;
+        return ok;
+    }
+    RV DecompressionStream::read(void* buffer, usize size, usize* read_bytes)
+    {
+        byte_t* dst = (byte_t*)buffer;
+        usize total = 0;
+        lutry
+        {
+            while (total < size)
+            {
+                if (m_block_pos == m_block.size())
+                {
+                    if (m_end) break;
+                    luexp(read_next_block());
+                    continue;
+                }
+                usize copy_size = min<usize>(size - total, m_block.size() - m_block_pos);
+                memcpy(dst + total, m_block.data() + m_block_pos, copy_size);
+                m_block_pos += copy_size;
+                total += copy_size;
+            }
+        }
+        lucatch
+        {
+            if (read_bytes) *read_bytes = total;
+            return luerr;
+        }
+        if (read_bytes) *read_bytes = total;
+        return ok;
+    }
+    LUNA_RUNTIME_API R<Ref<IStream>> new_decompression_stream(IStream* source, Span<const byte_t> dictionary)
+    {
+        lucheck(source);
+        Ref<IStream> ret;
+        lutry
+        {
+            CompressionFrameHeader header;
+            usize read_bytes;
+            luexp(source->read(&header, sizeof(CompressionFrameHeader), &read_bytes));
+            if (read_bytes != sizeof(CompressionFrameHeader) || header.magic != COMPRESSION_FRAME_MAGIC ||
+                !header.block_size || header.block_size >= COMPRESSION_BLOCK_UNCOMPRESSED)
+            {
+                return set_error(BasicError::format_error(), "Invalid compression frame header.");
+            }
+            Ref<DecompressionStream> stream = new_object<DecompressionStream>();
+            stream->m_source = source;
+            stream->m_format = header.format;
+            stream->m_block_size = header.block_size;
+            dictionary = get_effective_dictionary(header.format, dictionary);
+            stream->m_dictionary.assign(dictionary);
+            ret = stream;
+        }
+        lucatchret;
+        return ret;
+    }
+}
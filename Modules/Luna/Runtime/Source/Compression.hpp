@@ -0,0 +1,80 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Compression.hpp
+* @author JXMaster
+* @date 2024/5/13
+*/
+#pragma once
+#include "../Compression.hpp"
+#include "../Vector.hpp"
+
+namespace Luna
+{
+    // Gets the part of the dictionary that can be referred by compressed data.
+    Span<const byte_t> get_effective_dictionary(CompressionFormat format, Span<const byte_t> dictionary);
+
+    // Writes one block header and block data to `dst`. `prefix_size` bytes before `src` are used as the dictionary.
+    usize encode_compression_block(CompressionFormat format, const byte_t* src, usize src_size, usize prefix_size, byte_t* dst);
+
+    // Decodes the data of one block into `dst`, which must be `header.raw_size` bytes.
+    RV decode_compression_block(CompressionFormat format, const CompressionBlockHeader& header, const byte_t* data,
+        Span<const byte_t> dictionary, byte_t* dst);
+
+    struct CompressionStream : ICompressionStream
+    {
+        lustruct("CompressionStream", "{3b7e9c15-52a8-4d6f-b1e0-8c4a27f93d62}");
+        luiimpl();
+
+        Ref<IStream> m_target;
+        CompressionFormat m_format;
+        u32 m_block_size;
+        // The dictionary followed by data of the current block, so that blocks can be compressed with the dictionary
+        // without copying.
+        Vector<byte_t> m_buffer;
+        usize m_prefix_size = 0;
+        usize m_buffered_size = 0;
+        Vector<byte_t> m_compressed;
+        bool m_header_written = false;
+        bool m_finished = false;
+
+        ~CompressionStream();
+
+        RV flush_block();
+
+        virtual RV read(void* buffer, usize size, usize* read_bytes) override
+        {
+            if (read_bytes) *read_bytes = 0;
+            return BasicError::not_supported();
+        }
+        virtual RV write(const void* buffer, usize size, usize* write_bytes) override;
+        virtual RV finish() override;
+    };
+
+    struct DecompressionStream : IStream
+    {
+        lustruct("DecompressionStream", "{d05a6c82-7f14-4e3b-9a28-b6c13e5f7a94}");
+        luiimpl();
+
+        Ref<IStream> m_source;
+        CompressionFormat m_format;
+        u32 m_block_size;
+        Vector<byte_t> m_dictionary;
+        // Decompressed data of the current block.
+        Vector<byte_t> m_block;
+        usize m_block_pos = 0;
+        Vector<byte_t> m_compressed;
+        bool m_end = false;
+
+        RV read_next_block();
+
+        virtual RV read(void* buffer, usize size, usize* read_bytes) override;
+        virtual RV write(const void* buffer, usize size, usize* write_bytes) override
+        {
+            if (write_bytes) *write_bytes = 0;
+            return BasicError::not_supported();
+        }
+    };
+}
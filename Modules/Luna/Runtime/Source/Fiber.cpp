@@ -0,0 +1,40 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Fiber.cpp
+* @author JXMaster
+* @date 2024/3/8
+*/
+#include "../PlatformDefines.hpp"
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "Fiber.hpp"
+
+namespace Luna
+{
+    LUNA_RUNTIME_API Ref<IFiber> convert_thread_to_fiber()
+    {
+        Ref<Fiber> f = new_object<Fiber>();
+        f->m_handle = OS::convert_thread_to_fiber();
+        f->m_thread_fiber = true;
+        return f;
+    }
+    LUNA_RUNTIME_API void convert_fiber_to_thread()
+    {
+        OS::convert_fiber_to_thread();
+    }
+    LUNA_RUNTIME_API Ref<IFiber> new_fiber(void(*entry_func)(void* params), void* params, u32 stack_size)
+    {
+        luassert(entry_func);
+        Ref<Fiber> f = new_object<Fiber>();
+        f->m_handle = OS::new_fiber(entry_func, params, stack_size);
+        return f;
+    }
+    LUNA_RUNTIME_API void switch_to_fiber(IFiber* fiber)
+    {
+        lucheck(fiber);
+        Fiber* f = (Fiber*)fiber->get_object();
+        OS::switch_to_fiber(f->m_handle);
+    }
+}
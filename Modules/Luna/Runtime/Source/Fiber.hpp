@@ -0,0 +1,36 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Fiber.hpp
+* @author JXMaster
+* @date 2024/3/8
+*/
+#pragma once
+#include "../Fiber.hpp"
+#include "OS.hpp"
+namespace Luna
+{
+    struct Fiber : IFiber
+    {
+        lustruct("Fiber", "{c1e0f5b2-8a57-4d6e-a4a3-2b9f3c6d7e18}");
+        luiimpl();
+
+        opaque_t m_handle;
+        // `true` if this fiber is converted from thread. Such fiber is deleted by `convert_fiber_to_thread`.
+        bool m_thread_fiber;
+
+        Fiber() :
+            m_handle(nullptr),
+            m_thread_fiber(false) {}
+
+        ~Fiber()
+        {
+            if (m_handle && !m_thread_fiber)
+            {
+                OS::delete_fiber(m_handle);
+            }
+        }
+    };
+}
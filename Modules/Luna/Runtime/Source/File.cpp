@@ -13,6 +13,19 @@
 
 namespace Luna
 {
+    perf_counter_t g_file_bytes_read_counter = 0;
+    perf_counter_t g_file_bytes_written_counter = 0;
+
+    void file_init()
+    {
+        g_file_bytes_read_counter = register_perf_counter("Runtime.FileBytesRead", PerfCounterType::counter, "bytes");
+        g_file_bytes_written_counter = register_perf_counter("Runtime.FileBytesWritten", PerfCounterType::counter, "bytes");
+    }
+    void file_close()
+    {
+        g_file_bytes_read_counter = 0;
+        g_file_bytes_written_counter = 0;
+    }
     LUNA_RUNTIME_API R<Ref<IFile>>    open_file(const c8* filename, FileOpenFlag flags, FileCreationMode creation)
     {
         Ref<IFile> ret;
@@ -47,6 +60,25 @@ namespace Luna
         lucatchret;
         return ret;
     }
+    LUNA_RUNTIME_API opaque_t get_native_file_handle(IFile* file)
+    {
+        File* f = cast_object<File>(file->get_object());
+        if (!f) return nullptr;
+        return OS::get_native_file_handle(f->m_file);
+    }
+    LUNA_RUNTIME_API R<Ref<IMappedFile>> map_file(const c8* path)
+    {
+        Ref<IMappedFile> ret;
+        lutry
+        {
+            lulet(mapping, OS::map_file(path));
+            auto file = new_object<MappedFile>();
+            file->m_mapping = mapping;
+            ret = file;
+        }
+        lucatchret;
+        return ret;
+    }
     LUNA_RUNTIME_API R<FileAttribute> get_file_attribute(const c8* filename)
     {
         return OS::get_file_attribute(filename);
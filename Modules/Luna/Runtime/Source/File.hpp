@@ -11,9 +11,13 @@
 #include "../TSAssert.hpp"
 #include "../File.hpp"
 #include "OS.hpp"
+#include "../PerfCounter.hpp"
 
 namespace Luna
 {
+    extern perf_counter_t g_file_bytes_read_counter;
+    extern perf_counter_t g_file_bytes_written_counter;
+
     struct File : IFile
     {
         lustruct("File", "{915247e4-15b4-44ba-8781-dd7dcfd48f87}");
@@ -33,11 +37,19 @@ namespace Luna
         }
         virtual RV read(void* buffer, usize size, usize* read_bytes) override
         {
-            return OS::read_file(m_file, buffer, size, read_bytes);
+            usize bytes = 0;
+            RV r = OS::read_file(m_file, buffer, size, &bytes);
+            perf_counter_add(g_file_bytes_read_counter, (i64)bytes);
+            if (read_bytes) *read_bytes = bytes;
+            return r;
         }
         virtual RV write(const void* buffer, usize size, usize* write_bytes) override
         {
-            return OS::write_file(m_file, buffer, size, write_bytes);
+            usize bytes = 0;
+            RV r = OS::write_file(m_file, buffer, size, &bytes);
+            perf_counter_add(g_file_bytes_written_counter, (i64)bytes);
+            if (write_bytes) *write_bytes = bytes;
+            return r;
         }
         virtual u64 get_size() override
         {
@@ -94,4 +106,29 @@ namespace Luna
             return OS::dir_iterator_move_next(m_handle);
         }
     };
+    struct MappedFile : IMappedFile
+    {
+        lustruct("MappedFile", "{e1a94c27-6d3b-4f58-8c02-b7f5a3d91e64}");
+        luiimpl();
+
+        opaque_t m_mapping;
+
+        MappedFile() :
+            m_mapping(nullptr) {}
+        ~MappedFile()
+        {
+            if (m_mapping)
+            {
+                OS::unmap_file(m_mapping);
+            }
+        }
+        virtual const byte_t* get_data() override
+        {
+            return (const byte_t*)OS::get_mapped_file_data(m_mapping);
+        }
+        virtual usize get_size() override
+        {
+            return OS::get_mapped_file_size(m_mapping);
+        }
+    };
 }
\ No newline at end of file
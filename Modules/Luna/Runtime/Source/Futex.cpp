@@ -0,0 +1,29 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Futex.cpp
+* @author JXMaster
+* @date 2024/5/11
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_RUNTIME_API LUNA_EXPORT
+
+#include "../Futex.hpp"
+#include "OS.hpp"
+namespace Luna
+{
+    LUNA_RUNTIME_API bool futex_wait(u32 volatile* address, u32 expected, u32 timeout_ms)
+    {
+        return OS::wait_on_address(address, expected, timeout_ms);
+    }
+    LUNA_RUNTIME_API void futex_wake_one(u32 volatile* address)
+    {
+        OS::wake_by_address_single(address);
+    }
+    LUNA_RUNTIME_API void futex_wake_all(u32 volatile* address)
+    {
+        OS::wake_by_address_all(address);
+    }
+}
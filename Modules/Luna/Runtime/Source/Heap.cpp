@@ -0,0 +1,370 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Heap.cpp
+* @author JXMaster
+* @date 2024/3/9
+*/
+#include "../PlatformDefines.hpp"
+#include "OS.hpp"
+#include "../SpinLock.hpp"
+
+// The built-in heap allocator that implements `OS::memalloc`, `OS::memfree` and `OS::memsize`.
+//
+// Small blocks (not larger than `MAX_SMALL_SIZE`) are allocated from size classes. Every size class allocates blocks
+// from 64KB spans that are aligned to 64KB, so that blocks whose sizes are times of one power-of-two alignment are always
+// aligned to that alignment, and aligned allocations can be served by size classes directly without padding.
+//
+// Every thread caches free blocks for every size class, so most allocations and deallocations do not need any lock.
+// When the thread cache is empty or full, blocks are moved between the thread cache and the central cache of the size
+// class in batches. Spans are never returned to the system.
+//
+// Large blocks and blocks with large alignments are allocated from the system heap directly. The size class of every span
+// is recorded in one page map indexed by span address, so that the allocator can tell whether one block is allocated from
+// spans or from the system heap by the pointer only.
+
+namespace Luna
+{
+    namespace OS
+    {
+#ifdef LUNA_USE_SYSTEM_ALLOCATOR
+        void* memalloc(usize size, usize alignment)
+        {
+            return system_memalloc(size, alignment);
+        }
+        void memfree(void* ptr, usize alignment)
+        {
+            system_memfree(ptr, alignment);
+        }
+        void* memrealloc(void* ptr, usize size, usize alignment)
+        {
+            return system_memrealloc(ptr, size, alignment);
+        }
+        usize memsize(void* ptr, usize alignment)
+        {
+            return system_memsize(ptr, alignment);
+        }
+#else
+        constexpr usize SPAN_SIZE_BITS = 16;
+        constexpr usize SPAN_SIZE = (usize)1 << SPAN_SIZE_BITS;
+        // Spans are allocated from the system in segments.
+        constexpr usize SEGMENT_SIZE = 32 * SPAN_SIZE;
+        constexpr usize MAX_SMALL_SIZE = 32_kb;
+        // 8 classes for 16-128 bytes, then 4 classes for every power of two up to `MAX_SMALL_SIZE`.
+        constexpr u32 NUM_SIZE_CLASSES = 40;
+        // The maximum number of free blocks that one thread can cache for one size class is `MAX_CACHE_BATCHES` times
+        // of the batch size of that class.
+        constexpr u32 MAX_CACHE_BATCHES = 2;
+
+#ifdef LUNA_PLATFORM_64BIT
+        constexpr usize ADDRESS_BITS = 48;
+#else
+        constexpr usize ADDRESS_BITS = 32;
+#endif
+        constexpr usize PAGE_MAP_LEAF_BITS = 16;
+        constexpr usize PAGE_MAP_ROOT_BITS = ADDRESS_BITS - SPAN_SIZE_BITS - PAGE_MAP_LEAF_BITS;
+
+        inline u32 get_highest_bit(usize v)
+        {
+            u32 r = 0;
+            while (v >>= 1) ++r;
+            return r;
+        }
+        inline u32 size_to_class(usize size)
+        {
+            if (size <= 128) return (u32)((size + 15) / 16) - 1;
+            u32 lg = get_highest_bit(size - 1);
+            usize step_bits = lg - 2;
+            u32 k = (u32)((size - ((usize)1 << lg) + ((usize)1 << step_bits) - 1) >> step_bits);
+            return 8 + (lg - 7) * 4 + (k - 1);
+        }
+        inline usize class_to_size(u32 size_class)
+        {
+            if (size_class < 8) return (usize)(size_class + 1) * 16;
+            u32 lg = 7 + (size_class - 8) / 4;
+            usize k = (size_class - 8) % 4 + 1;
+            return ((usize)1 << lg) + (k << (lg - 2));
+        }
+        inline u32 get_batch_size(u32 size_class)
+        {
+            usize n = 16_kb / class_to_size(size_class);
+            return (u32)(n < 4 ? 4 : (n > 64 ? 64 : n));
+        }
+
+        // The page map records the size class plus one of every span, or 0 if the span is not allocated by the heap.
+        static u8* volatile g_page_map[(usize)1 << PAGE_MAP_ROOT_BITS];
+        static SpinLock g_page_map_lock;
+
+        inline u32 get_span_class(void* ptr)
+        {
+            usize span = (usize)ptr >> SPAN_SIZE_BITS;
+            usize root = span >> PAGE_MAP_LEAF_BITS;
+            if (root >= ((usize)1 << PAGE_MAP_ROOT_BITS)) return 0;
+            u8* leaf = g_page_map[root];
+            if (!leaf) return 0;
+            return leaf[span & (((usize)1 << PAGE_MAP_LEAF_BITS) - 1)];
+        }
+        static bool set_span_class(void* span_ptr, u32 size_class)
+        {
+            usize span = (usize)span_ptr >> SPAN_SIZE_BITS;
+            usize root = span >> PAGE_MAP_LEAF_BITS;
+            if (root >= ((usize)1 << PAGE_MAP_ROOT_BITS)) return false;
+            u8* leaf = g_page_map[root];
+            if (!leaf)
+            {
+                LockGuard guard(g_page_map_lock);
+                leaf = g_page_map[root];
+                if (!leaf)
+                {
+                    leaf = (u8*)virtual_alloc((usize)1 << PAGE_MAP_LEAF_BITS, (usize)1 << PAGE_MAP_LEAF_BITS);
+                    if (!leaf) return false;
+                    atom_exchange_pointer((void* volatile*)&g_page_map[root], leaf);
+                }
+            }
+            leaf[span & (((usize)1 << PAGE_MAP_LEAF_BITS) - 1)] = (u8)(size_class + 1);
+            return true;
+        }
+
+        static SpinLock g_segment_lock;
+        static usize g_segment_cursor;
+        static usize g_segment_end;
+
+        static void* allocate_span(u32 size_class)
+        {
+            void* span;
+            {
+                LockGuard guard(g_segment_lock);
+                if (g_segment_cursor == g_segment_end)
+                {
+                    void* segment = virtual_alloc(SEGMENT_SIZE, SPAN_SIZE);
+                    if (!segment) return nullptr;
+                    g_segment_cursor = (usize)segment;
+                    g_segment_end = g_segment_cursor + SEGMENT_SIZE;
+                }
+                span = (void*)g_segment_cursor;
+                g_segment_cursor += SPAN_SIZE;
+            }
+            if (!set_span_class(span, size_class))
+            {
+                // The span cannot be recorded (for example, the address is out of the range of the page map).
+                // The span is leaked, and the allocation falls back to the system heap.
+                return nullptr;
+            }
+            return span;
+        }
+
+        struct CentralCache
+        {
+            SpinLock m_lock;
+            void* m_free_list;
+            // The range of the current span that is not allocated yet.
+            usize m_cursor;
+            usize m_end;
+        };
+        static CentralCache g_central_caches[NUM_SIZE_CLASSES];
+
+        // Fetches at most `count` blocks from the central cache. The blocks are linked as one free list.
+        // Returns the number of fetched blocks.
+        static u32 fetch_blocks(u32 size_class, u32 count, void*& out_list)
+        {
+            CentralCache& c = g_central_caches[size_class];
+            usize size = class_to_size(size_class);
+            LockGuard guard(c.m_lock);
+            void* list = nullptr;
+            u32 n = 0;
+            while (n < count && c.m_free_list)
+            {
+                void* block = c.m_free_list;
+                c.m_free_list = *(void**)block;
+                *(void**)block = list;
+                list = block;
+                ++n;
+            }
+            while (n < count)
+            {
+                if (c.m_cursor + size > c.m_end)
+                {
+                    void* span = allocate_span(size_class);
+                    if (!span) break;
+                    c.m_cursor = (usize)span;
+                    c.m_end = c.m_cursor + SPAN_SIZE;
+                }
+                void* block = (void*)c.m_cursor;
+                c.m_cursor += size;
+                *(void**)block = list;
+                list = block;
+                ++n;
+            }
+            out_list = list;
+            return n;
+        }
+        // Gives at most `count` blocks in the list back to the central cache. Returns the remaining list.
+        static void* release_blocks(u32 size_class, void* list, u32 count)
+        {
+            CentralCache& c = g_central_caches[size_class];
+            LockGuard guard(c.m_lock);
+            for (u32 i = 0; i < count && list; ++i)
+            {
+                void* block = list;
+                list = *(void**)block;
+                *(void**)block = c.m_free_list;
+                c.m_free_list = block;
+            }
+            return list;
+        }
+
+        struct ThreadCacheList
+        {
+            void* m_head;
+            u32 m_count;
+        };
+        enum class ThreadCacheState : u8
+        {
+            uninitialized = 0,
+            active = 1,
+            // The thread is exiting and the cache is flushed. Further allocations of this thread use the central cache directly.
+            closed = 2,
+        };
+        // The thread cache is trivially constructible and destructible, so it is valid during the whole thread
+        // lifetime. Flushing is performed by `ThreadCacheCloser` when the thread exits.
+        struct ThreadCache
+        {
+            ThreadCacheList m_lists[NUM_SIZE_CLASSES];
+            ThreadCacheState m_state;
+        };
+        static thread_local ThreadCache t_thread_cache;
+
+        struct ThreadCacheCloser
+        {
+            ~ThreadCacheCloser()
+            {
+                ThreadCache& cache = t_thread_cache;
+                for (u32 i = 0; i < NUM_SIZE_CLASSES; ++i)
+                {
+                    ThreadCacheList& list = cache.m_lists[i];
+                    release_blocks(i, list.m_head, list.m_count);
+                    list.m_head = nullptr;
+                    list.m_count = 0;
+                }
+                cache.m_state = ThreadCacheState::closed;
+            }
+        };
+        static thread_local ThreadCacheCloser t_thread_cache_closer;
+
+        inline ThreadCache* get_thread_cache()
+        {
+            ThreadCache* cache = &t_thread_cache;
+            if (cache->m_state == ThreadCacheState::active) return cache;
+            if (cache->m_state == ThreadCacheState::closed) return nullptr;
+            // Accessing the closer object registers its destructor for the current thread.
+            ThreadCacheCloser* closer = &t_thread_cache_closer;
+            (void)closer;
+            cache->m_state = ThreadCacheState::active;
+            return cache;
+        }
+
+        static void* allocate_small(u32 size_class)
+        {
+            ThreadCache* cache = get_thread_cache();
+            if (!cache)
+            {
+                void* block;
+                return fetch_blocks(size_class, 1, block) ? block : nullptr;
+            }
+            ThreadCacheList& list = cache->m_lists[size_class];
+            if (!list.m_head)
+            {
+                list.m_count = fetch_blocks(size_class, get_batch_size(size_class), list.m_head);
+                if (!list.m_head) return nullptr;
+            }
+            void* block = list.m_head;
+            list.m_head = *(void**)block;
+            --list.m_count;
+            return block;
+        }
+        static void free_small(void* ptr, u32 size_class)
+        {
+            ThreadCache* cache = get_thread_cache();
+            if (!cache)
+            {
+                *(void**)ptr = nullptr;
+                release_blocks(size_class, ptr, 1);
+                return;
+            }
+            ThreadCacheList& list = cache->m_lists[size_class];
+            *(void**)ptr = list.m_head;
+            list.m_head = ptr;
+            ++list.m_count;
+            u32 batch = get_batch_size(size_class);
+            if (list.m_count > batch * MAX_CACHE_BATCHES)
+            {
+                list.m_head = release_blocks(size_class, list.m_head, batch);
+                list.m_count -= batch;
+            }
+        }
+
+        void* memalloc(usize size, usize alignment)
+        {
+            if (!size) return nullptr;
+            if (size <= MAX_SMALL_SIZE && alignment <= MAX_SMALL_SIZE)
+            {
+                u32 size_class = size_to_class(size > alignment ? size : alignment);
+                if (alignment > MAX_ALIGN)
+                {
+                    // Selects the first size class whose block size is times of the alignment. Since spans are aligned
+                    // to `SPAN_SIZE`, all blocks of such class are aligned.
+                    while (size_class < NUM_SIZE_CLASSES && (class_to_size(size_class) & (alignment - 1)))
+                    {
+                        ++size_class;
+                    }
+                }
+                if (size_class < NUM_SIZE_CLASSES)
+                {
+                    void* block = allocate_small(size_class);
+                    if (block) return block;
+                }
+            }
+            return system_memalloc(size, alignment);
+        }
+        void memfree(void* ptr, usize alignment)
+        {
+            if (!ptr) return;
+            u32 span_class = get_span_class(ptr);
+            if (span_class)
+            {
+                free_small(ptr, span_class - 1);
+                return;
+            }
+            system_memfree(ptr, alignment);
+        }
+        void* memrealloc(void* ptr, usize size, usize alignment)
+        {
+            u32 span_class = get_span_class(ptr);
+            if (!span_class)
+            {
+                return system_memrealloc(ptr, size, alignment);
+            }
+            // Blocks allocated from spans can only grow within their size classes.
+            usize old_size = class_to_size(span_class - 1);
+            if (size <= old_size) return ptr;
+            void* new_ptr = memalloc(size, alignment);
+            if (!new_ptr) return nullptr;
+            memcpy(new_ptr, ptr, old_size);
+            free_small(ptr, span_class - 1);
+            return new_ptr;
+        }
+        usize memsize(void* ptr, usize alignment)
+        {
+            if (!ptr) return 0;
+            u32 span_class = get_span_class(ptr);
+            if (span_class)
+            {
+                return class_to_size(span_class - 1);
+            }
+            return system_memsize(ptr, alignment);
+        }
+#endif
+    }
+}
@@ -11,27 +11,64 @@
 #define LUNA_RUNTIME_API LUNA_EXPORT
 #include "Interface.hpp"
 #include "../Reflection.hpp"
+#include "TypeInfo.hpp"
 
 namespace Luna
 {
+    static interface_cast_func_t* get_interface_cast_func(TypeInfo* t, interface_id_t iid)
+    {
+        if (iid < t->interface_table.size() && t->interface_table[iid])
+        {
+            return t->interface_table[iid];
+        }
+        // Generic instanced types use interfaces implemented by their generic types.
+        if (t->kind == TypeKind::generic_structure_instanced)
+        {
+            return get_interface_cast_func(((GenericStructureInstancedTypeInfo*)t)->generic_type, iid);
+        }
+        return nullptr;
+    }
     LUNA_RUNTIME_API void impl_interface_for_type(const InterfaceImplDesc& desc)
     {
         auto type = get_type_by_guid(desc.type_guid);
         lucheck(type);
-        InterfaceImplEntry* entry = (InterfaceImplEntry*)
-            set_type_private_data(type, desc.interface_guid, sizeof(InterfaceImplEntry), alignof(InterfaceImplEntry));
-        entry->cast_to_interface = desc.cast_to_interface;
+        TypeInfo* t = (TypeInfo*)type;
+        interface_id_t iid = get_interface_id(desc.interface_guid);
+        if (iid >= t->interface_table.size())
+        {
+            t->interface_table.resize(iid + 1, nullptr);
+        }
+        t->interface_table[iid] = desc.cast_to_interface;
     }
     LUNA_RUNTIME_API bool is_interface_implemented_by_type(typeinfo_t type, const Guid& iid)
     {
-        InterfaceImplEntry* entry = (InterfaceImplEntry*)get_type_private_data(type, iid);
-        return entry != nullptr;
+        interface_id_t id = find_interned_guid(iid);
+        if (id == INVALID_INTERFACE_ID) return false;
+        return get_interface_cast_func((TypeInfo*)type, id) != nullptr;
     }
     LUNA_RUNTIME_API void* query_interface(object_t object, const Guid& iid)
     {
-        typeinfo_t type = get_object_type(object);
-        InterfaceImplEntry* entry = (InterfaceImplEntry*)get_type_private_data(type, iid);
-        if (!entry) return nullptr;
-        return entry->cast_to_interface(object);
+        interface_id_t id = find_interned_guid(iid);
+        if (id == INVALID_INTERFACE_ID) return nullptr;
+        return query_interface_by_id(object, id);
+    }
+    LUNA_RUNTIME_API void* query_interface_by_id(object_t object, interface_id_t iid)
+    {
+        TypeInfo* t = (TypeInfo*)get_object_type(object);
+        interface_cast_func_t* cast_func = get_interface_cast_func(t, iid);
+        if (!cast_func) return nullptr;
+        return cast_func(object);
+    }
+    LUNA_RUNTIME_API void* cast_object_or_query_interface(object_t object, interface_id_t iid)
+    {
+        TypeInfo* t = (TypeInfo*)get_object_type(object);
+        // Checks whether the object is the specified type or derived types of the specified type.
+        for (typeinfo_t type = (typeinfo_t)t; type; type = get_base_type(type))
+        {
+            if (((TypeInfo*)type)->interned_id == iid) return object;
+        }
+        interface_cast_func_t* cast_func = get_interface_cast_func(t, iid);
+        if (!cast_func) return nullptr;
+        return cast_func(object);
     }
 }
\ No newline at end of file
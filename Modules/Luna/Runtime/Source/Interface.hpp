@@ -11,11 +11,3 @@
 #include "../Interface.hpp"
 #include "../HashMap.hpp"
 #include "../UniquePtr.hpp"
-
-namespace Luna
-{
-    struct InterfaceImplEntry
-    {
-        void* (*cast_to_interface)(object_t obj);
-    };
-}
\ No newline at end of file
@@ -13,6 +13,11 @@
 #include "../Mutex.hpp"
 #include "../File.hpp"
 #include "../Event.hpp"
+#include "../Thread.hpp"
+#include "../Signal.hpp"
+#include "../Atomic.hpp"
+#include "../Time.hpp"
+#include "../SpinLock.hpp"
 #include "OS.hpp"
 
 namespace Luna
@@ -49,31 +54,552 @@ namespace Luna
         }
     }
 
+    // The file log is written by one dedicated writer thread, so that file IO is never performed on the thread that emits logs.
+    // Log handlers are always called with `g_log_mutex` locked, so only one thread writes to the ring at one time, and 
+    // the ring can be implemented as one lock-free single-producer single-consumer byte ring.
+    constexpr usize LOG_RING_SIZE = 1_mb;
+
     struct FileLog
     {
         bool enabled;
         LogVerbosity verbosity = LogVerbosity::verbose;
+
+        // The log ring. `write_pos` is modified by the thread that holds `g_log_mutex`, `read_pos` is modified
+        // by the writer thread after the data is written to the file.
+        c8* ring = nullptr;
+        alignas(64) usize volatile write_pos = 0;
+        alignas(64) usize volatile read_pos = 0;
+
+        // The writer thread.
+        Ref<IThread> writer;
+        Ref<ISignal> writer_signal;
+        u32 volatile writer_sleeping = 0;
+        u32 volatile writer_exiting = 0;
+
+        // The file states, which are accessed by the writer thread and configuration functions with `file_mutex` locked.
+        Ref<IMutex> file_mutex;
         Name filename;
-        String log_buffer;
+        Ref<IFile> file;
+        u64 file_size = 0;
+        i64 file_open_time = 0;
+        u64 max_file_size = 0;
+        u64 max_file_age = 0;
+        u32 max_backup_files = 0;
     };
 
     static FileLog* g_filelog;
 
-    static void flush_log_file()
+    // Deferred logs are written to one ring buffer of every thread, and are formatted and dispatched by the writer thread.
+    constexpr usize DEFERRED_LOG_RING_SIZE = 64_kb;
+    // Records are aligned to 4 bytes, and one record whose size is `U32_MAX` tells the reader to skip to the beginning of the ring.
+    constexpr u32 DEFERRED_LOG_PADDING_RECORD = U32_MAX;
+
+    struct DeferredLogRing
+    {
+        u8* buffer = nullptr;
+        alignas(64) usize volatile write_pos = 0;
+        // The size of the record being written. This is accessed only by the producer thread.
+        usize record_size = 0;
+        alignas(64) usize volatile read_pos = 0;
+        // Set when the producer thread exits, the ring is freed by the writer thread after all records are read.
+        u32 volatile closed = 0;
+        DeferredLogRing* next = nullptr;
+    };
+
+    static SpinLock g_deferred_log_rings_lock;
+    static DeferredLogRing* g_deferred_log_rings = nullptr;
+    static opaque_t g_deferred_log_ring_tls;
+    // Increased by the writer thread every time it finishes reading all deferred log rings.
+    static u32 volatile g_deferred_log_epoch = 0;
+
+    static void wake_log_writer(FileLog* data)
+    {
+        if (data->writer_sleeping && atom_exchange_u32(&data->writer_sleeping, 0))
+        {
+            data->writer_signal->trigger();
+        }
+    }
+
+    static void rotate_log_file(FileLog* data)
+    {
+        data->file.reset();
+        if (data->max_backup_files)
+        {
+            // Log.txt -> Log.txt.1, Log.txt.1 -> Log.txt.2, and so on. The oldest backup file is overwritten.
+            c8 from[512];
+            c8 to[512];
+            for (u32 i = data->max_backup_files - 1; i > 0; --i)
+            {
+                snprintf(from, 512, "%s.%u", data->filename.c_str(), i);
+                snprintf(to, 512, "%s.%u", data->filename.c_str(), i + 1);
+                auto _ = move_file(from, to);
+            }
+            snprintf(to, 512, "%s.1", data->filename.c_str());
+            auto _ = move_file(data->filename.c_str(), to);
+        }
+        else
+        {
+            auto _ = delete_file(data->filename.c_str());
+        }
+    }
+
+    static void write_log_file(FileLog* data, const c8* buffer, usize size)
     {
-        if (!g_filelog->log_buffer.empty())
+        MutexGuard guard(data->file_mutex);
+        while (size)
         {
+            usize write_size = size;
+            if (data->file)
+            {
+                if (data->max_file_age && (u64)(get_utc_timestamp() - data->file_open_time) >= data->max_file_age)
+                {
+                    rotate_log_file(data);
+                }
+                else if (data->max_file_size && data->file_size + size > data->max_file_size)
+                {
+                    // Writes lines that fit in the current file, then rotates the file for the rest lines.
+                    usize fit_size = data->file_size < data->max_file_size ? (usize)(data->max_file_size - data->file_size) : 0;
+                    write_size = 0;
+                    for (usize i = fit_size; i > 0; --i)
+                    {
+                        if (buffer[i - 1] == '\n')
+                        {
+                            write_size = i;
+                            break;
+                        }
+                    }
+                    if (!write_size)
+                    {
+                        if (data->file_size)
+                        {
+                            rotate_log_file(data);
+                            continue;
+                        }
+                        // One line is larger than the size limit, writes it to one file.
+                        write_size = size;
+                    }
+                }
+            }
             lutry
             {
-                lulet(f, open_file(g_filelog->filename.c_str(), FileOpenFlag::write, FileCreationMode::open_always));
-                luexp(f->seek(0, SeekMode::end));
-                luexp(f->write(g_filelog->log_buffer.data(), g_filelog->log_buffer.size()));
-                g_filelog->log_buffer.clear();
+                if (!data->file)
+                {
+                    luset(data->file, open_file(data->filename.c_str(), FileOpenFlag::write, FileCreationMode::open_always));
+                    luexp(data->file->seek(0, SeekMode::end));
+                    data->file_size = data->file->get_size();
+                    data->file_open_time = get_utc_timestamp();
+                    continue;
+                }
+                luexp(data->file->write(buffer, write_size));
+                data->file_size += write_size;
             }
             lucatch
             {
+                // Logs are discarded if the log file cannot be written, and the file will be opened again for 
+                // next writes.
+                data->file.reset();
                 return;
             }
+            buffer += write_size;
+            size -= write_size;
+        }
+    }
+
+    // Writes logs in the log ring to the file. This is called only on the writer thread.
+    static bool drain_log_ring(FileLog* data)
+    {
+        usize read_pos = data->read_pos;
+        usize write_pos = data->write_pos;
+        if (read_pos == write_pos) return false;
+        // Log data must not be read before the write position is read.
+        atom_memory_barrier();
+        while (read_pos != write_pos)
+        {
+            usize offset = read_pos & (LOG_RING_SIZE - 1);
+            usize size = min(write_pos - read_pos, LOG_RING_SIZE - offset);
+            write_log_file(data, data->ring + offset, size);
+            read_pos += size;
+            atom_exchange_usize(&data->read_pos, read_pos);
+        }
+        return true;
+    }
+
+    static void append_format(String& dst, const c8* format, ...)
+    {
+        c8 buf[128];
+        VarList args;
+        va_start(args, format);
+        i32 len = vsnprintf(buf, 128, format, args);
+        va_end(args);
+        if (len <= 0) return;
+        if (len < 128)
+        {
+            dst.append(buf, len);
+            return;
+        }
+        usize offset = dst.size();
+        dst.resize(offset + len + 1, 0);
+        va_start(args, format);
+        vsnprintf(dst.data() + offset, len + 1, format, args);
+        va_end(args);
+        dst.resize(offset + len, 0);
+    }
+
+    // Formats one deferred log message. Every conversion specifier is formatted using the type of the argument stored
+    // in the record, only flags, width and precision are taken from the format string.
+    static void format_deferred_log(String& dst, const c8* format, const u8* args, const u8* args_end)
+    {
+        using Impl::DeferredLogArgType;
+        const c8* p = format;
+        while (*p)
+        {
+            if (*p != '%')
+            {
+                const c8* begin = p;
+                while (*p && *p != '%') ++p;
+                dst.append(begin, p - begin);
+                continue;
+            }
+            if (p[1] == '%')
+            {
+                dst.push_back('%');
+                p += 2;
+                continue;
+            }
+            // Parses flags, width and precision.
+            const c8* spec_begin = p++;
+            while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0') ++p;
+            while (*p >= '0' && *p <= '9') ++p;
+            if (*p == '.')
+            {
+                ++p;
+                while (*p >= '0' && *p <= '9') ++p;
+            }
+            usize spec_len = min<usize>(p - spec_begin, 24);
+            // Skips length modifiers.
+            while (*p == 'h' || *p == 'l' || *p == 'j' || *p == 'z' || *p == 't' || *p == 'L') ++p;
+            c8 conv = *p;
+            if (!conv) break;
+            ++p;
+            if (args >= args_end)
+            {
+                dst.append("<missing>");
+                continue;
+            }
+            c8 spec[32];
+            memcpy(spec, spec_begin, spec_len);
+            c8* spec_end = spec + spec_len;
+            DeferredLogArgType type = (DeferredLogArgType)*args;
+            ++args;
+            if (type == DeferredLogArgType::string)
+            {
+                u32 len;
+                memcpy(&len, args, sizeof(u32));
+                args += sizeof(u32);
+                // Precision specified in the format string is replaced by the string length, since strings are not 
+                // null-terminated in the record.
+                *spec_end = 0;
+                c8* dot = strchr(spec, '.');
+                if (dot) *dot = 0;
+                strcat(spec, ".*s");
+                append_format(dst, spec, (int)len, (const c8*)args);
+                args += len;
+                continue;
+            }
+            u64 value;
+            memcpy(&value, args, sizeof(u64));
+            args += sizeof(u64);
+            bool float_conv = conv == 'f' || conv == 'F' || conv == 'e' || conv == 'E' || conv == 'g' || conv == 'G' || conv == 'a' || conv == 'A';
+            bool int_conv = conv == 'd' || conv == 'i' || conv == 'u' || conv == 'o' || conv == 'x' || conv == 'X' || conv == 'c';
+            switch (type)
+            {
+            case DeferredLogArgType::signed_int:
+            case DeferredLogArgType::unsigned_int:
+            {
+                bool is_signed = type == DeferredLogArgType::signed_int;
+                if (float_conv)
+                {
+                    spec_end[0] = conv; spec_end[1] = 0;
+                    append_format(dst, spec, is_signed ? (f64)(i64)value : (f64)value);
+                }
+                else if (conv == 'c')
+                {
+                    spec_end[0] = 'c'; spec_end[1] = 0;
+                    append_format(dst, spec, (int)value);
+                }
+                else
+                {
+                    if (!int_conv) conv = is_signed ? 'd' : 'u';
+                    spec_end[0] = 'l'; spec_end[1] = 'l'; spec_end[2] = conv; spec_end[3] = 0;
+                    if (is_signed && (conv == 'd' || conv == 'i')) append_format(dst, spec, (long long)(i64)value);
+                    else append_format(dst, spec, (unsigned long long)value);
+                }
+                break;
+            }
+            case DeferredLogArgType::floating_point:
+            {
+                f64 v;
+                memcpy(&v, &value, sizeof(f64));
+                spec_end[0] = float_conv ? conv : 'f'; spec_end[1] = 0;
+                append_format(dst, spec, v);
+                break;
+            }
+            case DeferredLogArgType::pointer:
+            {
+                spec_end[0] = 'p'; spec_end[1] = 0;
+                append_format(dst, spec, (void*)(usize)value);
+                break;
+            }
+            default:
+                // The record is corrupted.
+                dst.append("<bad argument>");
+                return;
+            }
+        }
+    }
+
+    static void dispatch_deferred_log(const u8* record, usize size)
+    {
+        LogVerbosity verbosity = (LogVerbosity)record[0];
+        const c8* tag;
+        const c8* format;
+        memcpy(&tag, record + 1, sizeof(const c8*));
+        memcpy(&format, record + 1 + sizeof(const c8*), sizeof(const c8*));
+        const u8* args = record + 1 + sizeof(const c8*) * 2;
+        String message;
+        format_deferred_log(message, format, args, record + size);
+        if (!tag) tag = "";
+        MutexGuard guard(g_log_mutex);
+        g_log_callbacks(verbosity, tag, strlen(tag), message.c_str(), message.size());
+    }
+
+    // Formats and dispatches logs in deferred log rings of all threads. This is called only on the writer thread.
+    static bool drain_deferred_log_rings(FileLog* data)
+    {
+        bool drained = false;
+        DeferredLogRing* ring;
+        {
+            LockGuard guard(g_deferred_log_rings_lock);
+            ring = g_deferred_log_rings;
+        }
+        // Rings are only freed by the writer thread, and new rings are always inserted at the head of the list, so the 
+        // list can be walked without locking.
+        for (; ring; ring = ring->next)
+        {
+            usize read_pos = ring->read_pos;
+            usize write_pos = ring->write_pos;
+            if (read_pos == write_pos) continue;
+            atom_memory_barrier();
+            while (read_pos != write_pos)
+            {
+                usize offset = read_pos & (DEFERRED_LOG_RING_SIZE - 1);
+                u32 record_size;
+                memcpy(&record_size, ring->buffer + offset, sizeof(u32));
+                if (record_size == DEFERRED_LOG_PADDING_RECORD)
+                {
+                    read_pos += DEFERRED_LOG_RING_SIZE - offset;
+                    continue;
+                }
+                dispatch_deferred_log(ring->buffer + offset + sizeof(u32), record_size);
+                read_pos += align_upper(sizeof(u32) + record_size, sizeof(u32));
+            }
+            atom_exchange_usize(&ring->read_pos, read_pos);
+            drained = true;
+        }
+        // Frees rings of exited threads.
+        {
+            LockGuard guard(g_deferred_log_rings_lock);
+            DeferredLogRing** iter = &g_deferred_log_rings;
+            while (*iter)
+            {
+                DeferredLogRing* r = *iter;
+                if (r->closed && r->read_pos == r->write_pos)
+                {
+                    *iter = r->next;
+                    memfree(r->buffer);
+                    memdelete(r);
+                }
+                else
+                {
+                    iter = &r->next;
+                }
+            }
+        }
+        atom_inc_u32(&g_deferred_log_epoch);
+        return drained;
+    }
+
+    static bool has_pending_deferred_logs()
+    {
+        LockGuard guard(g_deferred_log_rings_lock);
+        for (DeferredLogRing* ring = g_deferred_log_rings; ring; ring = ring->next)
+        {
+            if (ring->read_pos != ring->write_pos) return true;
+        }
+        return false;
+    }
+
+    static void log_writer_main(void* params)
+    {
+        FileLog* data = (FileLog*)params;
+        while (true)
+        {
+            bool working = drain_deferred_log_rings(data);
+            working |= drain_log_ring(data);
+            if (working) continue;
+            if (data->writer_exiting) break;
+            // Sleeps until new logs are written. The write positions must be checked again after `writer_sleeping` is set, 
+            // or the wake-up from the producer may be lost.
+            atom_exchange_u32(&data->writer_sleeping, 1);
+            if (data->write_pos != data->read_pos || has_pending_deferred_logs() || data->writer_exiting)
+            {
+                atom_exchange_u32(&data->writer_sleeping, 0);
+                continue;
+            }
+            data->writer_signal->wait();
+        }
+    }
+
+    static void start_log_writer(FileLog* data)
+    {
+        if (data->writer) return;
+        data->ring = (c8*)memalloc(LOG_RING_SIZE);
+        data->writer_signal = new_signal(false);
+        data->writer = new_thread(log_writer_main, data, "Log Writer");
+    }
+
+    static void stop_log_writer(FileLog* data)
+    {
+        if (!data->writer) return;
+        atom_exchange_u32(&data->writer_exiting, 1);
+        data->writer_signal->trigger();
+        data->writer->wait();
+        data->writer.reset();
+        data->writer_signal.reset();
+        memfree(data->ring);
+        data->ring = nullptr;
+    }
+
+    static void write_log_ring(FileLog* data, const c8* buffer, usize size)
+    {
+        while (size)
+        {
+            usize write_pos = data->write_pos;
+            usize space = LOG_RING_SIZE - (write_pos - data->read_pos);
+            if (!space)
+            {
+                if (get_current_thread() == data->writer.get())
+                {
+                    // Deferred logs are dispatched on the writer thread, which cannot wait for itself.
+                    drain_log_ring(data);
+                    continue;
+                }
+                // The ring is full, waits for the writer thread to write logs to the file.
+                wake_log_writer(data);
+                yield_current_thread();
+                continue;
+            }
+            usize offset = write_pos & (LOG_RING_SIZE - 1);
+            usize copy_size = min(min(size, space), LOG_RING_SIZE - offset);
+            memcpy(data->ring + offset, buffer, copy_size);
+            // Log data must be visible before the new write position is visible.
+            atom_exchange_usize(&data->write_pos, write_pos + copy_size);
+            buffer += copy_size;
+            size -= copy_size;
+        }
+    }
+
+    // Waits for the writer thread to write all logs before `target_pos` to the file.
+    static bool wait_log_written(FileLog* data, usize target_pos, u64 begin_time, u64 timeout_ticks)
+    {
+        if (!data->writer) return true;
+        while ((isize)(data->read_pos - target_pos) < 0)
+        {
+            wake_log_writer(data);
+            if (get_ticks() - begin_time >= timeout_ticks) return false;
+            sleep(1);
+        }
+        return true;
+    }
+
+    // Waits for the writer thread to dispatch all deferred logs emitted before this call.
+    static bool wait_deferred_logs_dispatched(FileLog* data, u64 begin_time, u64 timeout_ticks)
+    {
+        if (!data->writer) return true;
+        // The pass that is running when this is called may miss logs emitted before this call, so we need to wait 
+        // for the next pass.
+        u32 epoch = g_deferred_log_epoch;
+        while ((i32)(g_deferred_log_epoch - epoch) < 2)
+        {
+            wake_log_writer(data);
+            if (get_ticks() - begin_time >= timeout_ticks) return false;
+            sleep(1);
+        }
+        return true;
+    }
+
+    static void close_deferred_log_ring(void* ring)
+    {
+        if (ring) atom_exchange_u32(&((DeferredLogRing*)ring)->closed, 1);
+    }
+
+    namespace Impl
+    {
+        LUNA_RUNTIME_API void* begin_deferred_log(usize size)
+        {
+            FileLog* data = g_filelog;
+            if (!data) return nullptr;
+            usize record_size = align_upper(sizeof(u32) + size, sizeof(u32));
+            // Records that are too large are discarded.
+            if (record_size > DEFERRED_LOG_RING_SIZE / 4) return nullptr;
+            DeferredLogRing* ring = (DeferredLogRing*)OS::tls_get(g_deferred_log_ring_tls);
+            if (!ring)
+            {
+                ring = memnew<DeferredLogRing>();
+                ring->buffer = (u8*)memalloc(DEFERRED_LOG_RING_SIZE);
+                OS::tls_set(g_deferred_log_ring_tls, ring);
+                {
+                    MutexGuard guard(g_log_mutex);
+                    start_log_writer(data);
+                }
+                LockGuard guard(g_deferred_log_rings_lock);
+                ring->next = g_deferred_log_rings;
+                g_deferred_log_rings = ring;
+            }
+            while (true)
+            {
+                usize write_pos = ring->write_pos;
+                usize offset = write_pos & (DEFERRED_LOG_RING_SIZE - 1);
+                usize contiguous = DEFERRED_LOG_RING_SIZE - offset;
+                usize required = contiguous < record_size ? contiguous + record_size : record_size;
+                if (DEFERRED_LOG_RING_SIZE - (write_pos - ring->read_pos) < required)
+                {
+                    // The ring is full, waits for the writer thread to dispatch logs.
+                    wake_log_writer(data);
+                    yield_current_thread();
+                    continue;
+                }
+                if (contiguous < record_size)
+                {
+                    // Records must be contiguous, so skips the tail of the ring.
+                    u32 padding = DEFERRED_LOG_PADDING_RECORD;
+                    memcpy(ring->buffer + offset, &padding, sizeof(u32));
+                    atom_exchange_usize(&ring->write_pos, write_pos + contiguous);
+                    continue;
+                }
+                u32 payload_size = (u32)size;
+                memcpy(ring->buffer + offset, &payload_size, sizeof(u32));
+                ring->record_size = record_size;
+                return ring->buffer + offset + sizeof(u32);
+            }
+        }
+        LUNA_RUNTIME_API void end_deferred_log()
+        {
+            FileLog* data = g_filelog;
+            DeferredLogRing* ring = (DeferredLogRing*)OS::tls_get(g_deferred_log_ring_tls);
+            // The record must be visible before the new write position is visible.
+            atom_exchange_usize(&ring->write_pos, ring->write_pos + ring->record_size);
+            wake_log_writer(data);
         }
     }
 
@@ -82,18 +608,15 @@ namespace Luna
         FileLog* data = g_filelog;
         if (data->enabled && (u8)verbosity <= (u8)data->verbosity)
         {
-            data->log_buffer.push_back('[');
-            data->log_buffer.append(tag, tag_length);
-            data->log_buffer.push_back(']');
-            data->log_buffer.append(print_verbosity(verbosity));
-            data->log_buffer.push_back(':');
-            data->log_buffer.push_back(' ');
-            data->log_buffer.append(message, message_length);
-            data->log_buffer.push_back('\n');
-            if (data->log_buffer.size() > 64_kb)
-            {
-                flush_log_file();
-            }
+            const c8* verbosity_str = print_verbosity(verbosity);
+            write_log_ring(data, "[", 1);
+            write_log_ring(data, tag, tag_length);
+            write_log_ring(data, "]", 1);
+            write_log_ring(data, verbosity_str, strlen(verbosity_str));
+            write_log_ring(data, ": ", 2);
+            write_log_ring(data, message, message_length);
+            write_log_ring(data, "\n", 1);
+            wake_log_writer(data);
         }
     }
 
@@ -103,12 +626,25 @@ namespace Luna
         register_log_handler(platform_log);
         g_filelog = memnew<FileLog>();
         g_filelog->filename = "./Log.txt";
+        g_filelog->file_mutex = new_mutex();
+        g_deferred_log_ring_tls = OS::tls_alloc(close_deferred_log_ring);
         register_log_handler(file_log);
     }
     void log_close()
     {
-        flush_log_file();
+        // The writer thread writes all remaining logs before exiting.
+        stop_log_writer(g_filelog);
         memdelete(g_filelog);
+        g_filelog = nullptr;
+        // Rings of threads that are still running are freed here.
+        while (g_deferred_log_rings)
+        {
+            DeferredLogRing* ring = g_deferred_log_rings;
+            g_deferred_log_rings = ring->next;
+            memfree(ring->buffer);
+            memdelete(ring);
+        }
+        OS::tls_free(g_deferred_log_ring_tls);
         g_log_callbacks.clear();
         g_log_mutex = nullptr;
     }
@@ -124,18 +660,25 @@ namespace Luna
     {
         c8 buf[LOG_STACK_BUFFER_SIZE];
         c8* abuf = nullptr;
+        // `args` may be consumed by the first call, so a copy is used if the message needs to be formatted again.
+        VarList args_copy;
+        va_copy(args_copy, args);
         i32 len = vsnprintf(buf, LOG_STACK_BUFFER_SIZE, format, args);
         if (len >= LOG_STACK_BUFFER_SIZE)
         {
             abuf = (c8*)memalloc(sizeof(c8) * (len + 1));
-            len = vsnprintf(abuf, len + 1, format, args);
+            len = vsnprintf(abuf, len + 1, format, args_copy);
         }
-        c8* use_buf = abuf ? abuf : buf;
+        va_end(args_copy);
+        if (len < 0) len = 0;
+        log_message(verbosity, tag, StringView(abuf ? abuf : buf, (usize)len));
+        if (abuf) memfree(abuf);
+    }
+    LUNA_RUNTIME_API void log_message(LogVerbosity verbosity, const c8* tag, StringView message)
+    {
         MutexGuard guard(g_log_mutex);
         if(!tag) tag = "";
-        g_log_callbacks(verbosity, tag, strlen(tag), use_buf, len);
-        guard.unlock();
-        if (abuf) memfree(abuf);
+        g_log_callbacks(verbosity, tag, strlen(tag), message.data(), message.size());
     }
     LUNA_RUNTIME_API usize register_log_handler(const Function<log_callback_t>& handler)
     {
@@ -215,22 +758,38 @@ namespace Luna
     LUNA_RUNTIME_API void set_log_to_file_enabled(bool enabled)
     {
         MutexGuard guard(g_log_mutex);
+        if (enabled) start_log_writer(g_filelog);
         g_filelog->enabled = enabled;
     }
     LUNA_RUNTIME_API void set_log_file(const c8* file)
     {
         MutexGuard guard(g_log_mutex);
-        flush_log_file();
+        // Logs emitted before this call are written to the old file.
+        wait_log_written(g_filelog, g_filelog->write_pos, get_ticks(), U64_MAX);
+        MutexGuard file_guard(g_filelog->file_mutex);
+        g_filelog->file.reset();
         g_filelog->filename = file;
     }
+    LUNA_RUNTIME_API void set_log_file_rotation(u64 max_file_size, u64 max_file_age, u32 max_backup_files)
+    {
+        MutexGuard guard(g_filelog->file_mutex);
+        g_filelog->max_file_size = max_file_size;
+        g_filelog->max_file_age = max_file_age;
+        g_filelog->max_backup_files = max_backup_files;
+    }
     LUNA_RUNTIME_API void set_log_to_file_verbosity(LogVerbosity verbosity)
     {
         MutexGuard guard(g_log_mutex);
         g_filelog->verbosity = verbosity;
     }
-    LUNA_RUNTIME_API void flush_log_to_file()
+    LUNA_RUNTIME_API bool flush_log_to_file(u32 timeout_milliseconds)
     {
+        u64 begin_time = get_ticks();
+        u64 timeout_ticks = timeout_milliseconds == U32_MAX ? U64_MAX : (u64)(get_ticks_per_second() * timeout_milliseconds / 1000.0);
+        if (!wait_deferred_logs_dispatched(g_filelog, begin_time, timeout_ticks)) return false;
         MutexGuard guard(g_log_mutex);
-        flush_log_file();
+        usize target_pos = g_filelog->write_pos;
+        guard.unlock();
+        return wait_log_written(g_filelog, target_pos, begin_time, timeout_ticks);
     }
 }
\ No newline at end of file
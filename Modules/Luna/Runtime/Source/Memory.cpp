@@ -15,7 +15,7 @@
 #include "OS.hpp"
 #include "../Atomic.hpp"
 #include "Memory.hpp"
-#include "../Profiler.hpp"
+#include "Profiler.hpp"
 
 namespace Luna
 {
@@ -23,9 +23,15 @@ namespace Luna
     {
         if(!size) return nullptr;
         void* mem = OS::memalloc(size, alignment);
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        if(g_allocation_tracker_enabled) allocation_tracker_record_allocation(size);
+#endif
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
-        usize allocated = OS::memsize(mem, alignment);
-        memory_profiler_allocate(mem, allocated);
+        // The block size is queried only for sampled allocations.
+        if(mem && memory_profiler_sample_allocation(size))
+        {
+            memory_profiler_record_allocation(mem, OS::memsize(mem, alignment));
+        }
 #endif
         return mem;
     }
@@ -41,15 +47,39 @@ namespace Luna
         // expanding or contracting the existing area pointed to by `ptr`, if possible.
         usize old_size = memsize(ptr, alignment);
         if(size <= old_size) return ptr;
-        // reallocating.
-        void* new_ptr = memalloc(size, alignment);
-        memcpy(new_ptr, ptr, min(old_size, size));
-        memfree(ptr, alignment);
+        // extending the existing block in place or reallocating.
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+        // The old block must be removed from the profiler before it is freed, since the address may be reused by other threads
+        // once it is freed.
+        memory_profiler_deallocate(ptr);
+#endif
+        void* new_ptr = OS::memrealloc(ptr, size, alignment);
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        // Reallocating is counted as one allocation and one deallocation, even if the block is extended in place.
+        if(g_allocation_tracker_enabled)
+        {
+            allocation_tracker_record_allocation(size);
+            allocation_tracker_record_deallocation();
+        }
+#endif
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+        if(new_ptr)
+        {
+            if(memory_profiler_sample_allocation(size)) memory_profiler_record_allocation(new_ptr, OS::memsize(new_ptr, alignment));
+        }
+        else
+        {
+            if(memory_profiler_sample_allocation(old_size)) memory_profiler_record_allocation(ptr, old_size);
+        }
+#endif
         return new_ptr;
     }
     LUNA_RUNTIME_API void memfree(void* ptr, usize alignment)
     {
         if(!ptr) return;
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        if(g_allocation_tracker_enabled) allocation_tracker_record_deallocation();
+#endif
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
         memory_profiler_deallocate(ptr);
 #endif
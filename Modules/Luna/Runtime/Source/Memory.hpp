@@ -9,8 +9,14 @@
 */
 #pragma once
 #include "../Memory.hpp"
+#include "../AllocationTracker.hpp"
 
 namespace Luna
 {
-    
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+    // Checked before calling the record functions, so that disabled tracking costs one load per allocation.
+    extern bool volatile g_allocation_tracker_enabled;
+    void allocation_tracker_record_allocation(usize size);
+    void allocation_tracker_record_deallocation();
+#endif
 }
\ No newline at end of file
@@ -18,6 +18,12 @@
 #include "../Name.hpp"
 #include "../Result.hpp"
 #include "../RingDeque.hpp"
+#include "../String.hpp"
+#include "../Thread.hpp"
+#include "../Mutex.hpp"
+#include "../Semaphore.hpp"
+#include "../Time.hpp"
+#include "../Log.hpp"
 namespace Luna
 {
     struct ModuleEntry
@@ -94,147 +100,225 @@ namespace Luna
         }
         return nullptr;
     }
-    static R<Vector<Module*>> get_module_init_queue()
+    // Collects `handle` and all uninitialized modules that `handle` depends on.
+    static void collect_init_modules(Module* handle, HashSet<Module*>& modules)
     {
-        HashSet<Module*> unresolved_modules;
-        for(auto& m : g_modules)
+        auto iter = g_modules.find(handle);
+        luassert(iter != g_modules.end());
+        if (iter->second.m_initialized || modules.contains(handle)) return;
+        modules.insert(handle);
+        for (Module* dep : iter->second.m_dependencies)
+        {
+            collect_init_modules(dep, modules);
+        }
+    }
+    struct ModuleInitContext;
+    struct ModuleInitTask
+    {
+        Module* m_module;
+        ModuleInitContext* m_context;
+        // The number of dependency modules of this module that are not initialized yet.
+        usize m_num_unresolved_dependencies = 0;
+        // The indices of tasks that depend on this module.
+        Vector<usize> m_dependents;
+        // The initialization result and time, filled by the thread that initializes the module.
+        ErrCode m_result = ErrCode(0);
+        String m_error_message;
+        u64 m_init_ticks = 0;
+        bool m_concurrent;
+    };
+    struct ModuleInitContext
+    {
+        Vector<ModuleInitTask> m_tasks;
+        // Task indices of concurrent modules that are finished on worker threads.
+        Vector<usize> m_finished_tasks;
+        Ref<IMutex> m_mtx;
+        Ref<ISemaphore> m_finished;
+    };
+    static void run_module_init_task(ModuleInitTask& task)
+    {
+        u64 begin_ticks = get_ticks();
+        auto r = task.m_module->on_init();
+        task.m_init_ticks = get_ticks() - begin_ticks;
+        if (failed(r))
+        {
+            // The error object is thread-local, so we need to copy the error message out.
+            task.m_result = unwrap_errcode(r);
+            task.m_error_message = explain(r.errcode());
+        }
+    }
+    static void module_init_worker(void* params)
+    {
+        ModuleInitTask* task = (ModuleInitTask*)params;
+        run_module_init_task(*task);
+        ModuleInitContext* ctx = task->m_context;
+        {
+            MutexGuard guard(ctx->m_mtx);
+            ctx->m_finished_tasks.push_back(task - ctx->m_tasks.data());
+        }
+        ctx->m_finished->release();
+    }
+    // Initializes all modules in `modules` by their dependency order. Dependencies of modules in `modules` must 
+    // either be initialized or be included in `modules`.
+    static RV init_module_set(const HashSet<Module*>& modules)
+    {
+        if (modules.empty()) return ok;
+        ModuleInitContext ctx;
+        HashMap<Module*, usize> task_indices;
+        ctx.m_tasks.reserve(modules.size());
+        for (Module* m : modules)
+        {
+            task_indices.insert(make_pair(m, ctx.m_tasks.size()));
+            ModuleInitTask task;
+            task.m_module = m;
+            task.m_context = &ctx;
+            task.m_concurrent = test_flags(m->get_init_flags(), ModuleInitFlag::concurrent);
+            ctx.m_tasks.push_back(move(task));
+        }
+        Vector<usize> ready_tasks;
+        for (usize i = 0; i < ctx.m_tasks.size(); ++i)
         {
-            if(!m.second.m_initialized)
+            ModuleInitTask& task = ctx.m_tasks[i];
+            auto& entry = g_modules.find(task.m_module)->second;
+            for (Module* dep : entry.m_dependencies)
+            {
+                auto iter = task_indices.find(dep);
+                if (iter != task_indices.end())
+                {
+                    ++task.m_num_unresolved_dependencies;
+                    ctx.m_tasks[iter->second].m_dependents.push_back(i);
+                }
+            }
+            if (!task.m_num_unresolved_dependencies)
             {
-                unresolved_modules.insert(m.first);
+                ready_tasks.push_back(i);
             }
         }
-        Vector<Module*> init_queue;
-        // Loop until all modules are resolved and pushed into the queue.
-        while (!unresolved_modules.empty())
+        ctx.m_mtx = new_mutex();
+        ctx.m_finished = new_semaphore(0, (i32)ctx.m_tasks.size());
+        Vector<Ref<IThread>> workers;
+        usize num_running_workers = 0;
+        usize num_finished_tasks = 0;
+        ErrCode err(0);
+        u64 begin_ticks = get_ticks();
+        f64 ticks_per_ms = get_ticks_per_second() / 1000.0;
+        // Called on this thread when one task is finished.
+        auto finish_task = [&](usize index)
         {
-            bool any_removed = false;
-            auto iter = unresolved_modules.begin();
-            while (iter != unresolved_modules.end())
+            ModuleInitTask& task = ctx.m_tasks[index];
+            ++num_finished_tasks;
+            if (task.m_result.code)
             {
-                bool can_init = true;    // If this module can be initialized.
-                // Check dependencies.
-                auto module_iter = g_modules.find(*iter);
-                luassert(module_iter != g_modules.end());
-                Vector<Module*>& dependencies = module_iter->second.m_dependencies;
-                for (Module* dep : dependencies)
+                if (!err.code)
                 {
-                    if (unresolved_modules.contains(dep))
-                    {
-                        // The dependency is not initialized.
-                        can_init = false;
-                        break;
-                    }
+                    err = set_error(task.m_result, "Failed to initialize module %s: %s", task.m_module->get_name(), task.m_error_message.c_str());
                 }
-                if (can_init)
+                return;
+            }
+            g_modules.find(task.m_module)->second.m_initialized = true;
+            g_initialized_modules.push_back(task.m_module);
+            log_info("Module", "Module %s initialized in %.3f ms%s", task.m_module->get_name(), 
+                (f64)task.m_init_ticks / ticks_per_ms, task.m_concurrent ? " (concurrent)" : "");
+            for (usize dependent : task.m_dependents)
+            {
+                if (!--ctx.m_tasks[dependent].m_num_unresolved_dependencies)
                 {
-                    // Remove this.
-                    init_queue.push_back(*iter);
-                    any_removed = true;
-                    iter = unresolved_modules.erase(iter);
+                    ready_tasks.push_back(dependent);
                 }
-                else
+            }
+        };
+        while (num_finished_tasks != ctx.m_tasks.size())
+        {
+            // Stop scheduling new tasks if any module fails, but wait for running workers.
+            while (!err.code && !ready_tasks.empty())
+            {
+                usize index = ready_tasks.back();
+                ready_tasks.pop_back();
+                ModuleInitTask& task = ctx.m_tasks[index];
+                if (task.m_concurrent)
                 {
-                    ++iter; // Skip this, leave to next roll.
+                    Ref<IThread> worker = new_thread(module_init_worker, &task, task.m_module->get_name());
+                    if (worker)
+                    {
+                        workers.push_back(move(worker));
+                        ++num_running_workers;
+                        continue;
+                    }
+                    // Fall back to initialize the module on this thread if the worker cannot be created.
                 }
+                run_module_init_task(task);
+                finish_task(index);
             }
-            if (!any_removed)
+            if (!num_running_workers)
             {
-                // Cycle reference detected.
-                return set_error(BasicError::bad_arguments(), "Cycling module dependencies detected.");
+                break;
             }
-        }
-        return init_queue;
-    }
-    static RV init_single_module(Module* handle)
-    {
-        lutry
-        {
-            auto entry = g_modules.find(handle);
-            if (!entry->second.m_initialized)
+            // Wait for any worker to finish.
+            ctx.m_finished->wait();
+            usize finished_index;
             {
-                luexp(entry->first->on_init());
-                entry->second.m_initialized = true;
-                g_initialized_modules.push_back(entry->first);
+                MutexGuard guard(ctx.m_mtx);
+                finished_index = ctx.m_finished_tasks.back();
+                ctx.m_finished_tasks.pop_back();
             }
+            --num_running_workers;
+            finish_task(finished_index);
         }
-        lucatch
+        for (auto& worker : workers)
         {
-            return set_error(luerr, "Failed to initialize module %s: %s", handle->get_name(), explain(luerr));
+            worker->wait();
         }
+        if (err.code) return err;
+        if (num_finished_tasks != ctx.m_tasks.size())
+        {
+            return set_error(BasicError::bad_arguments(), "Cycling module dependencies detected.");
+        }
+        log_info("Module", "%u modules initialized in %.3f ms", (u32)ctx.m_tasks.size(), (f64)(get_ticks() - begin_ticks) / ticks_per_ms);
         return ok;
     }
     LUNA_RUNTIME_API RV init_module_dependencies(Module* handle)
     {
         lucheck_msg(handle, "init_module_dependencies failed: handle is nullptr");
-        lutry
+        auto iter = g_modules.find(handle);
+        if (iter == g_modules.end())
         {
-            auto iter = g_modules.find(handle);
-            if (iter == g_modules.end())
-            {
-                return set_error(BasicError::not_found(), "Module %s is not registered.", handle->get_name());
-            }
-            if (iter->second.m_initialized) return ok;
-            lulet(queue, get_module_init_queue());
-            HashSet<Module*> dependencies;
-            for(Module* m : iter->second.m_dependencies)
-            {
-                dependencies.insert(m);
-            }
-            for (auto i : queue)
-            {
-                auto iter = dependencies.find(i);
-                if (iter != dependencies.end())
-                {
-                    luexp(init_single_module(i));
-                }
-            }
+            return set_error(BasicError::not_found(), "Module %s is not registered.", handle->get_name());
         }
-        lucatchret;
-        return ok;
+        if (iter->second.m_initialized) return ok;
+        HashSet<Module*> modules;
+        for (Module* dep : iter->second.m_dependencies)
+        {
+            collect_init_modules(dep, modules);
+        }
+        if (modules.contains(handle))
+        {
+            return set_error(BasicError::bad_arguments(), "Cycling module dependencies detected.");
+        }
+        return init_module_set(modules);
     }
     LUNA_RUNTIME_API RV init_module(Module* handle)
     {
         lucheck_msg(handle, "init_module failed: handle is nullptr");
-        lutry
+        auto iter = g_modules.find(handle);
+        if (iter == g_modules.end())
         {
-            auto iter = g_modules.find(handle);
-            if (iter == g_modules.end())
-            {
-                return set_error(BasicError::not_found(), "Module %s is not found.", handle->get_name());
-            }
-            if (iter->second.m_initialized) return ok;
-            lulet(queue, get_module_init_queue());
-            HashSet<Module*> dependencies;
-            for(Module* m : iter->second.m_dependencies)
-            {
-                dependencies.insert(m);
-            }
-            for (auto i : queue)
-            {
-                auto iter = dependencies.find(i);
-                if (iter != dependencies.end())
-                {
-                    luexp(init_single_module(i));
-                }
-            }
-            luexp(init_single_module(iter->first));
+            return set_error(BasicError::not_found(), "Module %s is not found.", handle->get_name());
         }
-        lucatchret;
-        return ok;
+        if (iter->second.m_initialized) return ok;
+        HashSet<Module*> modules;
+        collect_init_modules(handle, modules);
+        return init_module_set(modules);
     }
     LUNA_RUNTIME_API RV init_modules()
     {
-        lutry
+        HashSet<Module*> modules;
+        for (auto& m : g_modules)
         {
-            lulet(queue, get_module_init_queue());
-            // Initialize all modules by order.
-            for (auto i : queue)
+            if (!m.second.m_initialized && !test_flags(m.first->get_init_flags(), ModuleInitFlag::lazy))
             {
-                luexp(init_single_module(i));
+                collect_init_modules(m.first, modules);
             }
         }
-        lucatchret;
-        return ok;
+        return init_module_set(modules);
     }
 }
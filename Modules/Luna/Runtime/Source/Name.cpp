@@ -15,6 +15,7 @@
 #include "../SpinLock.hpp"
 #include "../Memory.hpp"
 #include "../Profiler.hpp"
+#include "../PerfCounter.hpp"
 namespace Luna
 {
     struct NameEntry
@@ -43,37 +44,78 @@ namespace Luna
             return v->m_id;
         }
     };
-    Unconstructed<SelfIndexedUnorderedMultiMap<name_id_t, NameEntry*, NameEntryExtractKey>> g_name_map;
-    RecursiveSpinLock g_name_mtx;
+    using name_map_t = SelfIndexedUnorderedMultiMap<name_id_t, NameEntry*, NameEntryExtractKey>;
+
+    // Names are stored in multiple shards selected by the name ID, so that interning names from
+    // multiple threads does not contend on one lock.
+    constexpr usize NUM_NAME_SHARDS = 64;
+
+    struct alignas(64) NameShard
+    {
+        // The lock is recursive because memory profiler callbacks may intern names.
+        RecursiveSpinLock m_mtx;
+        name_map_t m_map;
+    };
+    struct NameTable
+    {
+        NameShard m_shards[NUM_NAME_SHARDS];
+    };
+    Unconstructed<NameTable> g_name_table;
     bool g_name_inited = false;
-    static void erase_entry(NameEntry* entry)
+    // The number of interned name strings.
+    perf_counter_t g_num_names_counter = 0;
+
+    inline NameShard& get_name_shard(name_id_t id)
     {
-        auto range = g_name_map.get().equal_range(entry->m_id);
-        luassert(range.first != g_name_map.get().end());
+        // Use the higher bits, since the lower bits are used by the map of the shard.
+        return g_name_table.get().m_shards[(id >> 26) & (NUM_NAME_SHARDS - 1)];
+    }
+    static void erase_entry(NameShard& shard, NameEntry* entry)
+    {
+        auto range = shard.m_map.equal_range(entry->m_id);
+        luassert(range.first != shard.m_map.end());
         for (auto iter = range.first; iter != range.second; ++iter)
         {
             if (entry == *iter)
             {
-                g_name_map.get().erase(iter);
+                shard.m_map.erase(iter);
                 break;
             }
         }
         memfree(entry);
+        perf_counter_add(g_num_names_counter, -1);
+    }
+    //! Increases the reference count of the entry if the entry is not being released.
+    inline bool try_retain_entry(NameEntry* entry)
+    {
+        u32 ref_count = entry->m_ref_count;
+        while (ref_count)
+        {
+            u32 r = atom_compare_exchange_u32(&(entry->m_ref_count), ref_count + 1, ref_count);
+            if (r == ref_count) return true;
+            ref_count = r;
+        }
+        return false;
     }
     void name_init()
     {
-        g_name_map.construct();
+        g_name_table.construct();
         g_name_inited = true;
+        g_num_names_counter = register_perf_counter("Runtime.Names", PerfCounterType::gauge);
     }
     void name_close()
     {
         // Release all name strings.
-        for (auto& i : g_name_map.get())
+        for (auto& shard : g_name_table.get().m_shards)
         {
-            memfree(i);
+            for (auto& i : shard.m_map)
+            {
+                memfree(i);
+            }
         }
-        g_name_map.destruct();
+        g_name_table.destruct();
         g_name_inited = false;
+        g_num_names_counter = 0;
     }
     LUNA_RUNTIME_API const c8* intern_name(const c8* name)
     {
@@ -84,32 +126,19 @@ namespace Luna
     LUNA_RUNTIME_API const c8* intern_name(const c8* name, usize count)
     {
         lucheck_msg(g_name_inited, "intern_name must be called after Luna::init()!");
-        if (!name || (*name == '\0')) return nullptr;
-        name_id_t h = memhash<name_id_t>(name, count);
-        LockGuard guard(g_name_mtx);
-        auto range = g_name_map.get().equal_range(h);
-        if (range.first != g_name_map.get().end())
+        if (!name || !count || (*name == '\0')) return nullptr;
+        name_id_t h = (name_id_t)wyhash(name, count);
+        NameShard& shard = get_name_shard(h);
+        LockGuard guard(shard.m_mtx);
+        auto range = shard.m_map.equal_range(h);
+        for (auto iter = range.first; iter != range.second; ++iter)
         {
-            auto iter = range.first;
-            // Skip comparison for single-string case.
-            ++iter;
-            if(iter == range.second)
-            {
-                iter = range.first;
-                NameEntry* entry = *iter;
-                atom_inc_u32(&(entry->m_ref_count));
-                return get_name_string(entry);
-            }
-            // Compare each string to find the right one.
-            for (iter = range.first; iter != range.second; ++iter)
+            NameEntry* entry = *iter;
+            const c8* entry_string = get_name_string(entry);
+            // Entries whose reference count is 0 are being released by other threads and cannot be reused.
+            if (entry->m_str_size == count && !memcmp(name, entry_string, count * sizeof(c8)) && try_retain_entry(entry))
             {
-                NameEntry* entry = *iter;
-                const c8* entry_string = get_name_string(entry);
-                if (!memcmp(name, entry_string, count * sizeof(c8)))
-                {
-                    atom_inc_u32(&(entry->m_ref_count));
-                    return entry_string;
-                }
+                return entry_string;
             }
         }
         // Create new entry.
@@ -121,7 +150,8 @@ namespace Luna
         c8* buf = (c8*)(new_entry + 1);
         memcpy(buf, name, sizeof(c8) * count);
         buf[count] = 0;
-        g_name_map.get().insert(new_entry);
+        shard.m_map.insert(new_entry);
+        perf_counter_add(g_num_names_counter, 1);
         return buf;
     }
     LUNA_RUNTIME_API void retain_name(const c8* name)
@@ -137,10 +167,13 @@ namespace Luna
         u32 r = atom_dec_u32(&(entry->m_ref_count));
         if (!r)
         {
-            LockGuard guard(g_name_mtx);
-            erase_entry(entry);
+            NameShard& shard = get_name_shard(entry->m_id);
+            LockGuard guard(shard.m_mtx);
+            erase_entry(shard, entry);
         }
     }
+    // The following functions only read the entry header, which is not changed after the entry is created, so they
+    // do not need to lock the table.
     LUNA_RUNTIME_API name_id_t get_name_id(const c8* name)
     {
         if (!name) return 0;
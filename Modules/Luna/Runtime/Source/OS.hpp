@@ -56,7 +56,9 @@ namespace Luna
         //! @param[in] message_len The log message length, not including the null terminator.
         void log(LogVerbosity verbosity, const c8* tag, usize tag_len, const c8* message, usize message_len);
 
-        //! Allocates memory blocks from system heap.
+        //! Allocates memory blocks from the built-in heap allocator.
+        //! @details Small memory blocks are allocated from size-classed spans cached by every thread, other memory blocks are 
+        //! allocated from the system heap. If `LUNA_USE_SYSTEM_ALLOCATOR` is defined, all memory blocks are allocated from the system heap.
         //! @param[in] size The number of bytes to allocate. If this is 0, no memory will be allocated and the return value will be `nullptr`.
         //! @param[in] alignment Optional. The required alignment of the allocated memory block. 
         //! 
@@ -76,6 +78,15 @@ namespace Luna
         //! @param[in] alignment Optional. The alignment requirement specified when allocating the memory block. Default is 0.
         void memfree(void* ptr, usize alignment = 0);
 
+        //! Reallocates memory blocks allocated by `OS::memalloc` or `OS::memrealloc`.
+        //! @details The memory block is extended in place if possible. If the memory block cannot be extended, one new memory block is
+        //! allocated, and the data is copied to the new memory block.
+        //! @param[in] ptr The pointer returned by `OS::memalloc` or `OS::memrealloc`. This must not be `nullptr`.
+        //! @param[in] size The new size of the memory block. This must not be 0.
+        //! @param[in] alignment Optional. The alignment requirement specified when allocating the memory block. Default is 0.
+        //! @return Returns the reallocated memory block, or `nullptr` if failed. If failed, the old memory block is not changed.
+        void* memrealloc(void* ptr, usize size, usize alignment = 0);
+
         //! Gets the allocated size of the memory block allocated by `OS::memalloc` or `OS::memrealloc`. 
         //! The returned size is the size that is available for the user to use. 
         //! Note that the allocated size may be bigger than the size required to specify alignment and padding requirements.
@@ -84,6 +95,53 @@ namespace Luna
         //! @return The size of bytes of the memory block. If `ptr` is `nullptr`, the returned value is 0.
         usize memsize(void* ptr, usize alignment = 0);
 
+        //! Allocates memory from the system heap directly, bypassing the built-in heap allocator.
+        //! @details This has the same semantic as `OS::memalloc`. Memory blocks allocated by this function must be freed by `OS::system_memfree`.
+        void* system_memalloc(usize size, usize alignment = 0);
+
+        //! Frees memory blocks allocated by `OS::system_memalloc`.
+        void system_memfree(void* ptr, usize alignment = 0);
+
+        //! Reallocates memory blocks allocated by `OS::system_memalloc` or `OS::system_memrealloc`.
+        //! @details This has the same semantic as `OS::memrealloc`.
+        void* system_memrealloc(void* ptr, usize size, usize alignment = 0);
+
+        //! Gets the allocated size of the memory block allocated by `OS::system_memalloc`.
+        usize system_memsize(void* ptr, usize alignment = 0);
+
+        //! Allocates memory pages from the system virtual memory.
+        //! @param[in] size The size to allocate. This must be times of the system page size.
+        //! @param[in] alignment The alignment of the returned address. This must be powers of 2 and not smaller than the system page size.
+        //! @return Returns the allocated pages, or `nullptr` if failed. The pages are zero-initialized.
+        void* virtual_alloc(usize size, usize alignment);
+
+        //! Frees memory pages allocated by `OS::virtual_alloc`.
+        //! @param[in] ptr The pointer returned by `OS::virtual_alloc`.
+        //! @param[in] size The size passed to `OS::virtual_alloc`.
+        void virtual_free(void* ptr, usize size);
+
+        //! Gets the system page size.
+        usize get_page_size();
+
+        //! Gets the system large page size, or `0` if large pages are not supported.
+        usize get_large_page_size();
+
+        //! Reserves one range of virtual address space without committing it.
+        //! @param[in] size The size to reserve. This must be times of the system page size.
+        //! @param[in] large_page Whether to use large pages if possible. See @ref VirtualMemoryFlag::large_page for details.
+        R<void*> virtual_reserve(usize size, bool large_page);
+
+        //! Commits pages reserved by `OS::virtual_reserve`. `ptr` and `size` must be aligned to the system page size.
+        RV virtual_commit(void* ptr, usize size);
+
+        //! Decommits pages reserved by `OS::virtual_reserve`. `ptr` and `size` must be aligned to the system page size.
+        RV virtual_decommit(void* ptr, usize size);
+
+        //! Releases one range reserved by `OS::virtual_reserve`.
+        //! @param[in] ptr The pointer returned by `OS::virtual_reserve`.
+        //! @param[in] size The size passed to `OS::virtual_reserve`.
+        void virtual_release(void* ptr, usize size);
+
         //! Global object creation function.
         template <typename _Ty, typename... _Args>
         _Ty* memnew(_Args&&... args)
@@ -148,6 +206,11 @@ namespace Luna
         //! @param[in] priority The priority to set.
         void set_thread_priority(opaque_t thread, ThreadPriority priority);
 
+        //! Sets the processors that the thread is allowed to run on.
+        //! @param[in] thread The thread handle.
+        //! @param[in] processor_mask The affinity mask. `0` means all processors.
+        RV set_thread_affinity(opaque_t thread, u64 processor_mask);
+
         //! Waits for the thread to finish.
         void wait_thread(opaque_t thread);
 
@@ -160,6 +223,21 @@ namespace Luna
         //! Gets the current thread handle.
         opaque_t get_current_thread_handle();
 
+        //! Converts the current thread to fiber, and returns the fiber handle of the current thread.
+        opaque_t convert_thread_to_fiber();
+
+        //! Converts the current thread back from fiber.
+        void convert_fiber_to_thread();
+
+        //! Creates one new fiber. The callback function must never return.
+        opaque_t new_fiber(thread_callback_func_t* callback, void* params, usize stack_size);
+
+        //! Deletes one fiber created by `new_fiber`.
+        void delete_fiber(opaque_t fiber);
+
+        //! Suspends the current fiber and runs the specified fiber.
+        void switch_to_fiber(opaque_t fiber);
+
         //! Suspends current thread for a specific period of time. The actual suspended time may be longer than required.
         //! @param[in] time_milliseconds The time, in milliseconds, that this thread needs to suspend.
         void sleep(u32 time_milliseconds);
@@ -260,6 +338,16 @@ namespace Luna
         //! Releases the semaphore acquired.
         void release_semaphore(opaque_t sema);
 
+        //! Blocks the current thread while the value at `address` equals to `expected`, or until the timeout is reached.
+        //! Returns `false` if the wait times out. The function may return spuriously.
+        bool wait_on_address(u32 volatile* address, u32 expected, u32 timeout_ms);
+
+        //! Wakes up at most one thread that is blocked by `wait_on_address` on `address`.
+        void wake_by_address_single(u32 volatile* address);
+
+        //! Wakes up all threads that are blocked by `wait_on_address` on `address`.
+        void wake_by_address_all(u32 volatile* address);
+
         //! Initializes read write lock object.
         //! The read write lock object have three modes: unlocked mode, read mode or write mode.
         //! 
@@ -346,6 +434,19 @@ namespace Luna
         //! @return The size of the file, or error code on failure.
         u64 get_file_size(opaque_t file);
 
+        //! Reads data from the specified position of the file without using or changing the file cursor on POSIX platforms. 
+        //! This can be called from multiple threads on the same file handle.
+        //! @param[in] file The file handle opened by `open_file`.
+        //! @param[in] offset The offset, in bytes, from the beginning of the file to read data from.
+        //! @param[in] buffer The buffer to write read data to.
+        //! @param[in] size The number of bytes to read.
+        //! @param[out] read_bytes If not `nullptr`, the system writes the actual size of bytes being read to this parameter.
+        RV read_file_at(opaque_t file, u64 offset, void* buffer, usize size, usize* read_bytes = nullptr);
+
+        //! Gets the platform handle of the file, which is `HANDLE` on Windows and the file descriptor on POSIX platforms.
+        //! @param[in] file The file handle opened by `open_file`.
+        opaque_t get_native_file_handle(opaque_t file);
+
         //! Sets the size of the file in bytes.
         //! If the current file size is smaller than the size to set and this call succeeded, the stream will be extended to the size specified
         //! with data between the last size and current size be uninitialized. If the current file size is greater than the size to set and this 
@@ -375,6 +476,29 @@ namespace Luna
         //! @param[in] file The file handle opened by `open_file`.
         void flush_file(opaque_t file);
 
+        //! Maps one file to the process address space for reading.
+        //! @param[in] path The path of the file.
+        //! @return Returns the file mapping handle if succeeds. Returns one error code if failed.
+        //! @par Possible Errors
+        //! * BasicError::access_denied
+        //! * BasicError::not_found
+        //! * BasicError::bad_platform_call for all errors that cannot be identified.
+        R<opaque_t> map_file(const c8* path);
+
+        //! Unmaps one file mapped by `map_file`.
+        //! @param[in] mapping The file mapping handle returned by `map_file`.
+        void unmap_file(opaque_t mapping);
+
+        //! Gets the pointer to the mapped file data.
+        //! @param[in] mapping The file mapping handle returned by `map_file`.
+        //! @return Returns the pointer to the mapped file data. Returns `nullptr` if the file is empty.
+        const void* get_mapped_file_data(opaque_t mapping);
+
+        //! Gets the size of the mapped file data.
+        //! @param[in] mapping The file mapping handle returned by `map_file`.
+        //! @return Returns the size of the mapped file data in bytes.
+        usize get_mapped_file_size(opaque_t mapping);
+
         //! Gets the attribute/status of one file or directory.
         //! @param[in] path The path of the file to get.
         //! @return The file attribute structure if succeeded, returns error code if failed.
@@ -460,6 +584,10 @@ namespace Luna
         //! Returns the number of logical processors on the platform.
         u32 get_num_processors();
 
+        //! Returns the index of the last-level cache domain of the specified logical processor, or `0` if 
+        //! the cache topology cannot be queried.
+        u32 get_processor_cache_domain(u32 processor);
+
         //! Reads one string from the standard input.
         //! @param[in] buffer The buffer used to accept the input stream.
         //! @param[in] size The number of `c8` characters to read from the input stream.
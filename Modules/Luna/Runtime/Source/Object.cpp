@@ -21,18 +21,53 @@
 
 namespace Luna
 {
+    constexpr Guid thread_confined_data_guid("{5E0C7B1A-3D52-4F86-9A2E-7C41B8D06F93}");
+
+    enum ObjectFlag : u32
+    {
+        OBJECT_FLAG_THREAD_CONFINED = 1,
+    };
+
+#ifdef LUNA_DEBUG
+    // The address of one thread-local variable is unique for every alive thread, and is cheaper to fetch than
+    // the thread object.
+    static thread_local u8 tls_thread_tag;
+    inline const void* get_thread_tag()
+    {
+        return &tls_thread_tag;
+    }
+#endif
+
     struct ObjectHeader
     {
         typeinfo_t type;
         ref_count_t ref_count;
         ref_count_t weak_ref_count;
         u32 expired;
+        u32 flags;
+#ifdef LUNA_DEBUG
+        const void* owning_thread;
+#endif
         ObjectHeader() :
             ref_count(1)
             , weak_ref_count(0)
             , expired(0)
+            , flags(0)
+#ifdef LUNA_DEBUG
+            , owning_thread(nullptr)
+#endif
         {}
         ~ObjectHeader() {}
+        bool is_thread_confined() const
+        {
+            return (flags & OBJECT_FLAG_THREAD_CONFINED) != 0;
+        }
+        void check_thread() const
+        {
+#ifdef LUNA_DEBUG
+            luassert_msg(owning_thread == get_thread_tag(), "One thread-confined object is accessed from one thread other than its owning thread.");
+#endif
+        }
         object_t get_object() const
         {
             return (void*)((usize)this + sizeof(ObjectHeader));
@@ -86,6 +121,13 @@ namespace Luna
         ObjectHeader* header = get_header(object);
         new (header) ObjectHeader();
         header->type = type;
+        if (is_type_thread_confined(type))
+        {
+            header->flags |= OBJECT_FLAG_THREAD_CONFINED;
+#ifdef LUNA_DEBUG
+            header->owning_thread = get_thread_tag();
+#endif
+        }
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
         Name type_name = get_type_name(type);
         memory_profiler_set_memory_type(mem, type_name.c_str(), type_name.size());
@@ -95,12 +137,27 @@ namespace Luna
 
     LUNA_RUNTIME_API ref_count_t object_retain(object_t object_ptr)
     {
-        return atom_inc_i32(&(get_header(object_ptr)->ref_count));
+        ObjectHeader* header = get_header(object_ptr);
+        if (header->is_thread_confined())
+        {
+            header->check_thread();
+            return ++header->ref_count;
+        }
+        return atom_inc_i32(&(header->ref_count));
     }
     LUNA_RUNTIME_API ref_count_t object_release(object_t object_ptr)
     {
         ObjectHeader* header = get_header(object_ptr);
-        ref_count_t r = atom_dec_i32(&(header->ref_count));
+        ref_count_t r;
+        if (header->is_thread_confined())
+        {
+            header->check_thread();
+            r = --header->ref_count;
+        }
+        else
+        {
+            r = atom_dec_i32(&(header->ref_count));
+        }
         if (!r)
         {
             header->expire();
@@ -117,12 +174,27 @@ namespace Luna
     }
     LUNA_RUNTIME_API ref_count_t object_retain_weak(object_t object_ptr)
     {
-        return atom_inc_i32(&(get_header(object_ptr)->weak_ref_count));
+        ObjectHeader* header = get_header(object_ptr);
+        if (header->is_thread_confined())
+        {
+            header->check_thread();
+            return ++header->weak_ref_count;
+        }
+        return atom_inc_i32(&(header->weak_ref_count));
     }
     LUNA_RUNTIME_API ref_count_t object_release_weak(object_t object_ptr)
     {
         ObjectHeader* header = get_header(object_ptr);
-        ref_count_t r = atom_dec_i32(&(header->weak_ref_count));
+        ref_count_t r;
+        if (header->is_thread_confined())
+        {
+            header->check_thread();
+            r = --header->weak_ref_count;
+        }
+        else
+        {
+            r = atom_dec_i32(&(header->weak_ref_count));
+        }
         if (!r && !(header->ref_count))
         {
             header->destroy();
@@ -140,6 +212,13 @@ namespace Luna
     LUNA_RUNTIME_API bool object_retain_if_not_expired(object_t object_ptr)
     {
         ObjectHeader* header = get_header(object_ptr);
+        if (header->is_thread_confined())
+        {
+            header->check_thread();
+            if (!header->ref_count) return false;
+            ++header->ref_count;
+            return true;
+        }
         while (true)
         {
             ref_count_t tmp = static_cast<ref_count_t const volatile&>(header->ref_count);
@@ -147,6 +226,53 @@ namespace Luna
             if (atom_compare_exchange_i32(&(header->ref_count), tmp + 1, tmp) == tmp) return true;
         }
     }
+    LUNA_RUNTIME_API void object_set_thread_confined(object_t object_ptr, bool thread_confined)
+    {
+        ObjectHeader* header = get_header(object_ptr);
+        if (thread_confined)
+        {
+            header->flags |= OBJECT_FLAG_THREAD_CONFINED;
+#ifdef LUNA_DEBUG
+            header->owning_thread = get_thread_tag();
+#endif
+        }
+        else
+        {
+            header->check_thread();
+            header->flags &= ~OBJECT_FLAG_THREAD_CONFINED;
+#ifdef LUNA_DEBUG
+            header->owning_thread = nullptr;
+#endif
+        }
+    }
+    LUNA_RUNTIME_API bool object_is_thread_confined(object_t object_ptr)
+    {
+        return get_header(object_ptr)->is_thread_confined();
+    }
+    LUNA_RUNTIME_API bool object_is_accessible_from_current_thread(object_t object_ptr)
+    {
+#ifdef LUNA_DEBUG
+        ObjectHeader* header = get_header(object_ptr);
+        return !header->is_thread_confined() || header->owning_thread == get_thread_tag();
+#else
+        return true;
+#endif
+    }
+    LUNA_RUNTIME_API void set_type_thread_confined(typeinfo_t type, bool thread_confined)
+    {
+        if (thread_confined)
+        {
+            set_type_private_data(type, thread_confined_data_guid, sizeof(u8));
+        }
+        else
+        {
+            set_type_private_data(type, thread_confined_data_guid, 0);
+        }
+    }
+    LUNA_RUNTIME_API bool is_type_thread_confined(typeinfo_t type)
+    {
+        return get_type_private_data(type, thread_confined_data_guid) != nullptr;
+    }
     LUNA_RUNTIME_API typeinfo_t get_object_type(object_t object_ptr)
     {
         return get_header(object_ptr)->type;
@@ -0,0 +1,175 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PerfCounter.cpp
+* @author JXMaster
+* @date 2024/5/20
+*/
+#include "../PlatformDefines.hpp"
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "../PerfCounter.hpp"
+#include "../SpinLock.hpp"
+#include "../Atomic.hpp"
+#include "OS.hpp"
+
+namespace Luna
+{
+    // Counter values added by one thread.
+    // Values are written only by the owning thread, and are read by other threads when counters are queried.
+    struct PerfCounterThreadContext
+    {
+        i64 volatile m_values[MAX_PERF_COUNTERS] = {};
+        PerfCounterThreadContext* m_prev_context = nullptr;
+        PerfCounterThreadContext* m_next_context = nullptr;
+    };
+
+    struct PerfCounterEntry
+    {
+        c8* m_name;
+        c8* m_unit;
+        PerfCounterType m_type;
+    };
+
+    // Counter descriptions are written only once when counters are registered, and the number of counters is
+    // published after the description is written, so descriptions can be read without locking.
+    PerfCounterEntry g_perf_counters[MAX_PERF_COUNTERS];
+    u32 volatile g_num_perf_counters = 0;
+    // Values set by `perf_counter_set`.
+    i64 volatile g_perf_counter_bases[MAX_PERF_COUNTERS];
+    // Values added by threads that have exited.
+    i64 g_retired_perf_counter_values[MAX_PERF_COUNTERS];
+    PerfCounterThreadContext* g_perf_counter_contexts = nullptr;
+    SpinLock g_perf_counter_lock;
+    opaque_t g_perf_counter_tls;
+    bool g_perf_counter_inited = false;
+
+    static c8* copy_perf_counter_string(const c8* str)
+    {
+        if (!str) return nullptr;
+        usize size = strlen(str);
+        c8* r = (c8*)OS::memalloc(size + 1);
+        memcpy(r, str, size + 1);
+        return r;
+    }
+
+    static void perf_counter_thread_context_dtor(void* data)
+    {
+        PerfCounterThreadContext* ctx = (PerfCounterThreadContext*)data;
+        if (!ctx) return;
+        LockGuard guard(g_perf_counter_lock);
+        for (u32 i = 0; i < MAX_PERF_COUNTERS; ++i)
+        {
+            g_retired_perf_counter_values[i] += ctx->m_values[i];
+        }
+        if (ctx->m_prev_context) ctx->m_prev_context->m_next_context = ctx->m_next_context;
+        else g_perf_counter_contexts = ctx->m_next_context;
+        if (ctx->m_next_context) ctx->m_next_context->m_prev_context = ctx->m_prev_context;
+        guard.unlock();
+        OS::memdelete(ctx);
+    }
+
+    static PerfCounterThreadContext* get_perf_counter_thread_context()
+    {
+        PerfCounterThreadContext* ctx = (PerfCounterThreadContext*)OS::tls_get(g_perf_counter_tls);
+        if (!ctx)
+        {
+            ctx = OS::memnew<PerfCounterThreadContext>();
+            OS::tls_set(g_perf_counter_tls, ctx);
+            LockGuard guard(g_perf_counter_lock);
+            ctx->m_next_context = g_perf_counter_contexts;
+            if (g_perf_counter_contexts) g_perf_counter_contexts->m_prev_context = ctx;
+            g_perf_counter_contexts = ctx;
+        }
+        return ctx;
+    }
+
+    void perf_counter_init()
+    {
+        g_perf_counter_tls = OS::tls_alloc(perf_counter_thread_context_dtor);
+        g_perf_counter_inited = true;
+    }
+
+    void perf_counter_close()
+    {
+        g_perf_counter_inited = false;
+        // Contexts of threads that are still alive are freed here, since TLS destructors are not called after the
+        // slot is freed.
+        PerfCounterThreadContext* ctx = g_perf_counter_contexts;
+        while (ctx)
+        {
+            PerfCounterThreadContext* next = ctx->m_next_context;
+            OS::memdelete(ctx);
+            ctx = next;
+        }
+        g_perf_counter_contexts = nullptr;
+        OS::tls_free(g_perf_counter_tls);
+        for (u32 i = 0; i < g_num_perf_counters; ++i)
+        {
+            OS::memfree(g_perf_counters[i].m_name);
+            if (g_perf_counters[i].m_unit) OS::memfree(g_perf_counters[i].m_unit);
+            g_perf_counter_bases[i] = 0;
+            g_retired_perf_counter_values[i] = 0;
+        }
+        g_num_perf_counters = 0;
+    }
+
+    LUNA_RUNTIME_API perf_counter_t register_perf_counter(const c8* name, PerfCounterType type, const c8* unit)
+    {
+        luassert(name);
+        LockGuard guard(g_perf_counter_lock);
+        for (u32 i = 0; i < g_num_perf_counters; ++i)
+        {
+            if (!strcmp(g_perf_counters[i].m_name, name)) return i + 1;
+        }
+        if (g_num_perf_counters >= MAX_PERF_COUNTERS) return 0;
+        PerfCounterEntry& entry = g_perf_counters[g_num_perf_counters];
+        entry.m_name = copy_perf_counter_string(name);
+        entry.m_unit = copy_perf_counter_string(unit);
+        entry.m_type = type;
+        return atom_inc_u32(&g_num_perf_counters);
+    }
+
+    LUNA_RUNTIME_API void perf_counter_add(perf_counter_t counter, i64 delta)
+    {
+        if (!counter || !g_perf_counter_inited) return;
+        PerfCounterThreadContext* ctx = get_perf_counter_thread_context();
+        ctx->m_values[counter - 1] += delta;
+    }
+
+    LUNA_RUNTIME_API void perf_counter_set(perf_counter_t counter, i64 value)
+    {
+        if (!counter) return;
+        atom_exchange_i64(&g_perf_counter_bases[counter - 1], value);
+    }
+
+    LUNA_RUNTIME_API i64 get_perf_counter_value(perf_counter_t counter)
+    {
+        if (!counter || counter > g_num_perf_counters) return 0;
+        u32 index = counter - 1;
+        LockGuard guard(g_perf_counter_lock);
+        i64 r = g_perf_counter_bases[index] + g_retired_perf_counter_values[index];
+        for (PerfCounterThreadContext* ctx = g_perf_counter_contexts; ctx; ctx = ctx->m_next_context)
+        {
+            r += ctx->m_values[index];
+        }
+        return r;
+    }
+
+    LUNA_RUNTIME_API u32 get_num_perf_counters()
+    {
+        return g_num_perf_counters;
+    }
+
+    LUNA_RUNTIME_API PerfCounterDesc get_perf_counter_desc(perf_counter_t counter)
+    {
+        luassert(counter && counter <= g_num_perf_counters);
+        const PerfCounterEntry& entry = g_perf_counters[counter - 1];
+        PerfCounterDesc desc;
+        desc.name = entry.m_name;
+        desc.unit = entry.m_unit;
+        desc.type = entry.m_type;
+        return desc;
+    }
+}
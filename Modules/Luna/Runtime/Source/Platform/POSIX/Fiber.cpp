@@ -0,0 +1,96 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Fiber.cpp
+* @author JXMaster
+* @date 2024/3/8
+*/
+#ifdef __APPLE__
+// ucontext functions are only available with _XOPEN_SOURCE on macOS.
+#define _XOPEN_SOURCE 600
+#endif
+#include "../../OS.hpp"
+#include <ucontext.h>
+
+namespace Luna
+{
+    namespace OS
+    {
+        struct Fiber
+        {
+            ucontext_t m_context;
+            thread_callback_func_t* m_func = nullptr;
+            void* m_params = nullptr;
+            // `nullptr` for fibers converted from threads.
+            void* m_stack = nullptr;
+        };
+
+        // The fiber that is running on the current thread.
+        static thread_local Fiber* tls_current_fiber;
+
+        static void posix_fiber_main()
+        {
+            // `tls_current_fiber` is set to the new fiber before we switch to it.
+            Fiber* f = tls_current_fiber;
+            f->m_func(f->m_params);
+            lupanic_msg_always("The fiber entry function must not return.");
+        }
+        opaque_t convert_thread_to_fiber()
+        {
+            luassert(!tls_current_fiber);
+            Fiber* f = memnew<Fiber>();
+            tls_current_fiber = f;
+            return f;
+        }
+        void convert_fiber_to_thread()
+        {
+            Fiber* f = tls_current_fiber;
+            luassert(f && !f->m_stack);
+            memdelete(f);
+            tls_current_fiber = nullptr;
+        }
+        opaque_t new_fiber(thread_callback_func_t* callback, void* params, usize stack_size)
+        {
+            Fiber* f = memnew<Fiber>();
+            f->m_func = callback;
+            f->m_params = params;
+            if (stack_size == 0)
+            {
+                stack_size = 256_kb;
+            }
+            f->m_stack = memalloc(stack_size, 16);
+            if (getcontext(&f->m_context) != 0)
+            {
+                memfree(f->m_stack, 16);
+                memdelete(f);
+                lupanic_msg_always("getcontext failed.");
+            }
+            f->m_context.uc_stack.ss_sp = f->m_stack;
+            f->m_context.uc_stack.ss_size = stack_size;
+            f->m_context.uc_link = nullptr;
+            makecontext(&f->m_context, posix_fiber_main, 0);
+            return f;
+        }
+        void delete_fiber(opaque_t fiber)
+        {
+            Fiber* f = (Fiber*)fiber;
+            luassert(f != tls_current_fiber);
+            if (f->m_stack)
+            {
+                memfree(f->m_stack, 16);
+            }
+            memdelete(f);
+        }
+        void switch_to_fiber(opaque_t fiber)
+        {
+            Fiber* from = tls_current_fiber;
+            Fiber* to = (Fiber*)fiber;
+            luassert(from);
+            tls_current_fiber = to;
+            swapcontext(&from->m_context, &to->m_context);
+            // Do not access thread-local variables here, since the fiber may be resumed on another thread.
+        }
+    }
+}
@@ -22,6 +22,8 @@
 
 #include <fcntl.h>
 #include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
 #include <dirent.h>
 
 #ifdef LUNA_PLATFORM_MACOS
@@ -457,6 +459,18 @@ namespace Luna
             {
                 return f;
             }
+            if (test_flags(flags, FileOpenFlag::sequential_scan))
+            {
+                // Readahead hints are advisory, so failures are ignored.
+                int fd = buffered ? fileno((FILE*)f.get()) : (int)(usize)f.get();
+#if defined(LUNA_PLATFORM_LINUX) || defined(LUNA_PLATFORM_ANDROID)
+                posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#elif defined(LUNA_PLATFORM_MACOS) || defined(LUNA_PLATFORM_IOS)
+                fcntl(fd, F_RDAHEAD, 1);
+#else
+                (void)fd;
+#endif
+            }
             File* ret = Luna::memnew<File>();
             ret->buffered = buffered;
             ret->handle = f.get();
@@ -481,6 +495,33 @@ namespace Luna
             return f->buffered ? write_buffered_file(f->handle, buffer, size, write_bytes) :
                 write_unbuffered_file(f->handle, buffer, size, write_bytes);
         }
+        opaque_t get_native_file_handle(opaque_t file)
+        {
+            File* f = (File*)file;
+            int fd = f->buffered ? fileno((FILE*)f->handle) : (int)(usize)f->handle;
+            return (opaque_t)(usize)fd;
+        }
+        RV read_file_at(opaque_t file, u64 offset, void* buffer, usize size, usize* read_bytes)
+        {
+            File* f = (File*)file;
+            int fd = f->buffered ? fileno((FILE*)f->handle) : (int)(usize)f->handle;
+            usize total = 0;
+            while (total < size)
+            {
+                isize sz = ::pread(fd, (byte_t*)buffer + total, size - total, (off_t)(offset + total));
+                if (sz == -1)
+                {
+                    if (errno == EINTR) continue;
+                    if (read_bytes) *read_bytes = total;
+                    return BasicError::bad_platform_call();
+                }
+                // End of file.
+                if (sz == 0) break;
+                total += (usize)sz;
+            }
+            if (read_bytes) *read_bytes = total;
+            return ok;
+        }
         u64 get_file_size(opaque_t file)
         {
             File* f = (File*)file;
@@ -507,6 +548,68 @@ namespace Luna
             if (f->buffered) flush_buffered_file(f->handle);
             else flush_unbuffered_file(f->handle);
         }
+        struct MappedFile
+        {
+            void* data;
+            usize size;
+        };
+        R<opaque_t> map_file(const c8* path)
+        {
+            lucheck(path);
+            int fd = open(path, O_RDONLY, 0);
+            if (fd == -1)
+            {
+                auto err = errno;
+                switch (err)
+                {
+                case EPERM:
+                case EACCES:
+                    return BasicError::access_denied();
+                case ENOENT:
+                    return BasicError::not_found();
+                default:
+                    return BasicError::bad_platform_call();
+                }
+            }
+            struct stat s;
+            if (fstat(fd, &s) != 0)
+            {
+                ::close(fd);
+                return BasicError::bad_platform_call();
+            }
+            usize size = (usize)s.st_size;
+            void* data = nullptr;
+            // Empty files cannot be mapped.
+            if (size)
+            {
+                data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+                if (data == MAP_FAILED)
+                {
+                    ::close(fd);
+                    return BasicError::bad_platform_call();
+                }
+            }
+            // The mapping is still valid after the file descriptor is closed.
+            ::close(fd);
+            MappedFile* ret = Luna::memnew<MappedFile>();
+            ret->data = data;
+            ret->size = size;
+            return ret;
+        }
+        void unmap_file(opaque_t mapping)
+        {
+            MappedFile* m = (MappedFile*)mapping;
+            if (m->data) munmap(m->data, m->size);
+            Luna::memdelete(m);
+        }
+        const void* get_mapped_file_data(opaque_t mapping)
+        {
+            return ((MappedFile*)mapping)->data;
+        }
+        usize get_mapped_file_size(opaque_t mapping)
+        {
+            return ((MappedFile*)mapping)->size;
+        }
         R<FileAttribute> get_file_attribute(const c8* path)
         {
             struct stat s;
@@ -548,7 +651,7 @@ namespace Luna
             opaque_t to_file = nullptr;
             lutry
             {
-                luset(from_file, OS::open_file(from_path, FileOpenFlag::read, FileCreationMode::open_existing));
+                luset(from_file, OS::open_file(from_path, FileOpenFlag::read | FileOpenFlag::sequential_scan, FileCreationMode::open_existing));
                 if (test_flags(flags, FileCopyFlag::fail_if_exists))
                 {
                     luset(to_file, OS::open_file(to_path, FileOpenFlag::write, FileCreationMode::create_new));
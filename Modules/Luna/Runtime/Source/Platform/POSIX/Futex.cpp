@@ -0,0 +1,132 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Futex.cpp
+* @author JXMaster
+* @date 2024/5/11
+*/
+#include "../../OS.hpp"
+#include "../../../Assert.hpp"
+#include <errno.h>
+#include <time.h>
+
+#if defined(LUNA_PLATFORM_LINUX) || defined(LUNA_PLATFORM_ANDROID)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <limits.h>
+#elif defined(LUNA_PLATFORM_APPLE)
+// Private but stable system calls used by the system C++ library to implement `std::atomic::wait`.
+extern "C" int __ulock_wait(uint32_t operation, void* addr, uint64_t value, uint32_t timeout_us);
+extern "C" int __ulock_wake(uint32_t operation, void* addr, uint64_t wake_value);
+#define LUNA_UL_COMPARE_AND_WAIT 1
+#define LUNA_ULF_WAKE_ALL 0x00000100
+#define LUNA_ULF_NO_ERRNO 0x01000000
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#endif
+
+namespace Luna
+{
+    namespace OS
+    {
+#if defined(LUNA_PLATFORM_LINUX) || defined(LUNA_PLATFORM_ANDROID)
+        bool wait_on_address(u32 volatile* address, u32 expected, u32 timeout_ms)
+        {
+            struct timespec timeout;
+            struct timespec* ptimeout = nullptr;
+            if (timeout_ms != U32_MAX)
+            {
+                timeout.tv_sec = timeout_ms / 1000;
+                timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000;
+                ptimeout = &timeout;
+            }
+            long r = syscall(SYS_futex, (u32*)address, FUTEX_WAIT_PRIVATE, expected, ptimeout, nullptr, 0);
+            return !(r == -1 && errno == ETIMEDOUT);
+        }
+        void wake_by_address_single(u32 volatile* address)
+        {
+            syscall(SYS_futex, (u32*)address, FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+        }
+        void wake_by_address_all(u32 volatile* address)
+        {
+            syscall(SYS_futex, (u32*)address, FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+        }
+#elif defined(LUNA_PLATFORM_APPLE)
+        bool wait_on_address(u32 volatile* address, u32 expected, u32 timeout_ms)
+        {
+            // 0 means waiting infinitely.
+            u32 timeout_us = 0;
+            if (timeout_ms != U32_MAX)
+            {
+                timeout_us = timeout_ms >= U32_MAX / 1000 ? U32_MAX : max<u32>(timeout_ms * 1000, 1);
+            }
+            int r = __ulock_wait(LUNA_UL_COMPARE_AND_WAIT | LUNA_ULF_NO_ERRNO, (void*)address, expected, timeout_us);
+            return r != -ETIMEDOUT;
+        }
+        void wake_by_address_single(u32 volatile* address)
+        {
+            __ulock_wake(LUNA_UL_COMPARE_AND_WAIT | LUNA_ULF_NO_ERRNO, (void*)address, 0);
+        }
+        void wake_by_address_all(u32 volatile* address)
+        {
+            __ulock_wake(LUNA_UL_COMPARE_AND_WAIT | LUNA_ULF_WAKE_ALL | LUNA_ULF_NO_ERRNO, (void*)address, 0);
+        }
+#else
+        // Platforms without address-based waiting use one parking lot: waiting threads are parked on one 
+        // condition variable chosen by hashing the address, and all threads parked on the same bucket are waken up 
+        // when any address in the bucket is woken, so that threads waiting on different addresses do not miss wakes.
+        constexpr usize NUM_PARKING_BUCKETS = 64;
+        struct ParkingBucket
+        {
+            pthread_mutex_t m_mutex = PTHREAD_MUTEX_INITIALIZER;
+            pthread_cond_t m_cond = PTHREAD_COND_INITIALIZER;
+        };
+        static ParkingBucket g_parking_buckets[NUM_PARKING_BUCKETS];
+        inline ParkingBucket& get_parking_bucket(u32 volatile* address)
+        {
+            return g_parking_buckets[(((usize)address) >> 2) % NUM_PARKING_BUCKETS];
+        }
+        bool wait_on_address(u32 volatile* address, u32 expected, u32 timeout_ms)
+        {
+            ParkingBucket& bucket = get_parking_bucket(address);
+            bool ret = true;
+            luassert_msg_always(pthread_mutex_lock(&bucket.m_mutex) == 0, "pthread_mutex_lock failed.");
+            if (*address == expected)
+            {
+                if (timeout_ms == U32_MAX)
+                {
+                    luassert_msg_always(pthread_cond_wait(&bucket.m_cond, &bucket.m_mutex) == 0, "pthread_cond_wait failed.");
+                }
+                else
+                {
+                    struct timeval tv;
+                    gettimeofday(&tv, NULL);
+                    u64 nsec = (u64)tv.tv_usec * 1000 + (u64)(timeout_ms % 1000) * 1000000;
+                    struct timespec abstime;
+                    abstime.tv_sec = tv.tv_sec + timeout_ms / 1000 + (time_t)(nsec / 1000000000);
+                    abstime.tv_nsec = (long)(nsec % 1000000000);
+                    ret = pthread_cond_timedwait(&bucket.m_cond, &bucket.m_mutex, &abstime) != ETIMEDOUT;
+                }
+            }
+            luassert_msg_always(pthread_mutex_unlock(&bucket.m_mutex) == 0, "pthread_mutex_unlock failed.");
+            return ret;
+        }
+        void wake_by_address_all(u32 volatile* address)
+        {
+            ParkingBucket& bucket = get_parking_bucket(address);
+            // Locking the bucket ensures that one thread that has checked the value is blocked before it is waken.
+            luassert_msg_always(pthread_mutex_lock(&bucket.m_mutex) == 0, "pthread_mutex_lock failed.");
+            pthread_cond_broadcast(&bucket.m_cond);
+            luassert_msg_always(pthread_mutex_unlock(&bucket.m_mutex) == 0, "pthread_mutex_unlock failed.");
+        }
+        void wake_by_address_single(u32 volatile* address)
+        {
+            wake_by_address_all(address);
+        }
+#endif
+    }
+}
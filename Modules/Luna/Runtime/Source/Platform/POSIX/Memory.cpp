@@ -13,6 +13,7 @@
 #include "../../../Error.hpp"
 #include <pthread.h>
 #include <stdlib.h>
+#include <unistd.h>
 #include "../../../Algorithm.hpp"
 
 #ifdef LUNA_PLATFORM_MACOS
@@ -25,7 +26,7 @@ namespace Luna
 {
     namespace OS
     {
-        void* memalloc(usize size, usize alignment /* = 0 */)
+        void* system_memalloc(usize size, usize alignment /* = 0 */)
         {
             if (!size) return nullptr;
             if (alignment <= MAX_ALIGN) return malloc(size);
@@ -35,7 +36,7 @@ namespace Luna
             *((isize*)(aligned_ptr)-1) = offset;
             return (void*)aligned_ptr;
         }
-        void memfree(void* ptr, usize alignment /* = 0 */)
+        void system_memfree(void* ptr, usize alignment /* = 0 */)
         {
             if (!ptr) return;
             if (alignment <= MAX_ALIGN)
@@ -49,7 +50,25 @@ namespace Luna
                 free(origin_ptr);
             }
         }
-        usize memsize(void* ptr, usize alignment /* = 0 */)
+        void* system_memrealloc(void* ptr, usize size, usize alignment /* = 0 */)
+        {
+            // `realloc` extends the block in place if possible, and remaps pages for large blocks allocated by `mmap`.
+            if (alignment <= MAX_ALIGN) return realloc(ptr, size);
+            usize copy_size = min(system_memsize(ptr, alignment), size);
+            isize offset = *(((isize*)ptr) - 1);
+            usize origin_ptr = (usize)realloc((void*)(((usize)ptr) - offset), size + alignment);
+            if (!origin_ptr) return nullptr;
+            usize aligned_ptr = align_upper(origin_ptr + 1, alignment);
+            isize new_offset = aligned_ptr - origin_ptr;
+            if (new_offset != offset)
+            {
+                // The block is moved to one address with different alignment, so we need to move data to the new aligned address.
+                memmove((void*)aligned_ptr, (void*)(origin_ptr + offset), copy_size);
+                *((isize*)(aligned_ptr)-1) = new_offset;
+            }
+            return (void*)aligned_ptr;
+        }
+        usize system_memsize(void* ptr, usize alignment /* = 0 */)
         {
             if (!ptr) return 0;
             if (alignment <= MAX_ALIGN)
@@ -68,5 +87,104 @@ namespace Luna
             return malloc_usable_size(origin_ptr) - offset;
 #endif
         }
+        void* virtual_alloc(usize size, usize alignment)
+        {
+            // Reserves more pages than needed and trims unaligned head and tail pages.
+            usize reserve_size = size + alignment;
+            void* mem = mmap(nullptr, reserve_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (mem == MAP_FAILED) return nullptr;
+            usize begin = (usize)mem;
+            usize aligned_begin = align_upper(begin, alignment);
+            if (aligned_begin != begin)
+            {
+                munmap(mem, aligned_begin - begin);
+            }
+            usize end = begin + reserve_size;
+            usize aligned_end = aligned_begin + size;
+            if (aligned_end != end)
+            {
+                munmap((void*)aligned_end, end - aligned_end);
+            }
+            return (void*)aligned_begin;
+        }
+        void virtual_free(void* ptr, usize size)
+        {
+            munmap(ptr, size);
+        }
+        usize get_page_size()
+        {
+            static usize page_size = (usize)sysconf(_SC_PAGESIZE);
+            return page_size;
+        }
+        usize get_large_page_size()
+        {
+#ifdef MADV_HUGEPAGE
+            // Transparent huge pages are 2MB on all architectures we supported.
+            return 2_mb;
+#else
+            return 0;
+#endif
+        }
+        static ErrCode translate_mmap_error(int err)
+        {
+            switch (err)
+            {
+            case ENOMEM:
+            case EAGAIN:
+                return BasicError::out_of_memory();
+            case EINVAL:
+                return BasicError::bad_arguments();
+            case EACCES:
+            case EPERM:
+                return BasicError::access_denied();
+            default:
+                return BasicError::bad_platform_call();
+            }
+        }
+        R<void*> virtual_reserve(usize size, bool large_page)
+        {
+            usize alignment = large_page ? get_large_page_size() : 0;
+            // Reserved pages are mapped with no access, so they do not consume physical memory or swap space.
+            usize reserve_size = alignment ? size + alignment : size;
+            void* mem = mmap(nullptr, reserve_size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+            if (mem == MAP_FAILED) return translate_mmap_error(errno);
+            if (!alignment) return mem;
+            // Huge pages can only be used for aligned ranges, so trims unaligned head and tail pages.
+            usize begin = (usize)mem;
+            usize aligned_begin = align_upper(begin, alignment);
+            if (aligned_begin != begin)
+            {
+                munmap(mem, aligned_begin - begin);
+            }
+            usize end = begin + reserve_size;
+            usize aligned_end = aligned_begin + size;
+            if (aligned_end != end)
+            {
+                munmap((void*)aligned_end, end - aligned_end);
+            }
+#ifdef MADV_HUGEPAGE
+            // This is only a hint, so errors are ignored.
+            madvise((void*)aligned_begin, size, MADV_HUGEPAGE);
+#endif
+            return (void*)aligned_begin;
+        }
+        RV virtual_commit(void* ptr, usize size)
+        {
+            // Physical pages are allocated by the system when they are accessed for the first time.
+            if (mprotect(ptr, size, PROT_READ | PROT_WRITE) != 0) return translate_mmap_error(errno);
+            return ok;
+        }
+        RV virtual_decommit(void* ptr, usize size)
+        {
+            // Mapping new anonymous pages over the range discards old pages and their content, 
+            // while keeping the address range reserved.
+            void* mem = mmap(ptr, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+            if (mem == MAP_FAILED) return translate_mmap_error(errno);
+            return ok;
+        }
+        void virtual_release(void* ptr, usize size)
+        {
+            munmap(ptr, size);
+        }
     }
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include <sys/sysctl.h>
 #else
 #include <unistd.h>
+#include <stdio.h>
 #endif
 
 namespace Luna
@@ -55,5 +56,25 @@ namespace Luna
             return (u32)processor_count;
 #endif
         }
+
+        u32 get_processor_cache_domain(u32 processor)
+        {
+#ifdef LUNA_PLATFORM_LINUX
+            // Use the first processor that shares the last-level cache with the specified processor as the domain index.
+            // index3 is the L3 cache on most platforms, fall back to the L2 cache if the processor does not have L3 cache.
+            for (u32 cache_index = 3; cache_index >= 2; --cache_index)
+            {
+                c8 path[128];
+                snprintf(path, 128, "/sys/devices/system/cpu/cpu%u/cache/index%u/shared_cpu_list", processor, cache_index);
+                FILE* f = fopen(path, "r");
+                if (!f) continue;
+                unsigned int first_processor;
+                int r = fscanf(f, "%u", &first_processor);
+                fclose(f);
+                if (r == 1) return (u32)first_processor;
+            }
+#endif
+            return 0;
+        }
     }
 }
\ No newline at end of file
@@ -41,6 +41,9 @@ struct Thread
 
 thread_local Thread* tls_current_thread;
 
+// The thread record for the main thread, which is not created by `new_thread`.
+static Thread g_main_thread;
+
 static void* posix_thread_main(void* cookie)
 {
     Thread* t = (Thread*)cookie;
@@ -125,6 +128,32 @@ void set_thread_priority(opaque_t thread, ThreadPriority priority)
     }
 }
 
+RV set_thread_affinity(opaque_t thread, u64 processor_mask)
+{
+#ifdef LUNA_PLATFORM_LINUX
+    Thread* t = (Thread*)thread;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    u32 num_processors = min<u32>(get_num_processors(), 64);
+    for (u32 i = 0; i < num_processors; ++i)
+    {
+        if (!processor_mask || (processor_mask & ((u64)1 << i)))
+        {
+            CPU_SET(i, &set);
+        }
+    }
+    int r = pthread_setaffinity_np(t->m_handle, sizeof(cpu_set_t), &set);
+    if (r != 0)
+    {
+        return BasicError::bad_platform_call();
+    }
+    return ok;
+#else
+    // macOS does not support binding threads to processors.
+    return BasicError::not_supported();
+#endif
+}
+
 //! Waits for the thread to finish.
 void wait_thread(opaque_t thread)
 {
@@ -150,6 +179,13 @@ void detach_thread(opaque_t thread)
 //! Gets the current thread handle.
 opaque_t get_current_thread_handle()
 {
+    if (!tls_current_thread)
+    {
+        // This is only called for the main thread.
+        g_main_thread.m_handle = pthread_self();
+        pthread_getschedparam(g_main_thread.m_handle, &(g_main_thread.m_sched_policy), &(g_main_thread.m_sched_param));
+        tls_current_thread = &g_main_thread;
+    }
     return tls_current_thread;
 }
 void sleep(u32 time_milliseconds)
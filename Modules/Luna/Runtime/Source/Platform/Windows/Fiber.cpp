@@ -0,0 +1,90 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Fiber.cpp
+* @author JXMaster
+* @date 2024/3/8
+*/
+#include "../../OS.hpp"
+#include "../../../Platform/Windows/MiniWin.hpp"
+
+namespace Luna
+{
+    namespace OS
+    {
+        struct Fiber
+        {
+            LPVOID m_handle;
+            thread_callback_func_t* m_func;
+            void* m_params;
+        };
+    }
+}
+static VOID WINAPI WinFiberEntry(LPVOID cookie)
+{
+    using namespace Luna;
+    using namespace Luna::OS;
+    Fiber* f = (Fiber*)cookie;
+    f->m_func(f->m_params);
+    lupanic_msg_always("The fiber entry function must not return.");
+}
+namespace Luna
+{
+    namespace OS
+    {
+        opaque_t convert_thread_to_fiber()
+        {
+            Fiber* f = Luna::memnew<Fiber>();
+            f->m_func = nullptr;
+            f->m_params = nullptr;
+            f->m_handle = ::ConvertThreadToFiber(f);
+            if (!f->m_handle)
+            {
+                Luna::memdelete(f);
+                lupanic_msg_always("ConvertThreadToFiber failed.");
+            }
+            return f;
+        }
+        void convert_fiber_to_thread()
+        {
+            // The fiber object of the thread is stored as the fiber data of the thread fiber.
+            Fiber* f = (Fiber*)::GetFiberData();
+            if (!::ConvertFiberToThread())
+            {
+                lupanic_msg_always("ConvertFiberToThread failed.");
+            }
+            Luna::memdelete(f);
+        }
+        opaque_t new_fiber(thread_callback_func_t* callback, void* params, usize stack_size)
+        {
+            luassert(callback);
+            Fiber* f = Luna::memnew<Fiber>();
+            f->m_func = callback;
+            f->m_params = params;
+            if (stack_size == 0)
+            {
+                stack_size = 256_kb;
+            }
+            f->m_handle = ::CreateFiber(stack_size, &WinFiberEntry, f);
+            if (!f->m_handle)
+            {
+                Luna::memdelete(f);
+                lupanic_msg_always("CreateFiber failed.");
+            }
+            return f;
+        }
+        void delete_fiber(opaque_t fiber)
+        {
+            Fiber* f = (Fiber*)fiber;
+            ::DeleteFiber(f->m_handle);
+            Luna::memdelete(f);
+        }
+        void switch_to_fiber(opaque_t fiber)
+        {
+            Fiber* f = (Fiber*)fiber;
+            ::SwitchToFiber(f->m_handle);
+        }
+    }
+}
@@ -60,7 +60,12 @@ namespace Luna
                 lupanic();
                 break;
             }
-            HANDLE fileHandle = ::CreateFileW(pathbuffer, dw_access, FILE_SHARE_READ, nullptr, dw_creation, FILE_ATTRIBUTE_NORMAL, nullptr);
+            DWORD dw_flags = FILE_ATTRIBUTE_NORMAL;
+            if (test_flags(flags, FileOpenFlag::sequential_scan))
+            {
+                dw_flags |= FILE_FLAG_SEQUENTIAL_SCAN;
+            }
+            HANDLE fileHandle = ::CreateFileW(pathbuffer, dw_access, FILE_SHARE_READ, nullptr, dw_creation, dw_flags, nullptr);
             if (fileHandle == INVALID_HANDLE_VALUE)
             {
                 DWORD dw = ::GetLastError();
@@ -198,6 +203,16 @@ namespace Luna
             const wchar_t* mode;
             FILE* f = NULL;
             errno_t err;
+            bool sequential = test_flags(flags, FileOpenFlag::sequential_scan);
+            auto open_with_mode = [&](const wchar_t* open_mode) -> errno_t
+            {
+                if (!sequential) return _wfopen_s(&f, pathbuffer, open_mode);
+                // "S" passes `FILE_FLAG_SEQUENTIAL_SCAN` to the underlying file.
+                wchar_t seq_mode[8];
+                wcscpy_s(seq_mode, open_mode);
+                wcscat_s(seq_mode, L"S");
+                return _wfopen_s(&f, pathbuffer, seq_mode);
+            };
             if (((flags & FileOpenFlag::read) != FileOpenFlag::none) && ((flags & FileOpenFlag::write) != FileOpenFlag::none))
             {
                 // update mode.
@@ -205,7 +220,7 @@ namespace Luna
                 {
                 case FileCreationMode::create_always:
                     mode = L"w+b";
-                    err = _wfopen_s(&f, pathbuffer, mode);
+                    err = open_with_mode(mode);
                     break;
                 case FileCreationMode::create_new:
                     if (get_file_attribute(path).valid())
@@ -213,29 +228,29 @@ namespace Luna
                         return BasicError::already_exists();
                     }
                     mode = L"w+b";
-                    err = _wfopen_s(&f, pathbuffer, mode);
+                    err = open_with_mode(mode);
                     break;
                 case FileCreationMode::open_always:
                     if (get_file_attribute(path).valid())
                     {
                         mode = L"r+b";
-                        err = _wfopen_s(&f, pathbuffer, mode);
+                        err = open_with_mode(mode);
                     }
                     else
                     {
                         mode = L"w+b";
-                        err = _wfopen_s(&f, pathbuffer, mode);
+                        err = open_with_mode(mode);
                     }
                     break;
                 case FileCreationMode::open_existing:
                     mode = L"r+b";
-                    err = _wfopen_s(&f, pathbuffer, mode);
+                    err = open_with_mode(mode);
                     break;
                 case FileCreationMode::open_existing_as_new:
                     if ((get_file_attribute(path).valid()))
                     {
                         mode = L"w+b";
-                        err = _wfopen_s(&f, pathbuffer, mode);
+                        err = open_with_mode(mode);
                     }
                     else
                     {
@@ -260,7 +275,7 @@ namespace Luna
                     break;
                 case FileCreationMode::open_existing:
                     mode = L"rb";
-                    err = _wfopen_s(&f, pathbuffer, mode);
+                    err = open_with_mode(mode);
                     break;
                 default:
                     lupanic();
@@ -274,7 +289,7 @@ namespace Luna
                 {
                 case FileCreationMode::create_always:
                     mode = L"wb";
-                    err = _wfopen_s(&f, pathbuffer, mode);
+                    err = open_with_mode(mode);
                     break;
                 case FileCreationMode::create_new:
                     if (get_file_attribute(path).valid())
@@ -282,29 +297,29 @@ namespace Luna
                         return BasicError::already_exists();
                     }
                     mode = L"wb";
-                    err = _wfopen_s(&f, pathbuffer, mode);
+                    err = open_with_mode(mode);
                     break;
                 case FileCreationMode::open_always:
                     if (get_file_attribute(path).valid())
                     {
                         mode = L"r+b";
-                        err = _wfopen_s(&f, pathbuffer, mode);
+                        err = open_with_mode(mode);
                     }
                     else
                     {
                         mode = L"wb";
-                        err = _wfopen_s(&f, pathbuffer, mode);
+                        err = open_with_mode(mode);
                     }
                     break;
                 case FileCreationMode::open_existing:
                     mode = L"r+b";
-                    err = _wfopen_s(&f, pathbuffer, mode);
+                    err = open_with_mode(mode);
                     break;
                 case FileCreationMode::open_existing_as_new:
                     if (get_file_attribute(path).valid())
                     {
                         mode = L"wb";
-                        err = _wfopen_s(&f, pathbuffer, mode);
+                        err = open_with_mode(mode);
                     }
                     else
                     {
@@ -477,6 +492,40 @@ namespace Luna
             return f->buffered ? write_buffered_file(f->handle, buffer, size, write_bytes) :
                 write_unbuffered_file(f->handle, buffer, size, write_bytes);
         }
+        opaque_t get_native_file_handle(opaque_t file)
+        {
+            File* f = (File*)file;
+            HANDLE h = f->buffered ? (HANDLE)_get_osfhandle(_fileno((FILE*)f->handle)) : (HANDLE)f->handle;
+            return (opaque_t)h;
+        }
+        RV read_file_at(opaque_t file, u64 offset, void* buffer, usize size, usize* read_bytes)
+        {
+            File* f = (File*)file;
+            HANDLE h = f->buffered ? (HANDLE)_get_osfhandle(_fileno((FILE*)f->handle)) : (HANDLE)f->handle;
+            usize total = 0;
+            while (total < size)
+            {
+                u64 pos = offset + total;
+                OVERLAPPED overlapped;
+                memzero(&overlapped);
+                overlapped.Offset = (DWORD)(pos & 0xFFFFFFFF);
+                overlapped.OffsetHigh = (DWORD)(pos >> 32);
+                DWORD actual = 0;
+                DWORD bytes_to_read = (DWORD)min<usize>(size - total, 0x80000000);
+                if (!::ReadFile(h, (byte_t*)buffer + total, bytes_to_read, &actual, &overlapped))
+                {
+                    DWORD dw = ::GetLastError();
+                    // End of file.
+                    if (dw == ERROR_HANDLE_EOF) break;
+                    if (read_bytes) *read_bytes = total;
+                    return translate_last_error(dw);
+                }
+                if (actual == 0) break;
+                total += actual;
+            }
+            if (read_bytes) *read_bytes = total;
+            return ok;
+        }
         u64 get_file_size(opaque_t file)
         {
             File* f = (File*)file;
@@ -503,6 +552,71 @@ namespace Luna
             if (f->buffered) flush_buffered_file(f->handle);
             else flush_unbuffered_file(f->handle);
         }
+        struct MappedFile
+        {
+            void* data;
+            usize size;
+        };
+        R<opaque_t> map_file(const c8* path)
+        {
+            lucheck(path);
+            usize buffer_size = utf8_to_utf16_len(path) + 1;
+            wchar_t* pathbuffer = (wchar_t*)alloca(sizeof(wchar_t) * buffer_size);
+            utf8_to_utf16((char16_t*)pathbuffer, buffer_size, path);
+            HANDLE file_handle = ::CreateFileW(pathbuffer, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file_handle == INVALID_HANDLE_VALUE)
+            {
+                DWORD dw = ::GetLastError();
+                return translate_last_error(dw);
+            }
+            LARGE_INTEGER size;
+            if (!::GetFileSizeEx(file_handle, &size))
+            {
+                DWORD dw = ::GetLastError();
+                ::CloseHandle(file_handle);
+                return translate_last_error(dw);
+            }
+            void* data = nullptr;
+            // Empty files cannot be mapped.
+            if (size.QuadPart)
+            {
+                HANDLE mapping_handle = ::CreateFileMappingW(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+                if (!mapping_handle)
+                {
+                    DWORD dw = ::GetLastError();
+                    ::CloseHandle(file_handle);
+                    return translate_last_error(dw);
+                }
+                data = ::MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+                DWORD dw = ::GetLastError();
+                // The mapped view keeps the file mapping object and the file alive after handles are closed.
+                ::CloseHandle(mapping_handle);
+                if (!data)
+                {
+                    ::CloseHandle(file_handle);
+                    return translate_last_error(dw);
+                }
+            }
+            ::CloseHandle(file_handle);
+            MappedFile* ret = Luna::memnew<MappedFile>();
+            ret->data = data;
+            ret->size = (usize)size.QuadPart;
+            return ret;
+        }
+        void unmap_file(opaque_t mapping)
+        {
+            MappedFile* m = (MappedFile*)mapping;
+            if (m->data) ::UnmapViewOfFile(m->data);
+            Luna::memdelete(m);
+        }
+        const void* get_mapped_file_data(opaque_t mapping)
+        {
+            return ((MappedFile*)mapping)->data;
+        }
+        usize get_mapped_file_size(opaque_t mapping)
+        {
+            return ((MappedFile*)mapping)->size;
+        }
         inline i64 file_time_to_timestamp(const FILETIME& filetime)
         {
             ULARGE_INTEGER  ui;
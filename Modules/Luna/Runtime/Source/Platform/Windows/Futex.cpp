@@ -0,0 +1,37 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Futex.cpp
+* @author JXMaster
+* @date 2024/5/11
+*/
+#include "../../OS.hpp"
+#include "../../../Platform/Windows/MiniWin.hpp"
+#include <synchapi.h>
+
+#pragma comment(lib, "Synchronization.lib")
+
+namespace Luna
+{
+    namespace OS
+    {
+        bool wait_on_address(u32 volatile* address, u32 expected, u32 timeout_ms)
+        {
+            if (::WaitOnAddress(address, &expected, sizeof(u32), timeout_ms == U32_MAX ? INFINITE : (DWORD)timeout_ms))
+            {
+                return true;
+            }
+            return ::GetLastError() != ERROR_TIMEOUT;
+        }
+        void wake_by_address_single(u32 volatile* address)
+        {
+            ::WakeByAddressSingle((PVOID)address);
+        }
+        void wake_by_address_all(u32 volatile* address)
+        {
+            ::WakeByAddressAll((PVOID)address);
+        }
+    }
+}
@@ -11,12 +11,13 @@
 #include "../../../Platform/Windows/MiniWin.hpp"
 #include "../../OS.hpp"
 #include <Luna/Runtime/Result.hpp>
+#include "ErrCode.hpp"
 
 namespace Luna
 {
     namespace OS
     {
-        void* memalloc(usize size, usize alignment /* = 0 */)
+        void* system_memalloc(usize size, usize alignment /* = 0 */)
         {
             void* ret = (alignment > MAX_ALIGN) ? _aligned_malloc(size, alignment) : malloc(size);
             if (!ret)
@@ -25,7 +26,7 @@ namespace Luna
             }
             return ret;
         }
-        void memfree(void* ptr, usize alignment /* = 0 */)
+        void system_memfree(void* ptr, usize alignment /* = 0 */)
         {
             if (alignment > MAX_ALIGN)
             {
@@ -36,10 +37,85 @@ namespace Luna
                 free(ptr);
             }
         }
-        usize memsize(void* ptr, usize alignment /* = 0 */)
+        void* system_memrealloc(void* ptr, usize size, usize alignment /* = 0 */)
+        {
+            void* ret = (alignment > MAX_ALIGN) ? _aligned_realloc(ptr, size, alignment) : realloc(ptr, size);
+            if (!ret)
+            {
+                lupanic_msg_always("System memory allocation failed.");
+            }
+            return ret;
+        }
+        usize system_memsize(void* ptr, usize alignment /* = 0 */)
         {
             if (!ptr) return 0;
             return (alignment > MAX_ALIGN) ? _aligned_msize(ptr, alignment, 0) : _msize(ptr);
         }
+        void* virtual_alloc(usize size, usize alignment)
+        {
+            // Allocations are always aligned to the allocation granularity (64KB).
+            void* mem = ::VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+            if (!mem || ((usize)mem & (alignment - 1)) == 0) return mem;
+            ::VirtualFree(mem, 0, MEM_RELEASE);
+            // Reserves more pages to find one aligned address, then allocates at that address. The address may be
+            // taken by another thread between two calls, so we need to retry in such case.
+            for (u32 i = 0; i < 16; ++i)
+            {
+                void* reserved = ::VirtualAlloc(nullptr, size + alignment, MEM_RESERVE, PAGE_NOACCESS);
+                if (!reserved) return nullptr;
+                ::VirtualFree(reserved, 0, MEM_RELEASE);
+                mem = ::VirtualAlloc((void*)align_upper((usize)reserved, alignment), size, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+                if (mem) return mem;
+            }
+            return nullptr;
+        }
+        void virtual_free(void* ptr, usize size)
+        {
+            ::VirtualFree(ptr, 0, MEM_RELEASE);
+        }
+        usize get_page_size()
+        {
+            static usize page_size = []() {
+                SYSTEM_INFO info;
+                ::GetSystemInfo(&info);
+                return (usize)info.dwPageSize;
+            }();
+            return page_size;
+        }
+        usize get_large_page_size()
+        {
+            return (usize)::GetLargePageMinimum();
+        }
+        R<void*> virtual_reserve(usize size, bool large_page)
+        {
+            if (large_page)
+            {
+                // Large pages cannot be reserved without committing them, and require the SeLockMemoryPrivilege. 
+                // Falls back to normal pages if large pages are not granted.
+                usize large_page_size = get_large_page_size();
+                if (large_page_size)
+                {
+                    void* mem = ::VirtualAlloc(nullptr, align_upper(size, large_page_size), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+                    if (mem) return mem;
+                }
+            }
+            void* mem = ::VirtualAlloc(nullptr, size, MEM_RESERVE, PAGE_NOACCESS);
+            if (!mem) return translate_last_error(::GetLastError());
+            return mem;
+        }
+        RV virtual_commit(void* ptr, usize size)
+        {
+            if (!::VirtualAlloc(ptr, size, MEM_COMMIT, PAGE_READWRITE)) return translate_last_error(::GetLastError());
+            return ok;
+        }
+        RV virtual_decommit(void* ptr, usize size)
+        {
+            if (!::VirtualFree(ptr, size, MEM_DECOMMIT)) return translate_last_error(::GetLastError());
+            return ok;
+        }
+        void virtual_release(void* ptr, usize size)
+        {
+            ::VirtualFree(ptr, 0, MEM_RELEASE);
+        }
     }
 }
\ No newline at end of file
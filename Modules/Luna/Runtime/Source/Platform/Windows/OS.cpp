@@ -46,5 +46,36 @@ namespace Luna
             ::GetSystemInfo(&si);
             return si.dwNumberOfProcessors;
         }
+
+        u32 get_processor_cache_domain(u32 processor)
+        {
+            DWORD size = 0;
+            ::GetLogicalProcessorInformation(nullptr, &size);
+            if (!size) return 0;
+            SYSTEM_LOGICAL_PROCESSOR_INFORMATION* infos = (SYSTEM_LOGICAL_PROCESSOR_INFORMATION*)memalloc(size);
+            u32 domain = 0;
+            if (::GetLogicalProcessorInformation(infos, &size))
+            {
+                // Use the first processor that shares the last-level cache with the specified processor as the domain index.
+                BYTE level = 0;
+                usize num_infos = size / sizeof(SYSTEM_LOGICAL_PROCESSOR_INFORMATION);
+                for (usize i = 0; i < num_infos; ++i)
+                {
+                    auto& info = infos[i];
+                    if (info.Relationship != RelationCache || info.Cache.Level < level) continue;
+                    if (processor >= sizeof(ULONG_PTR) * 8 || !(info.ProcessorMask & ((ULONG_PTR)1 << processor))) continue;
+                    level = info.Cache.Level;
+                    ULONG_PTR mask = info.ProcessorMask;
+                    domain = 0;
+                    while (!(mask & 1))
+                    {
+                        mask >>= 1;
+                        ++domain;
+                    }
+                }
+            }
+            memfree(infos);
+            return domain;
+        }
     }
 }
\ No newline at end of file
@@ -13,6 +13,7 @@
 #include "../../../SpinLock.hpp"
 #include "../../../Unicode.hpp"
 #include "Utils.hpp"
+#include "ErrCode.hpp"
 
 namespace Luna
 {
@@ -112,6 +113,23 @@ namespace Luna
                 lupanic_msg_always("SetThreadPriority failed for thread object");
             }
         }
+        RV set_thread_affinity(opaque_t thread, u64 processor_mask)
+        {
+            DWORD_PTR mask = (DWORD_PTR)processor_mask;
+            if (!mask)
+            {
+                DWORD_PTR system_mask;
+                if (!::GetProcessAffinityMask(::GetCurrentProcess(), &mask, &system_mask))
+                {
+                    return translate_last_error(::GetLastError());
+                }
+            }
+            if (!::SetThreadAffinityMask((HANDLE)thread, mask))
+            {
+                return translate_last_error(::GetLastError());
+            }
+            return ok;
+        }
         void wait_thread(opaque_t thread)
         {
             if (::WaitForSingleObject((HANDLE)thread, INFINITE) != WAIT_OBJECT_0)
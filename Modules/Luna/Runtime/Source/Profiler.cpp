@@ -16,13 +16,24 @@
 #include "../Thread.hpp"
 #include "OS.hpp"
 #include "../Vector.hpp"
+#include "../SpinLock.hpp"
+#include "../Atomic.hpp"
+#include "../File.hpp"
+#include "../String.hpp"
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+#include "../HashMap.hpp"
+#include <cmath>
+#endif
 
 namespace Luna
 {
     Event<on_profiler_event_t, OSAllocator> g_profiler_callbacks;
+    Event<on_profiler_event_batch_t, OSAllocator> g_profiler_batch_callbacks;
     opaque_t g_profiler_callbacks_lock;
     opaque_t g_profiler_thread_context_tls;
     bool g_profiler_inited = false;
+    // Nonzero if batch mode is enabled.
+    u32 volatile g_profiler_batch_mode = 0;
 
     struct ProfilerEventEntry
     {
@@ -48,6 +59,69 @@ namespace Luna
             OS::memfree(data);
         }
     };
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+    // Memory counters of one memory domain or type.
+    struct MemoryCounterSlot
+    {
+        u64 volatile key = 0;
+        MemoryProfilerCounters counters;
+    };
+    constexpr usize NUM_MEMORY_COUNTER_SLOTS = 256;
+#endif
+    // One block of events buffered in batch mode.
+    // Events and data are written by the owning thread and read by the flushing thread. The owning thread publishes one event
+    // by increasing `m_num_events`, and publishes one new block by setting `m_next` of the last block after all events of the 
+    // last block are published. The flushing thread frees one block only when its `m_next` is set, so the last block is never freed 
+    // when the owning thread is writing to it.
+    struct ProfilerEventBlock
+    {
+        ProfilerEventBlock* volatile m_next;
+        u32 volatile m_num_events;
+        u32 m_events_capacity;
+        // Accessed only by the owning thread.
+        usize m_data_size;
+        usize m_data_capacity;
+
+        ProfilerEvent* get_events() { return (ProfilerEvent*)(this + 1); }
+        using dtor_t = void(*)(void*);
+        dtor_t* get_dtors() { return (dtor_t*)(get_events() + m_events_capacity); }
+        u8* get_data() { return (u8*)(get_dtors() + m_events_capacity); }
+
+        static ProfilerEventBlock* create(u32 events_capacity, usize data_capacity)
+        {
+            usize size = sizeof(ProfilerEventBlock) + (sizeof(ProfilerEvent) + sizeof(dtor_t)) * events_capacity + data_capacity;
+            ProfilerEventBlock* block = (ProfilerEventBlock*)OS::memalloc(size);
+            block->m_next = nullptr;
+            block->m_num_events = 0;
+            block->m_events_capacity = events_capacity;
+            block->m_data_size = 0;
+            block->m_data_capacity = data_capacity;
+            return block;
+        }
+    };
+    constexpr u32 PROFILER_EVENT_BLOCK_NUM_EVENTS = 256;
+    constexpr usize PROFILER_EVENT_BLOCK_DATA_SIZE = 16_kb;
+
+    struct ProfilerThreadContext;
+    // One begin or end record of one CPU zone captured for trace export.
+    struct CpuTraceEvent
+    {
+        // `nullptr` for end records.
+        const c8* name;
+        u64 timestamp;
+    };
+    // Trace records of one thread. Buffers are owned by the trace buffer list rather than thread contexts, so that
+    // records of threads that exit during one capture can still be exported.
+    struct CpuTraceBuffer
+    {
+        // Locked by the owning thread when writing records, and by the exporting thread when reading records, 
+        // so it is almost never contended.
+        SpinLock m_lock;
+        Vector<CpuTraceEvent, OSAllocator> m_events;
+        // `nullptr` if the owning thread has exited.
+        ProfilerThreadContext* m_owner;
+        u32 m_thread_index;
+    };
     struct ProfilerThreadContext
     {
         Vector<ProfilerEventEntry, OSAllocator> m_events;
@@ -56,16 +130,67 @@ namespace Luna
 
         bool m_thread_locked_callbacks = false;
 
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+        // Memory counters are written only by the owning thread, and are read by other threads 
+        // when counters are queried.
+        MemoryProfilerCounters m_memory_counters;
+        MemoryCounterSlot m_memory_tag_counters[NUM_MEMORY_COUNTER_SLOTS];
+        ProfilerThreadContext* m_prev_context = nullptr;
+        ProfilerThreadContext* m_next_context = nullptr;
+        bool m_context_registered = false;
+#endif
+        CpuTraceBuffer* m_trace_buffer = nullptr;
+
+        // Batch mode states.
+        // The first block that is not flushed, accessed only by the flushing thread.
+        ProfilerEventBlock* m_batch_head = nullptr;
+        // The block that is being written, accessed only by the owning thread.
+        ProfilerEventBlock* m_batch_tail = nullptr;
+        // The number of flushed events in `m_batch_head`.
+        u32 m_batch_read = 0;
+        // Whether data of `m_next_entry` is allocated from batch blocks.
+        bool m_next_entry_batched = false;
+        ProfilerThreadContext* m_prev_batch_context = nullptr;
+        ProfilerThreadContext* m_next_batch_context = nullptr;
+        bool m_batch_registered = false;
+        // Set when the owning thread exits, the context is then deleted by the flushing thread.
+        bool m_batch_retired = false;
+
+        void* allocate_event_data(usize size, usize alignment, void(*dtor)(void*));
         void* allocate_data_buffer(usize size, usize alignment, void(*dtor)(void*));
+        void* allocate_batch_data(usize size, usize alignment, void(*dtor)(void*));
         void merge_data_buffers();
         void dispatch_events();
+        void push_batch_event(const ProfilerEventEntry& entry);
     };
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+    void register_memory_counters(ProfilerThreadContext* ctx);
+    void unregister_memory_counters(ProfilerThreadContext* ctx);
+#endif
+    void release_cpu_trace_buffer(ProfilerThreadContext* ctx);
+    bool retire_batch_context(ProfilerThreadContext* ctx);
     void profiler_thread_context_dtor(void* data)
     {
-        if(data) OS::memdelete((ProfilerThreadContext*)data);
+        if(data)
+        {
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+            unregister_memory_counters((ProfilerThreadContext*)data);
+#endif
+            release_cpu_trace_buffer((ProfilerThreadContext*)data);
+            // Contexts that have buffered events are deleted after their events are flushed.
+            if(!retire_batch_context((ProfilerThreadContext*)data))
+            {
+                OS::memdelete((ProfilerThreadContext*)data);
+            }
+        }
+    }
+    void* ProfilerThreadContext::allocate_event_data(usize size, usize alignment, void(*dtor)(void*))
+    {
+        return g_profiler_batch_mode ? allocate_batch_data(size, alignment, dtor) : allocate_data_buffer(size, alignment, dtor);
     }
     void* ProfilerThreadContext::allocate_data_buffer(usize size, usize alignment, void(*dtor)(void*))
     {
+        m_next_entry_batched = false;
         m_next_entry.data_size = size;
         m_next_entry.dtor = dtor;
         m_next_entry.data = nullptr;
@@ -119,6 +244,7 @@ namespace Luna
             dst.thread = get_current_thread();
             OS::acquire_read_lock(g_profiler_callbacks_lock);
             g_profiler_callbacks(dst);
+            g_profiler_batch_callbacks(Span<const ProfilerEvent>(&dst, 1));
             OS::release_read_lock(g_profiler_callbacks_lock);
         }
         for(auto& e : m_events)
@@ -135,26 +261,194 @@ namespace Luna
         {
             ctx = OS::memnew<ProfilerThreadContext>();
             OS::tls_set(g_profiler_thread_context_tls, ctx);
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+            register_memory_counters(ctx);
+#endif
         }
         return ctx;
     }
+    opaque_t g_profiler_batch_mutex;
+    ProfilerThreadContext* g_profiler_batch_contexts = nullptr;
+    void register_batch_context(ProfilerThreadContext* ctx)
+    {
+        ProfilerEventBlock* block = ProfilerEventBlock::create(PROFILER_EVENT_BLOCK_NUM_EVENTS, PROFILER_EVENT_BLOCK_DATA_SIZE);
+        ctx->m_batch_head = block;
+        ctx->m_batch_tail = block;
+        ctx->m_batch_read = 0;
+        OS::lock_mutex(g_profiler_batch_mutex);
+        ctx->m_prev_batch_context = nullptr;
+        ctx->m_next_batch_context = g_profiler_batch_contexts;
+        if(g_profiler_batch_contexts) g_profiler_batch_contexts->m_prev_batch_context = ctx;
+        g_profiler_batch_contexts = ctx;
+        ctx->m_batch_registered = true;
+        OS::unlock_mutex(g_profiler_batch_mutex);
+    }
+    bool retire_batch_context(ProfilerThreadContext* ctx)
+    {
+        if(!g_profiler_inited) return false;
+        OS::lock_mutex(g_profiler_batch_mutex);
+        bool registered = ctx->m_batch_registered;
+        if(registered) ctx->m_batch_retired = true;
+        OS::unlock_mutex(g_profiler_batch_mutex);
+        return registered;
+    }
+    // Creates one new block for the owning thread so that one event with data of the specified size can be written.
+    ProfilerEventBlock* new_batch_block(ProfilerThreadContext* ctx, usize data_size)
+    {
+        ProfilerEventBlock* block = ProfilerEventBlock::create(PROFILER_EVENT_BLOCK_NUM_EVENTS, max(data_size, PROFILER_EVENT_BLOCK_DATA_SIZE));
+        // All events of the last block are published before the new block is published.
+        atom_exchange_pointer(&ctx->m_batch_tail->m_next, block);
+        ctx->m_batch_tail = block;
+        return block;
+    }
+    void* ProfilerThreadContext::allocate_batch_data(usize size, usize alignment, void(*dtor)(void*))
+    {
+        if(!m_batch_registered) register_batch_context(this);
+        m_next_entry_batched = true;
+        m_next_entry.data_size = size;
+        m_next_entry.dtor = dtor;
+        if(!alignment) alignment = MAX_ALIGN;
+        ProfilerEventBlock* block = m_batch_tail;
+        u8* data = block->get_data();
+        usize addr = align_upper((usize)data + block->m_data_size, alignment);
+        // The event slot is reserved along with the data.
+        if(block->m_num_events >= block->m_events_capacity || addr + size > (usize)data + block->m_data_capacity)
+        {
+            block = new_batch_block(this, size + alignment);
+            data = block->get_data();
+            addr = align_upper((usize)data, alignment);
+        }
+        block->m_data_size = addr + size - (usize)data;
+        m_next_entry.data = (void*)addr;
+        return m_next_entry.data;
+    }
+    void ProfilerThreadContext::push_batch_event(const ProfilerEventEntry& entry)
+    {
+        if(!m_batch_registered) register_batch_context(this);
+        ProfilerEventBlock* block = m_batch_tail;
+        if(block->m_num_events >= block->m_events_capacity)
+        {
+            luassert(!entry.data);
+            block = new_batch_block(this, 0);
+        }
+        u32 index = block->m_num_events;
+        ProfilerEvent& dst = block->get_events()[index];
+        dst.timestamp = entry.timestamp;
+        dst.id = entry.id;
+        dst.thread = get_current_thread();
+        dst.data = entry.data;
+        block->get_dtors()[index] = entry.dtor;
+        // Publishes the event to the flushing thread.
+        atom_exchange_u32(&block->m_num_events, index + 1);
+    }
+    // Dispatches all events written to the context before this call. The batch mutex must be locked.
+    void flush_batch_context(ProfilerThreadContext* ctx)
+    {
+        ProfilerEventBlock* end_block = ctx->m_batch_tail;
+        u32 end_count = end_block->m_num_events;
+        ProfilerEventBlock* block = ctx->m_batch_head;
+        while(true)
+        {
+            bool is_end = block == end_block;
+            u32 count = is_end ? end_count : block->m_num_events;
+            if(ctx->m_batch_read < count)
+            {
+                ProfilerEvent* events = block->get_events() + ctx->m_batch_read;
+                usize num_events = count - ctx->m_batch_read;
+                OS::acquire_read_lock(g_profiler_callbacks_lock);
+                for(usize i = 0; i < num_events; ++i) g_profiler_callbacks(events[i]);
+                g_profiler_batch_callbacks(Span<const ProfilerEvent>(events, num_events));
+                OS::release_read_lock(g_profiler_callbacks_lock);
+                auto dtors = block->get_dtors();
+                for(u32 i = ctx->m_batch_read; i < count; ++i)
+                {
+                    if(dtors[i]) dtors[i]((void*)block->get_events()[i].data);
+                }
+                ctx->m_batch_read = count;
+            }
+            if(is_end) break;
+            // Blocks before the end block are full and will not be written any more.
+            ProfilerEventBlock* next = block->m_next;
+            OS::memfree(block);
+            block = next;
+            ctx->m_batch_head = block;
+            ctx->m_batch_read = 0;
+        }
+    }
+    // Frees all blocks of the context without dispatching events.
+    void clear_batch_context(ProfilerThreadContext* ctx)
+    {
+        ProfilerEventBlock* block = ctx->m_batch_head;
+        u32 read = ctx->m_batch_read;
+        while(block)
+        {
+            auto dtors = block->get_dtors();
+            for(u32 i = read; i < block->m_num_events; ++i)
+            {
+                if(dtors[i]) dtors[i]((void*)block->get_events()[i].data);
+            }
+            ProfilerEventBlock* next = block->m_next;
+            OS::memfree(block);
+            block = next;
+            read = 0;
+        }
+        ctx->m_batch_head = nullptr;
+        ctx->m_batch_tail = nullptr;
+        ctx->m_batch_read = 0;
+    }
+    void unlink_batch_context(ProfilerThreadContext* ctx)
+    {
+        if(ctx->m_prev_batch_context) ctx->m_prev_batch_context->m_next_batch_context = ctx->m_next_batch_context;
+        else g_profiler_batch_contexts = ctx->m_next_batch_context;
+        if(ctx->m_next_batch_context) ctx->m_next_batch_context->m_prev_batch_context = ctx->m_prev_batch_context;
+        ctx->m_prev_batch_context = nullptr;
+        ctx->m_next_batch_context = nullptr;
+        ctx->m_batch_registered = false;
+    }
+    void clear_batch_contexts()
+    {
+        OS::lock_mutex(g_profiler_batch_mutex);
+        ProfilerThreadContext* ctx = g_profiler_batch_contexts;
+        while(ctx)
+        {
+            ProfilerThreadContext* next = ctx->m_next_batch_context;
+            clear_batch_context(ctx);
+            unlink_batch_context(ctx);
+            if(ctx->m_batch_retired) OS::memdelete(ctx);
+            ctx = next;
+        }
+        OS::unlock_mutex(g_profiler_batch_mutex);
+    }
     void profiler_init()
     {
         g_profiler_callbacks_lock = OS::new_read_write_lock();
+        g_profiler_batch_mutex = OS::new_mutex();
         g_profiler_thread_context_tls = OS::tls_alloc(profiler_thread_context_dtor);
         g_profiler_inited = true;
     }
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+    void clear_memory_profiler_records();
+#endif
+    void clear_cpu_trace_buffers();
     void profiler_close()
     {
         g_profiler_inited = false;
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+        clear_memory_profiler_records();
+#endif
+        clear_cpu_trace_buffers();
+        clear_batch_contexts();
+        g_profiler_batch_mode = 0;
         g_profiler_callbacks.clear();
+        g_profiler_batch_callbacks.clear();
         OS::tls_free(g_profiler_thread_context_tls);
+        OS::delete_mutex(g_profiler_batch_mutex);
         OS::delete_read_write_lock(g_profiler_callbacks_lock);
     }
     LUNA_RUNTIME_API void* allocate_profiler_event_data(usize size, usize alignment, void(*dtor)(void*))
     {
         auto ctx = get_profiler_thread_context();
-        return ctx->allocate_data_buffer(size, alignment, dtor);
+        return ctx->allocate_event_data(size, alignment, dtor);
     }
     LUNA_RUNTIME_API void submit_profiler_event(u64 event_id)
     {
@@ -162,6 +456,15 @@ namespace Luna
         auto ctx = get_profiler_thread_context();
         ctx->m_next_entry.timestamp = OS::get_ticks();
         ctx->m_next_entry.id = event_id;
+        // The event is written to the buffer where its data is allocated.
+        bool batched = ctx->m_next_entry.data ? ctx->m_next_entry_batched : (g_profiler_batch_mode != 0);
+        if(batched)
+        {
+            ctx->push_batch_event(ctx->m_next_entry);
+            ctx->m_next_entry = ProfilerEventEntry();
+            ctx->m_next_entry_batched = false;
+            return;
+        }
         ctx->m_events.push_back(ctx->m_next_entry);
         ctx->m_next_entry = ProfilerEventEntry();
         // This profiler event is issued in another profiler event or register/unregister profiler callback.
@@ -202,18 +505,540 @@ namespace Luna
             ctx->dispatch_events();
         }
     }
+    LUNA_RUNTIME_API usize register_profiler_batch_callback(const Function<on_profiler_event_batch_t>& handler)
+    {
+        auto ctx = get_profiler_thread_context();
+        auto move_handler = handler;
+        OS::acquire_write_lock(g_profiler_callbacks_lock);
+        ctx->m_thread_locked_callbacks = true;
+        usize r = g_profiler_batch_callbacks.add_handler(move(move_handler));
+        ctx->m_thread_locked_callbacks = false;
+        OS::release_write_lock(g_profiler_callbacks_lock);
+        if(!ctx->m_events.empty())
+        {
+            ctx->dispatch_events();
+        }
+        return r;
+    }
+    LUNA_RUNTIME_API void unregister_profiler_batch_callback(usize handler_id)
+    {
+        auto ctx = get_profiler_thread_context();
+        OS::acquire_write_lock(g_profiler_callbacks_lock);
+        ctx->m_thread_locked_callbacks = true;
+        g_profiler_batch_callbacks.remove_handler(handler_id);
+        ctx->m_thread_locked_callbacks = false;
+        OS::release_write_lock(g_profiler_callbacks_lock);
+        if(!ctx->m_events.empty())
+        {
+            ctx->dispatch_events();
+        }
+    }
+    LUNA_RUNTIME_API void set_profiler_batch_mode(bool enabled)
+    {
+        atom_exchange_u32(&g_profiler_batch_mode, enabled ? 1 : 0);
+        if(!enabled) flush_profiler_events();
+    }
+    LUNA_RUNTIME_API bool is_profiler_batch_mode()
+    {
+        return g_profiler_batch_mode != 0;
+    }
+    LUNA_RUNTIME_API void flush_profiler_events()
+    {
+        if(!g_profiler_inited) return;
+        auto self = get_profiler_thread_context();
+        // Events submitted in immediate mode by callbacks are dispatched after the read lock is released.
+        bool locked_callbacks = self->m_thread_locked_callbacks;
+        self->m_thread_locked_callbacks = true;
+        OS::lock_mutex(g_profiler_batch_mutex);
+        ProfilerThreadContext* ctx = g_profiler_batch_contexts;
+        while(ctx)
+        {
+            ProfilerThreadContext* next = ctx->m_next_batch_context;
+            flush_batch_context(ctx);
+            if(ctx->m_batch_retired)
+            {
+                // The owning thread has exited, so no more events will be written.
+                clear_batch_context(ctx);
+                unlink_batch_context(ctx);
+                OS::memdelete(ctx);
+            }
+            ctx = next;
+        }
+        OS::unlock_mutex(g_profiler_batch_mutex);
+        self->m_thread_locked_callbacks = locked_callbacks;
+        if(!locked_callbacks && !self->m_events.empty())
+        {
+            self->dispatch_events();
+        }
+    }
+    SpinLock g_cpu_trace_lock;
+    Vector<CpuTraceBuffer*, OSAllocator> g_cpu_trace_buffers;
+    u32 g_cpu_trace_next_thread_index = 0;
+    u64 g_cpu_trace_begin_time = 0;
+    u32 volatile g_cpu_trace_capturing = 0;
+
+    void release_cpu_trace_buffer(ProfilerThreadContext* ctx)
+    {
+        LockGuard guard(g_cpu_trace_lock);
+        if(ctx->m_trace_buffer)
+        {
+            // Records are kept until they are exported or discarded.
+            ctx->m_trace_buffer->m_owner = nullptr;
+            ctx->m_trace_buffer = nullptr;
+        }
+    }
+    void clear_cpu_trace_buffers()
+    {
+        LockGuard guard(g_cpu_trace_lock);
+        g_cpu_trace_capturing = 0;
+        for(CpuTraceBuffer* buffer : g_cpu_trace_buffers)
+        {
+            if(buffer->m_owner) buffer->m_owner->m_trace_buffer = nullptr;
+            OS::memdelete(buffer);
+        }
+        g_cpu_trace_buffers.clear();
+        g_cpu_trace_buffers.shrink_to_fit();
+    }
+    void record_cpu_trace_event(ProfilerThreadContext* ctx, const c8* name, u64 timestamp)
+    {
+        if(!ctx->m_trace_buffer)
+        {
+            CpuTraceBuffer* buffer = OS::memnew<CpuTraceBuffer>();
+            buffer->m_owner = ctx;
+            LockGuard guard(g_cpu_trace_lock);
+            buffer->m_thread_index = g_cpu_trace_next_thread_index++;
+            g_cpu_trace_buffers.push_back(buffer);
+            ctx->m_trace_buffer = buffer;
+        }
+        LockGuard guard(ctx->m_trace_buffer->m_lock);
+        ctx->m_trace_buffer->m_events.push_back({name, timestamp});
+    }
+    void submit_cpu_zone_event(const c8* name)
+    {
+        if(!g_profiler_inited) return;
+        u64 timestamp = OS::get_ticks();
+        auto ctx = get_profiler_thread_context();
+        if(g_cpu_trace_capturing)
+        {
+            record_cpu_trace_event(ctx, name, timestamp);
+        }
+        if(name)
+        {
+            ProfilerEventData::CpuZoneBegin* data = (ProfilerEventData::CpuZoneBegin*)ctx->allocate_event_data(
+                sizeof(ProfilerEventData::CpuZoneBegin), alignof(ProfilerEventData::CpuZoneBegin), nullptr);
+            data->name = name;
+            submit_profiler_event(ProfilerEventId::CPU_ZONE_BEGIN);
+        }
+        else
+        {
+            submit_profiler_event(ProfilerEventId::CPU_ZONE_END);
+        }
+    }
+    LUNA_RUNTIME_API void profiler_zone_begin(const c8* name)
+    {
+        submit_cpu_zone_event(name ? name : "");
+    }
+    LUNA_RUNTIME_API void profiler_zone_end()
+    {
+        submit_cpu_zone_event(nullptr);
+    }
+    LUNA_RUNTIME_API void begin_profiler_trace_capture()
+    {
+        LockGuard guard(g_cpu_trace_lock);
+        for(CpuTraceBuffer* buffer : g_cpu_trace_buffers)
+        {
+            LockGuard buffer_guard(buffer->m_lock);
+            buffer->m_events.clear();
+        }
+        g_cpu_trace_begin_time = OS::get_ticks();
+        atom_exchange_u32(&g_cpu_trace_capturing, 1);
+    }
+    LUNA_RUNTIME_API bool is_profiler_trace_capturing()
+    {
+        return g_cpu_trace_capturing != 0;
+    }
+    static void append_trace_escaped_string(String& dst, const c8* str)
+    {
+        for(const c8* cur = str; *cur; ++cur)
+        {
+            c8 ch = *cur;
+            if(ch == '"' || ch == '\\')
+            {
+                dst.push_back('\\');
+                dst.push_back(ch);
+            }
+            else if((u8)ch < 0x20)
+            {
+                c8 buf[8];
+                snprintf(buf, 8, "\\u%04x", (u32)(u8)ch);
+                dst.append(buf);
+            }
+            else
+            {
+                dst.push_back(ch);
+            }
+        }
+    }
+    static void append_trace_event(String& dst, bool& first, c8 phase, const c8* name, u32 tid, f64 ts)
+    {
+        dst.append(first ? "\n" : ",\n");
+        first = false;
+        c8 buf[128];
+        snprintf(buf, 128, "{\"ph\":\"%c\",\"pid\":1,\"tid\":%u,\"ts\":%.3f", phase, tid, ts);
+        dst.append(buf);
+        if(name)
+        {
+            dst.append(",\"name\":\"");
+            append_trace_escaped_string(dst, name);
+            dst.push_back('"');
+        }
+        dst.push_back('}');
+    }
+    LUNA_RUNTIME_API RV end_profiler_trace_capture(const c8* path)
+    {
+        String json;
+        {
+            LockGuard guard(g_cpu_trace_lock);
+            atom_exchange_u32(&g_cpu_trace_capturing, 0);
+            u64 end_time = OS::get_ticks();
+            f64 us_per_tick = 1000000.0 / OS::get_ticks_per_second();
+            if(path)
+            {
+                json.append("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+                bool first = true;
+                Vector<const c8*, OSAllocator> stack;
+                for(CpuTraceBuffer* buffer : g_cpu_trace_buffers)
+                {
+                    LockGuard buffer_guard(buffer->m_lock);
+                    if(buffer->m_events.empty()) continue;
+                    u32 tid = buffer->m_thread_index + 1;
+                    c8 buf[128];
+                    snprintf(buf, 128, "{\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"name\":\"thread_name\",\"args\":{\"name\":\"Thread %u\"}}", tid, tid);
+                    json.append(first ? "\n" : ",\n");
+                    json.append(buf);
+                    first = false;
+                    stack.clear();
+                    for(auto& e : buffer->m_events)
+                    {
+                        // Skips records written after the capture is ended.
+                        if(e.timestamp < g_cpu_trace_begin_time || e.timestamp > end_time) continue;
+                        f64 ts = (f64)(e.timestamp - g_cpu_trace_begin_time) * us_per_tick;
+                        if(e.name)
+                        {
+                            stack.push_back(e.name);
+                            append_trace_event(json, first, 'B', e.name, tid, ts);
+                        }
+                        else if(!stack.empty())
+                        {
+                            // End records of zones begun before the capture is started are skipped.
+                            stack.pop_back();
+                            append_trace_event(json, first, 'E', nullptr, tid, ts);
+                        }
+                    }
+                    // Closes zones that are not ended yet.
+                    f64 end_ts = (f64)(end_time - g_cpu_trace_begin_time) * us_per_tick;
+                    while(!stack.empty())
+                    {
+                        stack.pop_back();
+                        append_trace_event(json, first, 'E', nullptr, tid, end_ts);
+                    }
+                }
+                json.append("\n]}\n");
+            }
+            // Discards all records, and frees buffers of threads that have exited.
+            usize i = 0;
+            while(i < g_cpu_trace_buffers.size())
+            {
+                CpuTraceBuffer* buffer = g_cpu_trace_buffers[i];
+                LockGuard buffer_guard(buffer->m_lock);
+                buffer->m_events.clear();
+                if(!buffer->m_owner)
+                {
+                    buffer_guard.unlock();
+                    OS::memdelete(buffer);
+                    g_cpu_trace_buffers.erase(g_cpu_trace_buffers.begin() + i);
+                }
+                else
+                {
+                    buffer->m_events.shrink_to_fit();
+                    ++i;
+                }
+            }
+        }
+        if(!path) return ok;
+        lutry
+        {
+            lulet(f, open_file(path, FileOpenFlag::write, FileCreationMode::create_always));
+            luexp(f->write(json.c_str(), json.size()));
+        }
+        lucatch
+        {
+            return luerr;
+        }
+        return ok;
+    }
 #ifdef LUNA_MEMORY_PROFILER_ENABLED
-    LUNA_RUNTIME_API void memory_profiler_allocate(void* ptr, usize size)
+    // The record of one memory block that is sampled by the memory profiler.
+    struct MemorySampleRecord
     {
+        usize size;
+        usize sampled_size;
+        u64 domain;
+        u64 type;
+    };
+    constexpr usize NUM_MEMORY_SAMPLE_SHARDS = 16;
+    constexpr usize NUM_MEMORY_SAMPLE_FILTER_SLOTS = 4096;
+    struct alignas(64) MemorySampleShard
+    {
+        SpinLock m_lock;
+        HashMap<usize, MemorySampleRecord, hash<usize>, equal_to<usize>, OSAllocator> m_records;
+    };
+    MemorySampleShard g_memory_sample_shards[NUM_MEMORY_SAMPLE_SHARDS];
+    // Counts recorded blocks whose pointers fall into every slot, so that freeing one block that is not 
+    // recorded does not need to lock one shard in most cases.
+    u32 volatile g_memory_sample_filter[NUM_MEMORY_SAMPLE_FILTER_SLOTS];
+
+    usize g_memory_sample_interval = 0;
+    u32 g_memory_sample_num_frames = 0;
+    // Increased every time sampling settings are changed, so that every thread redraws its sampling distance.
+    u32 volatile g_memory_sample_epoch = 0;
+    static thread_local u64 tls_memory_sample_rng = 0;
+    static thread_local usize tls_memory_bytes_until_sample = 0;
+    static thread_local u32 tls_memory_sample_epoch = 0;
+
+    SpinLock g_memory_counters_lock;
+    ProfilerThreadContext* g_memory_counters_contexts = nullptr;
+    // Counters of threads that have exited.
+    MemoryProfilerCounters g_retired_memory_counters;
+    MemoryCounterSlot g_retired_memory_tag_counters[NUM_MEMORY_COUNTER_SLOTS];
+
+    constexpr u64 MEMORY_DOMAIN_KEY_SEED = strhash64("MEMORY_DOMAIN");
+    constexpr u64 MEMORY_TYPE_KEY_SEED = strhash64("MEMORY_TYPE");
+
+    inline u64 hash_memory_sample_ptr(void* ptr)
+    {
+        return ((u64)(usize)ptr >> 4) * 0x9E3779B97F4A7C15ULL;
+    }
+    inline MemorySampleShard& get_memory_sample_shard(u64 h)
+    {
+        return g_memory_sample_shards[(h >> 60) & (NUM_MEMORY_SAMPLE_SHARDS - 1)];
+    }
+    inline u32 volatile& get_memory_sample_filter(u64 h)
+    {
+        return g_memory_sample_filter[(h >> 32) & (NUM_MEMORY_SAMPLE_FILTER_SLOTS - 1)];
+    }
+    inline u64 get_memory_tag_key(const c8* name, usize str_size, u64 seed)
+    {
+        u64 key = wyhash(name, str_size, seed);
+        // `0` marks empty counter slots.
+        return key ? key : 1;
+    }
+    MemoryProfilerCounters* find_memory_counter_slot(MemoryCounterSlot* slots, u64 key, bool insert)
+    {
+        for(usize i = 0; i < NUM_MEMORY_COUNTER_SLOTS; ++i)
+        {
+            MemoryCounterSlot& slot = slots[(key + i) & (NUM_MEMORY_COUNTER_SLOTS - 1)];
+            if(slot.key == key) return &slot.counters;
+            if(!slot.key)
+            {
+                if(!insert) return nullptr;
+                slot.key = key;
+                return &slot.counters;
+            }
+        }
+        return nullptr;
+    }
+    inline u64 get_sampled_count(const MemorySampleRecord& record)
+    {
+        // One sample of a small block stands for multiple blocks of the same size.
+        return record.size ? max<u64>(record.sampled_size / record.size, 1) : 1;
+    }
+    inline void count_memory_allocation(MemoryProfilerCounters* counters, const MemorySampleRecord& record)
+    {
+        if(!counters) return;
+        counters->num_allocations += get_sampled_count(record);
+        counters->allocated_bytes += record.sampled_size;
+    }
+    inline void count_memory_deallocation(MemoryProfilerCounters* counters, const MemorySampleRecord& record)
+    {
+        if(!counters) return;
+        counters->num_deallocations += get_sampled_count(record);
+        counters->deallocated_bytes += record.sampled_size;
+    }
+    inline void add_memory_counters(MemoryProfilerCounters& dst, const MemoryProfilerCounters& src)
+    {
+        dst.num_allocations += src.num_allocations;
+        dst.num_deallocations += src.num_deallocations;
+        dst.allocated_bytes += src.allocated_bytes;
+        dst.deallocated_bytes += src.deallocated_bytes;
+    }
+    void register_memory_counters(ProfilerThreadContext* ctx)
+    {
+        LockGuard guard(g_memory_counters_lock);
+        ctx->m_next_context = g_memory_counters_contexts;
+        if(g_memory_counters_contexts) g_memory_counters_contexts->m_prev_context = ctx;
+        g_memory_counters_contexts = ctx;
+        ctx->m_context_registered = true;
+    }
+    void unregister_memory_counters(ProfilerThreadContext* ctx)
+    {
+        LockGuard guard(g_memory_counters_lock);
+        if(!ctx->m_context_registered) return;
+        add_memory_counters(g_retired_memory_counters, ctx->m_memory_counters);
+        for(auto& slot : ctx->m_memory_tag_counters)
+        {
+            if(!slot.key) continue;
+            MemoryProfilerCounters* dst = find_memory_counter_slot(g_retired_memory_tag_counters, slot.key, true);
+            if(dst) add_memory_counters(*dst, slot.counters);
+        }
+        if(ctx->m_prev_context) ctx->m_prev_context->m_next_context = ctx->m_next_context;
+        else g_memory_counters_contexts = ctx->m_next_context;
+        if(ctx->m_next_context) ctx->m_next_context->m_prev_context = ctx->m_prev_context;
+        ctx->m_context_registered = false;
+    }
+    void clear_memory_profiler_records()
+    {
+        for(auto& shard : g_memory_sample_shards)
+        {
+            LockGuard guard(shard.m_lock);
+            shard.m_records.clear();
+            shard.m_records.shrink_to_fit();
+        }
+        memzero((void*)g_memory_sample_filter, sizeof(g_memory_sample_filter));
+        LockGuard guard(g_memory_counters_lock);
+        for(ProfilerThreadContext* ctx = g_memory_counters_contexts; ctx; ctx = ctx->m_next_context)
+        {
+            ctx->m_context_registered = false;
+        }
+        g_memory_counters_contexts = nullptr;
+    }
+    // Draws the number of bytes to the next sample from one exponential distribution whose mean is `interval`, 
+    // so that sampling points form one Poisson process over allocated bytes.
+    usize draw_memory_sample_distance(usize interval)
+    {
+        u64 x = tls_memory_sample_rng;
+        if(!x) x = ((u64)(usize)&tls_memory_sample_rng ^ OS::get_ticks()) | 1;
+        // xorshift64*.
+        x ^= x >> 12;
+        x ^= x << 25;
+        x ^= x >> 27;
+        tls_memory_sample_rng = x;
+        u64 r = x * 0x2545F4914F6CDD1DULL;
+        // Uniform value in (0, 1].
+        f64 u = ((f64)(r >> 11) + 1.0) * (1.0 / 9007199254740992.0);
+        f64 distance = -::log(u) * (f64)interval;
+        if(distance < 1.0) return 1;
+        if(distance >= (f64)(USIZE_MAX >> 1)) return USIZE_MAX >> 1;
+        return (usize)distance;
+    }
+    bool memory_profiler_sample_allocation(usize size)
+    {
+        usize interval = g_memory_sample_interval;
+        if(!interval) return true;
+        u32 epoch = g_memory_sample_epoch;
+        if(tls_memory_sample_epoch != epoch)
+        {
+            tls_memory_sample_epoch = epoch;
+            tls_memory_bytes_until_sample = draw_memory_sample_distance(interval);
+        }
+        if(size < tls_memory_bytes_until_sample)
+        {
+            tls_memory_bytes_until_sample -= size;
+            return false;
+        }
+        tls_memory_bytes_until_sample = draw_memory_sample_distance(interval);
+        return true;
+    }
+    void memory_profiler_record_allocation(void* ptr, usize size)
+    {
+        if(!g_profiler_inited) return;
+        MemorySampleRecord record;
+        record.size = size;
+        record.sampled_size = size;
+        record.domain = 0;
+        record.type = 0;
+        usize interval = g_memory_sample_interval;
+        if(interval && size)
+        {
+            // One block of `size` bytes is sampled with probability `1 - exp(-size / interval)`, so weighting 
+            // the block by the reciprocal gives one unbiased estimation.
+            f64 p = -::expm1(-(f64)size / (f64)interval);
+            record.sampled_size = p > 0.0 ? (usize)((f64)size / p) : interval;
+        }
+        u64 h = hash_memory_sample_ptr(ptr);
+        {
+            MemorySampleShard& shard = get_memory_sample_shard(h);
+            LockGuard guard(shard.m_lock);
+            auto r = shard.m_records.insert(make_pair((usize)ptr, record));
+            if(r.second) atom_inc_u32(&get_memory_sample_filter(h));
+            else r.first->second = record;
+        }
+        ProfilerThreadContext* ctx = get_profiler_thread_context();
+        count_memory_allocation(&ctx->m_memory_counters, record);
+        u32 max_frames = g_memory_sample_num_frames;
         ProfilerEventData::MemoryAllocate* data = (ProfilerEventData::MemoryAllocate*)allocate_profiler_event_data(
-                sizeof(ProfilerEventData::MemoryAllocate), 
+                sizeof(ProfilerEventData::MemoryAllocate) + sizeof(opaque_t) * max_frames, 
                 alignof(ProfilerEventData::MemoryAllocate));
         data->ptr = ptr;
         data->size = size;
+        data->sampled_size = record.sampled_size;
+        opaque_t* frames = (opaque_t*)(data + 1);
+        data->num_frames = max_frames ? OS::stack_backtrace(Span<opaque_t>(frames, max_frames)) : 0;
+        data->frames = data->num_frames ? frames : nullptr;
         submit_profiler_event(ProfilerEventId::MEMORY_ALLOCATE);
     }
+    // Sets the domain or type of one recorded memory block, and moves its counters to the new domain or type.
+    // Returns `false` if the memory block is not recorded.
+    bool set_memory_sample_tag(void* ptr, u64 key, bool is_type)
+    {
+        u64 h = hash_memory_sample_ptr(ptr);
+        if(!get_memory_sample_filter(h)) return false;
+        MemorySampleRecord record;
+        u64 old_key;
+        {
+            MemorySampleShard& shard = get_memory_sample_shard(h);
+            LockGuard guard(shard.m_lock);
+            auto iter = shard.m_records.find((usize)ptr);
+            if(iter == shard.m_records.end()) return false;
+            u64& tag = is_type ? iter->second.type : iter->second.domain;
+            old_key = tag;
+            tag = key;
+            record = iter->second;
+        }
+        if(old_key != key)
+        {
+            ProfilerThreadContext* ctx = get_profiler_thread_context();
+            if(old_key) count_memory_deallocation(find_memory_counter_slot(ctx->m_memory_tag_counters, old_key, true), record);
+            count_memory_allocation(find_memory_counter_slot(ctx->m_memory_tag_counters, key, true), record);
+        }
+        return true;
+    }
+    LUNA_RUNTIME_API void memory_profiler_allocate(void* ptr, usize size)
+    {
+        if(memory_profiler_sample_allocation(size))
+        {
+            memory_profiler_record_allocation(ptr, size);
+        }
+    }
     LUNA_RUNTIME_API void memory_profiler_deallocate(void* ptr)
     {
+        u64 h = hash_memory_sample_ptr(ptr);
+        u32 volatile& filter = get_memory_sample_filter(h);
+        if(!filter) return;
+        MemorySampleRecord record;
+        {
+            MemorySampleShard& shard = get_memory_sample_shard(h);
+            LockGuard guard(shard.m_lock);
+            auto iter = shard.m_records.find((usize)ptr);
+            if(iter == shard.m_records.end()) return;
+            record = iter->second;
+            shard.m_records.erase(iter);
+            atom_dec_u32(&filter);
+        }
+        ProfilerThreadContext* ctx = get_profiler_thread_context();
+        count_memory_deallocation(&ctx->m_memory_counters, record);
+        if(record.domain) count_memory_deallocation(find_memory_counter_slot(ctx->m_memory_tag_counters, record.domain, true), record);
+        if(record.type) count_memory_deallocation(find_memory_counter_slot(ctx->m_memory_tag_counters, record.type, true), record);
         ProfilerEventData::MemoryDeallocate* data = (ProfilerEventData::MemoryDeallocate*)allocate_profiler_event_data(
             sizeof(ProfilerEventData::MemoryDeallocate),
             alignof(ProfilerEventData::MemoryDeallocate)
@@ -223,6 +1048,13 @@ namespace Luna
     }
     LUNA_RUNTIME_API void memory_profiler_set_memory_name(void* ptr, const c8* name, usize str_size)
     {
+        u64 h = hash_memory_sample_ptr(ptr);
+        if(!get_memory_sample_filter(h)) return;
+        {
+            MemorySampleShard& shard = get_memory_sample_shard(h);
+            LockGuard guard(shard.m_lock);
+            if(shard.m_records.find((usize)ptr) == shard.m_records.end()) return;
+        }
         if(str_size == USIZE_MAX) str_size = strlen(name);
         usize sz = sizeof(ProfilerEventData::SetMemoryName) + str_size; // One extra character is allocated in structure.
         ProfilerEventData::SetMemoryName* data = (ProfilerEventData::SetMemoryName*)allocate_profiler_event_data(sz, alignof(ProfilerEventData::SetMemoryName));
@@ -235,6 +1067,7 @@ namespace Luna
     LUNA_RUNTIME_API void memory_profiler_set_memory_type(void* ptr, const c8* type, usize str_size)
     {
         if(str_size == USIZE_MAX) str_size = strlen(type);
+        if(!set_memory_sample_tag(ptr, get_memory_tag_key(type, str_size, MEMORY_TYPE_KEY_SEED), true)) return;
         usize sz = sizeof(ProfilerEventData::SetMemoryType) + str_size; // One extra character is allocated in structure.
         ProfilerEventData::SetMemoryType* data = (ProfilerEventData::SetMemoryType*)allocate_profiler_event_data(sz, alignof(ProfilerEventData::SetMemoryType));
         data->ptr = ptr;
@@ -246,6 +1079,7 @@ namespace Luna
     LUNA_RUNTIME_API void memory_profiler_set_memory_domain(void* ptr, const c8* domain, usize str_size)
     {
         if(str_size == USIZE_MAX) str_size = strlen(domain);
+        if(!set_memory_sample_tag(ptr, get_memory_tag_key(domain, str_size, MEMORY_DOMAIN_KEY_SEED), false)) return;
         usize sz = sizeof(ProfilerEventData::SetMemoryDomain) + str_size; // One extra character is allocated in structure.
         ProfilerEventData::SetMemoryDomain* data = (ProfilerEventData::SetMemoryDomain*)allocate_profiler_event_data(sz, alignof(ProfilerEventData::SetMemoryDomain));
         data->ptr = ptr;
@@ -254,5 +1088,48 @@ namespace Luna
         dst[str_size] = 0;
         submit_profiler_event(ProfilerEventId::SET_MEMORY_DOMAIN);
     }
+    LUNA_RUNTIME_API void memory_profiler_set_sampling(usize sample_interval, u32 num_stack_frames)
+    {
+        g_memory_sample_interval = sample_interval;
+        g_memory_sample_num_frames = num_stack_frames;
+        atom_inc_u32(&g_memory_sample_epoch);
+    }
+    LUNA_RUNTIME_API usize memory_profiler_get_sample_interval()
+    {
+        return g_memory_sample_interval;
+    }
+    LUNA_RUNTIME_API MemoryProfilerCounters memory_profiler_get_counters()
+    {
+        LockGuard guard(g_memory_counters_lock);
+        MemoryProfilerCounters r = g_retired_memory_counters;
+        for(ProfilerThreadContext* ctx = g_memory_counters_contexts; ctx; ctx = ctx->m_next_context)
+        {
+            add_memory_counters(r, ctx->m_memory_counters);
+        }
+        return r;
+    }
+    MemoryProfilerCounters get_memory_tag_counters(u64 key)
+    {
+        LockGuard guard(g_memory_counters_lock);
+        MemoryProfilerCounters r;
+        MemoryProfilerCounters* src = find_memory_counter_slot(g_retired_memory_tag_counters, key, false);
+        if(src) add_memory_counters(r, *src);
+        for(ProfilerThreadContext* ctx = g_memory_counters_contexts; ctx; ctx = ctx->m_next_context)
+        {
+            src = find_memory_counter_slot(ctx->m_memory_tag_counters, key, false);
+            if(src) add_memory_counters(r, *src);
+        }
+        return r;
+    }
+    LUNA_RUNTIME_API MemoryProfilerCounters memory_profiler_get_domain_counters(const c8* domain, usize str_size)
+    {
+        if(str_size == USIZE_MAX) str_size = strlen(domain);
+        return get_memory_tag_counters(get_memory_tag_key(domain, str_size, MEMORY_DOMAIN_KEY_SEED));
+    }
+    LUNA_RUNTIME_API MemoryProfilerCounters memory_profiler_get_type_counters(const c8* type, usize str_size)
+    {
+        if(str_size == USIZE_MAX) str_size = strlen(type);
+        return get_memory_tag_counters(get_memory_tag_key(type, str_size, MEMORY_TYPE_KEY_SEED));
+    }
 #endif
-}
\ No newline at end of file
+}
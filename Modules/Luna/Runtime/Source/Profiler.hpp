@@ -14,4 +14,11 @@ namespace Luna
 {
     void profiler_init();
     void profiler_close();
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+    // Checks whether one allocation of `size` bytes should be recorded. This is called for every allocation, so it only 
+    // touches thread-local data.
+    bool memory_profiler_sample_allocation(usize size);
+    // Records one allocation that is accepted by `memory_profiler_sample_allocation` and emits the allocation event.
+    void memory_profiler_record_allocation(void* ptr, usize size);
+#endif
 }
\ No newline at end of file
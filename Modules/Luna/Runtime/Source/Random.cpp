@@ -10,80 +10,85 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_RUNTIME_API LUNA_EXPORT
 #include "Random.hpp"
-#include "../Mutex.hpp"
+#include "../Atomic.hpp"
 #include <Luna/Runtime/Time.hpp>
 namespace Luna
 {
-    std::mt19937 g_random_engine;
-    Ref<IMutex> g_random_mutex;
+    // The seed of the first thread generator. Generators of other threads are seeded by adding multiples of one 
+    // large odd constant to this, and are decorrelated by splitmix64 in `Xoshiro256::seed`.
+    u64 g_random_base_seed;
+    u64 volatile g_random_num_thread_generators;
+
+    struct ThreadRandom
+    {
+        Xoshiro256 engine;
+        bool initialized = false;
+    };
+    static thread_local ThreadRandom tls_random;
+
+    inline Xoshiro256& get_thread_random_engine()
+    {
+        ThreadRandom& r = tls_random;
+        if (!r.initialized)
+        {
+            u64 index = atom_inc_u64(&g_random_num_thread_generators);
+            r.engine.seed(g_random_base_seed + index * 0xD1B54A32D192ED03ULL);
+            r.initialized = true;
+        }
+        return r.engine;
+    }
     void random_init()
     {
         register_boxed_type<Random>();
         impl_interface_for_type<Random, IRandom>();
-        g_random_engine.seed((unsigned int)get_ticks());
-        g_random_mutex = new_mutex();
+        register_boxed_type<FastRandom>();
+        impl_interface_for_type<FastRandom, IRandom>();
+        g_random_base_seed = get_ticks();
+        g_random_num_thread_generators = 0;
     }
-    void random_close()
+    void random_close() {}
+    LUNA_RUNTIME_API Ref<IRandom> new_random_number_generator(u32 initial_seed)
     {
-        g_random_mutex = nullptr;
+        auto ret = new_object<Random>();
+        ret->set_seed(initial_seed);
+        return ret;
     }
-    LUNA_RUNTIME_API Ref<IRandom> new_random(u32 initial_seed)
+    LUNA_RUNTIME_API Ref<IRandom> new_fast_random_number_generator(u32 initial_seed)
     {
-        auto ret = new_object<Random>();
+        auto ret = new_object<FastRandom>();
         ret->set_seed(initial_seed);
         return ret;
     }
     LUNA_RUNTIME_API u32 random_u32()
     {
-        g_random_mutex->wait();
-        u32 r = g_random_engine();
-        g_random_mutex->unlock();
-        return r;
+        return (u32)(get_thread_random_engine().next() >> 32);
     }
     LUNA_RUNTIME_API i32 random_i32()
     {
-        g_random_mutex->wait();
-        i32 r = (i32)g_random_engine();
-        g_random_mutex->unlock();
-        return r;
+        return (i32)(get_thread_random_engine().next() >> 32);
     }
     LUNA_RUNTIME_API u64 random_u64()
     {
-        g_random_mutex->wait();
-        u64 r = ((u64)g_random_engine()) + (((u64)g_random_engine()) << 32);
-        g_random_mutex->unlock();
-        return r;
+        return get_thread_random_engine().next();
     }
     LUNA_RUNTIME_API i64 random_i64()
     {
-        g_random_mutex->wait();
-        i64 r = ((i64)g_random_engine()) + (((i64)g_random_engine()) << 32);
-        g_random_mutex->unlock();
-        return r;
+        return (i64)get_thread_random_engine().next();
     }
     LUNA_RUNTIME_API f32 random_f32(f32 range_begin, f32 range_end)
     {
-        g_random_mutex->wait();
-        std::uniform_real_distribution<f32> dis(range_begin, range_end);
-        f64 r = dis(g_random_engine);
-        g_random_mutex->unlock();
-        return r;
+        return range_begin + (range_end - range_begin) * random_bits_to_unit_f32(get_thread_random_engine().next());
     }
     LUNA_RUNTIME_API f64 random_f64(f64 range_begin, f64 range_end)
     {
-        g_random_mutex->wait();
-        std::uniform_real_distribution<f64> dis(range_begin, range_end);
-        f64 r = dis(g_random_engine);
-        g_random_mutex->unlock();
-        return r;
+        return range_begin + (range_end - range_begin) * random_bits_to_unit_f64(get_thread_random_engine().next());
     }
     LUNA_RUNTIME_API Guid random_guid()
     {
-        g_random_mutex->wait();
+        Xoshiro256& engine = get_thread_random_engine();
         Guid guid;
-        guid.low = random_u64();
-        guid.high = random_u64();
-        g_random_mutex->unlock();
+        guid.low = engine.next();
+        guid.high = engine.next();
         return guid;
     }
 }
\ No newline at end of file
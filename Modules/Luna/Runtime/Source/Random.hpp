@@ -13,6 +13,53 @@
 
 namespace Luna
 {
+    // Converts the high 24 bits of one random integer to one floating-point number in [0, 1).
+    inline f32 random_bits_to_unit_f32(u64 bits)
+    {
+        return (f32)(bits >> 40) * (1.0f / 16777216.0f);
+    }
+    // Converts the high 53 bits of one random integer to one floating-point number in [0, 1).
+    inline f64 random_bits_to_unit_f64(u64 bits)
+    {
+        return (f64)(bits >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    // The xoshiro256** generator by David Blackman and Sebastiano Vigna.
+    struct Xoshiro256
+    {
+        u64 m_state[4];
+
+        static u64 rotl(u64 x, i32 k)
+        {
+            return (x << k) | (x >> (64 - k));
+        }
+        // Expands one seed to the generator state using splitmix64, so that similar seeds generate 
+        // uncorrelated sequences.
+        void seed(u64 seed)
+        {
+            for (u32 i = 0; i < 4; ++i)
+            {
+                seed += 0x9E3779B97F4A7C15ULL;
+                u64 z = seed;
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+                m_state[i] = z ^ (z >> 31);
+            }
+        }
+        u64 next()
+        {
+            u64 result = rotl(m_state[1] * 5, 7) * 9;
+            u64 t = m_state[1] << 17;
+            m_state[2] ^= m_state[0];
+            m_state[3] ^= m_state[1];
+            m_state[1] ^= m_state[2];
+            m_state[0] ^= m_state[3];
+            m_state[2] ^= t;
+            m_state[3] = rotl(m_state[3], 45);
+            return result;
+        }
+    };
+
     struct Random : IRandom
     {
         lustruct("Random", "{4f09c790-fa3c-4613-b511-2d0175e15582}");
@@ -59,6 +106,78 @@ namespace Luna
             guid.high = gen_u64();
             return guid;
         }
+        virtual void gen_u32s(Span<u32> dst) override
+        {
+            for (u32& v : dst) v = m_engine();
+        }
+        virtual void gen_f32s(Span<f32> dst, f32 range_begin, f32 range_end) override
+        {
+            std::uniform_real_distribution<f32> dis(range_begin, range_end);
+            for (f32& v : dst) v = dis(m_engine);
+        }
+    };
+
+    struct FastRandom : IRandom
+    {
+        lustruct("FastRandom", "{a3d85e1f-6c27-4b90-8f4e-0b7d29c6e513}");
+        luiimpl();
+
+        Xoshiro256 m_engine;
+
+        FastRandom() {}
+
+        virtual void set_seed(u32 seed) override
+        {
+            m_engine.seed(seed);
+        }
+        virtual u32 gen_u32() override
+        {
+            return (u32)(m_engine.next() >> 32);
+        }
+        virtual i32 gen_i32() override
+        {
+            return (i32)(m_engine.next() >> 32);
+        }
+        virtual u64 gen_u64() override
+        {
+            return m_engine.next();
+        }
+        virtual i64 gen_i64() override
+        {
+            return (i64)m_engine.next();
+        }
+        virtual f32 gen_f32(f32 range_begin, f32 range_end) override
+        {
+            return range_begin + (range_end - range_begin) * random_bits_to_unit_f32(m_engine.next());
+        }
+        virtual f64 gen_f64(f64 range_begin, f64 range_end) override
+        {
+            return range_begin + (range_end - range_begin) * random_bits_to_unit_f64(m_engine.next());
+        }
+        virtual Guid gen_guid() override
+        {
+            Guid guid;
+            guid.low = m_engine.next();
+            guid.high = m_engine.next();
+            return guid;
+        }
+        virtual void gen_u32s(Span<u32> dst) override
+        {
+            // Every 64-bit output generates two numbers.
+            usize i = 0;
+            for (; i + 1 < dst.size(); i += 2)
+            {
+                u64 r = m_engine.next();
+                dst[i] = (u32)r;
+                dst[i + 1] = (u32)(r >> 32);
+            }
+            if (i < dst.size()) dst[i] = (u32)(m_engine.next() >> 32);
+        }
+        virtual void gen_f32s(Span<f32> dst, f32 range_begin, f32 range_end) override
+        {
+            f32 range = range_end - range_begin;
+            for (f32& v : dst) v = range_begin + range * random_bits_to_unit_f32(m_engine.next());
+        }
     };
 
     void random_init();
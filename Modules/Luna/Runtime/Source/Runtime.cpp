@@ -20,22 +20,36 @@
 #include "Semaphore.hpp"
 #include "File.hpp"
 #include "Thread.hpp"
+#include "Fiber.hpp"
 #include "TypeInfo.hpp"
 #include "Interface.hpp"
 #include "Random.hpp"
 #include "ReadWriteLock.hpp"
 #include "StdIO.hpp"
+#include "Compression.hpp"
 #include "Profiler.hpp"
 namespace Luna
 {
+    void cpu_init();
     void error_init();
     void error_close();
     void object_close();
     void add_builtin_typeinfo();
 
+    void async_file_close();
+
     void log_init();
     void log_close();
 
+    void perf_counter_init();
+    void perf_counter_close();
+    void file_init();
+    void file_close();
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+    void allocation_tracker_init();
+    void allocation_tracker_close();
+#endif
+
     void register_types_and_interfaces()
     {
         register_boxed_type<Signal>();
@@ -48,14 +62,22 @@ namespace Luna
         impl_interface_for_type<File, IFile, ISeekableStream, IStream>();
         register_boxed_type<FileIterator>();
         impl_interface_for_type<FileIterator, IFileIterator>();
+        register_boxed_type<MappedFile>();
+        impl_interface_for_type<MappedFile, IMappedFile>();
         register_boxed_type<Thread>();
         impl_interface_for_type<Thread, IWaitable, IThread>();
         register_boxed_type<MainThread>();
         impl_interface_for_type<MainThread, IWaitable, IThread>();
+        register_boxed_type<Fiber>();
+        impl_interface_for_type<Fiber, IFiber>();
         register_boxed_type<ReadWriteLock>();
         impl_interface_for_type<ReadWriteLock, IReadWriteLock>();
         register_boxed_type<StdIOStream>();
         impl_interface_for_type<StdIOStream, IStream>();
+        register_boxed_type<CompressionStream>();
+        impl_interface_for_type<CompressionStream, ICompressionStream, IStream>();
+        register_boxed_type<DecompressionStream>();
+        impl_interface_for_type<DecompressionStream, IStream>();
     }
 
     static bool g_initialized = false;
@@ -64,7 +86,13 @@ namespace Luna
     {
         if (g_initialized) return true;
         OS::init();
+        cpu_init();
         profiler_init();
+        perf_counter_init();
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        allocation_tracker_init();
+#endif
+        file_init();
         error_init();
         name_init();
         type_registry_init();
@@ -82,6 +110,7 @@ namespace Luna
     {
         if (!g_initialized) return;
         module_close();
+        async_file_close();
         std_io_close();
         log_close();
         random_close();
@@ -90,6 +119,11 @@ namespace Luna
         type_registry_close();
         name_close();
         error_close();
+        file_close();
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        allocation_tracker_close();
+#endif
+        perf_counter_close();
         profiler_close();
         OS::close();
         g_initialized = false;
@@ -18,10 +18,10 @@ namespace Luna
 
     static R<Variant> default_structure_serialization(typeinfo_t type, const void* inst)
     {
-        Variant ret(VariantType::object);
+        auto properties = get_struct_properties(type);
+        Variant ret(VariantType::object, properties.size());
         lutry
         {
-            auto properties = get_struct_properties(type);
             for(auto& prop : properties)
             {
                 if (is_type_serializable(prop.type))
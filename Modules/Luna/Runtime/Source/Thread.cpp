@@ -43,6 +43,11 @@ namespace Luna
     {
         return OS::get_num_processors();
     }
+    LUNA_RUNTIME_API u32 get_processor_cache_domain(u32 processor)
+    {
+        lucheck(processor < get_processors_count());
+        return OS::get_processor_cache_domain(processor);
+    }
     LUNA_RUNTIME_API Ref<IThread> new_thread(void(*entry_func)(void* params), void* params, const c8* name, u32 stack_size)
     {
         luassert(entry_func);
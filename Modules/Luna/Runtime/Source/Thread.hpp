@@ -36,6 +36,10 @@ namespace Luna
         {
             OS::set_thread_priority(m_handle, priority);
         }
+        virtual RV set_affinity(u64 processor_mask) override
+        {
+            return OS::set_thread_affinity(m_handle, processor_mask);
+        }
         ~Thread()
         {
             if (m_handle)
@@ -67,6 +71,10 @@ namespace Luna
         {
             OS::set_thread_priority(m_handle, priority);
         }
+        virtual RV set_affinity(u64 processor_mask) override
+        {
+            return OS::set_thread_affinity(m_handle, processor_mask);
+        }
     };
     void thread_init();
     void thread_close();
@@ -10,8 +10,8 @@
 #include "../PlatformDefines.hpp"
 #define LUNA_RUNTIME_API LUNA_EXPORT
 #include "TypeInfo.hpp"
-#include "../UnorderedMultiMap.hpp"
 #include "../HashMap.hpp"
+#include "../Atomic.hpp"
 #include "OS.hpp"
 
 namespace Luna
@@ -19,8 +19,30 @@ namespace Luna
     Vector<UniquePtr<TypeInfo>> g_type_registry;
     opaque_t g_type_registry_lock;
 
-    UnorderedMultiMap<Name, NamedTypeInfo*> g_type_name_map;
-    HashMap<Guid, NamedTypeInfo*> g_type_guid_map;
+    // The insert-only open addressing hash table used to look up named types without locking.
+    // Slots are published atomically and are never removed before the registry is closed, so readers can probe 
+    // the table while one writer holding `g_type_registry_lock` inserts new types.
+    struct TypeLookupTable
+    {
+        usize mask;
+        NamedTypeInfo* volatile* slots;
+    };
+    struct TypeLookupMap
+    {
+        TypeLookupTable* volatile table = nullptr;
+        usize size = 0;
+        // Tables replaced by larger ones. Readers may still probe them, so they are freed only when the registry is closed.
+        Vector<TypeLookupTable*> retired_tables;
+    };
+
+    // Types indexed by their names and aliases.
+    TypeLookupMap g_type_name_map;
+    // Types indexed by their GUIDs.
+    TypeLookupMap g_type_guid_map;
+
+    // Interned IDs are cached by `get_interface_id<_Ty>` in static variables, so this map is not cleared 
+    // when the type registry is closed to keep cached IDs valid.
+    HashMap<Guid, interface_id_t> g_interned_guid_map;
 
     static typeinfo_t g_void_type;
     static typeinfo_t g_u8_type;
@@ -67,6 +89,103 @@ namespace Luna
         }
     }
 
+    // `g_type_registry_lock` must be locked when calling this.
+    static interface_id_t intern_guid(const Guid& guid)
+    {
+        auto iter = g_interned_guid_map.find(guid);
+        if (iter != g_interned_guid_map.end()) return iter->second;
+        interface_id_t id = (interface_id_t)g_interned_guid_map.size();
+        g_interned_guid_map.insert(make_pair(guid, id));
+        return id;
+    }
+    interface_id_t find_interned_guid(const Guid& guid)
+    {
+        OSMutexGuard guard(g_type_registry_lock);
+        auto iter = g_interned_guid_map.find(guid);
+        return iter == g_interned_guid_map.end() ? INVALID_INTERFACE_ID : iter->second;
+    }
+    LUNA_RUNTIME_API interface_id_t get_interface_id(const Guid& guid)
+    {
+        OSMutexGuard guard(g_type_registry_lock);
+        return intern_guid(guid);
+    }
+
+    inline usize hash_type_name(const Name& name, const Name& alias)
+    {
+        return hash<Name>()(name) ^ (hash<Name>()(alias) * 31);
+    }
+    inline usize hash_type_guid(const Guid& guid)
+    {
+        return hash<Guid>()(guid);
+    }
+    static TypeLookupTable* new_type_lookup_table(usize capacity)
+    {
+        TypeLookupTable* table = (TypeLookupTable*)memalloc(sizeof(TypeLookupTable) + sizeof(NamedTypeInfo*) * capacity, alignof(TypeLookupTable));
+        table->mask = capacity - 1;
+        table->slots = (NamedTypeInfo* volatile*)(table + 1);
+        memzero((void*)table->slots, sizeof(NamedTypeInfo*) * capacity);
+        return table;
+    }
+    static void type_lookup_table_insert(TypeLookupTable* table, usize hash_code, NamedTypeInfo* type)
+    {
+        usize i = hash_code & table->mask;
+        while (table->slots[i]) i = (i + 1) & table->mask;
+        // The exchange makes all writes to the type visible before the slot is visible to readers.
+        atom_exchange_pointer(&table->slots[i], type);
+    }
+    // `g_type_registry_lock` must be locked when calling this.
+    static void type_lookup_map_insert(TypeLookupMap& map, NamedTypeInfo* type, usize(*hash_func)(NamedTypeInfo*))
+    {
+        TypeLookupTable* table = map.table;
+        // Keeps the load factor under 0.5 so that probing sequences are short.
+        if (!table || (map.size + 1) * 2 > table->mask + 1)
+        {
+            TypeLookupTable* new_table = new_type_lookup_table(table ? (table->mask + 1) * 2 : 64);
+            if (table)
+            {
+                for (usize i = 0; i <= table->mask; ++i)
+                {
+                    NamedTypeInfo* t = table->slots[i];
+                    if (t) type_lookup_table_insert(new_table, hash_func(t), t);
+                }
+                map.retired_tables.push_back(table);
+            }
+            atom_exchange_pointer(&map.table, new_table);
+            table = new_table;
+        }
+        type_lookup_table_insert(table, hash_func(type), type);
+        ++map.size;
+    }
+    template <typename _Pred>
+    static NamedTypeInfo* type_lookup_map_find(const TypeLookupMap& map, usize hash_code, _Pred pred)
+    {
+        TypeLookupTable* table = map.table;
+        if (!table) return nullptr;
+        usize i = hash_code & table->mask;
+        while (true)
+        {
+            NamedTypeInfo* t = table->slots[i];
+            if (!t) return nullptr;
+            if (pred(t)) return t;
+            i = (i + 1) & table->mask;
+        }
+    }
+    static void type_lookup_map_clear(TypeLookupMap& map)
+    {
+        for (TypeLookupTable* table : map.retired_tables) memfree(table, alignof(TypeLookupTable));
+        map.retired_tables.clear();
+        map.retired_tables.shrink_to_fit();
+        if (map.table) memfree(map.table, alignof(TypeLookupTable));
+        map.table = nullptr;
+        map.size = 0;
+    }
+    // `g_type_registry_lock` must be locked when calling this.
+    static void add_named_type(NamedTypeInfo* type)
+    {
+        type_lookup_map_insert(g_type_name_map, type, [](NamedTypeInfo* t) { return hash_type_name(t->name, t->alias); });
+        type_lookup_map_insert(g_type_guid_map, type, [](NamedTypeInfo* t) { return hash_type_guid(t->guid); });
+    }
+
     inline typeinfo_t add_primitive_typeinfo(const Name& name, const Guid& guid, usize size, usize alignment)
     {
         UniquePtr<TypeInfo> ti(memnew<PrimitiveTypeInfo>());
@@ -74,11 +193,11 @@ namespace Luna
         t->kind = TypeKind::primitive;
         t->name = name;
         t->guid = guid;
+        t->interned_id = intern_guid(guid);
         t->size = size;
         t->alignment = alignment;
         g_type_registry.push_back(move(ti));
-        g_type_name_map.insert(make_pair(name, t));
-        g_type_guid_map.insert(make_pair(guid, t));
+        add_named_type(t);
         return (typeinfo_t)t;
     }
 
@@ -107,9 +226,8 @@ namespace Luna
     {
         g_type_registry.clear();
         g_type_registry.shrink_to_fit();
-        g_type_name_map.clear();
-        g_type_guid_map.clear();
-        g_type_guid_map.shrink_to_fit();
+        type_lookup_map_clear(g_type_name_map);
+        type_lookup_map_clear(g_type_guid_map);
         OS::delete_mutex(g_type_registry_lock);
     }
     static void structure_default_construct(typeinfo_t type, void* data)
@@ -210,6 +328,7 @@ namespace Luna
         auto st = (StructureTypeInfo*)t.get();
         st->kind = TypeKind::structure;
         st->guid = desc.guid;
+        st->interned_id = intern_guid(desc.guid);
         st->name = desc.name;
         st->alias = desc.alias;
         st->size = desc.size;
@@ -248,8 +367,7 @@ namespace Luna
         if (!st->copy_assign && use_default_copy_assign) st->copy_assign = structure_default_copy_assign;
         if (!st->move_assign && use_default_move_assign) st->move_assign = structure_default_move_assign;
         g_type_registry.push_back(move(t));
-        g_type_name_map.insert(make_pair(st->name, (NamedTypeInfo*)st));
-        g_type_guid_map.insert(make_pair(st->guid, (NamedTypeInfo*)st));
+        add_named_type(st);
         return (typeinfo_t)st;
     }
     LUNA_RUNTIME_API typeinfo_t register_generic_struct_type(const GenericStructureTypeDesc& desc)
@@ -263,14 +381,14 @@ namespace Luna
         auto st = (GenericStructureTypeInfo*)t.get();
         st->kind = TypeKind::generic_structure;
         st->guid = desc.guid;
+        st->interned_id = intern_guid(desc.guid);
         st->name = desc.name;
         st->alias = desc.alias;
         st->generic_parameter_names.assign_n(desc.generic_parameter_names.data(), desc.generic_parameter_names.size());
         st->variable_generic_parameters = desc.variable_generic_parameters;
         st->instantiate = desc.instantiate;
         g_type_registry.push_back(move(t));
-        g_type_name_map.insert(make_pair(st->name, (NamedTypeInfo*)st));
-        g_type_guid_map.insert(make_pair(st->guid, (NamedTypeInfo*)st));
+        add_named_type(st);
         return (typeinfo_t)st;
     }
     LUNA_RUNTIME_API typeinfo_t register_enum_type(const EnumerationTypeDesc& desc)
@@ -286,14 +404,14 @@ namespace Luna
         EnumerationTypeInfo* et = (EnumerationTypeInfo*)t.get();
         et->kind = TypeKind::enumeration;
         et->guid = desc.guid;
+        et->interned_id = intern_guid(desc.guid);
         et->name = desc.name;
         et->alias = desc.alias;
         et->underlying_type = (PrimitiveTypeInfo*)ut;
         et->multienum = desc.multienum;
         et->options.assign_n(desc.options.data(), desc.options.size());
         g_type_registry.push_back(move(t));
-        g_type_name_map.insert(make_pair(et->name, (NamedTypeInfo*)et));
-        g_type_guid_map.insert(make_pair(et->guid, (NamedTypeInfo*)et));
+        add_named_type(et);
         return (typeinfo_t)et;
     }
 
@@ -352,39 +470,40 @@ namespace Luna
         if (!gt->copy_assign && use_default_copy_assign) gt->copy_assign = structure_default_copy_assign;
         if (!gt->move_assign && use_default_move_assign) gt->move_assign = structure_default_move_assign;
         g_type_registry.push_back(move(t));
-        generic_type->generic_instanced_types.push_back(gt);
+        gt->next_instanced_type = generic_type->first_instanced_type;
+        atom_exchange_pointer(&generic_type->first_instanced_type, gt);
         return (typeinfo_t)gt;
     }
     LUNA_RUNTIME_API typeinfo_t get_type_by_name(const Name& name, const Name& alias)
     {
-        OSMutexGuard guard(g_type_registry_lock);
-        auto range = g_type_name_map.equal_range(name);
-        if (range.first == range.second) return nullptr;
-        for (auto iter = range.first; iter != range.second; ++iter)
-        {
-            NamedTypeInfo* type = iter->second;
-            if (type->alias != alias) continue;
-            return (typeinfo_t)type;
-        }
-        return nullptr;
+        return (typeinfo_t)type_lookup_map_find(g_type_name_map, hash_type_name(name, alias), 
+            [&](NamedTypeInfo* t) { return t->name == name && t->alias == alias; });
     }
     LUNA_RUNTIME_API typeinfo_t get_type_by_guid(const Guid& guid)
     {
-        OSMutexGuard guard(g_type_registry_lock);
-        auto iter = g_type_guid_map.find(guid);
-        if (iter == g_type_guid_map.end()) return nullptr;
-        return (typeinfo_t)(iter->second);
+        return (typeinfo_t)type_lookup_map_find(g_type_guid_map, hash_type_guid(guid), 
+            [&](NamedTypeInfo* t) { return t->guid == guid; });
+    }
+    static GenericStructureInstancedTypeInfo* find_instanced_type(GenericStructureTypeInfo* generic_type, Span<const typeinfo_t> generic_arguments)
+    {
+        for (GenericStructureInstancedTypeInfo* gt = generic_type->first_instanced_type; gt; gt = gt->next_instanced_type)
+        {
+            if (generic_arguments_equal(gt->generic_arguments.data(), gt->generic_arguments.size(), generic_arguments.data(), generic_arguments.size())) return gt;
+        }
+        return nullptr;
     }
     LUNA_RUNTIME_API typeinfo_t get_generic_instanced_type(typeinfo_t generic_type, Span<const typeinfo_t> generic_arguments)
     {
-        OSMutexGuard guard(g_type_registry_lock);
         if (((TypeInfo*)generic_type)->kind != TypeKind::generic_structure) return nullptr;
         GenericStructureTypeInfo* st = (GenericStructureTypeInfo*)generic_type;
-        for (GenericStructureInstancedTypeInfo* gt : st->generic_instanced_types)
-        {
-            if (generic_arguments_equal(gt->generic_arguments.data(), gt->generic_arguments.size(), generic_arguments.data(), generic_arguments.size())) return (typeinfo_t)gt;
-        }
+        // Finds existing instanced types without locking.
+        GenericStructureInstancedTypeInfo* gt = find_instanced_type(st, generic_arguments);
+        if (gt) return (typeinfo_t)gt;
         if (generic_arguments.size() == 0) return nullptr;
+        OSMutexGuard guard(g_type_registry_lock);
+        // Checks again in case that the type is created by another thread before the lock is acquired.
+        gt = find_instanced_type(st, generic_arguments);
+        if (gt) return (typeinfo_t)gt;
         // Creates a new type for generic arguments.
         return new_instanced_type(st, generic_arguments);
     }
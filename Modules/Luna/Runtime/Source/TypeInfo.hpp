@@ -9,6 +9,7 @@
 */
 #pragma once
 #include "../TypeInfo.hpp"
+#include "../Interface.hpp"
 #include "../UniquePtr.hpp"
 #include "../SpinLock.hpp"
 
@@ -29,10 +30,15 @@ namespace Luna
         void* data;
         usize alignment;
     };
+    using interface_cast_func_t = void*(object_t obj);
     struct TypeInfo
     {
         TypeKind kind;
+        //! The interned ID of the type GUID. This is `INVALID_INTERFACE_ID` for types without GUIDs.
+        interface_id_t interned_id = INVALID_INTERFACE_ID;
         Vector<TypeInfoPrivateData> private_data;
+        //! The interface dispatch table indexed by interned interface IDs. `nullptr` means that the interface is not implemented.
+        Vector<interface_cast_func_t*> interface_table;
         Vector<Pair<Name, Variant>> attributes;
         virtual ~TypeInfo();
     };
@@ -78,11 +84,14 @@ namespace Luna
         Array<Name> generic_parameter_names;
         bool variable_generic_parameters;
         generic_structure_instantiate_t* instantiate;
-        Vector<GenericStructureInstancedTypeInfo*> generic_instanced_types;
+        //! The head of the instanced type list. New instanced types are published by atomically replacing the head,
+        //! so the list can be traversed without locking `g_type_registry_lock`.
+        GenericStructureInstancedTypeInfo* volatile first_instanced_type = nullptr;
     };
     struct GenericStructureInstancedTypeInfo : public TypeInfo
     {
         GenericStructureTypeInfo* generic_type;
+        GenericStructureInstancedTypeInfo* next_instanced_type;
         Array<typeinfo_t> generic_arguments;
         usize size;
         usize alignment;
@@ -97,6 +106,9 @@ namespace Luna
         Array<StructureProperty> properties;
         bool trivially_relocatable;
     };
+    //! Finds the interned ID of one GUID without interning the GUID.
+    //! Returns `INVALID_INTERFACE_ID` if the GUID is not interned.
+    interface_id_t find_interned_guid(const Guid& guid);
     void type_registry_init();
     void type_registry_close();
 }
\ No newline at end of file
@@ -0,0 +1,47 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file VirtualMemory.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "../PlatformDefines.hpp"
+#define LUNA_RUNTIME_API LUNA_EXPORT
+#include "../VirtualMemory.hpp"
+#include "OS.hpp"
+
+namespace Luna
+{
+    LUNA_RUNTIME_API usize get_page_size()
+    {
+        return OS::get_page_size();
+    }
+    LUNA_RUNTIME_API usize get_large_page_size()
+    {
+        return OS::get_large_page_size();
+    }
+    LUNA_RUNTIME_API R<void*> virtual_reserve(usize size, VirtualMemoryFlag flags)
+    {
+        if(!size) return BasicError::bad_arguments();
+        return OS::virtual_reserve(align_upper(size, OS::get_page_size()), test_flags(flags, VirtualMemoryFlag::large_page));
+    }
+    LUNA_RUNTIME_API RV virtual_commit(void* ptr, usize size)
+    {
+        lucheck(((usize)ptr & (OS::get_page_size() - 1)) == 0);
+        if(!size) return ok;
+        return OS::virtual_commit(ptr, align_upper(size, OS::get_page_size()));
+    }
+    LUNA_RUNTIME_API RV virtual_decommit(void* ptr, usize size)
+    {
+        lucheck(((usize)ptr & (OS::get_page_size() - 1)) == 0);
+        if(!size) return ok;
+        return OS::virtual_decommit(ptr, align_upper(size, OS::get_page_size()));
+    }
+    LUNA_RUNTIME_API void virtual_release(void* ptr, usize size)
+    {
+        if(!ptr) return;
+        OS::virtual_release(ptr, align_upper(size, OS::get_page_size()));
+    }
+}
@@ -0,0 +1,546 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file StaticSerialization.hpp
+* @author JXMaster
+* @date 2024/3/18
+* @brief The compile-time generated serialization API.
+*/
+#pragma once
+#include "Serialization.hpp"
+#include "Vector.hpp"
+#include "Name.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeSerialization
+    //! @{
+
+    //! Describes one field of one structure that is serialized by static serialization.
+    //! @details Use @ref lufield to declare one field and @ref lufields to declare the field list of one structure.
+    template <typename _Ty, typename _Mty>
+    struct StaticField
+    {
+        //! The name of the field, used as the key when the structure is serialized to one variant.
+        const c8* name;
+        //! The member pointer of the field.
+        _Mty _Ty::* member;
+    };
+
+    //! Creates one @ref StaticField.
+    //! @param[in] name The name of the field.
+    //! @param[in] member The member pointer of the field.
+    //! @return Returns the created field.
+    template <typename _Ty, typename _Mty>
+    constexpr StaticField<_Ty, _Mty> make_static_field(const c8* name, _Mty _Ty::* member)
+    {
+        return StaticField<_Ty, _Mty>{ name, member };
+    }
+
+    namespace Impl
+    {
+        template <typename _Ty, typename = void>
+        struct HasStaticFields : false_type {};
+        template <typename _Ty>
+        struct HasStaticFields<_Ty, typename _Ty::__static_fields_tag> : true_type {};
+
+        template <typename _Func, typename... _Fields>
+        inline RV for_each_static_field(_Func& func, const _Fields&... fields)
+        {
+            RV r = ok;
+            ((r = func(fields), succeeded(r)) && ...);
+            return r;
+        }
+    }
+
+    //! Writes data encoded by @ref static_serialize_binary.
+    class StaticBinaryWriter
+    {
+    public:
+        //! The buffer that receives written data.
+        Vector<byte_t>& m_buffer;
+
+        StaticBinaryWriter(Vector<byte_t>& buffer) : m_buffer(buffer) {}
+
+        //! Appends bytes to the buffer.
+        //! @param[in] data The data to append.
+        //! @param[in] size The number of bytes to append.
+        void write(const void* data, usize size)
+        {
+            if (!size) return;
+            usize offset = m_buffer.size();
+            m_buffer.resize(offset + size);
+            memcpy(m_buffer.data() + offset, data, size);
+        }
+        //! Appends one trivially copyable value to the buffer.
+        template <typename _Ty>
+        void write_value(const _Ty& v)
+        {
+            write(&v, sizeof(_Ty));
+        }
+    };
+
+    //! Reads data encoded by @ref static_serialize_binary.
+    class StaticBinaryReader
+    {
+    public:
+        //! The current reading position.
+        const byte_t* m_cur;
+        //! The end of the data.
+        const byte_t* m_end;
+
+        StaticBinaryReader(const void* data, usize size) :
+            m_cur((const byte_t*)data),
+            m_end((const byte_t*)data + size) {}
+
+        //! Gets the number of bytes that are not read yet.
+        usize remaining_size() const
+        {
+            return (usize)(m_end - m_cur);
+        }
+        //! Reads bytes from the data.
+        //! @param[out] data The buffer to receive the read bytes.
+        //! @param[in] size The number of bytes to read.
+        //! @par Possible Errors
+        //! * BasicError::format_error
+        RV read(void* data, usize size)
+        {
+            if (remaining_size() < size) return set_error(BasicError::format_error(), "Unexpected end of static binary data.");
+            if (size) memcpy(data, m_cur, size);
+            m_cur += size;
+            return ok;
+        }
+        //! Reads one trivially copyable value from the data.
+        template <typename _Ty>
+        RV read_value(_Ty& v)
+        {
+            return read(&v, sizeof(_Ty));
+        }
+        //! Reads one element count from the data and checks that the remaining data is large enough to store
+        //! the specified number of elements, so that corrupted data does not trigger huge allocations.
+        //! @param[out] count The read count.
+        //! @param[in] min_element_size The minimum number of bytes one element takes in the data.
+        //! @par Possible Errors
+        //! * BasicError::format_error
+        RV read_count(usize& count, usize min_element_size)
+        {
+            u64 n;
+            lutry
+            {
+                luexp(read_value(n));
+            }
+            lucatchret;
+            if (min_element_size && n > (u64)(remaining_size() / min_element_size))
+            {
+                return set_error(BasicError::format_error(), "Invalid element count in static binary data.");
+            }
+            count = (usize)n;
+            return ok;
+        }
+    };
+
+    //! The static serializer of one type.
+    //! @details Static serializers are resolved at compile time, so serializing one instance with static serialization does not
+    //! look up types or properties at run time. Static serializers are provided for arithmetic types, enumeration types, @ref String,
+    //! @ref Name, @ref Guid, @ref Vector of serializable types, and structures that declare their fields by @ref lufields.
+    //! The user may provide static serializers for other types by specializing this template.
+    //!
+    //! The default implementation forwards variant serialization to @ref serialize and @ref deserialize, so any type that is
+    //! registered to the type system and set to be serializable can be used as one field. Binary serialization is not supported by
+    //! the default implementation.
+    //!
+    //! One static serializer provides the following static functions:
+    //! * `R<Variant> serialize(const _Ty& inst)`, serializes the instance to one variant.
+    //! * `RV deserialize(_Ty& inst, const Variant& data)`, deserializes the instance from one variant.
+    //! * `void write(StaticBinaryWriter& writer, const _Ty& inst)`, serializes the instance to binary data. Optional.
+    //! * `RV read(StaticBinaryReader& reader, _Ty& inst)`, deserializes the instance from binary data. Optional.
+    //! * `static constexpr usize min_binary_size`, the minimum number of bytes one instance takes in binary data. Optional.
+    template <typename _Ty, typename = void>
+    struct StaticSerializer
+    {
+        static R<Variant> serialize(const _Ty& inst)
+        {
+            return Luna::serialize(typeof<_Ty>(), &inst);
+        }
+        static RV deserialize(_Ty& inst, const Variant& data)
+        {
+            return Luna::deserialize(typeof<_Ty>(), &inst, data);
+        }
+    };
+
+    template <>
+    struct StaticSerializer<bool>
+    {
+        static constexpr usize min_binary_size = 1;
+        static R<Variant> serialize(const bool& inst) { return Variant(inst); }
+        static RV deserialize(bool& inst, const Variant& data) { inst = data.boolean(); return ok; }
+        static void write(StaticBinaryWriter& writer, const bool& inst) { writer.write_value((u8)(inst ? 1 : 0)); }
+        static RV read(StaticBinaryReader& reader, bool& inst)
+        {
+            u8 v;
+            lutry
+            {
+                luexp(reader.read_value(v));
+            }
+            lucatchret;
+            inst = v != 0;
+            return ok;
+        }
+    };
+
+    template <typename _Ty>
+    struct StaticSerializer<_Ty, enable_if_t<is_arithmetic_v<_Ty> && !is_same_v<_Ty, bool>>>
+    {
+        static constexpr usize min_binary_size = sizeof(_Ty);
+        // Character types are always serialized as unsigned numbers, like runtime serialization does.
+        static constexpr bool is_unsigned_number = is_unsigned_v<_Ty> || is_same_v<_Ty, c8> || is_same_v<_Ty, c16> || is_same_v<_Ty, c32>;
+        static R<Variant> serialize(const _Ty& inst)
+        {
+            if constexpr (is_floating_point_v<_Ty>) return Variant((f64)inst);
+            else if constexpr (is_unsigned_number) return Variant((u64)inst);
+            else return Variant((i64)inst);
+        }
+        static RV deserialize(_Ty& inst, const Variant& data)
+        {
+            if constexpr (is_floating_point_v<_Ty>) inst = (_Ty)data.fnum();
+            else if constexpr (is_unsigned_number) inst = (_Ty)data.unum();
+            else inst = (_Ty)data.inum();
+            return ok;
+        }
+        static void write(StaticBinaryWriter& writer, const _Ty& inst) { writer.write_value(inst); }
+        static RV read(StaticBinaryReader& reader, _Ty& inst) { return reader.read_value(inst); }
+    };
+
+    //! Enumerations are serialized to variants by option names using the runtime type information registered by @ref luenum, and are
+    //! serialized to binary data by their underlying values.
+    template <typename _Ty>
+    struct StaticSerializer<_Ty, enable_if_t<is_enum_v<_Ty>>>
+    {
+        using underlying_t = underlying_type_t<_Ty>;
+        static constexpr usize min_binary_size = sizeof(underlying_t);
+        static R<Variant> serialize(const _Ty& inst) { return Luna::serialize(typeof<_Ty>(), &inst); }
+        static RV deserialize(_Ty& inst, const Variant& data) { return Luna::deserialize(typeof<_Ty>(), &inst, data); }
+        static void write(StaticBinaryWriter& writer, const _Ty& inst) { writer.write_value((underlying_t)inst); }
+        static RV read(StaticBinaryReader& reader, _Ty& inst)
+        {
+            underlying_t v;
+            lutry
+            {
+                luexp(reader.read_value(v));
+            }
+            lucatchret;
+            inst = (_Ty)v;
+            return ok;
+        }
+    };
+
+    template <>
+    struct StaticSerializer<String>
+    {
+        static constexpr usize min_binary_size = sizeof(u64);
+        static R<Variant> serialize(const String& inst) { return Variant(inst); }
+        static RV deserialize(String& inst, const Variant& data) { inst = data.str().c_str(); return ok; }
+        static void write(StaticBinaryWriter& writer, const String& inst)
+        {
+            writer.write_value((u64)inst.size());
+            writer.write(inst.data(), inst.size());
+        }
+        static RV read(StaticBinaryReader& reader, String& inst)
+        {
+            lutry
+            {
+                usize size;
+                luexp(reader.read_count(size, 1));
+                inst.assign((const c8*)reader.m_cur, size);
+                reader.m_cur += size;
+            }
+            lucatchret;
+            return ok;
+        }
+    };
+
+    template <>
+    struct StaticSerializer<Name>
+    {
+        static constexpr usize min_binary_size = sizeof(u64);
+        static R<Variant> serialize(const Name& inst) { return Variant(inst); }
+        static RV deserialize(Name& inst, const Variant& data) { inst = data.str(); return ok; }
+        static void write(StaticBinaryWriter& writer, const Name& inst)
+        {
+            writer.write_value((u64)inst.size());
+            writer.write(inst.c_str(), inst.size());
+        }
+        static RV read(StaticBinaryReader& reader, Name& inst)
+        {
+            lutry
+            {
+                usize size;
+                luexp(reader.read_count(size, 1));
+                inst = Name((const c8*)reader.m_cur, size);
+                reader.m_cur += size;
+            }
+            lucatchret;
+            return ok;
+        }
+    };
+
+    template <>
+    struct StaticSerializer<Guid>
+    {
+        static constexpr usize min_binary_size = sizeof(u64) * 2;
+        static R<Variant> serialize(const Guid& inst)
+        {
+            Variant ret(VariantType::array, 2);
+            ret.push_back(inst.low);
+            ret.push_back(inst.high);
+            return ret;
+        }
+        static RV deserialize(Guid& inst, const Variant& data)
+        {
+            inst.low = data[0].unum();
+            inst.high = data[1].unum();
+            return ok;
+        }
+        static void write(StaticBinaryWriter& writer, const Guid& inst)
+        {
+            writer.write_value(inst.low);
+            writer.write_value(inst.high);
+        }
+        static RV read(StaticBinaryReader& reader, Guid& inst)
+        {
+            lutry
+            {
+                luexp(reader.read_value(inst.low));
+                luexp(reader.read_value(inst.high));
+            }
+            lucatchret;
+            return ok;
+        }
+    };
+
+    template <typename _Ty, typename _Alloc>
+    struct StaticSerializer<Vector<_Ty, _Alloc>>
+    {
+        static constexpr usize min_binary_size = sizeof(u64);
+        static R<Variant> serialize(const Vector<_Ty, _Alloc>& inst)
+        {
+            Variant ret(VariantType::array, inst.size());
+            lutry
+            {
+                for (auto& v : inst)
+                {
+                    lulet(data, StaticSerializer<_Ty>::serialize(v));
+                    ret.push_back(move(data));
+                }
+            }
+            lucatchret;
+            return ret;
+        }
+        static RV deserialize(Vector<_Ty, _Alloc>& inst, const Variant& data)
+        {
+            lutry
+            {
+                usize size = data.size();
+                inst.clear();
+                inst.resize(size);
+                for (usize i = 0; i < size; ++i)
+                {
+                    luexp(StaticSerializer<_Ty>::deserialize(inst[i], data[i]));
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        static void write(StaticBinaryWriter& writer, const Vector<_Ty, _Alloc>& inst)
+        {
+            writer.write_value((u64)inst.size());
+            if constexpr (is_arithmetic_v<_Ty> && !is_same_v<_Ty, bool>)
+            {
+                writer.write(inst.data(), inst.size() * sizeof(_Ty));
+            }
+            else
+            {
+                for (auto& v : inst) StaticSerializer<_Ty>::write(writer, v);
+            }
+        }
+        static RV read(StaticBinaryReader& reader, Vector<_Ty, _Alloc>& inst)
+        {
+            lutry
+            {
+                usize size;
+                luexp(reader.read_count(size, StaticSerializer<_Ty>::min_binary_size));
+                inst.clear();
+                inst.resize(size);
+                if constexpr (is_arithmetic_v<_Ty> && !is_same_v<_Ty, bool>)
+                {
+                    luexp(reader.read(inst.data(), size * sizeof(_Ty)));
+                }
+                else
+                {
+                    for (usize i = 0; i < size; ++i)
+                    {
+                        luexp(StaticSerializer<_Ty>::read(reader, inst[i]));
+                    }
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+    };
+
+    //! Structures that declare their fields by @ref lufields are serialized to objects whose keys are field names, and are serialized
+    //! to binary data by concatenating fields in declaration order.
+    template <typename _Ty>
+    struct StaticSerializer<_Ty, enable_if_t<Impl::HasStaticFields<_Ty>::value>>
+    {
+        static constexpr usize min_binary_size = 0;
+        static R<Variant> serialize(const _Ty& inst)
+        {
+            usize num_fields = 0;
+            // The callback never fails.
+            auto _ = _Ty::__for_each_field([&](const auto&) -> RV { ++num_fields; return ok; });
+            Variant ret(VariantType::object, num_fields);
+            lutry
+            {
+                luexp(_Ty::__for_each_field([&](const auto& field) -> RV
+                {
+                    using field_t = remove_cv_t<remove_reference_t<decltype(inst.*(field.member))>>;
+                    auto data = StaticSerializer<field_t>::serialize(inst.*(field.member));
+                    if (failed(data)) return data.errcode();
+                    ret.insert(field.name, move(data.get()));
+                    return ok;
+                }));
+            }
+            lucatchret;
+            return ret;
+        }
+        static RV deserialize(_Ty& inst, const Variant& data)
+        {
+            return _Ty::__for_each_field([&](const auto& field) -> RV
+            {
+                using field_t = remove_cv_t<remove_reference_t<decltype(inst.*(field.member))>>;
+                auto& field_data = data[field.name];
+                if (!field_data.valid()) return ok;
+                return StaticSerializer<field_t>::deserialize(inst.*(field.member), field_data);
+            });
+        }
+        static void write(StaticBinaryWriter& writer, const _Ty& inst)
+        {
+            // The callback never fails.
+            auto _ = _Ty::__for_each_field([&](const auto& field) -> RV
+            {
+                using field_t = remove_cv_t<remove_reference_t<decltype(inst.*(field.member))>>;
+                StaticSerializer<field_t>::write(writer, inst.*(field.member));
+                return ok;
+            });
+        }
+        static RV read(StaticBinaryReader& reader, _Ty& inst)
+        {
+            return _Ty::__for_each_field([&](const auto& field) -> RV
+            {
+                using field_t = remove_cv_t<remove_reference_t<decltype(inst.*(field.member))>>;
+                return StaticSerializer<field_t>::read(reader, inst.*(field.member));
+            });
+        }
+    };
+
+    //! Serializes one instance using its static serializer.
+    //! @details The output is compatible with @ref serialize, so data serialized by one can be deserialized by the other,
+    //! provided that the fields declared by @ref lufields match the properties registered to the type system.
+    //! @param[in] inst The instance to serialize.
+    //! @return Returns one variant that stores the serialized data.
+    template <typename _Ty>
+    inline R<Variant> static_serialize(const _Ty& inst)
+    {
+        return StaticSerializer<_Ty>::serialize(inst);
+    }
+
+    //! Deserializes one instance using its static serializer.
+    //! @param[in] inst The instance to deserialize.
+    //! @param[in] data The serialized data used for deserialization.
+    template <typename _Ty>
+    inline RV static_deserialize(_Ty& inst, const Variant& data)
+    {
+        return StaticSerializer<_Ty>::deserialize(inst, data);
+    }
+
+    //! Serializes one instance to binary data using its static serializer, without creating any variant.
+    //! @details The binary data stores values in native byte order, and stores fields of structures in declaration order without
+    //! field names, so it can only be read by programs that declare the same fields in the same order on platforms with the same
+    //! byte order. Use @ref static_serialize if the data needs to be versioned or exchanged between platforms.
+    //! @param[in] inst The instance to serialize.
+    //! @param[in] buffer The buffer to append the serialized data to.
+    template <typename _Ty>
+    inline void static_serialize_binary(const _Ty& inst, Vector<byte_t>& buffer)
+    {
+        StaticBinaryWriter writer(buffer);
+        StaticSerializer<_Ty>::write(writer, inst);
+    }
+
+    //! Deserializes one instance from binary data written by @ref static_serialize_binary.
+    //! @param[in] inst The instance to deserialize.
+    //! @param[in] data The binary data to read.
+    //! @param[in] size The size of the binary data in bytes.
+    //! @param[out] read_bytes If not `nullptr`, the system sets the number of bytes consumed to this parameter.
+    //! @par Possible Errors
+    //! * BasicError::format_error
+    template <typename _Ty>
+    inline RV static_deserialize_binary(_Ty& inst, const void* data, usize size, usize* read_bytes = nullptr)
+    {
+        StaticBinaryReader reader(data, size);
+        lutry
+        {
+            luexp(StaticSerializer<_Ty>::read(reader, inst));
+        }
+        lucatchret;
+        if (read_bytes) *read_bytes = size - reader.remaining_size();
+        return ok;
+    }
+
+    //! Sets one type `_Ty` to be serializable, using its static serializer as the serialization function, so that @ref serialize
+    //! and @ref deserialize also use the serializer generated at compile time.
+    //! @details `_Ty` must be registered to the type system before calling this function.
+    template <typename _Ty>
+    inline void set_static_serializable()
+    {
+        SerializableTypeDesc desc;
+        desc.serialize_func = [](typeinfo_t type, const void* inst) -> R<Variant>
+        {
+            return StaticSerializer<_Ty>::serialize(*(const _Ty*)inst);
+        };
+        desc.deserialize_func = [](typeinfo_t type, void* inst, const Variant& data) -> RV
+        {
+            return StaticSerializer<_Ty>::deserialize(*(_Ty*)inst, data);
+        };
+        set_serializable(typeof<_Ty>(), &desc);
+    }
+
+    //! @}
+}
+
+//! @addtogroup RuntimeSerialization
+//! @{
+
+//! Declares one field used in @ref lufields.
+//! @param[in] _struct The outer structure or class name.
+//! @param[in] _name The field name.
+#define lufield(_struct, _name) Luna::make_static_field(#_name, &_struct::_name)
+
+//! Declares fields of one structure that are serialized by @ref Luna::StaticSerializer.
+//! @details Add this macro to the type body after all fields are declared. For exmaple:
+//! ```
+//! struct MyType
+//! {
+//!     lustruct("MyType", "{dbeecd7a-2dc5-423e-8e20-7521826c3f06}");
+//!     f32 a;
+//!     String b;
+//!     lufields(lufield(MyType, a), lufield(MyType, b));
+//! };
+//! ```
+//! @param[in] ... The fields declared by @ref lufield.
+#define lufields(...) using __static_fields_tag = void;\
+    template <typename _Func> static Luna::RV __for_each_field(_Func&& func) { return Luna::Impl::for_each_static_field(func, __VA_ARGS__); }
+
+//! @}
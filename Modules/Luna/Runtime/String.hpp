@@ -12,6 +12,8 @@
 #include "Algorithm.hpp"
 #include "Iterator.hpp"
 #include "MemoryUtils.hpp"
+#include "Functional.hpp"
+#include "StringView.hpp"
 #include "TypeInfo.hpp"
 
 namespace Luna
@@ -44,6 +46,17 @@ namespace Luna
         {
             static constexpr const wchar_t* null_string = L"";
         };
+
+        //! The buffer of one string, which stores characters inline for short strings, or stores the pointer to
+        //! the heap buffer for long strings.
+        template <typename _Char, usize _InlineCapacity>
+        union StringBuffer
+        {
+            _Char* heap_chars;
+            _Char inline_chars[_InlineCapacity + 1];
+
+            StringBuffer() { inline_chars[0] = (_Char)0; }
+        };
     }
 
     //! @addtogroup Runtime
@@ -74,6 +87,10 @@ namespace Luna
         //! is content specific.
         static constexpr usize npos = (usize)-1;
 
+        //! The maximum number of characters (excluding the null terminator) that can be stored in the string object 
+        //! directly without allocating memory from the allocator.
+        static constexpr usize INLINE_CAPACITY = (sizeof(usize) * 3) / sizeof(_Char) - 1;
+
         //! Constructs one empty string.
         BasicString();
         //! Constructs one empty string with an custom allocator.
@@ -164,15 +181,22 @@ namespace Luna
         //! @return Returns `*this`.
         BasicString& operator=(InitializerList<value_type> ilist);
         ~BasicString();
+        //! Constructs one string by copying characters from one string view.
+        //! @param[in] view The string view to copy characters from.
+        //! @param[in] alloc The optional allocator instance bound to this string. The allocator instance is copied into the string.
+        explicit BasicString(BasicStringView<_Char> view, const allocator_type& alloc = allocator_type()) :
+            BasicString(view.data(), view.size(), alloc) {}
+        //! Gets one string view of characters stored by this string.
+        //! @return Returns one string view of characters stored by this string. The view is invalidated when the string 
+        //! is modified or destroyed.
+        operator BasicStringView<_Char>() const { return BasicStringView<_Char>(data(), size()); }
         //! Gets one pointer to the underlying character data.
-        //! @return Returns one pointer to the underlying character data. The returned pointer may be `nullptr`
-        //! if the string is empty, to ensure one non-null return value, use @ref c_str instead, which always 
-        //! return one valid but empty string buffer ("") if the string is empty.
+        //! @return Returns one pointer to the underlying character data. The returned pointer is never `nullptr`, and 
+        //! the character data is always null-terminated.
         pointer data();
         //! Gets one constant pointer to the underlying character data.
-        //! @return Returns one constant pointer to the underlying character data. The returned pointer may be `nullptr`
-        //! if the string is empty, to ensure one non-null return value, use @ref c_str instead, which always 
-        //! return one valid but empty string buffer ("") if the string is empty.
+        //! @return Returns one constant pointer to the underlying character data. The returned pointer is never `nullptr`, and 
+        //! the character data is always null-terminated.
         const_pointer data() const;
         //! Gets a non-modifiable C string pointer to the characters stored by this string.
         //! @return Returns the C string pointer to the characters stored by this string. 
@@ -717,11 +741,21 @@ namespace Luna
 
     private:
         // -------------------- Begin of ABI compatible part --------------------
-        OptionalPair<allocator_type, _Char*> m_allocator_and_buffer;// The memory buffer.
+        OptionalPair<allocator_type, Impl::StringBuffer<_Char, INLINE_CAPACITY>> m_allocator_and_buffer;// The inline buffer or the pointer to the heap buffer.
         usize m_size;            // Number of elements in the vector.
         usize m_capacity;        // Number of elements that can be included in the buffer before a reallocation is needed.
+                                 // This is `INLINE_CAPACITY` if characters are stored in the inline buffer.
         // --------------------  End of ABI compatible part  --------------------
 
+        // The inline buffer does not point to itself, so the string is still trivially relocatable.
+        bool is_inline() const { return m_capacity <= INLINE_CAPACITY; }
+        value_type* internal_data() { return is_inline() ? m_allocator_and_buffer.second().inline_chars : m_allocator_and_buffer.second().heap_chars; }
+        const value_type* internal_data() const { return is_inline() ? m_allocator_and_buffer.second().inline_chars : m_allocator_and_buffer.second().heap_chars; }
+        // Initializes the string with the specified characters. The string must be empty and use the inline buffer.
+        void internal_init(const value_type* s, usize count);
+        // Takes the buffer of `rhs` and resets `rhs` to one empty string.
+        void internal_take(BasicString& rhs);
+
         value_type* allocate(usize n);
         void deallocate(value_type* ptr, usize n);
 
@@ -744,6 +778,53 @@ namespace Luna
     //! @details See @ref BasicString for string documentation.
     using String32 = BasicString<c32>;
 
+    template <typename _Char, typename _Alloc> struct hash<BasicString<_Char, _Alloc>>
+    {
+        usize operator()(const BasicString<_Char, _Alloc>& val) const { return (usize)wyhash(val.data(), val.size() * sizeof(_Char)); }
+    };
+
+    template <typename _Char, typename _Alloc> struct equal_to<BasicString<_Char, _Alloc>>
+    {
+        bool operator()(const BasicString<_Char, _Alloc>& lhs, const BasicString<_Char, _Alloc>& rhs) const
+        {
+            return lhs.size() == rhs.size() && !memcmp(lhs.data(), rhs.data(), lhs.size() * sizeof(_Char));
+        }
+    };
+
+    //! Formats one string.
+    //! @details The string is formatted into one stack buffer first, so no memory is allocated for short strings that fit in 
+    //! the inline buffer of @ref String.
+    //! @param[in] fmt The format string.
+    //! @param[in] args The format arguments.
+    //! @return Returns the formatted string.
+    inline String vstrprintf(const c8* fmt, VarList args)
+    {
+        c8 buf[256];
+        VarList args_copy;
+        va_copy(args_copy, args);
+        i32 len = vsnprintf(buf, 256, fmt, args_copy);
+        va_end(args_copy);
+        if (len < 0) return String();
+        if (len < 256) return String(buf, (usize)len);
+        String r((usize)len, (c8)0);
+        vsnprintf(r.data(), (usize)len + 1, fmt, args);
+        return r;
+    }
+
+    //! Formats one string.
+    //! @details The string is formatted into one stack buffer first, so no memory is allocated for short strings that fit in 
+    //! the inline buffer of @ref String.
+    //! @param[in] fmt The format string.
+    //! @return Returns the formatted string.
+    inline String strprintf(const c8* fmt, ...)
+    {
+        VarList args;
+        va_start(args, fmt);
+        String r = vstrprintf(fmt, args);
+        va_end(args);
+        return r;
+    }
+
     //! Gets the type object of @ref String.
     //! @return Returns the type object of @ref String.
     LUNA_RUNTIME_API typeinfo_t string_type();
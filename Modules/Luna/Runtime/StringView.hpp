@@ -0,0 +1,185 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file StringView.hpp
+* @author JXMaster
+* @date 2024/5/4
+*/
+#pragma once
+#include "Assert.hpp"
+#include "Iterator.hpp"
+#include "Functional.hpp"
+#include "StringUtils.hpp"
+
+namespace Luna
+{
+    //! @addtogroup RuntimeString
+    //! @{
+
+    //! Represents one non-owning view of one continuous character sequence.
+    //! @details The string view does not copy characters, and the character sequence is not required to be null-terminated.
+    //! The user should ensure that the viewed characters are valid during the lifetime of the view.
+    template <typename _Char>
+    class BasicStringView
+    {
+    public:
+        using value_type = _Char;
+        using reference = const value_type&;
+        using const_reference = const value_type&;
+        using pointer = const value_type*;
+        using const_pointer = const value_type*;
+        using iterator = const_pointer;
+        using const_iterator = const_pointer;
+        using reverse_iterator = ReverseIterator<iterator>;
+        using const_reverse_iterator = ReverseIterator<const_iterator>;
+
+        //! A special value that represents the end of the string view.
+        static constexpr usize npos = (usize)-1;
+
+        //! Constructs one empty string view.
+        constexpr BasicStringView() :
+            m_data(nullptr),
+            m_size(0) {}
+        //! Constructs one string view from one character sequence.
+        //! @param[in] s The pointer to the first character.
+        //! @param[in] count The number of characters in the view.
+        constexpr BasicStringView(const value_type* s, usize count) :
+            m_data(s),
+            m_size(count) {}
+        //! Constructs one string view from one null-terminated string.
+        //! @param[in] s The null-terminated string. If this is `nullptr`, one empty view is constructed.
+        BasicStringView(const value_type* s) :
+            m_data(s),
+            m_size(s ? strlen(s) : 0) {}
+
+        //! Gets the pointer to the first character of the view.
+        //! @return Returns the pointer to the first character of the view. The returned string may not be null-terminated.
+        constexpr const_pointer data() const { return m_data; }
+        //! Gets the number of characters in the view.
+        //! @return Returns the number of characters in the view.
+        constexpr usize size() const { return m_size; }
+        //! Gets the number of characters in the view.
+        //! @return Returns the number of characters in the view.
+        constexpr usize length() const { return m_size; }
+        //! Checks whether the view is empty.
+        //! @return Returns `true` if the view is empty. Returns `false` otherwise.
+        constexpr bool empty() const { return m_size == 0; }
+        constexpr const_iterator begin() const { return m_data; }
+        constexpr const_iterator end() const { return m_data + m_size; }
+        constexpr const_iterator cbegin() const { return m_data; }
+        constexpr const_iterator cend() const { return m_data + m_size; }
+        const_reverse_iterator rbegin() const { return const_reverse_iterator(end()); }
+        const_reverse_iterator rend() const { return const_reverse_iterator(begin()); }
+        //! Gets the character at the specified index.
+        //! @param[in] n The index of the character.
+        //! @return Returns the character at the specified index.
+        //! @par Valid Usage
+        //! * `n` must be in range [`0`, `size()`).
+        const_reference operator[](usize n) const { luassert(n < m_size); return m_data[n]; }
+        //! Gets the first character of the view.
+        //! @par Valid Usage
+        //! * `empty()` must be `false` when calling this function.
+        const_reference front() const { luassert(!empty()); return m_data[0]; }
+        //! Gets the last character of the view.
+        //! @par Valid Usage
+        //! * `empty()` must be `false` when calling this function.
+        const_reference back() const { luassert(!empty()); return m_data[m_size - 1]; }
+        //! Gets one sub-view of this view.
+        //! @param[in] pos The index of the first character of the sub-view.
+        //! @param[in] count The number of characters of the sub-view. The sub-view is clamped to the end of this view.
+        //! @return Returns the sub-view.
+        BasicStringView substr(usize pos, usize count = npos) const
+        {
+            luassert(pos <= m_size);
+            return BasicStringView(m_data + pos, min(count, m_size - pos));
+        }
+        //! Removes the first `n` characters from the view.
+        void remove_prefix(usize n) { luassert(n <= m_size); m_data += n; m_size -= n; }
+        //! Removes the last `n` characters from the view.
+        void remove_suffix(usize n) { luassert(n <= m_size); m_size -= n; }
+        //! Finds the first occurrence of the specified character in the view.
+        //! @param[in] ch The character to search for.
+        //! @param[in] pos The index at which to begin searching.
+        //! @return Returns the index of the found character. Returns @ref npos if no such character is found.
+        usize find(value_type ch, usize pos = 0) const
+        {
+            for (usize i = pos; i < m_size; ++i)
+            {
+                if (m_data[i] == ch) return i;
+            }
+            return npos;
+        }
+        //! Finds the last occurrence of the specified character in the view.
+        //! @param[in] ch The character to search for.
+        //! @return Returns the index of the found character. Returns @ref npos if no such character is found.
+        usize rfind(value_type ch) const
+        {
+            for (usize i = m_size; i > 0; --i)
+            {
+                if (m_data[i - 1] == ch) return i - 1;
+            }
+            return npos;
+        }
+        //! Compares two views for equality.
+        bool operator==(const BasicStringView& rhs) const
+        {
+            return m_size == rhs.m_size && (m_data == rhs.m_data || !memcmp(m_data, rhs.m_data, m_size * sizeof(value_type)));
+        }
+        //! Compares two views for non-equality.
+        bool operator!=(const BasicStringView& rhs) const
+        {
+            return !(*this == rhs);
+        }
+    private:
+        const value_type* m_data;
+        usize m_size;
+    };
+
+    //! The string view of @ref c8 characters.
+    using StringView = BasicStringView<c8>;
+
+    template <typename _Char> struct hash<BasicStringView<_Char>>
+    {
+        usize operator()(const BasicStringView<_Char>& val) const { return (usize)wyhash(val.data(), val.size() * sizeof(_Char)); }
+    };
+
+    //! Formats one string into the caller-provided buffer without allocating memory.
+    //! @param[in] buffer The buffer to write formatted characters to. The formatted string is always null-terminated
+    //! if `buffer_size` is not `0`.
+    //! @param[in] buffer_size The size of `buffer` in characters, including the null terminator.
+    //! @param[in] fmt The format string.
+    //! @param[in] args The format arguments.
+    //! @return Returns one view of the formatted characters stored in `buffer`. If `buffer` is not large enough,
+    //! the formatted string is truncated.
+    inline StringView vstrformat(c8* buffer, usize buffer_size, const c8* fmt, VarList args)
+    {
+        if (!buffer_size) return StringView();
+        i32 len = vsnprintf(buffer, buffer_size, fmt, args);
+        if (len < 0)
+        {
+            buffer[0] = 0;
+            return StringView(buffer, 0);
+        }
+        return StringView(buffer, min((usize)len, buffer_size - 1));
+    }
+
+    //! Formats one string into the caller-provided buffer without allocating memory.
+    //! @param[in] buffer The buffer to write formatted characters to. The formatted string is always null-terminated
+    //! if `buffer_size` is not `0`.
+    //! @param[in] buffer_size The size of `buffer` in characters, including the null terminator.
+    //! @param[in] fmt The format string.
+    //! @return Returns one view of the formatted characters stored in `buffer`. If `buffer` is not large enough,
+    //! the formatted string is truncated.
+    inline StringView strformat(c8* buffer, usize buffer_size, const c8* fmt, ...)
+    {
+        VarList args;
+        va_start(args, fmt);
+        StringView r = vstrformat(buffer, buffer_size, fmt, args);
+        va_end(args);
+        return r;
+    }
+
+    //! @}
+}
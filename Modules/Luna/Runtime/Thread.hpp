@@ -46,6 +46,15 @@ namespace Luna
         //! Sets thread priority.
         //! @param[in] priority The new priority of the thread.
         virtual void set_priority(ThreadPriority priority) = 0;
+
+        //! Sets the processors that the thread is allowed to run on.
+        //! @param[in] processor_mask The affinity mask of the thread. The Nth bit of the mask represents the Nth logical processor 
+        //! of the platform, only the first 64 logical processors can be specified. If this is `0`, the thread is allowed to run on all 
+        //! processors.
+        //! @par Possible Errors
+        //! * @ref BasicError::not_supported if the platform does not support setting thread affinity.
+        //! * @ref BasicError::bad_platform_call for all errors returned by the platform.
+        virtual RV set_affinity(u64 processor_mask) = 0;
     };
 
     //! Gets the number of logical processors on the platform.
@@ -53,6 +62,15 @@ namespace Luna
     //! processors returned will be two times of the physical cores of the CPU.
     LUNA_RUNTIME_API u32 get_processors_count();
 
+    //! Gets the cache domain of one logical processor.
+    //! @details One cache domain is one set of logical processors that share the same last-level cache (usually the L3 cache). 
+    //! Exchanging data between processors in the same cache domain is usually much cheaper than exchanging data between processors in
+    //! different cache domains, for example, between two CCXs of one AMD processor, or between two NUMA nodes.
+    //! @param[in] processor The index of the logical processor.
+    //! @return Returns the index of the cache domain. Two processors belong to the same cache domain if they have the same cache domain index.
+    //! Returns `0` for all processors if the cache topology cannot be queried on the platform.
+    LUNA_RUNTIME_API u32 get_processor_cache_domain(u32 processor);
+
     //! Create a new system thread and make it run the callback function. The thread will be closed when the callback function returns.
     //! @param[in] entry_func The function to invoke by the new thread.
     //! @param[in] params The additional parameter passed to the callback.
@@ -195,7 +195,7 @@ namespace Luna
             template <typename... _Tys>
             static typename TupleElement<_I, Tuple<_Tys...>>::type&& get(Tuple<_Tys...>&& t)
             {
-                return TupleGetter<_I - 1>::get(t.rest);
+                return TupleGetter<_I - 1>::get(move(t.rest));
             }
             template <typename... _Tys>
             static typename TupleElement<_I, Tuple<_Tys...>>::type const& get(const Tuple<_Tys...>& t)
@@ -205,7 +205,7 @@ namespace Luna
             template <typename... _Tys>
             static typename TupleElement<_I, Tuple<_Tys...>>::type const&& get(const Tuple<_Tys...>&& t)
             {
-                return TupleGetter<_I - 1>::get(t.rest);
+                return TupleGetter<_I - 1>::get(move(t.rest));
             }
             template <typename... _Tys>
             static typename TupleElement<_I, Tuple<_Tys...>>::type volatile& get(volatile Tuple<_Tys...>& t)
@@ -238,9 +238,9 @@ namespace Luna
                 return t.value;
             }
             template <typename _Ty, typename... _Tys>
-            static _Ty& get(Tuple<_Ty, _Tys...>&& t)
+            static _Ty&& get(Tuple<_Ty, _Tys...>&& t)
             {
-                return move(t.value);
+                return static_cast<_Ty&&>(t.value);
             }
             template <typename _Ty, typename... _Tys>
             static const _Ty& get(const Tuple<_Ty, _Tys...>& t)
@@ -248,9 +248,9 @@ namespace Luna
                 return t.value;
             }
             template <typename _Ty, typename... _Tys>
-            static const _Ty& get(const Tuple<_Ty, _Tys...>&& t)
+            static const _Ty&& get(const Tuple<_Ty, _Tys...>&& t)
             {
-                return move(t.value);
+                return static_cast<const _Ty&&>(t.value);
             }
             template <typename _Ty, typename... _Tys>
             static volatile _Ty& get(volatile Tuple<_Ty, _Tys...>& t)
@@ -13,6 +13,7 @@
 #include "Name.hpp"
 #include "Blob.hpp"
 #include "HashMap.hpp"
+#include "Arena.hpp"
 
 namespace Luna
 {
@@ -271,6 +272,20 @@ namespace Luna
         //! Initializes one empty variant with the specified variant type.
         //! @param[in] type The of the new variant. If not specified, one variant with @ref VariantType::null will be constructed.
         Variant(VariantType type = VariantType::null);
+        //! Initializes one empty object or array variant and reserves storage for the specified number of children.
+        //! @details Storage is reserved exactly for the specified number of children, so that building one object or array
+        //! whose children count is known does not waste memory.
+        //! 
+        //! If `arena` is not `nullptr`, storage of one small object or array is allocated from the arena, and is not freed
+        //! individually when the variant is destructed, so that destructing one document built from one arena skips freeing every
+        //! node and the memory is reclaimed when the arena is reset. The arena must outlive the variant in such case. Adding more
+        //! children than the reserved capacity moves children to storage allocated from heap, while copying the variant always
+        //! allocates storage from heap.
+        //! @param[in] type The type of the new variant. If this is not @ref VariantType::object or @ref VariantType::array,
+        //! `capacity` and `arena` are ignored.
+        //! @param[in] capacity The number of children to reserve.
+        //! @param[in] arena The arena to allocate storage from. If this is `nullptr`, storage is allocated from heap.
+        Variant(VariantType type, usize capacity, Arena* arena = nullptr);
         //! Initializes one variant by coping data from another variant.
         //! @param[in] rhs The variant to copy from.
         Variant(const Variant& rhs);
@@ -627,11 +642,13 @@ namespace Luna
         {
             none = 0,
             big_object = 0x01, // For objects whose children count >= 65536.
+            arena = 0x02, // For small objects whose storage is allocated from one arena and must not be freed.
         };
         enum class ArrayFlag : u8
         {
             none = 0,
             big_array = 0x01, // For array whose children count >= 65536.
+            arena = 0x02, // For small arrays whose storage is allocated from one arena and must not be freed.
         };
 
         // One variant value takes 16 bytes, with the following memory layout:
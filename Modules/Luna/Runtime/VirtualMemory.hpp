@@ -0,0 +1,79 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file VirtualMemory.hpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#pragma once
+#include "Result.hpp"
+
+#ifndef LUNA_RUNTIME_API
+#define LUNA_RUNTIME_API
+#endif
+
+namespace Luna
+{
+    //! @addtogroup RuntimeMemory
+    //! @{
+
+    //! Specifies attributes for one virtual memory reservation.
+    enum class VirtualMemoryFlag : u32
+    {
+        none = 0x00,
+        //! Requests the system to back the reserved range with large pages (usually 2MB) if possible, which reduces TLB misses
+        //! when accessing large buffers.
+        //! @details This is only a hint, the reservation does not fail if large pages are not available, in such case normal pages
+        //! will be used.
+        //!
+        //! On POSIX platforms, the range is aligned to the large page size and the system is advised to use transparent huge pages
+        //! for it. On Windows, large pages must be locked in physical memory, so if large pages are granted, the whole range is committed
+        //! when reserved and cannot be decommitted until it is released. Large pages on Windows require the "Lock pages in memory" privilege.
+        large_page = 0x01,
+    };
+
+    //! Gets the size of one memory page of the system virtual memory.
+    //! @return Returns the page size in bytes. Sizes and addresses passed to virtual memory functions must be aligned to this value.
+    LUNA_RUNTIME_API usize get_page_size();
+
+    //! Gets the size of one large memory page of the system virtual memory.
+    //! @return Returns the large page size in bytes, or `0` if large pages are not supported by the system.
+    LUNA_RUNTIME_API usize get_large_page_size();
+
+    //! Reserves one range of virtual address space.
+    //! @details Reserved pages cannot be accessed until they are committed by @ref virtual_commit, and do not consume
+    //! physical memory or page file space. This can be used to reserve address space for one large buffer up front, then
+    //! commit pages on demand, so that the buffer can grow without relocating its elements.
+    //! @param[in] size The size of the range to reserve. This will be rounded up to times of the page size.
+    //! @param[in] flags The reservation flags.
+    //! @return Returns the address of the reserved range. The address is aligned to the page size, and is aligned to the large page size
+    //! if @ref VirtualMemoryFlag::large_page is specified and large pages are supported by the system.
+    LUNA_RUNTIME_API R<void*> virtual_reserve(usize size, VirtualMemoryFlag flags = VirtualMemoryFlag::none);
+
+    //! Commits pages of one reserved range so that they can be read and written.
+    //! @details Committed pages are filled with zeros when they are accessed for the first time. Committing pages that are
+    //! already committed does not change their content.
+    //! @param[in] ptr The address of the first page to commit. This must be aligned to the page size.
+    //! @param[in] size The size of pages to commit. This will be rounded up to times of the page size.
+    //! @par Valid Usage
+    //! 1. All pages in [`ptr`, `ptr + size`) must be in one range reserved by @ref virtual_reserve.
+    LUNA_RUNTIME_API RV virtual_commit(void* ptr, usize size);
+
+    //! Decommits pages of one reserved range, returning their physical memory to the system.
+    //! @details Decommitted pages cannot be accessed until they are committed again, and their content will be lost.
+    //! The address range remains reserved.
+    //! @param[in] ptr The address of the first page to decommit. This must be aligned to the page size.
+    //! @param[in] size The size of pages to decommit. This will be rounded up to times of the page size.
+    //! @par Valid Usage
+    //! 1. All pages in [`ptr`, `ptr + size`) must be in one range reserved by @ref virtual_reserve.
+    LUNA_RUNTIME_API RV virtual_decommit(void* ptr, usize size);
+
+    //! Releases one range reserved by @ref virtual_reserve. All committed pages of the range are decommitted.
+    //! @param[in] ptr The address returned by @ref virtual_reserve.
+    //! @param[in] size The size passed to @ref virtual_reserve.
+    LUNA_RUNTIME_API void virtual_release(void* ptr, usize size);
+
+    //! @}
+}
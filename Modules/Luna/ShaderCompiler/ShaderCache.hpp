@@ -0,0 +1,53 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file ShaderCache.hpp
+* @author JXMaster
+* @date 2024/4/14
+* @brief The shader compile result cache.
+*/
+#pragma once
+#include "ShaderCompiler.hpp"
+
+namespace Luna
+{
+    namespace ShaderCompiler
+    {
+        //! @addtogroup ShaderCompiler
+        //! @{
+
+        //! Describes the shader cache.
+        //! @details The shader cache stores shader compile results using one hash of the shader source code and compile parameters
+        //! as the key. Every cached result also records the content hash of every file included by the shader, so that the cached
+        //! result is used only if no included file is changed. Compiling the same shader again returns the cached result without 
+        //! invoking the compiler.
+        //! 
+        //! Cached results are stored in two tiers:
+        //! 1. The memory tier, which stores results compiled by the current process.
+        //! 2. The disk tier, which is usually one directory on the local disk, so that results are kept between runs.
+        //! 
+        //! Results are looked up in the memory tier first, then in the disk tier. Results found in the disk tier are copied to the 
+        //! memory tier.
+        struct ShaderCacheDesc
+        {
+            //! The VFS directory of the disk tier. If this is empty, the disk tier is disabled.
+            Path disk_dir;
+            //! The maximum number of results stored in the memory tier. Results stored earliest are removed if the limit is exceeded.
+            //! If this is `0`, the memory tier is disabled.
+            usize max_memory_entries = 1024;
+        };
+
+        //! Sets the storage of the shader cache.
+        //! @details The shader cache is used by @ref ICompiler::compile if @ref ShaderCompileParameters::use_cache is `true`.
+        //! By default, only the memory tier is enabled.
+        //! @param[in] desc The shader cache descriptor.
+        LUNA_SHADER_COMPILER_API void set_shader_cache(const ShaderCacheDesc& desc);
+
+        //! Removes all results stored in the memory tier of the shader cache.
+        LUNA_SHADER_COMPILER_API void clear_shader_cache();
+
+        //! @}
+    }
+}
@@ -12,6 +12,9 @@
 #include <Luna/Runtime/Span.hpp>
 #include <Luna/Runtime/Path.hpp>
 #include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Ref.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/Runtime/Vector.hpp>
 
 #ifndef LUNA_SHADER_COMPILER_API
 #define LUNA_SHADER_COMPILER_API
@@ -62,7 +65,11 @@ namespace Luna
             //! Compiles the shader as pixel (fragment) shader.
             pixel = 2,
             //! Compiles the shader as compute shader.
-            compute = 3
+            compute = 3,
+            //! Compiles the shader as mesh shader. This requires shader model 6.5 or later.
+            mesh = 4,
+            //! Compiles the shader as amplification (task) shader. This requires shader model 6.5 or later.
+            amplification = 5,
         };
         
         //! Specifies the shader optimization level.
@@ -131,6 +138,101 @@ namespace Luna
             //! The target platform for one metal shader.
             //! This is used only if `target_format` is @ref TargetFormat::msl.
             MetalPlatform metal_platform = MetalPlatform::macos;
+            //! Whether to generate reflection data of the shader and store it in @ref ShaderCompileResult::reflection.
+            //! @details Reflection data is generated from SPIR-V. If the target format is @ref TargetFormat::dxil, the shader is 
+            //! compiled to SPIR-V one more time to generate reflection data.
+            bool generate_reflection = false;
+            //! Whether to look up and store the compile result in the shader cache.
+            //! @details If this is `true`, the compiler returns the cached result directly if the shader is compiled before with the same 
+            //! source code, parameters and included files. See @ref set_shader_cache for details.
+            bool use_cache = true;
+        };
+
+        //! Specifies the type of one shader resource.
+        enum class ShaderResourceType : u8
+        {
+            //! `cbuffer` or `ConstantBuffer` with register type `b`.
+            uniform_buffer = 0,
+            //! `StructuredBuffer`, `ByteAddressBuffer` or `Buffer` with register type `t`.
+            read_buffer,
+            //! `RWStructuredBuffer`, `RWByteAddressBuffer` or `RWBuffer` with register type `u`.
+            read_write_buffer,
+            //! Textures with register type `t`.
+            read_texture,
+            //! Read-write textures with register type `u`.
+            read_write_texture,
+            //! `SamplerState` or `SamplerComparisonState` with register type `s`.
+            sampler,
+            //! `RaytracingAccelerationStructure` with register type `t`.
+            acceleration_structure,
+        };
+
+        //! Specifies the dimension of one texture resource.
+        enum class ShaderTextureDimension : u8
+        {
+            //! The resource is not one texture.
+            none = 0,
+            //! 1D texture.
+            tex1d,
+            //! 2D texture.
+            tex2d,
+            //! 2D multi-sample texture.
+            tex2dms,
+            //! 3D texture.
+            tex3d,
+            //! Cube texture.
+            texcube,
+            //! 1D texture array.
+            tex1darray,
+            //! 2D texture array.
+            tex2darray,
+            //! 2D multi-sample texture array.
+            tex2dmsarray,
+            //! Cube texture array.
+            texcubearray,
+        };
+
+        //! Describes one resource accessed by one shader.
+        struct ShaderResourceReflection
+        {
+            //! The name of the resource variable.
+            Name name;
+            //! The register space of the resource, which is the index of the descriptor set that contains the resource.
+            u32 set = 0;
+            //! The register index of the resource, which is the binding slot of the resource in the descriptor set.
+            u32 binding = 0;
+            //! The number of descriptors of the resource. This is greater than 1 if the resource is one array, and is `0` if 
+            //! the resource is one unbounded array.
+            u32 num_descs = 1;
+            //! The type of the resource.
+            ShaderResourceType type = ShaderResourceType::uniform_buffer;
+            //! The dimension of the texture if `type` is @ref ShaderResourceType::read_texture or 
+            //! @ref ShaderResourceType::read_write_texture, @ref ShaderTextureDimension::none otherwise.
+            ShaderTextureDimension texture_dimension = ShaderTextureDimension::none;
+        };
+
+        //! Describes one vertex input attribute of one vertex shader.
+        struct ShaderInputReflection
+        {
+            //! The semantic name of the attribute, without the semantic index.
+            Name semantic_name;
+            //! The semantic index of the attribute.
+            u32 semantic_index = 0;
+            //! The location of the attribute.
+            u32 location = 0;
+            //! The number of components of the attribute.
+            u32 num_components = 0;
+        };
+
+        //! Describes reflection data of one shader.
+        struct ShaderReflection
+        {
+            //! Resources accessed by the shader, sorted by set and binding.
+            Vector<ShaderResourceReflection> resources;
+            //! The number of 32-bit pipeline constants used by the shader, see `Luna/RHI/Shaders/PipelineConstants.hlsl`.
+            u32 num_constants = 0;
+            //! Vertex input attributes of the shader, sorted by location. This is empty if the shader is not one vertex shader.
+            Vector<ShaderInputReflection> inputs;
         };
 
         //! Describes shader compile result.
@@ -157,6 +259,9 @@ namespace Luna
             //! @details This is used only when the compile target is @ref TargetFormat::msl, since MSL does not record this 
             //! in shader code.
             u32 metal_numthreads_z = 0;
+            //! The reflection data of the shader.
+            //! @details This is generated only if @ref ShaderCompileParameters::generate_reflection is `true`.
+            ShaderReflection reflection;
         };
 
         //! @interface ICompiler
@@ -169,6 +274,17 @@ namespace Luna
             //! @param[in] params The parameters passed to the compiler.
             //! @return Returns the compile result.
             virtual R<ShaderCompileResult> compile(const ShaderCompileParameters& params) = 0;
+
+            //! Compiles multiple shaders in parallel using worker threads of the job system.
+            //! @param[in] params The parameters of shaders to compile.
+            //! @param[out] results The array to write compile results to. The size of this array must not be smaller than 
+            //! the size of `params`. The compile result of `params[i]` will be written to `results[i]`.
+            //! @return Returns `ok` if all shaders are compiled successfully. Returns the error of the first failed shader 
+            //! in `params` order otherwise.
+            //! @remark Every worker thread uses its own DXC compiler instance, and files included by multiple shaders 
+            //! in one batch are read only once. This function blocks until all shaders are compiled. All shaders are 
+            //! compiled even if some of them fail, so that results of succeeded shaders can still be used.
+            virtual RV compile_batch(Span<const ShaderCompileParameters> params, Span<ShaderCompileResult> results) = 0;
         };
 
         //! Creates one new compiler.
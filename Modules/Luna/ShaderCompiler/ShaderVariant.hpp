@@ -0,0 +1,122 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ShaderVariant.hpp
+* @author JXMaster
+* @date 2024/4/15
+* @brief Shader variants compiled from one shader source with different static keywords.
+*/
+#pragma once
+#include "ShaderCompiler.hpp"
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    namespace ShaderCompiler
+    {
+        //! @addtogroup ShaderCompiler
+        //! @{
+
+        //! Describes one keyword set, which is one static switch of one shader.
+        struct ShaderKeywordSetDesc
+        {
+            //! The keywords of this set. Exactly one keyword of every set is enabled for one shader variant, and the enabled
+            //! keyword is defined as one macro with value `1` when compiling the variant. The first keyword is enabled by default.
+            //! @details One empty name can be used to represent the state where no keyword of this set is defined.
+            Vector<Name> keywords;
+        };
+
+        //! Describes one shader variant set.
+        struct ShaderVariantSetDesc
+        {
+            //! The parameters used for compiling every variant. Keyword macros of the variant are appended to `definitions`.
+            //! @details The source data, include paths and definitions are copied to the variant set, so they do not need
+            //! to be valid after @ref new_shader_variant_set returns.
+            ShaderCompileParameters params;
+            //! The keyword sets of the shader.
+            Vector<ShaderKeywordSetDesc> keyword_sets;
+        };
+
+        //! Identifies one variant in one shader variant set.
+        //! @details The variant key encodes the index of the enabled keyword of every keyword set. The key of the default
+        //! variant, where the first keyword of every set is enabled, is always `0`.
+        using shader_variant_t = u64;
+
+        //! @interface IShaderVariantSet
+        //! Represents all variants of one shader.
+        //! @details Variants are compiled when they are used for the first time. Variants with identical compile results
+        //! share one compile result, so that the result data is stored only once.
+        //!
+        //! For shipping builds, all used variants can be compiled offline and saved into one pack by calling @ref precompile
+        //! and @ref save_pack, then be loaded at run time by calling @ref load_pack, so that no variant is compiled at run time.
+        //! @threadsafe
+        struct IShaderVariantSet : virtual Interface
+        {
+            luiid("{6F2A9C3E-1B54-4D87-A0E6-8C3D5B71F294}");
+
+            //! Gets the number of variants in this set.
+            virtual u64 get_num_variants() = 0;
+
+            //! Gets the key of the variant that enables the specified keywords.
+            //! @param[in] keywords The keywords to enable. For every keyword set that does not have any keyword in this
+            //! array, the first keyword is enabled. Keywords that do not belong to any keyword set are ignored.
+            //! @return Returns the key of the variant.
+            virtual shader_variant_t get_variant_key(Span<const Name> keywords) = 0;
+
+            //! Gets the compile result of the specified variant, and compiles the variant if it is not compiled yet.
+            //! @param[in] variant The key of the variant.
+            //! @return Returns the compile result of the variant. The returned pointer is valid until the variant set is destroyed.
+            //! @remark If the variant is being compiled asynchronously, this function blocks until the compilation is finished.
+            virtual R<const ShaderCompileResult*> get_variant(shader_variant_t variant) = 0;
+
+            //! Gets the compile result of the specified variant without waiting for the compilation of the variant.
+            //! @details If the variant is not compiled yet, this function starts compiling the variant asynchronously using
+            //! the job system, and returns the compile result of `fallback` instead. The fallback variant is compiled
+            //! synchronously if it is not compiled yet.
+            //! @param[in] variant The key of the variant.
+            //! @param[in] fallback The key of the variant to return if `variant` is not compiled yet. This is usually
+            //! the default variant `0`, which should be compiled before the first use.
+            //! @return Returns the compile result of `variant` or `fallback`. The returned pointer is valid until the variant
+            //! set is destroyed.
+            virtual R<const ShaderCompileResult*> get_variant_async(shader_variant_t variant, shader_variant_t fallback = 0) = 0;
+
+            //! Checks whether the specified variant is compiled.
+            //! @param[in] variant The key of the variant.
+            //! @return Returns `true` if the compile result of the variant is available, `false` otherwise.
+            virtual bool is_variant_ready(shader_variant_t variant) = 0;
+
+            //! Blocks the current thread until all asynchronous compilations started by @ref get_variant_async are finished.
+            virtual void wait_async_compiles() = 0;
+
+            //! Gets keys of all variants requested by @ref get_variant and @ref get_variant_async.
+            //! @details This can be used to collect variants used by the application, so that they can be precompiled for
+            //! shipping builds.
+            //! @return Returns keys of all requested variants.
+            virtual Vector<shader_variant_t> get_used_variants() = 0;
+
+            //! Compiles the specified variants if they are not compiled yet.
+            //! @details Variants are compiled in parallel using @ref ICompiler::compile_batch.
+            //! @param[in] variants The keys of variants to compile.
+            virtual RV precompile(Span<const shader_variant_t> variants) = 0;
+
+            //! Saves compile results of all compiled variants into one pack.
+            //! @return Returns the pack data. Compile results shared by multiple variants are stored only once in the pack.
+            virtual R<Blob> save_pack() = 0;
+
+            //! Loads compile results of variants from one pack saved by @ref save_pack.
+            //! @param[in] data The pack data.
+            //! @return Returns @ref BasicError::version_dismatch if the pack is not saved by one variant set with the same
+            //! shader source, compile parameters and keyword sets. Returns @ref BasicError::bad_data if the pack data is invalid.
+            virtual RV load_pack(Span<const byte_t> data) = 0;
+        };
+
+        //! Creates one new shader variant set.
+        //! @param[in] desc The descriptor of the variant set.
+        //! @return Returns the created variant set.
+        LUNA_SHADER_COMPILER_API R<Ref<IShaderVariantSet>> new_shader_variant_set(const ShaderVariantSetDesc& desc);
+
+        //! @}
+    }
+}
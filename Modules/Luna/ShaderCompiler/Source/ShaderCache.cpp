@@ -0,0 +1,379 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ShaderCache.cpp
+* @author JXMaster
+* @date 2024/4/14
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_SHADER_COMPILER_API LUNA_EXPORT
+#include "ShaderCache.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/RingDeque.hpp>
+#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Hash.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/StaticSerialization.hpp>
+#include <Luna/VFS/VFS.hpp>
+
+namespace Luna
+{
+    namespace ShaderCompiler
+    {
+        // Increase this version when the compile result or the cache file format is changed, so that existing cached results
+        // are not used.
+        constexpr u32 SHADER_CACHE_VERSION = 2;
+        constexpr u32 SHADER_CACHE_FILE_MAGIC = 0x48534C4C; // "LLSH"
+
+        struct CachedShader
+        {
+            ShaderCompileResult m_result;
+            Vector<ShaderCacheInclude> m_includes;
+        };
+
+        struct ShaderCacheFileHeader
+        {
+            u32 magic;
+            u32 version;
+            u64 key;
+            u64 data_size;
+            u32 format;
+            u32 metal_numthreads_x;
+            u32 metal_numthreads_y;
+            u32 metal_numthreads_z;
+            u32 entry_point_size;
+            u32 num_includes;
+            u64 reflection_size;
+        };
+
+        Ref<IMutex> g_shader_cache_mtx;
+        ShaderCacheDesc g_shader_cache_desc;
+        HashMap<u64, CachedShader> g_memory_cache;
+        // Keys of results in the memory tier in insertion order.
+        RingDeque<u64> g_memory_cache_keys;
+
+        void init_shader_cache()
+        {
+            g_shader_cache_mtx = new_mutex();
+        }
+        void close_shader_cache()
+        {
+            g_memory_cache.clear();
+            g_memory_cache.shrink_to_fit();
+            g_memory_cache_keys.clear();
+            g_memory_cache_keys.shrink_to_fit();
+            g_shader_cache_desc = ShaderCacheDesc();
+            g_shader_cache_mtx.reset();
+        }
+        LUNA_SHADER_COMPILER_API void set_shader_cache(const ShaderCacheDesc& desc)
+        {
+            MutexGuard guard(g_shader_cache_mtx);
+            g_shader_cache_desc = desc;
+            while (g_memory_cache_keys.size() > desc.max_memory_entries)
+            {
+                g_memory_cache.erase(g_memory_cache_keys.front());
+                g_memory_cache_keys.pop_front();
+            }
+        }
+        LUNA_SHADER_COMPILER_API void clear_shader_cache()
+        {
+            MutexGuard guard(g_shader_cache_mtx);
+            g_memory_cache.clear();
+            g_memory_cache_keys.clear();
+        }
+        u64 hash_shader_file_data(const void* data, usize size)
+        {
+            return memhash64(data, size);
+        }
+        u64 get_shader_cache_key(const ShaderCompileParameters& params)
+        {
+            u64 h = memhash64(params.source.data(), params.source.size(), SHADER_CACHE_VERSION);
+            auto hash_string = [&](const c8* s) { h = strhash64(s ? s : "", h); };
+            auto hash_value = [&](const auto& value) { h = memhash64(&value, sizeof(value), h); };
+            hash_string(params.source_name.c_str());
+            hash_string(params.source_file_path.encode().c_str());
+            hash_string(params.entry_point.c_str());
+            hash_value(params.target_format);
+            hash_value(params.shader_type);
+            hash_value(params.shader_model.major);
+            hash_value(params.shader_model.minor);
+            hash_value(params.optimization_level);
+            hash_value(params.debug);
+            hash_value(params.skip_validation);
+            hash_value(params.matrix_pack_mode);
+            hash_value((u64)params.include_paths.size());
+            for (auto& path : params.include_paths) hash_string(path.encode().c_str());
+            hash_value((u64)params.definitions.size());
+            for (auto& def : params.definitions)
+            {
+                hash_string(def.first.c_str());
+                hash_string(def.second.c_str());
+            }
+            hash_value(params.metal_platform);
+            hash_value(params.generate_reflection);
+            return h;
+        }
+        static void append_data(Vector<byte_t>& dst, const void* data, usize size)
+        {
+            usize offset = dst.size();
+            dst.resize(offset + size);
+            memcpy(dst.data() + offset, data, size);
+        }
+        static void append_name(Vector<byte_t>& dst, const Name& name)
+        {
+            u32 size = (u32)name.size();
+            append_data(dst, &size, sizeof(u32));
+            append_data(dst, name.c_str(), size);
+        }
+        static bool read_data(const byte_t*& cur, const byte_t* end, void* dst, usize size)
+        {
+            if ((usize)(end - cur) < size) return false;
+            memcpy(dst, cur, size);
+            cur += size;
+            return true;
+        }
+        static bool read_name(const byte_t*& cur, const byte_t* end, Name& dst)
+        {
+            u32 size;
+            if (!read_data(cur, end, &size, sizeof(u32)) || (usize)(end - cur) < size) return false;
+            dst = Name((const c8*)cur, size);
+            cur += size;
+            return true;
+        }
+        void encode_shader_reflection(const ShaderReflection& reflection, Vector<byte_t>& dst)
+        {
+            u32 num_resources = (u32)reflection.resources.size();
+            append_data(dst, &num_resources, sizeof(u32));
+            for (auto& res : reflection.resources)
+            {
+                append_name(dst, res.name);
+                u32 values[4] = { res.set, res.binding, res.num_descs, (u32)res.type | ((u32)res.texture_dimension << 8) };
+                append_data(dst, values, sizeof(values));
+            }
+            append_data(dst, &reflection.num_constants, sizeof(u32));
+            u32 num_inputs = (u32)reflection.inputs.size();
+            append_data(dst, &num_inputs, sizeof(u32));
+            for (auto& input : reflection.inputs)
+            {
+                append_name(dst, input.semantic_name);
+                u32 values[3] = { input.semantic_index, input.location, input.num_components };
+                append_data(dst, values, sizeof(values));
+            }
+        }
+        bool decode_shader_reflection(const byte_t*& cur, const byte_t* end, ShaderReflection& dst)
+        {
+            u32 num_resources;
+            if (!read_data(cur, end, &num_resources, sizeof(u32))) return false;
+            dst.resources.clear();
+            for (u32 i = 0; i < num_resources; ++i)
+            {
+                ShaderResourceReflection res;
+                u32 values[4];
+                if (!read_name(cur, end, res.name) || !read_data(cur, end, values, sizeof(values))) return false;
+                res.set = values[0];
+                res.binding = values[1];
+                res.num_descs = values[2];
+                res.type = (ShaderResourceType)(values[3] & 0xFF);
+                res.texture_dimension = (ShaderTextureDimension)((values[3] >> 8) & 0xFF);
+                dst.resources.push_back(move(res));
+            }
+            u32 num_inputs;
+            if (!read_data(cur, end, &dst.num_constants, sizeof(u32)) || !read_data(cur, end, &num_inputs, sizeof(u32))) return false;
+            dst.inputs.clear();
+            for (u32 i = 0; i < num_inputs; ++i)
+            {
+                ShaderInputReflection input;
+                u32 values[3];
+                if (!read_name(cur, end, input.semantic_name) || !read_data(cur, end, values, sizeof(values))) return false;
+                input.semantic_index = values[0];
+                input.location = values[1];
+                input.num_components = values[2];
+                dst.inputs.push_back(move(input));
+            }
+            return true;
+        }
+        static bool is_includes_changed(Span<const ShaderCacheInclude> includes)
+        {
+            for (auto& include : includes)
+            {
+                auto f = open_file(include.m_path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing);
+                if (failed(f)) return true;
+                auto data = load_file_data(f.get());
+                if (failed(data)) return true;
+                if (hash_shader_file_data(data.get().data(), data.get().size()) != include.m_hash) return true;
+            }
+            return false;
+        }
+        // Stores every cache file in one subdirectory named by the last two characters of the key, so that one
+        // directory does not contain too many files.
+        static Path get_shader_cache_path(const Path& dir, u64 key)
+        {
+            c8 buf[32];
+            snprintf(buf, 32, "%016llx", (unsigned long long)key);
+            Path ret = dir;
+            ret.push_back(Name(buf + 14, 2));
+            ret.push_back(buf);
+            return ret;
+        }
+        static bool read_cache_file(const Path& path, u64 key, CachedShader& dst)
+        {
+            auto file = VFS::map_file(path);
+            if (failed(file)) return false;
+            const byte_t* data = file.get()->get_data();
+            usize size = file.get()->get_size();
+            if (size < sizeof(ShaderCacheFileHeader)) return false;
+            ShaderCacheFileHeader header;
+            memcpy(&header, data, sizeof(ShaderCacheFileHeader));
+            if (header.magic != SHADER_CACHE_FILE_MAGIC || header.version != SHADER_CACHE_VERSION || header.key != key) return false;
+            const byte_t* cur = data + sizeof(ShaderCacheFileHeader);
+            const byte_t* end = data + size;
+            if ((usize)(end - cur) < header.entry_point_size) return false;
+            dst.m_result.entry_point = Name((const c8*)cur, header.entry_point_size);
+            cur += header.entry_point_size;
+            dst.m_includes.clear();
+            for (u32 i = 0; i < header.num_includes; ++i)
+            {
+                u64 hash;
+                u32 path_size;
+                if ((usize)(end - cur) < sizeof(u64) + sizeof(u32)) return false;
+                memcpy(&hash, cur, sizeof(u64));
+                memcpy(&path_size, cur + sizeof(u64), sizeof(u32));
+                cur += sizeof(u64) + sizeof(u32);
+                if ((usize)(end - cur) < path_size) return false;
+                ShaderCacheInclude include;
+                include.m_path = Path((const c8*)cur, path_size);
+                include.m_hash = hash;
+                dst.m_includes.push_back(move(include));
+                cur += path_size;
+            }
+            if ((u64)(end - cur) < header.reflection_size) return false;
+            const byte_t* reflection_end = cur + header.reflection_size;
+            if (!decode_shader_reflection(cur, reflection_end, dst.m_result.reflection) || cur != reflection_end) return false;
+            if ((u64)(end - cur) != header.data_size) return false;
+            dst.m_result.data = Blob(cur, (usize)header.data_size);
+            dst.m_result.format = (TargetFormat)header.format;
+            dst.m_result.metal_numthreads_x = header.metal_numthreads_x;
+            dst.m_result.metal_numthreads_y = header.metal_numthreads_y;
+            dst.m_result.metal_numthreads_z = header.metal_numthreads_z;
+            return true;
+        }
+        static RV write_cache_file(const Path& path, u64 key, const CachedShader& src)
+        {
+            lutry
+            {
+                ShaderCacheFileHeader header;
+                header.magic = SHADER_CACHE_FILE_MAGIC;
+                header.version = SHADER_CACHE_VERSION;
+                header.key = key;
+                header.data_size = src.m_result.data.size();
+                header.format = (u32)src.m_result.format;
+                header.metal_numthreads_x = src.m_result.metal_numthreads_x;
+                header.metal_numthreads_y = src.m_result.metal_numthreads_y;
+                header.metal_numthreads_z = src.m_result.metal_numthreads_z;
+                header.entry_point_size = (u32)src.m_result.entry_point.size();
+                header.num_includes = (u32)src.m_includes.size();
+                Vector<byte_t> reflection;
+                encode_shader_reflection(src.m_result.reflection, reflection);
+                header.reflection_size = reflection.size();
+                Vector<String> include_paths;
+                usize size = sizeof(ShaderCacheFileHeader) + header.entry_point_size + reflection.size() + (usize)header.data_size;
+                for (auto& include : src.m_includes)
+                {
+                    include_paths.push_back(include.m_path.encode());
+                    size += sizeof(u64) + sizeof(u32) + include_paths.back().size();
+                }
+                Vector<byte_t> data;
+                data.reserve(size);
+                StaticBinaryWriter writer(data);
+                writer.write_value(header);
+                writer.write(src.m_result.entry_point.c_str(), header.entry_point_size);
+                for (usize i = 0; i < src.m_includes.size(); ++i)
+                {
+                    u32 path_size = (u32)include_paths[i].size();
+                    writer.write_value(src.m_includes[i].m_hash);
+                    writer.write_value(path_size);
+                    writer.write(include_paths[i].data(), path_size);
+                }
+                writer.write(reflection.data(), reflection.size());
+                writer.write(src.m_result.data.data(), (usize)header.data_size);
+                // Creates the cache directory and the subdirectory.
+                Path dir = path;
+                dir.pop_back();
+                Path cache_dir = dir;
+                cache_dir.pop_back();
+                for (const Path* d : { &cache_dir, &dir })
+                {
+                    auto r = VFS::create_dir(*d);
+                    if (failed(r) && r.errcode() != BasicError::already_exists()) return r.errcode();
+                }
+                luexp(VFS::write_file_atomically(path, data.cspan()));
+            }
+            lucatchret;
+            return ok;
+        }
+        static void store_memory_cache(u64 key, const CachedShader& shader)
+        {
+            if (!g_shader_cache_desc.max_memory_entries) return;
+            auto iter = g_memory_cache.find(key);
+            if (iter != g_memory_cache.end())
+            {
+                iter->second = shader;
+                return;
+            }
+            while (g_memory_cache_keys.size() >= g_shader_cache_desc.max_memory_entries)
+            {
+                g_memory_cache.erase(g_memory_cache_keys.front());
+                g_memory_cache_keys.pop_front();
+            }
+            g_memory_cache.insert(make_pair(key, shader));
+            g_memory_cache_keys.push_back(key);
+        }
+        bool load_cached_shader(u64 key, ShaderCompileResult& result)
+        {
+            CachedShader shader;
+            Path disk_dir;
+            bool found_in_memory = false;
+            {
+                MutexGuard guard(g_shader_cache_mtx);
+                auto iter = g_memory_cache.find(key);
+                if (iter != g_memory_cache.end())
+                {
+                    shader = iter->second;
+                    found_in_memory = true;
+                }
+                disk_dir = g_shader_cache_desc.disk_dir;
+            }
+            if (!found_in_memory)
+            {
+                if (disk_dir.empty() || !read_cache_file(get_shader_cache_path(disk_dir, key), key, shader)) return false;
+            }
+            if (is_includes_changed({shader.m_includes.data(), shader.m_includes.size()})) return false;
+            if (!found_in_memory)
+            {
+                MutexGuard guard(g_shader_cache_mtx);
+                store_memory_cache(key, shader);
+            }
+            result = move(shader.m_result);
+            return true;
+        }
+        void store_cached_shader(u64 key, const ShaderCompileResult& result, Span<const ShaderCacheInclude> includes)
+        {
+            CachedShader shader;
+            shader.m_result = result;
+            for (auto& include : includes) shader.m_includes.push_back(include);
+            Path disk_dir;
+            {
+                MutexGuard guard(g_shader_cache_mtx);
+                store_memory_cache(key, shader);
+                disk_dir = g_shader_cache_desc.disk_dir;
+            }
+            if (!disk_dir.empty())
+            {
+                // Failing to write the cache file only affects later compilations.
+                auto _ = write_cache_file(get_shader_cache_path(disk_dir, key), key, shader);
+            }
+        }
+    }
+}
@@ -0,0 +1,47 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file ShaderCache.hpp
+* @author JXMaster
+* @date 2024/4/14
+*/
+#pragma once
+#include "../ShaderCache.hpp"
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    namespace ShaderCompiler
+    {
+        // One file included by the shader when the shader is compiled.
+        struct ShaderCacheInclude
+        {
+            // The platform-native path of the file.
+            Path m_path;
+            // The hash of the file content.
+            u64 m_hash;
+        };
+
+        u64 hash_shader_file_data(const void* data, usize size);
+
+        // Computes the key of the shader compile result.
+        u64 get_shader_cache_key(const ShaderCompileParameters& params);
+
+        // Loads the shader compile result from the cache. Returns `false` if the result is not found or included files are changed.
+        bool load_cached_shader(u64 key, ShaderCompileResult& result);
+
+        // Stores the shader compile result to the cache.
+        void store_cached_shader(u64 key, const ShaderCompileResult& result, Span<const ShaderCacheInclude> includes);
+
+        // Appends the encoded reflection data to `dst`.
+        void encode_shader_reflection(const ShaderReflection& reflection, Vector<byte_t>& dst);
+
+        // Decodes reflection data starting at `cur`, and advances `cur` to the end of the decoded data. Returns `false` if the data is invalid.
+        bool decode_shader_reflection(const byte_t*& cur, const byte_t* end, ShaderReflection& dst);
+
+        void init_shader_cache();
+        void close_shader_cache();
+    }
+}
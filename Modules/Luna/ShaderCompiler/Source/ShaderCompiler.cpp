@@ -15,12 +15,15 @@
 #endif
 
 #include "ShaderCompiler.hpp"
+#include "ShaderVariant.hpp"
 #include <Luna/VariantUtils/JSON.hpp>
 #include <locale>
 #include <codecvt>
 #include <Luna/Runtime/HashSet.hpp>
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/Runtime/File.hpp>
+#include <Luna/VFS/VFS.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
 #include <spirv_cross/spirv_msl.hpp>
 
 namespace Luna
@@ -66,8 +69,36 @@ namespace Luna
                     ComPtr<IDxcBlobEncoding> pEncoding;
                     if (m_included_files.find(path) == m_included_files.end())
                     {
-                        lulet(f, open_file(path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing));
-                        lulet(data, load_file_data(f));
+                        Blob data;
+                        u64 hash = 0;
+                        bool cached = false;
+                        IncludeFileCache* cache = m_compiler->m_include_file_cache;
+                        if (cache)
+                        {
+                            MutexGuard guard(cache->m_mtx);
+                            auto iter = cache->m_files.find(path);
+                            if (iter != cache->m_files.end())
+                            {
+                                data = iter->second.first;
+                                hash = iter->second.second;
+                                cached = true;
+                            }
+                        }
+                        if (!cached)
+                        {
+                            lulet(f, open_file(path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing));
+                            luset(data, load_file_data(f));
+                            hash = hash_shader_file_data(data.data(), data.size());
+                            if (cache)
+                            {
+                                MutexGuard guard(cache->m_mtx);
+                                cache->m_files.insert(make_pair(path, make_pair(data, hash)));
+                            }
+                        }
+                        ShaderCacheInclude include;
+                        include.m_path = path;
+                        include.m_hash = hash;
+                        m_compiler->m_includes.push_back(move(include));
                         m_compiler->m_dxc_utils->CreateBlob(data.data(), (UINT32)data.size(), CP_UTF8, pEncoding.get_address_of());
                         *ppIncludeSource = pEncoding.detach();
                         m_included_files.insert(path);
@@ -136,6 +167,8 @@ namespace Luna
             case ShaderType::vertex: sm = "vs"; break;
             case ShaderType::pixel: sm = "ps"; break;
             case ShaderType::compute: sm = "cs"; break;
+            case ShaderType::mesh: sm = "ms"; break;
+            case ShaderType::amplification: sm = "as"; break;
             }
             snprintf(shader_type, 16, "%s_%u_%u", sm, params.shader_model.major, params.shader_model.minor);
             arguments.push_back(utf8_to_wstring(shader_type));
@@ -201,6 +234,13 @@ namespace Luna
             if (target_type == DxcTargetType::spir_v)
             {
                 argument_pointers.push_back(L"-spirv");
+                bool requires_spirv_1_4 = params.shader_type == ShaderType::mesh || params.shader_type == ShaderType::amplification ||
+                    params.shader_model.major > 6 || (params.shader_model.major == 6 && params.shader_model.minor >= 5);
+                if (requires_spirv_1_4)
+                {
+                    // SPV_EXT_mesh_shader and SPV_KHR_ray_query (used by shader model 6.5 ray queries) require SPIR-V 1.4.
+                    argument_pointers.push_back(L"-fspv-target-env=vulkan1.2");
+                }
             }
             // Include handler.
             DxcIncludeHandler include_handler;
@@ -244,6 +284,97 @@ namespace Luna
             }
             return result;
         }
+        static ShaderTextureDimension get_texture_dimension(const spirv_cross::SPIRType& type)
+        {
+            switch (type.image.dim)
+            {
+            case spv::Dim1D: return type.image.arrayed ? ShaderTextureDimension::tex1darray : ShaderTextureDimension::tex1d;
+            case spv::Dim2D:
+                if (type.image.ms) return type.image.arrayed ? ShaderTextureDimension::tex2dmsarray : ShaderTextureDimension::tex2dms;
+                return type.image.arrayed ? ShaderTextureDimension::tex2darray : ShaderTextureDimension::tex2d;
+            case spv::Dim3D: return ShaderTextureDimension::tex3d;
+            case spv::DimCube: return type.image.arrayed ? ShaderTextureDimension::texcubearray : ShaderTextureDimension::texcube;
+            default: return ShaderTextureDimension::none;
+            }
+        }
+        // Generates reflection data from SPIR-V compiled by DXC. DXC uses the register index as the binding and the register space
+        // as the descriptor set, so the reflected bindings match HLSL registers.
+        static void reflect_spirv(const void* data, usize size, ShaderType shader_type, ShaderReflection& dst)
+        {
+            spirv_cross::Compiler compiler((const uint32_t*)data, size / 4);
+            spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+            auto add_resources = [&](const spirv_cross::SmallVector<spirv_cross::Resource>& list, ShaderResourceType type)
+            {
+                for (auto& res : list)
+                {
+                    const spirv_cross::SPIRType& spirv_type = compiler.get_type(res.type_id);
+                    ShaderResourceReflection r;
+                    r.name = res.name.c_str();
+                    r.set = compiler.get_decoration(res.id, spv::DecorationDescriptorSet);
+                    r.binding = compiler.get_decoration(res.id, spv::DecorationBinding);
+                    // Runtime arrays have size 0.
+                    r.num_descs = (!spirv_type.array.empty() && spirv_type.array_size_literal.back()) ? spirv_type.array.back() : 1;
+                    r.type = type;
+                    if (spirv_type.basetype == spirv_cross::SPIRType::Image && spirv_type.image.dim == spv::DimBuffer)
+                    {
+                        // `Buffer` and `RWBuffer` are represented as texel buffers.
+                        r.type = type == ShaderResourceType::read_texture ? ShaderResourceType::read_buffer : ShaderResourceType::read_write_buffer;
+                    }
+                    else if (type == ShaderResourceType::read_texture || type == ShaderResourceType::read_write_texture)
+                    {
+                        r.texture_dimension = get_texture_dimension(spirv_type);
+                    }
+                    else if (type == ShaderResourceType::read_write_buffer && compiler.get_buffer_block_flags(res.id).get(spv::DecorationNonWritable))
+                    {
+                        // `StructuredBuffer` and `ByteAddressBuffer` are represented as non-writable storage buffers.
+                        r.type = ShaderResourceType::read_buffer;
+                    }
+                    dst.resources.push_back(r);
+                }
+            };
+            add_resources(resources.uniform_buffers, ShaderResourceType::uniform_buffer);
+            add_resources(resources.storage_buffers, ShaderResourceType::read_write_buffer);
+            add_resources(resources.separate_images, ShaderResourceType::read_texture);
+            add_resources(resources.sampled_images, ShaderResourceType::read_texture);
+            add_resources(resources.storage_images, ShaderResourceType::read_write_texture);
+            add_resources(resources.separate_samplers, ShaderResourceType::sampler);
+            add_resources(resources.acceleration_structures, ShaderResourceType::acceleration_structure);
+            sort(dst.resources.begin(), dst.resources.end(), [](const ShaderResourceReflection& lhs, const ShaderResourceReflection& rhs)
+            {
+                return lhs.set < rhs.set || (lhs.set == rhs.set && lhs.binding < rhs.binding);
+            });
+            for (auto& res : resources.push_constant_buffers)
+            {
+                usize size = compiler.get_declared_struct_size(compiler.get_type(res.base_type_id));
+                dst.num_constants = max(dst.num_constants, (u32)((size + 3) / 4));
+            }
+            if (shader_type == ShaderType::vertex)
+            {
+                for (auto& res : resources.stage_inputs)
+                {
+                    ShaderInputReflection input;
+                    // DXC names stage input variables as `in.var.{SEMANTIC}`.
+                    const c8* name = res.name.c_str();
+                    usize name_size = res.name.size();
+                    if (name_size > 7 && !memcmp(name, "in.var.", 7))
+                    {
+                        name += 7;
+                        name_size -= 7;
+                    }
+                    usize index_begin = name_size;
+                    while (index_begin > 0 && isdigit((u8)name[index_begin - 1])) --index_begin;
+                    input.semantic_name = Name(name, index_begin);
+                    input.semantic_index = index_begin == name_size ? 0 : (u32)strtoul(name + index_begin, nullptr, 10);
+                    input.location = compiler.get_decoration(res.id, spv::DecorationLocation);
+                    input.num_components = compiler.get_type(res.type_id).vecsize;
+                    dst.inputs.push_back(input);
+                }
+                sort(dst.inputs.begin(), dst.inputs.end(), [](const ShaderInputReflection& lhs, const ShaderInputReflection& rhs)
+                {
+                    return lhs.location < rhs.location;
+                });
+            }
+        }
         R<ShaderCompileResult> Compiler::spirv_compile(const ShaderCompileParameters& params, SpirvOutputType output_type)
         {
             ShaderCompileResult r;
@@ -256,6 +387,10 @@ namespace Luna
                 lulet(dxc_result, dxc_compile(dxc_params, DxcTargetType::spir_v));
                 void* dxc_out_data = dxc_result.m_dxc_blob->GetBufferPointer();
                 usize dxc_out_size = dxc_result.m_dxc_blob->GetBufferSize();
+                if (params.generate_reflection)
+                {
+                    reflect_spirv(dxc_out_data, dxc_out_size, params.shader_type, r.reflection);
+                }
                 if(output_type == SpirvOutputType::msl)
                 {
                     spirv_cross::CompilerMSL msl((const uint32_t*)dxc_out_data, dxc_out_size / 4);
@@ -273,6 +408,16 @@ namespace Luna
                         break;
                     }
                     msl.set_msl_options(options);
+                    // Binds push constants to buffer slot 15, which matches `RHI::PIPELINE_CONSTANTS_REGISTER_SPACE`.
+                    for (auto& entry : msl.get_entry_points_and_stages())
+                    {
+                        spirv_cross::MSLResourceBinding push_constant_binding;
+                        push_constant_binding.stage = entry.execution_model;
+                        push_constant_binding.desc_set = spirv_cross::kPushConstDescSet;
+                        push_constant_binding.binding = spirv_cross::kPushConstBinding;
+                        push_constant_binding.msl_buffer = 15;
+                        msl.add_msl_resource_binding(push_constant_binding);
+                    }
                     auto compiled_data = msl.compile();
                     r.data = Blob((const byte_t*)compiled_data.c_str(), compiled_data.size());
                     r.format = TargetFormat::msl;
@@ -294,6 +439,15 @@ namespace Luna
         {
             lutsassert();
             ShaderCompileResult r;
+            // Shaders compiled without target are only validated, so their results are not cached.
+            bool use_cache = params.use_cache && params.target_format != TargetFormat::none;
+            u64 cache_key = 0;
+            if (use_cache)
+            {
+                cache_key = get_shader_cache_key(params);
+                if (load_cached_shader(cache_key, r)) return r;
+            }
+            m_includes.clear();
             lutry
             {
                 switch (params.target_format)
@@ -307,6 +461,12 @@ namespace Luna
                     r.data = Blob((const byte_t*)dxc_result.m_dxc_blob->GetBufferPointer(), dxc_result.m_dxc_blob->GetBufferSize());
                     r.format = TargetFormat::dxil;
                     r.entry_point = params.entry_point;
+                    if (params.generate_reflection)
+                    {
+                        // DXIL is not reflected directly, since the DXIL reflection interface is available only on Windows.
+                        lulet(spirv_result, dxc_compile(params, DxcTargetType::spir_v));
+                        reflect_spirv(spirv_result.m_dxc_blob->GetBufferPointer(), spirv_result.m_dxc_blob->GetBufferSize(), params.shader_type, r.reflection);
+                    }
                     break;
                 }
                 case TargetFormat::spir_v:
@@ -315,6 +475,10 @@ namespace Luna
                     r.data = Blob((const byte_t*)dxc_result.m_dxc_blob->GetBufferPointer(), dxc_result.m_dxc_blob->GetBufferSize());
                     r.format = TargetFormat::spir_v;
                     r.entry_point = params.entry_point;
+                    if (params.generate_reflection)
+                    {
+                        reflect_spirv(r.data.data(), r.data.size(), params.shader_type, r.reflection);
+                    }
                     break;
                 }
                 case TargetFormat::msl:
@@ -324,11 +488,66 @@ namespace Luna
                     lupanic_msg("Unsupportted output format.");
                     break;
                 }
+                if (use_cache)
+                {
+                    store_cached_shader(cache_key, r, {m_includes.data(), m_includes.size()});
+                }
             }
             lucatchret;
             return r;
         }
 
+        RV Compiler::compile_batch(Span<const ShaderCompileParameters> params, Span<ShaderCompileResult> results)
+        {
+            lutsassert();
+            if (results.size() < params.size()) return BasicError::bad_arguments();
+            IncludeFileCache include_file_cache;
+            include_file_cache.m_mtx = new_mutex();
+            // Compilers not used by any thread. New compilers are created when all compilers are in use.
+            Ref<IMutex> compilers_mtx = new_mutex();
+            Vector<Compiler*> free_compilers;
+            for (auto& compiler : m_batch_compilers) free_compilers.push_back(compiler.get());
+            Vector<ErrCode> errors(params.size(), ErrCode(0));
+            Vector<String> error_messages(params.size());
+            JobSystem::parallel_for(0, params.size(), 1, [&](usize i)
+            {
+                Compiler* compiler = nullptr;
+                {
+                    MutexGuard guard(compilers_mtx);
+                    if (free_compilers.empty())
+                    {
+                        m_batch_compilers.push_back(new_object<Compiler>());
+                        compiler = m_batch_compilers.back().get();
+                    }
+                    else
+                    {
+                        compiler = free_compilers.back();
+                        free_compilers.pop_back();
+                    }
+                }
+                compiler->m_include_file_cache = &include_file_cache;
+                auto r = compiler->compile(params[i]);
+                compiler->m_include_file_cache = nullptr;
+                if (succeeded(r))
+                {
+                    results[i] = move(r.get());
+                }
+                else
+                {
+                    // Error messages are stored in thread-local error objects, so copy them here.
+                    errors[i] = r.errcode();
+                    error_messages[i] = explain(r.errcode());
+                }
+                MutexGuard guard(compilers_mtx);
+                free_compilers.push_back(compiler);
+            });
+            for (usize i = 0; i < params.size(); ++i)
+            {
+                if (errors[i].code) return set_error(errors[i], "%s", error_messages[i].c_str());
+            }
+            return ok;
+        }
+
         LUNA_SHADER_COMPILER_API Ref<ICompiler> new_compiler()
         {
             return new_object<Compiler>();
@@ -337,12 +556,24 @@ namespace Luna
         struct ShaderCompilerModule : public Module
         {
             virtual const c8* get_name() override { return "ShaderCompiler"; }
+            virtual ModuleInitFlag get_init_flags() override { return ModuleInitFlag::concurrent; }
+            virtual RV on_register() override
+            {
+                return add_dependency_modules(this, {module_vfs(), module_job_system()});
+            }
             virtual RV on_init() override
             {
                 register_boxed_type<Compiler>();
                 impl_interface_for_type<Compiler, ICompiler>();
+                register_boxed_type<ShaderVariantSet>();
+                impl_interface_for_type<ShaderVariantSet, IShaderVariantSet>();
+                init_shader_cache();
                 return ok;
             }
+            virtual void on_close() override
+            {
+                close_shader_cache();
+            }
         };
     }
     LUNA_SHADER_COMPILER_API Module* module_shader_compiler()
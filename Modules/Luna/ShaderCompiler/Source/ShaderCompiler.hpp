@@ -17,7 +17,10 @@
 #include <dxc/WinAdapter.h>
 #endif
 #include <Luna/Runtime/TSAssert.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Mutex.hpp>
 #include "../ShaderCompiler.hpp"
+#include "ShaderCache.hpp"
 #include <string>
 
 namespace Luna
@@ -92,6 +95,14 @@ namespace Luna
             ComPtr<IDxcBlob> m_dxc_blob;
         };
 
+        // Files included by shaders of one compile batch, so that every file is loaded only once.
+        struct IncludeFileCache
+        {
+            Ref<IMutex> m_mtx;
+            // The file data and the data hash of every loaded file.
+            HashMap<Path, Pair<Blob, u64>> m_files;
+        };
+
         struct Compiler : public ICompiler
         {
             lustruct("ShaderCompiler::Compiler", "{E89511FE-424E-4076-8478-6BE1254714E0}");
@@ -103,11 +114,20 @@ namespace Luna
             ComPtr<IDxcCompiler3> m_dxc_compiler;
             ComPtr<IDxcUtils> m_dxc_utils;
             ComPtr<IDxcIncludeHandler> m_default_include_handler;
+            // Files included by the shader being compiled.
+            Vector<ShaderCacheInclude> m_includes;
+            // The include file cache shared by all compilers of the current batch, `nullptr` if not compiling one batch.
+            IncludeFileCache* m_include_file_cache = nullptr;
+
+            // Compilers used by `compile_batch`. Every compiler owns its own DXC instances, so one compiler is used by 
+            // only one thread at a time.
+            Vector<Ref<Compiler>> m_batch_compilers;
 
             R<ShaderCompileResult> compile_none(const ShaderCompileParameters& params);
             R<DxcCompileResult> dxc_compile(const ShaderCompileParameters& params, DxcTargetType target_type);
             R<ShaderCompileResult> spirv_compile(const ShaderCompileParameters& params, SpirvOutputType output_type);
             virtual R<ShaderCompileResult> compile(const ShaderCompileParameters& params) override;
+            virtual RV compile_batch(Span<const ShaderCompileParameters> params, Span<ShaderCompileResult> results) override;
         };
     }
 }
@@ -0,0 +1,435 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ShaderVariant.cpp
+* @author JXMaster
+* @date 2024/4/15
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_SHADER_COMPILER_API LUNA_EXPORT
+#include "ShaderVariant.hpp"
+#include "ShaderCache.hpp"
+#include <Luna/Runtime/Hash.hpp>
+#include <Luna/Runtime/StaticSerialization.hpp>
+
+namespace Luna
+{
+    namespace ShaderCompiler
+    {
+        constexpr u32 SHADER_VARIANT_PACK_MAGIC = 0x50564C4C; // "LLVP"
+        constexpr u32 SHADER_VARIANT_PACK_VERSION = 2;
+
+        struct ShaderVariantPackHeader
+        {
+            u32 magic;
+            u32 version;
+            u64 desc_hash;
+            u64 num_results;
+            u64 num_variants;
+        };
+        // Followed by the entry point name, the reflection data and the result data.
+        struct ShaderVariantPackResult
+        {
+            u64 data_size;
+            u32 format;
+            u32 metal_numthreads_x;
+            u32 metal_numthreads_y;
+            u32 metal_numthreads_z;
+            u32 entry_point_size;
+            u32 reflection_size;
+        };
+        struct ShaderVariantPackVariant
+        {
+            u64 variant;
+            u64 result;
+        };
+
+        RV ShaderVariantSet::init(const ShaderVariantSetDesc& desc)
+        {
+            m_params = desc.params;
+            m_source = Blob((const byte_t*)desc.params.source.data(), desc.params.source.size());
+            m_include_paths.assign(desc.params.include_paths);
+            m_definitions.assign(desc.params.definitions);
+            m_params.source = { (const c8*)m_source.data(), m_source.size() };
+            m_params.include_paths = { m_include_paths.data(), m_include_paths.size() };
+            m_params.definitions = { m_definitions.data(), m_definitions.size() };
+            m_keyword_sets = desc.keyword_sets;
+            m_num_variants = 1;
+            m_desc_hash = get_shader_cache_key(m_params);
+            for (auto& keyword_set : m_keyword_sets)
+            {
+                u64 num_keywords = keyword_set.keywords.empty() ? 1 : keyword_set.keywords.size();
+                if (num_keywords > U64_MAX / m_num_variants)
+                {
+                    return set_error(BasicError::out_of_range(), "Too many shader variants for shader %s.", m_params.source_name.c_str());
+                }
+                m_num_variants *= num_keywords;
+                m_desc_hash = memhash64(&num_keywords, sizeof(num_keywords), m_desc_hash);
+                for (auto& keyword : keyword_set.keywords)
+                {
+                    m_desc_hash = strhash64(keyword ? keyword.c_str() : "", m_desc_hash);
+                }
+            }
+            m_mtx = new_mutex();
+            return ok;
+        }
+        ShaderVariantState& ShaderVariantSet::get_state(shader_variant_t variant)
+        {
+            auto iter = m_variants.find(variant);
+            if (iter == m_variants.end())
+            {
+                iter = m_variants.insert(make_pair(variant, ShaderVariantState())).first;
+            }
+            return iter->second;
+        }
+        void ShaderVariantSet::get_variant_definitions(shader_variant_t variant, Vector<Pair<Name, Name>>& definitions)
+        {
+            definitions = m_definitions;
+            for (auto& keyword_set : m_keyword_sets)
+            {
+                if (keyword_set.keywords.empty()) continue;
+                const Name& keyword = keyword_set.keywords[(usize)(variant % keyword_set.keywords.size())];
+                variant /= keyword_set.keywords.size();
+                if (keyword) definitions.push_back(make_pair(keyword, Name("1")));
+            }
+        }
+        static u64 hash_compile_result(const ShaderCompileResult& result)
+        {
+            u64 h = memhash64(result.data.data(), result.data.size());
+            h = strhash64(result.entry_point ? result.entry_point.c_str() : "", h);
+            u32 values[4] = { (u32)result.format, result.metal_numthreads_x, result.metal_numthreads_y, result.metal_numthreads_z };
+            return memhash64(values, sizeof(values), h);
+        }
+        static bool is_compile_result_equal(const ShaderCompileResult& lhs, const ShaderCompileResult& rhs)
+        {
+            return lhs.format == rhs.format &&
+                lhs.entry_point == rhs.entry_point &&
+                lhs.metal_numthreads_x == rhs.metal_numthreads_x &&
+                lhs.metal_numthreads_y == rhs.metal_numthreads_y &&
+                lhs.metal_numthreads_z == rhs.metal_numthreads_z &&
+                lhs.data.size() == rhs.data.size() &&
+                !memcmp(lhs.data.data(), rhs.data.data(), lhs.data.size());
+        }
+        usize ShaderVariantSet::add_result(ShaderCompileResult&& result)
+        {
+            u64 h = hash_compile_result(result);
+            auto iter = m_result_indices.find(h);
+            if (iter == m_result_indices.end())
+            {
+                iter = m_result_indices.insert(make_pair(h, Vector<usize>())).first;
+            }
+            for (usize index : iter->second)
+            {
+                if (is_compile_result_equal(*m_results[index], result)) return index;
+            }
+            usize index = m_results.size();
+            m_results.push_back(UniquePtr<ShaderCompileResult>(memnew<ShaderCompileResult>(move(result))));
+            iter->second.push_back(index);
+            return index;
+        }
+        Ref<ICompiler> ShaderVariantSet::acquire_compiler()
+        {
+            {
+                MutexGuard guard(m_mtx);
+                if (!m_free_compilers.empty())
+                {
+                    Ref<ICompiler> compiler = move(m_free_compilers.back());
+                    m_free_compilers.pop_back();
+                    return compiler;
+                }
+            }
+            return new_compiler();
+        }
+        void ShaderVariantSet::release_compiler(Ref<ICompiler>&& compiler)
+        {
+            MutexGuard guard(m_mtx);
+            m_free_compilers.push_back(move(compiler));
+        }
+        RV ShaderVariantSet::compile_variant(shader_variant_t variant)
+        {
+            Vector<Pair<Name, Name>> definitions;
+            get_variant_definitions(variant, definitions);
+            ShaderCompileParameters params = m_params;
+            params.definitions = { definitions.data(), definitions.size() };
+            Ref<ICompiler> compiler = acquire_compiler();
+            auto r = compiler->compile(params);
+            release_compiler(move(compiler));
+            MutexGuard guard(m_mtx);
+            ShaderVariantState& state = get_state(variant);
+            state.m_job = JobSystem::INVALID_JOB_ID;
+            if (failed(r))
+            {
+                state.m_error = r.errcode();
+                state.m_error_message = explain(r.errcode());
+                return r.errcode();
+            }
+            state.m_result = add_result(move(r.get()));
+            return ok;
+        }
+        R<const ShaderCompileResult*> ShaderVariantSet::get_finished_variant(const ShaderVariantState& state)
+        {
+            if (state.m_result != USIZE_MAX) return (const ShaderCompileResult*)m_results[state.m_result].get();
+            if (state.m_error.code) return set_error(state.m_error, "%s", state.m_error_message.c_str());
+            return BasicError::not_ready();
+        }
+        shader_variant_t ShaderVariantSet::get_variant_key(Span<const Name> keywords)
+        {
+            shader_variant_t key = 0;
+            u64 stride = 1;
+            for (auto& keyword_set : m_keyword_sets)
+            {
+                if (keyword_set.keywords.empty()) continue;
+                for (usize i = 0; i < keyword_set.keywords.size(); ++i)
+                {
+                    const Name& keyword = keyword_set.keywords[i];
+                    if (keyword && find(keywords.begin(), keywords.end(), keyword) != keywords.end())
+                    {
+                        key += i * stride;
+                        break;
+                    }
+                }
+                stride *= keyword_set.keywords.size();
+            }
+            return key;
+        }
+        R<const ShaderCompileResult*> ShaderVariantSet::get_variant(shader_variant_t variant)
+        {
+            if (variant >= m_num_variants) return BasicError::out_of_range();
+            JobSystem::job_id_t job;
+            {
+                MutexGuard guard(m_mtx);
+                ShaderVariantState& state = get_state(variant);
+                state.m_used = true;
+                if (state.m_result != USIZE_MAX || state.m_error.code) return get_finished_variant(state);
+                job = state.m_job;
+            }
+            if (job != JobSystem::INVALID_JOB_ID)
+            {
+                JobSystem::wait_job(job);
+            }
+            else
+            {
+                // The error is recorded in the variant state and returned below.
+                auto _ = compile_variant(variant);
+            }
+            MutexGuard guard(m_mtx);
+            return get_finished_variant(get_state(variant));
+        }
+        struct ShaderVariantCompileJob
+        {
+            ShaderVariantSet* m_set;
+            shader_variant_t m_variant;
+        };
+        static void shader_variant_compile_job(void* params)
+        {
+            ShaderVariantCompileJob* job = (ShaderVariantCompileJob*)params;
+            auto _ = job->m_set->compile_variant(job->m_variant);
+            // Releases the reference added in `get_variant_async`.
+            object_release(job->m_set);
+        }
+        R<const ShaderCompileResult*> ShaderVariantSet::get_variant_async(shader_variant_t variant, shader_variant_t fallback)
+        {
+            if (variant >= m_num_variants) return BasicError::out_of_range();
+            {
+                MutexGuard guard(m_mtx);
+                ShaderVariantState& state = get_state(variant);
+                state.m_used = true;
+                if (state.m_result != USIZE_MAX) return (const ShaderCompileResult*)m_results[state.m_result].get();
+                if (!state.m_error.code && state.m_job == JobSystem::INVALID_JOB_ID)
+                {
+                    object_retain(this);
+                    ShaderVariantCompileJob* job = (ShaderVariantCompileJob*)JobSystem::new_job(shader_variant_compile_job,
+                        sizeof(ShaderVariantCompileJob), alignof(ShaderVariantCompileJob));
+                    job->m_set = this;
+                    job->m_variant = variant;
+                    JobSystem::set_job_name(job, "ShaderVariantCompile");
+                    state.m_job = JobSystem::submit_job(job, JobSystem::JobPriority::background);
+                }
+            }
+            return get_variant(fallback);
+        }
+        bool ShaderVariantSet::is_variant_ready(shader_variant_t variant)
+        {
+            MutexGuard guard(m_mtx);
+            auto iter = m_variants.find(variant);
+            return iter != m_variants.end() && iter->second.m_result != USIZE_MAX;
+        }
+        void ShaderVariantSet::wait_async_compiles()
+        {
+            Vector<JobSystem::job_id_t> jobs;
+            {
+                MutexGuard guard(m_mtx);
+                for (auto& variant : m_variants)
+                {
+                    if (variant.second.m_job != JobSystem::INVALID_JOB_ID) jobs.push_back(variant.second.m_job);
+                }
+            }
+            for (auto job : jobs) JobSystem::wait_job(job);
+        }
+        Vector<shader_variant_t> ShaderVariantSet::get_used_variants()
+        {
+            Vector<shader_variant_t> ret;
+            MutexGuard guard(m_mtx);
+            for (auto& variant : m_variants)
+            {
+                if (variant.second.m_used) ret.push_back(variant.first);
+            }
+            return ret;
+        }
+        RV ShaderVariantSet::precompile(Span<const shader_variant_t> variants)
+        {
+            Vector<shader_variant_t> compile_variants;
+            Vector<JobSystem::job_id_t> jobs;
+            {
+                MutexGuard guard(m_mtx);
+                for (shader_variant_t variant : variants)
+                {
+                    if (variant >= m_num_variants) return BasicError::out_of_range();
+                    ShaderVariantState& state = get_state(variant);
+                    if (state.m_result != USIZE_MAX || state.m_error.code) continue;
+                    if (state.m_job != JobSystem::INVALID_JOB_ID) jobs.push_back(state.m_job);
+                    else compile_variants.push_back(variant);
+                }
+            }
+            RV r = ok;
+            if (!compile_variants.empty())
+            {
+                Vector<Vector<Pair<Name, Name>>> definitions(compile_variants.size());
+                Vector<ShaderCompileParameters> params(compile_variants.size());
+                Vector<ShaderCompileResult> results(compile_variants.size());
+                for (usize i = 0; i < compile_variants.size(); ++i)
+                {
+                    get_variant_definitions(compile_variants[i], definitions[i]);
+                    params[i] = m_params;
+                    params[i].definitions = { definitions[i].data(), definitions[i].size() };
+                }
+                Ref<ICompiler> compiler = acquire_compiler();
+                r = compiler->compile_batch({ params.data(), params.size() }, { results.data(), results.size() });
+                release_compiler(move(compiler));
+                MutexGuard guard(m_mtx);
+                for (usize i = 0; i < compile_variants.size(); ++i)
+                {
+                    // If the batch fails, we cannot tell which variants fail, so only results with data are recorded. Variants
+                    // not recorded are compiled again when they are used, which records their errors.
+                    if (failed(r) && results[i].data.empty()) continue;
+                    get_state(compile_variants[i]).m_result = add_result(move(results[i]));
+                }
+            }
+            for (auto job : jobs) JobSystem::wait_job(job);
+            return r;
+        }
+        R<Blob> ShaderVariantSet::save_pack()
+        {
+            MutexGuard guard(m_mtx);
+            Vector<ShaderVariantPackVariant> variants;
+            for (auto& variant : m_variants)
+            {
+                if (variant.second.m_result == USIZE_MAX) continue;
+                ShaderVariantPackVariant v;
+                v.variant = variant.first;
+                v.result = variant.second.m_result;
+                variants.push_back(v);
+            }
+            usize size = sizeof(ShaderVariantPackHeader) + sizeof(ShaderVariantPackVariant) * variants.size();
+            Vector<Vector<byte_t>> reflections(m_results.size());
+            for (usize i = 0; i < m_results.size(); ++i)
+            {
+                auto& result = m_results[i];
+                encode_shader_reflection(result->reflection, reflections[i]);
+                size += sizeof(ShaderVariantPackResult) + result->entry_point.size() + reflections[i].size() + result->data.size();
+            }
+            Vector<byte_t> data;
+            data.reserve(size);
+            StaticBinaryWriter writer(data);
+            ShaderVariantPackHeader header;
+            header.magic = SHADER_VARIANT_PACK_MAGIC;
+            header.version = SHADER_VARIANT_PACK_VERSION;
+            header.desc_hash = m_desc_hash;
+            header.num_results = m_results.size();
+            header.num_variants = variants.size();
+            writer.write_value(header);
+            for (usize i = 0; i < m_results.size(); ++i)
+            {
+                auto& result = m_results[i];
+                ShaderVariantPackResult r;
+                r.data_size = result->data.size();
+                r.format = (u32)result->format;
+                r.metal_numthreads_x = result->metal_numthreads_x;
+                r.metal_numthreads_y = result->metal_numthreads_y;
+                r.metal_numthreads_z = result->metal_numthreads_z;
+                r.entry_point_size = (u32)result->entry_point.size();
+                r.reflection_size = (u32)reflections[i].size();
+                writer.write_value(r);
+                writer.write(result->entry_point.c_str(), r.entry_point_size);
+                writer.write(reflections[i].data(), r.reflection_size);
+                writer.write(result->data.data(), result->data.size());
+            }
+            writer.write(variants.data(), sizeof(ShaderVariantPackVariant) * variants.size());
+            return Blob(data.cspan());
+        }
+        RV ShaderVariantSet::load_pack(Span<const byte_t> data)
+        {
+            const byte_t* cur = data.data();
+            const byte_t* end = data.data() + data.size();
+            if (data.size() < sizeof(ShaderVariantPackHeader)) return BasicError::bad_data();
+            ShaderVariantPackHeader header;
+            memcpy(&header, cur, sizeof(ShaderVariantPackHeader));
+            cur += sizeof(ShaderVariantPackHeader);
+            if (header.magic != SHADER_VARIANT_PACK_MAGIC) return BasicError::bad_data();
+            if (header.version != SHADER_VARIANT_PACK_VERSION || header.desc_hash != m_desc_hash) return BasicError::version_dismatch();
+            Vector<ShaderCompileResult> results;
+            for (u64 i = 0; i < header.num_results; ++i)
+            {
+                ShaderVariantPackResult r;
+                if ((usize)(end - cur) < sizeof(ShaderVariantPackResult)) return BasicError::bad_data();
+                memcpy(&r, cur, sizeof(ShaderVariantPackResult));
+                cur += sizeof(ShaderVariantPackResult);
+                if ((u64)(end - cur) < (u64)r.entry_point_size + r.reflection_size + r.data_size) return BasicError::bad_data();
+                ShaderCompileResult result;
+                result.entry_point = Name((const c8*)cur, r.entry_point_size);
+                cur += r.entry_point_size;
+                const byte_t* reflection_end = cur + r.reflection_size;
+                if (!decode_shader_reflection(cur, reflection_end, result.reflection) || cur != reflection_end) return BasicError::bad_data();
+                result.data = Blob(cur, (usize)r.data_size);
+                cur += (usize)r.data_size;
+                result.format = (TargetFormat)r.format;
+                result.metal_numthreads_x = r.metal_numthreads_x;
+                result.metal_numthreads_y = r.metal_numthreads_y;
+                result.metal_numthreads_z = r.metal_numthreads_z;
+                results.push_back(move(result));
+            }
+            if ((u64)(end - cur) != header.num_variants * sizeof(ShaderVariantPackVariant)) return BasicError::bad_data();
+            Vector<ShaderVariantPackVariant> variants((usize)header.num_variants);
+            memcpy(variants.data(), cur, sizeof(ShaderVariantPackVariant) * variants.size());
+            for (auto& variant : variants)
+            {
+                if (variant.variant >= m_num_variants || variant.result >= header.num_results) return BasicError::bad_data();
+            }
+            MutexGuard guard(m_mtx);
+            Vector<usize> result_indices;
+            result_indices.reserve(results.size());
+            for (auto& result : results) result_indices.push_back(add_result(move(result)));
+            for (auto& variant : variants)
+            {
+                ShaderVariantState& state = get_state(variant.variant);
+                if (state.m_result != USIZE_MAX) continue;
+                state.m_result = result_indices[(usize)variant.result];
+                state.m_error = ErrCode(0);
+                state.m_error_message.clear();
+            }
+            return ok;
+        }
+        LUNA_SHADER_COMPILER_API R<Ref<IShaderVariantSet>> new_shader_variant_set(const ShaderVariantSetDesc& desc)
+        {
+            Ref<ShaderVariantSet> ret = new_object<ShaderVariantSet>();
+            lutry
+            {
+                luexp(ret->init(desc));
+            }
+            lucatchret;
+            return Ref<IShaderVariantSet>(ret);
+        }
+    }
+}
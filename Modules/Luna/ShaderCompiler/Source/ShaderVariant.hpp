@@ -0,0 +1,85 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ShaderVariant.hpp
+* @author JXMaster
+* @date 2024/4/15
+*/
+#pragma once
+#include "../ShaderVariant.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/UniquePtr.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+
+namespace Luna
+{
+    namespace ShaderCompiler
+    {
+        struct ShaderVariantState
+        {
+            // The index of the compile result in `ShaderVariantSet::m_results`, or `USIZE_MAX` if the variant is not compiled.
+            usize m_result = USIZE_MAX;
+            // The asynchronous compile job of the variant.
+            JobSystem::job_id_t m_job = JobSystem::INVALID_JOB_ID;
+            // The compile error of the variant. Failed variants are not compiled again.
+            ErrCode m_error = ErrCode(0);
+            String m_error_message;
+            // Whether the variant is requested by the user.
+            bool m_used = false;
+        };
+
+        struct ShaderVariantSet : IShaderVariantSet
+        {
+            lustruct("ShaderCompiler::ShaderVariantSet", "{B3E8D54A-27C1-4F96-8A0D-5E19C7462B83}");
+            luiimpl();
+
+            // `m_params.source`, `m_params.include_paths` and `m_params.definitions` refer to data owned by the variant set.
+            ShaderCompileParameters m_params;
+            Blob m_source;
+            Vector<Path> m_include_paths;
+            Vector<Pair<Name, Name>> m_definitions;
+            Vector<ShaderKeywordSetDesc> m_keyword_sets;
+            u64 m_num_variants = 1;
+            // The hash of the source, compile parameters and keyword sets, used to validate packs.
+            u64 m_desc_hash = 0;
+
+            Ref<IMutex> m_mtx;
+            HashMap<shader_variant_t, ShaderVariantState> m_variants;
+            // Unique compile results. Results are never removed, so pointers to results are valid until the variant set is destroyed.
+            Vector<UniquePtr<ShaderCompileResult>> m_results;
+            // Maps the hash of one compile result to indices of results with the same hash.
+            HashMap<u64, Vector<usize>> m_result_indices;
+            // Compilers not used by any thread.
+            Vector<Ref<ICompiler>> m_free_compilers;
+
+            RV init(const ShaderVariantSetDesc& desc);
+            // Gets the state of one variant, and creates the state if not exists. Must be called with `m_mtx` locked.
+            ShaderVariantState& get_state(shader_variant_t variant);
+            // Gets definitions used for compiling the specified variant.
+            void get_variant_definitions(shader_variant_t variant, Vector<Pair<Name, Name>>& definitions);
+            // Adds one compile result and returns its index. Returns the index of the existing result if one identical result
+            // is added before. Must be called with `m_mtx` locked.
+            usize add_result(ShaderCompileResult&& result);
+            Ref<ICompiler> acquire_compiler();
+            void release_compiler(Ref<ICompiler>&& compiler);
+            // Compiles the variant synchronously and records the result.
+            RV compile_variant(shader_variant_t variant);
+            // Gets the result of one variant whose compilation is finished. Must be called with `m_mtx` locked.
+            R<const ShaderCompileResult*> get_finished_variant(const ShaderVariantState& state);
+
+            virtual u64 get_num_variants() override { return m_num_variants; }
+            virtual shader_variant_t get_variant_key(Span<const Name> keywords) override;
+            virtual R<const ShaderCompileResult*> get_variant(shader_variant_t variant) override;
+            virtual R<const ShaderCompileResult*> get_variant_async(shader_variant_t variant, shader_variant_t fallback) override;
+            virtual bool is_variant_ready(shader_variant_t variant) override;
+            virtual void wait_async_compiles() override;
+            virtual Vector<shader_variant_t> get_used_variants() override;
+            virtual RV precompile(Span<const shader_variant_t> variants) override;
+            virtual R<Blob> save_pack() override;
+            virtual RV load_pack(Span<const byte_t> data) override;
+        };
+    }
+}
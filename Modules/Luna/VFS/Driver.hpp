@@ -97,6 +97,14 @@ namespace Luna
             //! @param[in] path The path to convert.
             //! @return Returns one path string that represents the converted native path.
             R<Name>(*on_get_native_path)(void* driver_data, void* mount_data, const Path& path);
+            //! Called when @ref VFS::map_file is called on one file that belongs to devices of this driver.
+            //! @details This callback is optional. If this is `nullptr`, @ref VFS::map_file opens the file using @ref on_open_file
+            //! and reads the file data to one memory buffer.
+            //! @param[in] driver_data The user-provided driver data.
+            //! @param[in] mount_data The mount data returned by @ref on_mount for the device.
+            //! @param[in] path The path of the file to map relative to the mount root path.
+            //! @return Returns the mapped file object.
+            R<Ref<IMappedFile>>(*on_map_file)(void* driver_data, void* mount_data, const Path& path) = nullptr;
         };
 
         //! Registers one new VFS driver to the system.
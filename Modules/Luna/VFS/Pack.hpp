@@ -0,0 +1,65 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Pack.hpp
+* @author JXMaster
+* @date 2024/3/23
+*/
+#pragma once
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/Result.hpp>
+
+#ifndef LUNA_VFS_API
+#define LUNA_VFS_API
+#endif
+
+namespace Luna
+{
+    namespace VFS
+    {
+        //! @addtogroup VFS
+        //! @{
+
+        //! Specifies the compression method of one file stored in one pack file.
+        enum class PackCompression : u32
+        {
+            //! The file is stored without compression.
+            none = 0,
+            //! The file is compressed using LZ4 block format.
+            lz4 = 1,
+        };
+
+        //! Describes how to create one pack file.
+        struct PackDesc
+        {
+            //! The compression method used for files in the pack.
+            //! @details Files are stored uncompressed if compression does not reduce the file size enough.
+            PackCompression compression = PackCompression::lz4;
+            //! The alignment of file data in the pack file. This must be power of two.
+            //! @details Set this to the page size if uncompressed files should be mapped at page boundaries.
+            u32 alignment = 16;
+        };
+
+        //! Creates one pack file from all files in one directory.
+        //! @details The pack file stores one table of contents sorted by the hash of file paths and the data of all files
+        //! in the directory and its subdirectories. The pack file can be mounted by the driver returned by @ref get_pack_driver.
+        //! @param[in] source_dir The path of the directory to pack.
+        //! @param[in] pack_path The path of the pack file to create. The pack file will be overwritten if it already exists.
+        //! @param[in] desc The pack creation parameters.
+        //! @par Possible Errors
+        //! * BasicError::bad_arguments
+        //! * BasicError::not_found
+        //! * BasicError::not_directory
+        //! * Errors returned by file operations.
+        LUNA_VFS_API RV create_pack(const Path& source_dir, const Path& pack_path, const PackDesc& desc = PackDesc());
+
+        //! Gets the name of the VFS driver that mounts one pack file created by @ref create_pack.
+        //! @details The driver path passed to @ref mount is the native path of the pack file. The mounted device is read-only.
+        //! @return Returns the name of the pack file driver.
+        LUNA_VFS_API Name get_pack_driver();
+
+        //! @}
+    }
+}
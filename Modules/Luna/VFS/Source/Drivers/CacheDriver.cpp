@@ -0,0 +1,392 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file CacheDriver.cpp
+* @author JXMaster
+* @date 2024/3/24
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_VFS_API LUNA_EXPORT
+#include "CacheDriver.hpp"
+#include "../VFS.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/List.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+
+namespace Luna
+{
+    namespace VFS
+    {
+        struct CachedFileData
+        {
+            lustruct("VFS::CachedFileData", "{f28c6d40-9b15-4e7a-a3d2-6e0b85f1c937}");
+
+            Blob m_data;
+        };
+
+        // One read-only file whose data is stored in the cache.
+        struct CachedFile : IFile
+        {
+            lustruct("VFS::CachedFile", "{85a3e1c6-0d4f-4b29-9e76-2c1f7b8d0a54}");
+            luiimpl();
+
+            // The cached data is shared by all files opened from the same cache entry, and is kept alive
+            // even if the entry is evicted.
+            Ref<CachedFileData> m_data;
+            u64 m_cursor = 0;
+
+            virtual RV read(void* buffer, usize size, usize* read_bytes) override
+            {
+                u64 file_size = m_data->m_data.size();
+                usize sz = m_cursor >= file_size ? 0 : (usize)min<u64>(size, file_size - m_cursor);
+                memcpy(buffer, m_data->m_data.span().data() + m_cursor, sz);
+                m_cursor += sz;
+                perf_counter_add(g_bytes_read_counter, (i64)sz);
+                if (read_bytes) *read_bytes = sz;
+                return ok;
+            }
+            virtual RV write(const void* buffer, usize size, usize* write_bytes) override
+            {
+                if (write_bytes) *write_bytes = 0;
+                return BasicError::access_denied();
+            }
+            virtual u64 get_size() override
+            {
+                return m_data->m_data.size();
+            }
+            virtual RV set_size(u64 sz) override
+            {
+                return BasicError::access_denied();
+            }
+            virtual R<u64> tell() override
+            {
+                return m_cursor;
+            }
+            virtual RV seek(i64 offset, SeekMode mode) override
+            {
+                i64 base = 0;
+                switch (mode)
+                {
+                case SeekMode::begin: base = 0; break;
+                case SeekMode::current: base = (i64)m_cursor; break;
+                case SeekMode::end: base = (i64)m_data->m_data.size(); break;
+                }
+                i64 cursor = base + offset;
+                if (cursor < 0) return BasicError::bad_arguments();
+                m_cursor = (u64)cursor;
+                return ok;
+            }
+            virtual void flush() override {}
+        };
+
+        struct CachedMappedFile : IMappedFile
+        {
+            lustruct("VFS::CachedMappedFile", "{1d7b4e2a-63c8-4f05-b9a1-e48f0c2d6b7e}");
+            luiimpl();
+
+            Ref<CachedFileData> m_data;
+
+            virtual const byte_t* get_data() override
+            {
+                return m_data->m_data.span().data();
+            }
+            virtual usize get_size() override
+            {
+                return m_data->m_data.size();
+            }
+        };
+
+        // One least recently used cache indexed by paths. Every entry has one cost, and least recently used entries
+        // are evicted when the total cost exceeds the limit.
+        template <typename _Ty>
+        struct CacheLRU
+        {
+            struct Entry
+            {
+                Path m_path;
+                _Ty m_value;
+                usize m_cost;
+            };
+            // The most recently used entry is at the front.
+            List<Entry> m_entries;
+            HashMap<Path, typename List<Entry>::iterator> m_index;
+            usize m_total_cost = 0;
+            usize m_max_cost = 0;
+
+            _Ty* find(const Path& path)
+            {
+                auto iter = m_index.find(path);
+                if (iter == m_index.end()) return nullptr;
+                if (iter->second != m_entries.begin())
+                {
+                    m_entries.splice(m_entries.begin(), m_entries, iter->second);
+                }
+                return &iter->second->m_value;
+            }
+            void insert(const Path& path, _Ty value, usize cost)
+            {
+                erase(path);
+                if (cost > m_max_cost) return;
+                Entry entry;
+                entry.m_path = path;
+                entry.m_value = move(value);
+                entry.m_cost = cost;
+                m_entries.push_front(move(entry));
+                m_index.insert(make_pair(path, m_entries.begin()));
+                m_total_cost += cost;
+                while (m_total_cost > m_max_cost)
+                {
+                    auto& last = m_entries.back();
+                    m_total_cost -= last.m_cost;
+                    m_index.erase(last.m_path);
+                    m_entries.pop_back();
+                }
+            }
+            void erase(const Path& path)
+            {
+                auto iter = m_index.find(path);
+                if (iter == m_index.end()) return;
+                m_total_cost -= iter->second->m_cost;
+                m_entries.erase(iter->second);
+                m_index.erase(iter);
+            }
+            void clear()
+            {
+                m_entries.clear();
+                m_index.clear();
+                m_total_cost = 0;
+            }
+        };
+
+        struct CachedAttribute
+        {
+            // `false` if the file does not exist.
+            bool m_found;
+            FileAttribute m_attribute;
+        };
+
+        struct CacheMountData
+        {
+            // The VFS path that this device caches.
+            Path m_target;
+            usize m_max_cached_file_size;
+            SpinLock m_lock;
+            CacheLRU<Ref<CachedFileData>> m_files;
+            CacheLRU<CachedAttribute> m_attributes;
+
+            Path make_target_path(const Path& path) const
+            {
+                Path ret = m_target;
+                ret.append(path);
+                return ret;
+            }
+            void invalidate(const Path& target_path)
+            {
+                LockGuard guard(m_lock);
+                m_files.erase(target_path);
+                m_attributes.erase(target_path);
+            }
+            void invalidate_all()
+            {
+                LockGuard guard(m_lock);
+                m_files.clear();
+                m_attributes.clear();
+            }
+        };
+
+        static R<void*> cache_mount(void* driver_data, const c8* driver_path, const Path& mount_dir, typeinfo_t params_type, void* params_data)
+        {
+            CacheMountDesc desc;
+            if (params_data) desc = *(const CacheMountDesc*)params_data;
+            CacheMountData* data = memnew<CacheMountData>();
+            data->m_target = driver_path;
+            data->m_max_cached_file_size = desc.max_cached_file_size;
+            data->m_files.m_max_cost = desc.max_file_data_size;
+            data->m_attributes.m_max_cost = desc.max_file_attributes;
+            return data;
+        }
+        static RV cache_unmount(void* driver_data, void* mount_data)
+        {
+            memdelete((CacheMountData*)mount_data);
+            return ok;
+        }
+        // Gets the file data from the cache, or reads the data from the target path and adds it to the cache.
+        // Returns `nullptr` if the file is too large to be cached, in which case `out_file` receives the opened target file.
+        static R<Ref<CachedFileData>> cache_load_file(CacheMountData* data, const Path& target_path, Ref<IFile>& out_file)
+        {
+            {
+                LockGuard guard(data->m_lock);
+                auto cached = data->m_files.find(target_path);
+                if (cached) return *cached;
+            }
+            Ref<CachedFileData> ret;
+            lutry
+            {
+                lulet(file, open_file(target_path, FileOpenFlag::read, FileCreationMode::open_existing));
+                if (file->get_size() > data->m_max_cached_file_size)
+                {
+                    out_file = file;
+                    return Ref<CachedFileData>();
+                }
+                ret = new_object<CachedFileData>();
+                luset(ret->m_data, load_file_data(file));
+                LockGuard guard(data->m_lock);
+                data->m_files.insert(target_path, ret, ret->m_data.size());
+            }
+            lucatchret;
+            return ret;
+        }
+        static R<Ref<IFile>> cache_open_file(void* driver_data, void* mount_data, const Path& path, FileOpenFlag flags, FileCreationMode creation)
+        {
+            auto data = (CacheMountData*)mount_data;
+            Path target_path = data->make_target_path(path);
+            if (test_flags(flags, FileOpenFlag::write) || creation != FileCreationMode::open_existing)
+            {
+                // Writing operations go to the target directly.
+                data->invalidate(target_path);
+                return open_file(target_path, flags, creation);
+            }
+            Ref<IFile> ret;
+            lutry
+            {
+                lulet(cached_data, cache_load_file(data, target_path, ret));
+                if (cached_data)
+                {
+                    Ref<CachedFile> file = new_object<CachedFile>();
+                    file->m_data = cached_data;
+                    ret = file;
+                }
+            }
+            lucatchret;
+            return ret;
+        }
+        static R<Ref<IMappedFile>> cache_map_file(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (CacheMountData*)mount_data;
+            Path target_path = data->make_target_path(path);
+            Ref<IMappedFile> ret;
+            lutry
+            {
+                Ref<IFile> file;
+                lulet(cached_data, cache_load_file(data, target_path, file));
+                if (cached_data)
+                {
+                    Ref<CachedMappedFile> mapped = new_object<CachedMappedFile>();
+                    mapped->m_data = cached_data;
+                    ret = mapped;
+                }
+                else
+                {
+                    // Large files are mapped by the target driver.
+                    file = nullptr;
+                    luset(ret, map_file(target_path));
+                }
+            }
+            lucatchret;
+            return ret;
+        }
+        static R<FileAttribute> cache_get_file_attribute(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (CacheMountData*)mount_data;
+            Path target_path = data->make_target_path(path);
+            {
+                LockGuard guard(data->m_lock);
+                auto cached = data->m_attributes.find(target_path);
+                if (cached)
+                {
+                    if (!cached->m_found) return BasicError::not_found();
+                    return cached->m_attribute;
+                }
+            }
+            auto r = get_file_attribute(target_path);
+            CachedAttribute attribute;
+            if (succeeded(r))
+            {
+                attribute.m_found = true;
+                attribute.m_attribute = r.get();
+            }
+            else if (r.errcode() == BasicError::not_found())
+            {
+                // Caches missing files as well, since checking whether one file exists is a common operation.
+                attribute.m_found = false;
+            }
+            else
+            {
+                return r;
+            }
+            LockGuard guard(data->m_lock);
+            data->m_attributes.insert(target_path, attribute, 1);
+            return r;
+        }
+        static RV cache_copy_file(void* driver_data, void* from_mount_data, void* to_mount_data, const Path& from_path, const Path& to_path, FileCopyFlag flags)
+        {
+            auto from_data = (CacheMountData*)from_mount_data;
+            auto to_data = (CacheMountData*)to_mount_data;
+            Path to_target_path = to_data->make_target_path(to_path);
+            to_data->invalidate(to_target_path);
+            return copy_file(from_data->make_target_path(from_path), to_target_path, flags);
+        }
+        static RV cache_move_file(void* driver_data, void* from_mount_data, void* to_mount_data, const Path& from_path, const Path& to_path, FileMoveFlag flags)
+        {
+            auto from_data = (CacheMountData*)from_mount_data;
+            auto to_data = (CacheMountData*)to_mount_data;
+            // The moved path may be one directory, so all cached entries of the source device are invalidated.
+            from_data->invalidate_all();
+            Path to_target_path = to_data->make_target_path(to_path);
+            to_data->invalidate(to_target_path);
+            return move_file(from_data->make_target_path(from_path), to_target_path, flags);
+        }
+        static RV cache_delete_file(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (CacheMountData*)mount_data;
+            data->invalidate_all();
+            return delete_file(data->make_target_path(path));
+        }
+        static R<Ref<IFileIterator>> cache_open_dir(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (CacheMountData*)mount_data;
+            return open_dir(data->make_target_path(path));
+        }
+        static RV cache_create_dir(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (CacheMountData*)mount_data;
+            Path target_path = data->make_target_path(path);
+            data->invalidate(target_path);
+            return create_dir(target_path);
+        }
+        static R<Name> cache_get_native_path(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (CacheMountData*)mount_data;
+            return get_native_path(data->make_target_path(path));
+        }
+        void register_cache_driver()
+        {
+            register_boxed_type<CachedFileData>();
+            register_boxed_type<CachedFile>();
+            impl_interface_for_type<CachedFile, IFile, ISeekableStream, IStream>();
+            register_boxed_type<CachedMappedFile>();
+            impl_interface_for_type<CachedMappedFile, IMappedFile>();
+            DriverDesc desc;
+            desc.driver_data = nullptr;
+            desc.on_driver_unregister = nullptr;
+            desc.on_mount = cache_mount;
+            desc.on_unmount = cache_unmount;
+            desc.on_open_file = cache_open_file;
+            desc.on_get_file_attribute = cache_get_file_attribute;
+            desc.on_copy_file = cache_copy_file;
+            desc.on_move_file = cache_move_file;
+            desc.on_delete_file = cache_delete_file;
+            desc.on_open_dir = cache_open_dir;
+            desc.on_create_dir = cache_create_dir;
+            desc.on_get_native_path = cache_get_native_path;
+            desc.on_map_file = cache_map_file;
+            register_driver(get_cache_driver(), desc);
+        }
+        LUNA_VFS_API Name get_cache_driver()
+        {
+            return "Cache";
+        }
+    }
+}
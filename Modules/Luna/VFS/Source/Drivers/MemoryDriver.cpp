@@ -0,0 +1,455 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file MemoryDriver.cpp
+* @author JXMaster
+* @date 2024/3/24
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_VFS_API LUNA_EXPORT
+#include "MemoryDriver.hpp"
+#include "../VFS.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Time.hpp>
+
+namespace Luna
+{
+    namespace VFS
+    {
+        struct MemoryFileData
+        {
+            lustruct("VFS::MemoryFileData", "{3e8b1f07-5c2a-4d96-b7e4-a0f6d2c95e13}");
+
+            Vector<byte_t> m_data;
+            i64 m_last_write_time;
+        };
+
+        struct MemoryNode
+        {
+            // The file data, `nullptr` if this node is a directory.
+            Ref<MemoryFileData> m_file;
+            // The names of child nodes if this node is a directory.
+            Vector<Name> m_children;
+            i64 m_creation_time;
+        };
+
+        struct MemoryMountData
+        {
+            // Locks the node tree and data of all files in the device.
+            Ref<IMutex> m_mutex;
+            // Nodes indexed by their paths relative to the device root. The root directory is indexed by one empty path.
+            HashMap<Path, MemoryNode> m_nodes;
+
+            MemoryNode* find_node(const Path& path)
+            {
+                auto iter = m_nodes.find(path);
+                return iter == m_nodes.end() ? nullptr : &iter->second;
+            }
+        };
+
+        struct MemoryFile : IFile
+        {
+            lustruct("VFS::MemoryFile", "{b5d07e94-1a3c-4f62-8e0d-c7294f6b1a85}");
+            luiimpl();
+
+            Ref<IMutex> m_mutex;
+            Ref<MemoryFileData> m_data;
+            FileOpenFlag m_flags;
+            u64 m_cursor = 0;
+
+            virtual RV read(void* buffer, usize size, usize* read_bytes) override
+            {
+                if (read_bytes) *read_bytes = 0;
+                if (!test_flags(m_flags, FileOpenFlag::read)) return BasicError::access_denied();
+                MutexGuard guard(m_mutex);
+                u64 file_size = m_data->m_data.size();
+                usize sz = m_cursor >= file_size ? 0 : (usize)min<u64>(size, file_size - m_cursor);
+                memcpy(buffer, m_data->m_data.data() + m_cursor, sz);
+                m_cursor += sz;
+                perf_counter_add(g_bytes_read_counter, (i64)sz);
+                if (read_bytes) *read_bytes = sz;
+                return ok;
+            }
+            virtual RV write(const void* buffer, usize size, usize* write_bytes) override
+            {
+                if (write_bytes) *write_bytes = 0;
+                if (!test_flags(m_flags, FileOpenFlag::write)) return BasicError::access_denied();
+                MutexGuard guard(m_mutex);
+                auto& data = m_data->m_data;
+                if (m_cursor + size > data.size()) data.resize((usize)(m_cursor + size), 0);
+                memcpy(data.data() + m_cursor, buffer, size);
+                m_cursor += size;
+                m_data->m_last_write_time = get_utc_timestamp();
+                if (write_bytes) *write_bytes = size;
+                return ok;
+            }
+            virtual u64 get_size() override
+            {
+                MutexGuard guard(m_mutex);
+                return m_data->m_data.size();
+            }
+            virtual RV set_size(u64 sz) override
+            {
+                if (!test_flags(m_flags, FileOpenFlag::write)) return BasicError::access_denied();
+                MutexGuard guard(m_mutex);
+                m_data->m_data.resize((usize)sz, 0);
+                m_data->m_last_write_time = get_utc_timestamp();
+                return ok;
+            }
+            virtual R<u64> tell() override
+            {
+                return m_cursor;
+            }
+            virtual RV seek(i64 offset, SeekMode mode) override
+            {
+                i64 base = 0;
+                switch (mode)
+                {
+                case SeekMode::begin: base = 0; break;
+                case SeekMode::current: base = (i64)m_cursor; break;
+                case SeekMode::end: base = (i64)get_size(); break;
+                }
+                i64 cursor = base + offset;
+                if (cursor < 0) return BasicError::bad_arguments();
+                m_cursor = (u64)cursor;
+                return ok;
+            }
+            virtual void flush() override {}
+        };
+
+        struct MemoryDirChild
+        {
+            Name m_name;
+            FileAttributeFlag m_attributes;
+        };
+
+        struct MemoryFileIterator : IFileIterator
+        {
+            lustruct("VFS::MemoryFileIterator", "{6c2fa81d-e937-4b05-9d48-3b1e7f05c6a2}");
+            luiimpl();
+
+            // Children are copied when the directory is opened, so later changes to the directory are not visible.
+            Vector<MemoryDirChild> m_children;
+            usize m_index = 0;
+
+            virtual bool is_valid() override
+            {
+                return m_index < m_children.size();
+            }
+            virtual const c8* get_filename() override
+            {
+                return is_valid() ? m_children[m_index].m_name.c_str() : nullptr;
+            }
+            virtual FileAttributeFlag get_attributes() override
+            {
+                return is_valid() ? m_children[m_index].m_attributes : FileAttributeFlag::none;
+            }
+            virtual bool move_next() override
+            {
+                if (is_valid()) ++m_index;
+                return is_valid();
+            }
+        };
+
+        // Removes the root name and flags of the path so that the same node always has the same key.
+        static Path make_memory_key(const Path& path)
+        {
+            Path ret;
+            for (auto& node : path)
+            {
+                ret.push_back(node);
+            }
+            return ret;
+        }
+
+        static R<MemoryNode*> create_memory_node(MemoryMountData* data, const Path& key, bool directory)
+        {
+            if (key.empty()) return BasicError::already_exists();
+            if (data->find_node(key)) return BasicError::already_exists();
+            Path parent_key = key;
+            parent_key.pop_back();
+            MemoryNode* parent = data->find_node(parent_key);
+            if (!parent) return BasicError::not_found();
+            if (parent->m_file) return BasicError::not_directory();
+            parent->m_children.push_back(key.back());
+            MemoryNode node;
+            node.m_creation_time = get_utc_timestamp();
+            if (!directory)
+            {
+                node.m_file = new_object<MemoryFileData>();
+                node.m_file->m_last_write_time = node.m_creation_time;
+            }
+            auto iter = data->m_nodes.insert(make_pair(key, move(node))).first;
+            return &iter->second;
+        }
+
+        static void remove_memory_node(MemoryMountData* data, const Path& key)
+        {
+            // Removes all children first.
+            MemoryNode* node = data->find_node(key);
+            Vector<Name> children = move(node->m_children);
+            for (auto& child : children)
+            {
+                Path child_key = key;
+                child_key.push_back(child);
+                remove_memory_node(data, child_key);
+            }
+            data->m_nodes.erase(key);
+            Path parent_key = key;
+            parent_key.pop_back();
+            MemoryNode* parent = data->find_node(parent_key);
+            if (parent)
+            {
+                for (auto iter = parent->m_children.begin(); iter != parent->m_children.end(); ++iter)
+                {
+                    if (*iter == key.back())
+                    {
+                        parent->m_children.erase(iter);
+                        break;
+                    }
+                }
+            }
+        }
+
+        static R<void*> memory_mount(void* driver_data, const c8* driver_path, const Path& mount_dir, typeinfo_t params_type, void* params_data)
+        {
+            MemoryMountData* data = memnew<MemoryMountData>();
+            data->m_mutex = new_mutex();
+            MemoryNode root;
+            root.m_creation_time = get_utc_timestamp();
+            data->m_nodes.insert(make_pair(Path(), move(root)));
+            return data;
+        }
+        static RV memory_unmount(void* driver_data, void* mount_data)
+        {
+            memdelete((MemoryMountData*)mount_data);
+            return ok;
+        }
+        static R<Ref<IFile>> memory_open_file(void* driver_data, void* mount_data, const Path& path, FileOpenFlag flags, FileCreationMode creation)
+        {
+            auto data = (MemoryMountData*)mount_data;
+            if (!test_flags(flags, FileOpenFlag::read) && !test_flags(flags, FileOpenFlag::write)) return BasicError::bad_arguments();
+            Path key = make_memory_key(path);
+            MutexGuard guard(data->m_mutex);
+            MemoryNode* node = data->find_node(key);
+            if (node && !node->m_file) return BasicError::is_directory();
+            Ref<MemoryFileData> file_data;
+            lutry
+            {
+                switch (creation)
+                {
+                case FileCreationMode::create_always:
+                case FileCreationMode::open_always:
+                    if (!node)
+                    {
+                        luset(node, create_memory_node(data, key, false));
+                    }
+                    else if (creation == FileCreationMode::create_always)
+                    {
+                        node->m_file->m_data.clear();
+                        node->m_file->m_last_write_time = get_utc_timestamp();
+                    }
+                    break;
+                case FileCreationMode::create_new:
+                    if (node) return BasicError::already_exists();
+                    luset(node, create_memory_node(data, key, false));
+                    break;
+                case FileCreationMode::open_existing:
+                case FileCreationMode::open_existing_as_new:
+                    if (!node) return BasicError::not_found();
+                    if (creation == FileCreationMode::open_existing_as_new)
+                    {
+                        node->m_file->m_data.clear();
+                        node->m_file->m_last_write_time = get_utc_timestamp();
+                    }
+                    break;
+                }
+                file_data = node->m_file;
+            }
+            lucatchret;
+            Ref<MemoryFile> file = new_object<MemoryFile>();
+            file->m_mutex = data->m_mutex;
+            file->m_data = file_data;
+            file->m_flags = flags;
+            return Ref<IFile>(file);
+        }
+        static R<FileAttribute> memory_get_file_attribute(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (MemoryMountData*)mount_data;
+            Path key = make_memory_key(path);
+            MutexGuard guard(data->m_mutex);
+            MemoryNode* node = data->find_node(key);
+            if (!node) return BasicError::not_found();
+            FileAttribute attribute;
+            attribute.creation_time = node->m_creation_time;
+            if (node->m_file)
+            {
+                attribute.size = node->m_file->m_data.size();
+                attribute.last_write_time = node->m_file->m_last_write_time;
+                attribute.attributes = FileAttributeFlag::none;
+            }
+            else
+            {
+                attribute.size = 0;
+                attribute.last_write_time = node->m_creation_time;
+                attribute.attributes = FileAttributeFlag::directory;
+            }
+            attribute.last_access_time = attribute.last_write_time;
+            return attribute;
+        }
+        static RV memory_copy_file(void* driver_data, void* from_mount_data, void* to_mount_data, const Path& from_path, const Path& to_path, FileCopyFlag flags)
+        {
+            auto from_data = (MemoryMountData*)from_mount_data;
+            auto to_data = (MemoryMountData*)to_mount_data;
+            Path from_key = make_memory_key(from_path);
+            Path to_key = make_memory_key(to_path);
+            // Copies data out first, so that two devices are never locked at the same time.
+            Vector<byte_t> file_data;
+            {
+                MutexGuard guard(from_data->m_mutex);
+                MemoryNode* node = from_data->find_node(from_key);
+                if (!node) return BasicError::not_found();
+                if (!node->m_file) return BasicError::is_directory();
+                file_data = node->m_file->m_data;
+            }
+            MutexGuard guard(to_data->m_mutex);
+            MemoryNode* node = to_data->find_node(to_key);
+            if (node)
+            {
+                if (test_flags(flags, FileCopyFlag::fail_if_exists)) return BasicError::already_exists();
+                if (!node->m_file) return BasicError::is_directory();
+            }
+            else
+            {
+                lutry
+                {
+                    luset(node, create_memory_node(to_data, to_key, false));
+                }
+                lucatchret;
+            }
+            node->m_file->m_data = move(file_data);
+            node->m_file->m_last_write_time = get_utc_timestamp();
+            return ok;
+        }
+        static RV memory_delete_file(void* driver_data, void* mount_data, const Path& path);
+        static RV memory_move_file(void* driver_data, void* from_mount_data, void* to_mount_data, const Path& from_path, const Path& to_path, FileMoveFlag flags)
+        {
+            auto from_data = (MemoryMountData*)from_mount_data;
+            auto to_data = (MemoryMountData*)to_mount_data;
+            Path from_key = make_memory_key(from_path);
+            Path to_key = make_memory_key(to_path);
+            if (from_data == to_data)
+            {
+                MutexGuard guard(from_data->m_mutex);
+                MemoryNode* node = from_data->find_node(from_key);
+                if (!node) return BasicError::not_found();
+                if (!node->m_file) return BasicError::not_supported();
+                Ref<MemoryFileData> file = node->m_file;
+                MemoryNode* dst = from_data->find_node(to_key);
+                if (dst)
+                {
+                    if (test_flags(flags, FileMoveFlag::fail_if_exists)) return BasicError::already_exists();
+                    if (!dst->m_file) return BasicError::is_directory();
+                    if (dst == node) return ok;
+                    dst->m_file = file;
+                }
+                else
+                {
+                    auto r = create_memory_node(from_data, to_key, false);
+                    if (failed(r)) return r.errcode();
+                    dst = r.get();
+                    dst->m_file = file;
+                }
+                remove_memory_node(from_data, from_key);
+                return ok;
+            }
+            lutry
+            {
+                luexp(memory_copy_file(driver_data, from_mount_data, to_mount_data, from_path, to_path,
+                    test_flags(flags, FileMoveFlag::fail_if_exists) ? FileCopyFlag::fail_if_exists : FileCopyFlag::none));
+                luexp(memory_delete_file(driver_data, from_mount_data, from_path));
+            }
+            lucatchret;
+            return ok;
+        }
+        static RV memory_delete_file(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (MemoryMountData*)mount_data;
+            Path key = make_memory_key(path);
+            if (key.empty()) return BasicError::access_denied();
+            MutexGuard guard(data->m_mutex);
+            MemoryNode* node = data->find_node(key);
+            if (!node) return BasicError::not_found();
+            if (!node->m_file && !node->m_children.empty()) return BasicError::directory_not_empty();
+            remove_memory_node(data, key);
+            return ok;
+        }
+        static R<Ref<IFileIterator>> memory_open_dir(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (MemoryMountData*)mount_data;
+            Path key = make_memory_key(path);
+            MutexGuard guard(data->m_mutex);
+            MemoryNode* node = data->find_node(key);
+            if (!node) return BasicError::not_found();
+            if (node->m_file) return BasicError::not_directory();
+            Ref<MemoryFileIterator> iter = new_object<MemoryFileIterator>();
+            iter->m_children.reserve(node->m_children.size());
+            for (auto& name : node->m_children)
+            {
+                Path child_key = key;
+                child_key.push_back(name);
+                MemoryNode* child = data->find_node(child_key);
+                MemoryDirChild c;
+                c.m_name = name;
+                c.m_attributes = child->m_file ? FileAttributeFlag::none : FileAttributeFlag::directory;
+                iter->m_children.push_back(c);
+            }
+            return Ref<IFileIterator>(iter);
+        }
+        static RV memory_create_dir(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (MemoryMountData*)mount_data;
+            Path key = make_memory_key(path);
+            MutexGuard guard(data->m_mutex);
+            lutry
+            {
+                luexp(create_memory_node(data, key, true));
+            }
+            lucatchret;
+            return ok;
+        }
+        static R<Name> memory_get_native_path(void* driver_data, void* mount_data, const Path& path)
+        {
+            return BasicError::not_supported();
+        }
+        void register_memory_driver()
+        {
+            register_boxed_type<MemoryFileData>();
+            register_boxed_type<MemoryFile>();
+            impl_interface_for_type<MemoryFile, IFile, ISeekableStream, IStream>();
+            register_boxed_type<MemoryFileIterator>();
+            impl_interface_for_type<MemoryFileIterator, IFileIterator>();
+            DriverDesc desc;
+            desc.driver_data = nullptr;
+            desc.on_driver_unregister = nullptr;
+            desc.on_mount = memory_mount;
+            desc.on_unmount = memory_unmount;
+            desc.on_open_file = memory_open_file;
+            desc.on_get_file_attribute = memory_get_file_attribute;
+            desc.on_copy_file = memory_copy_file;
+            desc.on_move_file = memory_move_file;
+            desc.on_delete_file = memory_delete_file;
+            desc.on_open_dir = memory_open_dir;
+            desc.on_create_dir = memory_create_dir;
+            desc.on_get_native_path = memory_get_native_path;
+            register_driver(get_memory_driver(), desc);
+        }
+        LUNA_VFS_API Name get_memory_driver()
+        {
+            return "Memory";
+        }
+    }
+}
@@ -0,0 +1,19 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file MemoryDriver.hpp
+* @author JXMaster
+* @date 2024/3/24
+*/
+#pragma once
+#include <Luna/Runtime/Base.hpp>
+
+namespace Luna
+{
+    namespace VFS
+    {
+        void register_memory_driver();
+    }
+}
@@ -0,0 +1,531 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PackDriver.cpp
+* @author JXMaster
+* @date 2024/3/23
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_VFS_API LUNA_EXPORT
+#include "PackDriver.hpp"
+#include <Luna/Runtime/LZ4.hpp>
+#include "../VFS.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
+
+namespace Luna
+{
+    namespace VFS
+    {
+        // One read-only file opened from one pack.
+        struct PackFile : IFile
+        {
+            lustruct("VFS::PackFile", "{0b6e3d2f-94a1-4c7e-8f53-e2a7d81c6b90}");
+            luiimpl();
+
+            // Keeps the pack mapped if the data is read from the pack directly.
+            Ref<IMappedFile> m_pack;
+            // Stores the decompressed data if the file is compressed.
+            Blob m_buffer;
+            const byte_t* m_data = nullptr;
+            u64 m_size = 0;
+            u64 m_cursor = 0;
+
+            virtual RV read(void* buffer, usize size, usize* read_bytes) override
+            {
+                usize sz = m_cursor >= m_size ? 0 : (usize)min<u64>(size, m_size - m_cursor);
+                memcpy(buffer, m_data + m_cursor, sz);
+                m_cursor += sz;
+                perf_counter_add(g_bytes_read_counter, (i64)sz);
+                if (read_bytes) *read_bytes = sz;
+                return ok;
+            }
+            virtual RV write(const void* buffer, usize size, usize* write_bytes) override
+            {
+                if (write_bytes) *write_bytes = 0;
+                return BasicError::not_supported();
+            }
+            virtual u64 get_size() override
+            {
+                return m_size;
+            }
+            virtual RV set_size(u64 sz) override
+            {
+                return BasicError::not_supported();
+            }
+            virtual R<u64> tell() override
+            {
+                return m_cursor;
+            }
+            virtual RV seek(i64 offset, SeekMode mode) override
+            {
+                i64 base = 0;
+                switch (mode)
+                {
+                case SeekMode::begin: base = 0; break;
+                case SeekMode::current: base = (i64)m_cursor; break;
+                case SeekMode::end: base = (i64)m_size; break;
+                }
+                i64 cursor = base + offset;
+                if (cursor < 0) return BasicError::bad_arguments();
+                m_cursor = (u64)cursor;
+                return ok;
+            }
+            virtual void flush() override {}
+        };
+
+        // One mapped view of one uncompressed file in the pack.
+        struct PackMappedFile : IMappedFile
+        {
+            lustruct("VFS::PackMappedFile", "{c4f18a65-2b07-4d93-a6e1-5f90b3d72c48}");
+            luiimpl();
+
+            Ref<IMappedFile> m_pack;
+            const byte_t* m_data = nullptr;
+            usize m_size = 0;
+
+            virtual const byte_t* get_data() override
+            {
+                return m_data;
+            }
+            virtual usize get_size() override
+            {
+                return m_size;
+            }
+        };
+
+        struct PackDirChild
+        {
+            Name m_name;
+            bool m_directory;
+        };
+
+        struct PackFileIterator : IFileIterator
+        {
+            lustruct("VFS::PackFileIterator", "{7a93e5b1-d06c-4f28-b4a7-19c8e3f65d02}");
+            luiimpl();
+
+            Vector<PackDirChild> m_children;
+            usize m_index = 0;
+
+            virtual bool is_valid() override
+            {
+                return m_index < m_children.size();
+            }
+            virtual const c8* get_filename() override
+            {
+                return is_valid() ? m_children[m_index].m_name.c_str() : nullptr;
+            }
+            virtual FileAttributeFlag get_attributes() override
+            {
+                if (!is_valid()) return FileAttributeFlag::none;
+                return m_children[m_index].m_directory ?
+                    FileAttributeFlag::directory | FileAttributeFlag::read_only : FileAttributeFlag::read_only;
+            }
+            virtual bool move_next() override
+            {
+                if (is_valid()) ++m_index;
+                return is_valid();
+            }
+        };
+
+        struct PackMountData
+        {
+            Ref<IMappedFile> m_pack;
+            const PackEntry* m_entries;
+            u32 m_entry_count;
+            const c8* m_names;
+            // Children of every directory in the pack, indexed by the directory path. The root directory is indexed by one empty name.
+            HashMap<Name, Vector<PackDirChild>> m_dirs;
+
+            const PackEntry* find_entry(const String& name) const
+            {
+                u64 hash = pack_name_hash(name.c_str(), name.size());
+                auto iter = lower_bound(m_entries, m_entries + m_entry_count, hash,
+                    [](const PackEntry& entry, u64 hash) { return entry.name_hash < hash; });
+                while (iter != m_entries + m_entry_count && iter->name_hash == hash)
+                {
+                    if (iter->name_size == name.size() && !memcmp(m_names + iter->name_offset, name.c_str(), name.size()))
+                    {
+                        return iter;
+                    }
+                    ++iter;
+                }
+                return nullptr;
+            }
+        };
+
+        // Converts one path relative to the pack root to the name stored in the pack.
+        static String make_pack_name(const Path& path)
+        {
+            String ret;
+            for (usize i = 0; i < path.size(); ++i)
+            {
+                if (i) ret.push_back('/');
+                ret.append(path[i].c_str());
+            }
+            return ret;
+        }
+
+        inline bool pack_range_valid(u64 offset, u64 size, u64 total)
+        {
+            return offset <= total && size <= total - offset;
+        }
+
+        static R<void*> pack_mount(void* driver_data, const c8* driver_path, const Path& mount_dir, typeinfo_t params_type, void* params_data)
+        {
+            PackMountData* data = nullptr;
+            lutry
+            {
+                lulet(pack, Luna::map_file(driver_path));
+                const byte_t* pack_data = pack->get_data();
+                u64 pack_size = pack->get_size();
+                if (pack_size < sizeof(PackHeader)) return BasicError::format_error();
+                const PackHeader* header = (const PackHeader*)pack_data;
+                if (header->magic != PACK_MAGIC) return BasicError::format_error();
+                if (header->version != PACK_VERSION) return BasicError::version_dismatch();
+                if ((header->entries_offset % alignof(PackEntry)) ||
+                    !pack_range_valid(header->entries_offset, (u64)header->entry_count * sizeof(PackEntry), pack_size) ||
+                    !pack_range_valid(header->names_offset, header->names_size, pack_size))
+                {
+                    return BasicError::format_error();
+                }
+                const PackEntry* entries = (const PackEntry*)(pack_data + header->entries_offset);
+                const c8* names = (const c8*)(pack_data + header->names_offset);
+                for (u32 i = 0; i < header->entry_count; ++i)
+                {
+                    const PackEntry& entry = entries[i];
+                    if (!pack_range_valid(entry.name_offset, entry.name_size, header->names_size) ||
+                        !pack_range_valid(entry.data_offset, entry.stored_size, pack_size) ||
+                        (entry.compression != PackCompression::none && entry.compression != PackCompression::lz4) ||
+                        (entry.compression == PackCompression::none && entry.stored_size != entry.size))
+                    {
+                        return BasicError::format_error();
+                    }
+                }
+                data = memnew<PackMountData>();
+                data->m_pack = pack;
+                data->m_entries = entries;
+                data->m_entry_count = header->entry_count;
+                data->m_names = names;
+                // Builds the directory tree from file names.
+                data->m_dirs.insert(make_pair(Name(""), Vector<PackDirChild>()));
+                for (u32 i = 0; i < header->entry_count; ++i)
+                {
+                    const c8* name = names + entries[i].name_offset;
+                    usize name_size = entries[i].name_size;
+                    usize node_begin = 0;
+                    Name parent = "";
+                    for (usize j = 0; j <= name_size; ++j)
+                    {
+                        if (j != name_size && name[j] != '/') continue;
+                        PackDirChild child;
+                        child.m_name = Name(name + node_begin, j - node_begin);
+                        child.m_directory = j != name_size;
+                        if (child.m_directory)
+                        {
+                            Name dir = Name(name, j);
+                            if (data->m_dirs.find(dir) == data->m_dirs.end())
+                            {
+                                data->m_dirs.insert(make_pair(dir, Vector<PackDirChild>()));
+                                data->m_dirs.find(parent)->second.push_back(child);
+                            }
+                            parent = dir;
+                        }
+                        else
+                        {
+                            data->m_dirs.find(parent)->second.push_back(child);
+                        }
+                        node_begin = j + 1;
+                    }
+                }
+            }
+            lucatchret;
+            return data;
+        }
+        static RV pack_unmount(void* driver_data, void* mount_data)
+        {
+            memdelete((PackMountData*)mount_data);
+            return ok;
+        }
+        static R<const PackEntry*> pack_find_file(PackMountData* data, const Path& path)
+        {
+            String name = make_pack_name(path);
+            const PackEntry* entry = data->find_entry(name);
+            if (!entry)
+            {
+                if (data->m_dirs.find(Name(name)) != data->m_dirs.end()) return BasicError::is_directory();
+                return BasicError::not_found();
+            }
+            return entry;
+        }
+        static RV pack_decompress(PackMountData* data, const PackEntry* entry, Blob& buffer)
+        {
+            buffer.resize((usize)entry->size);
+            if (!LZ4::decompress(data->m_pack->get_data() + entry->data_offset, (usize)entry->stored_size, buffer.span().data(), buffer.size()))
+            {
+                return BasicError::bad_data();
+            }
+            return ok;
+        }
+        static R<Ref<IFile>> pack_open_file(void* driver_data, void* mount_data, const Path& path, FileOpenFlag flags, FileCreationMode creation)
+        {
+            auto data = (PackMountData*)mount_data;
+            if (test_flags(flags, FileOpenFlag::write)) return BasicError::access_denied();
+            if (creation != FileCreationMode::open_existing && creation != FileCreationMode::open_always) return BasicError::access_denied();
+            Ref<IFile> ret;
+            lutry
+            {
+                lulet(entry, pack_find_file(data, path));
+                Ref<PackFile> file = new_object<PackFile>();
+                if (entry->compression == PackCompression::none)
+                {
+                    file->m_pack = data->m_pack;
+                    file->m_data = data->m_pack->get_data() + entry->data_offset;
+                }
+                else
+                {
+                    luexp(pack_decompress(data, entry, file->m_buffer));
+                    file->m_data = file->m_buffer.span().data();
+                }
+                file->m_size = entry->size;
+                ret = file;
+            }
+            lucatchret;
+            return ret;
+        }
+        static R<Ref<IMappedFile>> pack_map_file(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (PackMountData*)mount_data;
+            Ref<IMappedFile> ret;
+            lutry
+            {
+                lulet(entry, pack_find_file(data, path));
+                if (entry->compression == PackCompression::none)
+                {
+                    // Uncompressed files are mapped directly from the pack.
+                    Ref<PackMappedFile> file = new_object<PackMappedFile>();
+                    file->m_pack = data->m_pack;
+                    file->m_data = data->m_pack->get_data() + entry->data_offset;
+                    file->m_size = (usize)entry->size;
+                    ret = file;
+                }
+                else
+                {
+                    Ref<BufferedMappedFile> file = new_object<BufferedMappedFile>();
+                    luexp(pack_decompress(data, entry, file->m_data));
+                    ret = file;
+                }
+            }
+            lucatchret;
+            return ret;
+        }
+        static R<FileAttribute> pack_get_file_attribute(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (PackMountData*)mount_data;
+            String name = make_pack_name(path);
+            FileAttribute attribute;
+            memzero(&attribute);
+            const PackEntry* entry = data->find_entry(name);
+            if (entry)
+            {
+                attribute.size = entry->size;
+                attribute.attributes = FileAttributeFlag::read_only;
+                return attribute;
+            }
+            if (data->m_dirs.find(Name(name)) != data->m_dirs.end())
+            {
+                attribute.attributes = FileAttributeFlag::directory | FileAttributeFlag::read_only;
+                return attribute;
+            }
+            return BasicError::not_found();
+        }
+        static RV pack_copy_file(void* driver_data, void* from_mount_data, void* to_mount_data, const Path& from_path, const Path& to_path, FileCopyFlag flags)
+        {
+            return BasicError::access_denied();
+        }
+        static RV pack_move_file(void* driver_data, void* from_mount_data, void* to_mount_data, const Path& from_path, const Path& to_path, FileMoveFlag flags)
+        {
+            return BasicError::access_denied();
+        }
+        static RV pack_delete_file(void* driver_data, void* mount_data, const Path& path)
+        {
+            return BasicError::access_denied();
+        }
+        static R<Ref<IFileIterator>> pack_open_dir(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (PackMountData*)mount_data;
+            auto iter = data->m_dirs.find(Name(make_pack_name(path)));
+            if (iter == data->m_dirs.end())
+            {
+                if (data->find_entry(make_pack_name(path))) return BasicError::not_directory();
+                return BasicError::not_found();
+            }
+            Ref<PackFileIterator> ret = new_object<PackFileIterator>();
+            ret->m_children = iter->second;
+            return Ref<IFileIterator>(ret);
+        }
+        static RV pack_create_dir(void* driver_data, void* mount_data, const Path& path)
+        {
+            return BasicError::access_denied();
+        }
+        static R<Name> pack_get_native_path(void* driver_data, void* mount_data, const Path& path)
+        {
+            return BasicError::not_supported();
+        }
+        void register_pack_driver()
+        {
+            register_boxed_type<PackFile>();
+            impl_interface_for_type<PackFile, IFile, ISeekableStream, IStream>();
+            register_boxed_type<PackMappedFile>();
+            impl_interface_for_type<PackMappedFile, IMappedFile>();
+            register_boxed_type<PackFileIterator>();
+            impl_interface_for_type<PackFileIterator, IFileIterator>();
+            DriverDesc desc;
+            desc.driver_data = nullptr;
+            desc.on_driver_unregister = nullptr;
+            desc.on_mount = pack_mount;
+            desc.on_unmount = pack_unmount;
+            desc.on_open_file = pack_open_file;
+            desc.on_get_file_attribute = pack_get_file_attribute;
+            desc.on_copy_file = pack_copy_file;
+            desc.on_move_file = pack_move_file;
+            desc.on_delete_file = pack_delete_file;
+            desc.on_open_dir = pack_open_dir;
+            desc.on_create_dir = pack_create_dir;
+            desc.on_get_native_path = pack_get_native_path;
+            desc.on_map_file = pack_map_file;
+            register_driver(get_pack_driver(), desc);
+        }
+        LUNA_VFS_API Name get_pack_driver()
+        {
+            return "Pack";
+        }
+
+        struct PackSourceFile
+        {
+            String m_name;
+            Path m_path;
+        };
+        static RV collect_pack_files(const Path& dir, const Path& source_dir, Vector<PackSourceFile>& files)
+        {
+            lutry
+            {
+                lulet(iter, open_dir(dir));
+                while (iter->is_valid())
+                {
+                    Path path = dir;
+                    path.push_back(iter->get_filename());
+                    if (test_flags(iter->get_attributes(), FileAttributeFlag::directory))
+                    {
+                        luexp(collect_pack_files(path, source_dir, files));
+                    }
+                    else
+                    {
+                        Path relative_path;
+                        relative_path.assign_relative(source_dir, path);
+                        PackSourceFile file;
+                        file.m_name = make_pack_name(relative_path);
+                        file.m_path = move(path);
+                        files.push_back(move(file));
+                    }
+                    iter->move_next();
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        static RV write_pack_padding(IFile* file, u64 size)
+        {
+            static const byte_t zeros[256] = { 0 };
+            lutry
+            {
+                while (size)
+                {
+                    usize sz = (usize)min<u64>(size, sizeof(zeros));
+                    luexp(file->write(zeros, sz));
+                    size -= sz;
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        LUNA_VFS_API RV create_pack(const Path& source_dir, const Path& pack_path, const PackDesc& desc)
+        {
+            if (!desc.alignment || (desc.alignment & (desc.alignment - 1))) return BasicError::bad_arguments();
+            lutry
+            {
+                lulet(attribute, get_file_attribute(source_dir));
+                if (!test_flags(attribute.attributes, FileAttributeFlag::directory)) return BasicError::not_directory();
+                Vector<PackSourceFile> files;
+                luexp(collect_pack_files(source_dir, source_dir, files));
+                lulet(pack, open_file(pack_path, FileOpenFlag::write, FileCreationMode::create_always));
+                // The header is written after all other data is written.
+                luexp(write_pack_padding(pack, sizeof(PackHeader)));
+                u64 offset = sizeof(PackHeader);
+                Vector<PackEntry> entries;
+                entries.reserve(files.size());
+                String names;
+                Vector<byte_t> compressed;
+                for (auto& f : files)
+                {
+                    lulet(file, open_file(f.m_path, FileOpenFlag::read, FileCreationMode::open_existing));
+                    lulet(data, load_file_data(file));
+                    file = nullptr;
+                    PackEntry entry;
+                    memzero(&entry);
+                    entry.name_hash = pack_name_hash(f.m_name.c_str(), f.m_name.size());
+                    entry.name_offset = names.size();
+                    entry.name_size = (u32)f.m_name.size();
+                    names.append(f.m_name.c_str(), f.m_name.size());
+                    entry.size = data.size();
+                    entry.compression = PackCompression::none;
+                    const byte_t* stored_data = data.span().data();
+                    usize stored_size = data.size();
+                    if (desc.compression == PackCompression::lz4 && data.size() >= 64 && data.size() < (usize)U32_MAX)
+                    {
+                        compressed.resize(LZ4::compress_bound(data.size()));
+                        usize compressed_size = LZ4::compress(data.span().data(), data.size(), compressed.data(), compressed.size());
+                        // Keeps the file uncompressed so that it can be mapped directly if compression does not save at least 1/8 of the size.
+                        if (compressed_size && compressed_size <= data.size() - data.size() / 8)
+                        {
+                            entry.compression = PackCompression::lz4;
+                            stored_data = compressed.data();
+                            stored_size = compressed_size;
+                        }
+                    }
+                    u64 data_offset = align_upper(offset, (u64)desc.alignment);
+                    luexp(write_pack_padding(pack, data_offset - offset));
+                    luexp(pack->write(stored_data, stored_size));
+                    entry.data_offset = data_offset;
+                    entry.stored_size = stored_size;
+                    offset = data_offset + stored_size;
+                    entries.push_back(entry);
+                }
+                sort(entries.begin(), entries.end(), [&names](const PackEntry& lhs, const PackEntry& rhs)
+                {
+                    if (lhs.name_hash != rhs.name_hash) return lhs.name_hash < rhs.name_hash;
+                    int r = memcmp(names.c_str() + lhs.name_offset, names.c_str() + rhs.name_offset, min(lhs.name_size, rhs.name_size));
+                    return r ? r < 0 : lhs.name_size < rhs.name_size;
+                });
+                PackHeader header;
+                header.magic = PACK_MAGIC;
+                header.version = PACK_VERSION;
+                header.entry_count = (u32)entries.size();
+                header.alignment = desc.alignment;
+                header.entries_offset = align_upper(offset, (u64)alignof(PackEntry));
+                luexp(write_pack_padding(pack, header.entries_offset - offset));
+                luexp(pack->write(entries.data(), entries.size() * sizeof(PackEntry)));
+                header.names_offset = header.entries_offset + entries.size() * sizeof(PackEntry);
+                header.names_size = names.size();
+                luexp(pack->write(names.c_str(), names.size()));
+                luexp(pack->seek(0, SeekMode::begin));
+                luexp(pack->write(&header, sizeof(PackHeader)));
+            }
+            lucatchret;
+            return ok;
+        }
+    }
+}
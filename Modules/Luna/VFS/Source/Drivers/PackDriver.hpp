@@ -0,0 +1,61 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PackDriver.hpp
+* @author JXMaster
+* @date 2024/3/23
+*/
+#pragma once
+#include <Luna/Runtime/Base.hpp>
+#include <Luna/Runtime/Hash.hpp>
+#include "../../Pack.hpp"
+
+namespace Luna
+{
+    namespace VFS
+    {
+        // "LPAK" in little endian.
+        constexpr u32 PACK_MAGIC = 0x4B41504C;
+        constexpr u32 PACK_VERSION = 1;
+
+        // The pack file layout:
+        // 1. One `PackHeader`.
+        // 2. File data, every file starts at one offset aligned to `PackHeader::alignment`.
+        // 3. `PackHeader::entry_count` `PackEntry` structures sorted by (`name_hash`, name).
+        // 4. The name table that stores UTF-8 file paths relative to the pack root, separated by '/'.
+        // All values are stored in little endian.
+        struct PackHeader
+        {
+            u32 magic;
+            u32 version;
+            u32 entry_count;
+            u32 alignment;
+            u64 entries_offset;
+            u64 names_offset;
+            u64 names_size;
+        };
+
+        struct PackEntry
+        {
+            u64 name_hash;
+            // The offset of the name in the name table.
+            u64 name_offset;
+            u64 data_offset;
+            // The size of the data stored in the pack file.
+            u64 stored_size;
+            // The size of the file after decompression.
+            u64 size;
+            u32 name_size;
+            PackCompression compression;
+        };
+
+        inline u64 pack_name_hash(const c8* name, usize name_size)
+        {
+            return memhash64(name, name_size);
+        }
+
+        void register_pack_driver();
+    }
+}
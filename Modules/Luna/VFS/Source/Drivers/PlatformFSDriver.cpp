@@ -51,6 +51,12 @@ namespace Luna
             auto native_path = data->make_native_path_str(path);
             return Luna::open_file(native_path.c_str(), flags, creation);
         }
+        static R<Ref<IMappedFile>> fs_map_file(void* driver_data, void* mount_data, const Path& path)
+        {
+            auto data = (PlatformFileSystemMountData*)mount_data;
+            auto native_path = data->make_native_path_str(path);
+            return Luna::map_file(native_path.c_str());
+        }
         static R<FileAttribute> fs_get_file_attribute(void* driver_data, void* mount_data, const Path& path)
         {
             auto data = (PlatformFileSystemMountData*)mount_data;
@@ -112,6 +118,7 @@ namespace Luna
             desc.on_open_dir = fs_open_dir;
             desc.on_create_dir = fs_create_dir;
             desc.on_get_native_path = fs_get_native_path;
+            desc.on_map_file = fs_map_file;
             register_driver(get_platform_filesystem_driver(), desc);
         }
         LUNA_VFS_API Name get_platform_filesystem_driver()
@@ -0,0 +1,98 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file FileWatcher.cpp
+* @author JXMaster
+* @date 2024/3/28
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_VFS_API LUNA_EXPORT
+#include "FileWatcher.hpp"
+#include "../VFS.hpp"
+
+namespace Luna
+{
+    namespace VFS
+    {
+        static RV scan_dir(const Path& dir, HashMap<Path, FileSnapshot>& out_files)
+        {
+            lutry
+            {
+                lulet(iter, open_dir(dir));
+                Path path = dir;
+                for (; iter->is_valid(); iter->move_next())
+                {
+                    const c8* filename = iter->get_filename();
+                    if (!strcmp(filename, ".") || !strcmp(filename, "..")) continue;
+                    path.push_back(filename);
+                    if (test_flags(iter->get_attributes(), FileAttributeFlag::directory))
+                    {
+                        luexp(scan_dir(path, out_files));
+                    }
+                    else
+                    {
+                        // The file may be deleted after the directory is iterated, such files are ignored.
+                        auto attr = get_file_attribute(path);
+                        if (succeeded(attr))
+                        {
+                            FileSnapshot snapshot;
+                            snapshot.size = attr.get().size;
+                            snapshot.last_write_time = attr.get().last_write_time;
+                            out_files.insert(make_pair(path, snapshot));
+                        }
+                    }
+                    path.pop_back();
+                }
+            }
+            lucatchret;
+            return ok;
+        }
+        RV FileWatcher::init(const Path& dir)
+        {
+            m_dir = dir;
+            return scan_dir(m_dir, m_files);
+        }
+        RV FileWatcher::poll(Vector<FileChange>& out_changes)
+        {
+            lutry
+            {
+                HashMap<Path, FileSnapshot> files;
+                luexp(scan_dir(m_dir, files));
+                for (auto& file : files)
+                {
+                    auto iter = m_files.find(file.first);
+                    if (iter == m_files.end())
+                    {
+                        out_changes.push_back({ file.first, FileChangeType::added });
+                    }
+                    else if (iter->second.size != file.second.size || iter->second.last_write_time != file.second.last_write_time)
+                    {
+                        out_changes.push_back({ file.first, FileChangeType::modified });
+                    }
+                }
+                for (auto& file : m_files)
+                {
+                    if (files.find(file.first) == files.end())
+                    {
+                        out_changes.push_back({ file.first, FileChangeType::removed });
+                    }
+                }
+                m_files = move(files);
+            }
+            lucatchret;
+            return ok;
+        }
+        LUNA_VFS_API R<Ref<IFileWatcher>> new_file_watcher(const Path& dir)
+        {
+            Ref<FileWatcher> ret = new_object<FileWatcher>();
+            lutry
+            {
+                luexp(ret->init(dir));
+            }
+            lucatchret;
+            return Ref<IFileWatcher>(ret);
+        }
+    }
+}
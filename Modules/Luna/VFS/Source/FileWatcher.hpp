@@ -0,0 +1,42 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file FileWatcher.hpp
+* @author JXMaster
+* @date 2024/3/28
+*/
+#pragma once
+#include "../VFS.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+
+namespace Luna
+{
+    namespace VFS
+    {
+        struct FileSnapshot
+        {
+            u64 size;
+            i64 last_write_time;
+        };
+
+        struct FileWatcher : IFileWatcher
+        {
+            lustruct("VFS::FileWatcher", "{0b8f3d62-95a1-4c7e-b24d-6e1a7c0f58d9}");
+            luiimpl();
+
+            Path m_dir;
+            // The state of all files when the directory was scanned last time.
+            HashMap<Path, FileSnapshot> m_files;
+
+            RV init(const Path& dir);
+
+            virtual const Path& get_dir() override
+            {
+                return m_dir;
+            }
+            virtual RV poll(Vector<FileChange>& out_changes) override;
+        };
+    }
+}
@@ -11,21 +11,49 @@
 #define LUNA_VFS_API LUNA_EXPORT
 #include "VFS.hpp"
 #include <Luna/Runtime/UniquePtr.hpp>
-#include <Luna/Runtime/Mutex.hpp>
+#include <Luna/Runtime/Futex.hpp>
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Random.hpp>
 #include "Drivers/PlatformFSDriver.hpp"
+#include "Drivers/PackDriver.hpp"
+#include "Drivers/MemoryDriver.hpp"
+#include "Drivers/CacheDriver.hpp"
+#include "FileWatcher.hpp"
 
 namespace Luna
 {
     namespace VFS
     {
         HashMap<Name, UniquePtr<DriverDesc>> g_drivers;
-        Ref<IMutex> g_driver_mutex;
-        Vector<MountPair> g_mounts;
-        Ref<IMutex> g_mounts_mutex;
+        FutexMutex g_driver_mutex;
+        // The current mount table snapshot. `g_mount_table_lock` is only held when reading or replacing the reference,
+        // so resolving paths never waits for mount operations or other resolving threads.
+        Ref<MountTable> g_mount_table;
+        SpinLock g_mount_table_lock;
+        // Serializes mount, unmount and remount.
+        FutexMutex g_mounts_mutex;
+        perf_counter_t g_bytes_read_counter = 0;
+
+        static Ref<MountTable> get_mount_table()
+        {
+            LockGuard guard(g_mount_table_lock);
+            return g_mount_table;
+        }
+        static void set_mount_table(Ref<MountTable> table)
+        {
+            Ref<MountTable> old_table;
+            {
+                LockGuard guard(g_mount_table_lock);
+                old_table = move(g_mount_table);
+                g_mount_table = move(table);
+            }
+            // The old snapshot is released outside of the lock.
+        }
         LUNA_VFS_API void register_driver(const Name& name, const DriverDesc& desc)
         {
-            MutexGuard guard(g_driver_mutex);
+            LockGuard guard(g_driver_mutex);
             auto iter = g_drivers.find(name);
             // If the driver is registered, unregister it first.
             if (iter != g_drivers.end())
@@ -40,7 +68,7 @@ namespace Luna
 
         inline DriverDesc* find_driver(const Name& driver)
         {
-            MutexGuard guard(g_driver_mutex);
+            LockGuard guard(g_driver_mutex);
             auto iter = g_drivers.find(driver);
             if (iter == g_drivers.end()) return nullptr;
             return iter->second.get();
@@ -49,41 +77,71 @@ namespace Luna
         LUNA_VFS_API RV mount(const Name& driver, const c8* driver_path, const Path& mount_path,
             typeinfo_t params_type, void* params_data)
         {
-            MutexGuard guard(g_mounts_mutex);
+            LockGuard guard(g_mounts_mutex);
             DriverDesc* d = find_driver(driver);
             if (!d) return VFSError::driver_not_found();
-            MountPair p;
-            p.m_mount_path = mount_path;
-            p.m_driver = d;
-            for (auto& i : g_mounts)
+            Ref<MountTable> table = get_mount_table();
+            for (auto& i : table->m_mounts)
             {
-                if (p.m_mount_path == i.m_mount_path)
+                if (mount_path == i.m_mount_path)
                 {
                     return BasicError::already_exists();
                 }
             }
+            Ref<MountPoint> mnt = new_object<MountPoint>();
+            mnt->m_driver = d;
             lutry
             {
-                luset(p.m_mount_data, d->on_mount(d->driver_data, driver_path, mount_path, params_type, params_data));
+                luset(mnt->m_mount_data, d->on_mount(d->driver_data, driver_path, mount_path, params_type, params_data));
             }
             lucatchret;
-            g_mounts.push_back(move(p));
+            Ref<MountTable> new_table = new_object<MountTable>();
+            new_table->m_mounts = table->m_mounts;
+            MountEntry entry;
+            entry.m_mount_path = mount_path;
+            entry.m_mount = mnt;
+            new_table->m_mounts.push_back(move(entry));
+            new_table->build();
+            set_mount_table(move(new_table));
             return ok;
         }
         LUNA_VFS_API RV unmount(const Path& mount_path)
         {
-            MutexGuard guard(g_mounts_mutex);
-            auto iter = g_mounts.begin();
-            while (iter != g_mounts.end())
+            LockGuard guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
+            for (usize i = 0; i < table->m_mounts.size(); ++i)
             {
-                if (iter->m_mount_path == mount_path)
+                if (table->m_mounts[i].m_mount_path == mount_path)
                 {
+                    Ref<MountPoint> mnt = table->m_mounts[i].m_mount;
+                    Ref<MountTable> new_table = new_object<MountTable>();
+                    new_table->m_mounts = table->m_mounts;
+                    new_table->m_mounts.erase(new_table->m_mounts.begin() + i);
+                    new_table->build();
+                    set_mount_table(new_table);
+                    table = nullptr;
+                    // Waits for operations that still use the device through old snapshots.
+                    while (object_ref_count(mnt.object()) > 1)
+                    {
+                        yield_current_thread();
+                    }
                     lutry
                     {
-                        luexp(iter->m_driver->on_unmount(iter->m_driver->driver_data, iter->m_mount_data));
+                        luexp(mnt->m_driver->on_unmount(mnt->m_driver->driver_data, mnt->m_mount_data));
+                    }
+                    lucatch
+                    {
+                        // Restores the device if it cannot be unmounted.
+                        Ref<MountTable> restored_table = new_object<MountTable>();
+                        restored_table->m_mounts = new_table->m_mounts;
+                        MountEntry entry;
+                        entry.m_mount_path = mount_path;
+                        entry.m_mount = mnt;
+                        restored_table->m_mounts.insert(restored_table->m_mounts.begin() + i, move(entry));
+                        restored_table->build();
+                        set_mount_table(move(restored_table));
+                        return luerr;
                     }
-                    lucatchret;
-                    g_mounts.erase(iter);
                     return ok;
                 }
             }
@@ -91,38 +149,84 @@ namespace Luna
         }
         LUNA_VFS_API RV remount(const Path& from_path, const Path& to_path)
         {
-            MutexGuard guard(g_mounts_mutex);
-            auto iter = g_mounts.begin();
-            while (iter != g_mounts.end())
+            LockGuard guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
+            for (usize i = 0; i < table->m_mounts.size(); ++i)
             {
-                if (iter->m_mount_path == from_path)
+                if (table->m_mounts[i].m_mount_path == from_path)
                 {
-                    iter->m_mount_path = to_path;
+                    Ref<MountTable> new_table = new_object<MountTable>();
+                    new_table->m_mounts = table->m_mounts;
+                    new_table->m_mounts[i].m_mount_path = to_path;
+                    new_table->build();
+                    set_mount_table(move(new_table));
                     return ok;
                 }
             }
             return BasicError::not_found();
         }
-        static R<MountPair> route_path(const Path& filename, Path& relative_path)
+        void MountTable::build()
         {
-            auto iter = g_mounts.rbegin();
-            while (iter != g_mounts.rend())
+            m_nodes.clear();
+            m_nodes.emplace_back();
+            for (usize i = 0; i < m_mounts.size(); ++i)
             {
-                if (filename.is_subpath_of(iter->m_mount_path))
+                const Path& path = m_mounts[i].m_mount_path;
+                u32 node = 0;
+                for (auto& name : path)
                 {
-                    // matched.
-                    auto driver = iter->m_driver;
-                    relative_path = Path();
-                    relative_path.assign_relative(iter->m_mount_path, filename);
-                    return *iter;
+                    auto iter = m_nodes[node].m_children.find(name);
+                    if (iter == m_nodes[node].m_children.end())
+                    {
+                        u32 child = (u32)m_nodes.size();
+                        m_nodes[node].m_children.insert(make_pair(name, child));
+                        m_nodes.emplace_back();
+                        node = child;
+                    }
+                    else
+                    {
+                        node = iter->second;
+                    }
                 }
-                else
+                m_nodes[node].m_mounts.push_back((u32)i);
+            }
+        }
+        R<MountPair> MountTable::route(const Path& filename, Path& relative_path) const
+        {
+            // Walks the trie along the path nodes, and selects the latest mounted entry among all entries 
+            // whose mount path is one prefix of the path.
+            const MountEntry* matched = nullptr;
+            u32 matched_index = 0;
+            u32 node = 0;
+            usize depth = 0;
+            while (true)
+            {
+                for (u32 i : m_nodes[node].m_mounts)
                 {
-                    ++iter;
+                    if (matched && i <= matched_index) continue;
+                    const Name& root = m_mounts[i].m_mount_path.root();
+                    if (filename.root() && root && (filename.root() != root)) continue;
+                    matched = &m_mounts[i];
+                    matched_index = i;
                 }
+                if (depth == filename.size()) break;
+                auto iter = m_nodes[node].m_children.find(filename[depth]);
+                if (iter == m_nodes[node].m_children.end()) break;
+                node = iter->second;
+                ++depth;
             }
-            // Not found.
-            return BasicError::not_found();
+            if (!matched)
+            {
+                // Not found.
+                return BasicError::not_found();
+            }
+            MountPair ret;
+            ret.m_mount_path = matched->m_mount_path;
+            ret.m_driver = matched->m_mount->m_driver;
+            ret.m_mount_data = matched->m_mount->m_mount_data;
+            relative_path = Path();
+            relative_path.assign_relative(matched->m_mount_path, filename);
+            return ret;
         }
         static RV copy_file_between_driver(MountPair* from, MountPair* to, const Path& from_path, const Path& to_path, bool fail_if_exists)
         {
@@ -132,7 +236,7 @@ namespace Luna
             u64 file_sz;
             lutry
             {
-                luset(from_file, from->m_driver->on_open_file(from->m_driver->driver_data, from->m_mount_data, from_path, FileOpenFlag::read, FileCreationMode::open_existing));
+                luset(from_file, from->m_driver->on_open_file(from->m_driver->driver_data, from->m_mount_data, from_path, FileOpenFlag::read | FileOpenFlag::sequential_scan, FileCreationMode::open_existing));
                 if (fail_if_exists)
                 {
                     luset(to_file, to->m_driver->on_open_file(to->m_driver->driver_data, to->m_mount_data, to_path, FileOpenFlag::write, FileCreationMode::create_new));
@@ -186,25 +290,48 @@ namespace Luna
         }
         LUNA_VFS_API R<Ref<IFile>>    open_file(const Path& path, FileOpenFlag flags, FileCreationMode creation)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path relative_path;
             Ref<IFile> ret;
             lutry
             {
-                lulet(mnt, route_path(path, relative_path));
+                lulet(mnt, table->route(path, relative_path));
                 luset(ret, mnt.m_driver->on_open_file(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path, flags, creation));
             }
             lucatchret;
             return ret;
         }
+        LUNA_VFS_API R<Ref<IMappedFile>> map_file(const Path& path)
+        {
+            Ref<MountTable> table = get_mount_table();
+            Path relative_path;
+            Ref<IMappedFile> ret;
+            lutry
+            {
+                lulet(mnt, table->route(path, relative_path));
+                if (mnt.m_driver->on_map_file)
+                {
+                    luset(ret, mnt.m_driver->on_map_file(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path));
+                }
+                else
+                {
+                    lulet(file, mnt.m_driver->on_open_file(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path, FileOpenFlag::read | FileOpenFlag::sequential_scan, FileCreationMode::open_existing));
+                    auto mapped = new_object<BufferedMappedFile>();
+                    luset(mapped->m_data, load_file_data(file));
+                    ret = mapped;
+                }
+            }
+            lucatchret;
+            return ret;
+        }
         LUNA_VFS_API R<FileAttribute> get_file_attribute(const Path& path)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path relative_path;
             FileAttribute ret;
             lutry
             {
-                lulet(mnt, route_path(path, relative_path));
+                lulet(mnt, table->route(path, relative_path));
                 luset(ret, mnt.m_driver->on_get_file_attribute(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path));
             }
             lucatchret;
@@ -212,13 +339,13 @@ namespace Luna
         }
         LUNA_VFS_API RV copy_file(const Path& from_file_path, const Path& to_file_path, FileCopyFlag flags)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path from_path;
             Path to_path;
             lutry
             {
-                lulet(from, route_path(from_file_path, from_path));
-                lulet(to, route_path(to_file_path, to_path));
+                lulet(from, table->route(from_file_path, from_path));
+                lulet(to, table->route(to_file_path, to_path));
                 if (from.m_driver == to.m_driver)
                 {
                     return from.m_driver->on_copy_file(from.m_driver->driver_data, from.m_mount_data, to.m_mount_data, from_path, to_path, flags);
@@ -231,13 +358,13 @@ namespace Luna
         }
         LUNA_VFS_API RV move_file(const Path& from_file_path, const Path& to_file_path, FileMoveFlag flags)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path from_path;
             Path to_path;
             lutry
             {
-                lulet(from, route_path(from_file_path, from_path));
-                lulet(to, route_path(to_file_path, to_path));
+                lulet(from, table->route(from_file_path, from_path));
+                lulet(to, table->route(to_file_path, to_path));
                 if (from.m_driver == to.m_driver)
                 {
                     return from.m_driver->on_move_file(from.m_driver->driver_data, from.m_mount_data, to.m_mount_data, from_path, to_path, flags);
@@ -251,11 +378,11 @@ namespace Luna
         }
         LUNA_VFS_API RV delete_file(const Path& file_path)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path relative_path;
             lutry
             {
-                lulet(mnt, route_path(file_path, relative_path));
+                lulet(mnt, table->route(file_path, relative_path));
                 luexp(mnt.m_driver->on_delete_file(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path));
             }
             lucatchret;
@@ -263,12 +390,12 @@ namespace Luna
         }
         LUNA_VFS_API R<Ref<IFileIterator>> open_dir(const Path& dir_path)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path relative_path;
             Ref<IFileIterator> ret;
             lutry
             {
-                lulet(mnt, route_path(dir_path, relative_path));
+                lulet(mnt, table->route(dir_path, relative_path));
                 luset(ret, mnt.m_driver->on_open_dir(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path));
             }
             lucatchret;
@@ -276,24 +403,48 @@ namespace Luna
         }
         LUNA_VFS_API RV    create_dir(const Path& dir_path)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path relative_path;
             lutry
             {
-                lulet(mnt, route_path(dir_path, relative_path));
+                lulet(mnt, table->route(dir_path, relative_path));
                 luexp(mnt.m_driver->on_create_dir(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path));
             }
             lucatchret;
             return ok;
         }
+        LUNA_VFS_API RV write_file_atomically(const Path& path, Span<const byte_t> data)
+        {
+            // One random suffix per call, so that concurrent writers never truncate or move the temporary file
+            // of each other.
+            Guid id = random_guid();
+            c8 extension[40];
+            snprintf(extension, 40, "%016llx%016llx.tmp", (unsigned long long)id.high, (unsigned long long)id.low);
+            Path temp_path = path;
+            temp_path.append_extension(extension);
+            lutry
+            {
+                {
+                    lulet(f, open_file(temp_path, FileOpenFlag::write, FileCreationMode::create_new));
+                    luexp(f->write(data.data(), data.size()));
+                }
+                luexp(move_file(temp_path, path, FileMoveFlag::none));
+            }
+            lucatch
+            {
+                auto _ = delete_file(temp_path);
+                return luerr;
+            }
+            return ok;
+        }
         LUNA_VFS_API R<Name> get_native_path(const Path& vfs_path)
         {
-            MutexGuard _guard(g_mounts_mutex);
+            Ref<MountTable> table = get_mount_table();
             Path relative_path;
             Name ret;
             lutry
             {
-                lulet(mnt, route_path(vfs_path, relative_path));
+                lulet(mnt, table->route(vfs_path, relative_path));
                 luset(ret, mnt.m_driver->on_get_native_path(mnt.m_driver->driver_data, mnt.m_mount_data, relative_path));
             }
             lucatchret;
@@ -305,23 +456,31 @@ namespace Luna
             virtual const c8* get_name() override { return "VFS"; }
             virtual RV on_init() override
             {
-                g_driver_mutex = new_mutex();
-                g_mounts_mutex = new_mutex();
+                register_boxed_type<MountPoint>();
+                register_boxed_type<MountTable>();
+                register_boxed_type<BufferedMappedFile>();
+                impl_interface_for_type<BufferedMappedFile, IMappedFile>();
+                register_boxed_type<FileWatcher>();
+                impl_interface_for_type<FileWatcher, IFileWatcher>();
+                g_mount_table = new_object<MountTable>();
+                g_mount_table->build();
+                g_bytes_read_counter = register_perf_counter("VFS.BytesRead", PerfCounterType::counter, "bytes");
                 register_platform_filesystem_driver();
+                register_pack_driver();
+                register_memory_driver();
+                register_cache_driver();
                 return ok;
             }
             virtual void on_close() override
             {
-                g_mounts.clear();
-                g_mounts.shrink_to_fit();
-                g_mounts_mutex = nullptr;
+                g_mount_table = nullptr;
+                g_bytes_read_counter = 0;
                 for (auto& i : g_drivers)
                 {
                     if (i.second.get()->on_driver_unregister) i.second.get()->on_driver_unregister(i.second.get()->driver_data);
                 }
                 g_drivers.clear();
                 g_drivers.shrink_to_fit();
-                g_driver_mutex = nullptr;
             }
         };
     }
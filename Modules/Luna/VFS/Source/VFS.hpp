@@ -10,6 +10,9 @@
 #pragma once
 #include "../VFS.hpp"
 #include "../Driver.hpp"
+#include <Luna/Runtime/Ref.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/PerfCounter.hpp>
 
 namespace Luna
 {
@@ -22,5 +25,68 @@ namespace Luna
             DriverDesc* m_driver;
             void* m_mount_data;
         };
+
+        // The mapped file used for drivers that do not support mapping files, which stores the file data in one memory buffer.
+        struct BufferedMappedFile : IMappedFile
+        {
+            lustruct("VFS::BufferedMappedFile", "{7d2c5e91-3f8a-4b6d-a4e0-c19b62f8d375}");
+            luiimpl();
+
+            Blob m_data;
+
+            virtual const byte_t* get_data() override
+            {
+                return m_data.span().data();
+            }
+            virtual usize get_size() override
+            {
+                return m_data.size();
+            }
+        };
+
+        // One mounted file device. The device is shared by all mount table snapshots that contain it, so 
+        // the reference count tells whether any operation is still using the device.
+        struct MountPoint
+        {
+            lustruct("VFS::MountPoint", "{5c1d2a3e-0f47-4b8e-9a61-3d7e2b9c4f10}");
+
+            DriverDesc* m_driver;
+            void* m_mount_data;
+        };
+
+        struct MountEntry
+        {
+            Path m_mount_path;
+            Ref<MountPoint> m_mount;
+        };
+
+        struct MountTrieNode
+        {
+            HashMap<Name, u32> m_children;
+            // Indices of mount entries whose mount path ends at this node.
+            Vector<u32> m_mounts;
+        };
+
+        // One immutable snapshot of the mount table.
+        // Snapshots are never modified after being published, mount, unmount and remount build one new snapshot 
+        // and replace the current one, so that resolving paths does not need to lock the table.
+        struct MountTable
+        {
+            lustruct("VFS::MountTable", "{a8e4f6b2-71c9-4d05-b3e8-6f2a90d1c57e}");
+
+            // Entries in mounting order. Entries mounted later have higher priority.
+            Vector<MountEntry> m_mounts;
+            // The prefix trie of mount paths, the first node is the root node.
+            Vector<MountTrieNode> m_nodes;
+
+            // Builds the prefix trie from mount entries.
+            void build();
+            // Finds the mount entry for the specified path.
+            R<MountPair> route(const Path& filename, Path& relative_path) const;
+        };
+
+        // Bytes read from files served by pack, memory and cache drivers. Files opened by the platform file system
+        // driver are native files, whose reads are counted by `Runtime.FileBytesRead`.
+        extern perf_counter_t g_bytes_read_counter;
     }
 }
\ No newline at end of file
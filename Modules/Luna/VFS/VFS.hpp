@@ -11,6 +11,7 @@
 #pragma once
 #include <Luna/Runtime/File.hpp>
 #include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/MemoryUtils.hpp>
 
 #ifndef LUNA_VFS_API
 #define LUNA_VFS_API
@@ -57,6 +58,16 @@ namespace Luna
         //! * BasicError::not_directory
         //! * BasicError::bad_platform_call for all errors that cannot be identified.
         LUNA_VFS_API R<Ref<IFile>> open_file(const Path& path, FileOpenFlag flags, FileCreationMode creation);
+        //! Maps one file to the process address space for reading.
+        //! @param[in] path The path of the file.
+        //! @return Returns the mapped file object.
+        //! @remark If the driver of the file does not support mapping files, the file data is read to one memory buffer, 
+        //! so the returned object can always be used in place of reading the whole file.
+        //! @par Possible Errors:
+        //! * BasicError::access_denied
+        //! * BasicError::not_found
+        //! * BasicError::bad_platform_call for all errors that cannot be identified.
+        LUNA_VFS_API R<Ref<IMappedFile>> map_file(const Path& path);
         //! Gets the file or directory attribute.
         //! @param[in] path The path of the file to check.
         //! @return Returns the file attribute structure.
@@ -109,16 +120,96 @@ namespace Luna
         //! * BasicError::not_found
         //! * BasicError::bad_platform_call for all errors that cannot be identified.
         LUNA_VFS_API RV create_dir(const Path& path);
+        //! Writes data to one file and replaces the file if it exists, so that readers never see partially written data.
+        //! @details Data is written to one temporary file with one unique name in the same directory first, then the 
+        //! temporary file is moved to `path`. Every call uses one different temporary file, so this can be called by 
+        //! multiple threads or processes on the same file concurrently, in which case one of the written files is kept.
+        //! The temporary file is deleted if this function fails.
+        //! @param[in] path The path of the file to write. The parent directory must exist.
+        //! @param[in] data The data to write.
+        //! @par Possible Errors:
+        //! * BasicError::not_found
+        //! * BasicError::access_denied
+        //! * BasicError::bad_platform_call for all errors that cannot be identified.
+        LUNA_VFS_API RV write_file_atomically(const Path& path, Span<const byte_t> data);
 
         //! Translates one VFS path to one native driver path.
         //! @param[in] vfs_path The virtual file system path to translate.
         //! @return Returns the translated native path of the virtual path. The translated path is driver-specific.
         LUNA_VFS_API R<Name> get_native_path(const Path& vfs_path);
 
+        //! Identifies the type of one file change.
+        enum class FileChangeType : u8
+        {
+            //! The file is created.
+            added = 0,
+            //! The file data is modified.
+            modified = 1,
+            //! The file is deleted.
+            removed = 2,
+        };
+
+        //! Describes one file change detected by one file watcher.
+        struct FileChange
+        {
+            //! The VFS path of the changed file.
+            Path path;
+            //! The change type.
+            FileChangeType type;
+        };
+
+        //! @interface IFileWatcher
+        //! Detects file changes in one VFS directory and its subdirectories.
+        struct IFileWatcher : virtual Interface
+        {
+            luiid("{e6a41c3d-7b28-4f95-9d0e-2c85f17b4a63}");
+
+            //! Gets the directory watched by this watcher.
+            virtual const Path& get_dir() = 0;
+
+            //! Checks the watched directory for changes since the last call to `poll` (or since the watcher is created).
+            //! @param[out] out_changes Returns file changes. Existing elements in the vector will be preserved.
+            //! @remark This call scans the whole watched directory, and the time of this call is proportional to the number
+            //! of files in the directory. The user may want to call this from one background thread.
+            virtual RV poll(Vector<FileChange>& out_changes) = 0;
+        };
+
+        //! Creates one file watcher that detects file changes in the specified directory.
+        //! @details File changes are detected by comparing the size and the last write time of all files in the directory, so this
+        //! works for all VFS drivers that report file attributes.
+        //! @param[in] dir The VFS directory to watch.
+        //! @return Returns the created file watcher.
+        LUNA_VFS_API R<Ref<IFileWatcher>> new_file_watcher(const Path& dir);
+
         //! Gets the name of the VFS driver that maps platform's native file system to vritual file system.
         //! @return Returns the name of the platform's native file system driver.
         LUNA_VFS_API Name get_platform_filesystem_driver();
 
+        //! Gets the name of the VFS driver that stores files and directories in memory.
+        //! @details This driver does not use `driver_path` and `params_data` when mounting. Every mount creates one new empty 
+        //! file system, and all files in the mount are released when the mount is unmounted.
+        //! @return Returns the name of the in-memory file system driver.
+        LUNA_VFS_API Name get_memory_driver();
+
+        //! Specifies parameters when mounting one device using the cache driver.
+        struct CacheMountDesc
+        {
+            //! The maximum total size of file data kept in the cache.
+            usize max_file_data_size = 64_mb;
+            //! The maximum size of one file whose data can be kept in the cache. Larger files are not cached.
+            usize max_cached_file_size = 4_mb;
+            //! The maximum number of file attributes kept in the cache.
+            usize max_file_attributes = 4096;
+        };
+
+        //! Gets the name of the VFS driver that caches file data and attributes of another VFS path.
+        //! @details When mounting using this driver, `driver_path` specifies the VFS path to cache, and `params_data` 
+        //! may point to one @ref CacheMountDesc structure or be `nullptr` to use default parameters.
+        //! Files opened for reading are served from one least recently used cache, and files opened for writing 
+        //! are opened from the cached path directly. Changes made without going through the cache mount are not detected.
+        //! @return Returns the name of the cache driver.
+        LUNA_VFS_API Name get_cache_driver();
+
         //! @}
     }
 
@@ -24,6 +24,8 @@ namespace Luna
 
         //! @interface IFontAtlas
         //! Represents one font glyph packer that packs font glyph data to one 
+        //! @details All functions of this interface are thread-safe. Querying glyphs that are already loaded only requires shared access,
+        //! so multiple threads can read the atlas concurrently.
         struct IFontAtlas : virtual Interface
         {
             luiid("{FCDB9053-448B-4E7D-BC94-B67A7E81081A}");
@@ -43,14 +45,16 @@ namespace Luna
             virtual void set_font(Font::IFontFile* font, u32 index) = 0;
 
             //! Gets the shape buffer that stores the glyph contour commands. 
-            //! @details This call will copy shape command points to the shape buffer using GPU if shape point data
-            //! is modified after last call to @ref get_shape_buffer (or if @ref get_shape_buffer is called for the first time after
-            //! @ref clear), so the user should call this function only if all glyph shapes are packed to the atlas to avoid data copy overhead.
+            //! @details This call will copy shape command points to the shape buffer if new glyphs are packed after last call to 
+            //! @ref get_shape_buffer (or if @ref get_shape_buffer is called for the first time after @ref clear). Only points of new glyphs 
+            //! are copied, and the shape buffer is re-created with a larger capacity only if new points cannot fit into it, so the user 
+            //! should call this function only if all glyph shapes are packed to the atlas to avoid data copy overhead.
             //! @return Returns the shape buffer.
             virtual R<RHI::IBuffer*> get_shape_buffer() = 0;
 
             //! Gets the shape points data.
-            //! @return Returns the shape point data. The returned data span is valid until a new glyph is packed to the atlas.
+            //! @return Returns the shape point data. The returned data span is valid until a new glyph is packed to the atlas, so the 
+            //! user should not use it when other threads may pack glyphs.
             virtual Span<const f32> get_shape_points() = 0;
 
             //! Queries the information of the specified glyph, and optionally packs the glyph to this atlas if it is not packed yet.
@@ -59,6 +63,41 @@ namespace Luna
             //! @param[out] num_shape_points If not `nullptr`, returns the number of points of the shape data.
             //! @param[out] bounding_rect If not `nullptr`, returns the bounding rect of the glyph.
             virtual void get_glyph(usize codepoint, usize* first_shape_point, usize* num_shape_points, RectF* bounding_rect) = 0;
+
+            //! Packs glyphs of one codepoint range to this atlas.
+            //! @param[in] first_codepoint The first codepoint of the range.
+            //! @param[in] num_codepoints The number of codepoints in the range.
+            //! @details Glyph shapes are decoded in parallel using the job system and packed to the atlas in one batch. Codepoints that are 
+            //! already packed are skipped. This can be used to load common characters before arranging text, so that glyphs are not loaded 
+            //! one at a time when @ref get_glyph is called.
+            virtual void prewarm_glyphs(usize first_codepoint, usize num_codepoints) = 0;
+
+            //! Gets the vertical metrics of the font bound to this font atlas.
+            //! @param[out] ascent If not `nullptr`, returns the ascent value of the font in font units.
+            //! @param[out] descent If not `nullptr`, returns the descent value of the font in font units.
+            //! @param[out] line_gap If not `nullptr`, returns the line gap value of the font in font units.
+            //! @details The values are fetched when the font is set, so this call does not query the font file.
+            virtual void get_vmetrics(i32* ascent, i32* descent, i32* line_gap) = 0;
+
+            //! Computes the scale factor that converts font units of the font bound to this font atlas to pixels.
+            //! @param[in] pixels The height in pixels from the highest ascender to the lowest descender.
+            //! @return Returns the scale factor.
+            virtual f32 scale_for_pixel_height(f32 pixels) = 0;
+
+            //! Gets the horizontal metrics of the specified glyph.
+            //! @param[in] codepoint The codepoint of the glyph.
+            //! @param[out] advance_width If not `nullptr`, returns the advance width of the glyph in font units.
+            //! @param[out] left_side_bearing If not `nullptr`, returns the left side bearing of the glyph in font units.
+            //! @details Metrics are cached by the font atlas, so querying the same glyph again does not query the font file.
+            //! Unlike @ref get_glyph, this call does not pack the glyph shape to the atlas.
+            virtual void get_glyph_hmetrics(usize codepoint, i32* advance_width, i32* left_side_bearing) = 0;
+
+            //! Gets the kerning advance between two glyphs.
+            //! @param[in] ch1 The codepoint of the first glyph.
+            //! @param[in] ch2 The codepoint of the second glyph.
+            //! @return Returns the kerning advance in font units.
+            //! @details Kerning values are cached by the font atlas, so querying the same glyph pair again does not query the font file.
+            virtual i32 get_kern_advance(usize ch1, usize ch2) = 0;
         };
 
         //! Creates one new font atlas.
@@ -0,0 +1,85 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SDFFontAtlas.hpp
+* @author JXMaster
+* @date 2024/4/22
+*/
+#pragma once
+#include "FontAtlas.hpp"
+#include <Luna/RHI/Texture.hpp>
+
+#ifndef LUNA_VG_API
+#define LUNA_VG_API
+#endif
+
+namespace Luna
+{
+    namespace VG
+    {
+        //! @addtogroup VG
+        //! @{
+
+        //! Describes one SDF font atlas.
+        struct SDFFontAtlasDesc
+        {
+            //! The pixel height (from the highest ascender to the lowest descender) used to generate glyph bitmaps.
+            u32 glyph_size = 32;
+            //! The distance range, in pixels of glyph bitmaps, that is encoded in glyph bitmaps.
+            //! Larger ranges allow glyphs to be rendered at smaller sizes, but reduce the precision of distances.
+            f32 pixel_range = 4.0f;
+            //! The width of the atlas texture in pixels.
+            u32 texture_width = 1024;
+            //! The height of the atlas texture in pixels.
+            u32 texture_height = 1024;
+        };
+
+        //! @interface ISDFFontAtlas
+        //! Represents one font atlas that packs multi-channel signed distance field (MSDF) bitmaps of glyphs to one texture, 
+        //! in addition to glyph contour commands provided by @ref IFontAtlas.
+        //! @details Rendering glyphs from distance field bitmaps costs one texture sample per pixel, which is cheaper than evaluating 
+        //! glyph contours when drawing large amounts of small text. Glyphs in the SDF font atlas are drawn by committing text using 
+        //! @ref TextRenderMode::sdf, and the draw list must be rendered by the shape renderer created by @ref new_sdf_shape_renderer.
+        //! 
+        //! All functions of this interface are thread-safe.
+        struct ISDFFontAtlas : virtual IFontAtlas
+        {
+            luiid("{B8E41F26-5D3A-4C07-9F62-E1A7C03D85B4}");
+
+            //! Gets the descriptor of the font atlas.
+            virtual SDFFontAtlasDesc get_desc() = 0;
+
+            //! Queries the distance field bitmap of the specified glyph, and packs the bitmap to the atlas if it is not packed yet.
+            //! @param[in] codepoint The codepoint of the glyph.
+            //! @param[out] texcoord_rect If not `nullptr`, returns the region of the glyph bitmap in the atlas texture in normalized texture 
+            //! coordinates. The first row of the bitmap is the top of the glyph.
+            //! @param[out] bounding_rect If not `nullptr`, returns the rectangle covered by the glyph bitmap in font units relative to the 
+            //! glyph origin. This is larger than the bounding rect of the glyph returned by @ref IFontAtlas::get_glyph, since the bitmap 
+            //! includes paddings to store distances outside of the glyph.
+            //! @return Returns `true` if the glyph bitmap is packed. Returns `false` if the glyph does not have one contour 
+            //! or if the atlas texture does not have enough space for the glyph.
+            virtual bool get_sdf_glyph(usize codepoint, RectF* texcoord_rect, RectF* bounding_rect) = 0;
+
+            //! Gets the atlas texture that stores distance field bitmaps of glyphs.
+            //! @details This call will copy new glyph bitmaps to the texture using GPU if glyphs are packed after the last 
+            //! call to @ref get_texture, so the user should call this function only if all glyphs are packed to avoid data copy overhead.
+            //! @return Returns the atlas texture. The format of the texture is @ref RHI::Format::rgba8_unorm, RGB channels store the 
+            //! multi-channel distance and the alpha channel stores the true distance.
+            virtual R<RHI::ITexture*> get_texture() = 0;
+        };
+
+        //! Creates one new SDF font atlas.
+        //! @param[in] font The font file data used to pack font glyph.
+        //! @param[in] index The index of the font to use in font file data.
+        //! @param[in] desc The descriptor of the font atlas.
+        //! @param[in] device The RHI device bound to the font atlas. If this is `nullptr`, the main device 
+        //! (device fetched from @ref RHI::get_main_device) will be used.
+        //! @return Returns the created font atlas.
+        LUNA_VG_API Ref<ISDFFontAtlas> new_sdf_font_atlas(Font::IFontFile* font, u32 index, 
+            const SDFFontAtlasDesc& desc = SDFFontAtlasDesc(), RHI::IDevice* device = nullptr);
+
+        //! @}
+    }
+}
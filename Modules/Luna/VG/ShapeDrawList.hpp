@@ -10,7 +10,11 @@
 #pragma once
 #include <Luna/Runtime/Math/Vector.hpp>
 #include <Luna/RHI/DescriptorSet.hpp>
+#include <Luna/RHI/CommandBuffer.hpp>
+#include <Luna/RHI/UploadRingBuffer.hpp>
 #include <Luna/Runtime/Ref.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+#include "Shapes.hpp"
 
 #ifndef LUNA_VG_API
 #define LUNA_VG_API
@@ -55,12 +59,94 @@ namespace Luna
             u32 base_index;
             //! The number of indices to draw for this draw call.
             u32 num_indices;
+            //! The value added to every index before reading vertices from the vertex buffer.
+            u32 base_vertex;
+            //! The index of the first command (f32 value) of the shape buffer that is visible to this draw call.
+            //! @details This is non-zero only when the internal shape buffer is allocated from one upload ring buffer by
+            //! @ref IShapeDrawList::compile_transient.
+            u32 shape_buffer_offset;
             //! The origin point for this draw call.
+            //! @details Draw calls generated by @ref IShapeDrawList always have this set to (0, 0), since the origin point 
+            //! is applied to vertices directly.
             Float2U origin_point;
             //! The rotation for this draw call.
+            //! @details Draw calls generated by @ref IShapeDrawList always have this set to 0, since the rotation
+            //! is applied to vertices directly.
             f32 rotation;
         };
 
+        //! Records shapes that are appended to one shape draw list later.
+        //! @details Shape batches are used to record shapes on multiple threads: every thread records shapes to its own batch, then 
+        //! all batches are appended to one shape draw list by @ref IShapeDrawList::draw_shape_batches. Shapes in batches always use the 
+        //! internal shape buffer of the draw list, so shape command points are recorded in @ref points, and command offsets of vertices 
+        //! are relative to the first point of the batch. The shape batch is not thread-safe, one batch should only be recorded 
+        //! by one thread at a time.
+        struct ShapeBatch
+        {
+            //! The shape command points of shapes in this batch. Use functions in @ref ShapeBuilder to add points.
+            Vector<f32> points;
+            //! The vertices of shapes in this batch.
+            Vector<Vertex> vertices;
+            //! The indices of shapes in this batch. Indices are relative to the first vertex of this batch.
+            Vector<u32> indices;
+            //! The index of the first vertex of every shape that should be banded when the draw list is compiled.
+            Vector<u32> banding_shapes;
+
+            //! Clears all shapes in this batch, but retains their memory so they can be reused for new shapes.
+            void reset()
+            {
+                points.clear();
+                vertices.clear();
+                indices.clear();
+                banding_shapes.clear();
+            }
+
+            //! Draws one shape by adding one draw rect (two triangles) to the batch. 
+            //! See @ref IShapeDrawList::draw_shape for details.
+            //! @param[in] begin_command The index of the first command point of the shape in @ref points.
+            //! @param[in] num_commands The number of command points of the shape.
+            //! @param[in] min_position The minimum position of the bounding rect of the shape.
+            //! @param[in] max_position The maximum position of the bounding rect of the shape.
+            //! @param[in] min_shapecoord The shape coordinate value that maps to the minimum position of the bounding rect of the shape.
+            //! @param[in] max_shapecoord The shape coordinate value that maps to the maximum position of the bounding rect of the shape.
+            //! @param[in] color The color to tint the shape in RGBA8 form.
+            //! @param[in] min_texcoord The texture coordinate value that maps to the minimum position of the bounding rect of the shape.
+            //! @param[in] max_texcoord The texture coordinate value that maps to the maximum position of the bounding rect of the shape.
+            void draw_shape(u32 begin_command, u32 num_commands,
+                const Float2U& min_position, const Float2U& max_position,
+                const Float2U& min_shapecoord, const Float2U& max_shapecoord,
+                u32 color = 0xFFFFFFFF,
+                const Float2U& min_texcoord = Float2U(0.0f), const Float2U& max_texcoord = Float2U(0.0f))
+            {
+                u32 idx_offset = (u32)vertices.size();
+                Vertex v;
+                v.color = color;
+                v.begin_command = begin_command;
+                v.num_commands = num_commands;
+                v.position = min_position;
+                v.shapecoord = min_shapecoord;
+                v.texcoord = min_texcoord;
+                vertices.push_back(v);
+                v.position.y = max_position.y;
+                v.shapecoord.y = max_shapecoord.y;
+                v.texcoord.y = max_texcoord.y;
+                vertices.push_back(v);
+                v.position = max_position;
+                v.shapecoord = max_shapecoord;
+                v.texcoord = max_texcoord;
+                vertices.push_back(v);
+                v.position.y = min_position.y;
+                v.shapecoord.y = min_shapecoord.y;
+                v.texcoord.y = min_texcoord.y;
+                vertices.push_back(v);
+                indices.insert(indices.end(), { idx_offset, idx_offset + 1, idx_offset + 2, idx_offset, idx_offset + 2, idx_offset + 3 });
+                if (num_commands >= SHAPE_BANDING_THRESHOLD)
+                {
+                    banding_shapes.push_back(idx_offset);
+                }
+            }
+        };
+
         //! @interface IShapeDrawList
         //! Represents a draw list that contains shapes to be drawn.
         struct IShapeDrawList : virtual Interface
@@ -123,6 +209,9 @@ namespace Luna
             //! The origin point of the canvas is at the bottom-left corner. The x axis points to right and the y axis points to up.
             //! 
             //! The initial origin point is (0,0) when the draw list has been reset.
+            //! 
+            //! The origin point is applied to vertex positions when shapes are drawn, so changing the origin point does not 
+            //! create new draw calls.
             //! @param[in] origin The origin point position to set.
             virtual void set_origin(const Float2& origin) = 0;
 
@@ -132,6 +221,9 @@ namespace Luna
 
             //! Sets the rotation for the following draw calls.
             //! @details The rotation is relative to the set origin point.
+            //! 
+            //! The rotation is applied to vertex positions when shapes are drawn, so changing the rotation does not 
+            //! create new draw calls.
             //! @param[in] degrees The rotation to set in clockwise degrees.
             virtual void set_rotation(f32 degrees) = 0;
 
@@ -161,34 +253,65 @@ namespace Luna
                 const Float2U& min_texcoord = Float2U(0.0f), const Float2U& max_texcoord = Float2U(0.0f)
                 ) = 0;
 
+            //! Appends shapes recorded in shape batches to the draw list.
+            //! @param[in] batches The batches to append. Shapes in former batches are drawn before shapes in latter batches.
+            //! @details Shape points of every batch are appended to the internal shape buffer, and command offsets and indices of 
+            //! every batch are adjusted to address the appended data. The current origin point and rotation are applied to vertices 
+            //! of batches. Data of different batches is copied on multiple threads, and batches are not modified by this call, 
+            //! so that they can be reused in succeeding frames.
+            //! @par Valid Usage
+            //! * The internal shape buffer must be set as the current shape buffer (by passing `nullptr` to @ref set_shape_buffer).
+            virtual void draw_shape_batches(Span<const ShapeBatch> batches) = 0;
+
             //! Builds render resources and draw calls that can be used for drawing glyphs.
+            //! @details Shapes drawn by @ref draw_shape from the internal shape buffer with at least @ref SHAPE_BANDING_THRESHOLD
+            //! command points are converted to banded shapes (see @ref COMMAND_BANDS) in this call.
+            //! @details The draw list owns upload buffers that hold compiled data. Buffers are re-created only when their capacity is 
+            //! not enough, and data is not uploaded again if the draw list is not modified since the last call to @ref compile.
             virtual RV compile() = 0;
 
+            //! Builds render resources and draw calls in device-local memory, so that the draw list can be rendered in multiple frames 
+            //! without being compiled again.
+            //! @param[in] command_buffer The command buffer used to copy data to device-local buffers. The command buffer will be submitted, 
+            //! synchronized and reset before this function returns.
+            //! @details This is suitable for draw lists that are recorded once and rendered every frame, like static UI. Data is not uploaded 
+            //! again if the draw list is not modified since the last call to @ref compile_static.
+            virtual RV compile_static(RHI::ICommandBuffer* command_buffer) = 0;
+
+            //! Builds render resources and draw calls by allocating memory from one upload ring buffer.
+            //! @param[in] ring_buffer The ring buffer to allocate memory from. The buffer must be created with 
+            //! @ref RHI::BufferUsageFlag::vertex_buffer, @ref RHI::BufferUsageFlag::index_buffer and @ref RHI::BufferUsageFlag::read_buffer usages.
+            //! @details This is suitable for draw lists that are recorded every frame. The draw list does not own buffers in this mode, 
+            //! compiled data is valid until the current frame of the ring buffer is reclaimed, and draw calls returned by @ref get_draw_calls 
+            //! use @ref ShapeDrawCall::base_vertex, @ref ShapeDrawCall::base_index and @ref ShapeDrawCall::shape_buffer_offset to address 
+            //! allocated ranges.
+            virtual RV compile_transient(RHI::IUploadRingBuffer* ring_buffer) = 0;
+
             //! Gets the compiled vertex buffer used for rendering glyphs in this draw list.
             //! @return Returns the compiled vertex buffer.
             //! @par Valid Usage
-            //! * This function must be called after calling @ref compile in order to let new shape draw commands 
+            //! * This function must be called after calling @ref compile, @ref compile_static or @ref compile_transient in order to let new shape draw commands 
             //! take effect.
             virtual RHI::IBuffer* get_vertex_buffer() = 0;
 
             //! Gets the number of vertices in the vertex buffer returned by @ref get_vertex_buffer.
             //! @return Returns the number of vertices in the vertex buffer.
             //! @par Valid Usage
-            //! * This function must be called after calling @ref compile in order to let new shape draw commands 
+            //! * This function must be called after calling @ref compile, @ref compile_static or @ref compile_transient in order to let new shape draw commands 
             //! take effect.
             virtual u32 get_vertex_buffer_size() = 0;
 
             //! Gets the compiled index buffer used for rendering glyphs in this draw list.
             //! @return Returns the compiled index buffer.
             //! @par Valid Usage
-            //! * This function must be called after calling @ref compile in order to let new shape draw commands 
+            //! * This function must be called after calling @ref compile, @ref compile_static or @ref compile_transient in order to let new shape draw commands 
             //! take effect.
             virtual RHI::IBuffer* get_index_buffer() = 0;
 
             //! Gets the number of indices in the index buffer returned by @ref get_index_buffer.
             //! @return Returns the number of indices in the index buffer.
             //! @par Valid Usage
-            //! * This function must be called after calling @ref compile in order to let new shape draw commands 
+            //! * This function must be called after calling @ref compile, @ref compile_static or @ref compile_transient in order to let new shape draw commands 
             //! take effect.
             virtual u32 get_index_buffer_size() = 0;
 
@@ -206,6 +329,35 @@ namespace Luna
         //! @return Returns the created shape draw list.
         LUNA_VG_API Ref<IShapeDrawList> new_shape_draw_list(RHI::IDevice* device = nullptr);
 
+        //! Records shapes using multiple threads and appends them to one shape draw list.
+        //! @param[in] draw_list The draw list to append shapes to. See @ref IShapeDrawList::draw_shape_batches for valid usage.
+        //! @param[in] batches The batches used to record shapes. The vector is resized to the number of batches required, and every batch 
+        //! is reset before being recorded. The user may keep this vector between frames so that memory of batches is reused.
+        //! @param[in] num_items The number of items to record.
+        //! @param[in] items_per_batch The number of items recorded to one batch. If this is `0`, 256 items are recorded to one batch.
+        //! @param[in] func The function that records one item. The function signature must be `void(ShapeBatch& batch, usize item_index)`. 
+        //! The function is called on multiple threads concurrently, but items of one batch are recorded by one thread in order.
+        //! @remark Items are drawn in their index order regardless of the thread that records them.
+        template <typename _Func>
+        void parallel_draw_shapes(IShapeDrawList* draw_list, Vector<ShapeBatch>& batches, usize num_items, usize items_per_batch, _Func&& func)
+        {
+            if (!num_items) return;
+            if (!items_per_batch) items_per_batch = 256;
+            usize num_batches = (num_items + items_per_batch - 1) / items_per_batch;
+            batches.resize(num_batches);
+            JobSystem::parallel_for(0, num_batches, 1, [&](usize batch_index)
+            {
+                ShapeBatch& batch = batches[batch_index];
+                batch.reset();
+                usize end = min(num_items, (batch_index + 1) * items_per_batch);
+                for (usize i = batch_index * items_per_batch; i < end; ++i)
+                {
+                    func(batch, i);
+                }
+            });
+            draw_list->draw_shape_batches({ batches.data(), batches.size() });
+        }
+
         //! @}
     }
 }
\ No newline at end of file
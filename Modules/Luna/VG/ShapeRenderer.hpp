@@ -50,6 +50,14 @@ namespace Luna
         //! @return Returns the created shape renderer.
         LUNA_VG_API R<Ref<IShapeRenderer>> new_fill_shape_renderer(RHI::ITexture* render_target);
 
+        //! Creates a new shape renderer that draws glyphs from multi-channel signed distance field textures.
+        //! @param[in] render_target The texture used as the render target of the renderer.
+        //! @return Returns the created shape renderer.
+        //! @details This renderer should be used to render draw lists filled by @ref commit_text_arrange_result with
+        //! @ref TextRenderMode::sdf. The texture of every draw call is sampled as one MSDF texture, and the shape coordinates
+        //! of every vertex store the distance range of the texture in texture coordinates.
+        LUNA_VG_API R<Ref<IShapeRenderer>> new_sdf_shape_renderer(RHI::ITexture* render_target);
+
         //! @}
     }
 }
\ No newline at end of file
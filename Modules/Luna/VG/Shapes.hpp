@@ -90,6 +90,39 @@ namespace Luna
         //! See remarks of @ref COMMAND_CIRCLE_Q1 for details.
         constexpr f32 COMMAND_CIRCLE_Q4 = 7.0f;
 
+        //! The command code that begins one banded shape.
+        //! @details Banded shapes are generated by @ref build_shape_bands, and should not be written manually. One banded shape 
+        //! stores every segment (line, curve or circle part) of the shape as one self-contained record, and splits the bounding rect 
+        //! of the shape to horizontal and vertical bands. Every band stores the list of segments that overlap with the band, so that 
+        //! the fill shader only tests segments in the band that the pixel is in, rather than all segments of the shape.
+        //! 
+        //! The banded shape data is arranged as follows, all offsets are relative to the first point of the shape:
+        //! * {COMMAND_BANDS, N, MIN_X, MIN_Y, MAX_X, MAX_Y}: N is the number of bands in each direction, 
+        //! MIN and MAX specify the bounding rect of the shape.
+        //! * {OFFSET, COUNT} * 2N: The offset of the first segment index and the number of segments of every band. The first 
+        //! N bands are horizontal bands ordered by Y, the next N bands are vertical bands ordered by X.
+        //! * Segment indices of every band. Segments of horizontal bands are sorted by their maximum X in descending order, 
+        //! and segments of vertical bands are sorted by their maximum Y in descending order.
+        //! * Segment records. Every record takes 8 points: {TYPE, X0, Y0, X1, Y1, X2, Y2, R}. TYPE is @ref COMMAND_LINE_TO, 
+        //! @ref COMMAND_CURVE_TO or one of circle commands. (X0, Y0) is the start point, (X1, Y1) is the end point for lines and circle parts, 
+        //! or the control point for curves. (X2, Y2) is the end point for curves, or the circle center for circle parts. R is the radius 
+        //! for circle parts.
+        constexpr f32 COMMAND_BANDS = 8.0f;
+
+        //! The minimum number of command points of one shape for the shape to be banded by @ref IShapeDrawList and @ref IFontAtlas.
+        //! @details Banding does not improve performance for simple shapes, since the pixel shader tests few segments for such shapes 
+        //! anyway.
+        constexpr usize SHAPE_BANDING_THRESHOLD = 64;
+
+        //! Converts shape commands to one banded shape.
+        //! @param[in] commands The shape commands to convert. This must not be one banded shape.
+        //! @param[out] out_points The vector to append the banded shape data to.
+        //! @param[in] num_bands The number of bands in each direction. If this is `0`, the number of bands is determined 
+        //! from the number of segments of the shape.
+        //! @return Returns the number of points appended to `out_points`.
+        //! @details See remarks of @ref COMMAND_BANDS for details.
+        LUNA_VG_API usize build_shape_bands(Span<const f32> commands, Vector<f32>& out_points, u32 num_bands = 0);
+
         namespace ShapeBuilder
         {
             //! @addtogroup ShapeBuilder A collection of functions that help generating shape command points.
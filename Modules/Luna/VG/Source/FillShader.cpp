@@ -248,6 +248,81 @@ static const float COMMAND_CIRCLE_Q1 = 4.0f;
 static const float COMMAND_CIRCLE_Q2 = 5.0f;
 static const float COMMAND_CIRCLE_Q3 = 6.0f;
 static const float COMMAND_CIRCLE_Q4 = 7.0f;
+static const float COMMAND_BANDS = 8.0f;
+static const uint BANDED_SEGMENT_SIZE = 8;
+
+struct Segment
+{
+    float type;
+    float2 v0;
+    float2 v1;
+    float2 v2;
+    float radius;
+};
+
+// Loads one segment record of one banded shape. Points are relative to the pixel.
+Segment load_segment(uint offset, float2 shapecoord)
+{
+    Segment s;
+    s.type = g_commands[offset];
+    s.v0 = float2(g_commands[offset + 1], g_commands[offset + 2]) - shapecoord;
+    s.v1 = float2(g_commands[offset + 3], g_commands[offset + 4]) - shapecoord;
+    s.v2 = float2(g_commands[offset + 5], g_commands[offset + 6]) - shapecoord;
+    s.radius = g_commands[offset + 7];
+    return s;
+}
+
+float2 segment_max(Segment s)
+{
+    float2 r = max(s.v0, s.v1);
+    // v2 is the circle center for circle parts, which does not bound the segment.
+    return s.type == COMMAND_CURVE_TO ? max(r, s.v2) : r;
+}
+
+float segment_test_x_axis(Segment s, float2 pixels_per_unit)
+{
+    if (s.type == COMMAND_LINE_TO) return line_test_x_axis(s.v0, s.v1, pixels_per_unit);
+    if (s.type == COMMAND_CURVE_TO) return curve_test_x_axis(s.v0, s.v1, s.v2, pixels_per_unit);
+    return circle_test_x_axis(s.v0, s.v1, s.v2, s.radius, (s.type == COMMAND_CIRCLE_Q2) || (s.type == COMMAND_CIRCLE_Q3), pixels_per_unit);
+}
+
+float segment_test_y_axis(Segment s, float2 pixels_per_unit)
+{
+    if (s.type == COMMAND_LINE_TO) return line_test_y_axis(s.v0, s.v1, pixels_per_unit);
+    if (s.type == COMMAND_CURVE_TO) return curve_test_y_axis(s.v0, s.v1, s.v2, pixels_per_unit);
+    return circle_test_y_axis(s.v0, s.v1, s.v2, s.radius, (s.type == COMMAND_CIRCLE_Q3) || (s.type == COMMAND_CIRCLE_Q4), pixels_per_unit);
+}
+
+// Computes coverage of one banded shape by only testing segments in the bands that the pixel is in.
+void banded_shape_coverage(uint base, float2 shapecoord, float2 pixels_per_unit, inout float coverage_x, inout float coverage_y)
+{
+    uint num_bands = (uint)g_commands[base + 1];
+    float2 bounds_min = float2(g_commands[base + 2], g_commands[base + 3]);
+    float2 bounds_max = float2(g_commands[base + 4], g_commands[base + 5]);
+    float2 band_scale = (float)num_bands / max(bounds_max - bounds_min, DENOMINATOR_EPSILON);
+    int2 band = clamp(int2(floor((shapecoord - bounds_min) * band_scale)), 0, (int)num_bands - 1);
+    // Rays along x axis only hit segments in the horizontal band.
+    uint header = base + 6 + (uint)band.y * 2;
+    uint first = base + (uint)g_commands[header];
+    uint count = (uint)g_commands[header + 1];
+    for (uint i = 0; i < count; ++i)
+    {
+        Segment s = load_segment(base + (uint)g_commands[first + i], shapecoord);
+        // Segments are sorted by their maximum x in descending order, so all remaining segments are before the pixel.
+        if (segment_max(s).x * pixels_per_unit.x < -0.5f) break;
+        coverage_x += segment_test_x_axis(s, pixels_per_unit);
+    }
+    // Rays along y axis only hit segments in the vertical band.
+    header = base + 6 + (num_bands + (uint)band.x) * 2;
+    first = base + (uint)g_commands[header];
+    count = (uint)g_commands[header + 1];
+    for (uint j = 0; j < count; ++j)
+    {
+        Segment s = load_segment(base + (uint)g_commands[first + j], shapecoord);
+        if (segment_max(s).y * pixels_per_unit.y < -0.5f) break;
+        coverage_y += segment_test_y_axis(s, pixels_per_unit);
+    }
+}
 
 [[vk::location(0)]]
 float4 main(PSIn v) : SV_Target
@@ -260,6 +335,11 @@ float4 main(PSIn v) : SV_Target
     uint end = i + v.num_commands;
     float2 last_point = 0.0f;
     bool hit_test = false;
+    if (v.num_commands != 0 && g_commands[i] == COMMAND_BANDS)
+    {
+        banded_shape_coverage(i, v.shapecoord, pixels_per_unit, coverage_x, coverage_y);
+        i = end;
+    }
     while (i < end)
     {
         // Read next command.
@@ -313,5 +393,52 @@ float4 main(PSIn v) : SV_Target
 }
 )";
         usize FILL_SHADER_SOURCE_PS_SIZE = sizeof(FILL_SHADER_SOURCE_PS);
+
+        const c8 SDF_SHADER_SOURCE_PS[] = R"(
+struct TransformParams
+{
+    float4x4 transform;
+};
+TransformParams g_cbuffer : register(b0);
+StructuredBuffer<float> g_commands : register(t1);
+Texture2D g_tex : register(t2);
+SamplerState g_sampler : register(s3);
+
+struct PSIn
+{
+    [[vk::location(0)]]
+    float4 position        : SV_POSITION;
+    [[vk::location(1)]]
+    float2 shapecoord    : SHAPECOORD;
+    [[vk::location(2)]]
+    float2 texcoord        : TEXCOORD;
+    [[vk::location(3)]]
+    float4 color        : COLOR;
+    [[vk::location(4)]]
+    uint begin_command_offset : COMMAND_OFFSET;
+    [[vk::location(5)]]
+    uint num_commands    : NUM_COMMANDS;
+};
+
+float median(float r, float g, float b)
+{
+    return max(min(r, g), min(max(r, g), b));
+}
+
+[[vk::location(0)]]
+float4 main(PSIn v) : SV_Target
+{
+    // shapecoord stores the distance range of the atlas in texture coordinates.
+    float4 msd = g_tex.Sample(g_sampler, v.texcoord);
+    float sd = median(msd.r, msd.g, msd.b) - 0.5f;
+    float2 screen_tex_size = 1.0f / max(fwidth(v.texcoord), 0.0000001f);
+    float screen_px_range = max(0.5f * dot(v.shapecoord, screen_tex_size), 1.0f);
+    float alpha = saturate(screen_px_range * sd + 0.5f);
+    float4 col = v.color;
+    col.w *= alpha;
+    return col;
+}
+)";
+        usize SDF_SHADER_SOURCE_PS_SIZE = sizeof(SDF_SHADER_SOURCE_PS);
     }
 }
@@ -13,95 +13,33 @@
 #include "../Shapes.hpp"
 #include <Luna/Runtime/Math/Vector.hpp>
 #include <Luna/RHI/RHI.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
 
 namespace Luna
 {
     namespace VG
     {
-        static Float2 circle_get_point(const Float2& center, f32 radius, f32 angle)
+        static void prepare_shape_points(Span<const f32> points, Vector<f32>& out_points)
         {
-            angle = angle * PI / 180.0f;
-            Float2 sc;
-            sc.y = sinf(angle);
-            sc.x = cosf(angle);
-            return center + radius * sc;
-        }
-        static void compute_bounding_rect(Span<const f32> commands, RectF* bounding_rect)
-        {
-            if (commands.size() < 3)
+            if (points.size() >= SHAPE_BANDING_THRESHOLD)
             {
-                *bounding_rect = RectF(0, 0, 0, 0);
+                // Complex glyphs are banded so that every pixel only tests segments near it.
+                build_shape_bands(points, out_points);
             }
             else
             {
-                Float2 min_point = Float2(commands[1], commands[2]);
-                Float2 max_point = min_point;
-                Float2 last_point = Float2(0.0f);
-                usize i = 0;
-                while (i < commands.size())
-                {
-                    if (commands[i] == COMMAND_MOVE_TO)
-                    {
-                        Float2 p1 = Float2(commands[i + 1], commands[i + 2]);
-                        min_point = min(min_point, p1);
-                        max_point = max(max_point, p1);
-                        last_point = p1;
-                        i += 3;
-                    }
-                    else if (commands[i] == COMMAND_LINE_TO)
-                    {
-                        Float2 p1 = Float2(commands[i + 1], commands[i + 2]);
-                        min_point = min(min_point, p1);
-                        max_point = max(max_point, p1);
-                        last_point = p1;
-                        i += 3;
-                    }
-                    else if (commands[i] == COMMAND_CURVE_TO)
-                    {
-                        Float2 p1 = Float2(commands[i + 1], commands[i + 2]);
-                        Float2 p2 = Float2(commands[i + 3], commands[i + 4]);
-                        min_point = min(min_point, p1);
-                        min_point = min(min_point, p2);
-                        max_point = max(max_point, p1);
-                        max_point = max(max_point, p2);
-                        last_point = p2;
-                        i += 5;
-                    }
-                    else if (commands[i] >= COMMAND_CIRCLE_Q1 && commands[i] <= COMMAND_CIRCLE_Q4)
-                    {
-                        f32 radius = commands[i + 1];
-                        f32 begin = commands[i + 2];
-                        f32 end = commands[i + 3];
-                        Float2 center = circle_get_point(last_point, radius, 180.0f + begin);
-                        Float2 p2 = circle_get_point(center, radius, end);
-                        min_point = min(min_point, p2);
-                        max_point = max(max_point, p2);
-                        last_point = p2;
-                        i += 4;
-                    }
-                }
-                *bounding_rect = RectF(min_point.x, min_point.y, max_point.x - min_point.x, max_point.y - min_point.y);
+                out_points.insert(out_points.end(), points);
             }
         }
-        usize FontAtlas::add_shape(Span<const f32> points, const RectF* bounding_rect)
+        usize FontAtlas::add_shape(Span<const f32> points, const RectF& bounding_rect)
         {
-            lutsassert();
-            usize begin = m_shape_points.size();
-            m_shape_points.insert(m_shape_points.end(), points);
             ShapeDesc desc;
-            desc.first_shape_point = begin;
+            desc.first_shape_point = m_shape_points.size();
             desc.num_shape_points = points.size();
-            if (bounding_rect)
-            {
-                desc.bounding_rect = *bounding_rect;
-            }
-            else
-            {
-                compute_bounding_rect(points, &desc.bounding_rect);
-            }
+            desc.bounding_rect = bounding_rect;
+            m_shape_points.insert(m_shape_points.end(), points);
             usize r = m_shapes.size();
             m_shapes.push_back(desc);
-            m_shape_buffer_dirty = true;
             return r;
         }
         void FontAtlas::load_default_glyph()
@@ -114,7 +52,9 @@ namespace Luna
                 COMMAND_LINE_TO, 0.0f, 0.0f,
             };
             RectF rect = RectF(0.0f, 0.0f, 5.0f, 10.0f);
-            usize index = add_shape({ points, 15 }, &rect);
+            Vector<f32> shape_points;
+            prepare_shape_points({ points, 15 }, shape_points);
+            usize index = add_shape({ shape_points.data(), shape_points.size() }, rect);
             GlyphData data;
             data.m_glyph = Font::INVALID_GLYPH;
             data.m_shape_index = index;
@@ -122,12 +62,21 @@ namespace Luna
             data.m_left_side_bearing = 0;
             m_shape_map.insert(make_pair(0, data));
         }
-        bool FontAtlas::load_glyph(u32 codepoint)
+        void FontAtlas::clear_glyphs()
         {
+            m_shape_points.clear();
+            m_shapes.clear();
+            m_shape_map.clear();
+            m_uploaded_shape_points = 0;
+            load_default_glyph();
+        }
+        void FontAtlas::decode_glyph(u32 codepoint, DecodedGlyph& out_glyph)
+        {
+            out_glyph.m_valid = false;
             auto glyph = m_font->find_glyph(m_font_index, codepoint);
             if (glyph == Font::INVALID_GLYPH)
             {
-                return false;
+                return;
             }
             Vector<i16> font_shape;
             m_font->get_glyph_shape(m_font_index, glyph, font_shape);
@@ -171,111 +120,185 @@ namespace Luna
                 }
             }
             RectI rect = m_font->get_glyph_bounding_box(m_font_index, glyph);
-            RectF rectf = RectF((f32)rect.offset_x, (f32)rect.offset_y, (f32)rect.width, (f32)rect.height);
-            usize shape_index = add_shape({ font_data.data(), font_data.size() }, &rectf);
-            GlyphData data;
-            data.m_shape_index = shape_index;
-            data.m_glyph = glyph;
-            m_font->get_glyph_hmetrics(m_font_index, glyph, &data.m_advance_width, &data.m_left_side_bearing);
-            m_shape_map.insert(make_pair(codepoint, data));
-            return true;
+            out_glyph.m_bounding_rect = RectF((f32)rect.offset_x, (f32)rect.offset_y, (f32)rect.width, (f32)rect.height);
+            out_glyph.m_points.clear();
+            prepare_shape_points({ font_data.data(), font_data.size() }, out_glyph.m_points);
+            out_glyph.m_data.m_glyph = glyph;
+            m_font->get_glyph_hmetrics(m_font_index, glyph, &out_glyph.m_data.m_advance_width, &out_glyph.m_data.m_left_side_bearing);
+            out_glyph.m_valid = true;
         }
-        usize FontAtlas::get_glyph_shape_index(u32 codepoint)
+        void FontAtlas::add_glyph(u32 codepoint, DecodedGlyph& glyph)
         {
+            if (m_shape_map.contains(codepoint))
+            {
+                // Added by another thread.
+                return;
+            }
+            if (!glyph.m_valid)
+            {
+                // Records glyphs that are not found in the font as the default glyph, so that they are not decoded again.
+                m_shape_map.insert(make_pair(codepoint, m_shape_map.find(0)->second));
+                return;
+            }
+            glyph.m_data.m_shape_index = add_shape({ glyph.m_points.data(), glyph.m_points.size() }, glyph.m_bounding_rect);
+            m_shape_map.insert(make_pair(codepoint, glyph.m_data));
+        }
+        FontAtlas::ShapeDesc FontAtlas::get_glyph_shape(u32 codepoint)
+        {
+            m_lock->acquire_read();
             auto iter = m_shape_map.find(codepoint);
-            if (iter == m_shape_map.end())
+            if (iter != m_shape_map.end())
             {
-                auto loaded = load_glyph(codepoint);
-                if (loaded) iter = m_shape_map.find(codepoint);
-                else iter = m_shape_map.find(0);
+                ShapeDesc desc = m_shapes[iter->second.m_shape_index];
+                m_lock->release_read();
+                return desc;
             }
-            return iter->second.m_shape_index;
+            m_lock->release_read();
+            // Decodes the glyph without blocking readers.
+            DecodedGlyph glyph;
+            decode_glyph(codepoint, glyph);
+            m_lock->acquire_write();
+            add_glyph(codepoint, glyph);
+            ShapeDesc desc = m_shapes[m_shape_map.find(codepoint)->second.m_shape_index];
+            m_lock->release_write();
+            return desc;
         }
-        RV FontAtlas::recreate_buffer()
+        RV FontAtlas::upload_shape_points()
         {
             lutry
             {
                 using namespace RHI;
-                if (m_shape_buffer_capacity < m_shape_points.size())
+                usize num_points = m_shape_points.size();
+                usize begin = m_uploaded_shape_points;
+                if (m_shape_buffer_capacity < num_points)
                 {
-                    u64 shape_buffer_size = m_shape_points.size() * sizeof(f32);
-                    luset(m_shape_buffer, get_main_device()->new_buffer(MemoryType::upload, BufferDesc(
-                        BufferUsageFlag::read_buffer, shape_buffer_size)));
-                    m_shape_buffer_capacity = m_shape_points.size();
+                    // Grows the buffer geometrically so that adding glyphs rarely recreates the buffer.
+                    usize capacity = max(num_points, m_shape_buffer_capacity * 2);
+                    luset(m_shape_buffer, m_device->new_buffer(MemoryType::upload, BufferDesc(
+                        BufferUsageFlag::read_buffer, capacity * sizeof(f32))));
+                    m_shape_buffer_capacity = capacity;
+                    begin = 0;
                 }
-                void* shape_data = nullptr;
-                luexp(m_shape_buffer->map(0, 0, &shape_data));
-                memcpy(shape_data, m_shape_points.data(), m_shape_points.size() * sizeof(f32));
-                m_shape_buffer->unmap(0, m_shape_points.size() * sizeof(f32));
-                m_shape_buffer_dirty = false;
+                if (begin < num_points)
+                {
+                    // Only writes points added after the last upload, points that may be used by the GPU are not touched.
+                    f32* shape_data = nullptr;
+                    luexp(m_shape_buffer->map(0, 0, (void**)&shape_data));
+                    memcpy(shape_data + begin, m_shape_points.data() + begin, (num_points - begin) * sizeof(f32));
+                    m_shape_buffer->unmap(begin * sizeof(f32), num_points * sizeof(f32));
+                }
+                m_uploaded_shape_points = num_points;
             }
             lucatchret;
             return ok;
         }
-        // void FontAtlas::get_glyph_hmetrics(u32 codepoint, i32* advance_width, i32* left_side_bearing)
-        // {
-        //     auto iter = m_shape_map.find(codepoint);
-        //     if (iter == m_shape_map.end())
-        //     {
-        //         auto loaded = load_glyph(codepoint);
-        //         if (loaded) iter = m_shape_map.find(codepoint);
-        //         else iter = m_shape_map.find(0);
-        //     }
-        //     if (advance_width) *advance_width = iter->second.m_advance_width;
-        //     if (left_side_bearing) *left_side_bearing = iter->second.m_left_side_bearing;
-        // }
-        // i32 FontAtlas::get_kern_advance(u32 ch1, u32 ch2)
-        // {
-        //     auto iter1 = m_shape_map.find(ch1);
-        //     if (iter1 == m_shape_map.end())
-        //     {
-        //         auto loaded = load_glyph(ch1);
-        //         if (loaded)
-        //         {
-        //             iter1 = m_shape_map.find(ch1);
-        //         }
-        //     }
-        //     auto iter2 = m_shape_map.find(ch2);
-        //     if (iter2 == m_shape_map.end())
-        //     {
-        //         auto loaded = load_glyph(ch2);
-        //         if (loaded)
-        //         {
-        //             iter2 = m_shape_map.find(ch2);
-        //         }
-        //     }
-        //     if (iter1 != m_shape_map.end() && iter2 != m_shape_map.end())
-        //     {
-        //         return m_font->get_kern_advance(m_font_index, iter1->second.m_glyph, iter2->second.m_glyph);
-        //     }
-        //     return 0;
-        // }
+        FontAtlas::GlyphMetrics FontAtlas::get_glyph_metrics(u32 codepoint)
+        {
+            m_lock->acquire_read();
+            auto iter = m_metrics_map.find(codepoint);
+            if (iter != m_metrics_map.end())
+            {
+                GlyphMetrics metrics = iter->second;
+                m_lock->release_read();
+                return metrics;
+            }
+            m_lock->release_read();
+            GlyphMetrics metrics;
+            metrics.m_glyph = m_font->find_glyph(m_font_index, codepoint);
+            m_font->get_glyph_hmetrics(m_font_index, metrics.m_glyph, &metrics.m_advance_width, &metrics.m_left_side_bearing);
+            m_lock->acquire_write();
+            m_metrics_map.insert(make_pair(codepoint, metrics));
+            m_lock->release_write();
+            return metrics;
+        }
+        void FontAtlas::get_glyph_hmetrics(usize codepoint, i32* advance_width, i32* left_side_bearing)
+        {
+            GlyphMetrics metrics = get_glyph_metrics((u32)codepoint);
+            if (advance_width) *advance_width = metrics.m_advance_width;
+            if (left_side_bearing) *left_side_bearing = metrics.m_left_side_bearing;
+        }
+        i32 FontAtlas::get_kern_advance(usize ch1, usize ch2)
+        {
+            u64 key = ((u64)(u32)ch1 << 32) | (u64)(u32)ch2;
+            m_lock->acquire_read();
+            auto iter = m_kern_map.find(key);
+            if (iter != m_kern_map.end())
+            {
+                i32 kern = iter->second;
+                m_lock->release_read();
+                return kern;
+            }
+            m_lock->release_read();
+            Font::glyph_t glyph1 = get_glyph_metrics((u32)ch1).m_glyph;
+            Font::glyph_t glyph2 = get_glyph_metrics((u32)ch2).m_glyph;
+            i32 kern = m_font->get_kern_advance(m_font_index, glyph1, glyph2);
+            m_lock->acquire_write();
+            m_kern_map.insert(make_pair(key, kern));
+            m_lock->release_write();
+            return kern;
+        }
         R<RHI::IBuffer*> FontAtlas::get_shape_buffer()
         {
-            lutsassert();
+            RHI::IBuffer* r = nullptr;
+            m_lock->acquire_write();
             lutry
             {
-                if (m_shape_buffer_dirty)
+                if (m_uploaded_shape_points != m_shape_points.size())
                 {
-                    luexp(recreate_buffer());
+                    luexp(upload_shape_points());
                 }
+                r = m_shape_buffer.get();
             }
-            lucatchret;
-            return m_shape_buffer.get();
+            lucatch
+            {
+                m_lock->release_write();
+                return luerr;
+            }
+            m_lock->release_write();
+            return r;
         }
         Span<const f32> FontAtlas::get_shape_points()
         {
-            lutsassert();
-            return { m_shape_points.data(), m_shape_points.size() };
+            m_lock->acquire_read();
+            Span<const f32> r = { m_shape_points.data(), m_shape_points.size() };
+            m_lock->release_read();
+            return r;
         }
         void FontAtlas::get_glyph(usize codepoint, usize* first_shape_point, usize* num_shape_points, RectF* bounding_rect)
         {
-            usize shape_index = get_glyph_shape_index(codepoint);
-            auto& desc = m_shapes[shape_index];
+            ShapeDesc desc = get_glyph_shape((u32)codepoint);
             if (first_shape_point) *first_shape_point = desc.first_shape_point;
             if (num_shape_points) *num_shape_points = desc.num_shape_points;
             if (bounding_rect) *bounding_rect = desc.bounding_rect;
         }
+        void FontAtlas::prewarm_glyphs(usize first_codepoint, usize num_codepoints)
+        {
+            // Collects glyphs that are not loaded.
+            Vector<u32> codepoints;
+            m_lock->acquire_read();
+            for (usize i = 0; i < num_codepoints; ++i)
+            {
+                u32 codepoint = (u32)(first_codepoint + i);
+                if (!m_shape_map.contains(codepoint))
+                {
+                    codepoints.push_back(codepoint);
+                }
+            }
+            m_lock->release_read();
+            if (codepoints.empty()) return;
+            // Decodes glyphs in parallel, then adds them in one batch.
+            Vector<DecodedGlyph> glyphs(codepoints.size());
+            JobSystem::parallel_for(0, codepoints.size(), 16, [&](usize i)
+            {
+                decode_glyph(codepoints[i], glyphs[i]);
+            });
+            m_lock->acquire_write();
+            for (usize i = 0; i < codepoints.size(); ++i)
+            {
+                add_glyph(codepoints[i], glyphs[i]);
+            }
+            m_lock->release_write();
+        }
         LUNA_VG_API Ref<IFontAtlas> new_font_atlas(Font::IFontFile* font, u32 index, RHI::IDevice* device)
         {
             Ref<FontAtlas> ret = new_object<FontAtlas>();
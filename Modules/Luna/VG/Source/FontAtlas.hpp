@@ -10,7 +10,7 @@
 #pragma once
 #include "../FontAtlas.hpp"
 #include <Luna/Runtime/HashMap.hpp>
-#include <Luna/Runtime/TSAssert.hpp>
+#include <Luna/Runtime/ReadWriteLock.hpp>
 #include <Luna/RHI/Device.hpp>
 
 namespace Luna
@@ -21,7 +21,6 @@ namespace Luna
         {
             lustruct("VG::FontAtlas", "{E25DC74A-20B6-4207-B0C1-3E4F8CDB45A2}");
             luiimpl();
-            lutsassert_lock();
 
             struct ShapeDesc
             {
@@ -30,6 +29,13 @@ namespace Luna
                 RectF bounding_rect;
             };
 
+            struct GlyphMetrics
+            {
+                i32 m_advance_width;
+                i32 m_left_side_bearing;
+                Font::glyph_t m_glyph;
+            };
+
             struct GlyphData
             {
                 i32 m_advance_width;
@@ -38,71 +44,102 @@ namespace Luna
                 usize m_shape_index;
             };
 
+            // The decoded shape of one glyph that is not added to the atlas yet.
+            struct DecodedGlyph
+            {
+                Vector<f32> m_points;
+                RectF m_bounding_rect;
+                GlyphData m_data;
+                bool m_valid;
+            };
+
+            // Guards all states below. Glyph lookups only acquire read access, glyph loading acquires write access only
+            // when adding decoded glyphs.
+            Ref<IReadWriteLock> m_lock;
+
             Ref<RHI::IDevice> m_device;
             Ref<Font::IFontFile> m_font;
             u32 m_font_index;
             Vector<f32> m_shape_points;
             Vector<ShapeDesc> m_shapes;
             HashMap<u64, GlyphData> m_shape_map;
+            // Caches glyph metrics and kerning values queried by text arranging, which depend only on the font.
+            HashMap<u64, GlyphMetrics> m_metrics_map;
+            HashMap<u64, i32> m_kern_map;
 
             Ref<RHI::IBuffer> m_shape_buffer;
             usize m_shape_buffer_capacity;
-            bool m_shape_buffer_dirty;
+            // The number of shape points that are already written to the shape buffer.
+            usize m_uploaded_shape_points;
 
             i32 m_ascent;
             i32 m_descent;
             i32 m_line_gap;
 
             FontAtlas() :
+                m_lock(new_read_write_lock()),
                 m_shape_buffer_capacity(0),
-                m_shape_buffer_dirty(false) {}
+                m_uploaded_shape_points(0) {}
 
-            usize add_shape(Span<const f32> points, const RectF* bounding_rect);
+            // The following functions require write access.
+            usize add_shape(Span<const f32> points, const RectF& bounding_rect);
             void load_default_glyph();
-            bool load_glyph(u32 codepoint);
-            usize get_glyph_shape_index(u32 codepoint);
-            RV recreate_buffer();
+            void add_glyph(u32 codepoint, DecodedGlyph& glyph);
+            void clear_glyphs();
+            RV upload_shape_points();
+
+            // Decodes the glyph shape from the font file. This only reads the font file, so it can be called without the lock.
+            void decode_glyph(u32 codepoint, DecodedGlyph& out_glyph);
+            // Loads the glyph if it is not loaded, and returns the shape description of the glyph.
+            ShapeDesc get_glyph_shape(u32 codepoint);
+            GlyphMetrics get_glyph_metrics(u32 codepoint);
 
             virtual void clear() override
             {
-                lutsassert();
-                m_shape_points.clear();
-                m_shapes.clear();
-                m_shape_buffer_dirty = false;
-                m_shape_map.clear();
-                load_default_glyph();
+                m_lock->acquire_write();
+                clear_glyphs();
+                m_lock->release_write();
             }
             virtual Font::IFontFile* get_font(u32* index) override
             {
-                lutsassert();
+                m_lock->acquire_read();
                 if (index) *index = m_font_index;
-                return m_font;
+                Font::IFontFile* font = m_font;
+                m_lock->release_read();
+                return font;
             }
             virtual void set_font(Font::IFontFile* font, u32 index) override
             {
-                lutsassert();
+                m_lock->acquire_write();
                 m_font = font;
                 m_font_index = index;
                 font->get_vmetrics(index, &(m_ascent), &(m_descent), &(m_line_gap));
-                clear();
+                m_metrics_map.clear();
+                m_kern_map.clear();
+                clear_glyphs();
+                m_lock->release_write();
+            }
+            virtual void get_vmetrics(i32* ascent, i32* descent, i32* line_gap) override
+            {
+                m_lock->acquire_read();
+                if (ascent) *ascent = m_ascent;
+                if (descent) *descent = m_descent;
+                if (line_gap) *line_gap = m_line_gap;
+                m_lock->release_read();
+            }
+            virtual f32 scale_for_pixel_height(f32 pixels) override
+            {
+                m_lock->acquire_read();
+                f32 r = m_font->scale_for_pixel_height(m_font_index, pixels);
+                m_lock->release_read();
+                return r;
             }
-            // void get_glyph_hmetrics(u32 codepoint, i32* advance_width, i32* left_side_bearing);
-            // f32 scale_for_pixel_height(f32 pixels)
-            // {
-            //     lutsassert();
-            //     return m_font->scale_for_pixel_height(m_font_index, pixels);
-            // }
-            // void get_vmetrics(i32* ascent, i32* descent, i32* line_gap)
-            // {
-            //     lutsassert();
-            //     if (ascent) *ascent = m_ascent;
-            //     if (descent) *descent = m_descent;
-            //     if (line_gap) *line_gap = m_line_gap;
-            // }
-            // i32 get_kern_advance(u32 ch1, u32 ch2);
+            virtual void get_glyph_hmetrics(usize codepoint, i32* advance_width, i32* left_side_bearing) override;
+            virtual i32 get_kern_advance(usize ch1, usize ch2) override;
             virtual R<RHI::IBuffer*> get_shape_buffer() override;
             virtual Span<const f32> get_shape_points() override;
             virtual void get_glyph(usize codepoint, usize* first_shape_point, usize* num_shape_points, RectF* bounding_rect) override;
+            virtual void prewarm_glyphs(usize first_codepoint, usize num_codepoints) override;
         };
     }
-}
\ No newline at end of file
+}
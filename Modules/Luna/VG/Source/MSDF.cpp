@@ -0,0 +1,347 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file MSDF.cpp
+* @author JXMaster
+* @date 2024/4/22
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_VG_API LUNA_EXPORT
+#include "MSDF.hpp"
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Font/Font.hpp>
+
+namespace Luna
+{
+    namespace VG
+    {
+        enum EdgeColor : u8
+        {
+            EDGE_COLOR_RED = 1,
+            EDGE_COLOR_GREEN = 2,
+            EDGE_COLOR_BLUE = 4,
+            EDGE_COLOR_YELLOW = EDGE_COLOR_RED | EDGE_COLOR_GREEN,
+            EDGE_COLOR_MAGENTA = EDGE_COLOR_RED | EDGE_COLOR_BLUE,
+            EDGE_COLOR_CYAN = EDGE_COLOR_GREEN | EDGE_COLOR_BLUE,
+            EDGE_COLOR_WHITE = EDGE_COLOR_RED | EDGE_COLOR_GREEN | EDGE_COLOR_BLUE,
+        };
+
+        struct MSDFEdge
+        {
+            Float2 p0;
+            Float2 p1;
+            // Only used by quadratic curves.
+            Float2 p2;
+            bool curve;
+            u8 color;
+
+            Float2 point(f32 t) const
+            {
+                if (!curve) return p0 + (p1 - p0) * t;
+                f32 s = 1.0f - t;
+                return p0 * (s * s) + p1 * (2.0f * s * t) + p2 * (t * t);
+            }
+            Float2 direction(f32 t) const
+            {
+                if (!curve) return p1 - p0;
+                Float2 d = (p1 - p0) * (1.0f - t) + (p2 - p1) * t;
+                // The tangent is zero if the control point overlaps one end point.
+                if (d.x == 0.0f && d.y == 0.0f) return p2 - p0;
+                return d;
+            }
+        };
+
+        // The distance from one point to one edge.
+        struct EdgeDistance
+        {
+            // The unsigned distance.
+            f32 distance;
+            // Larger if the point is more orthogonal to the edge, used to choose between edges with the same distance.
+            f32 orthogonality;
+            // The signed distance, positive if the point is inside the shape.
+            f32 signed_distance;
+            // The signed distance to the edge extended at end points.
+            f32 pseudo_distance;
+        };
+
+        static f32 cross2(const Float2& a, const Float2& b)
+        {
+            return a.x * b.y - a.y * b.x;
+        }
+        static f32 dot2(const Float2& a, const Float2& b)
+        {
+            return a.x * b.x + a.y * b.y;
+        }
+        static Float2 normalize2(const Float2& v)
+        {
+            f32 len = sqrtf(dot2(v, v));
+            return len > 0.0f ? v / len : Float2(0.0f);
+        }
+
+        static void build_contours(Span<const i16> commands, Vector<Vector<MSDFEdge>>& contours)
+        {
+            usize i = 0;
+            Float2 last_point = Float2(0.0f);
+            while (i < commands.size())
+            {
+                i16 command = commands[i];
+                if (command == Font::COMMAND_MOVE_TO)
+                {
+                    last_point = Float2(commands[i + 1], commands[i + 2]);
+                    contours.emplace_back();
+                    i += 3;
+                }
+                else if (command == Font::COMMAND_LINE_TO)
+                {
+                    Float2 p = Float2(commands[i + 1], commands[i + 2]);
+                    if ((p.x != last_point.x || p.y != last_point.y) && !contours.empty())
+                    {
+                        MSDFEdge e;
+                        e.p0 = last_point;
+                        e.p1 = p;
+                        e.p2 = p;
+                        e.curve = false;
+                        e.color = EDGE_COLOR_WHITE;
+                        contours.back().push_back(e);
+                    }
+                    last_point = p;
+                    i += 3;
+                }
+                else if (command == Font::COMMAND_CURVE_TO)
+                {
+                    Float2 c = Float2(commands[i + 1], commands[i + 2]);
+                    Float2 p = Float2(commands[i + 3], commands[i + 4]);
+                    if ((p.x != last_point.x || p.y != last_point.y) && !contours.empty())
+                    {
+                        MSDFEdge e;
+                        e.p0 = last_point;
+                        e.p1 = c;
+                        e.p2 = p;
+                        e.curve = true;
+                        e.color = EDGE_COLOR_WHITE;
+                        contours.back().push_back(e);
+                    }
+                    last_point = p;
+                    i += 5;
+                }
+                else
+                {
+                    // Unknown command.
+                    break;
+                }
+            }
+        }
+
+        static bool is_corner(const Float2& a, const Float2& b)
+        {
+            // sin(3 radians), so that turns sharper than about 8 degrees are treated as corners.
+            constexpr f32 CROSS_THRESHOLD = 0.14112f;
+            Float2 na = normalize2(a);
+            Float2 nb = normalize2(b);
+            return dot2(na, nb) <= 0.0f || fabsf(cross2(na, nb)) > CROSS_THRESHOLD;
+        }
+
+        // Assigns colors to edges, so that two edges that meet at one corner always share only one channel.
+        static void color_edges(Vector<MSDFEdge>& contour)
+        {
+            usize num_edges = contour.size();
+            if (num_edges == 0) return;
+            Vector<usize> corners;
+            for (usize i = 0; i < num_edges; ++i)
+            {
+                const MSDFEdge& prev = contour[(i + num_edges - 1) % num_edges];
+                if (is_corner(prev.direction(1.0f), contour[i].direction(0.0f)))
+                {
+                    corners.push_back(i);
+                }
+            }
+            if (corners.empty())
+            {
+                // Smooth contour, all channels are the same.
+                for (auto& e : contour) e.color = EDGE_COLOR_WHITE;
+            }
+            else if (corners.size() == 1)
+            {
+                // One corner, splits the contour into three parts.
+                const u8 colors[3] = { EDGE_COLOR_MAGENTA, EDGE_COLOR_WHITE, EDGE_COLOR_YELLOW };
+                if (num_edges < 3)
+                {
+                    for (auto& e : contour) e.color = EDGE_COLOR_WHITE;
+                    return;
+                }
+                for (usize i = 0; i < num_edges; ++i)
+                {
+                    usize index = (corners[0] + i) % num_edges;
+                    contour[index].color = colors[i * 3 / num_edges];
+                }
+            }
+            else
+            {
+                // Switches color at every corner.
+                const u8 colors[3] = { EDGE_COLOR_CYAN, EDGE_COLOR_MAGENTA, EDGE_COLOR_YELLOW };
+                usize num_splines = corners.size();
+                usize spline = 0;
+                for (usize i = 0; i < num_edges; ++i)
+                {
+                    usize index = (corners[0] + i) % num_edges;
+                    if (spline + 1 < num_splines && index == corners[spline + 1])
+                    {
+                        ++spline;
+                    }
+                    usize color_index = spline % 3;
+                    if (spline == num_splines - 1 && color_index == 0)
+                    {
+                        // The last spline must not have the same color as the first spline.
+                        color_index = 1;
+                    }
+                    contour[index].color = colors[color_index];
+                }
+            }
+        }
+
+        // Finds the parameter of the point on the edge that is closest to `p`.
+        static f32 find_closest_param(const MSDFEdge& e, const Float2& p)
+        {
+            if (!e.curve)
+            {
+                Float2 ab = e.p1 - e.p0;
+                f32 len2 = dot2(ab, ab);
+                return len2 > 0.0f ? clamp(dot2(p - e.p0, ab) / len2, 0.0f, 1.0f) : 0.0f;
+            }
+            // Coarse search followed by Newton iterations.
+            constexpr u32 NUM_SAMPLES = 8;
+            f32 best_t = 0.0f;
+            f32 best_d = F32_MAX;
+            for (u32 i = 0; i <= NUM_SAMPLES; ++i)
+            {
+                f32 t = (f32)i / (f32)NUM_SAMPLES;
+                Float2 d = e.point(t) - p;
+                f32 dist = dot2(d, d);
+                if (dist < best_d)
+                {
+                    best_d = dist;
+                    best_t = t;
+                }
+            }
+            Float2 dd = (e.p2 - e.p1 * 2.0f + e.p0) * 2.0f;
+            for (u32 i = 0; i < 4; ++i)
+            {
+                Float2 d = e.point(best_t) - p;
+                Float2 d1 = e.direction(best_t) * 2.0f;
+                f32 f = dot2(d, d1);
+                f32 df = dot2(d1, d1) + dot2(d, dd);
+                if (df == 0.0f) break;
+                best_t = clamp(best_t - f / df, 0.0f, 1.0f);
+            }
+            return best_t;
+        }
+
+        static EdgeDistance compute_edge_distance(const MSDFEdge& e, const Float2& p, f32 inside_sign)
+        {
+            f32 t = find_closest_param(e, p);
+            Float2 q = e.point(t);
+            Float2 dir = normalize2(e.direction(t));
+            Float2 pq = p - q;
+            EdgeDistance r;
+            r.distance = sqrtf(dot2(pq, pq));
+            f32 side = cross2(dir, pq) * inside_sign;
+            r.signed_distance = side >= 0.0f ? r.distance : -r.distance;
+            r.orthogonality = r.distance > 0.0f ? fabsf(cross2(dir, pq / r.distance)) : 1.0f;
+            r.pseudo_distance = r.signed_distance;
+            // Extends the edge along its tangent at end points, so that distances of adjacent edges with different 
+            // colors do not interfere near corners.
+            if (t <= 0.0f)
+            {
+                Float2 d0 = normalize2(e.direction(0.0f));
+                Float2 ap = p - e.p0;
+                if (dot2(ap, d0) < 0.0f)
+                {
+                    f32 pd = cross2(d0, ap) * inside_sign;
+                    if (fabsf(pd) <= r.distance) r.pseudo_distance = pd;
+                }
+            }
+            else if (t >= 1.0f)
+            {
+                Float2 d1 = normalize2(e.direction(1.0f));
+                Float2 end = e.curve ? e.p2 : e.p1;
+                Float2 bp = p - end;
+                if (dot2(bp, d1) > 0.0f)
+                {
+                    f32 pd = cross2(d1, bp) * inside_sign;
+                    if (fabsf(pd) <= r.distance) r.pseudo_distance = pd;
+                }
+            }
+            return r;
+        }
+
+        static bool is_closer(const EdgeDistance& a, const EdgeDistance& b)
+        {
+            constexpr f32 EPSILON = 1e-4f;
+            if (fabsf(a.distance - b.distance) <= EPSILON) return a.orthogonality > b.orthogonality;
+            return a.distance < b.distance;
+        }
+
+        static u8 encode_distance(f32 d, f32 range)
+        {
+            f32 v = clamp(d / range + 0.5f, 0.0f, 1.0f);
+            return (u8)(v * 255.0f + 0.5f);
+        }
+
+        void generate_msdf(Span<const i16> commands, const Float2& origin, f32 scale, f32 pixel_range, 
+            u32 width, u32 height, u8* out_data, usize row_pitch)
+        {
+            Vector<Vector<MSDFEdge>> contours;
+            build_contours(commands, contours);
+            // TrueType outlines wind clockwise, while CFF outlines wind counter-clockwise. Determines which side 
+            // of edges is inside from the total signed area of all contours.
+            f32 area = 0.0f;
+            for (auto& contour : contours)
+            {
+                for (auto& e : contour)
+                {
+                    Float2 end = e.curve ? e.p2 : e.p1;
+                    area += cross2(e.p0, end);
+                }
+            }
+            f32 inside_sign = area > 0.0f ? 1.0f : -1.0f;
+            for (auto& contour : contours)
+            {
+                color_edges(contour);
+            }
+            f32 range = pixel_range / scale;
+            for (u32 y = 0; y < height; ++y)
+            {
+                u8* row = out_data + row_pitch * y;
+                for (u32 x = 0; x < width; ++x)
+                {
+                    Float2 p = origin + Float2((f32)x + 0.5f, (f32)(height - y) - 0.5f) / scale;
+                    EdgeDistance channels[3];
+                    EdgeDistance nearest;
+                    channels[0].distance = channels[1].distance = channels[2].distance = nearest.distance = F32_MAX;
+                    channels[0].orthogonality = channels[1].orthogonality = channels[2].orthogonality = nearest.orthogonality = 0.0f;
+                    channels[0].pseudo_distance = channels[1].pseudo_distance = channels[2].pseudo_distance = -F32_MAX;
+                    nearest.signed_distance = -F32_MAX;
+                    for (auto& contour : contours)
+                    {
+                        for (auto& e : contour)
+                        {
+                            EdgeDistance d = compute_edge_distance(e, p, inside_sign);
+                            if (is_closer(d, nearest)) nearest = d;
+                            for (u32 c = 0; c < 3; ++c)
+                            {
+                                if ((e.color & (1 << c)) && is_closer(d, channels[c])) channels[c] = d;
+                            }
+                        }
+                    }
+                    u8* pixel = row + x * 4;
+                    pixel[0] = encode_distance(channels[0].pseudo_distance, range);
+                    pixel[1] = encode_distance(channels[1].pseudo_distance, range);
+                    pixel[2] = encode_distance(channels[2].pseudo_distance, range);
+                    pixel[3] = encode_distance(nearest.signed_distance, range);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,27 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file MSDF.hpp
+* @author JXMaster
+* @date 2024/4/22
+*/
+#pragma once
+#include <Luna/Runtime/Span.hpp>
+#include <Luna/Runtime/Math/Vector.hpp>
+
+namespace Luna
+{
+    namespace VG
+    {
+        // Generates one multi-channel signed distance field bitmap from glyph outline commands.
+        // `commands` are outline commands returned by `Font::IFontFile::get_glyph_shape`.
+        // The pixel at (x, y) samples the outline at `origin + (x + 0.5, height - y - 0.5) / scale`, so the first row 
+        // of the bitmap is the top of the glyph.
+        // RGB channels store the multi-channel distance, alpha stores the true distance. Distances are mapped from 
+        // [-pixel_range / 2, pixel_range / 2] pixels to [0, 255], values greater than 127 are inside the glyph.
+        void generate_msdf(Span<const i16> commands, const Float2& origin, f32 scale, f32 pixel_range, 
+            u32 width, u32 height, u8* out_data, usize row_pitch);
+    }
+}
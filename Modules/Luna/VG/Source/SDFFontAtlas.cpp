@@ -0,0 +1,220 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SDFFontAtlas.cpp
+* @author JXMaster
+* @date 2024/4/22
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_VG_API LUNA_EXPORT
+#define STB_RECT_PACK_IMPLEMENTATION
+#include "SDFFontAtlas.hpp"
+#include "MSDF.hpp"
+#include "ShapeRenderer.hpp"
+#include <Luna/RHI/RHI.hpp>
+#include <Luna/RHI/Utility.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+
+namespace Luna
+{
+    namespace VG
+    {
+        void SDFFontAtlas::reset_packer()
+        {
+            m_packer_nodes.resize(m_desc.texture_width);
+            stbrp_init_target(&m_packer, (int)m_desc.texture_width, (int)m_desc.texture_height, 
+                m_packer_nodes.data(), (int)m_packer_nodes.size());
+            m_glyphs.clear();
+            m_bitmap.clear();
+            m_bitmap.resize((usize)m_desc.texture_width * m_desc.texture_height * 4, 0);
+            m_dirty_begin = 0;
+            m_dirty_end = m_desc.texture_height;
+        }
+        void SDFFontAtlas::clear()
+        {
+            m_shape_atlas->clear();
+            LockGuard guard(m_lock);
+            reset_packer();
+        }
+        void SDFFontAtlas::set_font(Font::IFontFile* font, u32 index)
+        {
+            m_shape_atlas->set_font(font, index);
+            LockGuard guard(m_lock);
+            reset_packer();
+        }
+        void SDFFontAtlas::generate_glyph(u32 codepoint, GeneratedGlyph& out_glyph)
+        {
+            out_glyph.m_valid = false;
+            u32 font_index;
+            Font::IFontFile* font = m_shape_atlas->get_font(&font_index);
+            Font::glyph_t glyph = font->find_glyph(font_index, codepoint);
+            if (glyph == Font::INVALID_GLYPH) return;
+            Vector<i16> commands;
+            font->get_glyph_shape(font_index, glyph, commands);
+            if (commands.empty()) return;
+            RectI box = font->get_glyph_bounding_box(font_index, glyph);
+            if (box.width <= 0 || box.height <= 0) return;
+            f32 scale = font->scale_for_pixel_height(font_index, (f32)m_desc.glyph_size);
+            // Paddings store distances outside of the glyph.
+            u32 padding = (u32)ceilf(m_desc.pixel_range * 0.5f) + 1;
+            out_glyph.m_width = (u32)ceilf((f32)box.width * scale) + padding * 2;
+            out_glyph.m_height = (u32)ceilf((f32)box.height * scale) + padding * 2;
+            Float2 origin = Float2((f32)box.offset_x, (f32)box.offset_y) - Float2((f32)padding) / scale;
+            out_glyph.m_bounding_rect = RectF(origin.x, origin.y, (f32)out_glyph.m_width / scale, (f32)out_glyph.m_height / scale);
+            out_glyph.m_data.resize((usize)out_glyph.m_width * out_glyph.m_height * 4);
+            generate_msdf({ commands.data(), commands.size() }, origin, scale, m_desc.pixel_range, 
+                out_glyph.m_width, out_glyph.m_height, out_glyph.m_data.data(), out_glyph.m_width * 4);
+            out_glyph.m_valid = true;
+        }
+        void SDFFontAtlas::pack_glyph(u32 codepoint, const GeneratedGlyph& glyph)
+        {
+            if (m_glyphs.contains(codepoint)) return;
+            SDFGlyph data;
+            data.valid = false;
+            if (glyph.m_valid)
+            {
+                // Leaves one pixel gap between glyphs, so that linear sampling does not read adjacent glyphs.
+                stbrp_rect rect;
+                rect.id = 0;
+                rect.w = (stbrp_coord)(glyph.m_width + 1);
+                rect.h = (stbrp_coord)(glyph.m_height + 1);
+                stbrp_pack_rects(&m_packer, &rect, 1);
+                if (rect.was_packed)
+                {
+                    usize row_pitch = (usize)m_desc.texture_width * 4;
+                    for (u32 y = 0; y < glyph.m_height; ++y)
+                    {
+                        memcpy(m_bitmap.data() + row_pitch * (rect.y + y) + rect.x * 4, glyph.m_data.data() + glyph.m_width * 4 * y, glyph.m_width * 4);
+                    }
+                    if (m_dirty_begin == m_dirty_end)
+                    {
+                        m_dirty_begin = rect.y;
+                        m_dirty_end = rect.y + glyph.m_height;
+                    }
+                    else
+                    {
+                        m_dirty_begin = min<u32>(m_dirty_begin, rect.y);
+                        m_dirty_end = max<u32>(m_dirty_end, rect.y + glyph.m_height);
+                    }
+                    data.texcoord_rect = RectF((f32)rect.x / (f32)m_desc.texture_width, (f32)rect.y / (f32)m_desc.texture_height,
+                        (f32)glyph.m_width / (f32)m_desc.texture_width, (f32)glyph.m_height / (f32)m_desc.texture_height);
+                    data.bounding_rect = glyph.m_bounding_rect;
+                    data.valid = true;
+                }
+                else
+                {
+                    // The atlas is full, retry after the atlas is cleared.
+                    return;
+                }
+            }
+            m_glyphs.insert(make_pair(codepoint, data));
+        }
+        bool SDFFontAtlas::get_sdf_glyph(usize codepoint, RectF* texcoord_rect, RectF* bounding_rect)
+        {
+            {
+                LockGuard guard(m_lock);
+                auto iter = m_glyphs.find(codepoint);
+                if (iter != m_glyphs.end())
+                {
+                    if (texcoord_rect) *texcoord_rect = iter->second.texcoord_rect;
+                    if (bounding_rect) *bounding_rect = iter->second.bounding_rect;
+                    return iter->second.valid;
+                }
+            }
+            // Generates the bitmap without holding the lock.
+            GeneratedGlyph glyph;
+            generate_glyph((u32)codepoint, glyph);
+            LockGuard guard(m_lock);
+            pack_glyph((u32)codepoint, glyph);
+            auto iter = m_glyphs.find(codepoint);
+            if (iter == m_glyphs.end()) return false;
+            if (texcoord_rect) *texcoord_rect = iter->second.texcoord_rect;
+            if (bounding_rect) *bounding_rect = iter->second.bounding_rect;
+            return iter->second.valid;
+        }
+        void SDFFontAtlas::prewarm_glyphs(usize first_codepoint, usize num_codepoints)
+        {
+            m_shape_atlas->prewarm_glyphs(first_codepoint, num_codepoints);
+            Vector<u32> codepoints;
+            {
+                LockGuard guard(m_lock);
+                for (usize i = 0; i < num_codepoints; ++i)
+                {
+                    u32 codepoint = (u32)(first_codepoint + i);
+                    if (!m_glyphs.contains(codepoint))
+                    {
+                        codepoints.push_back(codepoint);
+                    }
+                }
+            }
+            if (codepoints.empty()) return;
+            // Generates bitmaps in parallel, then packs them in one batch.
+            Vector<GeneratedGlyph> glyphs(codepoints.size());
+            JobSystem::parallel_for(0, codepoints.size(), 4, [&](usize i)
+            {
+                generate_glyph(codepoints[i], glyphs[i]);
+            });
+            LockGuard guard(m_lock);
+            for (usize i = 0; i < codepoints.size(); ++i)
+            {
+                pack_glyph(codepoints[i], glyphs[i]);
+            }
+        }
+        RV SDFFontAtlas::upload_texture()
+        {
+            using namespace RHI;
+            lutry
+            {
+                if (!m_texture)
+                {
+                    luset(m_texture, m_device->new_texture(MemoryType::local, TextureDesc::tex2d(Format::rgba8_unorm, 
+                        TextureUsageFlag::read_texture | TextureUsageFlag::copy_dest, m_desc.texture_width, m_desc.texture_height, 1, 1)));
+                    m_dirty_begin = 0;
+                    m_dirty_end = m_desc.texture_height;
+                }
+                if (!m_upload_cmdbuf)
+                {
+                    luset(m_upload_cmdbuf, m_device->new_command_buffer(get_copy_queue_index(m_device)));
+                }
+                if (m_dirty_begin < m_dirty_end)
+                {
+                    // Only copies rows that are modified.
+                    u32 row_pitch = m_desc.texture_width * 4;
+                    u32 num_rows = m_dirty_end - m_dirty_begin;
+                    luexp(copy_resource_data(m_upload_cmdbuf, {
+                        CopyResourceData::write_texture(m_texture, SubresourceIndex(0, 0), 0, m_dirty_begin, 0,
+                            m_bitmap.data() + (usize)row_pitch * m_dirty_begin, row_pitch, row_pitch * num_rows, 
+                            m_desc.texture_width, num_rows, 1)
+                    }));
+                }
+                m_dirty_begin = m_dirty_end = 0;
+            }
+            lucatchret;
+            return ok;
+        }
+        R<RHI::ITexture*> SDFFontAtlas::get_texture()
+        {
+            LockGuard guard(m_lock);
+            lutry
+            {
+                if (!m_texture || m_dirty_begin != m_dirty_end)
+                {
+                    luexp(upload_texture());
+                }
+            }
+            lucatchret;
+            return m_texture.get();
+        }
+        LUNA_VG_API Ref<ISDFFontAtlas> new_sdf_font_atlas(Font::IFontFile* font, u32 index, const SDFFontAtlasDesc& desc, RHI::IDevice* device)
+        {
+            Ref<SDFFontAtlas> ret = new_object<SDFFontAtlas>();
+            ret->m_desc = desc;
+            ret->m_device = device ? device : RHI::get_main_device();
+            ret->m_shape_atlas = new_font_atlas(font, index, ret->m_device);
+            ret->reset_packer();
+            return ret;
+        }
+    }
+}
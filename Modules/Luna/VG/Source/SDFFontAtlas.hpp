@@ -0,0 +1,116 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SDFFontAtlas.hpp
+* @author JXMaster
+* @date 2024/4/22
+*/
+#pragma once
+#include "../SDFFontAtlas.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+#include <Luna/RHI/Device.hpp>
+#define STBRP_STATIC
+#include <stb_rect_pack.h>
+
+namespace Luna
+{
+    namespace VG
+    {
+        struct SDFFontAtlas : ISDFFontAtlas
+        {
+            lustruct("VG::SDFFontAtlas", "{4F0C9D72-6B1E-4A38-8D53-A2E7F41B96C0}");
+            luiimpl();
+
+            struct SDFGlyph
+            {
+                RectF texcoord_rect;
+                RectF bounding_rect;
+                bool valid;
+            };
+
+            // One glyph bitmap generated but not packed yet.
+            struct GeneratedGlyph
+            {
+                Vector<u8> m_data;
+                u32 m_width;
+                u32 m_height;
+                RectF m_bounding_rect;
+                bool m_valid;
+            };
+
+            SDFFontAtlasDesc m_desc;
+            Ref<RHI::IDevice> m_device;
+            // Provides glyph contours and metrics, all IFontAtlas functions are forwarded to this atlas.
+            Ref<IFontAtlas> m_shape_atlas;
+
+            // Guards all states below.
+            SpinLock m_lock;
+            HashMap<u64, SDFGlyph> m_glyphs;
+            stbrp_context m_packer;
+            Vector<stbrp_node> m_packer_nodes;
+            // The CPU copy of the atlas texture.
+            Vector<u8> m_bitmap;
+            Ref<RHI::ITexture> m_texture;
+            Ref<RHI::ICommandBuffer> m_upload_cmdbuf;
+            // Rows in [m_dirty_begin, m_dirty_end) are modified after last upload.
+            u32 m_dirty_begin;
+            u32 m_dirty_end;
+
+            SDFFontAtlas() :
+                m_dirty_begin(0),
+                m_dirty_end(0) {}
+
+            void reset_packer();
+            void generate_glyph(u32 codepoint, GeneratedGlyph& out_glyph);
+            // Requires `m_lock` to be locked.
+            void pack_glyph(u32 codepoint, const GeneratedGlyph& glyph);
+            RV upload_texture();
+
+            virtual void clear() override;
+            virtual Font::IFontFile* get_font(u32* index) override
+            {
+                return m_shape_atlas->get_font(index);
+            }
+            virtual void set_font(Font::IFontFile* font, u32 index) override;
+            virtual R<RHI::IBuffer*> get_shape_buffer() override
+            {
+                return m_shape_atlas->get_shape_buffer();
+            }
+            virtual Span<const f32> get_shape_points() override
+            {
+                return m_shape_atlas->get_shape_points();
+            }
+            virtual void get_glyph(usize codepoint, usize* first_shape_point, usize* num_shape_points, RectF* bounding_rect) override
+            {
+                m_shape_atlas->get_glyph(codepoint, first_shape_point, num_shape_points, bounding_rect);
+            }
+            virtual void prewarm_glyphs(usize first_codepoint, usize num_codepoints) override;
+            virtual void get_vmetrics(i32* ascent, i32* descent, i32* line_gap) override
+            {
+                m_shape_atlas->get_vmetrics(ascent, descent, line_gap);
+            }
+            virtual f32 scale_for_pixel_height(f32 pixels) override
+            {
+                return m_shape_atlas->scale_for_pixel_height(pixels);
+            }
+            virtual void get_glyph_hmetrics(usize codepoint, i32* advance_width, i32* left_side_bearing) override
+            {
+                m_shape_atlas->get_glyph_hmetrics(codepoint, advance_width, left_side_bearing);
+            }
+            virtual i32 get_kern_advance(usize ch1, usize ch2) override
+            {
+                return m_shape_atlas->get_kern_advance(ch1, ch2);
+            }
+
+            virtual SDFFontAtlasDesc get_desc() override
+            {
+                return m_desc;
+            }
+            virtual bool get_sdf_glyph(usize codepoint, RectF* texcoord_rect, RectF* bounding_rect) override;
+            virtual R<RHI::ITexture*> get_texture() override;
+        };
+    }
+}
@@ -10,8 +10,11 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_VG_API LUNA_EXPORT
 #include "ShapeDrawList.hpp"
+#include "../Shapes.hpp"
+#include <Luna/Runtime/HashMap.hpp>
 #include <Luna/RHI/Device.hpp>
 #include <Luna/RHI/RHI.hpp>
+#include <Luna/RHI/Utility.hpp>
 
 namespace Luna
 {
@@ -26,6 +29,28 @@ namespace Luna
             }
             return m_draw_calls.back();
         }
+        void ShapeDrawList::transform_vertices(Vertex* vertices, usize num_vertices)
+        {
+            if (m_rotation == 0.0f)
+            {
+                if (m_origin.x == 0.0f && m_origin.y == 0.0f) return;
+                for (usize i = 0; i < num_vertices; ++i)
+                {
+                    vertices[i].position.x += m_origin.x;
+                    vertices[i].position.y += m_origin.y;
+                }
+                return;
+            }
+            f32 angle = m_rotation / 180.0f * PI;
+            f32 s = sinf(angle);
+            f32 c = cosf(angle);
+            for (usize i = 0; i < num_vertices; ++i)
+            {
+                Float2U p = vertices[i].position;
+                vertices[i].position.x = p.x * c - p.y * s + m_origin.x;
+                vertices[i].position.y = p.x * s + p.y * c + m_origin.y;
+            }
+        }
         void ShapeDrawList::reset()
         {
             lutsassert();
@@ -33,12 +58,14 @@ namespace Luna
             m_vertices.clear();
             m_indices.clear();
             m_internal_shape_points.clear();
+            m_banding_shapes.clear();
             m_shape_buffer.reset();
             m_texture.reset();
             m_sampler = get_default_sampler();
             m_origin = Float2U(0.0f);
             m_rotation = 0.0f;
             m_state_dirty = false;
+            m_modified = true;
         }
         void ShapeDrawList::draw_shape_raw(Span<const Vertex> vertices, Span<const u32> indices)
         {
@@ -46,12 +73,14 @@ namespace Luna
             auto& dc = get_current_draw_call();
             u32 idx_offset = (u32)m_vertices.size();
             m_vertices.insert(m_vertices.end(), vertices);
+            transform_vertices(m_vertices.data() + idx_offset, vertices.size());
             m_indices.reserve(m_indices.size() + indices.size());
             for(u32 i : indices)
             {
                 m_indices.push_back(idx_offset + i);
             }
             dc.num_indices += (u32)indices.size();
+            m_modified = true;
         }
         void ShapeDrawList::draw_shape(u32 begin_command, u32 num_commands,
             const Float2U& min_position, const Float2U& max_position,
@@ -89,46 +118,158 @@ namespace Luna
             v[0].color = v[1].color = v[2].color = v[3].color = color;
             v[0].begin_command = v[1].begin_command = v[2].begin_command = v[3].begin_command = begin_command;
             v[0].num_commands = v[1].num_commands = v[2].num_commands = v[3].num_commands = num_commands;
+            transform_vertices(v, 4);
             m_vertices.insert(m_vertices.end(), Span<Vertex>(v, 4));
             u32 indices[] = {
                 idx_offset , idx_offset + 1, idx_offset + 2,
                 idx_offset , idx_offset + 2, idx_offset + 3 };
             m_indices.insert(m_indices.end(), Span<u32>(indices, 6));
             dc.num_indices += 6;
+            m_modified = true;
+            if (!m_shape_buffer && num_commands >= SHAPE_BANDING_THRESHOLD)
+            {
+                m_banding_shapes.push_back(idx_offset);
+            }
         }
-        RV ShapeDrawList::compile()
+        void ShapeDrawList::draw_shape_batches(Span<const ShapeBatch> batches)
         {
             lutsassert();
+            lucheck_msg(!m_shape_buffer, "Shape batches can only be drawn when the internal shape buffer is set.");
+            if (batches.empty()) return;
+            auto& dc = get_current_draw_call();
+            // Computes the destination offset of every batch.
+            m_batch_offsets.resize(batches.size());
+            ShapeBatchOffset offset = { m_internal_shape_points.size(), m_vertices.size(), m_indices.size() };
+            for (usize i = 0; i < batches.size(); ++i)
+            {
+                m_batch_offsets[i] = offset;
+                offset.point += batches[i].points.size();
+                offset.vertex += batches[i].vertices.size();
+                offset.index += batches[i].indices.size();
+            }
+            m_internal_shape_points.resize(offset.point);
+            m_vertices.resize(offset.vertex);
+            m_indices.resize(offset.index);
+            // Copies data of every batch in parallel.
+            JobSystem::parallel_for(0, batches.size(), 1, [&](usize i)
+            {
+                const ShapeBatch& batch = batches[i];
+                const ShapeBatchOffset& dst = m_batch_offsets[i];
+                memcpy(m_internal_shape_points.data() + dst.point, batch.points.data(), batch.points.size() * sizeof(f32));
+                Vertex* vertices = m_vertices.data() + dst.vertex;
+                for (usize j = 0; j < batch.vertices.size(); ++j)
+                {
+                    vertices[j] = batch.vertices[j];
+                    vertices[j].begin_command += (u32)dst.point;
+                }
+                transform_vertices(vertices, batch.vertices.size());
+                u32* indices = m_indices.data() + dst.index;
+                for (usize j = 0; j < batch.indices.size(); ++j)
+                {
+                    indices[j] = batch.indices[j] + (u32)dst.vertex;
+                }
+            });
+            for (usize i = 0; i < batches.size(); ++i)
+            {
+                for (u32 first_vertex : batches[i].banding_shapes)
+                {
+                    m_banding_shapes.push_back(first_vertex + (u32)m_batch_offsets[i].vertex);
+                }
+            }
+            dc.num_indices += (u32)(offset.index - m_batch_offsets[0].index);
+            m_modified = true;
+        }
+        void ShapeDrawList::build_bands()
+        {
+            // Shapes that are drawn multiple times are banded only once.
+            HashMap<u64, Pair<u32, u32>> banded_shapes;
+            Vector<f32> banded_points;
+            for (u32 first_vertex : m_banding_shapes)
+            {
+                Vertex* v = m_vertices.data() + first_vertex;
+                u64 key = ((u64)v->begin_command << 32) | (u64)v->num_commands;
+                auto iter = banded_shapes.find(key);
+                if (iter == banded_shapes.end())
+                {
+                    u32 begin = (u32)(m_internal_shape_points.size() + banded_points.size());
+                    u32 size = (u32)build_shape_bands({ m_internal_shape_points.data() + v->begin_command, v->num_commands }, banded_points);
+                    iter = banded_shapes.insert(make_pair(key, make_pair(begin, size))).first;
+                }
+                for (u32 i = 0; i < 4; ++i)
+                {
+                    v[i].begin_command = iter->second.first;
+                    v[i].num_commands = iter->second.second;
+                }
+            }
+            m_internal_shape_points.insert(m_internal_shape_points.end(), Span<const f32>(banded_points.data(), banded_points.size()));
+            m_banding_shapes.clear();
+        }
+        RV ShapeDrawList::reserve_buffers(ShapeDrawListCompileMode mode)
+        {
             lutry
             {
-                // Pack data.
+                if (m_compile_mode != mode)
+                {
+                    // Buffers of the previous mode cannot be reused.
+                    m_vertex_buffer.reset();
+                    m_index_buffer.reset();
+                    m_internal_shape_buffer.reset();
+                    m_vertex_buffer_capacity = 0;
+                    m_index_buffer_capacity = 0;
+                    m_internal_shape_buffer_capacity = 0;
+                    m_compile_mode = mode;
+                }
+                m_base_vertex = 0;
+                m_base_index = 0;
+                m_internal_shape_buffer_offset = 0;
+                RHI::MemoryType memory_type = mode == ShapeDrawListCompileMode::local ? RHI::MemoryType::local : RHI::MemoryType::upload;
+                RHI::BufferUsageFlag copy_usage = mode == ShapeDrawListCompileMode::local ? RHI::BufferUsageFlag::copy_dest : RHI::BufferUsageFlag::none;
                 u32 num_vertices = (u32)m_vertices.size();
                 u32 num_indices = (u32)m_indices.size();
                 u32 num_internal_buffer_points = (u32)m_internal_shape_points.size();
                 if (m_vertex_buffer_capacity < num_vertices)
                 {
                     // Recreate vertex buffer.
-                    luset(m_vertex_buffer, m_device->new_buffer(RHI::MemoryType::upload, RHI::BufferDesc(
-                        RHI::BufferUsageFlag::vertex_buffer, num_vertices * sizeof(Vertex))));
+                    luset(m_vertex_buffer, m_device->new_buffer(memory_type, RHI::BufferDesc(
+                        RHI::BufferUsageFlag::vertex_buffer | copy_usage, num_vertices * sizeof(Vertex))));
                     m_vertex_buffer_capacity = num_vertices;
                 }
                 m_vertex_buffer_size = num_vertices;
                 if (m_index_buffer_capacity < num_indices)
                 {
                     // Recreate index buffer.
-                    luset(m_index_buffer, m_device->new_buffer(RHI::MemoryType::upload, RHI::BufferDesc(
-                        RHI::BufferUsageFlag::index_buffer, num_indices * sizeof(u32))));
+                    luset(m_index_buffer, m_device->new_buffer(memory_type, RHI::BufferDesc(
+                        RHI::BufferUsageFlag::index_buffer | copy_usage, num_indices * sizeof(u32))));
                     m_index_buffer_capacity = num_indices;
                 }
                 m_index_buffer_size = num_indices;
                 if(m_internal_shape_buffer_capacity < num_internal_buffer_points)
                 {
                     // Recreate internal shape buffer.
-                    luset(m_internal_shape_buffer, m_device->new_buffer(RHI::MemoryType::upload, RHI::BufferDesc(
-                        RHI::BufferUsageFlag::read_buffer, num_internal_buffer_points * sizeof(f32))));
+                    luset(m_internal_shape_buffer, m_device->new_buffer(memory_type, RHI::BufferDesc(
+                        RHI::BufferUsageFlag::read_buffer | copy_usage, num_internal_buffer_points * sizeof(f32))));
                     m_internal_shape_buffer_capacity = num_internal_buffer_points;
                 }
                 m_internal_shape_buffer_size = num_internal_buffer_points;
+            }
+            lucatchret;
+            return ok;
+        }
+        RV ShapeDrawList::compile()
+        {
+            lutsassert();
+            lutry
+            {
+                if (m_compile_mode == ShapeDrawListCompileMode::upload && !m_modified)
+                {
+                    // Buffers already contain the recorded data.
+                    return ok;
+                }
+                if (!m_banding_shapes.empty())
+                {
+                    build_bands();
+                }
+                luexp(reserve_buffers(ShapeDrawListCompileMode::upload));
                 if(m_vertex_buffer)
                 {
                     Vertex* vertex_data = nullptr;
@@ -150,17 +291,113 @@ namespace Luna
                     memcpy(shape_data, m_internal_shape_points.data(), m_internal_shape_points.size() * sizeof(f32));
                     m_internal_shape_buffer->unmap(0, m_internal_shape_points.size() * sizeof(f32));
                 }
-                for(auto& dc : m_draw_calls)
+                m_modified = false;
+            }
+            lucatchret;
+            return ok;
+        }
+        RV ShapeDrawList::compile_static(RHI::ICommandBuffer* command_buffer)
+        {
+            lutsassert();
+            lutry
+            {
+                if (m_compile_mode == ShapeDrawListCompileMode::local && !m_modified)
+                {
+                    return ok;
+                }
+                if (!m_banding_shapes.empty())
+                {
+                    build_bands();
+                }
+                luexp(reserve_buffers(ShapeDrawListCompileMode::local));
+                Vector<RHI::CopyResourceData> copies;
+                if (!m_vertices.empty())
+                {
+                    copies.push_back(RHI::CopyResourceData::write_buffer(m_vertex_buffer, 0, m_vertices.data(), m_vertices.size() * sizeof(Vertex)));
+                }
+                if (!m_indices.empty())
+                {
+                    copies.push_back(RHI::CopyResourceData::write_buffer(m_index_buffer, 0, m_indices.data(), m_indices.size() * sizeof(u32)));
+                }
+                if (!m_internal_shape_points.empty())
+                {
+                    copies.push_back(RHI::CopyResourceData::write_buffer(m_internal_shape_buffer, 0, m_internal_shape_points.data(), m_internal_shape_points.size() * sizeof(f32)));
+                }
+                if (!copies.empty())
                 {
-                    if(!dc.shape_buffer)
-                    {
-                        dc.shape_buffer = m_internal_shape_buffer;
-                    }
+                    luexp(RHI::copy_resource_data(command_buffer, { copies.data(), copies.size() }));
                 }
+                m_modified = false;
             }
             lucatchret;
             return ok;
         }
+        RV ShapeDrawList::compile_transient(RHI::IUploadRingBuffer* ring_buffer)
+        {
+            lutsassert();
+            lutry
+            {
+                if (!m_banding_shapes.empty())
+                {
+                    build_bands();
+                }
+                // The draw list does not own buffers in this mode.
+                m_compile_mode = ShapeDrawListCompileMode::ring_buffer;
+                m_vertex_buffer.reset();
+                m_index_buffer.reset();
+                m_internal_shape_buffer.reset();
+                m_vertex_buffer_capacity = 0;
+                m_index_buffer_capacity = 0;
+                m_internal_shape_buffer_capacity = 0;
+                m_base_vertex = 0;
+                m_base_index = 0;
+                m_internal_shape_buffer_offset = 0;
+                m_vertex_buffer_size = (u32)m_vertices.size();
+                m_index_buffer_size = (u32)m_indices.size();
+                m_internal_shape_buffer_size = (u32)m_internal_shape_points.size();
+                // Ranges are aligned to their element sizes, so that offsets can be expressed in elements.
+                if (!m_vertices.empty())
+                {
+                    lulet(range, ring_buffer->allocate(m_vertices.size() * sizeof(Vertex), sizeof(Vertex)));
+                    memcpy(range.data, m_vertices.data(), m_vertices.size() * sizeof(Vertex));
+                    m_vertex_buffer = range.buffer;
+                    m_base_vertex = (u32)(range.offset / sizeof(Vertex));
+                }
+                if (!m_indices.empty())
+                {
+                    lulet(range, ring_buffer->allocate(m_indices.size() * sizeof(u32), sizeof(u32)));
+                    memcpy(range.data, m_indices.data(), m_indices.size() * sizeof(u32));
+                    m_index_buffer = range.buffer;
+                    m_base_index = (u32)(range.offset / sizeof(u32));
+                }
+                if (!m_internal_shape_points.empty())
+                {
+                    lulet(range, ring_buffer->allocate(m_internal_shape_points.size() * sizeof(f32), sizeof(f32)));
+                    memcpy(range.data, m_internal_shape_points.data(), m_internal_shape_points.size() * sizeof(f32));
+                    m_internal_shape_buffer = range.buffer;
+                    m_internal_shape_buffer_offset = (u32)(range.offset / sizeof(f32));
+                }
+                m_modified = false;
+            }
+            lucatchret;
+            return ok;
+        }
+        void ShapeDrawList::get_draw_calls(Vector<ShapeDrawCall>& out_draw_calls)
+        {
+            out_draw_calls.reserve(out_draw_calls.size() + m_draw_calls.size());
+            for (auto& dc : m_draw_calls)
+            {
+                out_draw_calls.push_back(dc);
+                ShapeDrawCall& out = out_draw_calls.back();
+                out.base_index += m_base_index;
+                out.base_vertex += m_base_vertex;
+                if (!out.shape_buffer)
+                {
+                    out.shape_buffer = m_internal_shape_buffer;
+                    out.shape_buffer_offset = m_internal_shape_buffer_offset;
+                }
+            }
+        }
         LUNA_VG_API Ref<IShapeDrawList> new_shape_draw_list(RHI::IDevice* device)
         {
             auto dl = new_object<ShapeDrawList>();
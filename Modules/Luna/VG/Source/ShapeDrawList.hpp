@@ -14,6 +14,16 @@ namespace Luna
 {
     namespace VG
     {
+        enum class ShapeDrawListCompileMode : u8
+        {
+            none,
+            // Compiled to upload buffers owned by the draw list.
+            upload,
+            // Compiled to device-local buffers owned by the draw list.
+            local,
+            // Compiled to ranges allocated from one upload ring buffer.
+            ring_buffer,
+        };
         struct ShapeDrawList : IShapeDrawList
         {
             lustruct("VG::ShapeDrawList", "{44732F66-CE52-4493-85C3-6E0164C4EA18}");
@@ -30,11 +40,28 @@ namespace Luna
             u64 m_vertex_buffer_capacity;
             u64 m_index_buffer_capacity;
             u64 m_internal_shape_buffer_capacity;
+            // Offsets of compiled data in buffers, used when the data is allocated from one upload ring buffer.
+            u32 m_base_vertex;
+            u32 m_base_index;
+            u32 m_internal_shape_buffer_offset;
+            ShapeDrawListCompileMode m_compile_mode;
+            // If `true`, then the recorded data is modified after the last compile.
+            bool m_modified;
 
             Vector<ShapeDrawCall> m_draw_calls;
             Vector<Vertex> m_vertices;
             Vector<u32> m_indices;
             Vector<f32> m_internal_shape_points;
+            // The index of the first vertex of every shape in the internal shape buffer that should be banded in `compile`.
+            Vector<u32> m_banding_shapes;
+            // The offsets of data of every batch appended by `draw_shape_batches`, kept to avoid allocations.
+            struct ShapeBatchOffset
+            {
+                usize point;
+                usize vertex;
+                usize index;
+            };
+            Vector<ShapeBatchOffset> m_batch_offsets;
 
             // Current draw state.
             Ref<RHI::IBuffer> m_shape_buffer;
@@ -53,12 +80,21 @@ namespace Luna
                 dc.shape_buffer = m_shape_buffer;
                 dc.texture = m_texture;
                 dc.sampler = m_sampler;
-                dc.origin_point = m_origin;
-                dc.rotation = m_rotation;
+                // The origin and rotation are applied to vertices directly, so that changing them does not break draw calls.
+                dc.origin_point = Float2U(0.0f);
+                dc.rotation = 0.0f;
                 dc.base_index = (u32)m_indices.size();
                 dc.num_indices = 0;
+                dc.base_vertex = 0;
+                dc.shape_buffer_offset = 0;
             }
             ShapeDrawCall& get_current_draw_call();
+            // Applies the current origin and rotation to vertex positions.
+            void transform_vertices(Vertex* vertices, usize num_vertices);
+            // Converts shapes recorded in `m_banding_shapes` to banded shapes.
+            void build_bands();
+            // Ensures that the draw list owns buffers of the specified memory type that can hold all recorded data.
+            RV reserve_buffers(ShapeDrawListCompileMode mode);
             static RHI::SamplerDesc get_default_sampler()
             {
                 return RHI::SamplerDesc(RHI::Filter::linear, RHI::Filter::linear, RHI::Filter::linear,
@@ -74,6 +110,11 @@ namespace Luna
                 m_index_buffer_capacity(0),
                 m_internal_shape_buffer_size(0),
                 m_internal_shape_buffer_capacity(0),
+                m_base_vertex(0),
+                m_base_index(0),
+                m_internal_shape_buffer_offset(0),
+                m_compile_mode(ShapeDrawListCompileMode::none),
+                m_modified(true),
                 m_sampler(get_default_sampler()),
                 m_origin(0.0f),
                 m_rotation(0.0f),
@@ -84,6 +125,8 @@ namespace Luna
             virtual Vector<f32>& get_shape_points() override
             {
                 lutsassert();
+                // The user may modify points through the returned vector.
+                m_modified = true;
                 return m_internal_shape_points;
             }
             virtual void set_shape_buffer(RHI::IBuffer* shape_buffer) override
@@ -137,11 +180,7 @@ namespace Luna
             virtual void set_origin(const Float2& origin) override
             {
                 lutsassert();
-                if (m_origin != origin)
-                {
-                    m_state_dirty = true;
-                    m_origin = origin;
-                }
+                m_origin = origin;
             }
             virtual Float2 get_origin() override
             {
@@ -150,11 +189,7 @@ namespace Luna
             virtual void set_rotation(f32 degrees) override
             {
                 lutsassert();
-                if (m_rotation != degrees)
-                {
-                    m_state_dirty = true;
-                    m_rotation = degrees;
-                }
+                m_rotation = degrees;
             }
             virtual f32 get_rotation() override
             {
@@ -165,7 +200,10 @@ namespace Luna
                 const Float2U& min_position, const Float2U& max_position,
                 const Float2U& min_shapecoord, const Float2U& max_shapecoord, u32 color,
                 const Float2U& min_texcoord, const Float2U& max_texcoord) override;
+            virtual void draw_shape_batches(Span<const ShapeBatch> batches) override;
             virtual RV compile() override;
+            virtual RV compile_static(RHI::ICommandBuffer* command_buffer) override;
+            virtual RV compile_transient(RHI::IUploadRingBuffer* ring_buffer) override;
             virtual RHI::IBuffer* get_vertex_buffer() override
             {
                 return m_vertex_buffer;
@@ -182,10 +220,7 @@ namespace Luna
             {
                 return m_index_buffer_size;
             }
-            virtual void get_draw_calls(Vector<ShapeDrawCall>& out_draw_calls) override
-            {
-                out_draw_calls.insert(out_draw_calls.end(), m_draw_calls.begin(), m_draw_calls.end());
-            }
+            virtual void get_draw_calls(Vector<ShapeDrawCall>& out_draw_calls) override;
         };
     }
 }
@@ -20,9 +20,34 @@ namespace Luna
     {
         ShaderCompiler::ShaderCompileResult g_fill_shader_vs;
         ShaderCompiler::ShaderCompileResult g_fill_shader_ps;
+        ShaderCompiler::ShaderCompileResult g_sdf_shader_ps;
         Ref<RHI::IDescriptorSetLayout> g_fill_desc_layout;
         Ref<RHI::IPipelineLayout> g_fill_playout;
         Ref<RHI::ITexture> g_white_tex;
+        // Bound to draw calls that do not have shape buffers, like draw calls of SDF glyphs.
+        Ref<RHI::IBuffer> g_empty_shape_buffer;
+
+        u32 get_copy_queue_index(RHI::IDevice* device)
+        {
+            using namespace RHI;
+            u32 copy_queue_index = U32_MAX;
+            // Prefer a dedicated copy queue if present.
+            u32 num_queues = device->get_num_command_queues();
+            for (u32 i = 0; i < num_queues; ++i)
+            {
+                auto desc = device->get_command_queue_desc(i);
+                if (desc.type == CommandQueueType::graphics && copy_queue_index == U32_MAX)
+                {
+                    copy_queue_index = i;
+                }
+                else if (desc.type == CommandQueueType::copy)
+                {
+                    copy_queue_index = i;
+                    break;
+                }
+            }
+            return copy_queue_index;
+        }
 
         RV init_render_resources()
         {
@@ -50,6 +75,10 @@ namespace Luna
                     params.shader_model = {6, 0};
                     params.optimization_level = ShaderCompiler::OptimizationLevel::full;
                     luset(g_fill_shader_ps, compiler->compile(params));
+
+                    params.source = { SDF_SHADER_SOURCE_PS, SDF_SHADER_SOURCE_PS_SIZE };
+                    params.source_name = "SDFPS";
+                    luset(g_sdf_shader_ps, compiler->compile(params));
                 }
                 {
                     DescriptorSetLayoutBinding bindings[] = {
@@ -72,29 +101,14 @@ namespace Luna
                     TextureDesc desc = TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::copy_dest, 1, 1);
                     luset(g_white_tex, dev->new_texture(MemoryType::local, desc));
                     u32 data = 0xFFFFFFFF;
+                    luset(g_empty_shape_buffer, dev->new_buffer(MemoryType::local, BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::copy_dest, sizeof(f32))));
+                    f32 empty_shape = 0.0f;
                     {
-                        u32 copy_queue_index = U32_MAX;
-                        {
-                            // Prefer a dedicated copy queue if present.
-                            u32 num_queues = dev->get_num_command_queues();
-                            for (u32 i = 0; i < num_queues; ++i)
-                            {
-                                auto desc = dev->get_command_queue_desc(i);
-                                if (desc.type == CommandQueueType::graphics && copy_queue_index == U32_MAX)
-                                {
-                                    copy_queue_index = i;
-                                }
-                                else if (desc.type == CommandQueueType::copy)
-                                {
-                                    copy_queue_index = i;
-                                    break;
-                                }
-                            }
-                        }
-                        lulet(upload_cmdbuf, dev->new_command_buffer(copy_queue_index));
+                        lulet(upload_cmdbuf, dev->new_command_buffer(get_copy_queue_index(dev)));
                         luexp(copy_resource_data(upload_cmdbuf, {
                             CopyResourceData::write_texture(g_white_tex, SubresourceIndex(0, 0), 0, 0, 0, 
-                            &data, sizeof(data), sizeof(data), 1, 1, 1)
+                            &data, sizeof(data), sizeof(data), 1, 1, 1),
+                            CopyResourceData::write_buffer(g_empty_shape_buffer, 0, &empty_shape, sizeof(f32))
                         }));
                     }
                 }
@@ -108,9 +122,12 @@ namespace Luna
             g_fill_shader_vs.entry_point.reset();
             g_fill_shader_ps.data.clear();
             g_fill_shader_ps.entry_point.reset();
+            g_sdf_shader_ps.data.clear();
+            g_sdf_shader_ps.entry_point.reset();
             g_fill_desc_layout = nullptr;
             g_fill_playout = nullptr;
             g_white_tex = nullptr;
+            g_empty_shape_buffer = nullptr;
         }
         RV FillShapeRenderer::create_pso(RHI::Format rt_format)
         {
@@ -132,7 +149,7 @@ namespace Luna
                 desc.input_layout = InputLayoutDesc({bindings, 1}, {attributes, 6});
                 desc.pipeline_layout = g_fill_playout;
                 desc.vs = get_shader_data_from_compile_result(g_fill_shader_vs);
-                desc.ps = get_shader_data_from_compile_result(g_fill_shader_ps);
+                desc.ps = get_shader_data_from_compile_result(m_sdf ? g_sdf_shader_ps : g_fill_shader_ps);
                 desc.blend_state = BlendDesc({ AttachmentBlendDesc(true, BlendFactor::src_alpha, BlendFactor::one_minus_src_alpha, BlendOp::add, BlendFactor::zero,
                         BlendFactor::one, BlendOp::add, ColorWriteMask::all) });
                 desc.rasterizer_state = RasterizerDesc(FillMode::solid, CullMode::back, false, false, false, false, false);
@@ -179,6 +196,26 @@ namespace Luna
             auto dev = get_main_device();
             lutry
             {
+                // Merges adjacent draw calls that use the same states and continuous indices.
+                Vector<ShapeDrawCall> merged_draw_calls;
+                merged_draw_calls.reserve(draw_calls.size());
+                for (auto& dc : draw_calls)
+                {
+                    if (!merged_draw_calls.empty())
+                    {
+                        auto& last = merged_draw_calls.back();
+                        if (last.shape_buffer == dc.shape_buffer && last.texture == dc.texture && last.sampler == dc.sampler &&
+                            last.origin_point == dc.origin_point && last.rotation == dc.rotation &&
+                            last.base_vertex == dc.base_vertex && last.shape_buffer_offset == dc.shape_buffer_offset &&
+                            last.base_index + last.num_indices == dc.base_index)
+                        {
+                            last.num_indices += dc.num_indices;
+                            continue;
+                        }
+                    }
+                    merged_draw_calls.push_back(dc);
+                }
+                draw_calls = { merged_draw_calls.data(), merged_draw_calls.size() };
                 u32 cb_element_size = (u32)align_upper(sizeof(Float4x4U), dev->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment);
                 usize num_draw_calls = draw_calls.size();
                 u64 cb_size = cb_element_size * num_draw_calls;
@@ -218,10 +255,12 @@ namespace Luna
                     }
                     auto& ds = m_desc_sets[i];
                     auto& dc = draw_calls[i];
-                    auto num_points = dc.shape_buffer->get_desc().size / sizeof(f32);
+                    IBuffer* shape_buffer = dc.shape_buffer ? dc.shape_buffer.get() : g_empty_shape_buffer.get();
+                    u32 shape_buffer_offset = dc.shape_buffer ? dc.shape_buffer_offset : 0;
+                    auto num_points = shape_buffer->get_desc().size / sizeof(f32) - shape_buffer_offset;
                     luexp(ds->update_descriptors({
                         WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(m_cbs_resource, i * cb_element_size)),
-                        WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(dc.shape_buffer, 0, num_points, 4)),
+                        WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(shape_buffer, shape_buffer_offset, num_points, 4)),
                         WriteDescriptorSet::read_texture_view(2, TextureViewDesc::tex2d(dc.texture ? dc.texture : g_white_tex)),
                         WriteDescriptorSet::sampler(3, dc.sampler)
                         }));
@@ -237,7 +276,16 @@ namespace Luna
                         barriers.push_back({ draw_calls[i].texture, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none });
                     }
                 }
-                cmdbuf->resource_barrier({}, { barriers.data(), (u32)barriers.size()});
+                // Vertex, index and shape buffers may be device-local buffers written by copy commands.
+                Vector<BufferBarrier> buffer_barriers;
+                buffer_barriers.push_back({ vertex_buffer, BufferStateFlag::automatic, BufferStateFlag::vertex_buffer, ResourceBarrierFlag::none });
+                buffer_barriers.push_back({ index_buffer, BufferStateFlag::automatic, BufferStateFlag::index_buffer, ResourceBarrierFlag::none });
+                for (usize i = 0; i < num_draw_calls; ++i)
+                {
+                    IBuffer* shape_buffer = draw_calls[i].shape_buffer ? draw_calls[i].shape_buffer.get() : g_empty_shape_buffer.get();
+                    buffer_barriers.push_back({ shape_buffer, BufferStateFlag::automatic, BufferStateFlag::shader_read_ps, ResourceBarrierFlag::none });
+                }
+                cmdbuf->resource_barrier({ buffer_barriers.data(), (u32)buffer_barriers.size() }, { barriers.data(), (u32)barriers.size()});
                 RenderPassDesc desc;
                 desc.color_attachments[0] = ColorAttachment(m_render_target, LoadOp::clear, StoreOp::store, Float4U{ 0.0f });
                 cmdbuf->begin_render_pass(desc);
@@ -254,7 +302,7 @@ namespace Luna
                     IDescriptorSet* ds = m_desc_sets[i];
                     cmdbuf->set_graphics_descriptor_sets(0, { &ds, 1 });
                     cmdbuf->set_scissor_rect(RectI(0, 0, m_screen_width, m_screen_height));
-                    cmdbuf->draw_indexed(draw_calls[i].num_indices, draw_calls[i].base_index, 0);
+                    cmdbuf->draw_indexed(draw_calls[i].num_indices, draw_calls[i].base_index, (i32)draw_calls[i].base_vertex);
                 }
                 cmdbuf->end_render_pass();
             }
@@ -273,5 +321,18 @@ namespace Luna
             ret = renderer;
             return ret;
         }
+        LUNA_VG_API R<Ref<IShapeRenderer>> new_sdf_shape_renderer(RHI::ITexture* render_target)
+        {
+            Ref<IShapeRenderer> ret;
+            Ref<FillShapeRenderer> renderer = new_object<FillShapeRenderer>();
+            renderer->m_sdf = true;
+            lutry
+            {
+                luexp(renderer->init(render_target));
+            }
+            lucatchret;
+            ret = renderer;
+            return ret;
+        }
     }
 }
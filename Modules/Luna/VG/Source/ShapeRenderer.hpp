@@ -17,11 +17,15 @@ namespace Luna
     {
         RV init_render_resources();
         void deinit_render_resources();
+        // Gets the index of the command queue used for uploading data, prefers one dedicated copy queue if present.
+        u32 get_copy_queue_index(RHI::IDevice* device);
 
         extern const c8 FILL_SHADER_SOURCE_VS[];
         extern const c8 FILL_SHADER_SOURCE_PS[];
         extern usize FILL_SHADER_SOURCE_VS_SIZE;
         extern usize FILL_SHADER_SOURCE_PS_SIZE;
+        extern const c8 SDF_SHADER_SOURCE_PS[];
+        extern usize SDF_SHADER_SOURCE_PS_SIZE;
 
         struct FillShapeRenderer : IShapeRenderer
         {
@@ -39,11 +43,14 @@ namespace Luna
             Vector<Ref<RHI::IDescriptorSet>> m_desc_sets;
             Ref<RHI::IBuffer> m_cbs_resource;
             usize m_cbs_capacity;
+            // If `true`, glyphs are rendered from distance field textures instead of shape contours.
+            bool m_sdf;
 
             FillShapeRenderer() :
                 m_screen_width(0),
                 m_screen_height(0),
                 m_cbs_capacity(0),
+                m_sdf(false),
                 m_rt_format(RHI::Format::unknown) {}
 
             RV create_pso(RHI::Format rt_format);
@@ -11,6 +11,7 @@
 #define LUNA_VG_API LUNA_EXPORT
 #include "../Shapes.hpp"
 #include <Luna/Runtime/Math/Vector.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
 
 namespace Luna
 {
@@ -197,5 +198,146 @@ namespace Luna
                 }
             }
         }
+        // The number of points of one segment record in banded shapes.
+        constexpr u32 BANDED_SEGMENT_SIZE = 8;
+        constexpr u32 MAX_SHAPE_BANDS = 16;
+        struct ShapeSegment
+        {
+            f32 type;
+            Float2 p0;
+            Float2 p1;
+            Float2 p2;
+            f32 radius;
+            // The bounding rect of the segment.
+            Float2 min_point;
+            Float2 max_point;
+        };
+        static Float2 circle_get_point(const Float2& center, f32 radius, f32 angle)
+        {
+            angle = angle * PI / 180.0f;
+            return center + radius * Float2(cosf(angle), sinf(angle));
+        }
+        static void get_shape_segments(Span<const f32> commands, Vector<ShapeSegment>& out_segments)
+        {
+            Float2 last_point = Float2(0.0f);
+            usize i = 0;
+            while (i < commands.size())
+            {
+                f32 command = commands[i];
+                ShapeSegment seg;
+                seg.type = command;
+                seg.p0 = last_point;
+                seg.radius = 0.0f;
+                if (command == COMMAND_MOVE_TO)
+                {
+                    last_point = Float2(commands[i + 1], commands[i + 2]);
+                    i += 3;
+                    continue;
+                }
+                else if (command == COMMAND_LINE_TO)
+                {
+                    seg.p1 = Float2(commands[i + 1], commands[i + 2]);
+                    seg.p2 = seg.p1;
+                    last_point = seg.p1;
+                    seg.min_point = min(seg.p0, seg.p1);
+                    seg.max_point = max(seg.p0, seg.p1);
+                    i += 3;
+                }
+                else if (command == COMMAND_CURVE_TO)
+                {
+                    seg.p1 = Float2(commands[i + 1], commands[i + 2]);
+                    seg.p2 = Float2(commands[i + 3], commands[i + 4]);
+                    last_point = seg.p2;
+                    // The curve is always inside the triangle formed by its control points.
+                    seg.min_point = min(min(seg.p0, seg.p1), seg.p2);
+                    seg.max_point = max(max(seg.p0, seg.p1), seg.p2);
+                    i += 5;
+                }
+                else if (command >= COMMAND_CIRCLE_Q1 && command <= COMMAND_CIRCLE_Q4)
+                {
+                    seg.radius = commands[i + 1];
+                    f32 begin = commands[i + 2];
+                    f32 end = commands[i + 3];
+                    seg.p2 = circle_get_point(last_point, seg.radius, 180.0f + begin);
+                    seg.p1 = circle_get_point(seg.p2, seg.radius, end);
+                    last_point = seg.p1;
+                    // Circle parts never cross quadrants, so they are bounded by their end points.
+                    seg.min_point = min(seg.p0, seg.p1);
+                    seg.max_point = max(seg.p0, seg.p1);
+                    i += 4;
+                }
+                else
+                {
+                    lupanic_msg("Invalid shape command.");
+                    return;
+                }
+                out_segments.push_back(seg);
+            }
+        }
+        LUNA_VG_API usize build_shape_bands(Span<const f32> commands, Vector<f32>& out_points, u32 num_bands)
+        {
+            Vector<ShapeSegment> segments;
+            get_shape_segments(commands, segments);
+            if (!num_bands)
+            {
+                num_bands = clamp<u32>((u32)segments.size() / 4, 1, MAX_SHAPE_BANDS);
+            }
+            Float2 min_point = Float2(0.0f);
+            Float2 max_point = Float2(0.0f);
+            if (!segments.empty())
+            {
+                min_point = segments[0].min_point;
+                max_point = segments[0].max_point;
+                for (auto& seg : segments)
+                {
+                    min_point = min(min_point, seg.min_point);
+                    max_point = max(max_point, seg.max_point);
+                }
+            }
+            Float2 band_size = (max_point - min_point) / (f32)num_bands;
+            // Collects segments for every band.
+            Vector<Vector<u32>> bands;
+            bands.resize(num_bands * 2);
+            for (u32 s = 0; s < (u32)segments.size(); ++s)
+            {
+                auto& seg = segments[s];
+                for (u32 b = 0; b < num_bands; ++b)
+                {
+                    f32 lo = min_point.y + band_size.y * b;
+                    f32 hi = (b == num_bands - 1) ? max_point.y : lo + band_size.y;
+                    if (seg.max_point.y >= lo && seg.min_point.y <= hi) bands[b].push_back(s);
+                    lo = min_point.x + band_size.x * b;
+                    hi = (b == num_bands - 1) ? max_point.x : lo + band_size.x;
+                    if (seg.max_point.x >= lo && seg.min_point.x <= hi) bands[num_bands + b].push_back(s);
+                }
+            }
+            // Sorts segments so that the pixel shader can stop testing once one segment is before the pixel.
+            for (u32 b = 0; b < num_bands; ++b)
+            {
+                sort(bands[b].begin(), bands[b].end(), [&](u32 lhs, u32 rhs) { return segments[lhs].max_point.x > segments[rhs].max_point.x; });
+                sort(bands[num_bands + b].begin(), bands[num_bands + b].end(), [&](u32 lhs, u32 rhs) { return segments[lhs].max_point.y > segments[rhs].max_point.y; });
+            }
+            usize begin = out_points.size();
+            out_points.insert(out_points.end(), { COMMAND_BANDS, (f32)num_bands, min_point.x, min_point.y, max_point.x, max_point.y });
+            usize band_headers = out_points.size();
+            out_points.resize(band_headers + num_bands * 4);
+            usize num_band_entries = 0;
+            for (auto& band : bands) num_band_entries += band.size();
+            usize records = out_points.size() - begin + num_band_entries;
+            for (u32 b = 0; b < num_bands * 2; ++b)
+            {
+                out_points[band_headers + b * 2] = (f32)(out_points.size() - begin);
+                out_points[band_headers + b * 2 + 1] = (f32)bands[b].size();
+                for (u32 s : bands[b])
+                {
+                    out_points.push_back((f32)(records + s * BANDED_SEGMENT_SIZE));
+                }
+            }
+            for (auto& seg : segments)
+            {
+                out_points.insert(out_points.end(), { seg.type, seg.p0.x, seg.p0.y, seg.p1.x, seg.p1.y, seg.p2.x, seg.p2.y, seg.radius });
+            }
+            return out_points.size() - begin;
+        }
     }
-}
\ No newline at end of file
+}
@@ -9,7 +9,8 @@
 */
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_VG_API LUNA_EXPORT
-#include "../TextArranger.hpp"
+#include "TextArranger.hpp"
+#include "../SDFFontAtlas.hpp"
 #include <Luna/Runtime/Unicode.hpp>
 
 namespace Luna
@@ -115,11 +116,9 @@ namespace Luna
             {
                 lucheck_msg(m_sections[m_section_cursor].font_atlas, "TextArrangeSection::font_atlas must not be nullptr!");
                 m_font_atlas = m_sections[m_section_cursor].font_atlas;
-                u32 font_index;
-                auto font_file = m_font_atlas->get_font(&font_index);
-                m_font_scale = font_file->scale_for_pixel_height(font_index, m_sections[m_section_cursor].font_size);
+                m_font_scale = m_font_atlas->scale_for_pixel_height(m_sections[m_section_cursor].font_size);
                 i32 a, d, l;
-                font_file->get_vmetrics(font_index, &a, &d, &l);
+                m_font_atlas->get_vmetrics(&a, &d, &l);
                 m_ascent = (f32)a * m_font_scale;
                 m_decent = (f32)d * m_font_scale;
                 m_line_gap = (f32)l * m_font_scale;
@@ -135,9 +134,7 @@ namespace Luna
             {
                 m_char = utf8_decode_char(m_text + m_cursor);
                 i32 advance_width, left_side_bearing;
-                u32 font_index;
-                auto font_file = m_font_atlas->get_font(&font_index);
-                font_file->get_glyph_hmetrics(font_index, font_file->find_glyph(font_index, m_char), &advance_width, &left_side_bearing);
+                m_font_atlas->get_glyph_hmetrics(m_char, &advance_width, &left_side_bearing);
                 m_char_advance_length = (f32)advance_width * m_font_scale;
                 m_char_left_side_bearing = (f32)left_side_bearing * m_font_scale;
                 RectF rect;
@@ -154,9 +151,7 @@ namespace Luna
             {
                 usize section_cursor = m_section_cursor + 1;
                 auto font = m_sections[section_cursor].font_atlas;
-                u32 font_index;
-                auto font_file = font->get_font(&font_index);
-                font_scale = font_file->scale_for_pixel_height(font_index, m_sections[section_cursor].font_size);
+                font_scale = font->scale_for_pixel_height(m_sections[section_cursor].font_size);
                 return font;
             }
             font_scale = m_font_scale;
@@ -234,12 +229,12 @@ namespace Luna
                     {
                         f32 next_font_scale;
                         auto next_font_atlas = s.get_next_char_font_file(next_font_scale);
-                        u32 next_font_index;
-                        auto next_font_file = next_font_atlas->get_font(&next_font_index);
-                        u32 font_index;
-                        auto font_file = s.m_font_atlas->get_font(&font_index);
-                        kern = max((f32)font_file->get_kern_advance(font_index, font_file->find_glyph(font_index, s.m_char), font_file->find_glyph(font_index, next_char)) * s.m_font_scale,
-                            (f32)next_font_file->get_kern_advance(next_font_index, next_font_file->find_glyph(next_font_index, s.m_char), next_font_file->find_glyph(next_font_index, next_char)) * next_font_scale);
+                        // Kerning values are cached by font atlases.
+                        kern = (f32)s.m_font_atlas->get_kern_advance(s.m_char, next_char) * s.m_font_scale;
+                        if (next_font_atlas != s.m_font_atlas || next_font_scale != s.m_font_scale)
+                        {
+                            kern = max(kern, (f32)next_font_atlas->get_kern_advance(s.m_char, next_char) * next_font_scale);
+                        }
                     }
                     else kern = 0.0f;
                     kern += s.m_char_span;
@@ -369,12 +364,81 @@ namespace Luna
             return res;
         }
 
-        LUNA_VG_API RV commit_text_arrange_result(
+        static RV commit_sdf_text_arrange_result(
             const TextArrangeResult& result,
             Span<const TextArrangeSection> sections,
             IShapeDrawList* draw_list
         )
         {
+            lutry
+            {
+                Ref<RHI::ITexture> prev_tex = draw_list->get_texture();
+                Ref<RHI::IBuffer> prev_shape_buffer = draw_list->get_shape_buffer();
+                RHI::SamplerDesc prev_sampler = draw_list->get_sampler();
+                RHI::SamplerDesc sampler(RHI::Filter::linear, RHI::Filter::linear, RHI::Filter::linear, 
+                    RHI::TextureAddressMode::clamp, RHI::TextureAddressMode::clamp, RHI::TextureAddressMode::clamp);
+                draw_list->set_shape_buffer(nullptr);
+                draw_list->set_sampler(&sampler);
+                usize state_index = 0;
+                usize next_section_begin = sections[state_index].num_chars;
+                ISDFFontAtlas* atlas = nullptr;
+                usize atlas_index = USIZE_MAX;
+                f32 scale = 0.0f;
+                Float2U range;
+                for (auto& line : result.lines)
+                {
+                    for (auto& glyph : line.glyphs)
+                    {
+                        usize cursor = glyph.index;
+                        while ((state_index < sections.size() - 1) && (next_section_begin <= cursor))
+                        {
+                            ++state_index;
+                            next_section_begin += sections[state_index].num_chars;
+                        }
+                        auto& section = sections[state_index];
+                        if (atlas_index != state_index)
+                        {
+                            atlas = query_interface<ISDFFontAtlas>(section.font_atlas->get_object());
+                            luassert(atlas);
+                            // Draw calls are merged if the atlas texture does not change between sections.
+                            lulet(tex, atlas->get_texture());
+                            draw_list->set_texture(tex);
+                            auto tex_desc = tex->get_desc();
+                            auto desc = atlas->get_desc();
+                            range = Float2U((f32)desc.pixel_range / (f32)tex_desc.width, (f32)desc.pixel_range / (f32)tex_desc.height);
+                            scale = atlas->scale_for_pixel_height(section.font_size);
+                            atlas_index = state_index;
+                        }
+                        RectF texcoord;
+                        RectF rect;
+                        if (!atlas->get_sdf_glyph(glyph.character, &texcoord, &rect)) continue;
+                        Float2U origin(line.bounding_rect.offset_x + glyph.origin_offset, line.bounding_rect.offset_y - line.decent);
+                        Float2U min_position(origin.x + rect.offset_x * scale, origin.y + rect.offset_y * scale);
+                        Float2U max_position(min_position.x + rect.width * scale, min_position.y + rect.height * scale);
+                        // The first row of the glyph bitmap is the top of the glyph.
+                        draw_list->draw_shape(0, 0, min_position, max_position, range, range, section.color,
+                            Float2U(texcoord.offset_x, texcoord.offset_y + texcoord.height),
+                            Float2U(texcoord.offset_x + texcoord.width, texcoord.offset_y));
+                    }
+                }
+                draw_list->set_texture(prev_tex);
+                draw_list->set_shape_buffer(prev_shape_buffer);
+                draw_list->set_sampler(&prev_sampler);
+            }
+            lucatchret;
+            return ok;
+        }
+        LUNA_VG_API RV commit_text_arrange_result(
+            const TextArrangeResult& result,
+            Span<const TextArrangeSection> sections,
+            IShapeDrawList* draw_list,
+            TextRenderMode mode
+        )
+        {
+            if (mode == TextRenderMode::sdf)
+            {
+                return commit_sdf_text_arrange_result(result, sections, draw_list);
+            }
             lutry
             {
                 usize state_index = 0;
@@ -412,5 +476,106 @@ namespace Luna
             lucatchret;
             return ok;
         }
+
+        usize TextArrangeCache::hash_key(const c8* text, usize text_len, Span<const TextArrangeSection> sections,
+            const RectF& bounding_rect, TextAlignment vertical_alignment, TextAlignment horizontal_alignment)
+        {
+            usize h = memhash<usize>(text, text_len);
+            for (auto& section : sections)
+            {
+                h = memhash<usize>(&section.font_atlas, sizeof(IFontAtlas*), h);
+                h = memhash<usize>(&section.num_chars, sizeof(usize), h);
+                h = memhash<usize>(&section.font_size, sizeof(f32), h);
+                h = memhash<usize>(&section.char_span, sizeof(f32), h);
+                h = memhash<usize>(&section.line_span, sizeof(f32), h);
+            }
+            h = memhash<usize>(&bounding_rect, sizeof(RectF), h);
+            u8 alignments[2] = { (u8)vertical_alignment, (u8)horizontal_alignment };
+            return memhash<usize>(alignments, sizeof(alignments), h);
+        }
+        bool TextArrangeCache::Entry::match(const c8* text, usize text_len, Span<const TextArrangeSection> sections,
+            const RectF& bounding_rect, TextAlignment vertical_alignment, TextAlignment horizontal_alignment) const
+        {
+            if (m_text.size() != text_len || memcmp(m_text.data(), text, text_len)) return false;
+            if (m_sections.size() != sections.size()) return false;
+            for (usize i = 0; i < sections.size(); ++i)
+            {
+                auto& key = m_sections[i];
+                auto& section = sections[i];
+                if (key.font_atlas != section.font_atlas || key.num_chars != section.num_chars || key.font_size != section.font_size ||
+                    key.char_span != section.char_span || key.line_span != section.line_span) return false;
+            }
+            return m_bounding_rect == bounding_rect && m_vertical_alignment == vertical_alignment && 
+                m_horizontal_alignment == horizontal_alignment;
+        }
+        const TextArrangeResult& TextArrangeCache::arrange(
+            const c8* text, usize text_len,
+            Span<const TextArrangeSection> sections,
+            const RectF& bounding_rect,
+            TextAlignment vertical_alignment, 
+            TextAlignment horizontal_alignment
+        )
+        {
+            lutsassert();
+            if (text_len == USIZE_MAX) text_len = strlen(text);
+            usize h = hash_key(text, text_len, sections, bounding_rect, vertical_alignment, horizontal_alignment);
+            auto iter = m_entries.find(h);
+            if (iter != m_entries.end() && 
+                iter->second.match(text, text_len, sections, bounding_rect, vertical_alignment, horizontal_alignment))
+            {
+                iter->second.m_last_used_frame = m_frame;
+                return iter->second.m_result;
+            }
+            // Replaces the existing entry if the hash collides.
+            Entry entry;
+            entry.m_text.assign(text, text_len);
+            entry.m_sections.reserve(sections.size());
+            for (auto& section : sections)
+            {
+                SectionKey key;
+                key.font_atlas = section.font_atlas;
+                key.num_chars = section.num_chars;
+                key.font_size = section.font_size;
+                key.char_span = section.char_span;
+                key.line_span = section.line_span;
+                entry.m_sections.push_back(key);
+            }
+            entry.m_bounding_rect = bounding_rect;
+            entry.m_vertical_alignment = vertical_alignment;
+            entry.m_horizontal_alignment = horizontal_alignment;
+            entry.m_result = arrange_text(text, text_len, sections, bounding_rect, vertical_alignment, horizontal_alignment);
+            entry.m_last_used_frame = m_frame;
+            if (iter != m_entries.end())
+            {
+                iter->second = move(entry);
+            }
+            else
+            {
+                iter = m_entries.insert(make_pair(h, move(entry))).first;
+            }
+            return iter->second.m_result;
+        }
+        void TextArrangeCache::new_frame()
+        {
+            lutsassert();
+            ++m_frame;
+            for (auto iter = m_entries.begin(); iter != m_entries.end();)
+            {
+                if (m_frame - iter->second.m_last_used_frame > m_max_unused_frames)
+                {
+                    iter = m_entries.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
+        }
+        LUNA_VG_API Ref<ITextArrangeCache> new_text_arrange_cache(u32 max_unused_frames)
+        {
+            Ref<TextArrangeCache> cache = new_object<TextArrangeCache>();
+            cache->m_max_unused_frames = max_unused_frames;
+            return cache;
+        }
     }
 }
\ No newline at end of file
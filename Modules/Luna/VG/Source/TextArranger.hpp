@@ -0,0 +1,76 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file TextArranger.hpp
+* @author JXMaster
+* @date 2024/4/20
+*/
+#pragma once
+#include "../TextArranger.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/TSAssert.hpp>
+
+namespace Luna
+{
+    namespace VG
+    {
+        struct TextArrangeCache : ITextArrangeCache
+        {
+            lustruct("VG::TextArrangeCache", "{0D5A7C13-9E42-4B6F-A8D1-C3F2E6B07F48}");
+            luiimpl();
+            lutsassert_lock();
+
+            // Section parameters that affect arranging.
+            struct SectionKey
+            {
+                Ref<IFontAtlas> font_atlas;
+                usize num_chars;
+                f32 font_size;
+                f32 char_span;
+                f32 line_span;
+            };
+
+            struct Entry
+            {
+                String m_text;
+                Vector<SectionKey> m_sections;
+                RectF m_bounding_rect;
+                TextAlignment m_vertical_alignment;
+                TextAlignment m_horizontal_alignment;
+                TextArrangeResult m_result;
+                u64 m_last_used_frame;
+
+                bool match(const c8* text, usize text_len, Span<const TextArrangeSection> sections,
+                    const RectF& bounding_rect, TextAlignment vertical_alignment, TextAlignment horizontal_alignment) const;
+            };
+
+            HashMap<usize, Entry> m_entries;
+            u64 m_frame = 0;
+            u32 m_max_unused_frames = 60;
+
+            static usize hash_key(const c8* text, usize text_len, Span<const TextArrangeSection> sections,
+                const RectF& bounding_rect, TextAlignment vertical_alignment, TextAlignment horizontal_alignment);
+
+            virtual const TextArrangeResult& arrange(
+                const c8* text, usize text_len,
+                Span<const TextArrangeSection> sections,
+                const RectF& bounding_rect,
+                TextAlignment vertical_alignment, 
+                TextAlignment horizontal_alignment
+            ) override;
+            virtual void new_frame() override;
+            virtual void clear() override
+            {
+                lutsassert();
+                m_entries.clear();
+            }
+            virtual usize get_num_cached_results() override
+            {
+                return m_entries.size();
+            }
+        };
+    }
+}
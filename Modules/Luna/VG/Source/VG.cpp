@@ -12,9 +12,12 @@
 #include "FontAtlas.hpp"
 #include "ShapeDrawList.hpp"
 #include "ShapeRenderer.hpp"
+#include "TextArranger.hpp"
+#include "SDFFontAtlas.hpp"
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/RHI/RHI.hpp>
 #include <Luna/ShaderCompiler/ShaderCompiler.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
 
 namespace Luna
 {
@@ -25,7 +28,7 @@ namespace Luna
             virtual const c8* get_name() override { return "VG"; }
             virtual RV on_register() override
             {
-                return add_dependency_modules(this, {module_rhi(), module_shader_compiler()});
+                return add_dependency_modules(this, {module_job_system(), module_rhi(), module_shader_compiler()});
             }
             virtual RV on_init() override
             {
@@ -35,6 +38,10 @@ namespace Luna
                 impl_interface_for_type<ShapeDrawList, IShapeDrawList>();
                 register_boxed_type<FillShapeRenderer>();
                 impl_interface_for_type<FillShapeRenderer, IShapeRenderer>();
+                register_boxed_type<TextArrangeCache>();
+                impl_interface_for_type<TextArrangeCache, ITextArrangeCache>();
+                register_boxed_type<SDFFontAtlas>();
+                impl_interface_for_type<SDFFontAtlas, ISDFFontAtlas, IFontAtlas>();
                 return init_render_resources();
             }
             virtual void on_close() override
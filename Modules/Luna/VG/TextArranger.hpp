@@ -125,17 +125,88 @@ namespace Luna
             TextAlignment horizontal_alignment
         );
 
+        //! Specifies how glyphs are rendered when committing text arrange results to draw lists.
+        enum class TextRenderMode : u8
+        {
+            //! Glyphs are rendered by evaluating glyph contours in the shape buffer directly.
+            //! This generates high-quality glyphs at any size, and should be rendered by @ref new_fill_shape_renderer.
+            analytic = 0,
+            //! Glyphs are rendered by sampling multi-channel signed distance field bitmaps stored in @ref ISDFFontAtlas.
+            //! This is faster for small text, and should be rendered by @ref new_sdf_shape_renderer.
+            //! Font atlases of all sections must implement @ref ISDFFontAtlas to use this mode.
+            sdf = 1,
+        };
+
+        //! The maximum font size in pixels that should be rendered with @ref TextRenderMode::sdf.
+        //! Larger glyphs are rendered with @ref TextRenderMode::analytic, since distance field bitmaps lose
+        //! sharp corners when being magnified too much.
+        constexpr f32 SDF_TEXT_MAX_FONT_SIZE = 48.0f;
+
+        //! Selects the preferred text render mode for the specified font size.
+        //! @param[in] font_size The font size in pixels.
+        //! @return Returns @ref TextRenderMode::sdf if `font_size` is not greater than @ref SDF_TEXT_MAX_FONT_SIZE, 
+        //! returns @ref TextRenderMode::analytic otherwise.
+        inline TextRenderMode select_text_render_mode(f32 font_size)
+        {
+            return font_size <= SDF_TEXT_MAX_FONT_SIZE ? TextRenderMode::sdf : TextRenderMode::analytic;
+        }
+
         //! Commits the text arrange result to the specicied draw list for rendering.
         //! @param[in] result The text arrange result.
         //! @param[in] sections The text arrange sections. This must be the same sections
         //! passed to @ref arrange_text when arranging texts.
         //! @param[in] draw_list The draw list to commit text arrange result to.
+        //! @param[in] mode The render mode of glyphs. Since one draw list is rendered by one shape renderer, all texts 
+        //! committed to the same draw list should use the same mode.
+        //! @par Valid Usage
+        //! * If `mode` is @ref TextRenderMode::sdf, font atlases of all sections must implement @ref ISDFFontAtlas.
         LUNA_VG_API RV commit_text_arrange_result(
             const TextArrangeResult& result,
             Span<const TextArrangeSection> sections,
-            IShapeDrawList* draw_list
+            IShapeDrawList* draw_list,
+            TextRenderMode mode = TextRenderMode::analytic
         );
 
+        //! @interface ITextArrangeCache
+        //! Caches text arrange results, so that arranging the same text with the same parameters again costs only one hash lookup.
+        //! @details This is useful for UI and HUD that arrange the same strings every frame. Results are keyed by the text, the 
+        //! font atlas, font size, character span and line span of every section, the bounding rectangle and alignments. Section colors 
+        //! are not part of the key, since they do not affect arranging.
+        //!
+        //! Cached results depend on font metrics, so the user should call @ref clear if the font of one font atlas used by the cache is
+        //! changed by @ref IFontAtlas::set_font.
+        struct ITextArrangeCache : virtual Interface
+        {
+            luiid("{6B2E8D41-A3F7-4C95-8E0D-2F17B9C4D536}");
+
+            //! Arranges glyphs in the specified bounding rectangle, or returns the cached result if the same text is arranged with the same
+            //! parameters before. See @ref arrange_text for details of parameters.
+            //! @return Returns the text arrange result. The returned reference is valid until the next call to @ref arrange, 
+            //! @ref new_frame or @ref clear.
+            virtual const TextArrangeResult& arrange(
+                const c8* text, usize text_len,
+                Span<const TextArrangeSection> sections,
+                const RectF& bounding_rect,
+                TextAlignment vertical_alignment, 
+                TextAlignment horizontal_alignment
+            ) = 0;
+
+            //! Begins one new frame, and removes results that are not used in the last `max_unused_frames` frames.
+            virtual void new_frame() = 0;
+
+            //! Removes all cached results.
+            virtual void clear() = 0;
+
+            //! Gets the number of cached results.
+            virtual usize get_num_cached_results() = 0;
+        };
+
+        //! Creates one new text arrange cache.
+        //! @param[in] max_unused_frames The maximum number of frames a cached result can be kept without being used. 
+        //! Results not used for more frames are removed in @ref ITextArrangeCache::new_frame.
+        //! @return Returns the created text arrange cache.
+        LUNA_VG_API Ref<ITextArrangeCache> new_text_arrange_cache(u32 max_unused_frames = 60);
+
         //! @}
     }
 }
\ No newline at end of file
@@ -1,6 +1,9 @@
+add_requires("stb")
+
 luna_sdk_module_target("VG")
     add_headerfiles("*.hpp", {prefixdir = "Luna/VG"})
     add_headerfiles("Source/**.hpp", {install = false})
     add_files("Source/**.cpp")
-    add_deps("Runtime", "RHI", "ShaderCompiler")
+    add_deps("Runtime", "JobSystem", "RHI", "ShaderCompiler")
+    add_packages("stb")
 target_end()
\ No newline at end of file
@@ -0,0 +1,58 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Binary.hpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#pragma once
+#include <Luna/Runtime/Variant.hpp>
+#include <Luna/Runtime/Stream.hpp>
+#include <Luna/Runtime/Blob.hpp>
+
+#ifndef LUNA_VARIANT_UTILS_API
+#define LUNA_VARIANT_UTILS_API
+#endif
+
+namespace Luna
+{
+    namespace VariantUtils
+    {
+        //! @addtogroup VariantUtils
+        //! @{
+
+        //! Parses one variant encoded in the binary variant format.
+        //! @details The binary variant format is one compact encoding of @ref Variant that can be read and written much faster
+        //! than text formats. Integers are encoded as variable-length integers, BLOB data is stored as raw bytes without any
+        //! text encoding, and every distinct object key and string value is stored only once in one name table at the beginning
+        //! of the data, so that it is interned only once when being read.
+        //! @param[in] src The binary data to read.
+        //! @param[in] src_size The size of the binary data in bytes. The actual read bytes may be smaller than this if the data ends early.
+        //! @param[in] arena If not `nullptr`, storage of objects and arrays is allocated from this arena. See
+        //! @ref Variant::Variant(VariantType, usize, Arena*) for details.
+        //! @return Returns one variant that contains the data read from the binary data.
+        LUNA_VARIANT_UTILS_API R<Variant> read_binary(const void* src, usize src_size, Arena* arena = nullptr);
+
+        //! Parses one variant encoded in the binary variant format.
+        //! @param[in] stream The stream that contains the binary data to read. @ref IStream::read will be called to read binary data
+        //! from the stream.
+        //! @param[in] arena If not `nullptr`, storage of objects and arrays is allocated from this arena. See
+        //! @ref Variant::Variant(VariantType, usize, Arena*) for details.
+        //! @return Returns one variant that contains the data read from the binary data.
+        LUNA_VARIANT_UTILS_API R<Variant> read_binary(IStream* stream, Arena* arena = nullptr);
+
+        //! Encodes one variant object in the binary variant format. See @ref read_binary for details.
+        //! @param[in] v The variant object that contains data to write.
+        //! @return Returns the encoded binary data.
+        LUNA_VARIANT_UTILS_API Blob write_binary(const Variant& v);
+
+        //! Encodes one variant object in the binary variant format. See @ref read_binary for details.
+        //! @param[in] stream The stream to write binary data to.
+        //! @param[in] v The variant object that contains data to write.
+        LUNA_VARIANT_UTILS_API RV write_binary(IStream* stream, const Variant& v);
+
+        //! @}
+    }
+}
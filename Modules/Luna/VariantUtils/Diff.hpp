@@ -21,12 +21,66 @@ namespace Luna
         //! @addtogroup VariantUtils
         //! @{
 
+        //! Specifies how arrays are compared by @ref diff.
+        enum class DiffArrayMode : u8
+        {
+            //! Finds the longest common subsequence of elements, so that elements inserted or removed in the middle of the array
+            //! are recorded as insertions and removals. Falls back to @ref DiffArrayMode::positional if the number of element 
+            //! pairs to compare exceeds @ref DiffDesc::max_lcs_size.
+            lcs = 0,
+            //! Compares elements at the same index, and records extra elements as insertions or removals at the end of the array.
+            //! This takes linear time but generates larger deltas if elements are inserted or removed in the middle of the array.
+            positional = 1,
+        };
+
+        //! The function that invokes one callback for every index in [`0`, `count`), possibly on multiple threads.
+        //! @param[in] userdata The user data specified in @ref DiffDesc::parallel_for_userdata.
+        //! @param[in] count The number of indices to process.
+        //! @param[in] func The callback to invoke for every index.
+        //! @param[in] func_ctx The context that must be passed to `func`.
+        //! @remark This function must not return until all indices are processed.
+        using diff_parallel_for_t = void(void* userdata, usize count, void(*func)(void* func_ctx, usize index), void* func_ctx);
+
+        //! Describes additional options for @ref diff.
+        struct DiffDesc
+        {
+            //! The mode used to compare arrays.
+            DiffArrayMode array_mode = DiffArrayMode::lcs;
+            //! The maximum number of element pairs compared when finding the longest common subsequence of two arrays.
+            //! @details Finding the longest common subsequence takes `O(M*N)` time and memory for arrays with `M` and `N` changed elements,
+            //! arrays that exceed this limit are compared by @ref DiffArrayMode::positional instead.
+            usize max_lcs_size = 1024 * 1024;
+            //! The function used to diff children of large objects and arrays in parallel. If this is `nullptr`, all children are diffed 
+            //! on the calling thread.
+            //! @details For example, the following function diffs children using the job system:
+            //! ```
+            //! void diff_parallel_for(void* userdata, usize count, void(*func)(void* func_ctx, usize index), void* func_ctx)
+            //! {
+            //!     JobSystem::parallel_for(0, count, 0, [&](usize i) { func(func_ctx, i); });
+            //! }
+            //! ```
+            diff_parallel_for_t* parallel_for = nullptr;
+            //! The user data passed to @ref parallel_for.
+            void* parallel_for_userdata = nullptr;
+            //! The minimum number of changed children of one object or array that are diffed in parallel.
+            usize parallel_threshold = 64;
+        };
+
         //! Creates one delta variant that stores changes from `before` to `after`.
         //! @param[in] before The first variant to compare.
         //! @param[in] after The second variant to compare.
         //! @return Return one delta variant that stores changes from `before` to `after`.
+        //! @remark The system computes one 64-bit hash for every object, array and blob in both variants before comparing them, 
+        //! so that unchanged subtrees are skipped by comparing their hashes. Two subtrees with the same hash are treated as unchanged.
         LUNA_VARIANT_UTILS_API Variant diff(const Variant& before, const Variant& after);
 
+        //! Creates one delta variant that stores changes from `before` to `after` with additional options.
+        //! @param[in] before The first variant to compare.
+        //! @param[in] after The second variant to compare.
+        //! @param[in] desc The options used to compute the delta.
+        //! @return Return one delta variant that stores changes from `before` to `after`.
+        LUNA_VARIANT_UTILS_API Variant diff(const Variant& before, const Variant& after, const DiffDesc& desc);
+
         //! Applys the difference to the variant, so that it contains the same data as `after` when the diff object
         //! is created.
         //! @param[in] before The variant to patch.
@@ -29,20 +29,116 @@ namespace Luna
         //! 
         //! If this value is greater than `strlen(src)`, `strlen(src)` will be used as the maximum number of characters to read
         //! instead of this value. So specifing @ref USIZE_MAX will let the system detects the string length automatically.
+        //! @param[in] arena If not `nullptr`, storage of objects and arrays is allocated from this arena. See
+        //! @ref Variant::Variant(VariantType, usize, Arena*) for details.
         //! @return Returns one variant that contains the data read from the JSON string.
-        LUNA_VARIANT_UTILS_API R<Variant> read_json(const c8* src, usize src_size = USIZE_MAX);
+        LUNA_VARIANT_UTILS_API R<Variant> read_json(const c8* src, usize src_size = USIZE_MAX, Arena* arena = nullptr);
+
+        //! Reads JSON data from one string view.
+        //! @param[in] src The string view that contains JSON data. The string does not need to be null-terminated.
+        //! @param[in] arena See @ref read_json for details.
+        //! @return Returns the read variant object.
+        inline R<Variant> read_json(StringView src, Arena* arena = nullptr)
+        {
+            return read_json(src.data(), src.size(), arena);
+        }
 
         //! Parses one JSON string.
         //! @param[in] stream The stream that contains the JSON string to read. @ref IStream::read will be called to read JSON string
         //! from the stream.
+        //! @param[in] arena If not `nullptr`, storage of objects and arrays is allocated from this arena. See
+        //! @ref Variant::Variant(VariantType, usize, Arena*) for details.
         //! @return Returns one variant that contains the data read from the JSON string.
-        LUNA_VARIANT_UTILS_API R<Variant> read_json(IStream* stream);
+        LUNA_VARIANT_UTILS_API R<Variant> read_json(IStream* stream, Arena* arena = nullptr);
+
+        //! The handler that receives events when one JSON string is parsed by @ref read_json_events.
+        //! @details Events are emitted in document order. If any method of the handler fails, parsing stops and the error is
+        //! returned from @ref read_json_events.
+        struct JSONReadHandler
+        {
+            //! Called when one object begins. Every field of the object is reported by one @ref on_key call
+            //! followed by events of the field value, then @ref on_end_object is called.
+            virtual RV on_begin_object() = 0;
+            //! Called before events of every object field value.
+            //! @param[in] key The key of the field.
+            virtual RV on_key(const Name& key) = 0;
+            //! Called when one object ends.
+            virtual RV on_end_object() = 0;
+            //! Called when one array begins. Events of every array element follow this, then @ref on_end_array is called.
+            virtual RV on_begin_array() = 0;
+            //! Called when one array ends.
+            virtual RV on_end_array() = 0;
+            //! Called for every null, Boolean, number, string and BLOB value.
+            //! @param[in] value The value. The handler may move data out of this variant.
+            virtual RV on_value(Variant& value) = 0;
+        };
+
+        //! Parses one JSON string and reports its content to one handler without building variants for objects and arrays.
+        //! @details Use this instead of @ref read_json to read large JSON data into user-defined structures directly.
+        //! @param[in] handler The handler to receive parsing events.
+        //! @param[in] src The JSON string to read.
+        //! @param[in] src_size The maximum number of characters to read in `src`. See @ref read_json for details.
+        LUNA_VARIANT_UTILS_API RV read_json_events(JSONReadHandler& handler, const c8* src, usize src_size = USIZE_MAX);
+
+        //! Parses one JSON string and reports its content to one handler without building variants for objects and arrays.
+        //! @param[in] handler The handler to receive parsing events.
+        //! @param[in] stream The stream that contains the JSON string to read.
+        LUNA_VARIANT_UTILS_API RV read_json_events(JSONReadHandler& handler, IStream* stream);
+
+        //! Represents one JSON value in one UTF-8 JSON string that is parsed only when it is accessed.
+        //! @details Views are created by @ref view_json, and views of child values can be fetched by @ref get_json_view_field and
+        //! @ref get_json_view_element, which skip other values without parsing them. The JSON string must be valid and unchanged
+        //! when the view and views fetched from it are used.
+        struct JSONView
+        {
+            //! The beginning of the JSON string, used to compute line and position information on errors.
+            const c8* src = nullptr;
+            //! The first character of the value.
+            const c8* value = nullptr;
+            //! The end of the JSON string.
+            const c8* end = nullptr;
+        };
+
+        //! Creates one view of the root value of one UTF-8 JSON string.
+        //! @param[in] src The JSON string.
+        //! @param[in] src_size The maximum number of characters to read in `src`. See @ref read_json for details.
+        //! @return Returns the created view. This operation does not parse the string.
+        LUNA_VARIANT_UTILS_API JSONView view_json(const c8* src, usize src_size = USIZE_MAX);
+
+        //! Gets the type of the value of one JSON view by checking the first character of the value.
+        //! @param[in] view The view to check.
+        //! @return Returns the type of the value. Returns @ref VariantType::null if the value is not a valid JSON value.
+        LUNA_VARIANT_UTILS_API VariantType get_json_view_type(const JSONView& view);
+
+        //! Gets the number of fields of one object value or elements of one array value.
+        //! @param[in] view The view of the object or array value.
+        //! @return Returns the number of fields or elements.
+        LUNA_VARIANT_UTILS_API R<usize> get_json_view_size(const JSONView& view);
+
+        //! Gets the view of one field value of one object value.
+        //! @param[in] view The view of the object value.
+        //! @param[in] key The key of the field.
+        //! @return Returns the view of the field value. Returns @ref BasicError::not_found if the field does not exist.
+        LUNA_VARIANT_UTILS_API R<JSONView> get_json_view_field(const JSONView& view, const Name& key);
+
+        //! Gets the view of one element of one array value.
+        //! @param[in] view The view of the array value.
+        //! @param[in] index The index of the element.
+        //! @return Returns the view of the element. Returns @ref BasicError::out_of_range if `index` is not smaller than the
+        //! number of elements.
+        LUNA_VARIANT_UTILS_API R<JSONView> get_json_view_element(const JSONView& view, usize index);
+
+        //! Parses the value of one JSON view.
+        //! @param[in] view The view to parse.
+        //! @return Returns one variant that contains the parsed value.
+        LUNA_VARIANT_UTILS_API R<Variant> read_json_view(const JSONView& view);
 
         //! Writes one variant object to JSON string.
         //! @param[in] v The variant object that contains data to write.
         //! @param[in] indent Whether to add indents and line breaks to the generated JSON string, so that improves readability but
         //! also increases the string size.
         //! @return Returns the generated JSON string.
+        //! @remark Floating-point numbers are written in the shortest form that reads back to the same value.
         LUNA_VARIANT_UTILS_API String write_json(const Variant& v, bool indent = true);
         
         //! Writes one variant object to JSON string.
@@ -50,6 +146,8 @@ namespace Luna
         //! @param[in] v The variant object that contains data to write.
         //! @param[in] indent Whether to add indents and line breaks to the generated JSON string, so that improves readability but
         //! also increases the string size.
+        //! @remark The JSON string is written to the stream in small chunks while being generated, so the whole string is never stored
+        //! in memory. If writing to the stream fails, generation stops writing and the first error is returned.
         LUNA_VARIANT_UTILS_API RV write_json(IStream* stream, const Variant& v, bool indent = true);
 
         //! @}
@@ -0,0 +1,450 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file Binary.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include <Luna/Runtime/PlatformDefines.hpp>
+#define LUNA_VARIANT_UTILS_API LUNA_EXPORT
+#include "../Binary.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/BufferedStream.hpp>
+
+namespace Luna
+{
+    namespace VariantUtils
+    {
+        // Binary variant format:
+        //
+        // [magic "LVB"] [version u8]
+        // [name count varint] { [name size varint] [name bytes] }
+        // [root value]
+        //
+        // One value starts with one type tag, followed by the payload of the tag. Variable-length integers are encoded
+        // in LEB128, with 7 bits per byte from the lowest bits and the highest bit set if more bytes follow.
+        // Multi-byte fixed-size values are stored in little-endian.
+        enum class BinaryTag : u8
+        {
+            null = 0x00,
+            boolean_false = 0x01,
+            boolean_true = 0x02,
+            // [varint]
+            number_u64 = 0x03,
+            // [zigzag varint]
+            number_i64 = 0x04,
+            // [8 bytes]
+            number_f64 = 0x05,
+            // [name index varint]
+            string = 0x06,
+            // [alignment varint] [size varint] [bytes]
+            blob = 0x07,
+            // [count varint] { [value] }
+            array = 0x08,
+            // [count varint] { [key name index varint] [value] }
+            object = 0x09,
+            // Unsigned integers in [0, 127] are stored in the tag directly as `0x80 | value`.
+            small_u64 = 0x80,
+        };
+        constexpr u8 BINARY_MAGIC[3] = { 'L', 'V', 'B' };
+        constexpr u8 BINARY_VERSION = 1;
+        // Limits the nesting depth so that malformed data cannot overflow the stack.
+        constexpr u32 BINARY_MAX_DEPTH = 512;
+
+        struct BinaryWriteContext
+        {
+            Vector<byte_t> m_buffer;
+            HashMap<Name, u32> m_name_indices;
+            Vector<Name> m_names;
+
+            void write(const void* data, usize size)
+            {
+                usize offset = m_buffer.size();
+                m_buffer.resize(offset + size, 0);
+                memcpy(m_buffer.data() + offset, data, size);
+            }
+            void write_u8(u8 v)
+            {
+                m_buffer.push_back(v);
+            }
+            void write_varint(u64 v)
+            {
+                while (v >= 0x80)
+                {
+                    m_buffer.push_back((byte_t)((v & 0x7F) | 0x80));
+                    v >>= 7;
+                }
+                m_buffer.push_back((byte_t)v);
+            }
+            void add_name(const Name& name)
+            {
+                if (m_name_indices.find(name) != m_name_indices.end()) return;
+                m_name_indices.insert(make_pair(name, (u32)m_names.size()));
+                m_names.push_back(name);
+            }
+            void collect_names(const Variant& v)
+            {
+                switch (v.type())
+                {
+                case VariantType::string:
+                    add_name(v.str());
+                    break;
+                case VariantType::array:
+                    for (auto& i : v.values()) collect_names(i);
+                    break;
+                case VariantType::object:
+                    for (auto& i : v.key_values())
+                    {
+                        add_name(i.first);
+                        collect_names(i.second);
+                    }
+                    break;
+                default: break;
+                }
+            }
+            void write_name_index(const Name& name)
+            {
+                auto iter = m_name_indices.find(name);
+                luassert(iter != m_name_indices.end());
+                write_varint(iter->second);
+            }
+            void write_value(const Variant& v)
+            {
+                switch (v.type())
+                {
+                case VariantType::null:
+                    write_u8((u8)BinaryTag::null);
+                    break;
+                case VariantType::boolean:
+                    write_u8((u8)(v.boolean() ? BinaryTag::boolean_true : BinaryTag::boolean_false));
+                    break;
+                case VariantType::number:
+                    switch (v.number_type())
+                    {
+                    case VariantNumberType::number_u64:
+                    {
+                        u64 n = v.unum();
+                        if (n < 0x80)
+                        {
+                            write_u8((u8)BinaryTag::small_u64 | (u8)n);
+                        }
+                        else
+                        {
+                            write_u8((u8)BinaryTag::number_u64);
+                            write_varint(n);
+                        }
+                    }
+                    break;
+                    case VariantNumberType::number_i64:
+                    {
+                        i64 n = v.inum();
+                        write_u8((u8)BinaryTag::number_i64);
+                        write_varint(((u64)n << 1) ^ (u64)(n >> 63));
+                    }
+                    break;
+                    case VariantNumberType::number_f64:
+                    {
+                        f64 n = v.fnum();
+                        write_u8((u8)BinaryTag::number_f64);
+                        write(&n, sizeof(f64));
+                    }
+                    break;
+                    default: lupanic(); break;
+                    }
+                    break;
+                case VariantType::string:
+                    write_u8((u8)BinaryTag::string);
+                    write_name_index(v.str());
+                    break;
+                case VariantType::blob:
+                    write_u8((u8)BinaryTag::blob);
+                    write_varint(v.blob_alignment());
+                    write_varint(v.blob_size());
+                    write(v.blob_data(), v.blob_size());
+                    break;
+                case VariantType::array:
+                    write_u8((u8)BinaryTag::array);
+                    write_varint(v.size());
+                    for (auto& i : v.values()) write_value(i);
+                    break;
+                case VariantType::object:
+                    write_u8((u8)BinaryTag::object);
+                    write_varint(v.size());
+                    for (auto& i : v.key_values())
+                    {
+                        write_name_index(i.first);
+                        write_value(i.second);
+                    }
+                    break;
+                }
+            }
+            void write_root(const Variant& v)
+            {
+                collect_names(v);
+                write(BINARY_MAGIC, sizeof(BINARY_MAGIC));
+                write_u8(BINARY_VERSION);
+                write_varint(m_names.size());
+                for (auto& name : m_names)
+                {
+                    write_varint(name.size());
+                    write(name.c_str(), name.size());
+                }
+                write_value(v);
+            }
+        };
+
+        struct BufferBinaryReader
+        {
+            const byte_t* m_cur;
+            const byte_t* m_end;
+
+            RV read(void* dst, usize size)
+            {
+                if ((usize)(m_end - m_cur) < size) return set_error(BasicError::format_error(), "Unexpected end of binary variant data.");
+                memcpy(dst, m_cur, size);
+                m_cur += size;
+                return ok;
+            }
+            // Gets the maximum number of bytes that can be read, used to reject malformed sizes before allocating memory.
+            usize max_remaining_size() const
+            {
+                return (usize)(m_end - m_cur);
+            }
+        };
+        struct StreamBinaryReader
+        {
+            BufferedStream m_stream;
+
+            StreamBinaryReader(IStream* stream) :
+                m_stream(stream) {}
+
+            RV read(void* dst, usize size)
+            {
+                lutry
+                {
+                    usize read_bytes = 0;
+                    luexp(m_stream.read(dst, size, &read_bytes));
+                    if (read_bytes != size) return set_error(BasicError::format_error(), "Unexpected end of binary variant data.");
+                }
+                lucatchret;
+                return ok;
+            }
+            usize max_remaining_size() const
+            {
+                return USIZE_MAX;
+            }
+        };
+
+        template <typename _Reader>
+        struct BinaryReadContext
+        {
+            _Reader& m_reader;
+            Arena* m_arena;
+            Vector<Name> m_names;
+
+            BinaryReadContext(_Reader& reader, Arena* arena) : m_reader(reader), m_arena(arena) {}
+
+            RV read_u8(u8& v)
+            {
+                return m_reader.read(&v, 1);
+            }
+            RV read_varint(u64& v)
+            {
+                v = 0;
+                lutry
+                {
+                    for (u32 shift = 0; shift < 64; shift += 7)
+                    {
+                        u8 b;
+                        luexp(read_u8(b));
+                        v |= (u64)(b & 0x7F) << shift;
+                        if (!(b & 0x80)) return ok;
+                    }
+                }
+                lucatchret;
+                return set_error(BasicError::format_error(), "Invalid variable-length integer in binary variant data.");
+            }
+            RV read_size(usize& v)
+            {
+                u64 n;
+                lutry
+                {
+                    luexp(read_varint(n));
+                }
+                lucatchret;
+                if (n > (u64)m_reader.max_remaining_size()) return set_error(BasicError::format_error(), "Invalid size in binary variant data.");
+                v = (usize)n;
+                return ok;
+            }
+            R<Name> read_name_index()
+            {
+                u64 index;
+                lutry
+                {
+                    luexp(read_varint(index));
+                }
+                lucatchret;
+                if (index >= m_names.size()) return set_error(BasicError::format_error(), "Invalid name index %llu in binary variant data.", (unsigned long long)index);
+                return m_names[(usize)index];
+            }
+            R<Variant> read_value(u32 depth)
+            {
+                if (depth > BINARY_MAX_DEPTH) return set_error(BasicError::format_error(), "The nesting depth of binary variant data exceeds %u.", BINARY_MAX_DEPTH);
+                Variant r;
+                lutry
+                {
+                    u8 tag;
+                    luexp(read_u8(tag));
+                    if (tag & (u8)BinaryTag::small_u64)
+                    {
+                        return Variant((u64)(tag & 0x7F));
+                    }
+                    switch ((BinaryTag)tag)
+                    {
+                    case BinaryTag::null:
+                        break;
+                    case BinaryTag::boolean_false:
+                        r = false;
+                        break;
+                    case BinaryTag::boolean_true:
+                        r = true;
+                        break;
+                    case BinaryTag::number_u64:
+                    {
+                        u64 n;
+                        luexp(read_varint(n));
+                        r = n;
+                    }
+                    break;
+                    case BinaryTag::number_i64:
+                    {
+                        u64 n;
+                        luexp(read_varint(n));
+                        r = (i64)((n >> 1) ^ (~(n & 1) + 1));
+                    }
+                    break;
+                    case BinaryTag::number_f64:
+                    {
+                        f64 n;
+                        luexp(m_reader.read(&n, sizeof(f64)));
+                        r = n;
+                    }
+                    break;
+                    case BinaryTag::string:
+                    {
+                        lulet(name, read_name_index());
+                        r = move(name);
+                    }
+                    break;
+                    case BinaryTag::blob:
+                    {
+                        u64 alignment;
+                        luexp(read_varint(alignment));
+                        if (alignment & (alignment - 1)) return set_error(BasicError::format_error(), "Invalid BLOB alignment in binary variant data.");
+                        usize size;
+                        luexp(read_size(size));
+                        Blob blob(size, (usize)alignment);
+                        luexp(m_reader.read(blob.data(), size));
+                        r = move(blob);
+                    }
+                    break;
+                    case BinaryTag::array:
+                    {
+                        usize count;
+                        luexp(read_size(count));
+                        // The count is not validated for streams, so the reserved capacity is clamped.
+                        r = Variant(VariantType::array, min(count, (usize)U16_MAX), m_arena);
+                        for (usize i = 0; i < count; ++i)
+                        {
+                            lulet(child, read_value(depth + 1));
+                            r.push_back(move(child));
+                        }
+                    }
+                    break;
+                    case BinaryTag::object:
+                    {
+                        usize count;
+                        luexp(read_size(count));
+                        // The count is not validated for streams, so the reserved capacity is clamped.
+                        r = Variant(VariantType::object, min(count, (usize)U16_MAX), m_arena);
+                        for (usize i = 0; i < count; ++i)
+                        {
+                            lulet(key, read_name_index());
+                            lulet(child, read_value(depth + 1));
+                            r[key] = move(child);
+                        }
+                    }
+                    break;
+                    default:
+                        return set_error(BasicError::format_error(), "Invalid type tag 0x%02x in binary variant data.", (u32)tag);
+                    }
+                }
+                lucatchret;
+                return r;
+            }
+            R<Variant> read_root()
+            {
+                lutry
+                {
+                    u8 header[4];
+                    luexp(m_reader.read(header, 4));
+                    if (memcmp(header, BINARY_MAGIC, sizeof(BINARY_MAGIC)))
+                    {
+                        return set_error(BasicError::format_error(), "The data is not binary variant data.");
+                    }
+                    if (header[3] != BINARY_VERSION)
+                    {
+                        return set_error(BasicError::not_supported(), "Binary variant data version %u is not supported.", (u32)header[3]);
+                    }
+                    usize num_names;
+                    luexp(read_size(num_names));
+                    m_names.reserve(num_names);
+                    String buf;
+                    for (usize i = 0; i < num_names; ++i)
+                    {
+                        usize size;
+                        luexp(read_size(size));
+                        buf.resize(size, 0);
+                        luexp(m_reader.read(buf.data(), size));
+                        m_names.push_back(Name(buf.c_str(), size));
+                    }
+                }
+                lucatchret;
+                return read_value(0);
+            }
+        };
+
+        LUNA_VARIANT_UTILS_API R<Variant> read_binary(const void* src, usize src_size, Arena* arena)
+        {
+            lucheck(src || !src_size);
+            BufferBinaryReader reader;
+            reader.m_cur = (const byte_t*)src;
+            reader.m_end = (const byte_t*)src + src_size;
+            BinaryReadContext<BufferBinaryReader> ctx(reader, arena);
+            return ctx.read_root();
+        }
+        LUNA_VARIANT_UTILS_API R<Variant> read_binary(IStream* stream, Arena* arena)
+        {
+            lucheck(stream);
+            StreamBinaryReader reader(stream);
+            BinaryReadContext<StreamBinaryReader> ctx(reader, arena);
+            return ctx.read_root();
+        }
+        LUNA_VARIANT_UTILS_API Blob write_binary(const Variant& v)
+        {
+            BinaryWriteContext ctx;
+            ctx.write_root(v);
+            return Blob(ctx.m_buffer.data(), ctx.m_buffer.size());
+        }
+        LUNA_VARIANT_UTILS_API RV write_binary(IStream* stream, const Variant& v)
+        {
+            lucheck(stream);
+            BinaryWriteContext ctx;
+            ctx.write_root(v);
+            return stream->write(ctx.m_buffer.data(), ctx.m_buffer.size());
+        }
+    }
+}
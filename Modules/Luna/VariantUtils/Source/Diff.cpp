@@ -10,183 +10,274 @@
 #include <Luna/Runtime/PlatformDefines.hpp>
 #define LUNA_VARIANT_UTILS_API LUNA_EXPORT
 #include "../Diff.hpp"
+#include <Luna/Runtime/Hash.hpp>
 
 namespace Luna
 {
     namespace VariantUtils
     {
-        //! Longest Common Subsequence, helper class to diff array.
-        struct LCSMatrix
-        {
-            Vector<usize> data;
-            usize row_size;
-
-            usize get(usize x, usize y) const { return data[x + y * row_size]; }
-            void set(usize x, usize y, usize v) { data[x + y * row_size] = v; }
-        };
+        constexpr u64 VARIANT_DIFF_OP_DELETED = 0;
+        constexpr u64 VARIANT_DIFF_OP_ARRAYMOVE = 3;
 
-        struct LCS
+        struct DiffContext
         {
-            Vector<usize> sequence;
-            Vector<usize> indices1;
-            Vector<usize> indices2;
-        };
+            const DiffDesc& desc;
+            // Hashes of objects, arrays and blobs in both variants. Hashes of other values are computed when needed,
+            // since they are cheap to compute. This map is not modified after `build_hash`, so it can be read 
+            // from multiple threads when children are diffed in parallel.
+            HashMap<const Variant*, u64> hashes;
 
-        inline usize find_index(const Vector<usize>& vec, usize v)
-        {
-            for (usize i = 0; i < vec.size(); ++i)
+            DiffContext(const DiffDesc& desc) : desc(desc) {}
+
+            // Both inputs are mixed with secrets before being combined, since `wymix(a, 0)` is always `0`, which 
+            // would make hashes of all arrays that contain one `0` child equal.
+            static u64 mix_hash(u64 a, u64 b)
             {
-                if (vec[i] == v) return i;
+                return Impl::wymix(a ^ Impl::wyhash_secret[0], b ^ Impl::wyhash_secret[1]);
             }
-            return USIZE_MAX;
-        }
 
-        static LCSMatrix lcs_internal(const Variant& before, const Variant& after, usize before_begin, usize before_size, usize after_begin, usize after_size)
-        {
-            LCSMatrix result;
-            result.row_size = before_size + 1;
-            result.data.resize(result.row_size * (after_size + 1), 0);
-            for (usize i = 1; i <= before_size; ++i)
+            static u64 value_hash(const Variant& v)
             {
-                for (usize j = 1; j <= after_size; ++j)
+                u64 h = (u64)v.type();
+                switch (v.type())
                 {
-                    if (before[before_begin + i - 1] == after[after_begin + j - 1])
+                case VariantType::number:
+                    switch (v.number_type())
                     {
-                        result.set(i, j, result.get(i - 1, j - 1) + 1);
+                    case VariantNumberType::number_u64: return mix_hash(h ^ 1, v.unum());
+                    case VariantNumberType::number_i64: return mix_hash(h ^ 2, (u64)v.inum());
+                    default:
+                    {
+                        f64 f = v.fnum();
+                        u64 bits;
+                        memcpy(&bits, &f, sizeof(f64));
+                        return mix_hash(h ^ 3, bits);
                     }
-                    else
+                    }
+                case VariantType::string: return mix_hash(h, (u64)v.str().id());
+                case VariantType::boolean: return mix_hash(h, v.boolean() ? 1 : 0);
+                default: return h;
+                }
+            }
+            u64 build_hash(const Variant& v)
+            {
+                u64 h;
+                switch (v.type())
+                {
+                case VariantType::object:
+                {
+                    // Children of objects are unordered, so hashes of children are summed up. Null children are ignored 
+                    // to match the behavior of `Variant::operator==`.
+                    u64 sum = 0;
+                    for (auto& p : v.key_values())
+                    {
+                        if (!p.second.valid()) continue;
+                        sum += mix_hash((u64)p.first.id(), build_hash(p.second));
+                    }
+                    h = mix_hash((u64)VariantType::object, sum);
+                    break;
+                }
+                case VariantType::array:
+                {
+                    h = mix_hash((u64)VariantType::array, v.size());
+                    for (auto& c : v.values())
                     {
-                        result.set(i, j, max(result.get(i - 1, j), result.get(i, j - 1)));
+                        h = mix_hash(h, build_hash(c));
                     }
+                    break;
                 }
+                case VariantType::blob:
+                    h = wyhash(v.blob_data(), v.blob_size(), (u64)VariantType::blob);
+                    break;
+                default:
+                    return value_hash(v);
+                }
+                hashes.insert(make_pair(&v, h));
+                return h;
             }
-            return result;
-        }
-
-        static LCS lcs_backtrack(LCSMatrix& matrix, const Variant& before, const Variant& after, usize before_begin, usize before_size, usize after_begin, usize after_size)
-        {
-            LCS result;
-            usize i = 1;
-            usize j = 1;
-            while (i <= before_size && j <= after_size)
+            u64 get_hash(const Variant& v) const
             {
-                // If the JSON tokens at the same position are both Objects or both Arrays, we just say they 
-                // are the same even if they are not, because we can package smaller deltas than an entire 
-                // object or array replacement by doing object to object or array to array diff.
-                if (before[before_begin + i - 1] == after[after_begin + j - 1]
-                    || (before[before_begin + i - 1].type() == VariantType::object && after[after_begin + j - 1].type() == VariantType::object)
-                    || (before[before_begin + i - 1].type() == VariantType::array && after[after_begin + j - 1].type() == VariantType::array))
+                auto iter = hashes.find(&v);
+                if (iter != hashes.end()) return iter->second;
+                return value_hash(v);
+            }
+            bool equal(const Variant& lhs, const Variant& rhs) const
+            {
+                if (lhs.type() != rhs.type()) return false;
+                switch (lhs.type())
                 {
-                    result.sequence.push_back(before_begin + i - 1);
-                    result.indices1.push_back(i - 1);
-                    result.indices2.push_back(j - 1);
-                    ++i;
-                    ++j;
-                    continue;
+                case VariantType::object:
+                case VariantType::array:
+                case VariantType::blob:
+                    return get_hash(lhs) == get_hash(rhs);
+                default:
+                    return lhs == rhs;
                 }
-                if (matrix.get(i, j - 1) > matrix.get(i - 1, j))
+            }
+            // Invokes `func(i)` for every i in [0, count), possibly in parallel.
+            template <typename _Func>
+            void for_each(usize count, _Func& func) const
+            {
+                if (desc.parallel_for && count >= desc.parallel_threshold && count > 1)
                 {
-                    ++i;
+                    desc.parallel_for(desc.parallel_for_userdata, count, [](void* f, usize i) { (*(_Func*)f)(i); }, &func);
                 }
                 else
                 {
-                    ++j;
+                    for (usize i = 0; i < count; ++i) func(i);
                 }
             }
-            return result;
-        }
+        };
+
+        static Variant diff_value(const DiffContext& ctx, const Variant& before, const Variant& after);
 
-        static LCS lcs_get(const Variant& before, const Variant& after, usize before_begin, usize before_size, usize after_begin, usize after_size)
+        static void set_array_delta(Variant& result, bool removed, usize index, Variant&& delta)
         {
-            LCSMatrix matrix = lcs_internal(before, after, before_begin, before_size, after_begin, after_size);
-            return lcs_backtrack(matrix, before, after, before_begin, before_size, after_begin, after_size);
+            c8 buf[32];
+            snprintf(buf, 32, removed ? "_%llu" : "%llu", (u64)index);
+            result[buf] = move(delta);
         }
-
-        constexpr u64 VARIANT_DIFF_OP_DELETED = 0;
-        constexpr u64 VARIANT_DIFF_OP_ARRAYMOVE = 3;
-
-        static Variant diff_object(const Variant& before, const Variant& after);
-
-        static Variant diff_array(const Variant& before, const Variant& after);
-
-        LUNA_VARIANT_UTILS_API Variant diff(const Variant& before, const Variant& after)
+        static Variant make_added_delta(const Variant& value)
         {
-            if (before.type() == VariantType::object && after.type() == VariantType::object)
-            {
-                return diff_object(before, after);
-            }
-            if (before.type() == VariantType::array && after.type() == VariantType::array)
-            {
-                return diff_array(before, after);
-            }
-            // Simply records two values.
-            if (before != after)
-            {
-                Variant diff_patch(VariantType::array);
-                diff_patch.push_back(before);
-                diff_patch.push_back(after);
-                return diff_patch;
-            }
-            // Returns one null value if equal.
-            return Variant();
+            Variant v(VariantType::array, 1);
+            v.push_back(value);
+            return v;
+        }
+        static Variant make_removed_delta(const Variant& value)
+        {
+            Variant v(VariantType::array, 3);
+            v.push_back(value);
+            v.push_back((u64)0);
+            v.push_back(VARIANT_DIFF_OP_DELETED);
+            return v;
         }
 
-        static Variant diff_object(const Variant& before, const Variant& after)
+        static Variant diff_object(const DiffContext& ctx, const Variant& before, const Variant& after)
         {
             Variant diff_patch(VariantType::object);
-            // Find properties modified or deleted.
+            // Collect properties that are deleted or changed, then diff changed properties.
+            struct Change
+            {
+                const Name* key;
+                const Variant* before;
+                const Variant* after;
+                Variant delta;
+            };
+            Vector<Change> changes;
             for (auto& lp : before.key_values())
             {
                 const Variant& rp = after[lp.first];
-
-                // Property deleted
-                if (rp.type() == VariantType::null)
+                if (rp.type() == VariantType::null || !ctx.equal(lp.second, rp))
                 {
-                    Variant delta(VariantType::array);
-                    delta.push_back(lp.second);
-                    delta.push_back((u64)0);
-                    delta.push_back(VARIANT_DIFF_OP_DELETED);
-                    diff_patch[lp.first] = move(delta);
-                    continue;
+                    changes.push_back({ &lp.first, &lp.second, &rp, Variant() });
                 }
-
+            }
+            auto diff_change = [&](usize i)
+            {
+                Change& c = changes[i];
+                // Property deleted
+                if (c.after->type() == VariantType::null) c.delta = make_removed_delta(*c.before);
                 // Property changed.
-                Variant d = diff(lp.second, rp);
-                if (d.type() != VariantType::null)
+                else c.delta = diff_value(ctx, *c.before, *c.after);
+            };
+            ctx.for_each(changes.size(), diff_change);
+            for (auto& c : changes)
+            {
+                if (c.delta.type() != VariantType::null)
                 {
-                    diff_patch[lp.first] = move(d);
+                    diff_patch[*c.key] = move(c.delta);
                 }
             }
             // Find properties that were added.
             for (auto& rp : after.key_values())
             {
                 if (before[rp.first].type() != VariantType::null) continue;
-                Variant v(VariantType::array);
-                v.push_back(rp.second);
-                diff_patch[rp.first] = move(v);
+                diff_patch[rp.first] = make_added_delta(rp.second);
             }
             if (!diff_patch.empty()) return diff_patch;
             return Variant();
         }
 
-        static Variant diff_array(const Variant& before, const Variant& after)
+        //! Longest Common Subsequence, helper to diff array.
+        //! Fills `before_matches` and `after_matches` with indices of matched elements in the other array, or `USIZE_MAX` if
+        //! the element is not matched.
+        static void lcs_match(const DiffContext& ctx, const Variant& before, const Variant& after, usize begin, usize before_size, usize after_size,
+            Vector<usize>& before_matches, Vector<usize>& after_matches)
+        {
+            // Compares hashes of elements instead of elements, so that every comparison takes constant time.
+            Vector<u64> before_hashes(before_size);
+            Vector<u64> after_hashes(after_size);
+            for (usize i = 0; i < before_size; ++i) before_hashes[i] = ctx.get_hash(before[begin + i]);
+            for (usize i = 0; i < after_size; ++i) after_hashes[i] = ctx.get_hash(after[begin + i]);
+            usize row_size = before_size + 1;
+            Vector<u32> matrix;
+            matrix.resize(row_size * (after_size + 1), 0);
+            for (usize j = 1; j <= after_size; ++j)
+            {
+                u32* row = matrix.data() + j * row_size;
+                const u32* prev_row = row - row_size;
+                for (usize i = 1; i <= before_size; ++i)
+                {
+                    if (before_hashes[i - 1] == after_hashes[j - 1])
+                    {
+                        row[i] = prev_row[i - 1] + 1;
+                    }
+                    else
+                    {
+                        row[i] = max(prev_row[i], row[i - 1]);
+                    }
+                }
+            }
+            before_matches.resize(before_size, USIZE_MAX);
+            after_matches.resize(after_size, USIZE_MAX);
+            usize i = 1;
+            usize j = 1;
+            while (i <= before_size && j <= after_size)
+            {
+                const Variant& b = before[begin + i - 1];
+                const Variant& a = after[begin + j - 1];
+                // If the JSON tokens at the same position are both Objects or both Arrays, we just say they 
+                // are the same even if they are not, because we can package smaller deltas than an entire 
+                // object or array replacement by doing object to object or array to array diff.
+                if (before_hashes[i - 1] == after_hashes[j - 1]
+                    || (b.type() == VariantType::object && a.type() == VariantType::object)
+                    || (b.type() == VariantType::array && a.type() == VariantType::array))
+                {
+                    before_matches[i - 1] = j - 1;
+                    after_matches[j - 1] = i - 1;
+                    ++i;
+                    ++j;
+                    continue;
+                }
+                if (matrix[i + (j - 1) * row_size] > matrix[(i - 1) + j * row_size])
+                {
+                    ++i;
+                }
+                else
+                {
+                    ++j;
+                }
+            }
+        }
+
+        static Variant diff_array(const DiffContext& ctx, const Variant& before, const Variant& after)
         {
+            if (ctx.equal(before, after)) return Variant();
             Variant result(VariantType::object);
             result["_t"] = "a";
             usize common_head = 0;
             usize common_tail = 0;
-            if (before == after) return Variant();
             // Find common head
             while (common_head < before.size() 
                 && common_head < after.size() 
-                && before[common_head] == after[common_head])
+                && ctx.equal(before[common_head], after[common_head]))
             {
                 ++common_head;
             }
             // Find common tail
             while (common_tail + common_head < before.size() 
                 && common_tail + common_head < after.size()
-                && before[before.size() - 1 - common_tail] == after[after.size() - 1 - common_tail])
+                && ctx.equal(before[before.size() - 1 - common_tail], after[after.size() - 1 - common_tail]))
             {
                 ++common_tail;
             }
@@ -195,11 +286,7 @@ namespace Luna
                 // Trivial case, a block (1 or more consecutive items) was added
                 for (usize index = common_head; index < after.size() - common_tail; ++index)
                 {
-                    c8 buf[32];
-                    snprintf(buf, 32, "%llu", (u64)index);
-                    Variant v(VariantType::array);
-                    v.push_back(after[index]);
-                    result[buf] = move(v);
+                    set_array_delta(result, false, index, make_added_delta(after[index]));
                 }
                 return result;
             }
@@ -208,61 +295,119 @@ namespace Luna
                 // Trivial case, a block (1 or more consecutive items) was removed
                 for (usize index = common_head; index < before.size() - common_tail; ++index)
                 {
-                    c8 buf[32];
-                    snprintf(buf, 32, "_%llu", (u64)index);
-                    Variant v(VariantType::array);
-                    v.push_back(before[index]);
-                    v.push_back((u64)0);
-                    v.push_back(VARIANT_DIFF_OP_DELETED);
-                    result[buf] = move(v);
+                    set_array_delta(result, true, index, make_removed_delta(before[index]));
                 }
                 return result;
             }
 
-            // Complex Diff, find the LCS (Longest Common Subsequence)
-            LCS lcs = lcs_get(before, after, common_head, before.size() - common_tail - common_head, common_head, after.size() - common_tail - common_head);
-            for (usize index = common_head; index < before.size() - common_tail; ++index)
+            usize before_size = before.size() - common_tail - common_head;
+            usize after_size = after.size() - common_tail - common_head;
+            Vector<usize> before_matches;
+            Vector<usize> after_matches;
+            if (ctx.desc.array_mode == DiffArrayMode::lcs && 
+                (after_size == 0 || before_size <= ctx.desc.max_lcs_size / after_size) &&
+                before_size < (usize)U32_MAX && after_size < (usize)U32_MAX)
             {
-                if (find_index(lcs.indices1, index - common_head) == USIZE_MAX)
+                // Complex Diff, find the LCS (Longest Common Subsequence)
+                lcs_match(ctx, before, after, common_head, before_size, after_size, before_matches, after_matches);
+            }
+            else
+            {
+                // Matches elements at the same index.
+                usize num_matches = min(before_size, after_size);
+                before_matches.resize(before_size, USIZE_MAX);
+                after_matches.resize(after_size, USIZE_MAX);
+                for (usize i = 0; i < num_matches; ++i)
+                {
+                    before_matches[i] = i;
+                    after_matches[i] = i;
+                }
+            }
+            for (usize i = 0; i < before_size; ++i)
+            {
+                if (before_matches[i] == USIZE_MAX)
                 {
                     // Removed.
-                    c8 buf[32];
-                    snprintf(buf, 32, "_%llu", (u64)index);
-                    Variant v(VariantType::array);
-                    v.push_back(before[index]);
-                    v.push_back((u64)0);
-                    v.push_back(VARIANT_DIFF_OP_DELETED);
-                    result[buf] = move(v);
+                    set_array_delta(result, true, i + common_head, make_removed_delta(before[i + common_head]));
                 }
             }
-            for (usize index = common_head; index < after.size() - common_tail; ++index)
+            // Diff matched elements that are changed.
+            struct Change
+            {
+                usize after_index;
+                usize before_index;
+                Variant delta;
+            };
+            Vector<Change> changes;
+            for (usize i = 0; i < after_size; ++i)
             {
-                usize index_after = find_index(lcs.indices2, index - common_head);
-                if (index_after == USIZE_MAX)
+                usize ai = i + common_head;
+                if (after_matches[i] == USIZE_MAX)
                 {
                     // Added
-                    c8 buf[32];
-                    snprintf(buf, 32, "%llu", (u64)index);
-                    Variant v(VariantType::array);
-                    v.push_back(after[index]);
-                    result[buf] = move(v);
+                    set_array_delta(result, false, ai, make_added_delta(after[ai]));
                 }
                 else
                 {
-                    usize bi = lcs.indices1[index_after] + common_head;
-                    usize ai = lcs.indices2[index_after] + common_head;
-                    Variant diff_result = diff(before[bi], after[ai]);
-                    if (diff_result.type() != VariantType::null)
+                    usize bi = after_matches[i] + common_head;
+                    if (!ctx.equal(before[bi], after[ai]))
                     {
-                        c8 buf[32];
-                        snprintf(buf, 32, "%llu", (u64)index);
-                        result[buf] = move(diff_result);
+                        changes.push_back({ ai, bi, Variant() });
                     }
                 }
             }
+            auto diff_change = [&](usize i)
+            {
+                Change& c = changes[i];
+                c.delta = diff_value(ctx, before[c.before_index], after[c.after_index]);
+            };
+            ctx.for_each(changes.size(), diff_change);
+            for (auto& c : changes)
+            {
+                if (c.delta.type() != VariantType::null)
+                {
+                    set_array_delta(result, false, c.after_index, move(c.delta));
+                }
+            }
             return result;
         }
 
+        static Variant diff_value(const DiffContext& ctx, const Variant& before, const Variant& after)
+        {
+            if (before.type() == VariantType::object && after.type() == VariantType::object)
+            {
+                return diff_object(ctx, before, after);
+            }
+            if (before.type() == VariantType::array && after.type() == VariantType::array)
+            {
+                return diff_array(ctx, before, after);
+            }
+            // Simply records two values.
+            if (!ctx.equal(before, after))
+            {
+                Variant diff_patch(VariantType::array, 2);
+                diff_patch.push_back(before);
+                diff_patch.push_back(after);
+                return diff_patch;
+            }
+            // Returns one null value if equal.
+            return Variant();
+        }
+
+        LUNA_VARIANT_UTILS_API Variant diff(const Variant& before, const Variant& after)
+        {
+            DiffDesc desc;
+            return diff(before, after, desc);
+        }
+
+        LUNA_VARIANT_UTILS_API Variant diff(const Variant& before, const Variant& after, const DiffDesc& desc)
+        {
+            DiffContext ctx(desc);
+            ctx.build_hash(before);
+            ctx.build_hash(after);
+            return diff_value(ctx, before, after);
+        }
+
         static void patch_object(Variant& before, const Variant& patch);
         static void patch_array(Variant& before, const Variant& patch);
 
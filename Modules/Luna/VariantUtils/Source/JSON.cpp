@@ -13,12 +13,24 @@
 #include <Luna/Runtime/Base64.hpp>
 #include <Luna/Runtime/Base85.hpp>
 #include "StringParser.hpp"
+#include "TextWriter.hpp"
+
+#ifndef LUNA_DISABLE_SIMD
+#if defined(LUNA_PLATFORM_X86) || defined(LUNA_PLATFORM_X86_64)
+#define LUNA_JSON_SSE2
+#include <emmintrin.h>
+#elif defined(LUNA_PLATFORM_ARM64)
+#define LUNA_JSON_NEON
+#include <arm_neon.h>
+#endif
+#endif
 
 namespace Luna
 {
     namespace VariantUtils
     {
-        static void skip_single_line_comment(IReadContext& ctx)
+        template <typename _Ctx>
+        static void skip_single_line_comment(_Ctx& ctx)
         {
             lucheck(ctx.next_char() == '/' && ctx.next_char(1) == '/');
             ctx.consume('/');
@@ -33,7 +45,8 @@ namespace Luna
             }
             ctx.consume(ch);// for \n.
         }
-        static void skip_multi_line_comment(IReadContext& ctx)
+        template <typename _Ctx>
+        static void skip_multi_line_comment(_Ctx& ctx)
         {
             lucheck(ctx.next_char() == '/' && ctx.next_char(1) == '*');
             ctx.consume('/');
@@ -60,8 +73,18 @@ namespace Luna
                 goto entry;
             }
         }
-        static void skip_whitespaces_and_comments(IReadContext& ctx)
+        // Skips ASCII whitespaces in bulk for UTF-8 buffers, and does nothing for other contexts.
+        inline void skip_ascii_whitespaces(IReadContext& ctx) {}
+        inline void skip_ascii_whitespaces(Utf8BufferReadContext& ctx)
+        {
+            const c8* cur = ctx.cur;
+            while (cur < ctx.end && (*cur == ' ' || *cur == '\n' || *cur == '\r' || *cur == '\t')) ++cur;
+            ctx.cur = cur;
+        }
+        template <typename _Ctx>
+        static void skip_whitespaces_and_comments(_Ctx& ctx)
         {
+            skip_ascii_whitespaces(ctx);
             c32 ch = ctx.next_char();
             while (ch)
             {
@@ -89,11 +112,50 @@ namespace Luna
                 ch = ctx.next_char();
             }
         }
-        static R<String> read_string_literal(IReadContext& ctx)
+        // Finds the first '"', '\\' or null character in [`cur`, `end`), or returns `end` if not found.
+        static const c8* find_string_special_char(const c8* cur, const c8* end)
+        {
+#if defined(LUNA_JSON_SSE2)
+            const __m128i quote = _mm_set1_epi8('"');
+            const __m128i backslash = _mm_set1_epi8('\\');
+            const __m128i zero = _mm_setzero_si128();
+            while (end - cur >= 16)
+            {
+                __m128i data = _mm_loadu_si128((const __m128i*)cur);
+                __m128i match = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(data, quote), _mm_cmpeq_epi8(data, backslash)), _mm_cmpeq_epi8(data, zero));
+                if (_mm_movemask_epi8(match)) break;
+                cur += 16;
+            }
+#elif defined(LUNA_JSON_NEON)
+            const uint8x16_t quote = vdupq_n_u8('"');
+            const uint8x16_t backslash = vdupq_n_u8('\\');
+            while (end - cur >= 16)
+            {
+                uint8x16_t data = vld1q_u8((const u8*)cur);
+                uint8x16_t match = vorrq_u8(vorrq_u8(vceqq_u8(data, quote), vceqq_u8(data, backslash)), vceqzq_u8(data));
+                if (vmaxvq_u8(match)) break;
+                cur += 16;
+            }
+#endif
+            while (cur < end && *cur != '"' && *cur != '\\' && *cur) ++cur;
+            return cur;
+        }
+        // Appends characters of one string literal until the next character that needs to be handled
+        // separately. This copies characters in bulk for UTF-8 buffers, and does nothing for other contexts.
+        inline void append_string_run(IReadContext& ctx, String& s) {}
+        inline void append_string_run(Utf8BufferReadContext& ctx, String& s)
+        {
+            const c8* run_end = find_string_special_char(ctx.cur, ctx.end);
+            s.append(ctx.cur, run_end - ctx.cur);
+            ctx.cur = run_end;
+        }
+        template <typename _Ctx>
+        static R<String> read_string_literal(_Ctx& ctx)
         {
             lucheck(ctx.next_char() == '"');
             ctx.consume('"');
             String s;
+            append_string_run(ctx, s);
             c32 ch = ctx.next_char();
             while (ch)
             {
@@ -163,6 +225,7 @@ namespace Luna
                     {
                         s.push_back(buf[i]);
                     }
+                    append_string_run(ctx, s);
                     ch = ctx.next_char();
                     continue;
                 }
@@ -175,66 +238,166 @@ namespace Luna
                 usize buf_count = utf8_encode_char(buf, ch);
                 s.append(buf, buf_count);
                 ctx.consume(ch);
+                append_string_run(ctx, s);
                 ch = ctx.next_char();
             }
             return s;
         }
-        static R<Variant> read_value(IReadContext& ctx);
-        static R<Variant> read_object(IReadContext& ctx)
+        template <typename _Ctx>
+        static R<Name> read_name_literal(_Ctx& ctx)
+        {
+            R<String> s = read_string_literal(ctx);
+            if (failed(s)) return s.errcode();
+            return Name(s.get());
+        }
+        // Creates the name from the buffer directly if the string literal does not contain escape sequences, so
+        // that the string need not to be copied.
+        static R<Name> read_name_literal(Utf8BufferReadContext& ctx)
+        {
+            lucheck(ctx.next_char() == '"');
+            const c8* begin = ctx.cur + 1;
+            const c8* run_end = find_string_special_char(begin, ctx.end);
+            if (run_end < ctx.end && *run_end == '"')
+            {
+                ctx.cur = run_end + 1;
+                return Name(begin, run_end - begin);
+            }
+            return read_name_literal<Utf8BufferReadContext>(ctx);
+        }
+        // Builds one variant from parsing events.
+        struct JSONVariantBuilder
+        {
+            // Children of objects and arrays being read are collected in `m_values`, so that every object and
+            // array can be created with the exact capacity when it ends.
+            struct Frame
+            {
+                usize first;
+                Name key;
+                VariantType type;
+            };
+            Vector<Frame> m_stack;
+            Vector<Pair<Name, Variant>> m_values;
+            Name m_key;
+            Variant m_result;
+            Arena* m_arena = nullptr;
+
+            void add(Variant&& value)
+            {
+                if (m_stack.empty())
+                {
+                    m_result = move(value);
+                    return;
+                }
+                m_values.push_back(make_pair(move(m_key), move(value)));
+            }
+            RV on_begin_object()
+            {
+                m_stack.push_back({ m_values.size(), move(m_key), VariantType::object });
+                return ok;
+            }
+            RV on_key(const Name& key)
+            {
+                m_key = key;
+                return ok;
+            }
+            RV on_end_object()
+            {
+                Frame& top = m_stack.back();
+                Variant value(top.type, m_values.size() - top.first, m_arena);
+                if (top.type == VariantType::object)
+                {
+                    for (usize i = top.first; i < m_values.size(); ++i) value.insert(m_values[i].first, move(m_values[i].second));
+                }
+                else
+                {
+                    for (usize i = top.first; i < m_values.size(); ++i) value.push_back(move(m_values[i].second));
+                }
+                m_values.resize(top.first);
+                m_key = move(top.key);
+                m_stack.pop_back();
+                add(move(value));
+                return ok;
+            }
+            RV on_begin_array()
+            {
+                m_stack.push_back({ m_values.size(), move(m_key), VariantType::array });
+                return ok;
+            }
+            RV on_end_array()
+            {
+                return on_end_object();
+            }
+            RV on_value(Variant& value)
+            {
+                add(move(value));
+                return ok;
+            }
+        };
+        template <typename _Ctx, typename _Handler>
+        static RV read_value(_Ctx& ctx, _Handler& handler);
+        template <typename _Ctx, typename _Handler>
+        static RV read_object(_Ctx& ctx, _Handler& handler)
         {
             lucheck(ctx.next_char() == '{');
             ctx.consume('{');
-            skip_whitespaces_and_comments(ctx);
-            Variant v(VariantType::object);
-            c32 ch = ctx.next_char();
-            while (ch && ch != '}')
+            lutry
             {
-                if (ch != '"') return set_error(BasicError::format_error(), "The object field must start with a string name (line %d pos %d).", ctx.get_line(), ctx.get_pos());
-                R<String> name_str = read_string_literal(ctx);
-                if (failed(name_str)) return name_str.errcode();
+                luexp(handler.on_begin_object());
                 skip_whitespaces_and_comments(ctx);
-                ch = ctx.next_char();
-                if (ch != ':') return set_error(BasicError::format_error(), "':' expected at the end of the field name (line %d pos %d).", ctx.get_line(), ctx.get_pos());
-                ctx.consume(ch);
-                R<Variant> val = read_value(ctx);
-                if (failed(val)) return val.errcode();
-                v.insert(Name(name_str.get()), move(val.get()));
-                skip_whitespaces_and_comments(ctx);
-                ch = ctx.next_char();
-                if (ch == '}') break;
-                if (ch != ',') set_error(BasicError::format_error(), "',' expected at the end of the field (line %d pos %d).", ctx.get_line(), ctx.get_pos());
-                ctx.consume(ch);
-                skip_whitespaces_and_comments(ctx);
-                ch = ctx.next_char();
+                c32 ch = ctx.next_char();
+                while (ch && ch != '}')
+                {
+                    if (ch != '"') return set_error(BasicError::format_error(), "The object field must start with a string name (line %d pos %d).", ctx.get_line(), ctx.get_pos());
+                    lulet(name, read_name_literal(ctx));
+                    skip_whitespaces_and_comments(ctx);
+                    ch = ctx.next_char();
+                    if (ch != ':') return set_error(BasicError::format_error(), "':' expected at the end of the field name (line %d pos %d).", ctx.get_line(), ctx.get_pos());
+                    ctx.consume(ch);
+                    luexp(handler.on_key(name));
+                    luexp(read_value(ctx, handler));
+                    skip_whitespaces_and_comments(ctx);
+                    ch = ctx.next_char();
+                    if (ch == '}') break;
+                    if (ch != ',') set_error(BasicError::format_error(), "',' expected at the end of the field (line %d pos %d).", ctx.get_line(), ctx.get_pos());
+                    ctx.consume(ch);
+                    skip_whitespaces_and_comments(ctx);
+                    ch = ctx.next_char();
+                }
+                if (!ch) return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
+                ctx.consume('}');
+                luexp(handler.on_end_object());
             }
-            if (!ch) return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
-            ctx.consume('}');
-            return v;
+            lucatchret;
+            return ok;
         }
 
-        static R<Variant> read_array(IReadContext& ctx)
+        template <typename _Ctx, typename _Handler>
+        static RV read_array(_Ctx& ctx, _Handler& handler)
         {
             lucheck(ctx.next_char() == '[');
             ctx.consume('[');
-            skip_whitespaces_and_comments(ctx);
-            Variant v(VariantType::array);
-            c32 ch = ctx.next_char();
-            while (ch && ch != ']')
+            lutry
             {
-                R<Variant> val = read_value(ctx);
-                if (failed(val)) return val.errcode();
-                v.push_back(move(val.get()));
-                skip_whitespaces_and_comments(ctx);
-                ch = ctx.next_char();
-                if (ch == ']') break;
-                if (ch != ',') set_error(BasicError::format_error(), "',' expected at the end of every array item (line %d pos %d).", ctx.get_line(), ctx.get_pos());
-                ctx.consume(ch);
+                luexp(handler.on_begin_array());
                 skip_whitespaces_and_comments(ctx);
-                ch = ctx.next_char();
+                c32 ch = ctx.next_char();
+                while (ch && ch != ']')
+                {
+                    luexp(read_value(ctx, handler));
+                    skip_whitespaces_and_comments(ctx);
+                    ch = ctx.next_char();
+                    if (ch == ']') break;
+                    if (ch != ',') set_error(BasicError::format_error(), "',' expected at the end of every array item (line %d pos %d).", ctx.get_line(), ctx.get_pos());
+                    ctx.consume(ch);
+                    skip_whitespaces_and_comments(ctx);
+                    ch = ctx.next_char();
+                }
+                if (!ch) return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
+                ctx.consume(']');
+                luexp(handler.on_end_array());
             }
-            if (!ch) return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
-            ctx.consume(']');
-            return v;
+            lucatchret;
+            return ok;
         }
 
         static R<Variant> read_blob(const String& str)
@@ -267,7 +430,8 @@ namespace Luna
             return BasicError::failure();
         }
 
-        static R<Variant> read_string_or_blob(IReadContext& ctx)
+        template <typename _Ctx>
+        static R<Variant> read_string_or_blob(_Ctx& ctx)
         {
             R<String> s = read_string_literal(ctx);
             if (failed(s)) return s.errcode();
@@ -275,12 +439,27 @@ namespace Luna
             if (blob.valid()) return blob;
             return Variant(Name(move(s.get())));
         }
+        static R<Variant> read_string_or_blob(Utf8BufferReadContext& ctx)
+        {
+            // Strings that start with '@' may be BLOBs, which are handled by the common path.
+            const c8* begin = ctx.cur + 1;
+            if (begin < ctx.end && *begin != '@')
+            {
+                R<Name> name = read_name_literal(ctx);
+                if (failed(name)) return name.errcode();
+                return Variant(name.get());
+            }
+            return read_string_or_blob<Utf8BufferReadContext>(ctx);
+        }
 
-        static Variant read_number(IReadContext& ctx)
+        template <typename _Ctx>
+        static Variant read_number(_Ctx& ctx)
         {
-            String32 integral;
-            String32 decimal;
-            String32 exponent;
+            // Digits are accumulated when they are read, so that they need not to be stored.
+            f64 fvalue = 0.0;
+            u64 uvalue = 0;
+            i64 ivalue = 0;
+            i64 exp = 0;
             bool is_integral_positive = true;
             bool is_exponent_positive = true;
             bool is_floating_point = false;
@@ -293,19 +472,14 @@ namespace Luna
                 ch = ctx.next_char();
             }
             // Process integral part.
-            while (ch)
+            while (ch >= '0' && ch <= '9')
             {
-                if (ch >= '0' && ch <= '9')
-                {
-                    integral.push_back(ch);
-                    ctx.consume(ch);
-                    ch = ctx.next_char();
-                    continue;
-                }
-                else
-                {
-                    break;
-                }
+                u32 digit = ch - '0';
+                fvalue = fvalue * 10 + digit;
+                uvalue = uvalue * 10 + digit;
+                ivalue = ivalue * 10 + digit;
+                ctx.consume(ch);
+                ch = ctx.next_char();
             }
             // Process decimal part.
             if (ch == '.')
@@ -313,19 +487,13 @@ namespace Luna
                 is_floating_point = true;
                 ctx.consume(ch);
                 ch = ctx.next_char();
-                while (ch)
+                f64 decimal_base = 0.1;
+                while (ch >= '0' && ch <= '9')
                 {
-                    if (ch >= '0' && ch <= '9')
-                    {
-                        decimal.push_back(ch);
-                        ctx.consume(ch);
-                        ch = ctx.next_char();
-                        continue;
-                    }
-                    else
-                    {
-                        break;
-                    }
+                    fvalue += decimal_base * (ch - '0');
+                    decimal_base /= 10;
+                    ctx.consume(ch);
+                    ch = ctx.next_char();
                 }
             }
             // Process exponent part.
@@ -340,239 +508,191 @@ namespace Luna
                     ctx.consume(ch);
                     ch = ctx.next_char();
                 }
-                while (ch)
+                while (ch >= '0' && ch <= '9')
                 {
-                    if (ch >= '0' && ch <= '9')
-                    {
-                        exponent.push_back(ch);
-                        ctx.consume(ch);
-                        ch = ctx.next_char();
-                        continue;
-                    }
-                    else
-                    {
-                        break;
-                    }
+                    exp = exp * 10 + (ch - '0');
+                    ctx.consume(ch);
+                    ch = ctx.next_char();
                 }
             }
             // Parse.
             if (is_floating_point)
             {
-                f64 value = 0.0;
-                for (auto& i : integral)
-                {
-                    value *= 10;
-                    value += i - '0';
-                }
-                f64 decimal_base = 0.1;
-                for (auto& i : decimal)
-                {
-                    value += decimal_base * (i - '0');
-                    decimal_base /= 10;
-                }
-                i64 exp = 0;
-                for (auto& i : exponent)
-                {
-                    exp *= 10;
-                    exp += i - '0';
-                }
                 exp = is_exponent_positive ? exp : -exp;
                 while (exp > 0)
                 {
-                    value *= 10.0;
+                    fvalue *= 10.0;
                     exp--;
                 }
                 while (exp < 0)
                 {
-                    value *= 0.1;
+                    fvalue *= 0.1;
                     exp++;
                 }
-                value = is_integral_positive ? value : -value;
-                return Variant(value);
+                fvalue = is_integral_positive ? fvalue : -fvalue;
+                return Variant(fvalue);
             }
             else if (is_integral_positive)
             {
-                u64 value = 0;
-                for (auto i : integral)
-                {
-                    value *= 10;
-                    value += i - '0';
-                }
-                return Variant(value);
+                return Variant(uvalue);
             }
             else
             {
-                i64 value = 0;
-                for (auto i : integral)
-                {
-                    value *= 10;
-                    value += i - '0';
-                }
-                return Variant(value);
+                return Variant(-ivalue);
             }
         }
 
-        static R<Variant> read_value(IReadContext& ctx)
+        template <typename _Ctx, typename _Handler>
+        static RV read_value(_Ctx& ctx, _Handler& handler)
         {
             skip_whitespaces_and_comments(ctx);
             c32 ch = ctx.next_char();
-            if (ch == '\0')
-            {
-                return set_error(BasicError::format_error(), "Unexpected EOF reached at at line %u, pos %u.", ctx.get_line(), ctx.get_pos());
-            }
-            else if (ch == '{')
-            {
-                return read_object(ctx);
-            }
-            else if (ch == '[')
-            {
-                return read_array(ctx);
-            }
-            else if (ch == '"')
+            Variant value;
+            lutry
             {
-                return read_string_or_blob(ctx);
-            }
-            else if (ch == 't' && ctx.next_char(1) == 'r' && ctx.next_char(2) == 'u' && ctx.next_char(3) == 'e')
-            {
-                ctx.consume('t');
-                ctx.consume('r');
-                ctx.consume('u');
-                ctx.consume('e');
-                return Variant(true);
-            }
-            else if (ch == 'f' && ctx.next_char(1) == 'a' && ctx.next_char(2) == 'l' && ctx.next_char(3) == 's' && ctx.next_char(4) == 'e')
-            {
-                // Check false.
-                ctx.consume('f');
-                ctx.consume('a');
-                ctx.consume('l');
-                ctx.consume('s');
-                ctx.consume('e');
-                return Variant(false);
-            }
-            else if (ch == 'n' && ctx.next_char(1) == 'u' && ctx.next_char(2) == 'l' && ctx.next_char(3) == 'l')
-            {
-                // Check null.
-                ctx.consume('n');
-                ctx.consume('u');
-                ctx.consume('l');
-                ctx.consume('l');
-                return Variant(VariantType::null);
-            }
-            else if (ch == '-' || ch == '0' || (ch >= '1' && ch <= '9'))
-            {
-                return read_number(ctx);
-            }
-            else
-            {
-                return set_error(BasicError::format_error(), "Unrecognized token: %c(0x%0x) at line %n, pos %n.", (c8)ch, (u32)ch, ctx.get_line(), ctx.get_pos());
+                if (ch == '\0')
+                {
+                    return set_error(BasicError::format_error(), "Unexpected EOF reached at at line %u, pos %u.", ctx.get_line(), ctx.get_pos());
+                }
+                else if (ch == '{')
+                {
+                    return read_object(ctx, handler);
+                }
+                else if (ch == '[')
+                {
+                    return read_array(ctx, handler);
+                }
+                else if (ch == '"')
+                {
+                    luset(value, read_string_or_blob(ctx));
+                }
+                else if (ch == 't' && ctx.next_char(1) == 'r' && ctx.next_char(2) == 'u' && ctx.next_char(3) == 'e')
+                {
+                    ctx.consume('t');
+                    ctx.consume('r');
+                    ctx.consume('u');
+                    ctx.consume('e');
+                    value = true;
+                }
+                else if (ch == 'f' && ctx.next_char(1) == 'a' && ctx.next_char(2) == 'l' && ctx.next_char(3) == 's' && ctx.next_char(4) == 'e')
+                {
+                    // Check false.
+                    ctx.consume('f');
+                    ctx.consume('a');
+                    ctx.consume('l');
+                    ctx.consume('s');
+                    ctx.consume('e');
+                    value = false;
+                }
+                else if (ch == 'n' && ctx.next_char(1) == 'u' && ctx.next_char(2) == 'l' && ctx.next_char(3) == 'l')
+                {
+                    // Check null.
+                    ctx.consume('n');
+                    ctx.consume('u');
+                    ctx.consume('l');
+                    ctx.consume('l');
+                }
+                else if (ch == '-' || ch == '0' || (ch >= '1' && ch <= '9'))
+                {
+                    value = read_number(ctx);
+                }
+                else
+                {
+                    return set_error(BasicError::format_error(), "Unrecognized token: %c(0x%0x) at line %n, pos %n.", (c8)ch, (u32)ch, ctx.get_line(), ctx.get_pos());
+                }
+                luexp(handler.on_value(value));
             }
+            lucatchret;
+            return ok;
         }
-
-        inline void write_indents(String& s, u32 num_indents)
+        struct JSONEscapeTable
         {
-            for (u32 i = 0; i < num_indents; ++i)
+            const c8* table[256] = {};
+            constexpr JSONEscapeTable()
             {
-                s.append("    ", 4);
+                table['\"'] = "\\\"";
+                table['\\'] = "\\\\";
+                table['/'] = "\\/";
+                table['\b'] = "\\b";
+                table['\f'] = "\\f";
+                table['\n'] = "\\n";
+                table['\r'] = "\\r";
+                table['\t'] = "\\t";
+                table['\a'] = "\\a";
+                table['\v'] = "\\v";
             }
+        };
+        static constexpr JSONEscapeTable g_json_escape_table;
+
+        inline void write_indents(TextWriter& s, u32 num_indents)
+        {
+            s.write_indents(' ', (usize)num_indents * 4);
         }
 
-        static void write_string_value(String& s, const c8* v, usize len)
+        static void write_string_value(TextWriter& s, const c8* v, usize len)
         {
-            s.push_back('"');
-            const c8* cur = v;
-            const c8* end = v + len;
-            while (cur < end)
-            {
-                c32 ch = utf8_decode_char(cur);
-                switch (ch)
-                {
-                case '\"':
-                    s.append("\\\"");
-                    break;
-                case '\\':
-                    s.append("\\\\");
-                    break;
-                case '/':
-                    s.append("\\/");
-                    break;
-                case '\b':
-                    s.append("\\b");
-                    break;
-                case '\f':
-                    s.append("\\f");
-                    break;
-                case '\n':
-                    s.append("\\n");
-                    break;
-                case '\r':
-                    s.append("\\r");
-                    break;
-                case '\t':
-                    s.append("\\t");
-                    break;
-                case '\a':
-                    s.append("\\a");
-                    break;
-                case '\v':
-                    s.append("\\v");
-                    break;
-                default:
-                    s.append(cur, utf8_charspan(ch));
-                    break;
-                }
-                cur += utf8_charspan(ch);
-            }
-            s.push_back('"');
+            s.put('"');
+            s.write_escaped(v, len, g_json_escape_table.table);
+            s.put('"');
         }
 
-        static void write_blob_value(String& s, const void* data, usize data_size, usize data_alignment)
+        static void write_blob_value(TextWriter& s, const void* data, usize data_size, usize data_alignment)
         {
+            // Encodes the blob in chunks, so that the encoded blob is never stored in memory as a whole.
+            // The chunk size is a multiple of both 3 (base64) and 4 (base85) bytes.
+            constexpr usize CHUNK_SIZE = 3072;
+            c8 encoded[CHUNK_SIZE / 3 * 4 + 1];
+            const byte_t* src = (const byte_t*)data;
+            c8 buf[128];
+            s.put('"');
             if (data_size % 4 == 0)
             {
-                c8 buf[128];
                 snprintf(buf, 128, "@base85@%llu@%llu@", (long long unsigned int)data_size, (long long unsigned int)data_alignment);
-                String raw(buf);
-                usize encoded_size = base85_get_encoded_size(data_size);
-                usize begin = raw.size();
-                raw.resize(raw.size() + encoded_size + 1, '\0');
-                base85_encode(raw.data() + begin, raw.size() - begin, data, data_size);
-                write_string_value(s, raw.c_str(), raw.size());
+                s.write(buf);
+                for (usize offset = 0; offset < data_size; offset += CHUNK_SIZE)
+                {
+                    usize chunk_size = min(data_size - offset, CHUNK_SIZE);
+                    usize encoded_size = base85_get_encoded_size(chunk_size);
+                    base85_encode(encoded, encoded_size + 1, src + offset, chunk_size);
+                    // Base85 characters include '"', '\\' and '/', which must be escaped.
+                    s.write_escaped(encoded, encoded_size, g_json_escape_table.table);
+                }
             }
             else
             {
-                s.push_back('"');
-                c8 buf[128];
                 snprintf(buf, 128, "@base64@%llu@%llu@", (long long unsigned int)data_size, (long long unsigned int)data_alignment);
-                s.append(buf);
-                usize encoded_size = base64_get_encoded_size(data_size);
-                usize offset = s.size();
-                s.resize(s.size() + encoded_size + 1, '\0');
-                base64_encode(s.data() + offset, encoded_size + 1, data, data_size);
-                s.push_back('"');
+                s.write(buf);
+                for (usize offset = 0; offset < data_size; offset += CHUNK_SIZE)
+                {
+                    usize chunk_size = min(data_size - offset, CHUNK_SIZE);
+                    usize encoded_size = base64_get_encoded_size(chunk_size);
+                    base64_encode(encoded, encoded_size + 1, src + offset, chunk_size);
+                    s.write(encoded, encoded_size);
+                }
             }
+            s.put('"');
         }
 
-        static void write_value(const Variant& v, String& s, bool indent, u32 base_indent)
+        static void write_value(const Variant& v, TextWriter& s, bool indent, u32 base_indent)
         {
             switch (v.type())
             {
             case VariantType::null:
-                s.append("null");
+                s.write("null", 4);
                 break;
             case VariantType::object:
             {
                 if (v.empty())
                 {
-                    s.append("{}"); // prevent indent for empty object.
+                    s.write("{}", 2); // prevent indent for empty object.
                 }
                 else
                 {
-                    s.push_back('{');
+                    s.put('{');
                     if (indent)
                     {
                         ++base_indent;
-                        s.push_back('\n');
+                        s.put('\n');
                     }
                     usize count = 0;
                     for (auto& i : v.key_values())
@@ -582,16 +702,16 @@ namespace Luna
                             write_indents(s, base_indent);
                         }
                         write_string_value(s, i.first.c_str(), i.first.size());
-                        s.push_back(':');
+                        s.put(':');
                         if (indent)
                         {
-                            s.push_back(' ');
+                            s.put(' ');
                         }
                         write_value(i.second, s, indent, base_indent);
-                        if (count != v.size() - 1) s.push_back(',');
+                        if (count != v.size() - 1) s.put(',');
                         if (indent)
                         {
-                            s.push_back('\n');
+                            s.put('\n');
                         }
                         ++count;
                     }
@@ -600,7 +720,7 @@ namespace Luna
                         --base_indent;
                         write_indents(s, base_indent);
                     }
-                    s.push_back('}');
+                    s.put('}');
                 }
             }
             break;
@@ -608,50 +728,61 @@ namespace Luna
             {
                 if (v.empty())
                 {
-                    s.append("[]");
+                    s.write("[]", 2);
                 }
                 else
                 {
-                    s.push_back('[');
+                    s.put('[');
                     for (usize i = 0; i < v.size(); ++i)
                     {
                         write_value(v[i], s, indent, base_indent);
-                        if (i != v.size() - 1) s.push_back(',');
+                        if (i != v.size() - 1) s.put(',');
                     }
-                    s.push_back(']');
+                    s.put(']');
                 }
             }
             break;
             case VariantType::number:
             {
-                c8 buf[64];
                 switch (v.number_type())
                 {
                 case VariantNumberType::number_f64:
-                    snprintf(buf, 64, "%f", v.fnum()); break;
+                    s.write_f64(v.fnum()); break;
                 case VariantNumberType::number_i64:
-                    snprintf(buf, 64, "%lld", (long long int)v.inum()); break;
+                    s.write_i64(v.inum()); break;
                 case VariantNumberType::number_u64:
-                    snprintf(buf, 64, "%llu", (long long unsigned int)v.unum()); break;
+                    s.write_u64(v.unum()); break;
                 default: lupanic(); break;
                 }
-                s.append(buf);
             }
             break;
             case VariantType::string:
                 write_string_value(s, v.str().c_str(), v.str().size());
                 break;
             case VariantType::boolean:
-                s.append(v.boolean() ? "true" : "false");
+                if (v.boolean()) s.write("true", 4);
+                else s.write("false", 5);
                 break;
             case VariantType::blob:
                 write_blob_value(s, v.blob_data(), v.blob_size(), v.blob_alignment());
                 break;
             }
         }
-        LUNA_VARIANT_UTILS_API R<Variant> read_json(const c8* src, usize src_size)
+        // Forwards parsing events to one user handler.
+        struct JSONEventForwarder
+        {
+            JSONReadHandler& m_handler;
+
+            RV on_begin_object() { return m_handler.on_begin_object(); }
+            RV on_key(const Name& key) { return m_handler.on_key(key); }
+            RV on_end_object() { return m_handler.on_end_object(); }
+            RV on_begin_array() { return m_handler.on_begin_array(); }
+            RV on_end_array() { return m_handler.on_end_array(); }
+            RV on_value(Variant& value) { return m_handler.on_value(value); }
+        };
+        template <typename _Handler>
+        static RV read_json_buffer(const c8* src, usize src_size, _Handler& handler)
         {
-            lucheck(src);
             BufferReadContext ctx;
             ctx.src = src;
             ctx.cur = src;
@@ -660,27 +791,315 @@ namespace Luna
             ctx.pos = 1;
             ctx.encoding = Encoding::utf_8;
             ctx.skip_utf16_bom();
-            return read_value(ctx);
+            if (ctx.encoding == Encoding::utf_8)
+            {
+                // The string may end before `src_size`, and `src_size` may be `USIZE_MAX`.
+                Utf8BufferReadContext utf8_ctx;
+                utf8_ctx.src = src;
+                utf8_ctx.cur = src;
+                utf8_ctx.end = src + strnlen(src, src_size);
+                return read_value(utf8_ctx, handler);
+            }
+            return read_value((IReadContext&)ctx, handler);
         }
-        LUNA_VARIANT_UTILS_API R<Variant> read_json(IStream* stream)
+        template <typename _Handler>
+        static RV read_json_stream(IStream* stream, _Handler& handler)
         {
-            lucheck(stream);
-            StreamReadContext ctx;
-            ctx.stream = stream;
+            StreamReadContext ctx(stream);
             ctx.line = 1;
             ctx.pos = 1;
-            return read_value(ctx);
+            return read_value((IReadContext&)ctx, handler);
+        }
+        LUNA_VARIANT_UTILS_API R<Variant> read_json(const c8* src, usize src_size, Arena* arena)
+        {
+            lucheck(src);
+            JSONVariantBuilder builder;
+            builder.m_arena = arena;
+            lutry
+            {
+                luexp(read_json_buffer(src, src_size, builder));
+            }
+            lucatchret;
+            return move(builder.m_result);
+        }
+        LUNA_VARIANT_UTILS_API R<Variant> read_json(IStream* stream, Arena* arena)
+        {
+            lucheck(stream);
+            JSONVariantBuilder builder;
+            builder.m_arena = arena;
+            lutry
+            {
+                luexp(read_json_stream(stream, builder));
+            }
+            lucatchret;
+            return move(builder.m_result);
+        }
+        LUNA_VARIANT_UTILS_API RV read_json_events(JSONReadHandler& handler, const c8* src, usize src_size)
+        {
+            lucheck(src);
+            JSONEventForwarder forwarder{ handler };
+            return read_json_buffer(src, src_size, forwarder);
+        }
+        LUNA_VARIANT_UTILS_API RV read_json_events(JSONReadHandler& handler, IStream* stream)
+        {
+            lucheck(stream);
+            JSONEventForwarder forwarder{ handler };
+            return read_json_stream(stream, forwarder);
+        }
+
+        // Skips one string literal starting at `cur`. Returns the position after the closing quote, or `nullptr` if the string does not end.
+        static const c8* skip_string_literal(const c8* cur, const c8* end)
+        {
+            ++cur; // for ".
+            while (true)
+            {
+                cur = find_string_special_char(cur, end);
+                if (cur >= end || !*cur) return nullptr;
+                if (*cur == '"') return cur + 1;
+                // Skips the escaped character.
+                cur += 2;
+                if (cur > end) return nullptr;
+            }
+        }
+        // Skips one JSON value without parsing it. This only matches brackets and skips string literals and comments, the
+        // skipped value is validated only when it is parsed.
+        static RV skip_json_value(Utf8BufferReadContext& ctx)
+        {
+            skip_whitespaces_and_comments(ctx);
+            const c8* cur = ctx.cur;
+            const c8* end = ctx.end;
+            if (cur >= end || !*cur) return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
+            if (*cur == '"')
+            {
+                cur = skip_string_literal(cur, end);
+                if (!cur) return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
+                ctx.cur = cur;
+                return ok;
+            }
+            if (*cur != '{' && *cur != '[')
+            {
+                // Skips one number, Boolean or null value.
+                while (cur < end && *cur && *cur != ',' && *cur != '}' && *cur != ']' && *cur != '/' && !is_whitespace((u8)*cur)) ++cur;
+                ctx.cur = cur;
+                return ok;
+            }
+            usize depth = 0;
+            while (cur < end && *cur)
+            {
+                c8 ch = *cur;
+                if (ch == '"')
+                {
+                    cur = skip_string_literal(cur, end);
+                    if (!cur) break;
+                    continue;
+                }
+                if (ch == '/' && cur + 1 < end && (cur[1] == '/' || cur[1] == '*'))
+                {
+                    ctx.cur = cur;
+                    skip_whitespaces_and_comments(ctx);
+                    cur = ctx.cur;
+                    continue;
+                }
+                ++cur;
+                if (ch == '{' || ch == '[')
+                {
+                    ++depth;
+                }
+                else if (ch == '}' || ch == ']')
+                {
+                    --depth;
+                    if (!depth)
+                    {
+                        ctx.cur = cur;
+                        return ok;
+                    }
+                }
+            }
+            return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
+        }
+        static Utf8BufferReadContext get_json_view_context(const JSONView& view)
+        {
+            Utf8BufferReadContext ctx;
+            ctx.src = view.src;
+            ctx.cur = view.value;
+            ctx.end = view.end;
+            return ctx;
+        }
+        static JSONView get_json_view(const Utf8BufferReadContext& ctx)
+        {
+            JSONView view;
+            view.src = ctx.src;
+            view.value = ctx.cur;
+            view.end = ctx.end;
+            return view;
+        }
+        // Moves the cursor to the first item of one object or array. Returns `false` if the object or array is empty.
+        static R<bool> begin_json_view_items(Utf8BufferReadContext& ctx, c32 open, c32 close)
+        {
+            if (ctx.next_char() != open) return set_error(BasicError::bad_arguments(), "The JSON value is not %s.", open == '{' ? "an object" : "an array");
+            ctx.consume(open);
+            skip_whitespaces_and_comments(ctx);
+            c32 ch = ctx.next_char();
+            if (!ch) return set_error(BasicError::format_error(), "Unexpected EOF occurred at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
+            return ch != close;
+        }
+        // Moves the cursor to the next item of one object or array after one item is skipped. Returns `false` if the object
+        // or array ends.
+        static R<bool> next_json_view_item(Utf8BufferReadContext& ctx, c32 close)
+        {
+            skip_whitespaces_and_comments(ctx);
+            c32 ch = ctx.next_char();
+            if (ch == close) return false;
+            if (ch != ',') return set_error(BasicError::format_error(), "',' expected at line %d, pos %d.", ctx.get_line(), ctx.get_pos());
+            ctx.consume(ch);
+            skip_whitespaces_and_comments(ctx);
+            return true;
+        }
+        // Reads one object key and moves the cursor to the field value.
+        static RV read_json_view_key(Utf8BufferReadContext& ctx, const Name& key, bool& matched)
+        {
+            if (ctx.next_char() != '"') return set_error(BasicError::format_error(), "The object field must start with a string name (line %d pos %d).", ctx.get_line(), ctx.get_pos());
+            const c8* begin = ctx.cur + 1;
+            const c8* run_end = find_string_special_char(begin, ctx.end);
+            if (run_end < ctx.end && *run_end == '"')
+            {
+                usize size = run_end - begin;
+                matched = size == key.size() && (!size || !memcmp(begin, key.c_str(), size));
+                ctx.cur = run_end + 1;
+            }
+            else
+            {
+                auto s = read_string_literal(ctx);
+                if (failed(s)) return s.errcode();
+                matched = s.get().size() == key.size() && (s.get().empty() || !memcmp(s.get().c_str(), key.c_str(), key.size()));
+            }
+            skip_whitespaces_and_comments(ctx);
+            c32 ch = ctx.next_char();
+            if (ch != ':') return set_error(BasicError::format_error(), "':' expected at the end of the field name (line %d pos %d).", ctx.get_line(), ctx.get_pos());
+            ctx.consume(ch);
+            skip_whitespaces_and_comments(ctx);
+            return ok;
+        }
+        LUNA_VARIANT_UTILS_API JSONView view_json(const c8* src, usize src_size)
+        {
+            lucheck(src);
+            Utf8BufferReadContext ctx;
+            ctx.src = src;
+            ctx.cur = src;
+            ctx.end = src + strnlen(src, src_size);
+            skip_whitespaces_and_comments(ctx);
+            return get_json_view(ctx);
+        }
+        LUNA_VARIANT_UTILS_API VariantType get_json_view_type(const JSONView& view)
+        {
+            if (view.value >= view.end) return VariantType::null;
+            switch (*view.value)
+            {
+            case '{': return VariantType::object;
+            case '[': return VariantType::array;
+            case '"':
+            {
+                usize size = view.end - view.value;
+                if (size > 9 && (!memcmp(view.value, "\"@base85@", 9) || !memcmp(view.value, "\"@base64@", 9))) return VariantType::blob;
+                return VariantType::string;
+            }
+            case 't':
+            case 'f': return VariantType::boolean;
+            case '-':
+            case '0': case '1': case '2': case '3': case '4':
+            case '5': case '6': case '7': case '8': case '9': return VariantType::number;
+            default: return VariantType::null;
+            }
+        }
+        LUNA_VARIANT_UTILS_API R<usize> get_json_view_size(const JSONView& view)
+        {
+            usize size = 0;
+            lutry
+            {
+                Utf8BufferReadContext ctx = get_json_view_context(view);
+                c32 ch = ctx.next_char();
+                c32 close = ch == '[' ? ']' : '}';
+                lulet(not_empty, begin_json_view_items(ctx, ch == '[' ? '[' : '{', close));
+                bool has_item = not_empty;
+                while (has_item)
+                {
+                    if (close == '}')
+                    {
+                        bool matched;
+                        luexp(read_json_view_key(ctx, Name(), matched));
+                    }
+                    luexp(skip_json_value(ctx));
+                    ++size;
+                    luset(has_item, next_json_view_item(ctx, close));
+                }
+            }
+            lucatchret;
+            return size;
+        }
+        LUNA_VARIANT_UTILS_API R<JSONView> get_json_view_field(const JSONView& view, const Name& key)
+        {
+            lutry
+            {
+                Utf8BufferReadContext ctx = get_json_view_context(view);
+                lulet(not_empty, begin_json_view_items(ctx, '{', '}'));
+                bool has_item = not_empty;
+                while (has_item)
+                {
+                    bool matched;
+                    luexp(read_json_view_key(ctx, key, matched));
+                    if (matched) return get_json_view(ctx);
+                    luexp(skip_json_value(ctx));
+                    luset(has_item, next_json_view_item(ctx, '}'));
+                }
+            }
+            lucatchret;
+            return BasicError::not_found();
+        }
+        LUNA_VARIANT_UTILS_API R<JSONView> get_json_view_element(const JSONView& view, usize index)
+        {
+            lutry
+            {
+                Utf8BufferReadContext ctx = get_json_view_context(view);
+                lulet(not_empty, begin_json_view_items(ctx, '[', ']'));
+                bool has_item = not_empty;
+                usize i = 0;
+                while (has_item)
+                {
+                    if (i == index) return get_json_view(ctx);
+                    luexp(skip_json_value(ctx));
+                    ++i;
+                    luset(has_item, next_json_view_item(ctx, ']'));
+                }
+            }
+            lucatchret;
+            return BasicError::out_of_range();
+        }
+        LUNA_VARIANT_UTILS_API R<Variant> read_json_view(const JSONView& view)
+        {
+            Utf8BufferReadContext ctx = get_json_view_context(view);
+            JSONVariantBuilder builder;
+            lutry
+            {
+                luexp(read_value(ctx, builder));
+            }
+            lucatchret;
+            return move(builder.m_result);
         }
         LUNA_VARIANT_UTILS_API String write_json(const Variant& v, bool indent)
         {
             String r;
-            write_value(v, r, indent, 0);
+            TextWriter writer(r);
+            write_value(v, writer, indent, 0);
+            // Writing to one string never fails.
+            auto _ = writer.finish();
             return r;
         }
         LUNA_VARIANT_UTILS_API RV write_json(IStream* stream, const Variant& v, bool indent)
         {
-            String data = write_json(v, indent);
-            return stream->write(data.data(), data.size());
+            lucheck(stream);
+            TextWriter writer(stream);
+            write_value(v, writer, indent, 0);
+            return writer.finish();
         }
     }
 }
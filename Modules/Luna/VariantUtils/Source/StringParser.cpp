@@ -139,65 +139,42 @@ namespace Luna
                 ++pos;
             }
         }
-        RV StreamReadContext::stream_read(void* buf, usize read_size, usize* read_bytes)
-        {
-            usize real_read_bytes = 0;
-            u8* buf_u8 = (u8*)buf;
-            while(read_size && !stream_buffer.empty())
-            {
-                *buf_u8 = stream_buffer.front();
-                stream_buffer.pop_front();
-                ++buf_u8;
-                ++real_read_bytes;
-                --read_size;
-            }
-            lutry
-            {
-                if(read_size)
-                {
-                    usize stream_read_bytes;
-                    luexp(stream->read(buf_u8, read_size, &stream_read_bytes));
-                    real_read_bytes += stream_read_bytes;
-                }
-            }
-            lucatchret;
-            if(read_bytes) *read_bytes = real_read_bytes;
-            return ok;
-        }
         R<c32> StreamReadContext::read_one_char_from_stream()
         {
             c32 ret;
             lutry
             {
+                Span<const byte_t> data;
                 if(encoding == Encoding::utf_8)
                 {
-                    c8 buf[6];
-                    usize read_bytes;
-                    luexp(stream_read(buf, sizeof(c8), &read_bytes));
-                    if (read_bytes != sizeof(c8)) return 0;
-                    usize charspan = utf8_charlen(buf[0]);
-                    if (charspan > 1)
+                    luset(data, stream.peek(sizeof(c8)));
+                    if (data.empty()) return 0;
+                    usize charspan = utf8_charlen((c8)data[0]);
+                    if (data.size() < charspan)
                     {
-                        luexp(stream_read((buf + 1), sizeof(c8) * (charspan - 1), &read_bytes));
-                        if (read_bytes != sizeof(c8) * (charspan - 1)) return 0;
+                        luset(data, stream.peek(charspan));
+                        if (data.size() < charspan) return 0;
                     }
-                    ret = utf8_decode_char(buf);
+                    ret = utf8_decode_char((const c8*)data.data());
+                    stream.consume(charspan);
                 }
                 else
                 {
                     c16 buf[2];
-                    usize read_bytes;
-                    luexp(stream_read(buf, sizeof(c16), &read_bytes));
-                    if (read_bytes != sizeof(c16)) return 0;
+                    luset(data, stream.peek(sizeof(c16)));
+                    if (data.size() < sizeof(c16)) return 0;
+                    memcpy(buf, data.data(), sizeof(c16));
                     buf[0] = utf16_read_char(buf[0], encoding);
                     usize charspan = utf16_charlen(buf[0]);
                     if (charspan > 1)
                     {
-                        luexp(stream_read((buf + 1), sizeof(c16) * (charspan - 1), &read_bytes));
-                        if (read_bytes != sizeof(c16) * (charspan - 1)) return 0;
+                        luset(data, stream.peek(sizeof(c16) * 2));
+                        if (data.size() < sizeof(c16) * 2) return 0;
+                        memcpy(buf + 1, data.data() + sizeof(c16), sizeof(c16));
                         buf[1] = utf16_read_char(buf[1], encoding);
                     }
                     ret = utf16_decode_char(buf);
+                    stream.consume(sizeof(c16) * charspan);
                 }
             }
             lucatchret;
@@ -215,29 +192,21 @@ namespace Luna
         }
         void StreamReadContext::skip_utf16_bom()
         {
-            u8 ch[2];
-            usize read_bytes;
-            auto r = stream->read(ch, 2, &read_bytes);
-            if(failed(r) || read_bytes != 2)
+            auto r = stream.peek(2);
+            if(failed(r) || r.get().size() != 2)
             {
-                if(read_bytes)
-                {
-                    stream_buffer.push_back(ch[0]);
-                }
                 return;
             }
+            const byte_t* ch = r.get().data();
             if(ch[0] == 0xFE && ch[1] == 0xFF)
             {
                 encoding = Encoding::utf_16_be;
+                stream.consume(2);
             }
             else if(ch[0] == 0xFF && ch[1] == 0xFE)
             {
                 encoding = Encoding::utf_16_le;
-            }
-            else
-            {
-                stream_buffer.push_back(ch[0]);
-                stream_buffer.push_back(ch[1]);
+                stream.consume(2);
             }
         }
     }
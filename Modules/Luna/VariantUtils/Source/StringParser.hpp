@@ -10,7 +10,7 @@
 #pragma once
 #include <Luna/Runtime/Base.hpp>
 #include <Luna/Runtime/Unicode.hpp>
-#include <Luna/Runtime/Stream.hpp>
+#include <Luna/Runtime/BufferedStream.hpp>
 #include <Luna/Runtime/RingDeque.hpp>
 
 namespace Luna
@@ -63,15 +63,79 @@ namespace Luna
             void skip_utf16_bom();
         };
 
-        // A stream read context
+        // A read context for UTF-8 buffers. Unlike other read contexts, this context is not accessed through
+        // @ref IReadContext, so that parsers can be instantiated with it and inline all character accesses.
+        // The line and position are not tracked when characters are consumed, but are computed from the
+        // buffer when requested, since they are only used for reporting errors.
+        struct Utf8BufferReadContext
+        {
+            const c8* src;
+            const c8* cur;
+            const c8* end;
+
+            void consume(c32 ch)
+            {
+                if (ch == 0) return;
+                cur += utf8_charspan(ch);
+            }
+            c32 next_char(usize index = 0)
+            {
+                const c8* next_cur = cur;
+                while (index)
+                {
+                    if (next_cur >= end) return 0;
+                    u8 b = (u8)*next_cur;
+                    if (b < 0x80)
+                    {
+                        if (!b) return 0;
+                        ++next_cur;
+                    }
+                    else
+                    {
+                        c32 ch = utf8_decode_char(next_cur);
+                        if (!ch) return 0;
+                        next_cur += utf8_charspan(ch);
+                    }
+                    --index;
+                }
+                if (next_cur >= end) return 0;
+                u8 b = (u8)*next_cur;
+                return b < 0x80 ? (c32)b : utf8_decode_char(next_cur);
+            }
+            u32 get_line()
+            {
+                u32 line = 1;
+                for (const c8* p = src; p < cur; ++p)
+                {
+                    if (*p == '\n') ++line;
+                }
+                return line;
+            }
+            u32 get_pos()
+            {
+                u32 pos = 1;
+                for (const c8* p = src; p < cur; ++p)
+                {
+                    if (*p == '\n') pos = 1;
+                    // Counts characters rather than bytes by skipping UTF-8 continuation bytes.
+                    else if (((u8)*p & 0xC0) != 0x80) ++pos;
+                }
+                return pos;
+            }
+        };
+
+        // A stream read context. Characters are decoded from the buffer of `stream` directly, so that
+        // the underlying stream is only called when the buffer is exhausted.
         struct StreamReadContext : public IReadContext
         {
             Encoding encoding = Encoding::utf_8;
-            IStream* stream;
-            RingDeque<u8> stream_buffer;
+            BufferedStream stream;
             RingDeque<c32> buffer;
             u32 line;
             u32 pos;
+
+            StreamReadContext(IStream* stream) :
+                stream(stream) {}
             virtual void consume(c32 ch) override;
         private:
             R<c32> read_one_char_from_stream();
@@ -80,8 +144,6 @@ namespace Luna
             virtual u32 get_line() override { return line; }
             virtual u32 get_pos() override { return pos; }
 
-            RV stream_read(void* buf, usize read_size, usize* read_bytes);
-
             void skip_utf16_bom();
         };
     }
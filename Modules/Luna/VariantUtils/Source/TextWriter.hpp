@@ -0,0 +1,201 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file TextWriter.hpp
+* @author JXMaster
+* @date 2024/3/20
+*/
+#pragma once
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/Stream.hpp>
+#include <Luna/Runtime/Result.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <charconv>
+
+namespace Luna
+{
+    namespace VariantUtils
+    {
+        // The common writer for writing string content (JSON, XML, etc).
+        // Text is collected in one fixed-size buffer and flushed to the target string or stream when the buffer is full,
+        // so writing to one stream never needs more memory than the buffer.
+        class TextWriter
+        {
+        public:
+            static constexpr usize BUFFER_SIZE = 4096;
+            // The maximum number of characters that can be written by one `reserve` call.
+            static constexpr usize MAX_RESERVE_SIZE = 64;
+
+            TextWriter(String& target) : m_string(&target) {}
+            TextWriter(IStream* target) : m_stream(target) {}
+
+            void write(const c8* data, usize size)
+            {
+                if (size <= BUFFER_SIZE - m_size)
+                {
+                    memcpy(m_buffer + m_size, data, size);
+                    m_size += size;
+                    return;
+                }
+                flush();
+                if (size >= BUFFER_SIZE)
+                {
+                    // Large data is written to the target directly.
+                    write_target(data, size);
+                    return;
+                }
+                memcpy(m_buffer, data, size);
+                m_size = size;
+            }
+            void write(const c8* str)
+            {
+                write(str, strlen(str));
+            }
+            void put(c8 ch)
+            {
+                if (m_size == BUFFER_SIZE) flush();
+                m_buffer[m_size++] = ch;
+            }
+            // Gets one pointer to write at most `size` characters to, `size` must not be greater than `MAX_RESERVE_SIZE`.
+            // Call `commit` to submit the characters actually written.
+            c8* reserve(usize size)
+            {
+                if (size > BUFFER_SIZE - m_size) flush();
+                return m_buffer + m_size;
+            }
+            void commit(usize size)
+            {
+                m_size += size;
+            }
+            void write_indents(c8 ch, usize count)
+            {
+                while (count)
+                {
+                    if (m_size == BUFFER_SIZE) flush();
+                    usize n = min(count, BUFFER_SIZE - m_size);
+                    memset(m_buffer + m_size, ch, n);
+                    m_size += n;
+                    count -= n;
+                }
+            }
+            // Writes data with characters specified by `escape_table` being escaped. `escape_table` stores one escape string for
+            // every byte value, or `nullptr` if the byte is written as is. Bytes that are not escaped are written in bulk.
+            void write_escaped(const c8* data, usize size, const c8* const* escape_table)
+            {
+                const c8* cur = data;
+                const c8* end = data + size;
+                const c8* run = cur;
+                while (cur < end)
+                {
+                    const c8* escape = escape_table[(u8)*cur];
+                    if (escape)
+                    {
+                        if (run != cur) write(run, cur - run);
+                        write(escape);
+                        ++cur;
+                        run = cur;
+                    }
+                    else
+                    {
+                        ++cur;
+                    }
+                }
+                if (run != cur) write(run, cur - run);
+            }
+            void write_u64(u64 v)
+            {
+                c8 buf[24];
+                c8* end = buf + 24;
+                c8* p = end;
+                do
+                {
+                    *(--p) = (c8)('0' + v % 10);
+                    v /= 10;
+                } while (v);
+                write(p, end - p);
+            }
+            void write_i64(i64 v)
+            {
+                if (v < 0)
+                {
+                    put('-');
+                    write_u64(0 - (u64)v);
+                }
+                else
+                {
+                    write_u64((u64)v);
+                }
+            }
+            // Writes the shortest representation of the number that reads back to the same value.
+            // One ".0" suffix is appended to integral values so that they are read back as floating-point numbers.
+            void write_f64(f64 v)
+            {
+                c8* p = reserve(MAX_RESERVE_SIZE);
+                usize len;
+#if defined(__cpp_lib_to_chars)
+                auto r = std::to_chars(p, p + MAX_RESERVE_SIZE - 2, v);
+                len = r.ptr - p;
+#else
+                // Tries 15 digits first, which is enough for most values, and falls back to 17 digits that always round trip.
+                int n = snprintf(p, MAX_RESERVE_SIZE - 2, "%.15g", v);
+                if (strtod(p, nullptr) != v) n = snprintf(p, MAX_RESERVE_SIZE - 2, "%.17g", v);
+                len = (usize)n;
+#endif
+                bool integral = true;
+                for (usize i = 0; i < len; ++i)
+                {
+                    c8 ch = p[i];
+                    if (ch == '.' || ch == 'e' || ch == 'E' || ch == 'n' || ch == 'i')
+                    {
+                        integral = false;
+                        break;
+                    }
+                }
+                if (integral)
+                {
+                    p[len++] = '.';
+                    p[len++] = '0';
+                }
+                commit(len);
+            }
+            // Flushes all data to the target and returns the first error that occurs when writing to the target.
+            RV finish()
+            {
+                flush();
+                if (m_error.code) return m_error;
+                return ok;
+            }
+        private:
+            void write_target(const c8* data, usize size)
+            {
+                if (m_string)
+                {
+                    m_string->append(data, size);
+                }
+                else if (!m_error.code)
+                {
+                    // Stops writing to the stream after the first error.
+                    auto r = m_stream->write(data, size);
+                    if (failed(r)) m_error = r.errcode();
+                }
+            }
+            void flush()
+            {
+                if (m_size)
+                {
+                    write_target(m_buffer, m_size);
+                    m_size = 0;
+                }
+            }
+
+            c8 m_buffer[BUFFER_SIZE];
+            usize m_size = 0;
+            String* m_string = nullptr;
+            IStream* m_stream = nullptr;
+            ErrCode m_error = ErrCode(0);
+        };
+    }
+}
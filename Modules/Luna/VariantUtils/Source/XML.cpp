@@ -11,6 +11,7 @@
 #define LUNA_VARIANT_UTILS_API LUNA_EXPORT
 #include "../XML.hpp"
 #include "StringParser.hpp"
+#include "TextWriter.hpp"
 
 namespace Luna
 {
@@ -445,9 +446,9 @@ namespace Luna
             lucatchret;
             return s;
         }
-        static R<Variant> read_xml_attribute(IReadContext& ctx, Name& attribute_name)
+        static R<String> read_xml_attribute(IReadContext& ctx, Name& attribute_name)
         {
-            Variant ret;
+            String ret;
             lutry
             {
                 String name;
@@ -461,13 +462,13 @@ namespace Luna
                 skip_whitespaces_and_comments(ctx);
                 ch = ctx.next_char();
                 if(ch != '"' && ch != '\'') return set_error(BasicError::format_error(), "'\"' expected. (line %d pos %d).", ctx.get_line(), ctx.get_pos());
-                lulet(data, read_xml_string_literal(ctx));
-                ret = Name(data);
+                luset(ret, read_xml_string_literal(ctx));
             }
             lucatchret;
             return ret;
         }
-        static RV read_xml_start_tag(IReadContext& ctx, Variant& element, Name& element_name, bool& empty_tag)
+        template <typename _Handler>
+        static RV read_xml_start_tag(IReadContext& ctx, _Handler& handler, Name& element_name, bool& empty_tag)
         {
             lutry
             {
@@ -482,16 +483,15 @@ namespace Luna
                 read_xml_name(ctx, name);
                 if(name.empty()) return set_error(BasicError::format_error(), "Valid name character expected. (line %d pos %d).", ctx.get_line(), ctx.get_pos());
                 element_name = name;
-                element = new_xml_element(element_name);
+                luexp(handler.on_begin_element(element_name));
                 skip_whitespaces_and_comments(ctx);
                 ch = ctx.next_char();
                 c32 ch2 = ctx.next_char(1);
-                Variant& attributes = get_xml_attributes(element);
                 while(ch != '>' && !(ch == '/' && ch2 == '>'))
                 {
                     Name attribute_name;
                     lulet(attribute, read_xml_attribute(ctx, attribute_name));
-                    attributes[attribute_name] = move(attribute);
+                    luexp(handler.on_attribute(attribute_name, attribute));
                     skip_whitespaces_and_comments(ctx);
                     ch = ctx.next_char();
                     ch2 = ctx.next_char(1);
@@ -567,12 +567,13 @@ namespace Luna
             }
             return r;
         }
-        static R<Variant> read_xml_element(IReadContext& ctx);
-        static RV read_xml_content(IReadContext& ctx, Variant& element)
+        template <typename _Handler>
+        static RV read_xml_element(IReadContext& ctx, _Handler& handler);
+        template <typename _Handler>
+        static RV read_xml_content(IReadContext& ctx, _Handler& handler)
         {
             lutry
             {
-                Variant& content = get_xml_content(element);
                 c32 ch = ctx.next_char();
                 while(true)
                 {
@@ -601,12 +602,11 @@ namespace Luna
                         {
                             // read CDATA.
                             lulet(cdata, read_xml_cdata(ctx));
-                            content.push_back(Variant(Name(cdata)));
+                            luexp(handler.on_text(cdata));
                         }
                         else
                         {
-                            lulet(child, read_xml_element(ctx));
-                            content.push_back(move(child));
+                            luexp(read_xml_element(ctx, handler));
                         }
                     }
                     else
@@ -628,7 +628,7 @@ namespace Luna
                         }
                         if(!is_blank)
                         {
-                            content.push_back(Variant(Name(chardata)));
+                            luexp(handler.on_text(chardata));
                         }
                     }
                     ch = ctx.next_char();
@@ -654,35 +654,77 @@ namespace Luna
             ctx.consume(ch);
             return ok;
         }
-        static R<Variant> read_xml_element(IReadContext& ctx)
+        template <typename _Handler>
+        static RV read_xml_element(IReadContext& ctx, _Handler& handler)
         {
-            Variant ret;
             lutry
             {
                 Name element_name;
                 bool empty_tag;
-                luexp(read_xml_start_tag(ctx, ret, element_name, empty_tag));
+                luexp(read_xml_start_tag(ctx, handler, element_name, empty_tag));
                 if(!empty_tag)
                 {
-                    luexp(read_xml_content(ctx, ret));
+                    luexp(read_xml_content(ctx, handler));
                     luexp(read_xml_end_tag(ctx, element_name));
                 }
+                luexp(handler.on_end_element());
             }
             lucatchret;
-            return ret;
+            return ok;
         }
-        static R<Variant> read_xml_document(IReadContext& ctx)
+        template <typename _Handler>
+        static RV read_xml_document(IReadContext& ctx, _Handler& handler)
         {
             lutry
             {
                 luexp(skip_xml_header(ctx));
             }
             lucatchret;
-            return read_xml_element(ctx);
+            return read_xml_element(ctx, handler);
         }
-        LUNA_VARIANT_UTILS_API R<Variant> read_xml(const void* src, usize src_size)
+        // Builds one variant from parsing events.
+        struct XMLVariantBuilder
+        {
+            Vector<Variant> m_stack;
+            Variant m_result;
+
+            RV on_begin_element(const Name& name)
+            {
+                m_stack.push_back(new_xml_element(name));
+                return ok;
+            }
+            RV on_attribute(const Name& name, const String& value)
+            {
+                get_xml_attributes(m_stack.back())[name] = Name(value);
+                return ok;
+            }
+            RV on_text(const String& text)
+            {
+                get_xml_content(m_stack.back()).push_back(Variant(Name(text)));
+                return ok;
+            }
+            RV on_end_element()
+            {
+                Variant element = move(m_stack.back());
+                m_stack.pop_back();
+                if (m_stack.empty()) m_result = move(element);
+                else get_xml_content(m_stack.back()).push_back(move(element));
+                return ok;
+            }
+        };
+        // Forwards parsing events to one user handler.
+        struct XMLEventForwarder
+        {
+            XMLReadHandler& m_handler;
+
+            RV on_begin_element(const Name& name) { return m_handler.on_begin_element(name); }
+            RV on_attribute(const Name& name, const String& value) { return m_handler.on_attribute(name, value); }
+            RV on_text(const String& text) { return m_handler.on_text(text); }
+            RV on_end_element() { return m_handler.on_end_element(); }
+        };
+        template <typename _Handler>
+        static RV read_xml_buffer(const void* src, usize src_size, _Handler& handler)
         {
-            lucheck(src);
             BufferReadContext ctx;
             ctx.src = src;
             ctx.cur = src;
@@ -691,82 +733,88 @@ namespace Luna
             ctx.pos = 1;
             ctx.encoding = Encoding::utf_8;
             ctx.skip_utf16_bom();
-            return read_xml_document(ctx);
+            return read_xml_document(ctx, handler);
         }
-        LUNA_VARIANT_UTILS_API R<Variant> read_xml(IStream* stream)
+        template <typename _Handler>
+        static RV read_xml_stream(IStream* stream, _Handler& handler)
         {
-            lucheck(stream);
-            StreamReadContext ctx;
-            ctx.stream = stream;
+            StreamReadContext ctx(stream);
             ctx.line = 1;
             ctx.pos = 1;
             ctx.skip_utf16_bom();
-            return read_xml_document(ctx);
+            return read_xml_document(ctx, handler);
+        }
+        LUNA_VARIANT_UTILS_API R<Variant> read_xml(const void* src, usize src_size)
+        {
+            lucheck(src);
+            XMLVariantBuilder builder;
+            lutry
+            {
+                luexp(read_xml_buffer(src, src_size, builder));
+            }
+            lucatchret;
+            return move(builder.m_result);
         }
-        inline void write_indents(String& s, u32 num_indents)
+        LUNA_VARIANT_UTILS_API R<Variant> read_xml(IStream* stream)
         {
-            for (u32 i = 0; i < num_indents; ++i)
+            lucheck(stream);
+            XMLVariantBuilder builder;
+            lutry
             {
-                s.push_back('\t');
+                luexp(read_xml_stream(stream, builder));
             }
+            lucatchret;
+            return move(builder.m_result);
+        }
+        LUNA_VARIANT_UTILS_API RV read_xml_events(XMLReadHandler& handler, const void* src, usize src_size)
+        {
+            lucheck(src);
+            XMLEventForwarder forwarder{ handler };
+            return read_xml_buffer(src, src_size, forwarder);
         }
-        void write_xml_string(String& dst, const Name& str)
+        LUNA_VARIANT_UTILS_API RV read_xml_events(XMLReadHandler& handler, IStream* stream)
         {
-            const c8* cur = str.c_str();
-            const c8* end = str.c_str() + str.size();
-            while (cur < end)
+            lucheck(stream);
+            XMLEventForwarder forwarder{ handler };
+            return read_xml_stream(stream, forwarder);
+        }
+        struct XMLEscapeTable
+        {
+            const c8* table[256] = {};
+            constexpr XMLEscapeTable()
             {
-                c32 ch = utf8_decode_char(cur);
-                switch (ch)
-                {
-                case '<':
-                    dst.append("&lt;");
-                    break;
-                case '>':
-                    dst.append("&gt;");
-                    break;
-                case '&':
-                    dst.append("&amp;");
-                    break;
-                case '"':
-                    dst.append("&quot;");
-                    break;
-                case '\'':
-                    dst.append("&apos;");
-                    break;
-                case '\n':
-                    dst.append("&#10;");
-                    break;
-                case '\r':
-                    dst.append("&#13;");
-                    break;
-                case '\t':
-                    dst.append("&#9;");
-                    break;
-                default:
-                    dst.append(cur, utf8_charspan(ch));
-                    break;
-                }
-                cur += utf8_charspan(ch);
+                table['<'] = "&lt;";
+                table['>'] = "&gt;";
+                table['&'] = "&amp;";
+                table['"'] = "&quot;";
+                table['\''] = "&apos;";
+                table['\n'] = "&#10;";
+                table['\r'] = "&#13;";
+                table['\t'] = "&#9;";
             }
+        };
+        static constexpr XMLEscapeTable g_xml_escape_table;
+
+        inline void write_xml_string(TextWriter& dst, const Name& str)
+        {
+            dst.write_escaped(str.c_str(), str.size(), g_xml_escape_table.table);
         }
-        void write_xml_element(const Variant& v, String& s, bool indent, u32 base_indent)
+        void write_xml_element(const Variant& v, TextWriter& s, bool indent, u32 base_indent)
         {
             auto name = get_xml_name(v);
             // start tag.
-            s.push_back('<');
-            s.append(name.c_str());
+            s.put('<');
+            s.write(name.c_str(), name.size());
             auto& attributes = get_xml_attributes(v);
             for(auto& attr : attributes.key_values())
             {
-                s.push_back(' ');
-                s.append(attr.first.c_str());
-                s.push_back('=');
-                s.push_back('"');
+                s.put(' ');
+                s.write(attr.first.c_str(), attr.first.size());
+                s.write("=\"", 2);
                 write_xml_string(s, attr.second.str());
-                s.push_back('"');
+                s.put('"');
             }
-            s.push_back('>');
+            s.put('>');
             auto& content = get_xml_content(v);
             if(!content.empty())
             {
@@ -774,13 +822,13 @@ namespace Luna
                 if(indent && !single_chardata_content)
                 {
                     ++base_indent;
-                    s.push_back('\n');
+                    s.put('\n');
                 }
                 for(auto& child : content.values())
                 {
                     if (indent && !single_chardata_content)
                     {
-                        write_indents(s, base_indent);
+                        s.write_indents('\t', base_indent);
                     }
                     if(child.type() == VariantType::object)
                     {
@@ -788,36 +836,45 @@ namespace Luna
                     }
                     else if(child.type() == VariantType::string)
                     {
-                        write_xml_string(s, child.c_str());
+                        write_xml_string(s, child.str());
                     }
                     if (indent && !single_chardata_content)
                     {
-                        s.push_back('\n');
+                        s.put('\n');
                     }
                 }
                 if (indent && !single_chardata_content)
                 {
                     --base_indent;
-                    write_indents(s, base_indent);
+                    s.write_indents('\t', base_indent);
                 }
             }
             // end tag.
-            s.push_back('<');
-            s.push_back('/');
-            s.append(name.c_str());
-            s.push_back('>');
+            s.write("</", 2);
+            s.write(name.c_str(), name.size());
+            s.put('>');
+        }
+        static void write_xml_document(const Variant& v, TextWriter& s, bool indent)
+        {
+            s.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
+            if(indent) s.put('\n');
+            write_xml_element(v, s, indent, 0);
         }
         LUNA_VARIANT_UTILS_API String write_xml(const Variant& v, bool indent)
         {
-            String r("<?xml version=\"1.0\" encoding=\"UTF-8\"?>");
-            if(indent) r.push_back('\n');
-            write_xml_element(v, r, indent, 0);
+            String r;
+            TextWriter writer(r);
+            write_xml_document(v, writer, indent);
+            // Writing to one string never fails.
+            auto _ = writer.finish();
             return r;
         }
         LUNA_VARIANT_UTILS_API RV write_xml(IStream* stream, const Variant& v, bool indent)
         {
-            String data = write_xml(v, indent);
-            return stream->write(data.data(), data.size());
+            lucheck(stream);
+            TextWriter writer(stream);
+            write_xml_document(v, writer, indent);
+            return writer.finish();
         }
     }
 }
\ No newline at end of file
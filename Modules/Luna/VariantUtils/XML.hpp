@@ -76,6 +76,36 @@ namespace Luna
         //! from the stream.
         //! @return Returns one variant that contains the data read from the XML string.
         LUNA_VARIANT_UTILS_API R<Variant> read_xml(IStream* stream);
+        //! The handler that receives events when one XML string is parsed by @ref read_xml_events.
+        //! @details Events are emitted in document order. If any method of the handler fails, parsing stops and the error is
+        //! returned from @ref read_xml_events.
+        struct XMLReadHandler
+        {
+            //! Called when the start tag of one element is read.
+            //! Attributes of the element are reported by @ref on_attribute after this, followed by content of the element, then
+            //! @ref on_end_element is called.
+            //! @param[in] name The name of the element.
+            virtual RV on_begin_element(const Name& name) = 0;
+            //! Called for every attribute of the current element.
+            //! @param[in] name The name of the attribute.
+            //! @param[in] value The value of the attribute, with references resolved.
+            virtual RV on_attribute(const Name& name, const String& value) = 0;
+            //! Called for every character data and CDATA section in the content of the current element.
+            //! Character data that only contains indention whitespaces is not reported.
+            //! @param[in] text The text, with references resolved.
+            virtual RV on_text(const String& text) = 0;
+            //! Called when the current element ends.
+            virtual RV on_end_element() = 0;
+        };
+        //! Parses one XML string and reports its content to one handler without building variants for elements.
+        //! @param[in] handler The handler to receive parsing events.
+        //! @param[in] src The XML string to read.
+        //! @param[in] src_size The maximum number of characters to read in `src`. See @ref read_xml for details.
+        LUNA_VARIANT_UTILS_API RV read_xml_events(XMLReadHandler& handler, const void* src, usize src_size = USIZE_MAX);
+        //! Parses one XML string and reports its content to one handler without building variants for elements.
+        //! @param[in] handler The handler to receive parsing events.
+        //! @param[in] stream The stream that contains the XML string to read.
+        LUNA_VARIANT_UTILS_API RV read_xml_events(XMLReadHandler& handler, IStream* stream);
         //! Writes one variant object to XML string.
         //! @param[in] v The variant object that represents the root XML element to write.
         //! @param[in] indent Whether to add indents and line breaks to the generated XML string, so that improves readability but
@@ -87,6 +117,8 @@ namespace Luna
         //! @param[in] v The variant object that represents the root XML element to write.
         //! @param[in] indent Whether to add indents and line breaks to the generated XML string, so that improves readability but
         //! also increases the string size.
+        //! @remark The XML string is written to the stream in small chunks while being generated, so the whole string is never stored
+        //! in memory. If writing to the stream fails, generation stops writing and the first error is returned.
         LUNA_VARIANT_UTILS_API RV write_xml(IStream* stream, const Variant& v, bool indent = true);
     
         //! @}
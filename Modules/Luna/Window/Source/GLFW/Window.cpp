@@ -16,6 +16,7 @@
 #include "Monitor.hpp"
 #include "../../Application.hpp"
 #include "../Window.hpp"
+#include <Luna/HID/InputEvent.hpp>
 namespace Luna
 {
     namespace Window
@@ -29,6 +30,28 @@ namespace Luna
                 glfwDestroyWindow(ptr);
             }
         }
+        RV Window::set_raw_mouse_motion(bool enabled)
+        {
+            if (enabled == m_raw_mouse_motion) return ok;
+            if (enabled)
+            {
+                glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+                if (glfwRawMouseMotionSupported()) glfwSetInputMode(m_window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+                glfwGetCursorPos(m_window, &m_last_cursor_x, &m_last_cursor_y);
+            }
+            else
+            {
+                if (glfwRawMouseMotionSupported()) glfwSetInputMode(m_window, GLFW_RAW_MOUSE_MOTION, GLFW_FALSE);
+                glfwSetInputMode(m_window, GLFW_CURSOR, GLFW_CURSOR_NORMAL);
+            }
+            lutry
+            {
+                luexp(check_glfw_error());
+            }
+            lucatchret;
+            m_raw_mouse_motion = enabled;
+            return ok;
+        }
         Int2U Window::get_position()
         {
             int x, y;
@@ -256,11 +279,25 @@ namespace Luna
             Window* pw = (Window*)glfwGetWindowUserPointer(window);
             pw->m_events.move(static_cast<IWindow*>(pw), xpos, ypos);
         }
+        static void submit_input_event(Window* pw, HID::InputEvent& e)
+        {
+            e.timestamp = 0;
+            e.source = static_cast<IWindow*>(pw);
+            e.index = 0;
+            HID::submit_input_event(e);
+        }
         static void glfw_on_key(GLFWwindow* window, int key, int scancode, int action, int mods)
         {
             Window* pw = (Window*)glfwGetWindowUserPointer(window);
             auto hid_key = glfw_translate_key(key);
             if (hid_key == HID::KeyCode::unknown) return;
+            if (HID::is_input_event_buffer_enabled() && (action == GLFW_PRESS || action == GLFW_RELEASE))
+            {
+                HID::InputEvent e;
+                e.type = action == GLFW_PRESS ? HID::InputEventType::key_down : HID::InputEventType::key_up;
+                e.key = hid_key;
+                submit_input_event(pw, e);
+            }
             if (action == GLFW_PRESS) pw->m_events.key_down(static_cast<IWindow*>(pw), hid_key);
             else if (action == GLFW_RELEASE) pw->m_events.key_up(static_cast<IWindow*>(pw), hid_key);
         }
@@ -268,6 +305,13 @@ namespace Luna
         {
             Window* pw = (Window*)glfwGetWindowUserPointer(window);
             c32 character = codepoint;
+            if (HID::is_input_event_buffer_enabled())
+            {
+                HID::InputEvent e;
+                e.type = HID::InputEventType::character;
+                e.character = character;
+                submit_input_event(pw, e);
+            }
             pw->m_events.input_character(static_cast<IWindow*>(pw), character);
         }
         static void glfw_on_mouse_move(GLFWwindow* window, double xpos, double ypos)
@@ -275,6 +319,26 @@ namespace Luna
             Window* pw = (Window*)glfwGetWindowUserPointer(window);
             i32 x = (i32)xpos;
             i32 y = (i32)ypos;
+            if (HID::is_input_event_buffer_enabled())
+            {
+                HID::InputEvent e;
+                if (pw->m_raw_mouse_motion)
+                {
+                    // One event per callback, so that no motion is coalesced by the application.
+                    e.type = HID::InputEventType::mouse_delta;
+                    e.delta.x = (f32)(xpos - pw->m_last_cursor_x);
+                    e.delta.y = (f32)(ypos - pw->m_last_cursor_y);
+                }
+                else
+                {
+                    e.type = HID::InputEventType::mouse_move;
+                    e.position.x = x;
+                    e.position.y = y;
+                }
+                submit_input_event(pw, e);
+            }
+            pw->m_last_cursor_x = xpos;
+            pw->m_last_cursor_y = ypos;
             pw->m_events.mouse_move(static_cast<IWindow*>(pw), x, y);
         }
         static void glfw_on_mouse_button(GLFWwindow* window, int button, int action, int mods)
@@ -288,6 +352,13 @@ namespace Luna
             else if (button == GLFW_MOUSE_BUTTON_5) btn = HID::MouseButton::function2;
             else return;
             auto modifier_flags = glfw_translate_mods(mods);
+            if (HID::is_input_event_buffer_enabled() && (action == GLFW_PRESS || action == GLFW_RELEASE))
+            {
+                HID::InputEvent e;
+                e.type = action == GLFW_PRESS ? HID::InputEventType::mouse_down : HID::InputEventType::mouse_up;
+                e.mouse_button = btn;
+                submit_input_event(pw, e);
+            }
             if (action == GLFW_PRESS) pw->m_events.mouse_down(static_cast<IWindow*>(pw), modifier_flags, btn);
             else if (action == GLFW_RELEASE) pw->m_events.mouse_up(static_cast<IWindow*>(pw), modifier_flags, btn);
         }
@@ -296,6 +367,14 @@ namespace Luna
             Window* pw = (Window*)glfwGetWindowUserPointer(window);
             f32 x_wheel_delta = (f32)xoffset;
             f32 y_wheel_delta = (f32)yoffset;
+            if (HID::is_input_event_buffer_enabled())
+            {
+                HID::InputEvent e;
+                e.type = HID::InputEventType::mouse_wheel;
+                e.delta.x = x_wheel_delta;
+                e.delta.y = y_wheel_delta;
+                submit_input_event(pw, e);
+            }
             pw->m_events.mouse_wheel(static_cast<IWindow*>(pw), x_wheel_delta, y_wheel_delta);
         }
         static void glfw_on_drop_file(GLFWwindow* window, int count, const char** paths)
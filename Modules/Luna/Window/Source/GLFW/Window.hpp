@@ -98,6 +98,11 @@ namespace Luna
             i32 m_windowed_pos_x;
             i32 m_windowed_pos_y;
 
+            // The last cursor position, used to compute mouse deltas in raw mouse motion mode.
+            f64 m_last_cursor_x;
+            f64 m_last_cursor_y;
+            bool m_raw_mouse_motion;
+
             virtual void close() override;
             virtual bool is_closed() override { return m_window == nullptr; }
             virtual bool is_focused() override { return glfwGetWindowAttrib(m_window, GLFW_FOCUSED) != 0; }
@@ -114,6 +119,8 @@ namespace Luna
             virtual RV set_resizable(bool resizable) override { glfwSetWindowAttrib(m_window, GLFW_RESIZABLE, resizable ? GLFW_TRUE : GLFW_FALSE); return check_glfw_error(); }
             virtual bool is_frameless() override { return glfwGetWindowAttrib(m_window, GLFW_DECORATED) == 0; }
             virtual RV set_frameless(bool frameless) override { glfwSetWindowAttrib(m_window, GLFW_DECORATED, frameless ? GLFW_FALSE : GLFW_TRUE); return check_glfw_error(); }
+            virtual bool is_raw_mouse_motion() override { return m_raw_mouse_motion; }
+            virtual RV set_raw_mouse_motion(bool enabled) override;
             virtual Int2U get_position() override;
             virtual RV set_position(i32 x, i32 y) override;
             virtual UInt2U get_size() override;
@@ -163,7 +170,10 @@ namespace Luna
             virtual Event<window_touch_event_handler_t>& get_touch_event()  override { return m_events.touch; }
             virtual Event<window_drop_file_event_handler_t>& get_drop_file_event()  override { return m_events.drop_file; }
             Window() :
-                m_window(nullptr) {}
+                m_window(nullptr),
+                m_last_cursor_x(0),
+                m_last_cursor_y(0),
+                m_raw_mouse_motion(false) {}
             ~Window()
             {
                 close();
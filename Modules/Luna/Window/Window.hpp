@@ -258,6 +258,17 @@ namespace Luna
             //! Sets the frameless state of the window.
             virtual RV set_frameless(bool frameless) = 0;
 
+            //! Checks whether raw mouse motion is enabled for the window.
+            virtual bool is_raw_mouse_motion() = 0;
+
+            //! Enables or disables raw mouse motion for the window.
+            //! @details When raw mouse motion is enabled, the cursor is hidden and locked to the window, and every mouse motion message 
+            //! is reported as one @ref HID::InputEventType::mouse_delta event to the input event buffer of the HID module, without being
+            //! coalesced or affected by cursor acceleration if the platform supports unaccelerated motion. This is usually used by 
+            //! camera controls of games. Mouse move events of the window are still triggered.
+            //! @param[in] enabled Whether to enable raw mouse motion.
+            virtual RV set_raw_mouse_motion(bool enabled) = 0;
+
             //! Gets the position of the window client area.
             virtual Int2U get_position() = 0;
 
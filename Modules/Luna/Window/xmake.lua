@@ -27,5 +27,5 @@ luna_sdk_module_target("Window")
         add_headerfiles("(Vulkan/*.hpp)", {prefixdir = "Luna/Window"})
         add_files("Source/Vulkan/*.cpp")
     end
-    add_deps("Runtime")
+    add_deps("Runtime", "HID")
 target_end()
@@ -12,6 +12,7 @@ includes("JobSystem")
 includes("Asset")
 includes("Image")
 includes("ObjLoader")
+includes("GLTFLoader")
 includes("RG")
 includes("AHI")
 
@@ -0,0 +1,121 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file main.cpp
+* @author JXMaster
+* @date 2024/3/23
+*/
+#include <Luna/Runtime/Runtime.hpp>
+#include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/StdIO.hpp>
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/VFS/VFS.hpp>
+#include <Luna/VFS/Pack.hpp>
+#include <stdlib.h>
+using namespace Luna;
+
+RV print_help()
+{
+    const c8 help_text[] = R"(LunaPack v0.0.1
+Pack file creator for LunaSDK.
+This program packs all files in one directory to one pack file that can be mounted by the VFS pack driver.
+Usage: LunaPack <source_dir> <pack_file> [options]
+Options:
+    -a <alignment>  Sets the alignment of file data in the pack. Use 16 if not specified.
+    -n              Stores all files without compression.
+    -h, --help      Print help message.
+)";
+    auto io = get_std_io_stream();
+    return io->write(help_text, sizeof(help_text));
+}
+
+Path get_absolute_path(const c8* path)
+{
+    Path ret = path;
+    if (!test_flags(ret.flags(), PathFlag::absolute))
+    {
+        u32 current_dir_len = get_current_dir(0, nullptr);
+        Vector<c8> current_dir_str(current_dir_len, 0);
+        get_current_dir(current_dir_len, current_dir_str.data());
+        Path tmp = current_dir_str.data();
+        tmp.append(ret);
+        ret = tmp;
+    }
+    return ret;
+}
+
+RV run(int argc, const char* argv[])
+{
+    lutry
+    {
+        set_log_to_platform_enabled(true);
+        set_log_to_platform_verbosity(LogVerbosity::info);
+        luexp(add_module(module_vfs()));
+        luexp(init_modules());
+        if (argc >= 2 && (Name(argv[1]) == "-h" || Name(argv[1]) == "--help"))
+        {
+            luexp(print_help());
+            return ok;
+        }
+        if (argc < 3)
+        {
+            const c8 usage[] = "Usage: LunaPack <source_dir> <pack_file> [options]\nType \"LunaPack --help\" for details.";
+            luexp(get_std_io_stream()->write(usage, sizeof(usage)));
+            return ok;
+        }
+        VFS::PackDesc desc;
+        int argi = 3;
+        while (argi < argc)
+        {
+            if (Name(argv[argi]) == "-a")
+            {
+                ++argi;
+                if (argi >= argc) return set_error(BasicError::bad_arguments(), "Alignment expected for -a");
+                desc.alignment = (u32)strtoul(argv[argi], nullptr, 10);
+                ++argi;
+            }
+            else if (Name(argv[argi]) == "-n")
+            {
+                desc.compression = VFS::PackCompression::none;
+                ++argi;
+            }
+            else
+            {
+                return set_error(BasicError::bad_arguments(), "Unknown parameter: %s", argv[argi]);
+            }
+        }
+        Path source_dir = get_absolute_path(argv[1]);
+        Path pack_path = get_absolute_path(argv[2]);
+        if (pack_path.empty()) return set_error(BasicError::bad_arguments(), "Invalid pack file path: %s", argv[2]);
+        Path pack_dir = pack_path;
+        pack_dir.pop_back();
+        // Mounts the source directory and the output directory so that the pack can be created using VFS paths.
+        luexp(VFS::mount(VFS::get_platform_filesystem_driver(), source_dir.encode(PathSeparator::system_preferred).c_str(), "/source"));
+        luexp(VFS::mount(VFS::get_platform_filesystem_driver(), pack_dir.encode(PathSeparator::system_preferred).c_str(), "/output"));
+        Path output_path = "/output";
+        output_path.push_back(pack_path.back());
+        log_info("LunaPack", "Packing %s to %s", source_dir.encode().c_str(), pack_path.encode().c_str());
+        luexp(VFS::create_pack("/source", output_path, desc));
+    }
+    lucatchret;
+    return ok;
+}
+
+int main(int argc, const char* argv[])
+{
+    bool inited = Luna::init();
+    if (!inited) return -1;
+    auto r = run(argc, argv);
+    if (failed(r))
+    {
+        log_error("LunaPack", "%s", explain(r.errcode()));
+        Luna::close();
+        return -1;
+    }
+    Luna::close();
+    return 0;
+}
@@ -0,0 +1,5 @@
+target("LunaPack")
+    set_luna_sdk_program()
+    add_files("**.cpp")
+    add_deps("Runtime", "VFS")
+target_end()
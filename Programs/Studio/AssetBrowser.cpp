@@ -733,23 +733,9 @@ namespace Luna
         ImGui::EndChild();
         ImGui::PopStyleVar();
     }
-    struct AssetLoadTask
-    {
-        Asset::asset_t asset;
-    };
-    void async_load_asset_func(void* params)
-    {
-        AssetLoadTask* task = (AssetLoadTask*)params;
-        auto r = Asset::load_asset(task->asset);
-        if(failed(r))
-        {
-            log_error("Studio", "Failed to load asset %s: %s", Asset::get_asset_path(task->asset).encode().c_str(), explain(r.errcode()));
-        }
-    }
     void async_load_asset(Asset::asset_t asset)
     {
-        AssetLoadTask* task = (AssetLoadTask*)JobSystem::new_job(async_load_asset_func, sizeof(AssetLoadTask), alignof(AssetLoadTask));
-        task->asset = asset;
-        JobSystem::submit_job(task);
+        // Requests for the same asset are merged by the asset system, so this can be called every frame.
+        Asset::load_asset_async(asset);
     }
 }
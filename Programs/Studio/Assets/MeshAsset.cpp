@@ -10,10 +10,13 @@
 #include "Mesh.hpp"
 #include <Luna/VFS/VFS.hpp>
 #include "../Mesh.hpp"
+#include "MeshOptimizer.hpp"
 #include <Luna/VariantUtils/JSON.hpp>
 #include <Luna/Runtime/Serialization.hpp>
+#include <Luna/Runtime/StaticSerialization.hpp>
 #include "../StudioHeader.hpp"
 #include <Luna/RHI/Utility.hpp>
+#include <Luna/Asset/DerivedDataCache.hpp>
 namespace Luna
 {
     Name get_static_mesh_asset_type()
@@ -21,30 +24,110 @@ namespace Luna
         return "Static Mesh";
     }
 
-    static RV reset_mesh(Mesh& mesh, const MeshAsset& mesh_asset)
+    static RV reset_mesh(Mesh& mesh, Span<const MeshPiece> pieces, Span<const byte_t> vertex_data, Span<const byte_t> index_data)
     {
         lutry
         {
             auto device = RHI::get_main_device();
+            u32 vb_count = (u32)vertex_data.size() / (u32)sizeof(Vertex);
+            const Vertex* vertices = (const Vertex*)vertex_data.data();
+            // Vertices are stored in full precision in assets, and are quantized only when uploaded to GPU.
+            Vector<QuantizedVertex> quantized_vertices(vb_count);
+            quantize_vertices({ vertices, vb_count }, { quantized_vertices.data(), quantized_vertices.size() });
             // Upload resource.
             lulet(vert_res, device->new_buffer(RHI::MemoryType::local, RHI::BufferDesc(
-                RHI::BufferUsageFlag::vertex_buffer | RHI::BufferUsageFlag::copy_dest, mesh_asset.vertex_data.size())));
+                RHI::BufferUsageFlag::vertex_buffer | RHI::BufferUsageFlag::copy_dest, quantized_vertices.size() * sizeof(QuantizedVertex))));
             lulet(index_res, device->new_buffer(RHI::MemoryType::local, RHI::BufferDesc(
-                RHI::BufferUsageFlag::index_buffer | RHI::BufferUsageFlag::copy_dest, mesh_asset.index_data.size())));
-            lulet(upload_cmdbuf, device->new_command_buffer(g_env->async_copy_queue));
-            luexp(RHI::copy_resource_data(upload_cmdbuf, {
-                RHI::CopyResourceData::write_buffer(vert_res, 0, mesh_asset.vertex_data.data(), mesh_asset.vertex_data.size()),
-                RHI::CopyResourceData::write_buffer(index_res, 0, mesh_asset.index_data.data(), mesh_asset.index_data.size())}));
-            mesh.pieces = mesh_asset.pieces;
+                RHI::BufferUsageFlag::index_buffer | RHI::BufferUsageFlag::copy_dest, index_data.size())));
+            // Extracts vertex positions to one separate vertex stream for depth-only passes.
+            Vector<Float3U> positions(vb_count);
+            for (u32 i = 0; i < vb_count; ++i) positions[i] = vertices[i].position;
+            lulet(position_res, device->new_buffer(RHI::MemoryType::local, RHI::BufferDesc(
+                RHI::BufferUsageFlag::vertex_buffer | RHI::BufferUsageFlag::copy_dest, positions.size() * sizeof(Float3U))));
+            lulet(upload_job, g_env->upload_manager->enqueue({
+                RHI::CopyResourceData::write_buffer(vert_res, 0, quantized_vertices.data(), quantized_vertices.size() * sizeof(QuantizedVertex)),
+                RHI::CopyResourceData::write_buffer(index_res, 0, index_data.data(), index_data.size()),
+                RHI::CopyResourceData::write_buffer(position_res, 0, positions.data(), positions.size() * sizeof(Float3U))}));
+            luexp(g_env->upload_manager->submit());
+            JobSystem::wait_job(upload_job);
+            mesh.pieces.assign(pieces);
             mesh.vb = vert_res;
             mesh.ib = index_res;
-            mesh.vb_count = (u32)mesh_asset.vertex_data.size() / (u32)sizeof(Vertex);
-            mesh.ib_count = (u32)mesh_asset.index_data.size() / (u32)sizeof(u32);
+            mesh.position_vb = position_res;
+            mesh.vb_count = vb_count;
+            mesh.ib_count = (u32)index_data.size() / (u32)sizeof(u32);
+            // Computes the bounding box from vertex positions, which is used by occlusion culling.
+            if (mesh.vb_count)
+            {
+                Float3 bb_min = vertices[0].position;
+                Float3 bb_max = vertices[0].position;
+                for (u32 i = 1; i < mesh.vb_count; ++i)
+                {
+                    Float3 pos = vertices[i].position;
+                    bb_min = min(bb_min, pos);
+                    bb_max = max(bb_max, pos);
+                }
+                mesh.bounding_box_min = bb_min;
+                mesh.bounding_box_max = bb_max;
+            }
         }
         lucatchret;
         return ok;
     }
 
+    // The cooked mesh data stored in the derived data cache, so that loading one mesh does not need to parse JSON.
+    // The header is followed by pieces, vertex data and index data.
+    struct CookedMeshHeader
+    {
+        u32 num_pieces;
+        u32 reserved;
+        u64 vertex_data_size;
+        u64 index_data_size;
+    };
+    constexpr const c8* MESH_COOKER = "StaticMesh";
+    constexpr u32 MESH_COOKER_VERSION = 1;
+
+    static RV cook_mesh(const Name& key, const MeshAsset& mesh_asset)
+    {
+        CookedMeshHeader header;
+        header.num_pieces = (u32)mesh_asset.pieces.size();
+        header.reserved = 0;
+        header.vertex_data_size = mesh_asset.vertex_data.size();
+        header.index_data_size = mesh_asset.index_data.size();
+        usize pieces_size = sizeof(MeshPiece) * mesh_asset.pieces.size();
+        Vector<byte_t> data;
+        data.reserve(sizeof(CookedMeshHeader) + pieces_size + mesh_asset.vertex_data.size() + mesh_asset.index_data.size());
+        StaticBinaryWriter writer(data);
+        writer.write_value(header);
+        writer.write(mesh_asset.pieces.data(), pieces_size);
+        writer.write(mesh_asset.vertex_data.data(), mesh_asset.vertex_data.size());
+        writer.write(mesh_asset.index_data.data(), mesh_asset.index_data.size());
+        return Asset::put_derived_data(key, data.cspan());
+    }
+
+    static R<bool> load_cooked_mesh(Mesh& mesh, const Name& key)
+    {
+        auto cooked = Asset::get_derived_data(key);
+        if (failed(cooked)) return false;
+        const byte_t* data = cooked.get()->get_data();
+        usize size = cooked.get()->get_size();
+        if (size < sizeof(CookedMeshHeader)) return false;
+        CookedMeshHeader header;
+        memcpy(&header, data, sizeof(CookedMeshHeader));
+        usize pieces_size = sizeof(MeshPiece) * header.num_pieces;
+        if (size != sizeof(CookedMeshHeader) + pieces_size + header.vertex_data_size + header.index_data_size) return false;
+        const byte_t* pieces = data + sizeof(CookedMeshHeader);
+        const byte_t* vertex_data = pieces + pieces_size;
+        const byte_t* index_data = vertex_data + header.vertex_data_size;
+        lutry
+        {
+            luexp(reset_mesh(mesh, { (const MeshPiece*)pieces, header.num_pieces },
+                { vertex_data, (usize)header.vertex_data_size }, { index_data, (usize)header.index_data_size }));
+        }
+        lucatchret;
+        return true;
+    }
+
     static R<ObjRef> load_static_mesh_asset(object_t userdata, Asset::asset_t asset, const Path& path)
     {
         ObjRef ret;
@@ -54,11 +137,18 @@ namespace Luna
             file_path.append_extension("mesh");
             lulet(file, VFS::open_file(file_path, FileOpenFlag::read | FileOpenFlag::user_buffering, FileCreationMode::open_existing));
             lulet(data, load_file_data(file));
-            lulet(file_data, VariantUtils::read_json((const c8*)data.data(), data.size()));
-            MeshAsset mesh_asset;
-            luexp(deserialize(mesh_asset, file_data));
             Ref<Mesh> mesh = new_object<Mesh>();
-            luexp(reset_mesh(*mesh.get(), mesh_asset));
+            Name key = Asset::get_derived_data_key(MESH_COOKER, MESH_COOKER_VERSION, data.cspan());
+            lulet(cooked, load_cooked_mesh(*mesh.get(), key));
+            if (!cooked)
+            {
+                lulet(file_data, VariantUtils::read_json((const c8*)data.data(), data.size()));
+                MeshAsset mesh_asset;
+                luexp(deserialize(mesh_asset, file_data));
+                luexp(reset_mesh(*mesh.get(), mesh_asset.pieces.cspan(), mesh_asset.vertex_data.cspan(), mesh_asset.index_data.cspan()));
+                // Failing to store cooked data only makes the next loading slower.
+                auto _ = cook_mesh(key, mesh_asset);
+            }
             ret = mesh;
         }
         lucatchret;
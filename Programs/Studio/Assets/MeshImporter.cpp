@@ -8,6 +8,10 @@
 * @date 2022/12/17
 */
 #include "Mesh.hpp"
+#include "MeshOptimizer.hpp"
+#include "Material.hpp"
+#include "Model.hpp"
+#include <Luna/JobSystem/Parallel.hpp>
 #include <Luna/ObjLoader/ObjLoader.hpp>
 #include <Luna/Window/FileDialog.hpp>
 #include <Luna/Window/MessageBox.hpp>
@@ -28,6 +32,11 @@ namespace Luna
 
         ObjLoader::ObjMesh m_obj_file;
 
+        //! Whether the source file is one glTF binary file.
+        bool m_is_gltf = false;
+
+        GLTFLoader::GLTFFile m_gltf_file;
+
         Vector<String> m_import_names;
 
         MeshImporter() {}
@@ -41,94 +50,22 @@ namespace Luna
         }
     };
 
-    template <>
-    struct hash<ObjLoader::Index>
+    // Computes tangents of vertices from texture coordinates of triangles in all pieces.
+    static void compute_tangents(Vector<Vertex>& vertices, const Vector<Vector<u32>>& pieces)
     {
-        usize operator()(const ObjLoader::Index& v) const
-        {
-            return hash<i32>()(v.vertex_index) ^ hash<i32>()(v.normal_index) ^ hash<i32>()(v.texcoord_index);
-        }
-    };
-
-    static RV create_mesh_asset_from_obj(MeshAsset& mesh, const ObjLoader::ObjMesh& obj_file, u32 shape_index)
-    {
-        auto& m = obj_file.shapes[shape_index].mesh;    // We only consider the mesh part of the specified shape.
-        auto& faces = m.num_face_vertices;    // 
-        auto& attrib = obj_file.attributes;
-
-        // Collect vertex used in this shape.
-        Vector<Vertex> vertices;
-        HashMap<ObjLoader::Index, usize> vertices_map;
-        for(auto& i : m.indices)
-        {
-            if(!vertices_map.contains(i))
-            {
-                Vertex v;
-                v.position = attrib.vertices[i.vertex_index];
-                auto& color3 = attrib.colors[i.vertex_index];
-                v.color = Float4U(color3.x, color3.y, color3.z, 1.0f);
-                if (i.normal_index != -1 && i.normal_index < attrib.normals.size())
-                {
-                    v.normal = attrib.normals[i.normal_index];
-                }
-                else
-                {
-                    v.normal = Float3U(0.0f, 0.0f, 1.0f);
-                }
-                if (i.texcoord_index != -1 && i.texcoord_index < attrib.texcoords.size())
-                {
-                    v.texcoord = attrib.texcoords[i.texcoord_index];
-                }
-                else
-                {
-                    v.texcoord = Float2U(0.0f, 0.0f);
-                }
-                vertices.push_back(v);
-                vertices_map.insert(make_pair(i, vertices.size() - 1));
-            }
-        }
-
-        // Build index list for every material.
-        // Material ID -> Index list.
-        HashMap<u32, Vector<u32>> mat_map;
-        usize index_offset = 0;
-        for(usize face_index = 0; face_index < faces.size(); ++face_index)
-        {
-            i32 mat_id = m.material_ids[face_index];
-            auto iter = mat_map.find(mat_id);
-            if (iter == mat_map.end())
-            {
-                iter = mat_map.insert(make_pair(mat_id, Vector<u32>())).first;
-            }
-            u8 num_face_vertices = faces[face_index];
-            // If this is not a triangle face, convert this to triangle fans.
-            for (i32 j = 0; j < ((i32)num_face_vertices - 2); ++j)
-            {
-                auto index1 = m.indices[index_offset];
-                auto index2 = m.indices[index_offset + j + 1];
-                auto index3 = m.indices[index_offset + j + 2];
-                iter->second.push_back(vertices_map.find(index1)->second);
-                iter->second.push_back(vertices_map.find(index2)->second);
-                iter->second.push_back(vertices_map.find(index3)->second);
-            }
-            index_offset += num_face_vertices;
-        }
-
-        // Calculate tangents.
         Vector<Float3U> tangents;
         Vector<Float3U> binormals;
         tangents.resize(vertices.size(), Float3U(0.0f, 0.0f, 0.0f));
         binormals.resize(vertices.size(), Float3U(0.0f, 0.0f, 0.0f));
 
-        u32 idx_offset = 0;
-        for (auto& i : mat_map)
+        for (auto& i : pieces)
         {
-            usize num_tris = i.second.size() / 3;
+            usize num_tris = i.size() / 3;
             for (usize j = 0; j < num_tris; ++j)
             {
-                u32 i1 = i.second[j * 3];
-                u32 i2 = i.second[j * 3 + 1];
-                u32 i3 = i.second[j * 3 + 2];
+                u32 i1 = i[j * 3];
+                u32 i2 = i[j * 3 + 1];
+                u32 i3 = i[j * 3 + 2];
                 Vertex& p1 = vertices[i1];
                 Vertex& p2 = vertices[i2];
                 Vertex& p3 = vertices[i3];
@@ -151,8 +88,6 @@ namespace Luna
                 binormals[i2] = binormals[i2] + binormal;
                 binormals[i3] = binormals[i3] + binormal;
             }
-
-            idx_offset += (u32)i.second.size();
         }
 
         for (usize i = 0; i < vertices.size(); ++i)
@@ -171,46 +106,230 @@ namespace Luna
             }
             vertices[i].tangent = tang;
         }
+    }
 
-        // Fill vertex data.
-        auto vb_blob = Blob(vertices.size() * sizeof(Vertex));
-        memcpy(vb_blob.data(), vertices.data(), vertices.size() * sizeof(Vertex));
+    // Optimizes vertices and indices, and writes them to the mesh asset. Every index list creates one mesh piece.
+    static void build_mesh_asset(MeshAsset& mesh, Vector<Vertex>& vertices, Vector<Vector<u32>>& piece_indices)
+    {
+        // Reorder triangles of every piece for the vertex cache, then reorder triangle clusters to reduce overdraw.
+        for (auto& i : piece_indices)
+        {
+            optimize_vertex_cache({i.data(), i.size()}, (u32)vertices.size());
+            optimize_overdraw({i.data(), i.size()}, {vertices.data(), vertices.size()});
+        }
 
         // Fill indices data.
         usize idx_count = 0;
-        for (auto& i : mat_map)
+        for (auto& i : piece_indices)
         {
-            idx_count += i.second.size();
+            idx_count += i.size();
         }
 
         auto ib_blob = Blob(idx_count * sizeof(u32));
 
-        idx_offset = 0;
+        u32 idx_offset = 0;
         Vector<MeshPiece> pieces;
-        for (auto& i : mat_map)
+        for (auto& i : piece_indices)
         {
             MeshPiece p;
             p.first_index_offset = idx_offset;
-            p.num_indices = (u32)i.second.size();
-            memcpy((u32*)ib_blob.data() + idx_offset, i.second.data(), sizeof(u32) * i.second.size());
+            p.num_indices = (u32)i.size();
+            memcpy((u32*)ib_blob.data() + idx_offset, i.data(), sizeof(u32) * i.size());
             idx_offset += p.num_indices;
             pieces.push_back(p);
         }
+
+        // Reorder vertices in the order they are used by indices of all pieces, then fill vertex data.
+        optimize_vertex_fetch(vertices, {(u32*)ib_blob.data(), idx_count});
+        auto vb_blob = Blob(vertices.size() * sizeof(Vertex));
+        memcpy(vb_blob.data(), vertices.data(), vertices.size() * sizeof(Vertex));
+
         mesh.pieces = move(pieces);
         mesh.vertex_data = move(vb_blob);
         mesh.index_data = move(ib_blob);
+    }
+
+    static RV create_mesh_asset_from_obj(MeshAsset& mesh, const ObjLoader::ObjMesh& obj_file, u32 shape_index)
+    {
+        auto& m = obj_file.shapes[shape_index].mesh;    // We only consider the mesh part of the specified shape.
+        auto& faces = m.num_face_vertices;    // 
+        auto& attrib = obj_file.attributes;
+
+        // Collect vertex used in this shape. Vertices are deduplicated by the OBJ loader.
+        Vector<Vertex> vertices;
+        vertices.reserve(m.unique_vertices.size());
+        for(auto& i : m.unique_vertices)
+        {
+            Vertex v;
+            v.position = attrib.vertices[i.vertex_index];
+            auto& color3 = attrib.colors[i.vertex_index];
+            v.color = Float4U(color3.x, color3.y, color3.z, 1.0f);
+            if (i.normal_index != -1 && i.normal_index < attrib.normals.size())
+            {
+                v.normal = attrib.normals[i.normal_index];
+            }
+            else
+            {
+                v.normal = Float3U(0.0f, 0.0f, 1.0f);
+            }
+            if (i.texcoord_index != -1 && i.texcoord_index < attrib.texcoords.size())
+            {
+                v.texcoord = attrib.texcoords[i.texcoord_index];
+            }
+            else
+            {
+                v.texcoord = Float2U(0.0f, 0.0f);
+            }
+            vertices.push_back(v);
+        }
+
+        // Build index list for every material.
+        // Material ID -> Index list.
+        HashMap<u32, Vector<u32>> mat_map;
+        usize index_offset = 0;
+        for(usize face_index = 0; face_index < faces.size(); ++face_index)
+        {
+            i32 mat_id = m.material_ids[face_index];
+            auto iter = mat_map.find(mat_id);
+            if (iter == mat_map.end())
+            {
+                iter = mat_map.insert(make_pair(mat_id, Vector<u32>())).first;
+            }
+            u8 num_face_vertices = faces[face_index];
+            // If this is not a triangle face, convert this to triangle fans.
+            for (i32 j = 0; j < ((i32)num_face_vertices - 2); ++j)
+            {
+                iter->second.push_back(m.vertex_indices[index_offset]);
+                iter->second.push_back(m.vertex_indices[index_offset + j + 1]);
+                iter->second.push_back(m.vertex_indices[index_offset + j + 2]);
+            }
+            index_offset += num_face_vertices;
+        }
+
+        Vector<Vector<u32>> pieces;
+        for (auto& i : mat_map)
+        {
+            pieces.push_back(move(i.second));
+        }
+        compute_tangents(vertices, pieces);
+        build_mesh_asset(mesh, vertices, pieces);
         return ok;
     }
 
-    static void import_static_mesh(const Path& path, const ObjLoader::ObjMesh& mesh, u32 shape_index)
+    // Reads one vertex attribute of one glTF primitive. Returns `false` if the primitive does not have the attribute.
+    static R<bool> read_gltf_attribute(const GLTFLoader::GLTFFile& file, const GLTFLoader::Primitive& primitive, const c8* name, 
+        usize num_vertices, u32 num_components, Vector<f32>& data)
+    {
+        i32 accessor = primitive.find_attribute(name);
+        if (accessor < 0) return false;
+        if (file.accessors[accessor].count != num_vertices)
+        {
+            return set_error(BasicError::format_error(), "The number of %s elements does not match the number of vertices.", name);
+        }
+        data.resize(num_vertices * num_components);
+        lutry
+        {
+            luexp(GLTFLoader::read_accessor_f32(file, (u32)accessor, data.data(), num_components));
+        }
+        lucatchret;
+        return true;
+    }
+
+    static RV create_mesh_asset_from_gltf(MeshAsset& mesh, Vector<i32>& piece_materials, const GLTFLoader::GLTFFile& file, u32 mesh_index)
     {
+        lutry
+        {
+            Vector<Vertex> vertices;
+            Vector<Vector<u32>> pieces;
+            Vector<f32> data;
+            bool has_tangents = true;
+            // Every primitive creates one mesh piece.
+            for (auto& p : file.meshes[mesh_index].primitives)
+            {
+                // Only triangle lists are imported.
+                i32 position = p.find_attribute("POSITION");
+                if (p.mode != GLTFLoader::PrimitiveMode::triangles || position < 0) continue;
+                usize base_vertex = vertices.size();
+                usize num_vertices = file.accessors[position].count;
+                vertices.resize(base_vertex + num_vertices);
+                Vertex* dst = vertices.data() + base_vertex;
+                luexp(read_gltf_attribute(file, p, "POSITION", num_vertices, 3, data));
+                for (usize i = 0; i < num_vertices; ++i)
+                {
+                    dst[i].position = Float3U(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]);
+                }
+                lulet(has_normal, read_gltf_attribute(file, p, "NORMAL", num_vertices, 3, data));
+                for (usize i = 0; i < num_vertices; ++i)
+                {
+                    dst[i].normal = has_normal ? Float3U(data[i * 3], data[i * 3 + 1], data[i * 3 + 2]) : Float3U(0.0f, 0.0f, 1.0f);
+                }
+                lulet(has_texcoord, read_gltf_attribute(file, p, "TEXCOORD_0", num_vertices, 2, data));
+                for (usize i = 0; i < num_vertices; ++i)
+                {
+                    dst[i].texcoord = has_texcoord ? Float2U(data[i * 2], data[i * 2 + 1]) : Float2U(0.0f, 0.0f);
+                }
+                lulet(has_color, read_gltf_attribute(file, p, "COLOR_0", num_vertices, 4, data));
+                bool rgb_color = has_color && file.accessors[p.find_attribute("COLOR_0")].type == GLTFLoader::AccessorType::vec3;
+                for (usize i = 0; i < num_vertices; ++i)
+                {
+                    dst[i].color = has_color ? Float4U(data[i * 4], data[i * 4 + 1], data[i * 4 + 2], rgb_color ? 1.0f : data[i * 4 + 3]) :
+                        Float4U(1.0f, 1.0f, 1.0f, 1.0f);
+                }
+                // The w component of glTF tangents stores the handedness.
+                lulet(has_tangent, read_gltf_attribute(file, p, "TANGENT", num_vertices, 4, data));
+                if (has_tangent)
+                {
+                    for (usize i = 0; i < num_vertices; ++i)
+                    {
+                        f32 w = data[i * 4 + 3] < 0.0f ? -1.0f : 1.0f;
+                        dst[i].tangent = Float3U(data[i * 4] * w, data[i * 4 + 1] * w, data[i * 4 + 2] * w);
+                    }
+                }
+                else
+                {
+                    has_tangents = false;
+                }
+                Vector<u32> indices;
+                if (p.indices >= 0)
+                {
+                    indices.resize(file.accessors[p.indices].count);
+                    luexp(GLTFLoader::read_accessor_u32(file, (u32)p.indices, indices.data()));
+                    for (u32& i : indices)
+                    {
+                        if (i >= num_vertices) return set_error(BasicError::format_error(), "Vertex index %u is out of range.", i);
+                        i += (u32)base_vertex;
+                    }
+                }
+                else
+                {
+                    indices.resize(num_vertices - num_vertices % 3);
+                    for (usize i = 0; i < indices.size(); ++i)
+                    {
+                        indices[i] = (u32)(base_vertex + i);
+                    }
+                }
+                indices.resize(indices.size() - indices.size() % 3);
+                pieces.push_back(move(indices));
+                piece_materials.push_back(p.material);
+            }
+            if (!has_tangents)
+            {
+                compute_tangents(vertices, pieces);
+            }
+            build_mesh_asset(mesh, vertices, pieces);
+        }
+        lucatchret;
+        return ok;
+    }
+
+    static R<Asset::asset_t> save_static_mesh(const Path& path, const MeshAsset& mesh_asset)
+    {
+        Asset::asset_t asset;
         lutry
         {
             auto file_path = path;
-            lulet(asset, Asset::new_asset(file_path, get_static_mesh_asset_type()));
+            luset(asset, Asset::new_asset(file_path, get_static_mesh_asset_type()));
             file_path.append_extension("mesh");
-            MeshAsset mesh_asset;
-            luexp(create_mesh_asset_from_obj(mesh_asset, mesh, shape_index));
             lulet(f, VFS::open_file(file_path, FileOpenFlag::write | FileOpenFlag::user_buffering, FileCreationMode::create_always));
             lulet(data, serialize(mesh_asset));
             auto json_data = VariantUtils::write_json(data);
@@ -218,6 +337,18 @@ namespace Luna
             f.reset();
             Asset::load_asset(asset);
         }
+        lucatchret;
+        return asset;
+    }
+
+    static void import_static_mesh(const Path& path, const ObjLoader::ObjMesh& mesh, u32 shape_index)
+    {
+        lutry
+        {
+            MeshAsset mesh_asset;
+            luexp(create_mesh_asset_from_obj(mesh_asset, mesh, shape_index));
+            luexp(save_static_mesh(path, mesh_asset));
+        }
         lucatch
         {
             auto _ = Window::message_box(explain(luerr), "Failed to import obj mesh asset",
@@ -225,10 +356,111 @@ namespace Luna
         }
     }
 
+    // Creates one material asset for one glTF material, or returns the existing asset if the asset is already imported.
+    static R<Asset::asset_t> import_gltf_material(const Path& path)
+    {
+        auto existing = Asset::get_asset_by_path(path);
+        if (succeeded(existing)) return existing;
+        Asset::asset_t asset;
+        lutry
+        {
+            luset(asset, Asset::new_asset(path, get_material_asset_type()));
+            // Textures of glTF materials are not imported, and should be assigned in the material editor.
+            Material material;
+            auto file_path = path;
+            file_path.append_extension("json");
+            luexp(save_object_to_json_file(material, file_path));
+            Asset::load_asset(asset);
+        }
+        lucatchret;
+        return asset;
+    }
+
+    static RV save_model(const Path& path, Asset::asset_t mesh, const Vector<Asset::asset_t>& materials)
+    {
+        lutry
+        {
+            lulet(asset, Asset::new_asset(path, get_model_asset_type()));
+            Model model;
+            model.mesh = mesh;
+            model.materials = materials;
+            auto file_path = path;
+            file_path.append_extension("json");
+            luexp(save_object_to_json_file(model, file_path));
+            Asset::load_asset(asset);
+        }
+        lucatchret;
+        return ok;
+    }
+
+    // Imports glTF meshes as mesh assets, and creates one model asset that binds the mesh with its materials for every mesh.
+    static void import_gltf_meshes(const Path& create_dir, const GLTFLoader::GLTFFile& file, Span<const u32> mesh_indices, Span<const String> names)
+    {
+        lutry
+        {
+            // Mesh data is built in parallel, assets are created on the current thread.
+            usize num_meshes = mesh_indices.size();
+            Vector<MeshAsset> mesh_assets;
+            mesh_assets.resize(num_meshes);
+            Vector<Vector<i32>> piece_materials;
+            piece_materials.resize(num_meshes);
+            Vector<RV> results;
+            results.resize(num_meshes);
+            JobSystem::parallel_for(0, num_meshes, 1, [&](usize i)
+            {
+                results[i] = create_mesh_asset_from_gltf(mesh_assets[i], piece_materials[i], file, mesh_indices[i]);
+            });
+            Vector<Asset::asset_t> material_assets;
+            material_assets.resize(file.materials.size());
+            for (usize i = 0; i < num_meshes; ++i)
+            {
+                luexp(results[i]);
+                Path mesh_path = create_dir;
+                mesh_path.push_back(names[i]);
+                lulet(mesh, save_static_mesh(mesh_path, mesh_assets[i]));
+                Vector<Asset::asset_t> materials;
+                for (i32 m : piece_materials[i])
+                {
+                    if (m < 0 || m >= (i32)file.materials.size())
+                    {
+                        materials.push_back(Asset::asset_t());
+                        continue;
+                    }
+                    if (!material_assets[m].handle)
+                    {
+                        Path material_path = create_dir;
+                        if (file.materials[m].name)
+                        {
+                            material_path.push_back(file.materials[m].name);
+                        }
+                        else
+                        {
+                            c8 material_name[32];
+                            snprintf(material_name, 32, "material_%d", m);
+                            material_path.push_back(material_name);
+                        }
+                        luset(material_assets[m], import_gltf_material(material_path));
+                    }
+                    materials.push_back(material_assets[m]);
+                }
+                String model_name = names[i];
+                model_name.append("_model");
+                Path model_path = create_dir;
+                model_path.push_back(model_name);
+                luexp(save_model(model_path, mesh, materials));
+            }
+        }
+        lucatch
+        {
+            auto _ = Window::message_box(explain(luerr), "Failed to import glTF mesh asset",
+                Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+        }
+    }
+
     void MeshImporter::on_render()
     {
         char title[32];
-        snprintf(title, 32, "Obj Mesh Importer###%d", (u32)(usize)this);
+        snprintf(title, 32, "Mesh Importer###%d", (u32)(usize)this);
 
         ImGui::Begin(title, &m_open, ImGuiWindowFlags_NoCollapse);
 
@@ -237,43 +469,68 @@ namespace Luna
             lutry
             {
                 Window::FileDialogFilter filter;
-                filter.name = "Obj File";
-                const c8* extension = "obj";
-                filter.extensions = {&extension, 1};
+                filter.name = "Mesh File";
+                const c8* extensions[] = { "obj", "glb" };
+                filter.extensions = {extensions, 2};
                 lulet(file_path, Window::open_file_dialog("Select Source File", {&filter, 1}));
                 // Open file.
                 auto path = file_path[0];
+                m_import_names.clear();
 
-                lulet(obj_file, open_file(path.encode(PathSeparator::system_preferred).c_str(),
-                    FileOpenFlag::read | FileOpenFlag::user_buffering, FileCreationMode::open_existing));
-                lulet(obj_file_data, load_file_data(obj_file));
-
-                path.replace_extension("mtl");
-                auto f = open_file(path.encode(PathSeparator::system_preferred).c_str(),
-                    FileOpenFlag::read | FileOpenFlag::user_buffering, FileCreationMode::open_existing);
-
-                Blob mtl_file_data;
-
-                if (succeeded(f))
+                if (path.extension() == "glb")
                 {
-                    luset(mtl_file_data, load_file_data(f.get()));
+                    // The file is mapped, so that vertex data is read from the mapped file directly.
+                    luset(m_gltf_file, GLTFLoader::load_file(path.encode(PathSeparator::system_preferred).c_str()));
+                    m_is_gltf = true;
+                    for (usize i = 0; i < m_gltf_file.meshes.size(); ++i)
+                    {
+                        if (m_gltf_file.meshes[i].name)
+                        {
+                            m_import_names.push_back(String(m_gltf_file.meshes[i].name.c_str()));
+                        }
+                        else
+                        {
+                            c8 mesh_name[32];
+                            snprintf(mesh_name, 32, "mesh_%u", (u32)i);
+                            m_import_names.push_back(String(mesh_name));
+                        }
+                    }
                 }
+                else
+                {
+                    lulet(obj_file, open_file(path.encode(PathSeparator::system_preferred).c_str(),
+                        FileOpenFlag::read | FileOpenFlag::user_buffering, FileCreationMode::open_existing));
+                    lulet(obj_file_data, load_file_data(obj_file));
 
-                luset(m_obj_file, ObjLoader::load(obj_file_data.cspan(), mtl_file_data.cspan()));
+                    path.replace_extension("mtl");
+                    auto f = open_file(path.encode(PathSeparator::system_preferred).c_str(),
+                        FileOpenFlag::read | FileOpenFlag::user_buffering, FileCreationMode::open_existing);
 
-                m_source_file_path = file_path[0];
+                    Blob mtl_file_data;
 
-                m_import_names.clear();
-                for (auto& i : m_obj_file.shapes)
-                {
-                    m_import_names.push_back(String(i.name.c_str()));
+                    if (succeeded(f))
+                    {
+                        luset(mtl_file_data, load_file_data(f.get()));
+                    }
+
+                    ObjLoader::LoadDesc load_desc;
+                    load_desc.build_unique_vertices = true;
+                    luset(m_obj_file, ObjLoader::load(obj_file_data.cspan(), mtl_file_data.cspan(), load_desc));
+                    m_is_gltf = false;
+
+                    for (auto& i : m_obj_file.shapes)
+                    {
+                        m_import_names.push_back(String(i.name.c_str()));
+                    }
                 }
+
+                m_source_file_path = file_path[0];
             }
             lucatch
             {
                 if (luerr != BasicError::interrupted())
                 {
-                    auto _ = Window::message_box(explain(luerr), "Failed to import obj file",
+                    auto _ = Window::message_box(explain(luerr), "Failed to import mesh file",
                         Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
                 }
                 m_source_file_path.clear();
@@ -283,7 +540,61 @@ namespace Luna
 
         if (m_source_file_path.empty())
         {
-            ImGui::Text("No obj file selected.");
+            ImGui::Text("No mesh file selected.");
+        }
+        else if (m_is_gltf)
+        {
+            ImGui::Text(m_source_file_path.encode().c_str());
+            ImGui::Text("glTF Information:");
+
+            ImGui::Text("Accessors count: %u", (u32)m_gltf_file.accessors.size());
+            ImGui::Text("Materials count: %u", (u32)m_gltf_file.materials.size());
+
+            if (m_gltf_file.meshes.empty())
+            {
+                ImGui::Text("No mesh detected, this file cannot be imported.");
+            }
+            else
+            {
+                ImGui::Text("%u meshes found", (u32)m_gltf_file.meshes.size());
+                ImGui::Text("One model asset named <mesh asset name>_model is created for every mesh to bind materials.");
+                if (ImGui::Button("Import All"))
+                {
+                    Vector<u32> mesh_indices;
+                    Vector<String> names;
+                    for (u32 i = 0; i < (u32)m_gltf_file.meshes.size(); ++i)
+                    {
+                        if (!m_import_names[i].empty())
+                        {
+                            mesh_indices.push_back(i);
+                            names.push_back(m_import_names[i]);
+                        }
+                    }
+                    import_gltf_meshes(m_create_dir, m_gltf_file, {mesh_indices.data(), mesh_indices.size()}, {names.data(), names.size()});
+                }
+                if (ImGui::CollapsingHeader("Meshes"))
+                {
+                    for (u32 i = 0; i < (u32)m_gltf_file.meshes.size(); ++i)
+                    {
+                        ImGui::Text("Name: %s", m_gltf_file.meshes[i].name.c_str());
+                        ImGui::Text("Primitives: %u", (u32)m_gltf_file.meshes[i].primitives.size());
+
+                        ImGui::PushID(i);
+                        ImGui::InputText("Asset Name", m_import_names[i]);
+                        if (!m_import_names[i].empty())
+                        {
+                            Path file_path = m_create_dir;
+                            file_path.push_back(m_import_names[i]);
+                            ImGui::Text("The mesh will be imported as: %s", file_path.encode().c_str());
+                            if (ImGui::Button("Import"))
+                            {
+                                import_gltf_meshes(m_create_dir, m_gltf_file, {&i, 1}, {&m_import_names[i], 1});
+                            }
+                        }
+                        ImGui::PopID();
+                    }
+                }
+            }
         }
         else
         {
@@ -0,0 +1,384 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file MeshOptimizer.cpp
+* @author JXMaster
+* @date 2024/5/2
+*/
+#include "MeshOptimizer.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/Runtime/Math/Vector.hpp>
+#include <math.h>
+
+namespace Luna
+{
+    // Parameters of the vertex cache optimization algorithm.
+    constexpr u32 VERTEX_CACHE_SIZE = 32;
+    constexpr f32 CACHE_DECAY_POWER = 1.5f;
+    constexpr f32 LAST_TRIANGLE_SCORE = 0.75f;
+    constexpr f32 VALENCE_BOOST_SCALE = 2.0f;
+    constexpr f32 VALENCE_BOOST_POWER = 0.5f;
+
+    // The cache size used to split clusters for overdraw optimization.
+    constexpr u32 OVERDRAW_CLUSTER_CACHE_SIZE = 16;
+
+    static f32 compute_vertex_score(i32 cache_position, u32 num_remaining_triangles)
+    {
+        // Vertices that are not used by any remaining triangle should never be selected.
+        if (!num_remaining_triangles) return -1.0f;
+        f32 score = 0.0f;
+        if (cache_position >= 0)
+        {
+            if (cache_position < 3)
+            {
+                // Vertices of the last triangle get one fixed score so that the next triangle does not
+                // prefer to share edges with the last triangle too strongly.
+                score = LAST_TRIANGLE_SCORE;
+            }
+            else
+            {
+                f32 scaler = 1.0f / (f32)(VERTEX_CACHE_SIZE - 3);
+                score = powf(1.0f - (f32)(cache_position - 3) * scaler, CACHE_DECAY_POWER);
+            }
+        }
+        // Boosts vertices with few remaining triangles, so that they are consumed early.
+        score += VALENCE_BOOST_SCALE * powf((f32)num_remaining_triangles, -VALENCE_BOOST_POWER);
+        return score;
+    }
+
+    void optimize_vertex_cache(Span<u32> indices, u32 num_vertices)
+    {
+        usize num_triangles = indices.size() / 3;
+        if (num_triangles < 2) return;
+        // Build vertex-triangle adjacency.
+        Vector<u32> num_remaining_triangles;
+        num_remaining_triangles.resize(num_vertices, 0);
+        for (usize i = 0; i < num_triangles * 3; ++i)
+        {
+            ++num_remaining_triangles[indices[i]];
+        }
+        Vector<u32> adjacency_offsets;
+        adjacency_offsets.resize(num_vertices + 1, 0);
+        for (u32 i = 0; i < num_vertices; ++i)
+        {
+            adjacency_offsets[i + 1] = adjacency_offsets[i] + num_remaining_triangles[i];
+        }
+        Vector<u32> adjacency;
+        adjacency.resize(num_triangles * 3);
+        {
+            Vector<u32> fill_offsets(adjacency_offsets.begin(), adjacency_offsets.end() - 1);
+            for (usize i = 0; i < num_triangles * 3; ++i)
+            {
+                adjacency[fill_offsets[indices[i]]++] = (u32)(i / 3);
+            }
+        }
+        // Initialize scores.
+        Vector<i32> cache_positions;
+        cache_positions.resize(num_vertices, -1);
+        Vector<f32> vertex_scores;
+        vertex_scores.resize(num_vertices);
+        for (u32 i = 0; i < num_vertices; ++i)
+        {
+            vertex_scores[i] = compute_vertex_score(-1, num_remaining_triangles[i]);
+        }
+        Vector<f32> triangle_scores;
+        triangle_scores.resize(num_triangles);
+        Vector<u8> emitted;
+        emitted.resize(num_triangles, 0);
+        i64 best_triangle = -1;
+        f32 best_score = -1.0f;
+        for (usize i = 0; i < num_triangles; ++i)
+        {
+            triangle_scores[i] = vertex_scores[indices[i * 3]] + vertex_scores[indices[i * 3 + 1]] + vertex_scores[indices[i * 3 + 2]];
+            if (triangle_scores[i] > best_score)
+            {
+                best_score = triangle_scores[i];
+                best_triangle = (i64)i;
+            }
+        }
+        Vector<u32> output;
+        output.reserve(num_triangles * 3);
+        u32 cache[VERTEX_CACHE_SIZE + 3];
+        u32 cache_count = 0;
+        usize next_unemitted = 0;
+        for (usize n = 0; n < num_triangles; ++n)
+        {
+            if (best_triangle < 0)
+            {
+                // No triangle in the cache can be used, so continue from the first triangle that is not emitted.
+                while (emitted[next_unemitted]) ++next_unemitted;
+                best_triangle = (i64)next_unemitted;
+            }
+            usize t = (usize)best_triangle;
+            emitted[t] = 1;
+            const u32* tri = indices.data() + t * 3;
+            output.insert(output.end(), tri, tri + 3);
+            // Remove the triangle from the adjacency of its vertices.
+            for (u32 k = 0; k < 3; ++k)
+            {
+                u32 v = tri[k];
+                u32* adj = adjacency.data() + adjacency_offsets[v];
+                u32 num_adj = num_remaining_triangles[v];
+                for (u32 j = 0; j < num_adj; ++j)
+                {
+                    if (adj[j] == (u32)t)
+                    {
+                        adj[j] = adj[num_adj - 1];
+                        --num_remaining_triangles[v];
+                        break;
+                    }
+                }
+            }
+            // Move vertices of the triangle to the front of the cache.
+            u32 new_cache[VERTEX_CACHE_SIZE + 3];
+            u32 new_cache_count = 0;
+            for (u32 k = 0; k < 3; ++k)
+            {
+                new_cache[new_cache_count++] = tri[k];
+            }
+            for (u32 i = 0; i < cache_count; ++i)
+            {
+                u32 v = cache[i];
+                if (v != tri[0] && v != tri[1] && v != tri[2]) new_cache[new_cache_count++] = v;
+            }
+            // Update scores of vertices in the cache, including vertices that are pushed out of the cache.
+            for (u32 i = 0; i < new_cache_count; ++i)
+            {
+                u32 v = new_cache[i];
+                i32 position = i < VERTEX_CACHE_SIZE ? (i32)i : -1;
+                cache_positions[v] = position;
+                f32 score = compute_vertex_score(position, num_remaining_triangles[v]);
+                f32 diff = score - vertex_scores[v];
+                vertex_scores[v] = score;
+                const u32* adj = adjacency.data() + adjacency_offsets[v];
+                for (u32 j = 0; j < num_remaining_triangles[v]; ++j)
+                {
+                    triangle_scores[adj[j]] += diff;
+                }
+            }
+            cache_count = min(new_cache_count, VERTEX_CACHE_SIZE);
+            memcpy(cache, new_cache, sizeof(u32) * cache_count);
+            // Select the next triangle from triangles that use vertices in the cache.
+            best_triangle = -1;
+            best_score = -1.0f;
+            for (u32 i = 0; i < cache_count; ++i)
+            {
+                u32 v = cache[i];
+                const u32* adj = adjacency.data() + adjacency_offsets[v];
+                for (u32 j = 0; j < num_remaining_triangles[v]; ++j)
+                {
+                    if (triangle_scores[adj[j]] > best_score)
+                    {
+                        best_score = triangle_scores[adj[j]];
+                        best_triangle = (i64)adj[j];
+                    }
+                }
+            }
+        }
+        memcpy(indices.data(), output.data(), sizeof(u32) * output.size());
+    }
+
+    struct TriangleCluster
+    {
+        u32 first_triangle;
+        u32 num_triangles;
+        f32 sort_key;
+    };
+
+    void optimize_overdraw(Span<u32> indices, Span<const Vertex> vertices)
+    {
+        usize num_triangles = indices.size() / 3;
+        if (num_triangles < 2) return;
+        // Split triangles into clusters at triangles whose vertices all miss the simulated cache, so
+        // that reordering clusters does not increase vertex cache misses too much.
+        Vector<TriangleCluster> clusters;
+        {
+            Vector<u32> cache_timestamps;
+            cache_timestamps.resize(vertices.size(), 0);
+            u32 timestamp = OVERDRAW_CLUSTER_CACHE_SIZE + 1;
+            for (usize i = 0; i < num_triangles; ++i)
+            {
+                u32 num_misses = 0;
+                for (u32 k = 0; k < 3; ++k)
+                {
+                    u32 v = indices[i * 3 + k];
+                    if (timestamp - cache_timestamps[v] > OVERDRAW_CLUSTER_CACHE_SIZE)
+                    {
+                        cache_timestamps[v] = timestamp++;
+                        ++num_misses;
+                    }
+                }
+                if (clusters.empty() || num_misses == 3)
+                {
+                    TriangleCluster cluster;
+                    cluster.first_triangle = (u32)i;
+                    cluster.num_triangles = 0;
+                    cluster.sort_key = 0.0f;
+                    clusters.push_back(cluster);
+                }
+                ++clusters.back().num_triangles;
+            }
+        }
+        if (clusters.size() < 2) return;
+        // Compute the area-weighted centroid and normal of every cluster.
+        Vector<Float3U> centroids;
+        Vector<Float3U> normals;
+        centroids.resize(clusters.size());
+        normals.resize(clusters.size());
+        Float3 mesh_centroid(0.0f, 0.0f, 0.0f);
+        f32 mesh_area = 0.0f;
+        for (usize c = 0; c < clusters.size(); ++c)
+        {
+            const TriangleCluster& cluster = clusters[c];
+            Float3 centroid(0.0f, 0.0f, 0.0f);
+            Float3 normal(0.0f, 0.0f, 0.0f);
+            f32 area = 0.0f;
+            for (u32 i = cluster.first_triangle; i < cluster.first_triangle + cluster.num_triangles; ++i)
+            {
+                Float3 p0 = vertices[indices[i * 3]].position;
+                Float3 p1 = vertices[indices[i * 3 + 1]].position;
+                Float3 p2 = vertices[indices[i * 3 + 2]].position;
+                Float3 n = cross(p1 - p0, p2 - p0);
+                f32 a = length(n);
+                centroid += (p0 + p1 + p2) * (a / 3.0f);
+                normal += n;
+                area += a;
+            }
+            mesh_centroid += centroid;
+            mesh_area += area;
+            centroids[c] = area > 0.0f ? centroid / area : Float3(vertices[indices[cluster.first_triangle * 3]].position);
+            f32 normal_length = length(normal);
+            normals[c] = normal_length > 0.0f ? normal / normal_length : Float3(0.0f, 0.0f, 0.0f);
+        }
+        if (mesh_area <= 0.0f) return;
+        mesh_centroid /= mesh_area;
+        // Clusters that face outside of the mesh are drawn first.
+        for (usize c = 0; c < clusters.size(); ++c)
+        {
+            clusters[c].sort_key = dot(Float3(centroids[c]) - mesh_centroid, Float3(normals[c]));
+        }
+        sort(clusters.begin(), clusters.end(), [](const TriangleCluster& lhs, const TriangleCluster& rhs)
+        {
+            return lhs.sort_key > rhs.sort_key;
+        });
+        Vector<u32> output;
+        output.reserve(num_triangles * 3);
+        for (auto& cluster : clusters)
+        {
+            const u32* begin = indices.data() + cluster.first_triangle * 3;
+            output.insert(output.end(), begin, begin + cluster.num_triangles * 3);
+        }
+        memcpy(indices.data(), output.data(), sizeof(u32) * output.size());
+    }
+
+    void optimize_vertex_fetch(Vector<Vertex>& vertices, Span<u32> indices)
+    {
+        Vector<u32> remap;
+        remap.resize(vertices.size(), U32_MAX);
+        Vector<Vertex> result;
+        result.reserve(vertices.size());
+        for (u32& index : indices)
+        {
+            if (remap[index] == U32_MAX)
+            {
+                remap[index] = (u32)result.size();
+                result.push_back(vertices[index]);
+            }
+            index = remap[index];
+        }
+        vertices = move(result);
+    }
+
+    f32 compute_acmr(Span<const u32> indices, u32 num_vertices, u32 cache_size)
+    {
+        usize num_triangles = indices.size() / 3;
+        if (!num_triangles) return 0.0f;
+        Vector<u32> cache_timestamps;
+        cache_timestamps.resize(num_vertices, 0);
+        u32 timestamp = cache_size + 1;
+        usize num_misses = 0;
+        for (usize i = 0; i < num_triangles * 3; ++i)
+        {
+            u32 v = indices[i];
+            if (timestamp - cache_timestamps[v] > cache_size)
+            {
+                cache_timestamps[v] = timestamp++;
+                ++num_misses;
+            }
+        }
+        return (f32)num_misses / (f32)num_triangles;
+    }
+
+    static i16 quantize_snorm16(f32 v)
+    {
+        return (i16)roundf(clamp(v, -1.0f, 1.0f) * 32767.0f);
+    }
+
+    static u8 quantize_unorm8(f32 v)
+    {
+        return (u8)roundf(clamp(v, 0.0f, 1.0f) * 255.0f);
+    }
+
+    // Converts one 32-bit floating-point number to one 16-bit floating-point number, rounding to nearest even.
+    static u16 quantize_half(f32 v)
+    {
+        u32 bits;
+        memcpy(&bits, &v, sizeof(u32));
+        u32 sign = (bits >> 16) & 0x8000;
+        u32 f32_exponent = (bits >> 23) & 0xFF;
+        u32 mantissa = bits & 0x7FFFFF;
+        // Infinity and NaN.
+        if (f32_exponent == 0xFF) return (u16)(sign | 0x7C00 | (mantissa ? 0x200 : 0));
+        i32 exponent = (i32)f32_exponent - 127 + 15;
+        // Overflow to infinity.
+        if (exponent >= 31) return (u16)(sign | 0x7C00);
+        u32 half;
+        u32 shift;
+        if (exponent <= 0)
+        {
+            // Underflow to zero.
+            if (exponent < -10) return (u16)sign;
+            // Subnormal numbers.
+            mantissa |= 0x800000;
+            shift = (u32)(14 - exponent);
+            half = mantissa >> shift;
+        }
+        else
+        {
+            shift = 13;
+            half = ((u32)exponent << 10) | (mantissa >> shift);
+        }
+        // A carry from the mantissa to the exponent still produces the correct result.
+        u32 remainder = mantissa & ((1 << shift) - 1);
+        u32 halfway = 1 << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) ++half;
+        return (u16)(sign | half);
+    }
+
+    void quantize_vertices(Span<const Vertex> vertices, Span<QuantizedVertex> out_vertices)
+    {
+        luassert(vertices.size() == out_vertices.size());
+        for (usize i = 0; i < vertices.size(); ++i)
+        {
+            const Vertex& src = vertices[i];
+            QuantizedVertex& dst = out_vertices[i];
+            dst.position = src.position;
+            dst.normal[0] = quantize_snorm16(src.normal.x);
+            dst.normal[1] = quantize_snorm16(src.normal.y);
+            dst.normal[2] = quantize_snorm16(src.normal.z);
+            dst.normal[3] = 0;
+            dst.tangent[0] = quantize_snorm16(src.tangent.x);
+            dst.tangent[1] = quantize_snorm16(src.tangent.y);
+            dst.tangent[2] = quantize_snorm16(src.tangent.z);
+            dst.tangent[3] = 0;
+            dst.texcoord[0] = quantize_half(src.texcoord.x);
+            dst.texcoord[1] = quantize_half(src.texcoord.y);
+            dst.color[0] = quantize_unorm8(src.color.x);
+            dst.color[1] = quantize_unorm8(src.color.y);
+            dst.color[2] = quantize_unorm8(src.color.z);
+            dst.color[3] = quantize_unorm8(src.color.w);
+        }
+    }
+}
@@ -0,0 +1,46 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file MeshOptimizer.hpp
+* @author JXMaster
+* @date 2024/5/2
+*/
+#pragma once
+#include "../Mesh.hpp"
+
+namespace Luna
+{
+    //! Reorders triangles of one triangle list to improve the hit rate of the post-transform vertex cache.
+    //! @details This uses the linear-speed vertex cache optimization algorithm by Tom Forsyth.
+    //! @param[in, out] indices The triangle list to reorder.
+    //! @param[in] num_vertices The number of vertices referred by `indices`.
+    void optimize_vertex_cache(Span<u32> indices, u32 num_vertices);
+
+    //! Reorders clusters of triangles of one triangle list to reduce overdraw.
+    //! @details The triangle list is split into clusters at positions where the vertex cache is fully missed, so this
+    //! should be called after @ref optimize_vertex_cache to keep the vertex cache hit rate. Clusters that face outside
+    //! of the mesh are drawn first, since they are more likely to occlude other clusters.
+    //! @param[in, out] indices The triangle list to reorder.
+    //! @param[in] vertices The vertices referred by `indices`.
+    void optimize_overdraw(Span<u32> indices, Span<const Vertex> vertices);
+
+    //! Reorders vertices in the order they are first referred by indices, so that vertices are fetched linearly
+    //! when drawing the mesh. Vertices not referred by indices are removed.
+    //! @param[in, out] vertices The vertices to reorder.
+    //! @param[in, out] indices The indices of all triangle lists that use `vertices`, which will be remapped.
+    void optimize_vertex_fetch(Vector<Vertex>& vertices, Span<u32> indices);
+
+    //! Computes the average number of vertex shader invocations per triangle (ACMR) of one triangle list with
+    //! one FIFO vertex cache simulation.
+    //! @param[in] indices The triangle list.
+    //! @param[in] num_vertices The number of vertices referred by `indices`.
+    //! @param[in] cache_size The number of vertices in the simulated cache.
+    f32 compute_acmr(Span<const u32> indices, u32 num_vertices, u32 cache_size = 16);
+
+    //! Converts vertices to the format stored in vertex buffers.
+    //! @param[in] vertices The vertices to convert.
+    //! @param[out] out_vertices The converted vertices. This must have the same size as `vertices`.
+    void quantize_vertices(Span<const Vertex> vertices, Span<QuantizedVertex> out_vertices);
+}
@@ -19,10 +19,12 @@
 #include "../EditObject.hpp"
 #include "../SceneSettings.hpp"
 #include "../Camera.hpp"
+#include "../CameraPath.hpp"
 #include <Luna/Window/FileDialog.hpp>
 #include <Luna/Window/MessageBox.hpp>
 #include <Luna/RHI/Utility.hpp>
 #include <Luna/Image/RHIHelper.hpp>
+#include <Luna/Runtime/Time.hpp>
 namespace Luna
 {
     struct SceneEditorUserData
@@ -73,6 +75,14 @@ namespace Luna
 
         bool m_open = true;
 
+        // Whether the render graph statistics window is open.
+        bool m_render_graph_stats_open = false;
+
+        // States for camera path recording.
+        bool m_recording_camera_path = false;
+        CameraPath m_recorded_camera_path;
+        u64 m_record_begin_ticks = 0;
+
         SceneEditor() :
             m_renderer(RHI::get_main_device()) {}
 
@@ -84,6 +94,8 @@ namespace Luna
 
         void draw_components_grid();
 
+        void draw_render_graph_stats();
+
         virtual void on_render() override;
         virtual bool closed() override
         {
@@ -310,6 +322,8 @@ namespace Luna
             if(m_renderer.get_settings().frame_profiling)
             {
                 m_renderer.collect_frame_profiling_data();
+                g_main_editor->m_frame_profiler.add_gpu_zones({m_renderer.enabled_passes.data(), m_renderer.enabled_passes.size()},
+                    {m_renderer.pass_timestamps.data(), m_renderer.pass_timestamps.size()}, m_renderer.timestamp_frequency);
             }
 
             ImGui::Text("Scene");
@@ -318,7 +332,12 @@ namespace Luna
 
             m_renderer.scene = s;
 
-            auto r = m_renderer.render();
+            RV r;
+            {
+                // Steady-state frames should not allocate, offenders are reported in the Frame Allocations window.
+                LUNA_ALLOCATION_FREE_SCOPE("SceneRenderer::render");
+                r = m_renderer.render();
+            }
             if(failed(r))
             {
                 ImGui::Text("%s", explain(r.errcode()));
@@ -439,6 +458,16 @@ namespace Luna
             }
             ImGui::SameLine();
             ImGui::Checkbox("Time Profiling", &settings.frame_profiling);
+            ImGui::SameLine();
+            ImGui::Checkbox("Dynamic Resolution", &settings.dynamic_resolution);
+            ImGui::SameLine();
+            ImGui::Checkbox("Occlusion Culling", &settings.occlusion_culling);
+            ImGui::SameLine();
+            ImGui::Checkbox("GPU Driven", &settings.gpu_driven);
+            ImGui::SameLine();
+            ImGui::Checkbox("Depth Pre-pass", &settings.depth_prepass);
+            ImGui::SameLine();
+            ImGui::Checkbox("Shadows", &settings.shadows);
 
             Float2 scene_sz = ImGui::GetContentRegionAvail();
             Float2 scene_pos = ImGui::GetCursorScreenPos();
@@ -482,6 +511,29 @@ namespace Luna
                 {
                     ImGui::Text("Frame Size: %ux%u", (u32)(scene_sz.x * io.DisplayFramebufferScale.x), (u32)(scene_sz.y * io.DisplayFramebufferScale.y));
                     ImGui::Text("FPS: %f", ImGui::GetIO().Framerate);
+                    if (m_renderer.get_settings().dynamic_resolution)
+                    {
+                        ImGui::Text("Render Scale: %.0f%%%s", m_renderer.get_render_scale() * 100.0f, m_renderer.is_coarse_shading() ? " (Coarse Shading)" : "");
+                    }
+                    auto cmdbuf_stats = m_renderer.command_buffer->get_statistics();
+                    ImGui::Text("Draws: %u, Dispatches: %u, Barriers: %u", cmdbuf_stats.num_draws, cmdbuf_stats.num_dispatches, cmdbuf_stats.num_barriers);
+                    ImGui::Text("Pipeline Binds: %u, Descriptor Set Binds: %u", cmdbuf_stats.num_pipeline_state_binds, cmdbuf_stats.num_descriptor_set_binds);
+                    auto device_stats = g_env->device->get_statistics();
+                    ImGui::Text("Buffers: %llu, Textures: %llu, Descriptor Sets Created: %llu",
+                        (unsigned long long)(device_stats.num_buffers_created - device_stats.num_buffers_destroyed),
+                        (unsigned long long)(device_stats.num_textures_created - device_stats.num_textures_destroyed),
+                        (unsigned long long)device_stats.num_descriptor_sets_created);
+                    auto& geometry_stats = m_renderer.geometry_pipeline_statistics;
+                    ImGui::Text("Geometry Primitives: %llu, Pixel Shader Invocations: %llu, Occlusion Culled Meshes: %u, Draw Calls: %u",
+                        (unsigned long long)geometry_stats.rendered_primitives,
+                        (unsigned long long)geometry_stats.ps_invocations,
+                        m_renderer.num_occlusion_culled_meshes,
+                        m_renderer.num_geometry_draw_calls);
+                    ImGui::Text("Unloaded Assets: %u, Prefetching Assets: %u", m_renderer.num_unloaded_assets, m_renderer.num_prefetching_assets);
+                    if (m_renderer.get_settings().shadows)
+                    {
+                        ImGui::Text("Shadow Tiles: %u, Rendered Shadow Tiles: %u", m_renderer.num_shadow_tiles, m_renderer.num_rendered_shadow_tiles);
+                    }
                     for (usize i = 0; i < m_renderer.pass_time_intervals.size(); ++i)
                     {
                         f64 interval = m_renderer.pass_time_intervals[i];
@@ -599,6 +651,20 @@ namespace Luna
                 eular.x = clamp(eular.x, deg_to_rad(-85.0f), deg_to_rad(85.0f));
                 camera_entity->rotation = Quaternion::from_euler_angles(eular);
             }
+            if (m_recording_camera_path && camera_entity)
+            {
+                // Records at most 30 keys per second, the performance mode interpolates keys between them.
+                f64 time = (f64)(get_ticks() - m_record_begin_ticks) / get_ticks_per_second();
+                auto& keys = m_recorded_camera_path.keys;
+                if (keys.empty() || time - keys.back().time >= 1.0 / 30.0)
+                {
+                    CameraPathKey key;
+                    key.time = time;
+                    key.position = camera_entity->position;
+                    key.rotation = camera_entity->rotation;
+                    keys.push_back(key);
+                }
+            }
             m_renderer.command_buffer->wait();
             luassert_always(succeeded(m_renderer.command_buffer->reset()));
             if(settings != m_renderer.get_settings())
@@ -785,6 +851,33 @@ namespace Luna
                         capture_save_path.replace_extension("bmp");
                     }
                 }
+                if (!m_recording_camera_path && ImGui::MenuItem("Start Recording Camera Path"))
+                {
+                    m_recording_camera_path = true;
+                    m_recorded_camera_path.keys.clear();
+                    m_record_begin_ticks = get_ticks();
+                }
+                if (m_recording_camera_path && ImGui::MenuItem("Stop Recording Camera Path"))
+                {
+                    m_recording_camera_path = false;
+                    Window::FileDialogFilter filter;
+                    filter.name = "Camera Path File";
+                    const c8* ext = "json";
+                    filter.extensions = {&ext, 1};
+                    auto r = Window::save_file_dialog("Save Camera Path", {&filter, 1});
+                    if (succeeded(r) && !m_recorded_camera_path.keys.empty())
+                    {
+                        Path path = r.get();
+                        path.replace_extension("json");
+                        auto r2 = save_camera_path(m_recorded_camera_path, path);
+                        if (failed(r2))
+                        {
+                            auto _ = Window::message_box(explain(r2.errcode()), "Failed to save camera path", Window::MessageBoxType::ok, Window::MessageBoxIcon::error);
+                        }
+                    }
+                    m_recorded_camera_path.keys.clear();
+                }
+                ImGui::MenuItem("Render Graph Statistics", nullptr, &m_render_graph_stats_open);
                 ImGui::EndMenu();
             }
             ImGui::EndMenuBar();
@@ -812,12 +905,150 @@ namespace Luna
 
         ImGui::End();
 
+        if(m_render_graph_stats_open)
+        {
+            draw_render_graph_stats();
+        }
+
         if(capture_scene)
         {
             capture_scene_to_file(capture_save_path);
         }
     }
 
+    static void print_memory_size(u64 size)
+    {
+        if(size >= 1_mb)
+        {
+            ImGui::Text("%.2fMB", (f64)size / (f64)1_mb);
+        }
+        else if(size >= 1_kb)
+        {
+            ImGui::Text("%.2fKB", (f64)size / (f64)1_kb);
+        }
+        else
+        {
+            ImGui::Text("%lluB", (unsigned long long)size);
+        }
+    }
+
+    void SceneEditor::draw_render_graph_stats()
+    {
+        char title[64];
+        snprintf(title, 64, "Render Graph Statistics###%d", (u32)(usize)this);
+        ImGui::SetNextWindowSize(Float2(800, 600), ImGuiCond_FirstUseEver);
+        ImGui::Begin(title, &m_render_graph_stats_open, ImGuiWindowFlags_NoCollapse);
+        auto graph = m_renderer.get_render_graph();
+        auto& stats = m_renderer.render_graph_stats;
+        if(!graph || !m_renderer.get_settings().frame_profiling)
+        {
+            ImGui::Text("Enable Time Profiling in the scene editor to collect render graph statistics.");
+            ImGui::End();
+            return;
+        }
+        auto& desc = graph->get_desc();
+        if(stats.resources.size() != desc.resources.size())
+        {
+            ImGui::Text("Render graph statistics not ready.");
+            ImGui::End();
+            return;
+        }
+        if(ImGui::CollapsingHeader("Render Passes", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            f64 gpu_freq = m_renderer.timestamp_frequency;
+            f64 cpu_freq = get_ticks_per_second();
+            if(ImGui::BeginTable("Render Passes", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg))
+            {
+                ImGui::TableSetupColumn("Pass");
+                ImGui::TableSetupColumn("GPU Time");
+                ImGui::TableSetupColumn("CPU Recording Time");
+                ImGui::TableSetupColumn("Buffer Barriers");
+                ImGui::TableSetupColumn("Texture Barriers");
+                ImGui::TableHeadersRow();
+                for(auto& pass : stats.passes)
+                {
+                    ImGui::TableNextRow();
+                    ImGui::TableSetColumnIndex(0);
+                    ImGui::Text("%s", desc.passes[pass.pass].name.c_str());
+                    ImGui::TableSetColumnIndex(1);
+                    ImGui::Text("%.3fms", gpu_freq > 0.0 ? (f64)pass.gpu_time / gpu_freq * 1000.0 : 0.0);
+                    ImGui::TableSetColumnIndex(2);
+                    ImGui::Text("%.1fus", (f64)pass.cpu_time / cpu_freq * 1000000.0);
+                    ImGui::TableSetColumnIndex(3);
+                    ImGui::Text("%u", pass.num_buffer_barriers);
+                    ImGui::TableSetColumnIndex(4);
+                    ImGui::Text("%u", pass.num_texture_barriers);
+                }
+                ImGui::EndTable();
+            }
+        }
+        if(ImGui::CollapsingHeader("Transient Memory", ImGuiTreeNodeFlags_DefaultOpen))
+        {
+            ImGui::Text("Without Aliasing:");
+            ImGui::SameLine();
+            print_memory_size(stats.transient_memory_size_without_aliasing);
+            ImGui::Text("With Aliasing:");
+            ImGui::SameLine();
+            print_memory_size(stats.transient_memory_size);
+            ImGui::Text("Peak:");
+            ImGui::SameLine();
+            print_memory_size(stats.transient_memory_peak);
+            for(usize i = 0; i < stats.transient_heap_sizes.size(); ++i)
+            {
+                ImGui::Text("Heap %u:", (u32)i);
+                ImGui::SameLine();
+                print_memory_size(stats.transient_heap_sizes[i]);
+            }
+        }
+        if(ImGui::CollapsingHeader("Resource Lifetimes", ImGuiTreeNodeFlags_DefaultOpen) && !stats.passes.empty())
+        {
+            // Maps pass indices to timeline columns.
+            Vector<usize> pass_columns(desc.passes.size(), USIZE_MAX);
+            for(usize i = 0; i < stats.passes.size(); ++i)
+            {
+                pass_columns[stats.passes[i].pass] = i;
+            }
+            ImGui::BeginChild("Resource Lifetimes", Float2(0.0f, 0.0f), true, ImGuiWindowFlags_HorizontalScrollbar);
+            ImDrawList* dl = ImGui::GetWindowDrawList();
+            f32 row_height = ImGui::GetTextLineHeight() + 2.0f;
+            f32 label_width = 200.0f;
+            f32 column_width = max((ImGui::GetContentRegionAvail().x - label_width) / (f32)stats.passes.size(), 16.0f);
+            Float2 origin = ImGui::GetCursorScreenPos();
+            f32 y = origin.y;
+            for(usize i = 0; i < stats.resources.size(); ++i)
+            {
+                auto& res = stats.resources[i];
+                if(res.first_pass == USIZE_MAX) continue;
+                usize first = pass_columns[res.first_pass];
+                usize last = pass_columns[res.last_pass];
+                if(first == USIZE_MAX || last == USIZE_MAX) continue;
+                dl->AddText(Float2(origin.x, y), 0xFFFFFFFF, desc.resources[i].name.c_str());
+                Float2 min_pos(origin.x + label_width + first * column_width, y);
+                Float2 max_pos(origin.x + label_width + (last + 1) * column_width - 1.0f, y + row_height - 1.0f);
+                // Resources in the same heap share the same color, non-transient resources are drawn in gray.
+                u32 color = 0xFF808080;
+                if(res.heap != USIZE_MAX)
+                {
+                    u32 hue = (u32)(res.heap * 0x9E3779B9);
+                    color = 0xFF000000 | (0x404040 + (hue & 0x7F7F7F));
+                }
+                dl->AddRectFilled(min_pos, max_pos, color);
+                if(ImGui::IsMouseHoveringRect(min_pos, max_pos))
+                {
+                    ImGui::BeginTooltip();
+                    ImGui::Text("%s", desc.resources[i].name.c_str());
+                    ImGui::Text("%s - %s", desc.passes[res.first_pass].name.c_str(), desc.passes[res.last_pass].name.c_str());
+                    print_memory_size(res.size);
+                    ImGui::EndTooltip();
+                }
+                y += row_height;
+            }
+            ImGui::Dummy(Float2(label_width + column_width * stats.passes.size(), y - origin.y));
+            ImGui::EndChild();
+        }
+        ImGui::End();
+    }
+
     void SceneEditor::capture_scene_to_file(const Path& path)
     {
         using namespace RHI;
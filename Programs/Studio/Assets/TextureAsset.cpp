@@ -15,6 +15,8 @@
 #include <Luna/VFS/VFS.hpp>
 #include <Luna/RHI/Utility.hpp>
 #include <Luna/Image/RHIHelper.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+#include <Luna/Runtime/Thread.hpp>
 
 namespace Luna
 {
@@ -129,73 +131,198 @@ namespace Luna
         lucatchret;
         return ok;
     }
+    // Decodes image files to the staging memory of the upload manager directly, so that pixels are not copied to
+    // intermediate blobs. Images are decoded in parallel.
+    static RV upload_image_files(RHI::ITexture* tex, Span<const Pair<const void*, usize>> mip_files, Image::ImageFormat desired_format)
+    {
+        auto desc = tex->get_desc();
+        Vector<RHI::UploadTextureWriteRegion> regions;
+        regions.reserve(mip_files.size());
+        ErrCode err = ErrCode(0);
+        for (usize i = 0; i < mip_files.size(); ++i)
+        {
+            auto region = g_env->upload_manager->begin_texture_write(tex, RHI::SubresourceIndex((u32)i, 0), 0, 0, 0,
+                max<u32>(desc.width >> i, 1), max<u32>(desc.height >> i, 1), 1);
+            if (failed(region))
+            {
+                err = region.errcode();
+                break;
+            }
+            regions.push_back(region.get());
+        }
+        Vector<ErrCode> errors;
+        errors.resize(regions.size(), ErrCode(0));
+        if (!err.code)
+        {
+            JobSystem::parallel_for(0, regions.size(), 1, [&](usize i)
+            {
+                Image::ImageDesc image_desc;
+                auto& region = regions[i];
+                auto r = Image::read_image_file_to(mip_files[i].first, mip_files[i].second, desired_format,
+                    region.data, region.row_pitch, region.slice_pitch, image_desc);
+                if (failed(r)) errors[i] = r.errcode();
+            });
+        }
+        // Every begun write must be ended even if decoding fails, or the batch can never be submitted.
+        for (auto& region : regions)
+        {
+            g_env->upload_manager->end_texture_write(region);
+        }
+        for (auto& e : errors)
+        {
+            if (e.code && !err.code) err = e;
+        }
+        auto r = g_env->upload_manager->submit();
+        if (failed(r) && !err.code) err = r.errcode();
+        // Writes may be submitted in different batches if other threads submit between two writes.
+        for (auto& region : regions)
+        {
+            JobSystem::wait_job(region.job_id);
+        }
+        if (err.code) return err;
+        return ok;
+    }
+    // The number of mips that are loaded first when loading DDS textures with many mips. Other mips are loaded in background.
+    constexpr u32 DDS_STREAMING_INITIAL_MIPS = 6;
+    // Gets the first mip to load when the DDS texture is loaded, returns `0` if all mips should be loaded at once.
+    static u32 get_dds_streaming_first_mip(const Image::DDSImageDesc& desc)
+    {
+        if (desc.dimension != Image::DDSDimension::tex2d || desc.mip_levels <= DDS_STREAMING_INITIAL_MIPS) return 0;
+        u32 first_mip = desc.mip_levels - DDS_STREAMING_INITIAL_MIPS;
+        // The most detailed mip of block-compressed textures must be multiple of the block size.
+        if (Image::is_compressed(desc.format) &&
+            (((desc.width >> first_mip) % 4) != 0 || ((desc.height >> first_mip) % 4) != 0))
+        {
+            return 0;
+        }
+        return first_mip;
+    }
+    // Creates one texture from mips [first_mip, mip_levels) of the DDS image, and uploads data of these mips.
+    static R<Ref<RHI::ITexture>> load_dds_texture(const Image::DDSImageView& dds_image, u32 first_mip)
+    {
+        Ref<RHI::ITexture> tex;
+        lutry
+        {
+            RHI::TextureDesc desc;
+            switch (dds_image.desc.dimension)
+            {
+            case Image::DDSDimension::tex2d: desc.type = RHI::TextureType::tex2d; break;
+            case Image::DDSDimension::tex3d: desc.type = RHI::TextureType::tex3d; break;
+            case Image::DDSDimension::tex1d: desc.type = RHI::TextureType::tex1d; break;
+            default: lupanic();
+            }
+            desc.format = Image::dds_to_rhi_format(dds_image.desc.format);
+            if (desc.format == RHI::Format::unknown) luthrow(set_error(BasicError::not_supported(), "Unsupported DDS formats."));
+            desc.width = max<u32>(dds_image.desc.width >> first_mip, 1);
+            desc.height = max<u32>(dds_image.desc.height >> first_mip, 1);
+            desc.depth = max<u32>(dds_image.desc.depth >> first_mip, 1);
+            desc.array_size = dds_image.desc.array_size;
+            desc.mip_levels = dds_image.desc.mip_levels - first_mip;
+            desc.sample_count = 1;
+            desc.usages = RHI::TextureUsageFlag::read_texture | RHI::TextureUsageFlag::copy_source | RHI::TextureUsageFlag::copy_dest;
+            // Block-compressed formats cannot be used as storage textures.
+            if(!Image::is_compressed(dds_image.desc.format))
+            {
+                desc.usages |= RHI::TextureUsageFlag::read_write_texture;
+            }
+            if (test_flags(dds_image.desc.flags, Image::DDSFlag::texturecube))
+            {
+                desc.usages |= RHI::TextureUsageFlag::cube;
+            }
+            desc.flags = RHI::ResourceFlag::none;
+            // Create resource.
+            luset(tex, g_env->device->new_texture(RHI::MemoryType::local, desc));
+            // Upload data.
+            Vector<RHI::CopyResourceData> copies;
+            for (u32 item = 0; item < desc.array_size; ++item)
+            {
+                for (u32 mip = 0; mip < desc.mip_levels; ++mip)
+                {
+                    auto& subresource = dds_image.subresources[Image::calc_dds_subresoruce_index(mip + first_mip, item, dds_image.desc.mip_levels)];
+                    RHI::CopyResourceData copy = RHI::CopyResourceData::write_texture(tex, RHI::SubresourceIndex(mip, item), 0, 0, 0, 
+                        dds_image.data + subresource.data_offset, subresource.row_pitch, subresource.slice_pitch, 
+                        subresource.width, subresource.height, subresource.depth);
+                    copies.push_back(move(copy));
+                }
+            }
+            lulet(upload_job, g_env->upload_manager->enqueue(copies.cspan()));
+            luexp(g_env->upload_manager->submit());
+            JobSystem::wait_job(upload_job);
+        }
+        lucatchret;
+        return tex;
+    }
+    struct DDSStreamingJob
+    {
+        // Keeps the mapped file alive until all mips are uploaded.
+        Ref<IMappedFile> file;
+        Image::DDSImageView image;
+        Asset::asset_t asset;
+        // The texture with only the least detailed mips, which is replaced by the texture with all mips.
+        Ref<RHI::ITexture> initial_texture;
+        Path path;
+    };
+    static void dds_streaming_job(void* params)
+    {
+        DDSStreamingJob* job = (DDSStreamingJob*)params;
+        auto tex = load_dds_texture(job->image, 0);
+        if (succeeded(tex))
+        {
+            tex.get()->set_name(job->path.encode().c_str());
+            // Waits for the asset system to set the initial texture as the asset data.
+            while (Asset::get_asset_state(job->asset) == Asset::AssetState::loading)
+            {
+                yield_current_thread();
+            }
+            // The asset may be unloaded or reloaded during streaming, in which case the texture is discarded.
+            ObjRef data = Asset::get_asset_data(job->asset);
+            if (data.get() == job->initial_texture.object())
+            {
+                auto _ = Asset::set_asset_data(job->asset, tex.get().object());
+            }
+        }
+        job->~DDSStreamingJob();
+    }
     static R<ObjRef> load_texture_asset(object_t userdata, Asset::asset_t asset, const Path& path)
     {
         ObjRef ret;
         lutry
         {
-            // Open image file.
+            // Map image file.
             Path file_path = path;
             file_path.append_extension("tex");
-            auto file = VFS::open_file(file_path, FileOpenFlag::read, FileCreationMode::open_existing);
+            auto file = VFS::map_file(file_path);
             if (failed(file))
             {
                 file_path.replace_extension("dds");
-                file = VFS::open_file(file_path, FileOpenFlag::read, FileCreationMode::open_existing);
+                file = VFS::map_file(file_path);
             }
             if (failed(file))
             {
                 return file.errcode();
             }
-            lulet(file_data, load_file_data(file.get()));
-            if (file_data.size() >= 4 && !memcmp((const c8*)file_data.data(), "DDS ", 4))
+            const byte_t* file_data = file.get()->get_data();
+            usize file_size = file.get()->get_size();
+            if (file_size >= 4 && !memcmp((const c8*)file_data, "DDS ", 4))
             {
-                lulet(dds_image, Image::read_dds_image(file_data.data(), file_data.size()));
-                RHI::TextureDesc desc;
-                switch (dds_image.desc.dimension)
-                {
-                case Image::DDSDimension::tex2d: desc.type = RHI::TextureType::tex2d; break;
-                case Image::DDSDimension::tex3d: desc.type = RHI::TextureType::tex3d; break;
-                case Image::DDSDimension::tex1d: desc.type = RHI::TextureType::tex1d; break;
-                default: lupanic();
-                }
-                desc.format = Image::dds_to_rhi_format(dds_image.desc.format);
-                if (desc.format == RHI::Format::unknown) luthrow(set_error(BasicError::not_supported(), "Unsupported DDS formats."));
-                desc.width = dds_image.desc.width;
-                desc.height = dds_image.desc.height;
-                desc.depth = dds_image.desc.depth;
-                desc.array_size = dds_image.desc.array_size;
-                desc.mip_levels = dds_image.desc.mip_levels;
-                desc.sample_count = 1;
-                desc.usages = RHI::TextureUsageFlag::read_texture | RHI::TextureUsageFlag::read_write_texture | RHI::TextureUsageFlag::copy_source | RHI::TextureUsageFlag::copy_dest;
-                if (test_flags(dds_image.desc.flags, Image::DDSFlag::texturecube))
-                {
-                    desc.usages |= RHI::TextureUsageFlag::cube;
-                }
-                desc.flags = RHI::ResourceFlag::none;
-                // Create resource.
-                lulet(tex, g_env->device->new_texture(RHI::MemoryType::local, desc));
-                // Upload data.
-                lulet(upload_cmdbuf, g_env->device->new_command_buffer(g_env->async_copy_queue));
-                Vector<RHI::CopyResourceData> copies;
-                for (u32 item = 0; item < desc.array_size; ++item)
-                {
-                    u32 d = desc.depth;
-                    for (u32 mip = 0; mip < desc.mip_levels; ++mip)
-                    {
-                        auto& subresource = dds_image.subresources[Image::calc_dds_subresoruce_index(mip, item, desc.mip_levels)];
-                        RHI::CopyResourceData copy = RHI::CopyResourceData::write_texture(tex, RHI::SubresourceIndex(mip, item), 0, 0, 0, (const u8*)dds_image.data.data() + subresource.data_offset, subresource.row_pitch, subresource.slice_pitch, subresource.width, subresource.height, d);
-                        copies.push_back(move(copy));
-                    }
-                    if (d > 1) d >>= 1;
-                }
-                luexp(copy_resource_data(upload_cmdbuf, copies.cspan()));
+                // Subresources are uploaded from the mapped file directly.
+                lulet(dds_image, Image::read_dds_image_view(file_data, file_size));
+                u32 first_mip = get_dds_streaming_first_mip(dds_image.desc);
+                lulet(tex, load_dds_texture(dds_image, first_mip));
                 tex->set_name(path.encode().c_str());
                 ret = tex;
+                if (first_mip)
+                {
+                    // Loads all mips in background, and replaces the asset data when finished.
+                    void* job = JobSystem::new_job(dds_streaming_job, sizeof(DDSStreamingJob), alignof(DDSStreamingJob));
+                    new (job) DDSStreamingJob{ file.get(), move(dds_image), asset, tex, path };
+                    JobSystem::set_job_name(job, "DDSStreamingJob");
+                    JobSystem::submit_job(job, JobSystem::JobPriority::background);
+                }
             }
-            else if (file_data.size() >= 8 && !memcmp((const c8*)file_data.data(), "LUNAMIPS", 8))
+            else if (file_size >= 8 && !memcmp((const c8*)file_data, "LUNAMIPS", 8))
             {
-                u64* dp = (u64*)((u8*)file_data.data() + 8);
+                const u64* dp = (const u64*)(file_data + 8);
                 u32 num_mips = (u32)*dp;
                 ++dp;
                 Vector<Pair<u64, u64>> mip_descs;
@@ -208,7 +335,7 @@ namespace Luna
                     mip_descs.push_back(p);
                 }
                 // Load texture from file.
-                lulet(desc, Image::read_image_file_desc((const u8*)file_data.data() + mip_descs[0].first, mip_descs[0].second));
+                lulet(desc, Image::read_image_file_desc(file_data + mip_descs[0].first, mip_descs[0].second));
                 auto desired_format = Image::get_rhi_desired_format(desc.format);
                 // Create resource.
                 lulet(tex, g_env->device->new_texture(RHI::MemoryType::local, RHI::TextureDesc::tex2d(
@@ -216,39 +343,29 @@ namespace Luna
                     RHI::TextureUsageFlag::read_texture | RHI::TextureUsageFlag::read_write_texture | RHI::TextureUsageFlag::copy_source | RHI::TextureUsageFlag::copy_dest, 
                     desc.width, desc.height)));
                 // Upload data
-                Vector<Blob> image_data_array;
-                Vector<RHI::CopyResourceData> copies;
-                image_data_array.reserve(num_mips);
-                copies.reserve(num_mips);
+                Vector<Pair<const void*, usize>> mip_files;
+                mip_files.reserve(num_mips);
                 for (u32 i = 0; i < num_mips; ++i)
                 {
-                    Image::ImageDesc desc;
-                    lulet(image_data, Image::read_image_file((const u8*)file_data.data() + mip_descs[i].first, mip_descs[i].second, desired_format, desc));
-                    copies.push_back(RHI::CopyResourceData::write_texture(tex, RHI::SubresourceIndex(i, 0), 0, 0, 0, 
-                        image_data.data(), pixel_size(desc.format) * desc.width, pixel_size(desc.format) * desc.width * desc.height, desc.width, desc.height, 1));
-                    image_data_array.push_back(move(image_data));
+                    mip_files.push_back(make_pair((const void*)(file_data + mip_descs[i].first), (usize)mip_descs[i].second));
                 }
-                lulet(upload_cmdbuf, g_env->device->new_command_buffer(g_env->async_copy_queue));
-                luexp(RHI::copy_resource_data(upload_cmdbuf, {copies.data(), copies.size()}));
+                luexp(upload_image_files(tex, mip_files.cspan(), desired_format));
                 tex->set_name(path.encode().c_str());
                 ret = tex;
             }
             else
             {
                 // Load texture from file.
-                lulet(desc, Image::read_image_file_desc(file_data.data(), file_data.size()));
+                lulet(desc, Image::read_image_file_desc(file_data, file_size));
                 auto desired_format = Image::get_rhi_desired_format(desc.format);
-                lulet(image_data, Image::read_image_file(file_data.data(), file_data.size(), desired_format, desc));
                 // Create resource.
                 lulet(tex, RHI::get_main_device()->new_texture(RHI::MemoryType::local, RHI::TextureDesc::tex2d(
                     Image::image_to_rhi_format(desc.format),
                     RHI::TextureUsageFlag::read_texture | RHI::TextureUsageFlag::read_write_texture | RHI::TextureUsageFlag::copy_source | RHI::TextureUsageFlag::copy_dest,
                     desc.width, desc.height)));
                 // Upload data.
-                lulet(upload_cmdbuf, g_env->device->new_command_buffer(g_env->async_copy_queue));
-                luexp(RHI::copy_resource_data(upload_cmdbuf, {RHI::CopyResourceData::write_texture(tex, RHI::SubresourceIndex(0, 0), 0, 0, 0,
-                    image_data.data(), pixel_size(desc.format) * desc.width, pixel_size(desc.format) * desc.width * desc.height,
-                    desc.width, desc.height, 1)}));
+                Pair<const void*, usize> image_file = make_pair((const void*)file_data, file_size);
+                luexp(upload_image_files(tex, { &image_file, 1 }, desired_format));
                 // Generate mipmaps.
                 Ref<TextureAssetUserdata> ctx = ObjRef(userdata);
                 lulet(cmdbuf, g_env->device->new_command_buffer(g_env->async_compute_queue));
@@ -15,6 +15,9 @@
 #include <Luna/RHI/Utility.hpp>
 #include <Luna/Image/DDSImage.hpp>
 #include <Luna/Image/RHIHelper.hpp>
+#include <Luna/Image/BlockCompression.hpp>
+#include <Luna/Image/KTX2Image.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
 namespace Luna
 {
     enum class TexturePrefilerType : u8
@@ -29,6 +32,16 @@ namespace Luna
         dds = 1,
     };
 
+    enum class TextureCompressionType : u8
+    {
+        none = 0,
+        bc1 = 1,
+        bc3 = 2,
+        bc4 = 3,
+        bc5 = 4,
+        bc7 = 5,
+    };
+
     struct TextureFile
     {
         Path m_path;
@@ -38,6 +51,7 @@ namespace Luna
         // For image files.
         Image::ImageDesc m_desc;
         TexturePrefilerType m_prefiler_type;
+        TextureCompressionType m_compression_type;
         // For DDS files.
         Image::DDSImageDesc m_dds_desc;
     };
@@ -299,6 +313,59 @@ namespace Luna
         dialog->m_create_dir = create_dir;
         return dialog;
     }
+    static Image::DDSFormat get_compressed_format(TextureCompressionType type, bool srgb)
+    {
+        switch(type)
+        {
+            case TextureCompressionType::bc1: return srgb ? Image::DDSFormat::bc1_unorm_srgb : Image::DDSFormat::bc1_unorm;
+            case TextureCompressionType::bc3: return srgb ? Image::DDSFormat::bc3_unorm_srgb : Image::DDSFormat::bc3_unorm;
+            case TextureCompressionType::bc4: return Image::DDSFormat::bc4_unorm;
+            case TextureCompressionType::bc5: return Image::DDSFormat::bc5_unorm;
+            case TextureCompressionType::bc7: return srgb ? Image::DDSFormat::bc7_unorm_srgb : Image::DDSFormat::bc7_unorm;
+            default: lupanic(); return Image::DDSFormat::unknown;
+        }
+    }
+    // Compresses all subresources of one RGBA8 image, every block row is compressed in parallel.
+    static R<Image::DDSImage> compress_texture_image(const Image::DDSImage& src, TextureCompressionType type)
+    {
+        Image::DDSImage dst;
+        lutry
+        {
+            if(src.desc.format != Image::DDSFormat::r8g8b8a8_unorm && src.desc.format != Image::DDSFormat::r8g8b8a8_unorm_srgb)
+            {
+                return set_error(BasicError::not_supported(), "Only RGBA8 textures can be compressed.");
+            }
+            // Block-compressed textures require the size of the most detailed mip to be multiple of the block size.
+            if((src.desc.width % 4) != 0 || (src.desc.height % 4) != 0)
+            {
+                return set_error(BasicError::not_supported(), "The width and height of compressed textures must be multiples of 4.");
+            }
+            Image::DDSImageDesc desc = src.desc;
+            desc.format = get_compressed_format(type, src.desc.format == Image::DDSFormat::r8g8b8a8_unorm_srgb);
+            luset(dst, Image::new_dds_image(desc));
+            for(usize i = 0; i < src.subresources.size(); ++i)
+            {
+                const Image::DDSSubresource& s = src.subresources[i];
+                const Image::DDSSubresource& d = dst.subresources[i];
+                u32 num_block_rows = (s.height + 3) / 4;
+                for(u32 z = 0; z < s.depth; ++z)
+                {
+                    const u8* src_data = (const u8*)src.data.data() + s.data_offset + s.slice_pitch * z;
+                    u8* dst_data = (u8*)dst.data.data() + d.data_offset + d.slice_pitch * z;
+                    // Block rows are encoded independently, so that they can be compressed on multiple threads.
+                    JobSystem::parallel_for(0, num_block_rows, 1, [&](usize row)
+                    {
+                        u32 y = (u32)row * 4;
+                        auto r = Image::compress_blocks(desc.format, src_data + s.row_pitch * y, s.row_pitch, s.width, min<u32>(4, s.height - y),
+                            dst_data + d.row_pitch * row, d.row_pitch);
+                        luassert(succeeded(r));
+                    });
+                }
+            }
+        }
+        lucatchret;
+        return dst;
+    }
     void TextureImporter::import_texture_asset(const Path& create_dir, const TextureFile& file)
     {
         lutry
@@ -394,7 +461,16 @@ namespace Luna
             }
             else if(file.m_type == TextureFileType::dds)
             {
-                lulet(dds_image, Image::read_dds_image(file.m_file_data.data(), file.m_file_data.size()));
+                Image::DDSImage dds_image;
+                // KTX2 files are loaded as DDS images and saved as DDS assets.
+                if(Image::is_ktx2_file(file.m_file_data.data(), file.m_file_data.size()))
+                {
+                    luset(dds_image, Image::read_ktx2_image(file.m_file_data.data(), file.m_file_data.size()));
+                }
+                else
+                {
+                    luset(dds_image, Image::read_dds_image(file.m_file_data.data(), file.m_file_data.size()));
+                }
                 RHI::TextureDesc desc;
                 switch(dds_image.desc.dimension)
                 {
@@ -411,7 +487,12 @@ namespace Luna
                 desc.array_size = dds_image.desc.array_size;
                 desc.mip_levels = dds_image.desc.mip_levels;
                 desc.sample_count = 1;
-                desc.usages = RHI::TextureUsageFlag::read_texture | RHI::TextureUsageFlag::read_write_texture | RHI::TextureUsageFlag::copy_source | RHI::TextureUsageFlag::copy_dest;
+                desc.usages = RHI::TextureUsageFlag::read_texture | RHI::TextureUsageFlag::copy_source | RHI::TextureUsageFlag::copy_dest;
+                // Block-compressed formats cannot be used as storage textures.
+                if(!Image::is_compressed(dds_image.desc.format))
+                {
+                    desc.usages |= RHI::TextureUsageFlag::read_write_texture;
+                }
                 if(test_flags(dds_image.desc.flags, Image::DDSFlag::texturecube))
                 {
                     desc.usages |= RHI::TextureUsageFlag::cube;
@@ -474,6 +555,11 @@ namespace Luna
                 }
                 lulet(readback_cmdbuf, device->new_command_buffer(g_env->async_copy_queue));
                 luexp(copy_resource_data(readback_cmdbuf, copies.cspan()));
+                if(file.m_type == TextureFileType::image && file.m_prefiler_type == TexturePrefilerType::normal &&
+                    file.m_compression_type != TextureCompressionType::none)
+                {
+                    luset(image, compress_texture_image(image, file.m_compression_type));
+                }
                 Path file_path = create_dir;
                 file_path.push_back(file.m_asset_name);
                 luset(asset, Asset::new_asset(file_path, get_static_texture_asset_type()));
@@ -614,8 +700,8 @@ namespace Luna
                 m_files.clear();
                 Window::FileDialogFilter filter;
                 filter.name = "Image File";
-                const c8* exts[] = {"jpg", "jpeg", "png", "tga", "bmp", "psd", "gif", "hdr", "pic", "dds"};
-                filter.extensions = {exts, 10};
+                const c8* exts[] = {"jpg", "jpeg", "png", "tga", "bmp", "psd", "gif", "hdr", "pic", "dds", "ktx2"};
+                filter.extensions = {exts, 11};
                 lulet(img_paths, Window::open_file_dialog("Select Source File", {&filter, 1}, Path(), Window::FileDialogFlag::multi_select));
                 for(auto& img_path : img_paths)
                 {
@@ -629,11 +715,17 @@ namespace Luna
                         file.m_type = TextureFileType::dds;
                         luset(file.m_dds_desc, Image::read_dds_image_file_desc(file.m_file_data.data(), file.m_file_data.size()));
                     }
+                    else if(img_path.extension() == "ktx2")
+                    {
+                        file.m_type = TextureFileType::dds;
+                        luset(file.m_dds_desc, Image::read_ktx2_image_file_desc(file.m_file_data.data(), file.m_file_data.size()));
+                    }
                     else
                     {
                         file.m_type = TextureFileType::image;
                         luset(file.m_desc, Image::read_image_file_desc(file.m_file_data.data(), file.m_file_data.size()));
                         file.m_prefiler_type = TexturePrefilerType::normal;
+                        file.m_compression_type = TextureCompressionType::none;
                     }
                     file.m_path = img_path;
                     img_path.remove_extension();
@@ -739,6 +831,12 @@ namespace Luna
                     int import_type = (int)file.m_prefiler_type;
                     ImGui::Combo("Import Type", &import_type, "Texture\0Environment Map\0\0");
                     file.m_prefiler_type = (TexturePrefilerType)import_type;
+                    if(file.m_prefiler_type == TexturePrefilerType::normal)
+                    {
+                        int compression_type = (int)file.m_compression_type;
+                        ImGui::Combo("Compression", &compression_type, "None\0BC1 (RGB)\0BC3 (RGBA)\0BC4 (R)\0BC5 (RG)\0BC7 (RGBA)\0\0");
+                        file.m_compression_type = (TextureCompressionType)compression_type;
+                    }
                 }
                 if (!file.m_asset_name.empty())
                 {
@@ -0,0 +1,105 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file CameraPath.cpp
+* @author JXMaster
+* @date 2024/5/18
+*/
+#include "CameraPath.hpp"
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/Runtime/Math/Quaternion.hpp>
+#include <Luna/VariantUtils/JSON.hpp>
+
+namespace Luna
+{
+    void CameraPath::sample(f64 time, Float3& out_position, Float4& out_rotation) const
+    {
+        luassert(!keys.empty());
+        if (time <= keys.front().time || keys.size() == 1)
+        {
+            out_position = keys.front().position;
+            out_rotation = keys.front().rotation;
+            return;
+        }
+        if (time >= keys.back().time)
+        {
+            out_position = keys.back().position;
+            out_rotation = keys.back().rotation;
+            return;
+        }
+        // Finds the first key whose time is greater than `time`.
+        auto iter = upper_bound(keys.begin(), keys.end(), time, [](f64 t, const CameraPathKey& key) { return t < key.time; });
+        const CameraPathKey& k1 = *iter;
+        const CameraPathKey& k0 = *(iter - 1);
+        f64 interval = k1.time - k0.time;
+        f32 t = interval > 0.0 ? (f32)((time - k0.time) / interval) : 1.0f;
+        out_position = lerp(Float3(k0.position), Float3(k1.position), t);
+        out_rotation = Quaternion::slerp(k0.rotation, k1.rotation, t);
+    }
+
+    RV load_camera_path(CameraPath& path, const Path& file_path)
+    {
+        lutry
+        {
+            lulet(f, open_file(file_path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing));
+            lulet(data, VariantUtils::read_json(f));
+            auto& keys = data["keys"];
+            if (keys.type() != VariantType::array || keys.empty())
+            {
+                return set_error(BasicError::bad_data(), "Camera path %s does not have any key.", file_path.encode().c_str());
+            }
+            path.keys.clear();
+            path.keys.reserve(keys.size());
+            for (auto& k : keys.values())
+            {
+                CameraPathKey key;
+                key.time = k["time"].fnum();
+                auto& pos = k["position"];
+                auto& rot = k["rotation"];
+                key.position = Float3U((f32)pos[0].fnum(), (f32)pos[1].fnum(), (f32)pos[2].fnum());
+                key.rotation = Float4U((f32)rot[0].fnum(), (f32)rot[1].fnum(), (f32)rot[2].fnum(), (f32)rot[3].fnum(1.0));
+                if (!path.keys.empty() && key.time < path.keys.back().time)
+                {
+                    return set_error(BasicError::bad_data(), "Keys of camera path %s are not sorted by time.", file_path.encode().c_str());
+                }
+                path.keys.push_back(key);
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV save_camera_path(const CameraPath& path, const Path& file_path)
+    {
+        lutry
+        {
+            Variant keys(VariantType::array);
+            for (auto& key : path.keys)
+            {
+                Variant k(VariantType::object);
+                k["time"] = key.time;
+                Variant pos(VariantType::array);
+                pos.push_back((f64)key.position.x);
+                pos.push_back((f64)key.position.y);
+                pos.push_back((f64)key.position.z);
+                k["position"] = move(pos);
+                Variant rot(VariantType::array);
+                rot.push_back((f64)key.rotation.x);
+                rot.push_back((f64)key.rotation.y);
+                rot.push_back((f64)key.rotation.z);
+                rot.push_back((f64)key.rotation.w);
+                k["rotation"] = move(rot);
+                keys.push_back(move(k));
+            }
+            Variant data(VariantType::object);
+            data["keys"] = move(keys);
+            lulet(f, open_file(file_path.encode().c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+            luexp(VariantUtils::write_json(f, data));
+        }
+        lucatchret;
+        return ok;
+    }
+}
@@ -0,0 +1,46 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file CameraPath.hpp
+* @author JXMaster
+* @date 2024/5/18
+*/
+#pragma once
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/Path.hpp>
+#include <Luna/Runtime/Result.hpp>
+#include <Luna/Runtime/Math/Vector.hpp>
+
+namespace Luna
+{
+    // One recorded camera transform.
+    struct CameraPathKey
+    {
+        // The time of this key in seconds, relative to the first key.
+        f64 time;
+        Float3U position;
+        Float4U rotation;
+    };
+
+    // One camera path recorded in the scene editor, played back by the performance mode.
+    // Camera paths are stored as JSON files: { "keys": [ { "time": t, "position": [x, y, z], "rotation": [x, y, z, w] }, ... ] }
+    struct CameraPath
+    {
+        // Keys sorted by time.
+        Vector<CameraPathKey> keys;
+
+        // Gets the duration of the path in seconds.
+        f64 get_duration() const
+        {
+            return keys.empty() ? 0.0 : keys.back().time;
+        }
+        // Samples the camera transform at the specified time by interpolating adjacent keys.
+        // The path must have at least one key.
+        void sample(f64 time, Float3& out_position, Float4& out_rotation) const;
+    };
+
+    RV load_camera_path(CameraPath& path, const Path& file_path);
+    RV save_camera_path(const CameraPath& path, const Path& file_path);
+}
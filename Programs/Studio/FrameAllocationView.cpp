@@ -0,0 +1,114 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file FrameAllocationView.cpp
+* @author JXMaster
+* @date 2024/5/21
+*/
+#include "FrameAllocationView.hpp"
+#include <Luna/Runtime/Debug.hpp>
+
+namespace Luna
+{
+    void FrameAllocationView::render()
+    {
+        ImGui::SetNextWindowSize({ 600.0f, 600.0f }, ImGuiCond_FirstUseEver);
+        ImGui::Begin("Frame Allocations", nullptr, ImGuiWindowFlags_NoCollapse);
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        bool enabled = allocation_tracker_is_enabled();
+        if(ImGui::Checkbox("Enabled", &enabled))
+        {
+            allocation_tracker_set_enabled(enabled);
+        }
+        ImGui::SameLine();
+        if(ImGui::Checkbox("Assert On Violation", &m_assert_on_violation))
+        {
+            allocation_tracker_set_assert_on_violation(m_assert_on_violation);
+        }
+        ImGui::Text("Frame %llu", allocation_tracker_get_frame_index());
+        AllocationFrameStats stats[64];
+        usize num_threads = min<usize>(allocation_tracker_get_last_frame_stats({stats, 64}), 64);
+        if(ImGui::BeginTable("Threads", 6))
+        {
+            ImGui::TableSetupColumn("Thread");
+            ImGui::TableSetupColumn("Allocations");
+            ImGui::TableSetupColumn("Deallocations");
+            ImGui::TableSetupColumn("Bytes");
+            ImGui::TableSetupColumn("Objects");
+            ImGui::TableSetupColumn("Violations");
+            ImGui::TableHeadersRow();
+            AllocationFrameStats total = {};
+            for(usize i = 0; i <= num_threads; ++i)
+            {
+                // The last row shows the sum of all threads.
+                AllocationFrameStats& s = i < num_threads ? stats[i] : total;
+                if(i < num_threads)
+                {
+                    total.num_allocations += s.num_allocations;
+                    total.num_deallocations += s.num_deallocations;
+                    total.allocated_bytes += s.allocated_bytes;
+                    total.num_objects_created += s.num_objects_created;
+                    total.num_violations += s.num_violations;
+                    // Threads that do not allocate in the last frame are hidden.
+                    if(!s.num_allocations && !s.num_deallocations && !s.num_objects_created) continue;
+                }
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+                if(i < num_threads) ImGui::Text("%u", s.thread_index);
+                else ImGui::Text("Total");
+                ImGui::TableSetColumnIndex(1);
+                ImGui::Text("%llu", s.num_allocations);
+                ImGui::TableSetColumnIndex(2);
+                ImGui::Text("%llu", s.num_deallocations);
+                ImGui::TableSetColumnIndex(3);
+                ImGui::Text("%llu", s.allocated_bytes);
+                ImGui::TableSetColumnIndex(4);
+                ImGui::Text("%llu", s.num_objects_created);
+                ImGui::TableSetColumnIndex(5);
+                ImGui::Text("%llu", s.num_violations);
+            }
+            ImGui::EndTable();
+        }
+        ImGui::Separator();
+        static AllocationOffender offenders[MAX_ALLOCATION_OFFENDERS];
+        usize num_offenders = min<usize>(allocation_tracker_get_offenders({offenders, MAX_ALLOCATION_OFFENDERS}), MAX_ALLOCATION_OFFENDERS);
+        ImGui::Text("Offenders: %u", (u32)num_offenders);
+        ImGui::SameLine();
+        if(ImGui::Button("Clear"))
+        {
+            allocation_tracker_clear_offenders();
+            num_offenders = 0;
+        }
+        for(usize i = 0; i < num_offenders; ++i)
+        {
+            auto& offender = offenders[i];
+            c8 label[256];
+            if(offender.object_type)
+            {
+                snprintf(label, 256, "[Frame %llu] %s: create %s##%u", offender.frame_index, offender.section, offender.object_type, (u32)i);
+            }
+            else
+            {
+                snprintf(label, 256, "[Frame %llu] %s: allocate %llu bytes##%u", offender.frame_index, offender.section, (u64)offender.size, (u32)i);
+            }
+            // Symbols are resolved only for expanded offenders, since resolving symbols is slow.
+            if(ImGui::TreeNode(label))
+            {
+                ImGui::Text("Thread %u", offender.thread_index);
+                const c8** symbols = stack_backtrace_symbols({offender.frames, offender.num_frames});
+                for(u32 f = 0; f < offender.num_frames; ++f)
+                {
+                    ImGui::Text("%s", symbols[f] ? symbols[f] : "[Unknown]");
+                }
+                free_backtrace_symbols(symbols);
+                ImGui::TreePop();
+            }
+        }
+#else
+        ImGui::Text("The allocation tracker is not enabled in this build. Build with the `allocation_tracker` option or in debug mode to enable it.");
+#endif
+        ImGui::End();
+    }
+}
@@ -0,0 +1,23 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file FrameAllocationView.hpp
+* @author JXMaster
+* @date 2024/5/21
+*/
+#pragma once
+#include "StudioHeader.hpp"
+#include <Luna/Runtime/AllocationTracker.hpp>
+
+namespace Luna
+{
+    // Shows allocation counts of the last frame and allocation offenders recorded by the allocation tracker.
+    struct FrameAllocationView
+    {
+        bool m_assert_on_violation = false;
+
+        void render();
+    };
+}
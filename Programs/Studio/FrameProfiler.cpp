@@ -0,0 +1,288 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file FrameProfiler.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "FrameProfiler.hpp"
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/Math/Color.hpp>
+
+namespace Luna
+{
+    void FrameProfiler::on_zone_begin(usize thread, const c8* name, u64 timestamp)
+    {
+        LockGuard guard(m_lock);
+        auto iter = m_open_zones.find(thread);
+        if(iter == m_open_zones.end())
+        {
+            iter = m_open_zones.insert(make_pair(thread, Vector<OpenZone>())).first;
+        }
+        iter->second.push_back({name, timestamp});
+    }
+    void FrameProfiler::on_zone_end(usize thread, u64 timestamp)
+    {
+        LockGuard guard(m_lock);
+        auto iter = m_open_zones.find(thread);
+        // Zones begun before the profiler is registered are ignored.
+        if(iter == m_open_zones.end() || iter->second.empty()) return;
+        OpenZone zone = iter->second.back();
+        iter->second.pop_back();
+        CpuTrack& track = get_cpu_track(m_current_frame, thread);
+        CpuZone dst;
+        dst.name = zone.name;
+        dst.begin = zone.begin;
+        dst.end = timestamp;
+        dst.depth = (u32)iter->second.size();
+        track.max_depth = max(track.max_depth, dst.depth);
+        track.zones.push_back(move(dst));
+    }
+    FrameProfiler::CpuTrack& FrameProfiler::get_cpu_track(FrameRecord& frame, usize thread)
+    {
+        for(auto& track : frame.cpu_tracks)
+        {
+            if(track.thread == thread) return track;
+        }
+        auto iter = m_thread_indices.find(thread);
+        if(iter == m_thread_indices.end())
+        {
+            iter = m_thread_indices.insert(make_pair(thread, (u32)m_thread_indices.size())).first;
+        }
+        CpuTrack track;
+        track.thread = thread;
+        track.thread_index = iter->second;
+        track.max_depth = 0;
+        frame.cpu_tracks.push_back(move(track));
+        // Tracks are displayed in the order of thread indices.
+        auto& tracks = frame.cpu_tracks;
+        usize i = tracks.size() - 1;
+        while(i > 0 && tracks[i - 1].thread_index > tracks[i].thread_index)
+        {
+            swap(tracks[i - 1], tracks[i]);
+            --i;
+        }
+        return tracks[i];
+    }
+    void FrameProfiler::begin_frame()
+    {
+        LockGuard guard(m_lock);
+        u64 now = get_ticks();
+        if(m_current_frame.begin_time)
+        {
+            m_current_frame.end_time = now;
+            m_frames.push_back(move(m_current_frame));
+            while(m_frames.size() > m_max_frames) m_frames.pop_front();
+        }
+        u64 frame_index = m_frames.empty() ? 0 : m_frames.back().frame_index + 1;
+        m_current_frame = FrameRecord();
+        m_current_frame.frame_index = frame_index;
+        m_current_frame.begin_time = now;
+    }
+    void FrameProfiler::on_gpu_submit()
+    {
+        LockGuard guard(m_lock);
+        m_current_frame.submit_time = get_ticks();
+    }
+    void FrameProfiler::add_gpu_zones(Span<const Name> names, Span<const u64> timestamps, f64 timestamp_frequency)
+    {
+        LockGuard guard(m_lock);
+        // GPU timestamps can only be read after the frame is finished, so they belong to the last frame.
+        if(m_frames.empty() || timestamp_frequency <= 0.0) return;
+        FrameRecord& frame = m_frames.back();
+        usize num_zones = min(names.size(), timestamps.size() / 2);
+        for(usize i = 0; i < num_zones; ++i)
+        {
+            GpuZone zone;
+            zone.name = names[i];
+            zone.begin = (f64)timestamps[i * 2] / timestamp_frequency;
+            zone.end = (f64)timestamps[i * 2 + 1] / timestamp_frequency;
+            if(zone.end < zone.begin) continue;
+            frame.gpu_zones.push_back(move(zone));
+        }
+        calibrate_gpu_clock();
+    }
+    void FrameProfiler::calibrate_gpu_clock()
+    {
+        // The GPU cannot start one frame before its commands are submitted, so for every frame,
+        // `gpu_begin - cpu_submit` is not smaller than the real clock offset, and is close to the offset if the GPU is
+        // idle when commands are submitted. We take the minimal value of recorded frames as the estimation, which also
+        // follows clock drift as old frames are discarded.
+        f64 ticks_per_second = get_ticks_per_second();
+        bool calibrated = false;
+        f64 offset = 0.0;
+        for(auto& frame : m_frames)
+        {
+            if(!frame.submit_time || frame.gpu_zones.empty()) continue;
+            f64 gpu_begin = frame.gpu_zones[0].begin;
+            for(auto& zone : frame.gpu_zones) gpu_begin = min(gpu_begin, zone.begin);
+            f64 candidate = gpu_begin - (f64)frame.submit_time / ticks_per_second;
+            if(!calibrated || candidate < offset)
+            {
+                offset = candidate;
+                calibrated = true;
+            }
+        }
+        if(calibrated)
+        {
+            m_gpu_clock_offset = offset;
+            m_gpu_clock_calibrated = true;
+        }
+    }
+    inline u32 get_zone_color(const Name& name)
+    {
+        // Every zone name gets one stable color.
+        u64 h = name.id();
+        Float4 color(0.35f + 0.4f * (f32)(h & 0xFF) / 255.0f,
+            0.35f + 0.4f * (f32)((h >> 8) & 0xFF) / 255.0f,
+            0.35f + 0.4f * (f32)((h >> 16) & 0xFF) / 255.0f, 1.0f);
+        return Color::to_rgba8(color);
+    }
+    inline void draw_zone(ImDrawList* dl, const Float2& min_pos, const Float2& max_pos, const Name& name, f64 duration)
+    {
+        dl->AddRectFilled(min_pos, max_pos, get_zone_color(name));
+        dl->AddRect(min_pos, max_pos, 0xFF202020);
+        if(max_pos.x - min_pos.x > 8.0f && name)
+        {
+            dl->PushClipRect(min_pos, max_pos, true);
+            dl->AddText(Float2(min_pos.x + 2.0f, min_pos.y), 0xFF000000, name.c_str());
+            dl->PopClipRect();
+        }
+        if(ImGui::IsMouseHoveringRect(min_pos, max_pos))
+        {
+            ImGui::SetTooltip("%s: %.3fms", name ? name.c_str() : "(unnamed)", duration * 1000.0);
+        }
+    }
+    void FrameProfiler::render()
+    {
+        ImGui::Begin("Frame Profiler", nullptr, ImGuiWindowFlags_NoCollapse);
+        LockGuard guard(m_lock);
+        if(m_frames.empty())
+        {
+            ImGui::Text("No frame recorded.");
+            ImGui::End();
+            return;
+        }
+        f64 ticks_per_second = get_ticks_per_second();
+        i32 num_frames = (i32)m_frames.size();
+        ImGui::Checkbox("Pause", &m_paused);
+        if(!m_paused) m_selected_frame = num_frames - 1;
+        m_selected_frame = clamp(m_selected_frame, 0, num_frames - 1);
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(200.0f);
+        ImGui::SliderFloat("Zoom", &m_zoom, 1.0f, 100.0f, "%.1fx", ImGuiSliderFlags_Logarithmic);
+        ImGui::SameLine();
+        if(m_gpu_clock_calibrated)
+        {
+            ImGui::Text("GPU clock offset: %.3fms", m_gpu_clock_offset * 1000.0);
+        }
+        else
+        {
+            ImGui::Text("GPU clock not calibrated");
+        }
+        // Frame history.
+        {
+            Vector<f32> frame_times;
+            frame_times.reserve(m_frames.size());
+            f32 max_frame_time = 0.0f;
+            for(auto& frame : m_frames)
+            {
+                f32 t = (f32)((f64)(frame.end_time - frame.begin_time) / ticks_per_second * 1000.0);
+                frame_times.push_back(t);
+                max_frame_time = max(max_frame_time, t);
+            }
+            c8 overlay[64];
+            snprintf(overlay, 64, "Frame %llu: %.3fms", (unsigned long long)m_frames[m_selected_frame].frame_index, frame_times[m_selected_frame]);
+            Float2 history_pos = ImGui::GetCursorScreenPos();
+            Float2 history_size(ImGui::GetContentRegionAvail().x, 60.0f);
+            ImGui::PlotHistogram("##Frame History", frame_times.data(), (int)frame_times.size(), 0, overlay, 0.0f, max_frame_time * 1.1f, history_size);
+            // Clicking one frame in the history selects the frame and pauses recording.
+            if(ImGui::IsItemHovered() && ImGui::IsMouseClicked(ImGuiMouseButton_Left) && history_size.x > 0.0f)
+            {
+                f32 x = (ImGui::GetMousePos().x - history_pos.x) / history_size.x;
+                m_selected_frame = clamp((i32)(x * num_frames), 0, num_frames - 1);
+                m_paused = true;
+            }
+        }
+        FrameRecord& frame = m_frames[m_selected_frame];
+        // Timeline.
+        ImGui::BeginChild("Timeline", Float2(0.0f, 0.0f), true, ImGuiWindowFlags_HorizontalScrollbar);
+        {
+            ImDrawList* dl = ImGui::GetWindowDrawList();
+            f32 row_height = ImGui::GetTextLineHeight() + 2.0f;
+            f32 width = max(ImGui::GetContentRegionAvail().x * m_zoom, 1.0f);
+            Float2 origin = ImGui::GetCursorScreenPos();
+            f64 frame_duration = max((f64)(frame.end_time - frame.begin_time) / ticks_per_second, 0.000001);
+            f64 pixels_per_second = (f64)width / frame_duration;
+            auto cpu_to_x = [&](u64 ticks) -> f32
+            {
+                f64 t = ((f64)ticks - (f64)frame.begin_time) / ticks_per_second;
+                return origin.x + (f32)(t * pixels_per_second);
+            };
+            f32 y = origin.y;
+            for(auto& track : frame.cpu_tracks)
+            {
+                c8 label[64];
+                snprintf(label, 64, "CPU Thread %u", track.thread_index);
+                dl->AddText(Float2(origin.x + ImGui::GetScrollX(), y), 0xFFFFFFFF, label);
+                y += row_height;
+                for(auto& zone : track.zones)
+                {
+                    Float2 min_pos(cpu_to_x(zone.begin), y + zone.depth * row_height);
+                    Float2 max_pos(max(cpu_to_x(zone.end), min_pos.x + 1.0f), min_pos.y + row_height - 1.0f);
+                    draw_zone(dl, min_pos, max_pos, zone.name, (f64)(zone.end - zone.begin) / ticks_per_second);
+                }
+                y += (track.max_depth + 1) * row_height + 4.0f;
+            }
+            if(!frame.gpu_zones.empty())
+            {
+                dl->AddText(Float2(origin.x + ImGui::GetScrollX(), y), 0xFFFFFFFF, m_gpu_clock_calibrated ? "GPU" : "GPU (not calibrated)");
+                y += row_height;
+                // If the clock is not calibrated, GPU zones are placed relative to the first zone.
+                f64 offset = m_gpu_clock_calibrated ? m_gpu_clock_offset : frame.gpu_zones[0].begin - (f64)frame.begin_time / ticks_per_second;
+                for(auto& zone : frame.gpu_zones)
+                {
+                    u64 begin = (u64)max((zone.begin - offset) * ticks_per_second, 0.0);
+                    u64 end = (u64)max((zone.end - offset) * ticks_per_second, 0.0);
+                    Float2 min_pos(cpu_to_x(begin), y);
+                    Float2 max_pos(max(cpu_to_x(end), min_pos.x + 1.0f), y + row_height - 1.0f);
+                    draw_zone(dl, min_pos, max_pos, zone.name, zone.end - zone.begin);
+                }
+                y += row_height + 4.0f;
+            }
+            if(frame.cpu_tracks.empty() && frame.gpu_zones.empty())
+            {
+                ImGui::Text("No zone is recorded in this frame. CPU zones are recorded only if LUNA_CPU_PROFILER_ENABLED is defined, and GPU zones are recorded only if frame profiling is enabled in the scene editor.");
+            }
+            else
+            {
+                ImGui::Dummy(Float2(width, y - origin.y));
+            }
+        }
+        ImGui::EndChild();
+        ImGui::End();
+    }
+    void FrameProfilerCallback::operator()(Span<const ProfilerEvent> events)
+    {
+        for(auto& event : events)
+        {
+            switch(event.id)
+            {
+                case ProfilerEventId::CPU_ZONE_BEGIN:
+                {
+                    auto data = (const ProfilerEventData::CpuZoneBegin*)event.data;
+                    m_profiler->on_zone_begin((usize)event.thread, data->name, event.timestamp);
+                }
+                break;
+                case ProfilerEventId::CPU_ZONE_END:
+                {
+                    m_profiler->on_zone_end((usize)event.thread, event.timestamp);
+                }
+                break;
+                default: break;
+            }
+        }
+    }
+}
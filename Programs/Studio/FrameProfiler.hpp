@@ -0,0 +1,102 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file FrameProfiler.hpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#pragma once
+#include "StudioHeader.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/RingDeque.hpp>
+#include <Luna/Runtime/Profiler.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+
+namespace Luna
+{
+    // Collects CPU zones and GPU pass timestamps of the last frames, and shows them on one timeline.
+    struct FrameProfiler
+    {
+        struct CpuZone
+        {
+            Name name;
+            // CPU ticks.
+            u64 begin;
+            u64 end;
+            u32 depth;
+        };
+        struct CpuTrack
+        {
+            // The thread that records zones of this track, used only as one identifier.
+            usize thread;
+            u32 thread_index;
+            u32 max_depth;
+            Vector<CpuZone> zones;
+        };
+        struct GpuZone
+        {
+            Name name;
+            // GPU time in seconds.
+            f64 begin;
+            f64 end;
+        };
+        struct FrameRecord
+        {
+            u64 frame_index = 0;
+            // CPU ticks.
+            u64 begin_time = 0;
+            u64 end_time = 0;
+            // The CPU ticks when GPU commands of this frame are submitted, `0` if no command is submitted.
+            u64 submit_time = 0;
+            Vector<CpuTrack> cpu_tracks;
+            Vector<GpuZone> gpu_zones;
+        };
+        struct OpenZone
+        {
+            const c8* name;
+            u64 begin;
+        };
+
+        RecursiveSpinLock m_lock;
+        // Completed frames, from the oldest to the newest.
+        RingDeque<FrameRecord> m_frames;
+        FrameRecord m_current_frame;
+        usize m_max_frames = 240;
+        // Zones that are not ended yet, keyed by thread.
+        HashMap<usize, Vector<OpenZone>> m_open_zones;
+        HashMap<usize, u32> m_thread_indices;
+
+        // The estimated difference between the GPU clock and the CPU clock in seconds, so that
+        // `gpu_seconds - m_gpu_clock_offset` gives the CPU time of one GPU timestamp.
+        f64 m_gpu_clock_offset = 0.0;
+        bool m_gpu_clock_calibrated = false;
+
+        // UI states.
+        bool m_paused = false;
+        i32 m_selected_frame = 0;
+        f32 m_zoom = 1.0f;
+
+        void on_zone_begin(usize thread, const c8* name, u64 timestamp);
+        void on_zone_end(usize thread, u64 timestamp);
+        // Closes the current frame record and starts a new one. Should be called after profiler events
+        // of the last frame are flushed.
+        void begin_frame();
+        // Records the time when GPU commands of the current frame are submitted.
+        void on_gpu_submit();
+        // Adds pass timestamps of the last frame.
+        void add_gpu_zones(Span<const Name> names, Span<const u64> timestamps, f64 timestamp_frequency);
+        void render();
+
+    private:
+        CpuTrack& get_cpu_track(FrameRecord& frame, usize thread);
+        void calibrate_gpu_clock();
+    };
+    struct FrameProfilerCallback
+    {
+        FrameProfiler* m_profiler;
+
+        void operator()(Span<const ProfilerEvent> events);
+    };
+}
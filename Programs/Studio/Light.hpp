@@ -16,6 +16,8 @@ namespace Luna
         lustruct("DirectionalLight", "{10FA0F19-622B-41E5-84A1-914DF54877A4}");
         Float3 intensity = { 0.5f, 0.5f, 0.5f };
         f32 intensity_multiplier = 1.0f;
+        // Whether to render cascaded shadow maps for this light.
+        bool cast_shadow = false;
     };
 
     struct PointLight
@@ -24,6 +26,8 @@ namespace Luna
         Float3 intensity = { 0.5f, 0.5f, 0.5f };
         f32 intensity_multiplier = 1.0f;
         f32 attenuation_power = 1.0f;
+        // Whether to render one cube shadow map (six shadow tiles) for this light.
+        bool cast_shadow = false;
     };
 
     struct SpotLight
@@ -33,5 +37,7 @@ namespace Luna
         f32 intensity_multiplier = 1.0f;
         f32 attenuation_power = 1.0f;
         f32 spot_power = 64.0f;
+        // Whether to render one shadow map for this light.
+        bool cast_shadow = false;
     };
 }
\ No newline at end of file
@@ -16,6 +16,8 @@
 #include "Assets/Material.hpp"
 
 #include <Luna/VFS/VFS.hpp>
+#include <Luna/Asset/DerivedDataCache.hpp>
+#include <Luna/ShaderCompiler/ShaderCache.hpp>
 #include <Luna/Window/MessageBox.hpp>
 
 #include "Camera.hpp"
@@ -27,68 +29,62 @@
 
 #include "RenderPasses/SkyBoxPass.hpp"
 #include "RenderPasses/ToneMappingPass.hpp"
+#include "RenderPasses/AutoExposurePass.hpp"
+#include "RenderPasses/UpscalePass.hpp"
+#include "RenderPasses/DepthPyramidPass.hpp"
 #include "RenderPasses/WireframePass.hpp"
 #include "RenderPasses/GeometryPass.hpp"
+#include "RenderPasses/LightCullingPass.hpp"
 #include "RenderPasses/DeferredLightingPass.hpp"
 #include "RenderPasses/BufferVisualizationPass.hpp"
+#include "RenderPasses/ShadowPass.hpp"
 
 #include "SceneRenderer.hpp"
 #include <Luna/Runtime/Log.hpp>
 #include <Luna/Runtime/Thread.hpp>
 #include <Luna/Runtime/Profiler.hpp>
+#include <Luna/Runtime/Time.hpp>
 
 namespace Luna
 {
     MainEditor* g_main_editor;
 
-    RV MainEditor::init(const Path& project_path)
+    RV open_project(const Path& project_path)
     {
         lutry
         {
-            set_log_to_platform_enabled(true);
-
-            MemoryProfilerCallback memory_profiler_callback;
-            memory_profiler_callback.m_profiler = &m_memory_profiler;
-            m_memory_profiler_callback_handle = register_profiler_callback(memory_profiler_callback);
-
-            char title[256];
-            auto name = project_path.filename();
-
             // Mount Data folder.
             auto mount_path = project_path;
             mount_path.push_back("Data");
             luexp(VFS::mount(VFS::get_platform_filesystem_driver(), mount_path.encode(PathSeparator::system_preferred).c_str(), "/"));
 
+            // Mount derived data cache folder.
+            auto cache_path = project_path;
+            cache_path.push_back("DerivedDataCache");
+            auto cache_native_path = cache_path.encode(PathSeparator::system_preferred);
+            auto r = create_dir(cache_native_path.c_str());
+            if (failed(r) && r.errcode() != BasicError::already_exists()) luthrow(r.errcode());
+            luexp(VFS::mount(VFS::get_platform_filesystem_driver(), cache_native_path.c_str(), "/.DerivedDataCache"));
+            Asset::DerivedDataCacheDesc ddc_desc;
+            ddc_desc.local_dir = "/.DerivedDataCache";
+            Asset::set_derived_data_cache(ddc_desc);
+            // Compiled shaders are also stored in the derived data cache folder, so that shaders are not compiled again 
+            // when Studio is launched next time.
+            ShaderCompiler::ShaderCacheDesc shader_cache_desc;
+            shader_cache_desc.disk_dir = "/.DerivedDataCache/Shaders";
+            ShaderCompiler::set_shader_cache(shader_cache_desc);
+
             // Load all asset metadata.
             luexp(Asset::load_assets_meta("/"));
+        }
+        lucatchret;
+        return ok;
+    }
 
-            // Create window and render objects.
-            snprintf(title, 256, "%s - Luna Studio", name.c_str());
-            luset(m_window, Window::new_window(title, Window::WindowDisplaySettings::as_windowed(), Window::WindowCreationFlag::resizable));
-
-            m_window->get_close_event().add_handler([](Window::IWindow* window) {window->close(); });
-
-            luset(m_swap_chain, g_env->device->new_swap_chain(g_env->graphics_queue, m_window, RHI::SwapChainDesc({0, 0, 2, RHI::Format::bgra8_unorm, true})));
-            luset(m_cmdbuf, g_env->device->new_command_buffer(g_env->graphics_queue));
-
-            // Create ImGui context.
-            ImGuiUtils::set_active_window(m_window);
-
-            // Create asset browser instance.
-            for (usize i = 0; i < 4; ++i)
-            {
-                Ref<AssetBrowser> browser = new_object<AssetBrowser>();
-                browser->m_editor = this;
-                //browser->m_index = m_next_asset_browser_index;
-                //++m_next_asset_browser_index;
-                browser->m_path = "/";
-                auto his_path = browser->m_path;
-                browser->m_histroy_paths.push_back(his_path);
-                m_asset_browsers[i] = browser;
-            }
-
-            // Register types.
-
+    RV register_studio_types()
+    {
+        lutry
+        {
             register_components();
 
             luexp(register_static_texture_asset_type());
@@ -112,9 +108,14 @@ namespace Luna
             luexp(register_sky_box_pass());
             luexp(register_wireframe_pass());
             luexp(register_geometry_pass());
+            luexp(register_light_culling_pass());
             luexp(register_deferred_lighting_pass());
             luexp(register_tone_mapping_pass());
+            luexp(register_auto_exposure_pass());
+            luexp(register_upscale_pass());
+            luexp(register_depth_pyramid_pass());
             luexp(register_buffer_visualization_pass());
+            luexp(register_shadow_pass());
 
             register_enum_type<SceneRendererMode>({
                 luoption(SceneRendererMode, lit),
@@ -135,9 +136,98 @@ namespace Luna
         return ok;
     }
 
+    RV MainEditor::init(const Path& project_path)
+    {
+        lutry
+        {
+            set_log_to_platform_enabled(true);
+
+            MemoryProfilerCallback memory_profiler_callback;
+            memory_profiler_callback.m_profiler = &m_memory_profiler;
+            m_memory_profiler_callback_handle = register_profiler_batch_callback(memory_profiler_callback);
+            FrameProfilerCallback frame_profiler_callback;
+            frame_profiler_callback.m_profiler = &m_frame_profiler;
+            m_frame_profiler_callback_handle = register_profiler_batch_callback(frame_profiler_callback);
+            // Memory events are dispatched once per frame instead of on every allocation.
+            set_profiler_batch_mode(true);
+
+            char title[256];
+            auto name = project_path.filename();
+
+            luexp(open_project(project_path));
+            luset(m_file_watcher, VFS::new_file_watcher("/"));
+
+            // Create window and render objects.
+            snprintf(title, 256, "%s - Luna Studio", name.c_str());
+            luset(m_window, Window::new_window(title, Window::WindowDisplaySettings::as_windowed(), Window::WindowCreationFlag::resizable));
+
+            m_window->get_close_event().add_handler([](Window::IWindow* window) {window->close(); });
+
+            luset(m_swap_chain, g_env->device->new_swap_chain(g_env->graphics_queue, m_window, RHI::SwapChainDesc({0, 0, 2, RHI::Format::bgra8_unorm, true})));
+            luset(m_cmdbuf, g_env->device->new_command_buffer(g_env->graphics_queue));
+
+            // Create ImGui context.
+            ImGuiUtils::set_active_window(m_window);
+
+            // Create asset browser instance.
+            for (usize i = 0; i < 4; ++i)
+            {
+                Ref<AssetBrowser> browser = new_object<AssetBrowser>();
+                browser->m_editor = this;
+                //browser->m_index = m_next_asset_browser_index;
+                //++m_next_asset_browser_index;
+                browser->m_path = "/";
+                auto his_path = browser->m_path;
+                browser->m_histroy_paths.push_back(his_path);
+                m_asset_browsers[i] = browser;
+            }
+
+            // Register types.
+            luexp(register_studio_types());
+        }
+        lucatchret;
+        return ok;
+    }
+
+    static void file_watch_job(void* params)
+    {
+        VFS::IFileWatcher* watcher = *(VFS::IFileWatcher**)params;
+        Vector<VFS::FileChange> changes;
+        auto r = watcher->poll(changes);
+        if (failed(r))
+        {
+            log_error("Studio", "Failed to check file changes: %s", explain(r.errcode()));
+            return;
+        }
+        Vector<Path> changed_files;
+        for (auto& change : changes)
+        {
+            if (change.type == VFS::FileChangeType::modified) changed_files.push_back(change.path);
+        }
+        if (!changed_files.empty())
+        {
+            usize num_reloads = Asset::reload_changed_assets(changed_files.cspan());
+            if (num_reloads) log_info("Studio", "Reloading %llu changed assets.", (u64)num_reloads);
+        }
+    }
     RV MainEditor::update()
     {
+        // Zones of the last frame are dispatched to the frame profiler before the frame is closed.
+        flush_profiler_events();
+        m_frame_profiler.begin_frame();
+        m_perf_counter_hud.update();
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        allocation_tracker_new_frame();
+#endif
+        ++g_env->frame_index;
+        // Waits for the swap chain before polling events, so that input is sampled as late as possible.
+        // Errors are reported by `present`, so the result is ignored here.
+        if (m_swap_chain)
+        {
+            auto _ = m_swap_chain->wait_for_next_frame();
+        }
         Window::poll_events();
+        g_env->device->update_memory_budget();
 
         if (m_window->is_closed())
         {
@@ -150,6 +240,16 @@ namespace Luna
             return ok;
         }
 
+        // Checks file changes once per second in background.
+        u64 ticks = get_ticks();
+        if ((f64)(ticks - m_last_file_watch_ticks) >= get_ticks_per_second() && JobSystem::is_job_finished(m_file_watch_job))
+        {
+            m_last_file_watch_ticks = ticks;
+            VFS::IFileWatcher** params = (VFS::IFileWatcher**)JobSystem::new_job(file_watch_job, sizeof(VFS::IFileWatcher*), alignof(VFS::IFileWatcher*));
+            *params = m_file_watcher.get();
+            m_file_watch_job = JobSystem::submit_job(params, JobSystem::JobPriority::io);
+        }
+
         lutry
         {
             // Recreate the back buffer if needed.
@@ -196,6 +296,9 @@ namespace Luna
                         ImGui::Checkbox(buf, &m_asset_browsers_enabled[i]);
                     }
                     ImGui::Checkbox("Memory Profiler", &m_memory_profiler_window_enabled);
+                    ImGui::Checkbox("Frame Profiler", &m_frame_profiler_window_enabled);
+                    ImGui::Checkbox("Performance Counters", &m_perf_counter_window_enabled);
+                    ImGui::Checkbox("Frame Allocations", &m_frame_allocation_window_enabled);
                     ImGui::EndMenu();
                 }
                 ImGui::EndMainMenuBar();
@@ -214,6 +317,21 @@ namespace Luna
                 m_memory_profiler.render();
             }
 
+            if(m_frame_profiler_window_enabled)
+            {
+                m_frame_profiler.render();
+            }
+
+            if(m_perf_counter_window_enabled)
+            {
+                m_perf_counter_hud.render();
+            }
+
+            if(m_frame_allocation_window_enabled)
+            {
+                m_frame_allocation_view.render();
+            }
+
             // Draw Editors.
             auto iter = m_editors.begin();
             while (iter != m_editors.end())
@@ -240,6 +358,7 @@ namespace Luna
             m_cmdbuf->resource_barrier({}, {
                     {back_buffer, RHI::TEXTURE_BARRIER_ALL_SUBRESOURCES, RHI::TextureStateFlag::automatic, RHI::TextureStateFlag::present, RHI::ResourceBarrierFlag::none}
                 });
+            m_frame_profiler.on_gpu_submit();
             luexp(m_cmdbuf->submit({}, {}, true));
             m_cmdbuf->wait();
             luexp(m_cmdbuf->reset());
@@ -250,7 +369,11 @@ namespace Luna
     }
     void MainEditor::close()
     {
-        unregister_profiler_callback(m_memory_profiler_callback_handle);
+        JobSystem::wait_job(m_file_watch_job);
+        m_file_watcher.reset();
+        set_profiler_batch_mode(false);
+        unregister_profiler_batch_callback(m_frame_profiler_callback_handle);
+        unregister_profiler_batch_callback(m_memory_profiler_callback_handle);
     }
 
     void register_components()
@@ -278,7 +401,8 @@ namespace Luna
 
         register_struct_type<DirectionalLight>({
                 luproperty(DirectionalLight, Float3, intensity),
-                luproperty(DirectionalLight, f32, intensity_multiplier)
+                luproperty(DirectionalLight, f32, intensity_multiplier),
+                luproperty(DirectionalLight, bool, cast_shadow)
             });
         set_serializable<DirectionalLight>();
         g_env->component_types.insert(typeof<DirectionalLight>());
@@ -286,7 +410,8 @@ namespace Luna
         register_struct_type<PointLight>({
             luproperty(PointLight, Float3, intensity),
             luproperty(PointLight, f32, intensity_multiplier),
-            luproperty(PointLight, f32, attenuation_power)
+            luproperty(PointLight, f32, attenuation_power),
+            luproperty(PointLight, bool, cast_shadow)
             });
         set_serializable<PointLight>();
         g_env->component_types.insert(typeof<PointLight>());
@@ -295,7 +420,8 @@ namespace Luna
             luproperty(SpotLight, Float3, intensity),
             luproperty(SpotLight, f32, intensity_multiplier),
             luproperty(SpotLight, f32, attenuation_power),
-            luproperty(SpotLight, f32, spot_power)
+            luproperty(SpotLight, f32, spot_power),
+            luproperty(SpotLight, bool, cast_shadow)
             });
         set_serializable<SpotLight>();
         g_env->component_types.insert(typeof<SpotLight>());
@@ -329,6 +455,7 @@ namespace Luna
     {
         register_boxed_type<MainEditor>();
         register_boxed_type<AssetBrowser>();
+        register_boxed_type<SceneRenderData>();
 
         Ref<MainEditor> main_editor = new_object<MainEditor>();
         g_main_editor = main_editor;
@@ -11,6 +11,10 @@
 #include "StudioHeader.hpp"
 #include "AssetBrowser.hpp"
 #include "MemoryProfiler.hpp"
+#include "FrameProfiler.hpp"
+#include "PerfCounterHUD.hpp"
+#include "FrameAllocationView.hpp"
+#include <Luna/JobSystem/JobSystem.hpp>
 #include <Luna/Runtime/HashMap.hpp>
 
 namespace Luna
@@ -34,8 +38,23 @@ namespace Luna
         usize m_memory_profiler_callback_handle;
         bool m_memory_profiler_window_enabled = false;
 
+        FrameProfiler m_frame_profiler;
+        usize m_frame_profiler_callback_handle;
+        bool m_frame_profiler_window_enabled = false;
+
+        PerfCounterHUD m_perf_counter_hud;
+        bool m_perf_counter_window_enabled = false;
+
+        FrameAllocationView m_frame_allocation_view;
+        bool m_frame_allocation_window_enabled = false;
+
         //u32 m_next_asset_browser_index;
 
+        // Detects changes of asset files and reloads changed assets.
+        Ref<VFS::IFileWatcher> m_file_watcher;
+        JobSystem::job_id_t m_file_watch_job = JobSystem::INVALID_JOB_ID;
+        u64 m_last_file_watch_ticks = 0;
+
         bool m_exiting;
 
         u32 m_main_window_width;
@@ -58,6 +77,12 @@ namespace Luna
 
     void register_components();
 
+    // Mounts the data and derived data cache folders of the project and loads all asset metadata.
+    RV open_project(const Path& project_path);
+
+    // Registers components, asset types, asset editors and render passes used by Studio.
+    RV register_studio_types();
+
     void run_main_editor(const Path& project_path);
 
     void draw_asset_tile(Asset::asset_t asset, const RectF& draw_rect);
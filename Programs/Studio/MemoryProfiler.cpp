@@ -126,7 +126,7 @@ namespace Luna
             case ProfilerEventId::MEMORY_ALLOCATE:
             {
                 auto data = (ProfilerEventData::MemoryAllocate*)event.data;
-                m_profiler->on_allocate(data->ptr, data->size);
+                m_profiler->on_allocate(data->ptr, data->sampled_size);
             }
             break;
             case ProfilerEventId::MEMORY_DEALLOCATE:
@@ -156,4 +156,11 @@ namespace Luna
             default: break;
         }
     }
-}
\ No newline at end of file
+    void MemoryProfilerCallback::operator()(Span<const ProfilerEvent> events)
+    {
+        for(auto& event : events)
+        {
+            (*this)(event);
+        }
+    }
+}
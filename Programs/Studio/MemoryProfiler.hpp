@@ -43,5 +43,6 @@ namespace Luna
         MemoryProfiler* m_profiler;
 
         void operator()(const ProfilerEvent& event);
+        void operator()(Span<const ProfilerEvent> events);
     };
 }
\ No newline at end of file
@@ -27,6 +27,20 @@ namespace Luna
 
     static_assert(sizeof(Vertex) == 60, "Wrong Vertex struct size");
 
+    //! The vertex format stored in vertex buffers of meshes, see `get_vertex_input_layout_desc`.
+    //! Normals and tangents are stored as 16-bit signed normalized integers, texture coordinates are stored as 16-bit
+    //! floating-point numbers and colors are stored as 8-bit unsigned normalized integers.
+    struct QuantizedVertex
+    {
+        Float3U position;
+        i16 normal[4];
+        i16 tangent[4];
+        u16 texcoord[2];
+        u8 color[4];
+    };
+
+    static_assert(sizeof(QuantizedVertex) == 36, "Wrong QuantizedVertex struct size");
+
     struct MeshPiece
     {
         lustruct("MeshPiece", "{C79DC405-C231-4140-8E55-7EE0A1E882B1}");
@@ -39,12 +53,19 @@ namespace Luna
     {
         lustruct("Mesh", "{1552A9F4-6DDD-4CC5-919F-48E1DEFF5A5B}");
 
+        //! The vertex buffer that stores `QuantizedVertex`.
         Ref<RHI::IBuffer> vb;
         Ref<RHI::IBuffer> ib;
+        //! The vertex positions only, used by depth-only passes to reduce vertex fetch bandwidth.
+        Ref<RHI::IBuffer> position_vb;
         //! The number of vertices in vertex buffer.
         u32 vb_count;
         //! The number of indices in index buffer.
         u32 ib_count;
+        //! The minimum point of the axis-aligned bounding box of the mesh in local space.
+        Float3U bounding_box_min = Float3U(0.0f);
+        //! The maximum point of the axis-aligned bounding box of the mesh in local space.
+        Float3U bounding_box_max = Float3U(0.0f);
 
         //! Every piece of the mesh can be assigned with a different material.
         Vector<MeshPiece> pieces;
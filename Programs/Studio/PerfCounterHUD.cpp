@@ -0,0 +1,108 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PerfCounterHUD.cpp
+* @author JXMaster
+* @date 2024/5/20
+*/
+#include "PerfCounterHUD.hpp"
+#include <Luna/Runtime/Time.hpp>
+
+namespace Luna
+{
+    static void format_perf_counter_value(c8* buf, usize buf_size, f64 value, const c8* unit)
+    {
+        if(unit && !strcmp(unit, "bytes"))
+        {
+            f64 abs_value = value < 0.0 ? -value : value;
+            if(abs_value >= (f64)1_gb) snprintf(buf, buf_size, "%.2fGB", value / (f64)1_gb);
+            else if(abs_value >= (f64)1_mb) snprintf(buf, buf_size, "%.2fMB", value / (f64)1_mb);
+            else if(abs_value >= (f64)1_kb) snprintf(buf, buf_size, "%.2fKB", value / (f64)1_kb);
+            else snprintf(buf, buf_size, "%.0fB", value);
+        }
+        else if(unit)
+        {
+            snprintf(buf, buf_size, "%.2f %s", value, unit);
+        }
+        else
+        {
+            snprintf(buf, buf_size, "%.2f", value);
+        }
+    }
+    void PerfCounterHUD::update()
+    {
+        u64 now = get_ticks();
+        u32 num_counters = get_num_perf_counters();
+        // Counters registered after the last sample start with their current values, so that the first rate is not
+        // the total value accumulated before the counter is sampled.
+        while(m_counters.size() < num_counters)
+        {
+            CounterHistory history;
+            history.last_value = get_perf_counter_value((perf_counter_t)m_counters.size() + 1);
+            history.samples.resize(m_max_samples, 0.0f);
+            m_counters.push_back(move(history));
+        }
+        if(!m_last_sample_time)
+        {
+            m_last_sample_time = now;
+            return;
+        }
+        f64 elapsed = (f64)(now - m_last_sample_time) / get_ticks_per_second();
+        if(m_paused || elapsed < m_sample_interval) return;
+        m_last_sample_time = now;
+        for(usize i = 0; i < m_counters.size(); ++i)
+        {
+            perf_counter_t counter = (perf_counter_t)i + 1;
+            auto& history = m_counters[i];
+            i64 value = get_perf_counter_value(counter);
+            f32 sample;
+            if(get_perf_counter_desc(counter).type == PerfCounterType::counter)
+            {
+                sample = (f32)((f64)(value - history.last_value) / elapsed);
+            }
+            else
+            {
+                sample = (f32)value;
+            }
+            history.last_value = value;
+            history.samples[m_next_sample] = sample;
+        }
+        m_next_sample = (m_next_sample + 1) % m_max_samples;
+    }
+    void PerfCounterHUD::render()
+    {
+        ImGui::SetNextWindowSize({ 500.0f, 800.0f }, ImGuiCond_FirstUseEver);
+        ImGui::Begin("Performance Counters", nullptr, ImGuiWindowFlags_NoCollapse);
+        ImGui::Checkbox("Paused", &m_paused);
+        ImGui::SameLine();
+        ImGui::InputText("Filter", m_filter, 64);
+        usize last_sample = (m_next_sample + m_max_samples - 1) % m_max_samples;
+        for(usize i = 0; i < m_counters.size(); ++i)
+        {
+            PerfCounterDesc desc = get_perf_counter_desc((perf_counter_t)i + 1);
+            if(m_filter[0] && !strstr(desc.name, m_filter)) continue;
+            auto& history = m_counters[i];
+            f32 min_value = history.samples[0];
+            f32 max_value = history.samples[0];
+            for(f32 v : history.samples)
+            {
+                min_value = min(min_value, v);
+                max_value = max(max_value, v);
+            }
+            c8 value_text[64];
+            format_perf_counter_value(value_text, 64, history.samples[last_sample], desc.unit);
+            c8 overlay[96];
+            if(desc.type == PerfCounterType::counter) snprintf(overlay, 96, "%s/s", value_text);
+            else snprintf(overlay, 96, "%s", value_text);
+            ImGui::Text("%s", desc.name);
+            ImGui::PushID((int)i);
+            // Keeps zero visible so that flat graphs are not stretched to the full height.
+            ImGui::PlotLines("", history.samples.data(), (int)history.samples.size(), (int)m_next_sample, overlay,
+                min(min_value, 0.0f), max(max_value, 1.0f), { -1.0f, 60.0f });
+            ImGui::PopID();
+        }
+        ImGui::End();
+    }
+}
@@ -0,0 +1,43 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PerfCounterHUD.hpp
+* @author JXMaster
+* @date 2024/5/20
+*/
+#pragma once
+#include "StudioHeader.hpp"
+#include <Luna/Runtime/PerfCounter.hpp>
+
+namespace Luna
+{
+    // Samples all performance counters periodically, and graphs them over time.
+    struct PerfCounterHUD
+    {
+        struct CounterHistory
+        {
+            // The counter value of the last sample, used to compute rates of counters.
+            i64 last_value = 0;
+            // Sampled values. Counters are stored as rates per second, gauges are stored as values.
+            // This is one ring buffer whose oldest sample is at `m_next_sample`.
+            Vector<f32> samples;
+        };
+
+        Vector<CounterHistory> m_counters;
+        usize m_max_samples = 300;
+        usize m_next_sample = 0;
+        // The sample interval in seconds.
+        f64 m_sample_interval = 0.1;
+        u64 m_last_sample_time = 0;
+
+        // UI states.
+        bool m_paused = false;
+        c8 m_filter[64] = {};
+
+        // Called once per frame. Samples counters if the sample interval has elapsed since the last sample.
+        void update();
+        void render();
+    };
+}
@@ -0,0 +1,348 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PerfMode.cpp
+* @author JXMaster
+* @date 2024/5/18
+*/
+#include "PerfMode.hpp"
+#include "MainEditor.hpp"
+#include "CameraPath.hpp"
+#include "FrameProfiler.hpp"
+#include "Scene.hpp"
+#include "SceneSettings.hpp"
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Profiler.hpp>
+#include <Luna/VariantUtils/JSON.hpp>
+#include <string.h>
+
+namespace Luna
+{
+    struct PerfSamples
+    {
+        // The CPU time of one frame, including the time waiting for GPU.
+        Vector<f64> cpu_frame_ms;
+        // The CPU time used to record commands of one frame in `SceneRenderer::render`.
+        Vector<f64> cpu_render_ms;
+        // The GPU time from the beginning of the first pass to the end of the last pass.
+        Vector<f64> gpu_frame_ms;
+        // The GPU time of every render graph pass.
+        HashMap<Name, Vector<f64>> pass_ms;
+        // The total time of every CPU zone in one frame.
+        HashMap<Name, Vector<f64>> zone_ms;
+        // The peak number of bytes allocated by `memalloc`, `U64_MAX` if the memory profiler is disabled.
+        u64 peak_cpu_memory = U64_MAX;
+        // The peak device local memory usage reported by the device.
+        u64 peak_gpu_memory = 0;
+    };
+
+    static const c8* get_backend_name()
+    {
+        switch (RHI::get_backend_type())
+        {
+        case RHI::BackendType::d3d12: return "d3d12";
+        case RHI::BackendType::vulkan: return "vulkan";
+        case RHI::BackendType::metal: return "metal";
+        default: lupanic(); return "";
+        }
+    }
+
+    // Gets the sample at the specified percentile using the nearest-rank method. `samples` must be sorted.
+    static f64 get_percentile(const Vector<f64>& samples, u32 percentile)
+    {
+        usize rank = (samples.size() * percentile + 99) / 100;
+        return samples[rank ? rank - 1 : 0];
+    }
+
+    static Variant make_stats(Vector<f64> samples)
+    {
+        Variant ret(VariantType::object);
+        if (samples.empty()) return ret;
+        sort(samples.begin(), samples.end());
+        f64 sum = 0.0;
+        for (f64 s : samples) sum += s;
+        ret["count"] = (u64)samples.size();
+        ret["mean"] = sum / samples.size();
+        ret["p50"] = get_percentile(samples, 50);
+        ret["p95"] = get_percentile(samples, 95);
+        ret["p99"] = get_percentile(samples, 99);
+        ret["max"] = samples.back();
+        return ret;
+    }
+
+    static void update_memory_peaks(PerfSamples& samples)
+    {
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+        auto counters = memory_profiler_get_counters();
+        u64 cpu_memory = counters.allocated_bytes - counters.deallocated_bytes;
+        samples.peak_cpu_memory = samples.peak_cpu_memory == U64_MAX ? cpu_memory : max(samples.peak_cpu_memory, cpu_memory);
+#endif
+        g_env->device->update_memory_budget();
+        samples.peak_gpu_memory = max(samples.peak_gpu_memory, g_env->device->get_memory_budget().local.usage);
+    }
+
+    // Renders one frame and waits for the frame to be finished by GPU. If `samples` is not `nullptr`, timings of the
+    // frame are appended to `samples`.
+    static RV render_frame(SceneRenderer& renderer, FrameProfiler& profiler, PerfSamples* samples)
+    {
+        lutry
+        {
+            u64 frame_begin = get_ticks();
+            ++g_env->frame_index;
+            luexp(renderer.render());
+            u64 render_end = get_ticks();
+            profiler.on_gpu_submit();
+            luexp(renderer.command_buffer->submit({}, {}, true));
+            renderer.command_buffer->wait();
+            luexp(renderer.command_buffer->reset());
+            u64 frame_end = get_ticks();
+            // Closes the frame record so that CPU zones of this frame are available.
+            flush_profiler_events();
+            profiler.begin_frame();
+            if (!samples) return ok;
+            f64 ms_per_tick = 1000.0 / get_ticks_per_second();
+            samples->cpu_frame_ms.push_back((frame_end - frame_begin) * ms_per_tick);
+            samples->cpu_render_ms.push_back((render_end - frame_begin) * ms_per_tick);
+            renderer.collect_frame_profiling_data();
+            u64 gpu_begin = U64_MAX;
+            u64 gpu_end = 0;
+            for (usize i = 0; i + 1 < renderer.pass_timestamps.size(); i += 2)
+            {
+                gpu_begin = min(gpu_begin, renderer.pass_timestamps[i]);
+                gpu_end = max(gpu_end, renderer.pass_timestamps[i + 1]);
+            }
+            if (gpu_end > gpu_begin && renderer.timestamp_frequency > 0.0)
+            {
+                samples->gpu_frame_ms.push_back((f64)(gpu_end - gpu_begin) / renderer.timestamp_frequency * 1000.0);
+            }
+            for (usize i = 0; i < renderer.pass_time_intervals.size() && i < renderer.enabled_passes.size(); ++i)
+            {
+                samples->pass_ms.insert(make_pair(renderer.enabled_passes[i], Vector<f64>())).first->second.push_back(renderer.pass_time_intervals[i] * 1000.0);
+            }
+            {
+                LockGuard guard(profiler.m_lock);
+                if (!profiler.m_frames.empty())
+                {
+                    HashMap<Name, u64> zone_ticks;
+                    for (auto& track : profiler.m_frames.back().cpu_tracks)
+                    {
+                        for (auto& zone : track.zones)
+                        {
+                            zone_ticks.insert(make_pair(zone.name, (u64)0)).first->second += zone.end - zone.begin;
+                        }
+                    }
+                    for (auto& zone : zone_ticks)
+                    {
+                        samples->zone_ms.insert(make_pair(zone.first, Vector<f64>())).first->second.push_back(zone.second * ms_per_tick);
+                    }
+                }
+            }
+            update_memory_peaks(*samples);
+        }
+        lucatchret;
+        return ok;
+    }
+
+    static Variant make_report(const PerfModeOptions& options, PerfSamples& samples)
+    {
+        Variant report(VariantType::object);
+        report["backend"] = get_backend_name();
+        report["scene"] = options.scene_path.encode();
+        report["camera_path"] = options.camera_path.encode();
+        auto& settings = options.renderer_settings;
+        Variant s(VariantType::object);
+        s["width"] = (u64)settings.screen_size.x;
+        s["height"] = (u64)settings.screen_size.y;
+        s["occlusion_culling"] = settings.occlusion_culling;
+        s["gpu_driven"] = settings.gpu_driven;
+        s["depth_prepass"] = settings.depth_prepass;
+        s["shadows"] = settings.shadows;
+        report["settings"] = move(s);
+        report["warmup_frames"] = (u64)options.warmup_frames;
+        report["frames"] = (u64)samples.cpu_frame_ms.size();
+        // All times are in milliseconds.
+        report["cpu_frame_ms"] = make_stats(samples.cpu_frame_ms);
+        report["cpu_render_ms"] = make_stats(samples.cpu_render_ms);
+        report["gpu_frame_ms"] = make_stats(samples.gpu_frame_ms);
+        Variant passes(VariantType::object);
+        for (auto& pass : samples.pass_ms) passes[pass.first] = make_stats(pass.second);
+        report["passes"] = move(passes);
+        Variant zones(VariantType::object);
+        for (auto& zone : samples.zone_ms) zones[zone.first] = make_stats(zone.second);
+        report["cpu_zones"] = move(zones);
+        if (samples.peak_cpu_memory != U64_MAX) report["peak_cpu_memory"] = samples.peak_cpu_memory;
+        report["peak_gpu_memory"] = samples.peak_gpu_memory;
+        Variant frames(VariantType::array);
+        for (usize i = 0; i < samples.cpu_frame_ms.size(); ++i)
+        {
+            Variant frame(VariantType::object);
+            frame["cpu"] = samples.cpu_frame_ms[i];
+            if (i < samples.gpu_frame_ms.size()) frame["gpu"] = samples.gpu_frame_ms[i];
+            frames.push_back(move(frame));
+        }
+        report["frame_times"] = move(frames);
+        return report;
+    }
+
+    // Compares the 95th percentile frame times with the baseline report. Returns `true` if any regression is detected.
+    static R<bool> check_regression(const PerfModeOptions& options, const Variant& report)
+    {
+        bool regressed = false;
+        lutry
+        {
+            lulet(f, open_file(options.baseline_path.encode().c_str(), FileOpenFlag::read, FileCreationMode::open_existing));
+            lulet(baseline, VariantUtils::read_json(f));
+            if (strcmp(baseline["backend"].c_str(), report["backend"].c_str()))
+            {
+                log_warning("Studio", "The baseline is captured on the %s backend, but the current backend is %s.",
+                    baseline["backend"].c_str(), report["backend"].c_str());
+            }
+            const c8* metrics[] = { "cpu_frame_ms", "gpu_frame_ms" };
+            for (const c8* metric : metrics)
+            {
+                f64 base = baseline[metric]["p95"].fnum();
+                f64 current = report[metric]["p95"].fnum();
+                if (base <= 0.0 || current <= 0.0) continue;
+                f64 ratio = current / base - 1.0;
+                if (ratio > options.regression_tolerance)
+                {
+                    log_error("Studio", "Frame time regression: %s p95 is %.3fms, baseline is %.3fms (%+.1f%%).", metric, current, base, ratio * 100.0);
+                    regressed = true;
+                }
+                else
+                {
+                    log_info("Studio", "%s p95 is %.3fms, baseline is %.3fms (%+.1f%%).", metric, current, base, ratio * 100.0);
+                }
+            }
+        }
+        lucatchret;
+        return regressed;
+    }
+
+    static R<bool> run_perf_mode_impl(const PerfModeOptions& options)
+    {
+        bool regressed = false;
+        lutry
+        {
+            luexp(open_project(options.project_path));
+            luexp(register_studio_types());
+
+            lulet(scene_asset, Asset::get_asset_by_path(options.scene_path));
+            luexp(Asset::load_asset(scene_asset));
+            Ref<Scene> scene = Asset::get_asset_data<Scene>(scene_asset);
+            if (!scene) return set_error(BasicError::bad_data(), "Failed to load scene %s.", options.scene_path.encode().c_str());
+            auto scene_settings = scene->get_scene_component<SceneSettings>();
+            Entity* camera_entity = scene_settings ? scene->find_entity(scene_settings->camera_entity) : nullptr;
+            if (!camera_entity) return set_error(BasicError::bad_data(), "The scene does not have one camera entity.");
+
+            CameraPath camera_path;
+            if (!options.camera_path.empty())
+            {
+                luexp(load_camera_path(camera_path, options.camera_path));
+            }
+            u32 num_frames = options.num_frames;
+            if (!num_frames)
+            {
+                if (camera_path.keys.empty()) return set_error(BasicError::bad_arguments(), "Either the camera path or the number of frames must be specified.");
+                num_frames = (u32)(camera_path.get_duration() / options.frame_interval) + 1;
+            }
+
+            SceneRenderer renderer(g_env->device);
+            luset(renderer.command_buffer, g_env->device->new_command_buffer(g_env->graphics_queue));
+            SceneRendererSettings settings = options.renderer_settings;
+            settings.frame_profiling = true;
+            luexp(renderer.reset(settings));
+            renderer.scene = scene;
+
+            FrameProfiler profiler;
+            FrameProfilerCallback callback;
+            callback.m_profiler = &profiler;
+            usize callback_handle = register_profiler_batch_callback(callback);
+            set_profiler_batch_mode(true);
+            PerfSamples samples;
+            auto r = [&]() -> RV
+            {
+                lutry
+                {
+                    // Renders frames until all assets referenced by the scene are loaded, so that asset streaming does not affect timings.
+                    if (!camera_path.keys.empty())
+                    {
+                        Float3 position;
+                        Float4 rotation;
+                        camera_path.sample(0.0, position, rotation);
+                        camera_entity->position = position;
+                        camera_entity->rotation = rotation;
+                    }
+                    u64 load_begin = get_ticks();
+                    u32 num_loaded_frames = 0;
+                    while (num_loaded_frames < 2)
+                    {
+                        luexp(render_frame(renderer, profiler, nullptr));
+                        num_loaded_frames = (renderer.num_unloaded_assets || renderer.num_prefetching_assets) ? 0 : num_loaded_frames + 1;
+                        if ((f64)(get_ticks() - load_begin) / get_ticks_per_second() > options.asset_load_timeout)
+                        {
+                            return set_error(BasicError::timeout(), "Assets of the scene are not loaded in %.0f seconds.", options.asset_load_timeout);
+                        }
+                    }
+                    log_info("Studio", "Scene loaded in %.2f seconds.", (f64)(get_ticks() - load_begin) / get_ticks_per_second());
+                    for (u32 i = 0; i < options.warmup_frames; ++i)
+                    {
+                        luexp(render_frame(renderer, profiler, nullptr));
+                    }
+                    for (u32 i = 0; i < num_frames; ++i)
+                    {
+                        if (!camera_path.keys.empty())
+                        {
+                            Float3 position;
+                            Float4 rotation;
+                            camera_path.sample(i * options.frame_interval, position, rotation);
+                            camera_entity->position = position;
+                            camera_entity->rotation = rotation;
+                        }
+                        luexp(render_frame(renderer, profiler, &samples));
+                    }
+                }
+                lucatchret;
+                return ok;
+            }();
+            set_profiler_batch_mode(false);
+            unregister_profiler_batch_callback(callback_handle);
+            luexp(r);
+
+            Variant report = make_report(options, samples);
+            log_info("Studio", "%u frames rendered on %s: CPU frame time p50 %.3fms p95 %.3fms, GPU frame time p50 %.3fms p95 %.3fms.",
+                (u32)samples.cpu_frame_ms.size(), get_backend_name(),
+                report["cpu_frame_ms"]["p50"].fnum(), report["cpu_frame_ms"]["p95"].fnum(),
+                report["gpu_frame_ms"]["p50"].fnum(), report["gpu_frame_ms"]["p95"].fnum());
+            if (!options.report_path.empty())
+            {
+                lulet(f, open_file(options.report_path.encode().c_str(), FileOpenFlag::write, FileCreationMode::create_always));
+                luexp(VariantUtils::write_json(f, report));
+            }
+            if (!options.baseline_path.empty())
+            {
+                luset(regressed, check_regression(options, report));
+            }
+        }
+        lucatchret;
+        return regressed;
+    }
+
+    int run_perf_mode(const PerfModeOptions& options)
+    {
+        register_boxed_type<SceneRenderData>();
+        auto r = run_perf_mode_impl(options);
+        if (failed(r))
+        {
+            log_error("Studio", "Performance mode failed: %s", explain(r.errcode()));
+            return 2;
+        }
+        return r.get() ? 1 : 0;
+    }
+}
@@ -0,0 +1,48 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PerfMode.hpp
+* @author JXMaster
+* @date 2024/5/18
+*/
+#pragma once
+#include "SceneRenderer.hpp"
+
+namespace Luna
+{
+    // Options of the performance mode, which renders one scene offscreen without opening any window,
+    // plays back one camera path and writes per-frame CPU and GPU timings to one report.
+    struct PerfModeOptions
+    {
+        // The project folder.
+        Path project_path;
+        // The asset path of the scene to render, relative to the Data folder of the project.
+        Path scene_path;
+        // The platform path of the camera path file recorded by the scene editor. If this is empty, the camera of
+        // the scene is not moved.
+        Path camera_path;
+        // The platform path of the report file. If this is empty, the report is not written.
+        Path report_path;
+        // The platform path of one report written by one earlier run. If not empty, the run fails if the 95th percentile
+        // CPU or GPU frame time exceeds the time in the baseline by more than `regression_tolerance`.
+        Path baseline_path;
+        f64 regression_tolerance = 0.1;
+        // The renderer settings. `frame_profiling` is always enabled.
+        SceneRendererSettings renderer_settings;
+        // The number of frames rendered before measuring, after all assets are loaded.
+        u32 warmup_frames = 60;
+        // The number of frames to measure. If this is `0`, frames are measured until the camera path ends.
+        u32 num_frames = 0;
+        // The simulated time between two frames in seconds, used to sample the camera path. The camera path is
+        // played with fixed time steps so that every run renders the same frames regardless of the frame rate.
+        f64 frame_interval = 1.0 / 60.0;
+        // The maximum time in seconds to wait for assets of the scene to be loaded.
+        f64 asset_load_timeout = 300.0;
+    };
+
+    // Runs the performance mode. Returns the process exit code: `0` on success, `1` if one frame-time regression
+    // is detected, and `2` if the run fails.
+    int run_perf_mode(const PerfModeOptions& options);
+}
@@ -0,0 +1,270 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AutoExposurePass.cpp
+* @author JXMaster
+* @date 2024/5/9
+*/
+#include "AutoExposurePass.hpp"
+#include <Luna/Runtime/File.hpp>
+#include "../StudioHeader.hpp"
+
+namespace Luna
+{
+    RV AutoExposurePassGlobalData::init(RHI::IDevice* device)
+    {
+        using namespace RHI;
+        lutry
+        {
+            // Histogram Clear Pass.
+            {
+                luset(m_histogram_clear_pass_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
+                    DescriptorSetLayoutBinding::read_write_buffer_view(0, 1, ShaderVisibilityFlag::compute)
+                    })));
+                auto dlayout = m_histogram_clear_pass_dlayout.get();
+                luset(m_histogram_clear_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dlayout, 1 },
+                    PipelineLayoutFlag::deny_vertex_shader_access |
+                    PipelineLayoutFlag::deny_pixel_shader_access)));
+
+                lulet(cs_blob, compile_shader("Shaders/LumHistogramClear.hlsl", ShaderCompiler::ShaderType::compute));
+                ComputePipelineStateDesc ps_desc;
+                fill_compute_pipeline_state_desc_from_compile_result(ps_desc, cs_blob);
+                ps_desc.pipeline_layout = m_histogram_clear_pass_playout;
+                luset(m_histogram_clear_pass_pso, device->new_compute_pipeline_state(ps_desc));
+            }
+            // Histogram Lum Pass.
+            {
+                luset(m_histogram_pass_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
+                    DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::compute),
+                    DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 1, 1, ShaderVisibilityFlag::compute),
+                    DescriptorSetLayoutBinding::read_write_buffer_view(2, 1, ShaderVisibilityFlag::compute)
+                    })));
+                auto dlayout = m_histogram_pass_dlayout.get();
+                luset(m_histogram_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dlayout, 1 },
+                    PipelineLayoutFlag::deny_vertex_shader_access |
+                    PipelineLayoutFlag::deny_pixel_shader_access)));
+
+                lulet(cs_blob, compile_shader("Shaders/LumHistogram.hlsl", ShaderCompiler::ShaderType::compute));
+                ComputePipelineStateDesc ps_desc;
+                fill_compute_pipeline_state_desc_from_compile_result(ps_desc, cs_blob);
+                ps_desc.pipeline_layout = m_histogram_pass_playout;
+                luset(m_histogram_pass_pso, device->new_compute_pipeline_state(ps_desc));
+            }
+            // Histogram Collect Pass.
+            {
+                luset(m_histogram_collect_pass_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
+                    DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::compute),
+                    DescriptorSetLayoutBinding::read_write_buffer_view(1, 1, ShaderVisibilityFlag::compute),
+                    DescriptorSetLayoutBinding::read_write_buffer_view(2, 1, ShaderVisibilityFlag::compute)
+                    })));
+                auto dlayout = m_histogram_collect_pass_dlayout.get();
+                luset(m_histogram_collect_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dlayout, 1 },
+                    PipelineLayoutFlag::deny_vertex_shader_access |
+                    PipelineLayoutFlag::deny_pixel_shader_access)));
+
+                lulet(cs_blob, compile_shader("Shaders/LumHistogramCollect.hlsl", ShaderCompiler::ShaderType::compute));
+                ComputePipelineStateDesc ps_desc;
+                fill_compute_pipeline_state_desc_from_compile_result(ps_desc, cs_blob);
+                ps_desc.pipeline_layout = m_histogram_collect_pass_playout;
+                luset(m_histogram_collect_pass_pso, device->new_compute_pipeline_state(ps_desc));
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+    struct LumHistogramParams
+    {
+        u32 src_width;
+        u32 src_height;
+        f32 min_brightness;
+        f32 max_brightness;
+    };
+    struct LumHistogramCollectParams
+    {
+        f32 min_brightness;
+        f32 max_brightness;
+        f32 time_coeff;
+        f32 num_pixels;
+    };
+    RV AutoExposurePass::init(AutoExposurePassGlobalData* global_data)
+    {
+        using namespace RHI;
+        lutry
+        {
+            m_global_data = global_data;
+            auto device = global_data->m_histogram_pass_pso->get_device();
+            luset(m_histogram_clear_ds, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_histogram_clear_pass_dlayout)));
+            luset(m_histogram_ds, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_histogram_pass_dlayout)));
+            luset(m_histogram_collect_ds, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_histogram_collect_pass_dlayout)));
+            auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+            luset(m_histogram_cb, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::uniform_buffer, align_upper(sizeof(LumHistogramParams), cb_align))));
+            luset(m_histogram_collect_cb, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::uniform_buffer, align_upper(sizeof(LumHistogramCollectParams), cb_align))));
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV AutoExposurePass::execute(RG::IRenderPassContext* ctx)
+    {
+        using namespace RHI;
+        lutry
+        {
+            auto cmdbuf = ctx->get_command_buffer();
+            Ref<ITexture> hdr_tex = ctx->get_input("hdr_texture");
+            Ref<IBuffer> luminance_buffer = ctx->get_output("luminance_buffer");
+            auto hdr_tex_desc = hdr_tex->get_desc();
+            auto cb_align = cmdbuf->get_device()->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+            constexpr f32 min_brightness = 0.001f;
+            constexpr f32 max_brightness = 20.0f;
+            // The HDR image holds the image of the last frame only if it is not recreated.
+            bool collect_histogram = enabled && hdr_tex == m_last_hdr_texture;
+            m_last_hdr_texture = hdr_tex;
+            u32 time_query_begin, time_query_end;
+            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            if (!collect_histogram)
+            {
+                // The luminance buffer keeps its last value, only timestamps are written.
+                if (query_heap)
+                {
+                    CopyPassDesc copy_pass;
+                    copy_pass.timestamp_query_heap = query_heap;
+                    copy_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                    copy_pass.timestamp_query_end_pass_write_index = time_query_end;
+                    cmdbuf->begin_copy_pass(copy_pass);
+                    cmdbuf->end_copy_pass();
+                }
+                return ok;
+            }
+            ComputePassDesc compute_pass;
+            if (query_heap)
+            {
+                compute_pass.timestamp_query_heap = query_heap;
+                compute_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                compute_pass.timestamp_query_end_pass_write_index = time_query_end;
+            }
+            cmdbuf->begin_compute_pass(compute_pass);
+            Ref<IBuffer> histogram_buffer;
+            luset(histogram_buffer, ctx->allocate_temporary_resource(RG::ResourceDesc::as_buffer(MemoryType::local, BufferDesc(BufferUsageFlag::read_write_buffer, sizeof(u32) * 256))));
+            cmdbuf->attach_device_object(histogram_buffer);
+            // Histogram Clear Pass.
+            {
+                cmdbuf->set_compute_pipeline_layout(m_global_data->m_histogram_clear_pass_playout);
+                cmdbuf->set_compute_pipeline_state(m_global_data->m_histogram_clear_pass_pso);
+                cmdbuf->resource_barrier({
+                        BufferBarrier(histogram_buffer, BufferStateFlag::automatic, BufferStateFlag::shader_write_cs)
+                    }, {});
+                auto vs = m_histogram_clear_ds.get();
+                luexp(vs->update_descriptors({
+                    WriteDescriptorSet::read_write_buffer_view(0, BufferViewDesc::structured_buffer(histogram_buffer, 0, 256, 4))
+                    }));
+                cmdbuf->set_compute_descriptor_sets(0, { &vs, 1 });
+                cmdbuf->dispatch(1, 1, 1);
+            }
+            // Histogram Lum Pass.
+            {
+                cmdbuf->set_compute_pipeline_layout(m_global_data->m_histogram_pass_playout);
+                cmdbuf->set_compute_pipeline_state(m_global_data->m_histogram_pass_pso);
+                LumHistogramParams* mapped = nullptr;
+                luexp(m_histogram_cb->map(0, 0, (void**)&mapped));
+                mapped->src_width = hdr_tex_desc.width;
+                mapped->src_height = hdr_tex_desc.height;
+                mapped->min_brightness = min_brightness;
+                mapped->max_brightness = max_brightness;
+                m_histogram_cb->unmap(0, sizeof(LumHistogramParams));
+                cmdbuf->resource_barrier({
+                        BufferBarrier(histogram_buffer, BufferStateFlag::shader_write_cs, BufferStateFlag::shader_read_cs | BufferStateFlag::shader_write_cs),
+                        BufferBarrier(m_histogram_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs),
+                    }, {
+                        TextureBarrier(hdr_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs)
+                    });
+                auto vs = m_histogram_ds.get();
+                luexp(vs->update_descriptors({
+                    WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(m_histogram_cb, 0, (u32)align_upper(sizeof(LumHistogramParams), cb_align))),
+                    WriteDescriptorSet::read_texture_view(1, TextureViewDesc::tex2d(hdr_tex)),
+                    WriteDescriptorSet::read_write_buffer_view(2, BufferViewDesc::structured_buffer(histogram_buffer, 0, 256, 4))
+                    }));
+                cmdbuf->set_compute_descriptor_sets(0, { &vs, 1 });
+                cmdbuf->dispatch(align_upper(hdr_tex_desc.width, 16) / 16,
+                    align_upper(hdr_tex_desc.height, 16) / 16, 1);
+            }
+            // Histogram Collect Lum passes.
+            {
+                cmdbuf->set_compute_pipeline_layout(m_global_data->m_histogram_collect_pass_playout);
+                cmdbuf->set_compute_pipeline_state(m_global_data->m_histogram_collect_pass_pso);
+                LumHistogramCollectParams* mapped = nullptr;
+                luexp(m_histogram_collect_cb->map(0, 0, (void**)&mapped));
+                mapped->min_brightness = min_brightness;
+                mapped->max_brightness = max_brightness;
+                mapped->time_coeff = 0.05f;
+                mapped->num_pixels = (f32)((u32)hdr_tex_desc.width * hdr_tex_desc.height);
+                m_histogram_collect_cb->unmap(0, sizeof(LumHistogramCollectParams));
+                cmdbuf->resource_barrier({
+                        BufferBarrier(m_histogram_collect_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs),
+                        BufferBarrier(histogram_buffer, BufferStateFlag::shader_write_cs, BufferStateFlag::shader_read_cs | BufferStateFlag::shader_write_cs),
+                        BufferBarrier(luminance_buffer, BufferStateFlag::automatic, BufferStateFlag::shader_read_cs | BufferStateFlag::shader_write_cs)
+                    }, {});
+                auto vs = m_histogram_collect_ds.get();
+                luexp(vs->update_descriptors({
+                    WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(m_histogram_collect_cb, 0, (u32)align_upper(sizeof(LumHistogramCollectParams), cb_align))),
+                    WriteDescriptorSet::read_write_buffer_view(1, BufferViewDesc::structured_buffer(histogram_buffer, 0, 256, 4)),
+                    WriteDescriptorSet::read_write_buffer_view(2, BufferViewDesc::structured_buffer(luminance_buffer, 0, 1, 4))
+                    }));
+                cmdbuf->set_compute_descriptor_sets(0, { &vs, 1 });
+                cmdbuf->dispatch(1, 1, 1);
+            }
+            cmdbuf->end_compute_pass();
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV compile_auto_exposure_pass(object_t userdata, RG::IRenderGraphCompiler* compiler)
+    {
+        lutry
+        {
+            AutoExposurePassGlobalData* data = (AutoExposurePassGlobalData*)userdata;
+            auto hdr_texture = compiler->get_input_resource("hdr_texture");
+            auto luminance_buffer = compiler->get_output_resource("luminance_buffer");
+
+            if(hdr_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "AutoExposurePass: Input \"hdr_texture\" is not specified.");
+            if(luminance_buffer == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "AutoExposurePass: Output \"luminance_buffer\" is not specified.");
+
+            RG::ResourceDesc desc = compiler->get_resource_desc(luminance_buffer);
+            if (desc.type != RG::ResourceType::buffer || desc.buffer.size < sizeof(f32) || !test_flags(desc.buffer.usages, RHI::BufferUsageFlag::read_write_buffer))
+            {
+                return set_error(BasicError::bad_arguments(), "AutoExposurePass: Invalid format for \"luminance_buffer\" is specified. \"luminance_buffer\" must be one buffer with BufferUsageFlag::read_write_buffer.");
+            }
+            Ref<AutoExposurePass> pass = new_object<AutoExposurePass>();
+            luexp(pass->init(data));
+            compiler->set_render_pass_object(pass);
+        }
+        lucatchret;
+        return ok;
+    }
+    RV register_auto_exposure_pass()
+    {
+        lutry
+        {
+            register_boxed_type<AutoExposurePassGlobalData>();
+            register_boxed_type<AutoExposurePass>();
+            impl_interface_for_type<AutoExposurePass, RG::IRenderPass>();
+            RG::RenderPassTypeDesc desc;
+            desc.name = "AutoExposure";
+            desc.desc = "Adapts the average luminance of the HDR image on GPU.";
+            desc.input_parameters.push_back({"hdr_texture", "The HDR image of the last frame.", RHI::TextureStateFlag::shader_read_cs});
+            desc.output_parameters.push_back({"luminance_buffer", "The buffer that stores the adapted average luminance as one float. "
+                "The luminance is adapted from the value stored in the buffer, so the buffer should be one external resource that is "
+                "initialized to 0 before the first execution. 0 means that the average luminance is not available.",
+                RHI::TextureStateFlag::automatic, RHI::BufferStateFlag::shader_read_cs | RHI::BufferStateFlag::shader_write_cs, false});
+            desc.compile = compile_auto_exposure_pass;
+            auto data = new_object<AutoExposurePassGlobalData>();
+            luexp(data->init(RHI::get_main_device()));
+            desc.userdata = data.object();
+            RG::register_render_pass_type(desc);
+        }
+        lucatchret;
+        return ok;
+    }
+}
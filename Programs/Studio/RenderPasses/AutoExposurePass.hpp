@@ -0,0 +1,62 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AutoExposurePass.hpp
+* @author JXMaster
+* @date 2024/5/9
+*/
+#pragma once
+#include <Luna/RG/RenderPass.hpp>
+
+namespace Luna
+{
+    struct AutoExposurePassGlobalData
+    {
+        lustruct("AutoExposurePassGlobalData", "{b5e0a7c3-2d49-4f18-9c6e-71f3d8a24b90}");
+
+        Ref<RHI::IDescriptorSetLayout> m_histogram_clear_pass_dlayout;
+        Ref<RHI::IPipelineLayout> m_histogram_clear_pass_playout;
+        Ref<RHI::IPipelineState> m_histogram_clear_pass_pso;
+        Ref<RHI::IDescriptorSetLayout> m_histogram_pass_dlayout;
+        Ref<RHI::IPipelineLayout> m_histogram_pass_playout;
+        Ref<RHI::IPipelineState> m_histogram_pass_pso;
+        Ref<RHI::IDescriptorSetLayout> m_histogram_collect_pass_dlayout;
+        Ref<RHI::IPipelineLayout> m_histogram_collect_pass_playout;
+        Ref<RHI::IPipelineState> m_histogram_collect_pass_pso;
+
+        RV init(RHI::IDevice* device);
+    };
+
+    // Builds the luminance histogram of the HDR image and adapts the average luminance stored in the luminance buffer
+    // entirely on GPU. The pass only records compute commands, so it can be executed on the async compute queue.
+    // The HDR image should be one persistent resource that still holds the image of the last frame when this pass
+    // is executed, so that this pass can overlap with the geometry passes of the current frame. The luminance buffer
+    // should be one external resource so that the adapted luminance is kept when the render graph is recompiled.
+    struct AutoExposurePass : RG::IRenderPass
+    {
+        lustruct("AutoExposurePass", "{0d6c94f2-8a1e-4b37-a5c2-e49f1b7d3068}");
+        luiimpl();
+
+        // Whether to update the luminance buffer. If this is `false`, the luminance buffer keeps its last value.
+        bool enabled;
+
+        RV init(AutoExposurePassGlobalData* global_data);
+        RV execute(RG::IRenderPassContext* ctx) override;
+
+        private:
+        Ref<AutoExposurePassGlobalData> m_global_data;
+
+        Ref<RHI::IBuffer> m_histogram_cb;
+        Ref<RHI::IBuffer> m_histogram_collect_cb;
+        Ref<RHI::IDescriptorSet> m_histogram_clear_ds;
+        Ref<RHI::IDescriptorSet> m_histogram_ds;
+        Ref<RHI::IDescriptorSet> m_histogram_collect_ds;
+        // The HDR image read in the last execution. The content of one newly created HDR image is undefined, so
+        // the histogram is not collected in the first execution after the HDR image is recreated.
+        Ref<RHI::ITexture> m_last_hdr_texture;
+    };
+
+    RV register_auto_exposure_pass();
+}
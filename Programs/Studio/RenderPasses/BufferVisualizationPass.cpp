@@ -84,13 +84,7 @@ namespace Luna
             auto device = cmdbuf->get_device();
             auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
             cmdbuf->resource_barrier(
-                { {m_vis_params, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none} },
-                {
-                    {scene_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs | TextureStateFlag::shader_write_cs, ResourceBarrierFlag::discard_content},
-                    {depth_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
-                    {base_color_roughness_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
-                    {normal_metallic_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
-                });
+                { {m_vis_params, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none} }, {});
             luexp(m_ds->update_descriptors({
                 WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(m_vis_params, 0, (u32)align_upper(sizeof(u32), cb_align))),
                 WriteDescriptorSet::read_texture_view(1, TextureViewDesc::tex2d(base_color_roughness_tex)),
@@ -165,10 +159,10 @@ namespace Luna
             RG::RenderPassTypeDesc desc;
             desc.name = "BufferVisualization";
             desc.desc = "Visualize geometry buffer data.";
-            desc.output_parameters.push_back({"scene_texture", "The scene texture."});
-            desc.input_parameters.push_back({"depth_texture", "The scene depth texture"});
-            desc.input_parameters.push_back({"base_color_roughness_texture", "The base color and roughness texture from geometry pass."});
-            desc.input_parameters.push_back({"normal_metallic_texture", "The normal and metallic texture from geometry pass."});
+            desc.output_parameters.push_back({"scene_texture", "The scene texture.", RHI::TextureStateFlag::shader_read_cs | RHI::TextureStateFlag::shader_write_cs, RHI::BufferStateFlag::automatic, true});
+            desc.input_parameters.push_back({"depth_texture", "The scene depth texture", RHI::TextureStateFlag::shader_read_cs});
+            desc.input_parameters.push_back({"base_color_roughness_texture", "The base color and roughness texture from geometry pass.", RHI::TextureStateFlag::shader_read_cs});
+            desc.input_parameters.push_back({"normal_metallic_texture", "The normal and metallic texture from geometry pass.", RHI::TextureStateFlag::shader_read_cs});
             desc.compile = compile_buffer_visualization_pass;
             auto data = new_object<BufferVisualizationPassGlobalData>();
             luexp(data->init(RHI::get_main_device()));
@@ -12,14 +12,15 @@
 
 namespace Luna
 {
+    //! Gets the input attributes of `QuantizedVertex`.
     inline void get_vertex_input_layout_desc(Vector<RHI::InputAttributeDesc>& attributes)
     {
         using namespace RHI;
         attributes.clear();
         attributes.push_back(InputAttributeDesc("POSITION", 0, 0, 0, 0, Format::rgb32_float));
-        attributes.push_back(InputAttributeDesc("NORMAL", 0, 1, 0, 12, Format::rgb32_float));
-        attributes.push_back(InputAttributeDesc("TANGENT", 0, 2, 0, 24, Format::rgb32_float));
-        attributes.push_back(InputAttributeDesc("TEXCOORD", 0, 3, 0, 36, Format::rg32_float));
-        attributes.push_back(InputAttributeDesc("COLOR", 0, 4, 0, 44, Format::rgba32_float));
+        attributes.push_back(InputAttributeDesc("NORMAL", 0, 1, 0, 12, Format::rgba16_snorm));
+        attributes.push_back(InputAttributeDesc("TANGENT", 0, 2, 0, 20, Format::rgba16_snorm));
+        attributes.push_back(InputAttributeDesc("TEXCOORD", 0, 3, 0, 28, Format::rg16_float));
+        attributes.push_back(InputAttributeDesc("COLOR", 0, 4, 0, 32, Format::rgba8_unorm));
     }
 }
\ No newline at end of file
@@ -12,8 +12,30 @@
 #include "../SceneRenderer.hpp"
 #include "../StudioHeader.hpp"
 #include <Luna/RHI/Utility.hpp>
+#include <Luna/Asset/DerivedDataCache.hpp>
 namespace Luna
 {
+    constexpr const c8* INTEGRATE_BRDF_COOKER = "IntegrateBRDF";
+    constexpr u32 INTEGRATE_BRDF_COOKER_VERSION = 1;
+
+    // The integrate BRDF texture only depends on its size and the shader code that computes it, so they are used as the
+    // source data of the derived data key, and the texture is computed again only if the shader code is changed.
+    static Vector<byte_t> get_integrate_brdf_source_data(u32 size)
+    {
+        Vector<byte_t> data;
+        data.insert(data.end(), (const byte_t*)&size, (const byte_t*)&size + sizeof(u32));
+        const c8* source_files[] = { "Shaders/PrecomputeIntegrateBRDF.hlsl", "Shaders/IBLCommon.hlsl", "Shaders/Common.hlsl" };
+        for (const c8* path : source_files)
+        {
+            auto f = open_file(path, FileOpenFlag::read, FileCreationMode::open_existing);
+            if (failed(f)) continue;
+            usize offset = data.size();
+            data.resize(offset + (usize)f.get()->get_size());
+            if (failed(f.get()->read(data.data() + offset, data.size() - offset))) data.resize(offset);
+        }
+        return data;
+    }
+
     RV DeferredLightingPassGlobalData::init(RHI::IDevice* device)
     {
         using namespace RHI;
@@ -30,7 +52,12 @@ namespace Luna
                         DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 7, 1, ShaderVisibilityFlag::compute),
                         DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 8, 1, ShaderVisibilityFlag::compute),
                         DescriptorSetLayoutBinding::read_write_texture_view(TextureViewType::tex2d, 9, 1, ShaderVisibilityFlag::compute),
-                        DescriptorSetLayoutBinding::sampler(10, 1, ShaderVisibilityFlag::compute)
+                        DescriptorSetLayoutBinding::sampler(10, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_buffer_view(11, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_buffer_view(12, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2darray, 13, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_buffer_view(14, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::sampler(15, 1, ShaderVisibilityFlag::compute)
                         })));
             auto dlayout = m_deferred_lighting_pass_dlayout.get();
             luset(m_deferred_lighting_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dlayout, 1 },
@@ -46,15 +73,32 @@ namespace Luna
 
             luset(m_default_skybox, device->new_texture(MemoryType::local, TextureDesc::tex2d(Format::rgba8_unorm, 
                 TextureUsageFlag::read_texture | TextureUsageFlag::copy_dest, 1, 1, 1, 1)));
+            luset(m_default_shadow_atlas, device->new_texture(MemoryType::local, TextureDesc::tex2d(Format::d32_float,
+                TextureUsageFlag::read_texture | TextureUsageFlag::depth_stencil_attachment, 1, 1, 1, 1)));
+            luset(m_default_shadow_matrices, device->new_buffer(MemoryType::local, BufferDesc(BufferUsageFlag::read_buffer, sizeof(Float4x4))));
             u8 skybox_data[] = {0, 0, 0, 0};
             lulet(upload_cmdbuf, device->new_command_buffer(g_env->async_copy_queue));
             luexp(copy_resource_data(upload_cmdbuf, {CopyResourceData::write_texture(m_default_skybox, SubresourceIndex(0, 0), 0, 0, 0, skybox_data, 4, 4, 1, 1, 1)}));
 
-            // Generate integrate brdf.
-            constexpr usize INTEGEATE_BRDF_SIZE = 256;
+            // Generate integrate brdf. The texture is loaded from the derived data cache if it has been computed before.
+            constexpr u32 INTEGEATE_BRDF_SIZE = 256;
+            constexpr u32 INTEGEATE_BRDF_ROW_PITCH = INTEGEATE_BRDF_SIZE * 4;
+            constexpr u32 INTEGEATE_BRDF_DATA_SIZE = INTEGEATE_BRDF_ROW_PITCH * INTEGEATE_BRDF_SIZE;
+            luset(m_integrate_brdf, device->new_texture(MemoryType::local, TextureDesc::tex2d(Format::rgba8_unorm,
+                TextureUsageFlag::read_texture | TextureUsageFlag::read_write_texture | TextureUsageFlag::copy_source | TextureUsageFlag::copy_dest, 
+                INTEGEATE_BRDF_SIZE, INTEGEATE_BRDF_SIZE, 1, 1)));
+            Vector<byte_t> integrate_brdf_source = get_integrate_brdf_source_data(INTEGEATE_BRDF_SIZE);
+            Name integrate_brdf_key = Asset::get_derived_data_key(INTEGRATE_BRDF_COOKER, INTEGRATE_BRDF_COOKER_VERSION, 
+                { integrate_brdf_source.data(), integrate_brdf_source.size() });
+            auto cached_integrate_brdf = Asset::get_derived_data(integrate_brdf_key);
+            if (succeeded(cached_integrate_brdf) && cached_integrate_brdf.get()->get_size() == INTEGEATE_BRDF_DATA_SIZE)
+            {
+                lulet(brdf_upload_cmdbuf, device->new_command_buffer(g_env->async_copy_queue));
+                luexp(copy_resource_data(brdf_upload_cmdbuf, {CopyResourceData::write_texture(m_integrate_brdf, SubresourceIndex(0, 0), 0, 0, 0, 
+                    cached_integrate_brdf.get()->get_data(), INTEGEATE_BRDF_ROW_PITCH, INTEGEATE_BRDF_DATA_SIZE, INTEGEATE_BRDF_SIZE, INTEGEATE_BRDF_SIZE, 1)}));
+            }
+            else
             {
-                luset(m_integrate_brdf, device->new_texture(MemoryType::local, TextureDesc::tex2d(Format::rgba8_unorm,
-                    TextureUsageFlag::read_texture | TextureUsageFlag::read_write_texture, INTEGEATE_BRDF_SIZE, INTEGEATE_BRDF_SIZE, 1, 1)));
                 lulet(dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
                         DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::compute),
                         DescriptorSetLayoutBinding::read_write_texture_view(TextureViewType::tex2d, 1, 1, ShaderVisibilityFlag::compute) })));
@@ -91,6 +135,12 @@ namespace Luna
                 compute_cmdbuf->end_compute_pass();
                 luexp(compute_cmdbuf->submit({}, {}, true));
                 compute_cmdbuf->wait();
+                // Failing to store the texture only causes the texture to be computed again in the next run.
+                Vector<byte_t> integrate_brdf_data(INTEGEATE_BRDF_DATA_SIZE);
+                lulet(readback_cmdbuf, device->new_command_buffer(g_env->async_copy_queue));
+                luexp(copy_resource_data(readback_cmdbuf, {CopyResourceData::read_texture(integrate_brdf_data.data(), INTEGEATE_BRDF_ROW_PITCH, 
+                    INTEGEATE_BRDF_DATA_SIZE, m_integrate_brdf, SubresourceIndex(0, 0), 0, 0, 0, INTEGEATE_BRDF_SIZE, INTEGEATE_BRDF_SIZE, 1)}));
+                auto _ = Asset::put_derived_data(integrate_brdf_key, { integrate_brdf_data.data(), integrate_brdf_data.size() });
             }
         }
         lucatchret;
@@ -100,6 +150,11 @@ namespace Luna
     {
         u32 lighting_mode;
         u32 num_lights;
+        u32 cluster_count_x;
+        u32 cluster_count_y;
+        f32 slice_scale;
+        f32 slice_bias;
+        u32 shadows_enabled;
     };
     RV DeferredLightingPass::init(DeferredLightingPassGlobalData* global_data)
     {
@@ -123,16 +178,33 @@ namespace Luna
         lutry
         {
             u32 num_lights = light_ts.empty() ? 1 : (u32)light_ts.size();
+            Ref<ITexture> shadow_atlas = ctx->get_input("shadow_atlas");
+            Ref<IBuffer> shadow_tile_matrices = shadow_matrices;
+            bool shadows_enabled = shadow_atlas && shadow_tile_matrices;
             LightingParamsCB* mapped = nullptr;
             luexp(m_lighting_params_cb->map(0, 0, (void**)&mapped));
             mapped->lighting_mode = lighting_mode;
             mapped->num_lights = num_lights;
+            mapped->cluster_count_x = cluster_params.cluster_count.x;
+            mapped->cluster_count_y = cluster_params.cluster_count.y;
+            mapped->slice_scale = cluster_params.slice_scale;
+            mapped->slice_bias = cluster_params.slice_bias;
+            mapped->shadows_enabled = shadows_enabled ? 1 : 0;
             m_lighting_params_cb->unmap(0, sizeof(LightingParamsCB));
             Ref<ITexture> scene_tex = ctx->get_output("scene_texture");
             Ref<ITexture> depth_tex = ctx->get_input("depth_texture");
             Ref<ITexture> base_color_roughness_tex = ctx->get_input("base_color_roughness_texture");
             Ref<ITexture> normal_metallic_tex = ctx->get_input("normal_metallic_texture");
             Ref<ITexture> emissive_tex = ctx->get_input("emissive_texture");
+            Ref<IBuffer> light_grid = ctx->get_input("light_grid");
+            Ref<IBuffer> light_indices = ctx->get_input("light_indices");
+            if (!shadows_enabled)
+            {
+                shadow_atlas = m_global_data->m_default_shadow_atlas;
+                shadow_tile_matrices = m_global_data->m_default_shadow_matrices;
+            }
+            u32 num_shadow_tiles = (u32)(shadow_tile_matrices->get_desc().size / sizeof(Float4x4));
+            u32 num_clusters = cluster_params.cluster_count.x * cluster_params.cluster_count.y * cluster_params.cluster_count.z;
             auto cmdbuf = ctx->get_command_buffer();
             auto device = cmdbuf->get_device();
             auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
@@ -151,7 +223,8 @@ namespace Luna
                 { 
                     {camera_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none},
                     {m_lighting_params_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none},
-                    {light_params, BufferStateFlag::automatic, BufferStateFlag::shader_read_cs, ResourceBarrierFlag::none}
+                    {light_params, BufferStateFlag::automatic, BufferStateFlag::shader_read_cs, ResourceBarrierFlag::none},
+                    {shadow_tile_matrices, BufferStateFlag::automatic, BufferStateFlag::shader_read_cs, ResourceBarrierFlag::none}
                 },
                 {
                     {scene_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs | TextureStateFlag::shader_write_cs, ResourceBarrierFlag::none},
@@ -161,11 +234,12 @@ namespace Luna
                     {emissive_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
                     {sky_box, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
                     {m_global_data->m_integrate_brdf, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
+                    {shadow_atlas, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
                 });
             luexp(m_ds->update_descriptors({
                 WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(camera_cb, 0, (u32)align_upper(sizeof(CameraCB), cb_align))),
                 WriteDescriptorSet::uniform_buffer_view(1, BufferViewDesc::uniform_buffer(m_lighting_params_cb, 0, (u32)align_upper(sizeof(LightingParamsCB), cb_align))),
-                WriteDescriptorSet::read_buffer_view(2, BufferViewDesc::structured_buffer(light_params, 0, num_lights, sizeof(LightingParams))),
+                WriteDescriptorSet::read_buffer_view(2, BufferViewDesc::structured_buffer(light_params, light_params_first_element, num_lights, sizeof(LightingParams))),
                 WriteDescriptorSet::read_texture_view(3, TextureViewDesc::tex2d(base_color_roughness_tex)),
                 WriteDescriptorSet::read_texture_view(4, TextureViewDesc::tex2d(normal_metallic_tex)),
                 WriteDescriptorSet::read_texture_view(5, TextureViewDesc::tex2d(emissive_tex)),
@@ -174,6 +248,12 @@ namespace Luna
                 WriteDescriptorSet::read_texture_view(8, TextureViewDesc::tex2d(m_global_data->m_integrate_brdf)),
                 WriteDescriptorSet::read_write_texture_view(9, TextureViewDesc::tex2d(scene_tex)),
                 WriteDescriptorSet::sampler(10, SamplerDesc(Filter::linear, Filter::linear, Filter::linear, TextureAddressMode::clamp, TextureAddressMode::clamp, TextureAddressMode::clamp)),
+                WriteDescriptorSet::read_buffer_view(11, BufferViewDesc::structured_buffer(light_grid, 0, num_clusters, sizeof(u32))),
+                WriteDescriptorSet::read_buffer_view(12, BufferViewDesc::structured_buffer(light_indices, 0, num_clusters * MAX_LIGHTS_PER_CLUSTER, sizeof(u32))),
+                WriteDescriptorSet::read_texture_view(13, TextureViewDesc::tex2darray(shadow_atlas, Format::d32_float, 0, 1)),
+                WriteDescriptorSet::read_buffer_view(14, BufferViewDesc::structured_buffer(shadow_tile_matrices, 0, num_shadow_tiles, sizeof(Float4x4))),
+                WriteDescriptorSet::sampler(15, SamplerDesc(Filter::linear, Filter::linear, Filter::nearest, TextureAddressMode::clamp, TextureAddressMode::clamp, TextureAddressMode::clamp,
+                    false, 1, BorderColor::float_0000, 0.0f, F32_MAX, true, CompareFunction::less_equal)),
                 }));
             auto scene_desc = scene_tex->get_desc();
             cmdbuf->set_compute_pipeline_layout(m_global_data->m_deferred_lighting_pass_playout);
@@ -197,11 +277,15 @@ namespace Luna
             auto base_color_roughness_texture = compiler->get_input_resource("base_color_roughness_texture");
             auto normal_metallic_texture = compiler->get_input_resource("normal_metallic_texture");
             auto emissive_texture = compiler->get_input_resource("emissive_texture");
+            auto light_grid = compiler->get_input_resource("light_grid");
+            auto light_indices = compiler->get_input_resource("light_indices");
             if(scene_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Output \"scene_texture\" is not specified.");
             if(depth_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Input \"depth_texture\" is not specified.");
             if(base_color_roughness_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Input \"base_color_roughness_texture\" is not specified.");
             if(normal_metallic_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Input \"normal_metallic_texture\" is not specified.");
             if(emissive_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Input \"emissive_texture\" is not specified.");
+            if(light_grid == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Input \"light_grid\" is not specified.");
+            if(light_indices == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Input \"light_indices\" is not specified.");
             RG::ResourceDesc desc = compiler->get_resource_desc(scene_texture);
             if (desc.texture.format != RHI::Format::rgba32_float)
             {
@@ -230,6 +314,27 @@ namespace Luna
             desc.texture.usages |= RHI::TextureUsageFlag::read_texture;
             compiler->set_resource_desc(emissive_texture, desc);
 
+            desc = compiler->get_resource_desc(light_grid);
+            desc.buffer.usages |= RHI::BufferUsageFlag::read_buffer;
+            compiler->set_resource_desc(light_grid, desc);
+
+            desc = compiler->get_resource_desc(light_indices);
+            desc.buffer.usages |= RHI::BufferUsageFlag::read_buffer;
+            compiler->set_resource_desc(light_indices, desc);
+
+            // The shadow atlas is optional, lights are not shadowed if it is not specified.
+            auto shadow_atlas = compiler->get_input_resource("shadow_atlas");
+            if (shadow_atlas != RG::INVALID_RESOURCE)
+            {
+                desc = compiler->get_resource_desc(shadow_atlas);
+                if (desc.texture.format != RHI::Format::d32_float)
+                {
+                    return set_error(BasicError::bad_arguments(), "DeferredLightingPass: Invalid format for \"shadow_atlas\" is specified. \"shadow_atlas\" must be Format::d32_float.");
+                }
+                desc.texture.usages |= RHI::TextureUsageFlag::read_texture;
+                compiler->set_resource_desc(shadow_atlas, desc);
+            }
+
             Ref<DeferredLightingPass> pass = new_object<DeferredLightingPass>();
             luexp(pass->init(data));
             compiler->set_render_pass_object(pass);
@@ -253,6 +358,12 @@ namespace Luna
             desc.input_parameters.push_back({"base_color_roughness_texture", "The base color and roughness texture from geometry pass."});
             desc.input_parameters.push_back({"normal_metallic_texture", "The normal and metallic texture from geometry pass."});
             desc.input_parameters.push_back({"emissive_texture", "The emissive texture from geometry pass."});
+            desc.input_parameters.push_back({"light_grid", "The number of lights of every cluster from light culling pass.",
+                RHI::TextureStateFlag::automatic, RHI::BufferStateFlag::shader_read_cs});
+            desc.input_parameters.push_back({"light_indices", "The light indices of every cluster from light culling pass.",
+                RHI::TextureStateFlag::automatic, RHI::BufferStateFlag::shader_read_cs});
+            desc.input_parameters.push_back({"shadow_atlas", "The shadow atlas from shadow pass. Lights are not shadowed if this is not specified.",
+                RHI::TextureStateFlag::shader_read_cs, RHI::BufferStateFlag::automatic});
             desc.compile = compile_deferred_lighting_pass;
             auto data = new_object<DeferredLightingPassGlobalData>();
             luexp(data->init(RHI::get_main_device()));
@@ -10,6 +10,7 @@
 #pragma once
 #include <Luna/RG/RenderPass.hpp>
 #include "../Scene.hpp"
+#include "LightCullingPass.hpp"
 
 namespace Luna
 {
@@ -25,6 +26,10 @@ namespace Luna
 
         Ref<RHI::ITexture> m_integrate_brdf;
 
+        // Bound if shadows are not rendered. Tile ranges of lights are ignored in such case, so they are never sampled.
+        Ref<RHI::ITexture> m_default_shadow_atlas;
+        Ref<RHI::IBuffer> m_default_shadow_matrices;
+
         RV init(RHI::IDevice* device);
     };
 
@@ -35,10 +40,14 @@ namespace Luna
 
         Ref<RHI::ITexture> skybox;
         u32 lighting_mode;
+        LightClusterParams cluster_params;
 
-        Span<Ref<Entity>> light_ts;
+        Span<BorrowedRef<Entity>> light_ts;
         Ref<RHI::IBuffer> camera_cb;
         Ref<RHI::IBuffer> light_params;
+        u64 light_params_first_element = 0;
+        // The world-to-projection matrix of every tile of the shadow atlas. Ignored if "shadow_atlas" is not connected.
+        Ref<RHI::IBuffer> shadow_matrices;
 
         RV init(DeferredLightingPassGlobalData* global_data);
         RV execute(RG::IRenderPassContext* ctx) override;
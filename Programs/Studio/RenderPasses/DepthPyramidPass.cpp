@@ -0,0 +1,275 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DepthPyramidPass.cpp
+* @author JXMaster
+* @date 2024/4/12
+*/
+#include "DepthPyramidPass.hpp"
+#include <Luna/Runtime/File.hpp>
+#include "../StudioHeader.hpp"
+
+namespace Luna
+{
+    struct DepthPyramidParams
+    {
+        UInt2U src_size;
+        UInt2U dst_size;
+    };
+
+    bool DepthPyramidReadback::is_visible(const Float3& bounding_box_min, const Float3& bounding_box_max, const Float4x4& local_to_world) const
+    {
+        if (!valid()) return true;
+        Float4x4 local_to_proj = mul(local_to_world, Float4x4(world_to_proj));
+        f32 min_x = F32_MAX, min_y = F32_MAX, min_z = F32_MAX;
+        f32 max_x = -F32_MAX, max_y = -F32_MAX;
+        for (u32 i = 0; i < 8; ++i)
+        {
+            Float4 corner(
+                (i & 1) ? bounding_box_max.x : bounding_box_min.x,
+                (i & 2) ? bounding_box_max.y : bounding_box_min.y,
+                (i & 4) ? bounding_box_max.z : bounding_box_min.z, 1.0f);
+            Float4 p = mul(corner, local_to_proj);
+            // The bounding box intersects the near plane, treat it as visible.
+            if (p.w <= 0.0f) return true;
+            f32 x = p.x / p.w;
+            f32 y = p.y / p.w;
+            f32 z = p.z / p.w;
+            min_x = min(min_x, x);
+            min_y = min(min_y, y);
+            min_z = min(min_z, z);
+            max_x = max(max_x, x);
+            max_y = max(max_y, y);
+        }
+        // Frustum test.
+        if (max_x < -1.0f || min_x > 1.0f || max_y < -1.0f || min_y > 1.0f || min_z > 1.0f) return false;
+        // Converts the bounding rectangle from NDC to texels. The Y axis is flipped in texture space.
+        i32 begin_x = clamp((i32)((min_x * 0.5f + 0.5f) * width), 0, (i32)width - 1);
+        i32 end_x = clamp((i32)((max_x * 0.5f + 0.5f) * width), 0, (i32)width - 1);
+        i32 begin_y = clamp((i32)((0.5f - max_y * 0.5f) * height), 0, (i32)height - 1);
+        i32 end_y = clamp((i32)((0.5f - min_y * 0.5f) * height), 0, (i32)height - 1);
+        for (i32 y = begin_y; y <= end_y; ++y)
+        {
+            for (i32 x = begin_x; x <= end_x; ++x)
+            {
+                if (min_z <= depths[y * width + x]) return true;
+            }
+        }
+        return false;
+    }
+    RV DepthPyramidPassGlobalData::init(RHI::IDevice* device)
+    {
+        using namespace RHI;
+        lutry
+        {
+            luset(m_depth_pyramid_pass_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
+                        DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 1, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_write_texture_view(TextureViewType::tex2d, 2, 1, ShaderVisibilityFlag::compute)
+                        })));
+            auto dlayout = m_depth_pyramid_pass_dlayout.get();
+            luset(m_depth_pyramid_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dlayout, 1 },
+                PipelineLayoutFlag::deny_vertex_shader_access |
+                PipelineLayoutFlag::deny_pixel_shader_access)));
+
+            lulet(cs_blob, compile_shader("Shaders/DepthPyramidCS.hlsl", ShaderCompiler::ShaderType::compute));
+
+            ComputePipelineStateDesc ps_desc;
+            fill_compute_pipeline_state_desc_from_compile_result(ps_desc, cs_blob);
+            ps_desc.pipeline_layout = m_depth_pyramid_pass_playout;
+            luset(m_depth_pyramid_pass_pso, device->new_compute_pipeline_state(ps_desc));
+        }
+        lucatchret;
+        return ok;
+    }
+    RV DepthPyramidPass::init(DepthPyramidPassGlobalData* global_data)
+    {
+        m_global_data = global_data;
+        return ok;
+    }
+    RV DepthPyramidPass::execute(RG::IRenderPassContext* ctx)
+    {
+        using namespace RHI;
+        lutry
+        {
+            Ref<ITexture> depth_tex = ctx->get_input("depth_texture");
+            Ref<ITexture> pyramid_tex = ctx->get_output("depth_pyramid");
+            auto depth_desc = depth_tex->get_desc();
+            auto pyramid_desc = pyramid_tex->get_desc();
+            auto cmdbuf = ctx->get_command_buffer();
+            auto device = cmdbuf->get_device();
+            auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+            usize cb_size = align_upper(sizeof(DepthPyramidParams), cb_align);
+            if (m_ds.size() != pyramid_desc.mip_levels)
+            {
+                m_ds.clear();
+                for (u32 i = 0; i < pyramid_desc.mip_levels; ++i)
+                {
+                    lulet(ds, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_depth_pyramid_pass_dlayout)));
+                    m_ds.push_back(ds);
+                }
+                luset(m_pyramid_params, device->new_buffer(MemoryType::upload,
+                    BufferDesc(BufferUsageFlag::uniform_buffer, cb_size * pyramid_desc.mip_levels)));
+            }
+            // Selects the first level that is small enough to be read back.
+            u32 readback_mip = 0;
+            while (readback_mip + 1 < pyramid_desc.mip_levels &&
+                max(max<u32>(pyramid_desc.width >> readback_mip, 1), max<u32>(pyramid_desc.height >> readback_mip, 1)) > READBACK_MAX_SIZE)
+            {
+                ++readback_mip;
+            }
+            u32 readback_width = max<u32>(pyramid_desc.width >> readback_mip, 1);
+            u32 readback_height = max<u32>(pyramid_desc.height >> readback_mip, 1);
+            u64 readback_size, readback_row_pitch, readback_slice_pitch;
+            device->get_texture_data_placement_info(readback_width, readback_height, 1, Format::r32_float,
+                &readback_size, nullptr, &readback_row_pitch, &readback_slice_pitch);
+            if (!m_readback_buffer || m_readback_buffer->get_desc().size < readback_size)
+            {
+                luset(m_readback_buffer, device->new_buffer(MemoryType::readback, BufferDesc(BufferUsageFlag::copy_dest, readback_size)));
+            }
+            DepthPyramidParams* mapped = nullptr;
+            luexp(m_pyramid_params->map(0, 0, (void**)&mapped));
+            for (u32 i = 0; i < pyramid_desc.mip_levels; ++i)
+            {
+                DepthPyramidParams* params = (DepthPyramidParams*)((usize)mapped + cb_size * i);
+                params->src_size = i == 0 ? UInt2U(depth_desc.width, depth_desc.height) :
+                    UInt2U(max<u32>(pyramid_desc.width >> (i - 1), 1), max<u32>(pyramid_desc.height >> (i - 1), 1));
+                params->dst_size = UInt2U(max<u32>(pyramid_desc.width >> i, 1), max<u32>(pyramid_desc.height >> i, 1));
+            }
+            m_pyramid_params->unmap(0, cb_size * pyramid_desc.mip_levels);
+
+            ComputePassDesc compute_pass;
+            u32 time_query_begin, time_query_end;
+            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            if(query_heap)
+            {
+                compute_pass.timestamp_query_heap = query_heap;
+                compute_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                compute_pass.timestamp_query_end_pass_write_index = time_query_end;
+            }
+            cmdbuf->begin_compute_pass(compute_pass);
+            cmdbuf->set_compute_pipeline_layout(m_global_data->m_depth_pyramid_pass_playout);
+            cmdbuf->set_compute_pipeline_state(m_global_data->m_depth_pyramid_pass_pso);
+            for (u32 i = 0; i < pyramid_desc.mip_levels; ++i)
+            {
+                u32 dst_width = max<u32>(pyramid_desc.width >> i, 1);
+                u32 dst_height = max<u32>(pyramid_desc.height >> i, 1);
+                ITexture* src_tex = i == 0 ? depth_tex.get() : pyramid_tex.get();
+                u32 src_mip = i == 0 ? 0 : i - 1;
+                cmdbuf->resource_barrier(
+                    { {m_pyramid_params, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none} },
+                    {
+                        {src_tex, SubresourceIndex(src_mip, 0), TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none},
+                        {pyramid_tex, SubresourceIndex(i, 0), TextureStateFlag::automatic, TextureStateFlag::shader_write_cs, ResourceBarrierFlag::discard_content},
+                    });
+                luexp(m_ds[i]->update_descriptors({
+                    WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(m_pyramid_params, cb_size * i, (u32)cb_size)),
+                    WriteDescriptorSet::read_texture_view(1, TextureViewDesc::tex2d(src_tex, Format::unknown, src_mip, 1)),
+                    WriteDescriptorSet::read_write_texture_view(2, TextureViewDesc::tex2d(pyramid_tex, Format::unknown, i, 1))
+                    }));
+                cmdbuf->set_compute_descriptor_set(0, m_ds[i]);
+                cmdbuf->dispatch((u32)align_upper(dst_width, 8) / 8, (u32)align_upper(dst_height, 8) / 8, 1);
+            }
+            cmdbuf->end_compute_pass();
+
+            m_last_world_to_proj = world_to_proj;
+            m_executed = true;
+            if (!readback_enabled) return ok;
+
+            // Copies the selected level to the readback buffer.
+            cmdbuf->begin_copy_pass();
+            cmdbuf->resource_barrier(
+                { {m_readback_buffer, BufferStateFlag::automatic, BufferStateFlag::copy_dest, ResourceBarrierFlag::none} },
+                { {pyramid_tex, SubresourceIndex(readback_mip, 0), TextureStateFlag::automatic, TextureStateFlag::copy_source, ResourceBarrierFlag::none} });
+            cmdbuf->copy_texture_to_buffer(m_readback_buffer, 0, (u32)readback_row_pitch, (u32)readback_slice_pitch,
+                pyramid_tex, SubresourceIndex(readback_mip, 0), 0, 0, 0, readback_width, readback_height, 1);
+            cmdbuf->end_copy_pass();
+            m_readback_width = readback_width;
+            m_readback_height = readback_height;
+            m_readback_row_pitch = readback_row_pitch;
+            m_readback_pending = true;
+        }
+        lucatchret;
+        return ok;
+    }
+    RV DepthPyramidPass::read_back()
+    {
+        lutry
+        {
+            if (!m_readback_pending) return ok;
+            m_readback_pending = false;
+            usize size = (usize)(m_readback_row_pitch * m_readback_height);
+            const byte_t* mapped = nullptr;
+            luexp(m_readback_buffer->map(0, size, (void**)&mapped));
+            m_readback.depths.resize((usize)m_readback_width * m_readback_height);
+            for (u32 y = 0; y < m_readback_height; ++y)
+            {
+                memcpy(m_readback.depths.data() + (usize)y * m_readback_width, mapped + m_readback_row_pitch * y, sizeof(f32) * m_readback_width);
+            }
+            m_readback_buffer->unmap(0, 0);
+            m_readback.width = m_readback_width;
+            m_readback.height = m_readback_height;
+            m_readback.world_to_proj = m_last_world_to_proj;
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV compile_depth_pyramid_pass(object_t userdata, RG::IRenderGraphCompiler* compiler)
+    {
+        lutry
+        {
+            DepthPyramidPassGlobalData* data = (DepthPyramidPassGlobalData*)userdata;
+            auto depth_texture = compiler->get_input_resource("depth_texture");
+            auto depth_pyramid = compiler->get_output_resource("depth_pyramid");
+            if(depth_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DepthPyramidPass: Input \"depth_texture\" is not specified.");
+            if(depth_pyramid == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "DepthPyramidPass: Output \"depth_pyramid\" is not specified.");
+            RG::ResourceDesc depth_desc = compiler->get_resource_desc(depth_texture);
+            if (depth_desc.type != RG::ResourceType::texture || depth_desc.texture.type != RHI::TextureType::tex2d || depth_desc.texture.format != RHI::Format::d32_float)
+            {
+                return set_error(BasicError::bad_arguments(), "DepthPyramidPass: Input \"depth_texture\" must be 2D texture with Format::d32_float.");
+            }
+            depth_desc.texture.usages |= RHI::TextureUsageFlag::read_texture;
+            compiler->set_resource_desc(depth_texture, depth_desc);
+
+            RG::ResourceDesc pyramid_desc = compiler->get_resource_desc(depth_pyramid);
+            pyramid_desc.type = RG::ResourceType::texture;
+            pyramid_desc.texture.type = RHI::TextureType::tex2d;
+            pyramid_desc.texture.format = RHI::Format::r32_float;
+            if(!pyramid_desc.texture.width) pyramid_desc.texture.width = depth_desc.texture.width;
+            if(!pyramid_desc.texture.height) pyramid_desc.texture.height = depth_desc.texture.height;
+            pyramid_desc.texture.usages |= RHI::TextureUsageFlag::read_texture | RHI::TextureUsageFlag::read_write_texture | RHI::TextureUsageFlag::copy_source;
+            compiler->set_resource_desc(depth_pyramid, pyramid_desc);
+
+            Ref<DepthPyramidPass> pass = new_object<DepthPyramidPass>();
+            luexp(pass->init(data));
+            compiler->set_render_pass_object(pass);
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV register_depth_pyramid_pass()
+    {
+        lutry
+        {
+            register_boxed_type<DepthPyramidPassGlobalData>();
+            register_boxed_type<DepthPyramidPass>();
+            impl_interface_for_type<DepthPyramidPass, RG::IRenderPass>();
+            RG::RenderPassTypeDesc desc;
+            desc.name = "DepthPyramid";
+            desc.desc = "Builds one depth pyramid that stores the farthest depth of every region for occlusion culling.";
+            desc.input_parameters.push_back({"depth_texture", "The scene depth texture.", RHI::TextureStateFlag::shader_read_cs});
+            desc.output_parameters.push_back({"depth_pyramid", "The depth pyramid texture."});
+            desc.compile = compile_depth_pyramid_pass;
+            auto data = new_object<DepthPyramidPassGlobalData>();
+            luexp(data->init(RHI::get_main_device()));
+            desc.userdata = data.object();
+            RG::register_render_pass_type(desc);
+        }
+        lucatchret;
+        return ok;
+    }
+}
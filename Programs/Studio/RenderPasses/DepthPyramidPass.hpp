@@ -0,0 +1,96 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file DepthPyramidPass.hpp
+* @author JXMaster
+* @date 2024/4/12
+*/
+#pragma once
+#include <Luna/RG/RenderPass.hpp>
+#include "../Scene.hpp"
+
+namespace Luna
+{
+    struct DepthPyramidPassGlobalData
+    {
+        lustruct("DepthPyramidPassGlobalData", "{5c7e1f3a-94d2-4b6e-8a0f-2d3b6c9e41a7}");
+
+        Ref<RHI::IPipelineState> m_depth_pyramid_pass_pso;
+        Ref<RHI::IDescriptorSetLayout> m_depth_pyramid_pass_dlayout;
+        Ref<RHI::IPipelineLayout> m_depth_pyramid_pass_playout;
+
+        RV init(RHI::IDevice* device);
+    };
+
+    //! The CPU copy of one depth pyramid level, used to test the visibility of bounding boxes (hierarchical-Z occlusion culling).
+    struct DepthPyramidReadback
+    {
+        //! The width of the depth data.
+        u32 width = 0;
+        //! The height of the depth data.
+        u32 height = 0;
+        //! The farthest depth of every region of the screen, in row-major order.
+        Vector<f32> depths;
+        //! The world-to-projection matrix used to render the depth data.
+        Float4x4U world_to_proj;
+
+        //! Checks whether this readback contains valid depth data.
+        bool valid() const { return width && height; }
+        //! Tests whether one bounding box may be visible.
+        //! @param[in] bounding_box_min The minimum point of the bounding box in local space.
+        //! @param[in] bounding_box_max The maximum point of the bounding box in local space.
+        //! @param[in] local_to_world The local-to-world matrix of the bounding box.
+        //! @return Returns `false` if the bounding box is outside the view frustum or behind the depth data.
+        //! Returns `true` otherwise.
+        bool is_visible(const Float3& bounding_box_min, const Float3& bounding_box_max, const Float4x4& local_to_world) const;
+    };
+
+    //! Builds one depth pyramid from the scene depth texture, where every texel of every mip stores the farthest depth of
+    //! the corresponding region in the depth texture. One small mip of the pyramid is read back to CPU for occlusion culling,
+    //! the pyramid texture can also be read by GPU culling shaders of the next frame directly.
+    struct DepthPyramidPass : RG::IRenderPass
+    {
+        lustruct("DepthPyramidPass", "{e2a94b61-7d3c-4f08-b15e-96c0d7a3f852}");
+        luiimpl();
+
+        //! The maximum width and height of the pyramid level read back to CPU.
+        static constexpr u32 READBACK_MAX_SIZE = 64;
+
+        //! The world-to-projection matrix used to render the depth texture of the current frame.
+        Float4x4U world_to_proj;
+        //! Whether to copy one pyramid level to CPU. Set this to `false` if the pyramid is only read by GPU.
+        bool readback_enabled = true;
+
+        RV init(DepthPyramidPassGlobalData* global_data);
+        RV execute(RG::IRenderPassContext* ctx) override;
+
+        //! Reads the depth pyramid level written by the last execution of this pass to CPU.
+        //! @details The command buffer that executed this pass must be completed before calling this.
+        RV read_back();
+        //! Gets the depth data read by @ref read_back.
+        const DepthPyramidReadback& get_readback() const { return m_readback; }
+        //! Checks whether this pass has been executed, so that the pyramid texture contains the depth pyramid of the last execution.
+        bool is_executed() const { return m_executed; }
+        //! Gets the world-to-projection matrix used to render the depth pyramid written by the last execution.
+        const Float4x4U& get_last_world_to_proj() const { return m_last_world_to_proj; }
+
+        private:
+        Ref<DepthPyramidPassGlobalData> m_global_data;
+        Ref<RHI::IBuffer> m_pyramid_params;
+        // One descriptor set per pyramid level.
+        Vector<Ref<RHI::IDescriptorSet>> m_ds;
+        Ref<RHI::IBuffer> m_readback_buffer;
+        u32 m_readback_width = 0;
+        u32 m_readback_height = 0;
+        u64 m_readback_row_pitch = 0;
+        Float4x4U m_last_world_to_proj;
+        bool m_executed = false;
+        // Whether `m_readback_buffer` is written by the last execution and not yet read.
+        bool m_readback_pending = false;
+        DepthPyramidReadback m_readback;
+    };
+
+    RV register_depth_pyramid_pass();
+}
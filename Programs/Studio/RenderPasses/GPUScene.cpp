@@ -0,0 +1,213 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file GPUScene.cpp
+* @author JXMaster
+* @date 2024/5/6
+*/
+#include "GPUScene.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
+
+namespace Luna
+{
+    struct GPUSceneItem
+    {
+        u32 material;
+        u32 piece;
+        Mesh* mesh;
+        u32 object;
+    };
+
+    RV GPUScene::update(RHI::IDevice* device, Span<Mesh* const> meshes, Span<const GeometryMaterialKey> piece_materials,
+        Span<const u32> mesh_buffer_indices)
+    {
+        lutry
+        {
+            if (mesh_buffer_indices.size() != meshes.size())
+            {
+                return set_error(BasicError::bad_arguments(), "GPUScene: The number of mesh buffer indices does not match meshes.");
+            }
+            // Buffers are always built once even if the scene is empty, so that they can always be bound.
+            bool changed = !instances || meshes.size() != m_meshes.size() || piece_materials.size() != m_piece_materials.size();
+            for (usize i = 0; i < meshes.size() && !changed; ++i)
+            {
+                if (m_meshes[i].get() != meshes[i]) changed = true;
+            }
+            if (!changed && !piece_materials.empty())
+            {
+                changed = memcmp(m_piece_materials.data(), piece_materials.data(), sizeof(GeometryMaterialKey) * piece_materials.size()) != 0;
+            }
+            if (!changed && !mesh_buffer_indices.empty())
+            {
+                changed = memcmp(m_mesh_buffer_indices.data(), mesh_buffer_indices.data(), sizeof(u32) * mesh_buffer_indices.size()) != 0;
+            }
+            if (changed)
+            {
+                luexp(rebuild(device, meshes, piece_materials, mesh_buffer_indices));
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV GPUScene::rebuild(RHI::IDevice* device, Span<Mesh* const> meshes, Span<const GeometryMaterialKey> piece_materials,
+        Span<const u32> mesh_buffer_indices)
+    {
+        using namespace RHI;
+        lutry
+        {
+            usize num_pieces = 0;
+            for (Mesh* mesh : meshes) num_pieces += mesh->pieces.size();
+            if (num_pieces != piece_materials.size())
+            {
+                return set_error(BasicError::bad_arguments(), "GPUScene: The number of piece materials does not match meshes.");
+            }
+            // Groups mesh pieces into batches. Materials are selected by instances, so pieces are batched by meshes only.
+            materials.clear();
+            batches.clear();
+            HashMap<GeometryMaterialKey, u32> material_indices;
+            Vector<GPUSceneItem> items;
+            items.reserve(piece_materials.size());
+            usize piece_index = 0;
+            for (usize i = 0; i < meshes.size(); ++i)
+            {
+                Mesh* mesh = meshes[i];
+                for (u32 j = 0; j < (u32)mesh->pieces.size(); ++j)
+                {
+                    const GeometryMaterialKey& material = piece_materials[piece_index++];
+                    auto iter = material_indices.find(material);
+                    if (iter == material_indices.end())
+                    {
+                        iter = material_indices.insert(make_pair(material, (u32)materials.size())).first;
+                        materials.push_back(material);
+                    }
+                    GPUSceneItem item;
+                    item.material = iter->second;
+                    item.piece = j;
+                    item.mesh = mesh;
+                    item.object = (u32)i;
+                    items.push_back(item);
+                }
+            }
+            sort(items.begin(), items.end(), [](const GPUSceneItem& lhs, const GPUSceneItem& rhs)
+            {
+                if (lhs.mesh != rhs.mesh) return lhs.mesh < rhs.mesh;
+                if (lhs.piece != rhs.piece) return lhs.piece < rhs.piece;
+                return lhs.material < rhs.material;
+            });
+            num_instances = (u32)items.size();
+            for (u32 i = 0; i < num_instances; ++i)
+            {
+                const GPUSceneItem& item = items[i];
+                if (batches.empty() || batches.back().mesh != item.mesh || batches.back().piece != item.piece)
+                {
+                    GPUSceneBatch batch;
+                    batch.material = U32_MAX;
+                    batch.piece = item.piece;
+                    batch.mesh = item.mesh;
+                    batch.first_instance = i;
+                    batch.num_instances = 0;
+                    batches.push_back(batch);
+                }
+                ++batches.back().num_instances;
+            }
+
+            // Creates buffers. Buffers are never empty so that they can always be bound.
+            usize num_buffer_instances = max<usize>(num_instances, 1);
+            usize num_batches = max<usize>(batches.size(), 1);
+            luset(instances, device->new_buffer(MemoryType::upload,
+                BufferDesc(BufferUsageFlag::read_buffer, sizeof(GPUSceneInstance) * num_buffer_instances)));
+            luset(initial_draw_arguments, device->new_buffer(MemoryType::upload,
+                BufferDesc(BufferUsageFlag::copy_source, sizeof(DrawIndexedIndirectArguments) * num_batches)));
+            luset(draw_arguments, device->new_buffer(MemoryType::local,
+                BufferDesc(BufferUsageFlag::indirect_buffer | BufferUsageFlag::read_write_buffer | BufferUsageFlag::copy_dest,
+                    sizeof(DrawIndexedIndirectArguments) * num_batches)));
+            luset(visible_instances, device->new_buffer(MemoryType::local,
+                BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::read_write_buffer, sizeof(u32) * num_buffer_instances)));
+            luset(visible_instance_materials, device->new_buffer(MemoryType::local,
+                BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::read_write_buffer, sizeof(u32) * num_buffer_instances)));
+            luset(material_textures, device->new_buffer(MemoryType::upload,
+                BufferDesc(BufferUsageFlag::read_buffer, sizeof(GPUSceneMaterial) * max<usize>(materials.size(), 1))));
+
+            // Registers textures of all materials. Textures are registered again on every rebuild, so that textures no 
+            // longer used by the scene are released.
+            if (!bindless_table)
+            {
+                luset(bindless_table, device->new_bindless_resource_table(get_gpu_scene_bindless_table_desc()));
+            }
+            for (u32 index : m_registered_texture_indices) bindless_table->unregister_texture(index);
+            m_registered_textures.clear();
+            m_registered_texture_indices.clear();
+            HashMap<ITexture*, u32> texture_indices;
+            Vector<GPUSceneMaterial> material_data(materials.size());
+            for (usize m = 0; m < materials.size(); ++m)
+            {
+                for (u32 t = 0; t < 5; ++t)
+                {
+                    ITexture* tex = materials[m].textures[t];
+                    auto iter = texture_indices.find(tex);
+                    if (iter == texture_indices.end())
+                    {
+                        lulet(index, bindless_table->register_texture(TextureViewDesc::tex2d(tex)));
+                        m_registered_textures.push_back(tex);
+                        m_registered_texture_indices.push_back(index);
+                        iter = texture_indices.insert(make_pair(tex, index)).first;
+                    }
+                    material_data[m].textures[t] = iter->second;
+                }
+            }
+            if (!material_data.empty())
+            {
+                void* mapped_materials = nullptr;
+                luexp(material_textures->map(0, 0, &mapped_materials));
+                memcpy(mapped_materials, material_data.data(), sizeof(GPUSceneMaterial) * material_data.size());
+                material_textures->unmap(0, sizeof(GPUSceneMaterial) * material_data.size());
+            }
+
+            // Writes instances and initial draw arguments.
+            GPUSceneInstance* mapped_instances = nullptr;
+            luexp(instances->map(0, 0, (void**)&mapped_instances));
+            for (u32 b = 0; b < (u32)batches.size(); ++b)
+            {
+                const GPUSceneBatch& batch = batches[b];
+                for (u32 i = batch.first_instance; i < batch.first_instance + batch.num_instances; ++i)
+                {
+                    GPUSceneInstance& dst = mapped_instances[i];
+                    dst.bounding_box_min = batch.mesh->bounding_box_min;
+                    dst.mesh_buffer_index = mesh_buffer_indices[items[i].object];
+                    dst.bounding_box_max = batch.mesh->bounding_box_max;
+                    dst.batch = b;
+                    dst.batch_first_instance = batch.first_instance;
+                    dst.material = items[i].material;
+                }
+            }
+            instances->unmap(0, sizeof(GPUSceneInstance) * num_instances);
+            DrawIndexedIndirectArguments* mapped_arguments = nullptr;
+            luexp(initial_draw_arguments->map(0, 0, (void**)&mapped_arguments));
+            memzero(mapped_arguments, sizeof(DrawIndexedIndirectArguments) * num_batches);
+            for (usize b = 0; b < batches.size(); ++b)
+            {
+                const MeshPiece& piece = batches[b].mesh->pieces[batches[b].piece];
+                DrawIndexedIndirectArguments& dst = mapped_arguments[b];
+                dst.index_count_per_instance = piece.num_indices;
+                dst.instance_count = 0;
+                dst.start_index_location = piece.first_index_offset;
+                dst.base_vertex_location = 0;
+                // The vertex shader adds the first instance of the batch explicitly, see `GeometryPass::execute`.
+                dst.start_instance_location = 0;
+            }
+            initial_draw_arguments->unmap(0, sizeof(DrawIndexedIndirectArguments) * num_batches);
+
+            m_meshes.clear();
+            m_meshes.reserve(meshes.size());
+            for (Mesh* mesh : meshes) m_meshes.push_back(mesh);
+            m_piece_materials.assign(piece_materials.begin(), piece_materials.end());
+            m_mesh_buffer_indices.assign(mesh_buffer_indices.begin(), mesh_buffer_indices.end());
+            ++version;
+        }
+        lucatchret;
+        return ok;
+    }
+}
@@ -0,0 +1,131 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file GPUScene.hpp
+* @author JXMaster
+* @date 2024/5/6
+*/
+#pragma once
+#include <Luna/Runtime/HashMap.hpp>
+#include "../Mesh.hpp"
+
+namespace Luna
+{
+    // The textures used by one mesh piece, in the same order as shader bindings `t2` to `t6`.
+    struct GeometryMaterialKey
+    {
+        RHI::ITexture* textures[5];
+
+        bool operator==(const GeometryMaterialKey& rhs) const
+        {
+            return !memcmp(textures, rhs.textures, sizeof(textures));
+        }
+    };
+
+    template <> struct hash<GeometryMaterialKey>
+    {
+        usize operator()(const GeometryMaterialKey& val) const { return memhash<usize>(val.textures, sizeof(val.textures)); }
+    };
+
+    // One mesh piece instance stored in `GPUScene::instances`. This must match `GPUSceneInstance` in Shaders/InstanceCullingCS.hlsl.
+    struct GPUSceneInstance
+    {
+        // The bounding box of the mesh in model space.
+        Float3U bounding_box_min;
+        // The element index of the mesh buffer of this instance in `SceneGPUData::mesh_buffers`.
+        u32 mesh_buffer_index;
+        Float3U bounding_box_max;
+        // The index of the batch this instance belongs to.
+        u32 batch;
+        // The first instance of the batch, see `GPUSceneBatch::first_instance`.
+        u32 batch_first_instance;
+        // The index of the material of this instance in `GPUScene::materials`.
+        u32 material;
+    };
+
+    // The bindless texture indices of one material stored in `GPUScene::material_textures`, in the same order as
+    // `GeometryMaterialKey::textures`. This must match `GeometryMaterial` in Shaders/GeometryBindlessPixel.hlsl.
+    struct GPUSceneMaterial
+    {
+        u32 textures[5];
+    };
+
+    // The descriptor of the bindless resource table of `GPUScene`. Pipelines that use the table are created with the layout
+    // of one table created with this descriptor, tables created with the same descriptor have compatible layouts.
+    inline RHI::BindlessResourceTableDesc get_gpu_scene_bindless_table_desc()
+    {
+        return RHI::BindlessResourceTableDesc(2048, 1, RHI::ShaderVisibilityFlag::pixel);
+    }
+
+    // Instances that share the same material, mesh and mesh piece, drawn by one instanced draw call.
+    // Batches of `GPUScene` are not split by materials, every instance selects its material by the material ID instead.
+    struct GPUSceneBatch
+    {
+        // The index of the material in `GeometryPass::m_materials`. Not used by batches of `GPUScene`.
+        u32 material;
+        u32 piece;
+        Mesh* mesh;
+        // The index of the first instance of this batch in `GPUScene::instances`, also the index of the first
+        // visible instance of this batch in `GPUScene::visible_instances`.
+        u32 first_instance;
+        u32 num_instances;
+    };
+
+    // The persistent scene data used to render meshes in GPU-driven mode. Mesh transforms, bounding boxes and material IDs
+    // of all mesh pieces are uploaded once and are updated only when they change, the culling shader then writes visible
+    // instances and indirect draw arguments of every batch.
+    // Material textures are registered to one bindless resource table owned by the scene, so that all meshes are drawn
+    // with one descriptor set and pieces that use different materials are drawn by the same draw call.
+    struct GPUScene
+    {
+        // Unique materials of all instances.
+        Vector<GeometryMaterialKey> materials;
+        // Batches sorted by mesh and piece.
+        Vector<GPUSceneBatch> batches;
+        // The number of instances in `instances`.
+        u32 num_instances = 0;
+
+        // `GPUSceneInstance` of every mesh piece, ordered by batches.
+        Ref<RHI::IBuffer> instances;
+        // Indirect draw arguments of every batch with `instance_count` set to 0, copied to `draw_arguments` before culling.
+        Ref<RHI::IBuffer> initial_draw_arguments;
+        // Indirect draw arguments of every batch written by the culling shader.
+        Ref<RHI::IBuffer> draw_arguments;
+        // The mesh buffer index of every visible instance written by the culling shader.
+        Ref<RHI::IBuffer> visible_instances;
+        // The material index of every visible instance written by the culling shader, in the same order as `visible_instances`.
+        Ref<RHI::IBuffer> visible_instance_materials;
+        // `GPUSceneMaterial` of every material in `materials`.
+        Ref<RHI::IBuffer> material_textures;
+        // The bindless resource table that contains textures of all materials, created with `get_gpu_scene_bindless_table_desc`.
+        // One table is used for every scene, since descriptors cannot be changed while command buffers that use the table 
+        // are executed, and scenes are rendered by different command buffers.
+        Ref<RHI::IBindlessResourceTable> bindless_table;
+        // Incremented every time buffers of the scene are recreated.
+        u64 version = 0;
+
+        // Updates the scene data. Buffers are rebuilt only if meshes, materials or mesh buffer indices are changed,
+        // transforms are read from the persistent mesh buffers directly.
+        // The command buffer that used the scene data last time must be completed before calling this, since buffers and
+        // the bindless resource table are rewritten in place.
+        // `meshes` and `mesh_buffer_indices` store data of every object, `piece_materials` stores the material of every
+        // piece of every object, ordered by objects.
+        RV update(RHI::IDevice* device, Span<Mesh* const> meshes, Span<const GeometryMaterialKey> piece_materials,
+            Span<const u32> mesh_buffer_indices);
+
+    private:
+        RV rebuild(RHI::IDevice* device, Span<Mesh* const> meshes, Span<const GeometryMaterialKey> piece_materials,
+            Span<const u32> mesh_buffer_indices);
+
+        // The mesh, the mesh buffer index of every object and the material of every mesh piece used to build the scene,
+        // used to detect changes of the scene. Meshes are kept alive since batches refer to them.
+        Vector<Ref<Mesh>> m_meshes;
+        Vector<GeometryMaterialKey> m_piece_materials;
+        Vector<u32> m_mesh_buffer_indices;
+        // Textures registered to `bindless_table` and their indices, textures are kept alive until they are unregistered.
+        Vector<Ref<RHI::ITexture>> m_registered_textures;
+        Vector<u32> m_registered_texture_indices;
+    };
+}
@@ -14,6 +14,7 @@
 #include "../Material.hpp"
 #include "../SceneRenderer.hpp"
 #include "../StudioHeader.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
 #include <Luna/RHI/Utility.hpp>
 
 namespace Luna
@@ -23,22 +24,18 @@ namespace Luna
         using namespace RHI;
         lutry
         {
-            luset(m_geometry_pass_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
-                DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::vertex | ShaderVisibilityFlag::pixel),
-                DescriptorSetLayoutBinding::read_buffer_view(1, 1, ShaderVisibilityFlag::vertex | ShaderVisibilityFlag::pixel),
-                DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 2, 1, ShaderVisibilityFlag::pixel),
-                DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 3, 1, ShaderVisibilityFlag::pixel),
-                DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 4, 1, ShaderVisibilityFlag::pixel),
-                DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 5, 1, ShaderVisibilityFlag::pixel),
-                DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 6, 1, ShaderVisibilityFlag::pixel),
-                DescriptorSetLayoutBinding::sampler(7, 1, ShaderVisibilityFlag::pixel)
-                })));
-            auto dl = m_geometry_pass_dlayout.get();
-            luset(m_geometry_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dl, 1 },
-                PipelineLayoutFlag::allow_input_assembler_input_layout)));
-
-            lulet(vs_blob, compile_shader("Shaders/GeometryVert.hlsl", ShaderCompiler::ShaderType::vertex));
-            lulet(ps_blob, compile_shader("Shaders/GeometryPixel.hlsl", ShaderCompiler::ShaderType::pixel));
+            lulet(vs_blob, compile_shader("Shaders/GeometryVert.hlsl", ShaderCompiler::ShaderType::vertex, true));
+            lulet(ps_blob, compile_shader("Shaders/GeometryPixel.hlsl", ShaderCompiler::ShaderType::pixel, true));
+            // Builds layouts from shader reflection data, so that they always match the shader source.
+            ShaderReflectionStage stages[] = {
+                { &vs_blob.reflection, ShaderVisibilityFlag::vertex },
+                { &ps_blob.reflection, ShaderVisibilityFlag::pixel }
+            };
+            Vector<Ref<IDescriptorSetLayout>> dlayouts;
+            luset(m_geometry_pass_playout, g_env->layout_cache.get_pipeline_layout({ stages, 2 },
+                PipelineLayoutFlag::allow_input_assembler_input_layout, &dlayouts));
+            if (dlayouts.size() != 1) return set_error(BasicError::bad_data(), "GeometryPass shaders must use exactly one descriptor set.");
+            m_geometry_pass_dlayout = dlayouts[0];
 
             GraphicsPipelineStateDesc ps_desc;
             ps_desc.primitive_topology = PrimitiveTopology::triangle_list;
@@ -48,7 +45,7 @@ namespace Luna
             ps_desc.ib_strip_cut_value = IndexBufferStripCutValue::disabled;
             Vector<InputAttributeDesc> attributes;
             get_vertex_input_layout_desc(attributes);
-            InputBindingDesc binding(0, sizeof(Vertex), InputRate::per_vertex);
+            InputBindingDesc binding(0, sizeof(QuantizedVertex), InputRate::per_vertex);
             ps_desc.input_layout.attributes = { attributes.data(), attributes.size() };
             ps_desc.input_layout.bindings = { &binding, 1 };
             ps_desc.vs = get_shader_data_from_compile_result(vs_blob);
@@ -60,6 +57,61 @@ namespace Luna
             ps_desc.color_formats[2] = Format::rgba16_float;
             ps_desc.depth_stencil_format = Format::d32_float;
             luset(m_geometry_pass_pso, device->new_graphics_pipeline_state(ps_desc));
+            // Shades pixels covered by the depth pre-pass only.
+            ps_desc.depth_stencil_state = DepthStencilDesc(true, false, CompareFunction::equal, false, 0x00, 0x00, DepthStencilOpDesc(), DepthStencilOpDesc());
+            luset(m_geometry_pass_depth_equal_pso, device->new_graphics_pipeline_state(ps_desc));
+
+            // The depth pre-pass reads a subset of resources of the geometry pass, so it uses the same pipeline layout
+            // and descriptor sets.
+            lulet(prepass_vs_blob, compile_shader("Shaders/DepthPrepassVert.hlsl", ShaderCompiler::ShaderType::vertex, true));
+            lulet(prepass_ps_blob, compile_shader("Shaders/DepthPrepassPixel.hlsl", ShaderCompiler::ShaderType::pixel, true));
+            InputAttributeDesc position_attribute("POSITION", 0, 0, 0, 0, Format::rgb32_float);
+            InputBindingDesc position_binding(0, sizeof(Float3U), InputRate::per_vertex);
+            ps_desc.depth_stencil_state = DepthStencilDesc(true, true, CompareFunction::less_equal, false, 0x00, 0x00, DepthStencilOpDesc(), DepthStencilOpDesc());
+            ps_desc.input_layout.attributes = { &position_attribute, 1 };
+            ps_desc.input_layout.bindings = { &position_binding, 1 };
+            ps_desc.vs = get_shader_data_from_compile_result(prepass_vs_blob);
+            ps_desc.ps = get_shader_data_from_compile_result(prepass_ps_blob);
+            ps_desc.num_color_attachments = 0;
+            luset(m_depth_prepass_pso, device->new_graphics_pipeline_state(ps_desc));
+
+            // Pipelines used in GPU-driven mode. Descriptor set 0 is built from shader reflection data, descriptor set 1 must use
+            // the layout of the bindless resource table, so the pipeline layout is created manually.
+            if (device->check_feature(DeviceFeature::unbound_descriptor_array).unbound_descriptor_array)
+            {
+                luset(m_bindless_layout_table, device->new_bindless_resource_table(get_gpu_scene_bindless_table_desc()));
+                lulet(bindless_vs_blob, compile_shader("Shaders/GeometryBindlessVert.hlsl", ShaderCompiler::ShaderType::vertex, true));
+                lulet(bindless_ps_blob, compile_shader("Shaders/GeometryBindlessPixel.hlsl", ShaderCompiler::ShaderType::pixel, true));
+                Vector<DescriptorSetLayoutBinding> bindings;
+                get_descriptor_set_layout_bindings_from_reflection(bindless_vs_blob.reflection, ShaderVisibilityFlag::vertex, 0, bindings);
+                get_descriptor_set_layout_bindings_from_reflection(bindless_ps_blob.reflection, ShaderVisibilityFlag::pixel, 0, bindings);
+                luset(m_bindless_geometry_dlayout, g_env->layout_cache.get_descriptor_set_layout(DescriptorSetLayoutDesc({ bindings.data(), bindings.size() })));
+                IDescriptorSetLayout* bindless_dlayouts[] = { m_bindless_geometry_dlayout, m_bindless_layout_table->get_descriptor_set_layout() };
+                luset(m_bindless_geometry_playout, device->new_pipeline_layout(PipelineLayoutDesc({ bindless_dlayouts, 2 },
+                    PipelineLayoutFlag::allow_input_assembler_input_layout, bindless_vs_blob.reflection.num_constants, ShaderVisibilityFlag::vertex)));
+                // The depth pre-pass shaders read a subset of descriptor set 0.
+                ps_desc.pipeline_layout = m_bindless_geometry_playout;
+                luset(m_bindless_depth_prepass_pso, device->new_graphics_pipeline_state(ps_desc));
+                ps_desc.input_layout.attributes = { attributes.data(), attributes.size() };
+                ps_desc.input_layout.bindings = { &binding, 1 };
+                ps_desc.vs = get_shader_data_from_compile_result(bindless_vs_blob);
+                ps_desc.ps = get_shader_data_from_compile_result(bindless_ps_blob);
+                ps_desc.num_color_attachments = 3;
+                luset(m_bindless_geometry_pso, device->new_graphics_pipeline_state(ps_desc));
+                ps_desc.depth_stencil_state = DepthStencilDesc(true, false, CompareFunction::equal, false, 0x00, 0x00, DepthStencilOpDesc(), DepthStencilOpDesc());
+                luset(m_bindless_geometry_depth_equal_pso, device->new_graphics_pipeline_state(ps_desc));
+            }
+
+            lulet(culling_blob, compile_shader("Shaders/InstanceCullingCS.hlsl", ShaderCompiler::ShaderType::compute, true));
+            ShaderReflectionStage culling_stage = { &culling_blob.reflection, ShaderVisibilityFlag::compute };
+            luset(m_instance_culling_playout, g_env->layout_cache.get_pipeline_layout({ &culling_stage, 1 },
+                PipelineLayoutFlag::deny_vertex_shader_access | PipelineLayoutFlag::deny_pixel_shader_access, &dlayouts));
+            if (dlayouts.size() != 1) return set_error(BasicError::bad_data(), "InstanceCullingCS.hlsl must use exactly one descriptor set.");
+            m_instance_culling_dlayout = dlayouts[0];
+            ComputePipelineStateDesc culling_desc;
+            fill_compute_pipeline_state_desc_from_compile_result(culling_desc, culling_blob);
+            culling_desc.pipeline_layout = m_instance_culling_playout;
+            luset(m_instance_culling_pso, device->new_compute_pipeline_state(culling_desc));
 
             luset(m_default_base_color, device->new_texture(MemoryType::local,
                 TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::copy_dest, 1, 1, 1, 1)));
@@ -90,6 +142,47 @@ namespace Luna
         return ok;
     }
 
+    // The number of executions after which unused descriptor sets are released from the cache.
+    constexpr u64 DESCRIPTOR_SET_CACHE_LIFETIME = 8;
+
+    // The number of instances processed by one thread group. This must match INSTANCE_CULLING_GROUP_SIZE in InstanceCullingCS.hlsl.
+    constexpr u32 INSTANCE_CULLING_GROUP_SIZE = 64;
+
+    struct InstanceCullingParamsCB
+    {
+        Float4x4U occlusion_world_to_proj;
+        u32 num_instances;
+        u32 occlusion_width;
+        u32 occlusion_height;
+        u32 occlusion_mip_levels;
+    };
+
+    static GeometryMaterialKey get_piece_material(GeometryPassGlobalData* global_data, Model* model, u32 piece)
+    {
+        using namespace RHI;
+        GeometryMaterialKey key;
+        key.textures[0] = global_data->m_default_base_color;
+        key.textures[1] = global_data->m_default_roughness;
+        key.textures[2] = global_data->m_default_normal;
+        key.textures[3] = global_data->m_default_metallic;
+        key.textures[4] = global_data->m_default_emissive;
+        if (piece < model->materials.size())
+        {
+            // Materials and textures are loaded by the scene prefetcher in priority order, default textures are used until they are loaded.
+            auto mat = Asset::get_asset_data<Material>(model->materials[piece]);
+            if (mat)
+            {
+                Asset::asset_t mat_textures[5] = { mat->base_color, mat->roughness, mat->normal, mat->metallic, mat->emissive };
+                for (u32 i = 0; i < 5; ++i)
+                {
+                    Ref<ITexture> tex = Asset::get_asset_data<ITexture>(mat_textures[i]);
+                    if (tex) key.textures[i] = tex;
+                }
+            }
+        }
+        return key;
+    }
+
     RV GeometryPass::init(GeometryPassGlobalData* global_data)
     {
         lutry
@@ -100,6 +193,306 @@ namespace Luna
         return ok;
     }
 
+    RV GeometryPass::build_draw_list(RHI::ICommandBuffer* cmdbuf)
+    {
+        using namespace RHI;
+        lutry
+        {
+            // Tests visibility of meshes against the depth of the last frame.
+            m_visible.resize(ts.size());
+            num_culled_meshes = 0;
+            for (usize i = 0; i < ts.size(); ++i)
+            {
+                m_visible[i] = true;
+                if (occlusion_culling_data)
+                {
+                    auto model = get_asset_or_async_load_if_not_ready<Model>(rs[i]->model);
+                    auto mesh = get_asset_or_async_load_if_not_ready<Mesh>(model->mesh);
+                    if (!occlusion_culling_data->is_visible(mesh->bounding_box_min, mesh->bounding_box_max, model_to_world_matrices[i]))
+                    {
+                        m_visible[i] = false;
+                        ++num_culled_meshes;
+                    }
+                }
+            }
+            m_materials.clear();
+            m_material_indices.clear();
+            m_draw_items.clear();
+            for (usize i = 0; i < ts.size(); ++i)
+            {
+                if (!m_visible[i]) continue;
+                auto model = get_asset_or_async_load_if_not_ready<Model>(rs[i]->model);
+                auto mesh = get_asset_or_async_load_if_not_ready<Mesh>(model->mesh);
+                // The squared distance from the camera to the bounding box center, used to sort meshes front-to-back.
+                Float3 center = (Float3(mesh->bounding_box_min) + Float3(mesh->bounding_box_max)) * 0.5f;
+                Float3 to_camera = mul(Float4(center.x, center.y, center.z, 1.0f), model_to_world_matrices[i]).xyz() - Float3(camera_position);
+                f32 distance = dot(to_camera, to_camera);
+                u32 num_pieces = (u32)mesh->pieces.size();
+                for (u32 j = 0; j < num_pieces; ++j)
+                {
+                    GeometryMaterialKey material = get_piece_material(m_global_data, model, j);
+                    auto iter = m_material_indices.find(material);
+                    if (iter == m_material_indices.end())
+                    {
+                        iter = m_material_indices.insert(make_pair(material, (u32)m_materials.size())).first;
+                        m_materials.push_back(material);
+                    }
+                    GeometryDrawItem item;
+                    item.material = iter->second;
+                    item.piece = j;
+                    item.mesh = mesh;
+                    item.mesh_buffer_index = model_matrix_indices[i];
+                    item.distance = distance;
+                    m_draw_items.push_back(item);
+                }
+            }
+            // Only one pipeline state is used by this pass, so draw items are sorted by material first to minimize
+            // descriptor set changes, then by mesh and piece so that identical pieces become adjacent and can be instanced,
+            // then front-to-back within every instanced draw call.
+            sort(m_draw_items.begin(), m_draw_items.end(), [](const GeometryDrawItem& lhs, const GeometryDrawItem& rhs)
+            {
+                if (lhs.material != rhs.material) return lhs.material < rhs.material;
+                if (lhs.mesh != rhs.mesh) return lhs.mesh < rhs.mesh;
+                if (lhs.piece != rhs.piece) return lhs.piece < rhs.piece;
+                return lhs.distance < rhs.distance;
+            });
+            // Merges adjacent draw items with the same material, mesh and piece into batches.
+            m_draw_batches.clear();
+            m_batch_distances.clear();
+            for (u32 i = 0; i < (u32)m_draw_items.size(); ++i)
+            {
+                const GeometryDrawItem& item = m_draw_items[i];
+                if (m_draw_batches.empty() || m_draw_batches.back().material != item.material ||
+                    m_draw_batches.back().mesh != item.mesh || m_draw_batches.back().piece != item.piece)
+                {
+                    GPUSceneBatch batch;
+                    batch.material = item.material;
+                    batch.piece = item.piece;
+                    batch.mesh = item.mesh;
+                    batch.first_instance = i;
+                    batch.num_instances = 0;
+                    m_draw_batches.push_back(batch);
+                    // Items are sorted front-to-back in every batch, so the first item is the nearest one.
+                    m_batch_distances.push_back(item.distance);
+                }
+                ++m_draw_batches.back().num_instances;
+            }
+            // The depth pre-pass ignores materials, so batches are drawn front-to-back by their nearest instances.
+            m_prepass_batch_order.clear();
+            if (depth_prepass)
+            {
+                for (u32 i = 0; i < (u32)m_draw_batches.size(); ++i) m_prepass_batch_order.push_back(i);
+                sort(m_prepass_batch_order.begin(), m_prepass_batch_order.end(), [this](u32 lhs, u32 rhs)
+                {
+                    return m_batch_distances[lhs] < m_batch_distances[rhs];
+                });
+            }
+
+            // Writes the mesh buffer index of every instance.
+            usize num_instances = max<usize>(m_draw_items.size(), 1);
+            if (m_instance_buffer_capacity < num_instances)
+            {
+                usize capacity = max<usize>(m_instance_buffer_capacity * 2, num_instances);
+                luset(m_instance_buffer, cmdbuf->get_device()->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::read_buffer, sizeof(u32) * capacity)));
+                m_instance_buffer_capacity = capacity;
+            }
+            if (!m_draw_items.empty())
+            {
+                u32* mapped = nullptr;
+                luexp(m_instance_buffer->map(0, 0, (void**)&mapped));
+                for (usize i = 0; i < m_draw_items.size(); ++i)
+                {
+                    mapped[i] = m_draw_items[i].mesh_buffer_index;
+                }
+                m_instance_buffer->unmap(0, sizeof(u32) * m_draw_items.size());
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV GeometryPass::cull_on_gpu(RHI::ICommandBuffer* cmdbuf)
+    {
+        using namespace RHI;
+        lutry
+        {
+            auto device = cmdbuf->get_device();
+            auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+            num_culled_meshes = 0;
+            // Updates the scene data. Batches are rebuilt only if meshes or materials are changed, transforms are read
+            // from `model_matrices` directly.
+            m_object_meshes.clear();
+            m_piece_materials.clear();
+            for (usize i = 0; i < ts.size(); ++i)
+            {
+                auto model = get_asset_or_async_load_if_not_ready<Model>(rs[i]->model);
+                auto mesh = get_asset_or_async_load_if_not_ready<Mesh>(model->mesh);
+                m_object_meshes.push_back(mesh);
+                u32 num_pieces = (u32)mesh->pieces.size();
+                for (u32 j = 0; j < num_pieces; ++j)
+                {
+                    m_piece_materials.push_back(get_piece_material(m_global_data, model, j));
+                }
+            }
+            luexp(m_gpu_scene.update(device, { m_object_meshes.data(), m_object_meshes.size() }, 
+                { m_piece_materials.data(), m_piece_materials.size() }, model_matrix_indices));
+            // Visible instances are only known on GPU, so the depth pre-pass draws batches in their stored order.
+            m_prepass_batch_order.clear();
+            if (depth_prepass)
+            {
+                for (u32 i = 0; i < (u32)m_gpu_scene.batches.size(); ++i) m_prepass_batch_order.push_back(i);
+            }
+
+            // Uploads culling parameters. The depth pyramid of the last frame is read by the culling shader directly. 
+            // One texture must always be bound, so one default texture is bound if no depth pyramid is provided, and
+            // occlusion culling is disabled by setting the number of levels to 0.
+            ITexture* depth_pyramid = occlusion_depth_pyramid ? occlusion_depth_pyramid.get() : m_global_data->m_default_metallic.get();
+            TextureDesc depth_pyramid_desc = depth_pyramid->get_desc();
+            u32 occlusion_mip_levels = occlusion_depth_pyramid ? depth_pyramid_desc.mip_levels : 0;
+            if (!m_culling_params_cb)
+            {
+                luset(m_culling_params_cb, device->new_buffer(MemoryType::upload,
+                    BufferDesc(BufferUsageFlag::uniform_buffer, align_upper(sizeof(InstanceCullingParamsCB), cb_align))));
+                luset(m_culling_ds, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_instance_culling_dlayout)));
+            }
+            InstanceCullingParamsCB* params = nullptr;
+            luexp(m_culling_params_cb->map(0, 0, (void**)&params));
+            params->occlusion_world_to_proj = occlusion_mip_levels ? occlusion_world_to_proj : Float4x4U(Float4x4::identity());
+            params->num_instances = m_gpu_scene.num_instances;
+            params->occlusion_width = depth_pyramid_desc.width;
+            params->occlusion_height = depth_pyramid_desc.height;
+            params->occlusion_mip_levels = occlusion_mip_levels;
+            m_culling_params_cb->unmap(0, sizeof(InstanceCullingParamsCB));
+
+            // Resets instance counts of draw arguments.
+            usize draw_arguments_size = sizeof(DrawIndexedIndirectArguments) * max<usize>(m_gpu_scene.batches.size(), 1);
+            cmdbuf->begin_copy_pass();
+            cmdbuf->resource_barrier({
+                {m_gpu_scene.initial_draw_arguments, BufferStateFlag::automatic, BufferStateFlag::copy_source, ResourceBarrierFlag::none},
+                {m_gpu_scene.draw_arguments, BufferStateFlag::automatic, BufferStateFlag::copy_dest, ResourceBarrierFlag::discard_content}
+            }, {});
+            cmdbuf->copy_buffer(m_gpu_scene.draw_arguments, 0, m_gpu_scene.initial_draw_arguments, 0, draw_arguments_size);
+            cmdbuf->end_copy_pass();
+
+            // Culls instances.
+            if (m_gpu_scene.num_instances)
+            {
+                cmdbuf->begin_compute_pass();
+                cmdbuf->resource_barrier({
+                    {camera_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none},
+                    {m_culling_params_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none},
+                    {model_matrices, BufferStateFlag::automatic, BufferStateFlag::shader_read_cs, ResourceBarrierFlag::none},
+                    {m_gpu_scene.instances, BufferStateFlag::automatic, BufferStateFlag::shader_read_cs, ResourceBarrierFlag::none},
+                    {m_gpu_scene.draw_arguments, BufferStateFlag::automatic, BufferStateFlag::shader_read_write_cs, ResourceBarrierFlag::none},
+                    {m_gpu_scene.visible_instances, BufferStateFlag::automatic, BufferStateFlag::shader_write_cs, ResourceBarrierFlag::discard_content},
+                    {m_gpu_scene.visible_instance_materials, BufferStateFlag::automatic, BufferStateFlag::shader_write_cs, ResourceBarrierFlag::discard_content}
+                }, {
+                    {depth_pyramid, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_cs, ResourceBarrierFlag::none}
+                });
+                luexp(m_culling_ds->update_descriptors({
+                    WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(camera_cb, 0, (u32)align_upper(sizeof(CameraCB), cb_align))),
+                    WriteDescriptorSet::uniform_buffer_view(1, BufferViewDesc::uniform_buffer(m_culling_params_cb, 0, (u32)align_upper(sizeof(InstanceCullingParamsCB), cb_align))),
+                    WriteDescriptorSet::read_buffer_view(2, BufferViewDesc::structured_buffer(model_matrices, 0, 
+                        (u32)(model_matrices->get_desc().size / (sizeof(Float4x4) * 2)), sizeof(Float4x4) * 2)),
+                    WriteDescriptorSet::read_buffer_view(3, BufferViewDesc::structured_buffer(m_gpu_scene.instances, 0, m_gpu_scene.num_instances, sizeof(GPUSceneInstance))),
+                    WriteDescriptorSet::read_texture_view(4, TextureViewDesc::tex2d(depth_pyramid)),
+                    WriteDescriptorSet::read_write_buffer_view(5, BufferViewDesc::structured_buffer(m_gpu_scene.draw_arguments, 0, 
+                        (u32)(draw_arguments_size / sizeof(u32)), sizeof(u32))),
+                    WriteDescriptorSet::read_write_buffer_view(6, BufferViewDesc::structured_buffer(m_gpu_scene.visible_instances, 0, m_gpu_scene.num_instances, sizeof(u32))),
+                    WriteDescriptorSet::read_write_buffer_view(7, BufferViewDesc::structured_buffer(m_gpu_scene.visible_instance_materials, 0, m_gpu_scene.num_instances, sizeof(u32)))
+                }));
+                cmdbuf->set_compute_pipeline_layout(m_global_data->m_instance_culling_playout);
+                cmdbuf->set_compute_pipeline_state(m_global_data->m_instance_culling_pso);
+                cmdbuf->set_compute_descriptor_set(0, m_culling_ds);
+                cmdbuf->dispatch(align_upper(m_gpu_scene.num_instances, INSTANCE_CULLING_GROUP_SIZE) / INSTANCE_CULLING_GROUP_SIZE, 1, 1);
+                cmdbuf->end_compute_pass();
+            }
+            cmdbuf->resource_barrier({
+                {m_gpu_scene.draw_arguments, BufferStateFlag::automatic, BufferStateFlag::indirect_argument, ResourceBarrierFlag::none},
+                {m_gpu_scene.visible_instances, BufferStateFlag::automatic, BufferStateFlag::shader_read_vs, ResourceBarrierFlag::none},
+                {m_gpu_scene.visible_instance_materials, BufferStateFlag::automatic, BufferStateFlag::shader_read_vs, ResourceBarrierFlag::none},
+                {m_gpu_scene.material_textures, BufferStateFlag::automatic, BufferStateFlag::shader_read_ps, ResourceBarrierFlag::none}
+            }, {});
+        }
+        lucatchret;
+        return ok;
+    }
+
+    R<RHI::IDescriptorSet*> GeometryPass::get_descriptor_set(RHI::IDevice* device, RHI::IBuffer* model_matrices, RHI::IBuffer* instances,
+        const GeometryMaterialKey& material)
+    {
+        using namespace RHI;
+        IDescriptorSet* ret = nullptr;
+        lutry
+        {
+            GeometryDescriptorSetKey key;
+            key.model_matrices = model_matrices;
+            key.instances = instances;
+            key.material = material;
+            auto iter = m_descriptor_sets.find(key);
+            if (iter == m_descriptor_sets.end())
+            {
+                auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+                CachedDescriptorSet entry;
+                luset(entry.descriptor_set, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_geometry_pass_dlayout)));
+                // Buffers are bound as a whole, so that the descriptor set does not depend on offsets that change every frame.
+                luexp(entry.descriptor_set->update_descriptors({
+                    WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(camera_cb, 0, (u32)align_upper(sizeof(CameraCB), cb_align))),
+                    WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(model_matrices, 0, 
+                        (u32)(model_matrices->get_desc().size / (sizeof(Float4x4) * 2)), sizeof(Float4x4) * 2)),
+                    WriteDescriptorSet::read_texture_view(2, TextureViewDesc::tex2d(material.textures[0])),
+                    WriteDescriptorSet::read_texture_view(3, TextureViewDesc::tex2d(material.textures[1])),
+                    WriteDescriptorSet::read_texture_view(4, TextureViewDesc::tex2d(material.textures[2])),
+                    WriteDescriptorSet::read_texture_view(5, TextureViewDesc::tex2d(material.textures[3])),
+                    WriteDescriptorSet::read_texture_view(6, TextureViewDesc::tex2d(material.textures[4])),
+                    WriteDescriptorSet::sampler(7, SamplerDesc(Filter::linear, Filter::linear, Filter::linear, TextureAddressMode::repeat, TextureAddressMode::repeat, TextureAddressMode::repeat)),
+                    WriteDescriptorSet::read_buffer_view(8, BufferViewDesc::structured_buffer(instances, 0, (u32)(instances->get_desc().size / sizeof(u32)), sizeof(u32)))
+                    }));
+                entry.model_matrices = model_matrices;
+                entry.instances = instances;
+                for (u32 t = 0; t < 5; ++t) entry.textures[t] = material.textures[t];
+                iter = m_descriptor_sets.insert(make_pair(key, move(entry))).first;
+            }
+            iter->second.last_used_execution = m_num_executions;
+            ret = iter->second.descriptor_set;
+        }
+        lucatchret;
+        return ret;
+    }
+
+    R<RHI::IDescriptorSet*> GeometryPass::get_bindless_descriptor_set(RHI::IDevice* device)
+    {
+        using namespace RHI;
+        lutry
+        {
+            if (!m_bindless_ds)
+            {
+                luset(m_bindless_ds, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_bindless_geometry_dlayout)));
+            }
+            // Buffers of the scene are recreated only when the scene is rebuilt, so the descriptor set is updated only if 
+            // the scene version or bound buffers change.
+            if (m_bindless_ds_scene_version != m_gpu_scene.version || m_bindless_ds_model_matrices != model_matrices)
+            {
+                auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+                u32 num_buffer_instances = max<u32>(m_gpu_scene.num_instances, 1);
+                luexp(m_bindless_ds->update_descriptors({
+                    WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(camera_cb, 0, (u32)align_upper(sizeof(CameraCB), cb_align))),
+                    WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(model_matrices, 0, 
+                        (u32)(model_matrices->get_desc().size / (sizeof(Float4x4) * 2)), sizeof(Float4x4) * 2)),
+                    WriteDescriptorSet::sampler(7, SamplerDesc(Filter::linear, Filter::linear, Filter::linear, TextureAddressMode::repeat, TextureAddressMode::repeat, TextureAddressMode::repeat)),
+                    WriteDescriptorSet::read_buffer_view(8, BufferViewDesc::structured_buffer(m_gpu_scene.visible_instances, 0, num_buffer_instances, sizeof(u32))),
+                    WriteDescriptorSet::read_buffer_view(9, BufferViewDesc::structured_buffer(m_gpu_scene.visible_instance_materials, 0, num_buffer_instances, sizeof(u32))),
+                    WriteDescriptorSet::read_buffer_view(10, BufferViewDesc::structured_buffer(m_gpu_scene.material_textures, 0, 
+                        (u32)max<usize>(m_gpu_scene.materials.size(), 1), sizeof(GPUSceneMaterial)))
+                    }));
+                m_bindless_ds_scene_version = m_gpu_scene.version;
+                m_bindless_ds_model_matrices = model_matrices;
+            }
+        }
+        lucatchret;
+        return m_bindless_ds.get();
+    }
+
     RV GeometryPass::execute(RG::IRenderPassContext* ctx)
     {
         using namespace RHI;
@@ -112,164 +505,241 @@ namespace Luna
             auto render_desc = base_color_roughness_tex->get_desc();
             auto cmdbuf = ctx->get_command_buffer();
             auto device = cmdbuf->get_device();
-            auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+            ++m_num_executions;
+            if (m_cached_camera_cb != camera_cb)
+            {
+                m_descriptor_sets.clear();
+                m_bindless_ds_scene_version = 0;
+                m_cached_camera_cb = camera_cb;
+            }
+            if (gpu_driven)
+            {
+                if (!m_global_data->m_bindless_geometry_pso)
+                {
+                    return set_error(BasicError::not_supported(), "GeometryPass: GPU-driven mode requires bindless resource tables, which are not supported by the device.");
+                }
+                luexp(cull_on_gpu(cmdbuf));
+            }
+            else
+            {
+                luexp(build_draw_list(cmdbuf));
+            }
+            cmdbuf->resource_barrier({
+                {model_matrices, BufferStateFlag::automatic, BufferStateFlag::shader_read_vs, ResourceBarrierFlag::none}
+            }, {});
+            Span<const GeometryMaterialKey> materials = gpu_driven ? 
+                Span<const GeometryMaterialKey>(m_gpu_scene.materials.data(), m_gpu_scene.materials.size()) :
+                Span<const GeometryMaterialKey>(m_materials.data(), m_materials.size());
             cmdbuf->resource_barrier(
                 {}, {
-                    {base_color_roughness_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::color_attachment_write, ResourceBarrierFlag::discard_content},
-                    {normal_metallic_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::color_attachment_write, ResourceBarrierFlag::discard_content},
-                    {emissive_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::color_attachment_write, ResourceBarrierFlag::discard_content},
                     {depth_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::depth_stencil_attachment_write, ResourceBarrierFlag::discard_content} });
-            
-            for (usize i = 0; i < ts.size(); ++i)
+            for (auto& material : materials)
             {
-                auto model = get_asset_or_async_load_if_not_ready<Model>(rs[i]->model);
-                auto mesh = get_asset_or_async_load_if_not_ready<Mesh>(model->mesh);
-
-                u32 num_pieces = (u32)mesh->pieces.size();
+                cmdbuf->resource_barrier(
+                {}, {
+                    {material.textures[0], TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
+                    {material.textures[1], TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
+                    {material.textures[2], TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
+                    {material.textures[3], TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
+                    {material.textures[4], TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none}});
+            }
 
-                for (u32 j = 0; j < num_pieces; ++j)
+            // With the depth pre-pass, depth is written by one depth-only render pass first, and the geometry render pass
+            // loads the depth and only shades pixels whose depth equals the pre-pass depth, so every pixel is shaded once.
+            u32 time_query_begin, time_query_end;
+            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            Span<const GPUSceneBatch> batches = gpu_driven ?
+                Span<const GPUSceneBatch>(m_gpu_scene.batches.data(), m_gpu_scene.batches.size()) :
+                Span<const GPUSceneBatch>(m_draw_batches.data(), m_draw_batches.size());
+            IBuffer* instances = gpu_driven ? m_gpu_scene.visible_instances.get() : m_instance_buffer.get();
+            num_draw_calls = 0;
+            Mesh* bound_mesh = nullptr;
+            u32 bound_material = U32_MAX;
+            auto draw_batch = [&](u32 b) -> RV
+            {
+                lutry
                 {
-                    Ref<ITexture> base_color_tex = m_global_data->m_default_base_color;
-                    Ref<ITexture> roughness_tex = m_global_data->m_default_roughness;
-                    Ref<ITexture> normal_tex = m_global_data->m_default_normal;
-                    Ref<ITexture> metallic_tex = m_global_data->m_default_metallic;
-                    Ref<ITexture> emissive_tex = m_global_data->m_default_emissive;
-
-                    if (j < model->materials.size())
+                    const GPUSceneBatch& batch = batches[b];
+                    // The vertex shader fetches the mesh buffer index of every instance from the instance buffer starting
+                    // at `first_instance`. `SV_InstanceID` does not include the start instance on all platforms, so the start 
+                    // instance is always 0 and the offset is passed as one pipeline constant instead.
+                    cmdbuf->set_graphics_constants(0, 1, &batch.first_instance);
+                    if (gpu_driven)
+                    {
+                        // The instance count is written by the culling shader.
+                        cmdbuf->draw_indexed_indirect(m_gpu_scene.draw_arguments, sizeof(DrawIndexedIndirectArguments) * b, 1);
+                    }
+                    else
+                    {
+                        auto& piece = batch.mesh->pieces[batch.piece];
+                        cmdbuf->draw_indexed_instanced(piece.num_indices, batch.num_instances, piece.first_index_offset, 0, 0);
+                    }
+                    ++num_draw_calls;
+                }
+                lucatchret;
+                return ok;
+            };
+            // In GPU-driven mode, all meshes are drawn with one descriptor set for per-pass resources and the bindless 
+            // resource table of the scene.
+            auto bind_bindless_descriptor_sets = [&]() -> RV
+            {
+                lutry
+                {
+                    lulet(ds, get_bindless_descriptor_set(device));
+                    IDescriptorSet* bindless_ds = m_gpu_scene.bindless_table->get_descriptor_set();
+                    cmdbuf->set_graphics_descriptor_set(0, ds);
+                    cmdbuf->set_graphics_descriptor_set(1, bindless_ds);
+                    cmdbuf->attach_device_object(ds);
+                    cmdbuf->attach_device_object(bindless_ds);
+                }
+                lucatchret;
+                return ok;
+            };
+            IPipelineLayout* playout = gpu_driven ? m_global_data->m_bindless_geometry_playout.get() : m_global_data->m_geometry_pass_playout.get();
+            if (depth_prepass)
+            {
+                RenderPassDesc prepass;
+                prepass.depth_stencil_attachment = DepthStencilAttachment(depth_tex, false, LoadOp::clear, StoreOp::store, 1.0F);
+                if (query_heap)
+                {
+                    prepass.timestamp_query_heap = query_heap;
+                    prepass.timestamp_query_begin_pass_write_index = time_query_begin;
+                }
+                cmdbuf->begin_render_pass(prepass);
+                cmdbuf->set_graphics_pipeline_layout(playout);
+                cmdbuf->set_graphics_pipeline_state(gpu_driven ? m_global_data->m_bindless_depth_prepass_pso : m_global_data->m_depth_prepass_pso);
+                cmdbuf->set_viewport(Viewport(0.0f, 0.0f, (f32)render_desc.width, (f32)render_desc.height, 0.0f, 1.0f));
+                cmdbuf->set_scissor_rect(RectI(0, 0, (i32)render_desc.width, (i32)render_desc.height));
+                // The depth-only pipeline reads camera data, mesh buffers and instances only, so any descriptor set of
+                // this execution can be used. Batches are drawn front-to-back so that occluded pixels fail early depth testing.
+                if (gpu_driven)
+                {
+                    luexp(bind_bindless_descriptor_sets());
+                }
+                else if (!batches.empty())
+                {
+                    lulet(ds, get_descriptor_set(device, model_matrices, instances, materials[batches[0].material]));
+                    cmdbuf->set_graphics_descriptor_set(0, ds);
+                    cmdbuf->attach_device_object(ds);
+                }
+                for (u32 b : m_prepass_batch_order)
+                {
+                    Mesh* mesh = batches[b].mesh;
+                    if (mesh != bound_mesh)
                     {
-                        auto mat = get_asset_or_async_load_if_not_ready<Material>(model->materials[j]);
-                        if (mat)
-                        {
-                            // Set material for this piece.
-                            Ref<ITexture> mat_base_color_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->base_color);
-                            Ref<ITexture> mat_roughness_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->roughness);
-                            Ref<ITexture> mat_normal_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->normal);
-                            Ref<ITexture> mat_metallic_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->metallic);
-                            Ref<ITexture> mat_emissive_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->emissive);
-                            if (mat_base_color_tex)
-                            {
-                                base_color_tex = mat_base_color_tex;
-                            }
-                            if (mat_roughness_tex)
-                            {
-                                roughness_tex = mat_roughness_tex;
-                            }
-                            if (mat_normal_tex)
-                            {
-                                normal_tex = mat_normal_tex;
-                            }
-                            if (mat_metallic_tex)
-                            {
-                                metallic_tex = mat_metallic_tex;
-                            }
-                            if (mat_emissive_tex)
-                            {
-                                emissive_tex = mat_emissive_tex;
-                            }
-                            cmdbuf->resource_barrier(
-                            {}, {
-                                {base_color_tex, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
-                                {roughness_tex, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
-                                {normal_tex, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
-                                {metallic_tex, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none},
-                                {emissive_tex, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::shader_read_ps, ResourceBarrierFlag::none}});
-                        }
+                        cmdbuf->set_vertex_buffers(0, { VertexBufferView(mesh->position_vb, 0,
+                            mesh->vb_count * sizeof(Float3U), sizeof(Float3U)) });
+                        cmdbuf->set_index_buffer({mesh->ib, 0, (u32)(mesh->ib_count * sizeof(u32)), Format::r32_uint});
+                        bound_mesh = mesh;
                     }
+                    luexp(draw_batch(b));
                 }
+                cmdbuf->end_render_pass();
+                bound_mesh = nullptr;
             }
-            
+
             RenderPassDesc render_pass;
-            render_pass.color_attachments[0] = ColorAttachment(base_color_roughness_tex, LoadOp::clear, StoreOp::store, Float4U(0.0f));
-            render_pass.color_attachments[1] = ColorAttachment(normal_metallic_tex, LoadOp::clear, StoreOp::store, Float4U(0.0f));
-            render_pass.color_attachments[2] = ColorAttachment(emissive_tex, LoadOp::clear, StoreOp::store, Float4U(0.0f));
-            render_pass.depth_stencil_attachment = DepthStencilAttachment(depth_tex, false, LoadOp::clear, StoreOp::store, 1.0F);
-            u32 time_query_begin, time_query_end;
-            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            // Attachments that are not read by succeeding passes are not stored, so that tile-based GPUs can skip writing them to memory.
+            render_pass.color_attachments[0] = ColorAttachment(base_color_roughness_tex, LoadOp::clear, 
+                ctx->get_attachment_store_op("base_color_roughness_texture"), Float4U(0.0f));
+            render_pass.color_attachments[1] = ColorAttachment(normal_metallic_tex, LoadOp::clear, 
+                ctx->get_attachment_store_op("normal_metallic_texture"), Float4U(0.0f));
+            render_pass.color_attachments[2] = ColorAttachment(emissive_tex, LoadOp::clear, 
+                ctx->get_attachment_store_op("emissive_texture"), Float4U(0.0f));
+            render_pass.depth_stencil_attachment = DepthStencilAttachment(depth_tex, false, depth_prepass ? LoadOp::load : LoadOp::clear, 
+                ctx->get_attachment_store_op("depth_texture"), 1.0F);
             if(query_heap)
             {
                 render_pass.timestamp_query_heap = query_heap;
-                render_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                if (!depth_prepass) render_pass.timestamp_query_begin_pass_write_index = time_query_begin;
                 render_pass.timestamp_query_end_pass_write_index = time_query_end;
             }
+            m_pipeline_statistics_pending = false;
+            if (collect_pipeline_statistics)
+            {
+                if (!m_pipeline_statistics_heap)
+                {
+                    // Pipeline statistics are not collected if the query heap cannot be created.
+                    auto heap = device->new_query_heap(QueryHeapDesc(QueryType::pipeline_statistics, 1));
+                    if (succeeded(heap)) m_pipeline_statistics_heap = heap.get();
+                }
+                if (m_pipeline_statistics_heap)
+                {
+                    render_pass.pipeline_statistics_query_heap = m_pipeline_statistics_heap;
+                    render_pass.pipeline_statistics_query_write_index = 0;
+                    m_pipeline_statistics_pending = true;
+                }
+            }
             cmdbuf->begin_render_pass(render_pass);
-            cmdbuf->set_graphics_pipeline_layout(m_global_data->m_geometry_pass_playout);
-            cmdbuf->set_graphics_pipeline_state(m_global_data->m_geometry_pass_pso);
+            cmdbuf->set_graphics_pipeline_layout(playout);
+            if (gpu_driven)
+            {
+                cmdbuf->set_graphics_pipeline_state(depth_prepass ? m_global_data->m_bindless_geometry_depth_equal_pso : m_global_data->m_bindless_geometry_pso);
+            }
+            else
+            {
+                cmdbuf->set_graphics_pipeline_state(depth_prepass ? m_global_data->m_geometry_pass_depth_equal_pso : m_global_data->m_geometry_pass_pso);
+            }
             cmdbuf->set_viewport(Viewport(0.0f, 0.0f, (f32)render_desc.width, (f32)render_desc.height, 0.0f, 1.0f));
             cmdbuf->set_scissor_rect(RectI(0, 0, (i32)render_desc.width, (i32)render_desc.height));
-
-            // Draw Meshes.
-            for (usize i = 0; i < ts.size(); ++i)
+            if (shading_rate != ShadingRate::rate_1x1 && device->check_feature(DeviceFeature::variable_rate_shading).variable_rate_shading)
             {
-                auto model = get_asset_or_async_load_if_not_ready<Model>(rs[i]->model);
-                auto mesh = get_asset_or_async_load_if_not_ready<Mesh>(model->mesh);
-                cmdbuf->set_vertex_buffers(0, { VertexBufferView(mesh->vb, 0,
-                    mesh->vb_count * sizeof(Vertex), sizeof(Vertex)) });
-                cmdbuf->set_index_buffer({mesh->ib, 0, (u32)(mesh->ib_count * sizeof(u32)), Format::r32_uint});
-
-                u32 num_pieces = (u32)mesh->pieces.size();
+                cmdbuf->set_shading_rate(shading_rate);
+            }
 
-                for (u32 j = 0; j < num_pieces; ++j)
+            // Draw meshes. Batches are sorted by material, so that every material is bound once. In GPU-driven mode,
+            // materials are selected by instances, so descriptor sets are bound once and batches are split by meshes only.
+            if (gpu_driven)
+            {
+                luexp(bind_bindless_descriptor_sets());
+            }
+            for (u32 b = 0; b < (u32)batches.size(); ++b)
+            {
+                const GPUSceneBatch& batch = batches[b];
+                if (!gpu_driven && batch.material != bound_material)
                 {
-                    Ref<ITexture> base_color_tex = m_global_data->m_default_base_color;
-                    Ref<ITexture> roughness_tex = m_global_data->m_default_roughness;
-                    Ref<ITexture> normal_tex = m_global_data->m_default_normal;
-                    Ref<ITexture> metallic_tex = m_global_data->m_default_metallic;
-                    Ref<ITexture> emissive_tex = m_global_data->m_default_emissive;
-
-                    if (j < model->materials.size())
-                    {
-                        auto mat = get_asset_or_async_load_if_not_ready<Material>(model->materials[j]);
-                        if (mat)
-                        {
-                            // Set material for this piece.
-                            Ref<ITexture> mat_base_color_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->base_color);
-                            Ref<ITexture> mat_roughness_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->roughness);
-                            Ref<ITexture> mat_normal_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->normal);
-                            Ref<ITexture> mat_metallic_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->metallic);
-                            Ref<ITexture> mat_emissive_tex = get_asset_or_async_load_if_not_ready<ITexture>(mat->emissive);
-                            if (mat_base_color_tex)
-                            {
-                                base_color_tex = mat_base_color_tex;
-                            }
-                            if (mat_roughness_tex)
-                            {
-                                roughness_tex = mat_roughness_tex;
-                            }
-                            if (mat_normal_tex)
-                            {
-                                normal_tex = mat_normal_tex;
-                            }
-                            if (mat_metallic_tex)
-                            {
-                                metallic_tex = mat_metallic_tex;
-                            }
-                            if (mat_emissive_tex)
-                            {
-                                emissive_tex = mat_emissive_tex;
-                            }
-                        }
-                    }
-                    lulet(vs, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_geometry_pass_dlayout)));
-                    luexp(vs->update_descriptors({
-                        WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(camera_cb, 0, (u32)align_upper(sizeof(CameraCB), cb_align))),
-                        WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(model_matrices, i, 1, sizeof(Float4x4) * 2)),
-                        WriteDescriptorSet::read_texture_view(2, TextureViewDesc::tex2d(base_color_tex)),
-                        WriteDescriptorSet::read_texture_view(3, TextureViewDesc::tex2d(roughness_tex)),
-                        WriteDescriptorSet::read_texture_view(4, TextureViewDesc::tex2d(normal_tex)),
-                        WriteDescriptorSet::read_texture_view(5, TextureViewDesc::tex2d(metallic_tex)),
-                        WriteDescriptorSet::read_texture_view(6, TextureViewDesc::tex2d(emissive_tex)),
-                        WriteDescriptorSet::sampler(7, SamplerDesc(Filter::linear, Filter::linear, Filter::linear, TextureAddressMode::repeat, TextureAddressMode::repeat, TextureAddressMode::repeat))
-                        }));
-                    cmdbuf->set_graphics_descriptor_set(0, vs);
-                    cmdbuf->attach_device_object(vs);
-                    cmdbuf->draw_indexed(mesh->pieces[j].num_indices, mesh->pieces[j].first_index_offset, 0);
+                    lulet(ds, get_descriptor_set(device, model_matrices, instances, materials[batch.material]));
+                    cmdbuf->set_graphics_descriptor_set(0, ds);
+                    cmdbuf->attach_device_object(ds);
+                    bound_material = batch.material;
                 }
+                if (batch.mesh != bound_mesh)
+                {
+                    cmdbuf->set_vertex_buffers(0, { VertexBufferView(batch.mesh->vb, 0,
+                        batch.mesh->vb_count * sizeof(QuantizedVertex), sizeof(QuantizedVertex)) });
+                    cmdbuf->set_index_buffer({batch.mesh->ib, 0, (u32)(batch.mesh->ib_count * sizeof(u32)), Format::r32_uint});
+                    bound_mesh = batch.mesh;
+                }
+                luexp(draw_batch(b));
             }
             cmdbuf->end_render_pass();
+
+            // Releases descriptor sets that are not used recently.
+            for (auto iter = m_descriptor_sets.begin(); iter != m_descriptor_sets.end();)
+            {
+                if (iter->second.last_used_execution + DESCRIPTOR_SET_CACHE_LIFETIME < m_num_executions)
+                {
+                    iter = m_descriptor_sets.erase(iter);
+                }
+                else
+                {
+                    ++iter;
+                }
+            }
         }
         lucatchret;
         return ok;
     }
+    R<bool> GeometryPass::read_pipeline_statistics(RHI::PipelineStatistics& statistics)
+    {
+        lutry
+        {
+            if (!m_pipeline_statistics_pending) return false;
+            luexp(m_pipeline_statistics_heap->get_pipeline_statistics_values(0, 1, &statistics));
+        }
+        lucatchret;
+        return true;
+    }
     RV compile_geometry_pass(object_t userdata, RG::IRenderGraphCompiler* compiler)
     {
         lutry
@@ -337,9 +807,9 @@ namespace Luna
             desc.name = "Geometry";
             desc.desc = "Writes scene geometry information to the geometry buffer (G-buffer).";
             desc.input_parameters.push_back({"depth_texture", "The scene depth texture with pre-rendered depth information."});
-            desc.output_parameters.push_back({"base_color_roughness_texture", "The base color (RGB) and roughness (A) G-buffer."});
-            desc.output_parameters.push_back({"normal_metallic_texture", "The normal (RGB) and metallic (A) G-buffer."});
-            desc.output_parameters.push_back({"emissive_texture", "The emissive (RGB) G-buffer."});
+            desc.output_parameters.push_back({"base_color_roughness_texture", "The base color (RGB) and roughness (A) G-buffer.", RHI::TextureStateFlag::color_attachment_write, RHI::BufferStateFlag::automatic, true});
+            desc.output_parameters.push_back({"normal_metallic_texture", "The normal (RGB) and metallic (A) G-buffer.", RHI::TextureStateFlag::color_attachment_write, RHI::BufferStateFlag::automatic, true});
+            desc.output_parameters.push_back({"emissive_texture", "The emissive (RGB) G-buffer.", RHI::TextureStateFlag::color_attachment_write, RHI::BufferStateFlag::automatic, true});
             desc.compile = compile_geometry_pass;
             auto data = new_object<GeometryPassGlobalData>();
             luexp(data->init(RHI::get_main_device()));
@@ -12,6 +12,8 @@
 #include "CommonVertex.hpp"
 #include "../Scene.hpp"
 #include "../ModelRenderer.hpp"
+#include "DepthPyramidPass.hpp"
+#include "GPUScene.hpp"
 
 namespace Luna
 {
@@ -22,6 +24,27 @@ namespace Luna
         Ref<RHI::IPipelineState> m_geometry_pass_pso;
         Ref<RHI::IDescriptorSetLayout> m_geometry_pass_dlayout;
         Ref<RHI::IPipelineLayout> m_geometry_pass_playout;
+        // Used with the depth pre-pass: the depth-only pipeline that reads vertex positions only, and the geometry 
+        // pipeline that shades pixels whose depth equals the pre-pass depth without writing depth.
+        // Both pipelines use `m_geometry_pass_playout`.
+        Ref<RHI::IPipelineState> m_depth_prepass_pso;
+        Ref<RHI::IPipelineState> m_geometry_pass_depth_equal_pso;
+
+        // Used in GPU-driven mode: pipelines that fetch material textures from the bindless resource table of `GPUScene`.
+        // Descriptor set 0 contains per-pass resources, descriptor set 1 is the bindless resource table. 
+        // These are `nullptr` if the device does not support bindless resource tables.
+        Ref<RHI::IPipelineState> m_bindless_geometry_pso;
+        Ref<RHI::IPipelineState> m_bindless_geometry_depth_equal_pso;
+        Ref<RHI::IPipelineState> m_bindless_depth_prepass_pso;
+        Ref<RHI::IDescriptorSetLayout> m_bindless_geometry_dlayout;
+        Ref<RHI::IPipelineLayout> m_bindless_geometry_playout;
+        // The table whose layout is used to create `m_bindless_geometry_playout`. Resources are not registered to this table.
+        Ref<RHI::IBindlessResourceTable> m_bindless_layout_table;
+
+        // Culls instances and writes indirect draw arguments in GPU-driven mode.
+        Ref<RHI::IPipelineState> m_instance_culling_pso;
+        Ref<RHI::IDescriptorSetLayout> m_instance_culling_dlayout;
+        Ref<RHI::IPipelineLayout> m_instance_culling_playout;
 
         Ref<RHI::ITexture> m_default_base_color;    // 1.0f, 1.0f, 1.0f, 1.0f
         Ref<RHI::ITexture> m_default_roughness;    // 0.5f
@@ -32,21 +55,138 @@ namespace Luna
         RV init(RHI::IDevice* device);
     };
 
+    // Identifies one descriptor set that can be reused across frames.
+    struct GeometryDescriptorSetKey
+    {
+        RHI::IBuffer* model_matrices;
+        RHI::IBuffer* instances;
+        GeometryMaterialKey material;
+
+        bool operator==(const GeometryDescriptorSetKey& rhs) const
+        {
+            return model_matrices == rhs.model_matrices && instances == rhs.instances && material == rhs.material;
+        }
+    };
+
+    template <> struct hash<GeometryDescriptorSetKey>
+    {
+        usize operator()(const GeometryDescriptorSetKey& val) const
+        {
+            return memhash<usize>(val.material.textures, sizeof(val.material.textures), (usize)val.model_matrices ^ ((usize)val.instances << 1));
+        }
+    };
+
+    // One mesh piece to draw, sorted by material and mesh so that identical pieces can be drawn in one instanced draw call.
+    struct GeometryDrawItem
+    {
+        // The index of the material in `GeometryPass::m_materials`.
+        u32 material;
+        u32 piece;
+        Mesh* mesh;
+        // The element index of the mesh buffer of this instance in `GeometryPass::model_matrices`.
+        u32 mesh_buffer_index;
+        // The squared distance from the camera to the mesh.
+        f32 distance;
+    };
+
     struct GeometryPass : RG::IRenderPass
     {
         lustruct("GeometryPass", "{addf4399-72e6-4855-83a9-457153a2c5a1}");
         luiimpl();
 
-        Span<Ref<Entity>> ts;
-        Span<Ref<ModelRenderer>> rs;
+        Span<BorrowedRef<Entity>> ts;
+        Span<BorrowedRef<ModelRenderer>> rs;
+        // The model-to-world matrix of every mesh in `ts`.
+        Span<const Float4x4> model_to_world_matrices;
+        // Whether to cull meshes and generate draw arguments on GPU. If `true`, `ts` and `rs` should contain all meshes 
+        // of the scene. This requires `RHI::DeviceFeature::unbound_descriptor_array`.
+        bool gpu_driven = false;
         Ref<RHI::IBuffer> camera_cb;
+        // Whether to render depth in one depth-only pass before shading meshes. If `true`, meshes are drawn 
+        // front-to-back with vertex positions only first, then shaded with depth-equal testing so that every pixel
+        // is shaded once.
+        bool depth_prepass = false;
+        // The camera position in world space, used to sort meshes front-to-back.
+        Float3U camera_position = Float3U(0.0f);
+        // The persistent mesh buffers of all entities, see `SceneGPUData::mesh_buffers`.
         Ref<RHI::IBuffer> model_matrices;
+        // The element index of the mesh buffer of every mesh in `ts` in `model_matrices`.
+        Span<const u32> model_matrix_indices;
+        // The shading rate used to draw meshes. Ignored if variable rate shading is not supported.
+        RHI::ShadingRate shading_rate = RHI::ShadingRate::rate_1x1;
+        // The depth data of the last frame used to cull occluded meshes. Meshes are not culled if this is `nullptr`.
+        // Not used in GPU-driven mode.
+        const DepthPyramidReadback* occlusion_culling_data = nullptr;
+        // The depth pyramid of the last frame used to cull occluded meshes in GPU-driven mode, see `DepthPyramidPass`.
+        // Meshes are not culled by depth if this is `nullptr`.
+        Ref<RHI::ITexture> occlusion_depth_pyramid;
+        // The world-to-projection matrix used to render `occlusion_depth_pyramid`.
+        Float4x4U occlusion_world_to_proj;
+        // Whether to collect pipeline statistics of this pass.
+        bool collect_pipeline_statistics = false;
+        // The number of meshes culled in the last execution. Meshes culled on GPU are not counted.
+        u32 num_culled_meshes = 0;
+        // The number of draw calls recorded in the last execution.
+        u32 num_draw_calls = 0;
 
         RV init(GeometryPassGlobalData* global_data);
         RV execute(RG::IRenderPassContext* ctx) override;
+        // Reads pipeline statistics written by the last execution of this pass. The command buffer that executed 
+        // this pass must be completed before calling this.
+        // Returns `false` if pipeline statistics are not collected in the last execution.
+        R<bool> read_pipeline_statistics(RHI::PipelineStatistics& statistics);
 
         private:
+        RV build_draw_list(RHI::ICommandBuffer* cmdbuf);
+        RV cull_on_gpu(RHI::ICommandBuffer* cmdbuf);
+        R<RHI::IDescriptorSet*> get_descriptor_set(RHI::IDevice* device, RHI::IBuffer* model_matrices, RHI::IBuffer* instances,
+            const GeometryMaterialKey& material);
+        R<RHI::IDescriptorSet*> get_bindless_descriptor_set(RHI::IDevice* device);
+
+        struct CachedDescriptorSet
+        {
+            Ref<RHI::IDescriptorSet> descriptor_set;
+            // Keeps resources referred by the key alive, so that their addresses are not reused by other resources
+            // while the entry is in the cache.
+            Ref<RHI::IBuffer> model_matrices;
+            Ref<RHI::IBuffer> instances;
+            Ref<RHI::ITexture> textures[5];
+            u64 last_used_execution;
+        };
+
         Ref<GeometryPassGlobalData> m_global_data;
+        // Descriptor sets are reused across executions as long as their bound resources do not change, entries
+        // not used for several executions are released.
+        HashMap<GeometryDescriptorSetKey, CachedDescriptorSet> m_descriptor_sets;
+        Ref<RHI::IBuffer> m_cached_camera_cb;
+        u64 m_num_executions = 0;
+        // The mesh buffer index of every instance, ordered by draw items. The command buffer that executed this pass
+        // last time is waited before this pass is executed again, so the buffer can be rewritten every execution.
+        Ref<RHI::IBuffer> m_instance_buffer;
+        usize m_instance_buffer_capacity = 0;
+        // Unique materials of the current execution.
+        Vector<GeometryMaterialKey> m_materials;
+        HashMap<GeometryMaterialKey, u32> m_material_indices;
+        Vector<GeometryDrawItem> m_draw_items;
+        // Draw items merged into instanced draw calls, and the distance of the nearest instance of every batch.
+        Vector<GPUSceneBatch> m_draw_batches;
+        Vector<f32> m_batch_distances;
+        // The order of batches drawn by the depth pre-pass.
+        Vector<u32> m_prepass_batch_order;
+        // Data used in GPU-driven mode.
+        GPUScene m_gpu_scene;
+        Ref<RHI::IBuffer> m_culling_params_cb;
+        Ref<RHI::IDescriptorSet> m_culling_ds;
+        // The descriptor set 0 of bindless pipelines, updated when the scene or bound buffers change.
+        Ref<RHI::IDescriptorSet> m_bindless_ds;
+        u64 m_bindless_ds_scene_version = 0;
+        Ref<RHI::IBuffer> m_bindless_ds_model_matrices;
+        Vector<Mesh*> m_object_meshes;
+        Vector<GeometryMaterialKey> m_piece_materials;
+        Ref<RHI::IQueryHeap> m_pipeline_statistics_heap;
+        bool m_pipeline_statistics_pending = false;
+        // The visibility of every mesh in the current execution.
+        Vector<bool> m_visible;
 
     };
 
@@ -0,0 +1,179 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file LightCullingPass.cpp
+* @author JXMaster
+* @date 2024/5/5
+*/
+#include "LightCullingPass.hpp"
+#include <Luna/Runtime/File.hpp>
+#include "../SceneRenderer.hpp"
+#include "../StudioHeader.hpp"
+
+namespace Luna
+{
+    // The number of clusters processed by one thread group. This must match LIGHT_CULLING_GROUP_SIZE in LightCullingCS.hlsl.
+    constexpr u32 LIGHT_CULLING_GROUP_SIZE = 64;
+
+    struct LightCullingParamsCB
+    {
+        UInt3U cluster_count;
+        u32 num_lights;
+        f32 slice_scale;
+        f32 slice_bias;
+    };
+    RV LightCullingPassGlobalData::init(RHI::IDevice* device)
+    {
+        using namespace RHI;
+        lutry
+        {
+            luset(m_light_culling_pass_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
+                        DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::uniform_buffer_view(1, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_buffer_view(2, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_write_buffer_view(3, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_write_buffer_view(4, 1, ShaderVisibilityFlag::compute)
+                        })));
+            auto dlayout = m_light_culling_pass_dlayout.get();
+            luset(m_light_culling_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dlayout, 1 },
+                PipelineLayoutFlag::deny_vertex_shader_access |
+                PipelineLayoutFlag::deny_pixel_shader_access)));
+
+            lulet(cs_blob, compile_shader("Shaders/LightCullingCS.hlsl", ShaderCompiler::ShaderType::compute));
+
+            ComputePipelineStateDesc ps_desc;
+            fill_compute_pipeline_state_desc_from_compile_result(ps_desc, cs_blob);
+            ps_desc.pipeline_layout = m_light_culling_pass_playout;
+            luset(m_light_culling_pass_pso, device->new_compute_pipeline_state(ps_desc));
+        }
+        lucatchret;
+        return ok;
+    }
+    RV LightCullingPass::init(LightCullingPassGlobalData* global_data)
+    {
+        using namespace RHI;
+        lutry
+        {
+            m_global_data = global_data;
+            auto device = m_global_data->m_light_culling_pass_dlayout->get_device();
+            luset(m_ds, device->new_descriptor_set(
+                DescriptorSetDesc(global_data->m_light_culling_pass_dlayout)));
+            luset(m_light_culling_params_cb, device->new_buffer(MemoryType::upload,
+                BufferDesc(BufferUsageFlag::uniform_buffer,
+                    align_upper(sizeof(LightCullingParamsCB), device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment))));
+        }
+        lucatchret;
+        return ok;
+    }
+    RV LightCullingPass::execute(RG::IRenderPassContext* ctx)
+    {
+        using namespace RHI;
+        lutry
+        {
+            // The light params buffer always contains at least one light, see `SceneRenderer::render`.
+            u32 num_lights = light_ts.empty() ? 1 : (u32)light_ts.size();
+            LightCullingParamsCB* mapped = nullptr;
+            luexp(m_light_culling_params_cb->map(0, 0, (void**)&mapped));
+            mapped->cluster_count = cluster_params.cluster_count;
+            mapped->num_lights = num_lights;
+            mapped->slice_scale = cluster_params.slice_scale;
+            mapped->slice_bias = cluster_params.slice_bias;
+            m_light_culling_params_cb->unmap(0, sizeof(LightCullingParamsCB));
+            Ref<IBuffer> light_grid = ctx->get_output("light_grid");
+            Ref<IBuffer> light_indices = ctx->get_output("light_indices");
+            u32 num_clusters = cluster_params.cluster_count.x * cluster_params.cluster_count.y * cluster_params.cluster_count.z;
+            auto cmdbuf = ctx->get_command_buffer();
+            auto device = cmdbuf->get_device();
+            auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+            ComputePassDesc compute_pass;
+            u32 time_query_begin, time_query_end;
+            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            if(query_heap)
+            {
+                compute_pass.timestamp_query_heap = query_heap;
+                compute_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                compute_pass.timestamp_query_end_pass_write_index = time_query_end;
+            }
+            cmdbuf->begin_compute_pass(compute_pass);
+            cmdbuf->resource_barrier(
+                { 
+                    {camera_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none},
+                    {m_light_culling_params_cb, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none},
+                    {light_params, BufferStateFlag::automatic, BufferStateFlag::shader_read_cs, ResourceBarrierFlag::none}
+                }, {});
+            luexp(m_ds->update_descriptors({
+                WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(camera_cb, 0, (u32)align_upper(sizeof(CameraCB), cb_align))),
+                WriteDescriptorSet::uniform_buffer_view(1, BufferViewDesc::uniform_buffer(m_light_culling_params_cb, 0, (u32)align_upper(sizeof(LightCullingParamsCB), cb_align))),
+                WriteDescriptorSet::read_buffer_view(2, BufferViewDesc::structured_buffer(light_params, light_params_first_element, num_lights, sizeof(LightingParams))),
+                WriteDescriptorSet::read_write_buffer_view(3, BufferViewDesc::structured_buffer(light_grid, 0, num_clusters, sizeof(u32))),
+                WriteDescriptorSet::read_write_buffer_view(4, BufferViewDesc::structured_buffer(light_indices, 0, num_clusters * MAX_LIGHTS_PER_CLUSTER, sizeof(u32))),
+                }));
+            cmdbuf->set_compute_pipeline_layout(m_global_data->m_light_culling_pass_playout);
+            cmdbuf->set_compute_pipeline_state(m_global_data->m_light_culling_pass_pso);
+            cmdbuf->set_compute_descriptor_set(0, m_ds);
+            cmdbuf->dispatch(align_upper(num_clusters, LIGHT_CULLING_GROUP_SIZE) / LIGHT_CULLING_GROUP_SIZE, 1, 1);
+            cmdbuf->end_compute_pass();
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV compile_light_culling_pass(object_t userdata, RG::IRenderGraphCompiler* compiler)
+    {
+        lutry
+        {
+            LightCullingPassGlobalData* data = (LightCullingPassGlobalData*)userdata;
+            auto light_grid = compiler->get_output_resource("light_grid");
+            auto light_indices = compiler->get_output_resource("light_indices");
+            if(light_grid == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "LightCullingPass: Output \"light_grid\" is not specified.");
+            if(light_indices == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "LightCullingPass: Output \"light_indices\" is not specified.");
+            RG::ResourceDesc desc = compiler->get_resource_desc(light_grid);
+            if (desc.type != RG::ResourceType::buffer)
+            {
+                return set_error(BasicError::bad_arguments(), "LightCullingPass: Output \"light_grid\" must be one buffer.");
+            }
+            desc.buffer.usages |= RHI::BufferUsageFlag::read_write_buffer;
+            compiler->set_resource_desc(light_grid, desc);
+
+            desc = compiler->get_resource_desc(light_indices);
+            if (desc.type != RG::ResourceType::buffer)
+            {
+                return set_error(BasicError::bad_arguments(), "LightCullingPass: Output \"light_indices\" must be one buffer.");
+            }
+            desc.buffer.usages |= RHI::BufferUsageFlag::read_write_buffer;
+            compiler->set_resource_desc(light_indices, desc);
+
+            Ref<LightCullingPass> pass = new_object<LightCullingPass>();
+            luexp(pass->init(data));
+            compiler->set_render_pass_object(pass);
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV register_light_culling_pass()
+    {
+        lutry
+        {
+            register_boxed_type<LightCullingPassGlobalData>();
+            register_boxed_type<LightCullingPass>();
+            impl_interface_for_type<LightCullingPass, RG::IRenderPass>();
+            RG::RenderPassTypeDesc desc;
+            desc.name = "LightCulling";
+            desc.desc = "Assigns lights to view-space clusters.";
+            desc.output_parameters.push_back({"light_grid", "The number of lights of every cluster.", 
+                RHI::TextureStateFlag::automatic, RHI::BufferStateFlag::shader_write_cs, true});
+            desc.output_parameters.push_back({"light_indices", "The light indices of every cluster.", 
+                RHI::TextureStateFlag::automatic, RHI::BufferStateFlag::shader_write_cs, true});
+            desc.compile = compile_light_culling_pass;
+            auto data = new_object<LightCullingPassGlobalData>();
+            luexp(data->init(RHI::get_main_device()));
+            desc.userdata = data.object();
+            RG::register_render_pass_type(desc);
+        }
+        lucatchret;
+        return ok;
+    }
+}
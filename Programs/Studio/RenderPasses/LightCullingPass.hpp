@@ -0,0 +1,86 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file LightCullingPass.hpp
+* @author JXMaster
+* @date 2024/5/5
+*/
+#pragma once
+#include <Luna/RG/RenderPass.hpp>
+#include "../Scene.hpp"
+
+namespace Luna
+{
+    // The light cluster layout. These values must match the values in Shaders/LightCluster.hlsl.
+    constexpr u32 LIGHT_CLUSTER_TILE_SIZE = 64;
+    constexpr u32 LIGHT_CLUSTER_Z_SLICES = 24;
+    constexpr u32 MAX_LIGHTS_PER_CLUSTER = 128;
+
+    // Describes how the view frustum is split into light clusters.
+    struct LightClusterParams
+    {
+        UInt3U cluster_count;
+        // Maps log2 of view-space depth to depth slices: `slice = log2(z) * slice_scale - slice_bias`.
+        f32 slice_scale;
+        f32 slice_bias;
+    };
+
+    // Gets the number of light clusters in every dimension for the specified render size.
+    inline UInt3U get_light_cluster_count(const UInt2U& render_size)
+    {
+        return UInt3U(
+            (u32)align_upper(max<u32>(render_size.x, 1), LIGHT_CLUSTER_TILE_SIZE) / LIGHT_CLUSTER_TILE_SIZE,
+            (u32)align_upper(max<u32>(render_size.y, 1), LIGHT_CLUSTER_TILE_SIZE) / LIGHT_CLUSTER_TILE_SIZE,
+            LIGHT_CLUSTER_Z_SLICES);
+    }
+
+    // Computes light cluster parameters from the render size and the depth range of the camera.
+    inline LightClusterParams make_light_cluster_params(const UInt2U& render_size, f32 z_near, f32 z_far)
+    {
+        LightClusterParams r;
+        r.cluster_count = get_light_cluster_count(render_size);
+        z_near = max(z_near, 0.0001f);
+        z_far = max(z_far, z_near * 2.0f);
+        f32 log_range = log2f(z_far / z_near);
+        r.slice_scale = (f32)LIGHT_CLUSTER_Z_SLICES / log_range;
+        r.slice_bias = (f32)LIGHT_CLUSTER_Z_SLICES * log2f(z_near) / log_range;
+        return r;
+    }
+
+    struct LightCullingPassGlobalData
+    {
+        lustruct("LightCullingPassGlobalData", "{3f1b8c2e-6a4d-4e57-9c0b-d8e27a5f1463}");
+
+        Ref<RHI::IPipelineState> m_light_culling_pass_pso;
+        Ref<RHI::IDescriptorSetLayout> m_light_culling_pass_dlayout;
+        Ref<RHI::IPipelineLayout> m_light_culling_pass_playout;
+
+        RV init(RHI::IDevice* device);
+    };
+
+    // Assigns lights to view-space clusters (froxels), so that the lighting pass only evaluates lights
+    // that may affect every pixel.
+    struct LightCullingPass : RG::IRenderPass
+    {
+        lustruct("LightCullingPass", "{a86e0d47-2c19-4b3f-8e5a-71f4c9b2d038}");
+        luiimpl();
+
+        LightClusterParams cluster_params;
+        Span<BorrowedRef<Entity>> light_ts;
+        Ref<RHI::IBuffer> camera_cb;
+        Ref<RHI::IBuffer> light_params;
+        u64 light_params_first_element = 0;
+
+        RV init(LightCullingPassGlobalData* global_data);
+        RV execute(RG::IRenderPassContext* ctx) override;
+
+        private:
+        Ref<LightCullingPassGlobalData> m_global_data;
+        Ref<RHI::IBuffer> m_light_culling_params_cb;
+        Ref<RHI::IDescriptorSet> m_ds;
+    };
+
+    RV register_light_culling_pass();
+}
@@ -0,0 +1,270 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ShadowPass.cpp
+* @author JXMaster
+* @date 2024/5/8
+*/
+#include "ShadowPass.hpp"
+#include "../StudioHeader.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/RHI/Utility.hpp>
+
+namespace Luna
+{
+    RV ShadowPassGlobalData::init(RHI::IDevice* device)
+    {
+        using namespace RHI;
+        lutry
+        {
+            lulet(vs_blob, compile_shader("Shaders/ShadowVert.hlsl", ShaderCompiler::ShaderType::vertex, true));
+            lulet(ps_blob, compile_shader("Shaders/ShadowPixel.hlsl", ShaderCompiler::ShaderType::pixel, true));
+            ShaderReflectionStage stages[] = {
+                { &vs_blob.reflection, ShaderVisibilityFlag::vertex },
+                { &ps_blob.reflection, ShaderVisibilityFlag::pixel }
+            };
+            Vector<Ref<IDescriptorSetLayout>> dlayouts;
+            luset(m_shadow_pass_playout, g_env->layout_cache.get_pipeline_layout({ stages, 2 },
+                PipelineLayoutFlag::allow_input_assembler_input_layout, &dlayouts));
+            if (dlayouts.size() != 1) return set_error(BasicError::bad_data(), "ShadowPass shaders must use exactly one descriptor set.");
+            m_shadow_pass_dlayout = dlayouts[0];
+
+            GraphicsPipelineStateDesc ps_desc;
+            ps_desc.primitive_topology = PrimitiveTopology::triangle_list;
+            // Both faces are rendered so that meshes that are not closed still cast shadows. Depth clipping is disabled so
+            // that casters between the light and the near plane of one cascade are clamped to the near plane instead
+            // of being clipped.
+            ps_desc.rasterizer_state = RasterizerDesc(FillMode::solid, CullMode::none, 1000, 2.0f, 0.0f, false, false);
+            ps_desc.depth_stencil_state = DepthStencilDesc(true, true, CompareFunction::less_equal, false, 0x00, 0x00, DepthStencilOpDesc(), DepthStencilOpDesc());
+            ps_desc.ib_strip_cut_value = IndexBufferStripCutValue::disabled;
+            InputAttributeDesc position_attribute("POSITION", 0, 0, 0, 0, Format::rgb32_float);
+            InputBindingDesc position_binding(0, sizeof(Float3U), InputRate::per_vertex);
+            ps_desc.input_layout.attributes = { &position_attribute, 1 };
+            ps_desc.input_layout.bindings = { &position_binding, 1 };
+            ps_desc.vs = get_shader_data_from_compile_result(vs_blob);
+            ps_desc.ps = get_shader_data_from_compile_result(ps_blob);
+            ps_desc.pipeline_layout = m_shadow_pass_playout;
+            ps_desc.num_color_attachments = 0;
+            ps_desc.depth_stencil_format = Format::d32_float;
+            luset(m_shadow_pass_pso, device->new_graphics_pipeline_state(ps_desc));
+        }
+        lucatchret;
+        return ok;
+    }
+
+    // Pipeline constants of ShadowVert.hlsl.
+    struct ShadowDrawParams
+    {
+        Float4x4U world_to_proj;
+        u32 first_instance;
+    };
+
+    RV ShadowPass::init(ShadowPassGlobalData* global_data)
+    {
+        lutry
+        {
+            m_global_data = global_data;
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV ShadowPass::execute(RG::IRenderPassContext* ctx)
+    {
+        using namespace RHI;
+        lutry
+        {
+            Ref<ITexture> atlas = ctx->get_output("shadow_atlas");
+            auto cmdbuf = ctx->get_command_buffer();
+            auto device = cmdbuf->get_device();
+            auto atlas_desc = atlas->get_desc();
+            // Tiles of one new atlas have no valid content, so all of them are rendered.
+            bool render_all = m_rendered_atlas != atlas;
+            m_rendered_atlas = atlas;
+
+            // Builds instanced draw calls of tiles to render. Casters of every tile are sorted by mesh and piece, so that
+            // identical pieces can be drawn by one draw call.
+            m_rendered_tiles.clear();
+            m_batches.clear();
+            m_tile_batch_offsets.clear();
+            m_instance_indices.clear();
+            for (u32 t = 0; t < (u32)tiles.size() && t < atlas_desc.array_size; ++t)
+            {
+                const ShadowTile& tile = tiles[t];
+                if (!tile.dirty && !render_all) continue;
+                m_rendered_tiles.push_back(t);
+                m_tile_batch_offsets.push_back((u32)m_batches.size());
+                m_items.clear();
+                for (auto& caster : tile.casters)
+                {
+                    for (u32 p = 0; p < (u32)caster.mesh->pieces.size(); ++p)
+                    {
+                        m_items.push_back({ caster.mesh, p, caster.transform_index });
+                    }
+                }
+                sort(m_items.begin(), m_items.end(), [](const ShadowDrawItem& lhs, const ShadowDrawItem& rhs)
+                {
+                    if (lhs.mesh != rhs.mesh) return lhs.mesh < rhs.mesh;
+                    return lhs.piece < rhs.piece;
+                });
+                for (auto& item : m_items)
+                {
+                    if (m_batches.size() == m_tile_batch_offsets.back() ||
+                        m_batches.back().mesh != item.mesh || m_batches.back().piece != item.piece)
+                    {
+                        m_batches.push_back({ item.mesh, item.piece, (u32)m_instance_indices.size(), 0 });
+                    }
+                    ++m_batches.back().num_instances;
+                    m_instance_indices.push_back(item.mesh_buffer_index);
+                }
+            }
+            m_tile_batch_offsets.push_back((u32)m_batches.size());
+            num_rendered_tiles = (u32)m_rendered_tiles.size();
+
+            u32 time_query_begin, time_query_end;
+            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            if (m_rendered_tiles.empty())
+            {
+                // All tiles are cached, only timestamps are written.
+                if (query_heap)
+                {
+                    CopyPassDesc copy_pass;
+                    copy_pass.timestamp_query_heap = query_heap;
+                    copy_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                    copy_pass.timestamp_query_end_pass_write_index = time_query_end;
+                    cmdbuf->begin_copy_pass(copy_pass);
+                    cmdbuf->end_copy_pass();
+                }
+                return ok;
+            }
+
+            // Writes the mesh buffer index of every instance. The command buffer that executed this pass last time is
+            // completed before this pass is executed again, so the buffer can be rewritten.
+            usize num_instances = max<usize>(m_instance_indices.size(), 1);
+            if (m_instance_buffer_capacity < num_instances)
+            {
+                usize capacity = max<usize>(m_instance_buffer_capacity * 2, num_instances);
+                luset(m_instance_buffer, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::read_buffer, sizeof(u32) * capacity)));
+                m_instance_buffer_capacity = capacity;
+            }
+            if (!m_instance_indices.empty())
+            {
+                void* mapped = nullptr;
+                luexp(m_instance_buffer->map(0, 0, &mapped));
+                memcpy(mapped, m_instance_indices.data(), sizeof(u32) * m_instance_indices.size());
+                m_instance_buffer->unmap(0, sizeof(u32) * m_instance_indices.size());
+            }
+            if (!m_ds || m_bound_model_matrices != model_matrices || m_bound_instance_buffer != m_instance_buffer)
+            {
+                if (!m_ds)
+                {
+                    luset(m_ds, device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_shadow_pass_dlayout)));
+                }
+                luexp(m_ds->update_descriptors({
+                    WriteDescriptorSet::read_buffer_view(0, BufferViewDesc::structured_buffer(model_matrices, 0,
+                        (u32)(model_matrices->get_desc().size / (sizeof(Float4x4) * 2)), sizeof(Float4x4) * 2)),
+                    WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(m_instance_buffer, 0,
+                        (u32)m_instance_buffer_capacity, sizeof(u32)))
+                    }));
+                m_bound_model_matrices = model_matrices;
+                m_bound_instance_buffer = m_instance_buffer;
+            }
+            cmdbuf->resource_barrier({
+                {model_matrices, BufferStateFlag::automatic, BufferStateFlag::shader_read_vs, ResourceBarrierFlag::none}
+            }, {
+                {atlas, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::depth_stencil_attachment_write, ResourceBarrierFlag::none}
+            });
+
+            // Every tile is one array slice of the atlas, so that every tile can be cleared and rendered by its own
+            // render pass without touching other tiles.
+            for (usize i = 0; i < m_rendered_tiles.size(); ++i)
+            {
+                u32 t = m_rendered_tiles[i];
+                RenderPassDesc render_pass;
+                render_pass.depth_stencil_attachment = DepthStencilAttachment(atlas, false, LoadOp::clear, StoreOp::store, 1.0f,
+                    LoadOp::dont_care, StoreOp::dont_care, 0, TextureViewType::tex2darray, Format::d32_float, 0, t);
+                if (query_heap)
+                {
+                    render_pass.timestamp_query_heap = query_heap;
+                    if (i == 0) render_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                    if (i + 1 == m_rendered_tiles.size()) render_pass.timestamp_query_end_pass_write_index = time_query_end;
+                }
+                cmdbuf->begin_render_pass(render_pass);
+                cmdbuf->set_graphics_pipeline_layout(m_global_data->m_shadow_pass_playout);
+                cmdbuf->set_graphics_pipeline_state(m_global_data->m_shadow_pass_pso);
+                cmdbuf->set_graphics_descriptor_set(0, m_ds);
+                cmdbuf->set_viewport(Viewport(0.0f, 0.0f, (f32)atlas_desc.width, (f32)atlas_desc.height, 0.0f, 1.0f));
+                cmdbuf->set_scissor_rect(RectI(0, 0, (i32)atlas_desc.width, (i32)atlas_desc.height));
+                ShadowDrawParams params;
+                params.world_to_proj = tiles[t].world_to_proj;
+                cmdbuf->set_graphics_constants(0, 16, &params.world_to_proj);
+                Mesh* bound_mesh = nullptr;
+                for (u32 b = m_tile_batch_offsets[i]; b < m_tile_batch_offsets[i + 1]; ++b)
+                {
+                    const ShadowDrawBatch& batch = m_batches[b];
+                    if (batch.mesh != bound_mesh)
+                    {
+                        cmdbuf->set_vertex_buffers(0, { VertexBufferView(batch.mesh->position_vb, 0,
+                            batch.mesh->vb_count * sizeof(Float3U), sizeof(Float3U)) });
+                        cmdbuf->set_index_buffer({batch.mesh->ib, 0, (u32)(batch.mesh->ib_count * sizeof(u32)), Format::r32_uint});
+                        bound_mesh = batch.mesh;
+                    }
+                    // See `GeometryPass::execute` for why the first instance is passed as one pipeline constant.
+                    cmdbuf->set_graphics_constants(16, 1, &batch.first_instance);
+                    auto& piece = batch.mesh->pieces[batch.piece];
+                    cmdbuf->draw_indexed_instanced(piece.num_indices, batch.num_instances, piece.first_index_offset, 0, 0);
+                }
+                cmdbuf->end_render_pass();
+            }
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV compile_shadow_pass(object_t userdata, RG::IRenderGraphCompiler* compiler)
+    {
+        lutry
+        {
+            ShadowPassGlobalData* data = (ShadowPassGlobalData*)userdata;
+            auto shadow_atlas = compiler->get_output_resource("shadow_atlas");
+            if (shadow_atlas == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "ShadowPass: Output \"shadow_atlas\" is not specified.");
+            RG::ResourceDesc desc = compiler->get_resource_desc(shadow_atlas);
+            if (desc.type != RG::ResourceType::texture || desc.texture.type != RHI::TextureType::tex2d || desc.texture.format != RHI::Format::d32_float)
+            {
+                return set_error(BasicError::bad_arguments(), "ShadowPass: Invalid format for \"shadow_atlas\" is specified. \"shadow_atlas\" must be 2D texture with Format::d32_float.");
+            }
+            desc.texture.usages |= RHI::TextureUsageFlag::depth_stencil_attachment;
+            compiler->set_resource_desc(shadow_atlas, desc);
+
+            Ref<ShadowPass> pass = new_object<ShadowPass>();
+            luexp(pass->init(data));
+            compiler->set_render_pass_object(pass);
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV register_shadow_pass()
+    {
+        lutry
+        {
+            register_boxed_type<ShadowPassGlobalData>();
+            register_boxed_type<ShadowPass>();
+            impl_interface_for_type<ShadowPass, RG::IRenderPass>();
+            RG::RenderPassTypeDesc desc;
+            desc.name = "Shadow";
+            desc.desc = "Renders dirty tiles of the shadow atlas.";
+            desc.output_parameters.push_back({"shadow_atlas", "The shadow atlas, every array slice of which stores one shadow tile.",
+                RHI::TextureStateFlag::depth_stencil_attachment_write, RHI::BufferStateFlag::automatic, false});
+            desc.compile = compile_shadow_pass;
+            auto data = new_object<ShadowPassGlobalData>();
+            luexp(data->init(RHI::get_main_device()));
+            desc.userdata = data.object();
+            RG::register_render_pass_type(desc);
+        }
+        lucatchret;
+        return ok;
+    }
+}
@@ -0,0 +1,82 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ShadowPass.hpp
+* @author JXMaster
+* @date 2024/5/8
+*/
+#pragma once
+#include <Luna/RG/RenderPass.hpp>
+#include "../SceneShadows.hpp"
+
+namespace Luna
+{
+    struct ShadowPassGlobalData
+    {
+        lustruct("ShadowPassGlobalData", "{6f3d0b52-8e1a-4c79-b4d2-93a5e7c10f68}");
+
+        Ref<RHI::IPipelineState> m_shadow_pass_pso;
+        Ref<RHI::IDescriptorSetLayout> m_shadow_pass_dlayout;
+        Ref<RHI::IPipelineLayout> m_shadow_pass_playout;
+
+        RV init(RHI::IDevice* device);
+    };
+
+    // Renders depth of shadow casters to tiles of the shadow atlas. The shadow atlas should be one persistent resource,
+    // since only dirty tiles are rendered and other tiles keep their content from the last execution.
+    struct ShadowPass : RG::IRenderPass
+    {
+        lustruct("ShadowPass", "{1c84e2f7-5a3b-4d96-9e07-b8f26d4a13c5}");
+        luiimpl();
+
+        // Tiles of the shadow atlas, see `SceneShadows::tiles`.
+        Span<const ShadowTile> tiles;
+        // The persistent mesh buffers of all entities, see `SceneGPUData::mesh_buffers`.
+        Ref<RHI::IBuffer> model_matrices;
+        // The number of tiles rendered in the last execution.
+        u32 num_rendered_tiles = 0;
+
+        RV init(ShadowPassGlobalData* global_data);
+        RV execute(RG::IRenderPassContext* ctx) override;
+
+        private:
+        // One mesh piece to draw to one tile.
+        struct ShadowDrawItem
+        {
+            Mesh* mesh;
+            u32 piece;
+            u32 mesh_buffer_index;
+        };
+        // One instanced draw call of one tile.
+        struct ShadowDrawBatch
+        {
+            Mesh* mesh;
+            u32 piece;
+            u32 first_instance;
+            u32 num_instances;
+        };
+
+        Ref<ShadowPassGlobalData> m_global_data;
+        Ref<RHI::IDescriptorSet> m_ds;
+        // Resources bound to `m_ds`.
+        Ref<RHI::IBuffer> m_bound_model_matrices;
+        Ref<RHI::IBuffer> m_bound_instance_buffer;
+        // The shadow atlas rendered in the last execution. All tiles are rendered if the atlas is recreated.
+        Ref<RHI::ITexture> m_rendered_atlas;
+        // The mesh buffer index of every instance, ordered by tiles and batches.
+        Ref<RHI::IBuffer> m_instance_buffer;
+        usize m_instance_buffer_capacity = 0;
+        // Tiles to render in the current execution, the batches of them, and the first batch of every tile to render
+        // plus the number of batches at the end.
+        Vector<u32> m_rendered_tiles;
+        Vector<ShadowDrawBatch> m_batches;
+        Vector<u32> m_tile_batch_offsets;
+        // Scratch buffers for sorting draw items of one tile and collecting instances.
+        Vector<ShadowDrawItem> m_items;
+        Vector<u32> m_instance_indices;
+    };
+
+    RV register_shadow_pass();
+}
@@ -124,7 +124,7 @@ namespace Luna
                     });
                 auto lighting_rt = output_tex;
                 RenderPassDesc render_pass;
-                render_pass.color_attachments[0] = ColorAttachment(output_tex, LoadOp::clear, StoreOp::store, Float4U(0.0f));
+                render_pass.color_attachments[0] = ColorAttachment(output_tex, LoadOp::clear, ctx->get_attachment_store_op(m_global_data->m_texture_name), Float4U(0.0f));
                 if(query_heap)
                 {
                     render_pass.timestamp_query_heap = query_heap;
@@ -16,15 +16,6 @@ namespace Luna
     {
         lustruct("ToneMappingPassGlobalData", "{83957a6a-f27c-44d5-8b74-a83d8050db08}");
 
-        Ref<RHI::IDescriptorSetLayout> m_histogram_clear_pass_dlayout;
-        Ref<RHI::IPipelineLayout> m_histogram_clear_pass_playout;
-        Ref<RHI::IPipelineState> m_histogram_clear_pass_pso;
-        Ref<RHI::IDescriptorSetLayout> m_histogram_pass_dlayout;
-        Ref<RHI::IPipelineLayout> m_histogram_pass_playout;
-        Ref<RHI::IPipelineState> m_histogram_pass_pso;
-        Ref<RHI::IDescriptorSetLayout> m_histogram_collect_pass_dlayout;
-        Ref<RHI::IPipelineLayout> m_histogram_collect_pass_playout;
-        Ref<RHI::IPipelineState> m_histogram_collect_pass_pso;
         Ref<RHI::IDescriptorSetLayout> m_tone_mapping_pass_dlayout;
         Ref<RHI::IPipelineLayout> m_tone_mapping_pass_playout;
         Ref<RHI::IPipelineState> m_tone_mapping_pass_pso;
@@ -32,6 +23,8 @@ namespace Luna
         RV init(RHI::IDevice* device);
     };
 
+    // Converts the HDR image to the LDR image. If auto exposure is enabled, the exposure is derived from the adapted
+    // average luminance computed by the auto exposure pass, so the luminance is never read back to CPU.
     struct ToneMappingPass : RG::IRenderPass
     {
         lustruct("ToneMappingPass", "{66b97075-111b-4915-bc03-7a0f4c477d0b}");
@@ -46,13 +39,7 @@ namespace Luna
         private:
         Ref<ToneMappingPassGlobalData> m_global_data;
         
-        Ref<RHI::IBuffer> m_histogram_cb;
-        Ref<RHI::IBuffer> m_histogram_collect_cb;
         Ref<RHI::IBuffer> m_tone_mapping_cb;
-        Ref<RHI::ITexture> m_lum_tex;
-        Ref<RHI::IDescriptorSet> m_histogram_clear_ds;
-        Ref<RHI::IDescriptorSet> m_histogram_ds;
-        Ref<RHI::IDescriptorSet> m_histogram_collect_ds;
         Ref<RHI::IDescriptorSet> m_tone_mapping_pass_ds;
     };
 
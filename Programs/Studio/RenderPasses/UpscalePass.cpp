@@ -0,0 +1,158 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file UpscalePass.cpp
+* @author JXMaster
+* @date 2024/4/9
+*/
+#include "UpscalePass.hpp"
+#include <Luna/Runtime/File.hpp>
+#include "../SceneRenderer.hpp"
+#include "../StudioHeader.hpp"
+
+namespace Luna
+{
+    RV UpscalePassGlobalData::init(RHI::IDevice* device)
+    {
+        using namespace RHI;
+        lutry
+        {
+            luset(m_upscale_pass_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({
+                        DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_texture_view(TextureViewType::tex2d, 1, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::read_write_texture_view(TextureViewType::tex2d, 2, 1, ShaderVisibilityFlag::compute),
+                        DescriptorSetLayoutBinding::sampler(3, 1, ShaderVisibilityFlag::compute)
+                        })));
+            auto dlayout = m_upscale_pass_dlayout.get();
+            luset(m_upscale_pass_playout, device->new_pipeline_layout(PipelineLayoutDesc({ &dlayout, 1 },
+                PipelineLayoutFlag::deny_vertex_shader_access |
+                PipelineLayoutFlag::deny_pixel_shader_access)));
+
+            lulet(cs_blob, compile_shader("Shaders/UpscaleCS.hlsl", ShaderCompiler::ShaderType::compute));
+
+            ComputePipelineStateDesc ps_desc;
+            fill_compute_pipeline_state_desc_from_compile_result(ps_desc, cs_blob);
+            ps_desc.pipeline_layout = m_upscale_pass_playout;
+            luset(m_upscale_pass_pso, device->new_compute_pipeline_state(ps_desc));
+        }
+        lucatchret;
+        return ok;
+    }
+    RV UpscalePass::init(UpscalePassGlobalData* global_data)
+    {
+        using namespace RHI;
+        lutry
+        {
+            m_global_data = global_data;
+            auto device = m_global_data->m_upscale_pass_dlayout->get_device();
+            luset(m_ds, device->new_descriptor_set(
+                DescriptorSetDesc(global_data->m_upscale_pass_dlayout)));
+            luset(m_upscale_params, device->new_buffer(MemoryType::upload,
+                BufferDesc(BufferUsageFlag::uniform_buffer, 
+                    align_upper(sizeof(Float2U), device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment))));
+        }
+        lucatchret;
+        return ok;
+    }
+    RV UpscalePass::execute(RG::IRenderPassContext* ctx)
+    {
+        using namespace RHI;
+        lutry
+        {
+            Ref<ITexture> src_tex = ctx->get_input("src_texture");
+            Ref<ITexture> dst_tex = ctx->get_output("dst_texture");
+            auto dst_desc = dst_tex->get_desc();
+            Float2U* mapped = nullptr;
+            luexp(m_upscale_params->map(0, 0, (void**)&mapped));
+            *mapped = Float2U(1.0f / (f32)dst_desc.width, 1.0f / (f32)dst_desc.height);
+            m_upscale_params->unmap(0, sizeof(Float2U));
+            auto cmdbuf = ctx->get_command_buffer();
+            ComputePassDesc compute_pass;
+            u32 time_query_begin, time_query_end;
+            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            if(query_heap)
+            {
+                compute_pass.timestamp_query_heap = query_heap;
+                compute_pass.timestamp_query_begin_pass_write_index = time_query_begin;
+                compute_pass.timestamp_query_end_pass_write_index = time_query_end;
+            }
+            cmdbuf->begin_compute_pass(compute_pass);
+            auto device = cmdbuf->get_device();
+            auto cb_align = device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
+            cmdbuf->resource_barrier(
+                { {m_upscale_params, BufferStateFlag::automatic, BufferStateFlag::uniform_buffer_cs, ResourceBarrierFlag::none} }, {});
+            luexp(m_ds->update_descriptors({
+                WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(m_upscale_params, 0, (u32)align_upper(sizeof(Float2U), cb_align))),
+                WriteDescriptorSet::read_texture_view(1, TextureViewDesc::tex2d(src_tex)),
+                WriteDescriptorSet::read_write_texture_view(2, TextureViewDesc::tex2d(dst_tex)),
+                WriteDescriptorSet::sampler(3, SamplerDesc(Filter::linear, Filter::linear, Filter::linear, TextureAddressMode::clamp, TextureAddressMode::clamp, TextureAddressMode::clamp))
+                }));
+            cmdbuf->set_compute_pipeline_layout(m_global_data->m_upscale_pass_playout);
+            cmdbuf->set_compute_pipeline_state(m_global_data->m_upscale_pass_pso);
+            cmdbuf->set_compute_descriptor_set(0, m_ds);
+            cmdbuf->dispatch((u32)align_upper(dst_desc.width, 8) / 8,
+                (u32)align_upper(dst_desc.height, 8) / 8, 1);
+            cmdbuf->end_compute_pass();
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV compile_upscale_pass(object_t userdata, RG::IRenderGraphCompiler* compiler)
+    {
+        lutry
+        {
+            UpscalePassGlobalData* data = (UpscalePassGlobalData*)userdata;
+            auto src_texture = compiler->get_input_resource("src_texture");
+            auto dst_texture = compiler->get_output_resource("dst_texture");
+            if(src_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "UpscalePass: Input \"src_texture\" is not specified.");
+            if(dst_texture == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "UpscalePass: Output \"dst_texture\" is not specified.");
+            RG::ResourceDesc src_desc = compiler->get_resource_desc(src_texture);
+            if (src_desc.type != RG::ResourceType::texture || src_desc.texture.type != RHI::TextureType::tex2d)
+            {
+                return set_error(BasicError::bad_arguments(), "UpscalePass: Input \"src_texture\" must be one 2D texture.");
+            }
+            src_desc.texture.usages |= RHI::TextureUsageFlag::read_texture;
+            compiler->set_resource_desc(src_texture, src_desc);
+
+            RG::ResourceDesc dst_desc = compiler->get_resource_desc(dst_texture);
+            dst_desc.type = RG::ResourceType::texture;
+            dst_desc.texture.type = RHI::TextureType::tex2d;
+            if(dst_desc.texture.format == RHI::Format::unknown) dst_desc.texture.format = src_desc.texture.format;
+            if(!dst_desc.texture.width) dst_desc.texture.width = src_desc.texture.width;
+            if(!dst_desc.texture.height) dst_desc.texture.height = src_desc.texture.height;
+            dst_desc.texture.usages |= RHI::TextureUsageFlag::read_write_texture;
+            compiler->set_resource_desc(dst_texture, dst_desc);
+
+            Ref<UpscalePass> pass = new_object<UpscalePass>();
+            luexp(pass->init(data));
+            compiler->set_render_pass_object(pass);
+        }
+        lucatchret;
+        return ok;
+    }
+
+    RV register_upscale_pass()
+    {
+        lutry
+        {
+            register_boxed_type<UpscalePassGlobalData>();
+            register_boxed_type<UpscalePass>();
+            impl_interface_for_type<UpscalePass, RG::IRenderPass>();
+            RG::RenderPassTypeDesc desc;
+            desc.name = "Upscale";
+            desc.desc = "Upscales one scene texture rendered at a reduced resolution using bilinear filtering.";
+            desc.input_parameters.push_back({"src_texture", "The scene texture rendered at a reduced resolution.", RHI::TextureStateFlag::shader_read_cs});
+            desc.output_parameters.push_back({"dst_texture", "The upscaled scene texture.", RHI::TextureStateFlag::shader_write_cs, RHI::BufferStateFlag::automatic, true});
+            desc.compile = compile_upscale_pass;
+            auto data = new_object<UpscalePassGlobalData>();
+            luexp(data->init(RHI::get_main_device()));
+            desc.userdata = data.object();
+            RG::register_render_pass_type(desc);
+        }
+        lucatchret;
+        return ok;
+    }
+}
@@ -0,0 +1,44 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file UpscalePass.hpp
+* @author JXMaster
+* @date 2024/4/9
+*/
+#pragma once
+#include <Luna/RG/RenderPass.hpp>
+#include "../Scene.hpp"
+
+namespace Luna
+{
+    struct UpscalePassGlobalData
+    {
+        lustruct("UpscalePassGlobalData", "{0b5a0f53-36d2-4a6c-8f0e-5c7c1b9e2d41}");
+
+        Ref<RHI::IPipelineState> m_upscale_pass_pso;
+        Ref<RHI::IDescriptorSetLayout> m_upscale_pass_dlayout;
+        Ref<RHI::IPipelineLayout> m_upscale_pass_playout;
+
+        RV init(RHI::IDevice* device);
+    };
+
+    //! Upscales one HDR scene texture rendered at a reduced resolution to the resolution of the destination texture
+    //! using bilinear filtering.
+    struct UpscalePass : RG::IRenderPass
+    {
+        lustruct("UpscalePass", "{9d3f6e27-51b4-4c8a-a0e2-7f4b36c1d958}");
+        luiimpl();
+
+        RV init(UpscalePassGlobalData* global_data);
+        RV execute(RG::IRenderPassContext* ctx) override;
+
+        private:
+        Ref<UpscalePassGlobalData> m_global_data;
+        Ref<RHI::IBuffer> m_upscale_params;
+        Ref<RHI::IDescriptorSet> m_ds;
+    };
+
+    RV register_upscale_pass();
+}
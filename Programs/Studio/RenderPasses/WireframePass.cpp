@@ -75,7 +75,7 @@ namespace Luna
             ps_desc.ib_strip_cut_value = IndexBufferStripCutValue::disabled;
             Vector<InputAttributeDesc> attributes;
             get_vertex_input_layout_desc(attributes);
-            InputBindingDesc binding(0, sizeof(Vertex), InputRate::per_vertex);
+            InputBindingDesc binding(0, sizeof(QuantizedVertex), InputRate::per_vertex);
             ps_desc.input_layout.bindings = { &binding, 1 };
             ps_desc.input_layout.attributes = { attributes.data(), attributes.size() };
             ps_desc.vs = get_shader_data_from_compile_result(vs_blob);
@@ -108,7 +108,7 @@ namespace Luna
             Ref<ITexture> output_tex = query_interface<ITexture>(ctx->get_output("scene_texture")->get_object());
             // Debug wireframe pass.
             RenderPassDesc render_pass;
-            render_pass.color_attachments[0] = ColorAttachment(output_tex, LoadOp::clear, StoreOp::store, Float4U(0.0f));
+            render_pass.color_attachments[0] = ColorAttachment(output_tex, LoadOp::clear, ctx->get_attachment_store_op("scene_texture"), Float4U(0.0f));
             u32 time_query_begin, time_query_end;
             auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
             if(query_heap)
@@ -118,7 +118,9 @@ namespace Luna
                 render_pass.timestamp_query_end_pass_write_index = time_query_end;
             }
             auto render_desc = output_tex->get_desc();
-            cmdbuf->resource_barrier({}, { {output_tex, SubresourceIndex(0, 0), TextureStateFlag::automatic, TextureStateFlag::color_attachment_write, ResourceBarrierFlag::discard_content} });
+            cmdbuf->resource_barrier({
+                {model_matrices, BufferStateFlag::automatic, BufferStateFlag::shader_read_vs, ResourceBarrierFlag::none}
+            }, {});
             cmdbuf->begin_render_pass(render_pass);
             cmdbuf->set_graphics_pipeline_layout(m_global_data->m_debug_mesh_renderer_playout);
             cmdbuf->set_graphics_pipeline_state(m_global_data->m_debug_mesh_renderer_pso);
@@ -130,7 +132,7 @@ namespace Luna
                 auto vs = device->new_descriptor_set(DescriptorSetDesc(m_global_data->m_debug_mesh_renderer_dlayout)).get();
                 luexp(vs->update_descriptors({
                     WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(camera_cb, 0, (u32)align_upper(sizeof(CameraCB), cb_align))),
-                    WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(model_matrices, i, 1, sizeof(Float4x4) * 2))
+                    WriteDescriptorSet::read_buffer_view(1, BufferViewDesc::structured_buffer(model_matrices, model_matrix_indices[i], 1, sizeof(Float4x4) * 2))
                     }));
                 IDescriptorSet* vs_d = vs.get();
                 cmdbuf->set_graphics_descriptor_sets(0, { &vs_d, 1 });
@@ -140,7 +142,7 @@ namespace Luna
                 auto mesh = get_asset_or_async_load_if_not_ready<Mesh>(get_asset_or_async_load_if_not_ready<Model>(rs[i]->model)->mesh);
 
                 auto vb_view = VertexBufferView(mesh->vb, 0,
-                    mesh->vb_count * sizeof(Vertex), sizeof(Vertex));
+                    mesh->vb_count * sizeof(QuantizedVertex), sizeof(QuantizedVertex));
 
                 cmdbuf->set_vertex_buffers(0, { &vb_view, 1 });
                 cmdbuf->set_index_buffer({mesh->ib, 0, (u32)(mesh->ib_count * sizeof(u32)), Format::r32_uint});
@@ -185,7 +187,7 @@ namespace Luna
             RG::RenderPassTypeDesc desc;
             desc.name = "Wireframe";
             desc.desc = "Draws wireframe of the scene.";
-            desc.output_parameters.push_back({"scene_texture", "The scene texture."});
+            desc.output_parameters.push_back({"scene_texture", "The scene texture.", RHI::TextureStateFlag::color_attachment_write, RHI::BufferStateFlag::automatic, true});
             desc.compile = compile_wireframe_pass;
             auto data = new_object<WireframePassGlobalData>();
             luexp(data->init(RHI::get_main_device()));
@@ -31,11 +31,14 @@ namespace Luna
         lustruct("WireframePass", "{849e92d5-6407-4018-9ee7-4ffa34ab3044}");
         luiimpl();
 
-        Span<Ref<Entity>> ts;
-        Span<Ref<ModelRenderer>> rs;
+        Span<BorrowedRef<Entity>> ts;
+        Span<BorrowedRef<ModelRenderer>> rs;
 
         Ref<RHI::IBuffer> camera_cb;
+        // The persistent mesh buffers of all entities, see `SceneGPUData::mesh_buffers`.
         Ref<RHI::IBuffer> model_matrices;
+        // The element index of the mesh buffer of every mesh in `ts` in `model_matrices`.
+        Span<const u32> model_matrix_indices;
 
         RV init(WireframePassGlobalData* global_data);
         RV execute(RG::IRenderPassContext* ctx) override;
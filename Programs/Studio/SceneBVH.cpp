@@ -0,0 +1,235 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SceneBVH.cpp
+* @author JXMaster
+* @date 2024/5/5
+*/
+#include "SceneBVH.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+
+namespace Luna
+{
+    // The maximum number of objects in one leaf node. Objects in one leaf node are tested together using batch APIs.
+    constexpr u32 BVH_LEAF_SIZE = 8;
+    // The minimum number of objects processed by one job.
+    constexpr usize BVH_OBJECT_GRAIN = 256;
+    // The minimum number of leaf nodes processed by one job.
+    constexpr usize BVH_LEAF_GRAIN = 32;
+
+    void SceneBVH::update(const SceneTransforms& transforms, Span<const u32> transform_indices, Span<const Float3U> mins, Span<const Float3U> maxs)
+    {
+        usize num_objects = transform_indices.size();
+        bool objects_changed = num_objects != m_input_transform_indices.size() ||
+            memcmp(transform_indices.data(), m_input_transform_indices.data(), sizeof(u32) * num_objects) ||
+            memcmp(mins.data(), m_input_mins.data(), sizeof(Float3U) * num_objects) ||
+            memcmp(maxs.data(), m_input_maxs.data(), sizeof(Float3U) * num_objects);
+        if (objects_changed)
+        {
+            m_input_transform_indices.assign(transform_indices);
+            m_input_mins.assign(mins);
+            m_input_maxs.assign(maxs);
+        }
+        // Compute world bounding boxes of objects whose transforms are changed. Bounding boxes of all objects 
+        // are computed if the object set is changed, since the hierarchy needs to be rebuilt from them.
+        object_ids.resize(num_objects);
+        this->transform_indices.resize(num_objects);
+        local_mins.resize(num_objects);
+        local_maxs.resize(num_objects);
+        world_mins.resize(num_objects);
+        world_maxs.resize(num_objects);
+        if (objects_changed)
+        {
+            for (u32 i = 0; i < (u32)num_objects; ++i)
+            {
+                object_ids[i] = i;
+                this->transform_indices[i] = transform_indices[i];
+                local_mins[i] = mins[i];
+                local_maxs[i] = maxs[i];
+            }
+        }
+        volatile u32 any_moved = 0;
+        JobSystem::parallel_for(0, num_objects, BVH_OBJECT_GRAIN, [&](usize i)
+        {
+            u32 t = this->transform_indices[i];
+            if (!objects_changed && !transforms.dirty[t]) return;
+            transform_aabbs(&transforms.local_to_world_matrices[t], &local_mins[i], &local_maxs[i], &world_mins[i], &world_maxs[i], 1);
+            any_moved = 1;
+        });
+        if (objects_changed)
+        {
+            rebuild();
+        }
+        else if (any_moved)
+        {
+            refit();
+        }
+    }
+
+    u32 SceneBVH::build_node(u32 first, u32 count)
+    {
+        u32 index = (u32)nodes.size();
+        nodes.emplace_back();
+        Node& node = nodes[index];
+        node.first_object = first;
+        node.num_objects = count;
+        node.right_child = 0;
+        if (count <= BVH_LEAF_SIZE)
+        {
+            return index;
+        }
+        // Split objects at the median of the longest axis of object centers.
+        Float3 center_min(F32_MAX, F32_MAX, F32_MAX);
+        Float3 center_max(-F32_MAX, -F32_MAX, -F32_MAX);
+        for (u32 i = first; i < first + count; ++i)
+        {
+            Float3 center = (Float3(world_mins[i]) + Float3(world_maxs[i])) * 0.5f;
+            center_min = min(center_min, center);
+            center_max = max(center_max, center);
+        }
+        Float3 extent = center_max - center_min;
+        u32 axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+        // Sort slot indices instead of slots, then permute all slot arrays.
+        Vector<u32> order;
+        order.resize(count);
+        for (u32 i = 0; i < count; ++i) order[i] = first + i;
+        sort(order.begin(), order.end(), [this, axis](u32 lhs, u32 rhs)
+        {
+            return world_mins[lhs].m[axis] + world_maxs[lhs].m[axis] < world_mins[rhs].m[axis] + world_maxs[rhs].m[axis];
+        });
+        auto permute = [&](auto& arr)
+        {
+            using value_type = typename remove_reference_t<decltype(arr)>::value_type;
+            Vector<value_type> tmp;
+            tmp.resize(count);
+            for (u32 i = 0; i < count; ++i) tmp[i] = arr[order[i]];
+            for (u32 i = 0; i < count; ++i) arr[first + i] = tmp[i];
+        };
+        permute(object_ids);
+        permute(transform_indices);
+        permute(local_mins);
+        permute(local_maxs);
+        permute(world_mins);
+        permute(world_maxs);
+        u32 left_count = count / 2;
+        build_node(first, left_count);
+        u32 right_child = build_node(first + left_count, count - left_count);
+        // `nodes` may be reallocated by building children.
+        nodes[index].right_child = right_child;
+        return index;
+    }
+
+    void SceneBVH::rebuild()
+    {
+        nodes.clear();
+        if (object_ids.empty()) return;
+        nodes.reserve(object_ids.size() * 2 / BVH_LEAF_SIZE + 1);
+        build_node(0, (u32)object_ids.size());
+        refit();
+    }
+
+    void SceneBVH::refit()
+    {
+        // Children always come after their parents, so visiting nodes in reverse order updates children first.
+        for (usize i = nodes.size(); i > 0; --i)
+        {
+            Node& node = nodes[i - 1];
+            Float3 bmin, bmax;
+            if (node.right_child)
+            {
+                const Node& left = nodes[i];
+                const Node& right = nodes[node.right_child];
+                bmin = min(Float3(left.min), Float3(right.min));
+                bmax = max(Float3(left.max), Float3(right.max));
+            }
+            else
+            {
+                bmin = world_mins[node.first_object];
+                bmax = world_maxs[node.first_object];
+                for (u32 j = node.first_object + 1; j < node.first_object + node.num_objects; ++j)
+                {
+                    bmin = min(bmin, Float3(world_mins[j]));
+                    bmax = max(bmax, Float3(world_maxs[j]));
+                }
+            }
+            node.min = bmin;
+            node.max = bmax;
+        }
+    }
+
+    // Returns `0` if the box is outside of the frustum, `1` if the box intersects with the frustum, 
+    // and `2` if the box is inside of the frustum.
+    static u32 classify_box(const Frustum& frustum, const Float3U& bmin, const Float3U& bmax)
+    {
+        u32 r = 2;
+        for (u32 p = 0; p < 6; ++p)
+        {
+            const Float4& plane = frustum.planes[p];
+            // The box corner that is farthest along the plane normal, and the corner that is nearest.
+            f32 far_d = plane.w +
+                plane.x * (plane.x >= 0.0f ? bmax.x : bmin.x) +
+                plane.y * (plane.y >= 0.0f ? bmax.y : bmin.y) +
+                plane.z * (plane.z >= 0.0f ? bmax.z : bmin.z);
+            if (far_d < 0.0f) return 0;
+            f32 near_d = plane.w +
+                plane.x * (plane.x >= 0.0f ? bmin.x : bmax.x) +
+                plane.y * (plane.y >= 0.0f ? bmin.y : bmax.y) +
+                plane.z * (plane.z >= 0.0f ? bmin.z : bmax.z);
+            if (near_d < 0.0f) r = 1;
+        }
+        return r;
+    }
+
+    usize SceneBVH::cull(const Frustum& frustum, Vector<u8>& results)
+    {
+        usize num_objects = object_ids.size();
+        results.clear();
+        results.resize(num_objects, 0);
+        if (nodes.empty()) return 0;
+        m_cull_slot_results.clear();
+        m_cull_slot_results.resize(num_objects, 0);
+        // Walk the hierarchy. Subtrees inside of the frustum are accepted without testing objects, leaf 
+        // nodes that intersect with the frustum are collected and tested in parallel.
+        m_cull_stack.clear();
+        m_cull_partial_nodes.clear();
+        m_cull_stack.push_back(0);
+        while (!m_cull_stack.empty())
+        {
+            u32 index = m_cull_stack.back();
+            m_cull_stack.pop_back();
+            const Node& node = nodes[index];
+            u32 c = classify_box(frustum, node.min, node.max);
+            if (c == 0) continue;
+            if (c == 2)
+            {
+                memset(m_cull_slot_results.data() + node.first_object, 1, node.num_objects);
+                continue;
+            }
+            if (node.right_child)
+            {
+                m_cull_stack.push_back(node.right_child);
+                m_cull_stack.push_back(index + 1);
+            }
+            else
+            {
+                m_cull_partial_nodes.push_back(index);
+            }
+        }
+        JobSystem::parallel_for(0, m_cull_partial_nodes.size(), BVH_LEAF_GRAIN, [&](usize i)
+        {
+            const Node& node = nodes[m_cull_partial_nodes[i]];
+            test_aabbs_in_frustum(frustum, world_mins.data() + node.first_object, world_maxs.data() + node.first_object,
+                m_cull_slot_results.data() + node.first_object, node.num_objects);
+        });
+        usize num_visible = 0;
+        for (usize i = 0; i < num_objects; ++i)
+        {
+            results[object_ids[i]] = m_cull_slot_results[i];
+            num_visible += m_cull_slot_results[i];
+        }
+        return num_visible;
+    }
+}
@@ -0,0 +1,68 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SceneBVH.hpp
+* @author JXMaster
+* @date 2024/5/5
+*/
+#pragma once
+#include "SceneTransforms.hpp"
+#include <Luna/Runtime/Math/Batch.hpp>
+
+namespace Luna
+{
+    // One bounding volume hierarchy over world-space bounding boxes of objects in one scene.
+    // Objects are identified by their indices in the arrays passed to `update`. The hierarchy is rebuilt
+    // when the object set changes, and is refitted when only transforms of objects are changed.
+    struct SceneBVH
+    {
+        struct Node
+        {
+            Float3U min;
+            // The first object of this subtree in `object_ids`. Objects of every subtree are stored continuously.
+            u32 first_object;
+            Float3U max;
+            // The number of objects of this subtree.
+            u32 num_objects;
+            // The index of the right child node, or `0` if this is one leaf node. The left child node
+            // is always the next node of this node.
+            u32 right_child;
+        };
+
+        // Nodes in depth-first order, so that children always come after their parents.
+        Vector<Node> nodes;
+        // The object index of every slot. Slots are ordered so that objects of every node are stored continuously.
+        Vector<u32> object_ids;
+        // The transform index, local bounding box and world bounding box of every slot.
+        Vector<u32> transform_indices;
+        Vector<Float3U> local_mins;
+        Vector<Float3U> local_maxs;
+        Vector<Float3U> world_mins;
+        Vector<Float3U> world_maxs;
+
+        // Updates the hierarchy.
+        // `transform_indices`, `mins` and `maxs` specify the transform index in `transforms` and the local
+        // bounding box of every object. `transforms` must be updated before calling this.
+        void update(const SceneTransforms& transforms, Span<const u32> transform_indices, Span<const Float3U> mins, Span<const Float3U> maxs);
+
+        // Tests objects against the frustum. `results` is resized to the number of objects, and every element is 
+        // set to `1` if the object is visible, or `0` otherwise. Returns the number of visible objects.
+        usize cull(const Frustum& frustum, Vector<u8>& results);
+
+    private:
+        // Object data passed to the last `update`, used to detect object set changes.
+        Vector<u32> m_input_transform_indices;
+        Vector<Float3U> m_input_mins;
+        Vector<Float3U> m_input_maxs;
+        // Scratch buffers for culling.
+        Vector<u32> m_cull_stack;
+        Vector<u32> m_cull_partial_nodes;
+        Vector<u8> m_cull_slot_results;
+
+        void rebuild();
+        void refit();
+        u32 build_node(u32 first, u32 count);
+    };
+}
@@ -0,0 +1,124 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file SceneGPUData.cpp
+* @author JXMaster
+* @date 2024/5/7
+*/
+#include "SceneGPUData.hpp"
+
+namespace Luna
+{
+    // Appends one slot to the ranges to upload, the slot is merged to the last range if they are adjacent,
+    // so that adjacent slots are uploaded by one copy command.
+    static void append_upload_range(Vector<Pair<u32, u32>>& ranges, u32 slot)
+    {
+        if (!ranges.empty() && ranges.back().second == slot)
+        {
+            ++ranges.back().second;
+        }
+        else
+        {
+            ranges.push_back(make_pair(slot, slot + 1));
+        }
+    }
+
+    static usize get_upload_range_size(const Vector<Pair<u32, u32>>& ranges)
+    {
+        usize size = 0;
+        for (auto& range : ranges) size += range.second - range.first;
+        return size;
+    }
+
+    RV SceneGPUData::update(RHI::ICommandBuffer* cmdbuf, RHI::IUploadRingBuffer* upload_ring, const SceneTransforms& transforms,
+        Span<const LightingParams> lights)
+    {
+        using namespace RHI;
+        lutry
+        {
+            auto device = cmdbuf->get_device();
+            // Collects entities whose world transforms are changed.
+            usize num_entities = transforms.entities.size();
+            bool upload_all_meshes = false;
+            if (m_mesh_buffer_capacity < max<usize>(num_entities, 1))
+            {
+                usize capacity = max<usize>(max<usize>(m_mesh_buffer_capacity * 2, num_entities), 1);
+                luset(mesh_buffers, device->new_buffer(MemoryType::local,
+                    BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::copy_dest, sizeof(Float4x4) * 2 * capacity)));
+                m_mesh_buffer_capacity = capacity;
+                upload_all_meshes = true;
+            }
+            m_mesh_ranges.clear();
+            for (usize i = 0; i < num_entities; ++i)
+            {
+                if (upload_all_meshes || transforms.dirty[i]) append_upload_range(m_mesh_ranges, (u32)i);
+            }
+            // Collects changed lights. Lights are identified by their indices, so all lights are uploaded if the
+            // number of lights is changed.
+            bool upload_all_lights = lights.size() != m_uploaded_lights.size();
+            if (m_lighting_params_capacity < lights.size())
+            {
+                usize capacity = max<usize>(m_lighting_params_capacity * 2, lights.size());
+                luset(lighting_params, device->new_buffer(MemoryType::local,
+                    BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::copy_dest, sizeof(LightingParams) * capacity)));
+                m_lighting_params_capacity = capacity;
+                upload_all_lights = true;
+            }
+            m_light_ranges.clear();
+            if (upload_all_lights)
+            {
+                m_uploaded_lights.assign(lights.begin(), lights.end());
+                if (!lights.empty()) m_light_ranges.push_back(make_pair(0u, (u32)lights.size()));
+            }
+            else
+            {
+                for (usize i = 0; i < lights.size(); ++i)
+                {
+                    if (!memcmp(&m_uploaded_lights[i], &lights[i], sizeof(LightingParams))) continue;
+                    m_uploaded_lights[i] = lights[i];
+                    append_upload_range(m_light_ranges, (u32)i);
+                }
+            }
+            usize num_meshes = get_upload_range_size(m_mesh_ranges);
+            usize num_lights = get_upload_range_size(m_light_ranges);
+            if (!num_meshes && !num_lights) return ok;
+
+            // Writes changed data to the upload ring and copies them to the persistent buffers.
+            usize mesh_data_size = sizeof(Float4x4) * 2 * num_meshes;
+            usize light_data_size = sizeof(LightingParams) * num_lights;
+            lulet(staging, upload_ring->allocate(mesh_data_size + light_data_size, 16));
+            Vector<BufferBarrier> barriers;
+            if (num_meshes) barriers.push_back({mesh_buffers, BufferStateFlag::automatic, BufferStateFlag::copy_dest, ResourceBarrierFlag::none});
+            if (num_lights) barriers.push_back({lighting_params, BufferStateFlag::automatic, BufferStateFlag::copy_dest, ResourceBarrierFlag::none});
+            cmdbuf->begin_copy_pass();
+            cmdbuf->resource_barrier({barriers.data(), barriers.size()}, {});
+            u8* dst = (u8*)staging.data;
+            u64 src_offset = staging.offset;
+            for (auto& range : m_mesh_ranges)
+            {
+                for (u32 i = range.first; i < range.second; ++i)
+                {
+                    memcpy(dst, transforms.local_to_world_matrices[i].r[0].m, sizeof(Float4x4));
+                    memcpy(dst + sizeof(Float4x4), transforms.world_to_local_matrices[i].r[0].m, sizeof(Float4x4));
+                    dst += sizeof(Float4x4) * 2;
+                }
+                u64 size = sizeof(Float4x4) * 2 * (range.second - range.first);
+                cmdbuf->copy_buffer(mesh_buffers, sizeof(Float4x4) * 2 * range.first, staging.buffer, src_offset, size);
+                src_offset += size;
+            }
+            for (auto& range : m_light_ranges)
+            {
+                u64 size = sizeof(LightingParams) * (range.second - range.first);
+                memcpy(dst, lights.data() + range.first, size);
+                dst += size;
+                cmdbuf->copy_buffer(lighting_params, sizeof(LightingParams) * range.first, staging.buffer, src_offset, size);
+                src_offset += size;
+            }
+            cmdbuf->end_copy_pass();
+        }
+        lucatchret;
+        return ok;
+    }
+}
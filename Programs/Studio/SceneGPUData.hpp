@@ -0,0 +1,56 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file SceneGPUData.hpp
+* @author JXMaster
+* @date 2024/5/7
+*/
+#pragma once
+#include "SceneTransforms.hpp"
+#include <Luna/RHI/RHI.hpp>
+
+namespace Luna
+{
+    struct LightingParams
+    {
+        Float3U strength;
+        f32 attenuation_power;
+        Float3U direction;
+        u32 type;
+        Float3U position;
+        f32 spot_attenuation_power;
+        // The shadow atlas tiles of this light, see `SceneShadows`. The light is not shadowed if `num_shadow_tiles` is 0.
+        u32 first_shadow_tile;
+        u32 num_shadow_tiles;
+    };
+
+    // Persistent GPU copies of scene data.
+    // Every entity has one stable slot in `mesh_buffers`, which is its index in `SceneTransforms`, and every light has one
+    // stable slot in `lighting_params` as long as the set of lights does not change. Only data of changed entities and lights
+    // is uploaded every frame, through one upload ring buffer.
+    struct SceneGPUData
+    {
+        // The model-to-world and world-to-model matrices of every entity, indexed by entity indices in `SceneTransforms`.
+        Ref<RHI::IBuffer> mesh_buffers;
+        // `LightingParams` of every light.
+        Ref<RHI::IBuffer> lighting_params;
+
+        // Records commands that upload changed data to `mesh_buffers` and `lighting_params`.
+        // `transforms` must be updated in this frame before calling this, so that its dirty flags are valid.
+        // `lights` stores `LightingParams` of every light, and must not be empty.
+        // Buffers are recreated if their sizes are not large enough, and all data is uploaded in such case.
+        RV update(RHI::ICommandBuffer* cmdbuf, RHI::IUploadRingBuffer* upload_ring, const SceneTransforms& transforms,
+            Span<const LightingParams> lights);
+
+    private:
+        usize m_mesh_buffer_capacity = 0;
+        usize m_lighting_params_capacity = 0;
+        // Lighting params that are uploaded to `lighting_params`, used to detect changes.
+        Vector<LightingParams> m_uploaded_lights;
+        // Scratch buffers that store begin and end slots of every range to upload.
+        Vector<Pair<u32, u32>> m_mesh_ranges;
+        Vector<Pair<u32, u32>> m_light_ranges;
+    };
+}
@@ -0,0 +1,168 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ScenePrefetcher.cpp
+* @author JXMaster
+* @date 2024/5/10
+*/
+#include "ScenePrefetcher.hpp"
+#include "Scene.hpp"
+#include "ModelRenderer.hpp"
+#include "Model.hpp"
+#include "Mesh.hpp"
+#include "Material.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
+
+namespace Luna
+{
+    // The priority of assets that cover the whole screen. Screen sizes are clamped to this value, so that the skybox
+    // is always loaded first.
+    constexpr f32 MAX_PREFETCH_PRIORITY = 1.0f;
+    // The minimum priority of prefetched assets, so that prefetched assets are loaded before assets requested without priority.
+    constexpr f32 MIN_PREFETCH_PRIORITY = 0.0001f;
+
+    void ScenePrefetcher::add_asset(Asset::asset_t asset, f32 priority)
+    {
+        if (!asset) return;
+        auto iter = m_priorities.find(asset.handle);
+        if (iter == m_priorities.end())
+        {
+            m_priorities.insert(make_pair(asset.handle, priority));
+        }
+        else
+        {
+            iter->second = max(iter->second, priority);
+        }
+    }
+
+    void ScenePrefetcher::update(const void* scene, const SceneTransforms& transforms, const Camera& camera,
+        const Float4x4& camera_view_to_world, Asset::asset_t skybox)
+    {
+        if (scene != m_scene)
+        {
+            reset();
+            m_scene = scene;
+        }
+        // Collects referenced assets and their priorities.
+        m_priorities.clear();
+        add_asset(skybox, MAX_PREFETCH_PRIORITY);
+        Float3 camera_position = AffineMatrix::translation(camera_view_to_world);
+        f32 tan_half_fov = tanf(camera.fov * 0.5f);
+        for (usize i = 0; i < transforms.entities.size(); ++i)
+        {
+            auto r = transforms.entities[i]->get_component<ModelRenderer>();
+            if (!r || !r->model) continue;
+            const Float4x4& model_to_world = transforms.local_to_world_matrices[i];
+            Float3 scale = AffineMatrix::scaling(model_to_world);
+            f32 max_scale = max(max(scale.x, scale.y), scale.z);
+            Ref<Model> model;
+            Ref<Mesh> mesh;
+            if (Asset::get_asset_state(r->model) == Asset::AssetState::loaded)
+            {
+                model = Asset::get_asset_data<Model>(r->model);
+                if (model && Asset::get_asset_state(model->mesh) == Asset::AssetState::loaded)
+                {
+                    mesh = Asset::get_asset_data<Mesh>(model->mesh);
+                }
+            }
+            // The bounding sphere radius is estimated from the entity scale until the mesh is loaded.
+            f32 radius = max_scale;
+            if (mesh)
+            {
+                Float3 extent = (Float3(mesh->bounding_box_max) - Float3(mesh->bounding_box_min)) * 0.5f;
+                radius = length(extent) * max_scale;
+            }
+            // The ratio of the bounding sphere diameter to the screen height.
+            f32 screen_size;
+            if (camera.type == CameraType::perspective)
+            {
+                f32 distance = max(length(AffineMatrix::translation(model_to_world) - camera_position) - radius, camera.near_clipping_plane);
+                screen_size = radius / (distance * tan_half_fov);
+            }
+            else
+            {
+                screen_size = radius * 2.0f / max(camera.size / camera.aspect_ratio, 0.0001f);
+            }
+            f32 priority = clamp(screen_size, MIN_PREFETCH_PRIORITY, MAX_PREFETCH_PRIORITY);
+            add_asset(r->model, priority);
+            if (!model) continue;
+            add_asset(model->mesh, priority);
+            for (auto& material : model->materials)
+            {
+                add_asset(material, priority);
+                if (Asset::get_asset_state(material) != Asset::AssetState::loaded) continue;
+                auto mat = Asset::get_asset_data<Material>(material);
+                if (!mat) continue;
+                add_asset(mat->base_color, priority);
+                add_asset(mat->roughness, priority);
+                add_asset(mat->normal, priority);
+                add_asset(mat->metallic, priority);
+                add_asset(mat->emissive, priority);
+            }
+        }
+
+        // Removes finished requests, and cancels requests of assets that are no longer referenced.
+        m_removed_requests.clear();
+        for (auto& request : m_requests)
+        {
+            auto state = request.second->get_state();
+            if (state == Asset::AssetLoadRequestState::finished || state == Asset::AssetLoadRequestState::cancelled)
+            {
+                m_removed_requests.push_back(request.first);
+            }
+            else if (m_priorities.find(request.first) == m_priorities.end())
+            {
+                request.second->cancel();
+                m_removed_requests.push_back(request.first);
+            }
+        }
+        for (opaque_t handle : m_removed_requests) m_requests.erase(handle);
+
+        // Sorts assets that are not loaded by priority.
+        m_candidates.clear();
+        for (auto& asset : m_priorities)
+        {
+            auto state = Asset::get_asset_state(asset.first);
+            if (state != Asset::AssetState::unloaded && state != Asset::AssetState::loading) continue;
+            m_candidates.push_back({asset.first, asset.second});
+        }
+        sort(m_candidates.begin(), m_candidates.end(), [](const Candidate& lhs, const Candidate& rhs)
+        {
+            return lhs.priority > rhs.priority;
+        });
+        num_unloaded_assets = (u32)m_candidates.size();
+
+        // Issues requests in priority order.
+        auto resident_size = Asset::get_resident_asset_size();
+        bool within_budget = resident_size.cpu_size < budget.cpu_budget && resident_size.gpu_size < budget.gpu_budget;
+        for (auto& candidate : m_candidates)
+        {
+            auto iter = m_requests.find(candidate.asset.handle);
+            if (iter != m_requests.end())
+            {
+                // Priorities of requests that are being loaded are not changed by this call.
+                iter->second->set_priority(candidate.priority);
+            }
+            else if (within_budget && m_requests.size() < max_pending_requests)
+            {
+                m_requests.insert(make_pair(candidate.asset.handle, Asset::load_asset_async(candidate.asset, candidate.priority)));
+            }
+        }
+        num_pending_requests = (u32)m_requests.size();
+    }
+
+    void ScenePrefetcher::reset()
+    {
+        for (auto& request : m_requests)
+        {
+            request.second->cancel();
+        }
+        m_requests.clear();
+        m_priorities.clear();
+        m_scene = nullptr;
+        num_pending_requests = 0;
+        num_unloaded_assets = 0;
+    }
+}
@@ -0,0 +1,68 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ScenePrefetcher.hpp
+* @author JXMaster
+* @date 2024/5/10
+*/
+#pragma once
+#include <Luna/Asset/Asset.hpp>
+#include "SceneTransforms.hpp"
+#include "Camera.hpp"
+
+namespace Luna
+{
+    // Schedules loading of assets referenced by one scene in priority order.
+    // Every referenced asset is prioritized by the screen size of the entities that use it, so that assets close to the
+    // camera and covering large areas of the screen are loaded first. Assets referenced by loaded assets (meshes and
+    // materials of models, textures of materials) are scheduled after their referencing assets are loaded.
+    // Only up to `max_pending_requests` requests are issued at the same time, so that the remaining assets can be
+    // reprioritized when the camera moves. The scene renderer does not request assets by itself, so assets that are
+    // not prefetched because of the budget are not rendered. Assets requested by other systems without priority are
+    // loaded after prefetched assets, since prefetched assets always have positive priorities.
+    struct ScenePrefetcher
+    {
+        // New assets are not prefetched if the resident asset size exceeds this budget.
+        Asset::AssetStreamingBudget budget;
+        // The maximum number of requests issued by the prefetcher that are not finished.
+        u32 max_pending_requests = 16;
+        // The number of requests issued by the prefetcher that are not finished after the last update.
+        u32 num_pending_requests = 0;
+        // The number of assets referenced by the scene that are not loaded after the last update.
+        u32 num_unloaded_assets = 0;
+
+        ScenePrefetcher()
+        {
+            budget.cpu_budget = 2ULL * 1024 * 1024 * 1024;
+            budget.gpu_budget = 1ULL * 1024 * 1024 * 1024;
+        }
+
+        // Updates priorities of assets referenced by entities in `transforms` and schedules loading requests.
+        // `scene` is only used to detect scene changes, all requests of the last scene are cancelled if it changes.
+        // `skybox` is loaded with the highest priority if it is not null.
+        void update(const void* scene, const SceneTransforms& transforms, const Camera& camera,
+            const Float4x4& camera_view_to_world, Asset::asset_t skybox);
+
+        // Cancels all pending requests.
+        void reset();
+
+    private:
+        struct Candidate
+        {
+            Asset::asset_t asset;
+            f32 priority;
+        };
+        const void* m_scene = nullptr;
+        // Requests issued by the prefetcher that are not finished.
+        HashMap<opaque_t, Ref<Asset::IAssetLoadRequest>> m_requests;
+        // The priority of every asset referenced in this update.
+        HashMap<opaque_t, f32> m_priorities;
+        // Scratch buffers.
+        Vector<Candidate> m_candidates;
+        Vector<opaque_t> m_removed_requests;
+
+        void add_asset(Asset::asset_t asset, f32 priority);
+    };
+}
@@ -0,0 +1,211 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file SceneRenderData.cpp
+* @author JXMaster
+* @date 2024/5/11
+*/
+#include "SceneRenderData.hpp"
+#include "Camera.hpp"
+#include "Light.hpp"
+#include "Model.hpp"
+#include "Mesh.hpp"
+#include "StudioHeader.hpp"
+
+namespace Luna
+{
+    SceneRenderData::~SceneRenderData()
+    {
+        prefetcher.reset();
+        auto iter = g_env->scene_render_data.find(scene.get());
+        if (iter != g_env->scene_render_data.end() && iter->second == this)
+        {
+            g_env->scene_render_data.erase(iter);
+        }
+    }
+    RV SceneRenderData::update(RHI::ICommandBuffer* cmdbuf, Entity* camera_entity, Asset::asset_t skybox)
+    {
+        using namespace RHI;
+        lutry
+        {
+            if (last_update_frame == g_env->frame_index) return ok;
+            last_update_frame = g_env->frame_index;
+            Scene* s = scene.get();
+
+            // Update world transforms of entities whose transforms are changed since the last frame.
+            transforms.update({s->root_entities.data(), s->root_entities.size()});
+
+            // Schedules loading of assets referenced by the scene.
+            u32 camera_index = transforms.get_index(camera_entity);
+            auto camera_component = camera_entity->get_component<Camera>();
+            lucheck(camera_index != U32_MAX && camera_component);
+            prefetcher.update(s, transforms, *camera_component, transforms.local_to_world_matrices[camera_index], skybox);
+
+            // Fetch meshes to draw.
+            mesh_ts.clear();
+            mesh_rs.clear();
+            mesh_transform_indices.clear();
+            shadow_casters.clear();
+            auto& entities = transforms.entities;
+            for (usize index = 0; index < entities.size(); ++index)
+            {
+                Entity* i = entities[index];
+                auto r = i->get_component<ModelRenderer>();
+                if (r)
+                {
+                    // Assets are loaded by `prefetcher` in priority order, meshes that are not loaded are skipped.
+                    auto model = Asset::get_asset_data<Model>(r->model);
+                    if (!model)
+                    {
+                        continue;
+                    }
+                    auto mesh = Asset::get_asset_data<Mesh>(model->mesh);
+                    if (!mesh)
+                    {
+                        continue;
+                    }
+                    mesh_ts.push_back(i);
+                    mesh_rs.push_back(r);
+                    mesh_transform_indices.push_back((u32)index);
+                    m_bounding_box_mins.push_back(mesh->bounding_box_min);
+                    m_bounding_box_maxs.push_back(mesh->bounding_box_max);
+                    shadow_casters.push_back({(u32)index, mesh.get()});
+                }
+            }
+
+            // The hierarchy is only refitted if meshes are moved, and is rebuilt if meshes are added or removed.
+            // The hierarchy is updated every frame even if no view culls meshes on CPU, since refitting relies on
+            // dirty flags of `transforms` that are only valid in this frame.
+            if (!mesh_ts.empty())
+            {
+                usize num_meshes = mesh_ts.size();
+                bvh.update(transforms, {mesh_transform_indices.data(), num_meshes},
+                    {m_bounding_box_mins.data(), num_meshes}, {m_bounding_box_maxs.data(), num_meshes});
+            }
+            m_bounding_box_mins.clear();
+            m_bounding_box_maxs.clear();
+
+            // Fetches lights to draw.
+            light_ts.clear();
+            m_light_rs.clear();
+            m_light_transform_indices.clear();
+            for (usize index = 0; index < entities.size(); ++index)
+            {
+                Entity* i = entities[index];
+                ObjRef r = ObjRef(i->get_component<DirectionalLight>());
+                if (!r)
+                {
+                    r = i->get_component<PointLight>();
+                    if (!r)
+                    {
+                        r = i->get_component<SpotLight>();
+                    }
+                }
+                if (r)
+                {
+                    light_ts.push_back(i);
+                    m_light_rs.push_back(r);
+                    m_light_transform_indices.push_back((u32)index);
+                }
+            }
+
+            // Compute lighting params.
+            lighting_params.resize(max<usize>(light_ts.size(), 1));
+            m_light_cast_shadows.resize(light_ts.size());
+            for (usize i = 0; i < light_ts.size(); ++i)
+            {
+                LightingParams p;
+                const Float4x4& light_to_world = transforms.local_to_world_matrices[m_light_transform_indices[i]];
+                Float3 light_position = AffineMatrix::translation(light_to_world);
+                Float3 light_direction = normalize(AffineMatrix::forward(light_to_world));
+                Ref<DirectionalLight> directional = m_light_rs[i];
+                if (directional)
+                {
+                    p.strength = directional->intensity * directional->intensity_multiplier;
+                    p.attenuation_power = 1.0f;
+                    p.direction = light_direction;
+                    p.type = 0;
+                    p.position = light_position;
+                    p.spot_attenuation_power = 0.0f;
+                    m_light_cast_shadows[i] = directional->cast_shadow;
+                }
+                else
+                {
+                    Ref<PointLight> point = m_light_rs[i];
+                    if (point)
+                    {
+                        p.strength = point->intensity * point->intensity_multiplier;
+                        p.attenuation_power = point->attenuation_power;
+                        p.direction = Float3U(0.0f, 0.0f, 1.0f);
+                        p.type = 1;
+                        p.position = light_position;
+                        p.spot_attenuation_power = 0.0f;
+                        m_light_cast_shadows[i] = point->cast_shadow;
+                    }
+                    else
+                    {
+                        Ref<SpotLight> spot = m_light_rs[i];
+                        if (spot)
+                        {
+                            p.strength = spot->intensity * spot->intensity_multiplier;
+                            p.attenuation_power = spot->attenuation_power;
+                            p.direction = light_direction;
+                            p.type = 2;
+                            p.position = light_position;
+                            p.spot_attenuation_power = spot->spot_power;
+                            m_light_cast_shadows[i] = spot->cast_shadow;
+                        }
+                        else
+                        {
+                            lupanic_always();
+                        }
+                    }
+                }
+                // Shadow tiles are assigned later.
+                p.first_shadow_tile = 0;
+                p.num_shadow_tiles = 0;
+                lighting_params[i] = p;
+            }
+            // Adds one fake light if there is no light so the SRV is not empty (which is invalid).
+            if (light_ts.empty())
+            {
+                LightingParams p;
+                p.strength = Float3U{ 0.0f, 0.0f, 0.0f };
+                p.attenuation_power = 1.0f;
+                p.direction = Float3U{ 0.0f, 0.0f, 1.0f };
+                p.type = 0;
+                p.position = Float3U{ 0.0f, 0.0f, 0.0f };
+                p.spot_attenuation_power = 0.0f;
+                p.first_shadow_tile = 0;
+                p.num_shadow_tiles = 0;
+                lighting_params[0] = p;
+            }
+            // Tile ranges are assigned even if no view renders shadows, and views without shadows ignore them.
+            assign_shadow_tiles({lighting_params.data(), light_ts.size()}, {m_light_cast_shadows.data(), light_ts.size()});
+
+            // Upload changed mesh matrices and lighting params to persistent buffers.
+            if (!m_upload_ring)
+            {
+                luset(m_upload_ring, cmdbuf->get_device()->new_upload_ring_buffer(UploadRingBufferDesc(256 * 1024, 2, BufferUsageFlag::copy_source)));
+            }
+            m_upload_ring->begin_frame();
+            luexp(gpu_data.update(cmdbuf, m_upload_ring, transforms, {lighting_params.data(), lighting_params.size()}));
+        }
+        lucatchret;
+        return ok;
+    }
+    Ref<SceneRenderData> get_scene_render_data(Scene* scene)
+    {
+        auto iter = g_env->scene_render_data.find(scene);
+        if (iter != g_env->scene_render_data.end())
+        {
+            return iter->second;
+        }
+        Ref<SceneRenderData> data = new_object<SceneRenderData>();
+        data->scene = scene;
+        g_env->scene_render_data.insert(make_pair((const void*)scene, data.get()));
+        return data;
+    }
+}
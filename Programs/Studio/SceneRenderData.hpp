@@ -0,0 +1,77 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file SceneRenderData.hpp
+* @author JXMaster
+* @date 2024/5/11
+*/
+#pragma once
+#include "Scene.hpp"
+#include "SceneTransforms.hpp"
+#include "SceneGPUData.hpp"
+#include "SceneBVH.hpp"
+#include "SceneShadows.hpp"
+#include "ScenePrefetcher.hpp"
+#include "ModelRenderer.hpp"
+
+namespace Luna
+{
+    // Render data of one scene that does not depend on views, shared by all renderers that render the same scene.
+    // The data is updated at most once per frame by the first renderer that renders the scene in that frame, so
+    // that every additional view of the scene only pays for its own culling and passes.
+    struct SceneRenderData
+    {
+        lustruct("SceneRenderData", "{4c1f2d8e-7a93-4b65-b0e2-96d5a3f17c48}");
+
+        // The rendered scene.
+        Ref<Scene> scene;
+        // Cached world transforms of the scene.
+        SceneTransforms transforms;
+        // Persistent GPU copies of model matrices and lighting params.
+        SceneGPUData gpu_data;
+        // The bounding volume hierarchy of meshes in `mesh_ts`, used for frustum culling and finding shadow casters.
+        SceneBVH bvh;
+        // Loads assets referenced by the scene in priority order.
+        ScenePrefetcher prefetcher;
+
+        // Entities whose meshes are loaded, their model renderers and their indices in `transforms`.
+        Vector<BorrowedRef<Entity>> mesh_ts;
+        Vector<BorrowedRef<ModelRenderer>> mesh_rs;
+        Vector<u32> mesh_transform_indices;
+        // All meshes that may cast shadows, ordered as objects in `bvh`.
+        Vector<ShadowCaster> shadow_casters;
+
+        // Entities with light components.
+        Vector<BorrowedRef<Entity>> light_ts;
+        // Lighting params of all lights, with shadow tiles assigned by `assign_shadow_tiles`. Stores one fake light
+        // if there is no light, so that this is never empty.
+        Vector<LightingParams> lighting_params;
+
+        // The frame index of the last update, see `AppEnv::frame_index`.
+        u64 last_update_frame = U64_MAX;
+
+        ~SceneRenderData();
+
+        // Updates the data for the current frame. Does nothing if the data is already updated in the current frame.
+        // Uploading commands are recorded to `cmdbuf`, which must be submitted before any other command buffer
+        // that reads the data in this frame. `camera_entity` and `skybox` are used to prioritize asset loading.
+        RV update(RHI::ICommandBuffer* cmdbuf, Entity* camera_entity, Asset::asset_t skybox);
+
+    private:
+        // Allocates staging data of changed model matrices and lighting params every frame.
+        Ref<RHI::IUploadRingBuffer> m_upload_ring;
+        // Whether every light in `lighting_params` casts shadows.
+        Vector<bool> m_light_cast_shadows;
+        // Scratch buffers.
+        Vector<Float3U> m_bounding_box_mins;
+        Vector<Float3U> m_bounding_box_maxs;
+        Vector<ObjRef> m_light_rs;
+        Vector<u32> m_light_transform_indices;
+    };
+
+    // Gets the render data of the specified scene. The render data is created if the scene is not rendered by
+    // any other renderer, and is destroyed when all renderers release it.
+    Ref<SceneRenderData> get_scene_render_data(Scene* scene);
+}
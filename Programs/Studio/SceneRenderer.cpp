@@ -16,11 +16,18 @@
 #include "Mesh.hpp"
 #include "RenderPasses/SkyBoxPass.hpp"
 #include "RenderPasses/ToneMappingPass.hpp"
+#include "RenderPasses/AutoExposurePass.hpp"
 #include "RenderPasses/WireframePass.hpp"
 #include "RenderPasses/GeometryPass.hpp"
+#include "RenderPasses/LightCullingPass.hpp"
 #include "RenderPasses/DeferredLightingPass.hpp"
 #include "RenderPasses/BufferVisualizationPass.hpp"
+#include "RenderPasses/DepthPyramidPass.hpp"
+#include "RenderPasses/ShadowPass.hpp"
 #include "StudioHeader.hpp"
+#include <Luna/Asset/DerivedDataCache.hpp>
+#include <Luna/RHI/Utility.hpp>
+#include <Luna/Runtime/Math/Batch.hpp>
 
 namespace Luna
 {
@@ -41,108 +48,274 @@ namespace Luna
             m_settings = settings;
             usize cb_align = m_device->check_feature(DeviceFeature::uniform_buffer_data_alignment).uniform_buffer_data_alignment;
             luset(m_camera_cb, m_device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::uniform_buffer, align_upper(sizeof(CameraCB), cb_align))));
+            if (!m_shadow_matrices)
+            {
+                luset(m_shadow_matrices, m_device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::read_buffer, sizeof(Float4x4) * MAX_SHADOW_TILES)));
+            }
+            if (!m_luminance_buffer)
+            {
+                luset(m_luminance_buffer, m_device->new_buffer(MemoryType::local, 
+                    BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::read_write_buffer | BufferUsageFlag::copy_dest, sizeof(f32))));
+                // 0 means that the average luminance is not available, so the first frames use the exposure specified by the user.
+                f32 value = 0.0f;
+                lulet(upload_cmdbuf, m_device->new_command_buffer(g_env->async_copy_queue));
+                luexp(copy_resource_data(upload_cmdbuf, {CopyResourceData::write_buffer(m_luminance_buffer, 0, &value, sizeof(f32))}));
+            }
+
+            if (!m_settings.dynamic_resolution)
+            {
+                m_render_scale = 1.0f;
+                m_coarse_shading = false;
+            }
+            luexp(build_render_graph());
+        }
+        lucatchret;
+        return ok;
+    }
+    bool SceneRenderer::is_render_scale_enabled() const
+    {
+        switch(m_settings.mode)
+        {
+            case SceneRendererMode::wireframe:
+            case SceneRendererMode::base_color:
+            case SceneRendererMode::normal:
+            case SceneRendererMode::roughness:
+            case SceneRendererMode::metallic:
+            case SceneRendererMode::depth:
+                return false;
+            default:
+                return true;
+        }
+    }
+    bool SceneRenderer::is_occlusion_culling_enabled() const
+    {
+        return m_settings.occlusion_culling && m_settings.mode != SceneRendererMode::wireframe;
+    }
+    bool SceneRenderer::is_gpu_driven_enabled() const
+    {
+        return m_settings.gpu_driven && m_settings.mode != SceneRendererMode::wireframe &&
+            m_device->check_feature(RHI::DeviceFeature::unbound_descriptor_array).unbound_descriptor_array;
+    }
+    bool SceneRenderer::is_shadows_enabled() const
+    {
+        // Render scale is enabled exactly for modes that perform lighting.
+        return m_settings.shadows && is_render_scale_enabled();
+    }
+    UInt2U SceneRenderer::get_render_size() const
+    {
+        if (!is_render_scale_enabled() || m_render_scale >= 1.0f) return m_settings.screen_size;
+        return UInt2U(max<u32>((u32)(m_settings.screen_size.x * m_render_scale), 1),
+            max<u32>((u32)(m_settings.screen_size.y * m_render_scale), 1));
+    }
+    static constexpr const c8* RENDER_GRAPH_CACHE_COOKER = "RenderGraphCompileCache";
+    static constexpr u32 RENDER_GRAPH_CACHE_VERSION = 4;
+
+    RV SceneRenderer::build_render_graph()
+    {
+        using namespace RHI;
+        lutry
+        {
+            using namespace RG;
             
-            // Build render graph.
+            UInt2U render_size = get_render_size();
+            bool upscale = render_size != m_settings.screen_size;
+            RenderGraphDesc desc;
+            desc.passes.resize(11);
+            desc.passes[WIREFRAME_PASS] = {"WireframePass", "Wireframe"};
+            desc.passes[GEOMETRY_PASS] = {"GeometryPass", "Geometry"};
+            desc.passes[DEPTH_PYRAMID_PASS] = {"DepthPyramidPass", "DepthPyramid"};
+            desc.passes[BUFFER_VIS_PASS] = {"BufferVisualizationPass", "BufferVisualization"};
+            // The auto exposure pass reads the lighting buffer of the last frame, so it runs on the async compute queue 
+            // before the lighting buffer is written, and overlaps with the geometry pass.
+            desc.passes[AUTO_EXPOSURE_PASS] = {"AutoExposurePass", "AutoExposure", RenderGraphPassFlag::async_compute};
+            desc.passes[SKYBOX_PASS] = {"SkyBoxPass", "SkyBox"};
+            desc.passes[SHADOW_PASS] = {"ShadowPass", "Shadow"};
+            desc.passes[LIGHT_CULLING_PASS] = {"LightCullingPass", "LightCulling"};
+            desc.passes[DEFERRED_LIGHTING_PASS] = {"DeferredLightingPass", "DeferredLighting"};
+            desc.passes[TONE_MAPPING_PASS] = {"ToneMappingPass", "ToneMapping"};
+            desc.passes[UPSCALE_PASS] = {"UpscalePass", "Upscale"};
+            desc.resources.resize(14);
+            desc.resources[LIGHTING_BUFFER] = { RenderGraphResourceType::transient,
+                RenderGraphResourceFlag::none,
+                "LightingBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba32_float, TextureUsageFlag::read_texture | TextureUsageFlag::read_write_texture,
+                        (u32)render_size.x, (u32)render_size.y, 1, 1)) };
+            desc.resources[DEPTH_BUFFER] = {RenderGraphResourceType::transient, 
+                RenderGraphResourceFlag::none,
+                "DepthBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::d32_float, TextureUsageFlag::depth_stencil_attachment | TextureUsageFlag::read_texture, 
+                        (u32)render_size.x, (u32)render_size.y, 1, 1)) };
+            desc.resources[BACK_BUFFER] = {RenderGraphResourceType::transient, 
+                RenderGraphResourceFlag::none,
+                "BackBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment | TextureUsageFlag::copy_source, 0, 0, 1, 1))};
+            desc.resources[WIREFRAME_BACK_BUFFER] = {RenderGraphResourceType::transient, 
+                RenderGraphResourceFlag::none,
+                "WireframeBackBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment | TextureUsageFlag::copy_source,
+                        (u32)m_settings.screen_size.x, (u32)m_settings.screen_size.y, 1, 1))};
+            desc.resources[GBUFFER_VIS_BUFFER] = {RenderGraphResourceType::transient, 
+                RenderGraphResourceFlag::none,
+                "GBufferBackBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment | TextureUsageFlag::copy_source,
+                        (u32)m_settings.screen_size.x, (u32)m_settings.screen_size.y, 1, 1))};
+            desc.resources[BASE_COLOR_ROUGHNESS_BUFFER] = {RenderGraphResourceType::transient, 
+                RenderGraphResourceFlag::none,
+                "BaseColorRoughnessBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment, 0, 0, 1, 1))};
+            desc.resources[NORMAL_METALLIC_BUFFER] = {RenderGraphResourceType::transient, 
+                RenderGraphResourceFlag::none,
+                "NormalMetallicBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment, 0, 0, 1, 1))};
+            desc.resources[EMISSIVE_BUFFER] = {RenderGraphResourceType::transient, 
+                RenderGraphResourceFlag::none,
+                "EmissiveBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba16_float, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment, 0, 0, 1, 1))};
+            desc.resources[UPSCALED_LIGHTING_BUFFER] = { RenderGraphResourceType::transient,
+                RenderGraphResourceFlag::none,
+                "UpscaledLightingBuffer",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::rgba32_float, TextureUsageFlag::read_texture | TextureUsageFlag::read_write_texture,
+                        (u32)m_settings.screen_size.x, (u32)m_settings.screen_size.y, 1, 1)) };
+            desc.resources[DEPTH_PYRAMID] = { RenderGraphResourceType::transient,
+                RenderGraphResourceFlag::none,
+                "DepthPyramid",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::r32_float, TextureUsageFlag::read_texture | TextureUsageFlag::read_write_texture | TextureUsageFlag::copy_source,
+                        (u32)render_size.x, (u32)render_size.y, 1, 0)) };
+            UInt3U cluster_count = get_light_cluster_count(render_size);
+            u32 num_clusters = cluster_count.x * cluster_count.y * cluster_count.z;
+            desc.resources[LIGHT_GRID] = { RenderGraphResourceType::transient,
+                RenderGraphResourceFlag::none,
+                "LightGrid",
+                ResourceDesc::as_buffer(MemoryType::local,
+                    BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::read_write_buffer, sizeof(u32) * num_clusters)) };
+            desc.resources[LIGHT_INDICES] = { RenderGraphResourceType::transient,
+                RenderGraphResourceFlag::none,
+                "LightIndices",
+                ResourceDesc::as_buffer(MemoryType::local,
+                    BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::read_write_buffer, sizeof(u32) * num_clusters * MAX_LIGHTS_PER_CLUSTER)) };
+            // Every array slice of the shadow atlas stores one shadow tile.
+            desc.resources[SHADOW_ATLAS] = { RenderGraphResourceType::transient,
+                RenderGraphResourceFlag::none,
+                "ShadowAtlas",
+                ResourceDesc::as_texture(MemoryType::local,
+                    TextureDesc::tex2d(Format::d32_float, TextureUsageFlag::depth_stencil_attachment | TextureUsageFlag::read_texture,
+                        SHADOW_TILE_SIZE, SHADOW_TILE_SIZE, MAX_SHADOW_TILES, 1)) };
+            desc.resources[LUMINANCE_BUFFER] = { RenderGraphResourceType::external,
+                RenderGraphResourceFlag::none,
+                "LuminanceBuffer",
+                ResourceDesc::as_buffer(MemoryType::local,
+                    BufferDesc(BufferUsageFlag::read_buffer | BufferUsageFlag::read_write_buffer | BufferUsageFlag::copy_dest, sizeof(f32))) };
+            if (is_shadows_enabled())
+            {
+                // Shadow tiles are cached across frames, so the atlas must keep its content between frames.
+                desc.resources[SHADOW_ATLAS].type = RenderGraphResourceType::persistent;
+                desc.output_connections.push_back({SHADOW_PASS, "shadow_atlas", SHADOW_ATLAS});
+                desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "shadow_atlas", SHADOW_ATLAS});
+            }
+            if (is_occlusion_culling_enabled())
+            {
+                // The depth pyramid is not read by any other pass, mark it as output so that the pass is not culled.
+                desc.resources[DEPTH_PYRAMID].type = RenderGraphResourceType::persistent;
+                desc.resources[DEPTH_PYRAMID].flags |= RenderGraphResourceFlag::output;
+                desc.input_connections.push_back({DEPTH_PYRAMID_PASS, "depth_texture", DEPTH_BUFFER});
+                desc.output_connections.push_back({DEPTH_PYRAMID_PASS, "depth_pyramid", DEPTH_PYRAMID});
+            }
+
+            switch(m_settings.mode)
             {
-                using namespace RG;
-                
-                RenderGraphDesc desc;
-                desc.passes.resize(8);
-                desc.passes[WIREFRAME_PASS] = {"WireframePass", "Wireframe"};
-                desc.passes[GEOMETRY_PASS] = {"GeometryPass", "Geometry"};
-                desc.passes[BUFFER_VIS_PASS] = {"BufferVisualizationPass", "BufferVisualization"};
-                desc.passes[SKYBOX_PASS] = {"SkyBoxPass", "SkyBox"};
-                desc.passes[DEFERRED_LIGHTING_PASS] = {"DeferredLightingPass", "DeferredLighting"};
-                desc.passes[TONE_MAPPING_PASS] = {"ToneMappingPass", "ToneMapping"};
-                desc.resources.resize(9);
-                desc.resources[LIGHTING_BUFFER] = { RenderGraphResourceType::transient,
-                    RenderGraphResourceFlag::none,
-                    "LightingBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::rgba32_float, TextureUsageFlag::read_texture | TextureUsageFlag::read_write_texture,
-                            (u32)settings.screen_size.x, (u32)settings.screen_size.y, 1, 1)) };
-                desc.resources[DEPTH_BUFFER] = {RenderGraphResourceType::transient, 
-                    RenderGraphResourceFlag::none,
-                    "DepthBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::d32_float, TextureUsageFlag::depth_stencil_attachment | TextureUsageFlag::read_texture, 
-                            (u32)settings.screen_size.x, (u32)settings.screen_size.y, 1, 1)) };
-                desc.resources[BACK_BUFFER] = {RenderGraphResourceType::transient, 
-                    RenderGraphResourceFlag::none,
-                    "BackBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment | TextureUsageFlag::copy_source, 0, 0, 1, 1))};
-                desc.resources[WIREFRAME_BACK_BUFFER] = {RenderGraphResourceType::transient, 
-                    RenderGraphResourceFlag::none,
-                    "WireframeBackBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment | TextureUsageFlag::copy_source,
-                            (u32)settings.screen_size.x, (u32)settings.screen_size.y, 1, 1))};
-                desc.resources[GBUFFER_VIS_BUFFER] = {RenderGraphResourceType::transient, 
-                    RenderGraphResourceFlag::none,
-                    "GBufferBackBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment | TextureUsageFlag::copy_source,
-                            (u32)settings.screen_size.x, (u32)settings.screen_size.y, 1, 1))};
-                desc.resources[BASE_COLOR_ROUGHNESS_BUFFER] = {RenderGraphResourceType::transient, 
-                    RenderGraphResourceFlag::none,
-                    "BaseColorRoughnessBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment, 0, 0, 1, 1))};
-                desc.resources[NORMAL_METALLIC_BUFFER] = {RenderGraphResourceType::transient, 
-                    RenderGraphResourceFlag::none,
-                    "NormalMetallicBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::rgba8_unorm, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment, 0, 0, 1, 1))};
-                desc.resources[EMISSIVE_BUFFER] = {RenderGraphResourceType::transient, 
-                    RenderGraphResourceFlag::none,
-                    "EmissiveBuffer",
-                    ResourceDesc::as_texture(MemoryType::local,
-                        TextureDesc::tex2d(Format::rgba16_float, TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment, 0, 0, 1, 1))};
+                case SceneRendererMode::wireframe:
+                    desc.resources[WIREFRAME_BACK_BUFFER].type = RenderGraphResourceType::persistent;
+                    desc.resources[WIREFRAME_BACK_BUFFER].flags |= RenderGraphResourceFlag::output;
+                    break;
+                case SceneRendererMode::base_color:
+                case SceneRendererMode::normal:
+                case SceneRendererMode::roughness:
+                case SceneRendererMode::metallic:
+                case SceneRendererMode::depth:
+                    desc.resources[GBUFFER_VIS_BUFFER].type = RenderGraphResourceType::persistent;
+                    desc.resources[GBUFFER_VIS_BUFFER].flags |= RenderGraphResourceFlag::output;
+                    break;
+                default:
+                    desc.resources[BACK_BUFFER].type = RenderGraphResourceType::persistent;
+                    desc.resources[BACK_BUFFER].flags |= RenderGraphResourceFlag::output;
+                    // The lighting buffer keeps the image of the last frame for the auto exposure pass.
+                    desc.resources[LIGHTING_BUFFER].type = RenderGraphResourceType::persistent;
+            }
+            
+            desc.output_connections.push_back({WIREFRAME_PASS, "scene_texture", WIREFRAME_BACK_BUFFER});
+            desc.output_connections.push_back({GEOMETRY_PASS, "depth_texture", DEPTH_BUFFER});
+            desc.output_connections.push_back({GEOMETRY_PASS, "base_color_roughness_texture", BASE_COLOR_ROUGHNESS_BUFFER});
+            desc.output_connections.push_back({GEOMETRY_PASS, "normal_metallic_texture", NORMAL_METALLIC_BUFFER});
+            desc.output_connections.push_back({GEOMETRY_PASS, "emissive_texture", EMISSIVE_BUFFER});
+            desc.input_connections.push_back({AUTO_EXPOSURE_PASS, "hdr_texture", LIGHTING_BUFFER});
+            desc.output_connections.push_back({AUTO_EXPOSURE_PASS, "luminance_buffer", LUMINANCE_BUFFER});
+            desc.input_connections.push_back({SKYBOX_PASS, "depth_texture", DEPTH_BUFFER});
+            desc.output_connections.push_back({SKYBOX_PASS, "texture", LIGHTING_BUFFER});
+            desc.output_connections.push_back({LIGHT_CULLING_PASS, "light_grid", LIGHT_GRID});
+            desc.output_connections.push_back({LIGHT_CULLING_PASS, "light_indices", LIGHT_INDICES});
+            desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "depth_texture", DEPTH_BUFFER});
+            desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "base_color_roughness_texture", BASE_COLOR_ROUGHNESS_BUFFER});
+            desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "normal_metallic_texture", NORMAL_METALLIC_BUFFER});
+            desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "emissive_texture", EMISSIVE_BUFFER});
+            desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "light_grid", LIGHT_GRID});
+            desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "light_indices", LIGHT_INDICES});
+            desc.output_connections.push_back({DEFERRED_LIGHTING_PASS, "scene_texture", LIGHTING_BUFFER});
+            desc.input_connections.push_back({BUFFER_VIS_PASS, "depth_texture", DEPTH_BUFFER});
+            desc.input_connections.push_back({BUFFER_VIS_PASS, "base_color_roughness_texture", BASE_COLOR_ROUGHNESS_BUFFER});
+            desc.input_connections.push_back({BUFFER_VIS_PASS, "normal_metallic_texture", NORMAL_METALLIC_BUFFER});
+            desc.output_connections.push_back({BUFFER_VIS_PASS, "scene_texture", GBUFFER_VIS_BUFFER});
+            desc.input_connections.push_back({UPSCALE_PASS, "src_texture", LIGHTING_BUFFER});
+            desc.output_connections.push_back({UPSCALE_PASS, "dst_texture", UPSCALED_LIGHTING_BUFFER});
+            desc.input_connections.push_back({TONE_MAPPING_PASS, "hdr_texture", upscale ? UPSCALED_LIGHTING_BUFFER : LIGHTING_BUFFER});
+            desc.input_connections.push_back({TONE_MAPPING_PASS, "luminance_buffer", LUMINANCE_BUFFER});
+            desc.output_connections.push_back({TONE_MAPPING_PASS, "ldr_texture", BACK_BUFFER});
 
-                switch(settings.mode)
+            m_render_graph->set_desc(desc);
+            RG::RenderGraphCompileConfig config;
+            // Dynamic resolution reads pass timestamps to measure GPU frame time.
+            config.enable_time_profiling = m_settings.frame_profiling || m_settings.dynamic_resolution;
+            // Passes flagged with `async_compute` run on the dedicated compute queue if the device has one.
+            if (g_env->async_compute_queue != g_env->graphics_queue) config.async_compute_queue = g_env->async_compute_queue;
+            // The compile cache is stored in the derived data cache, so that render graph analysis is skipped when the same
+            // render graph is built again in later runs. The render graph ignores the cache if the graph is changed.
+            u32 cache_key_data[] = { (u32)m_settings.mode, render_size.x, render_size.y, m_settings.screen_size.x, m_settings.screen_size.y,
+                (u32)is_occlusion_culling_enabled(), config.async_compute_queue, (u32)is_shadows_enabled() };
+            Name cache_key = Asset::get_derived_data_key(RENDER_GRAPH_CACHE_COOKER, RENDER_GRAPH_CACHE_VERSION, 
+                { (const byte_t*)cache_key_data, sizeof(cache_key_data) });
+            bool cache_loaded = false;
+            auto cache_file = Asset::get_derived_data(cache_key);
+            if (succeeded(cache_file))
+            {
+                auto cache = VariantUtils::read_json((const c8*)cache_file.get()->get_data(), cache_file.get()->get_size());
+                if (succeeded(cache))
                 {
-                    case SceneRendererMode::wireframe:
-                        desc.resources[WIREFRAME_BACK_BUFFER].type = RenderGraphResourceType::persistent;
-                        desc.resources[WIREFRAME_BACK_BUFFER].flags |= RenderGraphResourceFlag::output;
-                        break;
-                    case SceneRendererMode::base_color:
-                    case SceneRendererMode::normal:
-                    case SceneRendererMode::roughness:
-                    case SceneRendererMode::metallic:
-                    case SceneRendererMode::depth:
-                        desc.resources[GBUFFER_VIS_BUFFER].type = RenderGraphResourceType::persistent;
-                        desc.resources[GBUFFER_VIS_BUFFER].flags |= RenderGraphResourceFlag::output;
-                        break;
-                    default:
-                        desc.resources[BACK_BUFFER].type = RenderGraphResourceType::persistent;
-                        desc.resources[BACK_BUFFER].flags |= RenderGraphResourceFlag::output;
+                    m_render_graph->set_compile_cache(cache.get());
+                    cache_loaded = true;
+                }
+            }
+            luexp(m_render_graph->compile(config));
+            m_render_graph->set_external_resource(LUMINANCE_BUFFER, m_luminance_buffer);
+            if (!cache_loaded)
+            {
+                auto cache = m_render_graph->get_compile_cache();
+                if (succeeded(cache))
+                {
+                    String data = VariantUtils::write_json(cache.get());
+                    // Failing to store the cache only affects the startup time of the next run.
+                    auto _ = Asset::put_derived_data(cache_key, { (const byte_t*)data.data(), data.size() });
                 }
-                
-                desc.output_connections.push_back({WIREFRAME_PASS, "scene_texture", WIREFRAME_BACK_BUFFER});
-                desc.output_connections.push_back({GEOMETRY_PASS, "depth_texture", DEPTH_BUFFER});
-                desc.output_connections.push_back({GEOMETRY_PASS, "base_color_roughness_texture", BASE_COLOR_ROUGHNESS_BUFFER});
-                desc.output_connections.push_back({GEOMETRY_PASS, "normal_metallic_texture", NORMAL_METALLIC_BUFFER});
-                desc.output_connections.push_back({GEOMETRY_PASS, "emissive_texture", EMISSIVE_BUFFER});
-                desc.input_connections.push_back({SKYBOX_PASS, "depth_texture", DEPTH_BUFFER});
-                desc.output_connections.push_back({SKYBOX_PASS, "texture", LIGHTING_BUFFER});
-                desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "depth_texture", DEPTH_BUFFER});
-                desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "base_color_roughness_texture", BASE_COLOR_ROUGHNESS_BUFFER});
-                desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "normal_metallic_texture", NORMAL_METALLIC_BUFFER});
-                desc.input_connections.push_back({DEFERRED_LIGHTING_PASS, "emissive_texture", EMISSIVE_BUFFER});
-                desc.output_connections.push_back({DEFERRED_LIGHTING_PASS, "scene_texture", LIGHTING_BUFFER});
-                desc.input_connections.push_back({BUFFER_VIS_PASS, "depth_texture", DEPTH_BUFFER});
-                desc.input_connections.push_back({BUFFER_VIS_PASS, "base_color_roughness_texture", BASE_COLOR_ROUGHNESS_BUFFER});
-                desc.input_connections.push_back({BUFFER_VIS_PASS, "normal_metallic_texture", NORMAL_METALLIC_BUFFER});
-                desc.output_connections.push_back({BUFFER_VIS_PASS, "scene_texture", GBUFFER_VIS_BUFFER});
-                desc.input_connections.push_back({TONE_MAPPING_PASS, "hdr_texture", LIGHTING_BUFFER});
-                desc.output_connections.push_back({TONE_MAPPING_PASS, "ldr_texture", BACK_BUFFER});
-
-                m_render_graph->set_desc(desc);
-                RG::RenderGraphCompileConfig config;
-                config.enable_time_profiling = settings.frame_profiling;
-                luexp(m_render_graph->compile(config));
             }
+            m_frames_since_render_scale_change = 0;
         }
         lucatchret;
         return ok;
@@ -154,6 +327,11 @@ namespace Luna
             Scene* s = scene.get();
             if(!s) return set_error(BasicError::null_value(), "`scene` is `nullptr`.");
 
+            if (update_render_scale())
+            {
+                luexp(build_render_graph());
+            }
+
             auto scene_renderer = s->get_scene_component<SceneSettings>();
             if (!scene_renderer)
             {
@@ -175,8 +353,31 @@ namespace Luna
 
             camera_component->aspect_ratio = (f32)m_settings.screen_size.x / (f32)m_settings.screen_size.y;
 
+            // Updates data shared by all views of the scene. This does nothing if another view of the same 
+            // scene is already rendered in this frame.
+            if (!m_scene_data || m_scene_data->scene != s)
+            {
+                m_scene_data = get_scene_render_data(s);
+                m_shadows.invalidate();
+            }
+            else if (m_last_render_frame + 1 != g_env->frame_index)
+            {
+                // Moved casters are detected by dirty flags of transforms, which are missed if this view 
+                // is not rendered in some frames.
+                m_shadows.invalidate();
+            }
+            m_last_render_frame = g_env->frame_index;
+            SceneRenderData* scene_data = m_scene_data.get();
+            luexp(scene_data->update(command_buffer, camera_entity, scene_renderer->skybox));
+            num_unloaded_assets = scene_data->prefetcher.num_unloaded_assets;
+            num_prefetching_assets = scene_data->prefetcher.num_pending_requests;
+            auto& transforms = scene_data->transforms;
+            u32 camera_index = transforms.get_index(camera_entity);
+            lucheck(camera_index != U32_MAX);
+            Float4x4 camera_view_to_world = transforms.local_to_world_matrices[camera_index];
+
             // Update and upload camera data.
-            auto world_to_view = camera_entity->world_to_local_matrix();
+            auto world_to_view = transforms.world_to_local_matrices[camera_index];
             auto view_to_proj = camera_component->get_projection_matrix();
             auto world_to_proj = mul(world_to_view, view_to_proj);
             CameraCB camera_cb_data;
@@ -184,10 +385,11 @@ namespace Luna
             camera_cb_data.view_to_proj = view_to_proj;
             camera_cb_data.world_to_proj = world_to_proj;
             camera_cb_data.proj_to_world = inverse(world_to_proj);
-            camera_cb_data.view_to_world = camera_entity->local_to_world_matrix();
+            camera_cb_data.view_to_world = camera_view_to_world;
             Float3 env_color = scene_renderer->environment_color;
-            camera_cb_data.screen_width = m_settings.screen_size.x;
-            camera_cb_data.screen_height = m_settings.screen_size.y;
+            UInt2U render_size = get_render_size();
+            camera_cb_data.screen_width = render_size.x;
+            camera_cb_data.screen_height = render_size.y;
             void* mapped = nullptr;
             luexp(m_camera_cb->map(0, 0, &mapped));
             memcpy(mapped, &camera_cb_data, sizeof(CameraCB));
@@ -195,143 +397,63 @@ namespace Luna
 
             using namespace RHI;
 
-            auto device = command_buffer->get_device();
-
             // Fetch meshes to draw.
-            Vector<Ref<Entity>> ts;
-            Vector<Ref<ModelRenderer>> rs;
-            auto& entities = s->root_entities;
-            for (auto& i : entities)
+            Vector<BorrowedRef<Entity>> ts(scene_data->mesh_ts.begin(), scene_data->mesh_ts.end());
+            Vector<BorrowedRef<ModelRenderer>> rs(scene_data->mesh_rs.begin(), scene_data->mesh_rs.end());
+            Vector<u32> transform_indices(scene_data->mesh_transform_indices.begin(), scene_data->mesh_transform_indices.end());
+
+            // Cull meshes that are outside of the camera frustum. Meshes are culled by the geometry pass in GPU-driven mode.
+            bool gpu_driven = is_gpu_driven_enabled();
+            bool shadows = is_shadows_enabled();
+            if (!ts.empty() && !gpu_driven)
             {
-                auto r = i->get_component<ModelRenderer>();
-                if (r)
+                usize num_meshes = ts.size();
+                usize num_visible = scene_data->bvh.cull(make_frustum(world_to_proj), m_cull_results);
+                if (num_visible != num_meshes)
                 {
-                    auto model = get_asset_or_async_load_if_not_ready<Model>(r->model);
-                    if (!model)
+                    usize dst = 0;
+                    for (usize i = 0; i < num_meshes; ++i)
                     {
-                        continue;
+                        if (!m_cull_results[i]) continue;
+                        ts[dst] = ts[i];
+                        rs[dst] = rs[i];
+                        transform_indices[dst] = transform_indices[i];
+                        ++dst;
                     }
-                    auto mesh = get_asset_or_async_load_if_not_ready<Mesh>(model->mesh);
-                    if (!mesh)
-                    {
-                        continue;
-                    }
-                    ts.push_back(i);
-                    rs.push_back(r);
+                    ts.resize(dst);
+                    rs.resize(dst);
+                    transform_indices.resize(dst);
                 }
             }
 
-            // Upload mesh matrices.
+            // Mesh matrices are read from the persistent mesh buffers by their indices in `transforms`.
+            m_model_to_world_matrices.resize(ts.size());
+            for (usize i = 0; i < ts.size(); ++i)
             {
-                if (m_num_model_matrices < ts.size())
-                {
-                    luset(m_model_matrices, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::read_buffer, (u64)sizeof(Float4x4) * 2 * (u64)ts.size())));
-                    m_num_model_matrices = ts.size();
-                }
-                if (!ts.empty())
-                {
-                    void* mapped = nullptr;
-                    luexp(m_model_matrices->map(0, 0, &mapped));
-                    for (usize i = 0; i < ts.size(); ++i)
-                    {
-                        Float4x4 m2w = ts[i]->local_to_world_matrix();
-                        Float4x4 w2m = ts[i]->world_to_local_matrix();
-                        memcpy((Float4x4*)mapped + i * 2, m2w.r[0].m, sizeof(Float4x4));
-                        memcpy((Float4x4*)mapped + (i * 2 + 1), w2m.r[0].m, sizeof(Float4x4));
-                    }
-                    m_model_matrices->unmap(0, 2 * ts.size() * sizeof(Float4x4));
-                }
+                m_model_to_world_matrices[i] = transforms.local_to_world_matrices[transform_indices[i]];
             }
 
-            // Fetches lights to draw.
-            Vector<Ref<Entity>> light_ts;
-            Vector<ObjRef> light_rs;
-            for (auto& i : entities)
+            auto& light_ts = scene_data->light_ts;
+            auto& gpu_data = scene_data->gpu_data;
+
+            // Finds tiles to render again. Tile ranges of lights are assigned by `scene_data`.
+            num_shadow_tiles = 0;
+            if (shadows)
             {
-                ObjRef r = ObjRef(i->get_component<DirectionalLight>());
-                if (!r)
+                m_shadows.update(transforms, scene_data->bvh, {scene_data->shadow_casters.data(), scene_data->shadow_casters.size()}, 
+                    *camera_component, camera_view_to_world, {scene_data->lighting_params.data(), light_ts.size()});
+                num_shadow_tiles = (u32)m_shadows.tiles.size();
+                if (num_shadow_tiles)
                 {
-                    r = i->get_component<PointLight>();
-                    if (!r)
-                    {
-                        r = i->get_component<SpotLight>();
-                    }
-                }
-                if (r)
-                {
-                    light_ts.push_back(i);
-                    light_rs.push_back(r);
+                    Float4x4U* mapped_matrices = nullptr;
+                    luexp(m_shadow_matrices->map(0, 0, (void**)&mapped_matrices));
+                    for (u32 i = 0; i < num_shadow_tiles; ++i) mapped_matrices[i] = m_shadows.tiles[i].world_to_proj;
+                    m_shadow_matrices->unmap(0, sizeof(Float4x4U) * num_shadow_tiles);
                 }
             }
-
-            // Upload lighting params.
+            else
             {
-                usize light_size = max<usize>(light_ts.size(), 1);
-                if (m_num_lights < light_size)
-                {
-                    luset(m_lighting_params, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::read_buffer, sizeof(LightingParams) * light_size)));
-                    m_num_lights = light_size;
-                }
-                void* mapped = nullptr;
-                luexp(m_lighting_params->map(0, 0, &mapped));
-                for (usize i = 0; i < light_ts.size(); ++i)
-                {
-                    LightingParams p;
-                    Ref<DirectionalLight> directional = light_rs[i];
-                    if (directional)
-                    {
-                        p.strength = directional->intensity * directional->intensity_multiplier;
-                        p.attenuation_power = 1.0f;
-                        p.direction = AffineMatrix::forward(AffineMatrix::make_rotation(light_ts[i]->world_rotation()));
-                        p.type = 0;
-                        p.position = light_ts[i]->world_position();
-                        p.spot_attenuation_power = 0.0f;
-                    }
-                    else
-                    {
-                        Ref<PointLight> point = light_rs[i];
-                        if (point)
-                        {
-                            p.strength = point->intensity * point->intensity_multiplier;
-                            p.attenuation_power = point->attenuation_power;
-                            p.direction = Float3U(0.0f, 0.0f, 1.0f);
-                            p.type = 1;
-                            p.position = light_ts[i]->world_position();
-                            p.spot_attenuation_power = 0.0f;
-                        }
-                        else
-                        {
-                            Ref<SpotLight> spot = light_rs[i];
-                            if (spot)
-                            {
-                                p.strength = spot->intensity * spot->intensity_multiplier;
-                                p.attenuation_power = spot->attenuation_power;
-                                p.direction = AffineMatrix::forward(AffineMatrix::make_rotation(light_ts[i]->world_rotation()));
-                                p.type = 2;
-                                p.position = light_ts[i]->world_position();
-                                p.spot_attenuation_power = spot->spot_power;
-                            }
-                            else
-                            {
-                                lupanic_always();
-                            }
-                        }
-                    }
-                    memcpy((LightingParams*)mapped + i, &p, sizeof(LightingParams));
-                }
-                // Adds one fake light if there is no light so the SRV is not empty (which is invalid).
-                if (light_ts.empty())
-                {
-                    LightingParams p;
-                    p.strength = Float3U{ 0.0f, 0.0f, 0.0f };
-                    p.attenuation_power = 1.0f;
-                    p.direction = Float3U{ 0.0f, 0.0f, 1.0f };
-                    p.type = 0;
-                    p.position = Float3U{ 0.0f, 0.0f, 0.0f };
-                    p.spot_attenuation_power = 0.0f;
-                    memcpy((LightingParams*)mapped, &p, sizeof(LightingParams));
-                }
-                m_lighting_params->unmap(0, light_size * sizeof(LightingParams));
+                m_shadows.invalidate();
             }
 
             {
@@ -339,7 +461,8 @@ namespace Luna
                 if(m_settings.mode == SceneRendererMode::wireframe)
                 {
                     WireframePass* wireframe = cast_object<WireframePass>(m_render_graph->get_render_pass(WIREFRAME_PASS)->get_object());
-                    wireframe->model_matrices = m_model_matrices;
+                    wireframe->model_matrices = gpu_data.mesh_buffers;
+                    wireframe->model_matrix_indices = {transform_indices.data(), transform_indices.size()};
                     wireframe->camera_cb = m_camera_cb;
                     wireframe->ts = {ts.data(), ts.size()};
                     wireframe->rs = {rs.data(), rs.size()};
@@ -355,7 +478,10 @@ namespace Luna
                     geometry->camera_cb = m_camera_cb;
                     geometry->ts = {ts.data(), ts.size()};
                     geometry->rs = {rs.data(), rs.size()};
-                    geometry->model_matrices = m_model_matrices;
+                    geometry->model_to_world_matrices = {m_model_to_world_matrices.data(), m_model_to_world_matrices.size()};
+                    geometry->model_matrices = gpu_data.mesh_buffers;
+                    geometry->model_matrix_indices = {transform_indices.data(), transform_indices.size()};
+                    geometry->shading_rate = ShadingRate::rate_1x1;
                     switch(m_settings.mode)
                     {
                         case SceneRendererMode::base_color: buffer_vis->vis_type = 0; break;
@@ -370,21 +496,42 @@ namespace Luna
                 {
                     SkyBoxPass* skybox = cast_object<SkyBoxPass>(m_render_graph->get_render_pass(SKYBOX_PASS)->get_object());
                     GeometryPass* geometry = cast_object<GeometryPass>(m_render_graph->get_render_pass(GEOMETRY_PASS)->get_object());
+                    LightCullingPass* light_culling = cast_object<LightCullingPass>(m_render_graph->get_render_pass(LIGHT_CULLING_PASS)->get_object());
                     DeferredLightingPass* lighting = cast_object<DeferredLightingPass>(m_render_graph->get_render_pass(DEFERRED_LIGHTING_PASS)->get_object());
                     ToneMappingPass* tone_mapping = cast_object<ToneMappingPass>(m_render_graph->get_render_pass(TONE_MAPPING_PASS)->get_object());
+                    AutoExposurePass* auto_exposure = cast_object<AutoExposurePass>(m_render_graph->get_render_pass(AUTO_EXPOSURE_PASS)->get_object());
                     skybox->camera_fov = camera_component->fov;
                     skybox->camera_type = camera_component->type;
-                    skybox->view_to_world = camera_entity->local_to_world_matrix();
-                    auto skybox_tex = get_asset_or_async_load_if_not_ready<RHI::IResource>(scene_renderer->skybox);
+                    skybox->view_to_world = camera_view_to_world;
+                    auto skybox_tex = Asset::get_asset_data<RHI::IResource>(scene_renderer->skybox);
                     skybox->skybox = skybox_tex;
                     geometry->camera_cb = m_camera_cb;
                     geometry->ts = {ts.data(), ts.size()};
                     geometry->rs = {rs.data(), rs.size()};
-                    geometry->model_matrices = m_model_matrices;
+                    geometry->model_to_world_matrices = {m_model_to_world_matrices.data(), m_model_to_world_matrices.size()};
+                    geometry->model_matrices = gpu_data.mesh_buffers;
+                    geometry->model_matrix_indices = {transform_indices.data(), transform_indices.size()};
+                    geometry->shading_rate = m_coarse_shading ? ShadingRate::rate_2x2 : ShadingRate::rate_1x1;
+                    LightClusterParams cluster_params = make_light_cluster_params(render_size, 
+                        camera_component->near_clipping_plane, camera_component->far_clipping_plane);
+                    light_culling->cluster_params = cluster_params;
+                    light_culling->camera_cb = m_camera_cb;
+                    light_culling->light_params = gpu_data.lighting_params;
+                    light_culling->light_params_first_element = 0;
+                    light_culling->light_ts = {light_ts.data(), light_ts.size()};
+                    lighting->cluster_params = cluster_params;
                     lighting->skybox = skybox_tex;
                     lighting->camera_cb = m_camera_cb;
-                    lighting->light_params = m_lighting_params;
+                    lighting->light_params = gpu_data.lighting_params;
+                    lighting->light_params_first_element = 0;
                     lighting->light_ts = {light_ts.data(), light_ts.size()};
+                    lighting->shadow_matrices = m_shadow_matrices;
+                    if (shadows)
+                    {
+                        ShadowPass* shadow = cast_object<ShadowPass>(m_render_graph->get_render_pass(SHADOW_PASS)->get_object());
+                        shadow->tiles = {m_shadows.tiles.data(), m_shadows.tiles.size()};
+                        shadow->model_matrices = gpu_data.mesh_buffers;
+                    }
                     switch (m_settings.mode)
                     {
                         case SceneRendererMode::lit: lighting->lighting_mode = 0; break;
@@ -397,6 +544,40 @@ namespace Luna
                     }
                     tone_mapping->exposure = scene_renderer->exposure;
                     tone_mapping->auto_exposure = scene_renderer->auto_exposure;
+                    auto_exposure->enabled = scene_renderer->auto_exposure;
+                }
+                if (m_settings.mode != SceneRendererMode::wireframe)
+                {
+                    GeometryPass* geometry = cast_object<GeometryPass>(m_render_graph->get_render_pass(GEOMETRY_PASS)->get_object());
+                    geometry->collect_pipeline_statistics = m_settings.frame_profiling;
+                    geometry->gpu_driven = gpu_driven;
+                    geometry->depth_prepass = m_settings.depth_prepass;
+                    geometry->camera_position = AffineMatrix::translation(camera_view_to_world);
+                    geometry->occlusion_culling_data = nullptr;
+                    geometry->occlusion_depth_pyramid.reset();
+                    if (is_occlusion_culling_enabled())
+                    {
+                        DepthPyramidPass* depth_pyramid = cast_object<DepthPyramidPass>(m_render_graph->get_render_pass(DEPTH_PYRAMID_PASS)->get_object());
+                        depth_pyramid->readback_enabled = !gpu_driven;
+                        if (gpu_driven)
+                        {
+                            // The culling shader reads the depth pyramid texture of the last frame directly, which is kept 
+                            // between frames since it is one persistent resource.
+                            if (depth_pyramid->is_executed())
+                            {
+                                geometry->occlusion_depth_pyramid = m_render_graph->get_persistent_resource(DEPTH_PYRAMID);
+                                geometry->occlusion_world_to_proj = depth_pyramid->get_last_world_to_proj();
+                            }
+                        }
+                        else
+                        {
+                            // The command buffer of the last frame is completed before rendering a new frame, 
+                            // so the depth pyramid of the last frame can be read here.
+                            luexp(depth_pyramid->read_back());
+                            geometry->occlusion_culling_data = &depth_pyramid->get_readback();
+                        }
+                        depth_pyramid->world_to_proj = world_to_proj;
+                    }
                 }
             }
             luexp(m_render_graph->execute(command_buffer));
@@ -438,17 +619,102 @@ namespace Luna
                 {
                     enabled_passes.push_back(desc.passes[i].name);
                 }
-                Vector<u64> times;
-                auto r = m_render_graph->get_pass_time_intervals(times);
+                auto r = m_render_graph->get_pass_timestamps(pass_timestamps);
                 pass_time_intervals.clear();
+                timestamp_frequency = queue_freq;
                 if (succeeded(r))
                 {
-                    for (u64 t : times)
+                    for (usize i = 0; i + 1 < pass_timestamps.size(); i += 2)
                     {
-                        pass_time_intervals.push_back((f64)t / queue_freq);
+                        pass_time_intervals.push_back((f64)(pass_timestamps[i + 1] - pass_timestamps[i]) / queue_freq);
                     }
                 }
+                else
+                {
+                    pass_timestamps.clear();
+                }
+                if (failed(m_render_graph->get_stats(render_graph_stats)))
+                {
+                    render_graph_stats = {};
+                }
+            }
+            geometry_pipeline_statistics = {};
+            num_occlusion_culled_meshes = 0;
+            num_geometry_draw_calls = 0;
+            num_rendered_shadow_tiles = 0;
+            if (is_shadows_enabled())
+            {
+                RG::IRenderPass* shadow_pass = m_render_graph->get_render_pass(SHADOW_PASS);
+                if (shadow_pass) num_rendered_shadow_tiles = cast_object<ShadowPass>(shadow_pass->get_object())->num_rendered_tiles;
+            }
+            RG::IRenderPass* pass = m_settings.mode != SceneRendererMode::wireframe ? m_render_graph->get_render_pass(GEOMETRY_PASS) : nullptr;
+            if (pass)
+            {
+                GeometryPass* geometry = cast_object<GeometryPass>(pass->get_object());
+                auto r = geometry->read_pipeline_statistics(geometry_pipeline_statistics);
+                if (failed(r) || !r.get())
+                {
+                    geometry_pipeline_statistics = {};
+                }
+                num_occlusion_culled_meshes = geometry->num_culled_meshes;
+                num_geometry_draw_calls = geometry->num_draw_calls;
+            }
+        }
+    }
+    bool SceneRenderer::update_render_scale()
+    {
+        if (!m_settings.dynamic_resolution || !is_render_scale_enabled()) return false;
+        // Wait for the timestamps of the new render graph to be available.
+        if (m_frames_since_render_scale_change < RENDER_SCALE_SETTLE_FRAMES)
+        {
+            ++m_frames_since_render_scale_change;
+            return false;
+        }
+        Vector<u64> timestamps;
+        if (failed(m_render_graph->get_pass_timestamps(timestamps)) || timestamps.empty()) return false;
+        u64 begin = U64_MAX;
+        u64 end = 0;
+        for (usize i = 0; i + 1 < timestamps.size(); i += 2)
+        {
+            begin = min(begin, timestamps[i]);
+            end = max(end, timestamps[i + 1]);
+        }
+        if (end <= begin) return false;
+        f64 queue_freq = m_device->get_command_queue_timestamp_frequency(g_env->graphics_queue).get();
+        f32 gpu_frame_time = (f32)((f64)(end - begin) / queue_freq * 1000.0);
+        f32 render_scale = m_render_scale;
+        bool coarse_shading = m_coarse_shading;
+        if (gpu_frame_time > m_settings.target_gpu_frame_time * 1.05f)
+        {
+            // Reduce resolution first, then fall back to coarse shading if resolution cannot be reduced any more.
+            if (render_scale > MIN_RENDER_SCALE)
+            {
+                render_scale = max(render_scale - RENDER_SCALE_STEP, MIN_RENDER_SCALE);
+            }
+            else if (m_device->check_feature(RHI::DeviceFeature::variable_rate_shading).variable_rate_shading)
+            {
+                coarse_shading = true;
             }
         }
+        else if (gpu_frame_time < m_settings.target_gpu_frame_time * 0.8f)
+        {
+            // Recover in the reversed order.
+            if (coarse_shading)
+            {
+                coarse_shading = false;
+            }
+            else if (render_scale < 1.0f)
+            {
+                render_scale = min(render_scale + RENDER_SCALE_STEP, 1.0f);
+            }
+        }
+        bool rebuild = render_scale != m_render_scale;
+        if (rebuild || coarse_shading != m_coarse_shading)
+        {
+            m_render_scale = render_scale;
+            m_coarse_shading = coarse_shading;
+            m_frames_since_render_scale_change = 0;
+        }
+        return rebuild;
     }
 }
\ No newline at end of file
@@ -8,7 +8,7 @@
 * @date 2023/3/27
 */
 #pragma once
-#include "Scene.hpp"
+#include "SceneRenderData.hpp"
 #include <Luna/RG/RenderGraph.hpp>
 namespace Luna
 {
@@ -23,16 +23,6 @@ namespace Luna
         u32 screen_height;
     };
 
-    struct LightingParams
-    {
-        Float3U strength;
-        f32 attenuation_power;
-        Float3U direction;
-        u32 type;
-        Float3U position;
-        f32 spot_attenuation_power;
-    };
-
     enum class SceneRendererMode : u8
     {
         lit = 0,
@@ -59,12 +49,37 @@ namespace Luna
         bool frame_profiling = false;
         // The rendering mode.
         SceneRendererMode mode = SceneRendererMode::lit;
+        // Whether to scale the rendering resolution of the geometry buffer and lighting buffer dynamically
+        // based on GPU frame time. The scaled lighting buffer is upscaled to `screen_size` before tone mapping.
+        // Used only for modes that perform lighting.
+        bool dynamic_resolution = false;
+        // The GPU frame time, in milliseconds, that dynamic resolution tries to meet.
+        f32 target_gpu_frame_time = 16.0f;
+        // Whether to skip drawing meshes occluded by the depth buffer of the last frame.
+        // Used only for modes that render the geometry buffer.
+        bool occlusion_culling = false;
+        // Whether to cull meshes and generate draw arguments on GPU, so that meshes are drawn by a few indirect 
+        // draw calls. Used only for modes that render the geometry buffer, and only if the device supports
+        // `RHI::DeviceFeature::unbound_descriptor_array`.
+        bool gpu_driven = false;
+        // Whether to render depth of meshes front-to-back in one depth-only pass before rendering the geometry buffer,
+        // so that the geometry buffer is shaded once per pixel. Used only for modes that render the geometry buffer.
+        bool depth_prepass = false;
+        // Whether to render shadows of lights whose `cast_shadow` is `true`. Shadow tiles are cached across frames 
+        // and are rendered again only if their casters move. Used only for modes that perform lighting.
+        bool shadows = false;
 
         bool operator==(const SceneRendererSettings& rhs) const
         {
             return screen_size == rhs.screen_size && 
             frame_profiling == rhs.frame_profiling && 
-            mode == rhs.mode;
+            mode == rhs.mode &&
+            dynamic_resolution == rhs.dynamic_resolution &&
+            target_gpu_frame_time == rhs.target_gpu_frame_time &&
+            occlusion_culling == rhs.occlusion_culling &&
+            gpu_driven == rhs.gpu_driven &&
+            depth_prepass == rhs.depth_prepass &&
+            shadows == rhs.shadows;
         }
         bool operator!=(const SceneRendererSettings& rhs) const
         {
@@ -72,6 +87,9 @@ namespace Luna
         }
     };
 
+    // Renders one view of one scene. Data that does not depend on views, like transforms, GPU copies of model matrices 
+    // and lighting params and asset loading, is shared by all renderers of the same scene through `SceneRenderData`,
+    // while every renderer owns its render graph, camera data and shadow tiles.
     struct SceneRenderer
     {
         // The scene to be rendered.
@@ -87,12 +105,36 @@ namespace Luna
         Vector<Name> enabled_passes;
         // The time intervals of each passes if frame_profiling is enabled.
         Vector<f64> pass_time_intervals;
+        // The begin and end GPU timestamps of each passes if frame_profiling is enabled.
+        Vector<u64> pass_timestamps;
+        // The frequency of GPU timestamps.
+        f64 timestamp_frequency = 0.0;
+        // The pipeline statistics of the geometry pass if frame_profiling is enabled.
+        RHI::PipelineStatistics geometry_pipeline_statistics = {};
+        // The number of meshes culled by occlusion culling in the last frame.
+        u32 num_occlusion_culled_meshes = 0;
+        // The number of draw calls recorded by the geometry pass in the last frame.
+        u32 num_geometry_draw_calls = 0;
+        // The number of shadow tiles used and rendered in the last frame.
+        u32 num_shadow_tiles = 0;
+        u32 num_rendered_shadow_tiles = 0;
+        // The number of assets referenced by the scene that are not loaded, and the number of them being prefetched.
+        u32 num_unloaded_assets = 0;
+        u32 num_prefetching_assets = 0;
+        // The statistics of the render graph if frame_profiling is enabled.
+        RG::RenderGraphStats render_graph_stats;
 
         SceneRenderer(RHI::IDevice* device);
         const SceneRendererSettings& get_settings();
         RV reset(const SceneRendererSettings& settings);
         RV render();
         void collect_frame_profiling_data();
+        // Gets the current scale factor of the rendering resolution relative to the screen size.
+        f32 get_render_scale() const { return m_render_scale; }
+        // Gets the render graph used by this renderer, or `nullptr` if the renderer is not reset.
+        RG::IRenderGraph* get_render_graph() const { return m_render_graph.get(); }
+        // Checks whether the geometry pass is currently drawn with coarse shading rate.
+        bool is_coarse_shading() const { return m_coarse_shading; }
         
     private:
         // Resources.
@@ -104,21 +146,65 @@ namespace Luna
         static constexpr usize BASE_COLOR_ROUGHNESS_BUFFER = 5;
         static constexpr usize NORMAL_METALLIC_BUFFER = 6;
         static constexpr usize EMISSIVE_BUFFER = 7;
+        static constexpr usize UPSCALED_LIGHTING_BUFFER = 8;
+        static constexpr usize DEPTH_PYRAMID = 9;
+        static constexpr usize LIGHT_GRID = 10;
+        static constexpr usize LIGHT_INDICES = 11;
+        static constexpr usize SHADOW_ATLAS = 12;
+        static constexpr usize LUMINANCE_BUFFER = 13;
 
-        // Passes.
+        // Passes. Passes are executed in index order.
         static constexpr usize WIREFRAME_PASS = 0;
         static constexpr usize GEOMETRY_PASS = 1;
-        static constexpr usize BUFFER_VIS_PASS = 2;
-        static constexpr usize SKYBOX_PASS = 3;
-        static constexpr usize DEFERRED_LIGHTING_PASS = 4;
-        static constexpr usize TONE_MAPPING_PASS = 5;
+        static constexpr usize DEPTH_PYRAMID_PASS = 2;
+        static constexpr usize BUFFER_VIS_PASS = 3;
+        static constexpr usize AUTO_EXPOSURE_PASS = 4;
+        static constexpr usize SKYBOX_PASS = 5;
+        static constexpr usize SHADOW_PASS = 6;
+        static constexpr usize LIGHT_CULLING_PASS = 7;
+        static constexpr usize DEFERRED_LIGHTING_PASS = 8;
+        static constexpr usize UPSCALE_PASS = 9;
+        static constexpr usize TONE_MAPPING_PASS = 10;
+
+        // Dynamic resolution.
+        static constexpr f32 MIN_RENDER_SCALE = 0.5f;
+        static constexpr f32 RENDER_SCALE_STEP = 0.1f;
+        // The number of frames to wait after the render graph is changed before evaluating GPU frame time again.
+        static constexpr u32 RENDER_SCALE_SETTLE_FRAMES = 8;
         Ref<RHI::IDevice> m_device;
         SceneRendererSettings m_settings;
         Ref<RG::IRenderGraph> m_render_graph;
         Ref<RHI::IBuffer> m_camera_cb;
-        usize m_num_model_matrices = 0;
-        Ref<RHI::IBuffer> m_model_matrices;
-        usize m_num_lights = 0;
-        Ref<RHI::IBuffer> m_lighting_params;
+        // The render data of `scene` shared with other renderers.
+        Ref<SceneRenderData> m_scene_data;
+        // The frame index of the last `render` call, see `AppEnv::frame_index`.
+        u64 m_last_render_frame = U64_MAX;
+        // Model-to-world matrices of meshes to draw.
+        Vector<Float4x4> m_model_to_world_matrices;
+        // Scratch buffers for frustum culling.
+        Vector<u8> m_cull_results;
+        // Shadow tiles of this view.
+        SceneShadows m_shadows;
+        // The world-to-projection matrix of every shadow tile, read by the deferred lighting pass.
+        Ref<RHI::IBuffer> m_shadow_matrices;
+        // The adapted average luminance written by the auto exposure pass and read by the tone mapping pass.
+        // This is one external resource so that the luminance is kept when the render graph is rebuilt.
+        Ref<RHI::IBuffer> m_luminance_buffer;
+        // The scale factor of the rendering resolution.
+        f32 m_render_scale = 1.0f;
+        // Whether to draw the geometry pass with coarse shading rate. This is enabled only if 
+        // the rendering resolution reaches `MIN_RENDER_SCALE` and GPU frame time still exceeds the target.
+        bool m_coarse_shading = false;
+        u32 m_frames_since_render_scale_change = 0;
+
+        bool is_render_scale_enabled() const;
+        bool is_occlusion_culling_enabled() const;
+        bool is_gpu_driven_enabled() const;
+        bool is_shadows_enabled() const;
+        UInt2U get_render_size() const;
+        RV build_render_graph();
+        // Adjusts the render scale from the GPU frame time of the last frame.
+        // Returns `true` if the render graph needs to be rebuilt.
+        bool update_render_scale();
     };
 }
\ No newline at end of file
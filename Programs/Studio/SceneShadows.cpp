@@ -0,0 +1,189 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file SceneShadows.cpp
+* @author JXMaster
+* @date 2024/5/8
+*/
+#include "SceneShadows.hpp"
+
+namespace Luna
+{
+    // The maximum distance from the camera covered by directional light cascades.
+    constexpr f32 MAX_SHADOW_DISTANCE = 200.0f;
+    // The blend factor between logarithmic (1.0) and uniform (0.0) cascade splits.
+    constexpr f32 CASCADE_SPLIT_LAMBDA = 0.75f;
+    // Cascade centers are snapped to multiples of this number of texels in light space, so that one cascade moves
+    // only after the camera travels about one eighth of the cascade size.
+    constexpr f32 CASCADE_SNAP_TEXELS = 128.0f;
+    // The extra distance towards the light covered by cascades, so that casters outside of the view still cast shadows.
+    constexpr f32 CASCADE_CASTER_DISTANCE = 100.0f;
+    // The near plane distance of spot and point light shadow maps.
+    constexpr f32 SHADOW_NEAR_Z = 0.05f;
+    // Point and spot lights whose attenuated strength is lower than this value do not light surfaces.
+    // This must match LIGHT_CULLING_THRESHOLD in Shaders/LightCluster.hlsl.
+    constexpr f32 SHADOW_LIGHT_THRESHOLD = 0.001f;
+
+    // Makes one view matrix with orthonormal basis that looks to `dir`.
+    static Float4x4 make_light_view(const Float3& eye, const Float3& dir)
+    {
+        Float3 up = fabsf(dir.y) > 0.99f ? Float3(0.0f, 0.0f, 1.0f) : Float3(0.0f, 1.0f, 0.0f);
+        Float3 right = normalize(cross(up, dir));
+        return AffineMatrix::make_look_to(eye, dir, cross(dir, right));
+    }
+
+    static f32 get_light_range(const LightingParams& light)
+    {
+        f32 max_strength = max(max(light.strength.x, light.strength.y), light.strength.z);
+        f32 attenuation_power = max(light.attenuation_power, 0.000001f);
+        f32 range = attenuation_power * sqrtf(max(max_strength / SHADOW_LIGHT_THRESHOLD - 1.0f, 0.0f));
+        return clamp(range, SHADOW_NEAR_Z * 2.0f, MAX_SHADOW_DISTANCE);
+    }
+
+    static f32 snap(f32 value, f32 step)
+    {
+        return floorf(value / step + 0.5f) * step;
+    }
+
+    // Computes matrices of cascades of one directional light. Every cascade bounds one bounding sphere of one depth
+    // slice of the camera frustum, so the cascade size does not change when the camera rotates.
+    static void make_cascades(const Camera& camera, const Float4x4& camera_view_to_world, const Float3& light_dir, Float4x4* dst)
+    {
+        f32 near_z = camera.near_clipping_plane;
+        f32 far_z = max(min(camera.far_clipping_plane, MAX_SHADOW_DISTANCE), near_z * 2.0f);
+        // The half diagonal of the camera frustum slice at depth `z` is `extent_scale * z + extent_bias`.
+        f32 extent_scale = 0.0f;
+        f32 extent_bias = 0.0f;
+        if (camera.type == CameraType::perspective)
+        {
+            // `fov` is the diagonal field of view.
+            extent_scale = tanf(camera.fov * 0.5f);
+        }
+        else
+        {
+            f32 width = camera.size * 0.5f;
+            f32 height = width / camera.aspect_ratio;
+            extent_bias = sqrtf(width * width + height * height);
+        }
+        Float4x4 light_view = make_light_view(Float3(0.0f), light_dir);
+        f32 split_begin = near_z;
+        for (u32 i = 0; i < NUM_SHADOW_CASCADES; ++i)
+        {
+            f32 t = (f32)(i + 1) / (f32)NUM_SHADOW_CASCADES;
+            f32 log_split = near_z * powf(far_z / near_z, t);
+            f32 uniform_split = near_z + (far_z - near_z) * t;
+            f32 split_end = log_split * CASCADE_SPLIT_LAMBDA + uniform_split * (1.0f - CASCADE_SPLIT_LAMBDA);
+            // Finds the center on the view axis that has the same distance to near and far corners of the slice.
+            f32 e0 = extent_scale * split_begin + extent_bias;
+            f32 e1 = extent_scale * split_end + extent_bias;
+            f32 center_z = (e1 * e1 - e0 * e0 + split_end * split_end - split_begin * split_begin) / (2.0f * (split_end - split_begin));
+            center_z = clamp(center_z, split_begin, split_end);
+            f32 radius = sqrtf(max(e0 * e0 + (center_z - split_begin) * (center_z - split_begin),
+                e1 * e1 + (split_end - center_z) * (split_end - center_z)));
+            // Rounds the radius up so that floating-point errors do not change the cascade size.
+            radius = ceilf(radius * 16.0f) / 16.0f;
+            // The cascade is larger than the sphere so that the sphere is still covered after the center is snapped.
+            f32 half_size = radius * 1.25f;
+            f32 step = half_size * 2.0f * CASCADE_SNAP_TEXELS / (f32)SHADOW_TILE_SIZE;
+            Float3 center = mul(Float4(0.0f, 0.0f, center_z, 1.0f), camera_view_to_world).xyz();
+            Float3 light_center = mul(Float4(center.x, center.y, center.z, 1.0f), light_view).xyz();
+            light_center = Float3(snap(light_center.x, step), snap(light_center.y, step), snap(light_center.z, step));
+            Float4x4 proj = ProjectionMatrix::make_orthographic_off_center(
+                light_center.x - half_size, light_center.x + half_size,
+                light_center.y - half_size, light_center.y + half_size,
+                light_center.z - half_size - CASCADE_CASTER_DISTANCE, light_center.z + half_size);
+            dst[i] = mul(light_view, proj);
+            split_begin = split_end;
+        }
+    }
+
+    void assign_shadow_tiles(Span<LightingParams> lights, Span<const bool> cast_shadows)
+    {
+        u32 num_assigned_tiles = 0;
+        for (usize i = 0; i < lights.size(); ++i)
+        {
+            LightingParams& light = lights[i];
+            u32 num_tiles = light.type == 0 ? NUM_SHADOW_CASCADES : (light.type == 1 ? 6 : 1);
+            light.first_shadow_tile = 0;
+            light.num_shadow_tiles = 0;
+            if (!cast_shadows[i] || num_assigned_tiles + num_tiles > MAX_SHADOW_TILES) continue;
+            light.first_shadow_tile = num_assigned_tiles;
+            light.num_shadow_tiles = num_tiles;
+            num_assigned_tiles += num_tiles;
+        }
+    }
+
+    void SceneShadows::update(const SceneTransforms& transforms, SceneBVH& bvh, Span<const ShadowCaster> casters,
+        const Camera& camera, const Float4x4& camera_view_to_world, Span<const LightingParams> lights)
+    {
+        // Computes matrices of tiles assigned to lights.
+        m_tile_matrices.clear();
+        for (usize i = 0; i < lights.size(); ++i)
+        {
+            const LightingParams& light = lights[i];
+            if (!light.num_shadow_tiles) continue;
+            u32 num_tiles = light.num_shadow_tiles;
+            usize first = light.first_shadow_tile;
+            if (m_tile_matrices.size() < first + num_tiles) m_tile_matrices.resize(first + num_tiles);
+            Float4x4* dst = m_tile_matrices.data() + first;
+            Float3 position = light.position;
+            Float3 direction = normalize(Float3(light.direction));
+            if (light.type == 0)
+            {
+                make_cascades(camera, camera_view_to_world, direction, dst);
+            }
+            else if (light.type == 1)
+            {
+                // Cube faces, each covers 90 degrees so that every direction is covered by one face.
+                Float4x4 proj = ProjectionMatrix::make_perspective_fov_w(PI / 2.0f, 1.0f, SHADOW_NEAR_Z, get_light_range(light));
+                const Float3 face_dirs[6] = {
+                    Float3(1.0f, 0.0f, 0.0f), Float3(-1.0f, 0.0f, 0.0f),
+                    Float3(0.0f, 1.0f, 0.0f), Float3(0.0f, -1.0f, 0.0f),
+                    Float3(0.0f, 0.0f, 1.0f), Float3(0.0f, 0.0f, -1.0f)
+                };
+                for (u32 f = 0; f < 6; ++f)
+                {
+                    dst[f] = mul(make_light_view(position, face_dirs[f]), proj);
+                }
+            }
+            else
+            {
+                Float4x4 proj = ProjectionMatrix::make_perspective_fov_w(PI / 2.0f, 1.0f, SHADOW_NEAR_Z, get_light_range(light));
+                dst[0] = mul(make_light_view(position, direction), proj);
+            }
+        }
+
+        // Collects casters of every tile and compares them with the last frame.
+        usize num_tiles = m_tile_matrices.size();
+        usize num_old_tiles = tiles.size();
+        tiles.resize(num_tiles);
+        num_dirty_tiles = 0;
+        for (usize t = 0; t < num_tiles; ++t)
+        {
+            ShadowTile& tile = tiles[t];
+            m_tile_casters.clear();
+            if (!casters.empty() && bvh.cull(make_frustum(m_tile_matrices[t]), m_cull_results))
+            {
+                for (usize i = 0; i < casters.size(); ++i)
+                {
+                    if (m_cull_results[i]) m_tile_casters.push_back(casters[i]);
+                }
+            }
+            bool dirty = t >= num_old_tiles ||
+                memcmp(tile.world_to_proj.r[0].m, m_tile_matrices[t].r[0].m, sizeof(Float4x4)) != 0 ||
+                tile.casters.size() != m_tile_casters.size();
+            for (usize i = 0; i < m_tile_casters.size() && !dirty; ++i)
+            {
+                dirty = tile.casters[i] != m_tile_casters[i] || transforms.dirty[m_tile_casters[i].transform_index];
+            }
+            tile.world_to_proj = m_tile_matrices[t];
+            tile.casters.assign(m_tile_casters.begin(), m_tile_casters.end());
+            tile.dirty = dirty;
+            if (dirty) ++num_dirty_tiles;
+        }
+        m_meshes.clear();
+        for (auto& caster : casters) m_meshes.push_back(caster.mesh);
+    }
+}
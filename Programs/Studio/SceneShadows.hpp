@@ -0,0 +1,93 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file SceneShadows.hpp
+* @author JXMaster
+* @date 2024/5/8
+*/
+#pragma once
+#include "SceneBVH.hpp"
+#include "SceneGPUData.hpp"
+#include "Camera.hpp"
+#include "Mesh.hpp"
+
+namespace Luna
+{
+    // The width and height of one shadow tile in texels.
+    constexpr u32 SHADOW_TILE_SIZE = 1024;
+    // The number of tiles in the shadow atlas. Every tile is one array slice of the shadow atlas texture.
+    constexpr u32 MAX_SHADOW_TILES = 16;
+    // The number of cascades of one directional light.
+    constexpr u32 NUM_SHADOW_CASCADES = 4;
+
+    // One mesh that may cast shadows.
+    struct ShadowCaster
+    {
+        // The index of the entity in `SceneTransforms`, also the element index of its mesh buffer in `SceneGPUData::mesh_buffers`.
+        u32 transform_index;
+        Mesh* mesh;
+
+        bool operator==(const ShadowCaster& rhs) const
+        {
+            return transform_index == rhs.transform_index && mesh == rhs.mesh;
+        }
+        bool operator!=(const ShadowCaster& rhs) const
+        {
+            return !(*this == rhs);
+        }
+    };
+
+    // One shadow map stored in one tile of the shadow atlas.
+    struct ShadowTile
+    {
+        // The matrix that transforms world-space positions to the clip space of this tile.
+        Float4x4 world_to_proj;
+        // Meshes that intersect with the view frustum of this tile.
+        Vector<ShadowCaster> casters;
+        // Whether the tile must be rendered again, that is, its matrix or casters are changed, or any of its casters moves.
+        bool dirty = true;
+    };
+
+    // Assigns shadow atlas tiles to lights by writing `first_shadow_tile` and `num_shadow_tiles` of `lights`.
+    // `cast_shadows` specifies whether every light in `lights` casts shadows. Lights that cast shadows get tiles in order
+    // until the atlas is full, lights that do not get tiles are not shadowed. Tile ranges only depend on the light order,
+    // so that lighting params can be shared by all views of the scene.
+    void assign_shadow_tiles(Span<LightingParams> lights, Span<const bool> cast_shadows);
+
+    // Computes matrices of shadow tiles of one view and tracks which tiles need to be rendered again.
+    // Directional lights use NUM_SHADOW_CASCADES cascades that are snapped to coarse steps in light space, so that
+    // cascades of static lights only move after the camera travels a fraction of the cascade size. Spot lights use
+    // one tile and point lights use six tiles, whose matrices only change when lights move. Tiles whose matrices
+    // and casters are not changed keep their content from the last frame.
+    struct SceneShadows
+    {
+        // Tiles assigned in the last update. The tile index is also the array slice index in the shadow atlas.
+        Vector<ShadowTile> tiles;
+        // The number of dirty tiles in `tiles`.
+        u32 num_dirty_tiles = 0;
+
+        // Updates tiles for one frame.
+        // `casters` stores all meshes that may cast shadows, and must match objects passed to the last `bvh.update`.
+        // `lights` stores lighting params of all lights, whose tiles must be assigned by `assign_shadow_tiles`.
+        // `transforms` must be updated in this frame, and tiles must be invalidated if the last update is not called 
+        // in the last frame, since moved casters are detected by dirty flags of `transforms`.
+        void update(const SceneTransforms& transforms, SceneBVH& bvh, Span<const ShadowCaster> casters,
+            const Camera& camera, const Float4x4& camera_view_to_world, Span<const LightingParams> lights);
+
+        // Marks all tiles as dirty, so that they are rendered again in the next update.
+        void invalidate()
+        {
+            tiles.clear();
+        }
+
+    private:
+        // Meshes referred by `tiles`, kept alive so that their addresses are not reused while used to detect changes.
+        Vector<Ref<Mesh>> m_meshes;
+        // Scratch buffers.
+        Vector<Float4x4> m_tile_matrices;
+        Vector<ShadowCaster> m_tile_casters;
+        Vector<u8> m_cull_results;
+    };
+}
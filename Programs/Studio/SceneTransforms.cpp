@@ -0,0 +1,106 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SceneTransforms.cpp
+* @author JXMaster
+* @date 2024/4/25
+*/
+#include "SceneTransforms.hpp"
+#include "Scene.hpp"
+#include <Luna/JobSystem/Parallel.hpp>
+
+namespace Luna
+{
+    // The minimum number of entities processed by one job.
+    constexpr usize TRANSFORM_PROPAGATION_GRAIN = 256;
+
+    void SceneTransforms::update(Span<const Ref<Entity>> root_entities)
+    {
+        // Collect entities in breadth-first order. This only reads pointers, so it is much cheaper
+        // than computing transforms.
+        m_scratch_entities.clear();
+        m_scratch_parents.clear();
+        for (auto& e : root_entities)
+        {
+            m_scratch_entities.push_back(e.get());
+            m_scratch_parents.push_back(U32_MAX);
+        }
+        for (usize i = 0; i < m_scratch_entities.size(); ++i)
+        {
+            for (auto& child : m_scratch_entities[i]->children)
+            {
+                m_scratch_entities.push_back(child.get());
+                m_scratch_parents.push_back((u32)i);
+            }
+        }
+        bool hierarchy_changed = m_scratch_entities.size() != entities.size() ||
+            memcmp(m_scratch_entities.data(), entities.data(), sizeof(Entity*) * entities.size()) ||
+            memcmp(m_scratch_parents.data(), parents.data(), sizeof(u32) * parents.size());
+        if (hierarchy_changed)
+        {
+            rebuild();
+        }
+        usize num_entities = entities.size();
+        // Detect changed local transforms.
+        JobSystem::parallel_for(0, num_entities, TRANSFORM_PROPAGATION_GRAIN, [&](usize i)
+        {
+            Entity* e = entities[i];
+            LocalTransform& t = local_transforms[i];
+            if (hierarchy_changed || t.position != e->position || t.rotation != e->rotation || t.scale != e->scale)
+            {
+                t.position = e->position;
+                t.rotation = e->rotation;
+                t.scale = e->scale;
+                dirty[i] = 1;
+            }
+            else
+            {
+                dirty[i] = 0;
+            }
+        });
+        // Propagate transforms level by level. Parents are always updated before children, and
+        // entities in the same level are independent.
+        for (usize level = 0; level + 1 < level_offsets.size(); ++level)
+        {
+            JobSystem::parallel_for(level_offsets[level], level_offsets[level + 1], TRANSFORM_PROPAGATION_GRAIN, [&](usize i)
+            {
+                u32 parent = parents[i];
+                if (parent != U32_MAX && dirty[parent]) dirty[i] = 1;
+                if (!dirty[i]) return;
+                LocalTransform& t = local_transforms[i];
+                Float4x4 this_to_parent = AffineMatrix::make(t.position, t.rotation, t.scale);
+                local_to_world_matrices[i] = parent == U32_MAX ? this_to_parent : mul(this_to_parent, local_to_world_matrices[parent]);
+                world_to_local_matrices[i] = inverse(local_to_world_matrices[i]);
+            });
+        }
+    }
+
+    void SceneTransforms::rebuild()
+    {
+        entities.assign(Span<Entity* const>(m_scratch_entities.data(), m_scratch_entities.size()));
+        parents.assign(Span<const u32>(m_scratch_parents.data(), m_scratch_parents.size()));
+        usize num_entities = entities.size();
+        local_transforms.resize(num_entities);
+        local_to_world_matrices.resize(num_entities);
+        world_to_local_matrices.resize(num_entities);
+        dirty.resize(num_entities);
+        indices.clear();
+        level_offsets.clear();
+        // Entities are collected in breadth-first order, so one level ends when one entity's parent
+        // belongs to the current level.
+        u32 level_begin = 0;
+        level_offsets.push_back(0);
+        for (usize i = 0; i < num_entities; ++i)
+        {
+            indices.insert(make_pair(entities[i], (u32)i));
+            if (parents[i] != U32_MAX && parents[i] >= level_begin)
+            {
+                level_begin = (u32)i;
+                level_offsets.push_back((u32)i);
+            }
+        }
+        level_offsets.push_back((u32)num_entities);
+    }
+}
@@ -0,0 +1,65 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SceneTransforms.hpp
+* @author JXMaster
+* @date 2024/4/25
+*/
+#pragma once
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/Ref.hpp>
+#include <Luna/Runtime/Math/Transform.hpp>
+
+namespace Luna
+{
+    struct Entity;
+
+    // Caches world transforms of all entities in one scene.
+    // Entities are stored in one flat array ordered by depth, so that parents always come before
+    // their children, and every depth level can be propagated in parallel.
+    struct SceneTransforms
+    {
+        struct LocalTransform
+        {
+            Float3 position;
+            Float4 rotation;
+            Float3 scale;
+        };
+
+        // Entities ordered by depth.
+        Vector<Entity*> entities;
+        // The index of the parent entity in `entities`, or `U32_MAX` for root entities.
+        Vector<u32> parents;
+        // The first entity index of every depth level, plus the number of entities at the end.
+        Vector<u32> level_offsets;
+        // Cached local transforms used to detect changes.
+        Vector<LocalTransform> local_transforms;
+        Vector<Float4x4> local_to_world_matrices;
+        Vector<Float4x4> world_to_local_matrices;
+        // Whether the world transform of the entity is changed in the last update.
+        Vector<u8> dirty;
+        // Maps entities to their indices in `entities`.
+        HashMap<Entity*, u32> indices;
+
+        // Updates the cached transforms. Only entities whose local transforms are changed and their
+        // descendants are recomputed. The hierarchy is rebuilt if entities are added, removed or moved.
+        void update(Span<const Ref<Entity>> root_entities);
+
+        // Gets the index of the entity, returns `U32_MAX` if the entity is not in the cache.
+        u32 get_index(Entity* entity) const
+        {
+            auto iter = indices.find(entity);
+            return iter == indices.end() ? U32_MAX : iter->second;
+        }
+
+    private:
+        // Scratch buffer used to detect hierarchy changes.
+        Vector<Entity*> m_scratch_entities;
+        Vector<u32> m_scratch_parents;
+
+        void rebuild();
+    };
+}
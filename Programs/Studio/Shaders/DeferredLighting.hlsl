@@ -1,10 +1,16 @@
 #include "BRDF.hlsl"
 #include "CameraParams.hlsl"
+#include "LightCluster.hlsl"
 
 cbuffer LightingParams : register(b1)
 {
     uint lighting_mode;
     uint num_lights;
+    uint2 cluster_count_xy;
+    float slice_scale;
+    float slice_bias;
+    // 0 if the shadow atlas is not rendered, in which case tile ranges of lights are ignored.
+    uint shadows_enabled;
 };
 
 static const uint LIGHTING_MODE_LIT = 0;
@@ -14,22 +20,6 @@ static const uint LIGHTING_MODE_SPECULAR_LIGHTING = 3;
 static const uint LIGHTING_MODE_AMBIENT_DIFFUSE_LIGHTING = 4;
 static const uint LIGHTING_MODE_AMBIENT_SPECULAR_LIGHTING = 5;
 
-struct LightParams
-{
-    float3 strength;
-    float attenuation_power;    // Only for point / spot light.
-
-    float3 direction;   // Only for directional / spot light.
-    uint type;          // 0 = directional, 1 = point, 2 = spot.
-
-    float3 position;    // Only for point / spot light. In world space.
-    float spot_attenuation_power;   // Only for spot light.
-};
-
-static const uint DIRECTIONAL_LIGHT = 0;
-static const uint POINT_LIGHT = 1;
-static const uint SPOT_LIGHT = 2;
-
 StructuredBuffer<LightParams> g_light_params : register(t2);
 Texture2D<float4> g_base_color_roughness : register(t3);
 Texture2D<float4> g_normal_metallic : register(t4);
@@ -39,6 +29,30 @@ Texture2D<float4> g_skybox : register(t7);
 Texture2D<float4> g_integrate_brdf : register(t8);
 RWTexture2D<float4> g_light_buffer : register(u9);
 SamplerState g_sampler : register(s10);
+StructuredBuffer<uint> g_light_grid : register(t11);
+StructuredBuffer<uint> g_light_indices : register(t12);
+// Every array slice stores one shadow tile, see `SceneShadows`.
+Texture2DArray<float> g_shadow_atlas : register(t13);
+StructuredBuffer<float4x4> g_shadow_matrices : register(t14);
+SamplerComparisonState g_shadow_sampler : register(s15);
+
+// Gets the fraction of light that reaches the world position, 1.0 if the light is not shadowed.
+// Tiles of directional lights are ordered from the nearest cascade to the farthest one, so the first tile that 
+// contains the position is used.
+float get_shadow(LightParams light, float3 world_position)
+{
+    for (uint i = 0; i < light.num_shadow_tiles; ++i)
+    {
+        uint tile = light.first_shadow_tile + i;
+        float4 p = mul(g_shadow_matrices[tile], float4(world_position, 1.0f));
+        if (p.w <= 0.0f) continue;
+        float3 ndc = p.xyz / p.w;
+        if (abs(ndc.x) > 1.0f || abs(ndc.y) > 1.0f || ndc.z < 0.0f || ndc.z > 1.0f) continue;
+        float2 uv = float2(ndc.x * 0.5f + 0.5f, 0.5f - ndc.y * 0.5f);
+        return g_shadow_atlas.SampleCmpLevelZero(g_shadow_sampler, float3(uv, (float)tile), ndc.z);
+    }
+    return 1.0f;
+}
 
 float3 fresnel_lerp(float3 specular_color_0, float3 specular_color_1, float l_dot_h)
 {
@@ -82,9 +96,13 @@ void main(int3 dispatch_thread_id : SV_DispatchThreadID)
         lighting_mode == LIGHTING_MODE_DIFFUSE_LIGHTING ||
         lighting_mode == LIGHTING_MODE_SPECULAR_LIGHTING)
     {
-        // Calculates lights contribution.
-        for (uint index = 0; index < num_lights; ++index)
+        // Calculates lights contribution. Only lights assigned to the cluster of this pixel are evaluated.
+        float view_z = mul(world_to_view, float4(world_position, 1.0f)).z;
+        uint cluster = get_light_cluster_index(dispatch_thread_id.xy, view_z, cluster_count_xy, slice_scale, slice_bias);
+        uint num_cluster_lights = min(g_light_grid[cluster], MAX_LIGHTS_PER_CLUSTER);
+        for (uint i = 0; i < num_cluster_lights; ++i)
         {
+            uint index = g_light_indices[cluster * MAX_LIGHTS_PER_CLUSTER + i];
             float3 light_color = g_light_params[index].strength;
             float3 light_dir;                    // frag to light.
             if (g_light_params[index].type == DIRECTIONAL_LIGHT) // directional.
@@ -113,6 +131,10 @@ void main(int3 dispatch_thread_id : SV_DispatchThreadID)
             float3 half_dir = normalize(light_dir + view_dir);
             float nl = dot(normal, light_dir);
             if(nl <= 0.0) continue;
+            if (shadows_enabled && g_light_params[index].num_shadow_tiles)
+            {
+                light_color *= get_shadow(g_light_params[index], world_position);
+            }
             float nh = dot(normal, half_dir);
             float vh = dot(view_dir, half_dir);
 
@@ -0,0 +1,5 @@
+// The depth pre-pass writes depth only. This empty pixel shader is used since some backends require one pixel shader 
+// for every graphics pipeline.
+void main()
+{
+}
@@ -0,0 +1,13 @@
+#include "GeometryCommon.hlsl"
+struct VS_INPUT
+{
+    [[vk::location(0)]]
+    float3 position : POSITION;
+};
+
+float4 main(VS_INPUT input, uint instance_id : SV_InstanceID) : SV_POSITION
+{
+    MeshBuffer mesh_buffer = g_MeshBuffer[g_instance_mesh_buffer_indices[g_draw_params.first_instance + instance_id]];
+    float3 world_position;
+    return transform_position(mesh_buffer, input.position, world_position);
+}
@@ -0,0 +1,27 @@
+cbuffer CB : register(b0)
+{
+    uint2 src_size;
+    uint2 dst_size;
+}
+Texture2D<float> g_src_tex : register(t1);
+RWTexture2D<float> g_dst_tex : register(u2);
+
+[numthreads(8, 8, 1)]
+void main(uint3 dispatch_thread_id : SV_DispatchThreadID)
+{
+    if (any(dispatch_thread_id.xy >= dst_size)) return;
+    // The range of source pixels covered by this destination pixel. The range is rounded outward, so that
+    // source pixels in the last row or column are not skipped when the source dimension is odd.
+    uint2 begin = (dispatch_thread_id.xy * src_size) / dst_size;
+    uint2 end = min(((dispatch_thread_id.xy + 1) * src_size + dst_size - 1) / dst_size, src_size);
+    // Stores the farthest depth, so that one object is occluded only if it is behind all occluders in the region.
+    float depth = 0.0f;
+    for (uint y = begin.y; y < end.y; ++y)
+    {
+        for (uint x = begin.x; x < end.x; ++x)
+        {
+            depth = max(depth, g_src_tex[uint2(x, y)]);
+        }
+    }
+    g_dst_tex[dispatch_thread_id.xy] = depth;
+}
@@ -0,0 +1,52 @@
+#include "GeometryCommon.hlsl"
+#include "GeometryPixelCommon.hlsl"
+// Matches `get_gpu_scene_bindless_table_desc` in RenderPasses/GPUScene.hpp.
+#define LUNA_BINDLESS_SET 1
+#define LUNA_BINDLESS_MAX_TEXTURES 2048
+#define LUNA_BINDLESS_MAX_BUFFERS 1
+#include "Bindless.hlsl"
+
+// The bindless texture indices of one material. This must match `GPUSceneMaterial` in RenderPasses/GPUScene.hpp.
+struct GeometryMaterial
+{
+    uint base_color;
+    uint roughness;
+    uint normal;
+    uint metallic;
+    uint emissive;
+};
+StructuredBuffer<GeometryMaterial> g_materials : register(t10);
+
+struct PSInput
+{
+    [[vk::location(0)]]
+    float4 position : SV_POSITION;
+    [[vk::location(1)]]
+    float3 normal   : NORMAL;
+    [[vk::location(2)]]
+    float3 tangent  : TANGENT;
+    [[vk::location(3)]]
+    float2 texcoord : TEXCOORD;
+    [[vk::location(4)]]
+    float4 color    : COLOR;
+    [[vk::location(5)]]
+    float3 world_position : POSITION;
+    [[vk::location(6)]]
+    nointerpolation uint material : MATERIAL;
+};
+
+PSOutput main(PSInput i)
+{
+    float2 texcoord = get_material_texcoord(i.texcoord);
+    GeometryMaterial material = g_materials[i.material];
+
+    // Sample every texture. Pixels in one wave may belong to different instances and use different materials.
+    float4 base_color = BINDLESS_TEXTURE(material.base_color).Sample(g_sampler, texcoord);
+    clip(base_color.w - 0.1f);
+    float roughness = BINDLESS_TEXTURE(material.roughness).Sample(g_sampler, texcoord).x;
+    float3 normal = normalize(BINDLESS_TEXTURE(material.normal).Sample(g_sampler, texcoord).xyz - 0.5f);
+    float metallic = BINDLESS_TEXTURE(material.metallic).Sample(g_sampler, texcoord).x;
+    float4 emissive = BINDLESS_TEXTURE(material.emissive).Sample(g_sampler, texcoord);
+
+    return write_gbuffer(i.normal, i.tangent, base_color.xyz, roughness, normal, metallic, emissive.xyz);
+}
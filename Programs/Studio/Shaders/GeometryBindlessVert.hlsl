@@ -0,0 +1,36 @@
+#include "CommonVertex.hlsl"
+#include "GeometryCommon.hlsl"
+// The material index of every instance, indexed like `g_instance_mesh_buffer_indices`.
+StructuredBuffer<uint> g_instance_materials : register(t9);
+
+struct PS_INPUT
+{
+    [[vk::location(0)]]
+    float4 position : SV_POSITION;
+    [[vk::location(1)]]
+    float3 normal   : NORMAL;
+    [[vk::location(2)]]
+    float3 tangent  : TANGENT;
+    [[vk::location(3)]]
+    float2 texcoord : TEXCOORD;
+    [[vk::location(4)]]
+    float4 color    : COLOR;
+    [[vk::location(5)]]
+    float3 world_position : POSITION;
+    [[vk::location(6)]]
+    nointerpolation uint material : MATERIAL;
+};
+
+PS_INPUT main(MeshVertex input, uint instance_id : SV_InstanceID)
+{
+    PS_INPUT output;
+    uint instance = g_draw_params.first_instance + instance_id;
+    MeshBuffer mesh_buffer = g_MeshBuffer[g_instance_mesh_buffer_indices[instance]];
+    output.position = transform_position(mesh_buffer, input.position, output.world_position);
+    output.normal = mul(float4(input.normal, 0.0f), mesh_buffer.world_to_model).xyz;
+    output.tangent = mul(float4(input.tangent, 0.0f), mesh_buffer.world_to_model).xyz;
+    output.texcoord = input.texcoord;    
+    output.color = input.color;
+    output.material = g_instance_materials[instance];
+    return output;
+}
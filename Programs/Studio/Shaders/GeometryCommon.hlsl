@@ -11,9 +11,23 @@ cbuffer CBParam : register(b0)
     uint screen_height;
 };
 StructuredBuffer<MeshBuffer> g_MeshBuffer : register(t1);
-Texture2D g_base_color : register(t2);
-Texture2D g_roughness : register(t3);
-Texture2D g_normal : register(t4);
-Texture2D g_metallic : register(t5);
-Texture2D g_emissive : register(t6);
-SamplerState g_sampler : register(s7);
\ No newline at end of file
+// Material textures are bound to `t2` to `t6` by GeometryPixel.hlsl, and are fetched from the bindless resource table 
+// by GeometryBindlessPixel.hlsl.
+SamplerState g_sampler : register(s7);
+// The index of the mesh buffer of every instance, indexed by `g_draw_params.first_instance + SV_InstanceID`.
+StructuredBuffer<uint> g_instance_mesh_buffer_indices : register(t8);
+struct DrawParams
+{
+    uint first_instance;
+};
+[[vk::push_constant]] ConstantBuffer<DrawParams> g_draw_params : register(b0, space15);
+
+// Transforms one vertex position to world space and clip space. The geometry pass and the depth pre-pass must both 
+// use this function, so that depth values written by the pre-pass are matched exactly by depth-equal testing.
+float4 transform_position(MeshBuffer mesh_buffer, float3 position, out float3 world_position)
+{
+    precise float3 world = mul(mesh_buffer.model_to_world, float4(position, 1.0f)).xyz;
+    precise float4 clip = mul(world_to_proj, float4(world, 1.0f));
+    world_position = world;
+    return clip;
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+// Shared by GeometryPixel.hlsl and GeometryBindlessPixel.hlsl.
+struct PSOutput
+{
+    // RGB: base color, A: roughness
+    [[vk::location(0)]]
+    float4 base_color_roughness : SV_Target0;
+    // RGB: normal, A: metallic
+    [[vk::location(1)]]
+    float4 normal_metallic : SV_Target1;
+    // RGB: emissive, A: unused.
+    [[vk::location(2)]]
+    float4 emissive : SV_Target2;
+};
+
+float3 normal_tangent_to_world(float3 normal_map, float3 normal_world, float3 tangent_world)
+{
+    float3 n = normal_world;
+    float3 t = normalize(tangent_world - dot(tangent_world, n) * n);
+    float3 b = cross(n, t);
+    float3x3 tbn = float3x3(t, b, n);
+    return mul(normal_map, tbn);
+}
+
+// Converts mesh texture coordinates to the texture coordinates used to sample material textures.
+float2 get_material_texcoord(float2 texcoord)
+{
+    return float2(texcoord.x, 1.0f - texcoord.y);
+}
+
+// Writes G-buffer values from sampled material values.
+PSOutput write_gbuffer(float3 normal_world, float3 tangent_world, float3 base_color, float roughness, float3 normal_map,
+    float metallic, float3 emissive)
+{
+    // Calculates per-model informations.
+    float3 base_normal = normalize(normal_world);
+    float3 base_tangent = normalize(tangent_world);
+
+    // Apply normal map to model normal.
+    float3 normal = normal_tangent_to_world(normal_map, base_normal, base_tangent);
+
+    PSOutput o;
+    o.base_color_roughness.xyz = base_color;
+    o.base_color_roughness.w = roughness;
+    o.normal_metallic.xyz = max(normal * 0.5f + 0.5f, 0.0f);
+    o.normal_metallic.w = metallic;
+    o.emissive.xyz = emissive;
+    o.emissive.w = 0.0f;
+    return o;
+}
@@ -16,13 +16,13 @@ struct PS_INPUT
     float3 world_position : POSITION;
 };
 
-PS_INPUT main(MeshVertex input)
+PS_INPUT main(MeshVertex input, uint instance_id : SV_InstanceID)
 {
     PS_INPUT output;
-    output.world_position = mul(g_MeshBuffer[0].model_to_world, float4(input.position, 1.0f)).xyz;
-    output.position = mul(world_to_proj, float4(output.world_position, 1.0f));
-    output.normal = mul(float4(input.normal, 0.0f), g_MeshBuffer[0].world_to_model).xyz;
-    output.tangent = mul(float4(input.tangent, 0.0f), g_MeshBuffer[0].world_to_model).xyz;
+    MeshBuffer mesh_buffer = g_MeshBuffer[g_instance_mesh_buffer_indices[g_draw_params.first_instance + instance_id]];
+    output.position = transform_position(mesh_buffer, input.position, output.world_position);
+    output.normal = mul(float4(input.normal, 0.0f), mesh_buffer.world_to_model).xyz;
+    output.tangent = mul(float4(input.tangent, 0.0f), mesh_buffer.world_to_model).xyz;
     output.texcoord = input.texcoord;    
     output.color = input.color;    
     return output;
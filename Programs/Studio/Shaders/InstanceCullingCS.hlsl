@@ -0,0 +1,104 @@
+#include "CameraParams.hlsl"
+#include "MeshBuffer.hlsl"
+
+// The number of instances processed by one thread group. This must match INSTANCE_CULLING_GROUP_SIZE in GeometryPass.cpp.
+#define INSTANCE_CULLING_GROUP_SIZE 64
+
+// The number of 32-bit values of one indexed indirect draw argument record.
+#define DRAW_ARGUMENTS_STRIDE 5
+
+struct GPUSceneInstance
+{
+    float3 bounding_box_min;
+    uint mesh_buffer_index;
+    float3 bounding_box_max;
+    uint batch;
+    uint batch_first_instance;
+    uint material;
+};
+
+cbuffer CullingParams : register(b1)
+{
+    // The world-to-projection matrix used to render the depth pyramid.
+    float4x4 occlusion_world_to_proj;
+    uint num_instances;
+    // The size of the first level of the depth pyramid.
+    uint occlusion_width;
+    uint occlusion_height;
+    // The number of levels of the depth pyramid. Occlusion culling is disabled if this is 0.
+    uint occlusion_mip_levels;
+};
+StructuredBuffer<MeshBuffer> g_mesh_buffers : register(t2);
+StructuredBuffer<GPUSceneInstance> g_instances : register(t3);
+// The depth pyramid of the last frame written by DepthPyramidCS.hlsl, every texel stores the farthest depth of its region.
+Texture2D<float> g_depth_pyramid : register(t4);
+RWStructuredBuffer<uint> g_draw_arguments : register(u5);
+RWStructuredBuffer<uint> g_visible_instances : register(u6);
+RWStructuredBuffer<uint> g_visible_instance_materials : register(u7);
+
+// Computes the bounding rectangle of one bounding box in normalized device coordinates.
+// Returns false if the bounding box intersects the near plane.
+bool project_bounding_box(float3 bounding_box_min, float3 bounding_box_max, float4x4 model_to_world, float4x4 world_to_proj,
+    out float3 ndc_min, out float3 ndc_max)
+{
+    ndc_min = float3(1e30f, 1e30f, 1e30f);
+    ndc_max = float3(-1e30f, -1e30f, -1e30f);
+    for (uint i = 0; i < 8; ++i)
+    {
+        float3 corner = float3(
+            (i & 1) ? bounding_box_max.x : bounding_box_min.x,
+            (i & 2) ? bounding_box_max.y : bounding_box_min.y,
+            (i & 4) ? bounding_box_max.z : bounding_box_min.z);
+        float4 p = mul(world_to_proj, mul(model_to_world, float4(corner, 1.0f)));
+        if (p.w <= 0.0f) return false;
+        float3 ndc = p.xyz / p.w;
+        ndc_min = min(ndc_min, ndc);
+        ndc_max = max(ndc_max, ndc);
+    }
+    return true;
+}
+
+bool is_visible(GPUSceneInstance instance, float4x4 model_to_world)
+{
+    float3 ndc_min;
+    float3 ndc_max;
+    // Bounding boxes that intersect the near plane are treated as visible.
+    if (!project_bounding_box(instance.bounding_box_min, instance.bounding_box_max, model_to_world, world_to_proj, ndc_min, ndc_max)) return true;
+    // Frustum test.
+    if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f || ndc_min.z > 1.0f) return false;
+    if (occlusion_mip_levels == 0) return true;
+    // Occlusion test against the depth pyramid of the last frame.
+    if (!project_bounding_box(instance.bounding_box_min, instance.bounding_box_max, model_to_world, occlusion_world_to_proj, ndc_min, ndc_max)) return true;
+    if (ndc_max.x < -1.0f || ndc_min.x > 1.0f || ndc_max.y < -1.0f || ndc_min.y > 1.0f || ndc_min.z > 1.0f) return true;
+    // The bounding rectangle in texture space. The Y axis is flipped in texture space.
+    float2 uv_min = saturate(float2(ndc_min.x * 0.5f + 0.5f, 0.5f - ndc_max.y * 0.5f));
+    float2 uv_max = saturate(float2(ndc_max.x * 0.5f + 0.5f, 0.5f - ndc_min.y * 0.5f));
+    // Selects the first level where the rectangle is not larger than one texel, so that it covers at most 2x2 texels.
+    float2 size = (uv_max - uv_min) * float2(occlusion_width, occlusion_height);
+    uint mip = min((uint)ceil(log2(max(max(size.x, size.y), 1.0f))), occlusion_mip_levels - 1);
+    int2 level_size = int2(max(occlusion_width >> mip, 1u), max(occlusion_height >> mip, 1u));
+    int2 begin = clamp((int2)(uv_min * level_size), 0, level_size - 1);
+    int2 end = clamp((int2)(uv_max * level_size), 0, level_size - 1);
+    for (int y = begin.y; y <= end.y; ++y)
+    {
+        for (int x = begin.x; x <= end.x; ++x)
+        {
+            if (ndc_min.z <= g_depth_pyramid.Load(int3(x, y, mip))) return true;
+        }
+    }
+    return false;
+}
+
+[numthreads(INSTANCE_CULLING_GROUP_SIZE, 1, 1)]
+void main(uint3 dispatch_thread_id : SV_DispatchThreadID)
+{
+    uint index = dispatch_thread_id.x;
+    if (index >= num_instances) return;
+    GPUSceneInstance instance = g_instances[index];
+    if (!is_visible(instance, g_mesh_buffers[instance.mesh_buffer_index].model_to_world)) return;
+    // Appends the instance to its batch by incrementing `instance_count` of the draw arguments.
+    uint slot;
+    InterlockedAdd(g_draw_arguments[instance.batch * DRAW_ARGUMENTS_STRIDE + 1], 1, slot);
+    g_visible_instances[instance.batch_first_instance + slot] = instance.mesh_buffer_index;
+    g_visible_instance_materials[instance.batch_first_instance + slot] = instance.material;
+}
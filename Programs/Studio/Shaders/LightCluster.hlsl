@@ -0,0 +1,47 @@
+// Light cluster layout shared by light culling and lighting shaders.
+// The view frustum is split into screen-space tiles of LIGHT_CLUSTER_TILE_SIZE x LIGHT_CLUSTER_TILE_SIZE pixels, and 
+// every tile is split into LIGHT_CLUSTER_Z_SLICES depth slices distributed exponentially between near and far planes.
+// These values must match the values in LightCullingPass.hpp.
+static const uint LIGHT_CLUSTER_TILE_SIZE = 64;
+static const uint LIGHT_CLUSTER_Z_SLICES = 24;
+static const uint MAX_LIGHTS_PER_CLUSTER = 128;
+
+// Point and spot lights whose attenuated strength is lower than this value are not assigned to clusters.
+static const float LIGHT_CULLING_THRESHOLD = 0.001f;
+
+struct LightParams
+{
+    float3 strength;
+    float attenuation_power;    // Only for point / spot light.
+
+    float3 direction;   // Only for directional / spot light.
+    uint type;          // 0 = directional, 1 = point, 2 = spot.
+
+    float3 position;    // Only for point / spot light. In world space.
+    float spot_attenuation_power;   // Only for spot light.
+
+    uint first_shadow_tile; // The first shadow atlas tile of this light.
+    uint num_shadow_tiles;  // The number of shadow atlas tiles of this light, 0 if the light is not shadowed.
+};
+
+static const uint DIRECTIONAL_LIGHT = 0;
+static const uint POINT_LIGHT = 1;
+static const uint SPOT_LIGHT = 2;
+
+// Gets the distance where the attenuated light strength reaches LIGHT_CULLING_THRESHOLD.
+float get_light_range(LightParams light)
+{
+    float max_strength = max(max(light.strength.x, light.strength.y), light.strength.z);
+    float attenuation_power = max(light.attenuation_power, 0.000001f);
+    return attenuation_power * sqrt(max(max_strength / LIGHT_CULLING_THRESHOLD - 1.0f, 0.0f));
+}
+
+// Gets the index of the cluster that contains the specified pixel.
+// `slice_scale` and `slice_bias` map log2 of view-space depth to depth slices.
+uint get_light_cluster_index(uint2 pixel, float view_z, uint2 cluster_count_xy, float slice_scale, float slice_bias)
+{
+    float slice = floor(log2(max(view_z, 0.000001f)) * slice_scale - slice_bias);
+    uint z = (uint)clamp(slice, 0.0f, (float)(LIGHT_CLUSTER_Z_SLICES - 1));
+    uint2 tile = min(pixel / LIGHT_CLUSTER_TILE_SIZE, cluster_count_xy - 1);
+    return (z * cluster_count_xy.y + tile.y) * cluster_count_xy.x + tile.x;
+}
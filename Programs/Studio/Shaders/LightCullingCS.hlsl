@@ -0,0 +1,114 @@
+#include "CameraParams.hlsl"
+#include "LightCluster.hlsl"
+
+cbuffer LightCullingParams : register(b1)
+{
+    uint3 cluster_count;
+    uint num_lights;
+    float slice_scale;
+    float slice_bias;
+};
+
+StructuredBuffer<LightParams> g_light_params : register(t2);
+// The number of lights of every cluster.
+RWStructuredBuffer<uint> g_light_grid : register(u3);
+// The light indices of every cluster, every cluster has MAX_LIGHTS_PER_CLUSTER elements.
+RWStructuredBuffer<uint> g_light_indices : register(u4);
+
+static const uint LIGHT_CULLING_GROUP_SIZE = 64;
+
+// Bounding spheres of lights in view space, loaded by the thread group in batches. 
+// Directional lights have negative radius, and are assigned to all clusters.
+groupshared float4 s_light_spheres[LIGHT_CULLING_GROUP_SIZE];
+
+float3 unproject_to_view(float4x4 proj_to_view, float2 ndc, float z)
+{
+    float4 p = mul(proj_to_view, float4(ndc, z, 1.0f));
+    return p.xyz / p.w;
+}
+
+// Gets the point on the line from `near_p` to `far_p` with the specified view-space depth.
+float3 point_at_depth(float3 near_p, float3 far_p, float view_z)
+{
+    float t = (view_z - near_p.z) / (far_p.z - near_p.z);
+    return lerp(near_p, far_p, t);
+}
+
+[numthreads(LIGHT_CULLING_GROUP_SIZE, 1, 1)]
+void main(uint3 dispatch_thread_id : SV_DispatchThreadID, uint group_index : SV_GroupIndex)
+{
+    uint cluster = dispatch_thread_id.x;
+    uint num_clusters = cluster_count.x * cluster_count.y * cluster_count.z;
+    bool valid_cluster = cluster < num_clusters;
+
+    // Computes the view-space bounding box of the cluster.
+    uint tile_x = cluster % cluster_count.x;
+    uint tile_y = (cluster / cluster_count.x) % cluster_count.y;
+    uint slice = cluster / (cluster_count.x * cluster_count.y);
+    float2 pixel_min = float2(tile_x, tile_y) * LIGHT_CLUSTER_TILE_SIZE;
+    float2 pixel_max = min(pixel_min + LIGHT_CLUSTER_TILE_SIZE, float2(screen_width, screen_height));
+    float2 ndc_min = float2(pixel_min.x / screen_width * 2.0f - 1.0f, 1.0f - pixel_max.y / screen_height * 2.0f);
+    float2 ndc_max = float2(pixel_max.x / screen_width * 2.0f - 1.0f, 1.0f - pixel_min.y / screen_height * 2.0f);
+    float z_near = exp2((slice + slice_bias) / slice_scale);
+    float z_far = exp2((slice + 1 + slice_bias) / slice_scale);
+    float4x4 proj_to_view = mul(world_to_view, proj_to_world);
+    float3 aabb_min = 1e30f;
+    float3 aabb_max = -1e30f;
+    [unroll]
+    for (uint i = 0; i < 4; ++i)
+    {
+        float2 ndc = float2((i & 1) ? ndc_max.x : ndc_min.x, (i & 2) ? ndc_max.y : ndc_min.y);
+        float3 near_p = unproject_to_view(proj_to_view, ndc, 0.0f);
+        float3 far_p = unproject_to_view(proj_to_view, ndc, 1.0f);
+        float3 p0 = point_at_depth(near_p, far_p, z_near);
+        float3 p1 = point_at_depth(near_p, far_p, z_far);
+        aabb_min = min(aabb_min, min(p0, p1));
+        aabb_max = max(aabb_max, max(p0, p1));
+    }
+
+    uint count = 0;
+    uint base_index = cluster * MAX_LIGHTS_PER_CLUSTER;
+    for (uint batch = 0; batch < num_lights; batch += LIGHT_CULLING_GROUP_SIZE)
+    {
+        // Every thread loads one light of the batch.
+        uint light_index = batch + group_index;
+        if (light_index < num_lights)
+        {
+            LightParams light = g_light_params[light_index];
+            if (light.type == DIRECTIONAL_LIGHT)
+            {
+                s_light_spheres[group_index] = float4(0.0f, 0.0f, 0.0f, -1.0f);
+            }
+            else
+            {
+                float3 view_pos = mul(world_to_view, float4(light.position, 1.0f)).xyz;
+                s_light_spheres[group_index] = float4(view_pos, get_light_range(light));
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+        uint batch_size = min(LIGHT_CULLING_GROUP_SIZE, num_lights - batch);
+        if (valid_cluster)
+        {
+            for (uint j = 0; j < batch_size && count < MAX_LIGHTS_PER_CLUSTER; ++j)
+            {
+                float4 sphere = s_light_spheres[j];
+                bool intersects = sphere.w < 0.0f;
+                if (!intersects)
+                {
+                    float3 d = max(0.0f, max(aabb_min - sphere.xyz, sphere.xyz - aabb_max));
+                    intersects = dot(d, d) <= sphere.w * sphere.w;
+                }
+                if (intersects)
+                {
+                    g_light_indices[base_index + count] = batch + j;
+                    ++count;
+                }
+            }
+        }
+        GroupMemoryBarrierWithGroupSync();
+    }
+    if (valid_cluster)
+    {
+        g_light_grid[cluster] = count;
+    }
+}
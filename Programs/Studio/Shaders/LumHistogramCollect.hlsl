@@ -6,7 +6,8 @@ cbuffer LumHistogramCollectCB : register(b0)
     float num_pixels;
 }
 RWStructuredBuffer<uint> g_histogram : register(u1);
-RWTexture2D<float> g_target : register(u2);
+// The adapted average luminance. 0 means that the average luminance is not available.
+RWStructuredBuffer<float> g_target : register(u2);
 
 groupshared uint histogram_shared[256];
 
@@ -41,8 +42,8 @@ void main(uint group_index : SV_GroupIndex)
 
         // The new stored value will be interpolated using the last frames value
         // to prevent sudden shifts in the exposure.
-        float lum_last_frame = g_target[uint2(0, 0)];
+        float lum_last_frame = g_target[0];
         float adapted_lum = (lum_last_frame == 0.0f) ? weighted_avg_lum : (lum_last_frame + (weighted_avg_lum - lum_last_frame) * time_coeff);
-        g_target[uint2(0, 0)] = adapted_lum;
+        g_target[0] = adapted_lum;
     }
 }
\ No newline at end of file
@@ -0,0 +1,5 @@
+// Shadow maps store depth only. This empty pixel shader is used since some backends require one pixel shader 
+// for every graphics pipeline.
+void main()
+{
+}
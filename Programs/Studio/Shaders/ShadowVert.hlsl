@@ -0,0 +1,24 @@
+#include "MeshBuffer.hlsl"
+struct VS_INPUT
+{
+    [[vk::location(0)]]
+    float3 position : POSITION;
+};
+
+struct ShadowDrawParams
+{
+    // The world-to-projection matrix of the shadow tile being rendered.
+    float4x4 world_to_proj;
+    uint first_instance;
+};
+[[vk::push_constant]] ConstantBuffer<ShadowDrawParams> g_draw_params : register(b0, space15);
+StructuredBuffer<MeshBuffer> g_mesh_buffers : register(t0);
+// The index of the mesh buffer of every instance, indexed by `g_draw_params.first_instance + SV_InstanceID`.
+StructuredBuffer<uint> g_instance_mesh_buffer_indices : register(t1);
+
+float4 main(VS_INPUT input, uint instance_id : SV_InstanceID) : SV_POSITION
+{
+    MeshBuffer mesh_buffer = g_mesh_buffers[g_instance_mesh_buffer_indices[g_draw_params.first_instance + instance_id]];
+    float3 world_position = mul(mesh_buffer.model_to_world, float4(input.position, 1.0f)).xyz;
+    return mul(g_draw_params.world_to_proj, float4(world_position, 1.0f));
+}
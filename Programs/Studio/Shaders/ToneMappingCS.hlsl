@@ -5,7 +5,8 @@ cbuffer g_cb : register(b0)
     uint g_auto_exposure;
 }
 Texture2D<float4> g_scene_tex : register(t1);
-Texture2D<float> g_lum_tex : register(t2);
+// The adapted average luminance computed by the auto exposure pass. 0 means that the average luminance is not available.
+StructuredBuffer<float> g_luminance : register(t2);
 RWTexture2D<float4> g_dst_tex : register(u3);
 
 // @see: https://knarkowicz.wordpress.com/2016/01/06/aces-filmic-tone-mapping-curve/
@@ -35,9 +36,9 @@ void main(int3 dispatch_thread_id : SV_DispatchThreadID)
 {
     float3 hdr_color = g_scene_tex[dispatch_thread_id.xy].xyz;
     float exposure;
-    if(g_auto_exposure > 0)
+    float average_luminance = g_luminance[0];
+    if(g_auto_exposure > 0 && average_luminance > 0.0)
     {
-        float average_luminance = g_lum_tex[int2(0, 0)];
         exposure = g_exposure / max(0.0001, average_luminance);
     }
     else
@@ -0,0 +1,16 @@
+cbuffer CB : register(b0)
+{
+    float2 dst_texel_size;    // 1.0 / destination dimension
+}
+Texture2D<float4> g_src_tex : register(t1);
+RWTexture2D<float4> g_dst_tex : register(u2);
+SamplerState g_sampler : register(s3);
+
+[numthreads(8, 8, 1)]
+void main(uint3 dispatch_thread_id : SV_DispatchThreadID)
+{
+    // Map the center of the destination pixel to the source texture, so that the bilinear filter 
+    // reconstructs the value from the nearest 4 source pixels.
+    float2 texcoords = dst_texel_size * (dispatch_thread_id.xy + 0.5f);
+    g_dst_tex[dispatch_thread_id.xy] = g_src_tex.SampleLevel(g_sampler, texcoords, 0.0f);
+}
@@ -10,12 +10,14 @@
 #pragma once
 #include <Luna/HID/HID.hpp>
 #include <Luna/RHI/RHI.hpp>
+#include <Luna/RHI/UploadManager.hpp>
 #include <Luna/ImGui/ImGui.hpp>
 #include <Luna/Image/Image.hpp>
 #include <Luna/Image/DDSImage.hpp>
 #include <Luna/Font/Font.hpp>
 #include <Luna/Asset/Asset.hpp>
 #include <Luna/ObjLoader/ObjLoader.hpp>
+#include <Luna/GLTFLoader/GLTFLoader.hpp>
 #include <Luna/VFS/VFS.hpp>
 #include <Luna/Runtime/HashSet.hpp>
 #include <Luna/ShaderCompiler/ShaderCompiler.hpp>
@@ -86,7 +88,7 @@ namespace Luna
         lucatchret;
         return ok;
     }
-    inline R<ShaderCompiler::ShaderCompileResult> compile_shader(const Path& shader_file, ShaderCompiler::ShaderType shader_type)
+    inline R<ShaderCompiler::ShaderCompileResult> compile_shader(const Path& shader_file, ShaderCompiler::ShaderType shader_type, bool generate_reflection = false)
     {
         ShaderCompiler::ShaderCompileResult ret;
         lutry
@@ -105,6 +107,7 @@ namespace Luna
             params.target_format = RHI::get_current_platform_shader_target_format();
             params.shader_type = shader_type;
             params.shader_model = {6, 0};
+            params.generate_reflection = generate_reflection;
 #ifdef LUNA_DEBUG
             params.optimization_level = ShaderCompiler::OptimizationLevel::none;
             params.debug = true;
@@ -155,6 +158,8 @@ namespace Luna
         Ref<IAssetEditor>(*new_importer)(const Path& create_dir);
     };
 
+    struct SceneRenderData;
+
     struct AppEnv
     {
         HashSet<Name> new_asset_types; // Displayed on the "New" tab of asset browser.
@@ -171,6 +176,19 @@ namespace Luna
         u32 async_compute_queue;
         u32 async_copy_queue;
 
+        //! Uploads asset data using the async copy queue.
+        Ref<RHI::IUploadManager> upload_manager;
+
+        //! Shares descriptor set layouts and pipeline layouts created from shader reflection data.
+        RHI::ShaderLayoutCache layout_cache;
+
+        //! The index of the current frame, increased once per main loop iteration.
+        u64 frame_index = 0;
+
+        //! Render data of every scene being rendered, shared by all renderers of the same scene.
+        //! Entries are added by `get_scene_render_data` and removed when the render data is destroyed.
+        HashMap<const void*, SceneRenderData*> scene_render_data;
+
         void register_asset_importer_type(const Name& name, const AssetImporterDesc& desc)
         {
             importer_types.insert(Pair<Name, AssetImporterDesc>(name, desc));
@@ -12,11 +12,14 @@
 #include <Luna/Runtime/File.hpp>
 #include "ProjectSelector.hpp"
 #include "MainEditor.hpp"
+#include "PerfMode.hpp"
 #include <Luna/Runtime/Module.hpp>
 #include <Luna/Runtime/Log.hpp>
 #include <Luna/VariantUtils/VariantUtils.hpp>
 #include <Luna/RG/RG.hpp>
 #include <Luna/JobSystem/JobSystem.hpp>
+#include <string.h>
+#include <stdlib.h>
 
 namespace Luna
 {
@@ -50,15 +53,25 @@ namespace Luna
             }
             if (g_env->async_compute_queue == U32_MAX) g_env->async_compute_queue = g_env->graphics_queue;
             if(g_env->async_copy_queue == U32_MAX) g_env->async_copy_queue = g_env->graphics_queue;
+            RHI::UploadManagerDesc upload_desc;
+            upload_desc.command_queue_index = g_env->async_copy_queue;
+            luset(g_env->upload_manager, RHI::new_upload_manager(g_env->device, upload_desc));
+            g_env->layout_cache.init(g_env->device);
+            g_env->device->get_memory_budget_change_event().add_handler([](RHI::IDevice* device, const RHI::DeviceMemoryBudget& budget)
+            {
+                if (budget.local.usage > budget.local.budget)
+                {
+                    log_warning("Studio", "Video memory usage (%llu MB) exceeds the budget (%llu MB).",
+                        budget.local.usage / (1024 * 1024), budget.local.budget / (1024 * 1024));
+                }
+            });
         }
         lucatchret;
         return ok;
     }
 
-    void run_editor()
+    RV init_studio()
     {
-        set_log_to_platform_enabled(true);
-        set_log_to_platform_verbosity(LogVerbosity::error);
         lupanic_if_failed(add_modules({module_variant_utils(),
             module_hid(),
             module_window(),
@@ -68,15 +81,28 @@ namespace Luna
             module_imgui(),
             module_asset(),
             module_obj_loader(),
+            module_gltf_loader(),
             module_rg(),
             module_job_system()}));
-        auto r = init_modules();
+        lutry
+        {
+            luexp(init_modules());
+            luexp(init_env());
+        }
+        lucatchret;
+        return ok;
+    }
+
+    void run_editor()
+    {
+        set_log_to_platform_enabled(true);
+        set_log_to_platform_verbosity(LogVerbosity::error);
+        auto r = init_studio();
         if (failed(r))
         {
             log_error("App", explain(r.errcode()));
             return;
         }
-        if (failed(init_env())) return;
 
         // Run project selector.
         auto project = select_project();
@@ -96,6 +122,79 @@ namespace Luna
         return;
     }
 
+    // Runs the performance mode with options parsed from the command line:
+    // Studio --perf --project <dir> --scene <asset path> [--camera-path <file>] [--report <file>] [--baseline <file>]
+    //     [--tolerance <ratio>] [--width <w>] [--height <h>] [--warmup <frames>] [--frames <frames>] [--fps <rate>]
+    //     [--gpu-driven] [--occlusion-culling] [--depth-prepass] [--shadows]
+    // Relative paths are resolved against the working directory when the program starts.
+    int run_perf(int argc, char** argv, const Path& working_dir)
+    {
+        set_log_to_platform_enabled(true);
+        set_log_to_platform_verbosity(LogVerbosity::info);
+        PerfModeOptions options;
+        options.renderer_settings.screen_size = UInt2U(1920, 1080);
+        auto to_path = [&](const c8* arg)
+        {
+            Path p(arg);
+            if (!test_flags(p.flags(), PathFlag::absolute))
+            {
+                Path abs = working_dir;
+                abs.append(p);
+                p = move(abs);
+            }
+            return p;
+        };
+        for (int i = 2; i < argc; ++i)
+        {
+            const c8* arg = argv[i];
+            const c8* value = i + 1 < argc ? argv[i + 1] : nullptr;
+            if (!strcmp(arg, "--gpu-driven")) options.renderer_settings.gpu_driven = true;
+            else if (!strcmp(arg, "--occlusion-culling")) options.renderer_settings.occlusion_culling = true;
+            else if (!strcmp(arg, "--depth-prepass")) options.renderer_settings.depth_prepass = true;
+            else if (!strcmp(arg, "--shadows")) options.renderer_settings.shadows = true;
+            else if (!value)
+            {
+                log_error("Studio", "Missing value for option %s.", arg);
+                return 2;
+            }
+            else
+            {
+                if (!strcmp(arg, "--project")) options.project_path = to_path(value);
+                else if (!strcmp(arg, "--scene")) options.scene_path = value;
+                else if (!strcmp(arg, "--camera-path")) options.camera_path = to_path(value);
+                else if (!strcmp(arg, "--report")) options.report_path = to_path(value);
+                else if (!strcmp(arg, "--baseline")) options.baseline_path = to_path(value);
+                else if (!strcmp(arg, "--tolerance")) options.regression_tolerance = atof(value);
+                else if (!strcmp(arg, "--width")) options.renderer_settings.screen_size.x = (u32)atoi(value);
+                else if (!strcmp(arg, "--height")) options.renderer_settings.screen_size.y = (u32)atoi(value);
+                else if (!strcmp(arg, "--warmup")) options.warmup_frames = (u32)atoi(value);
+                else if (!strcmp(arg, "--frames")) options.num_frames = (u32)atoi(value);
+                else if (!strcmp(arg, "--fps")) options.frame_interval = 1.0 / max(atof(value), 1.0);
+                else
+                {
+                    log_error("Studio", "Unknown option %s.", arg);
+                    return 2;
+                }
+                ++i;
+            }
+        }
+        if (options.project_path.empty() || options.scene_path.empty())
+        {
+            log_error("Studio", "--project and --scene must be specified in performance mode.");
+            return 2;
+        }
+        auto r = init_studio();
+        if (failed(r))
+        {
+            log_error("App", explain(r.errcode()));
+            return 2;
+        }
+        int ret = run_perf_mode(options);
+        memdelete(g_env);
+        g_env = nullptr;
+        return ret;
+    }
+
     void set_current_dir_to_process_path()
     {
         Path p = get_process_path();
@@ -106,10 +205,26 @@ namespace Luna
 
 using namespace Luna;
 
-int main(){
+int main(int argc, char** argv)
+{
     luassert_always(Luna::init());
+    Path working_dir;
+    {
+        u32 working_dir_len = get_current_dir(0, nullptr);
+        Vector<c8> working_dir_str(working_dir_len, 0);
+        get_current_dir(working_dir_len, working_dir_str.data());
+        working_dir = working_dir_str.data();
+    }
     set_current_dir_to_process_path();
-    run_editor();
+    int ret = 0;
+    if (argc > 1 && !strcmp(argv[1], "--perf"))
+    {
+        ret = run_perf(argc, argv, working_dir);
+    }
+    else
+    {
+        run_editor();
+    }
     Luna::close();
-    return 0;
+    return ret;
 }
\ No newline at end of file
@@ -3,7 +3,7 @@ target("Studio")
     add_options("rhi_api")
     add_headerfiles("**.hpp")
     add_files("**.cpp")
-    add_deps("Runtime", "VariantUtils", "HID", "Window", "RHI", "Image", "Font", "ImGui", "Asset", "ObjLoader", "RG", "JobSystem")
+    add_deps("Runtime", "VariantUtils", "HID", "Window", "RHI", "Image", "Font", "ImGui", "Asset", "ObjLoader", "GLTFLoader", "RG", "JobSystem")
 
     local shader_files = {
             "Common.hlsl",
@@ -14,19 +14,35 @@ target("Studio")
             "MipmapGenerationCS.hlsl",
             "SkyboxCS.hlsl",
             "ToneMappingCS.hlsl",
+            "UpscaleCS.hlsl",
+            "DepthPyramidCS.hlsl",
             "LumHistogramClear.hlsl",
             "LumHistogram.hlsl",
             "LumHistogramCollect.hlsl",
             "GeometryCommon.hlsl",
             "GeometryVert.hlsl",
             "GeometryPixel.hlsl",
+            "GeometryPixelCommon.hlsl",
+            "GeometryBindlessVert.hlsl",
+            "GeometryBindlessPixel.hlsl",
+            "DepthPrepassVert.hlsl",
+            "DepthPrepassPixel.hlsl",
+            "ShadowVert.hlsl",
+            "ShadowPixel.hlsl",
             "MeshBuffer.hlsl",
+            "LightCluster.hlsl",
+            "LightCullingCS.hlsl",
+            "InstanceCullingCS.hlsl",
             "DeferredLighting.hlsl",
             "BufferVisualization.hlsl",
             "PrecomputeIntegrateBRDF.hlsl",
             "PrecomputeEnvironmentMapMips.hlsl",
             "WireframeVert.hlsl"
         }
+    -- Shader headers provided by SDK modules, copied to the same directory as shaders of this program.
+    local module_shader_files = {
+            "Modules/Luna/RHI/Shaders/Bindless.hlsl"
+        }
 
     after_build(function (target)
         local target_dir = target:targetdir()
@@ -34,6 +50,9 @@ target("Studio")
         for _, i in pairs(shader_files) do
             os.cp(path.join(shader_source_dir, i), path.join(target_dir, "Shaders", i))
         end
+        for _, i in pairs(module_shader_files) do
+            os.cp(path.join(os.projectdir(), i), path.join(target_dir, "Shaders", path.filename(i)))
+        end
     end)
     after_clean(function (target) 
         os.rm(path.join(target:targetdir(), "Shaders"))
@@ -43,6 +62,9 @@ target("Studio")
         for _, i in pairs(shader_files) do
             os.cp(path.join(shader_source_dir, i), path.join(target:installdir(), "bin", "Shaders", i))
         end
+        for _, i in pairs(module_shader_files) do
+            os.cp(path.join(os.projectdir(), i), path.join(target:installdir(), "bin", "Shaders", path.filename(i)))
+        end
     end)
     after_uninstall(function (target) 
         os.rm(path.join(target:installdir(), "bin", "Shaders"))
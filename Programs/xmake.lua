@@ -1,2 +1,3 @@
 includes("Studio")
-includes("LunaDoc")
\ No newline at end of file
+includes("LunaDoc")
+includes("LunaPack")
\ No newline at end of file
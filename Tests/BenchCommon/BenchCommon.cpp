@@ -0,0 +1,277 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BenchCommon.cpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#include "BenchCommon.hpp"
+#include <Luna/Runtime/Algorithm.hpp>
+#include <Luna/Runtime/Variant.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Memory.hpp>
+#include <Luna/Runtime/MemoryUtils.hpp>
+#include <Luna/Runtime/Profiler.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/VariantUtils/JSON.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace Luna
+{
+    volatile usize g_bench_sink = 0;
+
+    struct BenchResult
+    {
+        Name name;
+        u64 ops;
+        u32 repetitions;
+        // All times are nanoseconds per operation.
+        f64 min;
+        f64 mean;
+        f64 p50;
+        f64 p90;
+        f64 p99;
+        f64 max;
+        // Operations per second, based on the median time.
+        f64 throughput;
+        u64 peak_memory;
+    };
+
+    static BenchOptions g_options;
+    static Vector<BenchResult> g_results;
+
+    BenchOptions& get_bench_options()
+    {
+        return g_options;
+    }
+
+    bool parse_bench_option(const c8* option, const c8* value)
+    {
+        if (!strcmp(option, "--filter")) g_options.filter = value;
+        else if (!strcmp(option, "--repetitions")) g_options.repetitions = max<u32>((u32)atoi(value), 1);
+        else if (!strcmp(option, "--warmup")) g_options.warmup = (u32)atoi(value);
+        else if (!strcmp(option, "--scale")) g_options.scale = max(atof(value), 0.0);
+        else if (!strcmp(option, "--json")) g_options.json_path = value;
+        else return false;
+        return true;
+    }
+
+    bool bench_enabled(const c8* name)
+    {
+        return !g_options.filter || strstr(name, g_options.filter);
+    }
+
+    u32 scaled(u32 count)
+    {
+        return max<u32>((u32)(count * g_options.scale), 1);
+    }
+
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+    // Tracks the size of every memory block allocated by the benchmarked thread using one open-addressing hash table,
+    // so that the size can be subtracted when the block is freed. The table is allocated before tracking begins, so the
+    // profiler callback never allocates memory.
+    struct MemoryTracker
+    {
+        struct Entry
+        {
+            void* ptr;
+            usize size;
+        };
+        static constexpr usize CAPACITY = 1 << 21;
+
+        Entry* m_entries = nullptr;
+        usize m_count = 0;
+        u64 m_current = 0;
+        u64 m_peak = 0;
+        // `true` if the table is too full to record more blocks, in which case the peak memory is not reliable.
+        bool m_overflow = false;
+        IThread* m_thread = nullptr;
+        usize m_callback = USIZE_MAX;
+
+        static usize home(void* ptr)
+        {
+            return (usize)(((u64)(usize)ptr >> 4) * 0x9E3779B97F4A7C15ULL >> 43) & (CAPACITY - 1);
+        }
+        void on_allocate(void* ptr, usize size)
+        {
+            if (m_count * 4 >= CAPACITY * 3)
+            {
+                m_overflow = true;
+                return;
+            }
+            usize i = home(ptr);
+            while (m_entries[i].ptr) i = (i + 1) & (CAPACITY - 1);
+            m_entries[i].ptr = ptr;
+            m_entries[i].size = size;
+            ++m_count;
+            m_current += size;
+            m_peak = max(m_peak, m_current);
+        }
+        void on_deallocate(void* ptr)
+        {
+            usize i = home(ptr);
+            while (m_entries[i].ptr != ptr)
+            {
+                // Blocks allocated before tracking begins are not recorded.
+                if (!m_entries[i].ptr) return;
+                i = (i + 1) & (CAPACITY - 1);
+            }
+            m_current -= m_entries[i].size;
+            --m_count;
+            // Backward-shift deletion, which keeps probe sequences valid without tombstones.
+            usize j = i;
+            while (true)
+            {
+                j = (j + 1) & (CAPACITY - 1);
+                if (!m_entries[j].ptr) break;
+                usize k = home(m_entries[j].ptr);
+                bool in_range = i <= j ? (i < k && k <= j) : (i < k || k <= j);
+                if (!in_range)
+                {
+                    m_entries[i] = m_entries[j];
+                    i = j;
+                }
+            }
+            m_entries[i].ptr = nullptr;
+        }
+    };
+    static MemoryTracker g_memory_tracker;
+
+    bool begin_memory_tracking()
+    {
+        auto& t = g_memory_tracker;
+        t.m_entries = (MemoryTracker::Entry*)memalloc(sizeof(MemoryTracker::Entry) * MemoryTracker::CAPACITY);
+        memzero(t.m_entries, sizeof(MemoryTracker::Entry) * MemoryTracker::CAPACITY);
+        t.m_count = 0;
+        t.m_current = 0;
+        t.m_peak = 0;
+        t.m_overflow = false;
+        t.m_thread = get_current_thread();
+        if (is_profiler_batch_mode()) flush_profiler_events();
+        t.m_callback = register_profiler_callback([](const ProfilerEvent& event)
+        {
+            auto& t = g_memory_tracker;
+            if (event.thread != t.m_thread) return;
+            if (event.id == ProfilerEventId::MEMORY_ALLOCATE)
+            {
+                auto data = (const ProfilerEventData::MemoryAllocate*)event.data;
+                t.on_allocate(data->ptr, data->sampled_size);
+            }
+            else if (event.id == ProfilerEventId::MEMORY_DEALLOCATE)
+            {
+                auto data = (const ProfilerEventData::MemoryDeallocate*)event.data;
+                t.on_deallocate(data->ptr);
+            }
+        });
+        return true;
+    }
+
+    u64 end_memory_tracking()
+    {
+        auto& t = g_memory_tracker;
+        if (is_profiler_batch_mode()) flush_profiler_events();
+        unregister_profiler_callback(t.m_callback);
+        t.m_callback = USIZE_MAX;
+        memfree(t.m_entries);
+        t.m_entries = nullptr;
+        return t.m_overflow ? U64_MAX : t.m_peak;
+    }
+#else
+    bool begin_memory_tracking()
+    {
+        return false;
+    }
+
+    u64 end_memory_tracking()
+    {
+        return U64_MAX;
+    }
+#endif
+
+    // Gets the sample at the specified percentile using the nearest-rank method. `samples` must be sorted.
+    static u64 get_percentile(const Vector<u64>& samples, u32 percentile)
+    {
+        usize rank = (samples.size() * percentile + 99) / 100;
+        return samples[rank ? rank - 1 : 0];
+    }
+
+    void bench_record(const c8* name, u64 ops, Vector<u64>& samples, u64 peak_memory)
+    {
+        if (samples.empty()) return;
+        if (g_results.empty())
+        {
+            c8 unit_header[32];
+            snprintf(unit_header, 32, "M%ss/s", g_options.unit);
+            printf("%-48s %12s %10s %10s %10s %10s %10s %12s\n", "Benchmark", "Count", "min(ns)", "p50(ns)", "p90(ns)", "p99(ns)",
+                unit_header, "peak(KB)");
+        }
+        sort(samples.begin(), samples.end());
+        f64 ns_per_tick = 1000000000.0 / get_ticks_per_second() / (ops ? ops : 1);
+        u64 sum = 0;
+        for (u64 s : samples) sum += s;
+        BenchResult r;
+        r.name = name;
+        r.ops = ops;
+        r.repetitions = (u32)samples.size();
+        r.min = samples.front() * ns_per_tick;
+        r.mean = (f64)sum / samples.size() * ns_per_tick;
+        r.p50 = get_percentile(samples, 50) * ns_per_tick;
+        r.p90 = get_percentile(samples, 90) * ns_per_tick;
+        r.p99 = get_percentile(samples, 99) * ns_per_tick;
+        r.max = samples.back() * ns_per_tick;
+        r.throughput = r.p50 > 0.0 ? 1000000000.0 / r.p50 : 0.0;
+        r.peak_memory = peak_memory;
+        c8 peak_text[32];
+        if (peak_memory != U64_MAX) snprintf(peak_text, 32, "%.1f", peak_memory / 1024.0);
+        else snprintf(peak_text, 32, "-");
+        printf("%-48s %12llu %10.2f %10.2f %10.2f %10.2f %10.2f %12s\n", name, (unsigned long long)ops, r.min, r.p50, r.p90, r.p99,
+            r.throughput / 1000000.0, peak_text);
+        g_results.push_back(r);
+    }
+
+    void bench_report()
+    {
+        printf("%zu benchmarks finished, times are nanoseconds per %s.\n", g_results.size(), g_options.unit);
+        if (!g_options.json_path) return;
+        Variant results(VariantType::array);
+        for (auto& r : g_results)
+        {
+            Variant v(VariantType::object);
+            v["name"] = r.name;
+            v["ops"] = r.ops;
+            v["repetitions"] = (u64)r.repetitions;
+            v["min_ns"] = r.min;
+            v["mean_ns"] = r.mean;
+            v["p50_ns"] = r.p50;
+            v["p90_ns"] = r.p90;
+            v["p99_ns"] = r.p99;
+            v["max_ns"] = r.max;
+            v["ops_per_second"] = r.throughput;
+            if (r.peak_memory != U64_MAX) v["peak_memory_bytes"] = r.peak_memory;
+            results.push_back(move(v));
+        }
+        Variant root(VariantType::object);
+        root["program"] = g_options.name;
+        root["unit"] = g_options.unit;
+        root["warmup"] = (u64)g_options.warmup;
+        root["repetitions"] = (u64)g_options.repetitions;
+        root["scale"] = g_options.scale;
+        root["processors"] = (u64)get_processors_count();
+        root["results"] = move(results);
+        lutry
+        {
+            String json = VariantUtils::write_json(root);
+            lulet(f, open_file(g_options.json_path, FileOpenFlag::write, FileCreationMode::create_always));
+            luexp(f->write(json.c_str(), json.size()));
+        }
+        lucatch
+        {
+            log_error(g_options.name, "Failed to write benchmark results to %s: %s", g_options.json_path, explain(luerr));
+        }
+    }
+}
@@ -0,0 +1,135 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BenchCommon.hpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#pragma once
+#include <Luna/Runtime/Runtime.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    // The benchmark harness shared by all benchmark programs.
+    // Every program sets `name` and `unit` and its defaults in `BenchOptions`, parses command-line options with
+    // `parse_bench_option`, runs benchmarks with `bench`, then calls `bench_report`.
+
+    struct BenchOptions
+    {
+        // The name of the benchmark program, used in reports and logs.
+        const c8* name = "Bench";
+        // The name of one operation, like "op", "entity" or "byte". Results are reported per operation.
+        const c8* unit = "op";
+        // Number of runs executed before measuring, used to warm up caches and allocators.
+        u32 warmup = 3;
+        // Number of measured runs.
+        u32 repetitions = 30;
+        // If not `nullptr`, only benchmarks whose names contain this string are run.
+        const c8* filter = nullptr;
+        // Scales the problem size of benchmarks, see `scaled`.
+        f64 scale = 1.0;
+        // If not `nullptr`, results are written to this path in JSON format by `bench_report`.
+        const c8* json_path = nullptr;
+        // If `true`, every benchmark is run one more time to measure the peak memory usage of one run. This
+        // requires the memory profiler (LUNA_ENABLE_MEMORY_PROFILER or the profile debug level).
+        bool track_memory = false;
+    };
+
+    BenchOptions& get_bench_options();
+
+    // Parses one common command-line option: `--filter <name>`, `--repetitions <count>`, `--warmup <count>`,
+    // `--scale <factor>` or `--json <path>`. Returns `false` if `option` is not one common option.
+    bool parse_bench_option(const c8* option, const c8* value);
+
+    // Checks whether the benchmark should be run based on the filter.
+    bool bench_enabled(const c8* name);
+
+    // Scales one problem size by `BenchOptions::scale`. The result is at least `1`.
+    u32 scaled(u32 count);
+
+    // Records the result of one benchmark. `samples` are ticks of every measured run, `ops` is the number of operations
+    // performed by every run, and `peak_memory` is the peak number of bytes allocated by one run, or `U64_MAX` if memory
+    // is not tracked.
+    void bench_record(const c8* name, u64 ops, Vector<u64>& samples, u64 peak_memory = U64_MAX);
+
+    // Prints the summary of all benchmarks, and writes results to `BenchOptions::json_path` if it is not `nullptr`.
+    void bench_report();
+
+    // Starts tracking memory allocated by the current thread. Returns `false` if memory profiling is not enabled.
+    bool begin_memory_tracking();
+
+    // Stops tracking memory and returns the peak number of bytes allocated since `begin_memory_tracking`, not including
+    // memory that is allocated before tracking begins.
+    u64 end_memory_tracking();
+
+    // Stores one value to a volatile variable so that the compiler cannot eliminate computations of the value.
+    extern volatile usize g_bench_sink;
+    inline void bench_keep(usize v)
+    {
+        g_bench_sink = g_bench_sink + v;
+    }
+
+    // Generates pseudo-random numbers deterministically so that runs are comparable.
+    struct BenchRandom
+    {
+        u64 m_state = 0x9E3779B97F4A7C15ULL;
+
+        u64 next()
+        {
+            m_state ^= m_state << 13;
+            m_state ^= m_state >> 7;
+            m_state ^= m_state << 17;
+            return m_state;
+        }
+        f64 next_f64()
+        {
+            return (f64)(next() >> 11) / (f64)(1ULL << 53);
+        }
+    };
+
+    // Runs one benchmark. `setup` is called before every run without being measured, then `func` is called and measured.
+    // `func` is called `warmup` times without measuring, then `repetitions` times with every call measured separately,
+    // then one more time with memory tracking enabled if `BenchOptions::track_memory` is `true`. `ops` is the number of
+    // operations performed by one call of `func`.
+    template <typename _SetupFunc, typename _Func>
+    void bench(const c8* name, u64 ops, _SetupFunc&& setup, _Func&& func)
+    {
+        if (!bench_enabled(name)) return;
+        auto& options = get_bench_options();
+        for (u32 i = 0; i < options.warmup; ++i)
+        {
+            setup();
+            func();
+        }
+        Vector<u64> samples;
+        samples.reserve(options.repetitions);
+        for (u32 i = 0; i < options.repetitions; ++i)
+        {
+            setup();
+            u64 begin = get_ticks();
+            func();
+            samples.push_back(get_ticks() - begin);
+        }
+        u64 peak_memory = U64_MAX;
+        if (options.track_memory)
+        {
+            setup();
+            if (begin_memory_tracking())
+            {
+                func();
+                peak_memory = end_memory_tracking();
+            }
+        }
+        bench_record(name, ops, samples, peak_memory);
+    }
+
+    template <typename _Func>
+    void bench(const c8* name, u64 ops, _Func&& func)
+    {
+        bench(name, ops, []() {}, func);
+    }
+}
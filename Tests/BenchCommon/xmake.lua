@@ -0,0 +1,7 @@
+target("BenchCommon")
+    set_luna_sdk_test()
+    set_kind("static")
+    add_headerfiles("*.hpp", {install = false})
+    add_files("*.cpp")
+    add_deps("Runtime", "VariantUtils")
+target_end()
\ No newline at end of file
@@ -0,0 +1,49 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BenchMain.cpp
+* @author JXMaster
+* @date 2024/5/19
+*/
+#include "ECSBench.hpp"
+#include <Luna/Runtime/Module.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+using namespace Luna;
+
+// Usage: ECSBench [--filter <name>] [--repetitions <count>] [--warmup <count>] [--scale <factor>] [--workers <count>] [--json <path>]
+// All results are reported per entity, so results of runs with different `--scale` values are comparable.
+int main(int argc, char** argv)
+{
+    Luna::init();
+    auto& options = get_bench_options();
+    options.name = "ECSBench";
+    options.unit = "entity";
+    options.warmup = 2;
+    options.repetitions = 10;
+    JobSystem::JobSystemConfig config;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (parse_bench_option(argv[i], argv[i + 1])) continue;
+        if (!strcmp(argv[i], "--workers")) config.num_workers = (u32)atoi(argv[i + 1]);
+        else printf("Unknown option: %s\n", argv[i]);
+    }
+    JobSystem::set_config(config);
+    lupanic_if_failed(add_modules({module_job_system(), module_ecs(), module_variant_utils()}));
+    lupanic_if_failed(init_modules());
+    register_bench_components();
+    entity_bench();
+    structural_bench();
+    query_bench();
+    change_list_bench();
+    scheduler_bench();
+    bench_report();
+    Luna::close();
+    return 0;
+}
@@ -0,0 +1,98 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ChangeListBench.cpp
+* @author JXMaster
+* @date 2024/5/19
+*/
+#include "ECSBench.hpp"
+#include <Luna/JobSystem/Parallel.hpp>
+
+namespace Luna
+{
+    using namespace ECS;
+
+    // Measures recording structural changes from multiple jobs with `ITaskContext::submit`, and applying them
+    // with `IWorld::flush_change_lists`.
+    void change_list_bench()
+    {
+        constexpr u32 num_lists = 16;
+        u32 n = scaled(100000);
+        u32 n_per_list = max<u32>(n / num_lists, 1);
+        n = n_per_list * num_lists;
+        Ref<IWorld> world;
+        Vector<Ref<ITaskContext>> contexts;
+        Vector<entity_id_t> ids;
+        auto reset_world = [&]()
+        {
+            contexts.clear();
+            world = new_bench_world(n, 4, 1, &ids);
+            for (u32 i = 0; i < num_lists; ++i) contexts.push_back(new_task_context());
+        };
+        // Records one change list per job. `record` is called with the task context and the range of `ids` of the job.
+        auto submit_lists = [&](auto&& record)
+        {
+            JobSystem::parallel_for(0, num_lists, 1, [&](usize i)
+            {
+                ITaskContext* context = contexts[i];
+                context->begin(world, TaskExecutionMode::shared, {}, {});
+                record(context, i * n_per_list, (i + 1) * n_per_list);
+                context->submit(i);
+            });
+        };
+        auto record_spawn = [&](ITaskContext* context, usize begin, usize end)
+        {
+            context->add_entities({ ids.data() + begin, end - begin }, get_bench_components(4), {});
+        };
+        auto record_add_component = [&](ITaskContext* context, usize begin, usize end)
+        {
+            for (usize i = begin; i < end; ++i)
+            {
+                context->set_target_entity(ids[i]);
+                context->add_component<BenchComponent4>()->value = Float4U(1.0f);
+            }
+        };
+        auto record_remove = [&](ITaskContext* context, usize begin, usize end)
+        {
+            for (usize i = begin; i < end; ++i) context->remove_entity(ids[i]);
+        };
+        bench("change list record and flush (spawn)", n, reset_world, [&]()
+        {
+            submit_lists(record_spawn);
+            world->flush_change_lists();
+        });
+        bench("change list flush (spawn)", n, [&]()
+        {
+            reset_world();
+            submit_lists(record_spawn);
+        }, [&]()
+        {
+            world->flush_change_lists();
+        });
+        bench("change list record and flush (add component)", n, reset_world, [&]()
+        {
+            submit_lists(record_add_component);
+            world->flush_change_lists();
+        });
+        bench("change list flush (add component)", n, [&]()
+        {
+            reset_world();
+            submit_lists(record_add_component);
+        }, [&]()
+        {
+            world->flush_change_lists();
+        });
+        bench("change list flush (remove entity)", n, [&]()
+        {
+            reset_world();
+            submit_lists(record_remove);
+        }, [&]()
+        {
+            world->flush_change_lists();
+        });
+        contexts.clear();
+        world.reset();
+    }
+}
@@ -0,0 +1,60 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ECSBench.cpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#include "ECSBench.hpp"
+
+namespace Luna
+{
+    static typeinfo_t g_components[NUM_BENCH_COMPONENTS];
+
+    void register_bench_components()
+    {
+        g_components[0] = register_struct_type<BenchComponent0>({ luproperty(BenchComponent0, Float4U, value) });
+        g_components[1] = register_struct_type<BenchComponent1>({ luproperty(BenchComponent1, Float4U, value) });
+        g_components[2] = register_struct_type<BenchComponent2>({ luproperty(BenchComponent2, Float4U, value) });
+        g_components[3] = register_struct_type<BenchComponent3>({ luproperty(BenchComponent3, Float4U, value) });
+        g_components[4] = register_struct_type<BenchComponent4>({ luproperty(BenchComponent4, Float4U, value) });
+        g_components[5] = register_struct_type<BenchComponent5>({ luproperty(BenchComponent5, Float4U, value) });
+        g_components[6] = register_struct_type<BenchComponent6>({ luproperty(BenchComponent6, Float4U, value) });
+        g_components[7] = register_struct_type<BenchComponent7>({ luproperty(BenchComponent7, Float4U, value) });
+    }
+
+    Span<const typeinfo_t> get_bench_components(u32 count)
+    {
+        luassert(count <= NUM_BENCH_COMPONENTS);
+        return { g_components, count };
+    }
+
+    Ref<ECS::IWorld> new_bench_world(u32 num_entities, u32 num_components, u32 num_archetypes, Vector<ECS::entity_id_t>* out_ids)
+    {
+        using namespace ECS;
+        Ref<IWorld> world = new_world();
+        Ref<ITaskContext> context = new_task_context();
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        num_archetypes = max<u32>(num_archetypes, 1);
+        Vector<entity_id_t> ids(num_entities);
+        Vector<entity_id_t> tags;
+        for (u32 i = 1; i < num_archetypes; ++i)
+        {
+            tags.push_back(context->add_entity());
+        }
+        u32 first = 0;
+        for (u32 i = 0; i < num_archetypes; ++i)
+        {
+            u32 last = (u32)((u64)num_entities * (i + 1) / num_archetypes);
+            // The first archetype does not have any tag.
+            Span<const entity_id_t> tag = i ? Span<const entity_id_t>(&tags[i - 1], 1) : Span<const entity_id_t>();
+            context->add_entities({ ids.data() + first, last - first }, get_bench_components(num_components), tag);
+            first = last;
+        }
+        context->end();
+        if (out_ids) *out_ids = move(ids);
+        return world;
+    }
+}
@@ -0,0 +1,53 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ECSBench.hpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#pragma once
+#include "../../BenchCommon/BenchCommon.hpp"
+#include <Luna/Runtime/Math/Vector.hpp>
+#include <Luna/Experimental/ECS/ECS.hpp>
+
+namespace Luna
+{
+    void entity_bench();
+    void structural_bench();
+    void query_bench();
+    void change_list_bench();
+    void scheduler_bench();
+
+    // Component types used by benchmarks. Every component is 16 bytes, so that query iteration with N components
+    // touches 16*N bytes per entity.
+#define LUNA_ECS_BENCH_COMPONENT(_index, _guid) struct BenchComponent##_index\
+    {\
+        lustruct("ECSBench::BenchComponent" #_index, _guid);\
+        Float4U value;\
+    };
+
+    LUNA_ECS_BENCH_COMPONENT(0, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e70}")
+    LUNA_ECS_BENCH_COMPONENT(1, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e71}")
+    LUNA_ECS_BENCH_COMPONENT(2, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e72}")
+    LUNA_ECS_BENCH_COMPONENT(3, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e73}")
+    LUNA_ECS_BENCH_COMPONENT(4, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e74}")
+    LUNA_ECS_BENCH_COMPONENT(5, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e75}")
+    LUNA_ECS_BENCH_COMPONENT(6, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e76}")
+    LUNA_ECS_BENCH_COMPONENT(7, "{4c8d1e5b-0f7a-4b9e-8a1d-2f3c4b5a6e77}")
+
+#undef LUNA_ECS_BENCH_COMPONENT
+
+    constexpr u32 NUM_BENCH_COMPONENTS = 8;
+
+    void register_bench_components();
+
+    // Gets the types of the first `count` benchmark components.
+    Span<const typeinfo_t> get_bench_components(u32 count);
+
+    // Creates one world with `num_entities` entities, every entity has the first `num_components` benchmark components.
+    // If `num_archetypes` is greater than `1`, entities are distributed evenly to `num_archetypes` clusters that have the
+    // same components but different tags. IDs of created entities are written to `out_ids` if it is not `nullptr`.
+    Ref<ECS::IWorld> new_bench_world(u32 num_entities, u32 num_components, u32 num_archetypes = 1, Vector<ECS::entity_id_t>* out_ids = nullptr);
+}
@@ -0,0 +1,99 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file EntityBench.cpp
+* @author JXMaster
+* @date 2024/5/19
+*/
+#include "ECSBench.hpp"
+
+namespace Luna
+{
+    using namespace ECS;
+
+    void entity_bench()
+    {
+        u32 n = scaled(100000);
+        Ref<IWorld> world;
+        Ref<ITaskContext> context;
+        Vector<entity_id_t> ids;
+        auto new_empty_world = [&]()
+        {
+            world = new_world();
+            context = new_task_context();
+        };
+        auto new_populated_world = [&]()
+        {
+            context.reset();
+            world = new_bench_world(n, 4, 1, &ids);
+            context = new_task_context();
+        };
+        bench("spawn empty (add_entity)", n, new_empty_world, [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            for (u32 i = 0; i < n; ++i) context->add_entity();
+            context->end();
+        });
+        bench("spawn 4 components (add_entity)", n, new_empty_world, [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            for (u32 i = 0; i < n; ++i)
+            {
+                context->set_target_entity(context->add_entity());
+                context->add_component<BenchComponent0>()->value = Float4U(0.0f);
+                context->add_component<BenchComponent1>()->value = Float4U(0.0f);
+                context->add_component<BenchComponent2>()->value = Float4U(0.0f);
+                context->add_component<BenchComponent3>()->value = Float4U(0.0f);
+            }
+            context->end();
+        });
+        bench("spawn 4 components (add_entities)", n, new_empty_world, [&]()
+        {
+            ids.resize(n);
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            context->add_entities({ ids.data(), ids.size() }, get_bench_components(4), {});
+            context->end();
+        });
+        bench("spawn 4 components (shared task)", n, new_empty_world, [&]()
+        {
+            // Changes recorded by shared tasks are cached and applied by one trailing exclusive task.
+            ids.resize(n);
+            context->begin(world, TaskExecutionMode::shared, {}, {});
+            context->add_entities({ ids.data(), ids.size() }, get_bench_components(4), {});
+            context->end();
+        });
+        bench("destroy 4 components (remove_entity)", n, new_populated_world, [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            for (entity_id_t id : ids) context->remove_entity(id);
+            context->end();
+        });
+        bench("destroy 4 components (remove_entities)", n, new_populated_world, [&]()
+        {
+            QueryDesc desc;
+            desc.required_components = get_bench_components(4);
+            Ref<IQuery> query = world->new_query(desc);
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            context->remove_entities(query);
+            context->end();
+        });
+        bench("destroy 4 components (remove_all_entities)", n, new_populated_world, [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            context->remove_all_entities();
+            context->end();
+        });
+        bench("get_entity", n, new_populated_world, [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            usize sum = 0;
+            for (entity_id_t id : ids) sum += context->get_entity(id).get().index;
+            context->end();
+            bench_keep(sum);
+        });
+        context.reset();
+        world.reset();
+    }
+}
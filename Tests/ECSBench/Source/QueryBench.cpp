@@ -0,0 +1,103 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file QueryBench.cpp
+* @author JXMaster
+* @date 2024/5/19
+*/
+#include "ECSBench.hpp"
+#include <stdio.h>
+
+namespace Luna
+{
+    using namespace ECS;
+
+    // Accumulates all other components into the first component, so that every component array is read once and
+    // the first component array is written once.
+    template <typename _Ty, typename... _Rest>
+    inline void accumulate(usize count, Span<_Ty> dst, Span<const _Rest>... src)
+    {
+        for (usize i = 0; i < count; ++i)
+        {
+            f32 sum = (dst[i].value.x + ... + src[i].value.x);
+            dst[i].value.x = sum * 0.5f;
+        }
+    }
+
+    template <typename _Ty, typename... _Rest>
+    void query_iterate_bench(u32 n, u32 num_archetypes)
+    {
+        constexpr u32 num_components = 1 + sizeof...(_Rest);
+        c8 name[64];
+        snprintf(name, 64, "query %u components %u archetypes", num_components, num_archetypes);
+        if (!bench_enabled(name)) return;
+        Ref<IWorld> world = new_bench_world(n, num_components, num_archetypes);
+        QueryDesc desc;
+        desc.required_components = get_bench_components(num_components);
+        Ref<IQuery> query = world->new_query(desc);
+        bench(name, n, [&]()
+        {
+            for (Cluster* cluster : query->get_clusters())
+            {
+                for_each_chunk<_Ty, const _Rest...>(cluster, [](usize count, Span<_Ty> dst, Span<const _Rest>... src)
+                {
+                    accumulate<_Ty, _Rest...>(count, dst, src...);
+                });
+            }
+        });
+        snprintf(name, 64, "query %u components %u archetypes (parallel)", num_components, num_archetypes);
+        bench(name, n, [&]()
+        {
+            for (Cluster* cluster : query->get_clusters())
+            {
+                parallel_for_each_cluster_chunk(cluster, [cluster](const ClusterChunk& chunk)
+                {
+                    usize count = chunk.entities.size();
+                    accumulate<_Ty, _Rest...>(count,
+                        Span<_Ty>((_Ty*)chunk.components[get_cluster_component_index(cluster, typeof<_Ty>())], count),
+                        Span<const _Rest>((const _Rest*)chunk.components[get_cluster_component_index(cluster, typeof<_Rest>())], count)...);
+                });
+            }
+        });
+    }
+
+    void query_bench()
+    {
+        u32 n = scaled(1000000);
+        query_iterate_bench<BenchComponent0>(n, 1);
+        query_iterate_bench<BenchComponent0, BenchComponent1>(n, 1);
+        query_iterate_bench<BenchComponent0, BenchComponent1, BenchComponent2, BenchComponent3>(n, 1);
+        query_iterate_bench<BenchComponent0, BenchComponent1, BenchComponent2, BenchComponent3,
+            BenchComponent4, BenchComponent5, BenchComponent6, BenchComponent7>(n, 1);
+        // Entities spread to many clusters, which measures the per-cluster and per-chunk overhead.
+        query_iterate_bench<BenchComponent0, BenchComponent1, BenchComponent2, BenchComponent3>(n, 64);
+        {
+            // Measures the cost of finding changed chunks when only a few chunks are changed.
+            Ref<IWorld> world = new_bench_world(n, 4);
+            typeinfo_t changed = typeof<BenchComponent0>();
+            QueryDesc desc;
+            desc.required_components = get_bench_components(4);
+            desc.changed_components = { &changed, 1 };
+            Ref<IQuery> query = world->new_query(desc);
+            Vector<QueryChunk> chunks;
+            u64 since_version = 0;
+            bench("query changed chunks (1% changed)", n, [&]()
+            {
+                since_version = world->increment_change_version();
+                u64 version = world->increment_change_version();
+                for (Cluster* cluster : query->get_clusters())
+                {
+                    usize num_chunks = get_cluster_num_chunks(cluster);
+                    for (usize c = 0; c < num_chunks; c += 100)
+                    {
+                        write_cluster_components_data<BenchComponent0>(cluster, c, version);
+                    }
+                }
+                query->get_changed_chunks(chunks, since_version);
+                bench_keep(chunks.size());
+            });
+        }
+    }
+}
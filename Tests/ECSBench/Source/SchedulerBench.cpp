@@ -0,0 +1,88 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file SchedulerBench.cpp
+* @author JXMaster
+* @date 2024/5/19
+*/
+#include "ECSBench.hpp"
+
+namespace Luna
+{
+    using namespace ECS;
+
+    // Every system scales the component it writes by the component it reads.
+    struct SchedulerBenchSystem
+    {
+        typeinfo_t read_component;
+        typeinfo_t write_component;
+    };
+
+    static void scheduler_bench_chunk(Cluster* cluster, const ClusterChunk& chunk, void* userdata)
+    {
+        SchedulerBenchSystem* system = (SchedulerBenchSystem*)userdata;
+        const Float4U* src = (const Float4U*)chunk.components[get_cluster_component_index(cluster, system->read_component)];
+        Float4U* dst = (Float4U*)chunk.components[get_cluster_component_index(cluster, system->write_component)];
+        usize count = chunk.entities.size();
+        for (usize i = 0; i < count; ++i)
+        {
+            dst[i].x = dst[i].x * 0.5f + src[i].x;
+            dst[i].y = dst[i].y * 0.5f + src[i].y;
+            dst[i].z = dst[i].z * 0.5f + src[i].z;
+            dst[i].w = dst[i].w * 0.5f + src[i].w;
+        }
+    }
+
+    // Runs `num_systems` systems over all entities.
+    // If `chained` is `true`, every system writes the component read by the next system, so systems run one after another.
+    // Otherwise, every system writes one different component and all systems may run concurrently.
+    static void scheduler_systems_bench(const c8* name, u32 n, u32 num_systems, bool chained)
+    {
+        if (!bench_enabled(name)) return;
+        Ref<IWorld> world = new_bench_world(n, NUM_BENCH_COMPONENTS);
+        Ref<IScheduler> scheduler = new_scheduler();
+        Span<const typeinfo_t> components = get_bench_components(NUM_BENCH_COMPONENTS);
+        QueryDesc desc;
+        desc.required_components = components;
+        Ref<IQuery> query = world->new_query(desc);
+        Vector<SchedulerBenchSystem> systems(num_systems);
+        for (u32 i = 0; i < num_systems; ++i)
+        {
+            SchedulerBenchSystem& system = systems[i];
+            if (chained)
+            {
+                system.read_component = components[i % NUM_BENCH_COMPONENTS];
+                system.write_component = components[(i + 1) % NUM_BENCH_COMPONENTS];
+            }
+            else
+            {
+                system.read_component = components[0];
+                system.write_component = components[1 + i % (NUM_BENCH_COMPONENTS - 1)];
+            }
+            SystemDesc system_desc;
+            system_desc.name = "SchedulerBenchSystem";
+            system_desc.read_components = { &system.read_component, 1 };
+            system_desc.write_components = { &system.write_component, 1 };
+            system_desc.chunk_func = scheduler_bench_chunk;
+            system_desc.query = query;
+            system_desc.userdata = &system;
+            scheduler->add_system(system_desc);
+        }
+        bench(name, (usize)n * num_systems, [&]()
+        {
+            JobSystem::wait_job(scheduler->execute(world));
+        });
+    }
+
+    void scheduler_bench()
+    {
+        u32 n = scaled(1000000);
+        scheduler_systems_bench("scheduler 1 system", n, 1, false);
+        scheduler_systems_bench("scheduler 7 independent systems", n, 7, false);
+        scheduler_systems_bench("scheduler 8 chained systems", n, 8, true);
+        // Measures the fixed cost of one execution with many systems and few entities.
+        scheduler_systems_bench("scheduler 64 chained systems 1024 entities", 1024, 64, true);
+    }
+}
@@ -0,0 +1,85 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file StructuralBench.cpp
+* @author JXMaster
+* @date 2024/5/19
+*/
+#include "ECSBench.hpp"
+
+namespace Luna
+{
+    using namespace ECS;
+
+    // Adding or removing components moves entities to another cluster, which relocates all component data of the entity.
+    void structural_bench()
+    {
+        u32 n = scaled(100000);
+        Ref<IWorld> world;
+        Ref<ITaskContext> context;
+        Vector<entity_id_t> ids;
+        Ref<IQuery> query;
+        typeinfo_t moved_component = typeof<BenchComponent4>();
+        auto setup = [&](u32 num_components)
+        {
+            return [&, num_components]()
+            {
+                context.reset();
+                query.reset();
+                world = new_bench_world(n, num_components, 1, &ids);
+                context = new_task_context();
+                QueryDesc desc;
+                desc.required_components = get_bench_components(4);
+                query = world->new_query(desc);
+            };
+        };
+        bench("add component (per entity)", n, setup(4), [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            for (entity_id_t id : ids)
+            {
+                context->set_target_entity(id);
+                context->add_component<BenchComponent4>()->value = Float4U(1.0f);
+            }
+            context->end();
+        });
+        bench("remove component (per entity)", n, setup(5), [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            for (entity_id_t id : ids)
+            {
+                context->set_target_entity(id);
+                context->remove_component<BenchComponent4>();
+            }
+            context->end();
+        });
+        bench("add tag (per entity)", n, setup(4), [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            entity_id_t tag = context->add_entity();
+            for (entity_id_t id : ids)
+            {
+                context->set_target_entity(id);
+                context->add_tag(tag);
+            }
+            context->end();
+        });
+        bench("add component (move_entities)", n, setup(4), [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            context->move_entities(query, { &moved_component, 1 }, {}, {}, {});
+            context->end();
+        });
+        bench("remove component (move_entities)", n, setup(5), [&]()
+        {
+            context->begin(world, TaskExecutionMode::exclusive, {}, {});
+            context->move_entities(query, {}, { &moved_component, 1 }, {}, {});
+            context->end();
+        });
+        query.reset();
+        context.reset();
+        world.reset();
+    }
+}
@@ -0,0 +1,7 @@
+target("ECSBench")
+    set_luna_sdk_test()
+    set_kind("binary")
+    add_headerfiles("Source/*.hpp")
+    add_files("Source/*.cpp")
+    add_deps("Runtime", "JobSystem", "ECS", "VariantUtils", "BenchCommon")
+target_end()
\ No newline at end of file
@@ -9,6 +9,10 @@
 */
 #include <Luna/Runtime/Runtime.hpp>
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Stream.hpp>
+#include <Luna/Runtime/String.hpp>
 #include <Luna/Experimental/ECS/ECS.hpp>
 #include <Luna/Runtime/Math/Vector.hpp>
 #include <Luna/JobSystem/JobSystem.hpp>
@@ -21,6 +25,82 @@ struct Position
     Luna::Float3 position;
 };
 
+struct Velocity
+{
+    lustruct("Velocity", "{6F1E2B9A-3C47-4D85-9E0B-7A52C8D1F364}");
+    Luna::Float3 velocity = Luna::Float3(0.0f, 0.0f, 1.0f);
+};
+
+struct Label
+{
+    lustruct("Label", "{B83D51F0-6A2E-4C97-8D14-5E0F7A9C2B63}");
+    Luna::String label;
+};
+
+struct Parent
+{
+    lustruct("Parent", "{2E9C4A77-0B5D-4F18-A3E6-91D8C7B54F02}");
+    // The ID value of the parent entity.
+    Luna::u64 parent;
+};
+
+namespace Luna
+{
+    // Stores snapshots in memory.
+    struct SnapshotTestStream : IStream
+    {
+        lustruct("SnapshotTestStream", "{C41F8E26-7D3B-4A05-9B62-E8A0D5173F9C}");
+        luiimpl();
+
+        Vector<byte_t> m_data;
+        usize m_read_pos = 0;
+
+        virtual RV read(void* buffer, usize size, usize* read_bytes) override
+        {
+            usize sz = min(size, m_data.size() - m_read_pos);
+            memcpy(buffer, m_data.data() + m_read_pos, sz);
+            m_read_pos += sz;
+            if (read_bytes) *read_bytes = sz;
+            return ok;
+        }
+        virtual RV write(const void* buffer, usize size, usize* write_bytes) override
+        {
+            m_data.insert(m_data.end(), Span<const byte_t>((const byte_t*)buffer, size));
+            if (write_bytes) *write_bytes = size;
+            return ok;
+        }
+    };
+}
+
+// Checks whether one entity is stored in one cluster matched by the query.
+bool query_contains(Luna::ECS::IQuery* query, Luna::ECS::entity_id_t id)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    for (Cluster* cluster : query->get_clusters())
+    {
+        auto entities = get_cluster_entities(cluster);
+        for (entity_id_t e : entities)
+        {
+            if (e == id) return true;
+        }
+    }
+    return false;
+}
+
+// Counts entities stored in clusters matched by the query.
+Luna::usize count_query_entities(Luna::ECS::IQuery* query)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    usize count = 0;
+    for (Cluster* cluster : query->get_clusters())
+    {
+        count += get_cluster_entities(cluster).size();
+    }
+    return count;
+}
+
 void ecs_test()
 {
     using namespace Luna;
@@ -28,6 +108,17 @@ void ecs_test()
     register_struct_type<Position>({
         luproperty(Position, Float3, position)
         });
+    register_struct_type<Velocity>({
+        luproperty(Velocity, Float3, velocity)
+        });
+    register_struct_type<Label>({
+        luproperty(Label, String, label)
+        });
+    register_struct_type<Parent>({
+        luproperty(Parent, u64, parent)
+        });
+    register_boxed_type<SnapshotTestStream>();
+    impl_interface_for_type<SnapshotTestStream, IStream>();
     {
         // Create world and task context.
         Ref<IWorld> world = new_world();
@@ -129,6 +220,1070 @@ void ecs_test()
         lutest(!binary_search(tags2.begin(), tags2.end(), tag));
         context->end();
     }
+    {
+        // Change components of several entities of one cluster in one task. Relocating one entity moves the last
+        // entity of the cluster, so the other entities must be relocated from their current locations.
+        Ref<IWorld> world = new_world();
+        Ref<ITaskContext> context = new_task_context();
+        constexpr u32 num_entities = 8;
+        entity_id_t ids[num_entities];
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        for (u32 i = 0; i < num_entities; ++i)
+        {
+            ids[i] = context->add_entity();
+        }
+        context->end();
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        for (u32 i = 0; i < num_entities; ++i)
+        {
+            context->set_target_entity(ids[i]);
+            Position* data = context->add_component<Position>();
+            data->position = Float3((f32)i, 0.0f, 0.0f);
+        }
+        context->end();
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        for (u32 i = 0; i < num_entities; ++i)
+        {
+            EntityAddress addr = context->get_entity(ids[i]).get();
+            Position* data = get_cluster_components_data<Position>(addr.cluster);
+            lutest(data && data[addr.index].position == Float3((f32)i, 0.0f, 0.0f));
+        }
+        // Remove components from every other entity.
+        for (u32 i = 0; i < num_entities; i += 2)
+        {
+            context->set_target_entity(ids[i]);
+            context->remove_component<Position>();
+        }
+        context->end();
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        for (u32 i = 0; i < num_entities; ++i)
+        {
+            EntityAddress addr = context->get_entity(ids[i]).get();
+            Position* data = get_cluster_components_data<Position>(addr.cluster);
+            if (i % 2) lutest(data && data[addr.index].position == Float3((f32)i, 0.0f, 0.0f));
+            else lutest(data == nullptr);
+        }
+        context->end();
+    }
+    {
+        // Create entities and add components to them in the same task.
+        Ref<IWorld> world = new_world();
+        Ref<ITaskContext> context = new_task_context();
+        constexpr u32 num_entities = 4;
+        entity_id_t ids[num_entities];
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        for (u32 i = 0; i < num_entities; ++i)
+        {
+            ids[i] = context->add_entity();
+            context->set_target_entity(ids[i]);
+            Position* data = context->add_component<Position>();
+            data->position = Float3(0.0f, (f32)i, 0.0f);
+        }
+        context->end();
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        for (u32 i = 0; i < num_entities; ++i)
+        {
+            EntityAddress addr = context->get_entity(ids[i]).get();
+            Position* data = get_cluster_components_data<Position>(addr.cluster);
+            lutest(data && data[addr.index].position == Float3(0.0f, (f32)i, 0.0f));
+        }
+        context->end();
+    }
+}
+
+void query_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    Ref<ITaskContext> context = new_task_context();
+    typeinfo_t position = typeof<Position>();
+    typeinfo_t velocity = typeof<Velocity>();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    entity_id_t tag = context->add_entity();
+    context->end();
+    // Queries created before clusters exist are updated when clusters are created.
+    QueryDesc desc;
+    desc.required_components = { &position, 1 };
+    Ref<IQuery> position_query = world->new_query(desc);
+    desc.excluded_components = { &velocity, 1 };
+    Ref<IQuery> position_no_velocity_query = world->new_query(desc);
+    desc.excluded_components = {};
+    desc.excluded_tags = { &tag, 1 };
+    Ref<IQuery> position_no_tag_query = world->new_query(desc);
+    desc = QueryDesc();
+    desc.required_tags = { &tag, 1 };
+    Ref<IQuery> tag_query = world->new_query(desc);
+    lutest(position_query->get_clusters().empty());
+    lutest(tag_query->get_clusters().empty());
+
+    entity_id_t e_empty, e_pos, e_pos_vel, e_vel, e_pos_tag;
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    e_empty = context->add_entity();
+    e_pos = context->add_entity();
+    e_pos_vel = context->add_entity();
+    e_vel = context->add_entity();
+    e_pos_tag = context->add_entity();
+    context->set_target_entity(e_pos);
+    context->add_component<Position>()->position = Float3(1.0f, 0.0f, 0.0f);
+    context->set_target_entity(e_pos_vel);
+    context->add_component<Position>()->position = Float3(2.0f, 0.0f, 0.0f);
+    context->add_component<Velocity>()->velocity = Float3(2.0f, 0.0f, 0.0f);
+    context->set_target_entity(e_vel);
+    context->add_component<Velocity>()->velocity = Float3(3.0f, 0.0f, 0.0f);
+    context->set_target_entity(e_pos_tag);
+    context->add_component<Position>()->position = Float3(4.0f, 0.0f, 0.0f);
+    context->add_tag(tag);
+    context->end();
+
+    lutest(count_query_entities(position_query) == 3);
+    lutest(query_contains(position_query, e_pos));
+    lutest(query_contains(position_query, e_pos_vel));
+    lutest(query_contains(position_query, e_pos_tag));
+    lutest(!query_contains(position_query, e_vel));
+    lutest(!query_contains(position_query, e_empty));
+
+    lutest(count_query_entities(position_no_velocity_query) == 2);
+    lutest(query_contains(position_no_velocity_query, e_pos));
+    lutest(query_contains(position_no_velocity_query, e_pos_tag));
+
+    lutest(count_query_entities(position_no_tag_query) == 2);
+    lutest(query_contains(position_no_tag_query, e_pos));
+    lutest(query_contains(position_no_tag_query, e_pos_vel));
+
+    lutest(count_query_entities(tag_query) == 1);
+    lutest(query_contains(tag_query, e_pos_tag));
+
+    {
+        // Queries created after clusters exist match existing clusters, and optional components do not affect matching.
+        // Duplicated components are removed and components are sorted.
+        typeinfo_t required[] = { position, position };
+        desc = QueryDesc();
+        desc.required_components = { required, 2 };
+        desc.optional_components = { &velocity, 1 };
+        Ref<IQuery> query = world->new_query(desc);
+        lutest(query->get_required_components().size() == 1);
+        lutest(query->get_required_components()[0] == position);
+        lutest(query->get_optional_components().size() == 1);
+        auto clusters = query->get_clusters();
+        auto expected = position_query->get_clusters();
+        lutest(clusters.size() == expected.size());
+        for (Cluster* cluster : expected)
+        {
+            lutest(find(clusters.begin(), clusters.end(), cluster) != clusters.end());
+        }
+        typeinfo_t unsorted[] = { velocity, position };
+        desc = QueryDesc();
+        desc.required_components = { unsorted, 2 };
+        query = world->new_query(desc);
+        auto components = query->get_required_components();
+        lutest(components.size() == 2 && components[0] < components[1]);
+        lutest(count_query_entities(query) == 1);
+        lutest(query_contains(query, e_pos_vel));
+    }
+
+    // Moving entities between existing clusters and into new clusters updates query results.
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->set_target_entity(e_pos_vel);
+    context->remove_component<Velocity>();
+    context->set_target_entity(e_pos_tag);
+    context->add_component<Velocity>()->velocity = Float3(4.0f, 0.0f, 0.0f);
+    context->set_target_entity(e_empty);
+    context->add_tag(tag);
+    context->end();
+
+    lutest(count_query_entities(position_query) == 3);
+    lutest(count_query_entities(position_no_velocity_query) == 2);
+    lutest(query_contains(position_no_velocity_query, e_pos));
+    lutest(query_contains(position_no_velocity_query, e_pos_vel));
+    lutest(!query_contains(position_no_velocity_query, e_pos_tag));
+    lutest(count_query_entities(tag_query) == 2);
+    lutest(query_contains(tag_query, e_pos_tag));
+    lutest(query_contains(tag_query, e_empty));
+    for (Cluster* cluster : tag_query->get_clusters())
+    {
+        auto tags = get_cluster_tags(cluster);
+        lutest(binary_search(tags.begin(), tags.end(), tag));
+    }
+
+    // Released queries are not updated by the world anymore.
+    position_query.reset();
+    tag_query.reset();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->set_target_entity(e_vel);
+    context->add_tag(tag);
+    context->end();
+    lutest(count_query_entities(position_no_tag_query) == 2);
+}
+
+struct SchedulerTestContext
+{
+    // Increased every time one system starts, used to record the execution order of systems.
+    Luna::u32 volatile sequence;
+    Luna::u32 volatile num_chunk_entities;
+    Luna::u32 volatile num_chunks;
+    Luna::u32 volatile num_errors;
+    Luna::ECS::IQuery* position_query;
+};
+
+struct SchedulerTestSystem
+{
+    SchedulerTestContext* ctx;
+    Luna::u32 order;
+    // The value of `Position::position.x` of every entity expected when the chunk callback runs.
+    Luna::f32 expected_x;
+    // Whether the chunk callback increases `Position::position.x` of every entity.
+    bool write;
+};
+
+void scheduler_test_system(Luna::ECS::IWorld* world, void* userdata)
+{
+    using namespace Luna;
+    SchedulerTestSystem* system = (SchedulerTestSystem*)userdata;
+    system->order = atom_inc_u32(&system->ctx->sequence);
+}
+
+void scheduler_test_chunk(Luna::ECS::Cluster* cluster, const Luna::ECS::ClusterChunk& chunk, void* userdata)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    SchedulerTestSystem* system = (SchedulerTestSystem*)userdata;
+    Position* data = (Position*)chunk.components[get_cluster_component_index(cluster, typeof<Position>())];
+    for (usize i = 0; i < chunk.entities.size(); ++i)
+    {
+        if (data[i].position.x != system->expected_x) atom_inc_u32(&system->ctx->num_errors);
+        if (system->write) data[i].position.x += 1.0f;
+    }
+    atom_add_u32(&system->ctx->num_chunk_entities, (i32)chunk.entities.size());
+    atom_inc_u32(&system->ctx->num_chunks);
+}
+
+void scheduler_test_exclusive_system(Luna::ECS::IWorld* world, void* userdata)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    SchedulerTestSystem* system = (SchedulerTestSystem*)userdata;
+    system->order = atom_inc_u32(&system->ctx->sequence);
+    // All chunk jobs of preceding systems must be finished.
+    for (Cluster* cluster : system->ctx->position_query->get_clusters())
+    {
+        usize num_chunks = get_cluster_num_chunks(cluster);
+        for (usize c = 0; c < num_chunks; ++c)
+        {
+            ClusterChunk chunk = get_cluster_chunk(cluster, c);
+            Position* data = (Position*)chunk.components[get_cluster_component_index(cluster, typeof<Position>())];
+            for (usize i = 0; i < chunk.entities.size(); ++i)
+            {
+                if (data[i].position.x != system->expected_x) atom_inc_u32(&system->ctx->num_errors);
+            }
+        }
+    }
+}
+
+void scheduler_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    Ref<ITaskContext> context = new_task_context();
+    typeinfo_t position = typeof<Position>();
+    typeinfo_t velocity = typeof<Velocity>();
+    QueryDesc desc;
+    desc.required_components = { &position, 1 };
+    Ref<IQuery> position_query = world->new_query(desc);
+    constexpr u32 num_entities = 10000;
+    {
+        Vector<entity_id_t> ids(num_entities);
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        context->add_entities({ ids.data(), ids.size() }, { &position, 1 }, {});
+        context->end();
+        context->begin(world, TaskExecutionMode::exclusive, {}, {});
+        for (Cluster* cluster : position_query->get_clusters())
+        {
+            usize num_chunks = get_cluster_num_chunks(cluster);
+            for (usize c = 0; c < num_chunks; ++c)
+            {
+                ClusterChunk chunk = get_cluster_chunk(cluster, c);
+                Position* data = write_cluster_components_data<Position>(cluster, c, context->get_change_version());
+                for (usize i = 0; i < chunk.entities.size(); ++i) data[i].position = Float3(0.0f, 0.0f, 0.0f);
+            }
+        }
+        context->end();
+    }
+    lutest(position_query->get_clusters().size() == 1);
+    usize num_chunks = get_cluster_num_chunks(position_query->get_clusters()[0]);
+    // Entities must be spread across multiple chunks so that chunk callbacks run in parallel.
+    lutest(num_chunks > 1);
+
+    SchedulerTestContext ctx;
+    ctx.sequence = 0;
+    ctx.num_chunk_entities = 0;
+    ctx.num_chunks = 0;
+    ctx.num_errors = 0;
+    ctx.position_query = position_query;
+    SchedulerTestSystem systems[5];
+    for (auto& system : systems)
+    {
+        system.ctx = &ctx;
+        system.order = 0;
+        system.expected_x = 0.0f;
+        system.write = false;
+    }
+    Ref<IScheduler> scheduler = new_scheduler();
+    {
+        // 0: Writes Position.
+        SystemDesc sd;
+        sd.name = "WritePosition";
+        sd.write_components = { &position, 1 };
+        sd.func = scheduler_test_system;
+        sd.chunk_func = scheduler_test_chunk;
+        sd.query = position_query;
+        sd.userdata = &systems[0];
+        systems[0].write = true;
+        lutest(scheduler->add_system(sd) == 0);
+        // 1: Reads Position, must see all writes of system 0.
+        sd.name = "ReadPosition";
+        sd.write_components = {};
+        sd.read_components = { &position, 1 };
+        sd.userdata = &systems[1];
+        systems[1].expected_x = 1.0f;
+        lutest(scheduler->add_system(sd) == 1);
+        // 2: Reads Velocity only, does not conflict with systems 0 and 1.
+        sd.name = "ReadVelocity";
+        sd.read_components = { &velocity, 1 };
+        sd.chunk_func = nullptr;
+        sd.query = nullptr;
+        sd.userdata = &systems[2];
+        lutest(scheduler->add_system(sd) == 2);
+        // 3: Writes Position again, must wait for system 1 to finish reading.
+        sd.name = "WritePosition2";
+        sd.read_components = {};
+        sd.write_components = { &position, 1 };
+        sd.chunk_func = scheduler_test_chunk;
+        sd.query = position_query;
+        sd.userdata = &systems[3];
+        systems[3].expected_x = 1.0f;
+        systems[3].write = true;
+        lutest(scheduler->add_system(sd) == 3);
+        // 4: Exclusive, conflicts with all systems.
+        sd = SystemDesc();
+        sd.name = "Exclusive";
+        sd.exclusive = true;
+        sd.func = scheduler_test_exclusive_system;
+        sd.userdata = &systems[4];
+        systems[4].expected_x = 2.0f;
+        lutest(scheduler->add_system(sd) == 4);
+    }
+    // Only the nearest conflicting systems are recorded as dependencies.
+    lutest(scheduler->get_system_dependencies(0).empty());
+    auto deps = scheduler->get_system_dependencies(1);
+    lutest(deps.size() == 1 && deps[0] == 0);
+    lutest(scheduler->get_system_dependencies(2).empty());
+    // System 0 is reached through system 1.
+    deps = scheduler->get_system_dependencies(3);
+    lutest(deps.size() == 1 && deps[0] == 1);
+    // Systems 0 and 1 are reached through system 3.
+    deps = scheduler->get_system_dependencies(4);
+    lutest(deps.size() == 2);
+    lutest(find(deps.begin(), deps.end(), 2) != deps.end());
+    lutest(find(deps.begin(), deps.end(), 3) != deps.end());
+
+    JobSystem::wait_job(scheduler->execute(world));
+    lutest(ctx.num_errors == 0);
+    lutest(ctx.sequence == 5);
+    lutest(systems[1].order > systems[0].order);
+    lutest(systems[3].order > systems[1].order);
+    lutest(systems[4].order > systems[3].order);
+    lutest(systems[4].order > systems[2].order);
+    lutest(ctx.num_chunks == num_chunks * 3);
+    lutest(ctx.num_chunk_entities == num_entities * 3);
+
+    // Systems can be executed repeatedly.
+    ctx.sequence = 0;
+    ctx.num_chunks = 0;
+    ctx.num_chunk_entities = 0;
+    for (auto& system : systems)
+    {
+        system.expected_x += 2.0f;
+    }
+    JobSystem::wait_job(scheduler->execute(world));
+    lutest(ctx.num_errors == 0);
+    lutest(ctx.sequence == 5);
+    lutest(ctx.num_chunk_entities == num_entities * 3);
+
+    // Executing one scheduler without systems finishes immediately.
+    scheduler->clear_systems();
+    ctx.sequence = 0;
+    JobSystem::wait_job(scheduler->execute(world));
+    lutest(ctx.sequence == 0);
+}
+
+constexpr Luna::u32 NUM_ENTITY_ID_THREADS = 8;
+constexpr Luna::u32 NUM_ENTITY_ID_TASKS = 4;
+constexpr Luna::u32 NUM_ENTITY_ID_TASK_ENTITIES = 250;
+constexpr Luna::u32 NUM_ENTITY_ID_THREAD_ENTITIES = NUM_ENTITY_ID_TASKS * NUM_ENTITY_ID_TASK_ENTITIES;
+
+struct EntityIdTestContext
+{
+    Luna::ECS::IWorld* world;
+    Luna::ECS::entity_id_t* ids;
+};
+
+void entity_id_test_thread(void* params)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    EntityIdTestContext* ctx = (EntityIdTestContext*)params;
+    Ref<ITaskContext> context = new_task_context();
+    for (u32 i = 0; i < NUM_ENTITY_ID_TASKS; ++i)
+    {
+        context->begin(ctx->world, TaskExecutionMode::shared, {}, {});
+        for (u32 j = 0; j < NUM_ENTITY_ID_TASK_ENTITIES; ++j)
+        {
+            ctx->ids[i * NUM_ENTITY_ID_TASK_ENTITIES + j] = context->add_entity();
+        }
+        context->end();
+    }
+}
+
+void entity_id_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    // Allocate IDs from multiple threads concurrently. The total number of entities spans multiple record pages.
+    Vector<entity_id_t> ids(NUM_ENTITY_ID_THREADS * NUM_ENTITY_ID_THREAD_ENTITIES);
+    EntityIdTestContext ctxs[NUM_ENTITY_ID_THREADS];
+    Ref<IThread> threads[NUM_ENTITY_ID_THREADS];
+    for (u32 i = 0; i < NUM_ENTITY_ID_THREADS; ++i)
+    {
+        ctxs[i].world = world;
+        ctxs[i].ids = ids.data() + i * NUM_ENTITY_ID_THREAD_ENTITIES;
+        threads[i] = new_thread(entity_id_test_thread, &ctxs[i]);
+    }
+    for (auto& t : threads) t->wait();
+    // All IDs are unique and valid.
+    Vector<entity_id_t> sorted_ids = ids;
+    sort(sorted_ids.begin(), sorted_ids.end());
+    for (usize i = 0; i < sorted_ids.size(); ++i)
+    {
+        lutest(sorted_ids[i] != NULL_ENTITY);
+        if (i) lutest(sorted_ids[i].index != sorted_ids[i - 1].index);
+    }
+    Ref<ITaskContext> context = new_task_context();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    for (entity_id_t id : ids)
+    {
+        lutest(context->is_entity_valid(id));
+    }
+    context->end();
+    // Remove entities of the first thread, and allocate the same number of entities again.
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    for (u32 i = 0; i < NUM_ENTITY_ID_THREAD_ENTITIES; ++i)
+    {
+        context->remove_entity(ids[i]);
+    }
+    context->end();
+    Vector<entity_id_t> new_ids(NUM_ENTITY_ID_THREAD_ENTITIES);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    for (auto& id : new_ids)
+    {
+        id = context->add_entity();
+    }
+    context->end();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    for (u32 i = 0; i < ids.size(); ++i)
+    {
+        lutest(context->is_entity_valid(ids[i]) == (i >= NUM_ENTITY_ID_THREAD_ENTITIES));
+    }
+    // Freed indices are reused with increased generations, so removed IDs are not relived.
+    Vector<entity_id_t> removed_ids;
+    removed_ids.assign(ids.begin(), ids.begin() + NUM_ENTITY_ID_THREAD_ENTITIES);
+    sort(removed_ids.begin(), removed_ids.end(), [](entity_id_t lhs, entity_id_t rhs) { return lhs.index < rhs.index; });
+    for (entity_id_t id : new_ids)
+    {
+        lutest(context->is_entity_valid(id));
+        auto iter = binary_search_iter(removed_ids.begin(), removed_ids.end(), id,
+            [](entity_id_t lhs, entity_id_t rhs) { return lhs.index < rhs.index; });
+        lutest(iter != removed_ids.end());
+        lutest(id.generation == iter->generation + 1);
+    }
+    context->end();
+}
+
+void batch_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    Ref<ITaskContext> context = new_task_context();
+    typeinfo_t position = typeof<Position>();
+    typeinfo_t velocity = typeof<Velocity>();
+    constexpr u32 num_entities = 3000;
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    entity_id_t tag = context->add_entity();
+    context->end();
+    // Spawn entities with one component and tag set. Component order does not matter.
+    Vector<entity_id_t> ids(num_entities);
+    typeinfo_t components[] = { velocity, position };
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->add_entities({ ids.data(), ids.size() }, { components, 2 }, { &tag, 1 });
+    context->end();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    Cluster* cluster = context->get_entity(ids[0]).get().cluster;
+    lutest(get_cluster_components(cluster).size() == 2);
+    lutest(get_cluster_tags(cluster).size() == 1 && get_cluster_tags(cluster)[0] == tag);
+    lutest(get_cluster_entities(cluster).size() == num_entities);
+    for (u32 i = 0; i < num_entities; ++i)
+    {
+        auto addr = context->get_entity(ids[i]);
+        lutest(succeeded(addr) && addr.get().cluster == cluster);
+        lutest(get_cluster_entities(cluster)[addr.get().index] == ids[i]);
+        // Components are default-constructed.
+        Velocity* v = context->get_component<Velocity>(ids[i]).get();
+        lutest(v->velocity == Float3(0.0f, 0.0f, 1.0f));
+        context->get_component<Position>(ids[i]).get()->position = Float3((f32)i, 0.0f, 0.0f);
+    }
+    context->end();
+    // Move entities to another cluster. Shared components are relocated, removed components are destroyed.
+    QueryDesc desc;
+    desc.required_tags = { &tag, 1 };
+    Ref<IQuery> tag_query = world->new_query(desc);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->move_entities(tag_query, {}, { &velocity, 1 }, {}, { &tag, 1 });
+    context->end();
+    lutest(get_cluster_entities(cluster).empty());
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    Cluster* position_cluster = context->get_entity(ids[0]).get().cluster;
+    lutest(position_cluster != cluster);
+    lutest(get_cluster_components(position_cluster).size() == 1 && get_cluster_components(position_cluster)[0] == position);
+    lutest(get_cluster_tags(position_cluster).empty());
+    lutest(get_cluster_entities(position_cluster).size() == num_entities);
+    for (u32 i = 0; i < num_entities; ++i)
+    {
+        auto addr = context->get_entity(ids[i]);
+        lutest(succeeded(addr) && addr.get().cluster == position_cluster);
+        lutest(get_cluster_entities(position_cluster)[addr.get().index] == ids[i]);
+        lutest(!context->has_component<Velocity>(ids[i]));
+        lutest(context->get_component<Position>(ids[i]).get()->position == Float3((f32)i, 0.0f, 0.0f));
+    }
+    context->end();
+    // Added components are default-constructed.
+    desc = QueryDesc();
+    desc.required_components = { &position, 1 };
+    Ref<IQuery> position_query = world->new_query(desc);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->move_entities(position_query, { &velocity, 1 }, {}, {}, {});
+    context->end();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    Cluster* position_velocity_cluster = context->get_entity(ids[0]).get().cluster;
+    lutest(get_cluster_components(position_velocity_cluster).size() == 2);
+    lutest(get_cluster_tags(position_velocity_cluster).empty());
+    lutest(get_cluster_entities(position_cluster).empty());
+    for (u32 i = 0; i < num_entities; ++i)
+    {
+        lutest(context->get_entity(ids[i]).get().cluster == position_velocity_cluster);
+        lutest(context->get_component<Velocity>(ids[i]).get()->velocity == Float3(0.0f, 0.0f, 1.0f));
+        lutest(context->get_component<Position>(ids[i]).get()->position == Float3((f32)i, 0.0f, 0.0f));
+    }
+    context->end();
+    // Entity changes recorded before one batch operation are applied before the batch operation, so the entity 
+    // added and given Position here is removed by `remove_entities`, while the entity spawned after it is not.
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    entity_id_t e = context->add_entity();
+    context->set_target_entity(e);
+    context->add_component<Position>()->position = Float3(-1.0f, 0.0f, 0.0f);
+    context->remove_entities(position_query);
+    entity_id_t e2;
+    context->add_entities({ &e2, 1 }, { &position, 1 }, {});
+    context->end();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    for (u32 i = 0; i < num_entities; ++i)
+    {
+        lutest(!context->is_entity_valid(ids[i]));
+    }
+    lutest(!context->is_entity_valid(e));
+    lutest(context->is_entity_valid(e2));
+    lutest(count_query_entities(position_query) == 1);
+    context->end();
+}
+
+constexpr Luna::u32 NUM_CHANGE_LIST_THREADS = 8;
+constexpr Luna::u32 NUM_CHANGE_LIST_ENTITIES = 500;
+
+struct ChangeListTestContext
+{
+    Luna::ECS::IWorld* world;
+    Luna::ECS::entity_id_t target;
+    Luna::u64 order;
+    Luna::ECS::entity_id_t ids[NUM_CHANGE_LIST_ENTITIES];
+};
+
+void change_list_test_thread(void* params)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    ChangeListTestContext* ctx = (ChangeListTestContext*)params;
+    Ref<ITaskContext> context = new_task_context();
+    typeinfo_t velocity = typeof<Velocity>();
+    context->begin(ctx->world, TaskExecutionMode::shared, {}, {});
+    // Every change list overwrites the same component, so the final value is written by the last applied list.
+    context->set_target_entity(ctx->target);
+    context->add_component<Position>(true)->position = Float3((f32)ctx->order, 0.0f, 0.0f);
+    context->add_entities({ ctx->ids, NUM_CHANGE_LIST_ENTITIES }, { &velocity, 1 }, {});
+    context->submit(ctx->order);
+}
+
+void change_list_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    Ref<ITaskContext> context = new_task_context();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    entity_id_t target = context->add_entity();
+    context->set_target_entity(target);
+    context->add_component<Position>()->position = Float3(-1.0f, 0.0f, 0.0f);
+    context->end();
+    // Submit change lists from multiple threads. Order values are not the same as thread creation order.
+    ChangeListTestContext ctxs[NUM_CHANGE_LIST_THREADS];
+    Ref<IThread> threads[NUM_CHANGE_LIST_THREADS];
+    for (u32 i = 0; i < NUM_CHANGE_LIST_THREADS; ++i)
+    {
+        ctxs[i].world = world;
+        ctxs[i].target = target;
+        ctxs[i].order = (i * 5 + 3) % NUM_CHANGE_LIST_THREADS;
+        threads[i] = new_thread(change_list_test_thread, &ctxs[i]);
+    }
+    for (auto& t : threads) t->wait();
+    // Submitted changes are not applied until flushed.
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    lutest(context->get_component<Position>(target).get()->position.x == -1.0f);
+    for (auto& ctx : ctxs)
+    {
+        for (entity_id_t id : ctx.ids) lutest(!context->is_entity_valid(id));
+    }
+    context->end();
+    world->flush_change_lists();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    lutest(context->get_component<Position>(target).get()->position.x == (f32)(NUM_CHANGE_LIST_THREADS - 1));
+    for (auto& ctx : ctxs)
+    {
+        for (entity_id_t id : ctx.ids)
+        {
+            // Components of spawned entities are constructed in parallel when changes are flushed.
+            lutest(context->is_entity_valid(id));
+            lutest(context->get_component<Velocity>(id).get()->velocity == Float3(0.0f, 0.0f, 1.0f));
+        }
+    }
+    context->end();
+    // Changes submitted in descending order are still applied in ascending order.
+    Ref<ITaskContext> contexts[4];
+    for (u32 i = 0; i < 4; ++i)
+    {
+        contexts[i] = new_task_context();
+        contexts[i]->begin(world, TaskExecutionMode::shared, {}, {});
+    }
+    for (u32 i = 4; i > 0; --i)
+    {
+        contexts[i - 1]->set_target_entity(target);
+        contexts[i - 1]->add_component<Position>(true)->position = Float3((f32)(i - 1) * 10.0f, 0.0f, 0.0f);
+        contexts[i - 1]->submit(i - 1);
+    }
+    world->flush_change_lists();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    lutest(context->get_component<Position>(target).get()->position.x == 30.0f);
+    context->end();
+    // Flushing without submitted changes does nothing.
+    world->flush_change_lists();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    lutest(context->get_component<Position>(target).get()->position.x == 30.0f);
+    context->end();
+}
+
+void version_test_chunk(Luna::ECS::Cluster* cluster, const Luna::ECS::ClusterChunk& chunk, void* userdata)
+{
+    Luna::atom_inc_u32((Luna::u32 volatile*)userdata);
+}
+
+void version_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    Ref<ITaskContext> context = new_task_context();
+    typeinfo_t position = typeof<Position>();
+    typeinfo_t velocity = typeof<Velocity>();
+    typeinfo_t components[] = { position, velocity };
+    Vector<entity_id_t> ids(5000);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->add_entities({ ids.data(), ids.size() }, { components, 2 }, {});
+    context->end();
+    QueryDesc desc;
+    desc.required_components = { &position, 1 };
+    desc.changed_components = { &position, 1 };
+    Ref<IQuery> position_changed_query = world->new_query(desc);
+    desc.changed_components = { &velocity, 1 };
+    Ref<IQuery> velocity_changed_query = world->new_query(desc);
+    desc.changed_components = {};
+    Ref<IQuery> any_changed_query = world->new_query(desc);
+    lutest(position_changed_query->get_clusters().size() == 1);
+    Cluster* cluster = position_changed_query->get_clusters()[0];
+    usize num_chunks = get_cluster_num_chunks(cluster);
+    lutest(num_chunks > 2);
+    // Chunks filled by structural changes are marked with versions not greater than the current world version.
+    u64 base_version = world->get_change_version();
+    for (usize c = 0; c < num_chunks; ++c)
+    {
+        u64 v = get_cluster_component_version(cluster, position, c);
+        lutest(v > 0 && v <= base_version);
+        lutest(get_cluster_chunk(cluster, c).versions[get_cluster_component_index(cluster, position)] == v);
+    }
+    lutest(get_cluster_component_version(cluster, typeof<u32>(), 0) == 0);
+    Vector<QueryChunk> chunks;
+    position_changed_query->get_changed_chunks(chunks, 0);
+    lutest(chunks.size() == num_chunks);
+    position_changed_query->get_changed_chunks(chunks, base_version);
+    lutest(chunks.empty());
+
+    // Every task gets one new version, and writing one component array only marks that array.
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    u64 version = context->get_change_version();
+    lutest(version > base_version);
+    lutest(world->get_change_version() == version);
+    lutest(write_cluster_components_data<Position>(cluster, 1, version) == get_cluster_components_data<Position>(cluster, 1));
+    lutest(get_cluster_component_version(cluster, position, 1) == version);
+    lutest(get_cluster_component_version(cluster, velocity, 1) <= base_version);
+    lutest(get_cluster_component_version(cluster, position, 0) <= base_version);
+    // Writing with one older version does not decrease the version.
+    write_cluster_components_data<Position>(cluster, 1, base_version);
+    lutest(get_cluster_component_version(cluster, position, 1) == version);
+    context->end();
+    position_changed_query->get_changed_chunks(chunks, base_version);
+    lutest(chunks.size() == 1 && chunks[0].cluster == cluster && chunks[0].chunk_index == 1);
+    velocity_changed_query->get_changed_chunks(chunks, base_version);
+    lutest(chunks.empty());
+    any_changed_query->get_changed_chunks(chunks, base_version);
+    lutest(chunks.size() == 1 && chunks[0].chunk_index == 1);
+
+    // Adding entities marks all component arrays of the chunks that receive them.
+    u64 last_version = world->get_change_version();
+    entity_id_t id;
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->add_entities({ &id, 1 }, { components, 2 }, {});
+    context->end();
+    usize last_chunk = get_cluster_num_chunks(cluster) - 1;
+    velocity_changed_query->get_changed_chunks(chunks, last_version);
+    lutest(chunks.size() == 1 && chunks[0].chunk_index == last_chunk);
+    position_changed_query->get_changed_chunks(chunks, last_version);
+    lutest(chunks.size() == 1 && chunks[0].chunk_index == last_chunk);
+
+    // Systems with `changed_only` only receive chunks changed since their last execution.
+    u32 volatile num_chunk_calls = 0;
+    Ref<IScheduler> scheduler = new_scheduler();
+    SystemDesc sd;
+    sd.name = "ChangedPosition";
+    sd.read_components = { &position, 1 };
+    sd.chunk_func = version_test_chunk;
+    sd.query = position_changed_query;
+    sd.changed_only = true;
+    sd.userdata = (void*)&num_chunk_calls;
+    scheduler->add_system(sd);
+    JobSystem::wait_job(scheduler->execute(world));
+    lutest(num_chunk_calls == get_cluster_num_chunks(cluster));
+    num_chunk_calls = 0;
+    JobSystem::wait_job(scheduler->execute(world));
+    lutest(num_chunk_calls == 0);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    write_cluster_components_data<Position>(cluster, 0, context->get_change_version());
+    // Velocity is not checked by the query.
+    write_cluster_components_data<Velocity>(cluster, 2, context->get_change_version());
+    context->end();
+    JobSystem::wait_job(scheduler->execute(world));
+    lutest(num_chunk_calls == 1);
+    // The scheduler marks write components of every chunk passed to one system that writes them.
+    num_chunk_calls = 0;
+    sd.name = "WritePosition";
+    sd.read_components = {};
+    sd.write_components = { &position, 1 };
+    sd.changed_only = false;
+    scheduler->clear_systems();
+    scheduler->add_system(sd);
+    last_version = world->get_change_version();
+    JobSystem::wait_job(scheduler->execute(world));
+    lutest(num_chunk_calls == get_cluster_num_chunks(cluster));
+    position_changed_query->get_changed_chunks(chunks, last_version);
+    lutest(chunks.size() == get_cluster_num_chunks(cluster));
+    velocity_changed_query->get_changed_chunks(chunks, last_version);
+    lutest(chunks.empty());
+}
+
+void chunk_iteration_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    Ref<ITaskContext> context = new_task_context();
+    typeinfo_t components[] = { typeof<Position>(), typeof<Velocity>() };
+    // Use one entity count that leaves the last chunk partially filled.
+    Vector<entity_id_t> ids(3001);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    context->add_entities({ ids.data(), ids.size() }, { components, 2 }, {});
+    context->end();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    Cluster* cluster = context->get_entity(ids[0]).get().cluster;
+    usize capacity = get_cluster_chunk_capacity(cluster);
+    usize num_chunks = get_cluster_num_chunks(cluster);
+    lutest(num_chunks > 1);
+    lutest(ids.size() % capacity != 0);
+    // Spans cover all entities of every chunk in order, and component arrays are aligned.
+    usize index = 0;
+    usize num_calls = 0;
+    for_each_chunk<Position>(cluster, [&](usize count, Span<Position> positions)
+    {
+        lutest(positions.size() == count);
+        lutest(count == min(capacity, ids.size() - index));
+        lutest((usize)positions.data() % CLUSTER_COLUMN_ALIGNMENT == 0);
+        lutest(positions.data() == get_cluster_components_data<Position>(cluster, num_calls));
+        for (auto& p : positions)
+        {
+            p.position = Float3((f32)index, 0.0f, 0.0f);
+            ++index;
+        }
+        ++num_calls;
+    });
+    lutest(index == ids.size());
+    lutest(num_calls == num_chunks);
+    // Spans are passed in the order of template arguments, not the order of cluster components.
+    for_each_chunk<Velocity, const Position>(cluster, [&](usize count, Span<Velocity> velocities, Span<const Position> positions)
+    {
+        lutest((usize)velocities.data() % CLUSTER_COLUMN_ALIGNMENT == 0);
+        for (usize i = 0; i < count; ++i)
+        {
+            lutest(velocities[i].velocity == Float3(0.0f, 0.0f, 1.0f));
+            velocities[i].velocity = positions[i].position * 2.0f;
+        }
+    });
+    for (usize i = 0; i < ids.size(); ++i)
+    {
+        EntityAddress addr = context->get_entity(ids[i]).get();
+        lutest(addr.index == i);
+        lutest(context->get_component<Velocity>(ids[i]).get()->velocity == Float3((f32)i * 2.0f, 0.0f, 0.0f));
+    }
+    // Clusters without all requested components are skipped.
+    num_calls = 0;
+    for_each_chunk<Position, u32>(cluster, [&](usize count, Span<Position>, Span<u32>) { ++num_calls; });
+    for_each_chunk_batch<4, Position, u32>(cluster, [&](usize count, Position*, u32*) { ++num_calls; });
+    lutest(num_calls == 0);
+    // Batches cover all entities, only the last batch of every chunk may be partial, and full batches can be 
+    // stored at the end of every chunk without touching other entities.
+    index = 0;
+    usize chunk_begin = 0;
+    for_each_chunk_batch<4, Position>(cluster, [&](usize count, Position* positions)
+    {
+        lutest(count > 0 && count <= 4);
+        usize chunk_end = min(chunk_begin + capacity, ids.size());
+        lutest(count == min<usize>(4, chunk_end - index));
+        for (usize i = 0; i < count; ++i)
+        {
+            lutest(positions[i].position.x == (f32)index);
+            positions[i].position.y = 1.0f;
+            ++index;
+        }
+        for (usize i = count; i < 4; ++i)
+        {
+            positions[i].position = Float3(-1.0f, -1.0f, -1.0f);
+        }
+        if (index == chunk_end) chunk_begin = chunk_end;
+    });
+    lutest(index == ids.size());
+    // Batches of 8 Position (96 bytes) are aligned to CLUSTER_COLUMN_ALIGNMENT.
+    index = 0;
+    for_each_chunk_batch<8, const Position, Velocity>(cluster, [&](usize count, const Position* positions, Velocity* velocities)
+    {
+        lutest((usize)positions % CLUSTER_COLUMN_ALIGNMENT == 0);
+        for (usize i = 0; i < count; ++i)
+        {
+            lutest(positions[i].position == Float3((f32)index, 1.0f, 0.0f));
+            lutest(velocities[i].velocity.x == (f32)index * 2.0f);
+            ++index;
+        }
+    });
+    lutest(index == ids.size());
+    context->end();
+}
+
+// Checks that every entity of `src` exists in `dst` with the same ID, components and tags.
+void compare_worlds(Luna::ECS::ITaskContext* src, Luna::ECS::ITaskContext* dst)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Vector<Cluster*> clusters;
+    src->get_clusters(clusters, [](Cluster* cluster) { return true; });
+    for (Cluster* cluster : clusters)
+    {
+        auto components = get_cluster_components(cluster);
+        auto tags = get_cluster_tags(cluster);
+        auto entities = get_cluster_entities(cluster);
+        for (usize i = 0; i < entities.size(); ++i)
+        {
+            auto r = dst->get_entity(entities[i]);
+            lutest(succeeded(r));
+            EntityAddress addr = r.get();
+            lutest(get_cluster_entities(addr.cluster)[addr.index] == entities[i]);
+            auto dst_components = get_cluster_components(addr.cluster);
+            auto dst_tags = get_cluster_tags(addr.cluster);
+            lutest(dst_components.size() == components.size());
+            lutest(dst_tags.size() == tags.size());
+            for (usize t = 0; t < tags.size(); ++t) lutest(dst_tags[t] == tags[t]);
+            for (typeinfo_t type : components)
+            {
+                lutest(binary_search(dst_components.begin(), dst_components.end(), type));
+                void* src_data = get_cluster_entity_component(cluster, type, i);
+                void* dst_data = get_cluster_entity_component(addr.cluster, type, addr.index);
+                if (type == typeof<Label>())
+                {
+                    lutest(!((Label*)src_data)->label.compare(((Label*)dst_data)->label));
+                }
+                else
+                {
+                    lutest(!memcmp(src_data, dst_data, get_type_size(type)));
+                }
+            }
+        }
+    }
+}
+
+Luna::usize count_world_entities(Luna::ECS::ITaskContext* context)
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Vector<Cluster*> clusters;
+    context->get_clusters(clusters, [](Cluster* cluster) { return true; });
+    usize count = 0;
+    for (Cluster* cluster : clusters) count += get_cluster_entities(cluster).size();
+    return count;
+}
+
+void snapshot_test()
+{
+    using namespace Luna;
+    using namespace Luna::ECS;
+    Ref<IWorld> world = new_world();
+    Ref<ITaskContext> context = new_task_context();
+    typeinfo_t position = typeof<Position>();
+    constexpr u32 num_entities = 3000;
+    Vector<entity_id_t> ids(num_entities);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    entity_id_t tag = context->add_entity();
+    context->add_entities({ ids.data(), ids.size() }, { &position, 1 }, {});
+    context->end();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    for (u32 i = 0; i < num_entities; ++i)
+    {
+        context->get_component<Position>(ids[i]).get()->position = Float3((f32)i, (f32)i * 0.5f, -1.0f);
+    }
+    // Entities with serialized components, raw components that refer to other entities, and tags.
+    Vector<entity_id_t> labeled_ids;
+    for (u32 i = 0; i < 10; ++i)
+    {
+        entity_id_t id = context->add_entity();
+        labeled_ids.push_back(id);
+        context->set_target_entity(id);
+        Label* label = new (context->add_component<Label>()) Label();
+        label->label = "entity_";
+        label->label.push_back((c8)('0' + i));
+        context->add_component<Position>()->position = Float3(0.0f, (f32)i, 0.0f);
+        if (i % 2) context->add_tag(tag);
+        Parent* parent = context->add_component<Parent>();
+        parent->parent = ids[i * 10].value;
+        context->add_component<Velocity>()->velocity = Float3((f32)i, 0.0f, 0.0f);
+    }
+    // Remove some entities so that the snapshot contains free slots.
+    for (u32 i = 1; i < num_entities; i += 7)
+    {
+        context->remove_entity(ids[i]);
+    }
+    context->end();
+    // Reuse some freed slots, so that some live entities have generations greater than one.
+    Vector<entity_id_t> reused_ids(5);
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    for (auto& id : reused_ids)
+    {
+        id = context->add_entity();
+        context->set_target_entity(id);
+        context->add_component<Position>()->position = Float3(100.0f, 0.0f, 0.0f);
+    }
+    context->end();
+    Ref<SnapshotTestStream> stream = new_object<SnapshotTestStream>();
+    lutest(succeeded(world->save_snapshot(stream)));
+    lutest(!stream->m_data.empty());
+
+    // Load the snapshot into one world that already contains entities, the old entities are replaced.
+    Ref<IWorld> loaded_world = new_world();
+    entity_id_t old_id;
+    {
+        Ref<ITaskContext> loaded_context = new_task_context();
+        loaded_context->begin(loaded_world, TaskExecutionMode::exclusive, {}, {});
+        Vector<entity_id_t> old_ids(num_entities * 2);
+        loaded_context->add_entities({ old_ids.data(), old_ids.size() }, { &position, 1 }, { &tag, 1 });
+        old_id = old_ids.back();
+        loaded_context->end();
+    }
+    lutest(succeeded(loaded_world->load_snapshot(stream)));
+    Ref<ITaskContext> loaded_context = new_task_context();
+    context->begin(world, TaskExecutionMode::exclusive, {}, {});
+    loaded_context->begin(loaded_world, TaskExecutionMode::exclusive, {}, {});
+    // Entity IDs (including generations), components and tags are preserved.
+    compare_worlds(context, loaded_context);
+    lutest(count_world_entities(loaded_context) == count_world_entities(context));
+    lutest(!loaded_context->is_entity_valid(old_id));
+    for (u32 i = 1; i < num_entities; i += 7)
+    {
+        lutest(!loaded_context->is_entity_valid(ids[i]));
+    }
+    for (entity_id_t id : reused_ids)
+    {
+        lutest(id.generation > 1);
+        lutest(loaded_context->is_entity_valid(id));
+    }
+    // Entity references stored in components are still valid.
+    for (entity_id_t id : labeled_ids)
+    {
+        entity_id_t parent = loaded_context->get_component<Parent>(id).get()->parent;
+        lutest(loaded_context->is_entity_valid(parent));
+        lutest(loaded_context->get_component<Position>(parent).get()->position == context->get_component<Position>(parent).get()->position);
+    }
+    context->end();
+    loaded_context->end();
+    // New IDs allocated after loading do not collide with loaded IDs or removed IDs.
+    loaded_context->begin(loaded_world, TaskExecutionMode::exclusive, {}, {});
+    Vector<entity_id_t> new_ids(num_entities);
+    for (auto& id : new_ids) id = loaded_context->add_entity();
+    loaded_context->end();
+    loaded_context->begin(loaded_world, TaskExecutionMode::exclusive, {}, {});
+    for (entity_id_t id : new_ids)
+    {
+        lutest(loaded_context->is_entity_valid(id));
+        for (u32 i = 1; i < num_entities; i += 7) lutest(id != ids[i]);
+    }
+    for (entity_id_t id : ids)
+    {
+        for (entity_id_t new_id : new_ids) lutest(id.index != new_id.index || id.generation != new_id.generation);
+    }
+    lutest(count_world_entities(loaded_context) == count_world_entities(context) + num_entities);
+    loaded_context->end();
+
+    // Invalid snapshots are rejected.
+    Ref<SnapshotTestStream> bad_stream = new_object<SnapshotTestStream>();
+    bad_stream->m_data = stream->m_data;
+    bad_stream->m_data[0] ^= 0xFF;
+    auto r = new_world()->load_snapshot(bad_stream);
+    lutest(failed(r) && r.errcode() == BasicError::format_error());
+    bad_stream->m_data = stream->m_data;
+    bad_stream->m_data.resize(bad_stream->m_data.size() / 2);
+    bad_stream->m_read_pos = 0;
+    lutest(failed(new_world()->load_snapshot(bad_stream)));
 }
 
 int main()
@@ -137,6 +1292,14 @@ int main()
     lupanic_if_failed(Luna::add_modules({Luna::module_job_system(), Luna::module_ecs()}));
     lupanic_if_failed(Luna::init_modules());
     ecs_test();
+    query_test();
+    scheduler_test();
+    entity_id_test();
+    batch_test();
+    change_list_test();
+    version_test();
+    chunk_iteration_test();
+    snapshot_test();
     Luna::close();
     return 0;
 }
\ No newline at end of file
@@ -0,0 +1,318 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Main.cpp
+* @author JXMaster
+* @date 2024/5/15
+*/
+#include <Luna/Runtime/Runtime.hpp>
+#include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+#include <Luna/JobSystem/JobSystem.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
+#include "../BenchCommon/BenchCommon.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Usage: JobSystemBench [--workers <count>] [common benchmark options, see `parse_bench_option`]
+// The number of worker threads is fixed when the job system is initialized, so parallel_for scaling with different
+// worker counts is measured by running the benchmark once for every `--workers` value. Scaling with 1 to N participating
+// threads is also measured in one run by submitting N long-running jobs that share one work counter.
+namespace Luna
+{
+    using namespace JobSystem;
+
+    // Job sizes used by throughput and scaling benchmarks.
+    enum class WorkSize : u8
+    {
+        // Jobs that do nothing, which measures the scheduling overhead only.
+        empty,
+        // Jobs that run about 100 loop iterations.
+        tiny,
+        // Jobs that run 0 to 20000 loop iterations.
+        mixed,
+    };
+    static const c8* get_work_size_name(WorkSize size)
+    {
+        switch (size)
+        {
+        case WorkSize::empty: return "empty";
+        case WorkSize::tiny: return "tiny";
+        case WorkSize::mixed: return "mixed";
+        }
+        return "";
+    }
+
+    static volatile usize g_sink = 0;
+
+    static void do_work(WorkSize size, usize index)
+    {
+        usize iterations = 0;
+        switch (size)
+        {
+        case WorkSize::empty: return;
+        case WorkSize::tiny: iterations = 100; break;
+        // Uses one cheap hash of the index so that the job size distribution is deterministic.
+        case WorkSize::mixed: iterations = ((index * 2654435761U) >> 7) % 20000; break;
+        }
+        usize v = index;
+        for (usize i = 0; i < iterations; ++i)
+        {
+            v = v * 6364136223846793005ULL + 1442695040888963407ULL;
+        }
+        g_sink = v;
+    }
+
+    // Formats the name of one benchmark as "<name>/<jobs>/<threads>t", so that results of different job sizes and
+    // thread counts can be selected by `--filter`.
+    static const c8* get_bench_name(c8 (&buf)[64], const c8* name, const c8* jobs, u32 threads)
+    {
+        snprintf(buf, 64, "%s/%s/%ut", name, jobs, threads);
+        return buf;
+    }
+
+    struct WorkJob
+    {
+        WorkSize size;
+        usize index;
+    };
+    static void work_job(void* params)
+    {
+        WorkJob* job = (WorkJob*)params;
+        do_work(job->size, job->index);
+    }
+
+    // Measures the time to submit and finish N jobs from the main thread.
+    static void submit_bench(u32 num_threads)
+    {
+        constexpr usize N = 10000;
+        Vector<job_id_t> ids(N, INVALID_JOB_ID);
+        Vector<void*> jobs(N, nullptr);
+        c8 name[64];
+        for (WorkSize size : { WorkSize::empty, WorkSize::tiny, WorkSize::mixed })
+        {
+            bench(get_bench_name(name, "submit_job+wait_job", get_work_size_name(size), num_threads), N, [&]()
+            {
+                for (usize i = 0; i < N; ++i)
+                {
+                    WorkJob* job = (WorkJob*)new_job(work_job, sizeof(WorkJob), alignof(WorkJob));
+                    job->size = size;
+                    job->index = i;
+                    ids[i] = submit_job(job);
+                }
+                for (job_id_t id : ids) wait_job(id);
+            });
+            bench(get_bench_name(name, "submit_jobs+wait_job", get_work_size_name(size), num_threads), N, [&]()
+            {
+                for (usize i = 0; i < N; ++i)
+                {
+                    WorkJob* job = (WorkJob*)new_job(work_job, sizeof(WorkJob), alignof(WorkJob));
+                    job->size = size;
+                    job->index = i;
+                    jobs[i] = job;
+                }
+                submit_jobs({ jobs.data(), jobs.size() }, ids.data());
+                for (job_id_t id : ids) wait_job(id);
+            });
+        }
+    }
+
+    // Measures the time to finish one tree of jobs where every job spawns child jobs, so that most jobs are
+    // submitted by worker threads and distributed by stealing.
+    struct FanOutJob
+    {
+        u32 depth;
+        WorkSize size;
+    };
+    static void fan_out_job(void* params)
+    {
+        FanOutJob* job = (FanOutJob*)params;
+        if (!job->depth)
+        {
+            do_work(job->size, (usize)params);
+            return;
+        }
+        constexpr u32 FAN_OUT = 4;
+        job_id_t ids[FAN_OUT];
+        for (u32 i = 0; i < FAN_OUT; ++i)
+        {
+            FanOutJob* child = (FanOutJob*)new_job(fan_out_job, sizeof(FanOutJob), alignof(FanOutJob), params);
+            child->depth = job->depth - 1;
+            child->size = job->size;
+            ids[i] = submit_job(child);
+        }
+        for (u32 i = 0; i < FAN_OUT; ++i) wait_job(ids[i]);
+    }
+    static void fan_out_bench(u32 num_threads)
+    {
+        // 4^7 = 16384 leaf jobs.
+        constexpr u32 DEPTH = 7;
+        c8 name[64];
+        for (WorkSize size : { WorkSize::empty, WorkSize::tiny, WorkSize::mixed })
+        {
+            bench(get_bench_name(name, "recursive_fan_out", get_work_size_name(size), num_threads), 1 << (DEPTH * 2), [&]()
+            {
+                FanOutJob* root = (FanOutJob*)new_job(fan_out_job, sizeof(FanOutJob), alignof(FanOutJob));
+                root->depth = DEPTH;
+                root->size = size;
+                wait_job(submit_job(root));
+            });
+        }
+    }
+
+    static void latency_job(void* params)
+    {
+        // Parameters are released when the job finishes, so the time is written to the variable of the main thread.
+        u64 volatile* start_ticks = *(u64 volatile**)params;
+        *start_ticks = get_ticks();
+    }
+    // Measures the time from submitting one job on the main thread to the job being started by one worker.
+    // The main thread never executes the job since it waits by polling, so the job must be stolen by one worker.
+    // If `idle_ms` is not `0`, the main thread sleeps before every sample so that all workers are parked,
+    // which measures the wake-up latency. Otherwise, workers are still spinning when the job is submitted,
+    // which measures the steal latency.
+    // Every submission is one sample, so `num_samples` is used instead of `BenchOptions::repetitions`.
+    static void latency_bench(const c8* name, u32 num_threads, u32 idle_ms, u32 num_samples)
+    {
+        c8 bench_name[64];
+        if (!bench_enabled(get_bench_name(bench_name, name, "empty", num_threads))) return;
+        Vector<u64> samples;
+        for (u32 i = 0; i < num_samples; ++i)
+        {
+            if (idle_ms) sleep(idle_ms);
+            u64 volatile start_ticks = 0;
+            u64 volatile** params = (u64 volatile**)new_job(latency_job, sizeof(u64 volatile*), alignof(u64 volatile*));
+            *params = &start_ticks;
+            u64 begin = get_ticks();
+            job_id_t id = submit_job(params);
+            while (!is_job_finished(id)) {}
+            samples.push_back(start_ticks - begin);
+        }
+        bench_record(bench_name, 1, samples);
+    }
+
+    // Measures parallel_for over 100000 indices with the grain size computed by the job system.
+    static void parallel_for_bench(u32 num_threads)
+    {
+        constexpr usize N = 100000;
+        c8 name[64];
+        for (WorkSize size : { WorkSize::empty, WorkSize::tiny, WorkSize::mixed })
+        {
+            bench(get_bench_name(name, "parallel_for", get_work_size_name(size), num_threads), N, [size]()
+            {
+                parallel_for(0, N, 0, [size](usize i) { do_work(size, i); });
+            });
+        }
+    }
+
+    // Measures scaling with 1 to N participating threads in one process. One job is submitted for every
+    // participating thread except the main thread, and all threads take chunks of indices from one shared counter.
+    struct ScalingContext
+    {
+        WorkSize size;
+        usize count;
+        usize volatile next;
+        u32 volatile num_ready;
+        u32 num_participants;
+    };
+    static void run_scaling_loop(ScalingContext* ctx)
+    {
+        constexpr usize CHUNK = 64;
+        // Waits until all participants start, so that the measured time does not include the wake-up time of workers.
+        atom_inc_u32(&ctx->num_ready);
+        while (ctx->num_ready < ctx->num_participants) {}
+        while (true)
+        {
+            usize end = atom_add_usize(&ctx->next, CHUNK);
+            usize begin = end - CHUNK;
+            if (begin >= ctx->count) break;
+            end = min(end, ctx->count);
+            for (usize i = begin; i < end; ++i) do_work(ctx->size, i);
+        }
+    }
+    static void scaling_job(void* params)
+    {
+        run_scaling_loop(*(ScalingContext**)params);
+    }
+    static void scaling_bench(u32 num_threads)
+    {
+        constexpr usize N = 100000;
+        Vector<job_id_t> ids;
+        ScalingContext ctx;
+        c8 name[64];
+        for (WorkSize size : { WorkSize::tiny, WorkSize::mixed })
+        {
+            // Measures 1, 2, 4, ... participants, and always measures all threads.
+            for (u32 participants = 1; ; participants = min(participants * 2, num_threads))
+            {
+                auto setup = [&]()
+                {
+                    ctx.size = size;
+                    ctx.count = N;
+                    ctx.next = 0;
+                    ctx.num_ready = 0;
+                    ctx.num_participants = participants;
+                    ids.clear();
+                };
+                bench(get_bench_name(name, "shared_counter_scaling", get_work_size_name(size), participants), N, setup, [&]()
+                {
+                    for (u32 i = 1; i < participants; ++i)
+                    {
+                        ScalingContext** params = (ScalingContext**)new_job(scaling_job, sizeof(ScalingContext*), alignof(ScalingContext*));
+                        *params = &ctx;
+                        ids.push_back(submit_job(params));
+                    }
+                    run_scaling_loop(&ctx);
+                    for (job_id_t id : ids) wait_job(id);
+                });
+                if (participants == num_threads) break;
+            }
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    using namespace Luna;
+    Luna::init();
+    JobSystem::JobSystemConfig config;
+    auto& options = get_bench_options();
+    options.name = "JobSystemBench";
+    options.unit = "job";
+    options.warmup = 1;
+    options.repetitions = 10;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (parse_bench_option(argv[i], argv[i + 1])) continue;
+        if (!strcmp(argv[i], "--workers")) config.num_workers = (u32)atoi(argv[i + 1]);
+        else printf("Unknown option: %s\n", argv[i]);
+    }
+    JobSystem::set_config(config);
+    lupanic_if_failed(add_modules({module_job_system(), module_variant_utils()}));
+    lupanic_if_failed(init_modules());
+    u32 num_workers = 0;
+    for (auto& stats : JobSystem::get_worker_stats())
+    {
+        if (stats.is_worker && !stats.is_io_worker) ++num_workers;
+    }
+    // The main thread also executes jobs when waiting.
+    u32 num_threads = num_workers + 1;
+    printf("%u processors, %u workers.\n", get_processors_count(), num_workers);
+    submit_bench(num_threads);
+    fan_out_bench(num_threads);
+    if (num_workers)
+    {
+        latency_bench("steal latency", num_threads, 0, 1000);
+        latency_bench("wake-up latency", num_threads, 20, 100);
+    }
+    parallel_for_bench(num_threads);
+    scaling_bench(num_threads);
+    bench_report();
+    Luna::close();
+    return 0;
+}
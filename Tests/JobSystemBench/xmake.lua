@@ -0,0 +1,6 @@
+target("JobSystemBench")
+    set_luna_sdk_test()
+    set_kind("binary")
+    add_files("**.cpp")
+    add_deps("Runtime", "JobSystem", "VariantUtils", "BenchCommon")
+target_end()
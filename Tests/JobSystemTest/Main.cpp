@@ -9,9 +9,14 @@
 */
 #include <Luna/Runtime/Thread.hpp>
 #include <Luna/JobSystem/JobSystem.hpp>
+#include <Luna/JobSystem/Parallel.hpp>
 #include <Luna/Runtime/Time.hpp>
 #include <Luna/Runtime/Runtime.hpp>
 #include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+
+#define lutest luassert_always
 namespace Luna
 {
     using namespace JobSystem;
@@ -50,6 +55,37 @@ namespace Luna
         }
     }
 
+    static volatile u32 g_test_3_counter = 0;
+
+    static void test_func_3(void* params)
+    {
+        atom_inc_u32(&g_test_3_counter);
+    }
+
+    struct DependencyJob
+    {
+        u32* value;
+        u32 expected;
+    };
+
+    static void test_func_5(void* params)
+    {
+        DependencyJob* job = (DependencyJob*)params;
+        // Every job records the number of jobs that must be finished before it.
+        lutest(*job->value >= job->expected);
+        atom_inc_u32(job->value);
+    }
+
+    static void test_func_6(void* params)
+    {
+        // Simulates one blocking IO operation.
+        job_id_t gate = *(job_id_t*)params;
+        while (!is_job_finished(gate))
+        {
+            sleep(1);
+        }
+    }
+
     void job_system_test()
     {
         {
@@ -78,6 +114,157 @@ namespace Luna
             u64 end_time = get_ticks();
             printf("Jon System Test 1: %u levels of jobs finished in %f milliseconds.\n", RECURSIVE_DEPTH, (f64)(end_time - begin_time) / get_ticks_per_second() * 1000.0);
         }
+        {
+            constexpr usize N = 10000;
+            constexpr u32 FRAMES = 3;
+            Ref<IJobArena> arena = new_job_arena();
+            Vector<job_id_t> jobs;
+            jobs.reserve(N);
+            u64 begin_time = get_ticks();
+            for (u32 frame = 0; frame < FRAMES; ++frame)
+            {
+                for (usize i = 0; i < N; ++i)
+                {
+                    void* job = new_job(arena, test_func_3, 0, 0);
+                    jobs.push_back(submit_job(job));
+                }
+                for (job_id_t job : jobs)
+                {
+                    wait_job(job);
+                }
+                jobs.clear();
+                arena->reset();
+            }
+            u64 end_time = get_ticks();
+            lutest(g_test_3_counter == N * FRAMES);
+            printf("Jon System Test 3: %u arena jobs finished in %f milliseconds.\n", (u32)(N * FRAMES), (f64)(end_time - begin_time) / get_ticks_per_second() * 1000.0);
+        }
+        {
+            constexpr usize N = 1000000;
+            Vector<u32> values(N, 0);
+            u64 begin_time = get_ticks();
+            parallel_for(0, N, 0, [&](usize i) { values[i] = (u32)i; });
+            u64 sum = parallel_reduce(0, N, 1024, (u64)0,
+                [&](usize i) { return (u64)values[i]; },
+                [](u64 a, u64 b) { return a + b; });
+            u64 end_time = get_ticks();
+            lutest(sum == (u64)N * (N - 1) / 2);
+            printf("Jon System Test 4: parallel for and reduce of %u elements finished in %f milliseconds.\n", (u32)N, (f64)(end_time - begin_time) / get_ticks_per_second() * 1000.0);
+        }
+        {
+            // Builds one diamond-shaped dependency graph: A -> (B, C) -> D.
+            constexpr u32 ROUNDS = 1000;
+            u64 begin_time = get_ticks();
+            for (u32 i = 0; i < ROUNDS; ++i)
+            {
+                u32 value = 0;
+                job_id_t gate = allocate_job_id();
+                DependencyJob* a = (DependencyJob*)new_job(test_func_5, sizeof(DependencyJob), alignof(DependencyJob));
+                a->value = &value;
+                a->expected = 0;
+                job_id_t a_id = submit_job(a, { &gate, 1 });
+                DependencyJob* b = (DependencyJob*)new_job(test_func_5, sizeof(DependencyJob), alignof(DependencyJob));
+                b->value = &value;
+                b->expected = 1;
+                job_id_t b_id = submit_job(b, { &a_id, 1 });
+                DependencyJob* c = (DependencyJob*)new_job(test_func_5, sizeof(DependencyJob), alignof(DependencyJob));
+                c->value = &value;
+                c->expected = 1;
+                job_id_t c_id = submit_job(c, { &a_id, 1 });
+                DependencyJob* d = (DependencyJob*)new_job(test_func_5, sizeof(DependencyJob), alignof(DependencyJob));
+                d->value = &value;
+                d->expected = 3;
+                job_id_t bc_ids[] = { b_id, c_id };
+                job_id_t d_id = submit_job(d, { bc_ids, 2 });
+                // None of the jobs can be run before the gate is opened.
+                lutest(value == 0);
+                finish_job_id(gate);
+                wait_job(d_id);
+                lutest(value == 4);
+            }
+            u64 end_time = get_ticks();
+            printf("Jon System Test 5: %u dependency graphs finished in %f milliseconds.\n", ROUNDS, (f64)(end_time - begin_time) / get_ticks_per_second() * 1000.0);
+        }
+        {
+            // IO jobs are run by IO workers, so normal jobs can be finished while IO jobs are blocked.
+            job_id_t gate = allocate_job_id();
+            job_id_t io_jobs[2];
+            for (auto& id : io_jobs)
+            {
+                job_id_t* params = (job_id_t*)new_job(test_func_6, sizeof(job_id_t), alignof(job_id_t));
+                *params = gate;
+                id = submit_job(params, JobPriority::io);
+            }
+            job_id_t high_job = submit_job(new_job(test_func_3, 0, 0), JobPriority::high);
+            job_id_t background_job = submit_job(new_job(test_func_3, 0, 0), JobPriority::background);
+            wait_job(high_job);
+            wait_job(background_job);
+            lutest(!is_job_finished(io_jobs[0]) && !is_job_finished(io_jobs[1]));
+            finish_job_id(gate);
+            wait_job(io_jobs[0]);
+            wait_job(io_jobs[1]);
+            printf("Jon System Test 6: IO jobs finished.\n");
+        }
+        {
+            constexpr usize N = 10000;
+            u32 counter = g_test_3_counter;
+            Vector<void*> jobs(N, nullptr);
+            Vector<job_id_t> ids(N, INVALID_JOB_ID);
+            u64 begin_time = get_ticks();
+            for (usize i = 0; i < N; ++i)
+            {
+                jobs[i] = new_job(test_func_3, 0, 0);
+            }
+            submit_jobs({ jobs.data(), jobs.size() }, ids.data());
+            for (job_id_t id : ids)
+            {
+                wait_job(id);
+            }
+            u64 end_time = get_ticks();
+            lutest(g_test_3_counter == counter + N);
+            printf("Jon System Test 7: %u batched jobs finished in %f milliseconds.\n", (u32)N, (f64)(end_time - begin_time) / get_ticks_per_second() * 1000.0);
+        }
+        {
+            constexpr usize N = 1000;
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+            volatile u32 num_begin_events = 0;
+            usize handler = register_profiler_callback([&](const ProfilerEvent& e) {
+                if (e.id == JobSystem::ProfilerEventId::JOB_BEGIN && ((const JobSystem::ProfilerEventData::JobBegin*)e.data)->name)
+                {
+                    atom_inc_u32(&num_begin_events);
+                }
+            });
+#endif
+            u64 num_jobs_executed = 0;
+            for (auto& stats : get_worker_stats())
+            {
+                num_jobs_executed += stats.num_jobs_executed;
+            }
+            Vector<job_id_t> jobs(N, INVALID_JOB_ID);
+            for (usize i = 0; i < N; ++i)
+            {
+                void* job = new_job(test_func_3, 0, 0);
+                set_job_name(job, "Test Job");
+                jobs[i] = submit_job(job);
+            }
+            for (job_id_t job : jobs)
+            {
+                wait_job(job);
+            }
+            u64 num_jobs_executed_after = 0;
+            u64 busy_ticks = 0;
+            for (auto& stats : get_worker_stats())
+            {
+                num_jobs_executed_after += stats.num_jobs_executed;
+                busy_ticks += stats.busy_ticks;
+            }
+            lutest(num_jobs_executed_after >= num_jobs_executed + N);
+#ifdef LUNA_JOB_SYSTEM_PROFILER_ENABLED
+            unregister_profiler_callback(handler);
+            lutest(num_begin_events == N);
+#endif
+            printf("Jon System Test 8: %llu jobs executed, %f milliseconds spent on executing jobs.\n", num_jobs_executed_after, (f64)busy_ticks / get_ticks_per_second() * 1000.0);
+        }
     }
 }
 
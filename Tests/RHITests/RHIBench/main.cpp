@@ -0,0 +1,594 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file main.cpp
+* @author JXMaster
+* @date 2024/5/16
+*/
+#include "../RHITestBed/RHITestBed.hpp"
+#include <Luna/Runtime/Runtime.hpp>
+#include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/Time.hpp>
+#include <Luna/Runtime/Math/Color.hpp>
+#include <Luna/ShaderCompiler/ShaderCompiler.hpp>
+#include <Luna/RHI/ShaderCompileHelper.hpp>
+#include <Luna/RG/RG.hpp>
+#include <Luna/RG/RenderGraph.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
+#include "../../BenchCommon/BenchCommon.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Usage: RHIBench [--frames <count>] [common benchmark options, see `parse_bench_option`]
+// Runs every scenario for `warmup` frames and `repetitions` measured frames (`--frames` is one alias of `--repetitions`)
+// in the RHI test bed window, then closes the window and reports the CPU recording time ("<scenario>/cpu") and GPU
+// execution time ("<scenario>/gpu") of every scenario on the backend this program is built with.
+// Run the program once for every backend to compare backends.
+
+using namespace Luna;
+using namespace Luna::RHI;
+using namespace Luna::RHITestBed;
+
+constexpr u32 NUM_DRAW_CALLS = 100000;
+constexpr u32 NUM_DESCRIPTOR_SETS = 1000;
+constexpr u32 NUM_BARRIER_BUFFERS = 256;
+constexpr u32 NUM_BARRIER_ROUNDS = 16;
+constexpr u32 BARRIER_COPY_SIZE = 256;
+constexpr u32 NUM_MAP_BUFFERS = 64;
+constexpr u32 MAP_BUFFER_SIZE = 64 * 1024;
+constexpr u32 NUM_RG_PASSES = 64;
+constexpr u32 RG_TEXTURE_SIZE = 256;
+
+// Specifies how the GPU time of one scenario is measured.
+enum class GPUTiming : u8
+{
+    // The scenario does not record GPU work that can be measured.
+    none,
+    // The scenario writes the beginning and ending timestamps to index 0 and 1 of `g_query_heap`.
+    timestamps,
+    // The scenario executes `g_render_graph` with time profiling enabled.
+    render_graph,
+};
+
+struct Scenario
+{
+    const c8* name;
+    RV(*record)(ICommandBuffer* cmdbuf);
+    GPUTiming gpu_timing;
+    // In CPU ticks.
+    Vector<u64> cpu_samples;
+    // In GPU ticks.
+    Vector<u64> gpu_samples;
+    bool failed = false;
+};
+
+Vector<Scenario> g_scenarios;
+usize g_current_scenario = 0;
+u32 g_current_frame = 0;
+// The scenario whose GPU time of the last frame should be read. The test bed waits for the command buffer
+// to finish before the next frame, so the result is ready at the beginning of the next frame.
+usize g_gpu_pending_scenario = USIZE_MAX;
+f64 g_timestamp_frequency = 0.0;
+
+Ref<IQueryHeap> g_query_heap;
+
+Ref<IPipelineLayout> g_draw_playout;
+Ref<IPipelineState> g_draw_pso;
+
+Ref<IDescriptorSetLayout> g_dlayout;
+Ref<IBuffer> g_cb;
+Ref<IDescriptorSetArena> g_descriptor_set_arena;
+
+Vector<Ref<IBuffer>> g_barrier_buffers;
+Vector<BufferBarrier> g_barriers;
+BufferStateFlag g_barrier_buffer_state = BufferStateFlag::automatic;
+Ref<IBuffer> g_barrier_src;
+Ref<IBuffer> g_barrier_dst;
+
+Vector<Ref<IBuffer>> g_map_buffers;
+Vector<byte_t> g_map_data;
+
+Ref<RG::IRenderGraph> g_render_graph;
+RG::RenderGraphDesc g_render_graph_desc;
+
+// One render graph pass that clears its output texture, and reads its input texture (if any) so that
+// the render graph inserts one barrier between two succeeding passes.
+struct BenchFillPass : RG::IRenderPass
+{
+    lustruct("RHIBench::BenchFillPass", "{3b3f8a0e-0d6c-4a8e-9f3e-2e6b7c4d1a95}");
+    luiimpl();
+
+    RV execute(RG::IRenderPassContext* ctx) override
+    {
+        lutry
+        {
+            auto cmdbuf = ctx->get_command_buffer();
+            Ref<ITexture> dst = query_interface<ITexture>(ctx->get_output("dst")->get_object());
+            RenderPassDesc desc;
+            desc.color_attachments[0] = ColorAttachment(dst, LoadOp::clear, ctx->get_attachment_store_op("dst"), Color::blue());
+            u32 time_query_begin, time_query_end;
+            auto query_heap = ctx->get_timestamp_query_heap(&time_query_begin, &time_query_end);
+            if (query_heap)
+            {
+                desc.timestamp_query_heap = query_heap;
+                desc.timestamp_query_begin_pass_write_index = time_query_begin;
+                desc.timestamp_query_end_pass_write_index = time_query_end;
+            }
+            cmdbuf->begin_render_pass(desc);
+            cmdbuf->end_render_pass();
+        }
+        lucatchret;
+        return ok;
+    }
+};
+
+RV compile_bench_fill_pass(object_t userdata, RG::IRenderGraphCompiler* compiler)
+{
+    auto dst = compiler->get_output_resource("dst");
+    if (dst == RG::INVALID_RESOURCE) return set_error(BasicError::bad_arguments(), "BenchFillPass: Output \"dst\" is not specified.");
+    RG::ResourceDesc desc = compiler->get_resource_desc(dst);
+    desc.texture.usages |= TextureUsageFlag::color_attachment;
+    compiler->set_resource_desc(dst, desc);
+    Ref<BenchFillPass> pass = new_object<BenchFillPass>();
+    compiler->set_render_pass_object(pass);
+    return ok;
+}
+
+RV init_draw_scenario(IDevice* device)
+{
+    lutry
+    {
+        // The vertex shader generates one small triangle from the vertex ID, so that no vertex buffer is needed
+        // and the GPU time is dominated by draw call overhead rather than rasterization.
+        const char vs_shader_code[] =
+            R"(
+            struct PS_INPUT
+            {
+                [[vk::location(0)]]
+                float4 pos : SV_POSITION;
+            };
+            PS_INPUT main(uint vertex_id : SV_VertexID)
+            {
+                PS_INPUT output;
+                float2 uv = float2((vertex_id << 1) & 2, vertex_id & 2);
+                output.pos = float4(uv * 0.01f - 0.5f, 0.0f, 1.0f);
+                return output;
+            })";
+        auto compiler = ShaderCompiler::new_compiler();
+        ShaderCompiler::ShaderCompileParameters params;
+        params.source = { vs_shader_code, sizeof(vs_shader_code) };
+        params.source_name = "RHIBenchVS";
+        params.entry_point = "main";
+        params.target_format = RHI::get_current_platform_shader_target_format();
+        params.shader_type = ShaderCompiler::ShaderType::vertex;
+        params.shader_model = {6, 0};
+        params.optimization_level = ShaderCompiler::OptimizationLevel::full;
+        lulet(vs_data, compiler->compile(params));
+
+        const char ps_shader_code[] =
+            R"(
+            struct PS_INPUT
+            {
+                [[vk::location(0)]]
+                float4 pos : SV_POSITION;
+            };
+            [[vk::location(0)]]
+            float4 main(PS_INPUT input) : SV_Target
+            {
+                return float4(1.0f, 0.0f, 0.0f, 1.0f);
+            })";
+        params.source = { ps_shader_code, sizeof(ps_shader_code) };
+        params.source_name = "RHIBenchPS";
+        params.shader_type = ShaderCompiler::ShaderType::pixel;
+        lulet(ps_data, compiler->compile(params));
+
+        luset(g_draw_playout, device->new_pipeline_layout(PipelineLayoutDesc({},
+            PipelineLayoutFlag::deny_pixel_shader_access |
+            PipelineLayoutFlag::deny_vertex_shader_access)));
+        GraphicsPipelineStateDesc desc;
+        desc.pipeline_layout = g_draw_playout;
+        desc.vs = get_shader_data_from_compile_result(vs_data);
+        desc.ps = get_shader_data_from_compile_result(ps_data);
+        desc.rasterizer_state.depth_clip_enable = false;
+        desc.depth_stencil_state = DepthStencilDesc(false, false);
+        desc.num_color_attachments = 1;
+        desc.color_formats[0] = Format::bgra8_unorm;
+        luset(g_draw_pso, device->new_graphics_pipeline_state(desc));
+    }
+    lucatchret;
+    return ok;
+}
+
+RV init_render_graph_scenario(IDevice* device)
+{
+    lutry
+    {
+        register_boxed_type<BenchFillPass>();
+        impl_interface_for_type<BenchFillPass, RG::IRenderPass>();
+        RG::RenderPassTypeDesc pass_type;
+        pass_type.name = "BenchFill";
+        pass_type.desc = "Clears the output texture.";
+        pass_type.input_parameters.push_back({"src", "The texture written by the last pass.", TextureStateFlag::shader_read_ps});
+        pass_type.output_parameters.push_back({"dst", "The texture to clear.", TextureStateFlag::color_attachment_write, BufferStateFlag::automatic, true});
+        pass_type.compile = compile_bench_fill_pass;
+        RG::register_render_pass_type(pass_type);
+
+        // Builds one chain of passes, every pass writes one transient texture and reads the texture of the last pass.
+        auto& desc = g_render_graph_desc;
+        c8 name[32];
+        for (u32 i = 0; i < NUM_RG_PASSES; ++i)
+        {
+            snprintf(name, 32, "Pass%u", i);
+            desc.passes.push_back({Name(name), Name("BenchFill")});
+            snprintf(name, 32, "Texture%u", i);
+            desc.resources.push_back({RG::RenderGraphResourceType::transient,
+                i == NUM_RG_PASSES - 1 ? RG::RenderGraphResourceFlag::output : RG::RenderGraphResourceFlag::none, Name(name),
+                RG::ResourceDesc::as_texture(MemoryType::local, TextureDesc::tex2d(Format::rgba8_unorm,
+                    TextureUsageFlag::read_texture | TextureUsageFlag::color_attachment, RG_TEXTURE_SIZE, RG_TEXTURE_SIZE, 1, 1))});
+            desc.output_connections.push_back({i, Name("dst"), i});
+            if (i) desc.input_connections.push_back({i, Name("src"), i - 1});
+        }
+        g_render_graph = RG::new_render_graph(device);
+        g_render_graph->set_desc(desc);
+        RG::RenderGraphCompileConfig config;
+        config.enable_time_profiling = true;
+        luexp(g_render_graph->compile(config));
+    }
+    lucatchret;
+    return ok;
+}
+
+RV record_draw_calls(ICommandBuffer* cmdbuf)
+{
+    auto back_buffer = get_back_buffer();
+    cmdbuf->resource_barrier({}, {
+            {back_buffer, TEXTURE_BARRIER_ALL_SUBRESOURCES, TextureStateFlag::automatic, TextureStateFlag::color_attachment_write, ResourceBarrierFlag::discard_content}
+        });
+    RenderPassDesc desc;
+    desc.color_attachments[0] = ColorAttachment(back_buffer, LoadOp::clear, StoreOp::store, Color::black());
+    desc.timestamp_query_heap = g_query_heap;
+    desc.timestamp_query_begin_pass_write_index = 0;
+    desc.timestamp_query_end_pass_write_index = 1;
+    cmdbuf->begin_render_pass(desc);
+    cmdbuf->set_graphics_pipeline_layout(g_draw_playout);
+    cmdbuf->set_graphics_pipeline_state(g_draw_pso);
+    auto sz = get_window()->get_framebuffer_size();
+    cmdbuf->set_viewport(Viewport(0, 0, (f32)sz.x, (f32)sz.y, 0.0f, 1.0f));
+    cmdbuf->set_scissor_rect(RectI(0, 0, (i32)sz.x, (i32)sz.y));
+    for (u32 i = 0; i < NUM_DRAW_CALLS; ++i)
+    {
+        cmdbuf->draw(3, 0);
+    }
+    cmdbuf->end_render_pass();
+    return ok;
+}
+
+RV record_descriptor_sets(ICommandBuffer* cmdbuf)
+{
+    lutry
+    {
+        auto device = cmdbuf->get_device();
+        for (u32 i = 0; i < NUM_DESCRIPTOR_SETS; ++i)
+        {
+            lulet(ds, device->new_descriptor_set(DescriptorSetDesc(g_dlayout)));
+            luexp(ds->update_descriptors({
+                WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(g_cb, 0, 256))
+            }));
+            // Keeps the descriptor set alive until the command buffer is reset, like descriptor sets that are bound.
+            cmdbuf->attach_device_object(ds);
+        }
+    }
+    lucatchret;
+    return ok;
+}
+
+RV record_descriptor_set_arena(ICommandBuffer* cmdbuf)
+{
+    lutry
+    {
+        // The command buffer of the last frame is finished here, so descriptor sets of the last frame can be freed.
+        g_descriptor_set_arena->reset();
+        for (u32 i = 0; i < NUM_DESCRIPTOR_SETS; ++i)
+        {
+            lulet(ds, g_descriptor_set_arena->new_descriptor_set(DescriptorSetDesc(g_dlayout)));
+            luexp(ds->update_descriptors({
+                WriteDescriptorSet::uniform_buffer_view(0, BufferViewDesc::uniform_buffer(g_cb, 0, 256))
+            }));
+        }
+    }
+    lucatchret;
+    return ok;
+}
+
+void transition_barrier_buffers(ICommandBuffer* cmdbuf, BufferStateFlag after)
+{
+    for (u32 i = 0; i < NUM_BARRIER_BUFFERS; ++i)
+    {
+        g_barriers[i] = BufferBarrier(g_barrier_buffers[i], g_barrier_buffer_state, after);
+    }
+    cmdbuf->resource_barrier({g_barriers.data(), g_barriers.size()}, {});
+    g_barrier_buffer_state = after;
+}
+
+RV record_barriers(ICommandBuffer* cmdbuf)
+{
+    // Barriers are deferred and merged by the command buffer until the next command is recorded, so every batch of barriers
+    // is followed by one copy pass that uses all buffers.
+    cmdbuf->resource_barrier({
+        {g_barrier_dst, BufferStateFlag::automatic, BufferStateFlag::copy_dest}
+    }, {});
+    for (u32 round = 0; round < NUM_BARRIER_ROUNDS; ++round)
+    {
+        transition_barrier_buffers(cmdbuf, BufferStateFlag::copy_dest);
+        CopyPassDesc desc;
+        if (round == 0)
+        {
+            desc.timestamp_query_heap = g_query_heap;
+            desc.timestamp_query_begin_pass_write_index = 0;
+        }
+        cmdbuf->begin_copy_pass(desc);
+        for (u32 i = 0; i < NUM_BARRIER_BUFFERS; ++i)
+        {
+            cmdbuf->copy_buffer(g_barrier_buffers[i], 0, g_barrier_src, 0, BARRIER_COPY_SIZE);
+        }
+        cmdbuf->end_copy_pass();
+        transition_barrier_buffers(cmdbuf, BufferStateFlag::copy_source);
+        desc = CopyPassDesc();
+        if (round == NUM_BARRIER_ROUNDS - 1)
+        {
+            desc.timestamp_query_heap = g_query_heap;
+            desc.timestamp_query_end_pass_write_index = 1;
+        }
+        cmdbuf->begin_copy_pass(desc);
+        for (u32 i = 0; i < NUM_BARRIER_BUFFERS; ++i)
+        {
+            cmdbuf->copy_buffer(g_barrier_dst, i * BARRIER_COPY_SIZE, g_barrier_buffers[i], 0, BARRIER_COPY_SIZE);
+        }
+        cmdbuf->end_copy_pass();
+    }
+    return ok;
+}
+
+RV record_map_unmap(ICommandBuffer* cmdbuf)
+{
+    lutry
+    {
+        for (auto& buf : g_map_buffers)
+        {
+            void* mapped = nullptr;
+            luexp(buf->map(0, 0, &mapped));
+            memcpy(mapped, g_map_data.data(), MAP_BUFFER_SIZE);
+            buf->unmap(0, MAP_BUFFER_SIZE);
+        }
+    }
+    lucatchret;
+    return ok;
+}
+
+RV record_render_graph_compile(ICommandBuffer* cmdbuf)
+{
+    g_render_graph->set_desc(g_render_graph_desc);
+    RG::RenderGraphCompileConfig config;
+    config.enable_time_profiling = true;
+    return g_render_graph->compile(config);
+}
+
+RV record_render_graph_execute(ICommandBuffer* cmdbuf)
+{
+    return g_render_graph->execute(cmdbuf);
+}
+
+RV start()
+{
+    lutry
+    {
+        auto device = get_main_device();
+        luset(g_timestamp_frequency, device->get_command_queue_timestamp_frequency(get_command_queue_index()));
+        luset(g_query_heap, device->new_query_heap(QueryHeapDesc(QueryType::timestamp, 2)));
+
+        luexp(init_draw_scenario(device));
+
+        DescriptorSetLayoutBinding binding = DescriptorSetLayoutBinding::uniform_buffer_view(0, 1, ShaderVisibilityFlag::vertex);
+        luset(g_dlayout, device->new_descriptor_set_layout(DescriptorSetLayoutDesc({&binding, 1})));
+        luset(g_cb, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::uniform_buffer, 256)));
+        luset(g_descriptor_set_arena, device->new_descriptor_set_arena());
+
+        g_barrier_buffers.reserve(NUM_BARRIER_BUFFERS);
+        for (u32 i = 0; i < NUM_BARRIER_BUFFERS; ++i)
+        {
+            lulet(buf, device->new_buffer(MemoryType::local, BufferDesc(BufferUsageFlag::copy_source | BufferUsageFlag::copy_dest, BARRIER_COPY_SIZE)));
+            g_barrier_buffers.push_back(move(buf));
+        }
+        g_barriers.resize(NUM_BARRIER_BUFFERS);
+        luset(g_barrier_src, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::copy_source, BARRIER_COPY_SIZE)));
+        luset(g_barrier_dst, device->new_buffer(MemoryType::local, BufferDesc(BufferUsageFlag::copy_dest, (u64)BARRIER_COPY_SIZE * NUM_BARRIER_BUFFERS)));
+
+        g_map_buffers.reserve(NUM_MAP_BUFFERS);
+        for (u32 i = 0; i < NUM_MAP_BUFFERS; ++i)
+        {
+            lulet(buf, device->new_buffer(MemoryType::upload, BufferDesc(BufferUsageFlag::copy_source, MAP_BUFFER_SIZE)));
+            g_map_buffers.push_back(move(buf));
+        }
+        g_map_data.resize(MAP_BUFFER_SIZE);
+        for (u32 i = 0; i < MAP_BUFFER_SIZE; ++i) g_map_data[i] = (byte_t)i;
+
+        luexp(init_render_graph_scenario(device));
+
+        g_scenarios.push_back({"draw calls (100k)", record_draw_calls, GPUTiming::timestamps});
+        g_scenarios.push_back({"new_descriptor_set (1k)", record_descriptor_sets, GPUTiming::none});
+        g_scenarios.push_back({"descriptor set arena (1k)", record_descriptor_set_arena, GPUTiming::none});
+        g_scenarios.push_back({"buffer barriers (256x32)", record_barriers, GPUTiming::timestamps});
+        g_scenarios.push_back({"map/unmap (64x64KB)", record_map_unmap, GPUTiming::none});
+        g_scenarios.push_back({"render graph compile (64 passes)", record_render_graph_compile, GPUTiming::none});
+        g_scenarios.push_back({"render graph execute (64 passes)", record_render_graph_execute, GPUTiming::render_graph});
+        // Drops scenarios that are not selected by `--filter`.
+        for (usize i = g_scenarios.size(); i > 0; --i)
+        {
+            if (!bench_enabled(g_scenarios[i - 1].name)) g_scenarios.erase(g_scenarios.begin() + (i - 1));
+        }
+    }
+    lucatchret;
+    return ok;
+}
+
+void collect_gpu_time()
+{
+    Scenario& scenario = g_scenarios[g_gpu_pending_scenario];
+    g_gpu_pending_scenario = USIZE_MAX;
+    if (scenario.gpu_timing == GPUTiming::timestamps)
+    {
+        u64 timestamps[2];
+        if (succeeded(g_query_heap->get_timestamp_values(0, 2, timestamps)) && timestamps[1] >= timestamps[0])
+        {
+            scenario.gpu_samples.push_back(timestamps[1] - timestamps[0]);
+        }
+    }
+    else if (scenario.gpu_timing == GPUTiming::render_graph)
+    {
+        Vector<u64> intervals;
+        if (succeeded(g_render_graph->get_pass_time_intervals(intervals)))
+        {
+            u64 sum = 0;
+            for (u64 i : intervals) sum += i;
+            scenario.gpu_samples.push_back(sum);
+        }
+    }
+}
+
+void next_scenario()
+{
+    ++g_current_scenario;
+    g_current_frame = 0;
+    if (g_current_scenario >= g_scenarios.size())
+    {
+        get_window()->close();
+    }
+}
+
+void draw()
+{
+    if (g_gpu_pending_scenario != USIZE_MAX) collect_gpu_time();
+    if (g_current_scenario >= g_scenarios.size())
+    {
+        // Happens only if no scenario is selected.
+        get_window()->close();
+        return;
+    }
+    Scenario& scenario = g_scenarios[g_current_scenario];
+    auto cmdbuf = get_command_buffer();
+    u64 begin = get_ticks();
+    auto r = scenario.record(cmdbuf);
+    u64 cpu_time = get_ticks() - begin;
+    if (failed(r))
+    {
+        log_error("RHIBench", "Scenario %s failed: %s", scenario.name, explain(r.errcode()));
+        scenario.failed = true;
+        next_scenario();
+        return;
+    }
+    auto& options = get_bench_options();
+    if (g_current_frame >= options.warmup)
+    {
+        scenario.cpu_samples.push_back(cpu_time);
+        if (scenario.gpu_timing != GPUTiming::none) g_gpu_pending_scenario = g_current_scenario;
+    }
+    ++g_current_frame;
+    if (g_current_frame >= options.warmup + options.repetitions) next_scenario();
+}
+
+void resize(u32 width, u32 height)
+{
+}
+
+const c8* get_backend_name()
+{
+    switch (get_backend_type())
+    {
+    case BackendType::d3d12: return "D3D12";
+    case BackendType::vulkan: return "Vulkan";
+    case BackendType::metal: return "Metal";
+    default: lupanic(); return "";
+    }
+}
+
+void report()
+{
+    printf("Backend: %s\n", get_backend_name());
+    f64 cpu_frequency = get_ticks_per_second();
+    c8 name[128];
+    for (auto& scenario : g_scenarios)
+    {
+        if (scenario.failed) continue;
+        snprintf(name, 128, "%s/cpu", scenario.name);
+        bench_record(name, 1, scenario.cpu_samples);
+        if (scenario.gpu_samples.empty() || g_timestamp_frequency <= 0.0) continue;
+        // GPU samples are converted to CPU ticks, which are the unit of `bench_record`.
+        for (u64& sample : scenario.gpu_samples)
+        {
+            sample = (u64)(sample * cpu_frequency / g_timestamp_frequency);
+        }
+        snprintf(name, 128, "%s/gpu", scenario.name);
+        bench_record(name, 1, scenario.gpu_samples);
+    }
+    bench_report();
+}
+
+void cleanup()
+{
+    // The command buffer of the last frame is finished when the test bed closes.
+    if (g_gpu_pending_scenario != USIZE_MAX) collect_gpu_time();
+    report();
+    g_scenarios.clear();
+    g_render_graph.reset();
+    g_render_graph_desc = RG::RenderGraphDesc();
+    g_map_buffers.clear();
+    g_map_data.clear();
+    g_barriers.clear();
+    g_barrier_buffers.clear();
+    g_barrier_src.reset();
+    g_barrier_dst.reset();
+    g_descriptor_set_arena.reset();
+    g_cb.reset();
+    g_dlayout.reset();
+    g_draw_pso.reset();
+    g_draw_playout.reset();
+    g_query_heap.reset();
+}
+
+void run_app()
+{
+    register_init_func(start);
+    register_close_func(cleanup);
+    register_resize_func(resize);
+    register_draw_func(draw);
+    lupanic_if_failed(run());
+}
+
+int main(int argc, const char* argv[])
+{
+    auto& options = get_bench_options();
+    options.name = "RHIBench";
+    options.unit = "frame";
+    options.warmup = 16;
+    options.repetitions = 128;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (parse_bench_option(argv[i], argv[i + 1])) continue;
+        if (!strcmp(argv[i], "--frames")) options.repetitions = (u32)max(atoi(argv[i + 1]), 1);
+        else printf("Unknown option: %s\n", argv[i]);
+    }
+    if (!Luna::init()) return 0;
+    lupanic_if_failed(add_modules({module_rhi_test_bed(), module_shader_compiler(), module_rg(), module_variant_utils()}));
+    auto r = init_modules();
+    if (failed(r))
+    {
+        log_error("RHIBench", "%s", explain(r.errcode()));
+    }
+    else run_app();
+    Luna::close();
+    return 0;
+}
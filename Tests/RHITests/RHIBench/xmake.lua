@@ -0,0 +1,7 @@
+target("RHIBench")
+    add_luna_sdk_options()
+    set_group("Tests/RHITest")
+    set_kind("binary")
+    add_files("*.cpp")
+    add_deps("Runtime", "RHI", "RHITestBed", "ShaderCompiler", "RG", "VariantUtils", "BenchCommon")
+target_end()
\ No newline at end of file
@@ -3,4 +3,5 @@ includes("RHITest0_Empty")
 includes("RHITest1_FillBackBuffer")
 includes("RHITest2_Triangle")
 includes("RHITest3_Texture")
-includes("RHITest4_Box")
\ No newline at end of file
+includes("RHITest4_Box")
+includes("RHIBench")
\ No newline at end of file
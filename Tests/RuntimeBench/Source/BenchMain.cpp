@@ -0,0 +1,36 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BenchMain.cpp
+* @author JXMaster
+* @date 2024/5/14
+*/
+#include "RuntimeBench.hpp"
+#include <Luna/Runtime/Module.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
+#include <stdio.h>
+using namespace Luna;
+
+// Usage: RuntimeBench [--filter <name>] [--repetitions <count>] [--warmup <count>] [--json <path>]
+int main(int argc, char** argv)
+{
+    Luna::init();
+    lupanic_if_failed(add_modules({module_variant_utils()}));
+    lupanic_if_failed(init_modules());
+    auto& options = get_bench_options();
+    options.name = "RuntimeBench";
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!parse_bench_option(argv[i], argv[i + 1])) printf("Unknown option: %s\n", argv[i]);
+    }
+    container_bench();
+    hash_bench();
+    name_bench();
+    memory_bench();
+    variant_bench();
+    bench_report();
+    Luna::close();
+    return 0;
+}
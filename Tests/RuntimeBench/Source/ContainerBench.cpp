@@ -0,0 +1,121 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file ContainerBench.cpp
+* @author JXMaster
+* @date 2024/5/14
+*/
+#include "RuntimeBench.hpp"
+#include <Luna/Runtime/HashMap.hpp>
+#include <Luna/Runtime/UnorderedMap.hpp>
+#include <Luna/Runtime/RingDeque.hpp>
+
+namespace Luna
+{
+    constexpr usize CONTAINER_BENCH_SIZE = 100000;
+
+    static void vector_bench()
+    {
+        bench("Vector::push_back", CONTAINER_BENCH_SIZE, []()
+        {
+            Vector<u64> v;
+            for (usize i = 0; i < CONTAINER_BENCH_SIZE; ++i) v.push_back(i);
+            bench_keep(v.size());
+        });
+        bench("Vector::push_back (reserved)", CONTAINER_BENCH_SIZE, []()
+        {
+            Vector<u64> v;
+            v.reserve(CONTAINER_BENCH_SIZE);
+            for (usize i = 0; i < CONTAINER_BENCH_SIZE; ++i) v.push_back(i);
+            bench_keep(v.size());
+        });
+        Vector<u64> data;
+        data.resize(CONTAINER_BENCH_SIZE);
+        for (usize i = 0; i < CONTAINER_BENCH_SIZE; ++i) data[i] = i;
+        bench("Vector::iterate", CONTAINER_BENCH_SIZE, [&]()
+        {
+            u64 sum = 0;
+            for (u64 v : data) sum += v;
+            bench_keep((usize)sum);
+        });
+        bench("Vector::insert (front)", 1000, []()
+        {
+            Vector<u64> v;
+            for (usize i = 0; i < 1000; ++i) v.insert(v.begin(), i);
+            bench_keep(v.size());
+        });
+    }
+
+    template <typename _Map>
+    static void map_bench(const c8* insert_name, const c8* find_name, const c8* miss_name, const c8* erase_name)
+    {
+        Vector<u64> keys;
+        keys.reserve(CONTAINER_BENCH_SIZE);
+        BenchRandom random;
+        for (usize i = 0; i < CONTAINER_BENCH_SIZE; ++i) keys.push_back(random.next());
+        bench(insert_name, CONTAINER_BENCH_SIZE, [&]()
+        {
+            _Map map;
+            for (u64 k : keys) map.insert(make_pair(k, k));
+            bench_keep(map.size());
+        });
+        _Map map;
+        for (u64 k : keys) map.insert(make_pair(k, k));
+        bench(find_name, CONTAINER_BENCH_SIZE, [&]()
+        {
+            usize found = 0;
+            for (u64 k : keys) found += map.find(k) != map.end() ? 1 : 0;
+            bench_keep(found);
+        });
+        bench(miss_name, CONTAINER_BENCH_SIZE, [&]()
+        {
+            usize found = 0;
+            // Flipping the lowest bit almost never produces one existing key.
+            for (u64 k : keys) found += map.find(k ^ 1) != map.end() ? 1 : 0;
+            bench_keep(found);
+        });
+        bench(erase_name, CONTAINER_BENCH_SIZE, [&]()
+        {
+            _Map m = map;
+            usize erased = 0;
+            for (u64 k : keys) erased += m.erase(k);
+            bench_keep(erased);
+        });
+    }
+
+    static void ring_deque_bench()
+    {
+        bench("RingDeque::push_back", CONTAINER_BENCH_SIZE, []()
+        {
+            RingDeque<u64> q;
+            for (usize i = 0; i < CONTAINER_BENCH_SIZE; ++i) q.push_back(i);
+            bench_keep(q.size());
+        });
+        bench("RingDeque::push_back/pop_front", CONTAINER_BENCH_SIZE, []()
+        {
+            // Keeps a small number of elements in the queue so that the ring buffer wraps around.
+            RingDeque<u64> q;
+            u64 sum = 0;
+            for (usize i = 0; i < CONTAINER_BENCH_SIZE; ++i)
+            {
+                q.push_back(i);
+                if (q.size() > 64)
+                {
+                    sum += q.front();
+                    q.pop_front();
+                }
+            }
+            bench_keep((usize)sum);
+        });
+    }
+
+    void container_bench()
+    {
+        vector_bench();
+        map_bench<HashMap<u64, u64>>("HashMap::insert", "HashMap::find (hit)", "HashMap::find (miss)", "HashMap::erase");
+        map_bench<UnorderedMap<u64, u64>>("UnorderedMap::insert", "UnorderedMap::find (hit)", "UnorderedMap::find (miss)", "UnorderedMap::erase");
+        ring_deque_bench();
+    }
+}
@@ -0,0 +1,92 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file HashBench.cpp
+* @author JXMaster
+* @date 2024/5/14
+*/
+#include "RuntimeBench.hpp"
+#include <Luna/Runtime/Hash.hpp>
+#include <Luna/Runtime/Name.hpp>
+#include <Luna/Runtime/String.hpp>
+#include <stdio.h>
+
+namespace Luna
+{
+    void hash_bench()
+    {
+        Vector<byte_t> data;
+        data.resize(1_mb);
+        BenchRandom random;
+        for (auto& b : data) b = (byte_t)random.next();
+        bench("memhash (16B)", 100000, [&]()
+        {
+            usize h = 0;
+            for (usize i = 0; i < 100000; ++i) h += memhash<usize>(data.data() + (i & 0xFFFF), 16);
+            bench_keep(h);
+        });
+        bench("memhash (256B)", 10000, [&]()
+        {
+            usize h = 0;
+            for (usize i = 0; i < 10000; ++i) h += memhash<usize>(data.data() + (i & 0xFFFF), 256);
+            bench_keep(h);
+        });
+        bench("memhash (1MB)", 1, [&]()
+        {
+            bench_keep(memhash<usize>(data.data(), data.size()));
+        });
+        const c8* strs[] = { "a", "position", "MeshRenderer.material", "Assets/Textures/Environment/Sky/cubemap_hdr.dds" };
+        bench("strhash", 100000, [&]()
+        {
+            usize h = 0;
+            for (usize i = 0; i < 100000; ++i) h += strhash<usize>(strs[i & 3]);
+            bench_keep(h);
+        });
+    }
+
+    void name_bench()
+    {
+        constexpr usize NUM_NAMES = 10000;
+        Vector<String> strs;
+        strs.reserve(NUM_NAMES);
+        c8 buf[64];
+        for (usize i = 0; i < NUM_NAMES; ++i)
+        {
+            snprintf(buf, 64, "Entity/Component_%u.property", (u32)i);
+            strs.push_back(String(buf));
+        }
+        bench("intern_name (new)", NUM_NAMES, [&]()
+        {
+            // Names are released at the end of every run, so every run interns new names.
+            Vector<Name> names;
+            names.reserve(NUM_NAMES);
+            for (auto& s : strs) names.push_back(Name(s.c_str()));
+            bench_keep(names.size());
+        });
+        Vector<Name> names;
+        names.reserve(NUM_NAMES);
+        for (auto& s : strs) names.push_back(Name(s.c_str()));
+        bench("intern_name (existing)", NUM_NAMES, [&]()
+        {
+            usize sum = 0;
+            for (auto& s : strs)
+            {
+                Name n(s.c_str());
+                sum += (usize)n.c_str();
+            }
+            bench_keep(sum);
+        });
+        bench("Name copy", NUM_NAMES, [&]()
+        {
+            usize sum = 0;
+            for (auto& n : names)
+            {
+                Name c = n;
+                sum += (usize)c.c_str();
+            }
+            bench_keep(sum);
+        });
+    }
+}
@@ -0,0 +1,49 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file MemoryBench.cpp
+* @author JXMaster
+* @date 2024/5/14
+*/
+#include "RuntimeBench.hpp"
+#include <Luna/Runtime/Memory.hpp>
+
+namespace Luna
+{
+    void memory_bench()
+    {
+        constexpr usize NUM_ALLOCS = 10000;
+        Vector<void*> ptrs;
+        ptrs.resize(NUM_ALLOCS);
+        bench("memalloc/memfree (64B)", NUM_ALLOCS, [&]()
+        {
+            for (usize i = 0; i < NUM_ALLOCS; ++i) ptrs[i] = memalloc(64);
+            for (usize i = 0; i < NUM_ALLOCS; ++i) memfree(ptrs[i]);
+        });
+        bench("memalloc/memfree (64B, aligned 64)", NUM_ALLOCS, [&]()
+        {
+            for (usize i = 0; i < NUM_ALLOCS; ++i) ptrs[i] = memalloc(64, 64);
+            for (usize i = 0; i < NUM_ALLOCS; ++i) memfree(ptrs[i], 64);
+        });
+        bench("memalloc/memfree (mixed sizes)", NUM_ALLOCS, [&]()
+        {
+            BenchRandom random;
+            for (usize i = 0; i < NUM_ALLOCS; ++i) ptrs[i] = memalloc(16 + (usize)(random.next() % 4096));
+            for (usize i = 0; i < NUM_ALLOCS; ++i) memfree(ptrs[i]);
+        });
+        bench("memalloc/memfree (1MB)", 100, [&]()
+        {
+            for (usize i = 0; i < 100; ++i) ptrs[i] = memalloc(1_mb);
+            for (usize i = 0; i < 100; ++i) memfree(ptrs[i]);
+        });
+        bench("memrealloc (grow to 1MB)", 1, []()
+        {
+            // Grows one block by 64 bytes at a time, which simulates appending to one buffer without reserving.
+            void* p = nullptr;
+            for (usize size = 64; size <= 1_mb; size += 64) p = memrealloc(p, size);
+            memfree(p);
+        });
+    }
+}
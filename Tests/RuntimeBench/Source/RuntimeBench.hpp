@@ -0,0 +1,20 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file RuntimeBench.hpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#pragma once
+#include "../../BenchCommon/BenchCommon.hpp"
+
+namespace Luna
+{
+    void container_bench();
+    void hash_bench();
+    void name_bench();
+    void memory_bench();
+    void variant_bench();
+}
@@ -0,0 +1,83 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file VariantBench.cpp
+* @author JXMaster
+* @date 2024/5/14
+*/
+#include "RuntimeBench.hpp"
+#include <Luna/Runtime/Variant.hpp>
+#include <Luna/Runtime/Serialization.hpp>
+#include <Luna/Runtime/StaticSerialization.hpp>
+#include <Luna/Runtime/String.hpp>
+
+namespace Luna
+{
+    struct VariantBenchInner
+    {
+        Name name;
+        Vector<f32> values;
+        lufields(lufield(VariantBenchInner, name), lufield(VariantBenchInner, values));
+    };
+    struct VariantBenchOuter
+    {
+        i32 a;
+        bool b;
+        String c;
+        Vector<VariantBenchInner> inners;
+        lufields(lufield(VariantBenchOuter, a), lufield(VariantBenchOuter, b), lufield(VariantBenchOuter, c),
+            lufield(VariantBenchOuter, inners));
+    };
+
+    void variant_bench()
+    {
+        constexpr usize NUM_ELEMENTS = 1000;
+        bench("Variant array construction", NUM_ELEMENTS, []()
+        {
+            Variant v(VariantType::array);
+            for (usize i = 0; i < NUM_ELEMENTS; ++i) v.push_back(Variant((u64)i));
+            bench_keep(v.size());
+        });
+        Name keys[] = { Name("position"), Name("rotation"), Name("scale"), Name("name"), Name("enabled") };
+        bench("Variant object construction", NUM_ELEMENTS, [&]()
+        {
+            Variant v(VariantType::array);
+            for (usize i = 0; i < NUM_ELEMENTS; ++i)
+            {
+                Variant obj(VariantType::object);
+                obj[keys[0]] = (f64)i;
+                obj[keys[1]] = (f64)i;
+                obj[keys[2]] = 1.0;
+                obj[keys[3]] = "Entity";
+                obj[keys[4]] = true;
+                v.push_back(move(obj));
+            }
+            bench_keep(v.size());
+        });
+        Vector<f32> floats;
+        floats.resize(NUM_ELEMENTS);
+        for (usize i = 0; i < NUM_ELEMENTS; ++i) floats[i] = (f32)i;
+        bench("serialize Vector<f32>", NUM_ELEMENTS, [&]()
+        {
+            Variant v = serialize(floats).get();
+            bench_keep(v.size());
+        });
+        VariantBenchOuter outer;
+        outer.a = 5;
+        outer.b = true;
+        outer.c = "Outer";
+        outer.inners.resize(100);
+        for (auto& inner : outer.inners)
+        {
+            inner.name = "Inner";
+            inner.values.assign(16, 1.0f);
+        }
+        bench("static_serialize struct", 1, [&]()
+        {
+            Variant v = static_serialize(outer).get();
+            bench_keep(v.size());
+        });
+    }
+}
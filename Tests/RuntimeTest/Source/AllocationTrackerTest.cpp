@@ -0,0 +1,76 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file AllocationTrackerTest.cpp
+* @author JXMaster
+* @date 2024/5/21
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/AllocationTracker.hpp>
+#include <Luna/Runtime/Memory.hpp>
+#include <string.h>
+
+namespace Luna
+{
+    void allocation_tracker_test()
+    {
+#ifdef LUNA_ALLOCATION_TRACKER_ENABLED
+        allocation_tracker_set_enabled(true);
+        allocation_tracker_clear_offenders();
+        allocation_tracker_new_frame();
+        u64 frame_index = allocation_tracker_get_frame_index();
+        void* blocks[3];
+        for (auto& block : blocks) block = memalloc(16);
+        for (auto& block : blocks) memfree(block);
+        allocation_tracker_record_object_creation("TestObject");
+        allocation_tracker_new_frame();
+        lutest(allocation_tracker_get_frame_index() == frame_index + 1);
+        AllocationFrameStats stats[64];
+        usize num_threads = min<usize>(allocation_tracker_get_last_frame_stats({stats, 64}), 64);
+        u64 num_allocations = 0;
+        u64 num_deallocations = 0;
+        u64 allocated_bytes = 0;
+        u64 num_objects_created = 0;
+        for (usize i = 0; i < num_threads; ++i)
+        {
+            num_allocations += stats[i].num_allocations;
+            num_deallocations += stats[i].num_deallocations;
+            allocated_bytes += stats[i].allocated_bytes;
+            num_objects_created += stats[i].num_objects_created;
+            lutest(stats[i].num_violations == 0);
+        }
+        lutest(num_allocations >= 3);
+        lutest(num_deallocations >= 3);
+        lutest(allocated_bytes >= 48);
+        lutest(num_objects_created >= 1);
+
+        // Allocations in allocation-free sections are recorded as offenders, deallocations are not.
+        void* block = memalloc(32);
+        {
+            LUNA_ALLOCATION_FREE_SCOPE("AllocationTrackerTest");
+            memfree(block);
+            lutest(allocation_tracker_get_offenders({}) == 0);
+            block = memalloc(32);
+        }
+        memfree(block);
+        AllocationOffender offender;
+        lutest(allocation_tracker_get_offenders({&offender, 1}) == 1);
+        lutest(!strcmp(offender.section, "AllocationTrackerTest"));
+        lutest(offender.size == 32);
+        lutest(offender.object_type == nullptr);
+        lutest(offender.frame_index == allocation_tracker_get_frame_index());
+        allocation_tracker_clear_offenders();
+        lutest(allocation_tracker_get_offenders({}) == 0);
+
+        // Nothing is recorded when the tracker is disabled.
+        allocation_tracker_set_enabled(false);
+        {
+            LUNA_ALLOCATION_FREE_SCOPE("AllocationTrackerTest");
+            memfree(memalloc(32));
+        }
+        lutest(allocation_tracker_get_offenders({}) == 0);
+#endif
+    }
+}
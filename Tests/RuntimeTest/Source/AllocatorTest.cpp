@@ -0,0 +1,154 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file AllocatorTest.cpp
+* @author JXMaster
+* @date 2024/3/10
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Arena.hpp>
+#include <Luna/Runtime/Pool.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/List.hpp>
+#include <Luna/Runtime/HashMap.hpp>
+
+namespace Luna
+{
+    void allocator_test()
+    {
+        // Arena
+        {
+            Arena arena(1_kb);
+            void* a = arena.allocate(16);
+            void* b = arena.allocate(100, 64);
+            lutest(a && b && a != b);
+            lutest(((usize)b & 63) == 0);
+            // Large allocations use dedicated pages.
+            void* c = arena.allocate(4_kb);
+            lutest(c);
+            usize reserved = arena.get_reserved_size();
+            arena.reset();
+            // Pages are reused after reset.
+            lutest(arena.allocate(16) == a);
+            arena.allocate(4_kb);
+            lutest(arena.get_reserved_size() == reserved);
+        }
+
+        // ArenaScope
+        {
+            Arena arena;
+            void* a = arena.allocate(16);
+            void* b;
+            {
+                ArenaScope scope(arena);
+                b = arena.allocate(32);
+                lutest(b != a);
+            }
+            lutest(arena.allocate(32) == b);
+        }
+
+        // ArenaAllocator
+        {
+            Arena arena;
+            {
+                Vector<u32, ArenaAllocator> v(arena);
+                for (u32 i = 0; i < 1000; ++i)
+                {
+                    v.push_back(i);
+                }
+                lutest(v.size() == 1000);
+                for (u32 i = 0; i < 1000; ++i)
+                {
+                    lutest(v[i] == i);
+                }
+                lutest(v.get_allocator() == ArenaAllocator(arena));
+            }
+            {
+                HashMap<u32, u32, hash<u32>, equal_to<u32>, ArenaAllocator> m(arena);
+                for (u32 i = 0; i < 100; ++i)
+                {
+                    m.insert(make_pair(i, i * 2));
+                }
+                for (u32 i = 0; i < 100; ++i)
+                {
+                    auto iter = m.find(i);
+                    lutest(iter != m.end() && iter->second == i * 2);
+                }
+            }
+            arena.reset();
+            // Default-constructed allocator allocates from the global heap.
+            Vector<u32, ArenaAllocator> v;
+            v.push_back(1);
+            lutest(v.get_allocator().get_arena() == nullptr);
+        }
+
+        // StackAllocator
+        {
+            Arena arena;
+            StackAllocator alloc(arena);
+            u32* a = alloc.allocate<u32>(4);
+            u32* b = alloc.allocate<u32>(4);
+            alloc.deallocate(b, 4);
+            // The last allocation is freed immediately.
+            lutest(alloc.allocate<u32>(4) == b);
+            // Other allocations are not freed.
+            alloc.deallocate(a, 4);
+            lutest(alloc.allocate<u32>(4) != a);
+        }
+
+        // Pool
+        {
+            Pool<TestObject> pool(4);
+            TestObject* objects[10];
+            for (auto& o : objects)
+            {
+                o = pool.allocate();
+                lutest(o && ((usize)o % alignof(TestObject)) == 0);
+            }
+            TestObject* last = objects[9];
+            pool.deallocate(last);
+            lutest(pool.allocate() == last);
+            for (auto& o : objects)
+            {
+                pool.deallocate(o);
+            }
+        }
+
+        // PoolAllocator
+        {
+            // Uses one type that is large enough to hold list nodes.
+            struct Node
+            {
+                void* m_prev;
+                void* m_next;
+                u64 m_value;
+            };
+            Pool<Node> pool;
+            {
+                List<u64, PoolAllocator<Node>> l(pool);
+                for (u64 i = 0; i < 100; ++i)
+                {
+                    l.push_back(i);
+                }
+                u64 i = 0;
+                for (u64 v : l)
+                {
+                    lutest(v == i);
+                    ++i;
+                }
+                lutest(i == 100);
+            }
+            {
+                // Allocations that do not fit in pool blocks fall back to the global heap.
+                Vector<u64, PoolAllocator<Node>> v(pool);
+                for (u64 i = 0; i < 100; ++i)
+                {
+                    v.push_back(i);
+                }
+                lutest(v.size() == 100 && v[99] == 99);
+            }
+        }
+    }
+}
@@ -0,0 +1,205 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Base64Test.cpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Base64.hpp>
+
+namespace Luna
+{
+    // `base64_encode` and `base64_decode` run the vectorized kernel selected for the current processor (AVX2, SSSE3 or Neon)
+    // on the leading part of the data and the scalar code on the rest. The AVX2 kernel also hands its tail to the SSSE3
+    // kernel. Results are compared to this straightforward scalar implementation, with sizes around every block size of
+    // every kernel (12/24 bytes for encoding, 16/32 characters for decoding), so that every kernel and every transition
+    // between kernels and the scalar code is tested.
+    static const c8 BASE64_CHARS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    static Vector<c8> base64_reference_encode(const u8* src, usize size)
+    {
+        Vector<c8> ret;
+        for (usize i = 0; i < size; i += 3)
+        {
+            u32 v = (u32)src[i] << 16;
+            if (i + 1 < size) v |= (u32)src[i + 1] << 8;
+            if (i + 2 < size) v |= (u32)src[i + 2];
+            ret.push_back(BASE64_CHARS[(v >> 18) & 0x3F]);
+            ret.push_back(BASE64_CHARS[(v >> 12) & 0x3F]);
+            ret.push_back(i + 1 < size ? BASE64_CHARS[(v >> 6) & 0x3F] : '=');
+            ret.push_back(i + 2 < size ? BASE64_CHARS[v & 0x3F] : '=');
+        }
+        return ret;
+    }
+
+    // Invalid characters decode to `0`, which matches the scalar code.
+    static u32 base64_reference_decode_char(c8 c)
+    {
+        for (u32 i = 0; i < 64; ++i)
+        {
+            if (BASE64_CHARS[i] == c) return i;
+        }
+        return 0;
+    }
+
+    static Vector<u8> base64_reference_decode(const c8* src, usize size)
+    {
+        Vector<u8> ret;
+        for (usize i = 0; i + 4 <= size; i += 4)
+        {
+            u32 v = 0;
+            for (usize j = 0; j < 4; ++j) v = (v << 6) | (src[i + j] == '=' ? 0 : base64_reference_decode_char(src[i + j]));
+            ret.push_back((u8)(v >> 16));
+            if (src[i + 2] == '=') break;
+            ret.push_back((u8)(v >> 8));
+            if (src[i + 3] == '=') break;
+            ret.push_back((u8)v);
+        }
+        return ret;
+    }
+
+    static Vector<u8> base64_generate_data(usize size, u32 seed)
+    {
+        Vector<u8> ret(size);
+        u32 state = seed * 2654435761U + 1;
+        for (usize i = 0; i < size; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            ret[i] = (u8)state;
+        }
+        return ret;
+    }
+
+    static void base64_test_size(usize size)
+    {
+        constexpr u8 GUARD = 0xCD;
+        Vector<u8> data = base64_generate_data(size, (u32)size);
+        Vector<c8> expected = base64_reference_encode(data.data(), data.size());
+        lutest(expected.size() == base64_get_encoded_size(size));
+        // Encodes to one buffer that is exactly large enough, and checks that no character is written after the buffer.
+        Vector<c8> encoded(expected.size() + 1 + 64, (c8)GUARD);
+        usize num_chars = base64_encode(encoded.data(), expected.size() + 1, data.data(), data.size());
+        lutest(num_chars == expected.size());
+        lutest(expected.empty() || !memcmp(encoded.data(), expected.data(), expected.size()));
+        lutest(encoded[num_chars] == 0);
+        for (usize i = expected.size() + 1; i < encoded.size(); ++i) lutest((u8)encoded[i] == GUARD);
+        // Decodes to one buffer that is exactly large enough. Kernels write whole vectors, so this checks that they never
+        // write past `dst_max_bytes`.
+        Vector<u8> decoded(size + 64, GUARD);
+        usize num_bytes = base64_decode(decoded.data(), size, encoded.data());
+        lutest(num_bytes == size);
+        lutest(!size || !memcmp(decoded.data(), data.data(), size));
+        for (usize i = size; i < decoded.size(); ++i) lutest(decoded[i] == GUARD);
+        // Decodes with one explicit string size, followed by characters that must not be read.
+        encoded[num_chars] = 'A';
+        memzero(decoded.data(), decoded.size());
+        num_bytes = base64_decode(decoded.data(), decoded.size(), encoded.data(), num_chars);
+        lutest(num_bytes == size);
+        lutest(!size || !memcmp(decoded.data(), data.data(), size));
+        encoded[num_chars] = 0;
+    }
+
+    void base64_test()
+    {
+        lutest(base64_get_encoded_size(0) == 0);
+        lutest(base64_get_encoded_size(1) == 4);
+        lutest(base64_get_encoded_size(3) == 4);
+        lutest(base64_get_encoded_size(4) == 8);
+        lutest(base64_get_decoded_size(8) == 6);
+        {
+            // Known vectors from RFC 4648.
+            const c8* vectors[][2] = {
+                { "", "" }, { "f", "Zg==" }, { "fo", "Zm8=" }, { "foo", "Zm9v" },
+                { "foob", "Zm9vYg==" }, { "fooba", "Zm9vYmE=" }, { "foobar", "Zm9vYmFy" }
+            };
+            for (auto& v : vectors)
+            {
+                c8 buf[16];
+                usize n = base64_encode(buf, 16, v[0], strlen(v[0]));
+                lutest(n == strlen(v[1]) && !strcmp(buf, v[1]));
+                u8 data[16];
+                n = base64_decode(data, 16, v[1]);
+                lutest(n == strlen(v[0]) && !memcmp(data, v[0], n));
+            }
+        }
+        {
+            // All sizes up to several blocks of every kernel, and sizes around the block sizes of larger inputs.
+            for (usize size = 0; size <= 200; ++size) base64_test_size(size);
+            for (usize base : { 1024, 3072, 4096, 65536 })
+            {
+                for (usize size = base - 33; size <= base + 33; ++size) base64_test_size(size);
+            }
+        }
+        {
+            // Encoding stops at the last whole group of 4 characters that fits in the buffer.
+            Vector<u8> data = base64_generate_data(300, 1);
+            Vector<c8> expected = base64_reference_encode(data.data(), data.size());
+            Vector<c8> encoded(expected.size() + 64);
+            for (usize max_chars = 1; max_chars <= expected.size() + 1; ++max_chars)
+            {
+                memset(encoded.data(), 0x7F, encoded.size());
+                usize n = base64_encode(encoded.data(), max_chars, data.data(), data.size());
+                lutest(n == min<usize>((max_chars - 1) / 4 * 4, expected.size()));
+                lutest(!memcmp(encoded.data(), expected.data(), n));
+                lutest(encoded[n] == 0);
+                for (usize i = max_chars; i < encoded.size(); ++i) lutest(encoded[i] == 0x7F);
+            }
+            // Decoding stops when the buffer is full.
+            Vector<u8> decoded(data.size() + 64);
+            for (usize max_bytes = 0; max_bytes <= data.size(); ++max_bytes)
+            {
+                memset(decoded.data(), 0xCD, decoded.size());
+                usize n = base64_decode(decoded.data(), max_bytes, expected.data(), expected.size());
+                lutest(n == max_bytes);
+                lutest(!memcmp(decoded.data(), data.data(), n));
+                for (usize i = max_bytes; i < decoded.size(); ++i) lutest(decoded[i] == 0xCD);
+            }
+        }
+        {
+            // Invalid characters make the vectorized kernels stop at the block that contains them, and the scalar code
+            // continues from there.
+            Vector<u8> data = base64_generate_data(96, 2);
+            Vector<c8> encoded = base64_reference_encode(data.data(), data.size());
+            Vector<u8> decoded(data.size());
+            for (usize pos = 0; pos < encoded.size(); ++pos)
+            {
+                for (c8 invalid : { '*', '-', '_', ' ', '\x80' })
+                {
+                    Vector<c8> src = encoded;
+                    src[pos] = invalid;
+                    Vector<u8> expected = base64_reference_decode(src.data(), src.size());
+                    usize n = base64_decode(decoded.data(), decoded.size(), src.data(), src.size());
+                    lutest(n == expected.size());
+                    lutest(!memcmp(decoded.data(), expected.data(), n));
+                }
+            }
+            // Padding stops decoding.
+            Vector<c8> src = encoded;
+            src[45] = '=';
+            src[46] = '=';
+            src[47] = '=';
+            Vector<u8> expected = base64_reference_decode(src.data(), src.size());
+            lutest(expected.size() == 34);
+            usize n = base64_decode(decoded.data(), decoded.size(), src.data(), src.size());
+            lutest(n == expected.size());
+            lutest(!memcmp(decoded.data(), expected.data(), n));
+        }
+        {
+            // base64_encode_to_stream encodes 3072 bytes at a time.
+            for (usize size : { 0, 1, 2, 3, 100, 3071, 3072, 3073, 6144, 6145, 10000 })
+            {
+                Vector<u8> data = base64_generate_data(size, 3);
+                Vector<c8> expected = base64_reference_encode(data.data(), data.size());
+                Ref<TestMemoryStream> stream = new_object<TestMemoryStream>();
+                lutest(succeeded(base64_encode_to_stream(stream, data.data(), data.size())));
+                lutest(stream->m_data.size() == expected.size());
+                lutest(expected.empty() || !memcmp(stream->m_data.data(), expected.data(), expected.size()));
+            }
+        }
+    }
+}
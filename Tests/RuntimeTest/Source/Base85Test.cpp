@@ -0,0 +1,142 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Base85Test.cpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Base85.hpp>
+
+namespace Luna
+{
+    // `base85_encode` and `base85_decode` run the vectorized kernel selected for the current processor (SSSE3 or Neon)
+    // on the leading part of the data and the scalar code on the rest. Results are compared to this straightforward
+    // scalar implementation, with sizes around the block size of the kernels (16 bytes, 20 characters).
+    static Vector<c8> base85_reference_encode(const u8* src, usize size)
+    {
+        Vector<c8> ret;
+        for (usize i = 0; i + 4 <= size; i += 4)
+        {
+            u32 v = ((u32)src[i] << 24) | ((u32)src[i + 1] << 16) | ((u32)src[i + 2] << 8) | (u32)src[i + 3];
+            c8 digits[5];
+            for (i32 j = 4; j >= 0; --j)
+            {
+                digits[j] = (c8)(v % 85 + 33);
+                v /= 85;
+            }
+            for (c8 d : digits) ret.push_back(d);
+        }
+        return ret;
+    }
+
+    static Vector<u8> base85_generate_data(usize size, u32 seed)
+    {
+        Vector<u8> ret(size);
+        u32 state = seed * 2654435761U + 1;
+        for (usize i = 0; i < size; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            ret[i] = (u8)state;
+        }
+        return ret;
+    }
+
+    static void base85_test_size(usize size)
+    {
+        constexpr u8 GUARD = 0xCD;
+        Vector<u8> data = base85_generate_data(size, (u32)size);
+        Vector<c8> expected = base85_reference_encode(data.data(), data.size());
+        lutest(expected.size() == base85_get_encoded_size(size));
+        Vector<c8> encoded(expected.size() + 1 + 64, (c8)GUARD);
+        usize num_chars = base85_encode(encoded.data(), expected.size() + 1, data.data(), data.size());
+        lutest(num_chars == expected.size());
+        lutest(expected.empty() || !memcmp(encoded.data(), expected.data(), expected.size()));
+        lutest(encoded[num_chars] == 0);
+        for (usize i = expected.size() + 1; i < encoded.size(); ++i) lutest((u8)encoded[i] == GUARD);
+        Vector<u8> decoded(size + 64, GUARD);
+        usize num_bytes = base85_decode(decoded.data(), size, encoded.data());
+        lutest(num_bytes == size);
+        lutest(!size || !memcmp(decoded.data(), data.data(), size));
+        for (usize i = size; i < decoded.size(); ++i) lutest(decoded[i] == GUARD);
+        // Decodes with one explicit string size.
+        memzero(decoded.data(), decoded.size());
+        num_bytes = base85_decode(decoded.data(), decoded.size(), encoded.data(), num_chars);
+        lutest(num_bytes == size);
+        lutest(!size || !memcmp(decoded.data(), data.data(), size));
+    }
+
+    void base85_test()
+    {
+        lutest(base85_get_encoded_size(0) == 0);
+        lutest(base85_get_encoded_size(4) == 5);
+        lutest(base85_get_decoded_size(20) == 16);
+        {
+            // Known values: 0 encodes to "!!!!!", and 0xFFFFFFFF encodes to "s8W-!".
+            u8 zeros[4] = { 0, 0, 0, 0 };
+            u8 ones[4] = { 0xFF, 0xFF, 0xFF, 0xFF };
+            c8 buf[16];
+            lutest(base85_encode(buf, 16, zeros, 4) == 5 && !strcmp(buf, "!!!!!"));
+            lutest(base85_encode(buf, 16, ones, 4) == 5 && !strcmp(buf, "s8W-!"));
+        }
+        {
+            // All sizes up to several blocks, and sizes around the block size of larger inputs.
+            for (usize size = 0; size <= 256; size += 4) base85_test_size(size);
+            for (usize base : { 1024, 4096, 65536 })
+            {
+                for (usize size = base - 40; size <= base + 40; size += 4) base85_test_size(size);
+            }
+            // Extreme values, where the division by 85 in the kernels must be exact.
+            Vector<u8> data(64);
+            for (usize i = 0; i < data.size(); ++i) data[i] = (i & 4) ? 0xFF : (u8)(i * 85);
+            Vector<c8> expected = base85_reference_encode(data.data(), data.size());
+            Vector<c8> encoded(expected.size() + 1);
+            lutest(base85_encode(encoded.data(), encoded.size(), data.data(), data.size()) == expected.size());
+            lutest(!memcmp(encoded.data(), expected.data(), expected.size()));
+            Vector<u8> decoded(data.size());
+            lutest(base85_decode(decoded.data(), decoded.size(), encoded.data()) == data.size());
+            lutest(!memcmp(decoded.data(), data.data(), data.size()));
+        }
+        {
+            // Encoding stops at the last whole group of 5 characters that fits in the buffer.
+            Vector<u8> data = base85_generate_data(160, 1);
+            Vector<c8> expected = base85_reference_encode(data.data(), data.size());
+            Vector<c8> encoded(expected.size() + 64);
+            for (usize max_chars = 1; max_chars <= expected.size() + 1; ++max_chars)
+            {
+                memset(encoded.data(), 0x7F, encoded.size());
+                usize n = base85_encode(encoded.data(), max_chars, data.data(), data.size());
+                lutest(n == min<usize>((max_chars - 1) / 5 * 5, expected.size()));
+                lutest(!memcmp(encoded.data(), expected.data(), n));
+                lutest(encoded[n] == 0);
+                for (usize i = max_chars; i < encoded.size(); ++i) lutest(encoded[i] == 0x7F);
+            }
+            // Decoding stops at the last whole group of 4 bytes that fits in the buffer.
+            Vector<u8> decoded(data.size() + 64);
+            for (usize max_bytes = 0; max_bytes <= data.size(); ++max_bytes)
+            {
+                memset(decoded.data(), 0xCD, decoded.size());
+                usize n = base85_decode(decoded.data(), max_bytes, expected.data(), expected.size());
+                lutest(n == max_bytes / 4 * 4);
+                lutest(!memcmp(decoded.data(), data.data(), n));
+                for (usize i = n; i < decoded.size(); ++i) lutest(decoded[i] == 0xCD);
+            }
+        }
+        {
+            // base85_encode_to_stream encodes 4096 bytes at a time.
+            for (usize size : { 0, 4, 100, 4092, 4096, 4100, 8192, 8196, 10000 })
+            {
+                Vector<u8> data = base85_generate_data(size, 3);
+                Vector<c8> expected = base85_reference_encode(data.data(), data.size());
+                Ref<TestMemoryStream> stream = new_object<TestMemoryStream>();
+                lutest(succeeded(base85_encode_to_stream(stream, data.data(), data.size())));
+                lutest(stream->m_data.size() == expected.size());
+                lutest(expected.empty() || !memcmp(stream->m_data.data(), expected.data(), expected.size()));
+            }
+        }
+    }
+}
@@ -0,0 +1,365 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file CompressionTest.cpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Compression.hpp>
+
+namespace Luna
+{
+    // Generates data that contains repeated words, which is compressible.
+    static Vector<byte_t> generate_text_data(usize size, u32 seed)
+    {
+        static const c8* words[] = { "luna ", "sdk ", "compression ", "frame ", "block ", "dictionary ", "stream ", "\n" };
+        Vector<byte_t> ret;
+        ret.reserve(size);
+        u32 state = seed;
+        while (ret.size() < size)
+        {
+            state = state * 1664525 + 1013904223;
+            const c8* word = words[(state >> 16) % 8];
+            for (const c8* c = word; *c && ret.size() < size; ++c) ret.push_back((byte_t)*c);
+        }
+        return ret;
+    }
+
+    // Generates data that is not compressible.
+    static Vector<byte_t> generate_random_data(usize size, u32 seed)
+    {
+        Vector<byte_t> ret(size);
+        u32 state = seed;
+        for (usize i = 0; i < size; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            ret[i] = (byte_t)state;
+        }
+        return ret;
+    }
+
+    static bool blob_equals(const Blob& blob, const Vector<byte_t>& data)
+    {
+        return blob.size() == data.size() && (data.empty() || !memcmp(blob.data(), data.data(), data.size()));
+    }
+
+    static void test_block_round_trip(CompressionFormat format, const Vector<byte_t>& data, Span<const byte_t> dictionary)
+    {
+        usize bound = get_compress_bound(format, data.size());
+        Vector<byte_t> compressed(max<usize>(bound, 1));
+        auto r = compress(format, data.data(), data.size(), compressed.data(), compressed.size(), dictionary);
+        lutest(succeeded(r));
+        lutest(r.get() <= bound);
+        Vector<byte_t> decompressed(data.size() + 1);
+        lutest(succeeded(decompress(format, compressed.data(), r.get(), decompressed.data(), data.size(), dictionary)));
+        lutest(data.empty() || !memcmp(decompressed.data(), data.data(), data.size()));
+        if (format == CompressionFormat::lz4 && !data.empty())
+        {
+            // The decompressed size must match exactly.
+            lutest(failed(decompress(format, compressed.data(), r.get(), decompressed.data(), data.size() + 1, dictionary)));
+            lutest(failed(decompress(format, compressed.data(), r.get(), decompressed.data(), data.size() - 1, dictionary)));
+        }
+    }
+
+    static void test_frame_round_trip(const Vector<byte_t>& data, const CompressionDesc& desc)
+    {
+        auto frame = compress_frame(data.data(), data.size(), desc);
+        lutest(succeeded(frame));
+        Blob& f = frame.get();
+        lutest(f.size() >= sizeof(CompressionFrameHeader) + sizeof(CompressionBlockHeader));
+        CompressionFrameHeader header;
+        memcpy(&header, f.data(), sizeof(CompressionFrameHeader));
+        lutest(header.magic == COMPRESSION_FRAME_MAGIC);
+        lutest(header.format == desc.format);
+        lutest(header.block_size == desc.block_size);
+        // Checks block headers and the end of the frame.
+        usize num_blocks = 0;
+        usize raw_size = 0;
+        const byte_t* p = (const byte_t*)f.data() + sizeof(CompressionFrameHeader);
+        while (true)
+        {
+            CompressionBlockHeader block;
+            memcpy(&block, p, sizeof(CompressionBlockHeader));
+            p += sizeof(CompressionBlockHeader);
+            if (!block.stored_size && !block.raw_size) break;
+            lutest(block.raw_size <= desc.block_size);
+            lutest((block.stored_size & ~COMPRESSION_BLOCK_UNCOMPRESSED) <= block.raw_size);
+            p += block.stored_size & ~COMPRESSION_BLOCK_UNCOMPRESSED;
+            raw_size += block.raw_size;
+            ++num_blocks;
+        }
+        lutest(p == (const byte_t*)f.data() + f.size());
+        lutest(raw_size == data.size());
+        lutest(num_blocks == (data.size() + desc.block_size - 1) / desc.block_size);
+        auto decompressed = decompress_frame(f.data(), f.size(), desc.dictionary);
+        lutest(succeeded(decompressed));
+        lutest(blob_equals(decompressed.get(), data));
+
+        // Blocks compressed separately by `compress_frame_block` form the same frame.
+        Vector<byte_t> assembled(sizeof(CompressionFrameHeader));
+        memcpy(assembled.data(), &header, sizeof(CompressionFrameHeader));
+        Vector<byte_t> block_buffer(get_compress_frame_block_bound(desc.format, desc.block_size));
+        for (usize offset = 0; offset < data.size(); offset += desc.block_size)
+        {
+            usize block_size = min<usize>(desc.block_size, data.size() - offset);
+            usize written = compress_frame_block(desc, data.data() + offset, block_size, block_buffer.data());
+            lutest(written <= block_buffer.size());
+            assembled.insert(assembled.end(), Span<const byte_t>(block_buffer.data(), written));
+        }
+        CompressionBlockHeader end;
+        end.stored_size = 0;
+        end.raw_size = 0;
+        assembled.insert(assembled.end(), Span<const byte_t>((const byte_t*)&end, sizeof(CompressionBlockHeader)));
+        lutest(assembled.size() == f.size() && !memcmp(assembled.data(), f.data(), f.size()));
+    }
+
+    static void test_stream_round_trip(const Vector<byte_t>& data, const CompressionDesc& desc, usize write_chunk, usize read_chunk)
+    {
+        Ref<TestMemoryStream> target = new_object<TestMemoryStream>();
+        {
+            Ref<ICompressionStream> stream = new_compression_stream(target, desc);
+            for (usize offset = 0; offset < data.size(); offset += write_chunk)
+            {
+                usize size = min(write_chunk, data.size() - offset);
+                usize written = 0;
+                lutest(succeeded(stream->write(data.data() + offset, size, &written)));
+                lutest(written == size);
+            }
+            lutest(succeeded(stream->finish()));
+            lutest(succeeded(stream->finish()));
+            // Writing after finishing fails.
+            byte_t b = 0;
+            auto r = stream->write(&b, 1);
+            lutest(failed(r) && r.errcode() == BasicError::bad_calling_time());
+        }
+        // The stream produces the same frame as `compress_frame`.
+        auto frame = compress_frame(data.data(), data.size(), desc);
+        lutest(succeeded(frame));
+        lutest(frame.get().size() == target->m_data.size());
+        lutest(!memcmp(frame.get().data(), target->m_data.data(), target->m_data.size()));
+
+        auto source = new_decompression_stream(target, desc.dictionary);
+        lutest(succeeded(source));
+        Vector<byte_t> decompressed(data.size());
+        usize total = 0;
+        while (true)
+        {
+            // Reads in chunks that do not align with blocks.
+            byte_t buffer[4096];
+            usize read_bytes = 0;
+            lutest(succeeded(source.get()->read(buffer, min<usize>(read_chunk, 4096), &read_bytes)));
+            if (!read_bytes) break;
+            lutest(total + read_bytes <= data.size());
+            memcpy(decompressed.data() + total, buffer, read_bytes);
+            total += read_bytes;
+        }
+        lutest(total == data.size());
+        lutest(data.empty() || !memcmp(decompressed.data(), data.data(), data.size()));
+        // Reading at the end of the frame reads 0 bytes.
+        usize read_bytes = 1;
+        byte_t b;
+        lutest(succeeded(source.get()->read(&b, 1, &read_bytes)));
+        lutest(read_bytes == 0);
+    }
+
+    void compression_test()
+    {
+        const usize sizes[] = { 0, 1, 2, 15, 16, 17, 255, 256, 4095, 4096, 4097, 12288, 65535, 65536, 65537, 200000 };
+        {
+            // Block compression.
+            for (usize size : sizes)
+            {
+                Vector<byte_t> text = generate_text_data(size, (u32)size + 1);
+                Vector<byte_t> random = generate_random_data(size, (u32)size + 1);
+                for (CompressionFormat format : { CompressionFormat::none, CompressionFormat::lz4 })
+                {
+                    test_block_round_trip(format, text, Span<const byte_t>());
+                    test_block_round_trip(format, random, Span<const byte_t>());
+                }
+            }
+            // Text data is compressed.
+            Vector<byte_t> text = generate_text_data(65536, 1);
+            Vector<byte_t> compressed(get_compress_bound(CompressionFormat::lz4, text.size()));
+            auto r = compress(CompressionFormat::lz4, text.data(), text.size(), compressed.data(), compressed.size());
+            lutest(succeeded(r) && r.get() < text.size() / 2);
+            // Fails if the output buffer is too small.
+            Vector<byte_t> random = generate_random_data(4096, 7);
+            r = compress(CompressionFormat::lz4, random.data(), random.size(), compressed.data(), random.size() / 2);
+            lutest(failed(r) && r.errcode() == BasicError::insufficient_user_buffer());
+            r = compress(CompressionFormat::none, random.data(), random.size(), compressed.data(), random.size() - 1);
+            lutest(failed(r) && r.errcode() == BasicError::insufficient_user_buffer());
+        }
+        {
+            // Dictionaries.
+            Vector<byte_t> dictionary = generate_text_data(100000, 3);
+            Span<const byte_t> dict(dictionary.data(), dictionary.size());
+            for (usize size : { 0, 1, 64, 1000, 70000 })
+            {
+                test_block_round_trip(CompressionFormat::lz4, generate_text_data(size, 5), dict);
+            }
+            // Data that repeats the dictionary is compressed much better with the dictionary. Only the last 64KB of the
+            // dictionary is used, so the data is taken from the end of the dictionary.
+            Vector<byte_t> data(dictionary.end() - 1000, dictionary.end());
+            Vector<byte_t> with_dict(get_compress_bound(CompressionFormat::lz4, data.size()));
+            Vector<byte_t> without_dict(with_dict.size());
+            auto r1 = compress(CompressionFormat::lz4, data.data(), data.size(), with_dict.data(), with_dict.size(), dict);
+            auto r2 = compress(CompressionFormat::lz4, data.data(), data.size(), without_dict.data(), without_dict.size());
+            lutest(succeeded(r1) && succeeded(r2));
+            lutest(r1.get() < r2.get());
+            // Decompressing without the dictionary does not restore the data.
+            Vector<byte_t> decompressed(data.size());
+            RV r = decompress(CompressionFormat::lz4, with_dict.data(), r1.get(), decompressed.data(), decompressed.size());
+            lutest(failed(r) || memcmp(decompressed.data(), data.data(), data.size()));
+        }
+        {
+            // Frames.
+            CompressionDesc desc;
+            desc.block_size = 4096;
+            for (usize size : sizes)
+            {
+                desc.format = CompressionFormat::lz4;
+                test_frame_round_trip(generate_text_data(size, 11), desc);
+                test_frame_round_trip(generate_random_data(size, 11), desc);
+                desc.format = CompressionFormat::none;
+                test_frame_round_trip(generate_text_data(size, 11), desc);
+            }
+            // Incompressible blocks are stored without compression.
+            desc.format = CompressionFormat::lz4;
+            Vector<byte_t> random = generate_random_data(4096, 13);
+            auto frame = compress_frame(random.data(), random.size(), desc);
+            lutest(succeeded(frame));
+            CompressionBlockHeader block;
+            memcpy(&block, (const byte_t*)frame.get().data() + sizeof(CompressionFrameHeader), sizeof(CompressionBlockHeader));
+            lutest(block.stored_size == (4096 | COMPRESSION_BLOCK_UNCOMPRESSED));
+            lutest(block.raw_size == 4096);
+            // Invalid block sizes.
+            desc.block_size = 0;
+            lutest(failed(compress_frame(random.data(), random.size(), desc)));
+            desc.block_size = COMPRESSION_BLOCK_UNCOMPRESSED;
+            lutest(failed(compress_frame(random.data(), random.size(), desc)));
+            // Frames with dictionaries.
+            Vector<byte_t> dictionary = generate_text_data(8192, 17);
+            desc.block_size = 1024;
+            desc.dictionary = Span<const byte_t>(dictionary.data(), dictionary.size());
+            for (usize size : { 0, 100, 1024, 5000 })
+            {
+                test_frame_round_trip(generate_text_data(size, 19), desc);
+            }
+        }
+        {
+            // Truncated and corrupted frames.
+            CompressionDesc desc;
+            desc.block_size = 1024;
+            Vector<byte_t> data = generate_text_data(5000, 23);
+            auto frame = compress_frame(data.data(), data.size(), desc);
+            lutest(succeeded(frame));
+            const byte_t* f = (const byte_t*)frame.get().data();
+            usize frame_size = frame.get().size();
+            // Every truncated frame misses the end of the frame.
+            for (usize size = 0; size < frame_size; ++size)
+            {
+                auto r = decompress_frame(f, size);
+                lutest(failed(r) && r.errcode() == BasicError::format_error());
+            }
+            // Bad magic number.
+            Vector<byte_t> corrupted(f, f + frame_size);
+            corrupted[0] ^= 0xFF;
+            auto r = decompress_frame(corrupted.data(), corrupted.size());
+            lutest(failed(r) && r.errcode() == BasicError::format_error());
+            // Bad block sizes.
+            usize block_offset = sizeof(CompressionFrameHeader);
+            CompressionBlockHeader block;
+            memcpy(&block, f + block_offset, sizeof(CompressionBlockHeader));
+            for (u32 stored_size : { (u32)frame_size, (u32)block.stored_size | COMPRESSION_BLOCK_UNCOMPRESSED })
+            {
+                CompressionBlockHeader bad = block;
+                bad.stored_size = stored_size;
+                memcpy(corrupted.data(), f, frame_size);
+                memcpy(corrupted.data() + block_offset, &bad, sizeof(CompressionBlockHeader));
+                r = decompress_frame(corrupted.data(), corrupted.size());
+                lutest(failed(r) && r.errcode() == BasicError::format_error());
+            }
+            CompressionBlockHeader bad = block;
+            bad.raw_size = desc.block_size + 1;
+            memcpy(corrupted.data(), f, frame_size);
+            memcpy(corrupted.data() + block_offset, &bad, sizeof(CompressionBlockHeader));
+            r = decompress_frame(corrupted.data(), corrupted.size());
+            lutest(failed(r) && r.errcode() == BasicError::format_error());
+            // Corrupting any byte of compressed data never reads or writes out of bounds. The result is either one error,
+            // or data of the original size.
+            for (usize i = block_offset + sizeof(CompressionBlockHeader); i < block_offset + sizeof(CompressionBlockHeader) + (block.stored_size & ~COMPRESSION_BLOCK_UNCOMPRESSED); ++i)
+            {
+                memcpy(corrupted.data(), f, frame_size);
+                corrupted[i] ^= (byte_t)(i * 37 + 1);
+                r = decompress_frame(corrupted.data(), corrupted.size());
+                lutest(failed(r) ? r.errcode() == BasicError::format_error() : r.get().size() == data.size());
+            }
+            // Truncated and corrupted blocks.
+            Vector<byte_t> compressed(get_compress_bound(CompressionFormat::lz4, data.size()));
+            auto cr = compress(CompressionFormat::lz4, data.data(), data.size(), compressed.data(), compressed.size());
+            lutest(succeeded(cr));
+            Vector<byte_t> decompressed(data.size());
+            for (usize size = 0; size < cr.get(); size += 7)
+            {
+                lutest(failed(decompress(CompressionFormat::lz4, compressed.data(), size, decompressed.data(), decompressed.size())));
+            }
+            lutest(failed(decompress(CompressionFormat::none, compressed.data(), data.size() - 1, decompressed.data(), decompressed.size())));
+        }
+        {
+            // Streams.
+            CompressionDesc desc;
+            desc.block_size = 4096;
+            for (usize size : { 0, 1, 4095, 4096, 4097, 20000 })
+            {
+                test_stream_round_trip(generate_text_data(size, 29), desc, 1000, 333);
+                test_stream_round_trip(generate_random_data(size, 29), desc, 4096, 4096);
+                test_stream_round_trip(generate_text_data(size, 29), desc, 10000, 1);
+            }
+            Vector<byte_t> dictionary = generate_text_data(8192, 31);
+            desc.dictionary = Span<const byte_t>(dictionary.data(), dictionary.size());
+            test_stream_round_trip(generate_text_data(10000, 37), desc, 777, 100);
+            desc.dictionary = Span<const byte_t>();
+
+            // Destructing one stream without calling `finish` finishes the frame.
+            Vector<byte_t> data = generate_text_data(10000, 41);
+            Ref<TestMemoryStream> target = new_object<TestMemoryStream>();
+            {
+                Ref<ICompressionStream> stream = new_compression_stream(target, desc);
+                lutest(succeeded(stream->write(data.data(), data.size())));
+            }
+            auto r = decompress_frame(target->m_data.data(), target->m_data.size());
+            lutest(succeeded(r) && blob_equals(r.get(), data));
+
+            // Invalid frame headers.
+            Ref<TestMemoryStream> source = new_object<TestMemoryStream>();
+            source->m_data.assign(target->m_data.begin(), target->m_data.begin() + sizeof(CompressionFrameHeader) - 1);
+            auto s = new_decompression_stream(source);
+            lutest(failed(s) && s.errcode() == BasicError::format_error());
+            source->m_data.assign(target->m_data.begin(), target->m_data.end());
+            source->m_data[1] ^= 0xFF;
+            source->m_read_pos = 0;
+            s = new_decompression_stream(source);
+            lutest(failed(s) && s.errcode() == BasicError::format_error());
+
+            // Truncated frames fail when the missing data is read.
+            for (usize size : { sizeof(CompressionFrameHeader), sizeof(CompressionFrameHeader) + 3, target->m_data.size() / 2, target->m_data.size() - 1 })
+            {
+                source->m_data.assign(target->m_data.begin(), target->m_data.begin() + size);
+                source->m_read_pos = 0;
+                s = new_decompression_stream(source);
+                lutest(succeeded(s));
+                Vector<byte_t> buffer(data.size() + 1);
+                usize read_bytes = 0;
+                RV rr = s.get()->read(buffer.data(), buffer.size(), &read_bytes);
+                lutest(failed(rr) && rr.errcode() == BasicError::format_error());
+                lutest(read_bytes <= data.size());
+                lutest(!read_bytes || !memcmp(buffer.data(), data.data(), read_bytes));
+            }
+        }
+    }
+}
@@ -9,6 +9,7 @@
 */
 #include "TestCommon.hpp"
 #include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Thread.hpp>
 
 namespace Luna
 {
@@ -34,6 +35,43 @@ namespace Luna
             lutest(!strcmp(s, str));
             file = nullptr;
 
+            // Maps the file and reads the data from the mapped memory.
+            auto mapped = map_file("SampleFile.txt").get();
+            lutest(mapped->get_size() == 13);
+            lutest(!memcmp(mapped->get_data(), s, 13));
+            mapped = nullptr;
+
+            // Reads two parts of the file asynchronously.
+            file = open_file("SampleFile.txt",
+                FileOpenFlag::read, FileCreationMode::open_existing).get();
+            struct AsyncReadResult
+            {
+                volatile u32 finished = 0;
+                usize read_bytes = 0;
+                bool succeeded = false;
+            };
+            auto on_complete = [](void* userdata, RV result, usize read_bytes)
+            {
+                AsyncReadResult* r = (AsyncReadResult*)userdata;
+                r->succeeded = succeeded(result);
+                r->read_bytes = read_bytes;
+                atom_exchange_u32(&r->finished, 1);
+            };
+            char part1[6];
+            char part2[32];
+            AsyncReadResult results[2];
+            AsyncFileReadDesc reads[2];
+            reads[0] = { file.get(), 0, part1, 6, on_complete, &results[0] };
+            // Reads past the end of the file.
+            reads[1] = { file.get(), 7, part2, 32, on_complete, &results[1] };
+            lutest(succeeded(submit_async_file_reads({ reads, 2 })));
+            file = nullptr;
+            while (!results[0].finished || !results[1].finished) yield_current_thread();
+            lutest(results[0].succeeded && results[0].read_bytes == 6);
+            lutest(!memcmp(part1, "Sample", 6));
+            lutest(results[1].succeeded && results[1].read_bytes == 6);
+            lutest(!memcmp(part2, "String", 6));
+
             // Clean up.
             lutest(succeeded(delete_file("SampleFile.txt")));
         }
@@ -73,5 +73,31 @@ namespace Luna
             lutest(func2(3, 4) == 17);
         }
         lutest(allocated == get_allocated_memory());
+        {
+            // Small function objects are stored inline.
+            u32 data = 10;
+            Function<i32(i32, i32)> func = [data](int n1, int n2)
+            {
+                return n1 + n2 + data;
+            };
+            lutest(allocated == get_allocated_memory());
+            Function<i32(i32, i32)> func2 = move(func);
+            lutest(!func);
+            lutest(func2(1, 2) == 13);
+            func2.swap(func);
+            lutest(!func2);
+            lutest(func(1, 2) == 13);
+        }
+        lutest(allocated == get_allocated_memory());
+        {
+            Bar bar;
+            FunctionRef<i32(i32, i32)> func = bar;
+            lutest(func(3, 4) == 17);
+            bar.data = 20;
+            lutest(func(3, 4) == 27);
+            func = test_func1;
+            lutest(func(1, 2) == 3);
+        }
+        lutest(allocated == get_allocated_memory());
     }
 }
\ No newline at end of file
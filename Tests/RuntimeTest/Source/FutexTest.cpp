@@ -0,0 +1,264 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file FutexTest.cpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Futex.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/SpinLock.hpp>
+
+namespace Luna
+{
+    constexpr u32 NUM_FUTEX_THREADS = 8;
+    constexpr u32 NUM_FUTEX_ITERATIONS = 10000;
+
+    struct FutexWaitTestContext
+    {
+        u32 volatile value;
+        u32 volatile num_woken;
+    };
+
+    static void futex_wait_func(void* params)
+    {
+        FutexWaitTestContext* ctx = (FutexWaitTestContext*)params;
+        while (ctx->value == 0) futex_wait(&ctx->value, 0);
+        atom_inc_u32(&ctx->num_woken);
+    }
+
+    struct FutexMutexTestContext
+    {
+        FutexMutex mtx;
+        // Not atomic, protected by `mtx`.
+        u64 counter;
+        u32 num_inside;
+        bool overlapped;
+    };
+
+    static void futex_mutex_func(void* params)
+    {
+        FutexMutexTestContext* ctx = (FutexMutexTestContext*)params;
+        for (u32 i = 0; i < NUM_FUTEX_ITERATIONS; ++i)
+        {
+            LockGuard<FutexMutex> guard(ctx->mtx);
+            if (++ctx->num_inside != 1) ctx->overlapped = true;
+            ++ctx->counter;
+            --ctx->num_inside;
+        }
+    }
+
+    struct FutexConditionVariableTestContext
+    {
+        FutexMutex mtx;
+        FutexConditionVariable cv;
+        // Protected by `mtx`.
+        u32 num_items;
+        u32 num_consumed;
+        bool finished;
+    };
+
+    static void futex_consumer_func(void* params)
+    {
+        FutexConditionVariableTestContext* ctx = (FutexConditionVariableTestContext*)params;
+        ctx->mtx.lock();
+        while (true)
+        {
+            while (!ctx->num_items && !ctx->finished) ctx->cv.wait(ctx->mtx);
+            if (!ctx->num_items) break;
+            --ctx->num_items;
+            ++ctx->num_consumed;
+        }
+        ctx->mtx.unlock();
+    }
+
+    struct FutexSignalTestContext
+    {
+        FutexSignal ping;
+        FutexSignal pong;
+        // Passes all waiting threads once triggered.
+        FutexSignal start { true };
+        u32 volatile num_passed;
+    };
+
+    static void futex_ping_pong_func(void* params)
+    {
+        FutexSignalTestContext* ctx = (FutexSignalTestContext*)params;
+        for (u32 i = 0; i < NUM_FUTEX_ITERATIONS; ++i)
+        {
+            ctx->ping.wait();
+            ctx->pong.trigger();
+        }
+    }
+
+    static void futex_start_func(void* params)
+    {
+        FutexSignalTestContext* ctx = (FutexSignalTestContext*)params;
+        ctx->start.wait();
+        atom_inc_u32(&ctx->num_passed);
+    }
+
+    struct FutexSemaphoreTestContext
+    {
+        FutexSemaphore sema;
+        u32 volatile num_acquired;
+    };
+
+    static void futex_semaphore_func(void* params)
+    {
+        FutexSemaphoreTestContext* ctx = (FutexSemaphoreTestContext*)params;
+        for (u32 i = 0; i < NUM_FUTEX_ITERATIONS; ++i)
+        {
+            ctx->sema.acquire();
+            atom_inc_u32(&ctx->num_acquired);
+        }
+    }
+
+    void futex_test()
+    {
+        {
+            // futex_wait returns immediately if the value does not match, and times out if nobody wakes it.
+            u32 volatile value = 1;
+            lutest(futex_wait(&value, 0, 0));
+            lutest(!futex_wait(&value, 1, 10));
+            // Waking one address that no thread waits on does nothing.
+            futex_wake_one(&value);
+            futex_wake_all(&value);
+        }
+        {
+            // futex_wake_all wakes all waiting threads.
+            FutexWaitTestContext ctx;
+            ctx.value = 0;
+            ctx.num_woken = 0;
+            Ref<IThread> threads[NUM_FUTEX_THREADS];
+            for (auto& t : threads) t = new_thread(futex_wait_func, &ctx);
+            sleep(10);
+            lutest(ctx.num_woken == 0);
+            atom_exchange_u32(&ctx.value, 1);
+            futex_wake_all(&ctx.value);
+            for (auto& t : threads) t->wait();
+            lutest(ctx.num_woken == NUM_FUTEX_THREADS);
+        }
+        {
+            // FutexMutex
+            FutexMutexTestContext ctx;
+            lutest(ctx.mtx.try_lock());
+            lutest(!ctx.mtx.try_lock());
+            ctx.mtx.unlock();
+            lutest(ctx.mtx.try_lock());
+            ctx.mtx.unlock();
+            ctx.counter = 0;
+            ctx.num_inside = 0;
+            ctx.overlapped = false;
+            Ref<IThread> threads[NUM_FUTEX_THREADS];
+            for (auto& t : threads) t = new_thread(futex_mutex_func, &ctx);
+            for (auto& t : threads) t->wait();
+            lutest(!ctx.overlapped);
+            lutest(ctx.counter == (u64)NUM_FUTEX_THREADS * NUM_FUTEX_ITERATIONS);
+            lutest(ctx.mtx.try_lock());
+            ctx.mtx.unlock();
+        }
+        {
+            // FutexConditionVariable
+            FutexConditionVariableTestContext ctx;
+            ctx.num_items = 0;
+            ctx.num_consumed = 0;
+            ctx.finished = false;
+            Ref<IThread> threads[NUM_FUTEX_THREADS];
+            for (auto& t : threads) t = new_thread(futex_consumer_func, &ctx);
+            for (u32 i = 0; i < NUM_FUTEX_ITERATIONS; ++i)
+            {
+                ctx.mtx.lock();
+                ++ctx.num_items;
+                ctx.mtx.unlock();
+                ctx.cv.notify_one();
+            }
+            ctx.mtx.lock();
+            ctx.finished = true;
+            ctx.mtx.unlock();
+            ctx.cv.notify_all();
+            for (auto& t : threads) t->wait();
+            lutest(ctx.num_items == 0);
+            lutest(ctx.num_consumed == NUM_FUTEX_ITERATIONS);
+        }
+        {
+            // FutexSignal
+            FutexSignal auto_signal;
+            lutest(!auto_signal.try_wait());
+            auto_signal.trigger();
+            lutest(auto_signal.try_wait());
+            lutest(!auto_signal.try_wait());
+            auto_signal.trigger();
+            auto_signal.wait();
+            lutest(!auto_signal.try_wait());
+            auto_signal.trigger();
+            auto_signal.reset();
+            lutest(!auto_signal.try_wait());
+
+            FutexSignal manual_signal(true);
+            lutest(!manual_signal.try_wait());
+            manual_signal.trigger();
+            lutest(manual_signal.try_wait());
+            lutest(manual_signal.try_wait());
+            manual_signal.wait();
+            manual_signal.reset();
+            lutest(!manual_signal.try_wait());
+        }
+        {
+            // One auto-reset signal passes exactly one waiting thread for every trigger.
+            FutexSignalTestContext ctx;
+            ctx.num_passed = 0;
+            Ref<IThread> thread = new_thread(futex_ping_pong_func, &ctx);
+            for (u32 i = 0; i < NUM_FUTEX_ITERATIONS; ++i)
+            {
+                ctx.ping.trigger();
+                ctx.pong.wait();
+            }
+            thread->wait();
+            lutest(!ctx.ping.try_wait());
+            lutest(!ctx.pong.try_wait());
+        }
+        {
+            // One manual reset signal passes all waiting threads.
+            FutexSignalTestContext ctx;
+            ctx.num_passed = 0;
+            Ref<IThread> threads[NUM_FUTEX_THREADS];
+            for (auto& t : threads) t = new_thread(futex_start_func, &ctx);
+            sleep(10);
+            lutest(ctx.num_passed == 0);
+            ctx.start.trigger();
+            for (auto& t : threads) t->wait();
+            lutest(ctx.num_passed == NUM_FUTEX_THREADS);
+            lutest(ctx.start.try_wait());
+        }
+        {
+            // FutexSemaphore
+            FutexSemaphore sema(2);
+            lutest(sema.try_acquire());
+            lutest(sema.try_acquire());
+            lutest(!sema.try_acquire());
+            sema.release(3);
+            lutest(sema.try_acquire());
+            lutest(sema.try_acquire());
+            sema.acquire();
+            lutest(!sema.try_acquire());
+        }
+        {
+            // Every release passes exactly one acquire.
+            FutexSemaphoreTestContext ctx;
+            ctx.num_acquired = 0;
+            Ref<IThread> threads[NUM_FUTEX_THREADS];
+            for (auto& t : threads) t = new_thread(futex_semaphore_func, &ctx);
+            for (u32 i = 0; i < NUM_FUTEX_THREADS * NUM_FUTEX_ITERATIONS / 4; ++i)
+            {
+                ctx.sema.release(i & 1 ? 1 : 7);
+            }
+            for (auto& t : threads) t->wait();
+            lutest(ctx.num_acquired == NUM_FUTEX_THREADS * NUM_FUTEX_ITERATIONS);
+            lutest(!ctx.sema.try_acquire());
+        }
+    }
+}
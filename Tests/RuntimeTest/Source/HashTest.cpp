@@ -15,6 +15,8 @@
 #include <Luna/Runtime/HashMap.hpp>
 #include <Luna/Runtime/HashSet.hpp>
 #include <Luna/Runtime/Random.hpp>
+#include <Luna/Runtime/Impl/RobinHoodHashTable.hpp>
+#include <Luna/Runtime/String.hpp>
 
 namespace Luna
 {
@@ -824,4 +826,159 @@ namespace Luna
             }
         }
     }
+    // Runs one fixed sequence of inserts, hits, misses and erases on the table, and returns one checksum of the results.
+    template <typename _Table>
+    static u64 run_hash_table_ops(const Vector<u64>& keys)
+    {
+        _Table t;
+        for (u64 key : keys)
+        {
+            t.insert(make_pair(key, key));
+        }
+        u64 sum = 0;
+        for (u32 round = 0; round < 10; ++round)
+        {
+            for (u64 key : keys)
+            {
+                auto iter = t.find(key);
+                sum += iter->second;
+                // Misses.
+                sum += t.find(key + 1) == t.end() ? 0 : 1;
+            }
+        }
+        for (usize i = 0; i < keys.size(); i += 2)
+        {
+            t.erase(keys[i]);
+        }
+        for (u64 key : keys)
+        {
+            sum += t.contains(key) ? 1 : 0;
+        }
+        lutest(t.size() == keys.size() / 2);
+        return sum;
+    }
+
+    void swiss_hash_test()
+    {
+        {
+            // Erased slots must be reused, or the table grows infinitely.
+            HashMap<int, int, round_10_hash> h;
+            h.insert(make_pair(11, 1));
+            for (int i = 0; i < 10000; ++i)
+            {
+                h.insert(make_pair(i % 100 + 21, 1));
+                h.erase(i % 100 + 21);
+            }
+            lutest(h.size() == 1);
+            lutest(h.hash_table_size() == 16);
+            lutest(h.find(11) != h.end());
+        }
+        {
+            // Keys with the same hash are probed across groups.
+            HashMap<int, int, round_10_hash> h;
+            for (int i = 0; i < 1000; ++i)
+            {
+                h.insert(make_pair(i, i));
+            }
+            for (int i = 0; i < 1000; i += 3)
+            {
+                lutest(h.erase(i) == 1);
+            }
+            for (int i = 0; i < 1000; ++i)
+            {
+                auto iter = h.find(i);
+                if (i % 3 == 0) lutest(iter == h.end());
+                else lutest(iter != h.end() && iter->second == i);
+            }
+            usize n = 0;
+            for (auto iter = h.begin(); iter != h.end(); ++iter) ++n;
+            lutest(n == h.size());
+            h.shrink_to_fit();
+            for (int i = 0; i < 1000; ++i)
+            {
+                lutest(h.contains(i) == (i % 3 != 0));
+            }
+        }
+        TestObject::reset();
+        {
+            // Erase while iterating.
+            HashMap<int, TestObject> h;
+            for (int i = 0; i < 100; ++i)
+            {
+                h.insert(make_pair(i, TestObject(i, true)));
+            }
+            for (auto iter = h.begin(); iter != h.end();)
+            {
+                if (iter->first % 2) iter = h.erase(iter);
+                else ++iter;
+            }
+            lutest(h.size() == 50);
+            for (int i = 0; i < 100; ++i)
+            {
+                lutest(h.contains(i) == (i % 2 == 0));
+            }
+        }
+        lutest(TestObject::is_clear());
+        {
+            // Checks results against the Robin Hood hash table.
+            using robin_hood_map = RobinHoodHashing::HashTable<u64, Pair<const u64, u64>, Impl::MapExtractKey<u64, Pair<const u64, u64>>>;
+            constexpr usize num_keys = 100000;
+            Vector<u64> keys;
+            keys.reserve(num_keys);
+            for (usize i = 0; i < num_keys; ++i)
+            {
+                keys.push_back((u64)i * 4096);
+            }
+            u64 sum = run_hash_table_ops<HashMap<u64, u64>>(keys);
+            // Every key is hit 10 times, every miss is counted as 0, and half of the keys remain after erasing.
+            u64 expected = (u64)num_keys / 2;
+            for (u64 key : keys) expected += key * 10;
+            lutest(sum == expected);
+            lutest(run_hash_table_ops<robin_hood_map>(keys) == expected);
+        }
+    }
+    void hash_function_test()
+    {
+        {
+            // Compile-time string hashing.
+            constexpr u64 h = strhash64("Luna");
+            lutest(h == memhash64("Luna", 4));
+        }
+        {
+            u8 data[129];
+            for (usize i = 0; i < 129; ++i)
+            {
+                data[i] = (u8)(i * 7 + 3);
+            }
+            HashSet<u64> hashes;
+            for (usize i = 0; i <= 128; ++i)
+            {
+                u64 h = wyhash(data, i);
+                // The result does not depend on the alignment of the data.
+                u8 unaligned[130];
+                memcpy(unaligned + 1, data, i);
+                lutest(wyhash(unaligned + 1, i) == h);
+                lutest(wyhash(data, i, 1) != h);
+                hashes.insert(h);
+            }
+            lutest(hashes.size() == 129);
+        }
+        {
+            HashMap<String, usize> h;
+            c8 buf[32];
+            for (usize i = 0; i < 1000; ++i)
+            {
+                snprintf(buf, 32, "String%u", (u32)i);
+                h.insert(make_pair(String(buf), i));
+            }
+            lutest(h.size() == 1000);
+            for (usize i = 0; i < 1000; ++i)
+            {
+                snprintf(buf, 32, "String%u", (u32)i);
+                auto iter = h.find(String(buf));
+                lutest(iter != h.end() && iter->second == i);
+            }
+            lutest(h.find(String("String1000")) == h.end());
+        }
+    }
 }
\ No newline at end of file
@@ -0,0 +1,99 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file InlineVectorTest.cpp
+* @author JXMaster
+* @date 2024/3/10
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/InlineVector.hpp>
+
+namespace Luna
+{
+    void inline_vector_test()
+    {
+        TestObject::reset();
+        {
+            // Elements are stored inline until the capacity is exceeded.
+            usize allocated = get_allocated_memory();
+            InlineVector<TestObject, 4> vec1;
+            lutest(vec1.empty());
+            lutest(vec1.capacity() == 4);
+            for (i32 i = 0; i < 4; ++i)
+            {
+                vec1.push_back(TestObject(i));
+            }
+            lutest(vec1.size() == 4);
+            lutest(allocated == get_allocated_memory());
+            lutest((usize)vec1.data() >= (usize)&vec1 && (usize)vec1.data() < (usize)(&vec1 + 1));
+
+            // Spills to the allocator.
+            vec1.push_back(TestObject(4));
+            lutest(vec1.size() == 5);
+            lutest(vec1.capacity() > 4);
+            for (i32 i = 0; i < 5; ++i)
+            {
+                lutest(vec1[i] == TestObject(i));
+            }
+
+            // Moves back to the inline storage.
+            vec1.pop_back();
+            vec1.shrink_to_fit();
+            lutest(vec1.capacity() == 4);
+            lutest(vec1.size() == 4 && vec1.back() == TestObject(3));
+            lutest(allocated == get_allocated_memory());
+
+            // Move ctor from inline storage.
+            InlineVector<TestObject, 4> vec2(move(vec1));
+            lutest(vec1.empty());
+            lutest(vec2.size() == 4 && vec2[2] == TestObject(2));
+
+            // Move ctor from allocated buffer.
+            vec2.insert(vec2.begin(), TestObject(10));
+            lutest(vec2.size() == 5 && vec2[0] == TestObject(10) && vec2[4] == TestObject(3));
+            const TestObject* data = vec2.data();
+            InlineVector<TestObject, 4> vec3(move(vec2));
+            lutest(vec3.data() == data);
+            lutest(vec2.empty() && vec2.capacity() == 4);
+
+            // Copy and move assignment.
+            vec1 = vec3;
+            lutest(vec1.size() == 5 && vec1[4] == TestObject(3));
+            vec2 = { TestObject(1), TestObject(2) };
+            vec3 = move(vec2);
+            lutest(vec3.size() == 2 && vec3[1] == TestObject(2));
+            lutest(vec2.empty());
+
+            // Swap between inline and allocated storage.
+            vec1.swap(vec3);
+            lutest(vec1.size() == 2 && vec3.size() == 5);
+            lutest(vec1[0] == TestObject(1) && vec3[0] == TestObject(10));
+
+            vec3.erase(vec3.begin(), vec3.begin() + 3);
+            lutest(vec3.size() == 2 && vec3[0] == TestObject(2));
+            vec3.clear();
+            vec3.shrink_to_fit();
+            vec1.resize(8);
+            lutest(vec1.size() == 8 && vec1[7] == TestObject(0));
+        }
+        lutest(TestObject::is_clear());
+        TestObject::reset();
+        {
+            // Inline vectors in vectors are relocated correctly.
+            Vector<InlineVector<u32, 2>> vecs;
+            for (u32 i = 0; i < 100; ++i)
+            {
+                vecs.emplace_back();
+                vecs.back().push_back(i);
+                if (i % 2) vecs.back().push_back(i);
+            }
+            for (u32 i = 0; i < 100; ++i)
+            {
+                lutest(vecs[i].size() == ((i % 2) ? 2 : 1));
+                lutest(vecs[i][0] == i);
+            }
+        }
+    }
+}
@@ -0,0 +1,129 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file LogTest.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Log.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/String.hpp>
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    constexpr u32 NUM_LOGS_PER_THREAD = 1000;
+
+    static void log_test_thread(void* params)
+    {
+        for (u32 i = 0; i < NUM_LOGS_PER_THREAD; ++i)
+        {
+            log_info("LogTest", "Thread log %u", i);
+        }
+    }
+
+    static Vector<String> g_deferred_logs;
+
+    static void deferred_log_test_handler(LogVerbosity verbosity, const c8* tag, usize tag_length, const c8* message, usize message_length)
+    {
+        if (!strcmp(tag, "DeferredLogTest"))
+        {
+            g_deferred_logs.push_back(String(message, message_length));
+        }
+    }
+
+    static void deferred_log_test_thread(void* params)
+    {
+        for (u32 i = 0; i < NUM_LOGS_PER_THREAD; ++i)
+        {
+            log_deferred(LogVerbosity::verbose, "DeferredLogTest", "%u", i);
+        }
+    }
+
+    static u64 get_log_test_file_size(const c8* path)
+    {
+        auto attr = get_file_attribute(path);
+        return succeeded(attr) ? attr.get().size : 0;
+    }
+
+    void log_test()
+    {
+        set_log_to_platform_enabled(false);
+        {
+            // Logs are written to the file only by the writer thread.
+            auto _ = delete_file("LogTest.txt");
+            set_log_file("LogTest.txt");
+            set_log_to_file_enabled(true);
+            auto t = new_thread(log_test_thread, nullptr);
+            for (u32 i = 0; i < NUM_LOGS_PER_THREAD; ++i)
+            {
+                log_info("LogTest", "Main log %u", i);
+            }
+            t->wait();
+            lutest(flush_log_to_file());
+            auto file = open_file("LogTest.txt", FileOpenFlag::read, FileCreationMode::open_existing);
+            lutest(succeeded(file));
+            auto data = load_file_data(file.get());
+            lutest(succeeded(data));
+            usize num_lines = 0;
+            for (usize i = 0; i < data.get().size(); ++i)
+            {
+                if (((const c8*)data.get().data())[i] == '\n') ++num_lines;
+            }
+            lutest(num_lines == NUM_LOGS_PER_THREAD * 2);
+            file.get().reset();
+        }
+        {
+            // Tests size-based rotation.
+            set_log_file_rotation(4_kb, 0, 2);
+            for (u32 i = 0; i < NUM_LOGS_PER_THREAD; ++i)
+            {
+                log_info("LogTest", "Rotation log %u", i);
+            }
+            lutest(flush_log_to_file());
+            u64 size = get_log_test_file_size("LogTest.txt");
+            lutest(size > 0 && size <= 4_kb);
+            size = get_log_test_file_size("LogTest.txt.1");
+            lutest(size > 0 && size <= 4_kb);
+            size = get_log_test_file_size("LogTest.txt.2");
+            lutest(size > 0 && size <= 4_kb);
+            lutest(failed(get_file_attribute("LogTest.txt.3")));
+            set_log_file_rotation(0, 0, 0);
+        }
+        {
+            // Deferred logs are formatted on the writer thread.
+            usize handler = register_log_handler(deferred_log_test_handler);
+            log_deferred(LogVerbosity::info, "DeferredLogTest", "int %d uint %u hex %x float %.2f str %s %%", -5, 7u, 255, 3.14159, "abc");
+            log_deferred(LogVerbosity::info, "DeferredLogTest", "width [%5s] [%-4d] [%03lld]", "ab", 12, 7);
+            log_deferred(LogVerbosity::info, "DeferredLogTest", "missing %d");
+            lutest(flush_log_to_file());
+            lutest(g_deferred_logs.size() == 3);
+            lutest(!strcmp(g_deferred_logs[0].c_str(), "int -5 uint 7 hex ff float 3.14 str abc %"));
+            lutest(!strcmp(g_deferred_logs[1].c_str(), "width [   ab] [12  ] [007]"));
+            lutest(!strcmp(g_deferred_logs[2].c_str(), "missing <missing>"));
+            g_deferred_logs.clear();
+            // Logs from one thread are dispatched in order.
+            auto t = new_thread(deferred_log_test_thread, nullptr);
+            t->wait();
+            lutest(flush_log_to_file());
+            lutest(g_deferred_logs.size() == NUM_LOGS_PER_THREAD);
+            for (u32 i = 0; i < NUM_LOGS_PER_THREAD; ++i)
+            {
+                lutest(atoi(g_deferred_logs[i].c_str()) == (int)i);
+            }
+            unregister_log_handler(handler);
+            g_deferred_logs.clear();
+            g_deferred_logs.shrink_to_fit();
+        }
+        set_log_to_file_enabled(false);
+        set_log_file("./Log.txt");
+        lutest(succeeded(delete_file("LogTest.txt")));
+        lutest(succeeded(delete_file("LogTest.txt.1")));
+        lutest(succeeded(delete_file("LogTest.txt.2")));
+        set_log_to_platform_enabled(true);
+    }
+}
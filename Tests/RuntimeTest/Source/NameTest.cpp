@@ -9,9 +9,30 @@
 */
 #include "TestCommon.hpp"
 #include <Luna/Runtime/Name.hpp>
+#include <Luna/Runtime/Thread.hpp>
 
 namespace Luna
 {
+    static void name_thread_func(void* params)
+    {
+        const c8** results = (const c8**)params;
+        char str[16];
+        // Names are interned and released many times, so that names are released and recreated concurrently.
+        for (int round = 0; round < 100; ++round)
+        {
+            for (int i = 0; i < 100; ++i)
+            {
+                snprintf(str, 16, u8"ThreadName%d", i);
+                Name n = str;
+                lutest(n.size() == strlen(str) && !strcmp(n.c_str(), str));
+            }
+        }
+        for (int i = 0; i < 100; ++i)
+        {
+            snprintf(str, 16, u8"ThreadName%d", i);
+            results[i] = intern_name(str);
+        }
+    }
     void name_test()
     {
         // name object test.
@@ -53,5 +74,36 @@ namespace Luna
             Name n("Sample");
         }
 
+        {
+            // Interns names from multiple threads.
+            constexpr usize NUM_THREADS = 8;
+            const c8* results[NUM_THREADS][100];
+            {
+                Ref<IThread> threads[NUM_THREADS];
+                for (usize i = 0; i < NUM_THREADS; ++i)
+                {
+                    threads[i] = new_thread(name_thread_func, results[i]);
+                }
+                for (auto& t : threads)
+                {
+                    t->wait();
+                }
+            }
+            for (usize t = 1; t < NUM_THREADS; ++t)
+            {
+                for (usize i = 0; i < 100; ++i)
+                {
+                    lutest(results[t][i] == results[0][i]);
+                }
+            }
+            for (usize t = 0; t < NUM_THREADS; ++t)
+            {
+                for (usize i = 0; i < 100; ++i)
+                {
+                    release_name(results[t][i]);
+                }
+            }
+        }
+
     }
 }
@@ -0,0 +1,130 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file ObjectTest.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Ref.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Vector.hpp>
+
+namespace Luna
+{
+    struct ConfinedObject
+    {
+        lustruct("ConfinedObject", "{2B7E8F41-6C0D-4A95-B3E2-19D4F7A6C850}");
+        i32 value = 0;
+    };
+
+    struct SharedObject
+    {
+        lustruct("SharedObject", "{8D3A5C17-F2B9-4E60-A7D1-C05E9B48F236}");
+        i32 value = 0;
+    };
+
+    static void shared_object_thread_func(void* params)
+    {
+        SharedObject* obj = (SharedObject*)params;
+        for (usize i = 0; i < 10000; ++i)
+        {
+            Ref<SharedObject> r = obj;
+            BorrowedRef<SharedObject> b = r;
+            lutest(b->value == 5);
+        }
+    }
+
+    void object_test()
+    {
+        register_boxed_type<ConfinedObject>();
+        register_boxed_type<SharedObject>();
+        {
+            // Objects are not thread-confined by default.
+            Ref<SharedObject> obj = new_object<SharedObject>();
+            lutest(!object_is_thread_confined(obj.object()));
+            lutest(object_is_accessible_from_current_thread(obj.object()));
+            object_set_thread_confined(obj.object(), true);
+            lutest(object_is_thread_confined(obj.object()));
+            {
+                // Reference counters work normally for thread-confined objects.
+                Ref<SharedObject> obj2 = obj;
+                lutest(object_ref_count(obj.object()) == 2);
+                WeakRef<SharedObject> weak = obj;
+                lutest(object_weak_ref_count(obj.object()) == 1);
+                Ref<SharedObject> obj3 = weak.pin();
+                lutest(obj3 == obj);
+                lutest(object_ref_count(obj.object()) == 3);
+            }
+            lutest(object_ref_count(obj.object()) == 1);
+            lutest(object_weak_ref_count(obj.object()) == 0);
+            {
+                // Thread-confined objects expire when the last strong reference is released.
+                WeakRef<SharedObject> weak = obj;
+                obj.reset();
+                lutest(!weak.pin());
+            }
+        }
+        {
+            // Types can be marked as thread-confined.
+            lutest(!is_type_thread_confined(typeof<ConfinedObject>()));
+            set_type_thread_confined(typeof<ConfinedObject>(), true);
+            lutest(is_type_thread_confined(typeof<ConfinedObject>()));
+            Ref<ConfinedObject> obj = new_object<ConfinedObject>();
+            lutest(object_is_thread_confined(obj.object()));
+            lutest(object_is_accessible_from_current_thread(obj.object()));
+            set_type_thread_confined(typeof<ConfinedObject>(), false);
+            lutest(!is_type_thread_confined(typeof<ConfinedObject>()));
+            Ref<ConfinedObject> obj2 = new_object<ConfinedObject>();
+            lutest(!object_is_thread_confined(obj2.object()));
+            lutest(object_is_thread_confined(obj.object()));
+        }
+        {
+            // Borrowed references do not modify reference counters.
+            Vector<Ref<SharedObject>> objs;
+            for (i32 i = 0; i < 16; ++i)
+            {
+                Ref<SharedObject> obj = new_object<SharedObject>();
+                obj->value = i;
+                objs.push_back(obj);
+            }
+            Vector<BorrowedRef<SharedObject>> borrowed;
+            for (auto& i : objs)
+            {
+                borrowed.push_back(i);
+            }
+            for (usize i = 0; i < borrowed.size(); ++i)
+            {
+                lutest(borrowed[i]->value == (i32)i);
+                lutest(borrowed[i].object() == objs[i].object());
+                lutest(object_ref_count(objs[i].object()) == 1);
+            }
+            Ref<SharedObject> pinned = borrowed[3].pin();
+            lutest(pinned == objs[3]);
+            lutest(object_ref_count(objs[3].object()) == 2);
+            BorrowedRef<SharedObject> null_ref;
+            lutest(!null_ref.valid());
+            lutest(!null_ref.pin());
+        }
+        {
+            // Thread-confined objects can be passed to other threads after unconfined.
+            Ref<SharedObject> obj = new_object<SharedObject>();
+            obj->value = 5;
+            object_set_thread_confined(obj.object(), true);
+            object_set_thread_confined(obj.object(), false);
+            constexpr usize NUM_THREADS = 4;
+            Ref<IThread> threads[NUM_THREADS];
+            for (usize i = 0; i < NUM_THREADS; ++i)
+            {
+                threads[i] = new_thread(shared_object_thread_func, obj.get());
+            }
+            for (auto& t : threads)
+            {
+                t->wait();
+            }
+            lutest(object_ref_count(obj.object()) == 1);
+        }
+    }
+}
@@ -0,0 +1,63 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file PerfCounterTest.cpp
+* @author JXMaster
+* @date 2024/5/20
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/PerfCounter.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <string.h>
+
+namespace Luna
+{
+    static perf_counter_t g_test_counter = 0;
+
+    static void perf_counter_test_thread(void* params)
+    {
+        for (u32 i = 0; i < 1000; ++i)
+        {
+            perf_counter_add(g_test_counter, 2);
+        }
+    }
+
+    void perf_counter_test()
+    {
+        g_test_counter = register_perf_counter("PerfCounterTest.Counter", PerfCounterType::counter, "bytes");
+        lutest(g_test_counter);
+        // Registering one counter with the same name returns the same handle.
+        lutest(register_perf_counter("PerfCounterTest.Counter", PerfCounterType::counter) == g_test_counter);
+        PerfCounterDesc desc = get_perf_counter_desc(g_test_counter);
+        lutest(!strcmp(desc.name, "PerfCounterTest.Counter"));
+        lutest(!strcmp(desc.unit, "bytes"));
+        lutest(desc.type == PerfCounterType::counter);
+        lutest(get_num_perf_counters() >= g_test_counter);
+
+        i64 base = get_perf_counter_value(g_test_counter);
+        perf_counter_add(g_test_counter, 10);
+        lutest(get_perf_counter_value(g_test_counter) == base + 10);
+        // Values added by threads that have exited are kept.
+        auto t1 = new_thread(perf_counter_test_thread, nullptr);
+        auto t2 = new_thread(perf_counter_test_thread, nullptr);
+        t1->wait();
+        t2->wait();
+        t1.reset();
+        t2.reset();
+        lutest(get_perf_counter_value(g_test_counter) == base + 4010);
+
+        perf_counter_t gauge = register_perf_counter("PerfCounterTest.Gauge", PerfCounterType::gauge);
+        lutest(gauge && gauge != g_test_counter);
+        perf_counter_set(gauge, 42);
+        lutest(get_perf_counter_value(gauge) == 42);
+        perf_counter_set(gauge, 7);
+        lutest(get_perf_counter_value(gauge) == 7);
+
+        // Null handles are ignored.
+        perf_counter_add(0, 1);
+        perf_counter_set(0, 1);
+        lutest(get_perf_counter_value(0) == 0);
+    }
+}
@@ -0,0 +1,283 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file ProfilerTest.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/Memory.hpp>
+#include <Luna/Runtime/Vector.hpp>
+#include <Luna/Runtime/File.hpp>
+#include <Luna/Runtime/Thread.hpp>
+#include <Luna/Runtime/Atomic.hpp>
+#include <string.h>
+
+namespace Luna
+{
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+    static usize g_num_allocate_events = 0;
+    static u32 g_max_captured_frames = 0;
+
+    static void profiler_test_callback(const ProfilerEvent& event)
+    {
+        if (event.id == ProfilerEventId::MEMORY_ALLOCATE)
+        {
+            ProfilerEventData::MemoryAllocate* data = (ProfilerEventData::MemoryAllocate*)event.data;
+            ++g_num_allocate_events;
+            g_max_captured_frames = max(g_max_captured_frames, data->num_frames);
+        }
+    }
+#endif
+
+    static usize g_num_zone_begin_events = 0;
+    static usize g_num_zone_end_events = 0;
+    static void profiler_zone_test_callback(const ProfilerEvent& event)
+    {
+        if (event.id == ProfilerEventId::CPU_ZONE_BEGIN)
+        {
+            ProfilerEventData::CpuZoneBegin* data = (ProfilerEventData::CpuZoneBegin*)event.data;
+            if (!strcmp(data->name, "ProfilerTestZone")) ++g_num_zone_begin_events;
+        }
+        else if (event.id == ProfilerEventId::CPU_ZONE_END)
+        {
+            ++g_num_zone_end_events;
+        }
+    }
+    static void profiler_zone_test_thread(void* params)
+    {
+        for (u32 i = 0; i < 10; ++i)
+        {
+            ProfilerZone zone("ProfilerTestThreadZone");
+        }
+    }
+    static usize count_substrings(const c8* str, const c8* substr)
+    {
+        usize r = 0;
+        usize len = strlen(substr);
+        for (const c8* cur = strstr(str, substr); cur; cur = strstr(cur + len, substr)) ++r;
+        return r;
+    }
+    static void profiler_zone_test()
+    {
+        {
+            // Zone events are emitted whether or not one capture is started.
+            auto handle = register_profiler_callback(profiler_zone_test_callback);
+            g_num_zone_begin_events = 0;
+            g_num_zone_end_events = 0;
+            {
+                ProfilerZone zone("ProfilerTestZone");
+            }
+            unregister_profiler_callback(handle);
+            lutest(g_num_zone_begin_events == 1);
+            lutest(g_num_zone_end_events == 1);
+        }
+        {
+            // Unbalanced zones are trimmed, so the exported trace is always well nested.
+            profiler_zone_begin("ProfilerTestOuterZone");
+            begin_profiler_trace_capture();
+            lutest(is_profiler_trace_capturing());
+            profiler_zone_end();
+            for (u32 i = 0; i < 10; ++i)
+            {
+                ProfilerZone zone("ProfilerTestZone");
+                ProfilerZone inner_zone("Profiler\"Test\"InnerZone");
+            }
+            auto t = new_thread(profiler_zone_test_thread, nullptr);
+            t->wait();
+            profiler_zone_begin("ProfilerTestUnendedZone");
+            lutest(succeeded(end_profiler_trace_capture("ProfilerTest.json")));
+            profiler_zone_end();
+            lutest(!is_profiler_trace_capturing());
+            auto file = open_file("ProfilerTest.json", FileOpenFlag::read, FileCreationMode::open_existing);
+            lutest(succeeded(file));
+            auto data = load_file_data(file.get());
+            lutest(succeeded(data));
+            file.get().reset();
+            String json((const c8*)data.get().data(), data.get().size());
+            const c8* str = json.c_str();
+            lutest(count_substrings(str, "\"name\":\"ProfilerTestZone\"") == 10);
+            lutest(count_substrings(str, "\"name\":\"Profiler\\\"Test\\\"InnerZone\"") == 10);
+            lutest(count_substrings(str, "\"name\":\"ProfilerTestThreadZone\"") == 10);
+            lutest(count_substrings(str, "\"name\":\"ProfilerTestUnendedZone\"") == 1);
+            lutest(count_substrings(str, "ProfilerTestOuterZone") == 0);
+            lutest(count_substrings(str, "\"ph\":\"B\"") == 31);
+            lutest(count_substrings(str, "\"ph\":\"E\"") == 31);
+            lutest(count_substrings(str, "\"ph\":\"M\"") == 2);
+            lutest(succeeded(delete_file("ProfilerTest.json")));
+        }
+        {
+            // Records are discarded if no path is specified.
+            begin_profiler_trace_capture();
+            {
+                ProfilerZone zone("ProfilerTestZone");
+            }
+            lutest(succeeded(end_profiler_trace_capture(nullptr)));
+        }
+    }
+
+    namespace ProfilerTestEventId
+    {
+        constexpr u64 BATCH_TEST = strhash64("PROFILER_BATCH_TEST");
+    }
+    struct ProfilerBatchTestData
+    {
+        u32 source;
+        u32 index;
+        ProfilerBatchTestData(u32 source, u32 index) : source(source), index(index) {}
+        ~ProfilerBatchTestData()
+        {
+            atom_inc_u32(&g_num_destructed);
+        }
+        static u32 volatile g_num_destructed;
+    };
+    u32 volatile ProfilerBatchTestData::g_num_destructed = 0;
+    constexpr u32 NUM_BATCH_TEST_EVENTS = 1000;
+    static usize g_num_batch_test_events = 0;
+    static usize g_num_batch_test_spans = 0;
+    static u32 g_batch_test_next_index[3] = {0, 0, 0};
+    static bool g_batch_test_ordered = true;
+    static void submit_batch_test_events(u32 source)
+    {
+        for (u32 i = 0; i < NUM_BATCH_TEST_EVENTS; ++i)
+        {
+            ProfilerBatchTestData* data = allocate_profiler_event_data<ProfilerBatchTestData>();
+            new (data) ProfilerBatchTestData(source, i);
+            submit_profiler_event(ProfilerTestEventId::BATCH_TEST);
+        }
+    }
+    static void profiler_batch_test_thread(void* params)
+    {
+        submit_batch_test_events((u32)(usize)params);
+    }
+    static void profiler_batch_test_callback(Span<const ProfilerEvent> events)
+    {
+        bool counted = false;
+        for (auto& e : events)
+        {
+            if (e.id != ProfilerTestEventId::BATCH_TEST) continue;
+            const ProfilerBatchTestData* data = (const ProfilerBatchTestData*)e.data;
+            // Events of one thread are dispatched in submission order.
+            if (data->index != g_batch_test_next_index[data->source]) g_batch_test_ordered = false;
+            g_batch_test_next_index[data->source] = data->index + 1;
+            ++g_num_batch_test_events;
+            counted = true;
+        }
+        if (counted) ++g_num_batch_test_spans;
+    }
+    static void profiler_batch_test()
+    {
+        auto handle = register_profiler_batch_callback(profiler_batch_test_callback);
+        ProfilerBatchTestData::g_num_destructed = 0;
+        {
+            // Every event is dispatched as one span in immediate mode.
+            lutest(!is_profiler_batch_mode());
+            submit_batch_test_events(0);
+            lutest(g_num_batch_test_events == NUM_BATCH_TEST_EVENTS);
+            lutest(g_num_batch_test_spans == NUM_BATCH_TEST_EVENTS);
+            lutest(ProfilerBatchTestData::g_num_destructed == NUM_BATCH_TEST_EVENTS);
+        }
+        {
+            // Events are buffered until they are flushed in batch mode.
+            g_num_batch_test_events = 0;
+            g_num_batch_test_spans = 0;
+            ProfilerBatchTestData::g_num_destructed = 0;
+            for (auto& i : g_batch_test_next_index) i = 0;
+            set_profiler_batch_mode(true);
+            lutest(is_profiler_batch_mode());
+            submit_batch_test_events(0);
+            // Threads exit before their events are flushed.
+            auto t1 = new_thread(profiler_batch_test_thread, (void*)1);
+            auto t2 = new_thread(profiler_batch_test_thread, (void*)2);
+            t1->wait();
+            t2->wait();
+            lutest(g_num_batch_test_events == 0);
+            lutest(ProfilerBatchTestData::g_num_destructed == 0);
+            flush_profiler_events();
+            lutest(g_batch_test_ordered);
+            lutest(g_num_batch_test_events == NUM_BATCH_TEST_EVENTS * 3);
+            lutest(g_num_batch_test_spans < NUM_BATCH_TEST_EVENTS);
+            lutest(ProfilerBatchTestData::g_num_destructed == NUM_BATCH_TEST_EVENTS * 3);
+            // Pending events are flushed when batch mode is disabled.
+            submit_batch_test_events(0);
+            lutest(g_num_batch_test_events == NUM_BATCH_TEST_EVENTS * 3);
+            set_profiler_batch_mode(false);
+            lutest(g_num_batch_test_events == NUM_BATCH_TEST_EVENTS * 4);
+            lutest(ProfilerBatchTestData::g_num_destructed == NUM_BATCH_TEST_EVENTS * 4);
+        }
+        unregister_profiler_batch_callback(handle);
+    }
+
+    void profiler_test()
+    {
+        profiler_zone_test();
+        profiler_batch_test();
+#ifdef LUNA_MEMORY_PROFILER_ENABLED
+        constexpr usize NUM_BLOCKS = 100000;
+        constexpr usize BLOCK_SIZE = 64;
+        auto handle = register_profiler_callback(profiler_test_callback);
+        Vector<void*> blocks;
+        blocks.reserve(NUM_BLOCKS);
+        {
+            // Every allocation is recorded if sampling is disabled.
+            lutest(memory_profiler_get_sample_interval() == 0);
+            MemoryProfilerCounters before = memory_profiler_get_domain_counters("ProfilerTest");
+            usize allocated = 0;
+            for (usize i = 0; i < 100; ++i)
+            {
+                void* mem = memalloc(BLOCK_SIZE);
+                memory_profiler_set_memory_domain(mem, "ProfilerTest");
+                allocated += memsize(mem);
+                blocks.push_back(mem);
+            }
+            MemoryProfilerCounters after = memory_profiler_get_domain_counters("ProfilerTest");
+            lutest(after.num_allocations - before.num_allocations == 100);
+            lutest(after.allocated_bytes - before.allocated_bytes == allocated);
+            for (void* mem : blocks) memfree(mem);
+            blocks.clear();
+            after = memory_profiler_get_domain_counters("ProfilerTest");
+            lutest(after.num_deallocations - before.num_deallocations == 100);
+            lutest(after.deallocated_bytes - before.deallocated_bytes == allocated);
+        }
+        {
+            // Only a part of allocations is recorded in sampling mode, but the estimated size should be close
+            // to the real size.
+            memory_profiler_set_sampling(4096);
+            MemoryProfilerCounters before = memory_profiler_get_type_counters("ProfilerTestType");
+            usize num_events = g_num_allocate_events;
+            usize allocated = 0;
+            for (usize i = 0; i < NUM_BLOCKS; ++i)
+            {
+                void* mem = memalloc(BLOCK_SIZE);
+                memory_profiler_set_memory_type(mem, "ProfilerTestType");
+                allocated += memsize(mem);
+                blocks.push_back(mem);
+            }
+            num_events = g_num_allocate_events - num_events;
+            lutest(num_events > 0 && num_events < NUM_BLOCKS / 10);
+            MemoryProfilerCounters after = memory_profiler_get_type_counters("ProfilerTestType");
+            u64 estimated = after.allocated_bytes - before.allocated_bytes;
+            lutest(estimated > allocated / 10 * 8 && estimated < allocated / 10 * 12);
+            for (void* mem : blocks) memfree(mem);
+            blocks.clear();
+            after = memory_profiler_get_type_counters("ProfilerTestType");
+            lutest(after.deallocated_bytes - before.deallocated_bytes == estimated);
+            memory_profiler_set_sampling(0);
+        }
+        {
+            // Tests stack capture.
+            memory_profiler_set_sampling(0, 8);
+            g_max_captured_frames = 0;
+            void* mem = memalloc(BLOCK_SIZE);
+            memfree(mem);
+            lutest(g_max_captured_frames > 0 && g_max_captured_frames <= 8);
+            memory_profiler_set_sampling(0);
+        }
+        blocks.clear();
+        blocks.shrink_to_fit();
+        unregister_profiler_callback(handle);
+#endif
+    }
+}
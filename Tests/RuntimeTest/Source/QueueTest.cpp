@@ -0,0 +1,158 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file QueueTest.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/SPSCQueue.hpp>
+#include <Luna/Runtime/MPMCQueue.hpp>
+#include <Luna/Runtime/Thread.hpp>
+
+namespace Luna
+{
+    constexpr usize NUM_QUEUE_ITEMS = 100000;
+
+    static void spsc_producer_func(void* params)
+    {
+        SPSCQueue<usize>* queue = (SPSCQueue<usize>*)params;
+        for (usize i = 0; i < NUM_QUEUE_ITEMS; ++i)
+        {
+            while (!queue->push(i)) yield_current_thread();
+        }
+    }
+
+    struct MPMCQueueTestContext
+    {
+        MPMCQueue<usize>* queue;
+        usize volatile num_popped;
+        usize volatile sum;
+    };
+
+    static void mpmc_producer_func(void* params)
+    {
+        MPMCQueueTestContext* ctx = (MPMCQueueTestContext*)params;
+        for (usize i = 1; i <= NUM_QUEUE_ITEMS; ++i)
+        {
+            while (!ctx->queue->push(i)) yield_current_thread();
+        }
+    }
+
+    static void mpmc_consumer_func(void* params)
+    {
+        MPMCQueueTestContext* ctx = (MPMCQueueTestContext*)params;
+        usize sum = 0;
+        while (true)
+        {
+            usize v;
+            if (ctx->queue->pop(v))
+            {
+                sum += v;
+                atom_inc_usize(&ctx->num_popped);
+            }
+            else if (ctx->num_popped == NUM_QUEUE_ITEMS * 4)
+            {
+                break;
+            }
+            else
+            {
+                yield_current_thread();
+            }
+        }
+        atom_add_usize(&ctx->sum, (isize)sum);
+    }
+
+    void queue_test()
+    {
+        TestObject::reset();
+        {
+            // Single-threaded operations.
+            SPSCQueue<TestObject> queue(3);
+            lutest(queue.capacity() == 4);
+            lutest(queue.empty());
+            for (i32 i = 0; i < 4; ++i)
+            {
+                lutest(queue.push(TestObject(i)));
+            }
+            lutest(!queue.push(TestObject(4)));
+            lutest(queue.size() == 4);
+            TestObject obj;
+            for (i32 i = 0; i < 2; ++i)
+            {
+                lutest(queue.pop(obj));
+                lutest(obj.m_value == i);
+            }
+            // Wraps around the buffer.
+            lutest(queue.emplace(1, 2, 3));
+            lutest(queue.emplace(5));
+            lutest(queue.size() == 4);
+            lutest(queue.pop(obj) && obj.m_value == 2);
+            lutest(queue.pop(obj) && obj.m_value == 3);
+            lutest(queue.pop(obj) && obj.m_value == 6);
+            lutest(queue.pop(obj) && obj.m_value == 5);
+            lutest(!queue.pop(obj));
+            lutest(queue.empty());
+            // Elements left in the queue are destroyed with the queue.
+            queue.push(TestObject(7));
+            queue.push(TestObject(8));
+        }
+        lutest(TestObject::is_clear());
+        TestObject::reset();
+        {
+            MPMCQueue<TestObject> queue(1);
+            lutest(queue.capacity() == 2);
+            lutest(queue.push(TestObject(1)));
+            lutest(queue.push(TestObject(2)));
+            lutest(!queue.push(TestObject(3)));
+            TestObject obj;
+            lutest(queue.pop(obj) && obj.m_value == 1);
+            lutest(queue.emplace(1, 1, 1));
+            lutest(queue.pop(obj) && obj.m_value == 2);
+            lutest(queue.pop(obj) && obj.m_value == 3);
+            lutest(!queue.pop(obj));
+            lutest(queue.empty());
+            queue.push(TestObject(4));
+        }
+        lutest(TestObject::is_clear());
+        {
+            // One producer and one consumer.
+            SPSCQueue<usize> queue(64);
+            Ref<IThread> producer = new_thread(spsc_producer_func, &queue);
+            usize expected = 0;
+            while (expected < NUM_QUEUE_ITEMS)
+            {
+                usize v;
+                if (queue.pop(v))
+                {
+                    lutest(v == expected);
+                    ++expected;
+                }
+            }
+            producer->wait();
+            lutest(queue.empty());
+        }
+        {
+            // Multiple producers and multiple consumers.
+            MPMCQueue<usize> queue(256);
+            MPMCQueueTestContext ctx;
+            ctx.queue = &queue;
+            ctx.num_popped = 0;
+            ctx.sum = 0;
+            Ref<IThread> threads[8];
+            for (usize i = 0; i < 4; ++i)
+            {
+                threads[i] = new_thread(mpmc_producer_func, &ctx);
+                threads[i + 4] = new_thread(mpmc_consumer_func, &ctx);
+            }
+            for (auto& t : threads)
+            {
+                t->wait();
+            }
+            lutest(ctx.sum == NUM_QUEUE_ITEMS * (NUM_QUEUE_ITEMS + 1) / 2 * 4);
+            lutest(queue.empty());
+        }
+    }
+}
@@ -11,9 +11,42 @@
 #include <Luna/Runtime/Serialization.hpp>
 #include <Luna/Runtime/HashMap.hpp>
 #include <Luna/Runtime/Tuple.hpp>
+#include <Luna/Runtime/StaticSerialization.hpp>
 
 namespace Luna
 {
+    struct StaticSerializeTestInner
+    {
+        Name name;
+        Vector<f32> values;
+        lufields(lufield(StaticSerializeTestInner, name), lufield(StaticSerializeTestInner, values));
+    };
+    struct StaticSerializeTestOuter
+    {
+        i32 a;
+        bool b;
+        String c;
+        Guid d;
+        Vector<StaticSerializeTestInner> inners;
+        lufields(lufield(StaticSerializeTestOuter, a), lufield(StaticSerializeTestOuter, b), lufield(StaticSerializeTestOuter, c),
+            lufield(StaticSerializeTestOuter, d), lufield(StaticSerializeTestOuter, inners));
+    };
+    static bool operator==(const StaticSerializeTestOuter& lhs, const StaticSerializeTestOuter& rhs)
+    {
+        if (lhs.a != rhs.a || lhs.b != rhs.b || lhs.c.compare(rhs.c) != 0 || lhs.d != rhs.d || lhs.inners.size() != rhs.inners.size()) return false;
+        for (usize i = 0; i < lhs.inners.size(); ++i)
+        {
+            auto& l = lhs.inners[i];
+            auto& r = rhs.inners[i];
+            if (l.name != r.name || l.values.size() != r.values.size()) return false;
+            for (usize j = 0; j < l.values.size(); ++j)
+            {
+                if (l.values[j] != r.values[j]) return false;
+            }
+        }
+        return true;
+    }
+
     void serialize_test()
     {
         {
@@ -88,5 +121,34 @@ namespace Luna
                 lutest(v1[i] == v2[i]);
             }
         }
+
+        {
+            StaticSerializeTestOuter v1;
+            v1.a = -5;
+            v1.b = true;
+            v1.c = "Test String";
+            v1.d = Guid("{7C0FD89E-174E-46F0-A072-C6C2CCF452F2}");
+            v1.inners.resize(2);
+            v1.inners[0].name = "Inner1";
+            v1.inners[0].values = { 1.0f, 2.5f };
+            v1.inners[1].name = "Inner2";
+            auto var = static_serialize(v1).get();
+            lutest(var["a"].inum() == -5);
+            lutest(var["inners"][0]["values"][1].fnum() == 2.5);
+            StaticSerializeTestOuter v2;
+            lupanic_if_failed(static_deserialize(v2, var));
+            lutest(v1 == v2);
+
+            Vector<byte_t> data;
+            static_serialize_binary(v1, data);
+            StaticSerializeTestOuter v3;
+            usize read_bytes;
+            lupanic_if_failed(static_deserialize_binary(v3, data.data(), data.size(), &read_bytes));
+            lutest(read_bytes == data.size());
+            lutest(v1 == v3);
+            // Truncated data must fail.
+            StaticSerializeTestOuter v4;
+            lutest(failed(static_deserialize_binary(v4, data.data(), data.size() - 1)));
+        }
     }
 }
\ No newline at end of file
@@ -0,0 +1,114 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file SoAVectorTest.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/SoAVector.hpp>
+#include <Luna/Runtime/Math/Simd.hpp>
+
+namespace Luna
+{
+    void soa_vector_test()
+    {
+        TestObject::reset();
+        {
+            SoAVector<i32, TestObject, f64> vec;
+            lutest(vec.empty());
+            lutest(vec.capacity() == 0);
+            for (i32 i = 0; i < 100; ++i)
+            {
+                vec.emplace_back(i, TestObject(i * 2), (f64)i * 0.5);
+            }
+            lutest(vec.size() == 100);
+            lutest(vec.capacity() >= 100);
+            for (usize i = 0; i < 100; ++i)
+            {
+                auto e = vec[i];
+                lutest(get<0>(e) == (i32)i);
+                lutest(get<1>(e).m_value == (i32)i * 2);
+                lutest(get<2>(e) == (f64)i * 0.5);
+            }
+            // Every column is aligned and stores values continuously.
+            lutest(((usize)vec.column_data<0>() % SOA_COLUMN_ALIGNMENT) == 0);
+            lutest(((usize)vec.column_data<1>() % SOA_COLUMN_ALIGNMENT) == 0);
+            lutest(((usize)vec.column_data<2>() % SOA_COLUMN_ALIGNMENT) == 0);
+            auto col0 = vec.column<0>();
+            lutest(col0.size() == 100);
+            for (usize i = 0; i < col0.size(); ++i)
+            {
+                lutest(col0[i] == (i32)i);
+            }
+            // Modifies values through proxies.
+            get<0>(vec[3]) = 300;
+            get<1>(vec.back()).m_value = 1000;
+            lutest(vec.column<0>()[3] == 300);
+            lutest(vec.column<1>()[99].m_value == 1000);
+            vec[4] = Tuple<i32, TestObject, f64>(400, TestObject(800), 200.0);
+            lutest(get<0>(vec[4]) == 400 && get<1>(vec[4]).m_value == 800 && get<2>(vec[4]) == 200.0);
+            // Erases elements.
+            vec.erase(0);
+            lutest(vec.size() == 99);
+            lutest(get<0>(vec.front()) == 1);
+            lutest(get<0>(vec[2]) == 300);
+            vec.swap_erase(0);
+            lutest(vec.size() == 98);
+            lutest(get<0>(vec.front()) == 99);
+            lutest(get<1>(vec.front()).m_value == 1000);
+            vec.pop_back();
+            lutest(vec.size() == 97);
+            lutest(get<0>(vec.back()) == 97);
+            // Copies and moves.
+            SoAVector<i32, TestObject, f64> vec2 = vec;
+            lutest(vec2.size() == vec.size());
+            for (usize i = 0; i < vec.size(); ++i)
+            {
+                lutest(get<0>(vec2[i]) == get<0>(vec[i]));
+                lutest(get<1>(vec2[i]).m_value == get<1>(vec[i]).m_value);
+            }
+            SoAVector<i32, TestObject, f64> vec3 = move(vec2);
+            lutest(vec2.empty() && vec3.size() == vec.size());
+            vec2 = vec3;
+            lutest(vec2.size() == vec3.size());
+            vec3.clear();
+            lutest(vec3.empty());
+            vec3.shrink_to_fit();
+            lutest(vec3.capacity() == 0);
+            vec2.swap(vec3);
+            lutest(vec2.empty() && vec3.size() == vec.size());
+            // Resizes.
+            vec3.resize(10);
+            lutest(vec3.size() == 10);
+            vec3.resize(20);
+            lutest(get<1>(vec3[19]).m_value == 0);
+            vec3.shrink_to_fit();
+            lutest(vec3.capacity() == 20);
+            lutest(get<0>(vec3[9]) == get<0>(vec[9]));
+        }
+        lutest(TestObject::is_clear());
+        {
+            // Columns can be processed by SIMD instructions directly.
+            using namespace Simd;
+            SoAVector<f32, f32, f32> vec;
+            for (usize i = 0; i < 37; ++i)
+            {
+                vec.push_back(Tuple<f32, f32, f32>((f32)i, (f32)i * 2.0f, 0.0f));
+            }
+            f32* x = vec.column_data<0>();
+            f32* y = vec.column_data<1>();
+            f32* r = vec.column_data<2>();
+            for (usize i = 0; i < vec.size(); i += 4)
+            {
+                store_f4(r + i, add_f4(load_f4(x + i), load_f4(y + i)));
+            }
+            for (usize i = 0; i < vec.size(); ++i)
+            {
+                lutest(get<2>(vec[i]) == (f32)i * 3.0f);
+            }
+        }
+    }
+}
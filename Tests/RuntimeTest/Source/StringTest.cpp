@@ -19,7 +19,8 @@ namespace Luna
             String str1;
             lutest(str1.empty());
             lutest(str1.size() == 0);
-            lutest(str1.data() == nullptr);
+            lutest(str1.data() != nullptr);
+            lutest(str1.capacity() == String::INLINE_CAPACITY);
             lutest(!strcmp(str1.c_str(), u8""));
 
             // usize count, value_type ch, allocator_type& alloc
@@ -89,7 +90,7 @@ namespace Luna
             // const_pointer    c_str() const
             
             String s;
-            lutest(s.data() == nullptr);
+            lutest(s.data() != nullptr);
             lutest(!strcmp(s.c_str(), u8""));
         }
 
@@ -165,7 +166,8 @@ namespace Luna
             lutest(!strcmp(s.c_str(), u8"ccccccccccccccc"));
             s.shrink_to_fit();
             lutest(!strcmp(s.c_str(), u8"ccccccccccccccc"));
-            lutest(s.capacity() == 15);
+            // Short strings are moved back to the inline buffer.
+            lutest(s.capacity() == max<usize>(15, String::INLINE_CAPACITY));
         }
 
         {
@@ -241,5 +243,158 @@ namespace Luna
             lutest(!strcmp(s2.c_str(), u8"abc"));
             lutest(s2.size() == 3);
         }
+
+        {
+            // Inline buffer boundary.
+            // Strings with at most `INLINE_CAPACITY` characters are stored in the inline buffer, longer strings are
+            // stored in the heap.
+            constexpr usize N = String::INLINE_CAPACITY;
+            c8 chars[N + 2];
+            for (usize i = 0; i < N + 1; ++i) chars[i] = (c8)('a' + i % 26);
+            chars[N + 1] = 0;
+
+            String s1(chars, N - 1);
+            lutest(s1.size() == N - 1);
+            lutest(s1.capacity() == N);
+            lutest(!memcmp(s1.c_str(), chars, N - 1) && s1.c_str()[N - 1] == 0);
+
+            String s2(chars, N);
+            lutest(s2.size() == N);
+            lutest(s2.capacity() == N);
+            lutest(!memcmp(s2.c_str(), chars, N) && s2.c_str()[N] == 0);
+
+            String s3(chars, N + 1);
+            lutest(s3.size() == N + 1);
+            lutest(s3.capacity() > N);
+            lutest(!strcmp(s3.c_str(), chars));
+
+            // Growing from inline to heap by one character.
+            s1.push_back(chars[N - 1]);
+            lutest(!s1.compare(s2));
+            lutest(s1.capacity() == N);
+            s1.push_back(chars[N]);
+            lutest(!s1.compare(s3));
+            lutest(s1.capacity() > N);
+            lutest(!strcmp(s1.c_str(), chars));
+
+            // Shrinking from heap back to inline.
+            s1.pop_back();
+            lutest(!s1.compare(s2));
+            s1.shrink_to_fit();
+            lutest(s1.capacity() == N);
+            lutest(!s1.compare(s2));
+            lutest(s1.c_str()[N] == 0);
+
+            // Moving one heap string transfers the heap buffer.
+            const c8* heap_data = s3.data();
+            String s4(move(s3));
+            lutest(s4.data() == heap_data);
+            lutest(s4.size() == N + 1);
+            lutest(s3.empty() && s3.capacity() == N);
+            String s5;
+            s5 = move(s4);
+            lutest(s5.data() == heap_data);
+            lutest(!strcmp(s5.c_str(), chars));
+            lutest(s4.empty());
+
+            // Moving one inline string copies characters.
+            String s6(move(s2));
+            lutest(s6.size() == N && s6.capacity() == N);
+            lutest(!memcmp(s6.c_str(), chars, N));
+            lutest(s2.empty());
+
+            // Copying one heap string into one inline string, and one inline string into one heap string.
+            String s7 = s6;
+            s7 = s5;
+            lutest(!s7.compare(s5) && s7.data() != s5.data());
+            s7 = s6;
+            lutest(!s7.compare(s6));
+
+            // Swapping inline and heap strings.
+            s6.swap(s7);
+            s5.swap(s6);
+            lutest(s6.size() == N + 1 && !strcmp(s6.c_str(), chars));
+            lutest(s5.size() == N && !memcmp(s5.c_str(), chars, N));
+        }
+
+        {
+            // StringView
+            StringView v0;
+            lutest(v0.empty() && v0.size() == 0);
+            StringView v1(u8"Sample String");
+            lutest(v1.size() == 13);
+            lutest(v1.front() == 'S' && v1.back() == 'g');
+            lutest(v1[7] == 'S');
+            lutest(v1.find('S') == 0);
+            lutest(v1.find('S', 1) == 7);
+            lutest(v1.rfind('S') == 7);
+            lutest(v1.find('x') == StringView::npos);
+            lutest(v1.rfind('x') == StringView::npos);
+            lutest(v1.substr(7) == StringView(u8"String"));
+            lutest(v1.substr(0, 6) == StringView(u8"Sample"));
+            lutest(v1.substr(7, 100).size() == 6);
+            lutest(v1.substr(13).empty());
+            StringView v2 = v1;
+            v2.remove_prefix(7);
+            v2.remove_suffix(3);
+            lutest(v2 == StringView(u8"Str"));
+            lutest(v2 != StringView(u8"Stri"));
+            // The view does not need to be null-terminated.
+            StringView v3(u8"abcdef", 3);
+            lutest(v3 == StringView(u8"abc"));
+            usize n = 0;
+            for (c8 ch : v3) lutest(ch == "abc"[n++]);
+            lutest(n == 3);
+
+            // Conversions between String and StringView.
+            String s(v3);
+            lutest(!strcmp(s.c_str(), u8"abc"));
+            StringView v4 = s;
+            lutest(v4.data() == s.data() && v4.size() == 3);
+            lutest(hash<StringView>()(v4) == hash<StringView>()(v3));
+        }
+
+        {
+            // strformat
+            c8 buf[16];
+            StringView v = strformat(buf, 16, "%d-%s", 42, "abc");
+            lutest(v == StringView(u8"42-abc"));
+            lutest(v.data() == buf);
+            lutest(buf[6] == 0);
+            // Exactly fills the buffer.
+            v = strformat(buf, 16, "%s", "123456789012345");
+            lutest(v.size() == 15);
+            lutest(!strcmp(buf, "123456789012345"));
+            // Truncated, and still null-terminated.
+            v = strformat(buf, 16, "%s", "1234567890123456789");
+            lutest(v.size() == 15);
+            lutest(v == StringView(u8"123456789012345"));
+            lutest(buf[15] == 0);
+            v = strformat(buf, 1, "%s", "abc");
+            lutest(v.empty() && buf[0] == 0);
+            v = strformat(buf, 0, "%s", "abc");
+            lutest(v.empty());
+        }
+
+        {
+            // strprintf
+            String s = strprintf("%d-%s", 42, "abc");
+            lutest(!strcmp(s.c_str(), u8"42-abc"));
+            lutest(s.size() == 6);
+            s = strprintf("");
+            lutest(s.empty());
+            // Around the size of the stack buffer used by `vstrprintf`.
+            for (usize len : { 254, 255, 256, 257, 1000 })
+            {
+                String expected(len, 'x');
+                s = strprintf("%s", expected.c_str());
+                lutest(s.size() == len);
+                lutest(!s.compare(expected));
+                s = strprintf("%s%d", expected.c_str(), 7);
+                lutest(s.size() == len + 1);
+                lutest(s.back() == '7');
+                lutest(!memcmp(s.data(), expected.data(), len));
+            }
+        }
     }
 }
\ No newline at end of file
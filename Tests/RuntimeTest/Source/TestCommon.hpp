@@ -12,12 +12,18 @@
 #include <Luna/Runtime/Assert.hpp>
 #include <Luna/Runtime/Algorithm.hpp>
 #include <Luna/Runtime/Profiler.hpp>
+#include <Luna/Runtime/Object.hpp>
+#include <Luna/Runtime/Ref.hpp>
+#include <Luna/Runtime/Stream.hpp>
+#include <Luna/Runtime/Vector.hpp>
 
 namespace Luna
 {
     void vector_test();
     void open_hash_test();
     void robin_hood_hash_test();
+    void swiss_hash_test();
+    void hash_function_test();
     void name_test();
     void ring_deque_test();
     void string_test();
@@ -34,6 +40,20 @@ namespace Luna
     void invoke_test();
     void function_test();
     void unicode_test();
+    void allocator_test();
+    void inline_vector_test();
+    void object_test();
+    void queue_test();
+    void soa_vector_test();
+    void profiler_test();
+    void perf_counter_test();
+    void allocation_tracker_test();
+    void virtual_memory_test();
+    void log_test();
+    void futex_test();
+    void compression_test();
+    void base64_test();
+    void base85_test();
 
     // STL test framework modified from EASTL.
 
@@ -175,6 +195,31 @@ namespace Luna
         return t1.m_value < t2.m_value;
     }
 
+    // One stream that reads and writes one memory buffer. Registered by `run` before all tests.
+    struct TestMemoryStream : IStream
+    {
+        lustruct("TestMemoryStream", "{5A0E7C31-94D2-4B6F-8E15-C3B7A2069F48}");
+        luiimpl();
+
+        Vector<byte_t> m_data;
+        usize m_read_pos = 0;
+
+        virtual RV read(void* buffer, usize size, usize* read_bytes) override
+        {
+            usize sz = min(size, m_data.size() - m_read_pos);
+            memcpy(buffer, m_data.data() + m_read_pos, sz);
+            m_read_pos += sz;
+            if (read_bytes) *read_bytes = sz;
+            return ok;
+        }
+        virtual RV write(const void* buffer, usize size, usize* write_bytes) override
+        {
+            m_data.insert(m_data.end(), Span<const byte_t>((const byte_t*)buffer, size));
+            if (write_bytes) *write_bytes = size;
+            return ok;
+        }
+    };
+
 }
 
 #define lutest luassert_always
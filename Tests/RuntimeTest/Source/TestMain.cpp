@@ -16,13 +16,19 @@ void run()
 {
     set_log_to_platform_enabled(true);
     auto handle = register_profiler_callback(memory_profiler_callback);
+    register_boxed_type<TestMemoryStream>();
+    impl_interface_for_type<TestMemoryStream, IStream>();
     array_test();
     vector_test();
+    inline_vector_test();
+    soa_vector_test();
     open_hash_test();
     ring_deque_test();
     string_test();
     list_test();
     robin_hood_hash_test();
+    swiss_hash_test();
+    hash_function_test();
     tuple_test();
     name_test();
     path_test();
@@ -30,11 +36,23 @@ void run()
     variant_test();
     time_test();
     file_test();
+    log_test();
     math_test();
     serialize_test();
+    compression_test();
+    base64_test();
+    base85_test();
     invoke_test();
     function_test();
     unicode_test();
+    allocator_test();
+    virtual_memory_test();
+    object_test();
+    queue_test();
+    futex_test();
+    profiler_test();
+    perf_counter_test();
+    allocation_tracker_test();
     unregister_profiler_callback(handle);
 }
 
@@ -86,5 +86,32 @@ namespace Luna
 
             lutest(a == b);
         }
+
+        // Arena-backed objects and arrays.
+        {
+            Arena arena;
+            Variant copied;
+            {
+                Variant obj(VariantType::object, 2, &arena);
+                Variant arr(VariantType::array, 2, &arena);
+                arr.push_back((u64)1);
+                arr.push_back("Sample");
+                obj.insert("arr", move(arr));
+                obj.insert("num", (u64)2);
+                lutest(obj["arr"][1].str() == "Sample");
+                copied = obj;
+                // Growing past the reserved capacity moves children to heap.
+                obj["arr"].push_back((u64)3);
+                obj.insert("more", (u64)4);
+                lutest(obj.size() == 3);
+                lutest(obj["arr"].size() == 3);
+                lutest(obj["arr"][2].unum() == 3);
+                lutest(obj["more"].unum() == 4);
+            }
+            arena.reset();
+            lutest(copied.size() == 2);
+            lutest(copied["arr"][1].str() == "Sample");
+            lutest(copied["num"].unum() == 2);
+        }
     }
 }
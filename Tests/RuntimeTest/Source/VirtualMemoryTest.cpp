@@ -0,0 +1,56 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file VirtualMemoryTest.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "TestCommon.hpp"
+#include <Luna/Runtime/VirtualMemory.hpp>
+
+namespace Luna
+{
+    void virtual_memory_test()
+    {
+        usize page_size = get_page_size();
+        lutest(page_size && (page_size & (page_size - 1)) == 0);
+        {
+            // Reserves a large range and commits pages on demand.
+            constexpr usize reserve_size = 256_mb;
+            auto r = virtual_reserve(reserve_size);
+            lutest(succeeded(r));
+            u8* mem = (u8*)r.get();
+            lutest(((usize)mem & (page_size - 1)) == 0);
+            lutest(succeeded(virtual_commit(mem, page_size * 4)));
+            for (usize i = 0; i < page_size * 4; ++i) lutest(mem[i] == 0);
+            memset(mem, 0xCD, page_size * 4);
+            // Commits pages at the end of the range.
+            u8* tail = mem + reserve_size - page_size;
+            lutest(succeeded(virtual_commit(tail, page_size)));
+            tail[page_size - 1] = 0xEF;
+            lutest(tail[page_size - 1] == 0xEF);
+            // Committing committed pages does not change their content.
+            lutest(succeeded(virtual_commit(mem, page_size)));
+            lutest(mem[0] == 0xCD && mem[page_size - 1] == 0xCD);
+            // Decommitted pages are zero-filled when they are committed again.
+            lutest(succeeded(virtual_decommit(mem, page_size * 4)));
+            lutest(succeeded(virtual_commit(mem + page_size, page_size)));
+            for (usize i = 0; i < page_size; ++i) lutest(mem[page_size + i] == 0);
+            virtual_release(mem, reserve_size);
+        }
+        {
+            // Large pages are only a hint, so the reservation should always succeed.
+            usize large_page_size = get_large_page_size();
+            usize reserve_size = large_page_size ? large_page_size * 2 : 4_mb;
+            auto r = virtual_reserve(reserve_size, VirtualMemoryFlag::large_page);
+            lutest(succeeded(r));
+            u8* mem = (u8*)r.get();
+            lutest(succeeded(virtual_commit(mem, reserve_size)));
+            memset(mem, 0x12, reserve_size);
+            lutest(mem[0] == 0x12 && mem[reserve_size - 1] == 0x12);
+            virtual_release(mem, reserve_size);
+        }
+    }
+}
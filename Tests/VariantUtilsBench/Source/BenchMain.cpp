@@ -0,0 +1,164 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file BenchMain.cpp
+* @author JXMaster
+* @date 2024/5/17
+*/
+#include "VariantUtilsBench.hpp"
+#include <Luna/Runtime/Module.hpp>
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/VariantUtils/VariantUtils.hpp>
+#include <Luna/VariantUtils/JSON.hpp>
+#include <Luna/VariantUtils/XML.hpp>
+#include <Luna/VariantUtils/Binary.hpp>
+#include <Luna/VariantUtils/Diff.hpp>
+#include <stdio.h>
+
+namespace Luna
+{
+    // Benchmarks reading and writing one document in JSON format, both indented and compact.
+    static void json_document_bench(const c8* doc_name, const Variant& doc)
+    {
+        c8 name[64];
+        String text = VariantUtils::write_json(doc, true);
+        String compact = VariantUtils::write_json(doc, false);
+        snprintf(name, 64, "read_json %s", doc_name);
+        bench(name, text.size(), [&]()
+        {
+            bench_keep(VariantUtils::read_json(text.c_str(), text.size()).get().size());
+        });
+        snprintf(name, 64, "read_json %s (compact)", doc_name);
+        bench(name, compact.size(), [&]()
+        {
+            bench_keep(VariantUtils::read_json(compact.c_str(), compact.size()).get().size());
+        });
+        snprintf(name, 64, "write_json %s", doc_name);
+        bench(name, text.size(), [&]()
+        {
+            bench_keep(VariantUtils::write_json(doc, true).size());
+        });
+        snprintf(name, 64, "write_json %s (compact)", doc_name);
+        bench(name, compact.size(), [&]()
+        {
+            bench_keep(VariantUtils::write_json(doc, false).size());
+        });
+    }
+
+    void json_bench()
+    {
+        json_document_bench("scene", make_scene_document(scaled(10000)));
+        json_document_bench("blobs", make_blob_document(scaled(64), 64 * 1024));
+        // Asset meta files are small, so per-document overhead dominates.
+        Vector<Variant> metas = make_asset_meta_documents(scaled(2000));
+        Vector<String> texts;
+        texts.reserve(metas.size());
+        u64 total_size = 0;
+        for (auto& meta : metas)
+        {
+            texts.push_back(VariantUtils::write_json(meta, true));
+            total_size += texts.back().size();
+        }
+        bench("read_json asset meta", total_size, [&]()
+        {
+            usize n = 0;
+            for (auto& text : texts) n += VariantUtils::read_json(text.c_str(), text.size()).get().size();
+            bench_keep(n);
+        });
+        bench("write_json asset meta", total_size, [&]()
+        {
+            usize n = 0;
+            for (auto& meta : metas) n += VariantUtils::write_json(meta, true).size();
+            bench_keep(n);
+        });
+    }
+
+    void xml_bench()
+    {
+        Variant doc = make_xml_document(scaled(2000));
+        String text = VariantUtils::write_xml(doc, true);
+        bench("read_xml geometries", text.size(), [&]()
+        {
+            bench_keep(VariantUtils::read_xml(text.c_str(), text.size()).get().size());
+        });
+        bench("write_xml geometries", text.size(), [&]()
+        {
+            bench_keep(VariantUtils::write_xml(doc, true).size());
+        });
+    }
+
+    // Benchmarks reading and writing one document in the binary variant format.
+    static void binary_document_bench(const c8* doc_name, const Variant& doc)
+    {
+        c8 name[64];
+        Blob data = VariantUtils::write_binary(doc);
+        snprintf(name, 64, "read_binary %s", doc_name);
+        bench(name, data.size(), [&]()
+        {
+            bench_keep(VariantUtils::read_binary(data.data(), data.size()).get().size());
+        });
+        snprintf(name, 64, "write_binary %s", doc_name);
+        bench(name, data.size(), [&]()
+        {
+            bench_keep(VariantUtils::write_binary(doc).size());
+        });
+    }
+
+    void binary_bench()
+    {
+        binary_document_bench("scene", make_scene_document(scaled(10000)));
+        binary_document_bench("blobs", make_blob_document(scaled(64), 64 * 1024));
+    }
+
+    void diff_bench()
+    {
+        Variant before = make_scene_document(scaled(10000));
+        Variant after = make_modified_scene_document(before);
+        // Diff and patch throughput is measured against the compact JSON size of the original document.
+        u64 size = VariantUtils::write_json(before, false).size();
+        bench("diff scene", size, [&]()
+        {
+            bench_keep(VariantUtils::diff(before, after).size());
+        });
+        Variant delta = VariantUtils::diff(before, after);
+        Variant target;
+        bench("patch scene", size, [&]()
+        {
+            target = before;
+        }, [&]()
+        {
+            VariantUtils::patch(target, delta);
+            bench_keep(target.size());
+        });
+    }
+}
+
+using namespace Luna;
+
+// Usage: VariantUtilsBench [--filter <name>] [--repetitions <count>] [--warmup <count>] [--scale <factor>] [--json <path>]
+// Peak memory is reported only if the memory profiler is enabled (LUNA_ENABLE_MEMORY_PROFILER or the profile debug level).
+int main(int argc, char** argv)
+{
+    Luna::init();
+    lupanic_if_failed(add_modules({module_variant_utils()}));
+    lupanic_if_failed(init_modules());
+    auto& options = get_bench_options();
+    options.name = "VariantUtilsBench";
+    options.unit = "byte";
+    options.warmup = 2;
+    options.repetitions = 10;
+    options.track_memory = true;
+    for (int i = 1; i + 1 < argc; i += 2)
+    {
+        if (!parse_bench_option(argv[i], argv[i + 1])) printf("Unknown option: %s\n", argv[i]);
+    }
+    json_bench();
+    xml_bench();
+    binary_bench();
+    diff_bench();
+    bench_report();
+    Luna::close();
+    return 0;
+}
@@ -0,0 +1,232 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file Corpus.cpp
+* @author JXMaster
+* @date 2024/5/17
+*/
+#include "VariantUtilsBench.hpp"
+#include <Luna/Runtime/Blob.hpp>
+#include <Luna/VariantUtils/XML.hpp>
+#include <stdio.h>
+
+namespace Luna
+{
+    static Variant make_guid_string(BenchRandom& random)
+    {
+        c8 buf[48];
+        u64 a = random.next();
+        u64 b = random.next();
+        snprintf(buf, 48, "{%08x-%04x-%04x-%04x-%012llx}", (u32)a, (u32)(a >> 32) & 0xFFFF, (u32)(a >> 48),
+            (u32)b & 0xFFFF, (unsigned long long)(b >> 16));
+        return Variant(buf);
+    }
+
+    static Variant make_vector(BenchRandom& random, u32 n)
+    {
+        Variant v(VariantType::array);
+        for (u32 i = 0; i < n; ++i) v.push_back(Variant(random.next_f64() * 200.0 - 100.0));
+        return v;
+    }
+
+    static Variant make_entity(BenchRandom& random, u32 index)
+    {
+        c8 buf[64];
+        Variant entity(VariantType::object);
+        snprintf(buf, 64, "Entity_%u", index);
+        entity["name"] = buf;
+        entity["guid"] = make_guid_string(random);
+        entity["enabled"] = (random.next() & 7) != 0;
+        entity["parent"] = (u64)(index / 4);
+        Variant components(VariantType::object);
+        Variant transform(VariantType::object);
+        transform["position"] = make_vector(random, 3);
+        transform["rotation"] = make_vector(random, 4);
+        Variant scale(VariantType::array);
+        for (u32 i = 0; i < 3; ++i) scale.push_back(Variant(1.0));
+        transform["scale"] = move(scale);
+        components["Transform"] = move(transform);
+        if (random.next() % 4 != 0)
+        {
+            Variant renderer(VariantType::object);
+            snprintf(buf, 64, "Assets/Models/model_%u.mesh", (u32)(random.next() % 500));
+            renderer["model"] = buf;
+            Variant materials(VariantType::array);
+            u32 num_materials = 1 + (u32)(random.next() % 3);
+            for (u32 i = 0; i < num_materials; ++i)
+            {
+                snprintf(buf, 64, "Assets/Materials/material_%u.mat", (u32)(random.next() % 200));
+                materials.push_back(Variant(buf));
+            }
+            renderer["materials"] = move(materials);
+            renderer["cast_shadow"] = true;
+            components["MeshRenderer"] = move(renderer);
+        }
+        if (random.next() % 16 == 0)
+        {
+            Variant light(VariantType::object);
+            light["type"] = "Point";
+            light["color"] = make_vector(random, 3);
+            light["intensity"] = random.next_f64() * 10.0;
+            light["range"] = random.next_f64() * 50.0;
+            components["Light"] = move(light);
+        }
+        entity["components"] = move(components);
+        return entity;
+    }
+
+    Variant make_scene_document(u32 num_entities)
+    {
+        BenchRandom random;
+        Variant scene(VariantType::object);
+        scene["version"] = (u64)1;
+        scene["name"] = "BenchScene";
+        Variant settings(VariantType::object);
+        settings["ambient_color"] = make_vector(random, 3);
+        settings["skybox"] = "Assets/Textures/sky.dds";
+        settings["exposure"] = 1.0;
+        scene["settings"] = move(settings);
+        Variant entities(VariantType::array);
+        for (u32 i = 0; i < num_entities; ++i)
+        {
+            entities.push_back(make_entity(random, i));
+        }
+        scene["entities"] = move(entities);
+        return scene;
+    }
+
+    Variant make_modified_scene_document(const Variant& scene)
+    {
+        BenchRandom random;
+        random.m_state ^= 0x5555;
+        Variant ret(VariantType::object);
+        for (auto& i : scene.key_values())
+        {
+            if (i.first != Name("entities")) ret[i.first] = i.second;
+        }
+        ret["settings"]["exposure"] = 1.5;
+        const Variant& entities = scene["entities"];
+        Variant new_entities(VariantType::array);
+        u32 next_index = (u32)entities.size();
+        for (usize i = 0; i < entities.size(); ++i)
+        {
+            u64 r = random.next() % 100;
+            if (r == 0)
+            {
+                // Removes 1% of entities.
+                continue;
+            }
+            Variant entity = entities[i];
+            if (r < 5)
+            {
+                // Modifies 4% of entities.
+                entity["components"]["Transform"]["position"] = make_vector(random, 3);
+                entity["enabled"] = !entity["enabled"].boolean();
+            }
+            new_entities.push_back(move(entity));
+            if (r == 99)
+            {
+                // Inserts 1% new entities.
+                new_entities.push_back(make_entity(random, next_index++));
+            }
+        }
+        ret["entities"] = move(new_entities);
+        return ret;
+    }
+
+    Vector<Variant> make_asset_meta_documents(u32 count)
+    {
+        BenchRandom random;
+        const c8* types[] = { "Texture", "Model", "Mesh", "Material", "Scene" };
+        Vector<Variant> ret;
+        ret.reserve(count);
+        c8 buf[64];
+        for (u32 i = 0; i < count; ++i)
+        {
+            Variant meta(VariantType::object);
+            const c8* type = types[random.next() % 5];
+            meta["type"] = type;
+            meta["guid"] = make_guid_string(random);
+            snprintf(buf, 64, "Assets/%s/asset_%u.data", type, i);
+            meta["source"] = buf;
+            meta["version"] = (u64)(random.next() % 4);
+            Variant settings(VariantType::object);
+            settings["generate_mips"] = (random.next() & 1) != 0;
+            settings["srgb"] = (random.next() & 1) != 0;
+            settings["max_size"] = (u64)(256 << (random.next() % 5));
+            settings["compression"] = "bc7";
+            meta["import_settings"] = move(settings);
+            ret.push_back(move(meta));
+        }
+        return ret;
+    }
+
+    Variant make_xml_document(u32 num_geometries)
+    {
+        BenchRandom random;
+        using namespace VariantUtils;
+        Variant root = new_xml_element("COLLADA");
+        get_xml_attributes(root)["version"] = "1.4.1";
+        Variant library = new_xml_element("library_geometries");
+        c8 buf[64];
+        String text;
+        for (u32 i = 0; i < num_geometries; ++i)
+        {
+            Variant geometry = new_xml_element("geometry");
+            snprintf(buf, 64, "geometry_%u", i);
+            get_xml_attributes(geometry)["id"] = buf;
+            get_xml_attributes(geometry)["name"] = buf;
+            Variant mesh = new_xml_element("mesh");
+            Variant source = new_xml_element("source");
+            snprintf(buf, 64, "geometry_%u_positions", i);
+            get_xml_attributes(source)["id"] = buf;
+            Variant float_array = new_xml_element("float_array");
+            get_xml_attributes(float_array)["count"] = "96";
+            text.clear();
+            for (u32 j = 0; j < 96; ++j)
+            {
+                snprintf(buf, 64, j ? " %.5f" : "%.5f", random.next_f64() * 2.0 - 1.0);
+                text.append(buf);
+            }
+            get_xml_content(float_array).push_back(Variant(text.c_str()));
+            get_xml_content(source).push_back(move(float_array));
+            get_xml_content(mesh).push_back(move(source));
+            Variant triangles = new_xml_element("triangles");
+            get_xml_attributes(triangles)["count"] = "10";
+            get_xml_attributes(triangles)["material"] = "default";
+            Variant p = new_xml_element("p");
+            get_xml_content(p).push_back(Variant("0 1 2 2 1 3 3 4 5 5 6 7 7 8 9 9 10 11 11 12 13 13 14 15 15 16 17 17 18 19 19 20 21 21 22 23"));
+            get_xml_content(triangles).push_back(move(p));
+            get_xml_content(mesh).push_back(move(triangles));
+            get_xml_content(geometry).push_back(move(mesh));
+            get_xml_content(library).push_back(move(geometry));
+        }
+        get_xml_content(root).push_back(move(library));
+        return root;
+    }
+
+    Variant make_blob_document(u32 num_blobs, usize blob_size)
+    {
+        BenchRandom random;
+        Variant doc(VariantType::object);
+        Variant textures(VariantType::array);
+        c8 buf[64];
+        for (u32 i = 0; i < num_blobs; ++i)
+        {
+            Variant texture(VariantType::object);
+            snprintf(buf, 64, "texture_%u", i);
+            texture["name"] = buf;
+            texture["width"] = (u64)256;
+            texture["format"] = "rgba8_unorm";
+            Blob data(blob_size);
+            u64* words = (u64*)data.data();
+            for (usize j = 0; j < blob_size / sizeof(u64); ++j) words[j] = random.next();
+            texture["data"] = Variant(move(data));
+            textures.push_back(move(texture));
+        }
+        doc["textures"] = move(textures);
+        return doc;
+    }
+}
@@ -0,0 +1,37 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+*
+* @file VariantUtilsBench.hpp
+* @author JXMaster
+* @date 2024/5/22
+*/
+#pragma once
+#include "../../BenchCommon/BenchCommon.hpp"
+#include <Luna/Runtime/Variant.hpp>
+
+namespace Luna
+{
+    // Corpus generators. All documents are generated deterministically.
+
+    // Generates one scene document with `num_entities` entities, every entity has several components.
+    Variant make_scene_document(u32 num_entities);
+
+    // Modifies about 5% of entities in one scene document, and inserts and removes some entities.
+    Variant make_modified_scene_document(const Variant& scene);
+
+    // Generates `count` small asset meta documents.
+    Vector<Variant> make_asset_meta_documents(u32 count);
+
+    // Generates one XML document with `num_geometries` geometry elements, every geometry has long text contents.
+    Variant make_xml_document(u32 num_geometries);
+
+    // Generates one document with `num_blobs` blobs of `blob_size` bytes, and some metadata for every blob.
+    Variant make_blob_document(u32 num_blobs, usize blob_size);
+
+    void json_bench();
+    void xml_bench();
+    void binary_bench();
+    void diff_bench();
+}
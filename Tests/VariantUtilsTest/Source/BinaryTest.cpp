@@ -0,0 +1,87 @@
+/*!
+* This file is a portion of Luna SDK.
+* For conditions of distribution and use, see the disclaimer
+* and license in LICENSE.txt
+* 
+* @file BinaryTest.cpp
+* @author JXMaster
+* @date 2024/3/11
+*/
+#include "TestCommon.hpp"
+#include <Luna/VariantUtils/Binary.hpp>
+#include <Luna/VariantUtils/JSON.hpp>
+#include <Luna/Runtime/File.hpp>
+namespace Luna
+{
+    using namespace VariantUtils;
+    void binary_test()
+    {
+        const c8 src[] = R"({
+            "name": "Test",
+            "enabled": true,
+            "disabled": false,
+            "empty": null,
+            "small": 5,
+            "large": 123456789012,
+            "float": 3.5,
+            "array": [1, "Test", [], {}],
+            "object": { "name": "Test", "values": [0.25, 128, 127] }
+        })";
+        Variant v = read_json(src).get();
+        v["negative"] = (i64)-42;
+        v["array"].push_back((i64)-1000000);
+        v["blob"] = Blob("blob data", 9, 4);
+        {
+            Blob large_blob(8192, 16);
+            byte_t* data = (byte_t*)large_blob.data();
+            for (usize i = 0; i < large_blob.size(); ++i) data[i] = (byte_t)i;
+            v["large_blob"] = move(large_blob);
+        }
+
+        // Memory round trip.
+        {
+            Blob data = write_binary(v);
+            luassert_always(!data.empty());
+            Variant r = read_binary(data.data(), data.size()).get();
+            luassert_always(r == v);
+            luassert_always(r["object"].type() == VariantType::object);
+            luassert_always(r["array"][3].type() == VariantType::object);
+            luassert_always(r["negative"].number_type() == VariantNumberType::number_i64);
+            luassert_always(r["negative"].inum() == -42);
+            luassert_always(r["large"].unum() == 123456789012);
+            luassert_always(r["blob"].blob_size() == 9);
+            luassert_always(r["blob"].blob_alignment() == v["blob"].blob_alignment());
+            luassert_always(!memcmp(r["blob"].blob_data(), "blob data", 9));
+            luassert_always(r["large_blob"].blob_size() == 8192);
+            luassert_always(r["large_blob"].blob_alignment() == v["large_blob"].blob_alignment());
+            {
+                Arena arena;
+                Variant ra = read_binary(data.data(), data.size(), &arena).get();
+                luassert_always(ra == v);
+            }
+
+            // Truncated data must fail.
+            for (usize i = 0; i < data.size(); ++i)
+            {
+                luassert_always(failed(read_binary(data.data(), i)));
+            }
+            // Invalid header must fail.
+            luassert_always(failed(read_binary("{}", 2)));
+        }
+
+        // Stream round trip.
+        {
+            const c8* path = "VariantUtilsBinaryTest.bin";
+            {
+                auto f = open_file(path, FileOpenFlag::write, FileCreationMode::create_always).get();
+                luassert_always(succeeded(write_binary(f, v)));
+            }
+            {
+                auto f = open_file(path, FileOpenFlag::read, FileCreationMode::open_existing).get();
+                Variant r = read_binary(f).get();
+                luassert_always(r == v);
+            }
+            luassert_always(succeeded(delete_file(path)));
+        }
+    }
+}
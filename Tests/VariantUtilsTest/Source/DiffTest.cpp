@@ -180,6 +180,36 @@ namespace Luna
             patch(restored, delta);
             luassert_always(restored == after);
         }
+        //Diff_DiffDescModes_ValidPatch
+        {
+            Variant before = read_json("{\"a\": [1, 2, 3, {\"x\": 1}, 5, 6], \"b\": {\"c\": [true, false]}, \"d\": \"str\"}").get();
+            Variant after = read_json("{\"a\": [1, 3, {\"x\": 2}, 4, 5, 7, 8], \"b\": {\"c\": [true, true]}, \"e\": 1}").get();
+            DiffDesc desc;
+            // Runs the parallel path on the calling thread.
+            desc.parallel_threshold = 1;
+            desc.parallel_for = [](void* userdata, usize count, void(*func)(void* func_ctx, usize index), void* func_ctx)
+            {
+                for (usize i = count; i > 0; --i) func(func_ctx, i - 1);
+            };
+            for (DiffArrayMode mode : { DiffArrayMode::lcs, DiffArrayMode::positional })
+            {
+                desc.array_mode = mode;
+                Variant delta = diff(before, after, desc);
+                Variant restored = before;
+                patch(restored, delta);
+                luassert_always(restored == after);
+                revert(restored, delta);
+                luassert_always(restored == before);
+                luassert_always(diff(after, after, desc).type() == VariantType::null);
+            }
+            // LCS mode falls back to positional mode when exceeding the size limit.
+            desc.array_mode = DiffArrayMode::lcs;
+            desc.max_lcs_size = 1;
+            Variant delta = diff(before, after, desc);
+            Variant restored = before;
+            patch(restored, delta);
+            luassert_always(restored == after);
+        }
         //Diff_IntStringDiff_ValidPatch
         {
             Variant before = read_json("1").get();
@@ -259,6 +289,27 @@ namespace Luna
             patch(patched, delta);
             luassert_always(patched == after);
         }
+        //Diff_ArrayWithZeroAndFalseChildren_Changed
+        {
+            const c8* cases[][2] = {
+                { "[0, 2, 4]", "[0, 2, 3]" },
+                { "[5, 0, 4]", "[5, 0, 3]" },
+                { "[[0, 1], [1]]", "[[0, 7], [1]]" },
+                { "[false, 1]", "[false, 2]" },
+                { "[1, false]", "[1, true]" },
+                { "[[], 0, 1]", "[[], 0, 2]" },
+            };
+            for (auto& c : cases)
+            {
+                Variant before = read_json(c[0]).get();
+                Variant after = read_json(c[1]).get();
+                Variant delta = diff(before, after);
+                luassert_always(delta.valid());
+                Variant patched = before;
+                patch(patched, delta);
+                luassert_always(patched == after);
+            }
+        }
         //Patch_ArrayPatchAdd_Success
         {
             Variant before = read_json("[1,2,3]").get();
@@ -12,6 +12,27 @@
 
 namespace Luna
 {
+    struct JSONCountHandler : VariantUtils::JSONReadHandler
+    {
+        u32 num_objects = 0;
+        u32 num_arrays = 0;
+        u32 num_keys = 0;
+        u32 num_values = 0;
+        i32 depth = 0;
+        u64 sum = 0;
+
+        virtual RV on_begin_object() override { ++num_objects; ++depth; return ok; }
+        virtual RV on_key(const Name& key) override { ++num_keys; return ok; }
+        virtual RV on_end_object() override { --depth; return ok; }
+        virtual RV on_begin_array() override { ++num_arrays; ++depth; return ok; }
+        virtual RV on_end_array() override { --depth; return ok; }
+        virtual RV on_value(Variant& value) override
+        {
+            ++num_values;
+            if (value.type() == VariantType::number) sum += value.unum();
+            return ok;
+        }
+    };
     void json_test()
     {
         {
@@ -49,6 +70,22 @@ namespace Luna
             luassert_always(v.get() == v2.get());
         }
         
+        {
+            // Numbers round trip, and floating-point numbers with integral values are read back as floating-point numbers.
+            Variant v(VariantType::array);
+            v.push_back(0.1);
+            v.push_back(1.0);
+            v.push_back(0.5);
+            v.push_back(-3.0);
+            v.push_back(1e15);
+            v.push_back((i64)-42);
+            v.push_back((u64)18446744073709551615ULL);
+            String s = VariantUtils::write_json(v, false);
+            Variant v2 = VariantUtils::read_json(s.c_str()).get();
+            luassert_always(v == v2);
+            luassert_always(v2[1].number_type() == VariantNumberType::number_f64);
+        }
+
         {
             // Blob test.
             const c8 d[17] = "Sample BLOB Data";
@@ -74,5 +111,76 @@ namespace Luna
             Variant& blob_var2 = blob_var2_r.get();
             luassert_always(blob_var == blob_var2);
         }
+
+        {
+            // Strings with escape sequences, non-ASCII characters and comments.
+            const c8* src = u8"{ // comment\n\
+    \"plain\": \"A long string that is longer than sixteen characters\", \n\
+    \"esc\\taped\": \"Line 1\\nLine 2 \\\"quoted\\\" \\u0041\", \n\
+    /* multi-line \n comment */ \"unicode\": \"\u4f60\u597d, world\", \n\
+    \"empty\": \"\" \n\
+}";
+            R<Variant> v = VariantUtils::read_json(src);
+            luassert_always(succeeded(v));
+            luassert_always(v.get()["plain"].str() == "A long string that is longer than sixteen characters");
+            luassert_always(v.get()["esc\taped"].str() == "Line 1\nLine 2 \"quoted\" A");
+            luassert_always(v.get()["unicode"].str() == u8"\u4f60\u597d, world");
+            luassert_always(v.get()["empty"].str() == "");
+
+            // The string length limits the characters to read.
+            const c8 num_src[] = "[1, 2, 3] trailing";
+            R<Variant> v2 = VariantUtils::read_json(num_src, 9);
+            luassert_always(succeeded(v2));
+            luassert_always(v2.get().size() == 3);
+        }
+
+        {
+            // Event and view test.
+            const c8* src = R"({
+                "name": "root",
+                "skipped": { "a": [1, 2, { "b": "}]" }], "c": "\"" }, // comment
+                "items": [10, 20, /* comment */ 30, { "x": 40 }],
+                "empty": {}
+            })";
+            JSONCountHandler handler;
+            luassert_always(succeeded(VariantUtils::read_json_events(handler, src)));
+            luassert_always(handler.depth == 0);
+            luassert_always(handler.num_objects == 5);
+            luassert_always(handler.num_arrays == 2);
+            luassert_always(handler.num_keys == 8);
+            luassert_always(handler.num_values == 9);
+            luassert_always(handler.sum == 103);
+            luassert_always(failed(VariantUtils::read_json_events(handler, "{ \"a\": [1, 2 ")));
+
+            auto root = VariantUtils::view_json(src);
+            luassert_always(VariantUtils::get_json_view_type(root) == VariantType::object);
+            luassert_always(VariantUtils::get_json_view_size(root).get() == 4);
+            auto items = VariantUtils::get_json_view_field(root, "items").get();
+            luassert_always(VariantUtils::get_json_view_type(items) == VariantType::array);
+            luassert_always(VariantUtils::get_json_view_size(items).get() == 4);
+            auto item = VariantUtils::get_json_view_element(items, 2).get();
+            luassert_always(VariantUtils::read_json_view(item).get().unum() == 30);
+            item = VariantUtils::get_json_view_element(items, 3).get();
+            luassert_always(VariantUtils::read_json_view(VariantUtils::get_json_view_field(item, "x").get()).get().unum() == 40);
+            luassert_always(VariantUtils::get_json_view_element(items, 4).errcode() == BasicError::out_of_range());
+            luassert_always(VariantUtils::get_json_view_field(root, "missing").errcode() == BasicError::not_found());
+            auto empty = VariantUtils::get_json_view_field(root, "empty").get();
+            luassert_always(VariantUtils::get_json_view_size(empty).get() == 0);
+            auto name = VariantUtils::get_json_view_field(root, "name").get();
+            luassert_always(VariantUtils::get_json_view_type(name) == VariantType::string);
+            luassert_always(VariantUtils::read_json_view(name).get().str() == "root");
+            Variant full = VariantUtils::read_json(src).get();
+            luassert_always(VariantUtils::read_json_view(root).get() == full);
+            luassert_always(VariantUtils::read_json_view(VariantUtils::get_json_view_field(root, "skipped").get()).get() == full["skipped"]);
+
+            // Arena-backed reading.
+            Arena arena;
+            {
+                Variant v = VariantUtils::read_json(src, USIZE_MAX, &arena).get();
+                luassert_always(v == full);
+                v["items"].push_back((u64)50);
+                luassert_always(v["items"].size() == 5);
+            }
+        }
     }
 }
\ No newline at end of file
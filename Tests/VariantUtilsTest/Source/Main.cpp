@@ -24,6 +24,7 @@ int main()
     json_test();
     diff_test();
     xml_test();
+    binary_test();
     Luna::close();
     return 0;
 }
\ No newline at end of file
@@ -13,4 +13,5 @@ namespace Luna
     void json_test();
     void diff_test();
     void xml_test();
+    void binary_test();
 }
\ No newline at end of file
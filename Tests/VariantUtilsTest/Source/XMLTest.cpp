@@ -13,6 +13,22 @@
 
 namespace Luna
 {
+    struct XMLRecordHandler : VariantUtils::XMLReadHandler
+    {
+        String record;
+
+        virtual RV on_begin_element(const Name& name) override { record.append("<"); record.append(name.c_str()); return ok; }
+        virtual RV on_attribute(const Name& name, const String& value) override
+        {
+            record.append(" ");
+            record.append(name.c_str());
+            record.append("=");
+            record.append(value.c_str());
+            return ok;
+        }
+        virtual RV on_text(const String& text) override { record.append("|"); record.append(text.c_str()); return ok; }
+        virtual RV on_end_element() override { record.append(">"); return ok; }
+    };
     void xml_test()
     {
         {
@@ -62,5 +78,11 @@ namespace Luna
             luassert_always(elements.at(0).str() == "This is a ");
             luassert_always(elements.at(2).str() == " paragraph.");
         }
+        {
+            const c8* src = R"(<?xml version="1.0"?><p class="a &amp; b">Text <a href='x'/><![CDATA[<data>]]></p>)";
+            XMLRecordHandler handler;
+            luassert_always(succeeded(VariantUtils::read_xml_events(handler, src)));
+            luassert_always(!strcmp(handler.record.c_str(), "<p class=a & b|Text <a href=x>|<data>>"));
+        }
     }
 }
\ No newline at end of file
@@ -1,10 +1,15 @@
+includes("BenchCommon")
 includes("RuntimeTest")
+includes("RuntimeBench")
 includes("VariantUtilsTest")
+includes("VariantUtilsBench")
 includes("WindowTest")
 includes("RHITests")
 includes("VGTest")
 includes("FontArrangeTest")
 includes("ImGuiTest")
 includes("JobSystemTest")
+includes("JobSystemBench")
 includes("ECSTest")
+includes("ECSBench")
 includes("AHITest")
\ No newline at end of file
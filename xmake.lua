@@ -45,6 +45,27 @@ option("memory_profiler")
     add_defines("LUNA_ENABLE_MEMORY_PROFILER")
 option_end()
 
+option("job_system_profiler")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Whether to forcly enable job system profiler events for Luna SDK. The job system profiler events will still be enabled in Debug and Profile mode.")
+    add_defines("LUNA_ENABLE_JOB_SYSTEM_PROFILER")
+option_end()
+
+option("allocation_tracker")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Whether to forcly enable the per-frame allocation tracker for Luna SDK. The allocation tracker will still be enabled in Debug mode.")
+    add_defines("LUNA_ENABLE_ALLOCATION_TRACKER")
+option_end()
+
+option("system_allocator")
+    set_default(false)
+    set_showmenu(true)
+    set_description("Whether to use the system heap allocator instead of the built-in heap allocator for Luna SDK.")
+    add_defines("LUNA_USE_SYSTEM_ALLOCATOR")
+option_end()
+
 function get_default_rhi_api()
     local default_rhi_api = false
     if is_os("windows") then
@@ -82,7 +103,7 @@ elseif is_config("rhi_api", "D3D12") then
 end
 
 function add_luna_sdk_options()
-    add_options("shared", "contract_assertion", "thread_safe_assertion", "memory_profiler")
+    add_options("shared", "contract_assertion", "thread_safe_assertion", "memory_profiler", "job_system_profiler", "allocation_tracker", "system_allocator")
     -- Contract assertion is always enabled in debug mode.
     if has_config("contract_assertion") or is_mode("debug") then
         add_defines("LUNA_ENABLE_CONTRACT_ASSERTION")